@@ -31,6 +31,7 @@ list (APPEND MAIN_SOURCE_FILES
   opm/autodiff/NewtonIterationBlackoilCPR.cpp
   opm/autodiff/NewtonIterationBlackoilInterleaved.cpp
   opm/autodiff/NewtonIterationBlackoilSimple.cpp
+  opm/autodiff/LinearSolverReuseAmg.cpp
   opm/autodiff/NewtonIterationUtilities.cpp
   opm/autodiff/GridHelpers.cpp
   opm/autodiff/ImpesTPFAAD.cpp
@@ -50,6 +51,23 @@ list (APPEND MAIN_SOURCE_FILES
   opm/autodiff/WellMultiSegment.cpp
   opm/autodiff/MultisegmentWells.cpp
   opm/autodiff/MissingFeatures.cpp
+  opm/autodiff/PerformanceTrace.cpp
+  opm/autodiff/PerformanceSummary.cpp
+  opm/autodiff/StartupCache.cpp
+  opm/autodiff/OutputShard.cpp
+  opm/autodiff/CheckpointFile.cpp
+  opm/autodiff/EnsembleMembers.cpp
+  opm/autodiff/NodeSharedArray.cpp
+  opm/autodiff/DeckStaging.cpp
+  opm/autodiff/DebugLog.cpp
+  opm/autodiff/TimerTree.cpp
+  opm/autodiff/RankLoadReport.cpp
+  opm/autodiff/HardwareCounters.cpp
+  opm/autodiff/Hdf5Output.cpp
+  opm/autodiff/MatlabStepWriter.cpp
+  opm/autodiff/MemoryTracker.cpp
+  opm/autodiff/StartupProfile.cpp
+  opm/autodiff/OutputPrecision.cpp
   opm/polymer/PolymerState.cpp
   opm/polymer/PolymerBlackoilState.cpp
   opm/polymer/CompressibleTpfaPolymer.cpp
@@ -66,6 +84,7 @@ list (APPEND MAIN_SOURCE_FILES
   opm/simulators/SimulatorCompressibleTwophase.cpp
   opm/simulators/SimulatorIncompTwophase.cpp
   opm/simulators/WellSwitchingLogger.cpp
+  opm/simulators/MetricsExporter.cpp
   opm/simulators/vtk/writeVtkData.cpp
   opm/simulators/timestepping/TimeStepControl.cpp
   opm/simulators/timestepping/AdaptiveSimulatorTimer.cpp
@@ -91,9 +110,54 @@ list (APPEND TEST_SOURCE_FILES
   tests/test_solventprops_ad.cpp
   tests/test_multisegmentwells.cpp
   tests/test_multiphaseupwind.cpp
+  tests/test_paralleloverlappingilu0.cpp
+  tests/test_blockcprpreconditioner.cpp
+  tests/test_performancetrace.cpp
+  tests/test_startupcache.cpp
+  tests/test_outputshard.cpp
+  tests/test_checkpointfile.cpp
+  tests/test_wellchangetracker.cpp
+  tests/test_perforationblocks.cpp
+  tests/test_linearsystemdump.cpp
+  tests/test_forcingterm.cpp
+  tests/test_andersonacceleration.cpp
+  tests/test_subdomainpartition.cpp
+  tests/test_adaptiveimplicitjacobian.cpp
+  tests/test_multiscalepressuresolver.cpp
+  tests/test_distributedwells.cpp
+  tests/test_elementcoloring.cpp
+  tests/test_debuglog.cpp
+  tests/test_matrixordering.cpp
+  tests/test_blockmatrixdifference.cpp
+  tests/test_adjointsensitivities.cpp
+  tests/test_recyclinggcrsolver.cpp
+  tests/test_batchedgmressolver.cpp
+  tests/test_segmenttreejacobian.cpp
+  tests/test_timestepcontrol.cpp
+  tests/test_threadhandle.cpp
+  tests/test_ensemblemembers.cpp
+  tests/test_nodesharedarray.cpp
+  tests/test_writevtkdata.cpp
+  tests/test_parallelfilemerger.cpp
+  tests/test_autodiffarena.cpp
+  tests/test_propertycache.cpp
+  tests/test_sumandmaxreduction.cpp
+  tests/test_reorderingschedule.cpp
+  tests/test_indexedlineartable.cpp
+  tests/test_polymermobilities.cpp
+  tests/test_chebyshevsmoother.cpp
+  tests/test_blockkernels.cpp
   # tests/test_thresholdpressure.cpp
   tests/test_wellswitchlogger.cpp
   tests/test_timer.cpp
+  tests/test_timertree.cpp
+  tests/test_rankloadreport.cpp
+  tests/test_metricsexporter.cpp
+  tests/test_hdf5output.cpp
+  tests/test_matlabstepwriter.cpp
+  tests/test_startupprofile.cpp
+  tests/test_pararealiteration.cpp
+  tests/test_variableswitching.cpp
   )
 
 list (APPEND TEST_DATA_FILES
@@ -113,9 +177,12 @@ list (APPEND EXAMPLE_SOURCE_FILES
   #examples/flow_reorder.cpp
   #examples/flow_sequential.cpp
   examples/flow_ebos.cpp
- # examples/flow_ebos_2p.cpp
- # examples/flow_ebos_solvent.cpp
- # examples/flow_ebos_polymer.cpp
+  examples/flow_ebos_solvent.cpp
+  examples/flow_ebos_polymer.cpp
+  examples/flow_ebos_2p.cpp
+  examples/benchmark_autodiff.cpp
+  examples/replay_linear_solver.cpp
+  examples/generate_scaling_deck.cpp
  # examples/flow_multisegment.cpp
  # examples/flow_solvent.cpp
  # examples/sim_2p_incomp.cpp
@@ -136,8 +203,11 @@ list (APPEND PROGRAM_SOURCE_FILES
   #examples/sim_2p_incomp_ad.cpp
   #examples/sim_2p_comp_reorder.cpp
   examples/flow_ebos.cpp
- # examples/flow_ebos_solvent.cpp
- # examples/flow_ebos_polymer.cpp
+  examples/flow_ebos_solvent.cpp
+  examples/flow_ebos_polymer.cpp
+  examples/flow_ebos_2p.cpp
+  examples/replay_linear_solver.cpp
+  examples/generate_scaling_deck.cpp
  # examples/flow_legacy.cpp
  # examples/flow_reorder.cpp
  # examples/flow_sequential.cpp
@@ -152,13 +222,18 @@ list (APPEND PROGRAM_SOURCE_FILES
 # find opm -name '*.h*' -a ! -name '*-pch.hpp' -printf '\t%p\n' | sort
 list (APPEND PUBLIC_HEADER_FILES
   opm/autodiff/AdditionalObjectDeleter.hpp
+  opm/autodiff/AutoDiffArena.hpp
   opm/autodiff/AutoDiffBlock.hpp
+  opm/autodiff/AutoDiffGather.hpp
   opm/autodiff/AutoDiffHelpers.hpp
   opm/autodiff/AutoDiffMatrix.hpp
+  opm/autodiff/AutoDiffStencil.hpp
+  opm/autodiff/AutoDiffThreading.hpp
   opm/autodiff/AutoDiff.hpp
   opm/autodiff/BackupRestore.hpp
   opm/autodiff/BlackoilDetails.hpp
   opm/autodiff/BlackoilLegacyDetails.hpp
+  opm/autodiff/VariableSwitching.hpp
   opm/autodiff/BlackoilModel.hpp
   opm/autodiff/BlackoilModelBase.hpp
   opm/autodiff/BlackoilModelBase_impl.hpp
@@ -168,6 +243,8 @@ list (APPEND PUBLIC_HEADER_FILES
   opm/autodiff/BlackoilPropsAdFromDeck.hpp
   opm/autodiff/SolventPropsAdFromDeck.hpp
   opm/autodiff/Compat.hpp
+  opm/autodiff/ChebyshevSmoother.hpp
+  opm/autodiff/CellDataView.hpp
   opm/autodiff/CPRPreconditioner.hpp
   opm/autodiff/createGlobalCellArray.hpp
   opm/autodiff/DefaultBlackoilSolutionState.hpp
@@ -177,10 +254,12 @@ list (APPEND PUBLIC_HEADER_FILES
   opm/autodiff/BlackoilMultiSegmentModel.hpp
   opm/autodiff/BlackoilMultiSegmentModel_impl.hpp
   opm/autodiff/BlackoilReorderingTransportModel.hpp
+  opm/autodiff/ReorderingSchedule.hpp
   opm/autodiff/BlackoilTransportModel.hpp
   opm/autodiff/fastSparseOperations.hpp
   opm/autodiff/DebugTimeReport.hpp
   opm/autodiff/DuneMatrix.hpp
+  opm/autodiff/ElementColoring.hpp
   opm/autodiff/ExtractParallelGridInformationToISTL.hpp
   opm/autodiff/FlowMain.hpp
   opm/autodiff/FlowMainEbos.hpp
@@ -189,6 +268,7 @@ list (APPEND PUBLIC_HEADER_FILES
   opm/autodiff/FlowMainSolvent.hpp
   opm/autodiff/GeoProps.hpp
   opm/autodiff/GridHelpers.hpp
+  opm/autodiff/GridTopology.hpp
   opm/autodiff/GridInit.hpp
   opm/autodiff/ImpesTPFAAD.hpp
   opm/autodiff/ISTLSolver.hpp
@@ -199,13 +279,60 @@ list (APPEND PUBLIC_HEADER_FILES
   opm/autodiff/NewtonIterationBlackoilInterface.hpp
   opm/autodiff/NewtonIterationBlackoilInterleaved.hpp
   opm/autodiff/NewtonIterationBlackoilSimple.hpp
+  opm/autodiff/LinearSolverReuseAmg.hpp
   opm/autodiff/NewtonIterationUtilities.hpp
   opm/autodiff/NonlinearSolver.hpp
   opm/autodiff/NonlinearSolver_impl.hpp
   opm/autodiff/LinearisedBlackoilResidual.hpp
   opm/autodiff/ParallelDebugOutput.hpp
   opm/autodiff/ParallelOverlappingILU0.hpp
+  opm/autodiff/OwnerToAllExchange.hpp
+  opm/autodiff/MixedPrecisionPreconditioner.hpp
+  opm/autodiff/MemoryUsage.hpp
+  opm/autodiff/MatrixOrdering.hpp
+  opm/autodiff/LocalIndex.hpp
+  opm/autodiff/BlockMatrixDifference.hpp
+  opm/autodiff/AdjointSensitivities.hpp
+  opm/autodiff/FirstTouchAllocator.hpp
+  opm/autodiff/BlockCPRPreconditioner.hpp
+  opm/autodiff/BlockKernels.hpp
+  opm/autodiff/PerformanceSummary.hpp
+  opm/autodiff/PerformanceTrace.hpp
+  opm/autodiff/StartupCache.hpp
+  opm/autodiff/OutputShard.hpp
+  opm/autodiff/CheckpointFile.hpp
+  opm/autodiff/EnsembleMembers.hpp
+  opm/autodiff/NodeSharedArray.hpp
+  opm/autodiff/DeckStaging.hpp
+  opm/autodiff/DebugLog.hpp
+  opm/autodiff/TimerTree.hpp
+  opm/autodiff/RankLoadReport.hpp
+  opm/autodiff/HardwareCounters.hpp
+  opm/autodiff/Hdf5Output.hpp
+  opm/autodiff/MatlabStepWriter.hpp
+  opm/autodiff/MemoryTracker.hpp
+  opm/autodiff/StartupProfile.hpp
+  opm/autodiff/PararealPropagators.hpp
+  opm/autodiff/OutputPrecision.hpp
+  opm/autodiff/ProfilerAnnotations.hpp
+  opm/autodiff/WellChangeTracker.hpp
+  opm/autodiff/PerforationBlocks.hpp
+  opm/autodiff/LinearSystemDump.hpp
+  opm/autodiff/AndersonAcceleration.hpp
+  opm/autodiff/SubdomainPartition.hpp
+  opm/autodiff/AdaptiveImplicitJacobian.hpp
+  opm/autodiff/MultiscalePressureSolver.hpp
+  opm/autodiff/CartesianToCompressed.hpp
+  opm/autodiff/DistributedWells.hpp
+  opm/autodiff/PropertyCache.hpp
+  opm/autodiff/SumAndMaxReduction.hpp
+  opm/autodiff/PartitionWeights.hpp
+  opm/autodiff/LoadImbalanceMonitor.hpp
+  opm/autodiff/RecyclingGCRSolver.hpp
+  opm/autodiff/BatchedGMResSolver.hpp
+  opm/autodiff/SegmentTreeJacobian.hpp
   opm/autodiff/ParallelRestrictedAdditiveSchwarz.hpp
+  opm/autodiff/SubdomainDirectSolver.hpp
   opm/autodiff/RateConverter.hpp
   opm/autodiff/RedistributeDataHandles.hpp
   opm/autodiff/SimFIBODetails.hpp
@@ -256,6 +383,7 @@ list (APPEND PUBLIC_HEADER_FILES
   opm/polymer/SinglePointUpwindTwoPhasePolymer.hpp
   opm/polymer/TransportSolverTwophaseCompressiblePolymer.hpp
   opm/polymer/Point2D.hpp
+  opm/polymer/IndexedLinearTable.hpp
   opm/polymer/TransportSolverTwophasePolymer.hpp
   opm/polymer/fullyimplicit/PolymerPropsAd.hpp
   opm/polymer/fullyimplicit/BlackoilPolymerModel.hpp
@@ -269,10 +397,12 @@ list (APPEND PUBLIC_HEADER_FILES
   opm/simulators/SimulatorIncompTwophase.hpp
   opm/simulators/thresholdPressures.hpp
   opm/simulators/WellSwitchingLogger.hpp
+  opm/simulators/MetricsExporter.hpp
   opm/simulators/vtk/writeVtkData.hpp
   opm/simulators/timestepping/AdaptiveSimulatorTimer.hpp
   opm/simulators/timestepping/AdaptiveTimeStepping.hpp
   opm/simulators/timestepping/AdaptiveTimeStepping_impl.hpp
+  opm/simulators/timestepping/PararealIteration.hpp
   opm/simulators/timestepping/TimeStepControl.hpp
   opm/simulators/timestepping/TimeStepControlInterface.hpp
   opm/simulators/timestepping/SimulatorTimer.hpp
@@ -92,6 +92,36 @@ macro (add_test_compare_parallel_simulation casename filename simulator abs_tol
                TEST_ARGS ${OPM_DATA_ROOT}/${casename}/${filename})
 endmacro (add_test_compare_parallel_simulation)
 
+###########################################################################
+# TEST: add_test_performance
+###########################################################################
+
+# Input:
+#   - casename: basename (no extension)
+#   - threshold: allowed relative growth of times, iterations and memory
+#
+# Details:
+#   - This test class compares the performance summary of a simulation
+#     to a baseline recorded on the same machine. The tests only run in
+#     the performance configuration, i.e. with ctest -C performance.
+macro (add_test_performance casename filename simulator threshold)
+  if(${ARGC} GREATER 4)
+    set(DIR ${ARGV4})
+  else()
+    set(DIR ${casename})
+  endif()
+  set(RESULT_PATH ${BASE_RESULT_PATH}/performance/${simulator}+${casename})
+  opm_add_test(performance_${simulator}+${filename} NO_COMPILE
+               EXE_NAME ${simulator}
+               DRIVER_ARGS ${OPM_DATA_ROOT}/${DIR} ${RESULT_PATH}
+                           ${CMAKE_BINARY_DIR}/bin
+                           ${filename}
+                           ${threshold}
+                           ${OPM_PERFORMANCE_BASELINE_DIR}
+               TEST_ARGS ${OPM_DATA_ROOT}/${DIR}/${filename}
+               CONFIGURATION performance)
+endmacro (add_test_performance)
+
 if(NOT TARGET test-suite)
   add_custom_target(test-suite)
 endif()
@@ -149,3 +179,23 @@ if(MPI_FOUND)
   endforeach()
   add_test_compare_parallel_simulation(spe3 SPE3CASE1 flow_mpi ${abs_tol_parallel} ${rel_tol_parallel})
 endif()
+
+# Performance tests
+opm_set_test_driver(${PROJECT_SOURCE_DIR}/tests/run-performanceTest.sh "")
+
+set(OPM_PERFORMANCE_BASELINE_DIR ${PROJECT_BINARY_DIR}/tests/performance-baseline
+    CACHE PATH "Directory of the baselines of the performance tests")
+set(OPM_PERFORMANCE_THRESHOLD 0.1
+    CACHE STRING "Allowed relative growth of times, iterations and memory in the performance tests")
+
+add_test_performance(spe1 SPE1CASE2 flow_ebos ${OPM_PERFORMANCE_THRESHOLD})
+add_test_performance(spe3 SPE3CASE1 flow_ebos ${OPM_PERFORMANCE_THRESHOLD})
+add_test_performance(spe9 SPE9_CP_SHORT flow_ebos ${OPM_PERFORMANCE_THRESHOLD})
+add_test_performance(norne NORNE_ATW2013 flow_ebos ${OPM_PERFORMANCE_THRESHOLD})
+
+if(NOT TARGET performance-suite)
+  add_custom_target(performance-suite
+                    COMMAND ${CMAKE_CTEST_COMMAND} -C performance -R "^performance_" --output-on-failure
+                    WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+  add_dependencies(performance-suite flow_ebos)
+endif()
@@ -0,0 +1,280 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Micro-benchmarks of the building blocks of the legacy automatic
+// differentiation path: AutoDiffBlock arithmetic, AutoDiffMatrix sums and
+// products of all combinations of matrix types, the fast sparse products
+// and subset/superset.
+//
+// Parameters:
+//   min_time=<seconds>  minimum time spent on each benchmark (default 0.2)
+//   sizes=<n1,n2,...>   numbers of cells (default 10000,100000)
+//   filter=<string>     only run benchmarks whose name contains the string
+//   json_file=<file>    also write the results as JSON lines to file
+
+#include "config.h"
+
+#include <opm/autodiff/AutoDiffBlock.hpp>
+#include <opm/autodiff/AutoDiffHelpers.hpp>
+#include <opm/autodiff/AutoDiffMatrix.hpp>
+#include <opm/autodiff/fastSparseOperations.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    typedef Opm::AutoDiffBlock<double> ADB;
+    typedef ADB::V V;
+    typedef ADB::M M;
+    typedef Eigen::SparseMatrix<double> Sp;
+
+    // Results are accumulated here so that the benchmarked operations
+    // cannot be optimized away.
+    volatile double sink = 0.0;
+
+    class BenchmarkRunner
+    {
+    public:
+        BenchmarkRunner(const double minTime, const std::string& filter, const std::string& jsonFile)
+            : minTime_(minTime), filter_(filter)
+        {
+            if (!jsonFile.empty()) {
+                json_.reset(new std::ofstream(jsonFile.c_str()));
+                if (!*json_) {
+                    std::cerr << "Could not open " << jsonFile << std::endl;
+                    std::exit(EXIT_FAILURE);
+                }
+            }
+            std::cout << std::left << std::setw(40) << "benchmark" << std::right
+                      << std::setw(10) << "size" << std::setw(14) << "ns/op"
+                      << std::setw(12) << "runs" << "\n";
+        }
+
+        /// Run f in batches until minTime has passed and report the median
+        /// time per call of the batches.
+        template <class F>
+        void run(const std::string& name, const int size, F&& f)
+        {
+            if (name.find(filter_) == std::string::npos) {
+                return;
+            }
+            typedef std::chrono::steady_clock Clock;
+
+            // find a batch size of roughly a hundredth of the minimum time
+            int batch = 1;
+            for (;;) {
+                const auto start = Clock::now();
+                for (int i = 0; i < batch; ++i) {
+                    f();
+                }
+                const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+                if (elapsed > minTime_ / 100.0 || batch >= (1 << 24)) {
+                    break;
+                }
+                batch *= 2;
+            }
+
+            std::vector<double> times;
+            double total = 0.0;
+            while (total < minTime_ || times.size() < 5) {
+                const auto start = Clock::now();
+                for (int i = 0; i < batch; ++i) {
+                    f();
+                }
+                const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+                times.push_back(elapsed / batch);
+                total += elapsed;
+            }
+            std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+            const double ns = 1e9 * times[times.size() / 2];
+            const long runs = long(times.size()) * batch;
+
+            std::cout << std::left << std::setw(40) << name << std::right
+                      << std::setw(10) << size << std::setw(14) << std::setprecision(6) << ns
+                      << std::setw(12) << runs << std::endl;
+            if (json_) {
+                *json_ << "{\"name\": \"" << name << "\", \"size\": " << size
+                       << ", \"ns_per_op\": " << ns << ", \"runs\": " << runs << "}\n";
+            }
+        }
+
+    private:
+        double minTime_;
+        std::string filter_;
+        std::unique_ptr<std::ofstream> json_;
+    };
+
+    V randomValues(const int n, const double low, const double high)
+    {
+        V v(n);
+        for (int i = 0; i < n; ++i) {
+            v[i] = low + (high - low) * (std::rand() / double(RAND_MAX));
+        }
+        return v;
+    }
+
+    // A seven point stencil on an n-cell grid with 100 cells per row and
+    // 10000 cells per layer, roughly the Jacobian blocks of a reservoir grid.
+    Sp stencilMatrix(const int n)
+    {
+        std::vector<Eigen::Triplet<double>> t;
+        t.reserve(7 * n);
+        const int offsets[] = { -10000, -100, -1, 0, 1, 100, 10000 };
+        for (int row = 0; row < n; ++row) {
+            for (const int off : offsets) {
+                const int col = row + off;
+                if (col >= 0 && col < n) {
+                    t.emplace_back(row, col, off == 0 ? 6.0 : -1.0);
+                }
+            }
+        }
+        Sp s(n, n);
+        s.setFromTriplets(t.begin(), t.end());
+        return s;
+    }
+
+    // One matrix of each AutoDiffMatrix type, with its name.
+    std::vector<std::pair<std::string, M>> matrixTypes(const int n)
+    {
+        const Sp s = stencilMatrix(n);
+        std::vector<std::pair<std::string, M>> m;
+        m.emplace_back("zero", M(n, n));
+        m.emplace_back("identity", M::createIdentity(n));
+        m.emplace_back("diagonal", M(randomValues(n, 1.0, 2.0).matrix().asDiagonal()));
+        m.emplace_back("sparse", M(s));
+        m.emplace_back("stencil", M::createStencil(s));
+        return m;
+    }
+
+    void benchmarkAutoDiffBlock(BenchmarkRunner& runner, const int n)
+    {
+        // three cell variables and a handful of well variables, like the
+        // black-oil models
+        const std::vector<int> blocksizes = { n, n, n, 10 };
+        const ADB x = ADB::variable(0, randomValues(n, 1.0, 2.0), blocksizes);
+        const ADB y = ADB::variable(1, randomValues(n, 1.0, 2.0), blocksizes);
+        const ADB z = x * y + y;
+        const V v = randomValues(n, 1.0, 2.0);
+
+        runner.run("adb_add", n, [&]() { sink = sink + (x + y).value()[0]; });
+        runner.run("adb_sub", n, [&]() { sink = sink + (x - y).value()[0]; });
+        runner.run("adb_mul", n, [&]() { sink = sink + (x * y).value()[0]; });
+        runner.run("adb_div", n, [&]() { sink = sink + (x / y).value()[0]; });
+        runner.run("adb_mul_composite", n, [&]() { sink = sink + (z * x).value()[0]; });
+        runner.run("adb_mul_vector", n, [&]() { sink = sink + (x * v).value()[0]; });
+        runner.run("adb_mul_scalar", n, [&]() { sink = sink + (2.0 * z).value()[0]; });
+        runner.run("adb_expression", n, [&]() { sink = sink + ((x * y + z) / (x + v)).value()[0]; });
+
+        std::vector<int> half;
+        for (int i = 0; i < n; i += 2) {
+            half.push_back(i);
+        }
+        const ADB zhalf = Opm::subset(z, half);
+        runner.run("adb_subset", n, [&]() { sink = sink + Opm::subset(z, half).value()[0]; });
+        runner.run("adb_superset", n, [&]() { sink = sink + Opm::superset(zhalf, half, n).value()[0]; });
+        runner.run("v_subset", n, [&]() { sink = sink + Opm::subset(v, half)[0]; });
+    }
+
+    void benchmarkAutoDiffMatrix(BenchmarkRunner& runner, const int n)
+    {
+        const auto types = matrixTypes(n);
+        for (const auto& a : types) {
+            for (const auto& b : types) {
+                runner.run("adm_mul_" + a.first + "_" + b.first, n,
+                           [&]() { sink = sink + (a.second * b.second).rows(); });
+            }
+        }
+        for (const auto& a : types) {
+            for (const auto& b : types) {
+                runner.run("adm_add_" + a.first + "_" + b.first, n,
+                           [&]() { sink = sink + (a.second + b.second).rows(); });
+            }
+        }
+    }
+
+    void benchmarkFastSparseOperations(BenchmarkRunner& runner, const int n)
+    {
+        const Sp a = stencilMatrix(n);
+        const Sp b = stencilMatrix(n);
+        const V d = randomValues(n, 1.0, 2.0);
+        Sp res;
+
+        runner.run("fast_sparse_product", n, [&]() {
+                Opm::fastSparseProduct(a, b, res);
+                sink = sink + res.nonZeros();
+            });
+        runner.run("eigen_sparse_product", n, [&]() {
+                res = a * b;
+                sink = sink + res.nonZeros();
+            });
+        runner.run("fast_diag_sparse_product", n, [&]() {
+                Opm::fastDiagSparseProduct(d, a, res);
+                sink = sink + res.nonZeros();
+            });
+        runner.run("fast_sparse_diag_product", n, [&]() {
+                Opm::fastSparseDiagProduct(a, d, res);
+                sink = sink + res.nonZeros();
+            });
+    }
+
+    std::vector<int> parseSizes(const std::string& s)
+    {
+        std::vector<int> sizes;
+        std::istringstream is(s);
+        std::string item;
+        while (std::getline(is, item, ',')) {
+            sizes.push_back(std::atoi(item.c_str()));
+        }
+        return sizes;
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char** argv)
+try
+{
+    Opm::ParameterGroup param(argc, argv, false);
+    const double minTime = param.getDefault("min_time", 0.2);
+    const std::vector<int> sizes = parseSizes(param.getDefault("sizes", std::string("10000,100000")));
+    BenchmarkRunner runner(minTime,
+                           param.getDefault("filter", std::string("")),
+                           param.getDefault("json_file", std::string("")));
+
+    for (const int n : sizes) {
+        benchmarkAutoDiffBlock(runner, n);
+        benchmarkAutoDiffMatrix(runner, n);
+        benchmarkFastSparseOperations(runner, n);
+    }
+    return EXIT_SUCCESS;
+}
+catch (const std::exception& e) {
+    std::cerr << "Program threw an exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,453 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Write a synthetic corner-point deck of any size for scaling studies,
+// see tests/run-scalingStudy.sh. The same parameters give the same deck
+// on every machine.
+//
+// Parameters:
+//   output=<file>          the deck to write (default SCALING.DATA)
+//   case=spe1|spe10        three-phase black oil with the PVT of SPE1, or
+//                          dead oil and water like SPE10 model 2 (default spe1)
+//   nx, ny, nz             the grid dimensions (default 40, 40, 10)
+//   dx, dy, dz             the cell sizes in ft (default 200, 200, 20)
+//   dip                    depth increase in ft per cell in x (default 0)
+//   fault_throw            throw in ft of a fault in the middle of the x
+//                          direction, 0 for none (default 0)
+//   perm_mean              mean permeability in mD (default 100)
+//   perm_log_std           standard deviation of the log-permeability,
+//                          0 for a homogeneous field (default 1)
+//   perm_corr_length       lateral correlation length in cells (default 4)
+//   kv_kh                  ratio of vertical to horizontal permeability (default 0.1)
+//   poro_mean              mean porosity (default 0.2)
+//   injectors, producers   number of water injectors and producers (default 1, 1)
+//   nnc_density            fraction of the cells given an explicit NNC to
+//                          the cell diagonally below it (default 0)
+//   steps, step_days       number and length of the report steps (default 10, 30)
+//   seed                   seed of the random fields (default 1)
+
+#include "config.h"
+
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+    struct DeckParameters
+    {
+        std::string output;
+        std::string caseName;
+        int nx, ny, nz;
+        double dx, dy, dz;
+        double dip;
+        double faultThrow;
+        double permMean;
+        double permLogStd;
+        int permCorrLength;
+        double kvkh;
+        double poroMean;
+        int injectors;
+        int producers;
+        double nncDensity;
+        int steps;
+        double stepDays;
+        unsigned seed;
+
+        explicit DeckParameters(const Opm::ParameterGroup& param)
+        {
+            output = param.getDefault("output", std::string("SCALING.DATA"));
+            caseName = param.getDefault("case", std::string("spe1"));
+            nx = param.getDefault("nx", 40);
+            ny = param.getDefault("ny", 40);
+            nz = param.getDefault("nz", 10);
+            dx = param.getDefault("dx", 200.0);
+            dy = param.getDefault("dy", 200.0);
+            dz = param.getDefault("dz", 20.0);
+            dip = param.getDefault("dip", 0.0);
+            faultThrow = param.getDefault("fault_throw", 0.0);
+            permMean = param.getDefault("perm_mean", 100.0);
+            permLogStd = param.getDefault("perm_log_std", 1.0);
+            permCorrLength = param.getDefault("perm_corr_length", 4);
+            kvkh = param.getDefault("kv_kh", 0.1);
+            poroMean = param.getDefault("poro_mean", 0.2);
+            injectors = param.getDefault("injectors", 1);
+            producers = param.getDefault("producers", 1);
+            nncDensity = param.getDefault("nnc_density", 0.0);
+            steps = param.getDefault("steps", 10);
+            stepDays = param.getDefault("step_days", 30.0);
+            seed = param.getDefault("seed", 1);
+
+            if (caseName != "spe1" && caseName != "spe10") {
+                throw std::invalid_argument("case must be spe1 or spe10, not " + caseName);
+            }
+            if (nx < 1 || ny < 1 || nz < 1 || injectors < 0 || producers < 1 || steps < 1) {
+                throw std::invalid_argument("Invalid grid dimensions, well counts or steps");
+            }
+        }
+
+        bool threePhase() const { return caseName == "spe1"; }
+        int numCells() const { return nx * ny * nz; }
+    };
+
+
+    /// Write the values of an array keyword, with runs of equal values
+    /// written as n*value.
+    template <class T>
+    void writeArray(std::ostream& os, const std::string& keyword, const std::vector<T>& values)
+    {
+        os << keyword << "\n";
+        int onLine = 0;
+        for (std::size_t i = 0; i < values.size(); ) {
+            std::size_t j = i + 1;
+            while (j < values.size() && values[j] == values[i]) {
+                ++j;
+            }
+            if (j - i > 1) {
+                os << (j - i) << "*";
+            }
+            os << values[i];
+            i = j;
+            if (++onLine == 8) {
+                os << "\n";
+                onLine = 0;
+            } else {
+                os << " ";
+            }
+        }
+        os << "/\n\n";
+    }
+
+
+    /// A log-normal field with the given mean, laterally correlated by a box
+    /// filter of the correlation length and uncorrelated between layers.
+    std::vector<double> logNormalField(const DeckParameters& p, std::mt19937& gen,
+                                       const double mean, const double logStd)
+    {
+        const int nx = p.nx, ny = p.ny, nz = p.nz;
+        std::normal_distribution<double> normal(0.0, 1.0);
+        std::vector<double> noise(p.numCells());
+        for (auto& v : noise) {
+            v = normal(gen);
+        }
+
+        const int r = std::max(p.permCorrLength / 2, 0);
+        std::vector<double> field(p.numCells());
+        for (int k = 0; k < nz; ++k) {
+            for (int j = 0; j < ny; ++j) {
+                for (int i = 0; i < nx; ++i) {
+                    double sum = 0.0;
+                    int count = 0;
+                    for (int jj = std::max(j - r, 0); jj <= std::min(j + r, ny - 1); ++jj) {
+                        for (int ii = std::max(i - r, 0); ii <= std::min(i + r, nx - 1); ++ii) {
+                            sum += noise[(k*ny + jj)*nx + ii];
+                            ++count;
+                        }
+                    }
+                    // scaled back to unit variance
+                    field[(k*ny + j)*nx + i] = sum / std::sqrt(double(count));
+                }
+            }
+        }
+
+        for (auto& v : field) {
+            v = mean * std::exp(logStd * v - 0.5 * logStd * logStd);
+        }
+        return field;
+    }
+
+
+    /// The depth of a cell corner, with the fault displacing the cells
+    /// from the middle of the x direction on.
+    double cornerDepth(const DeckParameters& p, const double top, const int i, const int ci,
+                       const int k, const int ck)
+    {
+        double depth = top + (k + ck) * p.dz + p.dip * (i + ci);
+        if (p.faultThrow != 0.0 && i >= p.nx / 2) {
+            depth += p.faultThrow;
+        }
+        return depth;
+    }
+
+
+    void writeGrid(std::ostream& os, const DeckParameters& p, const double top, std::mt19937& gen)
+    {
+        os << "GRID\n\n"
+           << "INIT\n\n"
+           << "SPECGRID\n" << p.nx << " " << p.ny << " " << p.nz << " 1 F /\n\n";
+
+        // vertical pillars
+        std::vector<double> coord;
+        coord.reserve(6 * (p.nx + 1) * (p.ny + 1));
+        const double bottom = top + p.nz * p.dz + p.dip * p.nx + std::abs(p.faultThrow) + p.dz;
+        for (int j = 0; j <= p.ny; ++j) {
+            for (int i = 0; i <= p.nx; ++i) {
+                const double x = i * p.dx, y = j * p.dy;
+                coord.insert(coord.end(), { x, y, top - std::abs(p.faultThrow), x, y, bottom });
+            }
+        }
+        writeArray(os, "COORD", coord);
+
+        std::vector<double> zcorn(8 * p.numCells());
+        for (int k = 0; k < p.nz; ++k) {
+            for (int ck = 0; ck < 2; ++ck) {
+                for (int j = 0; j < p.ny; ++j) {
+                    for (int cj = 0; cj < 2; ++cj) {
+                        for (int i = 0; i < p.nx; ++i) {
+                            for (int ci = 0; ci < 2; ++ci) {
+                                const int index = (((2*k + ck)*2*p.ny + 2*j + cj)*2*p.nx) + 2*i + ci;
+                                zcorn[index] = cornerDepth(p, top, i, ci, k, ck);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        writeArray(os, "ZCORN", zcorn);
+
+        const std::vector<double> permx = logNormalField(p, gen, p.permMean, p.permLogStd);
+        std::vector<double> permz(permx);
+        for (auto& v : permz) {
+            v *= p.kvkh;
+        }
+        // porosity correlated with the permeability, as sqrt(k) for a Carman-Kozeny like rock
+        std::vector<double> poro(p.numCells());
+        for (int c = 0; c < p.numCells(); ++c) {
+            poro[c] = std::min(std::max(p.poroMean * std::sqrt(permx[c] / p.permMean), 0.01), 0.4);
+        }
+        os << std::setprecision(6);
+        writeArray(os, "PERMX", permx);
+        writeArray(os, "PERMY", permx);
+        writeArray(os, "PERMZ", permz);
+        writeArray(os, "PORO", poro);
+
+        if (p.nncDensity > 0.0 && p.nx > 1 && p.nz > 1) {
+            std::uniform_real_distribution<double> uniform(0.0, 1.0);
+            std::ostringstream nnc;
+            int count = 0;
+            for (int k = 0; k < p.nz - 1; ++k) {
+                for (int j = 0; j < p.ny; ++j) {
+                    for (int i = 0; i < p.nx - 1; ++i) {
+                        if (uniform(gen) < p.nncDensity) {
+                            // transmissibility of the harmonic average of the
+                            // vertical permeabilities through a horizontal face
+                            const int c1 = (k*p.ny + j)*p.nx + i;
+                            const int c2 = ((k + 1)*p.ny + j)*p.nx + i + 1;
+                            const double kh = 2.0 / (1.0 / permz[c1] + 1.0 / permz[c2]);
+                            const double trans = 0.001127 * kh * p.dx * p.dy / p.dz;
+                            nnc << " " << i + 1 << " " << j + 1 << " " << k + 1 << " "
+                                << i + 2 << " " << j + 1 << " " << k + 2 << " " << trans << " /\n";
+                            ++count;
+                        }
+                    }
+                }
+            }
+            if (count > 0) {
+                os << "NNC\n" << nnc.str() << "/\n\n";
+            }
+        }
+    }
+
+
+    void writeProps(std::ostream& os, const DeckParameters& p)
+    {
+        os << "PROPS\n\n";
+
+        // Corey relative permeabilities
+        const double swc = 0.2, sor = 0.2, sgc = 0.05;
+        os << "SWOF\n";
+        for (int i = 0; i <= 10; ++i) {
+            const double sw = swc + i * (1.0 - swc - sor) / 10.0;
+            const double swn = (sw - swc) / (1.0 - swc - sor);
+            os << " " << sw << " " << 0.6 * swn * swn << " " << (1.0 - swn) * (1.0 - swn) << " 0\n";
+        }
+        os << " 1.0 1.0 0.0 0 /\n\n";
+
+        if (p.threePhase()) {
+            os << "SGOF\n";
+            const double sgmax = 1.0 - swc;
+            os << " 0 0 1 0\n";
+            for (int i = 0; i <= 10; ++i) {
+                const double sg = sgc + i * (sgmax - sgc) / 10.0;
+                const double sgn = (sg - sgc) / (sgmax - sgc);
+                os << " " << sg << " " << 0.9 * sgn * sgn << " " << (1.0 - sgn) * (1.0 - sgn) << " 0\n";
+            }
+            os << "/\n\n";
+
+            // SPE1
+            os << "PVTW\n 4017.55 1.038 3.22E-6 0.318 0.0 /\n\n"
+               << "ROCK\n 14.7 3.0E-6 /\n\n"
+               << "DENSITY\n 53.66 64.49 0.0533 /\n\n"
+               << "PVDG\n"
+               << " 14.700 166.666 0.008000\n 264.70 12.0930 0.009600\n"
+               << " 514.70 6.27400 0.011200\n 1014.7 3.19700 0.014000\n"
+               << " 2014.7 1.61400 0.018900\n 2514.7 1.29400 0.020800\n"
+               << " 3014.7 1.08000 0.022800\n 4014.7 0.81100 0.026800\n"
+               << " 5014.7 0.64900 0.030900\n 9014.7 0.38600 0.047000 /\n\n"
+               << "PVTO\n"
+               << " 0.0010 14.7 1.0620 1.0400 /\n 0.0905 264.7 1.1500 0.9750 /\n"
+               << " 0.1800 514.7 1.2070 0.9100 /\n 0.3710 1014.7 1.2950 0.8300 /\n"
+               << " 0.6360 2014.7 1.4350 0.6950 /\n 0.7750 2514.7 1.5000 0.6410 /\n"
+               << " 0.9300 3014.7 1.5650 0.5940 /\n"
+               << " 1.2700 4014.7 1.6950 0.5100\n        9014.7 1.5790 0.7400 /\n"
+               << " 1.6180 5014.7 1.8270 0.4490\n        9014.7 1.7370 0.6310 /\n/\n\n";
+        } else {
+            // SPE10 model 2
+            os << "PVTW\n 6000.0 1.01 3.0E-6 0.3 0.0 /\n\n"
+               << "ROCK\n 6000.0 1.0E-6 /\n\n"
+               << "DENSITY\n 53.0 64.0 0.0624 /\n\n"
+               << "PVDO\n 300 1.05 2.85\n 800 1.02 2.99\n 8000 1.01 3.0 /\n\n";
+        }
+    }
+
+
+    /// The cell columns of n wells spread evenly over the grid, shifted by
+    /// half a pattern for the second well kind.
+    std::vector<std::pair<int, int>> wellColumns(const DeckParameters& p, const int n, const bool shifted)
+    {
+        std::vector<std::pair<int, int>> columns;
+        if (n == 0) {
+            return columns;
+        }
+        const int cols = std::max(1, int(std::ceil(std::sqrt(double(n) * p.nx / p.ny))));
+        const int rows = (n + cols - 1) / cols;
+        const double offset = shifted ? 0.0 : 0.5;
+        for (int w = 0; w < n; ++w) {
+            const int r = w / cols, c = w % cols;
+            const int i = std::min(p.nx - 1, int((c + offset) * p.nx / cols));
+            const int j = std::min(p.ny - 1, int((r + offset) * p.ny / rows));
+            columns.emplace_back(i + 1, j + 1);
+        }
+        return columns;
+    }
+
+
+    void writeDeck(std::ostream& os, const DeckParameters& p)
+    {
+        std::mt19937 gen(p.seed);
+        const double top = p.threePhase() ? 8325.0 : 12000.0;
+        const double thickness = p.nz * p.dz + p.dip * p.nx + std::abs(p.faultThrow);
+        const double pressure = p.threePhase() ? 4800.0 : 6000.0;
+        const double bhpProducer = p.threePhase() ? 1000.0 : 4000.0;
+        const double bhpInjector = p.threePhase() ? 9000.0 : 10000.0;
+
+        os << "-- Synthetic " << p.caseName << " deck written by generate_scaling_deck\n-- ";
+        os << "nx=" << p.nx << " ny=" << p.ny << " nz=" << p.nz << " perm_log_std=" << p.permLogStd
+           << " perm_corr_length=" << p.permCorrLength << " fault_throw=" << p.faultThrow
+           << " nnc_density=" << p.nncDensity << " injectors=" << p.injectors
+           << " producers=" << p.producers << " seed=" << p.seed << "\n\n";
+
+        os << "RUNSPEC\n\n"
+           << "DIMENS\n" << p.nx << " " << p.ny << " " << p.nz << " /\n\n"
+           << "OIL\n\nWATER\n\n";
+        if (p.threePhase()) {
+            os << "GAS\n\nDISGAS\n\n";
+        }
+        os << "FIELD\n\n"
+           << "START\n 1 'JAN' 2015 /\n\n"
+           << "EQLDIMS\n 1 /\n\n"
+           << "TABDIMS\n 1 1 20 20 /\n\n"
+           << "WELLDIMS\n " << p.injectors + p.producers << " " << p.nz << " 2 "
+           << p.injectors + p.producers << " /\n\n"
+           << "UNIFOUT\n\n";
+
+        writeGrid(os, p, top, gen);
+        writeProps(os, p);
+
+        os << "SOLUTION\n\n"
+           << "EQUIL\n " << top << " " << pressure << " " << top + thickness + 100.0
+           << " 0 " << top - 100.0 << " 0 1 0 0 /\n\n";
+        if (p.threePhase()) {
+            os << "RSVD\n " << top - 100.0 << " 1.27\n " << top + thickness + 100.0 << " 1.27 /\n\n";
+        }
+
+        os << "SUMMARY\n\nFOPR\nFWPR\nFWIR\nFPR\n\n";
+
+        // inject half of the pore volume over the simulated time
+        const double poreVolume = p.numCells() * p.dx * p.dy * p.dz * p.poroMean / 5.615;
+        const double totalDays = p.steps * p.stepDays;
+        const double rate = 0.5 * poreVolume / totalDays;
+
+        os << "SCHEDULE\n\n";
+        const auto inj = wellColumns(p, p.injectors, true);
+        const auto prod = wellColumns(p, p.producers, false);
+        os << "WELSPECS\n";
+        for (std::size_t w = 0; w < inj.size(); ++w) {
+            os << " 'I" << w + 1 << "' 'G1' " << inj[w].first << " " << inj[w].second << " 1* 'WATER' /\n";
+        }
+        for (std::size_t w = 0; w < prod.size(); ++w) {
+            os << " 'P" << w + 1 << "' 'G1' " << prod[w].first << " " << prod[w].second << " 1* 'OIL' /\n";
+        }
+        os << "/\n\nCOMPDAT\n";
+        for (std::size_t w = 0; w < inj.size(); ++w) {
+            os << " 'I" << w + 1 << "' 2* 1 " << p.nz << " 'OPEN' 2* 0.5 /\n";
+        }
+        for (std::size_t w = 0; w < prod.size(); ++w) {
+            os << " 'P" << w + 1 << "' 2* 1 " << p.nz << " 'OPEN' 2* 0.5 /\n";
+        }
+        os << "/\n\nWCONPROD\n";
+        for (std::size_t w = 0; w < prod.size(); ++w) {
+            os << " 'P" << w + 1 << "' 'OPEN' 'LRAT' 3* " << rate / prod.size() << " 1* "
+               << bhpProducer << " /\n";
+        }
+        os << "/\n\n";
+        if (!inj.empty()) {
+            os << "WCONINJE\n";
+            for (std::size_t w = 0; w < inj.size(); ++w) {
+                os << " 'I" << w + 1 << "' 'WATER' 'OPEN' 'RATE' " << rate / inj.size() << " 1* "
+                   << bhpInjector << " /\n";
+            }
+            os << "/\n\n";
+        }
+        os << "TSTEP\n " << p.steps << "*" << p.stepDays << " /\n\nEND\n";
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char** argv)
+try
+{
+    Opm::ParameterGroup param(argc, argv, false);
+    const DeckParameters p(param);
+
+    std::ofstream os(p.output.c_str());
+    if (!os) {
+        std::cerr << "Could not open " << p.output << std::endl;
+        return EXIT_FAILURE;
+    }
+    writeDeck(os, p);
+    std::cout << "Wrote " << p.output << " with " << p.numCells() << " cells" << std::endl;
+    return EXIT_SUCCESS;
+}
+catch (const std::exception& e) {
+    std::cerr << "Program threw an exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,181 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Solve a linear system written by flow_ebos with dump_linear_system=...,
+// see LinearSystemDump.hpp, with the linear solver parameters given on the
+// command line, e.g.
+//
+//   replay_linear_solver dump_file=linear_system_00012_it3.bin use_cpr=true
+//
+// All parameters of ISTLSolver are accepted, in addition to
+//   dump_file=<file>  the linear system to solve
+//   repeat=<n>        number of times to solve the system (default 1)
+
+#include "config.h"
+
+#define FLOW_SUPPORT_AMG 1
+
+#include <opm/autodiff/ISTLSolver.hpp>
+#include <opm/autodiff/LinearSystemDump.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/timer.hh>
+#include <dune/istl/operators.hh>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+    /// The operator A - B^T inv(D) C of a dumped linear system, the
+    /// counterpart of the WellModelMatrixAdapter of BlackoilModelEbos.
+    template <class System>
+    class DumpedSystemOperator
+        : public Dune::AssembledLinearOperator<typename System::Matrix,
+                                               typename System::Vector,
+                                               typename System::Vector>
+    {
+    public:
+        typedef typename System::Matrix matrix_type;
+        typedef typename System::Vector domain_type;
+        typedef typename System::Vector range_type;
+        typedef typename domain_type::field_type field_type;
+
+        enum {
+            //! \brief The solver category.
+            category = Dune::SolverCategory::sequential
+        };
+
+        explicit DumpedSystemOperator(const System& system)
+            : system_(system)
+        {
+        }
+
+        virtual void apply(const domain_type& x, range_type& y) const
+        {
+            system_.A.mv(x, y);
+            system_.applyWells(x, y);
+        }
+
+        // y += \alpha * A * x
+        virtual void applyscaleadd(field_type alpha, const domain_type& x, range_type& y) const
+        {
+            range_type Ax(y.size());
+            apply(x, Ax);
+            y.axpy(alpha, Ax);
+        }
+
+        virtual const matrix_type& getmat() const { return system_.A; }
+
+    private:
+        const System& system_;
+    };
+
+
+    template <int n>
+    int replay(const Opm::ParameterGroup& param, const std::string& filename)
+    {
+        typedef Dune::FieldMatrix<double, n, n> MatrixBlock;
+        typedef Dune::FieldVector<double, n> VectorBlock;
+        typedef Opm::LinearSystemDump<MatrixBlock, VectorBlock> System;
+        typedef typename System::Vector Vector;
+
+        Dune::Timer timer;
+        System system;
+        Opm::readLinearSystem(filename, system);
+        std::cout << "Read " << filename << " in " << timer.elapsed() << " s: "
+                  << system.A.N() << " cells, " << system.A.nonzeroes() << " nonzero blocks of size "
+                  << n << ", " << system.invD.N() << " wells, Newton iteration "
+                  << system.newtonIteration << ", linear solve " << system.linearSolve << std::endl;
+
+        const int repeat = param.getDefault("repeat", 1);
+        Opm::ISTLSolver<MatrixBlock, VectorBlock> solver(param);
+        DumpedSystemOperator<System> opA(system);
+        const double bnorm = system.b.two_norm();
+
+        bool allConverged = true;
+        std::cout << std::setw(6) << "solve" << std::setw(12) << "iterations"
+                  << std::setw(11) << "converged" << std::setw(14) << "setup [s]"
+                  << std::setw(14) << "krylov [s]" << std::setw(14) << "total [s]"
+                  << std::setw(16) << "reduction" << std::endl;
+        for (int i = 0; i < repeat; ++i) {
+            Vector x(system.b.size());
+            x = 0.0;
+            Vector b(system.b);
+            bool converged = true;
+            timer.reset();
+            try {
+                solver.solve(opA, x, b);
+                converged = solver.converged();
+            }
+            catch (const Opm::LinearSolverProblem&) {
+                converged = false;
+            }
+            const double total = timer.elapsed();
+
+            // the reduction of the residual that the solution achieves
+            Vector r(system.b);
+            opA.applyscaleadd(-1.0, x, r);
+            const double reduction = bnorm > 0.0 ? r.two_norm() / bnorm : 0.0;
+
+            allConverged = allConverged && converged;
+            std::cout << std::setw(6) << i << std::setw(12) << solver.iterations()
+                      << std::setw(11) << (converged ? "yes" : "no")
+                      << std::setw(14) << solver.preconditionerSetupTime()
+                      << std::setw(14) << solver.krylovSolveTime()
+                      << std::setw(14) << total
+                      << std::setw(16) << reduction << std::endl;
+        }
+        return allConverged ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+} // anonymous namespace
+
+
+int main(int argc, char** argv)
+try
+{
+    Dune::MPIHelper::instance(argc, argv);
+    Opm::ParameterGroup param(argc, argv, false);
+    const std::string filename = param.get<std::string>("dump_file");
+
+    const int blockSize = Opm::readLinearSystemBlockSize(filename);
+    switch (blockSize) {
+    case 2:
+        return replay<2>(param, filename);
+    case 3:
+        return replay<3>(param, filename);
+    case 4:
+        return replay<4>(param, filename);
+    default:
+        std::cerr << "Linear systems of block size " << blockSize << " are not supported" << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+catch (const std::exception& e) {
+    std::cerr << "Program threw an exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+}
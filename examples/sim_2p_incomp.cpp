@@ -40,6 +40,7 @@
 #include <opm/core/props/rock/RockCompressibility.hpp>
 
 #include <opm/core/linalg/LinearSolverFactory.hpp>
+#include <opm/autodiff/LinearSolverReuseAmg.hpp>
 
 #include <opm/core/simulator/TwophaseState.hpp>
 #include <opm/core/simulator/WellState.hpp>
@@ -201,8 +202,14 @@ try
         bcs.pressureSide(*grid->c_grid(), FlowBCManager::Side(pside), pside_pressure);
     }
 
-    // Linear solver.
-    LinearSolverFactory linsolver(param);
+    // Linear solver, optionally one keeping the matrix and the AMG setup
+    // between the pressure solves.
+    std::unique_ptr<LinearSolverInterface> linsolver;
+    if (param.getDefault("linsolver_reuse_amg", false)) {
+        linsolver.reset(new LinearSolverReuseAmg(param));
+    } else {
+        linsolver.reset(new LinearSolverFactory(param));
+    }
 
     // Write parameters used for later reference.
     bool output = param.getDefault("output", true);
@@ -234,7 +241,7 @@ try
                                           wells,
                                           src,
                                           bcs.c_bcs(),
-                                          linsolver,
+                                          *linsolver,
                                           grav);
         SimulatorTimer simtimer;
         simtimer.init(param);
@@ -284,7 +291,7 @@ try
                                               wells,
                                               src,
                                               bcs.c_bcs(),
-                                              linsolver,
+                                              *linsolver,
                                               grav);
             if (reportStepIdx == 0) {
                 warnIfUnusedParams(param);
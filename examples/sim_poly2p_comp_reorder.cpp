@@ -40,6 +40,7 @@
 #include <opm/core/props/rock/RockCompressibility.hpp>
 
 #include <opm/core/linalg/LinearSolverFactory.hpp>
+#include <opm/autodiff/LinearSolverReuseAmg.hpp>
 
 #include <opm/polymer/PolymerBlackoilState.hpp>
 #include <opm/core/simulator/WellState.hpp>
@@ -58,6 +59,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <numeric>
 
@@ -218,8 +220,14 @@ try
     bool use_gravity = (gravity[0] != 0.0 || gravity[1] != 0.0 || gravity[2] != 0.0);
     const double *grav = use_gravity ? &gravity[0] : 0;
 
-    // Linear solver.
-    LinearSolverFactory linsolver(param);
+    // Linear solver, optionally one keeping the matrix and the AMG setup
+    // between the pressure solves.
+    std::unique_ptr<LinearSolverInterface> linsolver;
+    if (param.getDefault("linsolver_reuse_amg", false)) {
+        linsolver.reset(new LinearSolverReuseAmg(param));
+    } else {
+        linsolver.reset(new LinearSolverFactory(param));
+    }
 
     // Write parameters used for later reference.
     bool output = param.getDefault("output", true);
@@ -248,7 +256,7 @@ try
                                                rock_comp->isActive() ? rock_comp.get() : 0,
                                                wells,
                                                polymer_inflow,
-                                               linsolver,
+                                               *linsolver,
                                                grav);
         SimulatorTimer simtimer;
         simtimer.init(param);
@@ -310,7 +318,7 @@ try
                                                    rock_comp->isActive() ? rock_comp.get() : 0,
                                                    wells,
                                                    *polymer_inflow,
-                                                   linsolver,
+                                                   *linsolver,
                                                    grav);
             if (reportStepIdx == 0) {
                 warnIfUnusedParams(param);
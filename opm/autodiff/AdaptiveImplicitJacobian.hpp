@@ -0,0 +1,135 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_ADAPTIVEIMPLICITJACOBIAN_HEADER_INCLUDED
+#define OPM_ADAPTIVEIMPLICITJACOBIAN_HEADER_INCLUDED
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace Opm
+{
+
+    // Functions for an adaptive implicit Jacobian of the mass balance
+    // equations: in a cell treated explicitly, the fluxes do not depend on
+    // the primary variables of the cell other than the pressure, as in
+    // IMPES. The flux derivatives with respect to these variables are found
+    // in the off-diagonal blocks of the column of the cell, in the diagonal
+    // block they are cancelled by the column sum of the off-diagonal blocks
+    // since the fluxes are conservative.
+
+    namespace AdaptiveImplicitDetail
+    {
+        /// The sums of the off-diagonal blocks of the columns of A.
+        template <class M>
+        void offDiagonalColumnSums(const M& A, std::vector<typename M::block_type>& sums)
+        {
+            typename M::block_type zero;
+            zero = 0.0;
+            sums.assign(A.M(), zero);
+            for (auto row = A.begin(); row != A.end(); ++row) {
+                for (auto col = row->begin(); col != row->end(); ++col) {
+                    if (col.index() != row.index()) {
+                        sums[col.index()] += *col;
+                    }
+                }
+            }
+        }
+    } // namespace AdaptiveImplicitDetail
+
+
+
+    /// Estimate the CFL number of each cell from the Jacobian A, as the ratio
+    /// of the flux and the accumulation derivatives with respect to the
+    /// primary variables other than pressureIdx. Cells without accumulation
+    /// derivatives get an infinite ratio.
+    template <class M>
+    void throughputRatios(const M& A, const int pressureIdx, std::vector<double>& ratios)
+    {
+        typedef typename M::block_type Block;
+        std::vector<Block> sums;
+        AdaptiveImplicitDetail::offDiagonalColumnSums(A, sums);
+
+        ratios.assign(A.N(), std::numeric_limits<double>::infinity());
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            const std::size_t cell = row.index();
+            if (!A.exists(cell, cell)) {
+                continue;
+            }
+            const Block& diagonal = (*row)[cell];
+            const Block& flux = sums[cell];
+            double fluxDerivatives = 0.0;
+            double accumulationDerivatives = 0.0;
+            for (int i = 0; i < Block::rows; ++i) {
+                for (int j = 0; j < Block::cols; ++j) {
+                    if (j != pressureIdx) {
+                        fluxDerivatives += std::abs(flux[i][j]);
+                        accumulationDerivatives += std::abs(diagonal[i][j] + flux[i][j]);
+                    }
+                }
+            }
+            if (accumulationDerivatives > 0.0) {
+                ratios[cell] = fluxDerivatives / accumulationDerivatives;
+            }
+        }
+    }
+
+
+
+    /// Remove the flux derivatives with respect to the primary variables
+    /// other than pressureIdx of the cells with isExplicit set from the
+    /// Jacobian A, i.e. zero these columns of the off-diagonal blocks and
+    /// subtract them from the diagonal block. The sparsity pattern of A
+    /// is kept.
+    template <class M>
+    void removeExplicitFluxDerivatives(M& A, const std::vector<char>& isExplicit, const int pressureIdx)
+    {
+        typedef typename M::block_type Block;
+        std::vector<Block> sums;
+        AdaptiveImplicitDetail::offDiagonalColumnSums(A, sums);
+
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = row->begin(); col != row->end(); ++col) {
+                const std::size_t cell = col.index();
+                if (!isExplicit[cell]) {
+                    continue;
+                }
+                Block& block = *col;
+                for (int i = 0; i < Block::rows; ++i) {
+                    for (int j = 0; j < Block::cols; ++j) {
+                        if (j == pressureIdx) {
+                            continue;
+                        }
+                        if (cell == row.index()) {
+                            block[i][j] += sums[cell][i][j];
+                        }
+                        else {
+                            block[i][j] = 0.0;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+} // namespace Opm
+
+#endif // OPM_ADAPTIVEIMPLICITJACOBIAN_HEADER_INCLUDED
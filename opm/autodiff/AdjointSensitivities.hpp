@@ -0,0 +1,402 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_ADJOINTSENSITIVITIES_HEADER_INCLUDED
+#define OPM_ADJOINTSENSITIVITIES_HEADER_INCLUDED
+
+#include <opm/common/ErrorMacros.hpp>
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/solvers.hh>
+
+#include <cstddef>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Gradients of an objective J = sum_n J_n(y_n) of a simulation with
+    /// respect to parameters m by the adjoint method, one forward and one
+    /// backward run instead of a forward run per parameter.
+    ///
+    /// The converged time steps solve R_n(y_n, y_{n-1}, m) = 0 for the cell
+    /// and well variables y_n = (x_n, w_n), with the Jacobian
+    ///
+    ///     J_n = [ A  B^T ]
+    ///           [ C  D   ]
+    ///
+    /// in the format of the Newton iterations, B and C indexed by well and
+    /// cell and D block diagonal. The linearizations of the converged steps
+    /// are recorded in the forward run, the values of A in the order of the
+    /// sparsity pattern of the first step, which the steps share. The
+    /// backward run solves for n = N, ..., 1
+    ///
+    ///     J_n^T l_n = -dJ_n/dy_n - (dR_{n+1}/dy_n)^T l_{n+1}
+    ///
+    /// with the wells eliminated, and the gradient is dJ/dm = sum_n l_n^T
+    /// dR_n/dm. A step depends on the previous one only through the
+    /// accumulation terms M(y)/dt, such that dR_{n+1}/dy_n = -M'(y_n)/dt_{n+1}
+    /// is block diagonal.
+    ///
+    /// The parameters are the pore volume multipliers of the cells, for which
+    /// dR_n/dm_i is the accumulation term (M(x_n) - M(x_{n-1}))/dt_n of cell
+    /// i, and the transmissibility multipliers of the well connections, to
+    /// which the connection rates are proportional.
+    template <class MatrixBlock, class VectorBlock>
+    class AdjointSensitivities
+    {
+    public:
+        typedef Dune::BCRSMatrix<MatrixBlock> Matrix;
+        typedef Dune::BlockVector<VectorBlock> Vector;
+
+        /// The derivatives of the residuals of a cell and a well with respect
+        /// to the transmissibility multiplier of their connection.
+        struct Connection
+        {
+            int parameter;
+            int cell;
+            int well;
+            VectorBlock cellDerivative;
+            VectorBlock wellDerivative;
+        };
+
+        /// The linearization of a converged time step.
+        struct Step
+        {
+            double dt = 0.0;
+            double objective = 0.0;
+            /// the values of A in the order of the sparsity pattern
+            std::vector<MatrixBlock> a;
+            /// the coupling of the wells and cells, empty without wells
+            Matrix b;
+            Matrix c;
+            std::vector<MatrixBlock> d;
+            /// M'(y_n) of the cells and wells
+            std::vector<MatrixBlock> cellStorage;
+            std::vector<MatrixBlock> wellStorage;
+            /// the well names, the well storage couples two steps only if
+            /// they have the same wells
+            std::vector<std::string> wellNames;
+            /// dJ_n/dw_n, the objective does not depend on the cells
+            Vector wellObjective;
+            /// the accumulation terms of the cells
+            Vector accumulation;
+            std::vector<Connection> connections;
+        };
+
+        /// \param[in] reduction      the residual reduction of the linear solves
+        /// \param[in] maxIterations  the iteration limit of the linear solves
+        /// \param[in] minRate        the rate below which the mismatch of a
+        ///                           well rate is absolute instead of relative
+        AdjointSensitivities(const double reduction, const int maxIterations, const double minRate)
+            : reduction_(reduction)
+            , maxIterations_(maxIterations)
+            , minRate_(minRate)
+        {
+        }
+
+        double minRate() const
+        {
+            return minRate_;
+        }
+
+        /// Store the values of the cell matrix of a step. The first step
+        /// defines the sparsity pattern.
+        void storeMatrix(const Matrix& A, Step& step)
+        {
+            if (transposed_.N() == 0) {
+                setPattern(A);
+            }
+            else if (A.N() != transposed_.M() || A.nonzeroes() != transposed_.nonzeroes()) {
+                OPM_THROW(std::logic_error, "The adjoint gradients need the same sparsity pattern in all steps.");
+            }
+            step.a.clear();
+            step.a.reserve(A.nonzeroes());
+            for (auto row = A.begin(); row != A.end(); ++row) {
+                for (auto col = row->begin(); col != row->end(); ++col) {
+                    step.a.push_back(*col);
+                }
+            }
+        }
+
+        /// The parameter index of the connection of a well to a cell.
+        int connectionParameter(const std::string& well, const int cell)
+        {
+            const auto key = std::make_pair(well, cell);
+            const auto it = connectionIndex_.find(key);
+            if (it != connectionIndex_.end()) {
+                return it->second;
+            }
+            const int parameter = connections_.size();
+            connectionIndex_.emplace(key, parameter);
+            connections_.push_back(key);
+            return parameter;
+        }
+
+        /// The well and cell of each connection parameter.
+        const std::vector< std::pair<std::string, int> >& connections() const
+        {
+            return connections_;
+        }
+
+        void addStep(Step&& step)
+        {
+            objective_ += step.objective;
+            steps_.push_back(std::move(step));
+        }
+
+        int numSteps() const
+        {
+            return steps_.size();
+        }
+
+        double objective() const
+        {
+            return objective_;
+        }
+
+        /// The number of bytes of the recorded steps.
+        std::size_t memoryUsage() const
+        {
+            std::size_t bytes = 0;
+            for (const Step& step : steps_) {
+                bytes += (step.a.size() + step.d.size() + step.cellStorage.size() + step.wellStorage.size())
+                    * sizeof(MatrixBlock)
+                    + (step.b.nonzeroes() + step.c.nonzeroes()) * sizeof(MatrixBlock)
+                    + (step.wellObjective.size() + step.accumulation.size()) * sizeof(VectorBlock)
+                    + step.connections.size() * sizeof(Connection);
+            }
+            return bytes;
+        }
+
+        /// Solve the adjoint equations backward in time.
+        /// \param[out] poreVolume  the gradient with respect to the pore
+        ///                         volume multipliers of the cells
+        /// \param[out] connection  the gradient with respect to the
+        ///                         connection parameters
+        void computeGradients(std::vector<double>& poreVolume,
+                              std::vector<double>& connection)
+        {
+            const int nc = transposed_.N();
+            poreVolume.assign(nc, 0.0);
+            connection.assign(connections_.size(), 0.0);
+            Vector lambda(nc);
+            Vector lambdaWells;
+            Vector rhs(nc);
+            Vector rhsWells;
+            for (int n = numSteps() - 1; n >= 0; --n) {
+                const Step& step = steps_[n];
+                const int nw = step.d.size();
+                rhs = 0.0;
+                rhsWells.resize(nw);
+                rhsWells = 0.0;
+                for (int w = 0; w < nw; ++w) {
+                    rhsWells[w] -= step.wellObjective[w];
+                }
+                if (n + 1 < numSteps()) {
+                    const Step& next = steps_[n + 1];
+                    const double scale = 1.0 / next.dt;
+                    for (int i = 0; i < nc; ++i) {
+                        step.cellStorage[i].usmtv(scale, lambda[i], rhs[i]);
+                    }
+                    if (step.wellNames == next.wellNames) {
+                        for (int w = 0; w < nw; ++w) {
+                            step.wellStorage[w].usmtv(scale, lambdaWells[w], rhsWells[w]);
+                        }
+                    }
+                }
+
+                solveTransposed(n, rhs, rhsWells, lambda, lambdaWells);
+
+                for (int i = 0; i < nc; ++i) {
+                    poreVolume[i] += lambda[i] * step.accumulation[i];
+                }
+                for (const Connection& conn : step.connections) {
+                    connection[conn.parameter] += lambda[conn.cell] * conn.cellDerivative
+                        + lambdaWells[conn.well] * conn.wellDerivative;
+                }
+            }
+        }
+
+    private:
+        /// The transposed Schur complement A^T - C^T D^-T B of a step.
+        class TransposedOperator : public Dune::LinearOperator<Vector, Vector>
+        {
+        public:
+            typedef Vector domain_type;
+            typedef Vector range_type;
+            typedef typename Vector::field_type field_type;
+
+            enum {
+                //! \brief The solver category.
+                category = Dune::SolverCategory::sequential
+            };
+
+            TransposedOperator(const Matrix& transposed, const Step& step,
+                               const std::vector<MatrixBlock>& invDT)
+                : transposed_(transposed), step_(step), invDT_(invDT)
+                , bx_(invDT.size()), z_(invDT.size())
+            {
+            }
+
+            virtual void apply(const Vector& x, Vector& y) const
+            {
+                transposed_.mv(x, y);
+                subtractWells(1.0, x, y);
+            }
+
+            virtual void applyscaleadd(field_type alpha, const Vector& x, Vector& y) const
+            {
+                transposed_.usmv(alpha, x, y);
+                subtractWells(alpha, x, y);
+            }
+
+        private:
+            void subtractWells(const field_type alpha, const Vector& x, Vector& y) const
+            {
+                if (invDT_.empty()) {
+                    return;
+                }
+                step_.b.mv(x, bx_);
+                for (std::size_t w = 0; w < invDT_.size(); ++w) {
+                    invDT_[w].mv(bx_[w], z_[w]);
+                }
+                step_.c.usmtv(-alpha, z_, y);
+            }
+
+            const Matrix& transposed_;
+            const Step& step_;
+            const std::vector<MatrixBlock>& invDT_;
+            mutable Vector bx_;
+            mutable Vector z_;
+        };
+
+        /// The transposed sparsity pattern of A and for each of its entries
+        /// the position of the entry of A.
+        void setPattern(const Matrix& A)
+        {
+            const int n = A.N();
+            std::vector<int> rowSize(A.M(), 0);
+            for (auto row = A.begin(); row != A.end(); ++row) {
+                for (auto col = row->begin(); col != row->end(); ++col) {
+                    ++rowSize[col.index()];
+                }
+            }
+            transposed_.setSize(A.M(), n, A.nonzeroes());
+            transposed_.setBuildMode(Matrix::random);
+            std::vector<int> rowStart(A.M() + 1, 0);
+            for (std::size_t r = 0; r < A.M(); ++r) {
+                transposed_.setrowsize(r, rowSize[r]);
+                rowStart[r + 1] = rowStart[r] + rowSize[r];
+            }
+            transposed_.endrowsizes();
+            for (auto row = A.begin(); row != A.end(); ++row) {
+                for (auto col = row->begin(); col != row->end(); ++col) {
+                    transposed_.addindex(col.index(), row.index());
+                }
+            }
+            transposed_.endindices();
+
+            // the rows of A are visited in order, so the entries of each row
+            // of the transpose are filled in order
+            transposeIndex_.assign(A.nonzeroes(), 0);
+            std::vector<int> next(rowStart.begin(), rowStart.end() - 1);
+            int k = 0;
+            for (auto row = A.begin(); row != A.end(); ++row) {
+                for (auto col = row->begin(); col != row->end(); ++col, ++k) {
+                    transposeIndex_[next[col.index()]++] = k;
+                }
+            }
+        }
+
+        /// Solve J_n^T (l, lw) = (rhs, rhsWells) of step n, rhs is overwritten.
+        void solveTransposed(const int n, Vector& rhs, const Vector& rhsWells,
+                             Vector& lambda, Vector& lambdaWells)
+        {
+            const Step& step = steps_[n];
+            int k = 0;
+            for (auto row = transposed_.begin(); row != transposed_.end(); ++row) {
+                for (auto col = row->begin(); col != row->end(); ++col, ++k) {
+                    const MatrixBlock& block = step.a[transposeIndex_[k]];
+                    for (int i = 0; i < MatrixBlock::rows; ++i) {
+                        for (int j = 0; j < MatrixBlock::cols; ++j) {
+                            (*col)[i][j] = block[j][i];
+                        }
+                    }
+                }
+            }
+
+            // the wells are eliminated with D^-T
+            const int nw = step.d.size();
+            std::vector<MatrixBlock> invDT(nw);
+            Vector z(nw);
+            for (int w = 0; w < nw; ++w) {
+                for (int i = 0; i < MatrixBlock::rows; ++i) {
+                    for (int j = 0; j < MatrixBlock::cols; ++j) {
+                        invDT[w][i][j] = step.d[w][j][i];
+                    }
+                }
+                invDT[w].invert();
+                invDT[w].mv(rhsWells[w], z[w]);
+            }
+            if (nw > 0) {
+                step.c.mmtv(z, rhs);
+            }
+
+            TransposedOperator op(transposed_, step, invDT);
+            Dune::SeqILU0<Matrix, Vector, Vector> precond(transposed_, 1.0);
+            Dune::BiCGSTABSolver<Vector> solver(op, precond, reduction_, maxIterations_, /*verbose=*/0);
+            Dune::InverseOperatorResult result;
+            lambda = 0.0;
+            solver.apply(lambda, rhs, result);
+            if (!result.converged) {
+                OPM_THROW(std::runtime_error, "The adjoint system of step " << n << " did not converge.");
+            }
+
+            lambdaWells.resize(nw);
+            if (nw > 0) {
+                Vector r = rhsWells;
+                step.b.mmv(lambda, r);
+                for (int w = 0; w < nw; ++w) {
+                    invDT[w].mv(r[w], lambdaWells[w]);
+                }
+            }
+        }
+
+        double reduction_;
+        int maxIterations_;
+        double minRate_;
+        double objective_ = 0.0;
+        std::vector<Step> steps_;
+        Matrix transposed_;
+        std::vector<int> transposeIndex_;
+        std::map< std::pair<std::string, int>, int > connectionIndex_;
+        std::vector< std::pair<std::string, int> > connections_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_ADJOINTSENSITIVITIES_HEADER_INCLUDED
@@ -0,0 +1,117 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_ANDERSONACCELERATION_HEADER_INCLUDED
+#define OPM_ANDERSONACCELERATION_HEADER_INCLUDED
+
+#include <Eigen/Dense>
+
+#include <deque>
+
+namespace Opm
+{
+
+    /// Anderson acceleration of a fixed-point iteration x = G(x).
+    ///
+    /// Given an iterate x_k and its image g_k = G(x_k), with the residual
+    /// f_k = g_k - x_k, the next iterate is
+    ///
+    ///     x_k+1 = x_k + beta f_k - (dX + beta dF) gamma,
+    ///
+    /// where the columns of dX and dF are the differences of the last
+    /// depth iterates and residuals and gamma minimizes |f_k - dF gamma|.
+    /// With depth 0 this is the relaxed fixed-point iteration
+    /// x_k+1 = x_k + beta f_k.
+    class AndersonAcceleration
+    {
+    public:
+        typedef Eigen::VectorXd Vector;
+
+        /// \param[in] depth       the number of differences kept
+        /// \param[in] relaxation  the relaxation factor beta
+        explicit AndersonAcceleration(const int depth, const double relaxation = 1.0)
+            : depth_(depth), relaxation_(relaxation)
+        {
+        }
+
+        /// Forget the previous iterates, e.g. at the start of a time step.
+        void reset()
+        {
+            dx_.clear();
+            df_.clear();
+            x_.resize(0);
+            f_.resize(0);
+        }
+
+        /// The next iterate of the iterate x with image g = G(x).
+        Vector update(const Vector& x, const Vector& g)
+        {
+            const Vector f = g - x;
+            if (x_.size() == x.size() && depth_ > 0) {
+                dx_.push_back(x - x_);
+                df_.push_back(f - f_);
+                if (static_cast<int>(dx_.size()) > depth_) {
+                    dx_.pop_front();
+                    df_.pop_front();
+                }
+            } else {
+                dx_.clear();
+                df_.clear();
+            }
+            x_ = x;
+            f_ = f;
+
+            Vector next = x + relaxation_ * f;
+            const int m = dx_.size();
+            if (m == 0) {
+                return next;
+            }
+
+            Eigen::MatrixXd dX(x.size(), m);
+            Eigen::MatrixXd dF(x.size(), m);
+            for (int i = 0; i < m; ++i) {
+                dX.col(i) = dx_[i];
+                dF.col(i) = df_[i];
+            }
+            const Vector gamma = dF.colPivHouseholderQr().solve(f);
+            if (!gamma.allFinite()) {
+                // start over from the plain fixed-point update
+                dx_.clear();
+                df_.clear();
+                return next;
+            }
+            next -= (dX + relaxation_ * dF) * gamma;
+            return next;
+        }
+
+        /// The number of differences used by the last update.
+        int historySize() const { return dx_.size(); }
+
+    private:
+        int depth_;
+        double relaxation_;
+        std::deque<Vector> dx_;
+        std::deque<Vector> df_;
+        Vector x_;
+        Vector f_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_ANDERSONACCELERATION_HEADER_INCLUDED
@@ -0,0 +1,193 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_AUTODIFFARENA_HEADER_INCLUDED
+#define OPM_AUTODIFFARENA_HEADER_INCLUDED
+
+#include <cstddef>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Per-thread cache of the storage of short-lived AutoDiff temporaries.
+    ///
+    /// While a Scope is alive on a thread, released buffers are kept in
+    /// lists per size class and handed out again by later allocations of
+    /// the same class, without going through the global heap. When the
+    /// outermost Scope ends, e.g. at the end of an assembly, all cached
+    /// buffers are returned to the heap. The memory held by the cache is
+    /// thereby bounded by the peak of one assembly.
+    ///
+    /// Buffers are always allocated with the size of their class, so
+    /// buffers allocated outside a Scope or on another thread may be
+    /// released into any cache.
+    class AutoDiffArena
+    {
+    public:
+        /// Enables the cache of the calling thread for its lifetime.
+        class Scope
+        {
+        public:
+            Scope()
+            {
+                ++AutoDiffArena::instance().depth_;
+            }
+
+            ~Scope()
+            {
+                AutoDiffArena& arena = AutoDiffArena::instance();
+                if (--arena.depth_ == 0) {
+                    arena.release();
+                }
+            }
+
+        private:
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+        };
+
+        /// The cache of the calling thread.
+        static AutoDiffArena& instance()
+        {
+            static thread_local AutoDiffArena arena;
+            return arena;
+        }
+
+        /// Allocate a buffer for at least bytes bytes.
+        static void* allocate(const std::size_t bytes)
+        {
+            const std::size_t size = sizeClass(bytes);
+            AutoDiffArena& arena = instance();
+            if (arena.depth_ > 0) {
+                auto list = arena.free_.find(size);
+                if (list != arena.free_.end() && !list->second.empty()) {
+                    void* ptr = list->second.back();
+                    list->second.pop_back();
+                    arena.cached_ -= size;
+                    ++arena.reused_;
+                    return ptr;
+                }
+            }
+            return ::operator new(size);
+        }
+
+        /// Release a buffer obtained from allocate(bytes).
+        static void deallocate(void* ptr, const std::size_t bytes)
+        {
+            if (ptr == nullptr) {
+                return;
+            }
+            AutoDiffArena& arena = instance();
+            if (arena.depth_ > 0) {
+                const std::size_t size = sizeClass(bytes);
+                arena.free_[size].push_back(ptr);
+                arena.cached_ += size;
+                return;
+            }
+            ::operator delete(ptr);
+        }
+
+        /// Number of bytes currently cached by the calling thread.
+        std::size_t cachedBytes() const { return cached_; }
+
+        /// Number of allocations served from the cache of the calling thread.
+        std::size_t reusedBuffers() const { return reused_; }
+
+        /// Size of the buffers of the class of bytes. Sizes are rounded up
+        /// to a quarter of their power of two, such that a buffer wastes
+        /// at most a fourth of its size.
+        static std::size_t sizeClass(const std::size_t bytes)
+        {
+            const std::size_t minSize = 64;
+            if (bytes <= minSize) {
+                return minSize;
+            }
+            std::size_t octave = minSize;
+            while (octave * 2 <= bytes) {
+                octave *= 2;
+            }
+            const std::size_t step = octave / 4;
+            return (bytes + step - 1) / step * step;
+        }
+
+        ~AutoDiffArena()
+        {
+            release();
+        }
+
+    private:
+        AutoDiffArena()
+            : depth_(0), cached_(0), reused_(0)
+        {
+        }
+
+        void release()
+        {
+            for (auto& list : free_) {
+                for (void* ptr : list.second) {
+                    ::operator delete(ptr);
+                }
+            }
+            free_.clear();
+            cached_ = 0;
+        }
+
+        int depth_;
+        std::size_t cached_;
+        std::size_t reused_;
+        std::unordered_map<std::size_t, std::vector<void*> > free_;
+    };
+
+
+
+    /// Standard allocator using the AutoDiffArena of the calling thread.
+    template <class T>
+    class AutoDiffArenaAllocator
+    {
+    public:
+        typedef T value_type;
+
+        AutoDiffArenaAllocator() {}
+
+        template <class U>
+        AutoDiffArenaAllocator(const AutoDiffArenaAllocator<U>&) {}
+
+        T* allocate(const std::size_t n)
+        {
+            return static_cast<T*>(AutoDiffArena::allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T* ptr, const std::size_t n)
+        {
+            AutoDiffArena::deallocate(ptr, n * sizeof(T));
+        }
+
+        template <class U>
+        bool operator==(const AutoDiffArenaAllocator<U>&) const { return true; }
+
+        template <class U>
+        bool operator!=(const AutoDiffArenaAllocator<U>&) const { return false; }
+    };
+
+} // namespace Opm
+
+#endif // OPM_AUTODIFFARENA_HEADER_INCLUDED
@@ -30,6 +30,7 @@
 #include <opm/common/utility/platform_dependent/reenable_warnings.h>
 
 #include <opm/autodiff/AutoDiffMatrix.hpp>
+#include <opm/autodiff/AutoDiffThreading.hpp>
 
 
 #include <utility>
@@ -224,7 +225,7 @@ namespace Opm
                 assert (value().size() == rhs.value().size());
 
                 const int num_blocks = numBlocks();
-#pragma omp parallel for schedule(static)
+#pragma omp parallel for schedule(static) if(!AutoDiffThreading::threaded(size()))
                 for (int block = 0; block < num_blocks; ++block) {
                     assert(jac_[block].rows() == rhs.jac_[block].rows());
                     assert(jac_[block].cols() == rhs.jac_[block].cols());
@@ -232,7 +233,7 @@ namespace Opm
                 }
             }
 
-            val_ += rhs.val_;
+            assignElementwise(val_, rhs.val_, Eigen::internal::scalar_sum_op<Scalar>());
 
             return *this;
         }
@@ -243,7 +244,7 @@ namespace Opm
             if (jac_.empty()) {
                 const int num_blocks = rhs.numBlocks();
                 jac_.resize(num_blocks);
-#pragma omp parallel for schedule(static)
+#pragma omp parallel for schedule(static) if(!AutoDiffThreading::threaded(size()))
                 for (int block = 0; block < num_blocks; ++block) {
                     jac_[block] = rhs.jac_[block] * (-1.0);
                 }
@@ -252,7 +253,7 @@ namespace Opm
                 assert (value().size() == rhs.value().size());
 
                 const int num_blocks = numBlocks();
-#pragma omp parallel for schedule(static)
+#pragma omp parallel for schedule(static) if(!AutoDiffThreading::threaded(size()))
                 for (int block = 0; block < num_blocks; ++block) {
                     assert(jac_[block].rows() == rhs.jac_[block].rows());
                     assert(jac_[block].cols() == rhs.jac_[block].cols());
@@ -260,7 +261,131 @@ namespace Opm
                 }
             }
 
-            val_ -= rhs.val_;
+            assignElementwise(val_, rhs.val_, Eigen::internal::scalar_difference_op<Scalar>());
+
+            return *this;
+        }
+
+        /// Elementwise operator *=, the Jacobian blocks are updated
+        /// in place instead of creating the temporaries of operator *.
+        AutoDiffBlock& operator*=(const AutoDiffBlock& rhs)
+        {
+            if (&rhs == this) {
+                *this = *this * rhs;
+                return *this;
+            }
+            if (rhs.jac_.empty()) {
+                return *this *= rhs.val_;
+            }
+            if (jac_.empty()) {
+                jac_ = rhs.jac_;
+                const int num_blocks = numBlocks();
+#pragma omp parallel for schedule(dynamic) if(!AutoDiffThreading::threaded(size()))
+                for (int block = 0; block < num_blocks; ++block) {
+                    jac_[block].scaleRows(val_);
+                }
+            } else {
+                assert (numBlocks()    == rhs.numBlocks());
+                assert (value().size() == rhs.value().size());
+
+                // d(a b) = diag(b) da + diag(a) db
+                const int num_blocks = numBlocks();
+#pragma omp parallel for schedule(dynamic) if(!AutoDiffThreading::threaded(size()))
+                for (int block = 0; block < num_blocks; ++block) {
+                    jac_[block].scaleRows(rhs.val_);
+                    jac_[block].addScaledRows(val_, rhs.jac_[block]);
+                }
+            }
+
+            assignElementwise(val_, rhs.val_, Eigen::internal::scalar_product_op<Scalar>());
+
+            return *this;
+        }
+
+        /// Elementwise operator *= with a constant vector.
+        AutoDiffBlock& operator*=(const V& rhs)
+        {
+            assert (value().size() == rhs.size());
+            const int num_blocks = numBlocks();
+#pragma omp parallel for schedule(dynamic) if(!AutoDiffThreading::threaded(size()))
+            for (int block = 0; block < num_blocks; ++block) {
+                jac_[block].scaleRows(rhs);
+            }
+
+            assignElementwise(val_, rhs, Eigen::internal::scalar_product_op<Scalar>());
+
+            return *this;
+        }
+
+        /// Operator *= with a scalar.
+        AutoDiffBlock& operator*=(const Scalar rhs)
+        {
+            const int num_blocks = numBlocks();
+            for (int block = 0; block < num_blocks; ++block) {
+                jac_[block] *= rhs;
+            }
+
+            val_ *= rhs;
+
+            return *this;
+        }
+
+        /// Fused multiply-add, computes *this += lhs * rhs elementwise
+        /// without creating the product as a temporary.
+        AutoDiffBlock& fma(const AutoDiffBlock& lhs, const AutoDiffBlock& rhs)
+        {
+            if (&lhs == this || &rhs == this) {
+                *this += lhs * rhs;
+                return *this;
+            }
+            if (lhs.jac_.empty()) {
+                return fma(lhs.val_, rhs);
+            }
+            if (rhs.jac_.empty()) {
+                return fma(rhs.val_, lhs);
+            }
+            assert (lhs.numBlocks() == rhs.numBlocks());
+            assert (value().size() == lhs.value().size());
+            assert (value().size() == rhs.value().size());
+            if (jac_.empty()) {
+                initZeroJacobian(lhs);
+            }
+            assert (numBlocks() == lhs.numBlocks());
+
+            const int num_blocks = numBlocks();
+#pragma omp parallel for schedule(dynamic) if(!AutoDiffThreading::threaded(size()))
+            for (int block = 0; block < num_blocks; ++block) {
+                jac_[block].addScaledRows(rhs.val_, lhs.jac_[block]);
+                jac_[block].addScaledRows(lhs.val_, rhs.jac_[block]);
+            }
+
+            addProduct(lhs.val_, rhs.val_);
+
+            return *this;
+        }
+
+        /// Fused multiply-add with a constant vector, computes
+        /// *this += lhs * rhs elementwise.
+        AutoDiffBlock& fma(const V& lhs, const AutoDiffBlock& rhs)
+        {
+            if (&rhs == this) {
+                *this += lhs * rhs;
+                return *this;
+            }
+            assert (value().size() == lhs.size());
+            assert (value().size() == rhs.value().size());
+            if (jac_.empty() && !rhs.jac_.empty()) {
+                initZeroJacobian(rhs);
+            }
+
+            const int num_blocks = rhs.numBlocks();
+            assert (rhs.jac_.empty() || numBlocks() == num_blocks);
+#pragma omp parallel for schedule(dynamic) if(!AutoDiffThreading::threaded(size()))
+            for (int block = 0; block < num_blocks; ++block) {
+                jac_[block].addScaledRows(lhs, rhs.jac_[block]);
+            }
+
+            addProduct(lhs, rhs.val_);
 
             return *this;
         }
@@ -269,7 +394,7 @@ namespace Opm
         AutoDiffBlock operator+(const AutoDiffBlock& rhs) const
         {
             if (jac_.empty() && rhs.jac_.empty()) {
-                return constant(val_ + rhs.val_);
+                return constant(elementwise(val_, rhs.val_, Eigen::internal::scalar_sum_op<Scalar>()));
             }
             if (jac_.empty()) {
                 return val_ + rhs;
@@ -280,20 +405,20 @@ namespace Opm
             std::vector<M> jac = jac_;
             assert(numBlocks() == rhs.numBlocks());
             int num_blocks = numBlocks();
-#pragma omp parallel for schedule(static)
+#pragma omp parallel for schedule(static) if(!AutoDiffThreading::threaded(size()))
             for (int block = 0; block < num_blocks; ++block) {
                 assert(jac[block].rows() == rhs.jac_[block].rows());
                 assert(jac[block].cols() == rhs.jac_[block].cols());
                 jac[block] += rhs.jac_[block];
             }
-            return function(val_ + rhs.val_, std::move(jac));
+            return function(elementwise(val_, rhs.val_, Eigen::internal::scalar_sum_op<Scalar>()), std::move(jac));
         }
 
         /// Elementwise operator -
         AutoDiffBlock operator-(const AutoDiffBlock& rhs) const
         {
             if (jac_.empty() && rhs.jac_.empty()) {
-                return constant(val_ - rhs.val_);
+                return constant(elementwise(val_, rhs.val_, Eigen::internal::scalar_difference_op<Scalar>()));
             }
             if (jac_.empty()) {
                 return val_ - rhs;
@@ -304,20 +429,20 @@ namespace Opm
             std::vector<M> jac = jac_;
             assert(numBlocks() == rhs.numBlocks());
             int num_blocks = numBlocks();
-#pragma omp parallel for schedule(static)
+#pragma omp parallel for schedule(static) if(!AutoDiffThreading::threaded(size()))
             for (int block = 0; block < num_blocks; ++block) {
                 assert(jac[block].rows() == rhs.jac_[block].rows());
                 assert(jac[block].cols() == rhs.jac_[block].cols());
                 jac[block] -= rhs.jac_[block];
             }
-            return function(val_ - rhs.val_, std::move(jac));
+            return function(elementwise(val_, rhs.val_, Eigen::internal::scalar_difference_op<Scalar>()), std::move(jac));
         }
 
         /// Elementwise operator *
         AutoDiffBlock operator*(const AutoDiffBlock& rhs) const
         {
             if (jac_.empty() && rhs.jac_.empty()) {
-                return constant(val_ * rhs.val_);
+                return constant(elementwise(val_, rhs.val_, Eigen::internal::scalar_product_op<Scalar>()));
             }
             if (jac_.empty()) {
                 return val_ * rhs;
@@ -328,33 +453,23 @@ namespace Opm
             int num_blocks = numBlocks();
             std::vector<M> jac(num_blocks);
             assert(numBlocks() == rhs.numBlocks());
-            M D1(val_.matrix().asDiagonal());
-            M D2(rhs.val_.matrix().asDiagonal());
-#pragma omp parallel for schedule(dynamic)
+            // d(a b) = diag(b) da + diag(a) db
+#pragma omp parallel for schedule(dynamic) if(!AutoDiffThreading::threaded(size()))
             for (int block = 0; block < num_blocks; ++block) {
                 assert(jac_[block].rows() == rhs.jac_[block].rows());
                 assert(jac_[block].cols() == rhs.jac_[block].cols());
-                if( jac_[block].nonZeros() == 0 && rhs.jac_[block].nonZeros() == 0 ) {
-                    jac[block] = M( D2.rows(), jac_[block].cols() );
-                }
-                else if( jac_[block].nonZeros() == 0 )
-                    jac[block] = D1*rhs.jac_[block];
-                else if ( rhs.jac_[block].nonZeros() == 0 ) {
-                    jac[block] = D2*jac_[block];
-                }
-                else {
-                    jac[block]  = D2*jac_[block];
-                    jac[block] += D1*rhs.jac_[block];
-                }
+                jac[block] = jac_[block];
+                jac[block].scaleRows(rhs.val_);
+                jac[block].addScaledRows(val_, rhs.jac_[block]);
             }
-            return function(val_ * rhs.val_, std::move(jac));
+            return function(elementwise(val_, rhs.val_, Eigen::internal::scalar_product_op<Scalar>()), std::move(jac));
         }
 
         /// Elementwise operator /
         AutoDiffBlock operator/(const AutoDiffBlock& rhs) const
         {
             if (jac_.empty() && rhs.jac_.empty()) {
-                return constant(val_ / rhs.val_);
+                return constant(elementwise(val_, rhs.val_, Eigen::internal::scalar_quotient_op<Scalar>()));
             }
             if (jac_.empty()) {
                 return val_ / rhs;
@@ -365,28 +480,23 @@ namespace Opm
             int num_blocks = numBlocks();
             std::vector<M> jac(num_blocks);
             assert(numBlocks() == rhs.numBlocks());
-            M D1(val_.matrix().asDiagonal());
-            M D2(rhs.val_.matrix().asDiagonal());
-            M D3((1.0/(rhs.val_*rhs.val_)).matrix().asDiagonal());
-#pragma omp parallel for schedule(dynamic)
+            // d(a / b) = diag(1 / b) da - diag(a / b^2) db
+            V quotient = elementwise(val_, rhs.val_, Eigen::internal::scalar_quotient_op<Scalar>());
+            V inverse(size());
+            V factor(size());
+            AutoDiffThreading::forChunks(size(), [&](const int begin, const int n) {
+                    inverse.segment(begin, n) = rhs.val_.segment(begin, n).inverse();
+                    factor.segment(begin, n) = -quotient.segment(begin, n) * inverse.segment(begin, n);
+                });
+#pragma omp parallel for schedule(dynamic) if(!AutoDiffThreading::threaded(size()))
             for (int block = 0; block < num_blocks; ++block) {
                 assert(jac_[block].rows() == rhs.jac_[block].rows());
                 assert(jac_[block].cols() == rhs.jac_[block].cols());
-                if( jac_[block].nonZeros() == 0 && rhs.jac_[block].nonZeros() == 0 ) {
-                    jac[block] = M( D3.rows(), jac_[block].cols() );
-                }
-                else if( jac_[block].nonZeros() == 0 ) {
-                    jac[block] =  D3 * ( D1*rhs.jac_[block]) * (-1.0);
-                }
-                else if ( rhs.jac_[block].nonZeros() == 0 )
-                {
-                    jac[block] = D3 * (D2*jac_[block]);
-                }
-                else {
-                    jac[block] = D3 * (D2*jac_[block] + (D1*rhs.jac_[block]*(-1.0)));
-                }
+                jac[block] = jac_[block];
+                jac[block].scaleRows(inverse);
+                jac[block].addScaledRows(factor, rhs.jac_[block]);
             }
-            return function(val_ / rhs.val_, std::move(jac));
+            return function(std::move(quotient), std::move(jac));
         }
 
         /// I/O.
@@ -469,6 +579,50 @@ namespace Opm
 #endif
         }
 
+        // The elementwise op(lhs, rhs) of two arrays, with Eigen's scalar
+        // functors to keep the operations vectorized, split among the
+        // threads for large arrays.
+        template <class Op>
+        static V elementwise(const V& lhs, const V& rhs, const Op& op)
+        {
+            assert(lhs.size() == rhs.size());
+            V result(lhs.size());
+            AutoDiffThreading::forChunks(lhs.size(), [&](const int begin, const int n) {
+                    result.segment(begin, n) = lhs.segment(begin, n).binaryExpr(rhs.segment(begin, n), op);
+                });
+            return result;
+        }
+
+        // lhs = op(lhs, rhs) elementwise.
+        template <class Op>
+        static void assignElementwise(V& lhs, const V& rhs, const Op& op)
+        {
+            assert(lhs.size() == rhs.size());
+            AutoDiffThreading::forChunks(lhs.size(), [&](const int begin, const int n) {
+                    lhs.segment(begin, n) = lhs.segment(begin, n).binaryExpr(rhs.segment(begin, n), op);
+                });
+        }
+
+        // val_ += a * b elementwise.
+        void addProduct(const V& a, const V& b)
+        {
+            assert(a.size() == size() && b.size() == size());
+            AutoDiffThreading::forChunks(size(), [&](const int begin, const int n) {
+                    val_.segment(begin, n) += a.segment(begin, n) * b.segment(begin, n);
+                });
+        }
+
+        // Zero Jacobian blocks with the block pattern of other.
+        void initZeroJacobian(const AutoDiffBlock& other)
+        {
+            const int num_blocks = other.numBlocks();
+            jac_.clear();
+            jac_.reserve(num_blocks);
+            for (int block = 0; block < num_blocks; ++block) {
+                jac_.emplace_back(size(), other.jac_[block].cols());
+            }
+        }
+
         V val_;
         std::vector<M> jac_;
     };
@@ -636,13 +790,18 @@ namespace Opm
     AutoDiffBlock<Scalar> pow(const AutoDiffBlock<Scalar>& base,
                               const double exponent)
     {
-        const typename AutoDiffBlock<Scalar>::V val = base.value().pow(exponent);
-        const typename AutoDiffBlock<Scalar>::V derivative = exponent * base.value().pow(exponent - 1.0);
-        const typename AutoDiffBlock<Scalar>::M derivative_diag(derivative.matrix().asDiagonal());
-
-        std::vector< typename AutoDiffBlock<Scalar>::M > jac (base.numBlocks());
+        const int num_elem = base.size();
+        const typename AutoDiffBlock<Scalar>::V& x = base.value();
+        typename AutoDiffBlock<Scalar>::V val(num_elem);
+        typename AutoDiffBlock<Scalar>::V derivative(num_elem);
+        AutoDiffThreading::forChunks(num_elem, [&](const int begin, const int n) {
+                val.segment(begin, n) = x.segment(begin, n).pow(exponent);
+                derivative.segment(begin, n) = exponent * x.segment(begin, n).pow(exponent - 1.0);
+            });
+
+        std::vector< typename AutoDiffBlock<Scalar>::M > jac (base.derivative());
         for (int block = 0; block < base.numBlocks(); block++) {
-             fastSparseProduct(derivative_diag, base.derivative()[block], jac[block]);
+            jac[block].scaleRows(derivative);
         }
 
         return AutoDiffBlock<Scalar>::function( std::move(val), std::move(jac) );
@@ -688,13 +847,17 @@ namespace Opm
     template <typename Scalar>
     AutoDiffBlock<Scalar> pow(const AutoDiffBlock<Scalar>& base,
                               const AutoDiffBlock<Scalar>& exponent)
-    {                       
+    {
         const int num_elem = base.value().size();
         assert(exponent.size() == num_elem);
+        const typename AutoDiffBlock<Scalar>::V& f = base.value();
+        const typename AutoDiffBlock<Scalar>::V& g = exponent.value();
         typename AutoDiffBlock<Scalar>::V val (num_elem);
-        for (int i = 0; i < num_elem; ++i) {
-            val[i] = std::pow(base.value()[i], exponent.value()[i]);
-        }
+        AutoDiffThreading::forChunks(num_elem, [&](const int begin, const int n) {
+                for (int i = begin; i < begin + n; ++i) {
+                    val[i] = std::pow(f[i], g[i]);
+                }
+            });
 
         // (f^g)' = f^g * ln(f) * g' + g * f^(g-1) * f' = der1 + der2
         // if f' is empty only der1 is calculated
@@ -707,31 +870,31 @@ namespace Opm
         std::vector< typename AutoDiffBlock<Scalar>::M > jac (num_blocks);
 
         if ( !exponent.derivative().empty() ) {
-            typename AutoDiffBlock<Scalar>::V der1 = val;
-            for (int i = 0; i < num_elem; ++i) {
-                der1[i] *= std::log(base.value()[i]);
-            }
-            std::vector< typename AutoDiffBlock<Scalar>::M > jac1 (exponent.numBlocks());
-            const typename AutoDiffBlock<Scalar>::M der1_diag(der1.matrix().asDiagonal());
+            typename AutoDiffBlock<Scalar>::V der1 (num_elem);
+            AutoDiffThreading::forChunks(num_elem, [&](const int begin, const int n) {
+                    for (int i = begin; i < begin + n; ++i) {
+                        der1[i] = val[i] * std::log(f[i]);
+                    }
+                });
             for (int block = 0; block < exponent.numBlocks(); block++) {
-                fastSparseProduct(der1_diag, exponent.derivative()[block], jac1[block]);
-                jac[block] = jac1[block];
+                jac[block] = exponent.derivative()[block];
+                jac[block].scaleRows(der1);
             }
         }
 
         if ( !base.derivative().empty() ) {
-            typename AutoDiffBlock<Scalar>::V der2 = exponent.value();
-            for (int i = 0; i < num_elem; ++i) {
-                der2[i] *= std::pow(base.value()[i], exponent.value()[i] - 1.0);
-            }
-            std::vector< typename AutoDiffBlock<Scalar>::M > jac2 (base.numBlocks());
-            const typename AutoDiffBlock<Scalar>::M der2_diag(der2.matrix().asDiagonal());
+            typename AutoDiffBlock<Scalar>::V der2 (num_elem);
+            AutoDiffThreading::forChunks(num_elem, [&](const int begin, const int n) {
+                    for (int i = begin; i < begin + n; ++i) {
+                        der2[i] = g[i] * std::pow(f[i], g[i] - 1.0);
+                    }
+                });
             for (int block = 0; block < base.numBlocks(); block++) {
-                fastSparseProduct(der2_diag, base.derivative()[block], jac2[block]);
                 if (!exponent.derivative().empty()) {
-                    jac[block] += jac2[block];
+                    jac[block].addScaledRows(der2, base.derivative()[block]);
                 } else {
-                    jac[block] = jac2[block];
+                    jac[block] = base.derivative()[block];
+                    jac[block].scaleRows(der2);
                 }
             }
         }
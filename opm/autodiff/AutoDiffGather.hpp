@@ -0,0 +1,262 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_AUTODIFFGATHER_HEADER_INCLUDED
+#define OPM_AUTODIFFGATHER_HEADER_INCLUDED
+
+#include <opm/autodiff/AutoDiffStencil.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Opm
+{
+
+    /// An index set prepared for gathering the rows indices[i] of vectors
+    /// and matrices into rows i, and for scattering rows i back to rows
+    /// indices[i], without forming the selection matrices.
+    ///
+    /// The plan stores for every row the positions at which it is
+    /// gathered. The symbolic parts of gathering and scattering the rows of
+    /// a stencil pattern are cached in the plan, such that a plan kept by
+    /// the caller, e.g. the one of the perforated cells of the wells, only
+    /// copies values when applied to the Jacobians of every iteration.
+    /// Copies of a plan share its cache.
+    class GatherPlan
+    {
+    public:
+        /// Symbolic gather or scatter of the rows of a stencil pattern. The
+        /// value of entry k of the result is the sum of the operand entries
+        /// source[t], t in [start[k], start[k+1]).
+        struct Selection
+        {
+            StencilPattern::Pointer pattern;
+            std::vector<int> start;
+            std::vector<int> source;
+        };
+
+        /// An empty plan.
+        GatherPlan()
+            : sorted_(true)
+            , positionStart_(1, 0)
+            , cache_(std::make_shared<Cache>())
+        {
+        }
+
+        /// The plan of the non-negative indices.
+        template <class IntVec>
+        explicit GatherPlan(const IntVec& indices)
+            : indices_(indices.size())
+            , sorted_(true)
+            , cache_(std::make_shared<Cache>())
+        {
+            int numRows = 0;
+            for (std::size_t i = 0; i < indices_.size(); ++i) {
+                indices_[i] = indices[i];
+                assert(indices_[i] >= 0);
+                sorted_ = sorted_ && (i == 0 || indices_[i - 1] <= indices_[i]);
+                numRows = std::max(numRows, indices_[i] + 1);
+            }
+            // counting sort, the positions of a row are increasing
+            positionStart_.assign(numRows + 1, 0);
+            for (const int row : indices_) {
+                ++positionStart_[row + 1];
+            }
+            for (int row = 0; row < numRows; ++row) {
+                positionStart_[row + 1] += positionStart_[row];
+            }
+            positions_.resize(indices_.size());
+            std::vector<int> next(positionStart_.begin(), positionStart_.end() - 1);
+            for (std::size_t i = 0; i < indices_.size(); ++i) {
+                positions_[next[indices_[i]]++] = i;
+            }
+        }
+
+        /// The number of indices, i.e. of gathered rows.
+        int size() const { return indices_.size(); }
+
+        int operator[](const int i) const { return indices_[i]; }
+
+        const std::vector<int>& indices() const { return indices_; }
+
+        /// Whether the indices are non-decreasing, then gathered and
+        /// scattered rows keep their order.
+        bool sorted() const { return sorted_; }
+
+        /// Call f(i) for the positions i with indices[i] == row in
+        /// increasing order.
+        template <class F>
+        void forEachPosition(const int row, F f) const
+        {
+            if (row + 1 < int(positionStart_.size())) {
+                for (int t = positionStart_[row]; t < positionStart_[row + 1]; ++t) {
+                    f(positions_[t]);
+                }
+            }
+        }
+
+        /// Symbolic gather of the rows of a column-wise pattern with
+        /// sorted rows, the result is column-wise with sorted rows.
+        template <class Index>
+        void gatherColumns(const int cols, const Index* outer, const Index* inner,
+                           std::vector<int>& newOuter, std::vector<int>& newInner,
+                           std::vector<int>& start, std::vector<int>& source) const
+        {
+            std::vector<std::pair<int, int> > terms;
+            beginColumns(cols, newOuter, newInner, start, source);
+            for (int col = 0; col < cols; ++col) {
+                terms.clear();
+                for (Index k = outer[col]; k < outer[col + 1]; ++k) {
+                    forEachPosition(inner[k], [&terms, k](const int i) {
+                            terms.emplace_back(i, int(k));
+                        });
+                }
+                appendColumn(col, terms, newOuter, newInner, start, source);
+            }
+        }
+
+        /// Symbolic scatter of the rows of a column-wise pattern with
+        /// sorted rows, rows with equal indices are summed.
+        template <class Index>
+        void scatterColumns(const int cols, const Index* outer, const Index* inner,
+                            std::vector<int>& newOuter, std::vector<int>& newInner,
+                            std::vector<int>& start, std::vector<int>& source) const
+        {
+            std::vector<std::pair<int, int> > terms;
+            beginColumns(cols, newOuter, newInner, start, source);
+            for (int col = 0; col < cols; ++col) {
+                terms.clear();
+                for (Index k = outer[col]; k < outer[col + 1]; ++k) {
+                    terms.emplace_back(indices_[inner[k]], int(k));
+                }
+                appendColumn(col, terms, newOuter, newInner, start, source);
+            }
+        }
+
+        /// The cached symbolic gather of the rows of a stencil pattern.
+        std::shared_ptr<const Selection> gather(const StencilPattern::Pointer& pattern) const
+        {
+            return selection(pattern, -1);
+        }
+
+        /// The cached symbolic scatter of the rows of a stencil pattern to
+        /// a pattern with the given number of rows.
+        std::shared_ptr<const Selection> scatter(const StencilPattern::Pointer& pattern, const int rows) const
+        {
+            assert(int(positionStart_.size()) - 1 <= rows);
+            return selection(pattern, rows);
+        }
+
+    private:
+        struct Entry
+        {
+            std::weak_ptr<const StencilPattern> pattern;
+            int rows; // -1 for a gather
+            std::shared_ptr<const Selection> selection;
+        };
+
+        struct Cache
+        {
+            std::mutex mutex;
+            std::vector<Entry> entries;
+        };
+
+        static void beginColumns(const int cols,
+                                 std::vector<int>& newOuter, std::vector<int>& newInner,
+                                 std::vector<int>& start, std::vector<int>& source)
+        {
+            newOuter.assign(cols + 1, 0);
+            newInner.clear();
+            start.assign(1, 0);
+            source.clear();
+        }
+
+        // Append the (row, source entry) terms of a column, merging equal
+        // rows.
+        void appendColumn(const int col, std::vector<std::pair<int, int> >& terms,
+                          std::vector<int>& newOuter, std::vector<int>& newInner,
+                          std::vector<int>& start, std::vector<int>& source) const
+        {
+            if (!sorted_) {
+                std::sort(terms.begin(), terms.end());
+            }
+            for (std::size_t t = 0; t < terms.size(); ++t) {
+                if (t == 0 || terms[t].first != terms[t - 1].first) {
+                    if (t > 0) {
+                        start.push_back(source.size());
+                    }
+                    newInner.push_back(terms[t].first);
+                }
+                source.push_back(terms[t].second);
+            }
+            if (!terms.empty()) {
+                start.push_back(source.size());
+            }
+            newOuter[col + 1] = newInner.size();
+        }
+
+        std::shared_ptr<const Selection> selection(const StencilPattern::Pointer& pattern, const int rows) const
+        {
+            std::lock_guard<std::mutex> lock(cache_->mutex);
+            std::shared_ptr<const Selection> result;
+            auto entry = cache_->entries.begin();
+            while (entry != cache_->entries.end()) {
+                const StencilPattern::Pointer key = entry->pattern.lock();
+                if (!key) {
+                    entry = cache_->entries.erase(entry);
+                    continue;
+                }
+                if (key == pattern && entry->rows == rows) {
+                    result = entry->selection;
+                }
+                ++entry;
+            }
+            if (!result) {
+                std::shared_ptr<Selection> computed(new Selection);
+                std::vector<int> outer;
+                std::vector<int> inner;
+                if (rows < 0) {
+                    gatherColumns(pattern->cols(), pattern->outer().data(), pattern->inner().data(),
+                                  outer, inner, computed->start, computed->source);
+                } else {
+                    scatterColumns(pattern->cols(), pattern->outer().data(), pattern->inner().data(),
+                                   outer, inner, computed->start, computed->source);
+                }
+                computed->pattern = StencilPattern::create(rows < 0 ? size() : rows, pattern->cols(),
+                                                           std::move(outer), std::move(inner));
+                cache_->entries.push_back(Entry{ pattern, rows, computed });
+                result = computed;
+            }
+            return result;
+        }
+
+        std::vector<int> indices_;
+        bool sorted_;
+        std::vector<int> positionStart_;
+        std::vector<int> positions_;
+        std::shared_ptr<Cache> cache_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_AUTODIFFGATHER_HEADER_INCLUDED
@@ -22,7 +22,9 @@
 #define OPM_AUTODIFFHELPERS_HEADER_INCLUDED
 
 #include <opm/autodiff/AutoDiffBlock.hpp>
+#include <opm/autodiff/AutoDiffGather.hpp>
 #include <opm/autodiff/GridHelpers.hpp>
+#include <opm/autodiff/GridTopology.hpp>
 #include <opm/autodiff/GeoProps.hpp>
 #include <opm/core/grid.h>
 #include <opm/core/grid/PinchProcessor.hpp>
@@ -32,6 +34,7 @@
 #include <opm/parser/eclipse/EclipseState/Grid/NNC.hpp>
 #include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 namespace Opm
@@ -64,6 +67,18 @@ struct HelperOps
     /// Extract for each cell the sum of all its adjacent faces' (signed) values.
     M fulldiv;
 
+    /// The operators applied to AD quantities as stencil matrices, see
+    /// AutoDiffMatrix. Their products with AD quantities keep the sparsity
+    /// pattern of the operator and products of such results, e.g. the
+    /// divergence of a flux, reuse the cached symbolic product.
+    struct Stencils
+    {
+        AutoDiffMatrix ngrad;
+        AutoDiffMatrix caver;
+        AutoDiffMatrix div;
+    };
+    Stencils stencil;
+
     /// Non-neighboring connections
     typedef Eigen::Array<int, Eigen::Dynamic, 2, Eigen::RowMajor> TwoColInt;
     TwoColInt nnc_cells;
@@ -74,17 +89,32 @@ struct HelperOps
     /// The set of all connections' cells (face or nnc).
     TwoColInt connection_cells;
 
+    /// The face-cell topology of the grid, shared with every other user
+    /// of the same grid.
+    std::shared_ptr<const GridTopology> topology;
+
     /// Constructs all helper vectors and matrices.
     template<class Grid>
     HelperOps(const Grid& grid, const NNC& nnc = NNC())
+        : HelperOps(grid, std::make_shared<const GridTopology>(grid), nnc)
+    {
+    }
+
+    /// Constructs all helper vectors and matrices from an already
+    /// extracted topology of grid.
+    template<class Grid>
+    HelperOps(const Grid& grid,
+              std::shared_ptr<const GridTopology> grid_topology,
+              const NNC& nnc = NNC())
+        : topology(std::move(grid_topology))
     {
         using namespace AutoDiffGrid;
-        const int nc = numCells(grid);
-        const int nf = numFaces(grid);
+        const int nc = topology->num_cells;
+        const int nf = topology->face_cells.rows();
         // Define some neighbourhood-derived helper arrays.
 
-        TwoColInt nbi;
-        extractInternalFaces(grid, internal_faces, nbi);
+        internal_faces = topology->internal_faces;
+        const TwoColInt& nbi = topology->internal_face_cells;
         const int num_internal = internal_faces.size();
 
         // handle non-neighboring connections
@@ -144,7 +174,7 @@ struct HelperOps
 
         std::vector<Tri> fullngrad_tri;
         fullngrad_tri.reserve(2*(nf+numNNC));
-        typename ADFaceCellTraits<Grid>::Type nb = faceCellsToEigen(grid);
+        const TwoColInt& nb = topology->face_cells;
         for (int i = 0; i < nf; ++i) {
             if (nb(i,0) >= 0) {
                 fullngrad_tri.emplace_back(i, nb(i,0), 1.0);
@@ -164,6 +194,10 @@ struct HelperOps
         fullngrad.setFromTriplets(fullngrad_tri.begin(), fullngrad_tri.end());
         fulldiv = fullngrad.transpose();
 
+        stencil.ngrad = AutoDiffMatrix::createStencil(ngrad);
+        stencil.caver = AutoDiffMatrix::createStencil(caver);
+        stencil.div = AutoDiffMatrix::createStencil(div);
+
         if (has_nnc) {
             connection_cells.resize(nbi.rows() + nnc_cells.rows(), 2);
             connection_cells << nbi, nnc_cells;
@@ -175,6 +209,25 @@ struct HelperOps
 // -------------------- upwinding helper class --------------------
 
 
+    /// The upwind cell of each connection (internal face or NNC) of h:
+    /// the first cell of the connection for a non-negative flux, the
+    /// second cell otherwise. Quantities are upwinded by gathering with
+    /// the result, e.g. subset(x, upwindCells(h, flux)).
+    template <class Vector>
+    std::vector<int>
+    upwindCells(const HelperOps& h, const Vector& connection_flux)
+    {
+        const int num_connections = h.connection_cells.rows();
+        assert(num_connections == connection_flux.size());
+        std::vector<int> cells(num_connections);
+        for (int conn = 0; conn < num_connections; ++conn) {
+            cells[conn] = h.connection_cells(conn, connection_flux[conn] >= 0 ? 0 : 1);
+            assert(cells[conn] >= 0);
+        }
+        return cells;
+    }
+
+
     /// Upwind selection in absence of counter-current flow (i.e.,
     /// without effects of gravity and/or capillary pressure).
     template <typename Scalar>
@@ -186,43 +239,23 @@ struct HelperOps
         UpwindSelector(const Grid& g,
                        const HelperOps&        h,
                        const typename ADB::V&  ifaceflux)
+            : upwind_cells_(upwindCells(h, ifaceflux))
         {
             using namespace AutoDiffGrid;
-            typedef HelperOps::IFaces::Index IFIndex;
-            const IFIndex nif = h.internal_faces.size();
-            typename ADFaceCellTraits<Grid>::Type
-                face_cells = faceCellsToEigen(g);
-
-            // num connections may possibly include NNCs
-            int num_nnc = h.nnc_trans.size();
-            int num_connections = nif + num_nnc;
-            assert(num_connections == ifaceflux.size());
+            const int num_connections = upwind_cells_.size();
 
-            // Define selector structure.
+            // Define selector structure, one entry per row. It is only
+            // needed for the derivatives of selected ADB quantities.
             typedef typename Eigen::Triplet<Scalar> Triplet;
             std::vector<Triplet> s;  s.reserve(num_connections);
-            for (IFIndex iface = 0; iface < nif; ++iface) {
-                const int f  = h.internal_faces[iface];
-                const int c1 = face_cells(f,0);
-                const int c2 = face_cells(f,1);
-
-                assert ((c1 >= 0) && (c2 >= 0));
-
-                // Select upwind cell.
-                const int c = (ifaceflux[iface] >= 0) ? c1 : c2;
-
-                s.push_back(Triplet(iface, c, Scalar(1)));
-            }
-            if (num_nnc > 0) {
-                for (int i = 0; i < num_nnc; ++i) {
-                    const int c = (ifaceflux[i+nif] >= 0) ? h.nnc_cells(i,0) : h.nnc_cells(i,1);
-                    s.push_back(Triplet(i+nif,c,Scalar(1)));
-                }
+            for (int conn = 0; conn < num_connections; ++conn) {
+                s.push_back(Triplet(conn, upwind_cells_[conn], Scalar(1)));
             }
 
             // Assemble explicit selector operator.
             select_.resize(num_connections, numCells(g));
             select_.setFromTriplets(s.begin(), s.end());
+            stencil_ = AutoDiffMatrix::createStencil(select_);
         }
 
         /// Apply selector to multiple per-cell quantities.
@@ -236,7 +269,7 @@ struct HelperOps
             for (typename std::vector<ADB>::const_iterator
                      b = xc.begin(), e = xc.end(); b != e; ++b)
             {
-                xf.push_back(select_ * (*b));
+                xf.push_back(stencil_ * (*b));
             }
 
             return xf;
@@ -245,47 +278,36 @@ struct HelperOps
         /// Apply selector to single per-cell ADB quantity.
         ADB select(const ADB& xc) const
         {
-            return select_*xc;
+            return stencil_*xc;
         }
 
         /// Apply selector to single per-cell constant quantity.
         typename ADB::V select(const typename ADB::V& xc) const
         {
-            return (select_*xc.matrix()).array();
+            const int num_connections = upwind_cells_.size();
+            typename ADB::V xf(num_connections);
+            for (int conn = 0; conn < num_connections; ++conn) {
+                xf[conn] = xc[upwind_cells_[conn]];
+            }
+            return xf;
+        }
+
+        /// The upwind cell of each connection.
+        const std::vector<int>& upwindCells() const
+        {
+            return upwind_cells_;
         }
 
     private:
+        std::vector<int> upwind_cells_;
         Eigen::SparseMatrix<double> select_;
+        // select_ as stencil matrix, its pattern is a subset of the one of
+        // HelperOps::stencil.ngrad, so upwinded fluxes keep that pattern
+        AutoDiffMatrix stencil_;
     };
 
 
 
-namespace {
-
-
-    template <typename Scalar, class IntVec>
-    typename Eigen::SparseMatrix<Scalar>
-    constructSupersetSparseMatrix(const int full_size, const IntVec& indices)
-    {
-        const int subset_size = indices.size();
-
-        if (subset_size == 0) {
-            Eigen::SparseMatrix<Scalar> mat(full_size, 0);
-            return mat;
-        }
-
-        Eigen::SparseMatrix<Scalar> mat(full_size, subset_size);
-        mat.reserve(Eigen::VectorXi::Constant(subset_size, 1));
-        for (int i = 0; i < subset_size; ++i) {
-            mat.insert(indices[i], i) = 1;
-        }
-        return mat;
-    }
-
-} // anon namespace
-
-
-
 /// Returns x(indices).
 template <typename Scalar, class IntVec>
 Eigen::Array<Scalar, Eigen::Dynamic, 1>
@@ -301,38 +323,95 @@ subset(const Eigen::Array<Scalar, Eigen::Dynamic, 1>& x,
     return std::move(ret);
 }
 
+/// Returns x(indices) for the indices of a gather plan.
+template <typename Scalar>
+Eigen::Array<Scalar, Eigen::Dynamic, 1>
+subset(const Eigen::Array<Scalar, Eigen::Dynamic, 1>& x,
+       const GatherPlan& plan)
+{
+    return subset(x, plan.indices());
+}
+
+/// Returns x(indices) for the indices of a gather plan. The rows of the
+/// Jacobians are gathered directly, keep the plan to reuse the gathered
+/// patterns of stencil Jacobians.
+template <typename Scalar>
+AutoDiffBlock<Scalar>
+subset(const AutoDiffBlock<Scalar>& x,
+       const GatherPlan& plan)
+{
+    typedef typename AutoDiffBlock<Scalar>::M M;
+    std::vector<M> jac;
+    jac.reserve(x.numBlocks());
+    for (const M& block : x.derivative()) {
+        jac.push_back(block.gatherRows(plan));
+    }
+    return AutoDiffBlock<Scalar>::function(subset(x.value(), plan.indices()), std::move(jac));
+}
+
 /// Returns x(indices).
 template <typename Scalar, class IntVec>
 AutoDiffBlock<Scalar>
 subset(const AutoDiffBlock<Scalar>& x,
        const IntVec& indices)
 {
-    const Eigen::SparseMatrix<Scalar> sub
-        = constructSupersetSparseMatrix<Scalar>(x.value().size(), indices).transpose().eval();
-    return sub * x;
+    return subset(x, GatherPlan(indices));
 }
 
 
 /// Returns v where v(indices) == x, v(!indices) == 0 and v.size() == n.
 template <typename Scalar, class IntVec>
-AutoDiffBlock<Scalar>
-superset(const AutoDiffBlock<Scalar>& x,
+Eigen::Array<Scalar, Eigen::Dynamic, 1>
+superset(const Eigen::Array<Scalar, Eigen::Dynamic, 1>& x,
          const IntVec& indices,
          const int n)
 {
-    return constructSupersetSparseMatrix<Scalar>(n, indices) * x;
+    Eigen::Array<Scalar, Eigen::Dynamic, 1> ret = Eigen::Array<Scalar, Eigen::Dynamic, 1>::Zero(n);
+    const int size = indices.size();
+    for (int i = 0; i < size; ++i) {
+        ret[indices[i]] += x[i];
+    }
+    return ret;
+}
+
+/// Returns v where v(indices) == x, v(!indices) == 0 and v.size() == n,
+/// for the indices of a gather plan.
+template <typename Scalar>
+Eigen::Array<Scalar, Eigen::Dynamic, 1>
+superset(const Eigen::Array<Scalar, Eigen::Dynamic, 1>& x,
+         const GatherPlan& plan,
+         const int n)
+{
+    return superset(x, plan.indices(), n);
 }
 
 
 
+/// Returns v where v(indices) == x, v(!indices) == 0 and v.size() == n,
+/// for the indices of a gather plan.
+template <typename Scalar>
+AutoDiffBlock<Scalar>
+superset(const AutoDiffBlock<Scalar>& x,
+         const GatherPlan& plan,
+         const int n)
+{
+    typedef typename AutoDiffBlock<Scalar>::M M;
+    std::vector<M> jac;
+    jac.reserve(x.numBlocks());
+    for (const M& block : x.derivative()) {
+        jac.push_back(block.scatterRows(plan, n));
+    }
+    return AutoDiffBlock<Scalar>::function(superset(x.value(), plan.indices(), n), std::move(jac));
+}
+
 /// Returns v where v(indices) == x, v(!indices) == 0 and v.size() == n.
 template <typename Scalar, class IntVec>
-Eigen::Array<Scalar, Eigen::Dynamic, 1>
-superset(const Eigen::Array<Scalar, Eigen::Dynamic, 1>& x,
+AutoDiffBlock<Scalar>
+superset(const AutoDiffBlock<Scalar>& x,
          const IntVec& indices,
          const int n)
 {
-    return constructSupersetSparseMatrix<Scalar>(n, indices) * x.matrix();
+    return superset(x, GatherPlan(indices), n);
 }
 
 
@@ -432,12 +511,25 @@ spdiag(const AutoDiffBlock<double>::V& d)
             } else if (left_elems_.empty()) {
                 return x2;
             } else {
-                return superset(subset(x1, left_elems_), left_elems_, x1.size())
-                    + superset(subset(x2, right_elems_), right_elems_, x2.size());
+                typename ADB::V result(x1.size());
+                choose(left_elems_, x1, result);
+                choose(right_elems_, x2, result);
+                return result;
             }
         }
 
     private:
+        // result[i] = x[i] for the elements i, split among the threads for
+        // large arrays.
+        static void choose(const std::vector<int>& elems, const typename ADB::V& x, typename ADB::V& result)
+        {
+            AutoDiffThreading::forChunks(elems.size(), [&](const int begin, const int n) {
+                    for (int k = begin; k < begin + n; ++k) {
+                        result[elems[k]] = x[elems[k]];
+                    }
+                });
+        }
+
         std::vector<int> left_elems_;
         std::vector<int> right_elems_;
     };
@@ -28,6 +28,10 @@
 #include <opm/common/utility/platform_dependent/reenable_warnings.h>
 
 #include <opm/common/ErrorMacros.hpp>
+#include <opm/autodiff/AutoDiffArena.hpp>
+#include <opm/autodiff/AutoDiffGather.hpp>
+#include <opm/autodiff/AutoDiffStencil.hpp>
+#include <opm/autodiff/AutoDiffThreading.hpp>
 #include <opm/autodiff/fastSparseOperations.hpp>
 #include <vector>
 
@@ -38,12 +42,16 @@ namespace Opm
     /**
      * AutoDiffMatrix is a wrapper class that optimizes matrix operations.
      * Internally, an AutoDiffMatrix can be either Zero, Identity, Diagonal,
-     * or Sparse, and we utilize this to perform faster matrix operations.
+     * Sparse or Stencil, and we utilize this to perform faster matrix operations.
+     * A Stencil matrix stores only values and shares an immutable sparsity
+     * pattern, e.g. the one of a gradient or divergence operator, with the
+     * matrices derived from it by scaling. Sums and products of stencil
+     * matrices stay stencil matrices and reuse cached symbolic parts.
      */
     class AutoDiffMatrix
     {
     public:
-        typedef std::vector<double> DiagRep;
+        typedef std::vector<double, AutoDiffArenaAllocator<double> > DiagRep;
         typedef Eigen::SparseMatrix<double> SparseRep;
 
 
@@ -55,7 +63,9 @@ namespace Opm
               rows_(0),
               cols_(0),
               diag_(),
-              sparse_()
+              sparse_(),
+              pattern_(),
+              values_()
         {
         }
 
@@ -68,7 +78,9 @@ namespace Opm
               rows_(num_rows),
               cols_(num_cols),
               diag_(),
-              sparse_()
+              sparse_(),
+              pattern_(),
+              values_()
         {
         }
 
@@ -93,7 +105,9 @@ namespace Opm
               rows_(d.rows()),
               cols_(d.cols()),
               diag_(d.diagonal().array().data(), d.diagonal().array().data() + d.rows()),
-              sparse_()
+              sparse_(),
+              pattern_(),
+              values_()
         {
             assert(rows_ == cols_);
         }
@@ -108,12 +122,28 @@ namespace Opm
               rows_(s.rows()),
               cols_(s.cols()),
               diag_(),
-              sparse_(s)
+              sparse_(s),
+              pattern_(),
+              values_()
         {
         }
 
 
 
+        /**
+         * Creates a stencil matrix from an Eigen sparse matrix. The matrix
+         * gets its own sparsity pattern, which is shared by all matrices
+         * derived from it by scaling.
+         */
+        static AutoDiffMatrix createStencil(const Eigen::SparseMatrix<double>& s)
+        {
+            AutoDiffMatrix retval(Stencil, s.rows(), s.cols());
+            retval.pattern_ = StencilPattern::fromSparse(s, retval.values_);
+            return retval;
+        }
+
+
+
         AutoDiffMatrix(const AutoDiffMatrix& other) = default;
         AutoDiffMatrix& operator=(const AutoDiffMatrix& other) = default;
 
@@ -124,7 +154,9 @@ namespace Opm
               rows_(0),
               cols_(0),
               diag_(),
-              sparse_()
+              sparse_(),
+              pattern_(),
+              values_()
         {
             swap(other);
         }
@@ -146,6 +178,8 @@ namespace Opm
             std::swap(cols_, other.cols_);
             diag_.swap(other.diag_);
             sparse_.swap(other.sparse_);
+            pattern_.swap(other.pattern_);
+            values_.swap(other.values_);
         }
 
 
@@ -160,6 +194,9 @@ namespace Opm
         {
             assert(rows_ == rhs.rows_);
             assert(cols_ == rhs.cols_);
+            if (type_ == Stencil || rhs.type_ == Stencil) {
+                return addStencil(*this, rhs);
+            }
             switch (type_) {
             case Zero:
                 return rhs;
@@ -220,6 +257,9 @@ namespace Opm
         AutoDiffMatrix operator*(const AutoDiffMatrix& rhs) const
         {
             assert(cols_ == rhs.rows_);
+            if (type_ == Stencil || rhs.type_ == Stencil) {
+                return mulStencil(*this, rhs);
+            }
             switch (type_) {
             case Zero:
                 return AutoDiffMatrix(rows_, rhs.cols_);
@@ -268,6 +308,16 @@ namespace Opm
             {
                 fastSparseAdd( sparse_, rhs.sparse_ );
             }
+            else if( type_ == Stencil && rhs.type_ == Stencil && pattern_ == rhs.pattern_ )
+            {
+                double* values = values_.data();
+                const double* rhsValues = rhs.values_.data();
+                AutoDiffThreading::forChunks(values_.size(), [values, rhsValues](const int begin, const int size) {
+                        for (int k = begin; k < begin + size; ++k) {
+                            values[k] += rhsValues[k];
+                        }
+                    });
+            }
             else {
                 *this = *this + rhs;
             }
@@ -285,6 +335,16 @@ namespace Opm
             {
                 fastSparseSubstract( sparse_, rhs.sparse_ );
             }
+            else if( type_ == Stencil && rhs.type_ == Stencil && pattern_ == rhs.pattern_ )
+            {
+                double* values = values_.data();
+                const double* rhsValues = rhs.values_.data();
+                AutoDiffThreading::forChunks(values_.size(), [values, rhsValues](const int begin, const int size) {
+                        for (int k = begin; k < begin + size; ++k) {
+                            values[k] -= rhsValues[k];
+                        }
+                    });
+            }
             else {
                 *this = *this + (rhs * -1.0);
             }
@@ -296,6 +356,266 @@ namespace Opm
 
 
 
+        /**
+         * Multiplies the rows of the matrix with the elements of d in place,
+         * i.e. computes diag(d) * M. Sparse matrices keep their sparsity
+         * pattern and no memory is allocated except for identity matrices,
+         * which become diagonal.
+         */
+        template <class Diag>
+        AutoDiffMatrix& scaleRows(const Diag& d)
+        {
+            assert(int(d.size()) == rows_);
+            switch (type_) {
+            case Zero:
+                break;
+            case Identity:
+                type_ = Diagonal;
+                diag_.resize(rows_);
+                for (int r = 0; r < rows_; ++r) {
+                    diag_[r] = d[r];
+                }
+                break;
+            case Diagonal:
+                {
+                    double* diag = diag_.data();
+                    AutoDiffThreading::forChunks(rows_, [diag, &d](const int begin, const int size) {
+                            for (int r = begin; r < begin + size; ++r) {
+                                diag[r] *= d[r];
+                            }
+                        });
+                }
+                break;
+            case Sparse:
+                fastDiagSparseScale(d, sparse_);
+                break;
+            case Stencil:
+                {
+                    const int* inner = pattern_->inner().data();
+                    double* values = values_.data();
+                    AutoDiffThreading::forChunks(values_.size(), [inner, values, &d](const int begin, const int size) {
+                            for (int k = begin; k < begin + size; ++k) {
+                                values[k] *= d[inner[k]];
+                            }
+                        });
+                }
+                break;
+            default:
+                OPM_THROW(std::logic_error, "Invalid AutoDiffMatrix type encountered: " << type_);
+            }
+            return *this;
+        }
+
+
+
+
+
+
+        /**
+         * Adds diag(d) * rhs to the matrix. Diagonal sums and sparse sums
+         * with equal sparsity pattern are computed in place, otherwise a
+         * temporary is created as in operator+=.
+         */
+        template <class Diag>
+        AutoDiffMatrix& addScaledRows(const Diag& d, const AutoDiffMatrix& rhs)
+        {
+            assert(rows_ == rhs.rows_);
+            assert(cols_ == rhs.cols_);
+            assert(int(d.size()) == rows_);
+            switch (rhs.type_) {
+            case Zero:
+                return *this;
+            case Identity:
+            case Diagonal:
+                if (type_ == Zero || type_ == Identity || type_ == Diagonal) {
+                    if (type_ == Zero) {
+                        diag_.assign(rows_, 0.0);
+                    } else if (type_ == Identity) {
+                        diag_.assign(rows_, 1.0);
+                    }
+                    type_ = Diagonal;
+                    double* diag = diag_.data();
+                    const double* rhsDiag = rhs.type_ == Identity ? nullptr : rhs.diag_.data();
+                    AutoDiffThreading::forChunks(rows_, [diag, rhsDiag, &d](const int begin, const int size) {
+                            for (int r = begin; r < begin + size; ++r) {
+                                diag[r] += d[r] * (rhsDiag ? rhsDiag[r] : 1.0);
+                            }
+                        });
+                    return *this;
+                }
+                break;
+            case Sparse:
+                if (type_ == Zero) {
+                    *this = rhs;
+                    return scaleRows(d);
+                }
+                if (type_ == Sparse) {
+                    fastSparseAddDiagProduct(sparse_, d, rhs.sparse_);
+                    return *this;
+                }
+                break;
+            case Stencil:
+                if (type_ == Zero) {
+                    *this = rhs;
+                    return scaleRows(d);
+                }
+                if (type_ == Stencil && pattern_ == rhs.pattern_) {
+                    const int* inner = pattern_->inner().data();
+                    double* values = values_.data();
+                    const double* rhsValues = rhs.values_.data();
+                    AutoDiffThreading::forChunks(values_.size(), [inner, values, rhsValues, &d](const int begin, const int size) {
+                            for (int k = begin; k < begin + size; ++k) {
+                                values[k] += d[inner[k]] * rhsValues[k];
+                            }
+                        });
+                    return *this;
+                }
+                break;
+            default:
+                OPM_THROW(std::logic_error, "Invalid AutoDiffMatrix type encountered: " << rhs.type_);
+            }
+            AutoDiffMatrix scaled(rhs);
+            scaled.scaleRows(d);
+            return *this += scaled;
+        }
+
+
+
+
+
+
+        /**
+         * Returns the matrix with plan.size() rows whose row i is row
+         * plan[i] of this matrix, i.e. the product of a selection matrix
+         * with this matrix, without forming the selection matrix. Stencil
+         * matrices stay stencil matrices with the gathered pattern cached
+         * in the plan.
+         */
+        AutoDiffMatrix gatherRows(const GatherPlan& plan) const
+        {
+            const int m = plan.size();
+            switch (type_) {
+            case Zero:
+                return AutoDiffMatrix(m, cols_);
+            case Identity:
+            case Diagonal:
+                {
+                    AutoDiffMatrix retval(Sparse, m, cols_, DiagRep(), SparseRep(m, cols_));
+                    retval.sparse_.reserve(m);
+                    for (int col = 0; col < cols_; ++col) {
+                        retval.sparse_.startVec(col);
+                        const double value = type_ == Identity ? 1.0 : diag_[col];
+                        plan.forEachPosition(col, [&retval, col, value](const int i) {
+                                retval.sparse_.insertBack(i, col) = value;
+                            });
+                    }
+                    retval.sparse_.finalize();
+                    return retval;
+                }
+            case Sparse:
+                {
+                    const SparseRep& s = compressed();
+                    std::vector<int> outer, inner, start, source;
+                    plan.gatherColumns(cols_, s.outerIndexPtr(), s.innerIndexPtr(),
+                                       outer, inner, start, source);
+                    AutoDiffMatrix retval(Sparse, m, cols_, DiagRep(), SparseRep(m, cols_));
+                    selectedToSparse(s.valuePtr(), outer, inner, start, source, retval.sparse_);
+                    return retval;
+                }
+            case Stencil:
+                return selectStencil(*plan.gather(pattern_));
+            default:
+                OPM_THROW(std::logic_error, "Invalid AutoDiffMatrix type encountered: " << type_);
+            }
+        }
+
+
+
+
+
+
+        /**
+         * Returns the matrix with n rows whose row plan[i] is the sum of
+         * the rows i of this matrix with that index, the other rows being
+         * zero, i.e. the product of the transposed selection matrix with
+         * this matrix.
+         */
+        AutoDiffMatrix scatterRows(const GatherPlan& plan, const int n) const
+        {
+            assert(rows_ == plan.size());
+            switch (type_) {
+            case Zero:
+                return AutoDiffMatrix(n, cols_);
+            case Identity:
+            case Diagonal:
+                {
+                    AutoDiffMatrix retval(Sparse, n, cols_, DiagRep(), SparseRep(n, cols_));
+                    retval.sparse_.reserve(cols_);
+                    for (int col = 0; col < cols_; ++col) {
+                        retval.sparse_.startVec(col);
+                        retval.sparse_.insertBack(plan[col], col) = type_ == Identity ? 1.0 : diag_[col];
+                    }
+                    retval.sparse_.finalize();
+                    return retval;
+                }
+            case Sparse:
+                {
+                    const SparseRep& s = compressed();
+                    std::vector<int> outer, inner, start, source;
+                    plan.scatterColumns(cols_, s.outerIndexPtr(), s.innerIndexPtr(),
+                                        outer, inner, start, source);
+                    AutoDiffMatrix retval(Sparse, n, cols_, DiagRep(), SparseRep(n, cols_));
+                    selectedToSparse(s.valuePtr(), outer, inner, start, source, retval.sparse_);
+                    return retval;
+                }
+            case Stencil:
+                return selectStencil(*plan.scatter(pattern_, n));
+            default:
+                OPM_THROW(std::logic_error, "Invalid AutoDiffMatrix type encountered: " << type_);
+            }
+        }
+
+
+
+
+
+
+        /**
+         * Multiplies an AutoDiffMatrix with a scalar in place.
+         */
+        AutoDiffMatrix& operator*=(const double rhs)
+        {
+            switch (type_) {
+            case Zero:
+                break;
+            case Identity:
+                type_ = Diagonal;
+                diag_.assign(rows_, rhs);
+                break;
+            case Diagonal:
+                for (double& elem : diag_) {
+                    elem *= rhs;
+                }
+                break;
+            case Sparse:
+                sparse_ *= rhs;
+                break;
+            case Stencil:
+                for (double& elem : values_) {
+                    elem *= rhs;
+                }
+                break;
+            default:
+                OPM_THROW(std::logic_error, "Invalid AutoDiffMatrix type encountered: " << type_);
+            }
+            return *this;
+        }
+
+
+
+
+
+
         /**
          * Multiplies an AutoDiffMatrix with a scalar. Optimizes internally
          * by exploiting that e.g., an identity matrix multiplied by a scalar x
@@ -327,6 +647,14 @@ namespace Opm
                     retval.sparse_ *= rhs;
                     return retval;
                 }
+            case Stencil:
+                {
+                    AutoDiffMatrix retval(*this);
+                    for (double& elem : retval.values_) {
+                        elem *= rhs;
+                    }
+                    return retval;
+                }
             default:
                 OPM_THROW(std::logic_error, "Invalid AutoDiffMatrix type encountered: " << type_);
             }
@@ -368,6 +696,14 @@ namespace Opm
                     retval.sparse_ /= rhs;
                     return retval;
                 }
+            case Stencil:
+                {
+                    AutoDiffMatrix retval(*this);
+                    for (double& elem : retval.values_) {
+                        elem /= rhs;
+                    }
+                    return retval;
+                }
             default:
                 OPM_THROW(std::logic_error, "Invalid AutoDiffMatrix type encountered: " << type_);
             }
@@ -398,6 +734,18 @@ namespace Opm
                 }
             case Sparse:
                 return sparse_ * rhs;
+            case Stencil:
+                {
+                    Eigen::VectorXd result = Eigen::VectorXd::Zero(rows_);
+                    const std::vector<int>& outer = pattern_->outer();
+                    const std::vector<int>& inner = pattern_->inner();
+                    for (int col = 0; col < cols_; ++col) {
+                        for (int k = outer[col]; k < outer[col + 1]; ++k) {
+                            result[inner[k]] += values_[k] * rhs[col];
+                        }
+                    }
+                    return result;
+                }
             default:
                 OPM_THROW(std::logic_error, "Invalid AutoDiffMatrix type encountered: " << type_);
             }
@@ -526,10 +874,206 @@ namespace Opm
             retval.type_ = Sparse;
             retval.rows_ = lhs.rows_;
             retval.cols_ = rhs.cols_;
-            fastSparseProduct(lhs.sparse_, rhs.sparse_, retval.sparse_);
+            SparseProductCache::multiply(lhs.sparse_, rhs.sparse_, retval.sparse_);
+            return retval;
+        }
+
+        // Add a stencil matrix and any matrix
+        static AutoDiffMatrix addStencil(const AutoDiffMatrix& lhs, const AutoDiffMatrix& rhs)
+        {
+            assert(lhs.type_ == Stencil || rhs.type_ == Stencil);
+            if (rhs.type_ == Zero) {
+                return lhs;
+            }
+            if (lhs.type_ == Zero) {
+                return rhs;
+            }
+            if (lhs.type_ == Stencil && rhs.type_ == Stencil) {
+                return addTT(lhs, rhs);
+            }
+            if (rhs.type_ == Identity || rhs.type_ == Diagonal) {
+                return addTD(lhs, rhs);
+            }
+            if (lhs.type_ == Identity || lhs.type_ == Diagonal) {
+                return addTD(rhs, lhs);
+            }
+            // one operand is sparse
+            return lhs.type_ == Stencil ? lhs.asSparse() + rhs : lhs + rhs.asSparse();
+        }
+
+        // Add stencil to stencil
+        static AutoDiffMatrix addTT(const AutoDiffMatrix& lhs, const AutoDiffMatrix& rhs)
+        {
+            assert(lhs.type_ == Stencil);
+            assert(rhs.type_ == Stencil);
+            if (lhs.pattern_ == rhs.pattern_) {
+                AutoDiffMatrix retval = lhs;
+                for (std::size_t k = 0; k < retval.values_.size(); ++k) {
+                    retval.values_[k] += rhs.values_[k];
+                }
+                return retval;
+            }
+            const std::shared_ptr<const StencilPattern::Sum> plan = lhs.pattern_->sum(rhs.pattern_);
+            AutoDiffMatrix retval(Stencil, lhs.rows_, lhs.cols_);
+            retval.pattern_ = plan->lhsPattern ? lhs.pattern_ : (plan->rhsPattern ? rhs.pattern_ : plan->pattern);
+            retval.values_.assign(retval.pattern_->nonZeros(), 0.0);
+            for (std::size_t k = 0; k < lhs.values_.size(); ++k) {
+                retval.values_[plan->lhs.empty() ? k : plan->lhs[k]] += lhs.values_[k];
+            }
+            for (std::size_t k = 0; k < rhs.values_.size(); ++k) {
+                retval.values_[plan->rhs.empty() ? k : plan->rhs[k]] += rhs.values_[k];
+            }
+            return retval;
+        }
+
+        // Add stencil to identity or diagonal
+        static AutoDiffMatrix addTD(const AutoDiffMatrix& lhs, const AutoDiffMatrix& rhs)
+        {
+            assert(lhs.type_ == Stencil);
+            assert(rhs.type_ == Identity || rhs.type_ == Diagonal);
+            const std::vector<int>& diagonal = lhs.pattern_->diagonal();
+            if (diagonal.empty()) {
+                return lhs.asSparse() + rhs;
+            }
+            AutoDiffMatrix retval = lhs;
+            for (int r = 0; r < lhs.rows_; ++r) {
+                retval.values_[diagonal[r]] += (rhs.type_ == Identity) ? 1.0 : rhs.diag_[r];
+            }
             return retval;
         }
 
+        // Multiply a stencil matrix and any matrix
+        static AutoDiffMatrix mulStencil(const AutoDiffMatrix& lhs, const AutoDiffMatrix& rhs)
+        {
+            assert(lhs.type_ == Stencil || rhs.type_ == Stencil);
+            if (lhs.type_ == Zero || rhs.type_ == Zero) {
+                return AutoDiffMatrix(lhs.rows_, rhs.cols_);
+            }
+            if (lhs.type_ == Identity) {
+                return rhs;
+            }
+            if (rhs.type_ == Identity) {
+                return lhs;
+            }
+            if (lhs.type_ == Diagonal) {
+                AutoDiffMatrix retval = rhs;
+                return retval.scaleRows(lhs.diag_);
+            }
+            if (rhs.type_ == Diagonal) {
+                // scale the columns
+                AutoDiffMatrix retval = lhs;
+                const std::vector<int>& outer = lhs.pattern_->outer();
+                for (int col = 0; col < lhs.cols_; ++col) {
+                    for (int k = outer[col]; k < outer[col + 1]; ++k) {
+                        retval.values_[k] *= rhs.diag_[col];
+                    }
+                }
+                return retval;
+            }
+            if (lhs.type_ == Stencil && rhs.type_ == Stencil) {
+                return mulTT(lhs, rhs);
+            }
+            // one operand is sparse
+            return lhs.type_ == Stencil ? lhs.asSparse() * rhs : lhs * rhs.asSparse();
+        }
+
+        // Multiply stencil with stencil
+        static AutoDiffMatrix mulTT(const AutoDiffMatrix& lhs, const AutoDiffMatrix& rhs)
+        {
+            assert(lhs.type_ == Stencil);
+            assert(rhs.type_ == Stencil);
+            const std::shared_ptr<const StencilPattern::Product> plan = lhs.pattern_->product(rhs.pattern_);
+            AutoDiffMatrix retval(Stencil, lhs.rows_, rhs.cols_);
+            retval.pattern_ = plan->pattern;
+            const int nnz = plan->pattern->nonZeros();
+            retval.values_.resize(nnz);
+            for (int k = 0; k < nnz; ++k) {
+                double value = 0.0;
+                for (int t = plan->start[k]; t < plan->start[k + 1]; ++t) {
+                    value += lhs.values_[plan->lhs[t]] * rhs.values_[plan->rhs[t]];
+                }
+                retval.values_[k] = value;
+            }
+            return retval;
+        }
+
+        // The sparse representation in compressed form, sparse_ itself
+        // unless it has been modified by insertions.
+        const SparseRep& compressed() const
+        {
+            assert(type_ == Sparse);
+            if (sparse_.isCompressed()) {
+                return sparse_;
+            }
+            SparseRep& mutable_sparse = const_cast<SparseRep&>(sparse_);
+            mutable_sparse.makeCompressed();
+            return sparse_;
+        }
+
+        // Stencil matrix with the selected entries of a stencil matrix
+        AutoDiffMatrix selectStencil(const GatherPlan::Selection& selection) const
+        {
+            assert(type_ == Stencil);
+            AutoDiffMatrix retval(Stencil, selection.pattern->rows(), cols_);
+            retval.pattern_ = selection.pattern;
+            retval.values_.resize(selection.pattern->nonZeros());
+            for (std::size_t k = 0; k < retval.values_.size(); ++k) {
+                double value = 0.0;
+                for (int t = selection.start[k]; t < selection.start[k + 1]; ++t) {
+                    value += values_[selection.source[t]];
+                }
+                retval.values_[k] = value;
+            }
+            return retval;
+        }
+
+        // Sparse matrix with the selected entries of the values
+        static void selectedToSparse(const double* values,
+                                     const std::vector<int>& outer, const std::vector<int>& inner,
+                                     const std::vector<int>& start, const std::vector<int>& source,
+                                     SparseRep& s)
+        {
+            const int cols = outer.size() - 1;
+            s.reserve(inner.size());
+            for (int col = 0; col < cols; ++col) {
+                s.startVec(col);
+                for (int k = outer[col]; k < outer[col + 1]; ++k) {
+                    double value = 0.0;
+                    for (int t = start[k]; t < start[k + 1]; ++t) {
+                        value += values[source[t]];
+                    }
+                    s.insertBack(inner[k], col) = value;
+                }
+            }
+            s.finalize();
+        }
+
+        // Sparse matrix with the entries of a stencil matrix
+        AutoDiffMatrix asSparse() const
+        {
+            assert(type_ == Stencil);
+            AutoDiffMatrix retval(Sparse, rows_, cols_);
+            stencilToSparse(retval.sparse_);
+            return retval;
+        }
+
+        // Copy the entries of a stencil matrix to a sparse matrix
+        void stencilToSparse(SparseRep& s) const
+        {
+            assert(type_ == Stencil);
+            const std::vector<int>& outer = pattern_->outer();
+            const std::vector<int>& inner = pattern_->inner();
+            s = SparseRep(rows_, cols_);
+            s.reserve(values_.size());
+            for (int col = 0; col < cols_; ++col) {
+                s.startVec(col);
+                for (int k = outer[col]; k < outer[col + 1]; ++k) {
+                    s.insertBack(inner[k], col) = values_[k];
+                }
+            }
+            s.finalize();
+        }
+
 
 
 
@@ -554,6 +1098,13 @@ namespace Opm
             case Sparse:
                 s = sparse_;
                 return;
+            case Stencil:
+                {
+                    SparseRep sparse;
+                    stencilToSparse(sparse);
+                    s = sparse;
+                }
+                return;
             }
         }
 
@@ -596,6 +1147,8 @@ namespace Opm
                 return rows_;
             case Sparse:
                 return sparse_.nonZeros();
+            case Stencil:
+                return values_.size();
             default:
                 OPM_THROW(std::logic_error, "Invalid AutoDiffMatrix type encountered: " << type_);
             }
@@ -618,6 +1171,11 @@ namespace Opm
                 return (row == col) ? diag_[row] : 0.0;
             case Sparse:
                 return sparse_.coeff(row, col);
+            case Stencil:
+                {
+                    const int k = pattern_->find(row, col);
+                    return k < 0 ? 0.0 : values_[k];
+                }
             default:
                 OPM_THROW(std::logic_error, "Invalid AutoDiffMatrix type encountered: " << type_);
             }
@@ -642,20 +1200,26 @@ namespace Opm
                  * the const qualifier.
                  */
                 SparseRep& mutable_sparse = const_cast<SparseRep&>(sparse_);
-                toSparse(mutable_sparse);
+                if (type_ == Stencil) {
+                    stencilToSparse(mutable_sparse);
+                } else {
+                    toSparse(mutable_sparse);
+                }
             }
             return sparse_;
         }
 
 
     private:
-        enum AudoDiffMatrixType { Zero, Identity, Diagonal, Sparse };
+        enum AudoDiffMatrixType { Zero, Identity, Diagonal, Sparse, Stencil };
 
         AudoDiffMatrixType type_;  //<  Type of matrix
         int rows_;                 //<  Number of rows
         int cols_;                 //<  Number of columns
         DiagRep diag_;             //<  Diagonal representation (only if type==Diagonal)
         SparseRep sparse_;         //<  Sparse representation (only if type==Sparse)
+        StencilPattern::Pointer pattern_; //<  Sparsity pattern (only if type==Stencil)
+        DiagRep values_;           //<  Values of the pattern entries (only if type==Stencil)
 
 
 
@@ -668,7 +1232,9 @@ namespace Opm
               rows_(rows_arg),
               cols_(cols_arg),
               diag_(diag),
-              sparse_(sparse)
+              sparse_(sparse),
+              pattern_(),
+              values_()
         {
         }
 
@@ -0,0 +1,291 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_AUTODIFFSTENCIL_HEADER_INCLUDED
+#define OPM_AUTODIFFSTENCIL_HEADER_INCLUDED
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Immutable sparsity pattern of a stencil matrix, stored column-wise
+    /// with sorted row indices.
+    ///
+    /// Matrices sharing a pattern store their values only. The symbolic
+    /// parts of sums and products of two patterns are computed once and
+    /// cached in the left pattern, such that repeated operations with the
+    /// same operands, e.g. the divergence of a flux in every Newton
+    /// iteration, only perform the numeric part.
+    class StencilPattern
+    {
+    public:
+        typedef std::shared_ptr<const StencilPattern> Pointer;
+
+        /// Symbolic product lhs * rhs. The value of entry k of the result
+        /// is the sum over t in [start[k], start[k+1]) of
+        /// lhs value lhs[t] times rhs value rhs[t].
+        struct Product
+        {
+            Pointer pattern;
+            std::vector<int> start;
+            std::vector<int> lhs;
+            std::vector<int> rhs;
+        };
+
+        /// Symbolic sum lhs + rhs. The result has the pattern of lhs if
+        /// lhsPattern is true, the pattern of rhs if rhsPattern is true,
+        /// and pattern otherwise. Entry k of an operand is entry map[k] of
+        /// the result, an empty map is the identity.
+        struct Sum
+        {
+            bool lhsPattern;
+            bool rhsPattern;
+            Pointer pattern;
+            std::vector<int> lhs;
+            std::vector<int> rhs;
+        };
+
+        /// Create a pattern from column starts and sorted row indices.
+        static Pointer create(const int rows, const int cols,
+                              std::vector<int>&& outer, std::vector<int>&& inner)
+        {
+            return Pointer(new StencilPattern(rows, cols, std::move(outer), std::move(inner)));
+        }
+
+        /// Create the pattern of a column major Eigen sparse matrix and
+        /// store its values in values.
+        template <class SparseMatrix, class Values>
+        static Pointer fromSparse(const SparseMatrix& s, Values& values)
+        {
+            const int cols = s.outerSize();
+            std::vector<int> outer(cols + 1, 0);
+            std::vector<int> inner;
+            inner.reserve(s.nonZeros());
+            values.clear();
+            values.reserve(s.nonZeros());
+            for (int col = 0; col < cols; ++col) {
+                for (typename SparseMatrix::InnerIterator it(s, col); it; ++it) {
+                    inner.push_back(it.row());
+                    values.push_back(it.value());
+                }
+                outer[col + 1] = inner.size();
+            }
+            return create(s.rows(), s.cols(), std::move(outer), std::move(inner));
+        }
+
+        int rows() const { return rows_; }
+        int cols() const { return cols_; }
+        int nonZeros() const { return inner_.size(); }
+
+        /// Start of each column in inner(), with cols() + 1 entries.
+        const std::vector<int>& outer() const { return outer_; }
+
+        /// Row of each entry.
+        const std::vector<int>& inner() const { return inner_; }
+
+        /// Index of entry (row, col), -1 if the entry is not in the pattern.
+        int find(const int row, const int col) const
+        {
+            const auto begin = inner_.begin() + outer_[col];
+            const auto end = inner_.begin() + outer_[col + 1];
+            const auto it = std::lower_bound(begin, end, row);
+            return (it != end && *it == row) ? int(it - inner_.begin()) : -1;
+        }
+
+        /// Index of the diagonal entry of every row, empty if the pattern
+        /// is not square or a diagonal entry is missing.
+        const std::vector<int>& diagonal() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!diagonalComputed_) {
+                diagonalComputed_ = true;
+                if (rows_ == cols_) {
+                    diagonal_.resize(rows_);
+                    for (int row = 0; row < rows_; ++row) {
+                        diagonal_[row] = find(row, row);
+                        if (diagonal_[row] < 0) {
+                            diagonal_.clear();
+                            break;
+                        }
+                    }
+                }
+            }
+            return diagonal_;
+        }
+
+        /// Symbolic product of this pattern with rhs.
+        std::shared_ptr<const Product> product(const Pointer& rhs) const
+        {
+            assert(cols_ == rhs->rows_);
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::shared_ptr<const Product> plan = lookup(products_, rhs);
+            if (!plan) {
+                plan = computeProduct(*rhs);
+                products_.emplace_back(rhs, plan);
+            }
+            return plan;
+        }
+
+        /// Symbolic sum of this pattern with rhs.
+        std::shared_ptr<const Sum> sum(const Pointer& rhs) const
+        {
+            assert(rows_ == rhs->rows_ && cols_ == rhs->cols_);
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::shared_ptr<const Sum> plan = lookup(sums_, rhs);
+            if (!plan) {
+                plan = computeSum(*rhs);
+                sums_.emplace_back(rhs, plan);
+            }
+            return plan;
+        }
+
+    private:
+        template <class Plan>
+        using Cache = std::vector<std::pair<std::weak_ptr<const StencilPattern>, std::shared_ptr<const Plan> > >;
+
+        StencilPattern(const int rows, const int cols,
+                       std::vector<int>&& outer, std::vector<int>&& inner)
+            : rows_(rows), cols_(cols),
+              outer_(std::move(outer)), inner_(std::move(inner)),
+              diagonalComputed_(false)
+        {
+            assert(int(outer_.size()) == cols_ + 1);
+            assert(outer_.back() == int(inner_.size()));
+        }
+
+        // Find the plan for rhs and drop the plans of destroyed patterns.
+        template <class Plan>
+        static std::shared_ptr<const Plan> lookup(Cache<Plan>& cache, const Pointer& rhs)
+        {
+            std::shared_ptr<const Plan> plan;
+            auto entry = cache.begin();
+            while (entry != cache.end()) {
+                const Pointer key = entry->first.lock();
+                if (!key) {
+                    entry = cache.erase(entry);
+                    continue;
+                }
+                if (key == rhs) {
+                    plan = entry->second;
+                }
+                ++entry;
+            }
+            return plan;
+        }
+
+        std::shared_ptr<const Product> computeProduct(const StencilPattern& rhs) const
+        {
+            std::shared_ptr<Product> plan(new Product);
+            std::vector<int> outer(rhs.cols_ + 1, 0);
+            std::vector<int> inner;
+            plan->start.push_back(0);
+
+            // (row, lhs entry, rhs entry) of the contributions to a column
+            std::vector<std::pair<int, std::pair<int, int> > > terms;
+            for (int col = 0; col < rhs.cols_; ++col) {
+                terms.clear();
+                for (int r = rhs.outer_[col]; r < rhs.outer_[col + 1]; ++r) {
+                    const int k = rhs.inner_[r];
+                    for (int l = outer_[k]; l < outer_[k + 1]; ++l) {
+                        terms.emplace_back(inner_[l], std::make_pair(l, r));
+                    }
+                }
+                std::sort(terms.begin(), terms.end());
+                for (std::size_t t = 0; t < terms.size(); ++t) {
+                    if (t == 0 || terms[t].first != terms[t - 1].first) {
+                        if (t > 0) {
+                            plan->start.push_back(plan->lhs.size());
+                        }
+                        inner.push_back(terms[t].first);
+                    }
+                    plan->lhs.push_back(terms[t].second.first);
+                    plan->rhs.push_back(terms[t].second.second);
+                }
+                if (!terms.empty()) {
+                    plan->start.push_back(plan->lhs.size());
+                }
+                outer[col + 1] = inner.size();
+            }
+            plan->pattern = create(rows_, rhs.cols_, std::move(outer), std::move(inner));
+            return plan;
+        }
+
+        std::shared_ptr<const Sum> computeSum(const StencilPattern& rhs) const
+        {
+            std::shared_ptr<Sum> plan(new Sum);
+            std::vector<int> outer(cols_ + 1, 0);
+            std::vector<int> inner;
+            inner.reserve(std::max(inner_.size(), rhs.inner_.size()));
+            plan->lhs.resize(inner_.size());
+            plan->rhs.resize(rhs.inner_.size());
+
+            // merge the sorted columns
+            for (int col = 0; col < cols_; ++col) {
+                int l = outer_[col];
+                int r = rhs.outer_[col];
+                const int lend = outer_[col + 1];
+                const int rend = rhs.outer_[col + 1];
+                while (l < lend || r < rend) {
+                    const int lrow = l < lend ? inner_[l] : rows_;
+                    const int rrow = r < rend ? rhs.inner_[r] : rows_;
+                    const int row = std::min(lrow, rrow);
+                    if (lrow == row) {
+                        plan->lhs[l++] = inner.size();
+                    }
+                    if (rrow == row) {
+                        plan->rhs[r++] = inner.size();
+                    }
+                    inner.push_back(row);
+                }
+                outer[col + 1] = inner.size();
+            }
+
+            plan->lhsPattern = inner.size() == inner_.size();
+            plan->rhsPattern = !plan->lhsPattern && inner.size() == rhs.inner_.size();
+            if (plan->lhsPattern) {
+                plan->lhs.clear();
+            } else if (plan->rhsPattern) {
+                plan->rhs.clear();
+            } else {
+                plan->pattern = create(rows_, cols_, std::move(outer), std::move(inner));
+            }
+            return plan;
+        }
+
+        const int rows_;
+        const int cols_;
+        const std::vector<int> outer_;
+        const std::vector<int> inner_;
+
+        mutable std::mutex mutex_;
+        mutable bool diagonalComputed_;
+        mutable std::vector<int> diagonal_;
+        mutable Cache<Product> products_;
+        mutable Cache<Sum> sums_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_AUTODIFFSTENCIL_HEADER_INCLUDED
@@ -0,0 +1,106 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_AUTODIFFTHREADING_HEADER_INCLUDED
+#define OPM_AUTODIFFTHREADING_HEADER_INCLUDED
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Opm
+{
+
+    /// Threading of the elementwise operations on the values and the
+    /// diagonal and stencil Jacobians of AutoDiffBlock.
+    ///
+    /// Arrays with at least minimumSize() elements are split into one
+    /// contiguous chunk per OpenMP thread. The chunks of arrays of the same
+    /// size are the same in every operation, so each thread works on the
+    /// same range of cells as in the previous operation and finds it in its
+    /// cache. The operations on the Jacobian blocks of such arrays are then
+    /// done one block after the other instead of one block per thread.
+    /// Nested calls within a parallel region are sequential.
+    class AutoDiffThreading
+    {
+    public:
+        /// The size from which arrays are split among the threads.
+        static int minimumSize()
+        {
+            return minimumSizeRef();
+        }
+
+        static void setMinimumSize(const int size)
+        {
+            minimumSizeRef() = size;
+        }
+
+        /// Whether operations on arrays of size n are split among the
+        /// threads.
+        static bool threaded(const int n)
+        {
+#ifdef _OPENMP
+            return n >= minimumSizeRef() && omp_get_max_threads() > 1 && !omp_in_parallel();
+#else
+            static_cast<void>(n);
+            return false;
+#endif
+        }
+
+        /// Call f(begin, size) for the contiguous chunks of [0, n), in
+        /// parallel if threaded(n). f must not throw.
+        template <class F>
+        static void forChunks(const int n, F f)
+        {
+#ifdef _OPENMP
+            if (threaded(n)) {
+#pragma omp parallel
+                {
+                    const int numThreads = omp_get_num_threads();
+                    const int thread = omp_get_thread_num();
+                    const int begin = chunkBegin(n, thread, numThreads);
+                    const int end = chunkBegin(n, thread + 1, numThreads);
+                    if (end > begin) {
+                        f(begin, end - begin);
+                    }
+                }
+                return;
+            }
+#endif
+            if (n > 0) {
+                f(0, n);
+            }
+        }
+
+    private:
+        static int& minimumSizeRef()
+        {
+            static int size = 100000;
+            return size;
+        }
+
+        static int chunkBegin(const int n, const int chunk, const int numChunks)
+        {
+            return static_cast<int>(static_cast<long long>(n) * chunk / numChunks);
+        }
+    };
+
+} // namespace Opm
+
+#endif // OPM_AUTODIFFTHREADING_HEADER_INCLUDED
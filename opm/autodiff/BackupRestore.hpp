@@ -26,6 +26,7 @@
 
 #include <opm/core/simulator/BlackoilState.hpp>
 #include <opm/autodiff/WellStateFullyImplicitBlackoil.hpp>
+#include <opm/autodiff/CheckpointFile.hpp>
 
 namespace Opm {
 
@@ -316,6 +317,103 @@ namespace Opm {
         return in;
     }
 
+    // Chunked checkpoints, see CheckpointFile. Every array is copied to a
+    // chunk of its own, to be written in bulk by CheckpointFile::write.
+
+    // SimulationDataContainer
+    inline
+    void addToCheckpoint( CheckpointFile::Chunks& chunks, const SimulationDataContainer& state )
+    {
+        CheckpointFile::add( chunks, "state.numPhases", std::vector<int>( 1, state.numPhases() ) );
+        for( const auto& pair : state.cellData() ) {
+            CheckpointFile::add( chunks, "cell." + pair.first, pair.second );
+        }
+        CheckpointFile::add( chunks, "face.FACEPRESSURE", state.facepressure() );
+        CheckpointFile::add( chunks, "face.FACEFLUX", state.faceflux() );
+    }
+
+    inline
+    void restoreFromCheckpoint( const CheckpointFile& checkpoint, SimulationDataContainer& state )
+    {
+        std::vector<int> numPhases;
+        checkpoint.read( "state.numPhases", numPhases, true );
+        if( numPhases.size() != 1 || numPhases[ 0 ] != (int) state.numPhases() )
+            OPM_THROW(std::logic_error,"num phases wrong");
+
+        std::vector<std::string> names;
+        for( const auto& pair : state.cellData() ) {
+            names.push_back( pair.first );
+        }
+        for( const auto& name : names ) {
+            checkpoint.read( "cell." + name, state.getCellData( name ) );
+        }
+        checkpoint.read( "face.FACEPRESSURE", state.facepressure() );
+        checkpoint.read( "face.FACEFLUX", state.faceflux() );
+    }
+
+    // WellStateFullyImplicitBlackoil
+    inline
+    void addToCheckpoint( CheckpointFile::Chunks& chunks, const WellStateFullyImplicitBlackoil& state )
+    {
+        std::vector<int> sizes( 2 );
+        sizes[ 0 ] = state.numWells();
+        sizes[ 1 ] = state.numPhases();
+        CheckpointFile::add( chunks, "well.sizes", sizes );
+        CheckpointFile::add( chunks, "well.bhp", state.bhp() );
+        CheckpointFile::add( chunks, "well.temperature", state.temperature() );
+        CheckpointFile::add( chunks, "well.wellRates", state.wellRates() );
+        CheckpointFile::add( chunks, "well.perfRates", state.perfRates() );
+        CheckpointFile::add( chunks, "well.perfPress", state.perfPress() );
+        CheckpointFile::add( chunks, "well.perfPhaseRates", state.perfPhaseRates() );
+        CheckpointFile::add( chunks, "well.currentControls", state.currentControls() );
+
+        // well map, the names are separated by '\0'
+        typedef WellStateFullyImplicitBlackoil::WellMapType WellMapType;
+        std::string names;
+        std::vector< WellMapType::mapped_type > entries;
+        for( const auto& well : state.wellMap() ) {
+            names += well.first;
+            names += '\0';
+            entries.push_back( well.second );
+        }
+        CheckpointFile::add( chunks, "well.names", names );
+        CheckpointFile::add( chunks, "well.map", entries );
+    }
+
+    inline
+    void restoreFromCheckpoint( const CheckpointFile& checkpoint, WellStateFullyImplicitBlackoil& state )
+    {
+        std::vector<int> sizes;
+        checkpoint.read( "well.sizes", sizes, true );
+        if( sizes.size() != 2 || sizes[ 0 ] != (int) state.numWells() )
+            OPM_THROW(std::logic_error,"wrong numWells");
+        if( sizes[ 0 ] > 0 && sizes[ 1 ] != (int) state.numPhases() )
+            OPM_THROW(std::logic_error,"wrong numPhases");
+
+        checkpoint.read( "well.bhp", state.bhp(), true );
+        checkpoint.read( "well.temperature", state.temperature(), true );
+        checkpoint.read( "well.wellRates", state.wellRates(), true );
+        checkpoint.read( "well.perfRates", state.perfRates(), true );
+        checkpoint.read( "well.perfPress", state.perfPress(), true );
+        checkpoint.read( "well.perfPhaseRates", state.perfPhaseRates(), true );
+        checkpoint.read( "well.currentControls", state.currentControls(), true );
+
+        typedef WellStateFullyImplicitBlackoil::WellMapType WellMapType;
+        std::string names;
+        std::vector< WellMapType::mapped_type > entries;
+        checkpoint.read( "well.names", names, true );
+        checkpoint.read( "well.map", entries, true );
+        state.wellMap().clear();
+        std::size_t begin = 0;
+        for( const auto& entry : entries ) {
+            const std::size_t end = names.find( '\0', begin );
+            if( end == std::string::npos )
+                OPM_THROW(std::logic_error,"wrong well map");
+            state.wellMap().insert( std::make_pair( names.substr( begin, end - begin ), entry ) );
+            begin = end + 1;
+        }
+    }
+
 } // namespace Opm
 
 #endif // OPM_BACKUPRESTORE_HEADER_INCLUDED
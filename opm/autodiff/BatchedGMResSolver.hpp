@@ -0,0 +1,356 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef OPM_BATCHEDGMRESSOLVER_HEADER_INCLUDED
+#define OPM_BATCHEDGMRESSOLVER_HEADER_INCLUDED
+
+#include <dune/common/timer.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/paamg/pinfo.hh>
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/solver.hh>
+
+#if HAVE_MPI
+#include <dune/istl/owneroverlapcopy.hh>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace Opm
+{
+
+    /*!
+      \brief Scalar products of a vector with several others, computed with
+             a single global reduction.
+    */
+    template <class X>
+    class BatchedScalarProduct
+    {
+    public:
+        virtual ~BatchedScalarProduct() {}
+
+        /*!
+          \brief The scalar products of w with the first n vectors of basis
+                 in results[0..n-1], and of w with itself in results[n].
+        */
+        virtual void dots(const std::vector<X>& basis, const int n, const X& w,
+                          std::vector<double>& results) const = 0;
+
+    protected:
+        // the local scalar products, optionally restricted to the rows of mask
+        static void localDots(const std::vector<X>& basis, const int n, const X& w,
+                              const std::vector<double>* mask, std::vector<double>& results)
+        {
+            results.assign(n + 1, 0.0);
+            const std::size_t size = w.size();
+            for (std::size_t row = 0; row < size; ++row) {
+                const double weight = mask ? (*mask)[row] : 1.0;
+                if (weight == 0.0) {
+                    continue;
+                }
+                const auto& wRow = w[row];
+                for (int i = 0; i < n; ++i) {
+                    results[i] += weight * (basis[i][row] * wRow);
+                }
+                results[n] += weight * (wRow * wRow);
+            }
+        }
+    };
+
+
+
+    /// Batched scalar products of a sequential run.
+    template <class X>
+    class SequentialBatchedScalarProduct : public BatchedScalarProduct<X>
+    {
+    public:
+        virtual void dots(const std::vector<X>& basis, const int n, const X& w,
+                          std::vector<double>& results) const
+        {
+            this->localDots(basis, n, w, nullptr, results);
+        }
+    };
+
+
+
+#if HAVE_MPI
+    /// Batched scalar products of the owned rows of an overlapping
+    /// decomposition, summed over the processes in one reduction.
+    template <class X, class Communication>
+    class OverlappingBatchedScalarProduct : public BatchedScalarProduct<X>
+    {
+    public:
+        explicit OverlappingBatchedScalarProduct(const Communication& comm)
+            : comm_(comm)
+        {
+            for (const auto& index : comm_.indexSet()) {
+                const std::size_t row = index.local().local();
+                if (row >= mask_.size()) {
+                    mask_.resize(row + 1, 1.0);
+                }
+                if (index.local().attribute() != Dune::OwnerOverlapCopyAttributeSet::owner) {
+                    mask_[row] = 0.0;
+                }
+            }
+        }
+
+        virtual void dots(const std::vector<X>& basis, const int n, const X& w,
+                          std::vector<double>& results) const
+        {
+            mask_.resize(w.size(), 1.0);
+            this->localDots(basis, n, w, &mask_, results);
+            comm_.communicator().sum(results.data(), n + 1);
+        }
+
+    private:
+        const Communication& comm_;
+        mutable std::vector<double> mask_;
+    };
+#endif
+
+
+
+    template <class X>
+    std::unique_ptr< BatchedScalarProduct<X> >
+    createBatchedScalarProduct(const Dune::Amg::SequentialInformation&)
+    {
+        return std::unique_ptr< BatchedScalarProduct<X> >(new SequentialBatchedScalarProduct<X>());
+    }
+
+#if HAVE_MPI
+    template <class X, class GlobalIdType, class LocalIdType>
+    std::unique_ptr< BatchedScalarProduct<X> >
+    createBatchedScalarProduct(const Dune::OwnerOverlapCopyCommunication<GlobalIdType, LocalIdType>& comm)
+    {
+        typedef Dune::OwnerOverlapCopyCommunication<GlobalIdType, LocalIdType> Communication;
+        return std::unique_ptr< BatchedScalarProduct<X> >(
+            new OverlappingBatchedScalarProduct<X, Communication>(comm));
+    }
+#endif
+
+
+
+    /*!
+      \brief Restarted right preconditioned GMRES with one global reduction
+             per iteration.
+
+      The Arnoldi process orthogonalizes the new direction by classical
+      Gram-Schmidt, so the scalar products with all basis vectors and the
+      norm of the new direction are computed in one reduction, where
+      modified Gram-Schmidt needs one per basis vector. The norm after the
+      projection follows from the Pythagorean theorem. If the projection
+      removes more than half of the norm, the direction is orthogonalized
+      a second time, which restores the accuracy of modified Gram-Schmidt
+      at the cost of a second reduction.
+
+      The basis is preconditioned only once per restart cycle, when the
+      solution is updated, so only the m + 1 basis vectors are stored.
+
+      \tparam X The vector type of the domain and range.
+    */
+    template <class X>
+    class BatchedGMResSolver : public Dune::InverseOperator<X,X>
+    {
+    public:
+        typedef X domain_type;
+        typedef X range_type;
+        typedef typename X::field_type field_type;
+
+        /*! \brief Constructor.
+
+          \param op        The operator of the system.
+          \param sp        The batched scalar product.
+          \param prec      The preconditioner.
+          \param reduction The relative reduction of the defect to reach.
+          \param restart   The number of iterations before a restart.
+          \param maxit     The maximum number of iterations.
+          \param verbose   Print the result of the solve if positive.
+        */
+        BatchedGMResSolver(Dune::LinearOperator<X,X>& op,
+                           const BatchedScalarProduct<X>& sp,
+                           Dune::Preconditioner<X,X>& prec,
+                           const double reduction,
+                           const int restart,
+                           const int maxit,
+                           const int verbose)
+            : op_(op),
+              sp_(sp),
+              prec_(prec),
+              reduction_(reduction),
+              restart_(std::max(restart, 1)),
+              maxit_(maxit),
+              verbose_(verbose)
+        {
+        }
+
+        virtual void apply(X& x, X& b, Dune::InverseOperatorResult& res)
+        {
+            apply(x, b, reduction_, res);
+        }
+
+        /*!
+          \brief Solve A x = b starting from x, b is overwritten with the defect.
+        */
+        virtual void apply(X& x, X& b, double reduction, Dune::InverseOperatorResult& res)
+        {
+            Dune::Timer watch;
+            res.clear();
+
+            // b is the defect from now on
+            op_.applyscaleadd(-1.0, x, b);
+            const double def0 = norm(b);
+            double def = def0;
+
+            const int m = restart_;
+            std::vector<X> v(m + 1, b);
+            // the Hessenberg matrix by columns, reduced to triangular form
+            std::vector<double> H((m + 1) * m, 0.0);
+            std::vector<double> cs(m), sn(m), g(m + 1);
+            std::vector<double> h;
+            X z(b);
+
+            prec_.pre(x, b);
+            int it = 0;
+            while (it < maxit_ && def > reduction * def0 && def > 0.0) {
+                v[0] = b;
+                v[0] *= 1.0 / def;
+                std::fill(g.begin(), g.end(), 0.0);
+                g[0] = def;
+
+                int j = 0;
+                while (j < m && it < maxit_) {
+                    z = 0.0;
+                    prec_.apply(z, v[j]);
+                    op_.apply(z, v[j + 1]);
+                    ++it;
+
+                    const double hNext = orthogonalize(v, j + 1, h);
+                    double* column = &H[j * (m + 1)];
+                    for (int i = 0; i <= j; ++i) {
+                        column[i] = h[i];
+                    }
+                    column[j + 1] = hNext;
+                    if (hNext > 0.0) {
+                        v[j + 1] *= 1.0 / hNext;
+                    }
+
+                    // apply the previous rotations and eliminate column[j+1]
+                    for (int i = 0; i < j; ++i) {
+                        const double temp = cs[i] * column[i] + sn[i] * column[i + 1];
+                        column[i + 1] = -sn[i] * column[i] + cs[i] * column[i + 1];
+                        column[i] = temp;
+                    }
+                    const double r = std::sqrt(column[j] * column[j] + column[j + 1] * column[j + 1]);
+                    cs[j] = r > 0.0 ? column[j] / r : 1.0;
+                    sn[j] = r > 0.0 ? column[j + 1] / r : 0.0;
+                    column[j] = r;
+                    column[j + 1] = 0.0;
+                    g[j + 1] = -sn[j] * g[j];
+                    g[j] = cs[j] * g[j];
+                    ++j;
+
+                    // the estimate of the defect, or a breakdown in the exact solution
+                    if (std::abs(g[j]) <= reduction * def0 || !(hNext > 0.0)) {
+                        break;
+                    }
+                }
+
+                // x += M^-1 V y with the solution y of the triangular system
+                std::vector<double> y(g.begin(), g.begin() + j);
+                for (int i = j - 1; i >= 0; --i) {
+                    for (int k = i + 1; k < j; ++k) {
+                        y[i] -= H[k * (m + 1) + i] * y[k];
+                    }
+                    y[i] = H[i * (m + 1) + i] != 0.0 ? y[i] / H[i * (m + 1) + i] : 0.0;
+                }
+                // the last basis vector is not part of the update
+                X& u = v[m];
+                u = 0.0;
+                for (int i = 0; i < j; ++i) {
+                    u.axpy(y[i], v[i]);
+                }
+                z = 0.0;
+                prec_.apply(z, u);
+                x += z;
+
+                // the true defect of the updated solution
+                op_.applyscaleadd(-1.0, z, b);
+                def = norm(b);
+            }
+            prec_.post(x);
+
+            res.iterations = it;
+            res.reduction = def0 > 0.0 ? def / def0 : 0.0;
+            res.converged = def <= reduction * def0;
+            res.conv_rate = it > 0 ? std::pow(res.reduction, 1.0 / it) : 0.0;
+            res.elapsed = watch.elapsed();
+
+            if (verbose_ > 0) {
+                std::cout << "=== BatchedGMResSolver: " << it << " iterations, reduction "
+                          << res.reduction << ", time " << res.elapsed << std::endl;
+            }
+        }
+
+    private:
+        double norm(const X& w) const
+        {
+            std::vector<double> results;
+            sp_.dots(std::vector<X>(), 0, w, results);
+            return std::sqrt(results[0]);
+        }
+
+        // Orthogonalize v[n] against v[0..n-1] by classical Gram-Schmidt,
+        // store the coefficients in h and return the norm of the result.
+        double orthogonalize(std::vector<X>& v, const int n, std::vector<double>& h) const
+        {
+            X& w = v[n];
+            std::vector<double> results;
+            h.assign(n, 0.0);
+            double norm2 = 0.0;
+            for (int pass = 0; pass < 2; ++pass) {
+                sp_.dots(v, n, w, results);
+                norm2 = results[n];
+                for (int i = 0; i < n; ++i) {
+                    w.axpy(-results[i], v[i]);
+                    h[i] += results[i];
+                    norm2 -= results[i] * results[i];
+                }
+                // twice is enough unless most of the norm was cancelled
+                if (norm2 > 0.5 * results[n]) {
+                    break;
+                }
+            }
+            return std::sqrt(std::max(norm2, 0.0));
+        }
+
+        Dune::LinearOperator<X,X>& op_;
+        const BatchedScalarProduct<X>& sp_;
+        Dune::Preconditioner<X,X>& prec_;
+        double reduction_;
+        int restart_;
+        int maxit_;
+        int verbose_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_BATCHEDGMRESSOLVER_HEADER_INCLUDED
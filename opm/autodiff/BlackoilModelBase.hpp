@@ -35,6 +35,7 @@
 #include <opm/autodiff/RateConverter.hpp>
 #include <opm/autodiff/IterationReport.hpp>
 #include <opm/autodiff/DefaultBlackoilSolutionState.hpp>
+#include <opm/autodiff/PropertyCache.hpp>
 #include <opm/parser/eclipse/EclipseState/Grid/NNC.hpp>
 #include <opm/simulators/timestepping/SimulatorTimerInterface.hpp>
 #include <opm/core/simulator/SimulatorReport.hpp>
@@ -363,6 +364,18 @@ namespace Opm {
         // rate converter between the surface volume rates and reservoir voidage rates
         RateConverterType rate_converter_;
 
+        // The saturation function and PVT results of the last evaluation
+        // for the state, which are reused by the assembly, the well setup
+        // and the fluid in place within one version of the state. The
+        // version changes with the phase condition, i.e. when updateState()
+        // or prepareStep() change the primary variables.
+        unsigned long state_version_;
+        mutable PropertyCache pressure_cache_;
+        mutable PropertyCache relperm_cache_;
+        // by canonical phase
+        mutable std::vector<PropertyCache> viscosity_cache_;
+        mutable std::vector<PropertyCache> fvf_cache_;
+
         // ---------  Protected methods  ---------
 
         /// Access the most-derived class used for
@@ -379,6 +392,10 @@ namespace Opm {
             return static_cast<const Implementation&>(*this);
         }
 
+        /// Start a new version of the state, such that the cached
+        /// properties of the previous version are not reused.
+        void invalidatePropertyCache() { ++state_version_; }
+
         /// return the Well struct in the WellModel
         const Wells& wells() const { return well_model_.wells(); }
 
@@ -430,6 +447,11 @@ namespace Opm {
                                            const SolutionState& state,
                                            const WellState& xw);
 
+        /// Newton increment of the well variables in solveWellEq(), from
+        /// the well equations with the reservoir variables kept fixed.
+        V
+        solveWellEqIncrement(const ADB& total_residual) const;
+
         bool getWellConvergence(const int iteration);
 
         bool isVFPActive() const;
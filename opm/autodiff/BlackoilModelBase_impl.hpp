@@ -27,7 +27,9 @@
 #include <opm/autodiff/BlackoilModelBase.hpp>
 #include <opm/autodiff/BlackoilDetails.hpp>
 #include <opm/autodiff/BlackoilLegacyDetails.hpp>
+#include <opm/autodiff/VariableSwitching.hpp>
 
+#include <opm/autodiff/AutoDiffArena.hpp>
 #include <opm/autodiff/AutoDiffBlock.hpp>
 #include <opm/autodiff/AutoDiffHelpers.hpp>
 #include <opm/autodiff/GridHelpers.hpp>
@@ -144,6 +146,9 @@ typedef Eigen::Array<double,
         // TODO: more delicate implementation will be required if we want to handle different
         // FIP regions specified from the well specifications.
         , rate_converter_(fluid_.phaseUsage(), fluid_.cellPvtRegionIndex(), AutoDiffGrid::numCells(grid_), std::vector<int>(AutoDiffGrid::numCells(grid_),0))
+        , state_version_(0)
+        , viscosity_cache_(Opm::BlackoilPhases::MaxNumPhases)
+        , fvf_cache_(Opm::BlackoilPhases::MaxNumPhases)
     {
         if (active_[Water]) {
             material_name_.push_back("Water");
@@ -224,6 +229,7 @@ typedef Eigen::Array<double,
         const double dt = timer.currentStepLength();
 
         pvdt_ = geo_.poreVolume() / dt;
+        invalidatePropertyCache();
         if (active_[Gas]) {
             updatePrimalVariableFromState(reservoir_state);
         }
@@ -286,11 +292,11 @@ typedef Eigen::Array<double,
             try {
                 dx = asImpl().solveJacobianSystem();
                 report.linear_solve_time += perfTimer.stop();
-                report.total_linear_iterations += linearIterationsLastSolve();
+                report.total_linear_iterations += asImpl().linearIterationsLastSolve();
             }
             catch (...) {
                 report.linear_solve_time += perfTimer.stop();
-                report.total_linear_iterations += linearIterationsLastSolve();
+                report.total_linear_iterations += asImpl().linearIterationsLastSolve();
                 throw;
             }
 
@@ -727,7 +733,8 @@ typedef Eigen::Array<double,
             if (active_[ phase ]) {
                 const int pos = pu.phase_pos[ phase ];
                 sd_.rq[pos].b = asImpl().fluidReciprocFVF(phase, state.canonical_phase_pressures[phase], temp, rs, rv, cond);
-                sd_.rq[pos].accum[aix] = pv_mult * sd_.rq[pos].b * sat[pos];
+                sd_.rq[pos].accum[aix] = pv_mult * sd_.rq[pos].b;
+                sd_.rq[pos].accum[aix] *= sat[pos];
                 // OPM_AD_DUMP(sd_.rq[pos].b);
                 // OPM_AD_DUMP(sd_.rq[pos].accum[aix]);
             }
@@ -742,8 +749,8 @@ typedef Eigen::Array<double,
             // when both dissolved gas and vaporized oil are present.
             const ADB accum_gas_copy =sd_.rq[pg].accum[aix];
 
-            sd_.rq[pg].accum[aix] += state.rs * sd_.rq[po].accum[aix];
-            sd_.rq[po].accum[aix] += state.rv * accum_gas_copy;
+            sd_.rq[pg].accum[aix].fma(state.rs, sd_.rq[po].accum[aix]);
+            sd_.rq[po].accum[aix].fma(state.rv, accum_gas_copy);
             // OPM_AD_DUMP(sd_.rq[pg].accum[aix]);
         }
     }
@@ -761,6 +768,9 @@ typedef Eigen::Array<double,
     {
         using namespace Opm::AutoDiffGrid;
 
+        // reuse the storage of the temporaries of this assembly
+        AutoDiffArena::Scope arenaScope;
+
         SimulatorReport report;
 
         // If we have VFP tables, we need the well connection
@@ -876,7 +886,7 @@ typedef Eigen::Array<double,
 
             residual_.material_balance_eq[ phaseIdx ] =
                 pvdt_ * (sd_.rq[phaseIdx].accum[1] - sd_.rq[phaseIdx].accum[0])
-                + ops_.div*sd_.rq[phaseIdx].mflux;
+                + ops_.stencil.div*sd_.rq[phaseIdx].mflux;
         }
 
         // -------- Extra (optional) rs and rv contributions to the mass balance equations --------
@@ -896,8 +906,8 @@ typedef Eigen::Array<double,
                                                 sd_.rq[pg].dh.value());
             const ADB rv_face = upwindGas.select(state.rv);
 
-            residual_.material_balance_eq[ pg ] += ops_.div * (rs_face * sd_.rq[po].mflux);
-            residual_.material_balance_eq[ po ] += ops_.div * (rv_face * sd_.rq[pg].mflux);
+            residual_.material_balance_eq[ pg ] += ops_.stencil.div * (rs_face * sd_.rq[po].mflux);
+            residual_.material_balance_eq[ po ] += ops_.stencil.div * (rv_face * sd_.rq[pg].mflux);
 
             // OPM_AD_DUMP(residual_.material_balance_eq[ Gas ]);
 
@@ -968,7 +978,7 @@ typedef Eigen::Array<double,
         const V& efficiency_factors = wellModel().wellPerfEfficiencyFactors();
         for (int phase = 0; phase < np; ++phase) {
             residual_.material_balance_eq[phase] -= superset(efficiency_factors * cq_s[phase],
-                                                             wellModel().wellOps().well_cells, nc);
+                                                             wellModel().wellOps().well_cells_plan, nc);
         }
     }
 
@@ -1012,6 +1022,26 @@ typedef Eigen::Array<double,
 
 
 
+    template <class Grid, class WellModel, class Implementation>
+    typename BlackoilModelBase<Grid, WellModel, Implementation>::V
+    BlackoilModelBase<Grid, WellModel, Implementation>::
+    solveWellEqIncrement(const ADB& total_residual) const
+    {
+        const std::vector<M>& Jn = total_residual.derivative();
+        typedef Eigen::SparseMatrix<double> Sp;
+        Sp Jn0;
+        Jn[0].toSparse(Jn0);
+        const Eigen::SparseLU< Sp > solver(Jn0);
+        ADB::V total_residual_v = total_residual.value();
+        const Eigen::VectorXd& dx = solver.solve(total_residual_v.matrix());
+        assert(dx.size() == total_residual_v.size());
+        return dx.array();
+    }
+
+
+
+
+
     template <class Grid, class WellModel, class Implementation>
     SimulatorReport
     BlackoilModelBase<Grid, WellModel, Implementation>::
@@ -1070,15 +1100,8 @@ typedef Eigen::Array<double,
                 eqs.push_back(residual_.well_flux_eq);
                 eqs.push_back(residual_.well_eq);
                 ADB total_residual = vertcatCollapseJacs(eqs);
-                const std::vector<M>& Jn = total_residual.derivative();
-                typedef Eigen::SparseMatrix<double> Sp;
-                Sp Jn0;
-                Jn[0].toSparse(Jn0);
-                const Eigen::SparseLU< Sp > solver(Jn0);
-                ADB::V total_residual_v = total_residual.value();
-                const Eigen::VectorXd& dx = solver.solve(total_residual_v.matrix());
-                assert(dx.size() == total_residual_v.size());
-                asImpl().wellModel().updateWellState(dx.array(), dbhpMaxRel(), well_state);
+                const V dx = asImpl().solveWellEqIncrement(total_residual);
+                asImpl().wellModel().updateWellState(dx, dbhpMaxRel(), well_state);
             }
             // We have to update the well controls regardless whether there are local
             // wells active or not as parallel logging will take place that needs to
@@ -1227,46 +1250,10 @@ typedef Eigen::Array<double,
             so = so_old - step * dso;
         }
 
-        if (active_[Gas]) {
-            auto ixg = sg < 0;
-            for (int c = 0; c < nc; ++c) {
-                if (ixg[c]) {
-                    if (active_[Water]) {
-                        sw[c] = sw[c] / (1-sg[c]);
-                    }
-                    so[c] = so[c] / (1-sg[c]);
-                    sg[c] = 0;
-                }
-            }
-        }
-
-        if (active_[Oil]) {
-            auto ixo = so < 0;
-            for (int c = 0; c < nc; ++c) {
-                if (ixo[c]) {
-                    if (active_[Water]) {
-                        sw[c] = sw[c] / (1-so[c]);
-                    }
-                    if (active_[Gas]) {
-                        sg[c] = sg[c] / (1-so[c]);
-                    }
-                    so[c] = 0;
-                }
-            }
-        }
-
-        if (active_[Water]) {
-            auto ixw = sw < 0;
-            for (int c = 0; c < nc; ++c) {
-                if (ixw[c]) {
-                    so[c] = so[c] / (1-sw[c]);
-                    if (active_[Gas]) {
-                        sg[c] = sg[c] / (1-sw[c]);
-                    }
-                    sw[c] = 0;
-                }
-            }
-        }
+        detail::chopSaturations(nc,
+                                active_[Water] ? sw.data() : nullptr,
+                                so.data(),
+                                active_[Gas] ? sg.data() : nullptr);
 
         // Update rs and rv
         const double drmaxrel = drMaxRel();
@@ -1287,11 +1274,9 @@ typedef Eigen::Array<double,
             rv = rv.max(zero);
         }
 
-        // Sg is used as primal variable for water only cells.
-        const double epsilon = std::sqrt(std::numeric_limits<double>::epsilon());
-        auto watOnly = sw >  (1 - epsilon);
-
-        // phase translation sg <-> rs
+        // phase translation sg <-> rs, Sg is used as primal variable for
+        // water only cells
+        const double* swData = active_[Water] ? sw.data() : nullptr;
         std::vector<HydroCarbonState>& hydroCarbonState = reservoir_state.hydroCarbonState();
         std::fill(hydroCarbonState.begin(), hydroCarbonState.end(), HydroCarbonState::GasAndOil);
 
@@ -1299,26 +1284,9 @@ typedef Eigen::Array<double,
             const V rsSat0 = fluidRsSat(p_old, s_old.col(pu.phase_pos[Oil]), cells_);
             const V rsSat = fluidRsSat(p, so, cells_);
             sd_.rsSat = ADB::constant(rsSat);
-            // The obvious case
-            auto hasGas = (sg > 0 && isRs_ == 0);
-
-            // Set oil saturated if previous rs is sufficiently large
-            const V rs_old = Eigen::Map<const V>(&reservoir_state.gasoilratio()[0], nc);
-            auto gasVaporized =  ( (rs > rsSat * (1+epsilon) && isRs_ == 1 ) && (rs_old > rsSat0 * (1-epsilon)) );
-            auto useSg = watOnly || hasGas || gasVaporized;
-            for (int c = 0; c < nc; ++c) {
-                if (useSg[c]) {
-                    rs[c] = rsSat[c];
-                    if (watOnly[c]) {
-                        so[c] = 0;
-                        sg[c] = 0;
-                        rs[c] = 0;
-                    }
-                } else {
-                    hydroCarbonState[c] = HydroCarbonState::OilOnly;
-                }
-            }
-            //rs = rs.min(rsSat);
+            detail::switchDissolvedGas(nc, swData, isRs_.data(), rsSat.data(), rsSat0.data(),
+                                       &reservoir_state.gasoilratio()[0],
+                                       so.data(), sg.data(), rs.data(), hydroCarbonState.data());
         }
 
         // phase transitions so <-> rv
@@ -1330,56 +1298,36 @@ typedef Eigen::Array<double,
             const V rvSat0 = fluidRvSat(gaspress_old, s_old.col(pu.phase_pos[Oil]), cells_);
             const V rvSat = fluidRvSat(gaspress, so, cells_);
             sd_.rvSat = ADB::constant(rvSat);
-
-            // The obvious case
-            auto hasOil = (so > 0 && isRv_ == 0);
-
-            // Set oil saturated if previous rv is sufficiently large
-            const V rv_old = Eigen::Map<const V>(&reservoir_state.rv()[0], nc);
-            auto oilCondensed = ( (rv > rvSat * (1+epsilon) && isRv_ == 1) && (rv_old > rvSat0 * (1-epsilon)) );
-            auto useSg = watOnly || hasOil || oilCondensed;
-            for (int c = 0; c < nc; ++c) {
-                if (useSg[c]) {
-                    rv[c] = rvSat[c];
-                    if (watOnly[c]) {
-                        so[c] = 0;
-                        sg[c] = 0;
-                        rv[c] = 0;
-                    }
-                } else {
-                    hydroCarbonState[c] = HydroCarbonState::GasOnly;
-                }
-            }
-            //rv = rv.min(rvSat);
+            detail::switchVaporizedOil(nc, swData, isRv_.data(), rvSat.data(), rvSat0.data(),
+                                       &reservoir_state.rv()[0],
+                                       so.data(), sg.data(), rv.data(), hydroCarbonState.data());
         }
 
-        // Update the reservoir_state
-        if (active_[Water]) {
-            for (int c = 0; c < nc; ++c) {
-                reservoir_state.saturation()[c*np + pu.phase_pos[ Water ]] = sw[c];
-            }
-        }
-
-        if (active_[Gas]) {
-            for (int c = 0; c < nc; ++c) {
-                reservoir_state.saturation()[c*np + pu.phase_pos[ Gas ]] = sg[c];
-            }
-        }
-
-        if (active_[ Oil ]) {
+        // Update the reservoir_state in one pass over the cells
+        {
+            double* saturation = &reservoir_state.saturation()[0];
+            double* gasoilratio = has_disgas_ ? &reservoir_state.gasoilratio()[0] : nullptr;
+            double* vaporizedoil = has_vapoil_ ? &reservoir_state.rv()[0] : nullptr;
+            const int waterPos = pu.phase_pos[ Water ];
+            const int oilPos = pu.phase_pos[ Oil ];
+            const int gasPos = pu.phase_pos[ Gas ];
             for (int c = 0; c < nc; ++c) {
-                reservoir_state.saturation()[c*np + pu.phase_pos[ Oil ]] = so[c];
+                if (active_[Water]) {
+                    saturation[c*np + waterPos] = sw[c];
+                }
+                if (active_[Gas]) {
+                    saturation[c*np + gasPos] = sg[c];
+                }
+                saturation[c*np + oilPos] = so[c];
+                if (gasoilratio) {
+                    gasoilratio[c] = rs[c];
+                }
+                if (vaporizedoil) {
+                    vaporizedoil[c] = rv[c];
+                }
             }
         }
 
-        if (has_disgas_) {
-            std::copy(&rs[0], &rs[0] + nc, reservoir_state.gasoilratio().begin());
-        }
-
-        if (has_vapoil_) {
-            std::copy(&rv[0], &rv[0] + nc, reservoir_state.rv().begin());
-        }
-
         asImpl().wellModel().updateWellState(dwells, dbhpMaxRel(), well_state);
 
         // Update phase conditions used for property calculations.
@@ -1413,7 +1361,13 @@ typedef Eigen::Array<double,
                          ? state.saturation[ pu.phase_pos[ Gas ] ]
                          : zero);
 
-        return fluid_.relperm(sw, so, sg, cells_);
+        std::vector<ADB> kr;
+        if (relperm_cache_.find(state_version_, { &sw, &so, &sg }, kr)) {
+            return kr;
+        }
+        kr = fluid_.relperm(sw, so, sg, cells_);
+        relperm_cache_.store(state_version_, { &sw, &so, &sg }, kr);
+        return kr;
     }
 
 
@@ -1428,8 +1382,13 @@ typedef Eigen::Array<double,
                      const ADB& so,
                      const ADB& sg) const
     {
+        std::vector<ADB> pressure;
+        if (pressure_cache_.find(state_version_, { &po, &sw, &so, &sg }, pressure)) {
+            return pressure;
+        }
+
         // convert the pressure offsets to the capillary pressures
-        std::vector<ADB> pressure = fluid_.capPress(sw, so, sg, cells_);
+        pressure = fluid_.capPress(sw, so, sg, cells_);
         for (int phaseIdx = 0; phaseIdx < BlackoilPhases::MaxNumPhases; ++phaseIdx) {
             // The reference pressure is always the liquid phase (oil) pressure.
             if (phaseIdx == BlackoilPhases::Liquid)
@@ -1454,6 +1413,7 @@ typedef Eigen::Array<double,
             }
         }
 
+        pressure_cache_.store(state_version_, { &po, &sw, &so, &sg }, pressure);
         return pressure;
     }
 
@@ -1495,8 +1455,8 @@ typedef Eigen::Array<double,
         sd_.rq[ actph ].mob = tr_mult * kr / mu;
 
         // Compute head differentials. Gravity potential is done using the face average as in eclipse and MRST.
-        const ADB rhoavg = ops_.caver * rho;
-        sd_.rq[ actph ].dh = ops_.ngrad * phasePressure - geo_.gravity()[2] * (rhoavg * (ops_.ngrad * geo_.z().matrix()));
+        const ADB rhoavg = ops_.stencil.caver * rho;
+        sd_.rq[ actph ].dh = ops_.stencil.ngrad * phasePressure - geo_.gravity()[2] * (rhoavg * (ops_.ngrad * geo_.z().matrix()));
         if (use_threshold_pressure_) {
             applyThresholdPressures(sd_.rq[ actph ].dh);
         }
@@ -1962,16 +1922,27 @@ typedef Eigen::Array<double,
                    const ADB&              rv   ,
                    const std::vector<PhasePresence>& cond) const
     {
+        if (phase < 0 || phase >= Opm::BlackoilPhases::MaxNumPhases) {
+            OPM_THROW(std::runtime_error, "Unknown phase index " << phase);
+        }
+        std::vector<ADB> mu;
+        PropertyCache& cache = viscosity_cache_[phase];
+        if (cache.find(state_version_, { &p, &temp, &rs, &rv }, mu)) {
+            return std::move(mu[0]);
+        }
         switch (phase) {
         case Water:
-            return fluid_.muWat(p, temp, cells_);
+            mu.assign(1, fluid_.muWat(p, temp, cells_));
+            break;
         case Oil:
-            return fluid_.muOil(p, temp, rs, cond, cells_);
+            mu.assign(1, fluid_.muOil(p, temp, rs, cond, cells_));
+            break;
         case Gas:
-            return fluid_.muGas(p, temp, rv, cond, cells_);
-        default:
-            OPM_THROW(std::runtime_error, "Unknown phase index " << phase);
+            mu.assign(1, fluid_.muGas(p, temp, rv, cond, cells_));
+            break;
         }
+        cache.store(state_version_, { &p, &temp, &rs, &rv }, mu);
+        return std::move(mu[0]);
     }
 
 
@@ -1988,16 +1959,27 @@ typedef Eigen::Array<double,
                      const ADB&              rv   ,
                      const std::vector<PhasePresence>& cond) const
     {
+        if (phase < 0 || phase >= Opm::BlackoilPhases::MaxNumPhases) {
+            OPM_THROW(std::runtime_error, "Unknown phase index " << phase);
+        }
+        std::vector<ADB> b;
+        PropertyCache& cache = fvf_cache_[phase];
+        if (cache.find(state_version_, { &p, &temp, &rs, &rv }, b)) {
+            return std::move(b[0]);
+        }
         switch (phase) {
         case Water:
-            return fluid_.bWat(p, temp, cells_);
+            b.assign(1, fluid_.bWat(p, temp, cells_));
+            break;
         case Oil:
-            return fluid_.bOil(p, temp, rs, cond, cells_);
+            b.assign(1, fluid_.bOil(p, temp, rs, cond, cells_));
+            break;
         case Gas:
-            return fluid_.bGas(p, temp, rv, cond, cells_);
-        default:
-            OPM_THROW(std::runtime_error, "Unknown phase index " << phase);
+            b.assign(1, fluid_.bGas(p, temp, rv, cond, cells_));
+            break;
         }
+        cache.store(state_version_, { &p, &temp, &rs, &rv }, b);
+        return std::move(b[0]);
     }
 
 
@@ -2016,10 +1998,10 @@ typedef Eigen::Array<double,
         const Opm::PhaseUsage& pu = fluid_.phaseUsage();
         ADB rho = rhos * b;
         if (phase == Oil && active_[Gas]) {
-            rho += fluid_.surfaceDensity(pu.phase_pos[ Gas ],  cells_) * rs * b;
+            rho.fma(fluid_.surfaceDensity(pu.phase_pos[ Gas ],  cells_) * rs, b);
         }
         if (phase == Gas && active_[Oil]) {
-            rho += fluid_.surfaceDensity(pu.phase_pos[ Oil ],  cells_) * rv * b;
+            rho.fma(fluid_.surfaceDensity(pu.phase_pos[ Oil ],  cells_) * rv, b);
         }
         return rho;
     }
@@ -2151,6 +2133,7 @@ typedef Eigen::Array<double,
     BlackoilModelBase<Grid, WellModel, Implementation>::
     classifyCondition(const ReservoirState& state)
     {
+        invalidatePropertyCache();
         using namespace Opm::AutoDiffGrid;
         const int nc = numCells(grid_);
         const int np = state.numPhases();
@@ -2205,6 +2188,7 @@ typedef Eigen::Array<double,
     BlackoilModelBase<Grid, WellModel, Implementation>::
     updatePhaseCondFromPrimalVariable(const ReservoirState& state)
     {
+        invalidatePropertyCache();
         const int nc = Opm::AutoDiffGrid::numCells(grid_);
         isRs_ = V::Zero(nc);
         isRv_ = V::Zero(nc);
@@ -2216,24 +2200,23 @@ typedef Eigen::Array<double,
             return;
         }
         for (int c = 0; c < nc; ++c) {
+            const HydroCarbonState hcState = state.hydroCarbonState()[c];
+            const bool gasAndOil = hcState == HydroCarbonState::GasAndOil;
+            const bool oilOnly = hcState == HydroCarbonState::OilOnly;
+            const bool gasOnly = hcState == HydroCarbonState::GasOnly;
+            if (!(gasAndOil || oilOnly || gasOnly)) {
+                OPM_THROW(std::logic_error, "Unknown primary variable enum value in cell " << c << ": " << hcState);
+            }
+            isSg_[c] = gasAndOil;
+            isRs_[c] = oilOnly;
+            isRv_[c] = gasOnly;
             phaseCondition_[c] = PhasePresence(); // No free phases.
             phaseCondition_[c].setFreeWater(); // Not necessary for property calculation usage.
-            switch (state.hydroCarbonState()[c]) {
-            case HydroCarbonState::GasAndOil:
-                phaseCondition_[c].setFreeOil();
-                phaseCondition_[c].setFreeGas();
-                isSg_[c] = 1;
-                break;
-            case HydroCarbonState::OilOnly:
+            if (!gasOnly) {
                 phaseCondition_[c].setFreeOil();
-                isRs_[c] = 1;
-                break;
-            case HydroCarbonState::GasOnly:
+            }
+            if (!oilOnly) {
                 phaseCondition_[c].setFreeGas();
-                isRv_[c] = 1;
-                break;
-            default:
-                OPM_THROW(std::logic_error, "Unknown primary variable enum value in cell " << c << ": " << state.hydroCarbonState()[c]);
             }
         }
     }
@@ -2272,6 +2255,9 @@ typedef Eigen::Array<double,
         saturation[Gas] = active_[Gas] ? ADB::constant(s.col(Gas)) : ADB::constant(V::Zero(nc));
         const ADB rs =  ADB::constant(Eigen::Map<const V>(& x.gasoilratio()[0], nc, 1));
         const ADB rv = ADB::constant(Eigen::Map<const V>(& x.rv()[0], nc, 1));
+        // the simulator updates the hysteresis of the saturation functions
+        // between the steps, which changes the capillary pressures
+        pressure_cache_.clear();
         const auto canonical_phase_pressures = computePressures(pressure, saturation[Water], saturation[Oil], saturation[Gas]);
         const Opm::PhaseUsage& pu = fluid_.phaseUsage();
         const std::vector<PhasePresence> cond = phaseCondition();
@@ -2594,7 +2580,7 @@ typedef Eigen::Array<double,
 
             for (int phase = 0; phase < np; ++phase) {
                 if (active_[phase]) {
-                    const std::vector<int>& well_cells = asImpl().wellModel().wellOps().well_cells;
+                    const GatherPlan& well_cells = asImpl().wellModel().wellOps().well_cells_plan;
                     const ADB mu = asImpl().fluidViscosity(canph_[phase], state.canonical_phase_pressures[canph_[phase]],
                                                        temp, rs, rv, cond);
                     mob[phase] = tr_mult * kr[canph_[phase]] / mu;
@@ -41,7 +41,15 @@
 #include <opm/autodiff/BlackoilDetails.hpp>
 #include <opm/autodiff/BlackoilModelEnums.hpp>
 #include <opm/autodiff/NewtonIterationBlackoilInterface.hpp>
+#include <opm/autodiff/PerformanceTrace.hpp>
+#include <opm/autodiff/TimerTree.hpp>
+#include <opm/autodiff/DebugLog.hpp>
+#include <opm/autodiff/HardwareCounters.hpp>
+#include <opm/autodiff/MemoryTracker.hpp>
+#include <opm/autodiff/ProfilerAnnotations.hpp>
 #include <opm/autodiff/RateConverter.hpp>
+#include <opm/autodiff/SumAndMaxReduction.hpp>
+#include <opm/autodiff/ThreadHandle.hpp>
 
 #include <opm/core/grid.h>
 #include <opm/core/simulator/SimulatorReport.hpp>
@@ -59,6 +67,15 @@
 #include <opm/parser/eclipse/EclipseState/Tables/TableManager.hpp>
 
 #include <opm/autodiff/ISTLSolver.hpp>
+#include <opm/autodiff/LinearSystemDump.hpp>
+#include <opm/autodiff/MemoryUsage.hpp>
+#include <opm/autodiff/MatrixOrdering.hpp>
+#include <opm/autodiff/BlockMatrixDifference.hpp>
+#include <opm/autodiff/AdjointSensitivities.hpp>
+#include <opm/autodiff/SubdomainPartition.hpp>
+#include <opm/autodiff/AdaptiveImplicitJacobian.hpp>
+#include <opm/autodiff/ElementColoring.hpp>
+#include <opm/autodiff/BlockKernels.hpp>
 #include <opm/common/data/SimulationDataContainer.hpp>
 
 #include <dune/istl/owneroverlapcopy.hh>
@@ -66,11 +83,22 @@
 #include <dune/common/timer.hh>
 #include <dune/common/unused.hh>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include <cassert>
 #include <cmath>
+#include <exception>
+#include <functional>
 #include <iostream>
 #include <iomanip>
 #include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
 #include <vector>
 #include <algorithm>
 #include <fstream>
@@ -104,10 +132,15 @@ namespace Opm {
         typedef BlackoilState ReservoirState;
         typedef WellStateFullyImplicitBlackoilDense WellState;
         typedef BlackoilModelParameters ModelParameters;
+        /// The dense well model, which is eliminated in the linear operator.
+        /// A model of multi-segment wells must provide the same interface.
+        typedef StandardWellsDense<TypeTag> WellModel;
 
         typedef typename GET_PROP_TYPE(TypeTag, Simulator)         Simulator;
         typedef typename GET_PROP_TYPE(TypeTag, Grid)              Grid;
         typedef typename GET_PROP_TYPE(TypeTag, ElementContext)    ElementContext;
+        typedef typename GET_PROP_TYPE(TypeTag, GridView)          GridView;
+        typedef typename GridView::template Codim<0>::Entity       Element;
         typedef typename GET_PROP_TYPE(TypeTag, SolutionVector)    SolutionVector ;
         typedef typename GET_PROP_TYPE(TypeTag, PrimaryVariables)  PrimaryVariables ;
         typedef typename GET_PROP_TYPE(TypeTag, FluidSystem)       FluidSystem;
@@ -127,8 +160,11 @@ namespace Opm {
         typedef Dune::FieldMatrix<Scalar, numEq, numEq >        MatrixBlockType;
         typedef Dune::BCRSMatrix <MatrixBlockType>      Mat;
         typedef Dune::BlockVector<VectorBlockType>      BVector;
+        typedef Dune::FieldMatrix<float, numEq, numEq > FloatMatrixBlockType;
+        typedef Dune::BCRSMatrix <FloatMatrixBlockType> FloatMat;
 
         typedef ISTLSolver< MatrixBlockType, VectorBlockType, BlackoilIndices::pressureSwitchIdx >  ISTLSolverType;
+        typedef AdjointSensitivities< MatrixBlockType, VectorBlockType > Adjoint;
         //typedef typename SolutionVector :: value_type            PrimaryVariables ;
 
         // For the conversion between the surface volume rate and resrevoir voidage rate
@@ -151,7 +187,7 @@ namespace Opm {
         /// \param[in] terminal_output  request output to cout/cerr
         BlackoilModelEbos(Simulator& ebosSimulator,
                           const ModelParameters& param,
-                          const StandardWellsDense<TypeTag>& well_model,
+                          const WellModel& well_model,
                           const NewtonIterationBlackoilInterface& linsolver,
                           const bool terminal_output
                           )
@@ -161,18 +197,31 @@ namespace Opm {
         , phaseUsage_(phaseUsageFromDeck(eclState()))
         , vfp_properties_(
             eclState().getTableManager().getVFPInjTables(),
-            eclState().getTableManager().getVFPProdTables())
+            eclState().getTableManager().getVFPProdTables(),
+            param.share_node_tables_)
         , active_(detail::activePhases(phaseUsage_))
         , has_disgas_(FluidSystem::enableDissolvedGas())
         , has_vapoil_(FluidSystem::enableVaporizedOil())
-        , has_solvent_(GET_PROP_VALUE(TypeTag, EnableSolvent))
-        , has_polymer_(GET_PROP_VALUE(TypeTag, EnablePolymer))
         , param_( param )
         , well_model_ (well_model)        
         , terminal_output_ (terminal_output)
         , rate_converter_(phaseUsage_, ebosSimulator_.problem().pvtRegionArray().empty()?nullptr:ebosSimulator_.problem().pvtRegionArray().data(), AutoDiffGrid::numCells(grid_), std::vector<int>(AutoDiffGrid::numCells(grid_),0))
+        , linear_failures_(0)
+        , linear_solves_(0)
+        , refinement_iterations_(0)
+        , forcing_term_(1.0)
+        , preconditioner_reuses_(0)
         , current_relaxation_(1.0)
         , dx_old_(AutoDiffGrid::numCells(grid_))
+        , reservoir_state_outdated_(false)
+        , well_assembly_time_(0.0)
+        , line_search_residual_(0.0)
+        , predictor_previous_step_length_(0.0)
+        , predictor_report_step_(-1)
+        , primaryVariableSwitches_(0)
+        , performanceTrace_(nullptr)
+        , adjoint_(nullptr)
+        , memoryUsageReported_(false)
         , isBeginReportStep_(false)
         {
             // Wells are active if they are active wells on at least
@@ -191,6 +240,21 @@ namespace Opm {
         bool isParallel() const
         { return  grid_.comm().size() > 1; }
 
+        /// Record the timings of the Newton iterations in the given trace,
+        /// which must outlive the model. Pass nullptr to disable tracing.
+        void setPerformanceTrace(PerformanceTrace* trace)
+        { performanceTrace_ = trace; }
+
+        /// The time in seconds spent in the assembly of the well equations
+        /// by this model, including failed time steps.
+        double wellAssemblyTime() const
+        { return well_assembly_time_; }
+
+        /// Record the converged time steps for the adjoint gradients, in the
+        /// given object which must outlive the model. Pass nullptr to disable.
+        void setAdjointSensitivities(Adjoint* adjoint)
+        { adjoint_ = adjoint; }
+
         const EclipseState& eclState() const
         { return ebosSimulator_.gridManager().eclState(); }
 
@@ -268,25 +332,39 @@ namespace Opm {
         /// \param[in] nonlinear_solver       nonlinear solver used (for oscillation/relaxation control)
         /// \param[in, out] reservoir_state   reservoir state variables
         /// \param[in, out] well_state        well state variables
+        /// \param[in] initial_reservoir_state  initial state given to NonlinearSolver::step(),
+        ///                                   the same object as reservoir_state if none was
+        ///                                   given. It is not used by this model.
         template <class NonlinearSolverType>
         SimulatorReport nonlinearIteration(const int iteration,
                                            const SimulatorTimerInterface& timer,
                                            NonlinearSolverType& nonlinear_solver,
                                            ReservoirState& reservoir_state,
-                                           WellState& well_state, ReservoirState& initial_reservoir_state)
+                                           WellState& well_state, const ReservoirState& initial_reservoir_state)
         {
-            ReservoirState copy_initial_reservoir_state = initial_reservoir_state;
+            TimerTree::Region region("Newton iteration");
             SimulatorReport report;
             failureReport_ = SimulatorReport();
             Dune::Timer perfTimer;
 
             perfTimer.start();
+            if (performanceTrace_) {
+                performanceTrace_->beginIteration(timer.reportStepNum(), timer.currentStepNum(), iteration);
+            }
             if (iteration == 0) {
                 // For each iteration we store in a vector the norms of the residual of
                 // the mass balance for each active phase, the well flux and the well equations.
                 residual_norms_history_.clear();
+                linear_failures_ = 0;
                 current_relaxation_ = 1.0;
                 dx_old_ = 0.0;
+                line_search_reservoir_state_.reset();
+                line_search_well_state_.reset();
+                reservoir_state_outdated_ = false;
+
+                if (param_.use_time_step_predictor_) {
+                    predictTimeStep(timer, reservoir_state);
+                }
             }
 
             report.total_linearizations = 1;
@@ -310,11 +388,84 @@ namespace Opm {
 
              // checking whether the group targets are converged
              if (wellModel().wellCollection()->groupControlActive()) {
-                  report.converged = report.converged && wellModel().wellCollection()->groupTargetConverged(well_state.wellRates());
+                  report.converged = report.converged && wellModel().groupTargetConverged(well_state.wellRates());
              }
 
             report.update_time += perfTimer.stop();
+
+            // backtrack along the previous update while it increased the
+            // residual, the residual of the full update is the one just assembled
+            int cuts = 0;
+            while (!report.converged && lineSearchRejects(iteration, residual_norms, cuts)) {
+                ++cuts;
+                const double step = std::pow(0.5, cuts);
+                if (terminalOutputEnabled()) {
+                    std::string msg = "    Residual increased: Newton update scaled by "
+                        + std::to_string(step);
+                    OpmLog::info(msg);
+                }
+
+                perfTimer.reset();
+                perfTimer.start();
+                if (param_.update_ebos_directly_) {
+                    previous_solution_ = ebosSimulator_.model().solution(/*timeIdx=*/0);
+                    ebosSimulator_.model().solution(/*timeIdx=*/0) = line_search_solution_;
+                    invalidateChangedIntensiveQuantities(previous_solution_);
+                }
+                else {
+                    reservoir_state = *line_search_reservoir_state_;
+                }
+                well_state = *line_search_well_state_;
+                BVector& x = workspace_.dx;
+                BVector& xw = workspace_.dxw;
+                x = line_search_dx_;
+                xw = line_search_dxw_;
+                x *= step;
+                xw *= step;
+                applyUpdate(iteration - 1, x, xw, reservoir_state, well_state);
+                report.update_time += perfTimer.stop();
+
+                perfTimer.reset();
+                perfTimer.start();
+                report.total_linearizations += 1;
+                try {
+                    report += assemble(timer, iteration, reservoir_state, well_state);
+                    report.assemble_time += perfTimer.stop();
+                }
+                catch (...) {
+                    report.assemble_time += perfTimer.stop();
+                    failureReport_ += report;
+                    throw;
+                }
+
+                perfTimer.reset();
+                perfTimer.start();
+                residual_norms.clear();
+                report.converged = getConvergence(timer, iteration,residual_norms) && iteration > nonlinear_solver.minIter();
+                if (wellModel().wellCollection()->groupControlActive()) {
+                    report.converged = report.converged && wellModel().groupTargetConverged(well_state.wellRates());
+                }
+                report.update_time += perfTimer.stop();
+            }
+
+            if (!report.converged && param_.nldd_num_subdomains_ > 0) {
+                try {
+                    solveSubdomains(timer, iteration, nonlinear_solver, reservoir_state, well_state,
+                                    residual_norms, report);
+                }
+                catch (...) {
+                    failureReport_ += report;
+                    throw;
+                }
+            }
+
             residual_norms_history_.push_back(residual_norms);
+            if (!report.converged
+                && nonlinear_solver.detectDivergence(residual_norms_history_, iteration, linear_failures_)) {
+                failureReport_ += report;
+                const std::string msg = "Diverging nonlinear iterations detected in iteration " + std::to_string(iteration);
+                OPM_THROW_NOLOG(NumericalProblem, msg);
+            }
             if (!report.converged) {
                 perfTimer.reset();
                 perfTimer.start();
@@ -326,13 +477,43 @@ namespace Opm {
                 // Compute the nonlinear update.
                 const int nc = AutoDiffGrid::numCells(grid_);
                 const int nw = numWells();
-                BVector x(nc);
-                BVector xw(nw);
+                workspace_.resize(nc, nw);
+                BVector& x = workspace_.dx;
+                BVector& xw = workspace_.dxw;
+
+                if (nonlinear_solver.linearForcing()) {
+                    // no tighter than linear_solver_reduction
+                    forcing_term_ = nonlinear_solver.forcingTerm(residual_norms_history_, iteration, forcing_term_);
+                    istlSolver().setReduction(std::max(forcing_term_, istlSolver().defaultReduction()));
+                }
+
+                if (param_.preconditioner_reuse_ratio_ > 0.0) {
+                    const bool reuse = reusePreconditioner(iteration);
+                    istlSolver().setPreconditionerReuse(reuse);
+                    preconditioner_reuses_ = reuse ? preconditioner_reuses_ + 1 : 0;
+                }
 
                 try {
-                    solveJacobianSystem(x, xw);
+                    if (param_.jacobian_free_newton_ && !isParallel()) {
+                        solveJacobianSystemMatrixFree(x, xw, timer.currentStepLength(), well_state);
+                    }
+                    else {
+                        solveJacobianSystem(x, xw, iteration);
+                    }
                     report.linear_solve_time += perfTimer.stop();
                     report.total_linear_iterations += linearIterationsLastSolve();
+                    // consecutive solves that did not converge, if such failures are ignored
+                    linear_failures_ = istlSolver().converged() ? 0 : linear_failures_ + 1;
+                    if (performanceTrace_) {
+                        performanceTrace_->record(PerformanceTrace::PreconditionerSetup, istlSolver().preconditionerSetupTime());
+                        performanceTrace_->record(PerformanceTrace::LinearSolve, istlSolver().krylovSolveTime());
+                        performanceTrace_->setLinearIterations(linearIterationsLastSolve());
+                    }
+                    if (!memoryUsageReported_) {
+                        reportMemoryUsage();
+                        reportMatrixBandwidth();
+                        memoryUsageReported_ = true;
+                    }
                 }
                 catch (...) {
                     report.linear_solve_time += perfTimer.stop();
@@ -360,541 +541,571 @@ namespace Opm {
                 }
                 nonlinear_solver.stabilizeNonlinearUpdate(x, dx_old_, current_relaxation_);
 
+                // keep the state before the update for backtracking
+                if (param_.line_search_max_cuts_ > 0) {
+                    // assign into the copies of the previous iteration, if any,
+                    // to reuse their storage
+                    if (line_search_well_state_) {
+                        *line_search_well_state_ = well_state;
+                    }
+                    else {
+                        line_search_well_state_.reset(new WellState(well_state));
+                    }
+                    if (param_.update_ebos_directly_) {
+                        line_search_solution_ = ebosSimulator_.model().solution(/*timeIdx=*/0);
+                    }
+                    else if (line_search_reservoir_state_) {
+                        *line_search_reservoir_state_ = reservoir_state;
+                    }
+                    else {
+                        line_search_reservoir_state_.reset(new ReservoirState(reservoir_state));
+                    }
+                    line_search_dx_ = x;
+                    line_search_dxw_ = xw;
+                    line_search_residual_ = maxResidualNorm(residual_norms);
+                }
+
                 // Apply the update, with considering model-dependent limitations and
                 // chopping of the update.
                 // Dune::printvector(std::cout, x, "x vector", "row");
-                updateState(x,reservoir_state);
-                wellModel().updateWellState(xw, well_state);
-                // if the solution is updated the solution needs to be comunicated to ebos
-                // and the cachedIntensiveQuantities needs to be updated.
-                convertInput( iteration, reservoir_state, ebosSimulator_ );
-                ebosSimulator_.model().invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+                applyUpdate(iteration, x, xw, reservoir_state, well_state);
 
                 report.update_time += perfTimer.stop();
             }
-            else{ // Now we have converged
-                ReservoirState final_reservoir_state = reservoir_state;
-
-                //--------------------------------- Numerical jacobian  -----------------------------------------
-                //---------------------------------        A  B         -----------------------------------------
-                //---------------------------------        C  D         -----------------------------------------
-
-                const int nw = numWells();
-                const int nc = AutoDiffGrid::numCells(grid_);
-
-                // Residual containers:
-                std::vector<GlobalEqVector> residualsMB(2); // {f(x - dx/2), f(x + dx/2)}
-                std::vector<std::vector<std::vector<Scalar>>> residualsWE;
-                // Initialization of residualsWE:
-                for (std::size_t i=0; i < 2; ++i){
-                    std::vector<std::vector<Scalar >> tmp1;
-                    for (std::size_t j=0; j < 2; ++j){
-                        std::vector<Scalar> tmp2;
-                        for (std::size_t k=0; k < 3; ++k){
-                            tmp2.push_back(0);
-                        }
-                        tmp1.push_back(tmp2);
-                    }
-                    residualsWE.push_back(tmp1);
-                }
-
-                // The perturbation vectors
-                BVector dw(nw);
-                BVector dx(nc);
-
-                // The ground truth
-                auto& duneA = ebosSimulator_.model().linearizer().matrixA();
-                auto& duneB = wellModel().B();
-                auto& duneC = wellModel().C();
-                auto& duneD = wellModel().D();
-
-
-                // ------------  create and setup the matrices for the jacobians ----------------------- Start
-
-                typedef Dune::FieldMatrix<Scalar,2,2> M;
-                Dune::BCRSMatrix<M> A(9,9, Dune::BCRSMatrix<M>::random);
-                Dune::BCRSMatrix<M> numA0(9,9, Dune::BCRSMatrix<M>::random);
-                Dune::BCRSMatrix<M> numA(9,9, Dune::BCRSMatrix<M>::random);
-                Dune::BCRSMatrix<M> diffA(9,9, Dune::BCRSMatrix<M>::random);
-                typedef Dune::FieldMatrix<Scalar,2,3> dimBlockB;
-                Dune::BCRSMatrix<dimBlockB> B(9,2, Dune::BCRSMatrix<dimBlockB>::random);
-                Dune::BCRSMatrix<dimBlockB> numB(9,2, Dune::BCRSMatrix<dimBlockB>::random);
-                Dune::BCRSMatrix<dimBlockB> diffB(9,2, Dune::BCRSMatrix<dimBlockB>::random);
-                typedef Dune::FieldMatrix<Scalar,3,2> dimBlockC;
-                Dune::BCRSMatrix<dimBlockC> C(2,9, Dune::BCRSMatrix<dimBlockC>::random);
-                Dune::BCRSMatrix<dimBlockC> numC(2,9, Dune::BCRSMatrix<dimBlockC>::random);
-                Dune::BCRSMatrix<dimBlockC> diffC(2,9, Dune::BCRSMatrix<dimBlockC>::random);
-                typedef Dune::FieldMatrix<Scalar,3,3> dimBlockD;
-                Dune::BCRSMatrix<dimBlockD> D(2,2, Dune::BCRSMatrix<dimBlockD>::random);
-                Dune::BCRSMatrix<dimBlockD> numD(2,2, Dune::BCRSMatrix<dimBlockD>::random);
-                Dune::BCRSMatrix<dimBlockD> diffD(2,2, Dune::BCRSMatrix<dimBlockD>::random);
-
-{
-                denseInitializationOfBCRSMatrix(A);
-                denseInitializationOfBCRSMatrix(numA0);
-                denseInitializationOfBCRSMatrix(numA);
-                denseInitializationOfBCRSMatrix(diffA);
-                denseInitializationOfBCRSMatrix(B);
-                denseInitializationOfBCRSMatrix(numB);
-                denseInitializationOfBCRSMatrix(diffB);
-                denseInitializationOfBCRSMatrix(C);
-                denseInitializationOfBCRSMatrix(numC);
-                denseInitializationOfBCRSMatrix(diffC);
-                denseInitializationOfBCRSMatrix(D);
-                denseInitializationOfBCRSMatrix(numD);
-                denseInitializationOfBCRSMatrix(diffD);
-
-                //Dune::printmatrix(std::cout, duneC, "AD duneC", "row");
-
-                // Copy the relevant elements from the AD jacobians made by the simulator.
-                for(std::size_t row_block=0; row_block < C.N(); ++row_block ){
-                    for(std::size_t col_block=0; col_block < C.M(); ++col_block ){
-                        if (duneC.exists(row_block, col_block)){
-                            C[row_block][col_block][0][0] = duneC[row_block][col_block][0][0];
-                            C[row_block][col_block][0][1] = duneC[row_block][col_block][0][1];
-                            C[row_block][col_block][1][0] = duneC[row_block][col_block][1][0];
-                            C[row_block][col_block][1][1] = duneC[row_block][col_block][1][1];
-                            C[row_block][col_block][2][0] = duneC[row_block][col_block][2][0];
-                            C[row_block][col_block][2][1] = duneC[row_block][col_block][2][1];
-                        }
-                    }
+            else {
+                if (reservoir_state_outdated_) {
+                    convertOutput(reservoir_state);
+                    reservoir_state_outdated_ = false;
                 }
-
-                // Copy the relevant elements from the AD jacobian made by the simulator.
-                for(std::size_t row_block=0; row_block < D.N(); ++row_block ){
-                    for(std::size_t col_block=0; col_block < D.M(); ++col_block ){
-                        if (duneD.exists(row_block, col_block)){
-                            D[row_block][col_block][0][0] = duneD[row_block][col_block][0][0];
-                            D[row_block][col_block][0][1] = duneD[row_block][col_block][0][1];
-                            D[row_block][col_block][0][2] = duneD[row_block][col_block][0][2];
-                            D[row_block][col_block][1][0] = duneD[row_block][col_block][1][0];
-                            D[row_block][col_block][1][1] = duneD[row_block][col_block][1][1];
-                            D[row_block][col_block][1][2] = duneD[row_block][col_block][1][2];
-                            D[row_block][col_block][2][0] = duneD[row_block][col_block][2][0];
-                            D[row_block][col_block][2][1] = duneD[row_block][col_block][2][1];
-                            D[row_block][col_block][2][2] = duneD[row_block][col_block][2][2];
-                        }
-                    }
+                // compare the Jacobian of the converged iteration with finite differences
+                if (param_.verify_jacobian_) {
+                    verifyJacobian(iteration, timer, well_state);
                 }
-
-                // duneB is transposed, B is not!
-                // Copy the relevant elements from the AD jacobian made by the simulator.
-                for(std::size_t row_block=0; row_block < B.N(); ++row_block ){
-                    for(std::size_t col_block=0; col_block < B.M(); ++col_block ){
-                        if (duneB.exists(col_block, row_block)){
-                            //B[row_block][col_block] = duneB[col_block][row_block].transpose();
-                            B[row_block][col_block][0][0] = duneB[col_block][row_block][0][0];
-                            B[row_block][col_block][0][1] = duneB[col_block][row_block][1][0];
-                            B[row_block][col_block][0][2] = duneB[col_block][row_block][2][0];
-                            B[row_block][col_block][1][0] = duneB[col_block][row_block][0][1];
-                            B[row_block][col_block][1][1] = duneB[col_block][row_block][1][1];
-                            B[row_block][col_block][1][2] = duneB[col_block][row_block][2][1];
-                        }
-                    }
+                if (param_.jacobian_directions_ > 0) {
+                    verifyJacobianDirections(iteration, timer, well_state);
                 }
-
-                // Copy the relevant elements from the AD jacobian made by the simulator.
-                for(std::size_t row_block=0; row_block < 9; ++row_block ){
-                    for(std::size_t col_block=0; col_block < 9; ++col_block ){
-                        if (duneA.exists(row_block, col_block)){
-                            A[row_block][col_block][0][0] = duneA[row_block][col_block][0][0];
-                            A[row_block][col_block][0][1] = duneA[row_block][col_block][0][1];
-                            A[row_block][col_block][1][0] = duneA[row_block][col_block][1][0];
-                            A[row_block][col_block][1][1] = duneA[row_block][col_block][1][1];
-                        }
-                    }
+                if (adjoint_) {
+                    recordAdjointStep(iteration, timer, well_state);
                 }
-}
-                // ------------  create and setup the matrices for the jacobians ----------------------- End
-
+            }
 
-                std::vector<Scalar> pert_sizes = {-0.000001, -10}; // Using a negative value is the same as applying a positive perturbation.
+                if (performanceTrace_) {
+                    performanceTrace_->endIteration();
+                }
+                return report;
+        }
 
 
-                // Calculates the numerical A and C.
-                for(std::size_t cell_block=0; cell_block<9; ++cell_block){         // For each grid block.
-                    for(int state_type = 0; state_type<2; ++state_type){           // For each phase/state_variable in that grid block
-                        residualsMB[0] = 0; residualsMB[1] = 0;
-                        // Resetting the well residual container:
-                        for (std::size_t i=0; i < residualsWE.size(); ++i){
-                            for (std::size_t j=0; j < residualsWE[i].size(); ++j){
-                                for (std::size_t k=0; k < residualsWE[i][j].size(); ++k){
-                                    residualsWE[i][j][k] = 0;
-                                }
-                            }
-                        }
+        /// Set a primary variable of a cell in ebos. Only the cached intensive
+        /// quantities of this cell depend on it and are invalidated, those of
+        /// the other cells are kept for the next evaluation.
+        void setPrimaryVariable(const int cellIdx, const int pvIdx, const double value)
+        {
+            ebosSimulator_.model().solution(/*timeIdx=*/0)[cellIdx][pvIdx] = value;
+            ebosSimulator_.model().setIntensiveQuantitiesCacheEntryValidity(cellIdx, /*timeIdx=*/0, false);
+        }
 
-                        for (int i = 0; i < 2; ++i){                            // We are doing central difference
+        /// Invalidate the cached intensive quantities of the cells whose primary
+        /// variables or their meaning differ from the previous solution, for
+        /// which the cache was valid. The unchanged cells, e.g. most of a
+        /// quiescent reservoir, keep their cached intensive quantities.
+        /// eturn the number of invalidated cells
+        int invalidateChangedIntensiveQuantities(const SolutionVector& previous)
+        {
+            auto& model = ebosSimulator_.model();
+            const SolutionVector& solution = model.solution(/*timeIdx=*/0);
+            const int numCells = solution.size();
+            if (static_cast<int>(previous.size()) != numCells) {
+                model.invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+                return numCells;
+            }
+            int changedCells = 0;
+            for (int cellIdx = 0; cellIdx < numCells; ++cellIdx) {
+                const PrimaryVariables& cellPv = solution[cellIdx];
+                const PrimaryVariables& previousPv = previous[cellIdx];
+                bool changed = cellPv.primaryVarsMeaning() != previousPv.primaryVarsMeaning();
+                for (int pvIdx = 0; pvIdx < numEq && !changed; ++pvIdx) {
+                    changed = cellPv[pvIdx] != previousPv[pvIdx];
+                }
+                if (changed) {
+                    model.setIntensiveQuantitiesCacheEntryValidity(cellIdx, /*timeIdx=*/0, false);
+                    ++changedCells;
+                }
+            }
+            return changedCells;
+        }
 
-                            ReservoirState tmp_reservoir_state = reservoir_state; // Copy
-                            WellState tmp_well_state = well_state; //copy
-                            dx = 0; // reset the perturbation vector
-                            dx[cell_block][state_type] = (i==0) ? -pert_sizes[state_type]/2 : pert_sizes[state_type]/2; // The first iteration calculates the f(x - dx/2)
+        /// Evaluate the residuals of the cells and wells for the primary
+        /// variables in ebos and the well variables of well_state, in the
+        /// flow format of the Newton iterations. Only the residuals are
+        /// converted and the well equations are assembled without their
+        /// matrices and with fixed controls.
+        void evaluatePerturbedResiduals(const double dt,
+                                        WellState& well_state,
+                                        BVector& cellResiduals,
+                                        BVector& wellResiduals)
+        {
+            ebosSimulator_.model().linearizer().linearize();
 
-                            // Apply the perturbation to the reservoir state variable
-                            updateState(dx,tmp_reservoir_state);
+            auto& ebosResid = ebosSimulator_.model().linearizer().residual();
+            convertResiduals(ebosResid);
+            wellModel().assembleResidual(ebosSimulator_, dt, well_state);
 
-                            // Send this information to ebos (and also convert it to ebos format)
-                            convertInput( iteration, tmp_reservoir_state, ebosSimulator_ );
+            cellResiduals = ebosResid;
+            if (numWells() > 0) {
+                wellResiduals = wellModel().residualWE();
+            }
+        }
 
-                            // Delete the cache and recalculate.
-                            ebosSimulator_.model().invalidateIntensiveQuantitiesCache(0); //0 is timeidx
+        /// Assemble the Jacobian and residuals of the converged iteration again
+        /// after the evaluations of the Jacobian verification, with the
+        /// primary variables in ebos restored.
+        void restoreLinearization(const int iteration,
+                                  const double dt,
+                                  const WellState& well_state)
+        {
+            ebosSimulator_.model().linearizer().linearize();
 
-                            // Calculate the residual (and also the ad jacobian)
-                            ebosSimulator_.model().linearizer().linearize();
+            auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
+            auto& ebosResid = ebosSimulator_.model().linearizer().residual();
+            convertResults(ebosResid, ebosJac);
+            WellState tmpWellState = well_state;
+            wellModel().assemble(ebosSimulator_, iteration, dt, tmpWellState);
+        }
 
-                            // Need to convert the jacobian to "flow format". (Scaling by some factors)
-                            auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
-                            auto& ebosResid = ebosSimulator_.model().linearizer().residual();
-                            convertResults(ebosResid, ebosJac);
+        /// Record the linearization of the converged step for the adjoint
+        /// gradients. The accumulation terms are the only ones which depend on
+        /// the time step, they are separated by a second linearization with
+        /// twice the time step: R(dt) - R(2 dt) = (M(y_n) - M(y_{n-1})) / (2 dt),
+        /// and the same for the diagonal blocks of the Jacobian and M'(y_n).
+        /// The converged linearization is restored afterwards.
+        void recordAdjointStep(const int iteration,
+                               const SimulatorTimerInterface& timer,
+                               const WellState& well_state)
+        {
+            const int nc = AutoDiffGrid::numCells(grid_);
+            const int nw = numWells();
+            const double dt = timer.currentStepLength();
+            adjoint_step_.reset(new typename Adjoint::Step());
+            typename Adjoint::Step& step = *adjoint_step_;
+            step.dt = dt;
 
-                            //Run the well equations too.
-                            double dt = timer.currentStepLength();
-                            wellModel().assemble(ebosSimulator_, iteration, dt, tmp_well_state); // This will affect the residuals and the jacobian in ebosSimulator_
+            const auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
+            const auto& ebosResid = ebosSimulator_.model().linearizer().residual();
+            ebosSimulator_.setTimeStepSize(2.0 * dt);
+            restoreLinearization(iteration, 2.0 * dt, well_state);
+            step.accumulation = ebosResid;
+            step.cellStorage.resize(nc);
+            for (int cell = 0; cell < nc; ++cell) {
+                step.cellStorage[cell] = ebosJac[cell][cell];
+            }
+            step.wellStorage.resize(nw);
+            if (nw > 0) {
+                const Mat D = wellModel().D();
+                for (int w = 0; w < nw; ++w) {
+                    step.wellStorage[w] = D[w][w];
+                }
+            }
 
+            ebosSimulator_.setTimeStepSize(dt);
+            restoreLinearization(iteration, dt, well_state);
+            adjoint_->storeMatrix(ebosJac, step);
+            for (int cell = 0; cell < nc; ++cell) {
+                step.accumulation[cell] -= ebosResid[cell];
+                step.accumulation[cell] *= -2.0;
+                step.cellStorage[cell] -= ebosJac[cell][cell];
+                step.cellStorage[cell] *= -2.0 * dt;
+            }
+            step.d.resize(nw);
+            if (nw > 0) {
+                step.b = wellModel().B();
+                step.c = wellModel().C();
+                const Mat D = wellModel().D();
+                for (int w = 0; w < nw; ++w) {
+                    step.d[w] = D[w][w];
+                    step.wellStorage[w] -= D[w][w];
+                    step.wellStorage[w] *= -2.0 * dt;
+                    step.wellNames.push_back(wells().name[w]);
+                }
+            }
 
-                            // Get a copy of the residuals
-                            auto resMB_perturbed = ebosSimulator_.model().linearizer().residual();
-                            auto resWE_perturbed_column = wellModel().residual(); // std::vector<double>
+            step.objective = dt * wellModel().historyRateMismatch(adjoint_->minRate(), step.wellObjective);
+            step.wellObjective *= dt;
 
-                            residualsWE[i][0][0] = resWE_perturbed_column[0];
-                            residualsWE[i][1][0] = resWE_perturbed_column[1];
-                            residualsWE[i][0][1] = resWE_perturbed_column[2];
-                            residualsWE[i][1][1] = resWE_perturbed_column[3];
-                            residualsMB[i] = resMB_perturbed;
+            // the connection rates are proportional to the connection
+            // transmissibilities, they are subtracted in the cells and wells
+            const int np = numPhases();
+            const int numComp = nw > 0 ? wellModel().numComponents() : 0;
+            const auto& perfResidual = wellModel().perforationResiduals();
+            for (int w = 0; w < nw; ++w) {
+                for (int perf = wells().well_connpos[w]; perf < wells().well_connpos[w+1]; ++perf) {
+                    typename Adjoint::Connection conn;
+                    conn.cell = wells().well_cells[perf];
+                    conn.well = w;
+                    conn.parameter = adjoint_->connectionParameter(wells().name[w], conn.cell);
+                    conn.cellDerivative = perfResidual[perf];
+                    conn.cellDerivative *= -1.0;
+                    conn.wellDerivative = 0.0;
+                    for (int compIdx = 0; compIdx < numComp; ++compIdx) {
+                        conn.wellDerivative[compIdx] = compIdx < np
+                            ? -well_state.perfPhaseRates()[perf*np + compIdx]
+                            : -well_state.perfRateSolvent()[perf];
+                    }
+                    step.connections.push_back(conn);
+                }
+            }
+        }
 
+        /// Compare the product of the Jacobian with a few random directions v
+        /// with central differences (F(x + eps v) - F(x - eps v)) / (2 eps).
+        /// The well variables follow the reservoir variables as in the Schur
+        /// complement, v_w = -inv(D) C v_x. The product is then that of the
+        /// operator of the linear solver with v_x, and the linearized well
+        /// equations vanish. This costs two residual evaluations per direction,
+        /// independent of the size of the model.
+        void verifyJacobianDirections(const int iteration,
+                                      const SimulatorTimerInterface& timer,
+                                      const WellState& well_state)
+        {
+            const auto& comm = grid_.comm();
+            const int nc = AutoDiffGrid::numCells(grid_);
+            const int nw = numWells();
+            const int numWellVars = nw > 0 ? wellModel().numComponents() : 0;
+            const int numDirections = param_.jacobian_directions_;
+            const double dt = timer.currentStepLength();
+            const double epsilon = param_.jacobian_perturbation_;
+            const double tolerance = param_.jacobian_tolerance_;
+
+            auto& solution = ebosSimulator_.model().solution(/*timeIdx=*/0);
+            const SolutionVector solution0 = solution;
+
+            // the directions, scaled by the magnitude of each variable, and the
+            // products with the Jacobian before it is overwritten
+            std::mt19937 generator(1 + comm.rank());
+            std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+            std::vector<BVector> directions(numDirections, BVector(nc));
+            std::vector<BVector> wellDirections(numDirections, BVector(nw));
+            std::vector<BVector> products(numDirections, BVector(nc));
+            std::vector<BVector> wellProducts(numDirections, BVector(nw));
+            {
+                const Mat& ebosJac = ebosSimulator_.model().linearizer().matrix();
+                BVector zero(nc);
+                zero = 0.0;
+                BVector recoveredZero(nw);
+                recoveredZero = 0.0;
+                wellModel().recoverVariable(zero, recoveredZero);
+                for (int k = 0; k < numDirections; ++k) {
+                    BVector& v = directions[k];
+                    for (int cell = 0; cell < nc; ++cell) {
+                        for (int pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                            v[cell][pvIdx] = distribution(generator) * std::max(std::abs(solution0[cell][pvIdx]), 1.0);
                         }
+                    }
+                }
+                // the operator of the linear solves, the Jacobian is read once
+                // for all directions
+                BlockKernels::matrixMultiMv(ebosJac, directions, products);
+                for (int k = 0; k < numDirections; ++k) {
+                    BVector& v = directions[k];
+                    wellModel().apply(v, products[k]);
+
+                    // v_w = inv(D) (r_w - C v_x) - inv(D) r_w
+                    BVector& vw = wellDirections[k];
+                    vw = 0.0;
+                    wellModel().recoverVariable(v, vw);
+                    vw -= recoveredZero;
+                    wellProducts[k] = 0.0;
+                    if (nw > 0) {
+                        wellModel().D().mv(vw, wellProducts[k]);
+                    }
+                }
+            }
 
-                        // Calculate the numerical difference
-                        for (std::size_t cell_block_res=0; cell_block_res < 9; ++cell_block_res){
-                            for (std::size_t res_nr=0; res_nr < 2; ++res_nr){
-                                // (f(x+dx/2) - f(x-dx/2)) / (dx)
-                                numA[cell_block_res][cell_block][res_nr][state_type] = (residualsMB[1][cell_block_res][res_nr] - residualsMB[0][cell_block_res][res_nr])/((-pert_sizes[state_type]));
-                            }
+            WellState perturbedWellState = well_state;
+            auto& wellSolutions = perturbedWellState.wellSolutions();
+            const std::vector<double> wellSolutions0 = wellSolutions;
+            BVector cellResPlus(nc), cellResMinus(nc);
+            BVector wellResPlus(nw), wellResMinus(nw);
+
+            std::ostringstream ss;
+            ss << "Jacobian verification in " << numDirections << " random directions:";
+            bool mismatch = false;
+            for (int k = 0; k < numDirections; ++k) {
+                for (const double sign : { 1.0, -1.0 }) {
+                    for (int cell = 0; cell < nc; ++cell) {
+                        for (int pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                            solution[cell][pvIdx] = solution0[cell][pvIdx] + sign * epsilon * directions[k][cell][pvIdx];
                         }
-                        for (std::size_t cell_block_res=0; cell_block_res < 2; ++cell_block_res){
-                            for (std::size_t res_nr=0; res_nr < 3; ++res_nr){
-                                // (f(x+dx/2) - f(x-dx/2)) / (dx)
-                                numC[cell_block_res][cell_block][res_nr][state_type] = (residualsWE[1][cell_block_res][res_nr] - residualsWE[0][cell_block_res][res_nr])/((-pert_sizes[state_type]));
-                            }
+                    }
+                    ebosSimulator_.model().invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+                    for (int w = 0; w < nw; ++w) {
+                        for (int pvIdx = 0; pvIdx < numWellVars; ++pvIdx) {
+                            wellSolutions[pvIdx*nw + w] = wellSolutions0[pvIdx*nw + w] + sign * epsilon * wellDirections[k][w][pvIdx];
                         }
                     }
+                    evaluatePerturbedResiduals(dt, perturbedWellState,
+                                               sign > 0.0 ? cellResPlus : cellResMinus,
+                                               sign > 0.0 ? wellResPlus : wellResMinus);
                 }
-                 //Dune::printmatrix(std::cout, numA, "numerical A", "row");
-                 //Dune::printmatrix(std::cout, numC, "numerical C", "row");
-
-
-                Dune::printmatrix(std::cout, A, "AD A", "row");
-                Dune::printmatrix(std::cout, numA, "numerical A", "row");
-                calculateDifference(A, numA, &diffA);
-                Dune::printmatrix(std::cout, diffA, "A  difference", "row");
-/*
-                Dune::printmatrix(std::cout, C, "AD C", "row");
-                Dune::printmatrix(std::cout, numC, "numerical C", "row");
-                calculateDifference(C, numC, &diffC);
-                Dune::printmatrix(std::cout, diffC, "C  difference", "row");
-*/
 
-                // RESETTING
-{
-                ReservoirState tmpResState = reservoir_state; // Copy
-                WellState tmpWellState = well_state; //copy
+                // the largest differences and the largest entries of the products,
+                // the well residuals should not change to first order
+                std::vector<double> maxima(4, 0.0);
+                for (int cell = 0; cell < nc; ++cell) {
+                    for (int eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+                        const double numerical = (cellResPlus[cell][eqIdx] - cellResMinus[cell][eqIdx]) / (2 * epsilon);
+                        maxima[0] = std::max(maxima[0], std::abs(numerical - products[k][cell][eqIdx]));
+                        maxima[1] = std::max(maxima[1], std::abs(products[k][cell][eqIdx]));
+                    }
+                }
+                for (int w = 0; w < nw; ++w) {
+                    for (int eqIdx = 0; eqIdx < numWellVars; ++eqIdx) {
+                        const double numerical = (wellResPlus[w][eqIdx] - wellResMinus[w][eqIdx]) / (2 * epsilon);
+                        maxima[2] = std::max(maxima[2], std::abs(numerical));
+                        maxima[3] = std::max(maxima[3], std::abs(wellProducts[k][w][eqIdx]));
+                    }
+                }
+                comm.max(maxima.data(), maxima.size());
 
-                // Send this information to ebos (and also convert it to ebos format)
-                convertInput( iteration, tmpResState, ebosSimulator_ );
+                const double reservoirError = maxima[0] / std::max(maxima[1], 1e-300);
+                const double wellError = maxima[3] > 0.0 ? maxima[2] / maxima[3] : 0.0;
+                ss << "\n  direction " << k << ": relative difference " << reservoirError
+                   << " of the reservoir equations, " << wellError << " of the well equations";
+                mismatch = mismatch || !(reservoirError <= tolerance && wellError <= tolerance);
+            }
 
-                // Delete the cache and recalculate.
-                ebosSimulator_.model().invalidateIntensiveQuantitiesCache(0); //0 is timeidx
+            solution = solution0;
+            ebosSimulator_.model().invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+            restoreLinearization(iteration, dt, well_state);
 
-                // Calculate the residual (and also the ad jacobian)
-                ebosSimulator_.model().linearizer().linearize();
+            if (terminalOutputEnabled()) {
+                if (mismatch) {
+                    OpmLog::warning(ss.str());
+                }
+                else {
+                    OpmLog::info(ss.str());
+                }
+            }
+        }
 
-                // Need to convert the jacobian to "flow format". (Scaling by some factors)
-                auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
-                auto& ebosResid = ebosSimulator_.model().linearizer().residual();
-                convertResults(ebosResid, ebosJac);
+        /// Compare the Jacobian of a converged Newton iteration with central
+        /// differences of the residuals. The columns of the cells and wells
+        /// are colored such that no equation depends on two columns of the
+        /// same color, and the columns of a color are perturbed together
+        /// (Curtis, Powell and Reid). This takes two residual evaluations per
+        /// color and primary variable, about 30 colors for a 3D 7-point
+        /// stencil, instead of two per cell and primary variable. Wells
+        /// couple their perforated cells and add colors accordingly.
+        ///
+        /// The variables are perturbed in place, in the ebos solution and in a
+        /// single copy of the well state, and only the intensive quantities of
+        /// the perturbed cells are recomputed.
+        ///
+        /// In parallel runs each process verifies the rows and columns of its
+        /// cells concurrently with the others, all taking part in the same
+        /// number of evaluations, and the differences are reduced.
+        ///
+        /// The comparison assumes the structurally symmetric stencil of the
+        /// reservoir equations, no explicit wells (well_schur_max_perforations
+        /// = 0) and no distributed wells.
+        void verifyJacobian(const int iteration,
+                            const SimulatorTimerInterface& timer,
+                            const WellState& well_state)
+        {
+            if (wellModel().distributedWellsActive()) {
+                if (terminalOutputEnabled()) {
+                    OpmLog::warning("The Jacobian is not verified with distributed wells.");
+                }
+                return;
+            }
+            const auto& comm = grid_.comm();
 
-                // Run the well equations too.
-                double dt = timer.currentStepLength();
-                wellModel().assemble(ebosSimulator_, iteration, dt, tmpWellState); // This will affect the residuals and the jacobian in ebosSimulator_
-}
+            const int nc = AutoDiffGrid::numCells(grid_);
+            const int nw = numWells();
+            const int numWellVars = nw > 0 ? wellModel().numComponents() : 0;
+            const double dt = timer.currentStepLength();
+            const double epsilon = param_.jacobian_perturbation_;
+            const double tolerance = param_.jacobian_tolerance_;
+
+            // the Jacobian of the converged iteration, the well matrices are
+            // indexed by well and cell
+            const Mat jacA = ebosSimulator_.model().linearizer().matrix();
+            std::unique_ptr<Mat> jacB, jacC, jacD;
+            if (nw > 0) {
+                jacB.reset(new Mat(wellModel().B()));
+                jacC.reset(new Mat(wellModel().C()));
+                jacD.reset(new Mat(wellModel().D()));
+            }
 
+            // the sparsity pattern of the cell equations followed by the well
+            // equations, the well variables are the columns after the cells
+            std::vector< std::vector<int> > pattern(nc + nw);
+            for (auto row = jacA.begin(); row != jacA.end(); ++row) {
+                for (auto col = row->begin(); col != row->end(); ++col) {
+                    pattern[row.index()].push_back(col.index());
+                }
+            }
+            for (int w = 0; w < nw; ++w) {
+                for (int perf = wells().well_connpos[w]; perf < wells().well_connpos[w+1]; ++perf) {
+                    const int cell = wells().well_cells[perf];
+                    pattern[cell].push_back(nc + w);
+                    pattern[nc + w].push_back(cell);
+                }
+                pattern[nc + w].push_back(nc + w);
+            }
 
-                std::vector<Scalar> pert_sizes2 = {-0.000001, -0.000001, -10}; // Using a negative value is the same as applying a positive perturbation.
+            // the linearizations are collective, every process evaluates the
+            // largest number of colors of any process
+            std::vector<int> color;
+            const int numLocalColors = distanceTwoColoring(pattern, nc + nw, color);
+            const int numColors = comm.max(numLocalColors);
+            std::vector< std::vector<int> > colorColumns(numColors);
+            for (int j = 0; j < nc + nw; ++j) {
+                colorColumns[color[j]].push_back(j);
+            }
 
-                // Calculating the numerical B and D
-                for(std::size_t well=0; well<2; ++well){      // For each well.
-                    for(int stateType = 0; stateType<2; ++stateType){           // For each phase/state_variable/component in that well
-                        residualsMB[0] = 0; residualsMB[1] = 0;
-                        // resetting the well residual container:
-                        for (std::size_t m=0; m < residualsWE.size(); ++m){
-                            for (std::size_t j=0; j < residualsWE[m].size(); ++j){
-                                for (std::size_t k=0; k < residualsWE[m][j].size(); ++k){
-                                    residualsWE[m][j][k] = 0;
-                                }
-                            }
+            const auto& solution = ebosSimulator_.model().solution(/*timeIdx=*/0);
+            // the well variables are perturbed in this copy
+            WellState perturbedWellState = well_state;
+            auto& wellSolutions = perturbedWellState.wellSolutions();
+            BlockMatrixDifference diffA(tolerance), diffB(tolerance), diffC(tolerance), diffD(tolerance);
+            BVector cellResPlus(nc), cellResMinus(nc);
+            BVector wellResPlus(nw), wellResMinus(nw);
+            std::vector<double> value(nc + nw, 0.0);
+            std::vector<double> step(nc + nw, 0.0);
+            for (int c = 0; c < numColors; ++c) {
+                for (int pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                    // a step relative to the value of each perturbed variable
+                    bool perturbed = false;
+                    for (const int j : colorColumns[c]) {
+                        step[j] = 0.0;
+                        if (j < nc) {
+                            value[j] = solution[j][pvIdx];
                         }
-
-                        for (int i = 0; i < 2; ++i){
-                            ReservoirState tmpResState = reservoir_state;   // Copy
-                            WellState tmpWellState = well_state;            // Copy
-                            dx = 0; // Reset the perturbation vectors
-                            dw = 0;
-                            dw[well][stateType] = (i==0) ? -pert_sizes2[stateType] : 0 ; // The first iteration calculates the f(x - dx/2)
-                            //dw[0][0] = -10;
-                            //dw[0][1] = -10;
-                            //dw[0][2] = -10;
-                            // Apply the perturbation to the well state variable
-                            wellModel().updateWellState(dw, tmpWellState);
-
-                            // Send this information to ebos (and also convert it to ebos format)
-                            convertInput( iteration, tmpResState, ebosSimulator_ );
-
-                            // Delete the cache and recalculate.
-                            ebosSimulator_.model().invalidateIntensiveQuantitiesCache(0); //0 is timeidx
-
-                            // Calculate the residual (and also the ad jacobian)
-                            ebosSimulator_.model().linearizer().linearize();
-
-                            // Need to convert the jacobian to "flow format". (Scaling by some factors)
-                            auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
-                            auto& ebosResid = ebosSimulator_.model().linearizer().residual();
-                            convertResults(ebosResid, ebosJac);
-
-                            //Run the well equations too.
-                            double dt = timer.currentStepLength();
-                            wellModel().assemble(ebosSimulator_, iteration, dt, tmpWellState); // This will affect the residuals and the jacobian in ebosSimulator_
-
-
-                            // Get a copy of the residuals
-                            auto resMB_perturbed = ebosSimulator_.model().linearizer().residual();
-                            auto resWE_perturbed_column = wellModel().residual(); // std::vector<double>
-                            auto resWE = wellModel().residualWE();
-
-                            for (std::size_t wellnr = 0; wellnr < 2; ++wellnr){
-                                for (std::size_t resnr = 0; resnr < 3; ++resnr){
-                                    residualsWE[i][wellnr][resnr] = resWE[wellnr][resnr];
-                                }
-                            }
-
-                            residualsMB[i] = resMB_perturbed;
-
+                        else if (pvIdx < numWellVars) {
+                            value[j] = wellSolutions[pvIdx*nw + j - nc];
                         }
+                        else {
+                            continue;
+                        }
+                        step[j] = epsilon * std::max(std::abs(value[j]), 1.0);
+                        perturbed = true;
+                    }
+                    if (comm.max(int(perturbed)) == 0) {
+                        continue;
+                    }
 
-
-                        // Calculate the numerical difference
-                        for (std::size_t cell_block_res=0; cell_block_res < 9; ++cell_block_res){
-                            for (std::size_t res_nr=0; res_nr < 2; ++res_nr){
-                                // (f(x+dx/2) - f(x-dx/2)) / (dx)
-                                numB[cell_block_res][well][res_nr][stateType] = (residualsMB[1][cell_block_res][res_nr] - residualsMB[0][cell_block_res][res_nr])/(-pert_sizes2[stateType]);
+                    // the variables at x + step/2 and x - step/2, then restored
+                    for (const double sign : { 1.0, -1.0, 0.0 }) {
+                        for (const int j : colorColumns[c]) {
+                            if (step[j] == 0.0) {
+                                continue;
                             }
-                        }
-                        for (std::size_t well_res=0; well_res < 2; ++well_res){
-                            for (std::size_t res_nr=0; res_nr < 2; ++res_nr){
-                                // (f(x+dx/2) - f(x-dx/2)) / (dx)
-                                numD[well_res][well][res_nr][stateType] = (residualsWE[1][well_res][res_nr] - residualsWE[0][well_res][res_nr])/(-pert_sizes2[stateType]);
+                            const double x = value[j] + sign * step[j] / 2;
+                            if (j < nc) {
+                                setPrimaryVariable(j, pvIdx, x);
+                            }
+                            else {
+                                wellSolutions[pvIdx*nw + j - nc] = x;
                             }
                         }
-                    }
-                }
-
-                //Dune::printmatrix(std::cout, numB, "numerical B", "row");
-                //Dune::printmatrix(std::cout, numD, "numerical D", "row");
-
-
-/*
-                Dune::printmatrix(std::cout, B, "AD B", "row");
-                Dune::printmatrix(std::cout, numB, "numerical B", "row");
-                calculateDifference(B, numB, &diffB);
-                Dune::printmatrix(std::cout, diffB, "B difference", "row");
-
-                Dune::printmatrix(std::cout, D, "AD D", "row");
-                Dune::printmatrix(std::cout, numD, "numerical D", "row");
-                calculateDifference(D, numD, &diffD);
-                Dune::printmatrix(std::cout, diffD, "D difference", "row");
- */
-
-                // RESETTING
-{
-                ReservoirState tmpResState = reservoir_state; // Copy
-                WellState tmpWellState = well_state; //copy
-
-                // Send this information to ebos (and also convert it to ebos format)
-                convertInput( iteration, tmpResState, ebosSimulator_ );
-
-                // Delete the cache and recalculate.
-                ebosSimulator_.model().invalidateIntensiveQuantitiesCache(0); //0 is timeidx
-
-                // Calculate the residual (and also the ad jacobian)
-                ebosSimulator_.model().linearizer().linearize();
-
-                // Need to convert the jacobian to "flow format". (Scaling by some factors)
-                auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
-                auto& ebosResid = ebosSimulator_.model().linearizer().residual();
-                convertResults(ebosResid, ebosJac);
-
-                // Run the well equations too.
-                double dt = timer.currentStepLength();
-                wellModel().assemble(ebosSimulator_, iteration, dt, tmpWellState); // This will affect the residuals and the jacobian in ebosSimulator_
-}
-
-/*
-                std::vector<Scalar> pert_sizes0 ={-0.000001, -10};
-                // Calculates the jacobian of the reservoir residuals w.r.t. the intial state.
-                for(std::size_t cell_block=0; cell_block<9; ++cell_block){      // For each grid block.
-                    for(int state_type = 0; state_type<2; ++state_type){        // For each state_variable (saturation_water, pressure_oil) in that grid block
-                        residualsMB[0] = 0; residualsMB[1] = 0; // reset.
-
-                        for (int i = 0; i < 2; ++i){                            // We are doing central difference
-                            // Copy the states
-                            ReservoirState tmp_initial_reservoir_state = copy_initial_reservoir_state;
-                            ReservoirState tmp_final_reservoir_state = final_reservoir_state ;
-                            WellState tmp_final_well_state = well_state;
-
-                            dx = 0; // Reset the perturbation vector
-                            dx[cell_block][state_type] = (i==0) ? -pert_sizes0[state_type]/2 : pert_sizes0[state_type]/2; // The first iteration calculates the f(x - dx/2)
-
-                            // Perturb the initial state
-                            updateState(dx,tmp_initial_reservoir_state);
-
-                            // Update the current and the previous solution in ebos with the perturbed initial solution
-                            convertInput( 0, tmp_initial_reservoir_state, ebosSimulator_ );
-
-                            // Update the current solution in ebos with the final state
-                            convertInput( 1, tmp_final_reservoir_state, ebosSimulator_ );
-
-                            ebosSimulator_.model().invalidateIntensiveQuantitiesCache(0);
-                            ebosSimulator_.model().invalidateIntensiveQuantitiesCache(1);
-
-                            auto tmp = nonlinear_solver.computeFluidInPlace(fipnum);
-                            //nonlinear_solver.FIPTotals(tmp, tmp_initial_reservoir_state);
-
-
-                            // Calculate the residual and the jacobian
-                            ebosSimulator_.model().linearizer().linearize();
-
-                            // Need to convert the result to "flow format".
-                            auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
-                            auto& ebosResid = ebosSimulator_.model().linearizer().residual();
-                            convertResults(ebosResid, ebosJac);
-
-                            //Run the well equations too.
-                            double dt = timer.currentStepLength();
-                            wellModel().assemble(ebosSimulator_, iteration, dt, tmp_final_well_state); // This will affect the residuals and the jacobian in ebosSimulator_
-
-                            // Get a copy of the residuals
-                            auto resMB_perturbed = ebosSimulator_.model().linearizer().residual();
-                            residualsMB[i] = resMB_perturbed;
+                        if (sign != 0.0) {
+                            evaluatePerturbedResiduals(dt, perturbedWellState,
+                                                       sign > 0.0 ? cellResPlus : cellResMinus,
+                                                       sign > 0.0 ? wellResPlus : wellResMinus);
                         }
+                    }
 
-                        // Calculate the numerical difference
-                        for (std::size_t cell_block_res=0; cell_block_res < 9; ++cell_block_res){
-                            for (std::size_t res_nr=0; res_nr < 2; ++res_nr){
-                                // (f(x+dx/2) - f(x-dx/2)) / (dx)
-                                numA0[cell_block_res][cell_block][res_nr][state_type] = (residualsMB[1][cell_block_res][res_nr] - residualsMB[0][cell_block_res][res_nr])/((-pert_sizes0[state_type]));
-                            }
+                    // the rows of a column are those of the column in the pattern
+                    for (const int j : colorColumns[c]) {
+                        if (step[j] == 0.0) {
+                            continue;
                         }
-
-                    }//end for stateType
-                } //end for cell_block
-*/
-                //Dune::printmatrix(std::cout, numA0, "numerical jacobian of reservoir residuals w.r.t. the initial state", "row");
-
-
-                /* ----------------- Minimum working example ----------------- */
-/*                ReservoirState tmp_reservoir_state = reservoir_state;
-
-                // Get the references to the ebos residual and Jacobian
-                auto& ebos_jac = ebosSimulator_.model().linearizer().matrix();
-                auto& ebos_resid = ebosSimulator_.model().linearizer().residual();
-
-                // Calculate the residual and the jacobian
-                ebosSimulator_.model().linearizer().linearize();
-
-                // Need to convert the result to "flow format".
-                convertResults(ebos_resid, ebos_jac);
-
-
-                // Get a copy of the residuals
-                auto copy_residuals_before = ebosSimulator_.model().linearizer().residual();
-                std::cout << "Residuals before we change the initial state:" << std::endl;
-                std::cout << copy_residuals_before << std::endl << std::endl;
-
-                // Update the current and the previous solution in ebos
-                convertInput( 0, tmp_reservoir_state, ebosSimulator_ );
-
-                ebosSimulator_.model().invalidateIntensiveQuantitiesCache(0);
-                ebosSimulator_.model().invalidateIntensiveQuantitiesCache(1);
-
-
-                // Calculate the residual and the jacobian
-                ebosSimulator_.model().linearizer().linearize();
-
-                // Need to convert the result to "flow format".
-                convertResults(ebos_resid, ebos_jac);
-
-
-                // Get a copy of the residuals
-                auto copy_residuals_after = ebosSimulator_.model().linearizer().residual();
-                std::cout << "Residuals after we have changed the initial state:" << std::endl;
-                std::cout << copy_residuals_after << std::endl << std::endl;
-*/
-           }//end else (the case that we have converged)
-
-                return report;
-        }
-
-
-        template<typename T>
-        void denseInitializationOfBCRSMatrix( T& mat){
-            for(int row=0; row < mat.N(); ++row){
-                mat.setrowsize(row, mat.M());
-            }
-            mat.endrowsizes();
-
-            for (int row=0; row < mat.N(); ++row){
-                for (int col=0; col < mat.M(); ++col){
-                    mat.addindex(row, col);
-                }
-            }
-            mat.endindices();
-        }
-
-        template<typename T>
-        void calculateDifference(T mat1, T mat0, T* matDiff){
-            for(std::size_t row_block=0; row_block < mat1.N(); ++row_block ){
-                for(std::size_t col_block=0; col_block < mat1.M(); ++col_block ){
-                    for(std::size_t row_in_block=0; row_in_block < mat1[row_block][col_block].N(); ++row_in_block ){
-                        for(std::size_t col_in_block=0; col_in_block < mat1[row_block][col_block].M(); ++col_in_block ){
-
-                            Scalar val1 = (mat1[row_block][col_block][row_in_block][col_in_block]);
-                            Scalar val0 = (mat0[row_block][col_block][row_in_block][col_in_block]);
-                            auto max = std::max(std::abs(val1),std::abs(val0));
-
-                            if (max > 0.00000000000001){
-                                if ( ( std::abs( val1 - val0) ) <= 0.00000000000001 * max ){ // Count it as zero
-                                    matDiff[0][row_block][col_block][row_in_block][col_in_block] = 0.0;
-                                }
-                                else{
-                                    matDiff[0][row_block][col_block][row_in_block][col_in_block] = val1 - val0;
+                        for (const int i : pattern[j]) {
+                            if (i < nc) {
+                                for (int eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+                                    const double numerical = (cellResPlus[i][eqIdx] - cellResMinus[i][eqIdx]) / step[j];
+                                    if (j < nc) {
+                                        diffA.add(jacA[i][j][eqIdx][pvIdx], numerical, i, j, eqIdx, pvIdx);
+                                    }
+                                    else {
+                                        // B is stored transposed
+                                        diffB.add((*jacB)[j - nc][i][pvIdx][eqIdx], numerical, i, j - nc, eqIdx, pvIdx);
+                                    }
                                 }
                             }
-                            else{ //Count it as zero
-                                matDiff[0][row_block][col_block][row_in_block][col_in_block] = 0.0;
+                            else {
+                                const int w = i - nc;
+                                for (int eqIdx = 0; eqIdx < numWellVars; ++eqIdx) {
+                                    const double numerical = (wellResPlus[w][eqIdx] - wellResMinus[w][eqIdx]) / step[j];
+                                    if (j < nc) {
+                                        diffC.add((*jacC)[w][j][eqIdx][pvIdx], numerical, w, j, eqIdx, pvIdx);
+                                    }
+                                    else {
+                                        diffD.add((*jacD)[w][j - nc][eqIdx][pvIdx], numerical, w, j - nc, eqIdx, pvIdx);
+                                    }
+                                }
                             }
-
-
                         }
                     }
                 }
             }
 
+            // the perturbed variables have been restored
+            restoreLinearization(iteration, dt, well_state);
+
+            // a summary per block over all processes, the location of the
+            // largest difference is known to its process only
+            const BlockMatrixDifference* blocks[] = { &diffA, &diffB, &diffC, &diffD };
+            const char* blockNames[] = { "A", "B", "C", "D" };
+            std::vector<double> maxima;
+            std::vector<int> counts;
+            for (const BlockMatrixDifference* diff : blocks) {
+                maxima.push_back(diff->maxRelative());
+                maxima.push_back(diff->maxAbsolute());
+                counts.push_back(diff->numEntries());
+                counts.push_back(diff->numAboveTolerance());
+            }
+            const std::vector<double> localMaxima = maxima;
+            comm.max(maxima.data(), maxima.size());
+            comm.sum(counts.data(), counts.size());
+            int numCells = nc;
+            numCells = comm.sum(numCells);
+            int numAllWells = nw;
+            numAllWells = comm.sum(numAllWells);
+
+            std::ostringstream ss;
+            ss << "Jacobian verification with " << numColors << " colors for "
+               << numCells << " cells and " << numAllWells << " wells:";
+            bool mismatch = false;
+            for (int b = 0; b < 4; ++b) {
+                ss << "\n  " << blockNames[b] << ": " << counts[2*b + 1] << " of "
+                   << counts[2*b] << " entries differ by more than " << tolerance;
+                if (maxima[2*b] > 0.0) {
+                    ss << ", largest relative difference " << maxima[2*b]
+                       << ", largest absolute difference " << maxima[2*b + 1];
+                    if (localMaxima[2*b] == maxima[2*b]) {
+                        const BlockMatrixDifference& diff = *blocks[b];
+                        ss << ", at row " << diff.row() << ", column " << diff.col()
+                           << ", equation " << diff.blockRow() << ", variable " << diff.blockCol()
+                           << " (AD " << diff.expected() << ", numerical " << diff.actual() << ")";
+                    }
+                }
+                mismatch = mismatch || counts[2*b + 1] > 0;
+            }
+            if (terminalOutputEnabled()) {
+                if (mismatch) {
+                    OpmLog::warning(ss.str());
+                }
+                else {
+                    OpmLog::info(ss.str());
+                }
+            }
         }
 
-
         void printIf(int c, double x, double y, double eps, std::string type) {
             if (std::abs(x-y) > eps) {
-                std::cout << type << " " <<c << ": "<<x << " " << y << std::endl;
+                OPM_DEBUG_LOG(Newton, type << " " << c << ": " << x << " " << y);
             }
         }
 
@@ -908,13 +1119,95 @@ namespace Opm {
                        const ReservoirState& reservoir_state,
                        WellState& well_state)
         {
-            DUNE_UNUSED_PARAMETER(timer);
             DUNE_UNUSED_PARAMETER(reservoir_state);
             DUNE_UNUSED_PARAMETER(well_state);
+
+            if (adjoint_step_) {
+                adjoint_->addStep(std::move(*adjoint_step_));
+                adjoint_step_.reset();
+            }
+
+            // the start of the accepted step is the older state of the next prediction
+            if (predictor_step_start_) {
+                predictor_previous_state_ = std::move(predictor_step_start_);
+                predictor_previous_step_length_ = timer.currentStepLength();
+                predictor_report_step_ = timer.reportStepNum();
+            }
         }
 
-        /// Assemble the residual and Jacobian of the nonlinear system.
-        /// \param[in]      reservoir_state   reservoir state variables
+        /// Replace the initial state of a time step by the state extrapolated
+        /// linearly in time from the last two accepted steps. Cells whose
+        /// hydrocarbon state changed in the last step or whose extrapolated
+        /// saturations or ratios are not physical keep their state. There is
+        /// no prediction after a failed step or at the start of a report step,
+        /// where the well controls may have changed.
+        void predictTimeStep(const SimulatorTimerInterface& timer,
+                             ReservoirState& reservoir_state)
+        {
+            const bool havePrevious = predictor_previous_state_
+                && predictor_report_step_ == timer.reportStepNum()
+                && predictor_previous_state_->numCells() == reservoir_state.numCells();
+            // ebos takes the initial state of these steps from reservoir_state
+            const bool initialFromState = timer.lastStepFailed() || timer.reportStepNum() == 0;
+            const bool predict = havePrevious && !initialFromState && predictor_previous_step_length_ > 0.0;
+
+            // the start of the step, also if this attempt fails and is repeated
+            predictor_step_start_.reset(new ReservoirState(reservoir_state));
+            if (!predict) {
+                return;
+            }
+
+            const double ratio = timer.currentStepLength() / predictor_previous_step_length_;
+            const ReservoirState& older = *predictor_previous_state_;
+            const ReservoirState& current = *predictor_step_start_;
+            const int numCells = reservoir_state.numCells();
+            const int np = numPhases();
+
+            auto extrapolate = [ratio](const double olderValue, const double currentValue) {
+                return currentValue + ratio * (currentValue - olderValue);
+            };
+
+            int predictedCells = 0;
+            for (int cellIdx = 0; cellIdx < numCells; ++cellIdx) {
+                if (older.hydroCarbonState()[cellIdx] != current.hydroCarbonState()[cellIdx]) {
+                    continue;
+                }
+
+                bool physical = true;
+                for (int phaseIdx = 0; phaseIdx < np; ++phaseIdx) {
+                    const int idx = cellIdx*np + phaseIdx;
+                    const double sat = extrapolate(older.saturation()[idx], current.saturation()[idx]);
+                    physical = physical && sat >= 0.0 && sat <= 1.0;
+                }
+                const double pressure = extrapolate(older.pressure()[cellIdx], current.pressure()[cellIdx]);
+                const double rs = extrapolate(older.gasoilratio()[cellIdx], current.gasoilratio()[cellIdx]);
+                const double rv = extrapolate(older.rv()[cellIdx], current.rv()[cellIdx]);
+                physical = physical && pressure > 0.0 && rs >= 0.0 && rv >= 0.0;
+                if (!physical) {
+                    continue;
+                }
+
+                for (int phaseIdx = 0; phaseIdx < np; ++phaseIdx) {
+                    const int idx = cellIdx*np + phaseIdx;
+                    reservoir_state.saturation()[idx] = extrapolate(older.saturation()[idx], current.saturation()[idx]);
+                }
+                reservoir_state.pressure()[cellIdx] = pressure;
+                reservoir_state.gasoilratio()[cellIdx] = rs;
+                reservoir_state.rv()[cellIdx] = rv;
+                ++predictedCells;
+            }
+
+            if (predictedCells > 0) {
+                // only the current solution, the solution of the previous time
+                // level remains the accepted state
+                previous_solution_ = ebosSimulator_.model().solution(/*timeIdx=*/0);
+                convertInput( /*iterationIdx=*/1, reservoir_state, ebosSimulator_ );
+                invalidateChangedIntensiveQuantities(previous_solution_);
+            }
+        }
+
+        /// Assemble the residual and Jacobian of the nonlinear system.
+        /// \param[in]      reservoir_state   reservoir state variables
         /// \param[in, out] well_state        well state variables
         /// \param[in]      initial_assembly  pass true if this is the first call to assemble() in this timestep
         SimulatorReport assemble(const SimulatorTimerInterface& timer,
@@ -923,24 +1216,78 @@ namespace Opm {
                                  WellState& well_state)
         {
             using namespace Opm::AutoDiffGrid;
+            TimerTree::Region region("assembly");
+            OPM_PROFILE_REGION("assemble");
+            HardwareCounters::Scope counters(HardwareCounters::Assembly);
 
             SimulatorReport report;
 
-            // when having VREP group control, update the rate converter based on reservoir state
-            if ( wellModel().wellCollection()->havingVREPGroups() ) {
-                updateRateConverter(reservoir_state);
+            // the region averages of the rate converter used by VREP group
+            // control are computed once per step, in prepareStep()
+
+            double dt = timer.currentStepLength();
+
+            // the elements are colored after the first linearization by ebos
+            const bool coloredLinearization = param_.colored_linearization_ && !element_colors_.empty();
+
+            // the wells may be assembled on a separate thread while ebos
+            // linearizes the reservoir, their contributions to the reservoir
+            // equations are added afterwards, or before the colored
+            // linearization, which adds them in its pass over the elements
+            const bool concurrentWells = !coloredLinearization
+                && param_.concurrent_well_assembly_threads_ > 0
+                && wellModel().wellsActive()
+                && wellModel().independentOfReservoirAssembly(ebosSimulator_);
+            const bool separateWells = concurrentWells
+                || (coloredLinearization && wellModel().wellsActive());
+            SimulatorReport wellReport;
+            double separateWellTime = 0.0;
+            std::function<void()> wellAssembly;
+            if (separateWells) {
+                wellAssembly = [&]() {
+                    TimerTree::Region wellRegion("well assembly");
+                    Dune::Timer wellTimer;
+                    wellTimer.start();
+                    try {
+                        wellReport = wellModel().assembleWells(ebosSimulator_, iterationIdx, dt, well_state);
+                    }
+                    catch ( const Dune::FMatrixError& e  ) {
+                        OPM_THROW(Opm::NumericalProblem,"Well equation did not converge");
+                    }
+                    separateWellTime = wellTimer.stop();
+                };
             }
 
             // -------- Mass balance equations --------
-            assembleMassBalanceEq(timer, iterationIdx, reservoir_state);
+            assembleMassBalanceEq(timer, iterationIdx, reservoir_state, wellAssembly, coloredLinearization);
 
 
             // -------- Well equations ----------
-            double dt = timer.currentStepLength();
-
             try
             {
-                report = wellModel().assemble(ebosSimulator_, iterationIdx, dt, well_state);
+                {
+                    TimerTree::Region wellRegion("well assembly");
+                    OPM_PROFILE_REGION("well assembly");
+                    Dune::Timer wellTimer;
+                    wellTimer.start();
+                    if (concurrentWells) {
+                        wellModel().addReservoirContributions(ebosSimulator_);
+                        report = wellReport;
+                    }
+                    else if (separateWells) {
+                        // the perforations have been added by the colored linearization
+                        wellModel().addExplicitWellContributions(ebosSimulator_);
+                        report = wellReport;
+                    }
+                    else {
+                        report = wellModel().assemble(ebosSimulator_, iterationIdx, dt, well_state);
+                    }
+                    // the time of a concurrent assembly overlaps the linearization
+                    const double wellTime = wellTimer.stop() + separateWellTime;
+                    well_assembly_time_ += wellTime;
+                    recordTrace(PerformanceTrace::WellAssembly, wellTime);
+                }
+                MemoryTracker::sample(MemoryTracker::FirstLinearization);
 
                 // Take a deep copy of the matrix and store it in matrixA
                 const auto& ebosJacConst = ebosSimulator_.model().linearizer().matrix();
@@ -951,8 +1298,8 @@ namespace Opm {
                 // Take a deep copy of the ebosRes, and store it in ebosRes2
                 auto& ebosRes = ebosSimulator_.model().linearizer().residual();
                 auto& ebosRes2 = ebosSimulator_.model().linearizer().residualA();
-                for (int i = 0; i < 9; ++i){
-                    for(int j = 0; j < 3; ++j){
+                for (int i = 0; i < std::min(9, int(ebosRes.size())); ++i){
+                    for(int j = 0; j < numEq; ++j){
                         ebosRes2[i][j] = ebosRes[i][j];
                     }
                 }
@@ -1022,39 +1369,336 @@ namespace Opm {
         /// Number of linear iterations used in last call to solveJacobianSystem().
         int linearIterationsLastSolve() const
         {
-            return istlSolver().iterations();
+            return istlSolver().iterations() + refinement_iterations_;
+        }
+
+        /// Log the memory held by the Jacobian, the preconditioner of the last
+        /// linear solve and the well equations: the smallest and largest
+        /// amount of a process and the sum over all processes. Collective.
+        void reportMemoryUsage() const
+        {
+            const auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
+            const std::vector<std::string> names = { "Jacobian", "Preconditioner", "Wells" };
+            std::vector<double> minUsage = { double(Opm::memoryUsage(ebosJac)),
+                                              double(istlSolver().preconditionerMemoryUsage()),
+                                              double(wellModel().memoryUsage()) };
+            std::vector<double> maxUsage = minUsage;
+            std::vector<double> sumUsage = minUsage;
+
+            const auto& comm = grid_.comm();
+            comm.min(minUsage.data(), minUsage.size());
+            comm.max(maxUsage.data(), maxUsage.size());
+            comm.sum(sumUsage.data(), sumUsage.size());
+
+            if (terminalOutputEnabled()) {
+                std::ostringstream ss;
+                ss << "Memory usage of the linear system (min / max per process, total of "
+                   << comm.size() << " processes):";
+                for (std::size_t i = 0; i < names.size(); ++i) {
+                    ss << "\n    " << std::left << std::setw(16) << names[i]
+                       << formatMemoryUsage(minUsage[i]) << " / "
+                       << formatMemoryUsage(maxUsage[i]) << ", "
+                       << formatMemoryUsage(sumUsage[i]);
+                }
+                OpmLog::info(ss.str());
+            }
+        }
+
+        /// Log the largest bandwidth of the local Jacobians in the cell
+        /// numbering of the grid and in reverse Cuthill-McKee order, which
+        /// the ILU preconditioner uses with ilu_reorder=true. Collective.
+        void reportMatrixBandwidth() const
+        {
+            const auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
+            std::vector<std::size_t> perm;
+            reverseCuthillMcKee(ebosJac, perm);
+            std::vector<double> bandwidth = { double(matrixBandwidth(ebosJac)),
+                                              double(matrixBandwidth(ebosJac, perm)) };
+            grid_.comm().max(bandwidth.data(), bandwidth.size());
+
+            if (terminalOutputEnabled()) {
+                std::ostringstream ss;
+                ss << "Bandwidth of the Jacobian: " << bandwidth[0]
+                   << " in the grid numbering, " << bandwidth[1]
+                   << " in reverse Cuthill-McKee order";
+                OpmLog::info(ss.str());
+            }
         }
 
         /// Solve the Jacobian system Jx = r where J is the Jacobian and
-        /// r is the residual.
-        void solveJacobianSystem(BVector& x, BVector& xw) const
+        /// r is the residual. The system is written to a file before the
+        /// solve or on a linear solver failure if the dump_linear_system
+        /// parameter asks for it.
+        void solveJacobianSystem(BVector& x, BVector& xw, const int iteration) const
         {
+            TimerTree::Region region("linear solve");
+            OPM_PROFILE_REGION("solveJacobianSystem");
             const auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
             auto& ebosResid = ebosSimulator_.model().linearizer().residual();
+            ++linear_solves_;
+
+            // the solvers overwrite the residual, keep it for a dump on failure
+            const bool dumpNow = param_.dump_linear_system_all_
+                || std::find(param_.dump_linear_system_iterations_.begin(),
+                             param_.dump_linear_system_iterations_.end(),
+                             iteration) != param_.dump_linear_system_iterations_.end();
+            if (dumpNow) {
+                dumpLinearSystem(ebosResid, iteration);
+            }
+            std::unique_ptr<BVector> residCopy;
+            if (param_.dump_linear_system_on_failure_ && !dumpNow) {
+                residCopy.reset(new BVector(ebosResid));
+            }
 
             // set initial guess
             x = 0.0;
 
             // Solve system.
+            refinement_iterations_ = 0;
+            try {
+                if( param_.float_jacobian_operator_ )
+                {
+                    solveFloatJacobianSystem(x, ebosResid);
+                }
+                else if( isParallel() )
+                {
+                    typedef WellModelMatrixAdapter< Mat, BVector, BVector, WellModel, true > Operator;
+                    Operator opA(ebosJac, well_model_, &istlSolver().parallelCommunication( ebosJac.N() ) );
+                    assert( opA.comm() );
+                    istlSolver().solve( opA, x, ebosResid, *(opA.comm()) );
+                }
+                else
+                {
+                    typedef WellModelMatrixAdapter< Mat, BVector, BVector, WellModel, false > Operator;
+                    Operator opA(ebosJac, well_model_);
+                    istlSolver().solve( opA, x, ebosResid );
+                }
+            }
+            catch (const LinearSolverProblem&) {
+                if (residCopy) {
+                    dumpLinearSystem(*residCopy, iteration);
+                }
+                throw;
+            }
+            if (residCopy && !istlSolver().converged()) {
+                // convergence failures are ignored
+                dumpLinearSystem(*residCopy, iteration);
+            }
+
+            // collective if wells have perforations on several processes
+            if( xw.size() > 0 || wellModel().distributedWellsActive() )
+            {
+                // recover wells.
+                xw = 0.0;
+                wellModel().recoverVariable(x, xw);
+            }
+        }
+
+        /// Solve the Jacobian system with the Jacobian applied by a single
+        /// precision copy of its blocks in the Krylov iterations, which halves
+        /// the memory traffic of the operator. The solution is refined by
+        /// outer iterations on the residual in double precision, until it is
+        /// reduced by the reduction of the linear solver or after
+        /// float_jacobian_max_refinements refinements. The preconditioner is
+        /// set up from the Jacobian in double precision.
+        void solveFloatJacobianSystem(BVector& x, const BVector& b) const
+        {
+            const auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
+            if( floatJacobian_.N() != ebosJac.N() || floatJacobian_.nonzeroes() != ebosJac.nonzeroes() ) {
+                detail::copyMatrixConvertingPrecision( ebosJac, floatJacobian_ );
+            }
+            else {
+                detail::copyValuesConvertingPrecision( ebosJac, floatJacobian_ );
+            }
+
             if( isParallel() )
             {
-                typedef WellModelMatrixAdapter< Mat, BVector, BVector, StandardWellsDense<TypeTag>, true > Operator;
-                Operator opA(ebosJac, well_model_, istlSolver().parallelInformation() );
-                assert( opA.comm() );
-                istlSolver().solve( opA, x, ebosResid, *(opA.comm()) );
+                typedef WellModelMatrixAdapter< Mat, BVector, BVector, WellModel, true > Operator;
+                typedef FloatJacobianMatrixAdapter< Mat, FloatMat, BVector, BVector, WellModel, true > FloatOperator;
+                auto* comm = &istlSolver().parallelCommunication( ebosJac.N() );
+                Operator opA(ebosJac, well_model_, comm);
+                FloatOperator opF(ebosJac, floatJacobian_, well_model_, comm);
+                refineFloatSolution(opA, comm, x, b, [&](BVector& d, BVector& r) {
+                    istlSolver().solve( opF, d, r, *comm );
+                });
             }
             else
             {
-                typedef WellModelMatrixAdapter< Mat, BVector, BVector, StandardWellsDense<TypeTag>, false > Operator;
+                typedef WellModelMatrixAdapter< Mat, BVector, BVector, WellModel, false > Operator;
+                typedef FloatJacobianMatrixAdapter< Mat, FloatMat, BVector, BVector, WellModel, false > FloatOperator;
+                typename Operator::communication_type* comm = nullptr;
                 Operator opA(ebosJac, well_model_);
-                istlSolver().solve( opA, x, ebosResid );
+                FloatOperator opF(ebosJac, floatJacobian_, well_model_);
+                refineFloatSolution(opA, comm, x, b, [&](BVector& d, BVector& r) {
+                    istlSolver().solve( opF, d, r );
+                });
+            }
+        }
+
+        /// The outer iterations of solveFloatJacobianSystem(), solveFloat(d, r)
+        /// solves for the correction d of the residual r, overwriting r.
+        template <class Operator, class Communication, class SolveFloat>
+        void refineFloatSolution(const Operator& opA, Communication* comm, BVector& x, const BVector& b,
+                                 const SolveFloat& solveFloat) const
+        {
+            // the norm over the owned rows of all processes
+            const auto norm = [&](BVector& v) {
+#if HAVE_MPI
+                if( comm ) {
+                    comm->project( v );
+                }
+#endif
+                return std::sqrt( grid_.comm().sum( v.two_norm2() ) );
+            };
+
+            BVector r(b);
+            BVector d(b.size());
+            const double target = istlSolver().reduction() * norm(r);
+            x = 0.0;
+            for (int refinement = 0; ; ++refinement) {
+                d = 0.0;
+                solveFloat(d, r);
+                x += d;
+                if (refinement >= param_.float_jacobian_max_refinements_) {
+                    break;
+                }
+                r = b;
+                opA.applyscaleadd(-1.0, x, r);
+                if (norm(r) <= target) {
+                    break;
+                }
+                // the iterations of the last solve are those of the solver
+                refinement_iterations_ += istlSolver().iterations();
             }
+        }
+
+        /// Solve the Newton system with the Jacobian of the reservoir equations
+        /// applied by forward differences of the residual, Jacobian-free
+        /// Newton-Krylov. The well variables follow a direction v as in the
+        /// Schur complement, v_w = -inv(D) C v, such that the operator is that
+        /// of solveJacobianSystem(). The assembled Jacobian of the iteration
+        /// is kept for the preconditioner, as the evaluations overwrite the
+        /// matrix and the residual of the linearizer.
+        void solveJacobianSystemMatrixFree(BVector& x, BVector& xw, const double dt,
+                                           const WellState& well_state)
+        {
+            TimerTree::Region region("linear solve");
+            OPM_PROFILE_REGION("solveJacobianSystem");
+            auto& ebosResid = ebosSimulator_.model().linearizer().residual();
+            ++linear_solves_;
+            refinement_iterations_ = 0;
+
+            const int nc = AutoDiffGrid::numCells(grid_);
+            const int nw = numWells();
+            const int numWellVars = nw > 0 ? wellModel().numComponents() : 0;
+            const double epsilon = param_.jacobian_free_perturbation_;
+            const Mat preconditionerMatrix = ebosSimulator_.model().linearizer().matrix();
+            BVector rhs = ebosResid;
+
+            auto& solution = ebosSimulator_.model().solution(/*timeIdx=*/0);
+            const SolutionVector solution0 = solution;
+            WellState perturbedWellState = well_state;
+            auto& wellSolutions = perturbedWellState.wellSolutions();
+            const std::vector<double> wellSolutions0 = wellSolutions;
+
+            // inv(D) r_w at the current iterate, recoverVariable() of the
+            // solution is this minus inv(D) C x
+            BVector zero(nc);
+            zero = 0.0;
+            BVector wellRecovered0(nw);
+            wellRecovered0 = 0.0;
+            wellModel().recoverVariable(zero, wellRecovered0);
+
+            // the residual at the current iterate, without the Schur complement of the wells
+            BVector resid0(nc);
+            BVector wellResid(nw);
+            evaluatePerturbedResiduals(dt, perturbedWellState, resid0, wellResid);
+
+            BVector resid(nc);
+            BVector vw(nw);
+            BVector vw0(nw);
+            auto applyJacobian = [&](const BVector& v, BVector& y) {
+                // v_w = -inv(D) C v, independent of the well residual
+                vw = 0.0;
+                vw0 = 0.0;
+                wellModel().recoverVariable(v, vw);
+                wellModel().recoverVariable(zero, vw0);
+                vw -= vw0;
+
+                // a step changing no variable by more than epsilon relative to its magnitude
+                double scale = 0.0;
+                for (int cell = 0; cell < nc; ++cell) {
+                    for (int pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                        scale = std::max(scale, std::abs(v[cell][pvIdx]) / std::max(std::abs(solution0[cell][pvIdx]), 1.0));
+                    }
+                }
+                for (int w = 0; w < nw; ++w) {
+                    for (int pvIdx = 0; pvIdx < numWellVars; ++pvIdx) {
+                        scale = std::max(scale, std::abs(vw[w][pvIdx]) / std::max(std::abs(wellSolutions0[pvIdx*nw + w]), 1.0));
+                    }
+                }
+                if (scale == 0.0) {
+                    y = 0.0;
+                    return;
+                }
+                const double h = epsilon / scale;
+
+                for (int cell = 0; cell < nc; ++cell) {
+                    for (int pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                        solution[cell][pvIdx] = solution0[cell][pvIdx] + h * v[cell][pvIdx];
+                    }
+                }
+                ebosSimulator_.model().invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+                for (int w = 0; w < nw; ++w) {
+                    for (int pvIdx = 0; pvIdx < numWellVars; ++pvIdx) {
+                        wellSolutions[pvIdx*nw + w] = wellSolutions0[pvIdx*nw + w] + h * vw[w][pvIdx];
+                    }
+                }
+                evaluatePerturbedResiduals(dt, perturbedWellState, resid, wellResid);
+
+                y = resid;
+                y -= resid0;
+                y *= 1.0 / h;
+            };
+
+            x = 0.0;
+            typedef MatrixFreeOperator< Mat, BVector, BVector > Operator;
+            Operator opA(preconditionerMatrix, applyJacobian);
+            istlSolver().solve( opA, x, rhs );
+
+            // back to the current iterate, the next linearization starts from it
+            solution = solution0;
+            ebosSimulator_.model().invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
 
             if( xw.size() > 0 )
             {
-                // recover wells.
+                // recover wells, inv(D) (r_w - C x) with r_w of the current iterate
                 xw = 0.0;
                 wellModel().recoverVariable(x, xw);
+                vw0 = 0.0;
+                wellModel().recoverVariable(zero, vw0);
+                xw -= vw0;
+                xw += wellRecovered0;
+            }
+        }
+
+        /// Write the Jacobian, the given residual and the well matrices to
+        /// a file of the dump_linear_system_dir directory, one per process.
+        void dumpLinearSystem(const BVector& resid, const int iteration) const
+        {
+            std::ostringstream filename;
+            filename << param_.dump_linear_system_dir_ << "/linear_system_"
+                     << std::setw(5) << std::setfill('0') << linear_solves_
+                     << "_it" << iteration;
+            if (isParallel()) {
+                filename << "_p" << grid_.comm().rank();
+            }
+            filename << ".bin";
+            writeLinearSystem(filename.str(), ebosSimulator_.model().linearizer().matrix(), resid,
+                              wellModel().matrixB(), wellModel().matrixC(), wellModel().invMatrixD(),
+                              wellModel().explicitWells(), iteration, linear_solves_);
+            if (terminalOutputEnabled()) {
+                OpmLog::info("Wrote linear system to " + filename.str());
             }
         }
 
@@ -1091,23 +1735,17 @@ namespace Opm {
                 Dune::SolverCategory::sequential
           };
 
-          //! constructor: just store a reference to a matrix
-          WellModelMatrixAdapter (const M& A, const WellModel& wellMod, const boost::any& parallelInformation = boost::any() )
-              : A_( A ), wellMod_( wellMod ), comm_()
+          //! constructor: just store a reference to a matrix and to the
+          //! communication of a parallel run, which is kept by the solver
+          WellModelMatrixAdapter (const M& A, const WellModel& wellMod, communication_type* comm = nullptr )
+              : A_( A ), wellMod_( wellMod ), comm_( comm )
           {
-#if HAVE_MPI
-            if( parallelInformation.type() == typeid(ParallelISTLInformation) )
-            {
-              const ParallelISTLInformation& info =
-                  boost::any_cast<const ParallelISTLInformation&>( parallelInformation);
-              comm_.reset( new communication_type( info.communicator() ) );
-            }
-#endif
           }
 
           virtual void apply( const X& x, Y& y ) const
           {
-            A_.mv( x, y );
+            HardwareCounters::Scope counters(HardwareCounters::WellOperator);
+            BlockKernels::matrixMv( A_, x, y );
             // add well model modification to y
             wellMod_.apply(x, y );
 
@@ -1134,15 +1772,438 @@ namespace Opm {
 
           communication_type* comm()
           {
-              return comm_.operator->();
+              return comm_;
           }
 
         protected:
           const matrix_type& A_ ;
           const WellModel& wellMod_;
-          std::unique_ptr< communication_type > comm_;
+          communication_type* comm_;
         };
 
+        /*!
+           \brief Adapter applying a single precision copy of the matrix and
+           the well model as the linear operator. The products are accumulated
+           in double precision and the matrix in double precision is kept for
+           the preconditioner.
+         */
+        template<class M, class FM, class X, class Y, class WellModel, bool overlapping >
+        class FloatJacobianMatrixAdapter : public Dune::AssembledLinearOperator<M,X,Y>
+        {
+        public:
+          typedef M matrix_type;
+          typedef X domain_type;
+          typedef Y range_type;
+          typedef typename X::field_type field_type;
+
+#if HAVE_MPI
+          typedef Dune::OwnerOverlapCopyCommunication<int,int> communication_type;
+#else
+          typedef Dune::CollectiveCommunication< Grid > communication_type;
+#endif
+
+          enum {
+            //! \brief The solver category.
+            category = overlapping ?
+                Dune::SolverCategory::overlapping :
+                Dune::SolverCategory::sequential
+          };
+
+          FloatJacobianMatrixAdapter (const M& A, const FM& floatA, const WellModel& wellMod,
+                                      communication_type* comm = nullptr )
+              : A_( A ), floatA_( floatA ), wellMod_( wellMod ), comm_( comm ), tmp_( A.N() )
+          {
+          }
+
+          virtual void apply( const X& x, Y& y ) const
+          {
+            HardwareCounters::Scope counters(HardwareCounters::WellOperator);
+            BlockKernels::matrixMv( floatA_, x, y );
+            wellMod_.apply(x, y );
+
+#if HAVE_MPI
+            if( comm_ )
+              comm_->project( y );
+#endif
+          }
+
+          // y += \alpha * A * x
+          virtual void applyscaleadd (field_type alpha, const X& x, Y& y) const
+          {
+            BlockKernels::matrixMv( floatA_, x, tmp_ );
+            wellMod_.apply(x, tmp_ );
+            y.axpy( alpha, tmp_ );
+
+#if HAVE_MPI
+            if( comm_ )
+              comm_->project( y );
+#endif
+          }
+
+          virtual const matrix_type& getmat() const { return A_; }
+
+          communication_type* comm()
+          {
+              return comm_;
+          }
+
+        protected:
+          const matrix_type& A_ ;
+          const FM& floatA_;
+          const WellModel& wellMod_;
+          communication_type* comm_;
+          mutable Y tmp_;
+        };
+
+        /*!
+           \brief A linear operator applying the Jacobian by a function, e.g.
+           finite differences of the residual, with an assembled matrix for
+           the preconditioner.
+         */
+        template<class M, class X, class Y>
+        class MatrixFreeOperator : public Dune::AssembledLinearOperator<M,X,Y>
+        {
+        public:
+          typedef M matrix_type;
+          typedef X domain_type;
+          typedef Y range_type;
+          typedef typename X::field_type field_type;
+
+          enum {
+            //! \brief The solver category.
+            category = Dune::SolverCategory::sequential
+          };
+
+          MatrixFreeOperator (const M& A, std::function<void(const X&, Y&)> applyJacobian)
+              : A_( A ), applyJacobian_( applyJacobian ), tmp_( A.N() )
+          {
+          }
+
+          virtual void apply( const X& x, Y& y ) const
+          {
+            applyJacobian_( x, y );
+          }
+
+          // y += \alpha * A * x
+          virtual void applyscaleadd (field_type alpha, const X& x, Y& y) const
+          {
+            applyJacobian_( x, tmp_ );
+            y.axpy( alpha, tmp_ );
+          }
+
+          virtual const matrix_type& getmat() const { return A_; }
+
+        protected:
+          const matrix_type& A_ ;
+          std::function<void(const X&, Y&)> applyJacobian_;
+          mutable Y tmp_;
+        };
+
+        /// Apply the Newton update of the reservoir and the wells and pass the
+        /// new solution to ebos.
+        void applyUpdate(const int iteration, const BVector& x, const BVector& xw,
+                         ReservoirState& reservoir_state, WellState& well_state)
+        {
+            TimerTree::Region region("update state");
+            OPM_PROFILE_REGION("updateState");
+            HardwareCounters::Scope counters(HardwareCounters::UpdateState);
+            Dune::Timer updateTimer;
+            updateTimer.start();
+            previous_solution_ = ebosSimulator_.model().solution(/*timeIdx=*/0);
+            if (param_.update_ebos_directly_) {
+                // the reservoir state is filled from ebos once the step converged
+                updatePrimaryVariables(x);
+                reservoir_state_outdated_ = true;
+            }
+            else {
+                updateState(x,reservoir_state);
+            }
+            wellModel().updateWellState(xw, well_state);
+            // if the solution is updated the solution needs to be comunicated to ebos
+            // and the cachedIntensiveQuantities of the changed cells need to be updated.
+            if (!param_.update_ebos_directly_) {
+                convertInput( iteration, reservoir_state, ebosSimulator_ );
+            }
+            invalidateChangedIntensiveQuantities(previous_solution_);
+            recordTrace(PerformanceTrace::UpdateState, updateTimer.stop());
+        }
+
+        /// The largest of the residual norms computed by getConvergence().
+        static double maxResidualNorm(const std::vector<double>& residual_norms)
+        {
+            double norm = 0.0;
+            for (const double value : residual_norms) {
+                norm = std::max(norm, value);
+            }
+            return norm;
+        }
+
+        /// Nonlinear domain decomposition: Newton iterations on the subdomains
+        /// with cells that do not satisfy the CNV tolerance, with the cells of
+        /// the other subdomains and the wells fixed, until all subdomains
+        /// converge or nldd_local_iterations are done. The subdomains are
+        /// solved independently of each other, in parallel, and the state is
+        /// assembled again after each local iteration. The global Newton
+        /// update of the iteration then corrects the coupling between the
+        /// subdomains.
+        template <class NonlinearSolverType>
+        void solveSubdomains(const SimulatorTimerInterface& timer, const int iteration,
+                             const NonlinearSolverType& nonlinear_solver,
+                             ReservoirState& reservoir_state, WellState& well_state,
+                             std::vector<double>& residual_norms, SimulatorReport& report)
+        {
+            Dune::Timer perfTimer;
+            const auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
+            if (!subdomains_ || subdomains_->numRows() != ebosJac.N()) {
+                subdomains_.reset(new SubdomainPartition(ebosJac, param_.nldd_num_subdomains_));
+                subdomainMatrices_.clear();
+                subdomainMatrices_.resize(subdomains_->numDomains());
+            }
+
+            for (int localIteration = 0; localIteration < param_.nldd_local_iterations_; ++localIteration) {
+                perfTimer.reset();
+                perfTimer.start();
+                const std::vector<int> domains = unconvergedSubdomains();
+                if (domains.empty()) {
+                    break;
+                }
+
+                BVector& x = workspace_.dx;
+                BVector& xw = workspace_.dxw;
+                x = 0.0;
+                xw = 0.0;
+                const int solved = solveSubdomainSystems(domains, x);
+                report.linear_solve_time += perfTimer.stop();
+                if (solved == 0) {
+                    break;
+                }
+
+                perfTimer.reset();
+                perfTimer.start();
+                applyUpdate(iteration, x, xw, reservoir_state, well_state);
+                report.update_time += perfTimer.stop();
+
+                perfTimer.reset();
+                perfTimer.start();
+                report.total_linearizations += 1;
+                report += assemble(timer, iteration, reservoir_state, well_state);
+                report.assemble_time += perfTimer.stop();
+
+                perfTimer.reset();
+                perfTimer.start();
+                residual_norms.clear();
+                report.converged = getConvergence(timer, iteration, residual_norms) && iteration > nonlinear_solver.minIter();
+                if (wellModel().wellCollection()->groupControlActive()) {
+                    report.converged = report.converged && wellModel().groupTargetConverged(well_state.wellRates());
+                }
+                report.update_time += perfTimer.stop();
+
+                if (terminalOutputEnabled()) {
+                    OPM_DEBUG_LOG(Newton, "    Local Newton iteration " << localIteration + 1
+                                  << " updated " << solved << " of "
+                                  << subdomains_->numDomains() << " subdomains");
+                }
+                if (report.converged) {
+                    break;
+                }
+            }
+        }
+
+        /// The subdomains with a cell whose scaled residual exceeds the CNV
+        /// tolerance, with the scaling of the last getConvergence().
+        std::vector<int> unconvergedSubdomains() const
+        {
+            const auto& ebosModel = ebosSimulator_.model();
+            const auto& ebosProblem = ebosSimulator_.problem();
+            const auto& ebosResid = ebosModel.linearizer().residual();
+            const int np = numPhases();
+            const int numComp = cnv_scale_.size();
+            std::vector<char> unconverged(subdomains_->numDomains(), 0);
+            const int numCells = ebosResid.size();
+            for (int cell_idx = 0; cell_idx < numCells; ++cell_idx) {
+                const int d = subdomains_->domain(cell_idx);
+                if (unconverged[d]) {
+                    continue;
+                }
+                const double pvValue = ebosProblem.porosity(cell_idx) * ebosModel.dofTotalVolume(cell_idx);
+                for (int compIdx = 0; compIdx < numComp; ++compIdx) {
+                    // the phase equations are in the ebos order, the others are not
+                    const int eqIdx = compIdx < np ? flowPhaseToEbosCompIdx(compIdx) : compIdx;
+                    if (!(cnv_scale_[compIdx] * std::abs(ebosResid[cell_idx][eqIdx]) / pvValue
+                          < param_.tolerance_cnv_)) {
+                        unconverged[d] = 1;
+                        break;
+                    }
+                }
+            }
+            std::vector<int> domains;
+            for (int d = 0; d < subdomains_->numDomains(); ++d) {
+                if (unconverged[d]) {
+                    domains.push_back(d);
+                }
+            }
+            return domains;
+        }
+
+        /// Solve the linear systems of the given subdomains, with the rows of
+        /// the other subdomains fixed, and store their solutions in x. In a
+        /// parallel run the rows not owned by the process are not updated.
+        /// Returns the number of subdomains whose solve converged, the others
+        /// are not updated.
+        int solveSubdomainSystems(const std::vector<int>& domains, BVector& x)
+        {
+            typedef Dune::MatrixAdapter<Mat, BVector, BVector> Operator;
+            const auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
+            const auto& ebosResid = ebosSimulator_.model().linearizer().residual();
+            const int numDomains = domains.size();
+            int solved = 0;
+
+            std::exception_ptr error;
+#pragma omp parallel for schedule(dynamic) reduction(+:solved)
+            for (int i = 0; i < numDomains; ++i) {
+                try {
+                    const int d = domains[i];
+                    Mat& local = subdomainMatrices_[d];
+                    if (local.N() == 0) {
+                        subdomains_->createMatrix(ebosJac, d, local);
+                    }
+                    else {
+                        subdomains_->copyMatrixValues(ebosJac, d, local);
+                    }
+                    BVector b;
+                    subdomains_->restrictVector(ebosResid, d, b);
+                    BVector dx(b.size());
+                    dx = 0.0;
+
+                    Operator opA(local);
+                    Dune::SeqILU0<Mat, BVector, BVector> precond(local, 1.0);
+                    Dune::BiCGSTABSolver<BVector> solver(opA, precond, 1e-3, 200, /*verbose=*/0);
+                    Dune::InverseOperatorResult result;
+                    solver.apply(dx, b, result);
+                    if (result.converged) {
+                        subdomains_->prolongateVector(dx, d, x);
+                        ++solved;
+                    }
+                }
+                catch (...) {
+#pragma omp critical
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+
+            if (isParallel()) {
+                // the overlap rows are updated by the processes owning them
+                if (interiorCells_.empty()) {
+                    collectInteriorCells();
+                }
+                for (std::size_t cell_idx = 0; cell_idx < x.size(); ++cell_idx) {
+                    if (!interiorCells_[cell_idx]) {
+                        x[cell_idx] = 0.0;
+                    }
+                }
+            }
+            return solved;
+        }
+
+        /// Mark the cells of the interior partition in interiorCells_.
+        void collectInteriorCells()
+        {
+            if (interiorElements_.empty()) {
+                collectElements<Dune::Interior_Partition>(interiorElements_);
+            }
+            interiorCells_.assign(AutoDiffGrid::numCells(grid_), 0);
+            ElementContext elemCtx(ebosSimulator_);
+            for (const auto& elem : interiorElements_) {
+                elemCtx.updatePrimaryStencil(elem);
+                interiorCells_[elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0)] = 1;
+            }
+        }
+
+        /// Whether the Newton update of a cell is below localized_update_tolerance,
+        /// relative to the pressure and to the dissolved gas or vaporized oil
+        /// ratio when that is the primary variable.
+        template <class CellUpdate>
+        bool negligibleUpdate(const CellUpdate& dx, const int cell_idx,
+                              const ReservoirState& reservoir_state) const
+        {
+            const int pressureIdx = flowPhaseToEbosCompIdx(0);
+            const int switchIdx = active_[Gas] ? flowPhaseToEbosCompIdx(active_[Water] ? 2 : 1) : -1;
+            const HydroCarbonState hydroCarbonState = reservoir_state.hydroCarbonState()[cell_idx];
+            for (int compIdx = 0; compIdx < static_cast<int>(dx.size()); ++compIdx) {
+                double scale = 1.0;
+                if (compIdx == pressureIdx) {
+                    scale = std::abs(reservoir_state.pressure()[cell_idx]);
+                } else if (compIdx == switchIdx && hydroCarbonState == HydroCarbonState::OilOnly) {
+                    scale = std::abs(reservoir_state.gasoilratio()[cell_idx]);
+                } else if (compIdx == switchIdx && hydroCarbonState == HydroCarbonState::GasOnly) {
+                    scale = std::abs(reservoir_state.rv()[cell_idx]);
+                }
+                // a nan update is never negligible
+                if (!(std::abs(dx[compIdx]) <= param_.localized_update_tolerance_ * scale)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// As above, relative to the primary variables of the cell in ebos.
+        template <class CellUpdate>
+        bool negligibleUpdate(const CellUpdate& dx, const PrimaryVariables& cellPv) const
+        {
+            const int pressureIdx = flowPhaseToEbosCompIdx(0);
+            const int switchIdx = active_[Gas] ? flowPhaseToEbosCompIdx(active_[Water] ? 2 : 1) : -1;
+            const bool dissolvedRatio = cellPv.primaryVarsMeaning() != PrimaryVariables::Sw_po_Sg;
+            for (int compIdx = 0; compIdx < static_cast<int>(dx.size()); ++compIdx) {
+                double scale = 1.0;
+                if (compIdx == pressureIdx) {
+                    scale = std::abs(cellPv[BlackoilIndices::pressureSwitchIdx]);
+                } else if (compIdx == switchIdx && dissolvedRatio) {
+                    scale = std::abs(cellPv[BlackoilIndices::compositionSwitchIdx]);
+                }
+                // a nan update is never negligible
+                if (!(std::abs(dx[compIdx]) <= param_.localized_update_tolerance_ * scale)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// Whether the linear solve of this iteration applies the preconditioner
+        /// of the previous one: not in the first iteration of a time step, not
+        /// after a linear solver failure, at most preconditioner_max_reuse times
+        /// in a row, and only while the residual drops by the factor
+        /// preconditioner_reuse_ratio per iteration.
+        bool reusePreconditioner(const int iteration) const
+        {
+            const int n = residual_norms_history_.size();
+            if (iteration == 0 || n < 2 || linear_failures_ > 0
+                || preconditioner_reuses_ >= param_.preconditioner_max_reuse_) {
+                return false;
+            }
+            const double previous = maxResidualNorm(residual_norms_history_[n - 2]);
+            const double current = maxResidualNorm(residual_norms_history_[n - 1]);
+            // a nan residual sets the preconditioner up again
+            return current <= param_.preconditioner_reuse_ratio_ * previous;
+        }
+
+        /// Whether the previous Newton update should be halved again, i.e. it
+        /// grew the residual and the line search has cuts left.
+        bool lineSearchRejects(const int iteration, const std::vector<double>& residual_norms,
+                               const int cuts) const
+        {
+            if (iteration == 0 || cuts >= param_.line_search_max_cuts_ || !line_search_well_state_) {
+                return false;
+            }
+            const double norm = maxResidualNorm(residual_norms);
+            // a nan residual is rejected as well
+            return !(norm <= param_.line_search_residual_growth_ * line_search_residual_);
+        }
+
         /// Apply an update to the primary variables, chopped if appropriate.
         /// \param[in]      dx                updates to apply to primary variables
         /// \param[in, out] reservoir_state   reservoir state variables
@@ -1153,198 +2214,471 @@ namespace Opm {
             using namespace Opm::AutoDiffGrid;
             const int np = phaseUsage_.num_phases;
 
-            ElementContext elemCtx( ebosSimulator_ );
-            const auto& gridView = ebosSimulator_.gridView();
-            const auto& elemEndIt = gridView.template end</*codim=*/0>();
-            for (auto elemIt = gridView.template begin</*codim=*/0>();
-                 elemIt != elemEndIt;
-                 ++elemIt)
+            if (allElements_.empty()) {
+                collectElements<Dune::All_Partition>(allElements_);
+            }
+            const int numElements = allElements_.size();
+            const bool localized = param_.localized_update_tolerance_ > 0.0;
+
+            // the number of primary variable switches counted by each thread,
+            // summed in the order of the threads
+            int numThreads = 1;
+#ifdef _OPENMP
+            numThreads = omp_get_max_threads();
+#endif
+            std::vector<int> threadSwitches(numThreads, 0);
+
+            std::exception_ptr error;
+#pragma omp parallel
             {
-                const auto& elem = *elemIt;
-                elemCtx.updatePrimaryStencil(elem);
-                elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
-                const unsigned cell_idx = elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0);
-                const double& dp = dx[cell_idx][flowPhaseToEbosCompIdx(0)];
-                //reservoir_state.pressure()[cell_idx] -= dp;
-                double& p = reservoir_state.pressure()[cell_idx];
-                const double& dp_rel_max = dpMaxRel();
-                const int sign_dp = dp > 0 ? 1: -1;
-                p -= sign_dp * std::min(std::abs(dp), std::abs(p)*dp_rel_max);
-                p = std::max(p, 0.0);
-
-                // Saturation updates.
-                const double dsw = active_[Water] ? dx[cell_idx][flowPhaseToEbosCompIdx(1)] : 0.0;
-                const int xvar_ind = active_[Water] ? 2 : 1;
-                const double dxvar = active_[Gas] ? dx[cell_idx][flowPhaseToEbosCompIdx(xvar_ind)] : 0.0;
-
-                double dso = 0.0;
-                double dsg = 0.0;
-                double drs = 0.0;
-                double drv = 0.0;
-
-                double maxVal = 0.0;
-                // water phase
-                maxVal = std::max(std::abs(dsw),maxVal);
-                dso -= dsw;
-                // gas phase
-                switch (reservoir_state.hydroCarbonState()[cell_idx]) {
-                case HydroCarbonState::GasAndOil:
-                    dsg = dxvar;
-                    break;
-                case HydroCarbonState::OilOnly:
-                    drs = dxvar;
-                    break;
-                case HydroCarbonState::GasOnly:
-                    dsg -= dsw;
-                    drv = dxvar;
-                    break;
-                default:
-                    OPM_THROW(std::logic_error, "Unknown primary variable enum value in cell " << cell_idx << ": " << reservoir_state.hydroCarbonState()[cell_idx]);
-                }
-                dso -= dsg;
+                int thread = 0;
+#ifdef _OPENMP
+                thread = omp_get_thread_num();
+#endif
+                int switches = 0;
+                ElementContext elemCtx( ebosSimulator_ );
+#pragma omp for schedule(static)
+                for (int elemIdx = 0; elemIdx < numElements; ++elemIdx)
+                {
+                    try {
+                        const auto& elem = allElements_[elemIdx];
+                        elemCtx.updatePrimaryStencil(elem);
+                        const unsigned cell_idx = elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0);
+                        if (localized && negligibleUpdate(dx[cell_idx], cell_idx, reservoir_state)) {
+                            continue;
+                        }
+                        elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+                        const HydroCarbonState oldHydroCarbonState = reservoir_state.hydroCarbonState()[cell_idx];
+                        const double& dp = dx[cell_idx][flowPhaseToEbosCompIdx(0)];
+                        //reservoir_state.pressure()[cell_idx] -= dp;
+                        double& p = reservoir_state.pressure()[cell_idx];
+                        const double& dp_rel_max = dpMaxRel();
+                        const int sign_dp = dp > 0 ? 1: -1;
+                        p -= sign_dp * std::min(std::abs(dp), std::abs(p)*dp_rel_max);
+                        p = std::max(p, 0.0);
+
+                        // Saturation updates.
+                        const double dsw = active_[Water] ? dx[cell_idx][flowPhaseToEbosCompIdx(1)] : 0.0;
+                        const int xvar_ind = active_[Water] ? 2 : 1;
+                        const double dxvar = active_[Gas] ? dx[cell_idx][flowPhaseToEbosCompIdx(xvar_ind)] : 0.0;
+
+                        double dso = 0.0;
+                        double dsg = 0.0;
+                        double drs = 0.0;
+                        double drv = 0.0;
+
+                        double maxVal = 0.0;
+                        // water phase
+                        maxVal = std::max(std::abs(dsw),maxVal);
+                        dso -= dsw;
+                        // gas phase
+                        switch (reservoir_state.hydroCarbonState()[cell_idx]) {
+                        case HydroCarbonState::GasAndOil:
+                            dsg = dxvar;
+                            break;
+                        case HydroCarbonState::OilOnly:
+                            drs = dxvar;
+                            break;
+                        case HydroCarbonState::GasOnly:
+                            dsg -= dsw;
+                            drv = dxvar;
+                            break;
+                        default:
+                            OPM_THROW(std::logic_error, "Unknown primary variable enum value in cell " << cell_idx << ": " << reservoir_state.hydroCarbonState()[cell_idx]);
+                        }
+                        dso -= dsg;
 
-                // solvent
-                const double dss = has_solvent_ ? dx[cell_idx][BlackoilIndices::solventSaturationIdx] : 0.0;
-                dso -= dss;
+                        // solvent
+                        const double dss = has_solvent_ ? dx[cell_idx][BlackoilIndices::solventSaturationIdx] : 0.0;
+                        dso -= dss;
 
-                // polymer
-                const double dc = has_polymer_ ? dx[cell_idx][BlackoilIndices::polymerConcentrationIdx] : 0.0;
+                        // polymer
+                        const double dc = has_polymer_ ? dx[cell_idx][BlackoilIndices::polymerConcentrationIdx] : 0.0;
 
-                // Appleyard chop process.
-                maxVal = std::max(std::abs(dsg),maxVal);
-                maxVal = std::max(std::abs(dss),maxVal);
+                        // Appleyard chop process.
+                        maxVal = std::max(std::abs(dsg),maxVal);
+                        maxVal = std::max(std::abs(dss),maxVal);
 
-                double step = dsMax()/maxVal;
-                step = std::min(step, 1.0);
+                        double step = dsMax()/maxVal;
+                        step = std::min(step, 1.0);
 
-                const Opm::PhaseUsage& pu = phaseUsage_;
-                if (active_[Water]) {
-                    double& sw = reservoir_state.saturation()[cell_idx*np + pu.phase_pos[ Water ]];
-                    sw -= step * dsw;
-                }
-                if (active_[Gas]) {
-                    double& sg = reservoir_state.saturation()[cell_idx*np + pu.phase_pos[ Gas ]];
-                    sg -= step * dsg;
-                }
+                        const Opm::PhaseUsage& pu = phaseUsage_;
+                        if (active_[Water]) {
+                            double& sw = reservoir_state.saturation()[cell_idx*np + pu.phase_pos[ Water ]];
+                            sw -= step * dsw;
+                        }
+                        if (active_[Gas]) {
+                            double& sg = reservoir_state.saturation()[cell_idx*np + pu.phase_pos[ Gas ]];
+                            sg -= step * dsg;
+                        }
 
-                if (has_solvent_) {
-                    double& ss = reservoir_state.getCellData( reservoir_state.SSOL )[cell_idx];
-                    ss -= step * dss;
-                }
+                        if (has_solvent_) {
+                            double& ss = reservoir_state.getCellData( reservoir_state.SSOL )[cell_idx];
+                            ss -= step * dss;
+                        }
 
-                if (has_polymer_) {
-                    double& c = reservoir_state.getCellData( reservoir_state.POLYMER )[cell_idx];
-                    c -= step * dc;
-                    c = std::max(c, 0.0);
-                }
-
-                double& so = reservoir_state.saturation()[cell_idx*np + pu.phase_pos[ Oil ]];
-                so -= step * dso;
-
-                // phase for when oil and gas
-                if (active_[Gas] && active_[Oil] ) {
-                    // const double drmaxrel = drMaxRel();
-                    // Update rs and rv
-                    if (has_disgas_) {
-                        double& rs = reservoir_state.gasoilratio()[cell_idx];
-                        rs -= drs;
-                        rs = std::max(rs, 0.0);
-
-                    }
-                    if (has_vapoil_) {
-                        double& rv = reservoir_state.rv()[cell_idx];
-                        rv -= drv;
-                        rv = std::max(rv, 0.0);
-                    }
-
-                    // Sg is used as primal variable for water only cells.
-                    const double epsilon = 1e-4; //std::sqrt(std::numeric_limits<double>::epsilon());
-                    double& sw = reservoir_state.saturation()[cell_idx*np + pu.phase_pos[ Water ]];
-                    double& sg = reservoir_state.saturation()[cell_idx*np + pu.phase_pos[ Gas ]];
-                    double& rs = reservoir_state.gasoilratio()[cell_idx];
-                    double& rv = reservoir_state.rv()[cell_idx];
-
-                    // phase translation sg <-> rs
-                    const HydroCarbonState hydroCarbonState = reservoir_state.hydroCarbonState()[cell_idx];
-                    const auto& intQuants = elemCtx.intensiveQuantities(/*spaceIdx=*/0, /*timeIdx=*/0);
-                    const auto& fs = intQuants.fluidState();
-                    switch (hydroCarbonState) {
-                    case HydroCarbonState::GasAndOil: {
-
-                        // for the Gas and Oil case rs=rsSat and rv=rvSat
-                        rs = FluidSystem::oilPvt().saturatedGasDissolutionFactor(fs.pvtRegionIndex(), reservoir_state.temperature()[cell_idx], reservoir_state.pressure()[cell_idx]);
-                        // use gas pressure?
-                        rv = FluidSystem::gasPvt().saturatedOilVaporizationFactor(fs.pvtRegionIndex(), reservoir_state.temperature()[cell_idx], reservoir_state.pressure()[cell_idx]);
-
-                        if (sw > (1.0 - epsilon)) // water only i.e. do nothing
-                            break;
+                        if (has_polymer_) {
+                            double& c = reservoir_state.getCellData( reservoir_state.POLYMER )[cell_idx];
+                            c -= step * dc;
+                            c = std::max(c, 0.0);
+                        }
 
-                        if (sg <= 0.0 && has_disgas_) {
-                            reservoir_state.hydroCarbonState()[cell_idx] = HydroCarbonState::OilOnly; // sg --> rs
-                            sg = 0;
-                            so = 1.0 - sw;
-                            if (has_solvent_) {
-                                double& ss = reservoir_state.getCellData( reservoir_state.SSOL )[cell_idx];
-                                so -= ss;
+                        double& so = reservoir_state.saturation()[cell_idx*np + pu.phase_pos[ Oil ]];
+                        so -= step * dso;
+
+                        // phase for when oil and gas
+                        if (active_[Gas] && active_[Oil] ) {
+                            // const double drmaxrel = drMaxRel();
+                            // Update rs and rv
+                            if (has_disgas_) {
+                                double& rs = reservoir_state.gasoilratio()[cell_idx];
+                                rs -= drs;
+                                rs = std::max(rs, 0.0);
+
+                            }
+                            if (has_vapoil_) {
+                                double& rv = reservoir_state.rv()[cell_idx];
+                                rv -= drv;
+                                rv = std::max(rv, 0.0);
+                            }
+
+                            // Sg is used as primal variable for water only cells.
+                            const double epsilon = 1e-4; //std::sqrt(std::numeric_limits<double>::epsilon());
+                            double& sw = reservoir_state.saturation()[cell_idx*np + pu.phase_pos[ Water ]];
+                            double& sg = reservoir_state.saturation()[cell_idx*np + pu.phase_pos[ Gas ]];
+                            double& rs = reservoir_state.gasoilratio()[cell_idx];
+                            double& rv = reservoir_state.rv()[cell_idx];
+
+                            // phase translation sg <-> rs
+                            const HydroCarbonState hydroCarbonState = reservoir_state.hydroCarbonState()[cell_idx];
+                            const auto& intQuants = elemCtx.intensiveQuantities(/*spaceIdx=*/0, /*timeIdx=*/0);
+                            const auto& fs = intQuants.fluidState();
+                            switch (hydroCarbonState) {
+                            case HydroCarbonState::GasAndOil: {
+
+                                // for the Gas and Oil case rs=rsSat and rv=rvSat
+                                rs = FluidSystem::oilPvt().saturatedGasDissolutionFactor(fs.pvtRegionIndex(), reservoir_state.temperature()[cell_idx], reservoir_state.pressure()[cell_idx]);
+                                // use gas pressure?
+                                rv = FluidSystem::gasPvt().saturatedOilVaporizationFactor(fs.pvtRegionIndex(), reservoir_state.temperature()[cell_idx], reservoir_state.pressure()[cell_idx]);
+
+                                if (sw > (1.0 - epsilon)) // water only i.e. do nothing
+                                    break;
+
+                                if (sg <= 0.0 && has_disgas_) {
+                                    reservoir_state.hydroCarbonState()[cell_idx] = HydroCarbonState::OilOnly; // sg --> rs
+                                    sg = 0;
+                                    so = 1.0 - sw;
+                                    if (has_solvent_) {
+                                        double& ss = reservoir_state.getCellData( reservoir_state.SSOL )[cell_idx];
+                                        so -= ss;
+                                    }
+                                    rs *= (1-epsilon);
+                                } else if (so <= 0.0 && has_vapoil_) {
+                                    reservoir_state.hydroCarbonState()[cell_idx] = HydroCarbonState::GasOnly; // sg --> rv
+                                    so = 0;
+                                    sg = 1.0 - sw;
+                                    if (has_solvent_) {
+                                        double& ss = reservoir_state.getCellData( reservoir_state.SSOL )[cell_idx];
+                                        sg -= ss;
+                                    }
+                                    rv *= (1-epsilon);
+                                }
+                                break;
+                            }
+                            case HydroCarbonState::OilOnly: {
+                                if (sw > (1.0 - epsilon)) {
+                                    // water only change to Sg
+                                    rs = 0;
+                                    rv = 0;
+                                    reservoir_state.hydroCarbonState()[cell_idx] = HydroCarbonState::GasAndOil;
+                                    //std::cout << "watonly rv -> sg" << cell_idx << std::endl;
+                                    break;
+                                }
+
+                                const double& rsSat = FluidSystem::oilPvt().saturatedGasDissolutionFactor(fs.pvtRegionIndex(), reservoir_state.temperature()[cell_idx], reservoir_state.pressure()[cell_idx]);
+                                if (rs > ( rsSat * (1+epsilon) ) ) {
+                                    reservoir_state.hydroCarbonState()[cell_idx] = HydroCarbonState::GasAndOil;
+                                    sg = epsilon;
+                                    so -= epsilon;
+                                    rs = rsSat;
+                                }
+                                break;
                             }
-                            rs *= (1-epsilon);
-                        } else if (so <= 0.0 && has_vapoil_) {
-                            reservoir_state.hydroCarbonState()[cell_idx] = HydroCarbonState::GasOnly; // sg --> rv
-                            so = 0;
-                            sg = 1.0 - sw;
-                            if (has_solvent_) {
-                                double& ss = reservoir_state.getCellData( reservoir_state.SSOL )[cell_idx];
-                                sg -= ss;
+                            case HydroCarbonState::GasOnly: {
+                                if (sw > (1.0 - epsilon)) {
+                                    // water only change to Sg
+                                    rs = 0;
+                                    rv = 0;
+                                    reservoir_state.hydroCarbonState()[cell_idx] = HydroCarbonState::GasAndOil;
+                                    //std::cout << "watonly rv -> sg" << cell_idx << std::endl;
+                                    break;
+                                }
+
+                                const double& rvSat = FluidSystem::gasPvt().saturatedOilVaporizationFactor(fs.pvtRegionIndex(), reservoir_state.temperature()[cell_idx], reservoir_state.pressure()[cell_idx]);
+                                if (rv > rvSat * (1+epsilon) ) {
+                                    reservoir_state.hydroCarbonState()[cell_idx] = HydroCarbonState::GasAndOil;
+                                    so = epsilon;
+                                    rv = rvSat;
+                                    sg -= epsilon;
+                                }
+                                break;
+                            }
+
+                            default:
+                                OPM_THROW(std::logic_error, "Unknown primary variable enum value in cell " << cell_idx << ": " << hydroCarbonState);
                             }
-                            rv *= (1-epsilon);
                         }
-                        break;
+
+                        if (reservoir_state.hydroCarbonState()[cell_idx] != oldHydroCarbonState) {
+                            ++switches;
+                        }
                     }
-                    case HydroCarbonState::OilOnly: {
-                        if (sw > (1.0 - epsilon)) {
-                            // water only change to Sg
-                            rs = 0;
-                            rv = 0;
-                            reservoir_state.hydroCarbonState()[cell_idx] = HydroCarbonState::GasAndOil;
-                            //std::cout << "watonly rv -> sg" << cell_idx << std::endl;
-                            break;
+                    catch (...) {
+#pragma omp critical
+                        if (!error) {
+                            error = std::current_exception();
                         }
+                    }
+                }
+                threadSwitches[thread] = switches;
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+
+            primaryVariableSwitches_ = 0;
+            for (int thread = 0; thread < numThreads; ++thread) {
+                primaryVariableSwitches_ += threadSwitches[thread];
+            }
+        }
 
-                        const double& rsSat = FluidSystem::oilPvt().saturatedGasDissolutionFactor(fs.pvtRegionIndex(), reservoir_state.temperature()[cell_idx], reservoir_state.pressure()[cell_idx]);
-                        if (rs > ( rsSat * (1+epsilon) ) ) {
-                            reservoir_state.hydroCarbonState()[cell_idx] = HydroCarbonState::GasAndOil;
-                            sg = epsilon;
-                            so -= epsilon;
-                            rs = rsSat;
+        /// Apply an update directly to the primary variables of ebos, chopped
+        /// and with the primary variable switching of updateState(). The
+        /// pressure variable of cells with only gas is the gas pressure, which
+        /// is converted with the capillary pressure of the last iteration when
+        /// the cell switches to or from that state.
+        /// \param[in]      dx                updates to apply to primary variables
+        void updatePrimaryVariables(const BVector& dx)
+        {
+            if (allElements_.empty()) {
+                collectElements<Dune::All_Partition>(allElements_);
+            }
+            const int numElements = allElements_.size();
+            const bool localized = param_.localized_update_tolerance_ > 0.0;
+            SolutionVector& solution = ebosSimulator_.model().solution(/*timeIdx=*/0);
+
+            // the number of primary variable switches counted by each thread,
+            // summed in the order of the threads
+            int numThreads = 1;
+#ifdef _OPENMP
+            numThreads = omp_get_max_threads();
+#endif
+            std::vector<int> threadSwitches(numThreads, 0);
+
+            std::exception_ptr error;
+#pragma omp parallel
+            {
+                int thread = 0;
+#ifdef _OPENMP
+                thread = omp_get_thread_num();
+#endif
+                int switches = 0;
+                ElementContext elemCtx( ebosSimulator_ );
+#pragma omp for schedule(static)
+                for (int elemIdx = 0; elemIdx < numElements; ++elemIdx)
+                {
+                    try {
+                        const auto& elem = allElements_[elemIdx];
+                        elemCtx.updatePrimaryStencil(elem);
+                        const unsigned cell_idx = elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0);
+                        PrimaryVariables& cellPv = solution[cell_idx];
+                        if (localized && negligibleUpdate(dx[cell_idx], cellPv)) {
+                            continue;
                         }
-                        break;
-                    }
-                    case HydroCarbonState::GasOnly: {
-                        if (sw > (1.0 - epsilon)) {
-                            // water only change to Sg
-                            rs = 0;
-                            rv = 0;
-                            reservoir_state.hydroCarbonState()[cell_idx] = HydroCarbonState::GasAndOil;
-                            //std::cout << "watonly rv -> sg" << cell_idx << std::endl;
-                            break;
+                        // the intensive quantities of the solution before the update
+                        elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+                        const auto& fs = elemCtx.intensiveQuantities(/*spaceIdx=*/0, /*timeIdx=*/0).fluidState();
+                        const auto oldMeaning = cellPv.primaryVarsMeaning();
+
+                        const double dp = dx[cell_idx][flowPhaseToEbosCompIdx(0)];
+                        double p = cellPv[BlackoilIndices::pressureSwitchIdx];
+                        const int sign_dp = dp > 0 ? 1: -1;
+                        p -= sign_dp * std::min(std::abs(dp), std::abs(p)*dpMaxRel());
+                        cellPv[BlackoilIndices::pressureSwitchIdx] = std::max(p, 0.0);
+
+                        const double dsw = active_[Water] ? dx[cell_idx][flowPhaseToEbosCompIdx(1)] : 0.0;
+                        const int xvar_ind = active_[Water] ? 2 : 1;
+                        const double dxvar = active_[Gas] ? dx[cell_idx][flowPhaseToEbosCompIdx(xvar_ind)] : 0.0;
+                        const double dss = has_solvent_ ? dx[cell_idx][BlackoilIndices::solventSaturationIdx] : 0.0;
+                        const double dc = has_polymer_ ? dx[cell_idx][BlackoilIndices::polymerConcentrationIdx] : 0.0;
+
+                        // the gas saturation of cells with only gas changes with
+                        // the water saturation
+                        double dsg = 0.0;
+                        if (active_[Gas] && oldMeaning == PrimaryVariables::Sw_po_Sg) {
+                            dsg = dxvar;
+                        } else if (active_[Gas] && oldMeaning == PrimaryVariables::Sw_pg_Rv) {
+                            dsg = -dsw;
                         }
 
-                        const double& rvSat = FluidSystem::gasPvt().saturatedOilVaporizationFactor(fs.pvtRegionIndex(), reservoir_state.temperature()[cell_idx], reservoir_state.pressure()[cell_idx]);
-                        if (rv > rvSat * (1+epsilon) ) {
-                            reservoir_state.hydroCarbonState()[cell_idx] = HydroCarbonState::GasAndOil;
-                            so = epsilon;
-                            rv = rvSat;
-                            sg -= epsilon;
+                        // Appleyard chop process.
+                        const double maxVal = std::max(std::abs(dsw), std::max(std::abs(dsg), std::abs(dss)));
+                        const double step = std::min(dsMax()/maxVal, 1.0);
+
+                        if (active_[Water]) {
+                            cellPv[BlackoilIndices::waterSaturationIdx] -= step * dsw;
+                        }
+                        if (has_solvent_) {
+                            cellPv[BlackoilIndices::solventSaturationIdx] -= step * dss;
+                        }
+                        if (has_polymer_) {
+                            double& c = cellPv[BlackoilIndices::polymerConcentrationIdx];
+                            c = std::max(c - step * dc, 0.0);
+                        }
+                        if (active_[Gas]) {
+                            double& xvar = cellPv[BlackoilIndices::compositionSwitchIdx];
+                            if (oldMeaning == PrimaryVariables::Sw_po_Sg) {
+                                xvar -= step * dsg;
+                            } else {
+                                // the dissolved gas or vaporized oil ratio
+                                xvar = std::max(xvar - dxvar, 0.0);
+                            }
+                        }
+
+                        if (active_[Gas] && active_[Oil]) {
+                            const double epsilon = 1e-4;
+                            const double sw = active_[Water] ? cellPv[BlackoilIndices::waterSaturationIdx] : 0.0;
+                            const double ss = has_solvent_ ? cellPv[BlackoilIndices::solventSaturationIdx] : 0.0;
+                            const double temperature = fs.temperature(FluidSystem::oilPhaseIdx).value();
+                            const double pcgo = fs.pressure(FluidSystem::gasPhaseIdx).value() - fs.pressure(FluidSystem::oilPhaseIdx).value();
+                            double& pressure = cellPv[BlackoilIndices::pressureSwitchIdx];
+                            double& xvar = cellPv[BlackoilIndices::compositionSwitchIdx];
+
+                            switch (oldMeaning) {
+                            case PrimaryVariables::Sw_po_Sg: {
+                                if (sw > (1.0 - epsilon)) // water only i.e. do nothing
+                                    break;
+
+                                const double so = 1.0 - sw - xvar - ss;
+                                if (xvar <= 0.0 && has_disgas_) {
+                                    const double rsSat = FluidSystem::oilPvt().saturatedGasDissolutionFactor(fs.pvtRegionIndex(), temperature, pressure);
+                                    xvar = rsSat * (1-epsilon);
+                                    cellPv.setPrimaryVarsMeaning(PrimaryVariables::Sw_po_Rs);
+                                } else if (so <= 0.0 && has_vapoil_) {
+                                    const double rvSat = FluidSystem::gasPvt().saturatedOilVaporizationFactor(fs.pvtRegionIndex(), temperature, pressure);
+                                    xvar = rvSat * (1-epsilon);
+                                    pressure += pcgo;
+                                    cellPv.setPrimaryVarsMeaning(PrimaryVariables::Sw_pg_Rv);
+                                }
+                                break;
+                            }
+                            case PrimaryVariables::Sw_po_Rs: {
+                                if (sw > (1.0 - epsilon)) {
+                                    // water only change to Sg
+                                    xvar = 0.0;
+                                    cellPv.setPrimaryVarsMeaning(PrimaryVariables::Sw_po_Sg);
+                                    break;
+                                }
+
+                                const double rsSat = FluidSystem::oilPvt().saturatedGasDissolutionFactor(fs.pvtRegionIndex(), temperature, pressure);
+                                if (xvar > ( rsSat * (1+epsilon) ) ) {
+                                    xvar = epsilon;
+                                    cellPv.setPrimaryVarsMeaning(PrimaryVariables::Sw_po_Sg);
+                                }
+                                break;
+                            }
+                            case PrimaryVariables::Sw_pg_Rv: {
+                                if (sw > (1.0 - epsilon)) {
+                                    // water only change to Sg
+                                    xvar = 1.0 - sw - ss;
+                                    pressure -= pcgo;
+                                    cellPv.setPrimaryVarsMeaning(PrimaryVariables::Sw_po_Sg);
+                                    break;
+                                }
+
+                                const double rvSat = FluidSystem::gasPvt().saturatedOilVaporizationFactor(fs.pvtRegionIndex(), temperature, pressure);
+                                if (xvar > rvSat * (1+epsilon) ) {
+                                    xvar = 1.0 - sw - ss - epsilon;
+                                    pressure -= pcgo;
+                                    cellPv.setPrimaryVarsMeaning(PrimaryVariables::Sw_po_Sg);
+                                }
+                                break;
+                            }
+                            default:
+                                OPM_THROW(std::logic_error, "Unknown primary variable meaning in cell " << cell_idx);
+                            }
+                        }
+
+                        if (cellPv.primaryVarsMeaning() != oldMeaning) {
+                            ++switches;
+                        }
+                    }
+                    catch (...) {
+#pragma omp critical
+                        if (!error) {
+                            error = std::current_exception();
                         }
-                        break;
                     }
+                }
+                threadSwitches[thread] = switches;
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
 
+            primaryVariableSwitches_ = 0;
+            for (int thread = 0; thread < numThreads; ++thread) {
+                primaryVariableSwitches_ += threadSwitches[thread];
+            }
+        }
+
+        /// Fill the reservoir state from the primary variables and intensive
+        /// quantities of ebos, the reverse of convertInput().
+        /// \param[out]     reservoir_state   reservoir state variables
+        void convertOutput(ReservoirState& reservoir_state)
+        {
+            if (allElements_.empty()) {
+                collectElements<Dune::All_Partition>(allElements_);
+            }
+            const int np = phaseUsage_.num_phases;
+            const Opm::PhaseUsage& pu = phaseUsage_;
+            const SolutionVector& solution = ebosSimulator_.model().solution(/*timeIdx=*/0);
+            ElementContext elemCtx( ebosSimulator_ );
+            for (const auto& elem : allElements_) {
+                elemCtx.updatePrimaryStencil(elem);
+                elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+                const unsigned cellIdx = elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0);
+                const auto& fs = elemCtx.intensiveQuantities(/*spaceIdx=*/0, /*timeIdx=*/0).fluidState();
+                const PrimaryVariables& cellPv = solution[cellIdx];
+
+                reservoir_state.pressure()[cellIdx] = fs.pressure(FluidSystem::oilPhaseIdx).value();
+                for (int phase = 0; phase < Opm::BlackoilPhases::MaxNumPhases; ++phase) {
+                    if (active_[phase]) {
+                        reservoir_state.saturation()[cellIdx*np + pu.phase_pos[phase]]
+                            = fs.saturation(flowPhaseToEbosPhaseIdx(phase)).value();
+                    }
+                }
+                if (active_[Gas] && active_[Oil]) {
+                    reservoir_state.gasoilratio()[cellIdx] = fs.Rs().value();
+                    reservoir_state.rv()[cellIdx] = fs.Rv().value();
+                    switch (cellPv.primaryVarsMeaning()) {
+                    case PrimaryVariables::Sw_po_Rs:
+                        reservoir_state.hydroCarbonState()[cellIdx] = HydroCarbonState::OilOnly;
+                        break;
+                    case PrimaryVariables::Sw_pg_Rv:
+                        reservoir_state.hydroCarbonState()[cellIdx] = HydroCarbonState::GasOnly;
+                        break;
                     default:
-                        OPM_THROW(std::logic_error, "Unknown primary variable enum value in cell " << cell_idx << ": " << hydroCarbonState);
+                        reservoir_state.hydroCarbonState()[cellIdx] = HydroCarbonState::GasAndOil;
                     }
                 }
+                if (has_solvent_) {
+                    reservoir_state.getCellData( reservoir_state.SSOL )[cellIdx] = cellPv[BlackoilIndices::solventSaturationIdx];
+                }
+                if (has_polymer_) {
+                    reservoir_state.getCellData( reservoir_state.POLYMER )[cellIdx] = cellPv[BlackoilIndices::polymerConcentrationIdx];
+                }
             }
-
         }
 
 
@@ -1372,8 +2706,8 @@ namespace Opm {
             if( comm.size() > 1 )
             {
                 // global reduction
-                std::vector< Scalar > sumBuffer;
-                std::vector< Scalar > maxBuffer;
+                std::vector< double > sumBuffer;
+                std::vector< double > maxBuffer;
                 const int numComp = B_avg.size();
                 sumBuffer.reserve( 2*numComp + 1 ); // +1 for pvSum
                 maxBuffer.reserve( 2*numComp );
@@ -1388,11 +2722,16 @@ namespace Opm {
                 // Compute total pore volume
                 sumBuffer.push_back( pvSum );
 
+#if HAVE_MPI
+                // compute global sum and max in one collective call
+                sumAndMaxAllReduce( comm, sumBuffer, maxBuffer );
+#else
                 // compute global sum
                 comm.sum( sumBuffer.data(), sumBuffer.size() );
 
                 // compute global max
                 comm.max( maxBuffer.data(), maxBuffer.size() );
+#endif
 
                 // restore values to local variables
                 for( int compIdx = 0, buffIdx = 0; compIdx < numComp; ++compIdx, ++buffIdx )
@@ -1420,6 +2759,8 @@ namespace Opm {
         /// \param[in]   iteration   current iteration number
         bool getConvergence(const SimulatorTimerInterface& timer, const int iteration, std::vector<double>& residual_norms)
         {
+            TimerTree::Region region("convergence");
+            OPM_PROFILE_REGION("getConvergence");
             typedef std::vector< Scalar > Vector;
 
             const double dt = timer.currentStepLength();
@@ -1440,50 +2781,96 @@ namespace Opm {
 
             const auto& ebosResid = ebosSimulator_.model().linearizer().residual();
 
-            ElementContext elemCtx(ebosSimulator_);
-            const auto& gridView = ebosSimulator().gridView();
-            const auto& elemEndIt = gridView.template end</*codim=*/0, Dune::Interior_Partition>();
+            // the interior elements are collected once, such that the
+            // elements can be distributed among the threads
+            if (interiorElements_.empty()) {
+                collectElements<Dune::Interior_Partition>(interiorElements_);
+            }
+            const int numElements = interiorElements_.size();
 
-            double pvSumLocal = 0.0;
-            for (auto elemIt = gridView.template begin</*codim=*/0, Dune::Interior_Partition>();
-                 elemIt != elemEndIt;
-                 ++elemIt)
+            // partial sums and maxima of each thread, which are combined in
+            // the order of the threads
+            int numThreads = 1;
+#ifdef _OPENMP
+            numThreads = omp_get_max_threads();
+#endif
+            std::vector< Vector > threadR_sum(numThreads, R_sum);
+            std::vector< Vector > threadB_avg(numThreads, B_avg);
+            std::vector< Vector > threadMaxCoeff(numThreads, maxCoeff);
+            std::vector< double > threadPvSum(numThreads, 0.0);
+
+            std::exception_ptr error;
+#pragma omp parallel
             {
-                const auto& elem = *elemIt;
-                elemCtx.updatePrimaryStencil(elem);
-                elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
-                const unsigned cell_idx = elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0);
-                const auto& intQuants = elemCtx.intensiveQuantities(/*spaceIdx=*/0, /*timeIdx=*/0);
-                const auto& fs = intQuants.fluidState();
+                int thread = 0;
+#ifdef _OPENMP
+                thread = omp_get_thread_num();
+#endif
+                Vector& localR_sum = threadR_sum[thread];
+                Vector& localB_avg = threadB_avg[thread];
+                Vector& localMaxCoeff = threadMaxCoeff[thread];
+                double& localPvSum = threadPvSum[thread];
+
+                ElementContext elemCtx(ebosSimulator_);
+#pragma omp for schedule(static)
+                for (int elemIdx = 0; elemIdx < numElements; ++elemIdx)
+                {
+                    try {
+                        const auto& elem = interiorElements_[elemIdx];
+                        elemCtx.updatePrimaryStencil(elem);
+                        elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+                        const unsigned cell_idx = elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0);
+                        const auto& intQuants = elemCtx.intensiveQuantities(/*spaceIdx=*/0, /*timeIdx=*/0);
+                        const auto& fs = intQuants.fluidState();
 
-                const double pvValue = ebosProblem.porosity(cell_idx) * ebosModel.dofTotalVolume( cell_idx );
-                pvSumLocal += pvValue;
+                        const double pvValue = ebosProblem.porosity(cell_idx) * ebosModel.dofTotalVolume( cell_idx );
+                        localPvSum += pvValue;
 
-                for ( int phaseIdx = 0; phaseIdx < np; ++phaseIdx )
-                {
-                    const int ebosPhaseIdx = flowPhaseToEbosPhaseIdx(phaseIdx);
-                    const int ebosCompIdx = flowPhaseToEbosCompIdx(phaseIdx);
+                        for ( int phaseIdx = 0; phaseIdx < np; ++phaseIdx )
+                        {
+                            const int ebosPhaseIdx = flowPhaseToEbosPhaseIdx(phaseIdx);
+                            const int ebosCompIdx = flowPhaseToEbosCompIdx(phaseIdx);
 
-                    B_avg[ phaseIdx ] += 1.0 / fs.invB(ebosPhaseIdx).value();
-                    const auto R2 = ebosResid[cell_idx][ebosCompIdx];
+                            localB_avg[ phaseIdx ] += 1.0 / fs.invB(ebosPhaseIdx).value();
+                            const auto R2 = ebosResid[cell_idx][ebosCompIdx];
 
-                    R_sum[ phaseIdx ] += R2;
-                    maxCoeff[ phaseIdx ] = std::max( maxCoeff[ phaseIdx ], std::abs( R2 ) / pvValue );
-                }
+                            localR_sum[ phaseIdx ] += R2;
+                            localMaxCoeff[ phaseIdx ] = std::max( localMaxCoeff[ phaseIdx ], std::abs( R2 ) / pvValue );
+                        }
 
-                if ( has_solvent_ ) {
-                    B_avg[ contiSolventEqIdx ] += 1.0 / intQuants.solventInverseFormationVolumeFactor().value();
-                    const auto R2 = ebosResid[cell_idx][contiSolventEqIdx];
-                    R_sum[ contiSolventEqIdx ] += R2;
-                    maxCoeff[ contiSolventEqIdx ] = std::max( maxCoeff[ contiSolventEqIdx ], std::abs( R2 ) / pvValue );
-                }
-                if (has_polymer_ ) {
-                    B_avg[ contiPolymerEqIdx ] += 1.0 / fs.invB(FluidSystem::waterPhaseIdx).value();
-                    const auto R2 = ebosResid[cell_idx][contiPolymerEqIdx];
-                    R_sum[ contiPolymerEqIdx ] += R2;
-                    maxCoeff[ contiPolymerEqIdx ] = std::max( maxCoeff[ contiPolymerEqIdx ], std::abs( R2 ) / pvValue );
+                        if ( has_solvent_ ) {
+                            localB_avg[ contiSolventEqIdx ] += 1.0 / intQuants.solventInverseFormationVolumeFactor().value();
+                            const auto R2 = ebosResid[cell_idx][contiSolventEqIdx];
+                            localR_sum[ contiSolventEqIdx ] += R2;
+                            localMaxCoeff[ contiSolventEqIdx ] = std::max( localMaxCoeff[ contiSolventEqIdx ], std::abs( R2 ) / pvValue );
+                        }
+                        if (has_polymer_ ) {
+                            localB_avg[ contiPolymerEqIdx ] += 1.0 / fs.invB(FluidSystem::waterPhaseIdx).value();
+                            const auto R2 = ebosResid[cell_idx][contiPolymerEqIdx];
+                            localR_sum[ contiPolymerEqIdx ] += R2;
+                            localMaxCoeff[ contiPolymerEqIdx ] = std::max( localMaxCoeff[ contiPolymerEqIdx ], std::abs( R2 ) / pvValue );
+                        }
+                    }
+                    catch (...) {
+#pragma omp critical
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
                 }
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
 
+            double pvSumLocal = 0.0;
+            for (int thread = 0; thread < numThreads; ++thread) {
+                pvSumLocal += threadPvSum[thread];
+                for (int compIdx = 0; compIdx < numComp; ++compIdx) {
+                    R_sum[ compIdx ] += threadR_sum[thread][ compIdx ];
+                    B_avg[ compIdx ] += threadB_avg[thread][ compIdx ];
+                    maxCoeff[ compIdx ] = std::max( maxCoeff[ compIdx ], threadMaxCoeff[thread][ compIdx ] );
+                }
             }
 
             // compute local average in terms of global number of elements
@@ -1509,6 +2896,7 @@ namespace Opm {
                                                       R_sum, maxCoeff, B_avg, maxNormWell );
 
             Vector CNV(numComp);
+            cnv_scale_.resize(numComp);
             Vector mass_balance_residual(numComp);
             Vector well_flux_residual(numComp);
 
@@ -1519,6 +2907,7 @@ namespace Opm {
             for ( int compIdx = 0; compIdx < numComp; ++compIdx )
             {
                 CNV[compIdx]                    = B_avg[compIdx] * dt * maxCoeff[compIdx];
+                cnv_scale_[compIdx]             = B_avg[compIdx] * dt;
                 mass_balance_residual[compIdx]  = std::abs(B_avg[compIdx]*R_sum[compIdx]) * dt / pvSum;
                 converged_MB                = converged_MB && (mass_balance_residual[compIdx] < tol_mb);
                 converged_CNV               = converged_CNV && (CNV[compIdx] < tol_cnv);
@@ -1643,124 +3032,155 @@ namespace Opm {
             int ntFip = *std::max_element(fipnum.begin(), fipnum.end());
             ntFip = comm.max(ntFip);
 
-            std::vector<double> tpv(ntFip, 0.0);
-            std::vector<double> hcpv(ntFip, 0.0);
-
-            std::vector<std::vector<double> > regionValues(ntFip, std::vector<double>(FIPDataType::fipValues,0.0));
-
             for (int i = 0; i<FIPDataType::fipValues; i++) {
                 fip_.fip[i].resize(nc,0.0);
             }
+            // the pore volume weighted pressure of each cell, for the regions
+            // without hydrocarbons
+            std::vector<double> pvPressure(nc, 0.0);
+
+            // the sums of each region are the FIP values followed by the
+            // hydrocarbon pore volume and the pore volume and hydrocarbon pore
+            // volume weighted pressures, all accumulated in a single pass by
+            // each thread and combined in the order of the threads
+            enum { HCPV = FIPDataType::fipValues, PV_PRESSURE, HCPV_PRESSURE, NumSums };
+            const int numSums = NumSums;
+
+            if (interiorElements_.empty()) {
+                collectElements<Dune::Interior_Partition>(interiorElements_);
+            }
+            const int numElements = interiorElements_.size();
 
-            ElementContext elemCtx(ebosSimulator_);
-            const auto& elemEndIt = gridView.template end</*codim=*/0, Dune::Interior_Partition>();
-            for (auto elemIt = gridView.template begin</*codim=*/0, Dune::Interior_Partition>();
-                 elemIt != elemEndIt;
-                 ++elemIt)
+            int numThreads = 1;
+#ifdef _OPENMP
+            numThreads = omp_get_max_threads();
+#endif
+            std::vector<std::vector<double> > threadSums(numThreads);
+            // the cell of each element attributed to a region, -1 otherwise
+            std::vector<int> elementCells(numElements, -1);
+
+            std::exception_ptr error;
+#pragma omp parallel
             {
-                elemCtx.updatePrimaryStencil(*elemIt);
-                elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+                int thread = 0;
+#ifdef _OPENMP
+                thread = omp_get_thread_num();
+#endif
+                std::vector<double>& sums = threadSums[thread];
+                sums.assign(ntFip * numSums, 0.0);
 
-                const unsigned cellIdx = elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0);
-                const auto& intQuants = elemCtx.intensiveQuantities(/*spaceIdx=*/0, /*timeIdx=*/0);
-                const auto& fs = intQuants.fluidState();
+                ElementContext elemCtx(ebosSimulator_);
+#pragma omp for schedule(static)
+                for (int elemIdx = 0; elemIdx < numElements; ++elemIdx)
+                {
+                    try {
+                        elemCtx.updatePrimaryStencil(interiorElements_[elemIdx]);
 
-                const int regionIdx = fipnum[cellIdx] - 1;
-                if (regionIdx < 0) {
-                    // the given cell is not attributed to any region
-                    continue;
-                }
+                        const unsigned cellIdx = elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0);
+                        const int regionIdx = fipnum[cellIdx] - 1;
+                        if (regionIdx < 0) {
+                            // the given cell is not attributed to any region
+                            continue;
+                        }
+                        elementCells[elemIdx] = cellIdx;
+
+                        elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+                        const auto& intQuants = elemCtx.intensiveQuantities(/*spaceIdx=*/0, /*timeIdx=*/0);
+                        const auto& fs = intQuants.fluidState();
+                        double* regionSums = &sums[regionIdx * numSums];
+
+                        // calculate the pore volume of the current cell. Note that the porosity
+                        // returned by the intensive quantities is defined as the ratio of pore
+                        // space to total cell volume and includes all pressure dependent (->
+                        // rock compressibility) and static modifiers (MULTPV, MULTREGP, NTG,
+                        // PORV, MINPV and friends). Also note that because of this, the porosity
+                        // returned by the intensive quantities can be outside of the physical
+                        // range [0, 1] in pathetic cases.
+                        const double pv =
+                            ebosSimulator_.model().dofTotalVolume(cellIdx)
+                            * intQuants.porosity().value();
+
+                        for (int phase = 0; phase < maxnp; ++phase) {
+                            const double b = fs.invB(flowPhaseToEbosPhaseIdx(phase)).value();
+                            const double s = fs.saturation(flowPhaseToEbosPhaseIdx(phase)).value();
+
+                            fip_.fip[phase][cellIdx] = b * s * pv;
+
+                            if (active_[ phase ]) {
+                                regionSums[phase] += fip_.fip[phase][cellIdx];
+                            }
+                        }
 
-                // calculate the pore volume of the current cell. Note that the porosity
-                // returned by the intensive quantities is defined as the ratio of pore
-                // space to total cell volume and includes all pressure dependent (->
-                // rock compressibility) and static modifiers (MULTPV, MULTREGP, NTG,
-                // PORV, MINPV and friends). Also note that because of this, the porosity
-                // returned by the intensive quantities can be outside of the physical
-                // range [0, 1] in pathetic cases.
-                const double pv =
-                    ebosSimulator_.model().dofTotalVolume(cellIdx)
-                    * intQuants.porosity().value();
+                        if (active_[ Oil ] && active_[ Gas ]) {
+                            // Account for gas dissolved in oil and vaporized oil
+                            fip_.fip[FIPDataType::FIP_DISSOLVED_GAS][cellIdx] = fs.Rs().value() * fip_.fip[FIPDataType::FIP_LIQUID][cellIdx];
+                            fip_.fip[FIPDataType::FIP_VAPORIZED_OIL][cellIdx] = fs.Rv().value() * fip_.fip[FIPDataType::FIP_VAPOUR][cellIdx];
+
+                            regionSums[FIPData::FIP_DISSOLVED_GAS] += fip_.fip[FIPData::FIP_DISSOLVED_GAS][cellIdx];
+                            regionSums[FIPData::FIP_VAPORIZED_OIL] += fip_.fip[FIPData::FIP_VAPORIZED_OIL][cellIdx];
+                        }
 
-                for (int phase = 0; phase < maxnp; ++phase) {
-                    const double b = fs.invB(flowPhaseToEbosPhaseIdx(phase)).value();
-                    const double s = fs.saturation(flowPhaseToEbosPhaseIdx(phase)).value();
+                        const double hydrocarbon = fs.saturation(FluidSystem::oilPhaseIdx).value() + fs.saturation(FluidSystem::gasPhaseIdx).value();
+                        const double pressure = fs.pressure(FluidSystem::oilPhaseIdx).value();
 
-                    fip_.fip[phase][cellIdx] = b * s * pv;
+                        fip_.fip[FIPDataType::FIP_PV][cellIdx] = pv;
+                        // divided by the region sums below
+                        fip_.fip[FIPDataType::FIP_WEIGHTED_PRESSURE][cellIdx] = pv * pressure * hydrocarbon;
+                        pvPressure[cellIdx] = pv * pressure;
 
-                    if (active_[ phase ]) {
-                        regionValues[regionIdx][phase] += fip_.fip[phase][cellIdx];
+                        regionSums[FIPDataType::FIP_PV] += pv;
+                        regionSums[HCPV] += pv * hydrocarbon;
+                        regionSums[PV_PRESSURE] += pvPressure[cellIdx];
+                        regionSums[HCPV_PRESSURE] += fip_.fip[FIPDataType::FIP_WEIGHTED_PRESSURE][cellIdx];
+                    }
+                    catch (...) {
+#pragma omp critical
+                        if (!error) {
+                            error = std::current_exception();
+                        }
                     }
                 }
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
 
-                if (active_[ Oil ] && active_[ Gas ]) {
-                    // Account for gas dissolved in oil and vaporized oil
-                    fip_.fip[FIPDataType::FIP_DISSOLVED_GAS][cellIdx] = fs.Rs().value() * fip_.fip[FIPDataType::FIP_LIQUID][cellIdx];
-                    fip_.fip[FIPDataType::FIP_VAPORIZED_OIL][cellIdx] = fs.Rv().value() * fip_.fip[FIPDataType::FIP_VAPOUR][cellIdx];
-
-                    regionValues[regionIdx][FIPData::FIP_DISSOLVED_GAS] += fip_.fip[FIPData::FIP_DISSOLVED_GAS][cellIdx];
-                    regionValues[regionIdx][FIPData::FIP_VAPORIZED_OIL] += fip_.fip[FIPData::FIP_VAPORIZED_OIL][cellIdx];
+            // combine the threads and sum over all processes at once
+            std::vector<double> sums(ntFip * numSums, 0.0);
+            for (int thread = 0; thread < numThreads; ++thread) {
+                const std::vector<double>& localSums = threadSums[thread];
+                for (std::size_t i = 0; i < localSums.size(); ++i) {
+                    sums[i] += localSums[i];
                 }
-
-                const double hydrocarbon = fs.saturation(FluidSystem::oilPhaseIdx).value() + fs.saturation(FluidSystem::gasPhaseIdx).value();
-
-                tpv[regionIdx] += pv;
-                hcpv[regionIdx] += pv * hydrocarbon;
             }
+            comm.sum(sums.data(), sums.size());
 
-            // sum tpv (-> total pore volume of the regions) and hcpv (-> pore volume of the
-            // the regions that is occupied by hydrocarbons)
-            comm.sum(tpv.data(), tpv.size());
-            comm.sum(hcpv.data(), hcpv.size());
-
-            for (auto elemIt = gridView.template begin</*codim=*/0, Dune::Interior_Partition>();
-                 elemIt != elemEndIt;
-                 ++elemIt)
-            {
-                const auto& elem = *elemIt;
-
-                elemCtx.updatePrimaryStencil(elem);
-                elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+            //Compute hydrocarbon pore volume weighted average pressure.
+            //If we have no hydrocarbon in region, use pore volume weighted average pressure instead
+            std::vector<std::vector<double> > regionValues(ntFip, std::vector<double>(FIPDataType::fipValues,0.0));
+            for (int regionIdx = 0; regionIdx < ntFip; ++regionIdx) {
+                const double* regionSums = &sums[regionIdx * numSums];
+                std::copy(regionSums, regionSums + FIPDataType::fipValues, regionValues[regionIdx].begin());
+                const double hcpv = regionSums[HCPV];
+                const double tpv = regionSums[FIPDataType::FIP_PV];
+                regionValues[regionIdx][FIPDataType::FIP_WEIGHTED_PRESSURE] =
+                    hcpv > 1e-10 ? regionSums[HCPV_PRESSURE] / hcpv : regionSums[PV_PRESSURE] / tpv;
+            }
 
-                unsigned cellIdx = elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0);
-                const int regionIdx = fipnum[cellIdx] - 1;
-                if (regionIdx < 0) {
-                    // the cell is not attributed to any region. ignore it!
+#pragma omp parallel for schedule(static)
+            for (int elemIdx = 0; elemIdx < numElements; ++elemIdx) {
+                const int cellIdx = elementCells[elemIdx];
+                if (cellIdx < 0) {
                     continue;
                 }
-
-                const auto& intQuants = elemCtx.intensiveQuantities(/*spaceIdx=*/0, /*timeIdx=*/0);
-                const auto& fs = intQuants.fluidState();
-
-                // calculate the pore volume of the current cell. Note that the
-                // porosity returned by the intensive quantities is defined as the
-                // ratio of pore space to total cell volume and includes all pressure
-                // dependent (-> rock compressibility) and static modifiers (MULTPV,
-                // MULTREGP, NTG, PORV, MINPV and friends). Also note that because of
-                // this, the porosity returned by the intensive quantities can be
-                // outside of the physical range [0, 1] in pathetic cases.
-                const double pv =
-                    ebosSimulator_.model().dofTotalVolume(cellIdx)
-                    * intQuants.porosity().value();
-
-                fip_.fip[FIPDataType::FIP_PV][cellIdx] = pv;
-                const double hydrocarbon = fs.saturation(FluidSystem::oilPhaseIdx).value() + fs.saturation(FluidSystem::gasPhaseIdx).value();
-
-                //Compute hydrocarbon pore volume weighted average pressure.
-                //If we have no hydrocarbon in region, use pore volume weighted average pressure instead
-                if (hcpv[regionIdx] > 1e-10) {
-                    fip_.fip[FIPDataType::FIP_WEIGHTED_PRESSURE][cellIdx] = pv * fs.pressure(FluidSystem::oilPhaseIdx).value() * hydrocarbon / hcpv[regionIdx];
+                const int regionIdx = fipnum[cellIdx] - 1;
+                const double hcpv = sums[regionIdx * numSums + HCPV];
+                double& weightedPressure = fip_.fip[FIPDataType::FIP_WEIGHTED_PRESSURE][cellIdx];
+                if (hcpv > 1e-10) {
+                    weightedPressure /= hcpv;
                 } else {
-                    fip_.fip[FIPDataType::FIP_WEIGHTED_PRESSURE][cellIdx] = pv * fs.pressure(FluidSystem::oilPhaseIdx).value() / tpv[regionIdx];
+                    weightedPressure = pvPressure[cellIdx] / sums[regionIdx * numSums + FIPDataType::FIP_PV];
                 }
-
-                regionValues[regionIdx][FIPDataType::FIP_PV] += fip_.fip[FIPDataType::FIP_PV][cellIdx];
-                regionValues[regionIdx][FIPDataType::FIP_WEIGHTED_PRESSURE] += fip_.fip[FIPDataType::FIP_WEIGHTED_PRESSURE][cellIdx];
-            }
-
-            // sum the results over all processes
-            for(int regionIdx=0; regionIdx < ntFip; ++regionIdx) {
-                comm.sum(regionValues[regionIdx].data(), regionValues[regionIdx].size());
             }
 
             return regionValues;
@@ -2050,6 +3470,12 @@ namespace Opm {
             return fip_;
         }
 
+        /// Number of cells which switched their primary variables in the
+        /// last update of the state.
+        int primaryVariableSwitches() const {
+            return primaryVariableSwitches_;
+        }
+
         const Simulator& ebosSimulator() const
         { return ebosSimulator_; }
 
@@ -2080,14 +3506,16 @@ namespace Opm {
         const std::vector<int>          cells_;  // All grid cells
         const bool has_disgas_;
         const bool has_vapoil_;
-        const bool has_solvent_;
-        const bool has_polymer_;
+        // the solvent and polymer variants are separate instantiations of
+        // the model, the branches on them are removed at compile time
+        static const bool has_solvent_ = GET_PROP_VALUE(TypeTag, EnableSolvent);
+        static const bool has_polymer_ = GET_PROP_VALUE(TypeTag, EnablePolymer);
 
         ModelParameters                 param_;
         SimulatorReport failureReport_;
 
         // Well Model
-        StandardWellsDense<TypeTag> well_model_;
+        WellModel well_model_;
 
         /// \brief Whether we print something to std::cout
         bool terminal_output_;
@@ -2098,15 +3526,124 @@ namespace Opm {
         RateConverterType rate_converter_;
 
         std::vector<std::vector<double>> residual_norms_history_;
+        int linear_failures_;
+        // the number of linear solves of the run, numbers the dumped systems
+        mutable int linear_solves_;
+        // the linear iterations of the solves before the last one of
+        // float_jacobian_operator, and its single precision Jacobian
+        mutable int refinement_iterations_;
+        mutable FloatMat floatJacobian_;
+        // the inexact Newton forcing term of the last iteration
+        double forcing_term_;
+        // the number of consecutive iterations that reused the preconditioner
+        int preconditioner_reuses_;
         double current_relaxation_;
         BVector dx_old_;
+        // whether the primary variables of ebos were updated since the
+        // reservoir state was last filled from them, with update_ebos_directly
+        bool reservoir_state_outdated_;
+        // the time spent in the assembly of the well equations
+        double well_assembly_time_;
+
+        // the state before the last Newton update, the update and the
+        // largest residual norm before it, for the line search
+        std::unique_ptr<ReservoirState> line_search_reservoir_state_;
+        std::unique_ptr<WellState> line_search_well_state_;
+        SolutionVector line_search_solution_;
+        BVector line_search_dx_;
+        BVector line_search_dxw_;
+        double line_search_residual_;
+
+        // the Newton update of the cells and wells, kept between the Newton
+        // iterations such that the vectors are only reallocated when the
+        // number of wells grows
+        struct LinearSolveWorkspace
+        {
+            BVector dx;
+            BVector dxw;
+
+            void resize(const int nc, const int nw)
+            {
+                if (static_cast<int>(dx.size()) != nc) {
+                    dx.resize(nc, false);
+                }
+                if (static_cast<int>(dxw.size()) != nw) {
+                    dxw.resize(nw, false);
+                }
+            }
+        };
+        LinearSolveWorkspace workspace_;
+
+        // the initial state of the current time step and of the last accepted
+        // step, with its length and report step, for the time step predictor
+        std::unique_ptr<ReservoirState> predictor_step_start_;
+        std::unique_ptr<ReservoirState> predictor_previous_state_;
+        double predictor_previous_step_length_;
+        int predictor_report_step_;
         mutable FIPDataType fip_;
 
+        // the elements of the grid, collected once for the threaded loops
+        std::vector<Element> allElements_;
+        std::vector<Element> interiorElements_;
+
+        // number of cells which switched their primary variables in the
+        // last call of updateState()
+        int primaryVariableSwitches_;
+
+        // the solution before the last update of the primary variables, to
+        // find the cells whose cached intensive quantities remain valid
+        SolutionVector previous_solution_;
+
+        // the subdomains of the nonlinear domain decomposition and their
+        // matrices, created on first use
+        std::unique_ptr<SubdomainPartition> subdomains_;
+
+        // the thread assembling the wells during the linearization
+        std::unique_ptr<ThreadHandle> wellAssemblyThread_;
+
+        // the interior elements of each color of the colored linearization
+        std::vector< std::vector<int> > element_colors_;
+        std::vector<Mat> subdomainMatrices_;
+        std::vector<char> interiorCells_;
+        // the scaling B_avg dt of the CNV norms of the last getConvergence()
+        std::vector<double> cnv_scale_;
+
+        // the estimated CFL numbers of the cells and whether they are treated
+        // as implicit in the pressure only, if aim_cfl_limit is set
+        std::vector<double> aim_ratios_;
+        std::vector<char> aim_explicit_cells_;
+
+        template <Dune::PartitionIteratorType partition>
+        void collectElements(std::vector<Element>& elements) const
+        {
+            const auto& gridView = ebosSimulator_.gridView();
+            const auto& elemEndIt = gridView.template end</*codim=*/0, partition>();
+            for (auto elemIt = gridView.template begin</*codim=*/0, partition>();
+                 elemIt != elemEndIt;
+                 ++elemIt)
+            {
+                elements.push_back(*elemIt);
+            }
+        }
+        // per cell scaling of the equations from the ebos to the flow format
+        mutable BVector rowScaling_;
+
+        // trace of the Newton iteration timings, owned by the simulator
+        PerformanceTrace* performanceTrace_;
+
+        // the adjoint gradients, owned by the simulator, and the converged
+        // step which is added when the step is accepted
+        Adjoint* adjoint_;
+        std::unique_ptr<typename Adjoint::Step> adjoint_step_;
+
+        // whether the memory usage has been logged after the first linear solve
+        bool memoryUsageReported_;
+
     public:
         /// return the StandardWells object
-        StandardWellsDense<TypeTag>&
+        WellModel&
         wellModel() { return well_model_; }
-        const StandardWellsDense<TypeTag>&
+        const WellModel&
         wellModel() const { return well_model_; }
 
         /// return the Well struct in the StandardWells
@@ -2341,82 +3878,102 @@ namespace Opm {
     private:
         void convertResults(BVector& ebosResid, Mat& ebosJac) const
         {
-            const Opm::PhaseUsage pu = phaseUsage_;
-            const int numFlowPhases = pu.num_phases;
             const int numCells = ebosJac.N();
             assert( numCells == static_cast<int>(ebosJac.M()) );
 
-            // write the right-hand-side values from the ebosJac into the objects
-            // allocated above.
+            if( static_cast<int>(rowScaling_.size()) != numCells ) {
+                updateRowScaling( numCells );
+            }
+
+            // translate the residual and the Jacobian of the residual from the
+            // format used by ebos to the one expected by flow. This is a pure
+            // row scaling, so both are handled in a single pass.
             const auto endrow = ebosJac.end();
-            for( int cellIdx = 0; cellIdx < numCells; ++cellIdx )
+            for( auto row = ebosJac.begin(); row != endrow; ++row )
             {
-                const double cellVolume = ebosSimulator_.model().dofTotalVolume(cellIdx);
-                auto& cellRes = ebosResid[ cellIdx ];
+                const int rowIdx = row.index();
+                const VectorBlockType& scale = rowScaling_[ rowIdx ];
 
-                unsigned pvtRegionIdx = ebosSimulator_.problem().pvtRegionIndex(cellIdx);
+                auto& cellRes = ebosResid[ rowIdx ];
+                for( int eqIdx = 0; eqIdx < numEq; ++eqIdx ) {
+                    cellRes[ eqIdx ] *= scale[ eqIdx ];
+                }
 
-                for( int flowPhaseIdx = 0; flowPhaseIdx < numFlowPhases; ++flowPhaseIdx )
+                const auto endcol = row->end();
+                for( auto col = row->begin(); col != endcol; ++col )
                 {
-                    const int canonicalFlowPhaseIdx = pu.phase_pos[flowPhaseIdx];
-                    const int ebosPhaseIdx = flowPhaseToEbosPhaseIdx(canonicalFlowPhaseIdx);
-                    const double refDens = FluidSystem::referenceDensity(ebosPhaseIdx, pvtRegionIdx);
-                    cellRes[ flowPhaseToEbosCompIdx( flowPhaseIdx ) ] /= refDens;
-                    cellRes[ flowPhaseToEbosCompIdx( flowPhaseIdx ) ] *= cellVolume;
-                }
-                if (has_solvent_) {
-                    // no need to store refDens for all cells?
-                    const auto& intQuants = ebosSimulator_.model().cachedIntensiveQuantities(cellIdx, /*timeIdx=*/0);
-                    const auto& refDens = intQuants->solventRefDensity();
-                    cellRes[ contiSolventEqIdx ] /= refDens;
-                    cellRes[ contiSolventEqIdx ] *= cellVolume;
+                    for( int eqIdx = 0; eqIdx < numEq; ++eqIdx ) {
+                        (*col)[ eqIdx ] *= scale[ eqIdx ];
+                    }
                 }
-                if (has_polymer_) {
-                    cellRes[ contiPolymerEqIdx ] *= cellVolume;
+            }
+        }
+
+        /// As convertResults() for the residual only, leaving the Jacobian in
+        /// the ebos format, for evaluations whose Jacobian is not used.
+        void convertResiduals(BVector& ebosResid) const
+        {
+            const int numCells = ebosResid.size();
+            if( static_cast<int>(rowScaling_.size()) != numCells ) {
+                updateRowScaling( numCells );
+            }
+
+            for( int cellIdx = 0; cellIdx < numCells; ++cellIdx )
+            {
+                const VectorBlockType& scale = rowScaling_[ cellIdx ];
+                auto& cellRes = ebosResid[ cellIdx ];
+                for( int eqIdx = 0; eqIdx < numEq; ++eqIdx ) {
+                    cellRes[ eqIdx ] *= scale[ eqIdx ];
                 }
             }
+        }
 
-            for( auto row = ebosJac.begin(); row != endrow; ++row )
+        /// Compute the factors which scale the equations from the ebos format
+        /// (mass per bulk volume) to the flow format (surface volume). They only
+        /// depend on the cell volumes and the reference densities and are
+        /// therefore computed once. The inverse reference densities are
+        /// tabulated per PVT region, so the cells only multiply by their volume.
+        void updateRowScaling( const int numCells ) const
+        {
+            const Opm::PhaseUsage pu = phaseUsage_;
+            const int numFlowPhases = pu.num_phases;
+
+            // inverse reference densities of the PVT regions, filled at the
+            // first cell of each region
+            std::vector< VectorBlockType > regionScaling;
+            std::vector< bool > regionDone;
+
+            rowScaling_.resize( numCells );
+            for( int cellIdx = 0; cellIdx < numCells; ++cellIdx )
             {
-                const int rowIdx = row.index();
-                const double cellVolume = ebosSimulator_.model().dofTotalVolume(rowIdx);
-                unsigned pvtRegionIdx = ebosSimulator_.problem().pvtRegionIndex(rowIdx);
+                const unsigned pvtRegionIdx = ebosSimulator_.problem().pvtRegionIndex(cellIdx);
+                if( pvtRegionIdx >= regionScaling.size() ) {
+                    regionScaling.resize( pvtRegionIdx + 1 );
+                    regionDone.resize( pvtRegionIdx + 1, false );
+                }
 
-                // translate the Jacobian of the residual from the format used by ebos to
-                // the one expected by flow
-                const auto endcol = row->end();
-                for( auto col = row->begin(); col != endcol; ++col )
+                VectorBlockType& regionScale = regionScaling[ pvtRegionIdx ];
+                if( ! regionDone[ pvtRegionIdx ] )
                 {
+                    regionScale = 1.0;
                     for( int flowPhaseIdx = 0; flowPhaseIdx < numFlowPhases; ++flowPhaseIdx )
                     {
                         const int canonicalFlowPhaseIdx = pu.phase_pos[flowPhaseIdx];
                         const int ebosPhaseIdx = flowPhaseToEbosPhaseIdx(canonicalFlowPhaseIdx);
                         const int ebosCompIdx = flowPhaseToEbosCompIdx(canonicalFlowPhaseIdx);
-                        const double refDens = FluidSystem::referenceDensity(ebosPhaseIdx, pvtRegionIdx);
-                        for( int pvIdx = 0; pvIdx < numEq; ++pvIdx )
-                        {
-                            (*col)[ebosCompIdx][flowToEbosPvIdx(pvIdx)] /= refDens;
-                            (*col)[ebosCompIdx][flowToEbosPvIdx(pvIdx)] *= cellVolume;
-                        }
+                        regionScale[ ebosCompIdx ] = 1.0 / FluidSystem::referenceDensity(ebosPhaseIdx, pvtRegionIdx);
                     }
                     if (has_solvent_) {
-                        // TODO store refDens pr pvtRegion?
-                        const auto& intQuants = ebosSimulator_.model().cachedIntensiveQuantities(rowIdx, /*timeIdx=*/0);
-                        const auto& refDens = intQuants->solventRefDensity();
-                        for( int pvIdx=0; pvIdx < numEq; ++pvIdx )
-                        {
-                            (*col)[contiSolventEqIdx][flowToEbosPvIdx(pvIdx)] /= refDens;
-                            (*col)[contiSolventEqIdx][flowToEbosPvIdx(pvIdx)] *= cellVolume;
-                        }
-                    }
-                    if (has_polymer_) {
-                        for( int pvIdx=0; pvIdx < numEq; ++pvIdx )
-                        {
-                            (*col)[contiPolymerEqIdx][flowToEbosPvIdx(pvIdx)] *= cellVolume;
-                        }
+                        const auto& intQuants = ebosSimulator_.model().cachedIntensiveQuantities(cellIdx, /*timeIdx=*/0);
+                        assert( intQuants );
+                        regionScale[ contiSolventEqIdx ] = 1.0 / intQuants->solventRefDensity();
                     }
-
+                    regionDone[ pvtRegionIdx ] = true;
                 }
+
+                VectorBlockType& scale = rowScaling_[ cellIdx ];
+                scale = regionScale;
+                scale *= ebosSimulator_.model().dofTotalVolume(cellIdx);
             }
         }
 
@@ -2469,7 +4026,9 @@ namespace Opm {
     private:
         void assembleMassBalanceEq(const SimulatorTimerInterface& timer,
                                    const int iterationIdx,
-                                   const ReservoirState& reservoirState)
+                                   const ReservoirState& reservoirState,
+                                   const std::function<void()>& wellAssembly = std::function<void()>(),
+                                   const bool coloredLinearization = false)
         {
             ebosSimulator_.startNextEpisode( timer.currentStepLength() );
             ebosSimulator_.setEpisodeIndex( timer.reportStepNum() );
@@ -2501,20 +4060,51 @@ namespace Opm {
             // if the last time step failed we need to update the solution varables in ebos
             // and recalculate the IntesiveQuantities. Also pass the solution initially.
             if ( (timer.lastStepFailed() || timer.reportStepNum()==0) && iterationIdx == 0  ) {
+                previous_solution_ = ebosSimulator_.model().solution(/*timeIdx=*/0);
                 convertInput( iterationIdx, reservoirState, ebosSimulator_ );
-                ebosSimulator_.model().invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+                invalidateChangedIntensiveQuantities(previous_solution_);
             }
 
-            ebosSimulator_.problem().beginIteration();
-            ebosSimulator_.model().linearizer().linearize();
-            ebosSimulator_.problem().endIteration();
+            {
+                TimerTree::Region region("reservoir linearization");
+                OPM_PROFILE_REGION("linearize");
+                Dune::Timer assemblyTimer;
+                assemblyTimer.start();
+                ebosSimulator_.problem().beginIteration();
+                if (coloredLinearization) {
+                    linearizeColored(wellAssembly);
+                }
+                else if (wellAssembly) {
+                    linearizeConcurrently(wellAssembly);
+                }
+                else {
+                    ebosSimulator_.model().linearizer().linearize();
+                }
+                ebosSimulator_.problem().endIteration();
+                recordTrace(PerformanceTrace::Assembly, assemblyTimer.stop());
+            }
+
+            if (param_.colored_linearization_ && element_colors_.empty()) {
+                colorElements();
+            }
 
             prevEpisodeIdx = ebosSimulator_.episodeIndex();
 
             auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
             auto& ebosResid = ebosSimulator_.model().linearizer().residual();
             //Dune::printmatrix(std::cout, ebosJac, "J ebos", "row");
-            convertResults(ebosResid, ebosJac);
+            // the colored linearization scales the rows in its pass
+            if (!coloredLinearization) {
+                TimerTree::Region region("convert results");
+                OPM_PROFILE_REGION("convertResults");
+                Dune::Timer convertTimer;
+                convertTimer.start();
+                convertResults(ebosResid, ebosJac);
+                recordTrace(PerformanceTrace::ConvertResults, convertTimer.stop());
+            }
+            if (param_.aim_cfl_limit_ > 0.0) {
+                adaptiveImplicitJacobian(ebosJac);
+            }
             //std::cout << " ----------------------------------------------------" << std::endl<< std::endl<< std::endl;
             //Dune::printmatrix(std::cout, ebosJac, "J flow", "row");
             //std::cout << " ----------------------------------------------------" << std::endl<< std::endl<< std::endl;
@@ -2527,6 +4117,246 @@ namespace Opm {
             A = ebosJacConst;
         }
 
+        // the assembly of the wells on the well assembly thread, with its
+        // own number of OpenMP threads
+        struct WellAssemblyCall
+        {
+            std::function<void()> assemble;
+            int numThreads;
+
+            void run()
+            {
+#ifdef _OPENMP
+                omp_set_num_threads(numThreads);
+#endif
+                assemble();
+            }
+        };
+
+        /// Linearize the reservoir while the wells are assembled on a separate
+        /// thread with concurrent_well_assembly_threads OpenMP threads, the
+        /// linearization uses the remaining ones. The wells only read the
+        /// intensive quantities of the perforated cells, which are therefore
+        /// computed and cached first, the linearization takes them from the
+        /// cache.
+        void linearizeConcurrently(const std::function<void()>& wellAssembly)
+        {
+            cachePerforatedCellIntensiveQuantities();
+
+            if (!wellAssemblyThread_) {
+                wellAssemblyThread_.reset(new ThreadHandle(true, 1, 1));
+            }
+            const int wellThreads = param_.concurrent_well_assembly_threads_;
+            wellAssemblyThread_->dispatch(WellAssemblyCall{ wellAssembly, wellThreads });
+
+#ifdef _OPENMP
+            const int numThreads = omp_get_max_threads();
+            omp_set_num_threads(std::max(1, numThreads - wellThreads));
+#endif
+            std::exception_ptr error;
+            try {
+                ebosSimulator_.model().linearizer().linearize();
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+#ifdef _OPENMP
+            omp_set_num_threads(numThreads);
+#endif
+
+            // the well assembly refers to the variables of the caller, it has
+            // to be finished before an error of the linearization is rethrown
+            try {
+                wellAssemblyThread_->wait();
+            }
+            catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        /// Linearize the reservoir by a threaded pass over the elements of
+        /// each color, see distanceTwoColoring(). The elements of one color
+        /// write disjoint blocks of the Jacobian and the residual of ebos, and
+        /// disjoint entries of its cache of intensive quantities, so no locks
+        /// are needed. The rows are scaled to the flow format in the same
+        /// pass, and the perforation contributions of the wells are subtracted
+        /// from the rows of their cells, the wells being assembled before by
+        /// wellAssembly if given.
+        void linearizeColored(const std::function<void()>& wellAssembly)
+        {
+            const bool addWells = bool(wellAssembly);
+            if (addWells) {
+                cachePerforatedCellIntensiveQuantities();
+                wellAssembly();
+            }
+
+            auto& ebosJac = ebosSimulator_.model().linearizer().matrix();
+            auto& ebosResid = ebosSimulator_.model().linearizer().residual();
+            ebosJac = 0.0;
+            ebosResid = 0.0;
+            const int numCells = ebosJac.N();
+            if( static_cast<int>(rowScaling_.size()) != numCells ) {
+                updateRowScaling( numCells );
+            }
+
+            std::exception_ptr error;
+#pragma omp parallel
+            {
+                int thread = 0;
+#ifdef _OPENMP
+                thread = omp_get_thread_num();
+#endif
+                ElementContext elemCtx( ebosSimulator_ );
+                auto& localLinearizer = ebosSimulator_.model().localLinearizer(thread);
+                for (const auto& elements : element_colors_) {
+                    const int numElements = elements.size();
+                    // the implicit barrier separates the colors
+#pragma omp for schedule(static)
+                    for (int i = 0; i < numElements; ++i) {
+                        try {
+                            localLinearizer.linearize(elemCtx, allElements_[elements[i]]);
+
+                            // the element adds the derivatives of the residuals of
+                            // its stencil with respect to its own primary variables
+                            const int numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+                            const int numDof = elemCtx.numDof(/*timeIdx=*/0);
+                            for (int primaryDofIdx = 0; primaryDofIdx < numPrimaryDof; ++primaryDofIdx) {
+                                const unsigned globI = elemCtx.globalSpaceIndex(/*spaceIdx=*/primaryDofIdx, /*timeIdx=*/0);
+                                const auto& residual = localLinearizer.residual(primaryDofIdx);
+                                const VectorBlockType& scaleI = rowScaling_[globI];
+                                for (int eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+                                    ebosResid[globI][eqIdx] += scaleI[eqIdx] * residual[eqIdx];
+                                }
+                                for (int dofIdx = 0; dofIdx < numDof; ++dofIdx) {
+                                    const unsigned globJ = elemCtx.globalSpaceIndex(/*spaceIdx=*/dofIdx, /*timeIdx=*/0);
+                                    const auto& jacobian = localLinearizer.jacobian(dofIdx, primaryDofIdx);
+                                    const VectorBlockType& scaleJ = rowScaling_[globJ];
+                                    auto& block = ebosJac[globJ][globI];
+                                    for (int eqIdx = 0; eqIdx < numEq; ++eqIdx) {
+                                        for (int pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                                            block[eqIdx][pvIdx] += scaleJ[eqIdx] * jacobian[eqIdx][pvIdx];
+                                        }
+                                    }
+                                }
+                                if (addWells) {
+                                    wellModel().subtractPerforationContributions(globI, ebosResid[globI], ebosJac[globI][globI]);
+                                }
+                            }
+                        }
+                        catch (...) {
+#pragma omp critical
+                            if (!error) {
+                                error = std::current_exception();
+                            }
+                        }
+                    }
+                }
+            }
+
+            // all processes fail together, like in the linearizer of ebos
+            const int succeeded = ebosSimulator_.gridView().comm().min(error ? 0 : 1);
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            if (!succeeded) {
+                OPM_THROW(Opm::NumericalProblem, "A process did not succeed in linearizing the system");
+            }
+        }
+
+        /// Color the interior elements for linearizeColored() by the pattern
+        /// of the Jacobian of ebos.
+        void colorElements()
+        {
+            if (allElements_.empty()) {
+                collectElements<Dune::All_Partition>(allElements_);
+            }
+            // the elements are collected in the order of the cells
+            std::vector<int> interior;
+            const int numElements = allElements_.size();
+            for (int elemIdx = 0; elemIdx < numElements; ++elemIdx) {
+                if (allElements_[elemIdx].partitionType() == Dune::InteriorEntity) {
+                    interior.push_back(elemIdx);
+                }
+            }
+            element_colors_ = distanceTwoColoring(ebosSimulator_.model().linearizer().matrix(), interior);
+        }
+
+        /// Compute the intensive quantities of the perforated cells and store
+        /// them in the cache of ebos.
+        void cachePerforatedCellIntensiveQuantities()
+        {
+            if (allElements_.empty()) {
+                collectElements<Dune::All_Partition>(allElements_);
+            }
+            const auto& cells = wellModel().perforatedCells();
+            const int numCells = cells.size();
+
+            std::exception_ptr error;
+#pragma omp parallel
+            {
+                ElementContext elemCtx( ebosSimulator_ );
+#pragma omp for schedule(static)
+                for (int i = 0; i < numCells; ++i) {
+                    try {
+                        // the elements are collected in the order of the cells
+                        elemCtx.updatePrimaryStencil(allElements_[cells[i]]);
+                        assert(int(elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0)) == cells[i]);
+                        elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+                    }
+                    catch (...) {
+#pragma omp critical
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
+                }
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        /// Remove the flux derivatives with respect to the non-pressure
+        /// primary variables of the cells without wells whose CFL number is
+        /// below aim_cfl_limit from the Jacobian. The residual is not changed,
+        /// so the solution is the fully implicit one.
+        void adaptiveImplicitJacobian(Mat& ebosJac)
+        {
+            const int pressureIdx = BlackoilIndices::pressureSwitchIdx;
+            throughputRatios(ebosJac, pressureIdx, aim_ratios_);
+
+            const int numCells = aim_ratios_.size();
+            aim_explicit_cells_.resize(numCells);
+            for (int cell_idx = 0; cell_idx < numCells; ++cell_idx) {
+                aim_explicit_cells_[cell_idx] = aim_ratios_[cell_idx] < param_.aim_cfl_limit_;
+            }
+            if (localWellsActive()) {
+                const Wells& w = wells();
+                for (int perf = 0; perf < w.well_connpos[w.number_of_wells]; ++perf) {
+                    aim_explicit_cells_[w.well_cells[perf]] = 0;
+                }
+            }
+            removeExplicitFluxDerivatives(ebosJac, aim_explicit_cells_, pressureIdx);
+
+            if (terminalOutputEnabled()) {
+                OPM_DEBUG_LOG(Newton, "Adaptive implicit Jacobian: "
+                              << std::count(aim_explicit_cells_.begin(), aim_explicit_cells_.end(), 1)
+                              << " of " << numCells << " cells implicit in the pressure only");
+            }
+        }
+
+        void recordTrace(const PerformanceTrace::Phase phase, const double seconds) const
+        {
+            if (performanceTrace_) {
+                performanceTrace_->record(phase, seconds);
+            }
+        }
+
         double dpMaxRel() const { return param_.dp_max_rel_; }
         double dsMax() const { return param_.ds_max_; }
         double drMaxRel() const { return param_.dr_max_rel_; }
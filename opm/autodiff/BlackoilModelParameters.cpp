@@ -20,6 +20,11 @@
 #include <opm/autodiff/BlackoilModelParameters.hpp>
 #include <opm/core/utility/parameters/ParameterGroup.hpp>
 #include <opm/parser/eclipse/Units/Units.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
 
 namespace Opm
 {
@@ -54,8 +59,62 @@ namespace Opm
                 param.getDefault("max_single_precision_days", unit::convert::to( maxSinglePrecisionTimeStep_, unit::day) ), unit::day );
         max_strict_iter_ = param.getDefault("max_strict_iter",8);
         solve_welleq_initially_ = param.getDefault("solve_welleq_initially",solve_welleq_initially_);
+        local_well_solve_ = param.getDefault("local_well_solve", local_well_solve_);
         update_equations_scaling_ = param.getDefault("update_equations_scaling", update_equations_scaling_);
         use_update_stabilization_ = param.getDefault("use_update_stabilization", use_update_stabilization_);
+        use_time_step_predictor_ = param.getDefault("use_time_step_predictor", use_time_step_predictor_);
+        line_search_max_cuts_ = param.getDefault("line_search_max_cuts", line_search_max_cuts_);
+        line_search_residual_growth_ = param.getDefault("line_search_residual_growth", line_search_residual_growth_);
+        well_apply_strategy_ = param.getDefault("well_apply_strategy", well_apply_strategy_);
+        parallel_well_assembly_ = param.getDefault("parallel_well_assembly", parallel_well_assembly_);
+        concurrent_well_assembly_threads_ = param.getDefault("concurrent_well_assembly_threads", concurrent_well_assembly_threads_);
+        colored_linearization_ = param.getDefault("colored_linearization", colored_linearization_);
+        jacobian_free_newton_ = param.getDefault("jacobian_free_newton", jacobian_free_newton_);
+        jacobian_free_perturbation_ = param.getDefault("jacobian_free_perturbation", jacobian_free_perturbation_);
+        float_jacobian_operator_ = param.getDefault("float_jacobian_operator", float_jacobian_operator_);
+        float_jacobian_max_refinements_ = param.getDefault("float_jacobian_max_refinements", float_jacobian_max_refinements_);
+        distributed_wells_ = param.getDefault("distributed_wells", distributed_wells_);
+        well_update_tolerance_ = param.getDefault("well_update_tolerance", well_update_tolerance_);
+        well_full_update_interval_ = param.getDefault("well_full_update_interval", well_full_update_interval_);
+        well_skip_converged_tolerance_ = param.getDefault("well_skip_converged_tolerance", well_skip_converged_tolerance_);
+        well_schur_max_perforations_ = param.getDefault("well_schur_max_perforations", well_schur_max_perforations_);
+        local_cfl_target_ = param.getDefault("local_cfl_target", local_cfl_target_);
+        local_max_substeps_ = param.getDefault("local_max_substeps", local_max_substeps_);
+        share_node_tables_ = param.getDefault("share_node_tables", share_node_tables_);
+        preconditioner_reuse_ratio_ = param.getDefault("preconditioner_reuse_ratio", preconditioner_reuse_ratio_);
+        preconditioner_max_reuse_ = param.getDefault("preconditioner_max_reuse", preconditioner_max_reuse_);
+        localized_update_tolerance_ = param.getDefault("localized_update_tolerance", localized_update_tolerance_);
+        nldd_num_subdomains_ = param.getDefault("nldd_num_subdomains", nldd_num_subdomains_);
+        nldd_local_iterations_ = param.getDefault("nldd_local_iterations", nldd_local_iterations_);
+        aim_cfl_limit_ = param.getDefault("aim_cfl_limit", aim_cfl_limit_);
+        update_ebos_directly_ = param.getDefault("update_ebos_directly", update_ebos_directly_);
+        pressure_setup_reuse_tolerance_ = param.getDefault("pressure_setup_reuse_tolerance", pressure_setup_reuse_tolerance_);
+        pressure_setup_max_reuse_ = param.getDefault("pressure_setup_max_reuse", pressure_setup_max_reuse_);
+        dump_linear_system_dir_ = param.getDefault("dump_linear_system_dir", dump_linear_system_dir_);
+        verify_jacobian_ = param.getDefault("verify_jacobian", verify_jacobian_);
+        jacobian_directions_ = param.getDefault("jacobian_directions", jacobian_directions_);
+        jacobian_perturbation_ = param.getDefault("jacobian_perturbation", jacobian_perturbation_);
+        jacobian_tolerance_ = param.getDefault("jacobian_tolerance", jacobian_tolerance_);
+        {
+            // a comma separated list of Newton iterations, "all" and "failure"
+            std::istringstream list(param.getDefault("dump_linear_system", std::string("")));
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                if (item == "all") {
+                    dump_linear_system_all_ = true;
+                } else if (item == "failure") {
+                    dump_linear_system_on_failure_ = true;
+                } else if (!item.empty()) {
+                    char* end = nullptr;
+                    const long iteration = std::strtol(item.c_str(), &end, 10);
+                    if (*end != '\0' || iteration < 0) {
+                        OPM_THROW(std::runtime_error, "Invalid entry '" << item << "' of dump_linear_system,"
+                                  " expected Newton iterations, 'all' or 'failure'");
+                    }
+                    dump_linear_system_iterations_.push_back(iteration);
+                }
+            }
+        }
         deck_file_name_ = param.template get<std::string>("deck_filename");
     }
 
@@ -77,8 +136,45 @@ namespace Opm
         tolerance_well_control_ = 1.0e-7;
         maxSinglePrecisionTimeStep_ = unit::convert::from( 20.0, unit::day );
         solve_welleq_initially_ = true;
+        local_well_solve_ = false;
         update_equations_scaling_ = false;
         use_update_stabilization_ = true;
+        use_time_step_predictor_ = false;
+        line_search_max_cuts_ = 0;
+        line_search_residual_growth_ = 1.0;
+        well_apply_strategy_ = 0;
+        parallel_well_assembly_ = false;
+        concurrent_well_assembly_threads_ = 0;
+        colored_linearization_ = false;
+        jacobian_free_newton_ = false;
+        jacobian_free_perturbation_ = 1e-7;
+        float_jacobian_operator_ = false;
+        float_jacobian_max_refinements_ = 4;
+        distributed_wells_ = false;
+        well_update_tolerance_ = 0.0;
+        well_full_update_interval_ = 10;
+        well_skip_converged_tolerance_ = 0.0;
+        well_schur_max_perforations_ = 0;
+        local_cfl_target_ = 0.0;
+        local_max_substeps_ = 16;
+        share_node_tables_ = false;
+        dump_linear_system_iterations_.clear();
+        dump_linear_system_all_ = false;
+        dump_linear_system_on_failure_ = false;
+        dump_linear_system_dir_ = ".";
+        verify_jacobian_ = false;
+        jacobian_directions_ = 0;
+        jacobian_perturbation_ = 1e-6;
+        jacobian_tolerance_ = 1e-3;
+        preconditioner_reuse_ratio_ = 0.0;
+        preconditioner_max_reuse_ = 3;
+        localized_update_tolerance_ = 0.0;
+        nldd_num_subdomains_ = 0;
+        nldd_local_iterations_ = 3;
+        aim_cfl_limit_ = 0.0;
+        update_ebos_directly_ = false;
+        pressure_setup_reuse_tolerance_ = 0.0;
+        pressure_setup_max_reuse_ = 10;
     }
 
 
@@ -21,6 +21,7 @@
 #define OPM_BLACKOILMODELPARAMETERS_HEADER_INCLUDED
 
 #include <string>
+#include <vector>
 
 namespace Opm
 {
@@ -62,12 +63,172 @@ namespace Opm
         /// Solve well equation initially
         bool solve_welleq_initially_;
 
+        /// Solve the well equations initially well by well, threaded over the
+        /// wells, instead of as one coupled system.
+        bool local_well_solve_;
+
         /// Update scaling factors for mass balance equations
         bool update_equations_scaling_;
 
         /// Try to detect oscillation or stagnation.
         bool use_update_stabilization_;
 
+        /// Start the Newton iterations of a time step from the state extrapolated
+        /// linearly in time from the last two accepted steps.
+        bool use_time_step_predictor_;
+
+        /// Maximum number of times the previous Newton update is halved when
+        /// it increased the residual, 0 disables the line search.
+        int line_search_max_cuts_;
+
+        /// Factor by which the largest CNV residual may grow in a Newton
+        /// update before the update is backtracked.
+        double line_search_residual_growth_;
+
+        /// How the well contributions are applied in the linear operator:
+        /// 0 serially, 1 threaded over wells and perforated cells,
+        /// 2 in a fused threaded pass over the wells.
+        int well_apply_strategy_;
+
+        /// Assemble the well equations threaded over the wells.
+        bool parallel_well_assembly_;
+
+        /// Assemble the wells on a separate thread with this many OpenMP
+        /// threads while the reservoir is linearized by the remaining ones,
+        /// 0 assembles them afterwards.
+        int concurrent_well_assembly_threads_;
+
+        /// Linearize the reservoir in a threaded pass over colored elements,
+        /// scaling the rows and adding the wells in the same pass.
+        bool colored_linearization_;
+
+        /// Apply the Jacobian in the linear solver by finite differences of the
+        /// residual (Jacobian-free Newton-Krylov), the assembled Jacobian only
+        /// preconditions. Serial runs only.
+        bool jacobian_free_newton_;
+
+        /// Largest relative change of a primary variable in the finite
+        /// differences of jacobian_free_newton.
+        double jacobian_free_perturbation_;
+
+        /// Apply the Jacobian in the Krylov iterations by a single precision
+        /// copy of its blocks, the solution is refined by outer iterations
+        /// on the residual in double precision.
+        bool float_jacobian_operator_;
+
+        /// Largest number of outer refinements of float_jacobian_operator.
+        int float_jacobian_max_refinements_;
+
+        /// Allow wells whose perforations are on several processes, their
+        /// well equations are summed over these processes.
+        bool distributed_wells_;
+
+        /// Relative change of the pressures and rates of a well below which its
+        /// connection pressures and potentials are not recomputed, 0 recomputes always.
+        double well_update_tolerance_;
+
+        /// Number of updates after which the connection pressures and potentials
+        /// of all wells are recomputed.
+        int well_full_update_interval_;
+
+        /// Relative change of the primary variables of a converged well and
+        /// its perforated cells below which the well is not reassembled in the
+        /// next Newton iteration, 0 reassembles all wells.
+        double well_skip_converged_tolerance_;
+
+        /// Wells with at most this many perforations have their Schur complement
+        /// added to the reservoir matrix, such that the preconditioner sees them.
+        /// 0 applies all wells implicitly in the linear operator.
+        int well_schur_max_perforations_;
+
+        /// Cells of the reordering transport solver whose CFL number exceeds
+        /// this value are solved in local sub-steps of the time step, at most
+        /// local_max_substeps_ of them. 0 disables local time stepping.
+        double local_cfl_target_;
+
+        /// Maximum number of local sub-steps of a cell.
+        int local_max_substeps_;
+
+        /// Store the read-only VFP tables once per compute node in MPI
+        /// shared memory instead of once per process.
+        bool share_node_tables_;
+
+        /// The Newton iterations of each time step whose linear systems are
+        /// written to files for replay_linear_solver, see LinearSystemDump.
+        std::vector<int> dump_linear_system_iterations_;
+
+        /// Write the linear systems of all Newton iterations.
+        bool dump_linear_system_all_;
+
+        /// Write the linear systems that the linear solver fails to solve.
+        bool dump_linear_system_on_failure_;
+
+        /// The directory of the linear system files.
+        std::string dump_linear_system_dir_;
+
+        /// Compare the Jacobian with finite differences of the residuals after
+        /// each converged Newton iteration.
+        bool verify_jacobian_;
+
+        /// Number of random directions v in which the product of the Jacobian
+        /// with v is compared with finite differences after each converged
+        /// Newton iteration, 0 disables the check.
+        int jacobian_directions_;
+
+        /// Perturbation of the primary variables relative to their magnitude
+        /// (at least 1) for the finite differences of verify_jacobian.
+        double jacobian_perturbation_;
+
+        /// Relative difference of the Jacobian entries above which they are
+        /// reported by verify_jacobian.
+        double jacobian_tolerance_;
+
+        /// Modified Newton: reuse the ILU preconditioner of an earlier iteration
+        /// of the time step, without updating it to the current Jacobian, while
+        /// the nonlinear residual drops by at least this factor per iteration.
+        /// 0 sets up the preconditioner in every iteration.
+        double preconditioner_reuse_ratio_;
+
+        /// Maximum number of consecutive iterations that reuse a preconditioner.
+        int preconditioner_max_reuse_;
+
+        /// Cells whose Newton update is below this tolerance, relative to the
+        /// pressure and the dissolved ratios and absolute for the saturations,
+        /// are not updated and keep their cached intensive quantities in the
+        /// next linearization. 0 updates all cells.
+        double localized_update_tolerance_;
+
+        /// Nonlinear domain decomposition: the number of subdomains of the
+        /// local grid, whose cells are updated by local Newton iterations
+        /// before each global one. 0 disables the local iterations.
+        int nldd_num_subdomains_;
+
+        /// Maximum number of local Newton iterations per global iteration.
+        int nldd_local_iterations_;
+
+        /// Adaptive implicit Jacobian: cells without wells whose CFL number,
+        /// estimated from the Jacobian, is below this limit are treated as
+        /// implicit in the pressure only, i.e. the flux derivatives with
+        /// respect to their other primary variables are removed from the
+        /// Jacobian. 0 keeps all cells fully implicit.
+        double aim_cfl_limit_;
+
+        /// Apply the Newton updates directly to the primary variables of
+        /// ebos, instead of the reservoir state which is then copied to ebos
+        /// in every iteration. The reservoir state is only filled from ebos
+        /// when the time step has converged.
+        bool update_ebos_directly_;
+
+        /// Sequential pressure model: keep the AMG setup of the pressure
+        /// system while the transmissibility-weighted total mobilities of
+        /// the faces change by less than this relative tolerance since the
+        /// setup, only recomputing its coarse operators. 0 builds a new
+        /// pressure solver in every iteration.
+        double pressure_setup_reuse_tolerance_;
+
+        /// Maximum number of pressure solves with the same AMG setup.
+        int pressure_setup_max_reuse_;
+
         // The file name of the deck
         std::string deck_file_name_;
 
@@ -145,6 +145,7 @@ namespace Opm {
         // using Base::wells;
         using Base::wellsActive;
         using Base::updatePrimalVariableFromState;
+        using Base::invalidatePropertyCache;
         using Base::phaseCondition;
         using Base::fluidRvSat;
         using Base::fluidRsSat;
@@ -173,6 +174,9 @@ namespace Opm {
                     SolutionState& state,
                     WellState& well_state);
 
+        typename Base::V
+        solveWellEqIncrement(const ADB& total_residual) const;
+
         void
         makeConstantState(SolutionState& state) const;
 
@@ -22,6 +22,7 @@
 
 #include <opm/autodiff/BlackoilMultiSegmentModel.hpp>
 
+#include <opm/autodiff/AutoDiffArena.hpp>
 #include <opm/autodiff/AutoDiffBlock.hpp>
 #include <opm/autodiff/AutoDiffHelpers.hpp>
 #include <opm/autodiff/GridHelpers.hpp>
@@ -86,6 +87,7 @@ namespace Opm {
     {
         const double dt = timer.currentStepLength();
         pvdt_ = geo_.poreVolume() / dt;
+        invalidatePropertyCache();
         if (active_[Gas]) {
             updatePrimalVariableFromState(reservoir_state);
         }
@@ -135,6 +137,9 @@ namespace Opm {
     {
         using namespace Opm::AutoDiffGrid;
 
+        // reuse the storage of the temporaries of this assembly
+        AutoDiffArena::Scope arenaScope;
+
         // TODO: include VFP effect.
         // If we have VFP tables, we need the well connection
         // pressures for the "simple" hydrostatic correction
@@ -271,6 +276,26 @@ namespace Opm {
 
 
 
+
+    template <class Grid>
+    typename BlackoilMultiSegmentModel<Grid>::Base::V
+    BlackoilMultiSegmentModel<Grid>::solveWellEqIncrement(const ADB& total_residual) const
+    {
+        // Eliminate the dense blocks of the segments along the segment
+        // trees, the sparse LU of the base version is only needed if the
+        // equations couple segments of different branches.
+        Eigen::SparseMatrix<double> jacobian;
+        total_residual.derivative()[0].toSparse(jacobian);
+        typename Base::V dx;
+        if (wellModel().solveSegmentSystem(jacobian, total_residual.value(), dx)) {
+            return dx;
+        }
+        return Base::solveWellEqIncrement(total_residual);
+    }
+
+
+
+
     template <class Grid>
     void
     BlackoilMultiSegmentModel<Grid>::
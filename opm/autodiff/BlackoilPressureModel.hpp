@@ -26,6 +26,9 @@
 #include <opm/core/simulator/BlackoilState.hpp>
 #include <opm/autodiff/WellStateFullyImplicitBlackoil.hpp>
 #include <opm/autodiff/BlackoilModelParameters.hpp>
+#include <opm/autodiff/CPRPreconditioner.hpp>
+#include <opm/autodiff/DuneMatrix.hpp>
+#include <opm/autodiff/NewtonIterationUtilities.hpp>
 #include <opm/simulators/timestepping/SimulatorTimerInterface.hpp>
 
 #include <algorithm>
@@ -79,8 +82,10 @@ namespace Opm {
                    eclState, has_disgas, has_vapoil, terminal_output),
               state0_(3),
               max_dp_rel_(std::numeric_limits<double>::infinity()),
-              scaling_{ ADB::null(), ADB::null(), ADB::null() }
+              scaling_{ ADB::null(), ADB::null(), ADB::null() },
+              pressure_iterations_(0)
         {
+            setup_param_.cpr_reuse_setup_ = param.pressure_setup_max_reuse_;
         }
 
         /// Called once per timestep.
@@ -120,7 +125,13 @@ namespace Opm {
                 residual_.singlePrecision
             };
             assert(pressure_res.sizeNonLinear() == n1 + n2);
-            V dx_pressure = linsolver_.computeNewtonIncrement(pressure_res);
+            V dx_pressure;
+            if (param_.pressure_setup_reuse_tolerance_ > 0.0) {
+                dx_pressure = solvePressureSystem(pressure_res);
+            } else {
+                dx_pressure = linsolver_.computeNewtonIncrement(pressure_res);
+                pressure_iterations_ = linsolver_.iterations();
+            }
             assert(dx_pressure.size() == n1 + n2);
             V dx_full = V::Zero(n_full);
             dx_full.topRows(n1) = dx_pressure.topRows(n1);
@@ -128,6 +139,12 @@ namespace Opm {
             return dx_full;
         }
 
+        /// Number of linear iterations used in last call to solveJacobianSystem().
+        int linearIterationsLastSolve() const
+        {
+            return pressure_iterations_;
+        }
+
         using Base::numPhases;
         using Base::numMaterials;
         using Base::wellModel;
@@ -141,11 +158,107 @@ namespace Opm {
         using Base::ops_;
         using Base::has_vapoil_;
         using Base::has_disgas_;
+        using Base::param_;
+        using Base::geo_;
+
+        typedef Dune::BCRSMatrix<Dune::FieldMatrix<double, 1, 1> > PressureMatrix;
+        typedef Dune::BlockVector<Dune::FieldVector<double, 1> > PressureVector;
 
         SolutionState state0_;
         double max_dp_rel_ = std::numeric_limits<double>::infinity();
         ADB scaling_[3] = { ADB::null(), ADB::null(), ADB::null() };
 
+        // The AMG setup of the pressure system, kept over the iterations
+        // and time steps, the transmissibility-weighted total mobilities
+        // of the faces in the last assembly and at the setup.
+        mutable CPREllipticSetup<PressureMatrix, PressureVector> setup_;
+        CPRParameter setup_param_;
+        V face_mobility_;
+        mutable V setup_mobility_;
+        mutable int pressure_iterations_;
+
+
+
+
+        /// Solve the pressure system with the stored AMG setup, which is
+        /// rebuilt if the face mobilities changed by more than
+        /// pressure_setup_reuse_tolerance since it was built.
+        V solvePressureSystem(const LinearisedBlackoilResidual& pressure_res) const
+        {
+            // Eliminate the well-related unknowns, and corresponding equations.
+            std::vector<ADB> eqs = { pressure_res.material_balance_eq[0] };
+            std::vector<ADB> elim_eqs;
+            const bool hasWells = pressure_res.well_flux_eq.size() > 0;
+            if (hasWells) {
+                eqs.push_back(pressure_res.well_flux_eq);
+                eqs.push_back(pressure_res.well_eq);
+                elim_eqs.push_back(eqs[1]);
+                eqs = eliminateVariable(eqs, 1); // Eliminate well flux unknowns.
+                elim_eqs.push_back(eqs[1]);
+                eqs = eliminateVariable(eqs, 1); // Eliminate well bhp unknowns.
+                assert(eqs.size() == 1);
+            }
+
+            const Eigen::SparseMatrix<double, Eigen::RowMajor> eigenA = eqs[0].derivative()[0].getSparse();
+            const DuneMatrix A(eigenA);
+            const int size = eqs[0].size();
+
+            if (setup_mobility_.size() != face_mobility_.size()
+                || relativeMobilityChange() > param_.pressure_setup_reuse_tolerance_) {
+                setup_.invalidate();
+            }
+            setup_.update(A, setup_param_);
+            if (!setup_.reused()) {
+                setup_mobility_ = face_mobility_;
+            }
+
+            PressureVector x(size);
+            x = 0.0;
+            PressureVector b(size);
+            std::copy_n(eqs[0].value().data(), size, b.begin());
+
+            // Same tolerances as NewtonIterationBlackoilInterleaved for the pressure system.
+            const int verbosity = 0;
+            const int maxit = 30;
+            const double tolerance = 1e-5;
+            Dune::BiCGSTABSolver<PressureVector> linsolve(setup_.op(), setup_.amg(), tolerance, maxit, verbosity);
+            Dune::InverseOperatorResult result;
+            linsolve.apply(x, b, result);
+            pressure_iterations_ = result.iterations;
+
+            if (!result.converged) {
+                // A failure with an old setup is not given away for a new one.
+                setup_.invalidate();
+                const std::string msg("Convergence failure for linear solver in solvePressureSystem().");
+                OpmLog::problem(msg);
+                OPM_THROW_NOLOG(LinearSolverProblem, msg);
+            }
+
+            V dx(size);
+            std::copy_n(x.begin(), size, dx.data());
+            if (hasWells) {
+                // Recovery in inverse order of elimination.
+                dx = recoverVariable(elim_eqs[1], dx, 1);
+                dx = recoverVariable(elim_eqs[0], dx, 1);
+            }
+            return dx;
+        }
+
+
+
+
+        /// The maximum change of the face mobilities since the setup,
+        /// relative to their maximum at the setup.
+        double relativeMobilityChange() const
+        {
+            if (face_mobility_.size() == 0) {
+                return 0.0;
+            }
+            const double scale = setup_mobility_.abs().maxCoeff();
+            const double change = (face_mobility_ - setup_mobility_).abs().maxCoeff();
+            return scale > 0.0 ? change / scale : (change > 0.0 ? std::numeric_limits<double>::infinity() : 0.0);
+        }
+
 
 
 
@@ -168,11 +281,21 @@ namespace Opm {
             residual_.material_balance_eq[0] = pressure_residual; // HACK
 
             // Compute total reservoir volume flux.
+            // Also compute the transmissibility-weighted total
+            // mobilities that decide on the reuse of the pressure setup.
             const int n = sd_.rq[0].mflux.size();
             V flux = V::Zero(n);
+            V mob = V::Zero(n);
             for (int phase = 0; phase < numPhases(); ++phase) {
                 UpwindSelector<double> upwind(grid_, ops_, sd_.rq[phase].dh.value());
                 flux += sd_.rq[phase].mflux.value() / upwind.select(sd_.rq[phase].b.value());
+                mob += upwind.select(sd_.rq[phase].mob.value());
+            }
+            if (param_.pressure_setup_reuse_tolerance_ > 0.0) {
+                const V transi = subset(geo_.transmissibility(), ops_.internal_faces);
+                V trans_all(transi.size() + ops_.nnc_trans.size());
+                trans_all << transi, ops_.nnc_trans;
+                face_mobility_ = trans_all * mob;
             }
 
             // Storing the fluxes in the assemble() method is a bit of
@@ -37,6 +37,11 @@
 
 #include <opm/common/ErrorMacros.hpp>
 
+#include <cassert>
+#include <exception>
+#include <numeric>
+#include <vector>
+
 namespace Opm
 {
     // Making these typedef to make the code more readable.
@@ -44,6 +49,116 @@ namespace Opm
     typedef BlackoilPropsAdFromDeck::V V;
     typedef Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Block;
 
+    namespace
+    {
+        typedef BlackoilPropsAdFromDeck::FluidSystem FluidSystem;
+
+        /// The positions of a subset of cells grouped by their PVT region,
+        /// such that the PVT of all cells of a region is evaluated as one
+        /// batch.
+        struct PvtRegionBatches
+        {
+            // the PVT region of each batch
+            std::vector<unsigned> region;
+            // the start of each batch in position, followed by the end of
+            // the last batch
+            std::vector<int> start;
+            // the positions in the subset ordered by region, empty if all
+            // cells are in one region
+            std::vector<int> position;
+        };
+
+        PvtRegionBatches pvtRegionBatches(const std::vector<int>& cellPvtRegionIdx,
+                                          const std::vector<int>& cells)
+        {
+            const int n = cells.size();
+            const int numRegions = FluidSystem::numRegions();
+            PvtRegionBatches batches;
+            if (numRegions <= 1) {
+                // there is nothing to gather for a single region
+                batches.region.assign(1, 0);
+                batches.start = { 0, n };
+                return batches;
+            }
+
+            // counting sort of the positions by region
+            std::vector<int> region(n);
+            std::vector<int> start(numRegions + 1, 0);
+            for (int i = 0; i < n; ++i) {
+                region[i] = cellPvtRegionIdx[cells[i]];
+                assert(region[i] >= 0 && region[i] < numRegions);
+                ++start[region[i] + 1];
+            }
+            std::partial_sum(start.begin(), start.end(), start.begin());
+            std::vector<int> next(start.begin(), start.end() - 1);
+            batches.position.resize(n);
+            for (int i = 0; i < n; ++i) {
+                batches.position[next[region[i]]++] = i;
+            }
+            for (int r = 0; r < numRegions; ++r) {
+                if (start[r + 1] > start[r]) {
+                    batches.region.push_back(r);
+                    batches.start.push_back(start[r]);
+                }
+            }
+            batches.start.push_back(n);
+            return batches;
+        }
+
+        /// Evaluate the PVT of the cells batch by batch, where
+        /// evaluate(pvtRegionIdx, i) computes the values and derivatives of
+        /// the cell at position i of the subset.
+        template <class Evaluate>
+        void evaluatePvt(const PvtRegionBatches& batches, const Evaluate& evaluate)
+        {
+            const int* position = batches.position.empty() ? nullptr : batches.position.data();
+            std::exception_ptr error;
+            for (std::size_t batch = 0; batch < batches.region.size(); ++batch) {
+                const unsigned pvtRegionIdx = batches.region[batch];
+                const int begin = batches.start[batch];
+                const int end = batches.start[batch + 1];
+                // small subsets such as the perforated cells are not worth the threads
+#pragma omp parallel for schedule(static) if (end - begin > 1000)
+                for (int k = begin; k < end; ++k) {
+                    try {
+                        evaluate(pvtRegionIdx, position ? position[k] : k);
+                    }
+                    catch (...) {
+#pragma omp critical
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
+                }
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        /// The AD value of a PVT quantity given its derivatives with respect
+        /// to the pressure p, and to r (rs or rv) if it is not null.
+        ADB pvtFunction(V&& value, const V& dvdp, const ADB& p,
+                        const ADB* r = nullptr, const V& dvdr = V())
+        {
+            ADB::M dvdp_diag(dvdp.matrix().asDiagonal());
+            const int num_blocks = p.numBlocks();
+            std::vector<ADB::M> jacs(num_blocks);
+            for (int block = 0; block < num_blocks; ++block) {
+                fastSparseProduct(dvdp_diag, p.derivative()[block], jacs[block]);
+            }
+            if (r) {
+                ADB::M dvdr_diag(dvdr.matrix().asDiagonal());
+                for (int block = 0; block < num_blocks; ++block) {
+                    ADB::M temp;
+                    fastSparseProduct(dvdr_diag, r->derivative()[block], temp);
+                    jacs[block] += temp;
+                }
+            }
+            return ADB::function(std::move(value), std::move(jacs));
+        }
+    } // anonymous namespace
+
     /// Constructor wrapping an opm-core black oil interface.
     BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const Opm::Deck& deck,
                                                      const Opm::EclipseState& eclState,
@@ -267,41 +382,9 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
         if (!phase_usage_.phase_used[Water]) {
             OPM_THROW(std::runtime_error, "Cannot call muWat(): water phase not active.");
         }
-        const int n = cells.size();
-        assert(pw.size() == n);
-
-        V mu(n);
-        V dmudp(n);
-
-        typedef Opm::DenseAd::Evaluation<double, /*size=*/1> Eval;
-
-        Eval pEval = 0.0;
-        Eval TEval = 0.0;
-
-        pEval.setDerivative(0, 1.0);
-
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(pw.value()[i]);
-            TEval.setValue(T.value()[i]);
-
-            const Eval& muEval = FluidSystem::waterPvt().viscosity(pvtRegionIdx, TEval, pEval);
-
-            mu[i] = muEval.value();
-            dmudp[i] = muEval.derivative(0);
-        }
-
-        if (pw.derivative().empty()) {
-            return ADB::constant(std::move(mu));
-        } else {
-            ADB::M dmudp_diag(dmudp.matrix().asDiagonal());
-            const int num_blocks = pw.numBlocks();
-            std::vector<ADB::M> jacs(num_blocks);
-            for (int block = 0; block < num_blocks; ++block) {
-                fastSparseProduct(dmudp_diag, pw.derivative()[block], jacs[block]);
-            }
-            return ADB::function(std::move(mu), std::move(jacs));
-        }
+        ADB mu = ADB::null();
+        evaluateWaterPvt(pw, T, cells, &mu, nullptr);
+        return mu;
     }
 
     /// Oil viscosity.
@@ -320,55 +403,9 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
         if (!phase_usage_.phase_used[Oil]) {
             OPM_THROW(std::runtime_error, "Cannot call muOil(): oil phase not active.");
         }
-        const int n = cells.size();
-        assert(po.size() == n);
-        V mu(n);
-        V dmudp(n);
-        V dmudr(n);
-
-        typedef Opm::DenseAd::Evaluation<double, /*size=*/2> Eval;
-
-        Eval pEval = 0.0;
-        Eval TEval = 0.0;
-        Eval RsEval = 0.0;
-
-        pEval.setDerivative(0, 1.0);
-        RsEval.setDerivative(1, 1.0);
-
-        Eval muEval;
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(po.value()[i]);
-            TEval.setValue(T.value()[i]);
-
-            if (cond[i].hasFreeGas()) {
-                muEval = FluidSystem::oilPvt().saturatedViscosity(pvtRegionIdx, TEval, pEval);
-            }
-            else {
-                if (phase_usage_.phase_used[Gas]) {
-                    RsEval.setValue(rs.value()[i]);
-                }
-                muEval = FluidSystem::oilPvt().viscosity(pvtRegionIdx, TEval, pEval, RsEval);
-            }
-
-            mu[i] = muEval.value();
-            dmudp[i] = muEval.derivative(0);
-            dmudr[i] = muEval.derivative(1);
-        }
-
-        ADB::M dmudp_diag(dmudp.matrix().asDiagonal());
-        ADB::M dmudr_diag(dmudr.matrix().asDiagonal());
-        const int num_blocks = po.numBlocks();
-        std::vector<ADB::M> jacs(num_blocks);
-        for (int block = 0; block < num_blocks; ++block) {
-            fastSparseProduct(dmudp_diag, po.derivative()[block], jacs[block]);
-            if (phase_usage_.phase_used[Gas]) {
-                ADB::M temp;
-                fastSparseProduct(dmudr_diag, rs.derivative()[block], temp);
-                jacs[block] += temp;
-            }
-        }
-        return ADB::function(std::move(mu), std::move(jacs));
+        ADB mu = ADB::null();
+        evaluateOilPvt(po, T, rs, cond, cells, &mu, nullptr);
+        return mu;
     }
 
     /// Gas viscosity.
@@ -387,51 +424,9 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
         if (!phase_usage_.phase_used[Gas]) {
             OPM_THROW(std::runtime_error, "Cannot call muGas(): gas phase not active.");
         }
-        const int n = cells.size();
-        assert(pg.value().size() == n);
-        V mu(n);
-        V dmudp(n);
-        V dmudr(n);
-
-        typedef Opm::DenseAd::Evaluation<double, /*size=*/2> Eval;
-
-        Eval pEval = 0.0;
-        Eval TEval = 0.0;
-        Eval RvEval = 0.0;
-        Eval muEval;
-
-        pEval.setDerivative(0, 1.0);
-        RvEval.setDerivative(1, 1.0);
-
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(pg.value()[i]);
-            TEval.setValue(T.value()[i]);
-
-            if (cond[i].hasFreeOil()) {
-                muEval = FluidSystem::gasPvt().saturatedViscosity(pvtRegionIdx, TEval, pEval);
-            }
-            else {
-                RvEval.setValue(rv.value()[i]);
-                muEval = FluidSystem::gasPvt().viscosity(pvtRegionIdx, TEval, pEval, RvEval);
-            }
-
-            mu[i] = muEval.value();
-            dmudp[i] = muEval.derivative(0);
-            dmudr[i] = muEval.derivative(1);
-        }
-
-        ADB::M dmudp_diag(dmudp.matrix().asDiagonal());
-        ADB::M dmudr_diag(dmudr.matrix().asDiagonal());
-        const int num_blocks = pg.numBlocks();
-        std::vector<ADB::M> jacs(num_blocks);
-        for (int block = 0; block < num_blocks; ++block) {
-            fastSparseProduct(dmudp_diag, pg.derivative()[block], jacs[block]);
-            ADB::M temp;
-            fastSparseProduct(dmudr_diag, rv.derivative()[block], temp);
-            jacs[block] += temp;
-        }
-        return ADB::function(std::move(mu), std::move(jacs));
+        ADB mu = ADB::null();
+        evaluateGasPvt(pg, T, rv, cond, cells, &mu, nullptr);
+        return mu;
     }
 
 
@@ -450,37 +445,9 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
         if (!phase_usage_.phase_used[Water]) {
             OPM_THROW(std::runtime_error, "Cannot call bWat(): water phase not active.");
         }
-        const int n = cells.size();
-        assert(pw.size() == n);
-
-        V b(n);
-        V dbdp(n);
-        V dbdr(n);
-
-        typedef Opm::DenseAd::Evaluation<double, /*size=*/1> Eval;
-
-        Eval pEval = 0.0;
-        Eval TEval = 0.0;
-
-        pEval.setDerivative(0, 1.0);
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(pw.value()[i]);
-            TEval.setValue(T.value()[i]);
-
-            const Eval& bEval = FluidSystem::waterPvt().inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
-
-            b[i] = bEval.value();
-            dbdp[i] = bEval.derivative(0);
-        }
-
-        ADB::M dbdp_diag(dbdp.matrix().asDiagonal());
-        const int num_blocks = pw.numBlocks();
-        std::vector<ADB::M> jacs(num_blocks);
-        for (int block = 0; block < num_blocks; ++block) {
-            fastSparseProduct(dbdp_diag, pw.derivative()[block], jacs[block]);
-        }
-        return ADB::function(std::move(b), std::move(jacs));
+        ADB b = ADB::null();
+        evaluateWaterPvt(pw, T, cells, nullptr, &b);
+        return b;
     }
 
     /// Oil formation volume factor.
@@ -499,61 +466,9 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
         if (!phase_usage_.phase_used[Oil]) {
             OPM_THROW(std::runtime_error, "Cannot call bOil(): oil phase not active.");
         }
-        const int n = cells.size();
-        assert(po.size() == n);
-
-        V b(n);
-        V dbdp(n);
-        V dbdr(n);
-
-        typedef Opm::DenseAd::Evaluation<double, /*size=*/2> Eval;
-
-        Eval pEval = 0.0;
-        Eval TEval = 0.0;
-        Eval RsEval = 0.0;
-        Eval bEval;
-
-        pEval.setDerivative(0, 1.0);
-        RsEval.setDerivative(1, 1.0);
-
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(po.value()[i]);
-            TEval.setValue(T.value()[i]);
-
-            //RS/RV only makes sense when gas phase is active
-            if (cond[i].hasFreeGas()) {
-                bEval = FluidSystem::oilPvt().saturatedInverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
-            }
-            else {
-                if (rs.size() == 0) {
-                    RsEval.setValue(0.0);
-                }
-                else {
-                    RsEval.setValue(rs.value()[i]);
-                }
-                bEval = FluidSystem::oilPvt().inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval, RsEval);
-            }
-
-            b[i] = bEval.value();
-            dbdp[i] = bEval.derivative(0);
-            dbdr[i] = bEval.derivative(1);
-        }
-
-        ADB::M dbdp_diag(dbdp.matrix().asDiagonal());
-        ADB::M dbdr_diag(dbdr.matrix().asDiagonal());
-        const int num_blocks = po.numBlocks();
-        std::vector<ADB::M> jacs(num_blocks);
-
-        for (int block = 0; block < num_blocks; ++block) {
-            fastSparseProduct(dbdp_diag, po.derivative()[block], jacs[block]);
-            if (phase_usage_.phase_used[Gas]) {
-                ADB::M temp;
-                fastSparseProduct(dbdr_diag, rs.derivative()[block], temp);
-                jacs[block] += temp;
-            }
-        }
-        return ADB::function(std::move(b), std::move(jacs));
+        ADB b = ADB::null();
+        evaluateOilPvt(po, T, rs, cond, cells, nullptr, &b);
+        return b;
     }
 
     /// Gas formation volume factor.
@@ -572,52 +487,56 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
         if (!phase_usage_.phase_used[Gas]) {
             OPM_THROW(std::runtime_error, "Cannot call bGas(): gas phase not active.");
         }
-        const int n = cells.size();
-        assert(pg.size() == n);
-
-        V b(n);
-        V dbdp(n);
-        V dbdr(n);
-
-        typedef Opm::DenseAd::Evaluation<double, /*size=*/2> Eval;
+        ADB b = ADB::null();
+        evaluateGasPvt(pg, T, rv, cond, cells, nullptr, &b);
+        return b;
+    }
 
-        Eval pEval = 0.0;
-        Eval TEval = 0.0;
-        Eval RvEval = 0.0;
-        Eval bEval;
 
-        pEval.setDerivative(0, 1.0);
-        RvEval.setDerivative(1, 1.0);
+    // ------ Viscosity and formation volume factor (b) ------
 
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(pg.value()[i]);
-            TEval.setValue(T.value()[i]);
 
-            if (cond[i].hasFreeOil()) {
-                bEval = FluidSystem::gasPvt().saturatedInverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
-            }
-            else {
-                RvEval.setValue(rv.value()[i]);
-                bEval = FluidSystem::gasPvt().inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval, RvEval);
-            }
+    /// Water viscosity and formation volume factor.
+    void BlackoilPropsAdFromDeck::muAndBWat(const ADB& pw,
+                                            const ADB& T,
+                                            const Cells& cells,
+                                            ADB& mu,
+                                            ADB& b) const
+    {
+        if (!phase_usage_.phase_used[Water]) {
+            OPM_THROW(std::runtime_error, "Cannot call muAndBWat(): water phase not active.");
+        }
+        evaluateWaterPvt(pw, T, cells, &mu, &b);
+    }
 
-            b[i] = bEval.value();
-            dbdp[i] = bEval.derivative(0);
-            dbdr[i] = bEval.derivative(1);
+    /// Oil viscosity and formation volume factor.
+    void BlackoilPropsAdFromDeck::muAndBOil(const ADB& po,
+                                            const ADB& T,
+                                            const ADB& rs,
+                                            const std::vector<PhasePresence>& cond,
+                                            const Cells& cells,
+                                            ADB& mu,
+                                            ADB& b) const
+    {
+        if (!phase_usage_.phase_used[Oil]) {
+            OPM_THROW(std::runtime_error, "Cannot call muAndBOil(): oil phase not active.");
         }
+        evaluateOilPvt(po, T, rs, cond, cells, &mu, &b);
+    }
 
-        ADB::M dbdp_diag(dbdp.matrix().asDiagonal());
-        ADB::M dbdr_diag(dbdr.matrix().asDiagonal());
-        const int num_blocks = pg.numBlocks();
-        std::vector<ADB::M> jacs(num_blocks);
-        for (int block = 0; block < num_blocks; ++block) {
-            fastSparseProduct(dbdp_diag, pg.derivative()[block], jacs[block]);
-            ADB::M temp;
-            fastSparseProduct(dbdr_diag, rv.derivative()[block], temp);
-            jacs[block] += temp;
+    /// Gas viscosity and formation volume factor.
+    void BlackoilPropsAdFromDeck::muAndBGas(const ADB& pg,
+                                            const ADB& T,
+                                            const ADB& rv,
+                                            const std::vector<PhasePresence>& cond,
+                                            const Cells& cells,
+                                            ADB& mu,
+                                            ADB& b) const
+    {
+        if (!phase_usage_.phase_used[Gas]) {
+            OPM_THROW(std::runtime_error, "Cannot call muAndBGas(): gas phase not active.");
         }
-        return ADB::function(std::move(b), std::move(jacs));
+        evaluateGasPvt(pg, T, rv, cond, cells, &mu, &b);
     }
 
 
@@ -641,28 +560,21 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
 
         typedef Opm::DenseAd::Evaluation<double, /*size=*/1> Eval;
 
-        Eval pEval = 0.0;
-        Eval TEval = 293.15; // temperature is not supported by this API!
+        evaluatePvt(pvtRegionBatches(cellPvtRegionIdx_, cells),
+                    [&](const unsigned pvtRegionIdx, const int i) {
+                        Eval pEval = 0.0;
+                        Eval TEval = 293.15; // temperature is not supported by this API!
 
-        pEval.setDerivative(0, 1.0);
+                        pEval.setValue(po.value()[i]);
+                        pEval.setDerivative(0, 1.0);
 
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(po.value()[i]);
-
-            const Eval& RsEval = FluidSystem::oilPvt().saturatedGasDissolutionFactor(pvtRegionIdx, TEval, pEval);
+                        const Eval& RsEval = FluidSystem::oilPvt().saturatedGasDissolutionFactor(pvtRegionIdx, TEval, pEval);
 
-            rbub[i] = RsEval.value();
-            drbubdp[i] = RsEval.derivative(0);
-        }
+                        rbub[i] = RsEval.value();
+                        drbubdp[i] = RsEval.derivative(0);
+                    });
 
-        ADB::M drbubdp_diag(drbubdp.matrix().asDiagonal());
-        const int num_blocks = po.numBlocks();
-        std::vector<ADB::M> jacs(num_blocks);
-        for (int block = 0; block < num_blocks; ++block) {
-            fastSparseProduct(drbubdp_diag, po.derivative()[block], jacs[block]);
-        }
-        return ADB::function(std::move(rbub), std::move(jacs));
+        return pvtFunction(std::move(rbub), drbubdp, po);
     }
 
     /// Bubble point curve for Rs as function of oil pressure.
@@ -698,28 +610,21 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
 
         typedef Opm::DenseAd::Evaluation<double, /*size=*/1> Eval;
 
-        Eval pEval = 0.0;
-        Eval TEval = 293.15; // temperature is not supported by this API!
-
-        pEval.setDerivative(0, 1.0);
+        evaluatePvt(pvtRegionBatches(cellPvtRegionIdx_, cells),
+                    [&](const unsigned pvtRegionIdx, const int i) {
+                        Eval pEval = 0.0;
+                        Eval TEval = 293.15; // temperature is not supported by this API!
 
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(pg.value()[i]);
+                        pEval.setValue(pg.value()[i]);
+                        pEval.setDerivative(0, 1.0);
 
-            const Eval& RvEval = FluidSystem::gasPvt().saturatedOilVaporizationFactor(pvtRegionIdx, TEval, pEval);
+                        const Eval& RvEval = FluidSystem::gasPvt().saturatedOilVaporizationFactor(pvtRegionIdx, TEval, pEval);
 
-            rv[i] = RvEval.value();
-            drvdp[i] = RvEval.derivative(0);
-        }
+                        rv[i] = RvEval.value();
+                        drvdp[i] = RvEval.derivative(0);
+                    });
 
-        ADB::M drvdp_diag(drvdp.matrix().asDiagonal());
-        const int num_blocks = pg.numBlocks();
-        std::vector<ADB::M> jacs(num_blocks);
-        for (int block = 0; block < num_blocks; ++block) {
-            fastSparseProduct(drvdp_diag, pg.derivative()[block], jacs[block]);
-        }
-        return ADB::function(std::move(rv), std::move(jacs));
+        return pvtFunction(std::move(rv), drvdp, pg);
     }
 
     /// Condensation curve for Rv as function of oil pressure.
@@ -1018,6 +923,208 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
     }
 
 
+    /// Water viscosity and/or formation volume factor of the cells, only
+    /// the results which are not null are computed.
+    void BlackoilPropsAdFromDeck::evaluateWaterPvt(const ADB& pw,
+                                                   const ADB& T,
+                                                   const Cells& cells,
+                                                   ADB* mu,
+                                                   ADB* b) const
+    {
+        const int n = cells.size();
+        assert(pw.size() == n);
+
+        V muValue(mu ? n : 0);
+        V dmudp(mu ? n : 0);
+        V bValue(b ? n : 0);
+        V dbdp(b ? n : 0);
+
+        typedef Opm::DenseAd::Evaluation<double, /*size=*/1> Eval;
+
+        evaluatePvt(pvtRegionBatches(cellPvtRegionIdx_, cells),
+                    [&](const unsigned pvtRegionIdx, const int i) {
+                        Eval pEval = 0.0;
+                        Eval TEval = 0.0;
+
+                        pEval.setValue(pw.value()[i]);
+                        pEval.setDerivative(0, 1.0);
+                        TEval.setValue(T.value()[i]);
+
+                        if (mu) {
+                            const Eval& muEval = FluidSystem::waterPvt().viscosity(pvtRegionIdx, TEval, pEval);
+                            muValue[i] = muEval.value();
+                            dmudp[i] = muEval.derivative(0);
+                        }
+                        if (b) {
+                            const Eval& bEval = FluidSystem::waterPvt().inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
+                            bValue[i] = bEval.value();
+                            dbdp[i] = bEval.derivative(0);
+                        }
+                    });
+
+        if (mu) {
+            *mu = pvtFunction(std::move(muValue), dmudp, pw);
+        }
+        if (b) {
+            *b = pvtFunction(std::move(bValue), dbdp, pw);
+        }
+    }
+
+    /// Oil viscosity and/or formation volume factor of the cells, only
+    /// the results which are not null are computed.
+    void BlackoilPropsAdFromDeck::evaluateOilPvt(const ADB& po,
+                                                 const ADB& T,
+                                                 const ADB& rs,
+                                                 const std::vector<PhasePresence>& cond,
+                                                 const Cells& cells,
+                                                 ADB* mu,
+                                                 ADB* b) const
+    {
+        const int n = cells.size();
+        assert(po.size() == n);
+
+        //RS/RV only makes sense when gas phase is active
+        const bool useRs = phase_usage_.phase_used[Gas] && rs.size() > 0;
+
+        V muValue(mu ? n : 0);
+        V dmudp(mu ? n : 0);
+        V dmudr(mu ? n : 0);
+        V bValue(b ? n : 0);
+        V dbdp(b ? n : 0);
+        V dbdr(b ? n : 0);
+
+        typedef Opm::DenseAd::Evaluation<double, /*size=*/2> Eval;
+
+        evaluatePvt(pvtRegionBatches(cellPvtRegionIdx_, cells),
+                    [&](const unsigned pvtRegionIdx, const int i) {
+                        Eval pEval = 0.0;
+                        Eval TEval = 0.0;
+                        Eval RsEval = 0.0;
+                        Eval muEval;
+                        Eval bEval;
+
+                        pEval.setValue(po.value()[i]);
+                        pEval.setDerivative(0, 1.0);
+                        TEval.setValue(T.value()[i]);
+
+                        const auto& pvt = FluidSystem::oilPvt();
+                        if (cond[i].hasFreeGas()) {
+                            if (mu) {
+                                muEval = pvt.saturatedViscosity(pvtRegionIdx, TEval, pEval);
+                            }
+                            if (b) {
+                                bEval = pvt.saturatedInverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
+                            }
+                        }
+                        else {
+                            if (useRs) {
+                                RsEval.setValue(rs.value()[i]);
+                            }
+                            RsEval.setDerivative(1, 1.0);
+                            if (mu) {
+                                muEval = pvt.viscosity(pvtRegionIdx, TEval, pEval, RsEval);
+                            }
+                            if (b) {
+                                bEval = pvt.inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval, RsEval);
+                            }
+                        }
+
+                        if (mu) {
+                            muValue[i] = muEval.value();
+                            dmudp[i] = muEval.derivative(0);
+                            dmudr[i] = muEval.derivative(1);
+                        }
+                        if (b) {
+                            bValue[i] = bEval.value();
+                            dbdp[i] = bEval.derivative(0);
+                            dbdr[i] = bEval.derivative(1);
+                        }
+                    });
+
+        const ADB* r = useRs ? &rs : nullptr;
+        if (mu) {
+            *mu = pvtFunction(std::move(muValue), dmudp, po, r, dmudr);
+        }
+        if (b) {
+            *b = pvtFunction(std::move(bValue), dbdp, po, r, dbdr);
+        }
+    }
+
+    /// Gas viscosity and/or formation volume factor of the cells, only
+    /// the results which are not null are computed.
+    void BlackoilPropsAdFromDeck::evaluateGasPvt(const ADB& pg,
+                                                 const ADB& T,
+                                                 const ADB& rv,
+                                                 const std::vector<PhasePresence>& cond,
+                                                 const Cells& cells,
+                                                 ADB* mu,
+                                                 ADB* b) const
+    {
+        const int n = cells.size();
+        assert(pg.size() == n);
+
+        V muValue(mu ? n : 0);
+        V dmudp(mu ? n : 0);
+        V dmudr(mu ? n : 0);
+        V bValue(b ? n : 0);
+        V dbdp(b ? n : 0);
+        V dbdr(b ? n : 0);
+
+        typedef Opm::DenseAd::Evaluation<double, /*size=*/2> Eval;
+
+        evaluatePvt(pvtRegionBatches(cellPvtRegionIdx_, cells),
+                    [&](const unsigned pvtRegionIdx, const int i) {
+                        Eval pEval = 0.0;
+                        Eval TEval = 0.0;
+                        Eval RvEval = 0.0;
+                        Eval muEval;
+                        Eval bEval;
+
+                        pEval.setValue(pg.value()[i]);
+                        pEval.setDerivative(0, 1.0);
+                        TEval.setValue(T.value()[i]);
+
+                        const auto& pvt = FluidSystem::gasPvt();
+                        if (cond[i].hasFreeOil()) {
+                            if (mu) {
+                                muEval = pvt.saturatedViscosity(pvtRegionIdx, TEval, pEval);
+                            }
+                            if (b) {
+                                bEval = pvt.saturatedInverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
+                            }
+                        }
+                        else {
+                            RvEval.setValue(rv.value()[i]);
+                            RvEval.setDerivative(1, 1.0);
+                            if (mu) {
+                                muEval = pvt.viscosity(pvtRegionIdx, TEval, pEval, RvEval);
+                            }
+                            if (b) {
+                                bEval = pvt.inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval, RvEval);
+                            }
+                        }
+
+                        if (mu) {
+                            muValue[i] = muEval.value();
+                            dmudp[i] = muEval.derivative(0);
+                            dmudr[i] = muEval.derivative(1);
+                        }
+                        if (b) {
+                            bValue[i] = bEval.value();
+                            dbdp[i] = bEval.derivative(0);
+                            dbdr[i] = bEval.derivative(1);
+                        }
+                    });
+
+        if (mu) {
+            *mu = pvtFunction(std::move(muValue), dmudp, pg, &rv, dmudr);
+        }
+        if (b) {
+            *b = pvtFunction(std::move(bValue), dbdp, pg, &rv, dbdr);
+        }
+    }
+
+
     /// Apply correction to rs/rv according to kw VAPPARS
     /// \param[in/out] r     Array of n rs/rv values.
     /// \param[in]     so    Array of n oil saturation values.
@@ -275,6 +275,55 @@ namespace Opm
                  const std::vector<PhasePresence>& cond,
                  const Cells& cells) const;
 
+        // ------ Viscosity and formation volume factor (b) ------
+
+        /// Water viscosity and formation volume factor, evaluated together
+        /// in one pass over the cells.
+        /// \param[in]  pw     Array of n water pressure values.
+        /// \param[in]  T      Array of n temperature values.
+        /// \param[in]  cells  Array of n cell indices to be associated with the pressure values.
+        /// \param[out] mu     Array of n viscosity values.
+        /// \param[out] b      Array of n formation volume factor values.
+        void muAndBWat(const ADB& pw,
+                       const ADB& T,
+                       const Cells& cells,
+                       ADB& mu,
+                       ADB& b) const;
+
+        /// Oil viscosity and formation volume factor, evaluated together
+        /// in one pass over the cells.
+        /// \param[in]  po     Array of n oil pressure values.
+        /// \param[in]  T      Array of n temperature values.
+        /// \param[in]  rs     Array of n gas solution factor values.
+        /// \param[in]  cond   Array of n objects, each specifying which phases are present with non-zero saturation in a cell.
+        /// \param[in]  cells  Array of n cell indices to be associated with the pressure values.
+        /// \param[out] mu     Array of n viscosity values.
+        /// \param[out] b      Array of n formation volume factor values.
+        void muAndBOil(const ADB& po,
+                       const ADB& T,
+                       const ADB& rs,
+                       const std::vector<PhasePresence>& cond,
+                       const Cells& cells,
+                       ADB& mu,
+                       ADB& b) const;
+
+        /// Gas viscosity and formation volume factor, evaluated together
+        /// in one pass over the cells.
+        /// \param[in]  pg     Array of n gas pressure values.
+        /// \param[in]  T      Array of n temperature values.
+        /// \param[in]  rv     Array of n vapor oil/gas ratio
+        /// \param[in]  cond   Array of n objects, each specifying which phases are present with non-zero saturation in a cell.
+        /// \param[in]  cells  Array of n cell indices to be associated with the pressure values.
+        /// \param[out] mu     Array of n viscosity values.
+        /// \param[out] b      Array of n formation volume factor values.
+        void muAndBGas(const ADB& pg,
+                       const ADB& T,
+                       const ADB& rv,
+                       const std::vector<PhasePresence>& cond,
+                       const Cells& cells,
+                       ADB& mu,
+                       ADB& b) const;
+
         // ------ Rs bubble point curve ------
 
         /// Bubble point curve for Rs as function of oil pressure.
@@ -468,6 +517,32 @@ namespace Opm
                   const int* cart_dims,
                   const bool init_rock);
 
+        /// Viscosity and/or formation volume factor of each phase. The PVT
+        /// of the cells is evaluated region by region, with the value and
+        /// the derivatives computed together. The results which are null
+        /// are not computed.
+        void evaluateWaterPvt(const ADB& pw,
+                              const ADB& T,
+                              const Cells& cells,
+                              ADB* mu,
+                              ADB* b) const;
+
+        void evaluateOilPvt(const ADB& po,
+                            const ADB& T,
+                            const ADB& rs,
+                            const std::vector<PhasePresence>& cond,
+                            const Cells& cells,
+                            ADB* mu,
+                            ADB* b) const;
+
+        void evaluateGasPvt(const ADB& pg,
+                            const ADB& T,
+                            const ADB& rv,
+                            const std::vector<PhasePresence>& cond,
+                            const Cells& cells,
+                            ADB* mu,
+                            ADB* b) const;
+
         /// Correction to rs/rv according to kw VAPPARS
         void applyVap(V& r,
                       const V& so,
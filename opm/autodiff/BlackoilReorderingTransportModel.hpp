@@ -25,12 +25,14 @@
 #include <opm/autodiff/BlackoilModelParameters.hpp>
 #include <opm/autodiff/DebugTimeReport.hpp>
 #include <opm/autodiff/multiPhaseUpwind.hpp>
+#include <opm/autodiff/ReorderingSchedule.hpp>
 #include <opm/core/grid.h>
-#include <opm/core/transport/reorder/reordersequence.h>
 #include <opm/core/simulator/BlackoilState.hpp>
 
 #include <opm/autodiff/BlackoilTransportModel.hpp>
 
+#include <cmath>
+
 namespace Opm {
 
 
@@ -308,6 +310,9 @@ namespace Opm {
                 computeOrdering();
             }
 
+            // Flag the cells to solve in local sub-steps.
+            computeLocalSteps();
+
             // Solve in every component (cell or block of cells), in order.
             {
                 DebugTimeReport tr("Solving all components");
@@ -440,8 +445,13 @@ namespace Opm {
         V total_wellflux_cell_;
         V oil_wellflux_cell_;
         V gas_wellflux_cell_;
-        std::vector<int> sequence_;
-        std::vector<int> components_;
+        ReorderingSchedule schedule_;
+        // neighbours of each cell and the connection to each neighbour
+        std::vector<int> neighbour_start_;
+        std::vector<int> neighbours_;
+        std::vector<int> neighbour_connections_;
+        // upstream flags of the neighbours used for the current ordering
+        std::vector<char> upstream_;
         V trans_all_;
         V gdz_;
         DataBlock rhos_;
@@ -449,6 +459,12 @@ namespace Opm {
         std::array<double, 2> max_abs_dx_;
         std::array<int, 2> max_abs_dx_cell_;
 
+        // number of local sub-steps of each cell, and the time averaged
+        // oil and gas component fluxes over the connections computed by
+        // the sub-stepped cells
+        std::vector<int> substeps_;
+        std::vector<std::array<double, 2>> local_flux_;
+
         // TODO: remove this, for debug only.
         BlackoilTransportModel<Grid, WellModel> tr_model_;
 
@@ -579,23 +595,43 @@ namespace Opm {
 
         void computeOrdering()
         {
-            assert(!geo_.nnc().hasNNC()); // TODO: support compute_sequence() with grid + nnc.
-            static_assert(std::is_same<Grid, UnstructuredGrid>::value,
-                          "compute_sequence() is written in C and therefore requires an UnstructuredGrid, "
-                          "it must be rewritten to use other grid classes such as CpGrid");
-            using namespace Opm::AutoDiffGrid;
-            const int num_cells = numCells(grid_);
-            sequence_.resize(num_cells);
-            components_.resize(num_cells + 1); // max possible size
-            int num_components = -1;
-
-
-            using namespace Opm::AutoDiffGrid;
-            const int num_faces = numFaces(grid_);
-            V flux_on_all_faces = superset(total_flux_, ops_.internal_faces, num_faces);
-            compute_sequence(&grid_, flux_on_all_faces.data(), sequence_.data(), components_.data(), &num_components);
-            OpmLog::debug(std::string("Number of components: ") + std::to_string(num_components));
-            components_.resize(num_components + 1); // resize to fit actually used part
+            const int num_cells = Opm::AutoDiffGrid::numCells(grid_);
+            if (neighbour_start_.empty()) {
+                neighbour_start_.reserve(num_cells + 1);
+                neighbour_start_.push_back(0);
+                for (int cell = 0; cell < num_cells; ++cell) {
+                    for (auto conn : graph_.cellConnections(cell)) {
+                        const auto conn_cells = graph_.connectionCells(conn.index);
+                        const int other = conn_cells[0] == cell ? conn_cells[1] : conn_cells[0];
+                        if (other >= 0) {
+                            neighbours_.push_back(other);
+                            neighbour_connections_.push_back(conn.index);
+                        }
+                    }
+                    neighbour_start_.push_back(neighbours_.size());
+                }
+            }
+
+            // A neighbour is upstream if the total flux goes from it into the cell.
+            // The ordering only depends on these directions, so it is kept
+            // as long as they do not change.
+            std::vector<char> upstream(neighbours_.size());
+            for (int cell = 0; cell < num_cells; ++cell) {
+                for (int pos = neighbour_start_[cell]; pos < neighbour_start_[cell + 1]; ++pos) {
+                    const int conn = neighbour_connections_[pos];
+                    const bool from_cell = graph_.connectionCells(conn)[0] == cell;
+                    const double outflux = from_cell ? total_flux_[conn] : -total_flux_[conn];
+                    upstream[pos] = outflux < 0.0;
+                }
+            }
+            if (upstream == upstream_ && !schedule_.components().empty()) {
+                OpmLog::debug("Flux directions unchanged, reusing ordering.");
+                return;
+            }
+            upstream_.swap(upstream);
+            schedule_.compute(neighbour_start_, neighbours_, upstream_);
+            OpmLog::debug(std::string("Number of components: ") + std::to_string(schedule_.numComponents())
+                          + ", number of levels: " + std::to_string(schedule_.numLevels()));
         }
 
 
@@ -609,14 +645,46 @@ namespace Opm {
             max_abs_dx_cell_[0] = -1;
             max_abs_dx_cell_[1] = -1;
 
-            // Solve the equations.
-            const int num_components = components_.size() - 1;
-            for (int comp = 0; comp < num_components; ++comp) {
-                const int comp_size = components_[comp + 1] - components_[comp];
-                if (comp_size == 1) {
-                    solveSingleCell(sequence_[components_[comp]]);
-                } else {
-                    solveMultiCell(comp_size, &sequence_[components_[comp]]);
+            // Solve the equations. The components of a level do not
+            // neighbour each other and are solved in parallel, in batches
+            // of single cells solved in lock step.
+            const std::vector<int>& sequence = schedule_.sequence();
+            const std::vector<int>& components = schedule_.components();
+            const std::vector<int>& level_start = schedule_.levelStart();
+            const std::vector<int>& level_components = schedule_.levelComponents();
+            const int num_levels = schedule_.numLevels();
+            const int batch_size = 64;
+#pragma omp parallel
+            {
+                std::array<double, 2> max_abs_dx = {{ 0.0, 0.0 }};
+                std::array<int, 2> max_abs_dx_cell = {{ -1, -1 }};
+                CellBatch batch;
+                for (int level = 0; level < num_levels; ++level) {
+                    const int level_end = level_start[level + 1];
+#pragma omp for schedule(dynamic, 1)
+                    for (int first = level_start[level]; first < level_end; first += batch_size) {
+                        batch.cells.clear();
+                        for (int ii = first; ii < std::min(first + batch_size, level_end); ++ii) {
+                            const int comp = level_components[ii];
+                            const int comp_size = components[comp + 1] - components[comp];
+                            const int cell = sequence[components[comp]];
+                            if (comp_size == 1 && substeps_[cell] > 1) {
+                                solveLocalSteps(cell, max_abs_dx, max_abs_dx_cell);
+                            } else if (comp_size == 1) {
+                                batch.cells.push_back(cell);
+                            } else {
+                                solveMultiCell(comp_size, &sequence[components[comp]], max_abs_dx, max_abs_dx_cell);
+                            }
+                        }
+                        solveCellBatch(batch, max_abs_dx, max_abs_dx_cell);
+                    }
+                }
+#pragma omp critical
+                for (int ii = 0; ii < 2; ++ii) {
+                    if (max_abs_dx[ii] > max_abs_dx_[ii]) {
+                        max_abs_dx_[ii] = max_abs_dx[ii];
+                        max_abs_dx_cell_[ii] = max_abs_dx_cell[ii];
+                    }
                 }
             }
 
@@ -633,23 +701,125 @@ namespace Opm {
 
 
 
-        void solveSingleCell(const int cell)
+        /// Start and fluxes of a local sub-step of a cell.
+        struct LocalStep
+        {
+            // oil and gas accumulation at the start of the sub-step
+            double ao0;
+            double ag0;
+            // number of sub-steps of the time step
+            double scale;
+            // connections computed by the cell and their oil and gas
+            // component fluxes, set by assembleSingleCell()
+            std::vector<std::pair<int, std::array<double, 2>>> flux;
+        };
+
+
+
+
+        /// Flag the cells whose CFL number, the total outflow of a time step
+        /// relative to the pore volume, exceeds the target, and give them
+        /// enough local sub-steps to reach it.
+        void computeLocalSteps()
+        {
+            const int num_cells = Opm::AutoDiffGrid::numCells(grid_);
+            substeps_.assign(num_cells, 1);
+            local_flux_.resize(total_flux_.size());
+            const double target = Base::param_.local_cfl_target_;
+            if (target <= 0.0) {
+                return;
+            }
+            const int max_substeps = std::max(Base::param_.local_max_substeps_, 1);
+            int num_local = 0;
+            for (int cell = 0; cell < num_cells; ++cell) {
+                double outflux = std::max(-total_wellflux_cell_[cell], 0.0);
+                for (auto conn : graph_.cellConnections(cell)) {
+                    const auto conn_cells = graph_.connectionCells(conn.index);
+                    if (conn_cells[0] >= 0 && conn_cells[1] >= 0) {
+                        outflux += std::max(conn.sign * total_flux_[conn.index], 0.0);
+                    }
+                }
+                const double cfl = outflux / Base::pvdt_[cell];
+                if (cfl > target) {
+                    substeps_[cell] = std::min(max_substeps, static_cast<int>(std::ceil(cfl / target)));
+                    ++num_local;
+                }
+            }
+            OpmLog::debug("Cells solved in local sub-steps: " + std::to_string(num_local));
+        }
+
+
+
+
+        /// True if the flux over the connection is computed by the cell of
+        /// conn, i.e. the total flux leaves it, or for no total flux it is
+        /// the first cell of the connection.
+        bool ownsConnection(const detail::Connection& conn) const
+        {
+            const double vt = conn.sign * total_flux_[conn.index];
+            return vt > 0.0 || (vt == 0.0 && conn.sign > 0.0);
+        }
+
+
+
+
+        /// Solve a cell in substeps_[cell] local sub-steps of the time step.
+        /// The fluxes from sub-stepped upstream cells are their time averages
+        /// and the other neighbours keep their values of the end of the step,
+        /// as in solveSingleCell(). The time averages of the fluxes computed
+        /// by the cell are stored for its neighbours, so the local steps
+        /// conserve mass.
+        void solveLocalSteps(const int cell,
+                             std::array<double, 2>& max_abs_dx,
+                             std::array<int, 2>& max_abs_dx_cell)
+        {
+            const int num_steps = substeps_[cell];
+            LocalStep local;
+            local.ao0 = oilAccumulation(cstate0_[cell]) * state0_.pv_mult[cell];
+            local.ag0 = gasAccumulation(cstate0_[cell]) * state0_.pv_mult[cell];
+            local.scale = num_steps;
+            std::vector<std::array<double, 2>> average;
+            for (int step = 0; step < num_steps; ++step) {
+                solveSingleCell(cell, max_abs_dx, max_abs_dx_cell, &local);
+                // the connections of a cell do not change between the sub-steps
+                average.resize(local.flux.size(), std::array<double, 2>{{ 0.0, 0.0 }});
+                for (std::size_t ii = 0; ii < local.flux.size(); ++ii) {
+                    average[ii][0] += local.flux[ii].second[0] / num_steps;
+                    average[ii][1] += local.flux[ii].second[1] / num_steps;
+                }
+                local.ao0 = oilAccumulation(cstate_[cell]) * state_.pv_mult[cell];
+                local.ag0 = gasAccumulation(cstate_[cell]) * state_.pv_mult[cell];
+            }
+            for (std::size_t ii = 0; ii < local.flux.size(); ++ii) {
+                local_flux_[local.flux[ii].first] = average[ii];
+            }
+        }
+
+
+
+
+
+        void solveSingleCell(const int cell,
+                             std::array<double, 2>& max_abs_dx,
+                             std::array<int, 2>& max_abs_dx_cell,
+                             LocalStep* local = nullptr)
         {
 
             Vec2 res;
             Mat22 jac;
-            assembleSingleCell(cell, res, jac);
+            assembleSingleCell(cell, res, jac, local);
+            const double scale = local ? local->scale : 1.0;
 
             // Newton loop.
             int iter = 0;
             const int max_iter = 25;
             double relaxation = 1.0;
-            while (!getConvergence(cell, res) && iter < max_iter) {
+            while (!getConvergence(cell, res, scale) && iter < max_iter) {
                 Vec2 dx;
                 jac.solve(dx, res);
                 dx *= relaxation;
-                updateState(cell, -dx);
-                assembleSingleCell(cell, res, jac);
+                updateState(cell, -dx, max_abs_dx, max_abs_dx_cell);
+                assembleSingleCell(cell, res, jac, local);
                 ++iter;
                 // if (iter > 15) {
                 //     relaxation = 0.7;
@@ -665,6 +835,8 @@ namespace Opm {
                 os << "Failed to converge in cell " << cell << ", residual = " << res
                    << ", cell values { s = ( " << cstate_[cell].s[Water] << ", " << cstate_[cell].s[Oil] << ", " << cstate_[cell].s[Gas]
                    << " ), rs = " << cstate_[cell].rs << ", rv = " << cstate_[cell].rv << " }";
+                // cells are solved in parallel
+#pragma omp critical
                 OpmLog::debug(os.str());
             }
         }
@@ -673,11 +845,124 @@ namespace Opm {
 
 
 
-        void solveMultiCell(const int comp_size, const int* cell_array)
+        /// Residuals and jacobians of a batch of cells, one array per entry.
+        struct CellBatch
+        {
+            std::vector<int> cells;
+            std::vector<int> active;
+            std::vector<int> failed;
+            std::vector<double> res0, res1;
+            std::vector<double> jac00, jac01, jac10, jac11;
+            std::vector<double> dx0, dx1;
+        };
+
+
+
+
+        /// Solve the cells of the batch, which must be independent of each
+        /// other, with the same Newton iterations as solveSingleCell(). All
+        /// unconverged cells take a step together, such that the 2x2 updates
+        /// run over contiguous arrays. The property evaluations are still
+        /// done cell by cell.
+        void solveCellBatch(CellBatch& batch,
+                            std::array<double, 2>& max_abs_dx,
+                            std::array<int, 2>& max_abs_dx_cell)
+        {
+            const int n = batch.cells.size();
+            for (auto* v : { &batch.res0, &batch.res1, &batch.jac00, &batch.jac01,
+                             &batch.jac10, &batch.jac11, &batch.dx0, &batch.dx1 }) {
+                v->resize(n);
+            }
+            // Assemble cell k of the batch, returns true if it has converged.
+            auto assemble = [this, &batch](const int k)
+            {
+                Vec2 res;
+                Mat22 jac;
+                assembleSingleCell(batch.cells[k], res, jac);
+                batch.res0[k] = res[0];
+                batch.res1[k] = res[1];
+                batch.jac00[k] = jac[0][0];
+                batch.jac01[k] = jac[0][1];
+                batch.jac10[k] = jac[1][0];
+                batch.jac11[k] = jac[1][1];
+                return getConvergence(batch.cells[k], res);
+            };
+
+            batch.active.clear();
+            batch.failed.clear();
+            for (int k = 0; k < n; ++k) {
+                if (!assemble(k)) {
+                    batch.active.push_back(k);
+                }
+            }
+
+            // Newton loop.
+            const int max_iter = 25;
+            for (int iter = 0; iter < max_iter && !batch.active.empty(); ++iter) {
+                const int num_active = batch.active.size();
+                const int* active = batch.active.data();
+                const double* r0 = batch.res0.data();
+                const double* r1 = batch.res1.data();
+                const double* j00 = batch.jac00.data();
+                const double* j01 = batch.jac01.data();
+                const double* j10 = batch.jac10.data();
+                const double* j11 = batch.jac11.data();
+                double* dx0 = batch.dx0.data();
+                double* dx1 = batch.dx1.data();
+                // Same formula as the 2x2 solve of Dune::FieldMatrix.
+#pragma omp simd
+                for (int a = 0; a < num_active; ++a) {
+                    const int k = active[a];
+                    const double detinv = 1.0 / (j00[k]*j11[k] - j01[k]*j10[k]);
+                    dx0[k] = detinv * (j11[k]*r0[k] - j01[k]*r1[k]);
+                    dx1[k] = detinv * (j00[k]*r1[k] - j10[k]*r0[k]);
+                }
+
+                int num_left = 0;
+                for (int a = 0; a < num_active; ++a) {
+                    const int k = active[a];
+                    if (!std::isfinite(dx0[k]) || !std::isfinite(dx1[k])) {
+                        // singular jacobian, give up on this cell
+                        batch.failed.push_back(k);
+                        continue;
+                    }
+                    Vec2 dx;
+                    dx[0] = -dx0[k];
+                    dx[1] = -dx1[k];
+                    updateState(batch.cells[k], dx, max_abs_dx, max_abs_dx_cell);
+                    if (!assemble(k)) {
+                        batch.active[num_left++] = k;
+                    }
+                }
+                batch.active.resize(num_left);
+            }
+
+            batch.failed.insert(batch.failed.end(), batch.active.begin(), batch.active.end());
+            for (const int k : batch.failed) {
+                const int cell = batch.cells[k];
+                std::ostringstream os;
+                os << "Failed to converge in cell " << cell << ", residual = " << batch.res0[k] << " " << batch.res1[k]
+                   << ", cell values { s = ( " << cstate_[cell].s[Water] << ", " << cstate_[cell].s[Oil] << ", " << cstate_[cell].s[Gas]
+                   << " ), rs = " << cstate_[cell].rs << ", rv = " << cstate_[cell].rv << " }";
+#pragma omp critical
+                OpmLog::debug(os.str());
+            }
+        }
+
+
+
+
+        void solveMultiCell(const int comp_size, const int* cell_array,
+                            std::array<double, 2>& max_abs_dx,
+                            std::array<int, 2>& max_abs_dx_cell)
         {
             // OpmLog::warning("solveMultiCell", "solveMultiCell() called with component size " + std::to_string(comp_size));
             for (int ii = 0; ii < comp_size; ++ii) {
-                solveSingleCell(cell_array[ii]);
+                if (substeps_[cell_array[ii]] > 1) {
+                    solveLocalSteps(cell_array[ii], max_abs_dx, max_abs_dx_cell);
+                } else {
+                    solveSingleCell(cell_array[ii], max_abs_dx, max_abs_dx_cell);
+                }
             }
         }
 
@@ -715,7 +1000,9 @@ namespace Opm {
 
 
 
-        void assembleSingleCell(const int cell, Vec2& res, Mat22& jac)
+        /// Assemble the equations of a cell over the time step, or over a
+        /// local sub-step if local is given.
+        void assembleSingleCell(const int cell, Vec2& res, Mat22& jac, LocalStep* local = nullptr)
         {
             assert(numPhases() == 3); // I apologize for this to my future self, that will have to fix it.
 
@@ -726,10 +1013,14 @@ namespace Opm {
             // Accumulation terms.
             const double pvm0 = state0_.pv_mult[cell];
             const double pvm = state_.pv_mult[cell];
-            const double ao0 = oilAccumulation(cstate0_[cell]) * pvm0;
+            const double ao0 = local ? local->ao0 : oilAccumulation(cstate0_[cell]) * pvm0;
             const Eval ao  = oilAccumulation(st) * pvm;
-            const double ag0 = gasAccumulation(cstate0_[cell]) * pvm0;
+            const double ag0 = local ? local->ag0 : gasAccumulation(cstate0_[cell]) * pvm0;
             const Eval ag  = gasAccumulation(st) * pvm;
+            const double pvdt = local ? Base::pvdt_[cell] * local->scale : Base::pvdt_[cell];
+            if (local) {
+                local->flux.clear();
+            }
 
             // Flux terms.
             Eval div_oilflux = Eval::createConstant(0.0);
@@ -743,6 +1034,13 @@ namespace Opm {
                 }
                 assert((from == cell) == (conn.sign > 0.0));
                 const int other = from == cell ? to : from;
+                const bool owned = ownsConnection(conn);
+                if (!owned && substeps_[other] > 1) {
+                    // Time averaged flux of the local sub-steps of the other cell.
+                    div_oilflux -= local_flux_[conn.index][0];
+                    div_gasflux -= local_flux_[conn.index][1];
+                    continue;
+                }
                 const double vt = conn.sign * total_flux_[conn.index];
                 const double gdz = conn.sign * gdz_[conn.index];
 
@@ -793,8 +1091,13 @@ namespace Opm {
                     }
                     flux[phase] = b[phase] * (mob[phase] / tot_mob) * (vt + tran*gflux);
                 }
-                div_oilflux += flux[Oil] + rv*flux[Gas];
-                div_gasflux += flux[Gas] + rs*flux[Oil];
+                const Eval oilflux = flux[Oil] + rv*flux[Gas];
+                const Eval gasflux = flux[Gas] + rs*flux[Oil];
+                div_oilflux += oilflux;
+                div_gasflux += gasflux;
+                if (local && owned) {
+                    local->flux.emplace_back(conn.index, std::array<double, 2>{{ oilflux.value(), gasflux.value() }});
+                }
             }
 
             // Well fluxes.
@@ -813,8 +1116,8 @@ namespace Opm {
                 div_gasflux -= (gasflux + st.rs * oilflux);
             }
 
-            const Eval oileq = Base::pvdt_[cell]*(ao - ao0) + div_oilflux;
-            const Eval gaseq = Base::pvdt_[cell]*(ag - ag0) + div_gasflux;
+            const Eval oileq = pvdt*(ao - ao0) + div_oilflux;
+            const Eval gaseq = pvdt*(ag - ag0) + div_gasflux;
 
             res[0] = oileq.value();
             res[1] = gaseq.value();
@@ -828,12 +1131,14 @@ namespace Opm {
 
 
 
-        bool getConvergence(const int cell, const Vec2& res)
+        /// Convergence of a cell, scale is the number of local sub-steps.
+        bool getConvergence(const int cell, const Vec2& res, const double scale = 1.0)
         {
             const double tol = 1e-7;
             // Compute scaled residuals (scaled like saturations).
-            double sres[] = { res[0] / (cstate_[cell].b[Oil] * Base::pvdt_[cell]),
-                              res[1] / (cstate_[cell].b[Gas] * Base::pvdt_[cell]) };
+            const double pvdt = Base::pvdt_[cell] * scale;
+            double sres[] = { res[0] / (cstate_[cell].b[Oil] * pvdt),
+                              res[1] / (cstate_[cell].b[Gas] * pvdt) };
             return std::fabs(sres[0]) < tol && std::fabs(sres[1]) < tol;
         }
 
@@ -841,16 +1146,18 @@ namespace Opm {
 
 
         void updateState(const int cell,
-                         const Vec2& dx)
+                         const Vec2& dx,
+                         std::array<double, 2>& max_abs_dx,
+                         std::array<int, 2>& max_abs_dx_cell)
         {
-            if (std::fabs(dx[0]) > max_abs_dx_[0]) {
-                max_abs_dx_cell_[0] = cell;
+            if (std::fabs(dx[0]) > max_abs_dx[0]) {
+                max_abs_dx_cell[0] = cell;
             }
-            if (std::fabs(dx[1]) > max_abs_dx_[1]) {
-                max_abs_dx_cell_[1] = cell;
+            if (std::fabs(dx[1]) > max_abs_dx[1]) {
+                max_abs_dx_cell[1] = cell;
             }
-            max_abs_dx_[0] = std::max(max_abs_dx_[0], std::fabs(dx[0]));
-            max_abs_dx_[1] = std::max(max_abs_dx_[1], std::fabs(dx[1]));
+            max_abs_dx[0] = std::max(max_abs_dx[0], std::fabs(dx[0]));
+            max_abs_dx[1] = std::max(max_abs_dx[1], std::fabs(dx[1]));
 
             // Get saturation updates.
             const double dsw = dx[0];
@@ -22,20 +22,31 @@
 #define OPM_BLACKOILSEQUENTIALMODEL_HEADER_INCLUDED
 
 
+#include <opm/autodiff/AndersonAcceleration.hpp>
 #include <opm/autodiff/BlackoilModelBase.hpp>
 #include <opm/core/simulator/BlackoilState.hpp>
 #include <opm/autodiff/WellStateFullyImplicitBlackoil.hpp>
 #include <opm/autodiff/BlackoilModelParameters.hpp>
 #include <opm/simulators/timestepping/SimulatorTimerInterface.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 namespace Opm {
 
     struct BlackoilSequentialModelParameters : public BlackoilModelParameters
     {
         bool iterate_to_fully_implicit;
+        // number of previous outer iterations used by the Anderson acceleration
+        // of the iteration to the fully implicit solution, 0 disables it
+        int anderson_depth;
+        // relaxation factor of the Anderson acceleration
+        double anderson_relaxation;
         explicit BlackoilSequentialModelParameters( const ParameterGroup& param )
             : BlackoilModelParameters(param),
-              iterate_to_fully_implicit(param.getDefault("iterate_to_fully_implicit", false))
+              iterate_to_fully_implicit(param.getDefault("iterate_to_fully_implicit", false)),
+              anderson_depth(param.getDefault("anderson_depth", 0)),
+              anderson_relaxation(param.getDefault("anderson_relaxation", 1.0))
         {
         }
     };
@@ -95,7 +106,12 @@ namespace Opm {
           pressure_solver_(typename PressureSolver::SolverParameters(), std::move(pressure_model_)),
           transport_solver_(typename TransportSolver::SolverParameters(), std::move(transport_model_)),
           initial_reservoir_state_(0, 0, 0), // will be overwritten
-          iterate_to_fully_implicit_(param.iterate_to_fully_implicit)
+          iterate_to_fully_implicit_(param.iterate_to_fully_implicit),
+          use_anderson_(param.anderson_depth > 0),
+          anderson_(param.anderson_depth, param.anderson_relaxation),
+          pressure_scale_(1.0),
+          rs_scale_(1.0),
+          rv_scale_(1.0)
         {
             typename PressureSolver::SolverParameters pp;
             pp.min_iter_ = 0;
@@ -119,6 +135,10 @@ namespace Opm {
         {
             initial_reservoir_state_ = reservoir_state;
             initial_well_state_ = well_state;
+            if (use_anderson_) {
+                anderson_.reset();
+                setAndersonScaling(reservoir_state);
+            }
         }
 
 
@@ -180,6 +200,12 @@ namespace Opm {
                     OpmLog::info("Using sequential model in iterative mode, outer iteration " + std::to_string(iteration));
                 }
 
+                // the iterate of the outer iteration
+                AndersonAcceleration::Vector outer_iterate;
+                if (use_anderson_) {
+                    outer_iterate = packState(reservoir_state);
+                }
+
                 // Pressure solve.
                 if (terminalOutputEnabled()) {
                     OpmLog::info("Solving the pressure equation.");
@@ -213,6 +239,16 @@ namespace Opm {
                     }
                 }
 
+                // Replace the result of the pressure and transport solves by the
+                // accelerated iterate, the well state is kept.
+                if (use_anderson_ && !done) {
+                    unpackState(anderson_.update(outer_iterate, packState(reservoir_state)), reservoir_state);
+                    if (terminalOutputEnabled()) {
+                        OpmLog::info("Anderson acceleration with " + std::to_string(anderson_.historySize())
+                                     + " previous outer iterations.");
+                    }
+                }
+
                 SimulatorReport report;
                 report.converged = done;
                 report.total_linear_iterations = pressure_liniter + transport_liniter;
@@ -313,6 +349,67 @@ namespace Opm {
         { return failureReport_; }
 
     protected:
+        /// Set the scaling of the pressures and of the dissolved gas-oil and
+        /// vaporized oil-gas ratios, which makes the components of the state
+        /// vector of the Anderson acceleration of similar size.
+        void setAndersonScaling(const ReservoirState& state)
+        {
+            auto largest = [](const std::vector<double>& v) {
+                double value = 0.0;
+                for (const double x : v) {
+                    value = std::max(value, std::abs(x));
+                }
+                return value > 0.0 ? value : 1.0;
+            };
+            pressure_scale_ = largest(state.pressure());
+            rs_scale_ = largest(state.gasoilratio());
+            rv_scale_ = largest(state.rv());
+        }
+
+        /// The scaled pressures, saturations, rs and rv of a state.
+        AndersonAcceleration::Vector packState(const ReservoirState& state) const
+        {
+            const int nc = state.pressure().size();
+            const int nsat = state.saturation().size();
+            AndersonAcceleration::Vector x(nc + nsat + 2*nc);
+            for (int c = 0; c < nc; ++c) {
+                x[c] = state.pressure()[c] / pressure_scale_;
+                x[nc + nsat + c] = state.gasoilratio()[c] / rs_scale_;
+                x[2*nc + nsat + c] = state.rv()[c] / rv_scale_;
+            }
+            for (int i = 0; i < nsat; ++i) {
+                x[nc + i] = state.saturation()[i];
+            }
+            return x;
+        }
+
+        /// Set a state from a vector of packState(), with the saturations
+        /// of each cell cut to [0, 1] and normalized, and rs and rv not
+        /// negative.
+        void unpackState(const AndersonAcceleration::Vector& x, ReservoirState& state) const
+        {
+            const int nc = state.pressure().size();
+            const int nsat = state.saturation().size();
+            const int np = nsat / nc;
+            for (int c = 0; c < nc; ++c) {
+                state.pressure()[c] = x[c] * pressure_scale_;
+                state.gasoilratio()[c] = std::max(x[nc + nsat + c], 0.0) * rs_scale_;
+                state.rv()[c] = std::max(x[2*nc + nsat + c], 0.0) * rv_scale_;
+
+                double sum = 0.0;
+                for (int p = 0; p < np; ++p) {
+                    double& sat = state.saturation()[c*np + p];
+                    sat = std::min(std::max(x[nc + c*np + p], 0.0), 1.0);
+                    sum += sat;
+                }
+                if (sum > 0.0) {
+                    for (int p = 0; p < np; ++p) {
+                        state.saturation()[c*np + p] /= sum;
+                    }
+                }
+            }
+        }
+
         SimulatorReport failureReport_;
 
         std::unique_ptr<PressureModel> pressure_model_;
@@ -324,6 +421,13 @@ namespace Opm {
         WellState initial_well_state_;
 
         bool iterate_to_fully_implicit_;
+
+        // acceleration of the iteration to the fully implicit solution
+        bool use_anderson_;
+        AndersonAcceleration anderson_;
+        double pressure_scale_;
+        double rs_scale_;
+        double rv_scale_;
     };
 
 } // namespace Opm
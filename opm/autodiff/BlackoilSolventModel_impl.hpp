@@ -271,7 +271,8 @@ namespace Opm {
             const ADB& pg = state.canonical_phase_pressures[pu.phase_pos[Gas]];
             const std::vector<PhasePresence>& cond = phaseCondition();
             sd_.rq[solvent_pos_].b = fluidReciprocFVF(Solvent, pg, state.temperature, state.rs, state.rv,cond);
-            sd_.rq[solvent_pos_].accum[aix] = pv_mult * sd_.rq[solvent_pos_].b * ss;
+            sd_.rq[solvent_pos_].accum[aix] = pv_mult * sd_.rq[solvent_pos_].b;
+            sd_.rq[solvent_pos_].accum[aix] *= ss;
         }
     }
 
@@ -290,7 +291,7 @@ namespace Opm {
         if (has_solvent_) {
             residual_.material_balance_eq[ solvent_pos_ ] =
                 pvdt_ * (sd_.rq[solvent_pos_].accum[1] - sd_.rq[solvent_pos_].accum[0])
-                + ops_.div*sd_.rq[solvent_pos_].mflux;
+                + ops_.stencil.div*sd_.rq[solvent_pos_].mflux;
         }
 
     }
@@ -887,9 +888,12 @@ namespace Opm {
         const ADB& pg = state.canonical_phase_pressures[pu.phase_pos[Gas]];
         const std::vector<PhasePresence>& cond = phaseCondition();
 
-        const ADB mu_w = fluid_.muWat(pw, state.temperature, cells_);
-        const ADB mu_o = fluid_.muOil(po, state.temperature, state.rs, cond, cells_);
-        const ADB mu_g = fluid_.muGas(pg, state.temperature, state.rv, cond, cells_);
+        ADB mu_w = ADB::null(), bw = ADB::null();
+        ADB mu_o = ADB::null(), bo = ADB::null();
+        ADB mu_g = ADB::null(), bg = ADB::null();
+        fluid_.muAndBWat(pw, state.temperature, cells_, mu_w, bw);
+        fluid_.muAndBOil(po, state.temperature, state.rs, cond, cells_, mu_o, bo);
+        fluid_.muAndBGas(pg, state.temperature, state.rv, cond, cells_, mu_g, bg);
         const ADB mu_s = solvent_props_.muSolvent(pg,cells_);
         std::vector<ADB> viscosity(np + 1, ADB::null());
         viscosity[pu.phase_pos[Oil]] = mu_o;
@@ -898,9 +902,6 @@ namespace Opm {
         viscosity[solvent_pos_] = mu_s;
 
         // Density
-        const ADB bw = fluid_.bWat(pw, state.temperature, cells_);
-        const ADB bo = fluid_.bOil(po, state.temperature, state.rs, cond, cells_);
-        const ADB bg = fluid_.bGas(pg, state.temperature, state.rv, cond, cells_);
         const ADB bs = solvent_props_.bSolvent(pg, cells_);
 
         std::vector<ADB> density(np + 1, ADB::null());
@@ -25,6 +25,7 @@
 #include <opm/core/simulator/BlackoilState.hpp>
 #include <opm/autodiff/WellStateFullyImplicitBlackoil.hpp>
 #include <opm/autodiff/BlackoilModelParameters.hpp>
+#include <opm/autodiff/NewtonIterationBlackoilInterleaved.hpp>
 #include <opm/simulators/timestepping/SimulatorTimerInterface.hpp>
 #include <opm/autodiff/multiPhaseUpwind.hpp>
 
@@ -53,7 +54,10 @@ namespace Opm {
         /// \param[in] geo              rock properties
         /// \param[in] rock_comp_props  if non-null, rock compressibility properties
         /// \param[in] wells_arg        well structure
-        /// \param[in] linsolver        linear solver
+        /// \param[in] linsolver        linear solver, only its parallel
+        ///                             information is used, the transport
+        ///                             systems are solved with an ILU0
+        ///                             preconditioned BiCGStab
         /// \param[in] eclState         eclipse state
         /// \param[in] has_disgas       turn on dissolved gas
         /// \param[in] has_vapoil       turn on vaporized oil feature
@@ -71,6 +75,7 @@ namespace Opm {
                                const bool                              terminal_output)
             : Base(param, grid, fluid, geo, rock_comp_props, std_wells, linsolver,
                    eclState, has_disgas, has_vapoil, terminal_output)
+            , transport_linsolver_(ParameterGroup(), linsolver.parallelInformation())
         {
         }
 
@@ -173,6 +178,9 @@ namespace Opm {
 
         /// Solve the Jacobian system Jx = r where J is the Jacobian and
         /// r is the residual.
+        /// Only the saturation and Rs/Rv/Sg unknowns are variables of the
+        /// transport equations, so the system has 2x2 blocks without the
+        /// frozen pressure.
         V solveJacobianSystem() const
         {
             const int n_transport = residual_.material_balance_eq[1].size();
@@ -181,8 +189,8 @@ namespace Opm {
             LinearisedBlackoilResidual transport_res = {
                 {
                     // TODO: handle general 2-phase etc.
-                    ADB::function(mb[1].value(), { mb[1].derivative()[1], mb[1].derivative()[2] }),
-                    ADB::function(mb[2].value(), { mb[2].derivative()[1], mb[2].derivative()[2] })
+                    mb[1],
+                    mb[2]
                 },
                 ADB::null(),
                 ADB::null(),
@@ -190,7 +198,7 @@ namespace Opm {
                 residual_.singlePrecision
             };
             assert(transport_res.sizeNonLinear() == 2*n_transport);
-            V dx_transport = linsolver_.computeNewtonIncrement(transport_res);
+            V dx_transport = transport_linsolver_.computeNewtonIncrement(transport_res);
             assert(dx_transport.size() == 2*n_transport);
             V dx_full = V::Zero(n_full);
             for (int i = 0; i < 2*n_transport; ++i) {
@@ -201,6 +209,14 @@ namespace Opm {
 
 
 
+        /// Number of linear iterations used in last call to solveJacobianSystem().
+        int linearIterationsLastSolve() const
+        {
+            return transport_linsolver_.iterations();
+        }
+
+
+
 
 
         using Base::numPhases;
@@ -235,6 +251,7 @@ namespace Opm {
         V total_wellperf_flux_;
         DataBlock comp_wellperf_flux_;
         Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic> upwind_flags_;
+        NewtonIterationBlackoilInterleaved transport_linsolver_;
 
 
 
@@ -245,12 +262,19 @@ namespace Opm {
                       const WellState& xw) const
         {
             // As Base::variableState(), except making Pressure, Qs and Bhp constants.
+            // Only Sw and Xvar are variables, such that the jacobians have
+            // just their two blocks.
+            // TODO: handle general 2-phase etc.
             std::vector<V> vars0 = asImpl().variableStateInitials(x, xw);
-            std::vector<ADB> vars = ADB::variables(vars0);
             const std::vector<int> indices = asImpl().variableStateIndices();
-            vars[indices[Pressure]] = ADB::constant(vars[indices[Pressure]].value());
-            vars[indices[Qs]] = ADB::constant(vars[indices[Qs]].value());
-            vars[indices[Bhp]] = ADB::constant(vars[indices[Bhp]].value());
+            std::vector<ADB> vars;
+            vars.reserve(vars0.size());
+            for (const V& v : vars0) {
+                vars.push_back(ADB::constant(v));
+            }
+            const std::vector<ADB> transport_vars = ADB::variables({ vars0[indices[Sw]], vars0[indices[Xvar]] });
+            vars[indices[Sw]] = transport_vars[0];
+            vars[indices[Xvar]] = transport_vars[1];
             return asImpl().variableStateExtractVars(x, indices, vars);
         }
 
@@ -384,21 +408,12 @@ namespace Opm {
             assert(numPhases() == 3);
             const int num_connections = head_diff[0].size();
             Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic> upwind(num_connections, numPhases());
-            for (int conn = 0; conn < num_connections; ++conn) {
-                const double q = total_flux_[conn];
-                const double t = transmissibility[conn];
-                const int a = ops_.connection_cells(conn, 0); // first cell of connection
-                const int b = ops_.connection_cells(conn, 1); // second cell of connection
-                auto up = connectionMultiPhaseUpwind(
-                    {{ head_diff[0].value()[conn], head_diff[1].value()[conn], head_diff[2].value()[conn] }},
-                    {{ sd_.rq[0].mob.value()[a], sd_.rq[1].mob.value()[a], sd_.rq[2].mob.value()[a]}},
-                    {{ sd_.rq[0].mob.value()[b], sd_.rq[1].mob.value()[b], sd_.rq[2].mob.value()[b]}},
-                    t,
-                    q);
-                for (int ii = 0; ii < numPhases(); ++ii) {
-                    upwind(conn, ii) = up[ii];
-                }
-            }
+            assert(ops_.connection_cells.rows() == num_connections);
+            Opm::multiPhaseUpwind(num_connections, ops_.connection_cells.data(),
+                                  {{ head_diff[0].value().data(), head_diff[1].value().data(), head_diff[2].value().data() }},
+                                  {{ sd_.rq[0].mob.value().data(), sd_.rq[1].mob.value().data(), sd_.rq[2].mob.value().data() }},
+                                  transmissibility.data(), total_flux_.data(),
+                                  {{ upwind.col(0).data(), upwind.col(1).data(), upwind.col(2).data() }});
             return upwind;
         }
 
@@ -0,0 +1,403 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef OPM_BLOCKCPRPRECONDITIONER_HEADER_INCLUDED
+#define OPM_BLOCKCPRPRECONDITIONER_HEADER_INCLUDED
+
+#include <opm/autodiff/CPRPreconditioner.hpp>
+#include <opm/autodiff/MultiscalePressureSolver.hpp>
+#include <opm/autodiff/ParallelOverlappingILU0.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/unused.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/paamg/pinfo.hh>
+
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace Opm
+{
+    namespace detail
+    {
+        /// \brief Compute the quasi-IMPES weights of all cells.
+        ///
+        /// The weights w_i of cell i solve D_ii^T w_i = e_p, where D_ii is
+        /// the diagonal block and e_p the unit vector of the pressure
+        /// variable. Combining the equations of a cell with these weights
+        /// decouples the pressure from the other cell variables locally.
+        template <int pressureIndex, class M, class Weights>
+        void computeQuasiImpesWeights(const M& A, std::vector<Weights>& weights)
+        {
+            typedef typename M::field_type Scalar;
+            static const int numEq = M::block_type::rows;
+            typedef Dune::FieldMatrix<Scalar, numEq, numEq> Block;
+
+            weights.resize( A.N() );
+            const auto endi = A.end();
+            for( auto row = A.begin(); row != endi; ++row )
+            {
+                // the row of D_ii^{-1} belonging to the pressure is w_i
+                Block diag( (*row)[ row.index() ] );
+                diag.invert();
+                Weights& w = weights[ row.index() ];
+                for( int k = 0; k < numEq; ++k ) {
+                    w[ k ] = diag[ pressureIndex ][ k ];
+                }
+            }
+        }
+
+        /// \brief Create the sparsity pattern of the scalar pressure matrix,
+        ///        which is the block pattern of A.
+        template <class M, class PressureMatrix>
+        void createPressurePattern(const M& A, PressureMatrix& Ap)
+        {
+            Ap.setSize( A.N(), A.M(), A.nonzeroes() );
+            Ap.setBuildMode( PressureMatrix::row_wise );
+            for( auto row = Ap.createbegin(); row != Ap.createend(); ++row )
+            {
+                const auto& rowA = A[ row.index() ];
+                const auto endj = rowA.end();
+                for( auto col = rowA.begin(); col != endj; ++col )
+                {
+                    row.insert( col.index() );
+                }
+            }
+        }
+
+        /// \brief Compute the values of the pressure matrix
+        ///        (Ap)_ij = w_i^T A_ij e_p, which must have the pattern of A.
+        template <int pressureIndex, class M, class Weights, class PressureMatrix>
+        void computePressureMatrix(const M& A, const std::vector<Weights>& weights, PressureMatrix& Ap)
+        {
+            static const int numEq = M::block_type::rows;
+            const int n = A.N();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+            for( int i = 0; i < n; ++i )
+            {
+                const auto& rowA = A[ i ];
+                auto& rowP = Ap[ i ];
+                const Weights& w = weights[ i ];
+                auto colP = rowP.begin();
+                const auto endj = rowA.end();
+                for( auto col = rowA.begin(); col != endj; ++col, ++colP )
+                {
+                    assert( colP.index() == col.index() );
+                    typename M::field_type value = 0.0;
+                    for( int k = 0; k < numEq; ++k ) {
+                        value += w[ k ] * (*col)[ k ][ pressureIndex ];
+                    }
+                    *colP = value;
+                }
+            }
+        }
+
+        /// \brief Copy the scalar pressure matrix into the row-major sparse
+        ///        matrix of the multiscale pressure solver.
+        template <class PressureMatrix>
+        void copyPressureMatrix(const PressureMatrix& Ap, MultiscalePressureSolver::Matrix& matrix)
+        {
+            typedef Eigen::Triplet<double> Triplet;
+            std::vector<Triplet> entries;
+            entries.reserve( Ap.nonzeroes() );
+            const auto endi = Ap.end();
+            for( auto row = Ap.begin(); row != endi; ++row )
+            {
+                const auto endj = row->end();
+                for( auto col = row->begin(); col != endj; ++col )
+                {
+                    entries.push_back( Triplet( row.index(), col.index(), (*col)[ 0 ][ 0 ] ) );
+                }
+            }
+            matrix.resize( Ap.N(), Ap.M() );
+            matrix.setFromTriplets( entries.begin(), entries.end() );
+        }
+    } // end namespace detail
+
+    /*!
+      \brief Two-stage CPR preconditioner for block matrices.
+
+      Unlike CPRPreconditioner, which needs the elliptic part assembled
+      separately, this preconditioner works directly on the block-structured
+      Jacobian (one block per cell). The pressure system is extracted with
+      quasi-IMPES weights and preconditioned with one AMG cycle, or in
+      sequential runs optionally with the multiscale restriction-smoothed
+      basis solver, whose basis functions are kept between linear solves.
+      The second stage applies ILU0 to the defect of the pressure correction.
+
+      \tparam M The matrix type to operate on.
+      \tparam X Type of the update.
+      \tparam Y Type of the defect.
+      \tparam P Type of the parallel information.
+      \tparam pressureIndex The index of the pressure in the vector blocks.
+      \tparam SecondStage The ILU0 preconditioner for the whole system.
+    */
+    template<class M, class X, class Y,
+             class P=Dune::Amg::SequentialInformation,
+             int pressureIndex=0,
+             class SecondStage=ParallelOverlappingILU0<M,X,Y,P> >
+    class BlockCPRPreconditioner : public Dune::Preconditioner<X,Y>
+    {
+        typedef typename M::field_type Scalar;
+        static const int numEq = M::block_type::rows;
+
+    public:
+        //! \brief The matrix type the preconditioner is for.
+        typedef typename std::remove_const<M>::type matrix_type;
+        //! \brief The domain type of the preconditioner.
+        typedef X domain_type;
+        //! \brief The range type of the preconditioner.
+        typedef Y range_type;
+        //! \brief The field type of the preconditioner.
+        typedef typename X::field_type field_type;
+
+        // define the category
+        enum {
+            //! \brief The category the preconditioner is part of.
+            category = std::is_same<P,Dune::Amg::SequentialInformation>::value?
+            Dune::SolverCategory::sequential:Dune::SolverCategory::overlapping
+        };
+
+        //! \brief The scalar pressure matrix and vector.
+        typedef Dune::BCRSMatrix< Dune::FieldMatrix< Scalar, 1, 1 > > PressureMatrix;
+        typedef Dune::BlockVector< Dune::FieldVector< Scalar, 1 > >    PressureVector;
+
+        typedef ISTLUtility::CPRSelector< PressureMatrix, PressureVector, PressureVector, P > CPRSelectorType;
+        //! \brief Operator of the pressure system
+        typedef typename CPRSelectorType::Operator PressureOperator;
+        //! \brief amg preconditioner for the pressure system
+        typedef typename CPRSelectorType::AMG AMG;
+
+        typedef Dune::FieldVector< Scalar, numEq > Weights;
+
+        /*! \brief Constructor.
+
+          \param A       The matrix to operate on.
+          \param relax   The ILU0 relaxation factor of the second stage.
+          \param comm    The information about the parallelization, if this is a
+                         parallel run
+          \param param   The CPR parameters, only the coarsening and
+                         agglomeration of the pressure AMG are used.
+          \param msrsb   If given, the multiscale solver used instead of AMG for
+                         the pressure system, updated for the new pressure
+                         matrix. It must outlive the preconditioner and is only
+                         available for sequential runs.
+        */
+        BlockCPRPreconditioner (const M& A, const double relax,
+                                const P& comm, const CPRParameter& param = CPRParameter(),
+                                MultiscalePressureSolver* msrsb = nullptr)
+            : A_( A ),
+              weights_(),
+              Ap_(),
+              opAp_(),
+              amg_(),
+              ilu_(),
+              rp_( A.N() ),
+              xp_( A.N() ),
+              dmodified_( A.N() ),
+              vilu_( A.N() ),
+              comm_( comm ),
+              msrsb_( msrsb )
+        {
+            detail::computeQuasiImpesWeights< pressureIndex >( A_, weights_ );
+            detail::createPressurePattern( A_, Ap_ );
+            detail::computePressureMatrix< pressureIndex >( A_, weights_, Ap_ );
+
+            if( msrsb_ )
+            {
+                if( ! std::is_same< P, Dune::Amg::SequentialInformation >::value ) {
+                    OPM_THROW(std::logic_error, "The multiscale pressure solver is only available for sequential runs");
+                }
+                // first stage: multiscale solver for the pressure system,
+                // only the basis functions with changed mobilities are smoothed
+                MultiscalePressureSolver::Matrix matrix;
+                detail::copyPressureMatrix( Ap_, matrix );
+                msrsb_->update( matrix );
+                ilu_.reset( createSecondStage( relax, comm_ ) );
+                return;
+            }
+
+            // first stage: amg for the pressure system
+            opAp_.reset( CPRSelectorType::makeOperator( Ap_, comm_ ) );
+            ISTLUtility::createAMGPreconditionerPointer( *opAp_, 1.0, comm_, amg_,
+                                                         param.cpr_amg_coarsen_target_,
+                                                         param.cpr_amg_max_level_,
+                                                         param.amgAccumulationMode() );
+
+            // second stage: ilu0 for the whole system
+            ilu_.reset( createSecondStage( relax, comm_ ) );
+        }
+
+        /*!
+          \brief Prepare the preconditioner.
+
+          \copydoc Preconditioner::pre(X&,Y&)
+        */
+        virtual void pre (X& x, Y& b)
+        {
+            DUNE_UNUSED_PARAMETER(x);
+            DUNE_UNUSED_PARAMETER(b);
+            xp_ = 0;
+            rp_ = 0;
+            if( amg_ ) {
+                amg_->pre( xp_, rp_ );
+            }
+        }
+
+        /*!
+          \brief Apply the preconditioner.
+
+          \copydoc Preconditioner::apply(X&,const Y&)
+        */
+        virtual void apply (X& v, const Y& d)
+        {
+            const int n = A_.N();
+
+            // restrict the defect to the pressure equation
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+            for( int i = 0; i < n; ++i )
+            {
+                rp_[ i ] = weights_[ i ] * d[ i ];
+            }
+
+            // solve the pressure system approximately
+            xp_ = 0;
+            if( msrsb_ ) {
+                applyMultiscale();
+            }
+            else {
+                amg_->apply( xp_, rp_ );
+            }
+
+            // prolongate the pressure correction
+            v = 0;
+            for( int i = 0; i < n; ++i )
+            {
+                v[ i ][ pressureIndex ] = xp_[ i ];
+            }
+
+            // second stage on the remaining defect
+            dmodified_ = d;
+            A_.mmv( v, dmodified_ );
+            vilu_ = 0;
+            ilu_->apply( vilu_, dmodified_ );
+            v += vilu_;
+
+            // for parallel runs make the update consistent
+            comm_.copyOwnerToAll( v, v );
+        }
+
+        /*!
+          \brief Clean up.
+
+          \copydoc Preconditioner::post(X&)
+        */
+        virtual void post (X& x)
+        {
+            DUNE_UNUSED_PARAMETER(x);
+            if( amg_ ) {
+                amg_->post( xp_ );
+            }
+        }
+
+        //! \brief The pressure matrix of the first stage.
+        const PressureMatrix& pressureMatrix() const { return Ap_; }
+
+        //! \brief The quasi-IMPES weights of all cells.
+        const std::vector< Weights >& weights() const { return weights_; }
+
+        //! \brief The number of bytes held by the weights, the pressure matrix,
+        //! the second stage and the work vectors. The AMG hierarchy of the
+        //! first stage does not expose its matrices and is not included.
+        std::size_t memoryUsage() const
+        {
+            return Opm::memoryUsage( weights_ ) + Opm::memoryUsage( Ap_ )
+                + ( ilu_ ? ilu_->memoryUsage() : 0 )
+                + Opm::memoryUsage( rp_ ) + Opm::memoryUsage( xp_ )
+                + Opm::memoryUsage( dmodified_ ) + Opm::memoryUsage( vilu_ );
+        }
+
+    protected:
+        //! \brief xp_ = one application of the multiscale solver to rp_.
+        void applyMultiscale()
+        {
+            const int n = rp_.size();
+            MultiscalePressureSolver::Vector r( n );
+            for( int i = 0; i < n; ++i ) {
+                r[ i ] = rp_[ i ];
+            }
+            MultiscalePressureSolver::Vector x;
+            msrsb_->apply( r, x );
+            for( int i = 0; i < n; ++i ) {
+                xp_[ i ] = x[ i ];
+            }
+        }
+
+        SecondStage* createSecondStage( const double relax, const Dune::Amg::SequentialInformation& ) const
+        {
+            return new SecondStage( A_, 0, relax );
+        }
+
+        template <class Comm>
+        SecondStage* createSecondStage( const double relax, const Comm& comm ) const
+        {
+            return new SecondStage( A_, comm, relax );
+        }
+
+        //! \brief The matrix for the full linear problem.
+        const matrix_type& A_;
+
+        //! \brief The quasi-IMPES weights
+        std::vector< Weights > weights_;
+
+        //! \brief The pressure matrix and its operator
+        PressureMatrix Ap_;
+        std::unique_ptr< PressureOperator > opAp_;
+
+        //! \brief AMG preconditioner for the pressure system
+        std::unique_ptr< AMG > amg_;
+
+        //! \brief ILU0 preconditioner for the whole system
+        std::unique_ptr< SecondStage > ilu_;
+
+        //! \brief temporary variables
+        PressureVector rp_;
+        PressureVector xp_;
+        Y dmodified_;
+        X vilu_;
+
+        //! \brief The information about the parallelization
+        const P& comm_;
+
+        //! \brief The multiscale solver of the pressure system, if used
+        MultiscalePressureSolver* msrsb_;
+    };
+
+} // end namespace Opm
+#endif
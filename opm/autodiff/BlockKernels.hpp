@@ -0,0 +1,178 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_BLOCKKERNELS_HEADER_INCLUDED
+#define OPM_BLOCKKERNELS_HEADER_INCLUDED
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace Opm
+{
+
+namespace BlockKernels
+{
+
+    /// Block operations of the linear solvers. The blocks of size 2 and 3
+    /// used by the black-oil models have fully unrolled kernels without
+    /// the loops and temporaries of the generic FieldMatrix operations,
+    /// which leaves the compiler free to keep the vector block in registers
+    /// and to vectorize the row products. All other sizes use the
+    /// FieldMatrix operations.
+
+    /// y -= A x
+    template <class K, int n, int m>
+    inline void mmv(const Dune::FieldMatrix<K, n, m>& A, const Dune::FieldVector<K, m>& x, Dune::FieldVector<K, n>& y)
+    {
+        A.mmv(x, y);
+    }
+
+    template <class K>
+    inline void mmv(const Dune::FieldMatrix<K, 2, 2>& A, const Dune::FieldVector<K, 2>& x, Dune::FieldVector<K, 2>& y)
+    {
+        const K x0 = x[0], x1 = x[1];
+        y[0] -= A[0][0]*x0 + A[0][1]*x1;
+        y[1] -= A[1][0]*x0 + A[1][1]*x1;
+    }
+
+    template <class K>
+    inline void mmv(const Dune::FieldMatrix<K, 3, 3>& A, const Dune::FieldVector<K, 3>& x, Dune::FieldVector<K, 3>& y)
+    {
+        const K x0 = x[0], x1 = x[1], x2 = x[2];
+        y[0] -= A[0][0]*x0 + A[0][1]*x1 + A[0][2]*x2;
+        y[1] -= A[1][0]*x0 + A[1][1]*x1 + A[1][2]*x2;
+        y[2] -= A[2][0]*x0 + A[2][1]*x1 + A[2][2]*x2;
+    }
+
+    /// y += A x
+    template <class K, int n, int m>
+    inline void umv(const Dune::FieldMatrix<K, n, m>& A, const Dune::FieldVector<K, m>& x, Dune::FieldVector<K, n>& y)
+    {
+        A.umv(x, y);
+    }
+
+    template <class K>
+    inline void umv(const Dune::FieldMatrix<K, 2, 2>& A, const Dune::FieldVector<K, 2>& x, Dune::FieldVector<K, 2>& y)
+    {
+        const K x0 = x[0], x1 = x[1];
+        y[0] += A[0][0]*x0 + A[0][1]*x1;
+        y[1] += A[1][0]*x0 + A[1][1]*x1;
+    }
+
+    template <class K>
+    inline void umv(const Dune::FieldMatrix<K, 3, 3>& A, const Dune::FieldVector<K, 3>& x, Dune::FieldVector<K, 3>& y)
+    {
+        const K x0 = x[0], x1 = x[1], x2 = x[2];
+        y[0] += A[0][0]*x0 + A[0][1]*x1 + A[0][2]*x2;
+        y[1] += A[1][0]*x0 + A[1][1]*x1 + A[1][2]*x2;
+        y[2] += A[2][0]*x0 + A[2][1]*x1 + A[2][2]*x2;
+    }
+
+    /// y += A x with the blocks of A in single precision, the products are
+    /// accumulated in the double precision of x and y.
+    template <int n, int m>
+    inline void umv(const Dune::FieldMatrix<float, n, m>& A, const Dune::FieldVector<double, m>& x, Dune::FieldVector<double, n>& y)
+    {
+        for (int i = 0; i < n; ++i) {
+            double yi = y[i];
+            for (int j = 0; j < m; ++j) {
+                yi += double(A[i][j])*x[j];
+            }
+            y[i] = yi;
+        }
+    }
+
+    /// y = A x, x and y must not alias.
+    template <class K, int n, int m>
+    inline void mv(const Dune::FieldMatrix<K, n, m>& A, const Dune::FieldVector<K, m>& x, Dune::FieldVector<K, n>& y)
+    {
+        A.mv(x, y);
+    }
+
+    template <class K>
+    inline void mv(const Dune::FieldMatrix<K, 2, 2>& A, const Dune::FieldVector<K, 2>& x, Dune::FieldVector<K, 2>& y)
+    {
+        assert(&x != &y);
+        const K x0 = x[0], x1 = x[1];
+        y[0] = A[0][0]*x0 + A[0][1]*x1;
+        y[1] = A[1][0]*x0 + A[1][1]*x1;
+    }
+
+    template <class K>
+    inline void mv(const Dune::FieldMatrix<K, 3, 3>& A, const Dune::FieldVector<K, 3>& x, Dune::FieldVector<K, 3>& y)
+    {
+        assert(&x != &y);
+        const K x0 = x[0], x1 = x[1], x2 = x[2];
+        y[0] = A[0][0]*x0 + A[0][1]*x1 + A[0][2]*x2;
+        y[1] = A[1][0]*x0 + A[1][1]*x1 + A[1][2]*x2;
+        y[2] = A[2][0]*x0 + A[2][1]*x1 + A[2][2]*x2;
+    }
+
+    /// y = A x for a block sparse matrix, the replacement of BCRSMatrix::mv.
+    /// The blocks of A may be in single precision for vectors in double.
+    template <class M, class X, class Y>
+    void matrixMv(const M& A, const X& x, Y& y)
+    {
+        assert(y.size() == A.N());
+        const auto endi = A.end();
+        for (auto i = A.begin(); i != endi; ++i) {
+            auto& yi = y[i.index()];
+            yi = 0.0;
+            const auto endj = i->end();
+            for (auto j = i->begin(); j != endj; ++j) {
+                umv(*j, x[j.index()], yi);
+            }
+        }
+    }
+
+    /// y[k] = A x[k] for several vectors of a block sparse matrix, every
+    /// block of A is read once for all of them.
+    template <class M, class X, class Y>
+    void matrixMultiMv(const M& A, const std::vector<X>& x, std::vector<Y>& y)
+    {
+        assert(x.size() == y.size());
+        const std::size_t n = x.size();
+        const auto endi = A.end();
+        for (auto i = A.begin(); i != endi; ++i) {
+            const auto row = i.index();
+            for (std::size_t k = 0; k < n; ++k) {
+                assert(y[k].size() == A.N());
+                y[k][row] = 0.0;
+            }
+            const auto endj = i->end();
+            for (auto j = i->begin(); j != endj; ++j) {
+                const auto col = j.index();
+                for (std::size_t k = 0; k < n; ++k) {
+                    umv(*j, x[k][col], y[k][row]);
+                }
+            }
+        }
+    }
+
+} // namespace BlockKernels
+
+} // namespace Opm
+
+#endif // OPM_BLOCKKERNELS_HEADER_INCLUDED
@@ -0,0 +1,143 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_BLOCKMATRIXDIFFERENCE_HEADER_INCLUDED
+#define OPM_BLOCKMATRIXDIFFERENCE_HEADER_INCLUDED
+
+#include <algorithm>
+#include <cmath>
+
+namespace Opm
+{
+
+    /// The differences between the entries of two block matrices, e.g. a
+    /// Jacobian by automatic differentiation and one by finite differences.
+    /// The largest relative and absolute differences are kept with the
+    /// position of the largest relative one, and the entries whose relative
+    /// difference exceeds a tolerance are counted. Entries below a zero
+    /// tolerance in both matrices are counted but not compared.
+    class BlockMatrixDifference
+    {
+    public:
+        explicit BlockMatrixDifference(const double tolerance = 1e-3,
+                                       const double zeroTolerance = 1e-14)
+            : tolerance_(tolerance)
+            , zeroTolerance_(zeroTolerance)
+        {
+        }
+
+        /// Compare the entry (i, j) of the block (row, col).
+        void add(const double expected, const double actual,
+                 const int row, const int col, const int i, const int j)
+        {
+            ++numEntries_;
+            const double scale = std::max(std::abs(expected), std::abs(actual));
+            if (scale <= zeroTolerance_) {
+                return;
+            }
+            const double absolute = std::abs(expected - actual);
+            const double relative = absolute / scale;
+            maxAbsolute_ = std::max(maxAbsolute_, absolute);
+            if (relative > tolerance_) {
+                ++numAboveTolerance_;
+            }
+            if (relative > maxRelative_) {
+                maxRelative_ = relative;
+                row_ = row;
+                col_ = col;
+                i_ = i;
+                j_ = j;
+                expected_ = expected;
+                actual_ = actual;
+            }
+        }
+
+        double tolerance() const { return tolerance_; }
+        double maxRelative() const { return maxRelative_; }
+        double maxAbsolute() const { return maxAbsolute_; }
+        int numEntries() const { return numEntries_; }
+        int numAboveTolerance() const { return numAboveTolerance_; }
+
+        /// The position of the largest relative difference, the block row
+        /// and column and the row and column in the block, and the entries.
+        int row() const { return row_; }
+        int col() const { return col_; }
+        int blockRow() const { return i_; }
+        int blockCol() const { return j_; }
+        double expected() const { return expected_; }
+        double actual() const { return actual_; }
+
+    private:
+        double tolerance_;
+        double zeroTolerance_;
+        double maxRelative_ = 0.0;
+        double maxAbsolute_ = 0.0;
+        int numEntries_ = 0;
+        int numAboveTolerance_ = 0;
+        int row_ = -1;
+        int col_ = -1;
+        int i_ = -1;
+        int j_ = -1;
+        double expected_ = 0.0;
+        double actual_ = 0.0;
+    };
+
+
+
+    /// Compare the leading rows x cols entries of the blocks of A and B, a
+    /// Dune::BCRSMatrix or matrices with the same row and column iterator
+    /// interface and sorted columns, possibly of different block types.
+    /// The blocks of the union of the sparsity patterns are visited in
+    /// place, a block missing in one of the matrices counts as zero.
+    template <class MA, class MB>
+    void addBlockMatrixDifference(const MA& A, const MB& B, const int rows, const int cols,
+                                  BlockMatrixDifference& diff)
+    {
+        const int n = std::min(A.N(), B.N());
+        auto rowA = A.begin();
+        auto rowB = B.begin();
+        for (int r = 0; r < n; ++r, ++rowA, ++rowB) {
+            auto colA = rowA->begin();
+            auto colB = rowB->begin();
+            const auto endA = rowA->end();
+            const auto endB = rowB->end();
+            while (colA != endA || colB != endB) {
+                const bool inA = colA != endA && (colB == endB || colA.index() <= colB.index());
+                const bool inB = colB != endB && (colA == endA || colB.index() <= colA.index());
+                const int c = inA ? colA.index() : colB.index();
+                for (int i = 0; i < rows; ++i) {
+                    for (int j = 0; j < cols; ++j) {
+                        const double a = inA ? double((*colA)[i][j]) : 0.0;
+                        const double b = inB ? double((*colB)[i][j]) : 0.0;
+                        diff.add(a, b, r, c, i, j);
+                    }
+                }
+                if (inA) {
+                    ++colA;
+                }
+                if (inB) {
+                    ++colB;
+                }
+            }
+        }
+    }
+
+} // namespace Opm
+
+#endif // OPM_BLOCKMATRIXDIFFERENCE_HEADER_INCLUDED
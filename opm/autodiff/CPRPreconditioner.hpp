@@ -24,7 +24,10 @@
 #ifndef OPM_CPRPRECONDITIONER_HEADER_INCLUDED
 #define OPM_CPRPRECONDITIONER_HEADER_INCLUDED
 
+#include <cassert>
+#include <limits>
 #include <memory>
+#include <string>
 #include <type_traits>
 
 #include <opm/common/utility/platform_dependent/disable_warnings.h>
@@ -137,6 +140,32 @@ createParallelDeleter(ILU& ilu, const Dune::OwnerOverlapCopyCommunication<I1,I2>
     }
 #endif
 
+///
+/// \brief A traits class for selecting the AMG smoother built from a
+///        sequential preconditioner.
+///
+/// \tparam S The type of the sequential preconditioner.
+/// \tparam P The type of the parallel information.
+////
+template<class S, class P>
+struct AMGSmootherSelector
+{
+    /// \brief The type of the smoother.
+    typedef S Smoother;
+};
+
+#if HAVE_MPI
+/// \copydoc AMGSmootherSelector<S,P>
+/// The sequential preconditioner is applied to the overlapping subdomain of
+/// each process.
+template<class S, class I1, class I2>
+struct AMGSmootherSelector<S,Dune::OwnerOverlapCopyCommunication<I1,I2> >
+{
+    typedef Dune::BlockPreconditioner<typename S::domain_type, typename S::range_type,
+                                      Dune::OwnerOverlapCopyCommunication<I1,I2>, S> Smoother;
+};
+#endif
+
 //! \brief Creates and initializes a unique pointer to an sequential ILU0 preconditioner.
 //! \param A     The matrix of the linear system to solve.
 //! \param relax The relaxation factor to use.
@@ -271,14 +300,24 @@ createEllipticPreconditionerPointer(const M& Ae, double relax,
 
 #endif // #if HAVE_MPI
 
-/// \brief Creates the elliptic preconditioner (ILU0)
-/// \param opA     The operator representing the matrix of the system.
-/// \param relax   The relaxation parameter for ILU0.
-/// \param comm    The object describing the parallelization information and communication.
-//  \param amgPtr  The unique_ptr to be filled (return)
+/// \brief Creates the elliptic preconditioner (AMG)
+/// \param opA           The operator representing the matrix of the system.
+/// \param relax         The relaxation parameter of the smoother.
+/// \param comm          The object describing the parallelization information and communication.
+/// \param amgPtr        The unique_ptr to be filled (return)
+/// \param coarsenTarget The level size below which no further coarsening happens.
+/// \param maxLevel      The maximum number of levels of the hierarchy.
+/// \param accumulate    How the coarse levels are agglomerated onto fewer processes.
+///                      With atOnceAccu the coarse level is gathered on a single
+///                      process and solved there redundantly (directly if UMFPack or
+///                      SuperLU is available), with successiveAccu the levels below
+///                      coarsenTarget unknowns per process are repartitioned onto a
+///                      subset of the processes (needs ParMETIS).
 template < int pressureIndex=0, class Op, class P, class AMG >
 inline void
-createAMGPreconditionerPointer( Op& opA, const double relax, const P& comm, std::unique_ptr< AMG >& amgPtr )
+createAMGPreconditionerPointer( Op& opA, const double relax, const P& comm, std::unique_ptr< AMG >& amgPtr,
+                                const int coarsenTarget, const int maxLevel,
+                                const Dune::Amg::AccumulationMode accumulate )
 {
     // type of matrix
     typedef typename Op::matrix_type  M;
@@ -292,11 +331,10 @@ createAMGPreconditionerPointer( Op& opA, const double relax, const P& comm, std:
     // The coarsening criterion used in the AMG
     typedef Dune::Amg::CoarsenCriterion<CritBase> Criterion;
 
-    // TODO: revise choice of parameters
-    int coarsenTarget=1200;
-    Criterion criterion(15,coarsenTarget);
+    Criterion criterion(maxLevel,coarsenTarget);
     criterion.setDebugLevel( 0 ); // no debug information, 1 for printing hierarchy information
     criterion.setDefaultValuesIsotropic(2);
+    criterion.setAccumulate( accumulate );
     criterion.setNoPostSmoothSteps( 1 );
     criterion.setNoPreSmoothSteps( 1 );
 
@@ -310,6 +348,15 @@ createAMGPreconditionerPointer( Op& opA, const double relax, const P& comm, std:
     amgPtr.reset( new AMG(opA, criterion, smootherArgs, comm ) );
 }
 
+/// \brief Creates the elliptic preconditioner (AMG) with a coarsening target
+///        of 1200 unknowns, at most 15 levels and no agglomeration.
+template < int pressureIndex=0, class Op, class P, class AMG >
+inline void
+createAMGPreconditionerPointer( Op& opA, const double relax, const P& comm, std::unique_ptr< AMG >& amgPtr )
+{
+    createAMGPreconditionerPointer< pressureIndex >( opA, relax, comm, amgPtr, 1200, 15, Dune::Amg::noAccu );
+}
+
 } // end namespace ISTLUtility
 
     struct CPRParameter
@@ -318,9 +365,19 @@ createAMGPreconditionerPointer( Op& opA, const double relax, const P& comm, std:
         double cpr_solver_tol_;
         int cpr_ilu_n_;
         int cpr_max_ell_iter_;
+        int cpr_reuse_setup_;
         bool cpr_use_amg_;
         bool cpr_use_bicgstab_;
         bool cpr_solver_verbose_;
+        int cpr_amg_coarsen_target_;
+        int cpr_amg_max_level_;
+        std::string cpr_amg_accumulate_;
+        std::string cpr_pressure_solver_;
+        int cpr_msrsb_block_size_;
+        int cpr_msrsb_iterations_;
+        double cpr_msrsb_tolerance_;
+        double cpr_msrsb_update_tolerance_;
+        int cpr_msrsb_smoothing_;
 
         CPRParameter() { reset(); }
 
@@ -333,9 +390,59 @@ createAMGPreconditionerPointer( Op& opA, const double relax, const P& comm, std:
             cpr_solver_tol_     = param.getDefault("cpr_solver_tol", cpr_solver_tol_);
             cpr_ilu_n_          = param.getDefault("cpr_ilu_n", cpr_ilu_n_);
             cpr_max_ell_iter_   = param.getDefault("cpr_max_elliptic_iter",cpr_max_ell_iter_);
+            cpr_reuse_setup_    = param.getDefault("cpr_reuse_setup", cpr_reuse_setup_);
             cpr_use_amg_        = param.getDefault("cpr_use_amg", cpr_use_amg_);
             cpr_use_bicgstab_   = param.getDefault("cpr_use_bicgstab", cpr_use_bicgstab_);
             cpr_solver_verbose_ = param.getDefault("cpr_solver_verbose", cpr_solver_verbose_);
+            cpr_amg_coarsen_target_ = param.getDefault("cpr_amg_coarsen_target", cpr_amg_coarsen_target_);
+            cpr_amg_max_level_  = param.getDefault("cpr_amg_max_level", cpr_amg_max_level_);
+            cpr_amg_accumulate_ = param.getDefault("cpr_amg_accumulate", cpr_amg_accumulate_);
+            cpr_pressure_solver_ = param.getDefault("cpr_pressure_solver", cpr_pressure_solver_);
+            cpr_msrsb_block_size_ = param.getDefault("cpr_msrsb_block_size", cpr_msrsb_block_size_);
+            cpr_msrsb_iterations_ = param.getDefault("cpr_msrsb_iterations", cpr_msrsb_iterations_);
+            cpr_msrsb_tolerance_ = param.getDefault("cpr_msrsb_tolerance", cpr_msrsb_tolerance_);
+            cpr_msrsb_update_tolerance_ = param.getDefault("cpr_msrsb_update_tolerance", cpr_msrsb_update_tolerance_);
+            cpr_msrsb_smoothing_ = param.getDefault("cpr_msrsb_smoothing", cpr_msrsb_smoothing_);
+
+            if( cpr_amg_coarsen_target_ < 1 || cpr_amg_max_level_ < 1 ) {
+                OPM_THROW(std::runtime_error, "cpr_amg_coarsen_target and cpr_amg_max_level must be positive");
+            }
+            // validate the agglomeration mode
+            amgAccumulationMode();
+            if( cpr_pressure_solver_ != "amg" && cpr_pressure_solver_ != "msrsb" ) {
+                OPM_THROW(std::runtime_error, "Unknown cpr_pressure_solver " << cpr_pressure_solver_
+                          << ", use amg or msrsb");
+            }
+            if( cpr_msrsb_block_size_ < 1 ) {
+                OPM_THROW(std::runtime_error, "cpr_msrsb_block_size must be positive");
+            }
+        }
+
+        /// \brief Whether the pressure system of the first stage is solved with
+        ///        the multiscale restriction-smoothed basis method instead of AMG.
+        bool useMultiscalePressureSolver() const
+        {
+            return cpr_pressure_solver_ == "msrsb";
+        }
+
+        /// \brief The agglomeration of the coarse pressure levels: "none" keeps
+        ///        every level distributed, "once" gathers the coarsest level on a
+        ///        single process for a redundant solve and "successive" moves the
+        ///        levels below cpr_amg_coarsen_target unknowns per process onto
+        ///        fewer processes.
+        Dune::Amg::AccumulationMode amgAccumulationMode() const
+        {
+            if( cpr_amg_accumulate_ == "none" ) {
+                return Dune::Amg::noAccu;
+            }
+            if( cpr_amg_accumulate_ == "once" ) {
+                return Dune::Amg::atOnceAccu;
+            }
+            if( cpr_amg_accumulate_ == "successive" ) {
+                return Dune::Amg::successiveAccu;
+            }
+            OPM_THROW(std::runtime_error, "Unknown cpr_amg_accumulate " << cpr_amg_accumulate_
+                      << ", use none, once or successive");
         }
 
         void reset()
@@ -344,13 +451,125 @@ createAMGPreconditionerPointer( Op& opA, const double relax, const P& comm, std:
             cpr_solver_tol_     = 1e-2;
             cpr_ilu_n_          = 0;
             cpr_max_ell_iter_   = 25;
+            cpr_reuse_setup_    = 0;
             cpr_use_amg_        = true;
             cpr_use_bicgstab_   = true;
             cpr_solver_verbose_ = false;
+            cpr_amg_coarsen_target_ = 1200;
+            cpr_amg_max_level_  = 15;
+            cpr_amg_accumulate_ = "none";
+            cpr_pressure_solver_ = "amg";
+            cpr_msrsb_block_size_ = 256;
+            cpr_msrsb_iterations_ = 100;
+            cpr_msrsb_tolerance_ = 1e-3;
+            cpr_msrsb_update_tolerance_ = 0.2;
+            cpr_msrsb_smoothing_ = 2;
         }
     };
 
 
+    /*!
+      \brief AMG setup for the elliptic part of the CPR preconditioner that
+      can be kept for several linear solves.
+
+      The AMG hierarchy (aggregates, prolongators, smoothers) is built once and
+      reused for cpr_reuse_setup linear solves. For the reuses only the Galerkin
+      coarse operators are recomputed from the new elliptic matrix, while the
+      smoothers stay the ones of the last setup. This is sufficient as the
+      elliptic system is only solved approximately.
+
+      The hierarchy keeps references to the parallel information, hence the
+      setup is only available for the sequential case.
+
+      \tparam M The matrix type of the elliptic system.
+      \tparam X The vector type of the elliptic system.
+    */
+    template<class M, class X>
+    class CPREllipticSetup
+    {
+    public:
+        typedef Dune::Amg::SequentialInformation ParallelInformation;
+        typedef ISTLUtility::CPRSelector<M,X,X,ParallelInformation> CPRSelectorType;
+        typedef typename CPRSelectorType::Operator Operator;
+        typedef typename CPRSelectorType::AMG AMG;
+
+        CPREllipticSetup()
+            : Ae_(), info_(), opAe_(), amg_(), uses_( 0 )
+        {
+        }
+
+        /// \brief Prepare the setup for a new elliptic matrix.
+        /// \param Ae    The elliptic matrix of the current linear system.
+        /// \param param The CPR parameters.
+        void update( const M& Ae, const CPRParameter& param )
+        {
+            if( amg_ && uses_ < param.cpr_reuse_setup_ && copyValues( Ae ) )
+            {
+                // keep the coarsening, only redo the Galerkin products
+                amg_->recalculateHierarchy();
+                ++uses_;
+            }
+            else
+            {
+                // the hierarchy references the operator and the matrix
+                amg_.reset();
+                opAe_.reset();
+                Ae_ = Ae;
+                opAe_.reset( CPRSelectorType::makeOperator( Ae_, info_ ) );
+                ISTLUtility::createAMGPreconditionerPointer( *opAe_, param.cpr_relax_, info_, amg_,
+                                                             param.cpr_amg_coarsen_target_,
+                                                             param.cpr_amg_max_level_,
+                                                             param.amgAccumulationMode() );
+                uses_ = 1;
+            }
+        }
+
+        /// \brief Whether the last update kept the coarsening of an earlier one.
+        bool reused() const { return uses_ > 1; }
+
+        /// \brief Build a new setup at the next update.
+        void invalidate() { uses_ = std::numeric_limits<int>::max(); }
+
+        /// \brief The operator of the stored elliptic matrix.
+        Operator& op() { assert( opAe_ ); return *opAe_; }
+
+        /// \brief The AMG for the stored elliptic matrix.
+        AMG& amg() { assert( amg_ ); return *amg_; }
+
+    protected:
+        /// \brief Copy the values of Ae into the stored matrix.
+        /// \return false if the sparsity patterns differ.
+        bool copyValues( const M& Ae )
+        {
+            if( Ae_.N() != Ae.N() || Ae_.nonzeroes() != Ae.nonzeroes() ) {
+                return false;
+            }
+
+            auto row = Ae_.begin();
+            const auto endi = Ae.end();
+            for( auto rowAe = Ae.begin(); rowAe != endi; ++rowAe, ++row )
+            {
+                auto col = row->begin();
+                const auto endj = rowAe->end();
+                for( auto colAe = rowAe->begin(); colAe != endj; ++colAe, ++col )
+                {
+                    if( col.index() != colAe.index() ) {
+                        return false;
+                    }
+                    *col = *colAe;
+                }
+            }
+            return true;
+        }
+
+        M Ae_;
+        ParallelInformation info_;
+        std::unique_ptr< Operator > opAe_;
+        std::unique_ptr< AMG > amg_;
+        int uses_;
+    };
+
+
     /*!
       \brief CPR preconditioner.
 
@@ -430,6 +649,8 @@ createAMGPreconditionerPointer( Op& opA, const double relax, const P& comm, std:
               opAe_(CPRSelectorType::makeOperator(Ae_, commAe)),
               precond_(), // ilu0 preconditioner for elliptic system
               amg_(),     // amg  preconditioner for elliptic system
+              opAePtr_( opAe_.get() ),
+              amgPtr_( nullptr ),
               pre_(), // copy A will be made be the preconditioner
               vilu_( A_.N() ),
               comm_(comm),
@@ -437,14 +658,41 @@ createAMGPreconditionerPointer( Op& opA, const double relax, const P& comm, std:
         {
             // create appropriate preconditioner for elliptic system
             createEllipticPreconditioner( param_.cpr_use_amg_, commAe_ );
+            amgPtr_ = amg_.get();
 
-            // create the preconditioner for the whole system.
-            if( param_.cpr_ilu_n_ == 0 ) {
-                pre_ = ISTLUtility::createILU0Ptr<M,X>( A_, param_.cpr_relax_, comm_ );
-            }
-            else {
-                pre_ = ISTLUtility::createILUnPtr<M,X>( A_, param_.cpr_ilu_n_, param_.cpr_relax_, comm_ );
-            }
+            createWholeSystemPreconditioner();
+        }
+
+        /*! \brief Constructor using an elliptic operator and AMG set up elsewhere.
+
+          \param A       The matrix to operate on.
+          \param Ae      The top-left elliptic part of A.
+          \param opAe    The operator of the elliptic part, e.g. from a CPREllipticSetup.
+          \param amg     The AMG for the elliptic part, which is applied but not modified.
+          \param paralleInformation The information about the parallelization, if this is a
+                                    parallel run
+        */
+        CPRPreconditioner (const CPRParameter& param, const M& A, const M& Ae,
+                           Operator& opAe, AMG& amg,
+                           const ParallelInformation& comm=ParallelInformation(),
+                           const ParallelInformation& commAe=ParallelInformation())
+            : param_( param ),
+              A_(A),
+              Ae_(Ae),
+              de_( Ae_.N() ),
+              ve_( Ae_.M() ),
+              dmodified_( A_.N() ),
+              opAe_(),
+              precond_(),
+              amg_(),
+              opAePtr_( &opAe ),
+              amgPtr_( &amg ),
+              pre_(),
+              vilu_( A_.N() ),
+              comm_(comm),
+              commAe_(commAe)
+        {
+            createWholeSystemPreconditioner();
         }
 
         /*!
@@ -525,15 +773,15 @@ createAMGPreconditionerPointer( Op& opA, const double relax, const P& comm, std:
             std::unique_ptr<typename ScalarProductChooser::ScalarProduct>
                 sp(ScalarProductChooser::construct(commAe_));
 
-            if( amg_ )
+            if( amgPtr_ )
             {
                 // Solve system with AMG
                 if( param_.cpr_use_bicgstab_ ) {
-                    Dune::BiCGSTABSolver<X> linsolve(*opAe_, *sp, (*amg_), tolerance, maxit, verbosity);
+                    Dune::BiCGSTABSolver<X> linsolve(*opAePtr_, *sp, (*amgPtr_), tolerance, maxit, verbosity);
                     linsolve.apply(x, de, result);
                 }
                 else {
-                    Dune::CGSolver<X> linsolve(*opAe_, *sp, (*amg_), tolerance, maxit, verbosity);
+                    Dune::CGSolver<X> linsolve(*opAePtr_, *sp, (*amgPtr_), tolerance, maxit, verbosity);
                     linsolve.apply(x, de, result);
                 }
             }
@@ -576,6 +824,10 @@ createAMGPreconditionerPointer( Op& opA, const double relax, const P& comm, std:
         //! \brief AMG preconditioner with ILU0 smoother
         std::unique_ptr< AMG > amg_;
 
+        //! \brief The elliptic operator and AMG used, either owned or external
+        Operator* opAePtr_;
+        AMG* amgPtr_;
+
         //! \brief The preconditioner for the whole system
         //!
         //! We have to use a shared_ptr instead of a unique_ptr
@@ -593,11 +845,25 @@ createAMGPreconditionerPointer( Op& opA, const double relax, const P& comm, std:
         //! of the system
         const P& commAe_;
      protected:
+        void createWholeSystemPreconditioner()
+        {
+            // create the preconditioner for the whole system.
+            if( param_.cpr_ilu_n_ == 0 ) {
+                pre_ = ISTLUtility::createILU0Ptr<M,X>( A_, param_.cpr_relax_, comm_ );
+            }
+            else {
+                pre_ = ISTLUtility::createILUnPtr<M,X>( A_, param_.cpr_ilu_n_, param_.cpr_relax_, comm_ );
+            }
+        }
+
         void createEllipticPreconditioner( const bool amg, const P& comm )
         {
             if( amg )
             {
-                ISTLUtility::createAMGPreconditionerPointer( *opAe_ , param_.cpr_relax_, comm, amg_ );
+                ISTLUtility::createAMGPreconditionerPointer( *opAe_ , param_.cpr_relax_, comm, amg_,
+                                                             param_.cpr_amg_coarsen_target_,
+                                                             param_.cpr_amg_max_level_,
+                                                             param_.amgAccumulationMode() );
             }
             else
             {
@@ -0,0 +1,115 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_CARTESIANTOCOMPRESSED_HEADER_INCLUDED
+#define OPM_CARTESIANTOCOMPRESSED_HEADER_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Lookup of the compressed (active) cell index of a Cartesian cell
+    /// index, the inverse of the global_cell array of a grid.
+    ///
+    /// Grids with at most denseFactor Cartesian cells per active cell use
+    /// a dense array over the Cartesian cells, sparser grids a sorted array
+    /// of the active cells with binary search, which needs memory only for
+    /// the active cells. Both are built once per grid in linear (dense) or
+    /// n log n (sparse) time and are meant to be kept for the whole run.
+    class CartesianToCompressed
+    {
+    public:
+        enum { denseFactor = 4 };
+
+        /// \param[in] globalCell  the Cartesian index of each active cell,
+        ///                        null if all cells are active
+        /// \param[in] numCells    the number of active cells
+        /// \param[in] cartDims    the logical Cartesian dimensions
+        CartesianToCompressed(const int* globalCell, const int numCells, const int* cartDims)
+            : cartDims_{ { cartDims[0], cartDims[1], cartDims[2] } },
+              numCartesian_(std::size_t(cartDims[0]) * cartDims[1] * cartDims[2]),
+              identity_(globalCell == nullptr)
+        {
+            if (identity_) {
+                return;
+            }
+            if (numCartesian_ <= std::size_t(denseFactor) * std::size_t(numCells)) {
+                dense_.assign(numCartesian_, -1);
+                for (int c = 0; c < numCells; ++c) {
+                    dense_[globalCell[c]] = c;
+                }
+            }
+            else {
+                sparse_.resize(numCells);
+                for (int c = 0; c < numCells; ++c) {
+                    sparse_[c] = std::make_pair(globalCell[c], c);
+                }
+                std::sort(sparse_.begin(), sparse_.end());
+            }
+        }
+
+        /// The compressed index of a Cartesian cell, -1 if the cell is
+        /// inactive or outside the grid.
+        int compressedIndex(const int cartesianIndex) const
+        {
+            if (cartesianIndex < 0 || std::size_t(cartesianIndex) >= numCartesian_) {
+                return -1;
+            }
+            if (identity_) {
+                return cartesianIndex;
+            }
+            if (!dense_.empty()) {
+                return dense_[cartesianIndex];
+            }
+            const auto it = std::lower_bound(sparse_.begin(), sparse_.end(), std::make_pair(cartesianIndex, -1));
+            return (it != sparse_.end() && it->first == cartesianIndex) ? it->second : -1;
+        }
+
+        /// The compressed index of the cell (i, j, k), -1 if the cell is
+        /// inactive or outside the grid.
+        int compressedIndex(const int i, const int j, const int k) const
+        {
+            if (i < 0 || j < 0 || k < 0 || i >= cartDims_[0] || j >= cartDims_[1] || k >= cartDims_[2]) {
+                return -1;
+            }
+            return compressedIndex(i + cartDims_[0] * (j + cartDims_[1] * k));
+        }
+
+        /// Whether the lookup uses the dense array.
+        bool isDense() const
+        {
+            return identity_ || !dense_.empty();
+        }
+
+    private:
+        std::array<int, 3> cartDims_;
+        std::size_t numCartesian_;
+        bool identity_;
+        std::vector<int> dense_;
+        std::vector<std::pair<int, int>> sparse_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_CARTESIANTOCOMPRESSED_HEADER_INCLUDED
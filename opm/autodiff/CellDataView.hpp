@@ -0,0 +1,94 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_CELLDATAVIEW_HEADER_INCLUDED
+#define OPM_CELLDATAVIEW_HEADER_INCLUDED
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace Opm
+{
+
+    /// A read-only view of one value per cell without a copy of the values,
+    /// either a strided span over an array owned by someone else, e.g. one
+    /// member of an array of structs, or a function of the cell index that
+    /// computes the values on access, e.g. from the ebos problem. The owner
+    /// of the array or of the data used by the function must outlive the
+    /// view.
+    template <class T>
+    class CellDataView
+    {
+    public:
+        /// An empty view.
+        CellDataView()
+            : data_(nullptr)
+            , stride_(1)
+            , size_(0)
+        {
+        }
+
+        /// The values data[i * stride] of the cells i = 0, ..., size - 1.
+        CellDataView(const T* data, const int size, const int stride = 1)
+            : data_(data)
+            , stride_(stride)
+            , size_(size)
+        {
+        }
+
+        /// The values of a vector.
+        explicit CellDataView(const std::vector<T>& values)
+            : data_(values.data())
+            , stride_(1)
+            , size_(values.size())
+        {
+        }
+
+        /// The values value(i) of the cells i = 0, ..., size - 1.
+        CellDataView(const int size, std::function<T(int)> value)
+            : data_(nullptr)
+            , stride_(1)
+            , size_(size)
+            , value_(std::move(value))
+        {
+        }
+
+        /// The number of cells.
+        int size() const { return size_; }
+
+        bool empty() const { return size_ == 0; }
+
+        /// The value of a cell.
+        T operator[](const int cell) const
+        {
+            return data_ ? data_[std::ptrdiff_t(cell) * stride_] : value_(cell);
+        }
+
+    private:
+        const T* data_;
+        int stride_;
+        int size_;
+        std::function<T(int)> value_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_CELLDATAVIEW_HEADER_INCLUDED
@@ -0,0 +1,214 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_CHEBYSHEVSMOOTHER_HEADER_INCLUDED
+#define OPM_CHEBYSHEVSMOOTHER_HEADER_INCLUDED
+
+#include <dune/common/unused.hh>
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/solvercategory.hh>
+#include <dune/istl/paamg/construction.hh>
+#include <dune/istl/paamg/smoother.hh>
+
+#include <algorithm>
+#include <vector>
+
+namespace Opm
+{
+
+    /// \brief A Chebyshev polynomial smoother with (block) Jacobi scaling.
+    ///
+    /// A polynomial of the given degree in D^{-1}A, D being the block
+    /// diagonal of A, is applied to the defect. The polynomial damps the
+    /// eigenvalues of D^{-1}A in [lambda_max / eigenvalueRatio, lambda_max],
+    /// where lambda_max is estimated by power iteration in the constructor.
+    /// Only matrix-vector products are needed, so unlike ILU0 and
+    /// Gauss-Seidel the smoother has no sequential recurrence.
+    /// \tparam M The matrix type.
+    /// \tparam X The domain type.
+    /// \tparam Y The range type.
+    template <class M, class X, class Y>
+    class ChebyshevSmoother
+        : public Dune::Preconditioner<X,Y>
+    {
+    public:
+        //! \brief The matrix type the preconditioner is for.
+        typedef M matrix_type;
+        //! \brief The domain type of the preconditioner.
+        typedef X domain_type;
+        //! \brief The range type of the preconditioner.
+        typedef Y range_type;
+        //! \brief The field type of the preconditioner.
+        typedef typename X::field_type field_type;
+
+        // define the category
+        enum {
+            //! \brief The category the preconditioner is part of.
+            category = Dune::SolverCategory::sequential
+        };
+
+        /// \brief Constructor.
+        /// \param A               The matrix to operate on.
+        /// \param degree          The degree of the polynomial, i.e. the
+        ///                        number of matrix-vector products per apply.
+        /// \param eigenvalueRatio The ratio of the largest and the smallest
+        ///                        eigenvalue damped by the polynomial.
+        /// \param powerIterations The number of power iterations used to
+        ///                        estimate the largest eigenvalue.
+        ChebyshevSmoother( const M& A, const int degree,
+                           const double eigenvalueRatio = 30.0,
+                           const int powerIterations = 10 )
+            : A_( A ),
+              degree_( std::max( degree, 1 ) ),
+              invDiag_( A.N() ),
+              r_( A.N() ),
+              z_( A.N() ),
+              p_( A.N() )
+        {
+            for( auto row = A_.begin(); row != A_.end(); ++row )
+            {
+                invDiag_[ row.index() ] = (*row)[ row.index() ];
+                invDiag_[ row.index() ].invert();
+            }
+            // the power iteration underestimates the largest eigenvalue
+            lambdaMax_ = 1.1 * estimateLargestEigenvalue( powerIterations );
+            lambdaMin_ = lambdaMax_ / eigenvalueRatio;
+        }
+
+        virtual void pre (X& x, Y& b)
+        {
+            DUNE_UNUSED_PARAMETER(x);
+            DUNE_UNUSED_PARAMETER(b);
+        }
+
+        virtual void apply (X& v, const Y& d)
+        {
+            const double theta = 0.5 * ( lambdaMax_ + lambdaMin_ );
+            const double delta = 0.5 * ( lambdaMax_ - lambdaMin_ );
+            const double sigma = theta / delta;
+            double rho = 1.0 / sigma;
+
+            // r = d - A v, p = D^{-1} r / theta
+            r_ = d;
+            A_.mmv( v, r_ );
+            scaleByInverseDiagonal( r_, z_ );
+            p_ = z_;
+            p_ *= 1.0 / theta;
+            v += p_;
+
+            for( int k = 1; k < degree_; ++k )
+            {
+                A_.mmv( p_, r_ );
+                scaleByInverseDiagonal( r_, z_ );
+                const double rhoNew = 1.0 / ( 2.0 * sigma - rho );
+                p_ *= rhoNew * rho;
+                p_.axpy( 2.0 * rhoNew / delta, z_ );
+                v += p_;
+                rho = rhoNew;
+            }
+        }
+
+        virtual void post (X& x)
+        {
+            DUNE_UNUSED_PARAMETER(x);
+        }
+
+        /// \brief The (safeguarded) estimate of the largest eigenvalue of D^{-1}A.
+        double largestEigenvalue() const { return lambdaMax_; }
+
+    protected:
+        void scaleByInverseDiagonal( const Y& r, X& z ) const
+        {
+            const int n = invDiag_.size();
+            for( int i = 0; i < n; ++i )
+            {
+                invDiag_[ i ].mv( r[ i ], z[ i ] );
+            }
+        }
+
+        double estimateLargestEigenvalue( const int iterations )
+        {
+            // a fixed pseudo random start vector, the vector of ones is
+            // (close to) the null space of pressure-like matrices
+            unsigned int seed = 12345u;
+            for( auto block = p_.begin(); block != p_.end(); ++block )
+            {
+                for( auto entry = block->begin(); entry != block->end(); ++entry )
+                {
+                    seed = 1664525u * seed + 1013904223u;
+                    *entry = double( seed ) / 4294967296.0 - 0.5;
+                }
+            }
+
+            double lambda = 0.0;
+            for( int it = 0; it < iterations; ++it )
+            {
+                const double norm = p_.two_norm();
+                if( norm == 0.0 )
+                {
+                    break;
+                }
+                p_ *= 1.0 / norm;
+                A_.mv( p_, r_ );
+                scaleByInverseDiagonal( r_, z_ );
+                lambda = z_.two_norm();
+                p_ = z_;
+            }
+            return lambda > 0.0 ? lambda : 1.0;
+        }
+
+        const M& A_;
+        const int degree_;
+        std::vector< typename M::block_type > invDiag_;
+        double lambdaMax_;
+        double lambdaMin_;
+        Y r_;
+        X z_;
+        X p_;
+    };
+
+} // end namespace Opm
+
+namespace Dune
+{
+namespace Amg
+{
+
+/// \brief Constructs the Chebyshev smoother of an AMG level, the number of
+///        smoother iterations is the degree of the polynomial.
+template<class M, class X, class Y>
+struct ConstructionTraits<Opm::ChebyshevSmoother<M,X,Y> >
+{
+    typedef DefaultConstructionArgs<Opm::ChebyshevSmoother<M,X,Y> > Arguments;
+
+    static inline Opm::ChebyshevSmoother<M,X,Y>* construct(Arguments& args)
+    {
+        return new Opm::ChebyshevSmoother<M,X,Y>(args.getMatrix(), args.getArgs().iterations);
+    }
+
+    static inline void deconstruct(Opm::ChebyshevSmoother<M,X,Y>* smoother)
+    {
+        delete smoother;
+    }
+};
+
+} // end namespace Amg
+} // end namespace Dune
+
+#endif // OPM_CHEBYSHEVSMOOTHER_HEADER_INCLUDED
@@ -0,0 +1,514 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#include <opm/autodiff/CheckpointFile.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace Opm
+{
+
+    namespace
+    {
+        const char magic[8] = { 'O', 'P', 'M', 'C', 'H', 'K', 'P', 'T' };
+        const std::uint64_t version = 1;
+
+        // the keyframe step and block size of a delta, and the changed
+        // blocks of its partial chunks
+        const std::string deltaHeader = "delta.header";
+        const std::string deltaPrefix = "delta.";
+
+        // names and chunks are padded to keep the chunks aligned
+        std::size_t paddedLength(const std::size_t length)
+        {
+            return (length + 7) / 8 * 8;
+        }
+
+        void writeWord(std::ofstream& file, const std::uint64_t value)
+        {
+            file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        std::size_t numBlocks(const std::size_t size, const std::size_t blockSize)
+        {
+            return (size + blockSize - 1) / blockSize;
+        }
+
+        // size of block b of a chunk before compression
+        std::size_t rawBlockSize(const std::size_t size, const std::size_t blockSize, const std::size_t b)
+        {
+            return std::min(blockSize, size - b * blockSize);
+        }
+
+        // Compress the blocks of a chunk, a block is left empty if it does
+        // not shrink and is written uncompressed.
+        std::vector<std::vector<char> > compressBlocks(const std::vector<char>& bytes,
+                                                       const std::size_t blockSize,
+                                                       const CheckpointFile::Compression compression)
+        {
+            const int n = numBlocks(bytes.size(), blockSize);
+            std::vector<std::vector<char> > blocks(compression == CheckpointFile::NoCompression ? 0 : n);
+#if HAVE_ZLIB
+            if (compression == CheckpointFile::ZlibCompression) {
+#pragma omp parallel for schedule(dynamic)
+                for (int b = 0; b < n; ++b) {
+                    const std::size_t raw = rawBlockSize(bytes.size(), blockSize, b);
+                    uLongf length = compressBound(raw);
+                    std::vector<char>& block = blocks[b];
+                    block.resize(length);
+                    const int status = compress2(reinterpret_cast<Bytef*>(block.data()), &length,
+                                                 reinterpret_cast<const Bytef*>(bytes.data() + b * blockSize),
+                                                 raw, Z_BEST_SPEED);
+                    if (status != Z_OK || length >= raw) {
+                        block.clear();
+                    } else {
+                        block.resize(length);
+                    }
+                }
+            }
+#endif
+            return blocks;
+        }
+
+        // True if block b of a chunk differs from the keyframe.
+        bool blockChanged(const CheckpointFile::Chunk& keyframe, const CheckpointFile::Chunk& current,
+                          const double tolerance, const std::size_t blockSize, const std::size_t b)
+        {
+            const std::size_t begin = b * blockSize;
+            const std::size_t size = rawBlockSize(current.bytes.size(), blockSize, b);
+            if (!current.isDouble || blockSize % sizeof(double) != 0) {
+                return std::memcmp(keyframe.bytes.data() + begin, current.bytes.data() + begin, size) != 0;
+            }
+            for (std::size_t i = begin; i < begin + size; i += sizeof(double)) {
+                double key, value;
+                std::memcpy(&key, keyframe.bytes.data() + i, sizeof(double));
+                std::memcpy(&value, current.bytes.data() + i, sizeof(double));
+                // also true for NaN
+                if (!(std::abs(value - key) <= tolerance * std::abs(key))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    } // anonymous namespace
+
+
+    CheckpointFile::CheckpointFile(const std::string& filename)
+        : data_(nullptr)
+        , size_(0)
+        , reportStep_(-1)
+        , keyframeStep_(-1)
+        , keyframe_(nullptr)
+    {
+        open(filename);
+    }
+
+
+    CheckpointFile::CheckpointFile(const std::string& filename, const CheckpointFile& keyframe)
+        : data_(nullptr)
+        , size_(0)
+        , reportStep_(-1)
+        , keyframeStep_(-1)
+        , keyframe_(&keyframe)
+    {
+        open(filename);
+        if (keyframe.isDelta() || keyframe.reportStep() != keyframeStep_) {
+            if (data_) {
+                ::munmap(const_cast<char*>(data_), size_);
+            }
+            OPM_THROW(std::runtime_error, "Checkpoint of step " << keyframe.reportStep()
+                      << " is not the keyframe of " << filename);
+        }
+    }
+
+
+    void CheckpointFile::open(const std::string& filename)
+    {
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            OPM_THROW(std::runtime_error, "Could not open checkpoint " << filename);
+        }
+        struct stat status;
+        if (::fstat(fd, &status) == 0 && status.st_size > 0) {
+            void* mapped = ::mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data_ = static_cast<const char*>(mapped);
+                size_ = status.st_size;
+            }
+        }
+        ::close(fd);
+
+        try {
+            parse(filename);
+            keyframeStep_ = reportStep_;
+            if (entries_.find(deltaHeader) != entries_.end()) {
+                const ChunkView header = stored(deltaHeader);
+                std::int64_t words[2];
+                if (header.size != sizeof(words)) {
+                    OPM_THROW(std::runtime_error, "Checkpoint " << filename << " has an invalid delta header");
+                }
+                std::memcpy(words, header.data, sizeof(words));
+                keyframeStep_ = words[0];
+            }
+        }
+        catch (...) {
+            if (data_) {
+                ::munmap(const_cast<char*>(data_), size_);
+            }
+            throw;
+        }
+    }
+
+
+    CheckpointFile::~CheckpointFile()
+    {
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+
+    bool CheckpointFile::has(const std::string& name) const
+    {
+        return entries_.find(name) != entries_.end() || (keyframe_ && keyframe_->has(name));
+    }
+
+
+    CheckpointFile::ChunkView CheckpointFile::chunk(const std::string& name) const
+    {
+        if (!isDelta()) {
+            return stored(name);
+        }
+        if (!keyframe_) {
+            OPM_THROW(std::runtime_error, "Delta checkpoint of step " << reportStep_
+                      << " is read without its keyframe");
+        }
+
+        const auto changed = entries_.find(deltaPrefix + name);
+        if (changed == entries_.end()) {
+            // unchanged or entirely stored chunk
+            return entries_.find(name) == entries_.end() ? keyframe_->chunk(name) : stored(name);
+        }
+
+        auto merged = merged_.find(name);
+        if (merged == merged_.end()) {
+            std::int64_t header[2];
+            std::memcpy(header, stored(deltaHeader).data, sizeof(header));
+            const std::size_t blockSize = header[1];
+
+            const ChunkView base = keyframe_->chunk(name);
+            std::vector<char> bytes(base.data, base.data + base.size);
+            const ChunkView indices = stored(changed->first);
+            const ChunkView blocks = stored(name);
+            std::size_t pos = 0;
+            bool valid = blockSize > 0 && indices.size % sizeof(int) == 0;
+            for (std::size_t i = 0; valid && i < indices.size / sizeof(int); ++i) {
+                int b;
+                std::memcpy(&b, indices.data + i * sizeof(int), sizeof(int));
+                const std::size_t begin = std::size_t(b) * blockSize;
+                valid = b >= 0 && begin < bytes.size();
+                if (valid) {
+                    const std::size_t size = rawBlockSize(bytes.size(), blockSize, b);
+                    valid = blocks.size - pos >= size;
+                    if (valid) {
+                        std::memcpy(bytes.data() + begin, blocks.data + pos, size);
+                        pos += size;
+                    }
+                }
+            }
+            if (!valid || pos != blocks.size) {
+                OPM_THROW(std::runtime_error, "Could not apply chunk " << name
+                          << " of the delta checkpoint of step " << reportStep_);
+            }
+            merged = merged_.emplace(name, std::move(bytes)).first;
+        }
+        return ChunkView{ merged->second.data(), merged->second.size() };
+    }
+
+
+    CheckpointFile::ChunkView CheckpointFile::stored(const std::string& name) const
+    {
+        const auto it = entries_.find(name);
+        if (it == entries_.end()) {
+            OPM_THROW(std::runtime_error, "Checkpoint of step " << reportStep_ << " has no chunk " << name);
+        }
+        const Entry& entry = it->second;
+
+        // uncompressed blocks are stored contiguously
+        std::size_t stored = 0;
+        for (const std::size_t block : entry.blocks) {
+            stored += block;
+        }
+        if (stored == entry.size) {
+            return ChunkView{ entry.data, entry.size };
+        }
+
+        auto inflated = inflated_.find(name);
+        if (inflated == inflated_.end()) {
+            std::vector<char> bytes(entry.size);
+            const int n = entry.blocks.size();
+            std::vector<std::size_t> offset(n + 1, 0);
+            for (int b = 0; b < n; ++b) {
+                offset[b + 1] = offset[b] + entry.blocks[b];
+            }
+            int failed = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+:failed)
+            for (int b = 0; b < n; ++b) {
+                const std::size_t raw = rawBlockSize(entry.size, entry.blockSize, b);
+                char* dest = bytes.data() + b * entry.blockSize;
+                if (entry.blocks[b] == raw) {
+                    std::memcpy(dest, entry.data + offset[b], raw);
+                    continue;
+                }
+#if HAVE_ZLIB
+                uLongf length = raw;
+                if (entry.compression != ZlibCompression ||
+                    uncompress(reinterpret_cast<Bytef*>(dest), &length,
+                               reinterpret_cast<const Bytef*>(entry.data + offset[b]),
+                               entry.blocks[b]) != Z_OK ||
+                    length != raw) {
+                    ++failed;
+                }
+#else
+                ++failed;
+#endif
+            }
+            if (failed) {
+                OPM_THROW(std::runtime_error, "Could not inflate chunk " << name
+                          << " of the checkpoint of step " << reportStep_);
+            }
+            inflated = inflated_.emplace(name, std::move(bytes)).first;
+        }
+        return ChunkView{ inflated->second.data(), inflated->second.size() };
+    }
+
+
+    void CheckpointFile::parse(const std::string& filename)
+    {
+        std::size_t pos = 0;
+        auto readWord = [this, &pos](std::uint64_t& value) {
+            if (size_ - pos < sizeof(value)) {
+                return false;
+            }
+            std::memcpy(&value, data_ + pos, sizeof(value));
+            pos += sizeof(value);
+            return true;
+        };
+
+        if (!data_ || size_ < sizeof(magic) || std::memcmp(data_, magic, sizeof(magic)) != 0) {
+            OPM_THROW(std::runtime_error, "Could not read checkpoint " << filename);
+        }
+        pos = sizeof(magic);
+
+        std::uint64_t fileVersion, step, count;
+        if (!readWord(fileVersion) || fileVersion != version ||
+            !readWord(step) || !readWord(count)) {
+            OPM_THROW(std::runtime_error, "Could not read checkpoint " << filename);
+        }
+        reportStep_ = step;
+
+        for (std::uint64_t c = 0; c < count; ++c) {
+            std::uint64_t nameLength, size, compression, blockSize, n;
+            bool valid = readWord(nameLength) && readWord(size) && readWord(compression) &&
+                readWord(blockSize) && readWord(n) && blockSize > 0 &&
+                n == numBlocks(size, blockSize);
+            Entry entry;
+            entry.compression = Compression(compression);
+            entry.size = size;
+            entry.blockSize = blockSize;
+            std::size_t stored = 0;
+            for (std::uint64_t b = 0; valid && b < n; ++b) {
+                std::uint64_t block;
+                valid = readWord(block) && block <= rawBlockSize(size, blockSize, b);
+                entry.blocks.push_back(block);
+                stored += block;
+            }
+            valid = valid && size_ - pos >= paddedLength(nameLength);
+            if (valid) {
+                const std::string name(data_ + pos, nameLength);
+                pos += paddedLength(nameLength);
+                valid = size_ - pos >= paddedLength(stored);
+                if (valid) {
+                    entry.data = data_ + pos;
+                    pos += paddedLength(stored);
+                    entries_[name] = std::move(entry);
+                }
+            }
+            if (!valid) {
+                OPM_THROW(std::runtime_error, "Checkpoint " << filename << " is truncated");
+            }
+        }
+    }
+
+
+    CheckpointFile::Chunks CheckpointFile::delta(const Chunks& keyframe, const Chunks& current,
+                                                 const int keyframeStep, const double tolerance,
+                                                 const std::size_t blockSize)
+    {
+        Chunks result;
+        const std::vector<std::int64_t> header = { keyframeStep, std::int64_t(blockSize) };
+        add(result, deltaHeader, header);
+
+        for (const auto& pair : current) {
+            const std::string& name = pair.first;
+            const Chunk& chunk = pair.second;
+            const auto key = keyframe.find(name);
+            if (key == keyframe.end() || key->second.bytes.size() != chunk.bytes.size()) {
+                result[name] = chunk;
+                continue;
+            }
+
+            const int n = numBlocks(chunk.bytes.size(), blockSize);
+            std::vector<char> isChanged(n, false);
+#pragma omp parallel for schedule(static)
+            for (int b = 0; b < n; ++b) {
+                isChanged[b] = blockChanged(key->second, chunk, tolerance, blockSize, b);
+            }
+
+            std::vector<int> changed;
+            for (int b = 0; b < n; ++b) {
+                if (isChanged[b]) {
+                    changed.push_back(b);
+                }
+            }
+            if (changed.empty()) {
+                continue;
+            }
+            if (int(changed.size()) == n) {
+                result[name] = chunk;
+                continue;
+            }
+
+            Chunk& part = result[name];
+            part.isDouble = chunk.isDouble;
+            for (const int b : changed) {
+                const char* begin = chunk.bytes.data() + b * blockSize;
+                part.bytes.insert(part.bytes.end(), begin,
+                                  begin + rawBlockSize(chunk.bytes.size(), blockSize, b));
+            }
+            add(result, deltaPrefix + name, changed);
+        }
+        return result;
+    }
+
+
+    std::string CheckpointFile::filename(const std::string& baseName, const int rank, const int reportStep)
+    {
+        std::ostringstream name;
+        name << baseName << ".CHKP"
+             << std::setw(4) << std::setfill('0') << reportStep << "."
+             << std::setw(5) << std::setfill('0') << rank;
+        return name.str();
+    }
+
+
+    bool CheckpointFile::compressionAvailable(const Compression compression)
+    {
+#if HAVE_ZLIB
+        return compression == NoCompression || compression == ZlibCompression;
+#else
+        return compression == NoCompression;
+#endif
+    }
+
+
+    void CheckpointFile::write(const std::string& filename, const int reportStep,
+                               const Chunks& chunks, const Compression compression,
+                               const std::size_t blockSize)
+    {
+        if (!compressionAvailable(compression)) {
+            OPM_THROW(std::runtime_error, "Checkpoint compression " << int(compression) << " is not available");
+        }
+
+        const std::string partial = filename + ".tmp";
+        {
+            std::ofstream file(partial.c_str(), std::ios::binary);
+            if (!file) {
+                OPM_THROW(std::runtime_error, "Could not open checkpoint " << partial);
+            }
+
+            file.write(magic, sizeof(magic));
+            writeWord(file, version);
+            writeWord(file, reportStep);
+            writeWord(file, chunks.size());
+
+            const char padding[8] = { 0 };
+            for (const auto& chunk : chunks) {
+                const std::string& name = chunk.first;
+                const std::vector<char>& bytes = chunk.second.bytes;
+                const std::size_t n = numBlocks(bytes.size(), blockSize);
+                const std::vector<std::vector<char> > compressed = compressBlocks(bytes, blockSize, compression);
+
+                writeWord(file, name.size());
+                writeWord(file, bytes.size());
+                writeWord(file, compression);
+                writeWord(file, blockSize);
+                writeWord(file, n);
+                std::size_t stored = 0;
+                for (std::size_t b = 0; b < n; ++b) {
+                    const std::size_t size = (b < compressed.size() && !compressed[b].empty())
+                        ? compressed[b].size() : rawBlockSize(bytes.size(), blockSize, b);
+                    writeWord(file, size);
+                    stored += size;
+                }
+                file.write(name.data(), name.size());
+                file.write(padding, paddedLength(name.size()) - name.size());
+
+                if (compressed.empty()) {
+                    file.write(bytes.data(), bytes.size());
+                } else {
+                    for (std::size_t b = 0; b < n; ++b) {
+                        if (compressed[b].empty()) {
+                            file.write(bytes.data() + b * blockSize, rawBlockSize(bytes.size(), blockSize, b));
+                        } else {
+                            file.write(compressed[b].data(), compressed[b].size());
+                        }
+                    }
+                }
+                file.write(padding, paddedLength(stored) - stored);
+            }
+
+            if (!file.flush()) {
+                OPM_THROW(std::runtime_error, "Could not write checkpoint " << partial);
+            }
+        }
+
+        if (std::rename(partial.c_str(), filename.c_str()) != 0) {
+            OPM_THROW(std::runtime_error, "Could not rename checkpoint " << partial << " to " << filename);
+        }
+    }
+
+} // namespace Opm
@@ -0,0 +1,198 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_CHECKPOINTFILE_HEADER_INCLUDED
+#define OPM_CHECKPOINTFILE_HEADER_INCLUDED
+
+#include <opm/common/ErrorMacros.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Opm
+{
+
+    /// A binary checkpoint of one report step written by one process,
+    /// holding the arrays of the simulator state as named chunks.
+    ///
+    /// Every chunk is written with a single bulk write per block of
+    /// blockSize bytes, optionally compressed block by block. The file is
+    /// memory mapped when read, an uncompressed chunk is used in place
+    /// while a compressed one is inflated when it is first accessed. The
+    /// data is stored in the native byte order, a checkpoint is not meant
+    /// to be moved between machines. Files are written under a temporary
+    /// name and renamed when complete, such that an interrupted write
+    /// never leaves a truncated checkpoint.
+    ///
+    /// A checkpoint may be a delta to a keyframe, i.e. to an earlier full
+    /// checkpoint, see delta(). It then only holds the blocks of the
+    /// chunks that changed since the keyframe, and is opened together
+    /// with the keyframe to read the chunks as if it were full.
+    class CheckpointFile
+    {
+    public:
+        enum Compression { NoCompression = 0, ZlibCompression = 1 };
+
+        /// The raw bytes of a chunk, and whether they are doubles, which
+        /// are compared with a tolerance by delta().
+        struct Chunk
+        {
+            std::vector<char> bytes;
+            bool isDouble = false;
+        };
+
+        /// The chunks by name.
+        typedef std::map<std::string, Chunk> Chunks;
+
+        /// A read-only view of a chunk.
+        struct ChunkView
+        {
+            const char* data;
+            std::size_t size;
+        };
+
+        static const std::size_t defaultBlockSize = std::size_t(1) << 22;
+
+        /// Size of the blocks of the chunks compared by delta().
+        static const std::size_t defaultDeltaBlockSize = 4096;
+
+        /// Open and map a checkpoint file, throws std::runtime_error if
+        /// the file cannot be read or is not a checkpoint.
+        explicit CheckpointFile(const std::string& filename);
+
+        /// Open and map a delta checkpoint file together with its
+        /// keyframe, which has to outlive the checkpoint. Throws
+        /// std::runtime_error if the file cannot be read or keyframe is
+        /// not its keyframe.
+        CheckpointFile(const std::string& filename, const CheckpointFile& keyframe);
+
+        ~CheckpointFile();
+
+        CheckpointFile(const CheckpointFile&) = delete;
+        CheckpointFile& operator=(const CheckpointFile&) = delete;
+
+        int reportStep() const { return reportStep_; }
+
+        /// True if the checkpoint is a delta to a keyframe.
+        bool isDelta() const { return keyframeStep_ != reportStep_; }
+
+        /// The report step of the keyframe of a delta, the report step of
+        /// the checkpoint itself if it is full.
+        int keyframeStep() const { return keyframeStep_; }
+
+        /// True if the checkpoint holds a chunk of the given name.
+        bool has(const std::string& name) const;
+
+        /// The bytes of a chunk, throws std::runtime_error if the chunk is
+        /// not in the checkpoint or cannot be inflated.
+        ChunkView chunk(const std::string& name) const;
+
+        /// Copy a chunk into a container of trivially copyable values. The
+        /// container is resized if adjustSize is true, otherwise its size
+        /// has to match the chunk, or std::logic_error is thrown.
+        template <class Container>
+        void read(const std::string& name, Container& container, const bool adjustSize = false) const
+        {
+            typedef typename Container::value_type T;
+            const ChunkView view = chunk(name);
+            if (adjustSize) {
+                container.resize(view.size / sizeof(T));
+            }
+            if (view.size != container.size() * sizeof(T)) {
+                OPM_THROW(std::logic_error, "Size of checkpoint chunk " << name
+                          << " and simulation data does not match "
+                          << view.size << " " << (container.size() * sizeof(T)));
+            }
+            if (view.size > 0) {
+                std::memcpy(&container[0], view.data, view.size);
+            }
+        }
+
+        /// Add a copy of a container of trivially copyable values as a
+        /// chunk.
+        template <class Container>
+        static void add(Chunks& chunks, const std::string& name, const Container& container)
+        {
+            typedef typename Container::value_type T;
+            Chunk& chunk = chunks[name];
+            chunk.isDouble = std::is_same<T, double>::value;
+            chunk.bytes.resize(container.size() * sizeof(T));
+            if (!chunk.bytes.empty()) {
+                std::memcpy(chunk.bytes.data(), &container[0], chunk.bytes.size());
+            }
+        }
+
+        /// The chunks of a delta checkpoint of the current chunks to the
+        /// chunks of the keyframe written at keyframeStep. A chunk is
+        /// split into blocks of blockSize bytes, and only the blocks which
+        /// changed are kept. A double changes if it differs from the
+        /// keyframe by more than tolerance relative to the keyframe, any
+        /// other value if it differs at all. Chunks which are not in the
+        /// keyframe or changed their size are kept entirely.
+        static Chunks delta(const Chunks& keyframe, const Chunks& current,
+                            const int keyframeStep, const double tolerance,
+                            const std::size_t blockSize = defaultDeltaBlockSize);
+
+        /// Name of the checkpoint file of a process and report step.
+        static std::string filename(const std::string& baseName, const int rank, const int reportStep);
+
+        /// True if checkpoints can be written with the given compression.
+        static bool compressionAvailable(const Compression compression);
+
+        /// Write a checkpoint, throws std::runtime_error on failure. Blocks
+        /// which do not shrink by compression are stored uncompressed.
+        static void write(const std::string& filename, const int reportStep,
+                          const Chunks& chunks, const Compression compression,
+                          const std::size_t blockSize = defaultBlockSize);
+
+    private:
+        struct Entry
+        {
+            Compression compression;
+            std::size_t size;
+            std::size_t blockSize;
+            std::vector<std::size_t> blocks;
+            const char* data;
+        };
+
+        void open(const std::string& filename);
+
+        void parse(const std::string& filename);
+
+        // the chunk as stored in this file
+        ChunkView stored(const std::string& name) const;
+
+        const char* data_;
+        std::size_t size_;
+        int reportStep_;
+        int keyframeStep_;
+        const CheckpointFile* keyframe_;
+        std::map<std::string, Entry> entries_;
+        mutable std::map<std::string, std::vector<char> > inflated_;
+        mutable std::map<std::string, std::vector<char> > merged_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_CHECKPOINTFILE_HEADER_INCLUDED
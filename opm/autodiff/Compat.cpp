@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <utility>
 
 #include <opm/polymer/PolymerBlackoilState.hpp>
 #include <opm/common/data/SimulationDataContainer.hpp>
@@ -213,6 +214,51 @@ void solutionToSim( const data::Solution& sol,
 
 
 
+void solutionToSim( data::Solution&& sol,
+                    const std::map<std::string,std::vector<double> >& extra,
+                    PhaseUsage phases,
+                    SimulationDataContainer& state ) {
+
+    // swap the fields into the state and remove them from sol, so that
+    // they are not copied again below
+    const auto takeOver = [&sol]( const std::string& key, std::vector< double >& field ) {
+        if( sol.has( key ) && sol.data( key ).size() == field.size() ) {
+            field.swap( sol.data( key ) );
+            sol.erase( key );
+        }
+    };
+
+    takeOver( "PRESSURE", state.pressure() );
+    takeOver( "TEMP", state.temperature() );
+    if( state.hasCellData( "GASOILRATIO" ) ) {
+        takeOver( "RS", state.getCellData( "GASOILRATIO" ) );
+    }
+    if( state.hasCellData( "RV" ) ) {
+        takeOver( "RV", state.getCellData( "RV" ) );
+    }
+
+    // the maximum oil saturation and the hysteresis parameters of a restart
+    // are only in the state if the restart file has them
+    const std::pair< const char*, const char* > hysteresisFields[] = {
+        { "SOMAX", "SOMAX" },
+        { "PCSWM_OW", "PCSWMDC_OW" },
+        { "KRNSW_OW", "KRNSWMDC_OW" },
+        { "PCSWM_GO", "PCSWMDC_GO" },
+        { "KRNSW_GO", "KRNSWMDC_GO" }
+    };
+    for( const auto& field : hysteresisFields ) {
+        if( sol.has( field.first ) ) {
+            state.registerCellData( field.second, 1 );
+            takeOver( field.first, state.getCellData( field.second ) );
+        }
+    }
+
+    const data::Solution& remaining = sol;
+    solutionToSim( remaining, extra, phases, state );
+}
+
+
+
 
 
 
@@ -65,6 +65,14 @@ namespace Opm {
                         PhaseUsage phases,
                         SimulationDataContainer& state );
 
+    /// As above, but takes over the storage of the single component fields
+    /// PRESSURE, TEMP, RS and RV of sol instead of copying them, e.g. for
+    /// the restart values which are not needed afterwards.
+    void solutionToSim( data::Solution&& sol,
+                        const std::map<std::string,std::vector<double> >& extra,
+                        PhaseUsage phases,
+                        SimulationDataContainer& state );
+
     /// Copies the following fields from wells into state.
     ///   bhp, temperature, currentControls, wellRates, perfPress, perfRates, perfPhaseRates
     void wellsToState( const data::Wells& wells,
@@ -0,0 +1,65 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include <opm/autodiff/DebugLog.hpp>
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/OpmLog/OpmLog.hpp>
+
+#include <stdexcept>
+
+namespace Opm
+{
+
+    unsigned DebugLog::topics_ = 0;
+
+    void DebugLog::enable(const std::string& topics)
+    {
+        unsigned enabled = 0;
+        std::istringstream list(topics);
+        std::string name;
+        while (std::getline(list, name, ',')) {
+            if (name.empty()) {
+                continue;
+            }
+            if (name == "wells") {
+                enabled |= Wells;
+            }
+            else if (name == "newton") {
+                enabled |= Newton;
+            }
+            else if (name == "linearsolver") {
+                enabled |= LinearSolver;
+            }
+            else if (name == "all") {
+                enabled |= Wells | Newton | LinearSolver;
+            }
+            else {
+                OPM_THROW(std::invalid_argument, "Unknown debug log topic " << name);
+            }
+        }
+        topics_ = enabled;
+    }
+
+    void DebugLog::write(const std::string& message)
+    {
+        OpmLog::debug(message);
+    }
+
+} // namespace Opm
@@ -0,0 +1,78 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_DEBUGLOG_HEADER_INCLUDED
+#define OPM_DEBUGLOG_HEADER_INCLUDED
+
+#include <sstream>
+#include <string>
+
+namespace Opm
+{
+
+    /// Detailed diagnostics of the Newton and well loops, written to the
+    /// debug log when their topic is enabled at run time, e.g. with the
+    /// parameter debug_log=wells,newton. A disabled message costs a single
+    /// test of a flag and evaluates none of its arguments, such that the
+    /// diagnostics can stay in the hot loops. Defining
+    /// OPM_DEBUG_LOG_DISABLED at compile time removes them altogether.
+    class DebugLog
+    {
+    public:
+        /// The topics of the messages, any combination can be enabled.
+        enum Topic {
+            Wells = 1 << 0,
+            Newton = 1 << 1,
+            LinearSolver = 1 << 2
+        };
+
+        /// Enable the topics of a comma separated list of their names,
+        /// "wells", "newton" and "linearsolver", or "all", disabling the
+        /// others. Throws std::invalid_argument for an unknown name.
+        static void enable(const std::string& topics);
+
+        /// Whether the messages of a topic are written.
+        static bool enabled(const Topic topic) { return (topics_ & topic) != 0; }
+
+        /// Write a message to the debug log.
+        static void write(const std::string& message);
+
+    private:
+        static unsigned topics_;
+    };
+
+} // namespace Opm
+
+/// Write the streamed message, e.g. "well " << name << " switched", to the
+/// debug log if the topic, a DebugLog::Topic without qualification, is
+/// enabled. The message is not evaluated otherwise.
+#ifndef OPM_DEBUG_LOG_DISABLED
+#define OPM_DEBUG_LOG(topic, message)                                 \
+    do {                                                              \
+        if (Opm::DebugLog::enabled(Opm::DebugLog::topic)) {           \
+            std::ostringstream opmDebugLogStream;                     \
+            opmDebugLogStream << message;                             \
+            Opm::DebugLog::write(opmDebugLogStream.str());            \
+        }                                                             \
+    } while (false)
+#else
+#define OPM_DEBUG_LOG(topic, message) do { } while (false)
+#endif
+
+#endif // OPM_DEBUGLOG_HEADER_INCLUDED
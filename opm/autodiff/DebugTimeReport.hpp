@@ -22,16 +22,20 @@
 
 #include <opm/common/OpmLog/OpmLog.hpp>
 #include <opm/core/utility/StopWatch.hpp>
+#include <opm/autodiff/TimerTree.hpp>
 #include <string>
 
 namespace Opm
 {
 
+    /// Logs the time spent in its scope, which is also a region of the
+    /// TimerTree.
     class DebugTimeReport
     {
     public:
         explicit DebugTimeReport(const std::string& report_name)
             : report_name_(report_name)
+            , region_(report_name_.c_str())
         {
             clock_.start();
         }
@@ -46,6 +50,7 @@ namespace Opm
 
     private:
         std::string report_name_;
+        TimerTree::Region region_;
         time::StopWatch clock_;
     };
 
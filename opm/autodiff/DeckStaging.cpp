@@ -0,0 +1,345 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#include <opm/autodiff/DeckStaging.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <unistd.h>
+
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
+namespace Opm
+{
+
+    namespace
+    {
+        // the line up to a comment, which starts with "--" outside of quotes
+        std::string stripComment(const std::string& line)
+        {
+            char quote = 0;
+            for (std::size_t i = 0; i < line.size(); ++i) {
+                const char c = line[i];
+                if (quote != 0) {
+                    if (c == quote) {
+                        quote = 0;
+                    }
+                }
+                else if (c == '\'' || c == '"') {
+                    quote = c;
+                }
+                else if (c == '-' && i + 1 < line.size() && line[i + 1] == '-') {
+                    return line.substr(0, i);
+                }
+            }
+            return line;
+        }
+
+        // the keyword starting in the first column of a line, in upper case,
+        // or an empty string
+        std::string keyword(const std::string& line)
+        {
+            if (line.empty() || !std::isalpha(static_cast<unsigned char>(line[0]))) {
+                return std::string();
+            }
+            std::size_t end = 0;
+            while (end < line.size() && !std::isspace(static_cast<unsigned char>(line[end]))
+                   && line[end] != '/') {
+                ++end;
+            }
+            std::string name = line.substr(0, end);
+            std::transform(name.begin(), name.end(), name.begin(),
+                           [](unsigned char c) { return std::toupper(c); });
+            return name;
+        }
+
+        // Append the items of a line up to a slash outside of quotes, returns
+        // whether the record ends on this line.
+        bool recordItems(const std::string& line, std::vector<std::string>& items)
+        {
+            std::size_t i = 0;
+            const std::size_t n = line.size();
+            while (i < n) {
+                const char c = line[i];
+                if (std::isspace(static_cast<unsigned char>(c))) {
+                    ++i;
+                }
+                else if (c == '/') {
+                    return true;
+                }
+                else if (c == '\'' || c == '"') {
+                    const std::size_t end = line.find(c, i + 1);
+                    if (end == std::string::npos) {
+                        items.push_back(line.substr(i + 1));
+                        return false;
+                    }
+                    items.push_back(line.substr(i + 1, end - i - 1));
+                    i = end + 1;
+                }
+                else {
+                    std::size_t end = i;
+                    while (end < n && !std::isspace(static_cast<unsigned char>(line[end])) && line[end] != '/') {
+                        ++end;
+                    }
+                    items.push_back(line.substr(i, end - i));
+                    i = end;
+                }
+            }
+            return false;
+        }
+
+        class DeckFlattener
+        {
+        public:
+            explicit DeckFlattener(const std::string& deckFile)
+                : root_(deckDirectory(deckFile))
+            {
+            }
+
+            void process(const std::string& file, const int depth)
+            {
+                if (depth > 100) {
+                    OPM_THROW(std::runtime_error, "The INCLUDE files are nested too deeply at " << file);
+                }
+                std::ifstream is(file.c_str());
+                if (!is) {
+                    OPM_THROW(std::runtime_error, "Cannot read the deck file " << file);
+                }
+                std::string line;
+                while (std::getline(is, line)) {
+                    const std::string name = keyword(stripComment(line));
+                    if (name == "INCLUDE") {
+                        std::vector<std::string> items;
+                        readRecord(is, file, items);
+                        if (items.empty()) {
+                            OPM_THROW(std::runtime_error, "An INCLUDE keyword in " << file << " has no file name.");
+                        }
+                        process(resolve(items[0]), depth + 1);
+                    }
+                    else if (name == "PATHS") {
+                        out_ << line << '\n';
+                        for (;;) {
+                            std::vector<std::string> items;
+                            out_ << readRecord(is, file, items);
+                            if (items.empty()) {
+                                break;
+                            }
+                            if (items.size() >= 2) {
+                                aliases_[items[0]] = items[1];
+                            }
+                        }
+                    }
+                    else if (name == "IMPORT" || name == "GDFILE" || name == "RESTART") {
+                        OPM_THROW(std::runtime_error, "The keyword " << name << " in " << file
+                                  << " refers to a file relative to the deck, which is not staged.");
+                    }
+                    else {
+                        out_ << line << '\n';
+                    }
+                }
+            }
+
+            std::string text() const
+            {
+                return out_.str();
+            }
+
+        private:
+            // Read the lines of a record and its items, returns the lines.
+            std::string readRecord(std::istream& is, const std::string& file, std::vector<std::string>& items)
+            {
+                std::string lines;
+                std::string line;
+                while (std::getline(is, line)) {
+                    lines += line + '\n';
+                    if (recordItems(stripComment(line), items)) {
+                        return lines;
+                    }
+                }
+                OPM_THROW(std::runtime_error, "A record in " << file << " is not terminated by a slash.");
+            }
+
+            // the path of an included file with the PATHS aliases substituted,
+            // relative paths start in the directory of the deck
+            std::string resolve(std::string path) const
+            {
+                if (!path.empty() && path[0] == '$') {
+                    const std::size_t end = path.find('/');
+                    const std::string alias = path.substr(1, end == std::string::npos ? std::string::npos : end - 1);
+                    const auto it = aliases_.find(alias);
+                    if (it == aliases_.end()) {
+                        OPM_THROW(std::runtime_error, "The PATHS alias " << alias << " is not defined.");
+                    }
+                    path = it->second + (end == std::string::npos ? std::string() : path.substr(end));
+                }
+                const boost::filesystem::path p(path);
+                return p.is_absolute() ? path : (boost::filesystem::path(root_) / p).string();
+            }
+
+            std::string root_;
+            std::map<std::string, std::string> aliases_;
+            std::ostringstream out_;
+        };
+
+#if HAVE_MPI
+        // Whether this process writes the staged deck of its node, and the
+        // directory. Without shared memory communicators every process
+        // writes its own copy.
+        bool stagingWriter(boost::filesystem::path& directory)
+        {
+#if MPI_VERSION >= 3
+            MPI_Comm nodeComm;
+            MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &nodeComm);
+            int nodeRank = 0;
+            MPI_Comm_rank(nodeComm, &nodeRank);
+            MPI_Comm_free(&nodeComm);
+            static_cast<void>(directory);
+            return nodeRank == 0;
+#else
+            int rank = 0;
+            MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+            directory /= std::to_string(rank);
+            return true;
+#endif
+        }
+#endif
+    } // anonymous namespace
+
+
+
+    std::string flattenDeck(const std::string& deckFile)
+    {
+        DeckFlattener flattener(deckFile);
+        flattener.process(deckFile, 0);
+        return flattener.text();
+    }
+
+
+
+    std::string stageDeck(const std::string& deckFile, const std::string& stageDirectory)
+    {
+#if HAVE_MPI
+        int initialized = 0;
+        MPI_Initialized(&initialized);
+        int size = 1;
+        int rank = 0;
+        if (initialized) {
+            MPI_Comm_size(MPI_COMM_WORLD, &size);
+            MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        }
+        if (size == 1) {
+            return deckFile;
+        }
+
+        // the length of the text, negative if it could not be read, and the
+        // process id of the first process, which names the directory
+        std::string text;
+        std::string error;
+        long long header[2] = { -1, 0 };
+        if (rank == 0) {
+            try {
+                text = flattenDeck(deckFile);
+                header[0] = text.size();
+            }
+            catch (const std::exception& e) {
+                error = e.what();
+            }
+            header[1] = getpid();
+        }
+        MPI_Bcast(header, 2, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+        if (header[0] < 0) {
+            OPM_THROW(std::runtime_error, "The deck " << deckFile << " could not be staged"
+                      << (error.empty() ? std::string(".") : ": " + error));
+        }
+        text.resize(header[0]);
+        const long long chunk = 1LL << 30;
+        for (long long offset = 0; offset < header[0]; offset += chunk) {
+            const int count = std::min(chunk, header[0] - offset);
+            MPI_Bcast(&text[offset], count, MPI_CHAR, 0, MPI_COMM_WORLD);
+        }
+
+        const boost::filesystem::path deckPath(deckFile);
+        boost::filesystem::path directory = boost::filesystem::path(stageDirectory)
+            / ("opm-" + deckPath.stem().string() + "-" + std::to_string(header[1]));
+        const bool writer = stagingWriter(directory);
+        const boost::filesystem::path staged = directory / deckPath.filename();
+        int ok = 1;
+        if (writer) {
+            try {
+                boost::filesystem::create_directories(directory);
+                std::ofstream os(staged.string().c_str(), std::ios::binary);
+                os.write(text.data(), text.size());
+                ok = os.good() ? 1 : 0;
+            }
+            catch (const std::exception&) {
+                ok = 0;
+            }
+        }
+        // the reduction also keeps the readers waiting for the writers
+        MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+        if (!ok) {
+            OPM_THROW(std::runtime_error, "The deck could not be staged in " << stageDirectory);
+        }
+        return staged.string();
+#else
+        static_cast<void>(stageDirectory);
+        return deckFile;
+#endif
+    }
+
+
+
+    void unstageDeck(const std::string& deckFile, const std::string& stagedDeck)
+    {
+        if (stagedDeck == deckFile) {
+            return;
+        }
+#if HAVE_MPI
+        MPI_Barrier(MPI_COMM_WORLD);
+        boost::filesystem::path directory = boost::filesystem::path(stagedDeck).parent_path();
+        boost::filesystem::path unused;
+        if (stagingWriter(unused)) {
+            boost::system::error_code ec;
+            boost::filesystem::remove_all(directory, ec);
+        }
+#endif
+    }
+
+
+
+    std::string deckDirectory(const std::string& deckFile)
+    {
+        const boost::filesystem::path directory = boost::filesystem::path(deckFile).parent_path();
+        return directory.empty() ? std::string(".") : directory.string();
+    }
+
+} // namespace Opm
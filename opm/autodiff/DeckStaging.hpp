@@ -0,0 +1,59 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_DECKSTAGING_HEADER_INCLUDED
+#define OPM_DECKSTAGING_HEADER_INCLUDED
+
+#include <string>
+
+namespace Opm
+{
+
+    /// Read an input deck with its INCLUDE files on a single process and
+    /// stage it on the compute nodes, such that the processes read the deck
+    /// from a node-local directory instead of all reading the same files
+    /// from the shared file system.
+
+    /// The text of a deck with its INCLUDE files inlined recursively. The
+    /// include paths are relative to the directory of the deck, with the
+    /// aliases of the PATHS keyword substituted. Throws std::runtime_error
+    /// if a file cannot be read or if the deck refers to other files by the
+    /// keywords IMPORT, GDFILE or RESTART, which would have to be found
+    /// relative to the directory of the deck.
+    std::string flattenDeck(const std::string& deckFile);
+
+    /// Inline the deck on the first process, broadcast it and write it to
+    /// the directory stageDirectory/opm-<deck>-<id> by the first process of
+    /// each node, under the file name of the deck. Returns the name of the
+    /// staged deck, or deckFile itself in a run on a single process.
+    /// Collective, throws std::runtime_error on all processes if the deck
+    /// could not be flattened or written.
+    std::string stageDeck(const std::string& deckFile, const std::string& stageDirectory);
+
+    /// Remove the directory of a deck staged by stageDeck() once all
+    /// processes have read it. Collective.
+    void unstageDeck(const std::string& deckFile, const std::string& stagedDeck);
+
+    /// The directory of a deck file, "." for a file name without one, which
+    /// is the default output directory of the deck.
+    std::string deckDirectory(const std::string& deckFile);
+
+} // namespace Opm
+
+#endif // OPM_DECKSTAGING_HEADER_INCLUDED
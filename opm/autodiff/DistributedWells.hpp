@@ -0,0 +1,154 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_DISTRIBUTEDWELLS_HEADER_INCLUDED
+#define OPM_DISTRIBUTEDWELLS_HEADER_INCLUDED
+
+#include <cassert>
+#include <vector>
+
+namespace Opm
+{
+
+    /// The wells whose perforations are on several processes.
+    ///
+    /// The equations of such a well are the sums of the contributions of
+    /// its perforations on all processes, and the products of its coupling
+    /// matrix C with a reservoir vector are sums over the processes as
+    /// well. The distributed wells are numbered in the order of the wells
+    /// of the schedule, which is the same on all processes, such that their
+    /// values can be summed with a single reduction of a packed buffer. All
+    /// processes take part in the reductions, including those without any
+    /// of the wells.
+    class DistributedWells
+    {
+    public:
+        /// Find the distributed wells, collective over the processes.
+        /// \param[in] localIndex     for each well of the schedule the index of
+        ///                           the local well with its perforations on
+        ///                           this process, -1 if it has none
+        /// \param[in] numLocalWells  the number of local wells
+        /// \param[in] comm           the collective communication of the grid
+        template <class Communication>
+        void init(const std::vector<int>& localIndex, const int numLocalWells, const Communication& comm)
+        {
+            const int numWells = localIndex.size();
+            std::vector<int> numProcesses(numWells, 0);
+            std::vector<int> owner(numWells, comm.size());
+            for (int i = 0; i < numWells; ++i) {
+                if (localIndex[i] >= 0) {
+                    numProcesses[i] = 1;
+                    owner[i] = comm.rank();
+                }
+            }
+            if (numWells > 0) {
+                comm.sum(numProcesses.data(), numWells);
+                comm.min(owner.data(), numWells);
+            }
+
+            localWells_.clear();
+            distributed_.assign(numLocalWells, false);
+            owner_.assign(numLocalWells, true);
+            for (int i = 0; i < numWells; ++i) {
+                if (numProcesses[i] < 2) {
+                    continue;
+                }
+                const int w = localIndex[i];
+                localWells_.push_back(w);
+                if (w >= 0) {
+                    assert(w < numLocalWells);
+                    distributed_[w] = true;
+                    owner_[w] = owner[i] == comm.rank();
+                }
+            }
+        }
+
+        /// Whether any well is distributed, the same on all processes.
+        bool active() const
+        {
+            return !localWells_.empty();
+        }
+
+        /// The number of distributed wells.
+        int size() const
+        {
+            return localWells_.size();
+        }
+
+        /// The local well of the distributed well i, -1 if it has no
+        /// perforations on this process.
+        int localWell(const int i) const
+        {
+            return localWells_[i];
+        }
+
+        /// Whether the local well w has perforations on other processes.
+        bool isDistributed(const int w) const
+        {
+            return !distributed_.empty() && distributed_[w];
+        }
+
+        /// Whether this process adds the terms of the local well w that do
+        /// not belong to a perforation, i.e. the lowest rank with
+        /// perforations of a distributed well and always for the others.
+        bool isOwner(const int w) const
+        {
+            return owner_.empty() || owner_[w];
+        }
+
+        /// Sum the blocks of the distributed wells over the processes, the
+        /// block of the local well w is blocks[w], with blockSize entries.
+        template <class Blocks, class Communication>
+        void sumBlocks(Blocks& blocks, const int blockSize, const Communication& comm) const
+        {
+            if (!active()) {
+                return;
+            }
+            buffer_.assign(size() * blockSize, 0.0);
+            for (int i = 0; i < size(); ++i) {
+                const int w = localWells_[i];
+                if (w >= 0) {
+                    int k = i * blockSize;
+                    for (const auto& value : blocks[w]) {
+                        buffer_[k++] = value;
+                    }
+                }
+            }
+            comm.sum(buffer_.data(), buffer_.size());
+            for (int i = 0; i < size(); ++i) {
+                const int w = localWells_[i];
+                if (w >= 0) {
+                    int k = i * blockSize;
+                    for (auto& value : blocks[w]) {
+                        value = buffer_[k++];
+                    }
+                }
+            }
+        }
+
+    private:
+        std::vector<int> localWells_;
+        std::vector<bool> distributed_;
+        std::vector<bool> owner_;
+        mutable std::vector<double> buffer_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_DISTRIBUTEDWELLS_HEADER_INCLUDED
@@ -0,0 +1,70 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_ELEMENTCOLORING_HEADER_INCLUDED
+#define OPM_ELEMENTCOLORING_HEADER_INCLUDED
+
+#include <vector>
+
+namespace Opm
+{
+
+    /// Color the rows of the matrix A with a symmetric pattern such that two
+    /// rows of the same color have no neighbour in common, i.e. they are at
+    /// a distance of more than two in the graph of A. The linearization of
+    /// the elements of one color then writes disjoint rows and columns of A
+    /// and of the residual, and can be threaded without locks.
+    /// \param[in] A      matrix whose row i is the stencil of element i
+    /// \param[in] rows   the rows to color, in the order of coloring
+    /// \return the rows of each color, each in the order of rows
+    template <class M>
+    std::vector< std::vector<int> > distanceTwoColoring(const M& A, const std::vector<int>& rows)
+    {
+        const int n = A.N();
+        std::vector<int> color(n, -1);
+        // the last row for which a color was found in the neighbourhood
+        std::vector<int> forbidden;
+        std::vector< std::vector<int> > colors;
+
+        for (const int row : rows) {
+            for (auto nb = A[row].begin(); nb != A[row].end(); ++nb) {
+                for (auto nb2 = A[nb.index()].begin(); nb2 != A[nb.index()].end(); ++nb2) {
+                    const int c = color[nb2.index()];
+                    if (c >= 0) {
+                        forbidden[c] = row;
+                    }
+                }
+            }
+            int c = 0;
+            while (c < int(colors.size()) && forbidden[c] == row) {
+                ++c;
+            }
+            if (c == int(colors.size())) {
+                colors.emplace_back();
+                forbidden.push_back(-1);
+            }
+            color[row] = c;
+            colors[c].push_back(row);
+        }
+        return colors;
+    }
+
+} // namespace Opm
+
+#endif // OPM_ELEMENTCOLORING_HEADER_INCLUDED
@@ -0,0 +1,88 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <opm/autodiff/EnsembleMembers.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace Opm
+{
+
+    EnsembleMembers::EnsembleMembers(const std::string& filename)
+    {
+        std::ifstream input(filename.c_str());
+        if (!input) {
+            OPM_THROW(std::runtime_error, "Could not open ensemble file " << filename);
+        }
+        read(input, filename);
+    }
+
+
+
+    EnsembleMembers::EnsembleMembers(std::istream& input, const std::string& name)
+    {
+        read(input, name);
+    }
+
+
+
+    void EnsembleMembers::read(std::istream& input, const std::string& name)
+    {
+        std::set<std::string> names;
+        std::string line;
+        int lineno = 0;
+        while (std::getline(input, line)) {
+            ++lineno;
+            const std::string::size_type comment = line.find('#');
+            if (comment != std::string::npos) {
+                line.erase(comment);
+            }
+
+            std::istringstream tokens(line);
+            Member member;
+            if (!(tokens >> member.name)) {
+                continue;
+            }
+            if (member.name.find('=') != std::string::npos) {
+                OPM_THROW(std::runtime_error, name << ":" << lineno
+                          << ": the line must start with the name of the member");
+            }
+            if (!names.insert(member.name).second) {
+                OPM_THROW(std::runtime_error, name << ":" << lineno
+                          << ": duplicate member " << member.name);
+            }
+
+            std::string token;
+            while (tokens >> token) {
+                const std::string::size_type eq = token.find('=');
+                if (eq == std::string::npos || eq == 0) {
+                    OPM_THROW(std::runtime_error, name << ":" << lineno
+                              << ": expected key=value, got " << token);
+                }
+                member.overrides[token.substr(0, eq)] = token.substr(eq + 1);
+            }
+            members_.push_back(member);
+        }
+    }
+
+} // namespace Opm
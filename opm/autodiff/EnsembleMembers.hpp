@@ -0,0 +1,80 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_ENSEMBLEMEMBERS_HEADER_INCLUDED
+#define OPM_ENSEMBLEMEMBERS_HEADER_INCLUDED
+
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    /// The realizations of an ensemble run, read from an ensemble file.
+    ///
+    /// Each non-empty line of the file describes one member: its name
+    /// followed by the parameters in which it differs from the base run,
+    /// as whitespace separated key=value pairs. Everything after a '#' is
+    /// a comment.
+    ///
+    ///     # name    overrides
+    ///     real-001  tolerance_cnv=0.02  solver_approach=interleaved
+    ///     real-002
+    ///
+    /// The member name is used as the name of its output directory, it
+    /// must be unique.
+    class EnsembleMembers
+    {
+    public:
+        typedef std::map<std::string, std::string> Overrides;
+
+        struct Member
+        {
+            std::string name;
+            Overrides overrides;
+        };
+
+        /// Read the members from a file. Throws std::runtime_error if
+        /// the file cannot be opened or a line is malformed.
+        explicit EnsembleMembers(const std::string& filename);
+
+        /// Read the members from a stream, the name is only used in
+        /// error messages.
+        EnsembleMembers(std::istream& input, const std::string& name);
+
+        std::size_t size() const { return members_.size(); }
+
+        bool empty() const { return members_.empty(); }
+
+        const Member& operator[](const std::size_t idx) const { return members_[idx]; }
+
+        std::vector<Member>::const_iterator begin() const { return members_.begin(); }
+        std::vector<Member>::const_iterator end() const { return members_.end(); }
+
+    private:
+        void read(std::istream& input, const std::string& name);
+
+        std::vector<Member> members_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_ENSEMBLEMEMBERS_HEADER_INCLUDED
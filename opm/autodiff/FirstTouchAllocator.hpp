@@ -0,0 +1,132 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_FIRSTTOUCHALLOCATOR_HEADER_INCLUDED
+#define OPM_FIRSTTOUCHALLOCATOR_HEADER_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace Opm
+{
+
+    namespace detail
+    {
+        /// Write one byte of every page of [begin, begin + bytes) in a
+        /// statically scheduled OpenMP loop. The operating system places a
+        /// page on the NUMA node of the thread that first writes to it, so
+        /// the pages of the i-th part of the range end up on the node of the
+        /// thread which handles the i-th part of a statically scheduled loop
+        /// over the elements, as in the threaded assembly and preconditioner
+        /// loops. Ranges below a few pages are left alone.
+        inline void firstTouch(void* begin, const std::size_t bytes)
+        {
+            const std::size_t pageSize = 4096;
+            const long numPages = bytes/pageSize;
+            if (numPages < 16) {
+                return;
+            }
+            char* const pages = static_cast<char*>(begin);
+#pragma omp parallel for schedule(static)
+            for (long page = 0; page < numPages; ++page) {
+                pages[page*pageSize] = 0;
+            }
+        }
+    } // namespace detail
+
+    /// An allocator which touches the memory it hands out with all OpenMP
+    /// threads, see detail::firstTouch(). Containers which are later written
+    /// and read in statically scheduled threaded loops then have their pages
+    /// distributed over the NUMA nodes of the threads instead of placed on
+    /// the node of the thread that allocated them. Without OpenMP it behaves
+    /// like std::allocator.
+    template <class T>
+    class FirstTouchAllocator
+    {
+    public:
+        typedef T value_type;
+        typedef T* pointer;
+        typedef const T* const_pointer;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        template <class U>
+        struct rebind
+        {
+            typedef FirstTouchAllocator<U> other;
+        };
+
+        FirstTouchAllocator() noexcept
+        {
+        }
+
+        template <class U>
+        FirstTouchAllocator(const FirstTouchAllocator<U>&) noexcept
+        {
+        }
+
+        pointer allocate(const size_type n, const void* = nullptr)
+        {
+            pointer p = std::allocator<T>().allocate(n);
+            detail::firstTouch(p, n*sizeof(T));
+            return p;
+        }
+
+        void deallocate(pointer p, const size_type n)
+        {
+            std::allocator<T>().deallocate(p, n);
+        }
+
+        size_type max_size() const noexcept
+        {
+            return std::size_t(-1)/sizeof(T);
+        }
+
+        template <class U, class... Args>
+        void construct(U* p, Args&&... args)
+        {
+            ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+        }
+
+        template <class U>
+        void destroy(U* p)
+        {
+            p->~U();
+        }
+    };
+
+    template <class T, class U>
+    bool operator==(const FirstTouchAllocator<T>&, const FirstTouchAllocator<U>&)
+    {
+        return true;
+    }
+
+    template <class T, class U>
+    bool operator!=(const FirstTouchAllocator<T>&, const FirstTouchAllocator<U>&)
+    {
+        return false;
+    }
+
+} // namespace Opm
+
+#endif // OPM_FIRSTTOUCHALLOCATOR_HEADER_INCLUDED
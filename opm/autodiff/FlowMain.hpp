@@ -37,6 +37,7 @@
 
 
 #include <opm/core/grid/GridManager.hpp>
+#include <opm/autodiff/AutoDiffThreading.hpp>
 #include <opm/autodiff/GridHelpers.hpp>
 #include <opm/autodiff/createGlobalCellArray.hpp>
 #include <opm/autodiff/GridInit.hpp>
@@ -70,6 +71,7 @@
 #include <opm/autodiff/RedistributeDataHandles.hpp>
 #include <opm/autodiff/moduleVersion.hpp>
 #include <opm/autodiff/MissingFeatures.hpp>
+#include <opm/autodiff/DeckStaging.hpp>
 
 #include <opm/core/utility/share_obj.hpp>
 #include <opm/core/utility/initHydroCarbonState.hpp>
@@ -96,9 +98,11 @@
 #include <memory>
 #include <algorithm>
 #include <cstdlib>
+#include <iomanip>
 #include <iostream>
 #include <vector>
 #include <numeric>
+#include <sstream>
 #include <cstdlib>
 #include <stdexcept>
 
@@ -218,6 +222,7 @@ namespace Opm
         bool output_to_files_ = false;
         std::string output_dir_ = std::string(".");
         // readDeckInput()
+        bool deck_staged_ = false;
         std::shared_ptr<Deck> deck_;
         std::shared_ptr<EclipseState> eclipse_state_;
         // setupGridAndProps()
@@ -352,6 +357,10 @@ namespace Opm
                     "    c) as a parameter in a parameter file (.param or .xml) passed to the program.\n";
                 return false;
             }
+
+            // the size from which the elementwise AD operations are threaded
+            AutoDiffThreading::setMinimumSize(param_.getDefault("ad_threading_min_size",
+                                                                AutoDiffThreading::minimumSize()));
             return true;
         }
 
@@ -370,8 +379,11 @@ namespace Opm
 
             // Setup output directory.
             auto& ioConfig = eclipse_state_->getIOConfig();
-            // Default output directory is the directory where the deck is found.
-            const std::string default_output_dir = ioConfig.getOutputDir();
+            // Default output directory is the directory where the deck is found,
+            // not the one of its staged copy.
+            const std::string default_output_dir = deck_staged_
+                ? deckDirectory(param_.get<std::string>("deck_filename"))
+                : ioConfig.getOutputDir();
             output_dir_ = param_.getDefault("output_dir", default_output_dir);
             // Override output directory if user specified.
             ioConfig.setOutputDir(output_dir_);
@@ -487,6 +499,22 @@ namespace Opm
         {
             std::string deck_filename = param_.get<std::string>("deck_filename");
 
+            // with stage_deck_dir set, read a node-local copy of the deck
+            // with its INCLUDE files inlined, written once per node
+            std::string staged_deck = deck_filename;
+            const std::string stage_dir = param_.getDefault("stage_deck_dir", std::string(""));
+            if (!stage_dir.empty()) {
+                try {
+                    staged_deck = stageDeck(deck_filename, stage_dir);
+                    deck_staged_ = staged_deck != deck_filename;
+                }
+                catch (const std::runtime_error& e) {
+                    if (output_cout_) {
+                        std::cout << "Reading the deck on every process. " << e.what() << std::endl;
+                    }
+                }
+            }
+
             // Create Parser
             Parser parser;
 
@@ -496,7 +524,8 @@ namespace Opm
                                             { ParseContext::PARSE_MISSING_DIMS_KEYWORD, InputError::WARN   },
                                             { ParseContext::SUMMARY_UNKNOWN_WELL,       InputError::WARN   },
                                             { ParseContext::SUMMARY_UNKNOWN_GROUP,      InputError::WARN   }});
-                deck_ = std::make_shared< Deck >( parser.parseFile(deck_filename, parseContext) );
+                deck_ = std::make_shared< Deck >( parser.parseFile(staged_deck, parseContext) );
+                unstageDeck(deck_filename, staged_deck);
                 checkDeck(*deck_, parser);
 
                 if ( output_cout_)
@@ -569,6 +598,20 @@ namespace Opm
             // Geological properties
             use_local_perm_ = param_.getDefault("use_local_perm", use_local_perm_);
             geoprops_.reset(new DerivedGeology(grid, *fluidprops_, *eclipse_state_, use_local_perm_, gravity_.data()));
+
+            if (output_cout_) {
+                const DerivedGeology::SetupTimes& times = geoprops_->setupTimes();
+                std::ostringstream ss;
+                ss << std::fixed << std::setprecision(3)
+                   << "Geology setup time (sec): " << times.total() << "\n"
+                   << "  Pore volumes:               " << times.poreVolume << "\n"
+                   << "  Half-transmissibilities:    " << times.halfTransmissibility << "\n"
+                   << "  Multipliers:                " << times.multipliers << "\n"
+                   << "  Transmissibilities:         " << times.transmissibility << "\n"
+                   << "  Non-cartesian connections:  " << times.nnc << "\n"
+                   << "  Gravity potentials:         " << times.gravity;
+                OpmLog::debug(ss.str());
+            }
         }
 
 
@@ -689,7 +732,8 @@ namespace Opm
                     distributeGridAndData(grid_init_->grid(), *deck_, *eclipse_state_,
                                           *state_, *fluidprops_, *geoprops_,
                                           material_law_manager_, threshold_pressures_,
-                                          parallel_information_, use_local_perm_);
+                                          parallel_information_, use_local_perm_,
+                                          PartitionWeightParameters(param_));
             }
         }
 
@@ -35,10 +35,20 @@
 #include <opm/autodiff/NewtonIterationBlackoilCPR.hpp>
 #include <opm/autodiff/NewtonIterationBlackoilInterleaved.hpp>
 #include <opm/autodiff/MissingFeatures.hpp>
+#include <opm/autodiff/PerformanceSummary.hpp>
+#include <opm/autodiff/TimerTree.hpp>
+#include <opm/autodiff/HardwareCounters.hpp>
+#include <opm/autodiff/MemoryTracker.hpp>
+#include <opm/autodiff/StartupProfile.hpp>
 #include <opm/autodiff/moduleVersion.hpp>
 #include <opm/autodiff/ExtractParallelGridInformationToISTL.hpp>
 #include <opm/autodiff/RedistributeDataHandles.hpp>
 #include <opm/autodiff/SimulatorFullyImplicitBlackoilEbos.hpp>
+#include <opm/autodiff/StartupCache.hpp>
+#include <opm/autodiff/EnsembleMembers.hpp>
+#include <opm/autodiff/DeckStaging.hpp>
+#include <opm/autodiff/PararealPropagators.hpp>
+#include <opm/simulators/timestepping/PararealIteration.hpp>
 
 #include <opm/core/props/satfunc/RelpermDiagnostics.hpp>
 
@@ -80,6 +90,7 @@ namespace Opm
         typedef typename GET_PROP_TYPE(TypeTag, Problem) Problem;
         typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
         typedef typename GET_PROP_TYPE(TypeTag, FluidSystem) FluidSystem;
+        typedef typename GET_PROP_TYPE(TypeTag, ElementContext) ElementContext;
 
         typedef Opm::SimulatorFullyImplicitBlackoilEbos<TypeTag> Simulator;
         typedef typename Simulator::ReservoirState ReservoirState;
@@ -97,27 +108,56 @@ namespace Opm
                 // with incorrect locale settings.
                 resetLocale();
 
+                programName_ = boost::filesystem::path(argv[0]).filename().string();
                 setupParallelism(argc, argv);
                 printStartupMessage();
                 const bool ok = setupParameters(argc, argv);
                 if (!ok) {
                     return EXIT_FAILURE;
                 }
+                MemoryTracker::enable(param_.getDefault("memory_tracking", false));
+                DebugLog::enable(param_.getDefault("debug_log", std::string()));
 
                 setupEbosSimulator();
+                MemoryTracker::sample(MemoryTracker::DeckAndGrid);
+                startupProfile_.endStep("deck, grid and distribution");
                 setupOutput();
+                openMemoryTracking();
                 setupLogging();
                 printPRTHeader();
                 extractMessages();
                 runDiagnostics();
+                startupProfile_.endStep("logging and diagnostics");
                 setupState();
+                MemoryTracker::sample(MemoryTracker::Equilibration);
+                startupProfile_.endStep("initial state");
                 writeInit();
+                MemoryTracker::sample(MemoryTracker::Geology);
+                startupProfile_.endStep("INIT file");
                 setupOutputWriter();
+                startupProfile_.endStep("output writer");
                 setupLinearSolver();
-                createSimulator();
+                startupProfile_.endStep("linear solver");
+
+                if (param_.getDefault("dry_run", false)) {
+                    const int ret = runDryRun();
+                    mergeParallelLogFiles();
+                    return ret;
+                }
 
                 // Run.
-                auto ret =  runSimulator();
+                int ret;
+                const std::string ensembleFile = param_.getDefault("ensemble_file", std::string(""));
+                const int pararealSlabs = param_.getDefault("parareal_slabs", 0);
+                if (pararealSlabs > 0) {
+                    createSimulator();
+                    ret = runParareal(pararealSlabs);
+                } else if (ensembleFile.empty()) {
+                    createSimulator();
+                    ret = runSimulator();
+                } else {
+                    ret = runEnsemble(EnsembleMembers(ensembleFile));
+                }
 
                 mergeParallelLogFiles();
 
@@ -262,8 +302,11 @@ namespace Opm
 
             // Setup output directory.
             auto& ioConfig = eclState().getIOConfig();
-            // Default output directory is the directory where the deck is found.
-            const std::string default_output_dir = ioConfig.getOutputDir();
+            // Default output directory is the directory where the deck is found,
+            // not the one of its staged copy.
+            const std::string default_output_dir = deck_staged_
+                ? deckDirectory(param_.get<std::string>("deck_filename"))
+                : ioConfig.getOutputDir();
             output_dir_ = param_.getDefault("output_dir", default_output_dir);
             // Override output directory if user specified.
             ioConfig.setOutputDir(output_dir_);
@@ -387,7 +430,23 @@ namespace Opm
             // force closing of all log files.
             OpmLog::removeAllBackends();
 
-            if( mpi_rank_ != 0 || !must_distribute_ || !output_to_files_ )
+            // "serial": rank 0 appends the files of all processes,
+            // "tree": the processes merge the files pairwise, see
+            // detail::mergeParallelFilesTree,
+            // "index": rank 0 lists the files in an index and keeps them.
+            std::string merge = param_.getDefault("parallel_log_merge", std::string("serial"));
+            if ( merge != "serial" && merge != "tree" && merge != "index" )
+            {
+                if ( mpi_rank_ == 0 )
+                {
+                    std::cerr << "Value " << merge << " passed to option parallel_log_merge"
+                              << " was invalid. Using \"serial\" instead." << std::endl;
+                }
+                merge = "serial";
+            }
+
+            // output_to_files_ is only set on rank 0
+            if( !must_distribute_ || output_ == OUTPUT_NONE )
             {
                 return;
             }
@@ -401,22 +460,71 @@ namespace Opm
 
             fs::path deck_filename(param_.get<std::string>("deck_filename"));
 
+            if ( merge == "tree" )
+            {
+                detail::mergeParallelFilesTree(output_path, deck_filename.stem().string(),
+                                               Dune::MPIHelper::getCollectiveCommunication());
+                return;
+            }
+
+            if( mpi_rank_ != 0 || !output_to_files_ )
+            {
+                return;
+            }
+
             std::for_each(fs::directory_iterator(output_path),
                           fs::directory_iterator(),
-                          detail::ParallelFileMerger(output_path, deck_filename.stem().string()));
+                          detail::ParallelFileMerger(output_path, deck_filename.stem().string(),
+                                                     merge == "index"));
+        }
+
+        // The deck file for ebos. With stage_deck_dir set, the first process
+        // reads the deck and its INCLUDE files, and a copy with the files
+        // inlined is written to this node-local directory on every node,
+        // which the processes read instead of the shared file system. The
+        // deck itself is read if it cannot be staged.
+        std::string stageDeckInput(const std::string& deckFilename)
+        {
+            const std::string stageDir = param_.getDefault("stage_deck_dir", std::string(""));
+            if (stageDir.empty()) {
+                return deckFilename;
+            }
+            try {
+                const std::string stagedDeck = stageDeck(deckFilename, stageDir);
+                deck_staged_ = stagedDeck != deckFilename;
+                return stagedDeck;
+            }
+            catch (const std::runtime_error& e) {
+                if (output_cout_) {
+                    std::cout << "Reading the deck on every process. " << e.what() << std::endl;
+                }
+                return deckFilename;
+            }
         }
 
         void setupEbosSimulator()
         {
             std::string progName("flow_ebos");
+            const std::string deckFilename = param_.get<std::string>("deck_filename");
+            const std::string stagedDeck = stageDeckInput(deckFilename);
             std::string deckFile("--ecl-deck-file-name=");
-            deckFile += param_.get<std::string>("deck_filename");
-            char* ptr[2];
+            deckFile += stagedDeck;
+            // ebos threads its linearization and sizes its per-thread data,
+            // e.g. the local linearizers, by the number of threads per process
+            int numThreads = 1;
+#ifdef _OPENMP
+            numThreads = omp_get_max_threads();
+#endif
+            std::string threadsPerProcess("--threads-per-process=");
+            threadsPerProcess += std::to_string(numThreads);
+            char* ptr[3];
             ptr[ 0 ] = const_cast< char * > (progName.c_str());
             ptr[ 1 ] = const_cast< char * > (deckFile.c_str());
+            ptr[ 2 ] = const_cast< char * > (threadsPerProcess.c_str());
             EbosSimulator::registerParameters();
-            Ewoms::setupParameters_< TypeTag > ( 2, ptr );
+            Ewoms::setupParameters_< TypeTag > ( 3, ptr );
             ebosSimulator_.reset(new EbosSimulator(/*verbose=*/false));
+            unstageDeck(deckFilename, stagedDeck);
             ebosSimulator_->model().applyInitialSolution();
 
             // Create a grid with a global view.
@@ -516,7 +624,15 @@ namespace Opm
                                                   Opm::UgGridHelpers::numFaces(grid),
                                                   props.numPhases()));
 
-                initStateEquil(grid, props, deck(), eclState(), gravity(), *state_);
+                if (param_.getDefault("equil_from_ebos", false)) {
+                    // ebos has already equilibrated its initial solution on the
+                    // cells of this process, take the state from there instead of
+                    // equilibrating a second time
+                    extractEbosInitialState_(pu, *state_);
+                    initBlackoilSurfvolUsingRSorRV(Opm::UgGridHelpers::numCells(grid), props, *state_);
+                } else {
+                    initStateEquil(grid, props, deck(), eclState(), gravity(), *state_);
+                }
                 //state_.faceflux().resize(Opm::UgGridHelpers::numFaces(grid), 0.0);
             } else {
                 state_.reset( new ReservoirState( Opm::UgGridHelpers::numCells(grid),
@@ -608,11 +724,21 @@ namespace Opm
             bool output_ecl  = param_.getDefault("output_ecl", true);
             if( output && output_ecl && grid().comm().rank() == 0 )
             {
-                exportNncStructure_();
+                // the transmissibilities and nncs of the INIT file are taken from
+                // the startup cache, if there is one for this deck
+                const std::string cacheFile = param_.getDefault("startup_cache", std::string(""));
+                if( cacheFile.empty() || !readStartupCache_(cacheFile, initProps_) )
+                {
+                    exportNncStructure_();
+                    initProps_ = computeLegacySimProps_();
+                    if( !cacheFile.empty() ) {
+                        writeStartupCache_(cacheFile, initProps_);
+                    }
+                }
 
                 const EclipseGrid& inputGrid = eclState().getInputGrid();
                 eclIO_.reset(new EclipseIO(eclState(), UgGridHelpers::createEclipseGrid( this->globalGrid() , inputGrid )));
-                eclIO_->writeInitial(computeLegacySimProps_(), nnc_);
+                eclIO_->writeInitial(initProps_, nnc_);
             }
         }
 
@@ -644,6 +770,11 @@ namespace Opm
             const auto& initConfig = eclState().getInitConfig();
             simtimer.init(timeMap, (size_t)initConfig.getRestartStep());
 
+            const int benchmarkIterations = param_.getDefault("benchmark_iterations", 0);
+            if (benchmarkIterations > 0) {
+                return runBenchmark(simtimer, benchmarkIterations);
+            }
+
             if (!ioConfig.initOnly()) {
                 if (output_cout_) {
                     std::string msg;
@@ -651,8 +782,20 @@ namespace Opm
                     OpmLog::info(msg);
                 }
 
+                performanceSummary_.endPhase(PerformanceSummary::Setup);
+                TimerTree::enable(param_.getDefault("timer_tree", false));
+                if (param_.getDefault("hardware_counters", false) && !HardwareCounters::open()) {
+                    OpmLog::warning("Hardware performance counters are not available, "
+                                    "check /proc/sys/kernel/perf_event_paranoid");
+                }
                 SimulatorReport successReport = simulator_->run(simtimer, *state_);
                 SimulatorReport failureReport = simulator_->failureReport();
+                performanceSummary_.endPhase(PerformanceSummary::Simulation);
+                MemoryTracker::sample(MemoryTracker::Simulation);
+                writePerformanceSummary(successReport, failureReport);
+                writeTimerTree();
+                writeHardwareCounters();
+                writeMemoryTracking();
 
                 if (output_cout_) {
                     std::ostringstream ss;
@@ -682,6 +825,311 @@ namespace Opm
             return EXIT_SUCCESS;
         }
 
+        // Write the summary of the run to the file given by the parameter
+        // performance_summary_file, if any. Times and memory use are the
+        // maxima over all processes.
+        void writePerformanceSummary(const SimulatorReport& successReport,
+                                     const SimulatorReport& failureReport)
+        {
+            const std::string summaryFile = param_.getDefault("performance_summary_file", std::string(""));
+            if (summaryFile.empty()) {
+                return;
+            }
+            const auto& comm = ebosSimulator_->gridView().comm();
+            performanceSummary_.reduce(comm);
+            const int globalNumCells = comm.sum(ebosSimulator_->gridView().size(/*codim=*/0));
+            if (output_cout_) {
+                namespace fs = boost::filesystem;
+                const fs::path deckFile(param_.get<std::string>("deck_filename"));
+                performanceSummary_.write(summaryFile, programName_, deckFile.stem().string(),
+                                          comm.size(), globalNumCells,
+                                          successReport, failureReport);
+            }
+        }
+
+        // Log the timed regions of the run, with the minimum, average and
+        // maximum time over the processes, if the parameter timer_tree is set.
+        void writeTimerTree()
+        {
+            if (!TimerTree::enabled()) {
+                return;
+            }
+            TimerTree::enable(false);
+            const std::string report = TimerTree::report(ebosSimulator_->gridView().comm());
+            if (output_cout_) {
+                OpmLog::info(report);
+            }
+        }
+
+        // Log the hardware counters of the hot phases of the IO rank, if the
+        // parameter hardware_counters is set and they could be opened.
+        void writeHardwareCounters()
+        {
+            if (!HardwareCounters::enabled()) {
+                return;
+            }
+            HardwareCounters::close();
+            if (output_cout_) {
+                OpmLog::info(HardwareCounters::report());
+            }
+        }
+
+        // Open the file of the memory samples of this process in the output
+        // directory, if the parameter memory_tracking is set. Every process
+        // writes its own file, the last line of a process that ran out of
+        // memory is its last completed phase.
+        void openMemoryTracking()
+        {
+            if (!MemoryTracker::enabled()) {
+                return;
+            }
+            ensureDirectoryExists(output_dir_);
+            MemoryTracker::open(output_dir_ + "/memory." + std::to_string(mpi_rank_) + ".txt");
+        }
+
+        // Log the memory use of the phases over the processes, if the
+        // parameter memory_tracking is set.
+        void writeMemoryTracking()
+        {
+            if (!MemoryTracker::enabled()) {
+                return;
+            }
+            const std::string report = MemoryTracker::report(ebosSimulator_->gridView().comm());
+            if (output_cout_) {
+                OpmLog::info(report);
+            }
+        }
+
+        // Run the members of an ensemble one after the other. The grid, the
+        // geology, the well topology and the linear solver are set up once and
+        // shared by all members, each member only gets a fresh initial state,
+        // its own output writer and simulator, and writes to the subdirectory
+        // of the output directory named after it.
+        // Parameters of the linear solver are taken from the base run, member
+        // overrides of them have no effect.
+        // Returns EXIT_SUCCESS if all members ran, EXIT_FAILURE otherwise.
+        int runEnsemble(const EnsembleMembers& members)
+        {
+            if (members.empty()) {
+                OpmLog::warning("The ensemble file does not contain any members.");
+                return EXIT_SUCCESS;
+            }
+
+            auto& ioConfig = eclState().getIOConfig();
+            const ParameterGroup baseParam = param_;
+            const std::string baseOutputDir = output_dir_;
+            bool ok = true;
+            for (const auto& member : members) {
+                param_ = baseParam;
+                for (const auto& value : member.overrides) {
+                    param_.insertParameter(value.first, value.second);
+                }
+                output_dir_ = baseOutputDir + "/" + member.name;
+                param_.insertParameter("output_dir", output_dir_);
+                ioConfig.setOutputDir(output_dir_);
+                if (output_to_files_) {
+                    ensureDirectoryExists(output_dir_);
+                    param_.writeParam(output_dir_ + "/simulation.param");
+                }
+
+                if (output_cout_) {
+                    OpmLog::info("\n\n================ Ensemble member " + member.name
+                                 + " ===============\n");
+                }
+
+                try {
+                    // the first member uses the state set up by execute()
+                    if (&member != &members[0]) {
+                        ebosSimulator_->model().applyInitialSolution();
+                        setupState();
+                    }
+                    writeMemberInit();
+                    setupOutputWriter();
+                    createSimulator();
+                    runSimulator();
+                }
+                catch (const std::exception& e) {
+                    // a failing member must not take down the rest of the ensemble
+                    OpmLog::error("Ensemble member " + member.name + " failed: " + e.what());
+                    ok = false;
+                }
+
+                simulator_.reset();
+                output_writer_.reset();
+            }
+
+            param_ = baseParam;
+            output_dir_ = baseOutputDir;
+            ioConfig.setOutputDir(output_dir_);
+            return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        // Write the INIT file of an ensemble member from the transmissibilities
+        // and NNCs computed once by writeInit().
+        void writeMemberInit()
+        {
+            bool output      = ( output_ > OUTPUT_LOG_ONLY );
+            bool output_ecl  = param_.getDefault("output_ecl", true);
+            if( output && output_ecl && grid().comm().rank() == 0 && !eclIO_ )
+            {
+                const EclipseGrid& inputGrid = eclState().getInputGrid();
+                eclIO_.reset(new EclipseIO(eclState(), UgGridHelpers::createEclipseGrid( this->globalGrid() , inputGrid )));
+                eclIO_->writeInitial(initProps_, nnc_);
+            }
+        }
+
+        // Run a fixed number of Newton iterations on the initial state and
+        // report the timings instead of running the simulation.
+        // Returns EXIT_SUCCESS if it does not throw.
+        int runBenchmark(const SimulatorTimer& simtimer, const int iterations)
+        {
+            if (output_cout_) {
+                std::ostringstream ss;
+                ss << "\n\n================ Benchmarking " << iterations
+                   << " Newton iterations ===============\n";
+                OpmLog::info(ss.str());
+            }
+
+            const SimulatorReport report = simulator_->benchmark(simtimer, *state_, iterations);
+
+            int globalNumCells = ebosSimulator_->gridView().size(/*codim=*/0);
+            globalNumCells = ebosSimulator_->gridView().comm().sum(globalNumCells);
+            const double solveTime = report.assemble_time + report.linear_solve_time + report.update_time;
+
+            if (output_cout_) {
+                std::ostringstream ss;
+                ss << "Cells:                     " << globalNumCells << "\n"
+                   << "Newton iterations:         " << iterations << "\n"
+                   << "Linear iterations:         " << report.total_linear_iterations << "\n"
+                   << "Assembly time (s):         " << report.assemble_time << "\n"
+                   << "Linear solve time (s):     " << report.linear_solve_time << "\n"
+                   << "Update time (s):           " << report.update_time << "\n"
+                   << "Total time (s):            " << report.total_time << "\n"
+                   << "Throughput (cells*its/s):  "
+                   << (solveTime > 0.0 ? double(globalNumCells) * iterations / solveTime : 0.0) << "\n";
+                OpmLog::info(ss.str());
+            }
+            return EXIT_SUCCESS;
+        }
+
+        // Run the startup and a first linearization and linear solve on the
+        // initial state, which includes the setup of the preconditioner, and
+        // report the time and memory of each step instead of running the
+        // simulation, if the parameter dry_run is set.
+        // Returns EXIT_SUCCESS if it does not throw.
+        int runDryRun()
+        {
+            createSimulator();
+            startupProfile_.endStep("simulator");
+
+            SimulatorTimer simtimer;
+            const auto& initConfig = eclState().getInitConfig();
+            simtimer.init(eclState().getSchedule().getTimeMap(), (size_t)initConfig.getRestartStep());
+            const SimulatorReport report = simulator_->benchmark(simtimer, *state_, /*iterations=*/1);
+            MemoryTracker::sample(MemoryTracker::FirstLinearSolve);
+            startupProfile_.endStep("first linearization and solve");
+
+            const auto& comm = ebosSimulator_->gridView().comm();
+            const std::string table = startupProfile_.report(comm);
+            const double assembleTime = comm.max(report.assemble_time);
+            const double linearSolveTime = comm.max(report.linear_solve_time);
+            const int globalNumCells = comm.sum(ebosSimulator_->gridView().size(/*codim=*/0));
+            writeMemoryTracking();
+            if (output_cout_) {
+                std::ostringstream ss;
+                ss << "\n\n================ Dry run, the simulation is not run ===============\n\n"
+                   << table
+                   << "Cells:                     " << globalNumCells << "\n"
+                   << "First assembly time (s):   " << assembleTime << "\n"
+                   << "First linear solve (s):    " << linearSolveTime << "\n";
+                OpmLog::info(ss.str());
+            }
+            return EXIT_SUCCESS;
+        }
+
+        // Run the schedule with the parallel-in-time iteration of Parareal
+        // over numSlabs time slabs, if the parameter parareal_slabs is set.
+        // The coarse propagator is the simulator with the looser tolerances
+        // and the larger time steps of the parareal_coarse_* parameters. The
+        // fine solves of an iteration are run one after another by the
+        // processes of the grid, the report gives the time they would take
+        // on one group of processes per slab, to judge whether a run
+        // parallel in time pays off for the model. Nothing is written but
+        // the report.
+        // Returns EXIT_SUCCESS if it does not throw.
+        int runParareal(const int numSlabs)
+        {
+            const auto& timeMap = eclState().getSchedule().getTimeMap();
+            const int first = eclState().getInitConfig().getRestartStep();
+            std::vector<double> lengths(timeMap.numTimesteps());
+            for (std::size_t step = 0; step < lengths.size(); ++step) {
+                lengths[step] = timeMap.getTimeStepLength(step);
+            }
+            const std::vector<int> boundaries = PararealIteration::slabBoundaries(lengths, first, numSlabs);
+
+            ParameterGroup coarseParam(param_);
+            coarseParam.insertParameter("tolerance_cnv", param_.getDefault("parareal_coarse_tolerance_cnv", std::string("0.1")));
+            coarseParam.insertParameter("tolerance_mb", param_.getDefault("parareal_coarse_tolerance_mb", std::string("1e-4")));
+            coarseParam.insertParameter("timestep.initial_timestep_in_days",
+                                        param_.getDefault("parareal_coarse_timestep_in_days", std::string("30")));
+            coarseParam.insertParameter("full_timestep_initially", "true");
+            for (const char* name : { "performance_trace_file", "metrics_file", "metrics_udp_address", "adjoint_gradient_file" }) {
+                coarseParam.insertParameter(name, "");
+            }
+            Simulator coarseSimulator(*ebosSimulator_,
+                                      coarseParam,
+                                      *fis_solver_,
+                                      FluidSystem::enableDissolvedGas(),
+                                      FluidSystem::enableVaporizedOil(),
+                                      eclState(),
+                                      *output_writer_,
+                                      defunctWellNames());
+
+            PararealPropagators<Simulator> propagators(coarseSimulator, *simulator_, timeMap, boundaries,
+                                                       Opm::phaseUsageFromDeck(deck()),
+                                                       FluidSystem::enableDissolvedGas(),
+                                                       FluidSystem::enableVaporizedOil());
+            PararealIteration parareal(boundaries.size() - 1,
+                                       param_.getDefault("parareal_tolerance", 1e-3),
+                                       param_.getDefault("parareal_max_iterations", numSlabs));
+
+            // the sequential fine solution for the speedup, if asked for
+            double sequentialTime = 0.0;
+            if (param_.getDefault("parareal_sequential_reference", false)) {
+                ReservoirState state(*state_);
+                SimulatorTimer simtimer;
+                simtimer.init(timeMap, first);
+                Opm::time::StopWatch watch;
+                watch.start();
+                simulator_->runSlab(simtimer, state, boundaries.back());
+                watch.stop();
+                sequentialTime = watch.secsSinceStart();
+            }
+
+            parareal.run(*state_, propagators);
+
+            if (output_cout_) {
+                const double pararealTime = parareal.coarseTime() + parareal.fineCriticalPath();
+                std::ostringstream ss;
+                ss << "\n\n================ Parareal over " << (boundaries.size() - 1)
+                   << " time slabs ===============\n\n"
+                   << "Iterations:                " << parareal.iterations()
+                   << (parareal.converged() ? "" : " (not converged)") << "\n"
+                   << "Coarse time (s):           " << parareal.coarseTime() << "\n"
+                   << "Fine time (s):             " << parareal.fineTime() << "\n"
+                   << "Fine time per slab (s):    " << parareal.fineCriticalPath() << "\n"
+                   << "Time parallel in time (s): " << pararealTime << "\n"
+                   << "Newton iterations:         " << propagators.coarseReport().total_newton_iterations
+                   << " coarse, " << propagators.fineReport().total_newton_iterations << " fine\n";
+                if (sequentialTime > 0.0) {
+                    ss << "Sequential time (s):       " << sequentialTime << "\n"
+                       << "Speedup:                   " << sequentialTime / pararealTime << "\n";
+                }
+                OpmLog::info(ss.str());
+            }
+            return EXIT_SUCCESS;
+        }
+
         // Setup linear solver.
         // Writes to:
         //   fis_solver_
@@ -934,6 +1382,112 @@ namespace Opm
             }
         }
 
+        // Copy pressure, saturations, Rs and Rv of the initial solution of
+        // ebos into the reservoir state.
+        void extractEbosInitialState_(const PhaseUsage& pu, ReservoirState& state)
+        {
+            enum { Aqua = BlackoilPhases::Aqua, Liquid = BlackoilPhases::Liquid, Vapour = BlackoilPhases::Vapour };
+            const int np = pu.num_phases;
+            auto& pressure = state.pressure();
+            auto& saturation = state.saturation();
+            auto& rs = state.gasoilratio();
+            auto& rv = state.rv();
+
+            const auto& gridView = ebosSimulator_->gridManager().gridView();
+            ElementContext elemCtx(*ebosSimulator_);
+            const auto& elemEndIt = gridView.template end</*codim=*/0>();
+            for (auto elemIt = gridView.template begin</*codim=*/0>(); elemIt != elemEndIt; ++elemIt) {
+                elemCtx.updatePrimaryStencil(*elemIt);
+                elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
+
+                const unsigned cellIdx = elemCtx.globalSpaceIndex(/*spaceIdx=*/0, /*timeIdx=*/0);
+                const auto& fs = elemCtx.intensiveQuantities(/*spaceIdx=*/0, /*timeIdx=*/0).fluidState();
+
+                pressure[cellIdx] = fs.pressure(FluidSystem::oilPhaseIdx).value();
+                if (pu.phase_used[Aqua]) {
+                    saturation[cellIdx*np + pu.phase_pos[Aqua]] = fs.saturation(FluidSystem::waterPhaseIdx).value();
+                }
+                if (pu.phase_used[Liquid]) {
+                    saturation[cellIdx*np + pu.phase_pos[Liquid]] = fs.saturation(FluidSystem::oilPhaseIdx).value();
+                }
+                if (pu.phase_used[Vapour]) {
+                    saturation[cellIdx*np + pu.phase_pos[Vapour]] = fs.saturation(FluidSystem::gasPhaseIdx).value();
+                }
+                rs[cellIdx] = FluidSystem::enableDissolvedGas() ? fs.Rs().value() : 0.0;
+                rv[cellIdx] = FluidSystem::enableVaporizedOil() ? fs.Rv().value() : 0.0;
+            }
+        }
+
+        // The key of the startup cache: the hash of the deck file and the
+        // size of the global grid. Included files are not part of the hash.
+        std::uint64_t startupCacheKey_() const
+        {
+            const int* dims = UgGridHelpers::cartDims(grid());
+            std::uint64_t key = StartupCache::hashFile(param_.get<std::string>("deck_filename"));
+            for (int d = 0; d < 3; ++d) {
+                key = StartupCache::hashCombine(key, dims[d]);
+            }
+            return StartupCache::hashCombine(key, UgGridHelpers::numCells(this->globalGrid()));
+        }
+
+        bool readStartupCache_(const std::string& cacheFile, data::Solution& simProps)
+        {
+            const StartupCache cache(cacheFile, startupCacheKey_());
+            const char* names[] = { "TRANX", "TRANY", "TRANZ" };
+            for (const char* name : names) {
+                if (!cache.has(name)) {
+                    return false;
+                }
+            }
+            const auto cell1 = cache.array("NNC_CELL1");
+            const auto cell2 = cache.array("NNC_CELL2");
+            const auto trans = cache.array("NNC_TRANS");
+            if (cell1.size != trans.size || cell2.size != trans.size) {
+                return false;
+            }
+
+            for (const char* name : names) {
+                const auto values = cache.array(name);
+                data::CellData cellData = {UnitSystem::measure::transmissibility,
+                                           std::vector<double>(values.begin(), values.end()),
+                                           data::TargetType::INIT};
+                simProps.insert(std::make_pair(std::string(name), cellData));
+            }
+
+            nnc_ = NNC();
+            for (std::size_t i = 0; i < trans.size; ++i) {
+                nnc_.addNNC(static_cast<int>(cell1.data[i]), static_cast<int>(cell2.data[i]), trans.data[i]);
+            }
+
+            if (output_cout_) {
+                OpmLog::info("Read transmissibilities and NNCs from the startup cache " + cacheFile);
+            }
+            return true;
+        }
+
+        void writeStartupCache_(const std::string& cacheFile, const data::Solution& simProps)
+        {
+            StartupCache::Arrays arrays;
+            for (const char* name : { "TRANX", "TRANY", "TRANZ" }) {
+                arrays[name] = simProps.at(name).data;
+            }
+            auto& cell1 = arrays["NNC_CELL1"];
+            auto& cell2 = arrays["NNC_CELL2"];
+            auto& trans = arrays["NNC_TRANS"];
+            for (const auto& nnc : nnc_.nncdata()) {
+                cell1.push_back(nnc.cell1);
+                cell2.push_back(nnc.cell2);
+                trans.push_back(nnc.trans);
+            }
+
+            try {
+                StartupCache::write(cacheFile, startupCacheKey_(), arrays);
+            }
+            catch (const std::exception& e) {
+                OpmLog::warning("Could not write the startup cache: " + std::string(e.what()));
+            }
+        }
+
         std::unique_ptr<EbosSimulator> ebosSimulator_;
         int  mpi_rank_ = 0;
         bool output_cout_ = false;
@@ -942,13 +1496,18 @@ namespace Opm
         ParameterGroup param_;
         bool output_to_files_ = false;
         std::string output_dir_ = std::string(".");
+        bool deck_staged_ = false;
         std::unique_ptr<ReservoirState> state_;
         NNC nnc_;
+        data::Solution initProps_;
         std::unique_ptr<EclipseIO> eclIO_;
         std::unique_ptr<OutputWriter> output_writer_;
         boost::any parallel_information_;
         std::unique_ptr<NewtonIterationBlackoilInterface> fis_solver_;
         std::unique_ptr<Simulator> simulator_;
+        PerformanceSummary performanceSummary_;
+        StartupProfile startupProfile_;
+        std::string programName_;
         std::string logFile_;
         // Needs to be shared pointer because it gets initialzed before MPI_Init.
         std::shared_ptr<Grid> globalGrid_;
@@ -46,7 +46,11 @@
 
 #include <opm/common/utility/platform_dependent/reenable_warnings.h>
 
+#include <chrono>
 #include <cstddef>
+#include <exception>
+#include <iterator>
+#include <vector>
 
 namespace Opm
 {
@@ -61,6 +65,23 @@ namespace Opm
     public:
         typedef Eigen::ArrayXd Vector;
 
+        /// Wall clock times in seconds of the parts of the last update().
+        struct SetupTimes
+        {
+            double poreVolume = 0.0;
+            double halfTransmissibility = 0.0;
+            double multipliers = 0.0;
+            double transmissibility = 0.0;
+            double nnc = 0.0;
+            double gravity = 0.0;
+
+            double total() const
+            {
+                return poreVolume + halfTransmissibility + multipliers
+                    + transmissibility + nnc + gravity;
+            }
+        };
+
         /// Construct contained derived geological properties
         /// from grid and property information.
         template <class Props, class Grid>
@@ -112,8 +133,21 @@ namespace Opm
             // Get grid from parser.
             const auto& eclgrid = eclState.getInputGrid();
 
+            // the loops over cells and faces below are threaded, the cells
+            // store their faces in the cell face arrays from cellFaceStart
+            const std::vector<int> cellFaceStart = cellFaceStart_(grid);
+            typedef std::chrono::steady_clock Clock;
+            Clock::time_point start = Clock::now();
+            auto lap = [&start]() {
+                const Clock::time_point now = Clock::now();
+                const double seconds = std::chrono::duration<double>(now - start).count();
+                start = now;
+                return seconds;
+            };
+
             // update the pore volume of all active cells in the grid
             computePoreVolume_(grid, eclState);
+            setupTimes_.poreVolume = lap();
 
             // Non-neighbour connections.
             nnc_ = eclState.getInputNNC();
@@ -123,11 +157,12 @@ namespace Opm
             Grid* ug = const_cast<Grid*>(& grid);
 
             if (! use_local_perm_) {
-                tpfa_htrans_compute(ug, props.permeability(), htrans.data());
+                tpfa_htrans_compute_(grid, cellFaceStart, props.permeability(), htrans);
             }
             else {
-                tpfa_loc_trans_compute_(grid,eclgrid, props.permeability(),htrans);
+                tpfa_loc_trans_compute_(grid, cellFaceStart, eclgrid, props.permeability(), htrans);
             }
+            setupTimes_.halfTransmissibility = lap();
 
             // Use volume weighted arithmetic average of the NTG values for
             // the cells effected by the current OPM cpgrid process algorithm
@@ -142,12 +177,13 @@ namespace Opm
             }
 
             std::vector<double> mult;
-            multiplyHalfIntersections_(grid, eclState, ntg, htrans, mult);
+            multiplyHalfIntersections_(grid, cellFaceStart, eclState, ntg, htrans, mult);
 
             if (!opmfil && eclgrid.isPinchActive()) {
                 // opmfil is hardcoded to be true. i.e the pinch processor is never used
                 pinchProcess_(grid, eclState, htrans, numCells);
             }
+            setupTimes_.multipliers = lap();
 
             // combine the half-face transmissibilites into the final face
             // transmissibilites.
@@ -155,15 +191,16 @@ namespace Opm
 
             // multiply the face transmissibilities with their appropriate
             // transmissibility multipliers
-            for (int faceIdx = 0; faceIdx < numFaces; faceIdx++) {
-                trans_[faceIdx] *= mult[faceIdx];
-            }
+            trans_ *= Eigen::Map<const Vector>(mult.data(), numFaces);
+            setupTimes_.transmissibility = lap();
 
             // Create the set of noncartesian connections.
             noncartesian_ = nnc_;
             exportNncStructure(grid);
+            setupTimes_.nnc = lap();
 
             // Compute z coordinates
+#pragma omp parallel for schedule(static)
             for (int c = 0; c<numCells; ++c){
                 z_[c] = Opm::UgGridHelpers::cellCenterDepth(grid, c);
             }
@@ -176,13 +213,14 @@ namespace Opm
                 typedef typename AutoDiffGrid::ADCell2FacesTraits<Grid>::Type Cell2Faces;
                 Cell2Faces c2f=AutoDiffGrid::cell2Faces(grid);
 
-                std::size_t i = 0;
-                for (typename Vector::Index c = 0; c < numCells; ++c) {
+#pragma omp parallel for schedule(static)
+                for (int c = 0; c < numCells; ++c) {
                     const double* const cc = AutoDiffGrid::cellCentroid(grid, c);
 
                     typename Cell2Faces::row_type faces=c2f[c];
                     typedef typename Cell2Faces::row_type::iterator Iter;
 
+                    std::size_t i = cellFaceStart[c];
                     for (Iter f=faces.begin(), end=faces.end(); f!=end; ++f, ++i) {
                         auto fc = AutoDiffGrid::faceCentroid(grid, *f);
 
@@ -193,6 +231,7 @@ namespace Opm
                 }
                 std::copy(grav, grav + nd, gravity_);
             }
+            setupTimes_.gravity = lap();
         }
 
 
@@ -207,6 +246,7 @@ namespace Opm
         Vector&       transmissibility()       { return trans_  ;}
         const NNC& nnc() const { return nnc_;}
         const NNC& nonCartesianConnections() const { return noncartesian_;}
+        const SetupTimes& setupTimes() const { return setupTimes_;}
 
 
         /// Most properties are loaded by the parser, and managed by
@@ -273,6 +313,7 @@ namespace Opm
     private:
         template <class Grid>
         void multiplyHalfIntersections_(const Grid &grid,
+                                        const std::vector<int>& cellFaceStart,
                                         const EclipseState& eclState,
                                         const std::vector<double> &ntg,
                                         Vector &halfIntersectTransmissibility,
@@ -280,10 +321,32 @@ namespace Opm
 
         template <class Grid>
         void tpfa_loc_trans_compute_(const Grid &grid,
+                                     const std::vector<int>& cellFaceStart,
                                      const EclipseGrid& eclGrid,
                                      const double* perm,
                                      Vector &hTrans);
 
+        template <class Grid>
+        void tpfa_htrans_compute_(const Grid &grid,
+                                  const std::vector<int>& cellFaceStart,
+                                  const double* perm,
+                                  Vector &hTrans);
+
+        /// Start of the faces of each cell in the cell face arrays, such as
+        /// the half-transmissibilities, with one entry per cell plus one.
+        template <class Grid>
+        static std::vector<int> cellFaceStart_(const Grid& grid)
+        {
+            const int numCells = AutoDiffGrid::numCells(grid);
+            auto c2f = Opm::UgGridHelpers::cell2Faces(grid);
+            std::vector<int> start(numCells + 1, 0);
+            for (int c = 0; c < numCells; ++c) {
+                auto faces = c2f[c];
+                start[c + 1] = start[c] + std::distance(faces.begin(), faces.end());
+            }
+            return start;
+        }
+
         template <class Grid>
         void minPvFillProps_(const Grid &grid,
                              const EclipseState& eclState,
@@ -309,6 +372,7 @@ namespace Opm
                 eclState.get3DProperties().getIntGridProperty("ACTNUM").getData();
 
 
+#pragma omp parallel for schedule(static)
             for (int cellIdx = 0; cellIdx < numCells; ++cellIdx) {
                 const int cellCartIdx = globalCell[cellIdx];
 
@@ -402,6 +466,7 @@ namespace Opm
         Vector z_;
         double gravity_[3]; // Size 3 even if grid is 2-dim.
         bool use_local_perm_;
+        SetupTimes setupTimes_;
 
         // Non-neighboring connections
         NNC nnc_;
@@ -490,6 +555,7 @@ namespace Opm
 
     template <class GridType>
     inline void DerivedGeology::multiplyHalfIntersections_(const GridType &grid,
+                                                           const std::vector<int>& cellFaceStart,
                                                            const EclipseState& eclState,
                                                            const std::vector<double> &ntg,
                                                            Vector &halfIntersectTransmissibility,
@@ -505,80 +571,109 @@ namespace Opm
         auto cell2Faces = Opm::UgGridHelpers::cell2Faces(grid);
         auto faceCells  = Opm::AutoDiffGrid::faceCells(grid);
         const int* global_cell = Opm::UgGridHelpers::globalCell(grid);
-        int cellFaceIdx = 0;
 
-        for (int cellIdx = 0; cellIdx < numCells; ++cellIdx) {
-            // loop over all logically-Cartesian faces of the current cell
-            auto cellFacesRange = cell2Faces[cellIdx];
+        // The multipliers of every cell face are computed in parallel and
+        // applied to the faces afterwards, in the order of the cell faces
+        // as before, since two cells contribute to a face.
+        const int numCellFaces = cellFaceStart[numCells];
+        std::vector<double> cellFaceMult(numCellFaces, 1.0);
+        std::vector<double> cellFaceRegionMult(numCellFaces, 1.0);
 
-            for(auto cellFaceIter = cellFacesRange.begin(), cellFaceEnd = cellFacesRange.end();
-                cellFaceIter != cellFaceEnd; ++cellFaceIter, ++cellFaceIdx)
-            {
-                // the index of the current cell in arrays for the logically-Cartesian grid
-                int cartesianCellIdx = global_cell[cellIdx];
-
-                // The index of the face in the compressed grid
-                int faceIdx = *cellFaceIter;
-
-                // the logically-Cartesian direction of the face
-                int faceTag = Opm::UgGridHelpers::faceTag(grid, cellFaceIter);
-
-                // Translate the C face tag into the enum used by opm-parser's TransMult class
-                Opm::FaceDir::DirEnum faceDirection;
-                if (faceTag == 0) // left
-                    faceDirection = Opm::FaceDir::XMinus;
-                else if (faceTag == 1) // right
-                    faceDirection = Opm::FaceDir::XPlus;
-                else if (faceTag == 2) // back
-                    faceDirection = Opm::FaceDir::YMinus;
-                else if (faceTag == 3) // front
-                    faceDirection = Opm::FaceDir::YPlus;
-                else if (faceTag == 4) // bottom
-                    faceDirection = Opm::FaceDir::ZMinus;
-                else if (faceTag == 5) // top
-                    faceDirection = Opm::FaceDir::ZPlus;
-                else
-                    OPM_THROW(std::logic_error, "Unhandled face direction: " << faceTag);
-
-                // Account for NTG in horizontal one-sided transmissibilities
-                switch (faceDirection) {
-                case Opm::FaceDir::XMinus:
-                case Opm::FaceDir::XPlus:
-                case Opm::FaceDir::YMinus:
-                case Opm::FaceDir::YPlus:
-                    halfIntersectTransmissibility[cellFaceIdx] *= ntg[cartesianCellIdx];
-                    break;
-                default:
-                    // do nothing for the top and bottom faces
-                    break;
-                }
+        std::exception_ptr error;
+#pragma omp parallel for schedule(static)
+        for (int cellIdx = 0; cellIdx < numCells; ++cellIdx) {
+            try {
+                // loop over all logically-Cartesian faces of the current cell
+                auto cellFacesRange = cell2Faces[cellIdx];
+                int cellFaceIdx = cellFaceStart[cellIdx];
+
+                for(auto cellFaceIter = cellFacesRange.begin(), cellFaceEnd = cellFacesRange.end();
+                    cellFaceIter != cellFaceEnd; ++cellFaceIter, ++cellFaceIdx)
+                {
+                    // the index of the current cell in arrays for the logically-Cartesian grid
+                    int cartesianCellIdx = global_cell[cellIdx];
+
+                    // The index of the face in the compressed grid
+                    int faceIdx = *cellFaceIter;
+
+                    // the logically-Cartesian direction of the face
+                    int faceTag = Opm::UgGridHelpers::faceTag(grid, cellFaceIter);
+
+                    // Translate the C face tag into the enum used by opm-parser's TransMult class
+                    Opm::FaceDir::DirEnum faceDirection;
+                    if (faceTag == 0) // left
+                        faceDirection = Opm::FaceDir::XMinus;
+                    else if (faceTag == 1) // right
+                        faceDirection = Opm::FaceDir::XPlus;
+                    else if (faceTag == 2) // back
+                        faceDirection = Opm::FaceDir::YMinus;
+                    else if (faceTag == 3) // front
+                        faceDirection = Opm::FaceDir::YPlus;
+                    else if (faceTag == 4) // bottom
+                        faceDirection = Opm::FaceDir::ZMinus;
+                    else if (faceTag == 5) // top
+                        faceDirection = Opm::FaceDir::ZPlus;
+                    else
+                        OPM_THROW(std::logic_error, "Unhandled face direction: " << faceTag);
+
+                    // Account for NTG in horizontal one-sided transmissibilities
+                    switch (faceDirection) {
+                    case Opm::FaceDir::XMinus:
+                    case Opm::FaceDir::XPlus:
+                    case Opm::FaceDir::YMinus:
+                    case Opm::FaceDir::YPlus:
+                        halfIntersectTransmissibility[cellFaceIdx] *= ntg[cartesianCellIdx];
+                        break;
+                    default:
+                        // do nothing for the top and bottom faces
+                        break;
+                    }
 
-                // Multiplier contribution on this face for MULT[XYZ] logical cartesian multipliers
-                intersectionTransMult[faceIdx] *=
-                    multipliers.getMultiplier(cartesianCellIdx, faceDirection);
+                    // Multiplier contribution on this face for MULT[XYZ] logical cartesian multipliers
+                    cellFaceMult[cellFaceIdx] = multipliers.getMultiplier(cartesianCellIdx, faceDirection);
 
-                // Multiplier contribution on this fase for region multipliers
-                const int cellIdxInside  = faceCells(faceIdx, 0);
-                const int cellIdxOutside = faceCells(faceIdx, 1);
+                    // Multiplier contribution on this fase for region multipliers
+                    const int cellIdxInside  = faceCells(faceIdx, 0);
+                    const int cellIdxOutside = faceCells(faceIdx, 1);
 
-                // Do not apply region multipliers in the case of boundary connections
-                if (cellIdxInside < 0 || cellIdxOutside < 0) {
-                    continue;
+                    // Do not apply region multipliers in the case of boundary connections
+                    if (cellIdxInside < 0 || cellIdxOutside < 0) {
+                        continue;
+                    }
+                    const int cartesianCellIdxInside = global_cell[cellIdxInside];
+                    const int cartesianCellIdxOutside = global_cell[cellIdxOutside];
+                    //  Only apply the region multipliers from the inside
+                    if (cartesianCellIdx == cartesianCellIdxInside) {
+                        cellFaceRegionMult[cellFaceIdx] = multipliers.getRegionMultiplier(cartesianCellIdxInside,cartesianCellIdxOutside,faceDirection);
+                    }
                 }
-                const int cartesianCellIdxInside = global_cell[cellIdxInside];
-                const int cartesianCellIdxOutside = global_cell[cellIdxOutside];
-                //  Only apply the region multipliers from the inside
-                if (cartesianCellIdx == cartesianCellIdxInside) {
-                    intersectionTransMult[faceIdx] *= multipliers.getRegionMultiplier(cartesianCellIdxInside,cartesianCellIdxOutside,faceDirection);
+            }
+            catch (...) {
+#pragma omp critical
+                if (!error) {
+                    error = std::current_exception();
                 }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
 
-
+        int cellFaceIdx = 0;
+        for (int cellIdx = 0; cellIdx < numCells; ++cellIdx) {
+            auto cellFacesRange = cell2Faces[cellIdx];
+            for(auto cellFaceIter = cellFacesRange.begin(), cellFaceEnd = cellFacesRange.end();
+                cellFaceIter != cellFaceEnd; ++cellFaceIter, ++cellFaceIdx)
+            {
+                intersectionTransMult[*cellFaceIter] *= cellFaceMult[cellFaceIdx];
+                intersectionTransMult[*cellFaceIter] *= cellFaceRegionMult[cellFaceIdx];
             }
         }
     }
 
     template <class GridType>
     inline void DerivedGeology::tpfa_loc_trans_compute_(const GridType& grid,
+                                                        const std::vector<int>& cellFaceStart,
                                                         const EclipseGrid& eclGrid,
                                                         const double* perm,
                                                         Vector& hTrans){
@@ -589,65 +684,120 @@ namespace Opm
         // to face centroid and N is the normal vector  pointing outwards with norm equal to the face area.
         // Off-diagonal permeability values are ignored without warning
         int numCells = AutoDiffGrid::numCells(grid);
-        int cellFaceIdx = 0;
         auto cell2Faces = Opm::UgGridHelpers::cell2Faces(grid);
         auto faceCells = Opm::UgGridHelpers::faceCells(grid);
 
+        std::exception_ptr error;
+#pragma omp parallel for schedule(static)
         for (int cellIdx = 0; cellIdx < numCells; ++cellIdx) {
-            // loop over all logically-Cartesian faces of the current cell
-            auto cellFacesRange = cell2Faces[cellIdx];
-
-            for(auto cellFaceIter = cellFacesRange.begin(), cellFaceEnd = cellFacesRange.end();
-                cellFaceIter != cellFaceEnd; ++cellFaceIter, ++cellFaceIdx)
-            {
-                // The index of the face in the compressed grid
-                const int faceIdx = *cellFaceIter;
-
-                // the logically-Cartesian direction of the face
-                const int faceTag = Opm::UgGridHelpers::faceTag(grid, cellFaceIter);
+            try {
+                // loop over all logically-Cartesian faces of the current cell
+                auto cellFacesRange = cell2Faces[cellIdx];
+                int cellFaceIdx = cellFaceStart[cellIdx];
+
+                for(auto cellFaceIter = cellFacesRange.begin(), cellFaceEnd = cellFacesRange.end();
+                    cellFaceIter != cellFaceEnd; ++cellFaceIter, ++cellFaceIdx)
+                {
+                    // The index of the face in the compressed grid
+                    const int faceIdx = *cellFaceIter;
+
+                    // the logically-Cartesian direction of the face
+                    const int faceTag = Opm::UgGridHelpers::faceTag(grid, cellFaceIter);
+
+                    // d = 0: XPERM d = 4: YPERM d = 8: ZPERM ignores off-diagonal permeability values.
+                    const int d = std::floor(faceTag/2) * 4;
+
+                    // compute the half transmissibility
+                    double dist = 0.0;
+                    double cn = 0.0;
+                    double sgn = 2.0 * (faceCells(faceIdx, 0) == cellIdx) - 1;
+                    const int dim = Opm::UgGridHelpers::dimensions(grid);
+
+                    int cartesianCellIdx = AutoDiffGrid::globalCell(grid)[cellIdx];
+                    auto cellCenter = eclGrid.getCellCenter(cartesianCellIdx);
+                    const auto& faceCenter = Opm::UgGridHelpers::faceCenterEcl(grid, cellIdx, faceTag);
+                    const auto& faceAreaNormalEcl = Opm::UgGridHelpers::faceAreaNormalEcl(grid, faceIdx);
+
+                    for (int indx = 0; indx < dim; ++indx) {
+                        const double Ci = faceCenter[indx] - cellCenter[indx];
+                        dist += Ci*Ci;
+                        cn += sgn * Ci * faceAreaNormalEcl[ indx ];
+                    }
 
-                // d = 0: XPERM d = 4: YPERM d = 8: ZPERM ignores off-diagonal permeability values.
-                const int d = std::floor(faceTag/2) * 4;
+                    if (cn < 0){
+                        if (d != 0 && d != 4 && d != 8) {
+                            OPM_THROW(std::logic_error, "Inconsistency in the faceTag in cell: " << cellIdx);
+                        }
+                        const char direction = "XYZ"[d / 4];
+    #pragma omp critical
+                        OPM_MESSAGE("Warning: negative " << direction << "-transmissibility value in cell: " << cellIdx << " replace by absolute value") ;
+                        cn = -cn;
+                    }
+                    hTrans[cellFaceIdx] = perm[cellIdx*dim*dim + d] * cn / dist;
 
-                // compute the half transmissibility
-                double dist = 0.0;
-                double cn = 0.0;
-                double sgn = 2.0 * (faceCells(faceIdx, 0) == cellIdx) - 1;
-                const int dim = Opm::UgGridHelpers::dimensions(grid);
+                }
+            }
+            catch (...) {
+#pragma omp critical
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
 
-                int cartesianCellIdx = AutoDiffGrid::globalCell(grid)[cellIdx];
-                auto cellCenter = eclGrid.getCellCenter(cartesianCellIdx);
-                const auto& faceCenter = Opm::UgGridHelpers::faceCenterEcl(grid, cellIdx, faceTag);
-                const auto& faceAreaNormalEcl = Opm::UgGridHelpers::faceAreaNormalEcl(grid, faceIdx);
+    }
 
-                for (int indx = 0; indx < dim; ++indx) {
-                    const double Ci = faceCenter[indx] - cellCenter[indx];
-                    dist += Ci*Ci;
-                    cn += sgn * Ci * faceAreaNormalEcl[ indx ];
-                }
+    template <class GridType>
+    inline void DerivedGeology::tpfa_htrans_compute_(const GridType& grid,
+                                                     const std::vector<int>& cellFaceStart,
+                                                     const double* perm,
+                                                     Vector& hTrans)
+    {
+        // The two-point half-transmissibilities of tpfa_htrans_compute(),
+        // hTrans(cellFaceIdx) = |C' K N| / C' C, where C is the vector from
+        // the cell centroid to the face centroid, K the permeability tensor
+        // of the cell and N the face normal, with norm equal to the face
+        // area. K N is summed column by column as by dgemv.
+        const int numCells = AutoDiffGrid::numCells(grid);
+        const int dim = Opm::UgGridHelpers::dimensions(grid);
+        auto cell2Faces = Opm::UgGridHelpers::cell2Faces(grid);
+        auto faceCells = Opm::UgGridHelpers::faceCells(grid);
 
-                if (cn < 0){
-                    switch (d) {
-                    case 0:
-                        OPM_MESSAGE("Warning: negative X-transmissibility value in cell: " << cellIdx << " replace by absolute value") ;
-                                break;
-                    case 4:
-                        OPM_MESSAGE("Warning: negative Y-transmissibility value in cell: " << cellIdx << " replace by absolute value") ;
-                                break;
-                    case 8:
-                        OPM_MESSAGE("Warning: negative Z-transmissibility value in cell: " << cellIdx << " replace by absolute value") ;
-                                break;
-                    default:
-                        OPM_THROW(std::logic_error, "Inconsistency in the faceTag in cell: " << cellIdx);
+#pragma omp parallel for schedule(static)
+        for (int cellIdx = 0; cellIdx < numCells; ++cellIdx) {
+            const double* const K = perm + cellIdx*dim*dim;
+            const double* const cc = AutoDiffGrid::cellCentroid(grid, cellIdx);
+            auto cellFacesRange = cell2Faces[cellIdx];
+            int cellFaceIdx = cellFaceStart[cellIdx];
 
+            for(auto cellFaceIter = cellFacesRange.begin(), cellFaceEnd = cellFacesRange.end();
+                cellFaceIter != cellFaceEnd; ++cellFaceIter, ++cellFaceIdx)
+            {
+                const int faceIdx = *cellFaceIter;
+                const double sgn = 2.0 * (faceCells(faceIdx, 0) == cellIdx) - 1.0;
+                const double* const n = Opm::UgGridHelpers::faceNormal(grid, faceIdx);
+                const auto fc = AutoDiffGrid::faceCentroid(grid, faceIdx);
+
+                double Kn[3] = { 0.0, 0.0, 0.0 };
+                for (int j = 0; j < dim; ++j) {
+                    for (int i = 0; i < dim; ++i) {
+                        Kn[i] += n[j] * K[i + j*dim];
                     }
-                    cn = -cn;
                 }
-                hTrans[cellFaceIdx] = perm[cellIdx*dim*dim + d] * cn / dist;
 
+                double htrans = 0.0;
+                double denom = 0.0;
+                for (int d = 0; d < dim; ++d) {
+                    const double dist = fc[d] - cc[d];
+                    htrans += sgn * dist * Kn[d];
+                    denom += dist * dist;
+                }
+                hTrans[cellFaceIdx] = std::abs(htrans / denom);
             }
         }
-
     }
 
 }
@@ -0,0 +1,107 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_GRIDTOPOLOGY_HEADER_INCLUDED
+#define OPM_GRIDTOPOLOGY_HEADER_INCLUDED
+
+#include <opm/autodiff/GridHelpers.hpp>
+
+#include <vector>
+
+namespace Opm
+{
+
+    /// The face-cell topology of a grid, extracted in a single pass over
+    /// the faces of the grid. It is built once per grid and shared, e.g.
+    /// through HelperOps::topology, by everything that needs the internal
+    /// faces or the faces of each cell, instead of each of them querying
+    /// the grid again.
+    struct GridTopology
+    {
+        typedef Eigen::Array<int, Eigen::Dynamic, 1> IFaces;
+        typedef Eigen::Array<int, Eigen::Dynamic, 2, Eigen::RowMajor> TwoColInt;
+
+        /// The number of cells of the grid.
+        int num_cells;
+
+        /// The cells of each face of the grid, -1 outside the grid.
+        TwoColInt face_cells;
+
+        /// The grid face index of each internal face.
+        IFaces internal_faces;
+
+        /// The two cells of each internal face.
+        TwoColInt internal_face_cells;
+
+        /// The internal faces of cell c are
+        /// cell_internal_faces[cell_internal_face_start[c] .. cell_internal_face_start[c+1]),
+        /// given as indices into internal_faces, in increasing order.
+        std::vector<int> cell_internal_face_start;
+        std::vector<int> cell_internal_faces;
+
+        template <class Grid>
+        explicit GridTopology(const Grid& grid)
+        {
+            using namespace AutoDiffGrid;
+            num_cells = numCells(grid);
+            const int nf = numFaces(grid);
+
+            typename ADFaceCellTraits<Grid>::Type nb = faceCellsToEigen(grid);
+            face_cells.resize(nf, 2);
+            int num_internal = 0;
+            for (int f = 0; f < nf; ++f) {
+                face_cells(f, 0) = nb(f, 0);
+                face_cells(f, 1) = nb(f, 1);
+                if (face_cells(f, 0) >= 0 && face_cells(f, 1) >= 0) {
+                    ++num_internal;
+                }
+            }
+
+            internal_faces.resize(num_internal);
+            internal_face_cells.resize(num_internal, 2);
+            cell_internal_face_start.assign(num_cells + 1, 0);
+            int i = 0;
+            for (int f = 0; f < nf; ++f) {
+                const int c1 = face_cells(f, 0);
+                const int c2 = face_cells(f, 1);
+                if (c1 >= 0 && c2 >= 0) {
+                    internal_faces[i] = f;
+                    internal_face_cells(i, 0) = c1;
+                    internal_face_cells(i, 1) = c2;
+                    ++cell_internal_face_start[c1 + 1];
+                    ++cell_internal_face_start[c2 + 1];
+                    ++i;
+                }
+            }
+
+            for (int c = 0; c < num_cells; ++c) {
+                cell_internal_face_start[c + 1] += cell_internal_face_start[c];
+            }
+            cell_internal_faces.resize(cell_internal_face_start[num_cells]);
+            std::vector<int> next(cell_internal_face_start.begin(), cell_internal_face_start.end() - 1);
+            for (i = 0; i < num_internal; ++i) {
+                cell_internal_faces[next[internal_face_cells(i, 0)]++] = i;
+                cell_internal_faces[next[internal_face_cells(i, 1)]++] = i;
+            }
+        }
+    };
+
+} // namespace Opm
+
+#endif // OPM_GRIDTOPOLOGY_HEADER_INCLUDED
@@ -0,0 +1,199 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <opm/autodiff/HardwareCounters.hpp>
+
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace Opm
+{
+
+    bool HardwareCounters::enabled_ = false;
+
+    namespace
+    {
+        const char* phaseNames[ HardwareCounters::NumPhases ] = {
+            "assembly",
+            "ILU0 apply",
+            "well operator apply",
+            "update state"
+        };
+
+        // the size of the cache line fetched per last level cache miss
+        const double cacheLineBytes = 64.0;
+
+        // the file descriptors of the counters, the first is the group leader
+        int fds[ HardwareCounters::NumCounters ] = { -1, -1, -1 };
+        std::thread::id owner;
+
+        std::array<HardwareCounters::Values, HardwareCounters::NumPhases> phaseTotals;
+        std::array<double, HardwareCounters::NumPhases> phaseSeconds;
+        std::array<long, HardwareCounters::NumPhases> phaseCalls;
+
+#ifdef __linux__
+        int openCounter(const std::uint64_t config, const int groupFd)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = config;
+            attr.read_format = PERF_FORMAT_GROUP;
+            // user space only, allowed with the default perf_event_paranoid
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.disabled = groupFd == -1 ? 1 : 0;
+            return syscall(__NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1, groupFd, /*flags=*/0);
+        }
+#endif
+    } // anonymous namespace
+
+
+    bool HardwareCounters::open()
+    {
+        close();
+#ifdef __linux__
+        const std::uint64_t configs[ NumCounters ] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES
+        };
+        for (int c = 0; c < NumCounters; ++c) {
+            fds[c] = openCounter(configs[c], c == 0 ? -1 : fds[0]);
+            if (fds[c] < 0) {
+                close();
+                return false;
+            }
+        }
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        owner = std::this_thread::get_id();
+        enabled_ = true;
+#endif
+        return enabled_;
+    }
+
+
+    void HardwareCounters::close()
+    {
+        enabled_ = false;
+#ifdef __linux__
+        for (int c = NumCounters - 1; c >= 0; --c) {
+            if (fds[c] >= 0) {
+                ::close(fds[c]);
+                fds[c] = -1;
+            }
+        }
+#endif
+    }
+
+
+    bool HardwareCounters::read(Values& values)
+    {
+#ifdef __linux__
+        if (std::this_thread::get_id() != owner) {
+            return false;
+        }
+        // the number of counters followed by their values
+        std::uint64_t buffer[ NumCounters + 1 ];
+        const ssize_t bytes = ::read(fds[0], buffer, sizeof(buffer));
+        if (bytes != ssize_t(sizeof(buffer)) || buffer[0] != std::uint64_t(NumCounters)) {
+            return false;
+        }
+        for (int c = 0; c < NumCounters; ++c) {
+            values[c] = buffer[c + 1];
+        }
+        return true;
+#else
+        static_cast<void>(values);
+        return false;
+#endif
+    }
+
+
+    void HardwareCounters::add(const Phase phase, const Values& start, const Values& end, const double seconds)
+    {
+        for (int c = 0; c < NumCounters; ++c) {
+            phaseTotals[phase][c] += end[c] - start[c];
+        }
+        phaseSeconds[phase] += seconds;
+        ++phaseCalls[phase];
+    }
+
+
+    const HardwareCounters::Values& HardwareCounters::totals(const Phase phase)
+    {
+        return phaseTotals[phase];
+    }
+
+
+    double HardwareCounters::seconds(const Phase phase)
+    {
+        return phaseSeconds[phase];
+    }
+
+
+    long HardwareCounters::calls(const Phase phase)
+    {
+        return phaseCalls[phase];
+    }
+
+
+    std::string HardwareCounters::report()
+    {
+        std::ostringstream os;
+        os << "Hardware counters of the main thread:\n";
+        os << std::left << std::setw(22) << "phase" << std::right
+           << std::setw(10) << "calls"
+           << std::setw(10) << "seconds"
+           << std::setw(14) << "cycles"
+           << std::setw(14) << "instructions"
+           << std::setw(8) << "IPC"
+           << std::setw(14) << "LLC misses"
+           << std::setw(10) << "GB/s" << "\n";
+        for (int p = 0; p < NumPhases; ++p) {
+            const Values& values = phaseTotals[p];
+            const double ipc = values[Cycles] > 0 ? double(values[Instructions]) / values[Cycles] : 0.0;
+            const double bandwidth = phaseSeconds[p] > 0.0
+                ? values[CacheMisses] * cacheLineBytes / phaseSeconds[p] * 1e-9 : 0.0;
+            os << std::left << std::setw(22) << phaseNames[p] << std::right
+               << std::setw(10) << phaseCalls[p]
+               << std::fixed << std::setprecision(3) << std::setw(10) << phaseSeconds[p]
+               << std::scientific << std::setprecision(3)
+               << std::setw(14) << double(values[Cycles])
+               << std::setw(14) << double(values[Instructions])
+               << std::fixed << std::setprecision(2) << std::setw(8) << ipc
+               << std::scientific << std::setprecision(3) << std::setw(14) << double(values[CacheMisses])
+               << std::fixed << std::setprecision(2) << std::setw(10) << bandwidth << "\n";
+        }
+        return os.str();
+    }
+
+} // namespace Opm
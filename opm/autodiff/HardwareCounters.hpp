@@ -0,0 +1,127 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef OPM_HARDWARECOUNTERS_HEADER_INCLUDED
+#define OPM_HARDWARECOUNTERS_HEADER_INCLUDED
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace Opm
+{
+
+    /// Hardware performance counters of the hot phases of a run: cycles,
+    /// instructions and last level cache misses, read with the Linux
+    /// perf_event interface. The memory traffic is estimated as one cache
+    /// line per last level cache miss, which ignores prefetching, and is
+    /// therefore a lower bound of the bandwidth used.
+    ///
+    /// The counters count the thread that opened them, the threads of the
+    /// parallel loops within a phase are not counted. Phases on other
+    /// threads are ignored.
+    class HardwareCounters
+    {
+    public:
+        /// The phases that are counted.
+        enum Phase {
+            Assembly = 0,
+            Preconditioner,
+            WellOperator,
+            UpdateState,
+            NumPhases
+        };
+
+        /// The counters of a phase.
+        enum Counter {
+            Cycles = 0,
+            Instructions,
+            CacheMisses,
+            NumCounters
+        };
+
+        typedef std::array<std::uint64_t, NumCounters> Values;
+
+        /// Count a phase until the end of the scope.
+        class Scope
+        {
+        public:
+            explicit Scope(const Phase phase)
+                : phase_(phase)
+                , active_(HardwareCounters::enabled() && HardwareCounters::read(start_))
+            {
+                if (active_) {
+                    startTime_ = std::chrono::steady_clock::now();
+                }
+            }
+
+            ~Scope()
+            {
+                Values end;
+                if (active_ && HardwareCounters::read(end)) {
+                    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime_;
+                    HardwareCounters::add(phase_, start_, end, elapsed.count());
+                }
+            }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            Phase phase_;
+            Values start_;
+            bool active_;
+            std::chrono::steady_clock::time_point startTime_;
+        };
+
+        /// Open the counters for the calling thread. Returns false, and the
+        /// phases are not counted, if the counters are not available, e.g.
+        /// on other systems than Linux, in virtual machines without a
+        /// performance monitoring unit or if perf_event_paranoid forbids it.
+        static bool open();
+
+        /// Close the counters, the totals of the phases are kept.
+        static void close();
+
+        /// Whether the counters are open.
+        static bool enabled() { return enabled_; }
+
+        /// The counters of a phase summed over its calls.
+        static const Values& totals(const Phase phase);
+
+        /// The time in seconds and the number of calls of a phase.
+        static double seconds(const Phase phase);
+        static long calls(const Phase phase);
+
+        /// The table of the counters of the phases with the instructions
+        /// per cycle and the estimated memory bandwidth.
+        static std::string report();
+
+    private:
+        static bool read(Values& values);
+        static void add(const Phase phase, const Values& start, const Values& end, const double seconds);
+
+        static bool enabled_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_HARDWARECOUNTERS_HEADER_INCLUDED
@@ -0,0 +1,402 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+#include <opm/autodiff/Hdf5Output.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
+#if HAVE_HDF5
+#include <hdf5.h>
+#endif
+
+namespace Opm
+{
+
+#if HAVE_HDF5
+
+    static_assert(sizeof(hid_t) <= sizeof(std::int64_t), "hid_t does not fit the identifiers of Hdf5Output");
+
+    namespace
+    {
+#if HAVE_MPI
+        bool useMpi()
+        {
+            int initialized = 0;
+            MPI_Initialized(&initialized);
+            return initialized != 0;
+        }
+#endif
+
+        // The offset of the rows of this process and the total number of
+        // rows of all processes.
+        void rowRange(const long long rows, long long& offset, long long& total)
+        {
+            offset = 0;
+            total = rows;
+#if HAVE_MPI
+            if (useMpi()) {
+                int rank = 0;
+                MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+                MPI_Exscan(&rows, &offset, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+                if (rank == 0) {
+                    offset = 0;
+                }
+                MPI_Allreduce(&rows, &total, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+            }
+#endif
+        }
+
+        bool onAllProcesses(const bool value)
+        {
+            int result = value ? 1 : 0;
+#if HAVE_MPI
+            if (useMpi()) {
+                MPI_Allreduce(MPI_IN_PLACE, &result, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+            }
+#endif
+            return result != 0;
+        }
+
+        int maxOverProcesses(const int value)
+        {
+            int result = value;
+#if HAVE_MPI
+            if (useMpi()) {
+                MPI_Allreduce(&value, &result, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+            }
+#endif
+            return result;
+        }
+
+        void check(const herr_t status, const std::string& what)
+        {
+            if (status < 0) {
+                OPM_THROW(std::runtime_error, "HDF5 output failed to " << what);
+            }
+        }
+
+        hid_t checkId(const hid_t id, const std::string& what)
+        {
+            if (id < 0) {
+                OPM_THROW(std::runtime_error, "HDF5 output failed to " << what);
+            }
+            return id;
+        }
+
+        // Whether the datasets may be compressed, writing filtered datasets
+        // in parallel needs HDF5 1.10.2.
+        bool compressionSupported(const int size)
+        {
+            if (!H5Zfilter_avail(H5Z_FILTER_DEFLATE)) {
+                return false;
+            }
+#if H5_VERSION_GE(1, 10, 2)
+            static_cast<void>(size);
+            return true;
+#else
+            return size == 1;
+#endif
+        }
+    } // anonymous namespace
+
+
+    bool Hdf5Output::available()
+    {
+        return true;
+    }
+
+
+    Hdf5Output::Hdf5Output(const std::string& filename, const int compression,
+                           const OutputPrecision& precision)
+        : precision_(precision)
+        , file_(-1)
+        , group_(-1)
+        , compression_(std::min(std::max(compression, 0), 9))
+        , size_(1)
+    {
+        const hid_t fapl = checkId(H5Pcreate(H5P_FILE_ACCESS), "create the file access list");
+#if HAVE_MPI
+        if (useMpi()) {
+            MPI_Comm_size(MPI_COMM_WORLD, &size_);
+#ifdef H5_HAVE_PARALLEL
+            H5Pset_fapl_mpio(fapl, MPI_COMM_WORLD, MPI_INFO_NULL);
+#else
+            if (size_ > 1) {
+                H5Pclose(fapl);
+                OPM_THROW(std::runtime_error, "HDF5 output of parallel runs needs an HDF5 library built with MPI");
+            }
+#endif
+        }
+#endif
+        if (!compressionSupported(size_)) {
+            compression_ = 0;
+        }
+        file_ = H5Fcreate(filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+        H5Pclose(fapl);
+        checkId(file_, "create " + filename);
+    }
+
+
+    Hdf5Output::~Hdf5Output()
+    {
+        if (group_ >= 0) {
+            H5Gclose(group_);
+        }
+        if (file_ >= 0) {
+            H5Fclose(file_);
+        }
+    }
+
+
+    void Hdf5Output::beginStep(const int reportStep, const double time)
+    {
+        if (group_ >= 0) {
+            endStep();
+        }
+        const std::string name = groupName(reportStep);
+        if (H5Lexists(file_, name.c_str(), H5P_DEFAULT) > 0) {
+            // the space of the old group is not reclaimed
+            check(H5Ldelete(file_, name.c_str(), H5P_DEFAULT), "replace " + name);
+        }
+        group_ = checkId(H5Gcreate2(file_, name.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT),
+                         "create " + name);
+
+        const hid_t space = H5Screate(H5S_SCALAR);
+        const hid_t step = H5Acreate2(group_, "report_step", H5T_NATIVE_INT, space, H5P_DEFAULT, H5P_DEFAULT);
+        check(H5Awrite(step, H5T_NATIVE_INT, &reportStep), "write the report step");
+        H5Aclose(step);
+        const hid_t seconds = H5Acreate2(group_, "time", H5T_NATIVE_DOUBLE, space, H5P_DEFAULT, H5P_DEFAULT);
+        check(H5Awrite(seconds, H5T_NATIVE_DOUBLE, &time), "write the time");
+        H5Aclose(seconds);
+        H5Sclose(space);
+    }
+
+
+    void Hdf5Output::write(const std::string& name, const std::vector<double>& values, const int stride)
+    {
+        const int s = std::max(maxOverProcesses(stride), 1);
+        const OutputPrecision::Field& field = precision_.field(name);
+        if (field.type == OutputPrecision::Quantized) {
+            std::vector<int> quantized;
+            const bool ok = OutputPrecision::quantize(values, field.tolerance, quantized);
+            if (onAllProcesses(ok)) {
+                writeRows(name, quantized.data(), H5T_NATIVE_INT, values.size() / s, s, field.tolerance);
+                return;
+            }
+        }
+        else if (field.type == OutputPrecision::Float) {
+            const std::vector<float> converted(values.begin(), values.end());
+            writeRows(name, converted.data(), H5T_NATIVE_FLOAT, values.size() / s, s);
+            return;
+        }
+        writeRows(name, values.data(), H5T_NATIVE_DOUBLE, values.size() / s, s);
+    }
+
+
+    void Hdf5Output::write(const std::string& name, const std::vector<int>& values, const int stride)
+    {
+        const int s = std::max(maxOverProcesses(stride), 1);
+        writeRows(name, values.data(), H5T_NATIVE_INT, values.size() / s, s);
+    }
+
+
+    void Hdf5Output::write(const std::string& name, const std::vector<std::string>& values)
+    {
+        std::size_t length = 1;
+        for (const auto& value : values) {
+            length = std::max(length, value.size());
+        }
+        length = maxOverProcesses(length);
+
+        // fixed length strings, padded with zeros
+        std::vector<char> buffer(values.size() * length, '\0');
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            std::copy(values[i].begin(), values[i].end(), buffer.begin() + i * length);
+        }
+        const hid_t type = H5Tcopy(H5T_C_S1);
+        H5Tset_size(type, length);
+        H5Tset_strpad(type, H5T_STR_NULLPAD);
+        try {
+            writeRows(name, buffer.data(), type, values.size(), 1);
+        }
+        catch (...) {
+            H5Tclose(type);
+            throw;
+        }
+        H5Tclose(type);
+    }
+
+
+    void Hdf5Output::writeRows(const std::string& name, const void* values, const std::int64_t type,
+                               const long long rows, const int stride, const double tolerance)
+    {
+        if (group_ < 0) {
+            OPM_THROW(std::logic_error, "HDF5 output of " << name << " outside of a report step");
+        }
+        long long offset = 0;
+        long long total = 0;
+        rowRange(rows, offset, total);
+
+        const int rank = stride > 1 ? 2 : 1;
+        const hsize_t dims[2] = { hsize_t(total), hsize_t(stride) };
+        const hid_t fileSpace = H5Screate_simple(rank, dims, nullptr);
+
+        const hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+        if (total > 0) {
+            const hsize_t chunk[2] = { hsize_t(std::min(total, (long long)(chunkRows))), hsize_t(stride) };
+            H5Pset_chunk(dcpl, rank, chunk);
+            if (compression_ > 0) {
+                // the bytes of equal significance of the values are stored
+                // together, which deflate compresses much better
+                H5Pset_shuffle(dcpl);
+                H5Pset_deflate(dcpl, compression_);
+            }
+        }
+        const hid_t lcpl = H5Pcreate(H5P_LINK_CREATE);
+        H5Pset_create_intermediate_group(lcpl, 1);
+        const hid_t dataset = H5Dcreate2(group_, name.c_str(), type, fileSpace, lcpl, dcpl, H5P_DEFAULT);
+        H5Pclose(lcpl);
+        H5Pclose(dcpl);
+        if (dataset < 0) {
+            H5Sclose(fileSpace);
+            OPM_THROW(std::runtime_error, "HDF5 output failed to create the dataset " << name);
+        }
+
+        herr_t status = 0;
+        if (tolerance > 0.0) {
+            const double attributes[2] = { OutputPrecision::step(tolerance), tolerance };
+            const char* attributeNames[2] = { "scale_factor", "quantization_tolerance" };
+            const hid_t space = H5Screate(H5S_SCALAR);
+            for (int a = 0; a < 2 && status >= 0; ++a) {
+                const hid_t attribute = H5Acreate2(dataset, attributeNames[a], H5T_NATIVE_DOUBLE, space,
+                                                   H5P_DEFAULT, H5P_DEFAULT);
+                status = H5Awrite(attribute, H5T_NATIVE_DOUBLE, &attributes[a]);
+                H5Aclose(attribute);
+            }
+            H5Sclose(space);
+        }
+        if (total > 0 && status >= 0) {
+            const hsize_t start[2] = { hsize_t(offset), 0 };
+            const hsize_t count[2] = { hsize_t(rows), hsize_t(stride) };
+            const hid_t memSpace = H5Screate_simple(rank, count, nullptr);
+            if (rows > 0) {
+                H5Sselect_hyperslab(fileSpace, H5S_SELECT_SET, start, nullptr, count, nullptr);
+            }
+            else {
+                H5Sselect_none(fileSpace);
+                H5Sselect_none(memSpace);
+            }
+            const hid_t dxpl = H5Pcreate(H5P_DATASET_XFER);
+#if HAVE_MPI && defined(H5_HAVE_PARALLEL)
+            if (useMpi()) {
+                H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_COLLECTIVE);
+            }
+#endif
+            status = H5Dwrite(dataset, type, memSpace, fileSpace, dxpl, values);
+            H5Pclose(dxpl);
+            H5Sclose(memSpace);
+        }
+        H5Dclose(dataset);
+        H5Sclose(fileSpace);
+        check(status, "write the dataset " + name);
+    }
+
+
+    void Hdf5Output::endStep()
+    {
+        if (group_ >= 0) {
+            H5Gclose(group_);
+            group_ = -1;
+        }
+        check(H5Fflush(file_, H5F_SCOPE_GLOBAL), "flush the file");
+    }
+
+#else // HAVE_HDF5
+
+    bool Hdf5Output::available()
+    {
+        return false;
+    }
+
+
+    Hdf5Output::Hdf5Output(const std::string&, const int, const OutputPrecision&)
+        : file_(-1)
+        , group_(-1)
+        , compression_(0)
+        , size_(1)
+    {
+        OPM_THROW(std::runtime_error, "HDF5 output is not available in this build");
+    }
+
+
+    Hdf5Output::~Hdf5Output()
+    {
+    }
+
+
+    void Hdf5Output::beginStep(const int, const double)
+    {
+    }
+
+
+    void Hdf5Output::write(const std::string&, const std::vector<double>&, const int)
+    {
+    }
+
+
+    void Hdf5Output::write(const std::string&, const std::vector<int>&, const int)
+    {
+    }
+
+
+    void Hdf5Output::write(const std::string&, const std::vector<std::string>&)
+    {
+    }
+
+
+    void Hdf5Output::writeRows(const std::string&, const void*, const std::int64_t, const long long, const int, const double)
+    {
+    }
+
+
+    void Hdf5Output::endStep()
+    {
+    }
+
+#endif // HAVE_HDF5
+
+
+    std::string Hdf5Output::groupName(const int reportStep)
+    {
+        std::ostringstream name;
+        name << "report_step_" << std::setw(4) << std::setfill('0') << reportStep;
+        return name.str();
+    }
+
+} // namespace Opm
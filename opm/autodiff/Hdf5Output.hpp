@@ -0,0 +1,109 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef OPM_HDF5OUTPUT_HEADER_INCLUDED
+#define OPM_HDF5OUTPUT_HEADER_INCLUDED
+
+#include <opm/autodiff/OutputPrecision.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    /// An HDF5 file of the cell and well data of the report steps of a
+    /// run, written by all processes together.
+    ///
+    /// Every report step is a group /report_step_NNNN with the attributes
+    /// report_step and time (in seconds), holding one dataset per field.
+    /// A dataset has one row per entry of all processes, e.g. per owned
+    /// cell, and stride columns. The rows of the processes follow each
+    /// other in the order of their ranks, each process writes its own
+    /// hyperslab with collective I/O. The datasets are chunked and, where
+    /// the library supports it, compressed with deflate after shuffling
+    /// the bytes of the values, such that single fields can be read
+    /// without reading the file.
+    ///
+    /// The fields of doubles are written with the precision given for
+    /// their name. A quantized field is a dataset of integers with the
+    /// attributes scale_factor, the step of the quantization, and
+    /// quantization_tolerance, following the CF conventions such that
+    /// e.g. xarray returns the values. A field that cannot be quantized
+    /// on some process is written in double precision.
+    ///
+    /// All processes must call the methods in the same order with the
+    /// same names, the calls are collective over MPI_COMM_WORLD. Parallel
+    /// runs need an HDF5 library built with MPI.
+    class Hdf5Output
+    {
+    public:
+        /// Whether HDF5 output is available in this build.
+        static bool available();
+
+        /// Create the file, replacing an existing one.
+        /// \param[in] filename     name of the file
+        /// \param[in] compression  deflate level from 0 (none) to 9
+        /// \param[in] precision    precision of the fields of doubles
+        Hdf5Output(const std::string& filename, const int compression,
+                   const OutputPrecision& precision = OutputPrecision());
+
+        ~Hdf5Output();
+
+        Hdf5Output(const Hdf5Output&) = delete;
+        Hdf5Output& operator=(const Hdf5Output&) = delete;
+
+        /// Start the group of a report step, replacing one written before.
+        void beginStep(const int reportStep, const double time);
+
+        /// Write the rows of this process of a field of the current step,
+        /// values.size() / stride rows. The name may contain a path
+        /// relative to the group of the step, e.g. wells/bhp.
+        void write(const std::string& name, const std::vector<double>& values, const int stride = 1);
+        void write(const std::string& name, const std::vector<int>& values, const int stride = 1);
+
+        /// Write the rows of this process of a field of strings, one row
+        /// per string.
+        void write(const std::string& name, const std::vector<std::string>& values);
+
+        /// End the group of the step and flush the file.
+        void endStep();
+
+        /// The name of the group of a report step.
+        static std::string groupName(const int reportStep);
+
+        /// The number of rows of the chunks of the datasets.
+        static const int chunkRows = 1 << 16;
+
+    private:
+        void writeRows(const std::string& name, const void* values, const std::int64_t type,
+                       const long long rows, const int stride, const double tolerance = 0.0);
+
+        OutputPrecision precision_;
+        std::int64_t file_;
+        std::int64_t group_;
+        int compression_;
+        int size_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_HDF5OUTPUT_HEADER_INCLUDED
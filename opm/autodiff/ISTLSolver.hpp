@@ -22,13 +22,24 @@
 
 #include <opm/autodiff/AdditionalObjectDeleter.hpp>
 #include <opm/autodiff/CPRPreconditioner.hpp>
+#include <opm/autodiff/BlockCPRPreconditioner.hpp>
+#include <opm/autodiff/MultiscalePressureSolver.hpp>
+#include <opm/autodiff/ChebyshevSmoother.hpp>
 #include <opm/autodiff/NewtonIterationBlackoilInterleaved.hpp>
 #include <opm/autodiff/NewtonIterationUtilities.hpp>
 #include <opm/autodiff/ParallelRestrictedAdditiveSchwarz.hpp>
 #include <opm/autodiff/ParallelOverlappingILU0.hpp>
+#include <opm/autodiff/FirstTouchAllocator.hpp>
+#include <opm/autodiff/MixedPrecisionPreconditioner.hpp>
+#include <opm/autodiff/RecyclingGCRSolver.hpp>
+#include <opm/autodiff/SubdomainDirectSolver.hpp>
+#include <opm/autodiff/BatchedGMResSolver.hpp>
 #include <opm/autodiff/AutoDiffHelpers.hpp>
+#include <opm/autodiff/TimerTree.hpp>
+#include <opm/autodiff/MemoryTracker.hpp>
 
 #include <opm/common/Exceptions.hpp>
+#include <opm/common/OpmLog/OpmLog.hpp>
 #include <opm/core/linalg/ParallelIstlInformation.hpp>
 #include <opm/common/utility/platform_dependent/disable_warnings.h>
 
@@ -38,9 +49,16 @@
 #include <dune/istl/solvers.hh>
 #include <dune/istl/owneroverlapcopy.hh>
 #include <dune/istl/paamg/amg.hh>
+#include <dune/common/timer.hh>
 
 #include <opm/common/utility/platform_dependent/reenable_warnings.h>
 
+#include <cassert>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace Dune
 {
 
@@ -198,9 +216,18 @@ namespace Opm
         ISTLSolver(const NewtonIterationBlackoilInterleavedParameters& param,
                    const boost::any& parallelInformation_arg=boost::any())
         : iterations_( 0 ),
+          converged_( true ),
+          preconditionerSetupTime_( 0.0 ),
+          krylovSolveTime_( 0.0 ),
+          preconditionerMemoryUsage_( 0 ),
           parallelInformation_(parallelInformation_arg),
           isIORank_(isIORank(parallelInformation_arg)),
-          parameters_( param )
+          parameters_( param ),
+          reduction_( parameters_.linear_solver_reduction_ ),
+          keepPreconditioner_( false ),
+          reusePreconditioner_( false ),
+          subdomainSolverSize_( 0 ),
+          subdomainSolverUses_( 0 )
         {
         }
 
@@ -211,9 +238,19 @@ namespace Opm
         ISTLSolver(const ParameterGroup& param,
                    const boost::any& parallelInformation_arg=boost::any())
         : iterations_( 0 ),
+          converged_( true ),
+          preconditionerSetupTime_( 0.0 ),
+          krylovSolveTime_( 0.0 ),
+          preconditionerMemoryUsage_( 0 ),
           parallelInformation_(parallelInformation_arg),
           isIORank_(isIORank(parallelInformation_arg)),
-          parameters_( param )
+          parameters_( param ),
+          cprParameters_( param ),
+          reduction_( parameters_.linear_solver_reduction_ ),
+          keepPreconditioner_( false ),
+          reusePreconditioner_( false ),
+          subdomainSolverSize_( 0 ),
+          subdomainSolverUses_( 0 )
         {
         }
 
@@ -233,9 +270,43 @@ namespace Opm
         /// \copydoc NewtonIterationBlackoilInterface::iterations
         int iterations () const { return iterations_; }
 
+        /// Whether the last solve reached the requested reduction, which
+        /// may be false if convergence failures are ignored.
+        bool converged() const { return converged_; }
+
         /// \copydoc NewtonIterationBlackoilInterface::parallelInformation
         const boost::any& parallelInformation() const { return parallelInformation_; }
 
+        /// Time in seconds spent setting up the preconditioner in the last solve.
+        double preconditionerSetupTime() const { return preconditionerSetupTime_; }
+
+        /// Time in seconds spent in the Krylov iterations of the last solve.
+        double krylovSolveTime() const { return krylovSolveTime_; }
+
+        /// Number of bytes held by the preconditioner of the last solve, 0 if
+        /// it does not report its memory usage (AMG).
+        std::size_t preconditionerMemoryUsage() const { return preconditionerMemoryUsage_; }
+
+        /// The relative residual reduction of the following solves, e.g. an
+        /// inexact Newton forcing term of the current Newton iteration.
+        void setReduction(const double reduction) const { reduction_ = reduction; }
+
+        /// The relative residual reduction of the following solves.
+        double reduction() const { return reduction_; }
+
+        /// The relative residual reduction given by linear_solver_reduction.
+        double defaultReduction() const { return parameters_.linear_solver_reduction_; }
+
+        /// Keep the ILU preconditioner between the following solves and, if
+        /// reuse is set, apply the one of the previous solve without updating
+        /// it to the matrix, e.g. in the iterations of a modified Newton
+        /// method. Preconditioners other than ILU are set up for every solve.
+        void setPreconditionerReuse(const bool reuse) const
+        {
+            keepPreconditioner_ = true;
+            reusePreconditioner_ = reuse;
+        }
+
     public:
         /// \brief construct the CPR preconditioner and the solver.
         /// \tparam P The type of the parallel information.
@@ -246,6 +317,11 @@ namespace Opm
                                              const POrComm& parallelInformation_arg,
                                              Dune::InverseOperatorResult& result) const
         {
+            // the time outside the Krylov iterations is the preconditioner setup
+            TimerTree::Region region("preconditioner and solve");
+            Dune::Timer setupTimer;
+            krylovSolveTime_ = 0.0;
+
             // Construct scalar product.
             typedef Dune::ScalarProductChooser<Vector, POrComm, category> ScalarProductChooser;
             typedef std::unique_ptr<typename ScalarProductChooser::ScalarProduct> SPPointer;
@@ -255,38 +331,101 @@ namespace Opm
             parallelInformation_arg.copyOwnerToAll(istlb, istlb);
 
 #if FLOW_SUPPORT_AMG // activate AMG if either flow_ebos is used or UMFPack is not available
-            if( parameters_.linear_solver_use_amg_ )
+            if( parameters_.use_cpr_ )
             {
-                typedef ISTLUtility::CPRSelector< Matrix, Vector, Vector, POrComm>  CPRSelectorType;
-                typedef typename CPRSelectorType::AMG AMG;
-                typedef typename CPRSelectorType::Operator MatrixOperator;
-
-                std::unique_ptr< AMG > amg;
-                std::unique_ptr< MatrixOperator > opA;
+                // Construct the two-stage CPR preconditioner.
+                auto precond = constructCPRPrecond(linearOperator, parallelInformation_arg);
+                preconditionerMemoryUsage_ = precond->memoryUsage();
 
-                if( ! std::is_same< LinearOperator, MatrixOperator > :: value )
+                // Solve.
+                solve(linearOperator, x, istlb, *sp, *precond, parallelInformation_arg, result);
+            }
+            else if( parameters_.linear_solver_use_amg_ )
+            {
+                typedef ISTLUtility::CPRSelector< Matrix, Vector, Vector, POrComm>  CPRSelectorType;
+                const std::string& smoother = parameters_.amg_smoother_;
+                if( smoother == "jacobi" )
+                {
+                    typedef Dune::SeqJac< Matrix, Vector, Vector > SeqSmoother;
+                    typedef typename ISTLUtility::AMGSmootherSelector< SeqSmoother, POrComm >::Smoother Smoother;
+                    solveAMG< Smoother >( linearOperator, x, istlb, *sp, parallelInformation_arg, result );
+                }
+                else if( smoother == "gs" )
+                {
+                    // SOR, i.e. Gauss-Seidel for amg_smoother_relaxation = 1
+                    typedef Dune::SeqSOR< Matrix, Vector, Vector > SeqSmoother;
+                    typedef typename ISTLUtility::AMGSmootherSelector< SeqSmoother, POrComm >::Smoother Smoother;
+                    solveAMG< Smoother >( linearOperator, x, istlb, *sp, parallelInformation_arg, result );
+                }
+                else if( smoother == "sgs" )
                 {
-                    // create new operator in case linear operator and matrix operator differ
-                    opA.reset( CPRSelectorType::makeOperator( linearOperator.getmat(), parallelInformation_arg ) );
+                    typedef Dune::SeqSSOR< Matrix, Vector, Vector > SeqSmoother;
+                    typedef typename ISTLUtility::AMGSmootherSelector< SeqSmoother, POrComm >::Smoother Smoother;
+                    solveAMG< Smoother >( linearOperator, x, istlb, *sp, parallelInformation_arg, result );
                 }
+                else if( smoother == "chebyshev" )
+                {
+                    typedef ChebyshevSmoother< Matrix, Vector, Vector > SeqSmoother;
+                    typedef typename ISTLUtility::AMGSmootherSelector< SeqSmoother, POrComm >::Smoother Smoother;
+                    solveAMG< Smoother >( linearOperator, x, istlb, *sp, parallelInformation_arg, result );
+                }
+                else
+                {
+                    solveAMG< typename CPRSelectorType::Smoother >( linearOperator, x, istlb, *sp, parallelInformation_arg, result );
+                }
+                preconditionerMemoryUsage_ = 0;
+            }
+            else
+#endif
+            if( parameters_.subdomain_solver_ == "lu" )
+            {
+                // Factorize the subdomain matrix, unless the factorization
+                // of a previous solve is kept.
+                auto& precond = reusedSubdomainSolver(linearOperator, subdomainDirectSolver_);
+                preconditionerMemoryUsage_ = 0;
 
-                const double relax = 1.0;
+                // Solve.
+                solveSubdomains(linearOperator, x, istlb, *sp, precond, parallelInformation_arg, result);
+            }
+            else if( parameters_.subdomain_solver_ == "iluk" )
+            {
+                auto& precond = reusedSubdomainSolver(linearOperator, subdomainILU_);
+                preconditionerMemoryUsage_ = precond.memoryUsage();
 
-                // Construct preconditioner.
-                constructAMGPrecond( linearOperator, parallelInformation_arg, amg, opA, relax );
+                // Solve.
+                solveSubdomains(linearOperator, x, istlb, *sp, precond, parallelInformation_arg, result);
+            }
+            else if( parameters_.ilu_single_precision_ )
+            {
+                // Construct preconditioner stored in single precision.
+                auto precond = constructMixedPrecisionPrecond(linearOperator, parallelInformation_arg);
+                preconditionerMemoryUsage_ = precond->memoryUsage();
 
                 // Solve.
-                solve(linearOperator, x, istlb, *sp, *amg, result);
+                solve(linearOperator, x, istlb, *sp, *precond, parallelInformation_arg, result);
+            }
+            else if( parameters_.ilu_reuse_structure_ || keepPreconditioner_ )
+            {
+                // Update or reuse the preconditioner of the previous solve.
+                auto& precond = reusedPrecond(linearOperator, parallelInformation_arg);
+                preconditionerMemoryUsage_ = precond.memoryUsage();
+
+                // Solve.
+                solve(linearOperator, x, istlb, *sp, precond, parallelInformation_arg, result);
             }
             else
-#endif
             {
                 // Construct preconditioner.
                 auto precond = constructPrecond(linearOperator, parallelInformation_arg);
+                preconditionerMemoryUsage_ = precond->memoryUsage();
 
                 // Solve.
-                solve(linearOperator, x, istlb, *sp, *precond, result);
+                solve(linearOperator, x, istlb, *sp, *precond, parallelInformation_arg, result);
             }
+
+            // everything but the Krylov iterations is preconditioner setup
+            preconditionerSetupTime_ = setupTimer.elapsed() - krylovSolveTime_;
+            MemoryTracker::sample(MemoryTracker::FirstLinearSolve);
         }
 
 #if DUNE_VERSION_NEWER(DUNE_ISTL, 2 , 5)
@@ -303,10 +442,71 @@ namespace Opm
         {
             const double relax   = parameters_.ilu_relaxation_;
             const int ilu_fillin = parameters_.ilu_fillin_level_;
-            std::unique_ptr<SeqPreconditioner> precond(new SeqPreconditioner(opA.getmat(), ilu_fillin, relax));
+            const bool levelScheduling = parameters_.ilu_level_scheduling_;
+            const bool compact = parameters_.ilu_compact_;
+            const bool reorder = parameters_.ilu_reorder_;
+            const double dropTolerance = parameters_.ilu_drop_tolerance_;
+            const bool coloring = parameters_.ilu_coloring_;
+            std::unique_ptr<SeqPreconditioner> precond(new SeqPreconditioner(opA.getmat(), ilu_fillin, relax, levelScheduling, compact, reorder,
+                                                                             dropTolerance, coloring));
             return precond;
         }
 
+        // the single precision copies are created for the preconditioner, so
+        // their pages are placed on the NUMA nodes of the threads using them
+#if DUNE_VERSION_NEWER(DUNE_ISTL, 2 , 5)
+        typedef Dune::FieldMatrix<float, Matrix::block_type::rows, Matrix::block_type::cols> FloatMatrixBlock;
+#else
+        typedef Dune::MatrixBlock<float, Matrix::block_type::rows, Matrix::block_type::cols> FloatMatrixBlock;
+#endif
+        typedef Dune::BCRSMatrix<FloatMatrixBlock, FirstTouchAllocator<FloatMatrixBlock> > FloatMatrix;
+        typedef Dune::FieldVector<float, VectorBlockType::dimension> FloatVectorBlock;
+        typedef Dune::BlockVector<FloatVectorBlock, FirstTouchAllocator<FloatVectorBlock> > FloatVector;
+        typedef ParallelOverlappingILU0<FloatMatrix,FloatVector,FloatVector> FloatSeqPreconditioner;
+        typedef MixedPrecisionPreconditioner<Vector,Vector,FloatSeqPreconditioner> MixedSeqPreconditioner;
+
+        /// \brief Construct an ILU preconditioner stored in single precision,
+        ///        the Krylov solver and the operator stay in double precision.
+        template <class Operator>
+        std::unique_ptr<MixedSeqPreconditioner>
+        constructMixedPrecisionPrecond(Operator& opA, const Dune::Amg::SequentialInformation&) const
+        {
+            const double relax   = parameters_.ilu_relaxation_;
+            const int ilu_fillin = parameters_.ilu_fillin_level_;
+            const bool levelScheduling = parameters_.ilu_level_scheduling_;
+            const bool compact = parameters_.ilu_compact_;
+            const bool reorder = parameters_.ilu_reorder_;
+            const double dropTolerance = parameters_.ilu_drop_tolerance_;
+            const bool coloring = parameters_.ilu_coloring_;
+
+            // the decomposition is a copy, floatA is not needed after construction
+            FloatMatrix floatA;
+            detail::copyMatrixConvertingPrecision( opA.getmat(), floatA );
+            std::unique_ptr<FloatSeqPreconditioner>
+                precond(new FloatSeqPreconditioner(floatA, ilu_fillin, relax, levelScheduling, compact, reorder,
+                                                   dropTolerance, coloring));
+
+            return std::unique_ptr<MixedSeqPreconditioner>
+                (new MixedSeqPreconditioner(std::move(precond), opA.getmat().N()));
+        }
+
+        /// \brief Return the preconditioner of the previous solve updated for
+        ///        the matrix of opA. The symbolic structure of the decomposition
+        ///        is kept as long as the sparsity pattern does not change.
+        template <class Operator>
+        SeqPreconditioner& reusedPrecond(Operator& opA, const Dune::Amg::SequentialInformation& info) const
+        {
+            if( seqPrecond_ ) {
+                if( !reusePreconditioner_ ) {
+                    seqPrecond_->update( opA.getmat() );
+                }
+            }
+            else {
+                seqPrecond_ = constructPrecond( opA, info );
+            }
+            return *seqPrecond_;
+        }
+
 #if HAVE_MPI
         typedef Dune::OwnerOverlapCopyCommunication<int, int> Comm;
 #if DUNE_VERSION_NEWER(DUNE_ISTL, 2 , 5)
@@ -323,37 +523,314 @@ namespace Opm
         {
             typedef std::unique_ptr<ParPreconditioner> Pointer;
             const double relax  = parameters_.ilu_relaxation_;
-            return Pointer(new ParPreconditioner(opA.getmat(), comm, relax));
+            const bool levelScheduling = parameters_.ilu_level_scheduling_;
+            const bool compact = parameters_.ilu_compact_;
+            const int ilu_fillin = parameters_.ilu_fillin_level_;
+            const double dropTolerance = parameters_.ilu_drop_tolerance_;
+            return Pointer(new ParPreconditioner(opA.getmat(), comm, relax, levelScheduling, compact, ilu_fillin, dropTolerance));
+        }
+
+        typedef ParallelOverlappingILU0<FloatMatrix,FloatVector,FloatVector,Comm> FloatParPreconditioner;
+        typedef MixedPrecisionPreconditioner<Vector,Vector,FloatParPreconditioner> MixedParPreconditioner;
+
+        template <class Operator>
+        std::unique_ptr<MixedParPreconditioner>
+        constructMixedPrecisionPrecond(Operator& opA, const Comm& comm) const
+        {
+            const double relax  = parameters_.ilu_relaxation_;
+            const bool levelScheduling = parameters_.ilu_level_scheduling_;
+            const bool compact = parameters_.ilu_compact_;
+            const int ilu_fillin = parameters_.ilu_fillin_level_;
+            const double dropTolerance = parameters_.ilu_drop_tolerance_;
+
+            FloatMatrix floatA;
+            detail::copyMatrixConvertingPrecision( opA.getmat(), floatA );
+            std::unique_ptr<FloatParPreconditioner>
+                precond(new FloatParPreconditioner(floatA, comm, relax, levelScheduling, compact, ilu_fillin, dropTolerance));
+
+            return std::unique_ptr<MixedParPreconditioner>
+                (new MixedParPreconditioner(std::move(precond), opA.getmat().N()));
+        }
+
+        template <class Operator>
+        ParPreconditioner& reusedPrecond(Operator& opA, const Comm& comm) const
+        {
+            if( parPrecond_ ) {
+                // the communication object is recreated for every solve
+                if( !reusePreconditioner_ ) {
+                    parPrecond_->update( opA.getmat(), &comm );
+                }
+            }
+            else {
+                parPrecond_ = constructPrecond( opA, comm );
+            }
+            return *parPrecond_;
+        }
+#endif
+
+        typedef SubdomainDirectSolver<Matrix, Vector, Vector> SeqDirectSolver;
+
+        /// \brief Create a new subdomain direct solver for the (local) matrix of opA,
+        ///        or refactorize the one of the previous solve keeping its
+        ///        symbolic analysis if subdomain_solver_keep_symbolic is set.
+        template <class Operator>
+        void constructSubdomainSolver(Operator& opA, std::unique_ptr<SeqDirectSolver>& solver) const
+        {
+            if( solver && parameters_.subdomain_solver_keep_symbolic_ ) {
+                solver->update( opA.getmat() );
+            }
+            else {
+                solver.reset( new SeqDirectSolver( opA.getmat() ) );
+            }
+        }
+
+        /// \brief Create a new ILU(ilu_fillin_level) for the (local) matrix of
+        ///        opA, or update the one of the previous solve if
+        ///        ilu_reuse_structure is set.
+        template <class Operator>
+        void constructSubdomainSolver(Operator& opA, std::unique_ptr<SeqPreconditioner>& solver) const
+        {
+            if( solver && parameters_.ilu_reuse_structure_ ) {
+                solver->update( opA.getmat() );
+            }
+            else {
+                solver = constructPrecond( opA, Dune::Amg::SequentialInformation() );
+            }
+        }
+
+        /// \brief Return the subdomain solver of the previous solve for the
+        ///        next subdomain_solver_reuse solves, afterwards or if the
+        ///        size of the matrix changed a new one.
+        template <class Operator, class SubdomainSolver>
+        SubdomainSolver& reusedSubdomainSolver(Operator& opA, std::unique_ptr<SubdomainSolver>& solver) const
+        {
+            const std::size_t size = opA.getmat().N();
+            if( solver && subdomainSolverSize_ == size &&
+                subdomainSolverUses_ < parameters_.subdomain_solver_reuse_ ) {
+                ++subdomainSolverUses_;
+            }
+            else {
+                constructSubdomainSolver( opA, solver );
+                subdomainSolverSize_ = size;
+                subdomainSolverUses_ = 0;
+            }
+            return *solver;
+        }
+
+        /// \brief Solve with the subdomain solver as preconditioner.
+        template <class Operator, class ScalarProd, class SubdomainSolver>
+        void solveSubdomains(Operator& opA, Vector& x, Vector& istlb, ScalarProd& sp, SubdomainSolver& solver,
+                             const Dune::Amg::SequentialInformation& info, Dune::InverseOperatorResult& result) const
+        {
+            solve(opA, x, istlb, sp, solver, info, result);
+        }
+
+#if HAVE_MPI
+        /// \brief Solve with the restricted additive Schwarz method applying
+        ///        the subdomain solver to the overlapping subdomain of the process.
+        template <class Operator, class ScalarProd, class SubdomainSolver>
+        void solveSubdomains(Operator& opA, Vector& x, Vector& istlb, ScalarProd& sp, SubdomainSolver& solver,
+                             const Comm& comm, Dune::InverseOperatorResult& result) const
+        {
+            typedef ParallelRestrictedOverlappingSchwarz<Vector, Vector, Comm, SubdomainSolver> SchwarzPreconditioner;
+            SchwarzPreconditioner precond( solver, comm );
+            solve(opA, x, istlb, sp, precond, comm, result);
+        }
+#endif
+
+        /// \brief The multiscale solver of the CPR pressure stage, kept between
+        ///        linear solves to reuse its basis functions, or null if the
+        ///        pressure stage uses AMG.
+        MultiscalePressureSolver* multiscalePressureSolver() const
+        {
+            if( ! cprParameters_.useMultiscalePressureSolver() ) {
+                return nullptr;
+            }
+            if( ! msrsb_ ) {
+                msrsb_.reset(new MultiscalePressureSolver(cprParameters_.cpr_msrsb_block_size_,
+                                                          cprParameters_.cpr_msrsb_iterations_,
+                                                          cprParameters_.cpr_msrsb_tolerance_,
+                                                          cprParameters_.cpr_msrsb_update_tolerance_,
+                                                          cprParameters_.cpr_msrsb_smoothing_));
+            }
+            return msrsb_.get();
+        }
+
+        typedef BlockCPRPreconditioner<Matrix, Vector, Vector, Dune::Amg::SequentialInformation,
+                                       pressureIndex, SeqPreconditioner> SeqCPRPreconditioner;
+
+        /// \brief Construct the CPR preconditioner using quasi-IMPES weights
+        ///        for the pressure stage and ILU0 for the second stage.
+        template <class Operator>
+        std::unique_ptr<SeqCPRPreconditioner>
+        constructCPRPrecond(Operator& opA, const Dune::Amg::SequentialInformation& info) const
+        {
+            const double relax = parameters_.ilu_relaxation_;
+            std::unique_ptr<SeqCPRPreconditioner> precond(new SeqCPRPreconditioner(opA.getmat(), relax, info, cprParameters_,
+                                                                                   multiscalePressureSolver()));
+            return precond;
+        }
+
+#if HAVE_MPI
+        typedef BlockCPRPreconditioner<Matrix, Vector, Vector, Comm,
+                                       pressureIndex, ParPreconditioner> ParCPRPreconditioner;
+
+        template <class Operator>
+        std::unique_ptr<ParCPRPreconditioner>
+        constructCPRPrecond(Operator& opA, const Comm& comm) const
+        {
+            const double relax = parameters_.ilu_relaxation_;
+            std::unique_ptr<ParCPRPreconditioner> precond(new ParCPRPreconditioner(opA.getmat(), relax, comm, cprParameters_,
+                                                                                   multiscalePressureSolver()));
+            return precond;
         }
 #endif
 
+        /// \brief Construct the AMG with the given smoother and solve.
+        template <class Smoother, class LinearOperator, class ScalarProd, class POrComm>
+        void solveAMG(LinearOperator& linearOperator, Vector& x, Vector& istlb, ScalarProd& sp,
+                      const POrComm& comm, Dune::InverseOperatorResult& result) const
+        {
+            typedef ISTLUtility::CPRSelector< Matrix, Vector, Vector, POrComm>  CPRSelectorType;
+            typedef typename CPRSelectorType::Operator MatrixOperator;
+            typedef Dune::Amg::AMG< MatrixOperator, Vector, Smoother, typename CPRSelectorType::ParallelInformation > AMG;
+
+            std::unique_ptr< AMG > amg;
+            std::unique_ptr< MatrixOperator > opA;
+
+            if( ! std::is_same< LinearOperator, MatrixOperator > :: value )
+            {
+                // create new operator in case linear operator and matrix operator differ
+                opA.reset( CPRSelectorType::makeOperator( linearOperator.getmat(), comm ) );
+            }
+
+            // Construct preconditioner.
+            constructAMGPrecond( linearOperator, comm, amg, opA );
+
+            // Solve.
+            solve(linearOperator, x, istlb, sp, *amg, comm, result);
+        }
+
         template <class LinearOperator, class MatrixOperator, class POrComm, class AMG >
         void
-        constructAMGPrecond(LinearOperator& /* linearOperator */, const POrComm& comm, std::unique_ptr< AMG >& amg, std::unique_ptr< MatrixOperator >& opA, const double relax ) const
+        constructAMGPrecond(LinearOperator& /* linearOperator */, const POrComm& comm, std::unique_ptr< AMG >& amg, std::unique_ptr< MatrixOperator >& opA ) const
         {
-            ISTLUtility::template createAMGPreconditionerPointer<pressureIndex>( *opA, relax, comm, amg );
+            createAMG( *opA, comm, amg );
         }
 
 
         template <class MatrixOperator, class POrComm, class AMG >
         void
-        constructAMGPrecond(MatrixOperator& opA, const POrComm& comm, std::unique_ptr< AMG >& amg, std::unique_ptr< MatrixOperator >&, const double relax ) const
+        constructAMGPrecond(MatrixOperator& opA, const POrComm& comm, std::unique_ptr< AMG >& amg, std::unique_ptr< MatrixOperator >& ) const
+        {
+            createAMG( opA, comm, amg );
+        }
+
+        /// \brief Create the AMG with the aggregation, smoothing and cycle
+        ///        parameters given by the amg_* parameters.
+        template <class MatrixOperator, class POrComm, class AMG >
+        void
+        createAMG(MatrixOperator& opA, const POrComm& comm, std::unique_ptr< AMG >& amg) const
+        {
+            typedef typename MatrixOperator::matrix_type M;
+            typedef Dune::Amg::Diagonal<pressureIndex> CouplingMetric;
+            typedef Dune::Amg::SymmetricCriterion<M, CouplingMetric> CritBase;
+            typedef Dune::Amg::CoarsenCriterion<CritBase> Criterion;
+
+            Criterion criterion( parameters_.amg_max_level_, parameters_.amg_coarsen_target_ );
+            // debug level 1 lets the hierarchy print the size of every level
+            criterion.setDebugLevel( parameters_.amg_report_ ? 1 : 0 );
+            criterion.setDefaultValuesIsotropic( parameters_.amg_aggregation_dim_ );
+            criterion.setAlpha( parameters_.amg_alpha_ );
+            criterion.setNoPreSmoothSteps( parameters_.amg_pre_smooth_steps_ );
+            criterion.setNoPostSmoothSteps( parameters_.amg_post_smooth_steps_ );
+            criterion.setGamma( parameters_.amg_cycle_ == "w" ? 2 : 1 );
+            if( parameters_.amg_coarse_accumulate_ )
+            {
+                // gather the coarse levels on one process, where the coarse
+                // system can be solved directly
+                criterion.setAccumulate( Dune::Amg::atOnceAccu );
+            }
+
+            typedef typename Dune::Amg::SmootherTraits<typename AMG::Smoother>::Arguments SmootherArgs;
+            SmootherArgs smootherArgs;
+            smootherArgs.iterations = parameters_.amg_smoother_iterations_;
+            smootherArgs.relaxationFactor = parameters_.amg_smoother_relaxation_;
+
+            Dune::Timer timer;
+            {
+                TimerTree::Region region("AMG setup");
+                amg.reset( new AMG( opA, criterion, smootherArgs, comm ) );
+            }
+
+            if( parameters_.amg_report_ && isIORank_ )
+            {
+                std::ostringstream msg;
+                msg << "AMG setup took " << timer.elapsed() << " seconds: "
+                    << amg->maxlevels() << " levels, " << parameters_.amg_smoother_ << " smoother, "
+                    << parameters_.amg_cycle_ << "-cycle, "
+                    << ( amg->usesDirectCoarseLevelSolver() ? "direct" : "iterative" ) << " coarse solver";
+                OpmLog::info(msg.str());
+            }
+        }
+
+        /// \brief Solve the system using the given preconditioner and scalar
+        ///        product, and the further systems of solveMultiple() with the
+        ///        same preconditioner.
+        template <class Operator, class ScalarProd, class Precond, class POrComm>
+        void solve(Operator& opA, Vector& x, Vector& istlb, ScalarProd& sp, Precond& precond,
+                   const POrComm& comm, Dune::InverseOperatorResult& result) const
         {
-            ISTLUtility::template createAMGPreconditionerPointer<pressureIndex>( opA, relax, comm, amg );
+            krylovSolve(opA, x, istlb, sp, precond, comm, result);
+            for( const auto& system : furtherSystems_ )
+            {
+                Vector& rhs = *system.second;
+                comm.copyOwnerToAll(rhs, rhs);
+                Dune::InverseOperatorResult systemResult;
+                krylovSolve(opA, *system.first, rhs, sp, precond, comm, systemResult);
+                result.iterations += systemResult.iterations;
+                result.converged = result.converged && systemResult.converged;
+            }
         }
 
-        /// \brief Solve the system using the given preconditioner and scalar product.
-        template <class Operator, class ScalarProd, class Precond>
-        void solve(Operator& opA, Vector& x, Vector& istlb, ScalarProd& sp, Precond& precond, Dune::InverseOperatorResult& result) const
+        /// \brief The Krylov iterations of a single system.
+        template <class Operator, class ScalarProd, class Precond, class POrComm>
+        void krylovSolve(Operator& opA, Vector& x, Vector& istlb, ScalarProd& sp, Precond& precond,
+                         const POrComm& comm, Dune::InverseOperatorResult& result) const
         {
             // TODO: Revise when linear solvers interface opm-core is done
             // Construct linear solver.
             // GMRes solver
             int verbosity = ( isIORank_ ) ? parameters_.linear_solver_verbosity_ : 0;
+            TimerTree::Region region("Krylov iterations");
+            Dune::Timer krylovTimer;
 
-            if ( parameters_.newton_use_gmres_ ) {
+            if ( parameters_.linear_solver_recycle_ > 0 ) {
+                // keeps search directions in recycledSpace_ for the next solve
+                RecyclingGCRSolver<Vector> linsolve(opA, sp, precond,
+                          reduction_,
+                          parameters_.linear_solver_restart_,
+                          parameters_.linear_solver_maxiter_,
+                          verbosity,
+                          recycledSpace_,
+                          parameters_.linear_solver_recycle_);
+                // Solve system.
+                linsolve.apply(x, istlb, result);
+            }
+            else if ( parameters_.linear_solver_batched_gmres_ ) {
+                // one global reduction per iteration instead of one per basis vector
+                auto batchedSp = createBatchedScalarProduct<Vector>(comm);
+                BatchedGMResSolver<Vector> linsolve(opA, *batchedSp, precond,
+                          reduction_,
+                          parameters_.linear_solver_restart_,
+                          parameters_.linear_solver_maxiter_,
+                          verbosity);
+                // Solve system.
+                linsolve.apply(x, istlb, result);
+            }
+            else if ( parameters_.newton_use_gmres_ ) {
                 Dune::RestartedGMResSolver<Vector> linsolve(opA, sp, precond,
-                          parameters_.linear_solver_reduction_,
+                          reduction_,
                           parameters_.linear_solver_restart_,
                           parameters_.linear_solver_maxiter_,
                           verbosity);
@@ -362,14 +839,151 @@ namespace Opm
             }
             else { // BiCGstab solver
                 Dune::BiCGSTABSolver<Vector> linsolve(opA, sp, precond,
-                          parameters_.linear_solver_reduction_,
+                          reduction_,
                           parameters_.linear_solver_maxiter_,
                           verbosity);
                 // Solve system.
                 linsolve.apply(x, istlb, result);
             }
+            krylovSolveTime_ += krylovTimer.elapsed();
+        }
+
+
+        /// \brief Solve with the configured preconditioner and, if that fails,
+        ///        again from the same initial guess with the stages of
+        ///        linear_solver_fallback in turn until one converges. The
+        ///        iterations and times of all attempts are accumulated.
+        template<int category=Dune::SolverCategory::sequential, class LinearOperator, class POrComm>
+        void solveWithFallback(LinearOperator& linearOperator, Vector& x, Vector& istlb,
+                               const POrComm& parallelInformation_arg,
+                               Dune::InverseOperatorResult& result) const
+        {
+            // a copy, parameters_ is reassigned by the stages
+            const std::vector<std::string> stages = parameters_.linear_solver_fallback_;
+            if( stages.empty() ) {
+                constructPreconditionerAndSolve<category>(linearOperator, x, istlb, parallelInformation_arg, result);
+                return;
+            }
+
+            // the Krylov solvers overwrite the right hand side
+            const Vector x0( x );
+            const Vector b0( istlb );
+            constructPreconditionerAndSolve<category>(linearOperator, x, istlb, parallelInformation_arg, result);
+            int iterations = result.iterations;
+            double setupTime = preconditionerSetupTime_;
+            double krylovTime = krylovSolveTime_;
+            const std::size_t localSize = maxLocalSize( linearOperator.getmat().N(), parallelInformation_arg );
+
+            for( const auto& stage : stages )
+            {
+                if( result.converged ) {
+                    break;
+                }
+                if( stage == "lu" && localSize > std::size_t( parameters_.linear_solver_fallback_lu_size_ ) ) {
+                    continue;
+                }
+#if ! FLOW_SUPPORT_AMG
+                if( stage == "cpr" ) {
+                    continue;
+                }
+#endif
+                if( isIORank_ ) {
+                    OpmLog::info("Linear solver failed to converge, retrying with the " + stage + " fallback.");
+                }
+
+                // the parameters of the stage replace the configured ones for this solve
+                const NewtonIterationBlackoilInterleavedParameters configured = parameters_;
+                parameters_.use_cpr_ = ( stage == "cpr" );
+                parameters_.linear_solver_use_amg_ = false;
+                if( stage != "cpr" ) {
+                    parameters_.subdomain_solver_ = stage;
+                    parameters_.subdomain_solver_reuse_ = 0;
+                    parameters_.ilu_fillin_level_ = parameters_.linear_solver_fallback_ilu_level_;
+                }
+                x = x0;
+                istlb = b0;
+                try {
+                    constructPreconditionerAndSolve<category>(linearOperator, x, istlb, parallelInformation_arg, result);
+                }
+                catch (...) {
+                    parameters_ = configured;
+                    throw;
+                }
+                parameters_ = configured;
+                iterations += result.iterations;
+                setupTime += preconditionerSetupTime_;
+                krylovTime += krylovSolveTime_;
+            }
+            result.iterations = iterations;
+            preconditionerSetupTime_ = setupTime;
+            krylovSolveTime_ = krylovTime;
+        }
+
+        template<int category=Dune::SolverCategory::sequential, class LinearOperator, class POrComm>
+        void solveMultiple(LinearOperator& linearOperator, std::vector<Vector>& x, std::vector<Vector>& b,
+                           const POrComm& parallelInformation_arg, Dune::InverseOperatorResult& result) const
+        {
+            assert( x.size() == b.size() );
+            if( x.empty() ) {
+                result.iterations = 0;
+                result.converged = true;
+                return;
+            }
+            furtherSystems_.clear();
+            for( std::size_t k = 1; k < x.size(); ++k ) {
+                furtherSystems_.emplace_back( &x[k], &b[k] );
+            }
+            try {
+                constructPreconditionerAndSolve<category>(linearOperator, x[0], b[0], parallelInformation_arg, result);
+            }
+            catch (...) {
+                furtherSystems_.clear();
+                throw;
+            }
+            furtherSystems_.clear();
+        }
+
+#if HAVE_MPI
+        /// \brief The communication of the parallel solves of systems with
+        ///        size rows per process. It is created with its index sets and
+        ///        remote indices at the first call and kept for the following
+        ///        solves, a new one is only set up if the size changes or after
+        ///        resetParallelCommunication(), e.g. after a repartitioning.
+        Comm& parallelCommunication( const std::size_t size ) const
+        {
+            if( ! parallelCommunication_ || parallelCommunicationSize_ != size ) {
+                const ParallelISTLInformation& info =
+                    boost::any_cast<const ParallelISTLInformation&>( parallelInformation_);
+                parallelCommunication_.reset( new Comm( info.communicator() ) );
+                // As we use a dune-istl with block size np the number of components
+                // per parallel is only one.
+                info.copyValuesTo( parallelCommunication_->indexSet(), parallelCommunication_->remoteIndices(),
+                                   size, 1 );
+                parallelCommunicationSize_ = size;
+            }
+            return *parallelCommunication_;
+        }
+
+        /// \brief Set up the communication of the parallel solves again at
+        ///        the next call of parallelCommunication().
+        void resetParallelCommunication() const
+        {
+            parallelCommunication_.reset();
+        }
+#endif
+
+        /// \brief The maximum number of rows of a process.
+        static std::size_t maxLocalSize( const std::size_t size, const Dune::Amg::SequentialInformation& )
+        {
+            return size;
         }
 
+#if HAVE_MPI
+        static std::size_t maxLocalSize( const std::size_t size, const Comm& comm )
+        {
+            return comm.communicator().max( size );
+        }
+#endif
 
         /// Solve the linear system Ax = b, with A being the
         /// combined derivative matrix of the residual and b
@@ -416,16 +1030,20 @@ namespace Opm
 #if HAVE_MPI
             if (parallelInformation_.type() == typeid(ParallelISTLInformation))
             {
-                const size_t size = opA.getmat().N();
-                const ParallelISTLInformation& info =
-                    boost::any_cast<const ParallelISTLInformation&>( parallelInformation_);
-
-                // As we use a dune-istl with block size np the number of components
-                // per parallel is only one.
-                info.copyValuesTo(comm.indexSet(), comm.remoteIndices(),
-                                  size, 1);
+                // The index sets of the communication kept by the solver are
+                // set up already.
+                if( &comm != parallelCommunication_.get() ) {
+                    const size_t size = opA.getmat().N();
+                    const ParallelISTLInformation& info =
+                        boost::any_cast<const ParallelISTLInformation&>( parallelInformation_);
+
+                    // As we use a dune-istl with block size np the number of components
+                    // per parallel is only one.
+                    info.copyValuesTo(comm.indexSet(), comm.remoteIndices(),
+                                      size, 1);
+                }
                 // Construct operator, scalar product and vectors needed.
-                constructPreconditionerAndSolve<Dune::SolverCategory::overlapping>(opA, x, b, comm, result);
+                solveWithFallback<Dune::SolverCategory::overlapping>(opA, x, b, comm, result);
             }
             else
 #endif
@@ -448,14 +1066,43 @@ namespace Opm
             Dune::InverseOperatorResult result;
             // Construct operator, scalar product and vectors needed.
             Dune::Amg::SequentialInformation info;
-            constructPreconditionerAndSolve(opA, x, b, info, result);
+            solveWithFallback(opA, x, b, info, result);
             checkConvergence( result );
         }
 
+        /// Solve the linear systems A x[k] = b[k] with the same matrix, the
+        /// preconditioner is set up once and applied in the Krylov solves of
+        /// all right hand sides. The fallback stages are not tried, the
+        /// iterations are those of all solves.
+        /// \param[in] A   matrix A
+        /// \param[inout] x  solutions to be computed, as many as b
+        /// \param[in] b   right hand sides, overwritten
+        template <class Operator>
+        void solveMultiple(Operator& opA, std::vector<Vector>& x, std::vector<Vector>& b) const
+        {
+            Dune::InverseOperatorResult result;
+            Dune::Amg::SequentialInformation info;
+            solveMultiple(opA, x, b, info, result);
+            checkConvergence( result );
+        }
+
+#if HAVE_MPI
+        /// Solve the linear systems A x[k] = b[k] of a parallel run with the
+        /// communication of parallelCommunication(), see solveMultiple().
+        template <class Operator>
+        void solveMultiple(Operator& opA, std::vector<Vector>& x, std::vector<Vector>& b, Comm& comm) const
+        {
+            Dune::InverseOperatorResult result;
+            solveMultiple<Dune::SolverCategory::overlapping>(opA, x, b, comm, result);
+            checkConvergence( result );
+        }
+#endif
+
         void checkConvergence( const Dune::InverseOperatorResult& result ) const
         {
             // store number of iterations
             iterations_ = result.iterations;
+            converged_ = result.converged;
 
             // Check for failure of linear solver.
             if (!parameters_.ignoreConvergenceFailure_ && !result.converged) {
@@ -465,10 +1112,47 @@ namespace Opm
         }
     protected:
         mutable int iterations_;
+        mutable bool converged_;
+        mutable double preconditionerSetupTime_;
+        mutable double krylovSolveTime_;
+        mutable std::size_t preconditionerMemoryUsage_;
         boost::any parallelInformation_;
         bool isIORank_;
 
-        NewtonIterationBlackoilInterleavedParameters parameters_;
+        // replaced by the parameters of a fallback stage during its solve
+        mutable NewtonIterationBlackoilInterleavedParameters parameters_;
+        // coarsening and agglomeration of the pressure AMG of the CPR preconditioner
+        CPRParameter cprParameters_;
+        // the multiscale pressure solver of the CPR preconditioner, if used
+        mutable std::unique_ptr<MultiscalePressureSolver> msrsb_;
+        // the reduction of the Krylov solves, linear_solver_reduction unless set
+        mutable double reduction_;
+        // whether the ILU preconditioner is kept between solves, and applied
+        // without an update to the matrix
+        mutable bool keepPreconditioner_;
+        mutable bool reusePreconditioner_;
+
+        // the solutions and right hand sides of the systems of solveMultiple()
+        // after the first one, solved with the preconditioner of the first
+        mutable std::vector< std::pair< Vector*, Vector* > > furtherSystems_;
+
+        // search directions kept between solves if linear_solver_recycle is set
+        mutable std::vector< Vector > recycledSpace_;
+
+        // preconditioners kept between solves if ilu_reuse_structure is set
+        mutable std::unique_ptr< SeqPreconditioner > seqPrecond_;
+#if HAVE_MPI
+        mutable std::unique_ptr< ParPreconditioner > parPrecond_;
+        // the communication of the parallel solves, see parallelCommunication()
+        mutable std::unique_ptr< Comm > parallelCommunication_;
+        mutable std::size_t parallelCommunicationSize_ = 0;
+#endif
+
+        // subdomain solvers kept for subdomain_solver_reuse solves
+        mutable std::unique_ptr< SeqDirectSolver > subdomainDirectSolver_;
+        mutable std::unique_ptr< SeqPreconditioner > subdomainILU_;
+        mutable std::size_t subdomainSolverSize_;
+        mutable int subdomainSolverUses_;
     }; // end ISTLSolver
 
 } // namespace Opm
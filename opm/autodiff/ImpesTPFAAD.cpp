@@ -29,6 +29,8 @@
 #include <opm/core/linalg/LinearSolverInterface.hpp>
 #include <opm/core/wells.h>
 
+#include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <iomanip>
 
@@ -52,11 +54,14 @@ namespace {
         return all_cells;
     }
 
+    /// The coefficients of the gravity contribution T_f * dG to the head
+    /// of each internal face, column 0 for the first and column 1 for the
+    /// second cell of the face.
     template <class GeoProps>
-    AutoDiffBlock<double>::M
-    gravityOperator(const UnstructuredGrid& grid,
-                    const HelperOps&        ops ,
-                    const GeoProps&         geo )
+    Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+    gravityCoefficients(const UnstructuredGrid& grid,
+                        const HelperOps&        ops ,
+                        const GeoProps&         geo )
     {
         using namespace Opm::AutoDiffGrid;
         const int nc = numCells(grid);
@@ -80,13 +85,37 @@ namespace {
         }
 
         typedef AutoDiffBlock<double>::V V;
-        typedef AutoDiffBlock<double>::M M;
 
         const V& gpot  = geo.gravityPotential();
         const V& trans = geo.transmissibility();
 
         const HelperOps::IFaces::Index ni = ops.internal_faces.size();
 
+        Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> coeff(ni, 2);
+        for (HelperOps::IFaces::Index i = 0; i < ni; ++i) {
+            const int f  = ops.internal_faces[ i ];
+            assert ((face_cells(f,0) >= 0) && (face_cells(f,1) >= 0));
+
+            const double t = trans[ f ];
+            coeff(i, 0) = t * gpot[ f2hf[2*f + 0] ];
+            coeff(i, 1) = t * gpot[ f2hf[2*f + 1] ];
+        }
+
+        return coeff;
+    }
+
+    AutoDiffBlock<double>::M
+    gravityOperator(const UnstructuredGrid& grid,
+                    const HelperOps&        ops ,
+                    const Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>& coeff)
+    {
+        using namespace Opm::AutoDiffGrid;
+        const int nc = numCells(grid);
+        Eigen::Array<int, Eigen::Dynamic, 2, Eigen::RowMajor>
+            face_cells = faceCellsToEigen(grid);
+
+        const HelperOps::IFaces::Index ni = ops.internal_faces.size();
+
         typedef Eigen::Triplet<double> Tri;
         std::vector<Tri> grav;  grav.reserve(2 * ni);
         for (HelperOps::IFaces::Index i = 0; i < ni; ++i) {
@@ -94,23 +123,39 @@ namespace {
             const int c1 = face_cells(f,0);
             const int c2 = face_cells(f,1);
 
-            assert ((c1 >= 0) && (c2 >= 0));
-
-            const double dG1 = gpot[ f2hf[2*f + 0] ];
-            const double dG2 = gpot[ f2hf[2*f + 1] ];
-            const double t   = trans[ f ];
-
-            grav.push_back(Tri(i, c1,   t * dG1));
-            grav.push_back(Tri(i, c2, - t * dG2));
+            grav.push_back(Tri(i, c1,   coeff(i, 0)));
+            grav.push_back(Tri(i, c2, - coeff(i, 1)));
         }
 
         S G_s(ni, nc);
         G_s.setFromTriplets(grav.begin(), grav.end());
-        M G(G_s);
+        AutoDiffBlock<double>::M G(G_s);
 
         return G;
     }
 
+    /// Value and derivative of a quantity depending on a single variable
+    /// per entry, i.e. with a diagonal Jacobian.
+    void valueAndDerivative(const AutoDiffBlock<double>& a,
+                            AutoDiffBlock<double>::V& value,
+                            AutoDiffBlock<double>::V& derivative)
+    {
+        value = a.value();
+        derivative = AutoDiffBlock<double>::V::Zero(a.size());
+        if (a.derivative().empty()) {
+            return;
+        }
+        S jac;
+        a.derivative()[0].toSparse(jac);
+        for (int k = 0; k < jac.outerSize(); ++k) {
+            for (S::InnerIterator it(jac, k); it; ++it) {
+                if (it.row() == it.col()) {
+                    derivative[it.row()] = it.value();
+                }
+            }
+        }
+    }
+
     V computePerfPress(const UnstructuredGrid& grid, const Wells& wells, const V& rho, const double grav)
     {
         using namespace Opm::AutoDiffGrid;
@@ -155,13 +200,102 @@ namespace {
         , linsolver_(linsolver)
           // , pdepfdata_(grid.number_of_cells, fluid)
         , ops_      (grid)
-        , grav_     (gravityOperator(grid_, ops_, geo_))
-        , cell_residual_ (ADB::null())
-        , well_flow_residual_ ()
-        , well_residual_ (ADB::null())
-        , total_residual_ (ADB::null())
-        , qs_ (ADB::null())
+        , face_grav_(gravityCoefficients(grid_, ops_, geo_))
+        , grav_     (gravityOperator(grid_, ops_, face_grav_))
     {
+        setupSparsityPattern();
+    }
+
+
+
+
+
+    void
+    ImpesTPFAAD::setupSparsityPattern()
+    {
+        using namespace Opm::AutoDiffGrid;
+        const int nc = numCells(grid_);
+        const int nw = wells_.number_of_wells;
+        const int nperf = wells_.well_connpos[nw];
+        const int ni = ops_.internal_faces.size();
+        const Eigen::Array<int, Eigen::Dynamic, 2, Eigen::RowMajor>
+            face_cells = faceCellsToEigen(grid_);
+
+        perf_well_.resize(nperf);
+        for (int w = 0; w < nw; ++w) {
+            for (int perf = wells_.well_connpos[w]; perf < wells_.well_connpos[w+1]; ++perf) {
+                perf_well_[perf] = w;
+            }
+        }
+
+        // Columns of each row: the cell itself, its neighbours and the
+        // wells perforating it, a well row couples to its perforated
+        // cells whatever its control.
+        std::vector<std::vector<int>> columns(nc + nw);
+        cell_perf_start_.assign(nc + 1, 0);
+        for (int row = 0; row < nc + nw; ++row) {
+            columns[row].push_back(row);
+        }
+        for (int i = 0; i < ni; ++i) {
+            const int f  = ops_.internal_faces[i];
+            const int c1 = face_cells(f, 0);
+            const int c2 = face_cells(f, 1);
+            columns[c1].push_back(c2);
+            columns[c2].push_back(c1);
+        }
+        for (int perf = 0; perf < nperf; ++perf) {
+            const int c = wells_.well_cells[perf];
+            const int w = perf_well_[perf];
+            columns[c].push_back(nc + w);
+            columns[nc + w].push_back(c);
+            ++cell_perf_start_[c + 1];
+        }
+
+        jac_rows_.assign(1, 0);
+        jac_cols_.clear();
+        for (auto& cols : columns) {
+            std::sort(cols.begin(), cols.end());
+            cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+            jac_cols_.insert(jac_cols_.end(), cols.begin(), cols.end());
+            jac_rows_.push_back(jac_cols_.size());
+        }
+        jac_values_.assign(jac_cols_.size(), 0.0);
+
+        const auto position = [this](const int row, const int col) {
+            const auto begin = jac_cols_.begin() + jac_rows_[row];
+            const auto end   = jac_cols_.begin() + jac_rows_[row + 1];
+            const auto it = std::lower_bound(begin, end, col);
+            assert(it != end && *it == col);
+            return int(it - jac_cols_.begin());
+        };
+
+        diag_pos_.resize(nc + nw);
+        for (int row = 0; row < nc + nw; ++row) {
+            diag_pos_[row] = position(row, row);
+        }
+
+        face_pos_.resize(2 * ni);
+        for (int c = 0; c < nc; ++c) {
+            cell_perf_start_[c + 1] += cell_perf_start_[c];
+        }
+        cell_perfs_.resize(cell_perf_start_[nc]);
+        for (int i = 0; i < ni; ++i) {
+            const int f  = ops_.internal_faces[i];
+            const int c1 = face_cells(f, 0);
+            const int c2 = face_cells(f, 1);
+            face_pos_[2*i]     = position(c1, c2);
+            face_pos_[2*i + 1] = position(c2, c1);
+        }
+
+        perf_pos_.resize(2 * nperf);
+        std::vector<int> next(cell_perf_start_.begin(), cell_perf_start_.end() - 1);
+        for (int perf = 0; perf < nperf; ++perf) {
+            const int c = wells_.well_cells[perf];
+            const int w = perf_well_[perf];
+            perf_pos_[2*perf]     = position(c, nc + w);
+            perf_pos_[2*perf + 1] = position(nc + w, c);
+            cell_perfs_[next[c]++] = perf;
+        }
     }
 
 
@@ -177,8 +311,6 @@ namespace {
         const int nc = numCells(grid_);
         const int np = state.numPhases();
 
-        well_flow_residual_.resize(np, ADB::null());
-
         // Compute dynamic data that are treated explicitly.
         computeExplicitData(dt, state, well_state);
         // Compute relperms once and for all (since saturations are explicit).
@@ -305,127 +437,176 @@ namespace {
     {
         using namespace Opm::AutoDiffGrid;
         const V& pv = geo_.poreVolume();
-        const int nc = numCells(grid_);              ;
+        const int nc = numCells(grid_);
         const int np = state.numPhases();
         const int nw = wells_.number_of_wells;
         const int nperf = wells_.well_connpos[nw];
+        const int ni = ops_.internal_faces.size();
 
         const std::vector<int> cells = buildAllCells(nc);
+        const std::vector<int> well_cells(wells_.well_cells,
+                                          wells_.well_cells + nperf);
+        const Eigen::Array<int, Eigen::Dynamic, 2, Eigen::RowMajor>
+            face_cells = faceCellsToEigen(grid_);
 
         const Eigen::Map<const DataBlock> z0all(&state.surfacevol()[0], nc, np);
-        const DataBlock qall = DataBlock::Zero(nc, np);
-        const V delta_t = dt * V::Ones(nc, 1);
         const V transi = subset(geo_.transmissibility(),
                                 ops_.internal_faces);
-        const std::vector<int> well_cells(wells_.well_cells,
-                                          wells_.well_cells + nperf);
         const V transw = Eigen::Map<const V>(wells_.WI, nperf, 1);
 
-        // Initialize AD variables: p (cell pressures) and bhp (well bhp).
         const V p0 = Eigen::Map<const V>(&state.pressure()[0], nc, 1);
         const V T0 = Eigen::Map<const V>(&state.temperature()[0], nc, 1);
         const V bhp0 = Eigen::Map<const V>(&well_state.bhp()[0], nw, 1);
-        std::vector<V> vars0 = { p0, bhp0 };
-        std::vector<ADB> vars = ADB::variables(vars0);
-        const ADB& p = vars[0];
+        const ADB p = ADB::variables(std::vector<V>{ p0 })[0];
         const ADB T = ADB::constant(T0);
-        const ADB& bhp = vars[1];
 
-        // Compute T_ij * (p_i - p_j).
-        const ADB nkgradp = transi * (ops_.ngrad * p);
+        // Perforation pressures of the wells, the derivative w.r.t. the
+        // bhp of the well is one.
+        V p_perfwell0(nperf);
+        for (int perf = 0; perf < nperf; ++perf) {
+            p_perfwell0[perf] = bhp0[perf_well_[perf]] + well_perf_dp_[perf];
+        }
+        const ADB p_perfwell = ADB::variables(std::vector<V>{ p_perfwell0 })[0];
+        const ADB T_perfcell = ADB::constant(subset(T0, well_cells));
 
-        // Extract variables for perforation cell pressures
-        // and corresponding perforation well pressures.
-        const ADB p_perfcell = subset(p, well_cells);
-        const ADB T_perfcell = subset(T, well_cells);
-        // Construct matrix to map wells->perforations.
-        S well_to_perf(well_cells.size(), nw);
-        typedef Eigen::Triplet<double> Tri;
-        std::vector<Tri> w2p;
-        for (int w = 0; w < nw; ++w) {
-            for (int perf = wells_.well_connpos[w]; perf < wells_.well_connpos[w+1]; ++perf) {
-                w2p.emplace_back(perf, w, 1.0);
+        // Cell and perforation properties of all phases and their pressure
+        // derivatives, mobilities are explicit in the pressure.
+        std::vector<V> b(np), db(np), rho(np), drho(np), mob(np);
+        std::vector<V> well_b(np), well_db(np), well_mob(np);
+        for (int phase = 0; phase < np; ++phase) {
+            valueAndDerivative(fluidFvf(phase, p, T, cells), b[phase], db[phase]);
+            const V& rhos = fluid_.surfaceDensity(phase, cells);
+            rho[phase]  = rhos * b[phase];
+            drho[phase] = rhos * db[phase];
+            mob[phase]  = fluidKr(phase) / fluidMu(phase, p0, T0, cells);
+
+            valueAndDerivative(fluidFvf(phase, p_perfwell, T_perfcell, well_cells), well_b[phase], well_db[phase]);
+            well_mob[phase] = fluidKrWell(phase) / fluidMu(phase, p_perfwell0, T_perfcell.value(), well_cells);
+        }
+
+        // Surface volume fluxes of the internal faces and their derivatives
+        // w.r.t. the pressures of the first and the second cell.
+        std::vector<double> flux(np * ni), dflux1(np * ni), dflux2(np * ni);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int i = 0; i < ni; ++i) {
+            const int f  = ops_.internal_faces[i];
+            const int c1 = face_cells(f, 0);
+            const int c2 = face_cells(f, 1);
+            const double t = transi[i];
+            for (int phase = 0; phase < np; ++phase) {
+                const double head = t * (p0[c1] - p0[c2])
+                    + face_grav_(i, 0) * rho[phase][c1] - face_grav_(i, 1) * rho[phase][c2];
+                const double dhead1 =  t + face_grav_(i, 0) * drho[phase][c1];
+                const double dhead2 = -t - face_grav_(i, 1) * drho[phase][c2];
+                const bool upwind1 = head >= 0.0;
+                const int up = upwind1 ? c1 : c2;
+                const double m  = mob[phase][up];
+                const double bf = b[phase][up];
+                const int k = phase * ni + i;
+                flux[k]   = m * head * bf;
+                dflux1[k] = m * (dhead1 * bf + (upwind1 ? head * db[phase][up] : 0.0));
+                dflux2[k] = m * (dhead2 * bf + (upwind1 ? 0.0 : head * db[phase][up]));
             }
         }
-        well_to_perf.setFromTriplets(w2p.begin(), w2p.end());
-        const S perf_to_well = well_to_perf.transpose();
-        // Finally construct well perforation pressures and well flows.
-        const ADB p_perfwell = well_to_perf*bhp + well_perf_dp_;
-        const ADB nkgradp_well = transw * (p_perfcell - p_perfwell);
-        const Selector<double> cell_to_well_selector(nkgradp_well.value());
-
-        cell_residual_ = ADB::constant(pv);
-        well_residual_ = ADB::constant(V::Zero(nw,1));
-        ADB divcontrib_sum = ADB::constant(V::Zero(nc,1));
-        qs_ = ADB::constant(V::Zero(nw*np, 1));
-        for (int phase = 0; phase < np; ++phase) {
-            const ADB cell_b = fluidFvf(phase, p, T, cells);
-            const ADB cell_rho = fluidRho(phase, p, T, cells);
-            const ADB well_b = fluidFvf(phase, p_perfwell, T_perfcell, well_cells);
-            const V kr = fluidKr(phase);
-            // Explicitly not asking for derivatives of viscosity,
-            // since they are not available yet.
-            const V mu = fluidMu(phase, p.value(), T.value(), cells);
-            const V cell_mob = kr / mu;
-            const ADB head_diff_grav = (grav_ * cell_rho);
-            const ADB head = nkgradp + (grav_ * cell_rho);
-            const UpwindSelector<double> upwind(grid_, ops_, head.value());
-            const V face_mob = upwind.select(cell_mob);
-            const V well_kr = fluidKrWell(phase);
-            const V well_mu = fluidMu(phase, p_perfwell.value(), T_perfcell.value(), well_cells);
-            const V well_mob = well_kr / well_mu;
-            const V perf_mob = cell_to_well_selector.select(subset(cell_mob, well_cells), well_mob);
-            const ADB flux = face_mob * head;
-            const ADB perf_flux = perf_mob * (nkgradp_well); // No gravity term for perforations.
-            const ADB face_b = upwind.select(cell_b);
-            const ADB perf_b = cell_to_well_selector.select(subset(cell_b, well_cells), well_b);
-            const V z0 = z0all.block(0, phase, nc, 1);
-            const V q  = qall .block(0, phase, nc, 1);
-            const ADB well_contrib = superset(perf_flux*perf_b, well_cells, nc);
-            const ADB divcontrib = delta_t * (ops_.div * (flux * face_b) + well_contrib);
-            const V qcontrib = delta_t * q;
-            const ADB pvcontrib = ADB::constant(pv*z0);
-            const ADB component_contrib = pvcontrib + qcontrib;
-            divcontrib_sum = divcontrib_sum - divcontrib/cell_b;
-            cell_residual_ = cell_residual_ - (component_contrib/cell_b);
-            const ADB well_rates = perf_to_well * (perf_flux*perf_b);
-            qs_ = qs_ +  superset(well_rates, Span(nw, 1, phase*nw), nw*np);
-        }
-        cell_residual_ = cell_residual_ + divcontrib_sum;
-        // Handling BHP and SURFACE_RATE wells.
-        V bhp_targets(nw,1);
-        V rate_targets(nw,1);
-        S rate_distr(nw, np*nw);
+
+        // Surface volume rates of the perforations (positive for production)
+        // and their derivatives w.r.t. the cell pressure and the bhp.
+        std::vector<double> perf_rate(np * nperf), dperf_cell(np * nperf), dperf_bhp(np * nperf);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int perf = 0; perf < nperf; ++perf) {
+            const int c = well_cells[perf];
+            const double drawdown = transw[perf] * (p0[c] - p_perfwell0[perf]); // No gravity term for perforations.
+            const bool producing = drawdown >= 0.0;
+            for (int phase = 0; phase < np; ++phase) {
+                const double m  = producing ? mob[phase][c] : well_mob[phase][perf];
+                const double pb = producing ? b[phase][c] : well_b[phase][perf];
+                const int k = phase * nperf + perf;
+                perf_rate[k]  = m * drawdown * pb;
+                dperf_cell[k] = m * ( transw[perf] * pb + (producing ? drawdown * db[phase][c] : 0.0));
+                dperf_bhp[k]  = m * (-transw[perf] * pb + (producing ? 0.0 : drawdown * well_db[phase][perf]));
+            }
+        }
+
+        residual_.resize(nc + nw);
+        std::fill(jac_values_.begin(), jac_values_.end(), 0.0);
+        const GridTopology& topology = *ops_.topology;
+
+        // Cell rows: sum over the phases of the surface volume balances
+        // divided by the formation volume factors of the cell.
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int c = 0; c < nc; ++c) {
+            double residual = pv[c];
+            double diag = 0.0;
+            for (int phase = 0; phase < np; ++phase) {
+                const double bc = b[phase][c];
+                double div = 0.0;
+                double ddiv = 0.0;
+                for (int k = topology.cell_internal_face_start[c]; k < topology.cell_internal_face_start[c + 1]; ++k) {
+                    const int i = topology.cell_internal_faces[k];
+                    const int idx = phase * ni + i;
+                    if (face_cells(ops_.internal_faces[i], 0) == c) {
+                        div  += flux[idx];
+                        ddiv += dflux1[idx];
+                        jac_values_[face_pos_[2*i]] -= dt * dflux2[idx] / bc;
+                    }
+                    else {
+                        div  -= flux[idx];
+                        ddiv -= dflux2[idx];
+                        jac_values_[face_pos_[2*i + 1]] += dt * dflux1[idx] / bc;
+                    }
+                }
+                for (int k = cell_perf_start_[c]; k < cell_perf_start_[c + 1]; ++k) {
+                    const int perf = cell_perfs_[k];
+                    const int idx = phase * nperf + perf;
+                    div  += perf_rate[idx];
+                    ddiv += dperf_cell[idx];
+                    jac_values_[perf_pos_[2*perf]] -= dt * dperf_bhp[idx] / bc;
+                }
+                const double accumulation = pv[c] * z0all(c, phase) + dt * div;
+                residual -= accumulation / bc;
+                diag += accumulation / (bc * bc) * db[phase][c] - dt * ddiv / bc;
+            }
+            residual_[c] = residual;
+            jac_values_[diag_pos_[c]] += diag;
+        }
+
+        // Well rates and the well rows, handling BHP and SURFACE_RATE wells.
+        qs_ = V::Zero(nw * np);
         for (int w = 0; w < nw; ++w) {
+            for (int perf = wells_.well_connpos[w]; perf < wells_.well_connpos[w+1]; ++perf) {
+                for (int phase = 0; phase < np; ++phase) {
+                    qs_[phase*nw + w] += perf_rate[phase * nperf + perf];
+                }
+            }
+
             const WellControls* wc = wells_.ctrls[w];
             if (well_controls_get_current_type(wc) == BHP) {
-                bhp_targets[w] = well_controls_get_current_target( wc );
-                rate_targets[w] = -1e100;
+                residual_[nc + w] = bhp0[w] - well_controls_get_current_target( wc );
+                jac_values_[diag_pos_[nc + w]] = 1.0;
             } else if (well_controls_get_current_type(wc) == SURFACE_RATE) {
-                bhp_targets[w] = -1e100;
-                rate_targets[w] = well_controls_get_current_target( wc );
-                {
-                    const double * distr = well_controls_get_current_distr( wc );
+                const double * distr = well_controls_get_current_distr( wc );
+                double rate = 0.0;
+                for (int phase = 0; phase < np; ++phase) {
+                    rate += distr[phase] * qs_[phase*nw + w];
+                }
+                residual_[nc + w] = rate - well_controls_get_current_target( wc );
+                for (int perf = wells_.well_connpos[w]; perf < wells_.well_connpos[w+1]; ++perf) {
                     for (int phase = 0; phase < np; ++phase) {
-                        rate_distr.insert(w, phase*nw + w) = distr[phase];
+                        const int idx = phase * nperf + perf;
+                        jac_values_[perf_pos_[2*perf + 1]] += distr[phase] * dperf_cell[idx];
+                        jac_values_[diag_pos_[nc + w]] += distr[phase] * dperf_bhp[idx];
                     }
                 }
             } else {
                 OPM_THROW(std::runtime_error, "Can only handle BHP and SURFACE_RATE type controls.");
             }
         }
-        const ADB bhp_residual = bhp - bhp_targets;
-        const ADB rate_residual = rate_distr * qs_ - rate_targets;
-        // Choose bhp residual for positive bhp targets.
-        Selector<double> bhp_selector(bhp_targets);
-        well_residual_ = bhp_selector.select(bhp_residual, rate_residual);
-
-        // Build full residual by concatenation of residual arrays and
-        // jacobian matrices.
-        total_residual_ = collapseJacs(vertcat(cell_residual_, well_residual_));
-
-        // std::cout.precision(16);
-        // std::cout << total_residual_;
     }
 
 
@@ -439,16 +620,12 @@ namespace {
         using namespace Opm::AutoDiffGrid;
         const int nc = numCells(grid_);
         const int nw = wells_.number_of_wells;
-        // const int np = state.numPhases();
-
-        Eigen::SparseMatrix<double, Eigen::RowMajor> matr;
-        total_residual_.derivative()[0].toSparse(matr);
 
-        V dx(V::Zero(total_residual_.size()));
+        V dx(V::Zero(residual_.size()));
         Opm::LinearSolverInterface::LinearSolverReport rep
-            = linsolver_.solve(matr.rows(), matr.nonZeros(),
-                               matr.outerIndexPtr(), matr.innerIndexPtr(), matr.valuePtr(),
-                               total_residual_.value().data(), dx.data());
+            = linsolver_.solve(nc + nw, jac_values_.size(),
+                               jac_rows_.data(), jac_cols_.data(), jac_values_.data(),
+                               residual_.data(), dx.data());
         if (!rep.converged) {
             OPM_THROW(LinearSolverProblem, "ImpesTPFAAD::solve(): Linear solver convergence failure.");
         }
@@ -470,7 +647,7 @@ namespace {
     double
     ImpesTPFAAD::residualNorm() const
     {
-        return total_residual_.value().matrix().norm();
+        return residual_.matrix().norm();
     }
 
 
@@ -548,7 +725,7 @@ namespace {
         std::copy(perf_flux.data(), perf_flux.data() + nperf, well_state.perfRates().begin());
 
         std::copy(p_perfwell.data(), p_perfwell.data() + nperf, well_state.perfPress().begin());
-        std::copy(qs_.value().data(), qs_.value().data() + np*nw, &well_state.wellRates()[0]);
+        std::copy(qs_.data(), qs_.data() + np*nw, &well_state.wellRates()[0]);
     }
 
 
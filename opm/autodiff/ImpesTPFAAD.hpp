@@ -26,6 +26,8 @@
 #include <opm/autodiff/BlackoilModelEnums.hpp>
 #include <opm/autodiff/BlackoilPropsAdFromDeck.hpp>
 
+#include <vector>
+
 struct UnstructuredGrid;
 struct Wells;
 
@@ -37,6 +39,11 @@ namespace Opm {
     class WellState;
 
     /// Class for solving black-oil impes problems.
+    /// The pressure system is assembled directly into compressed row
+    /// storage with threaded loops over faces, perforations and cells.
+    /// Its sparsity pattern is set up once in the constructor and reused
+    /// for all steps, the arrays are passed unchanged to the linear solver
+    /// (e.g. an AMG configured in the LinearSolverInterface).
     /// Current known limitations:
     ///   - pressure solve only
     ///   - no miscibility
@@ -82,17 +89,33 @@ namespace Opm {
         const Wells&                 wells_;
         const LinearSolverInterface& linsolver_;
         HelperOps                    ops_;
+        const DataBlock              face_grav_;
         const M                      grav_;
-        ADB                          cell_residual_;
-        std::vector<ADB>             well_flow_residual_;
-        ADB                          well_residual_;
-        ADB                          total_residual_;
+        V                            residual_;
         std::vector<V>               kr_;
         std::vector<V>               well_kr_;
-        ADB                          qs_;
+        V                            qs_;
         V                            well_perf_dp_;
 
+        // Jacobian of the pressure system in compressed row storage, the
+        // unknowns are the cell pressures followed by the well bhps.
+        std::vector<int>             jac_rows_;
+        std::vector<int>             jac_cols_;
+        std::vector<double>          jac_values_;
+        // Positions in jac_values_: the diagonal of each row, for internal
+        // face i the entries (c1,c2) and (c2,c1) at 2i and 2i+1, for
+        // perforation j the entries (cell,bhp) and (well,cell) at 2j and 2j+1.
+        std::vector<int>             diag_pos_;
+        std::vector<int>             face_pos_;
+        std::vector<int>             perf_pos_;
+        // Perforations of each cell, the well of each perforation. The
+        // internal faces of each cell are those of ops_.topology.
+        std::vector<int>             cell_perf_start_;
+        std::vector<int>             cell_perfs_;
+        std::vector<int>             perf_well_;
+
         // Methods for assembling and solving.
+        void setupSparsityPattern();
         void computeExplicitData(const double         dt,
                                  const BlackoilState& state,
                                  const WellState& well_state);
@@ -0,0 +1,186 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+
+#include <opm/autodiff/LinearSolverReuseAmg.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Opm
+{
+
+    namespace
+    {
+        // The diagonal entry of row i, zero if it is not in the pattern.
+        template <class Matrix>
+        double diagonal(const Matrix& matrix, const int i)
+        {
+            const auto entry = matrix[i].find(i);
+            return entry != matrix[i].end() ? double(*entry) : 0.0;
+        }
+    }
+
+
+    LinearSolverReuseAmg::LinearSolverReuseAmg(const ParameterGroup& param)
+        : tolerance_(param.getDefault("linsolver_residual_tolerance", 1e-8)),
+          maxIterations_(param.getDefault("linsolver_max_iterations", 150)),
+          verbosity_(param.getDefault("linsolver_verbosity", 0)),
+          amgParam_(param),
+          reuseChange_(param.getDefault("linsolver_reuse_change", 0.5)),
+          warmStart_(param.getDefault("linsolver_warm_start", false)),
+          ia_(),
+          ja_(),
+          matrix_(),
+          setup_(),
+          setupDiagonal_(),
+          iterations_(0)
+    {
+        // the number of solves an AMG coarsening is used for
+        amgParam_.cpr_reuse_setup_ = std::max(param.getDefault("linsolver_reuse_setup", 10), 1);
+    }
+
+
+
+    LinearSolverInterface::LinearSolverReport
+    LinearSolverReuseAmg::solve(const int size,
+                                const int nonzeros,
+                                const int* ia,
+                                const int* ja,
+                                const double* sa,
+                                const double* rhs,
+                                double* solution) const
+    {
+        updateMatrix(size, nonzeros, ia, ja, sa);
+        if (diagonalChange() > reuseChange_) {
+            setup_.invalidate();
+        }
+        setup_.update(matrix_, amgParam_);
+
+        Vector b(size);
+        for (int i = 0; i < size; ++i) {
+            b[i] = rhs[i];
+        }
+        Vector x(size);
+        Dune::InverseOperatorResult result;
+        // two attempts, the second with a new setup if the reused one failed
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            if (!setup_.reused()) {
+                setupDiagonal_.resize(size);
+                for (int i = 0; i < size; ++i) {
+                    setupDiagonal_[i] = diagonal(matrix_, i);
+                }
+            }
+            for (int i = 0; i < size; ++i) {
+                x[i] = warmStart_ ? solution[i] : 0.0;
+            }
+            Vector defect(b);
+            Dune::BiCGSTABSolver<Vector> linsolve(setup_.op(), setup_.amg(), tolerance_, maxIterations_, verbosity_);
+            linsolve.apply(x, defect, result);
+            if (result.converged || !setup_.reused()) {
+                break;
+            }
+            setup_.invalidate();
+            setup_.update(matrix_, amgParam_);
+        }
+
+        for (int i = 0; i < size; ++i) {
+            solution[i] = x[i];
+        }
+        iterations_ = result.iterations;
+
+        LinearSolverReport rep;
+        rep.converged = result.converged;
+        rep.iterations = result.iterations;
+        rep.residual_reduction = result.reduction;
+        return rep;
+    }
+
+
+
+    void LinearSolverReuseAmg::setTolerance(const double tol)
+    {
+        tolerance_ = tol;
+    }
+
+
+
+    double LinearSolverReuseAmg::getTolerance() const
+    {
+        return tolerance_;
+    }
+
+
+
+    double LinearSolverReuseAmg::diagonalChange() const
+    {
+        const int size = matrix_.N();
+        if (int(setupDiagonal_.size()) != size) {
+            return std::numeric_limits<double>::infinity();
+        }
+        double change = 0.0;
+        for (int i = 0; i < size; ++i) {
+            const double d0 = setupDiagonal_[i];
+            const double d = diagonal(matrix_, i);
+            if (d0 != 0.0) {
+                change = std::max(change, std::abs(d - d0) / std::abs(d0));
+            } else if (d != 0.0) {
+                return std::numeric_limits<double>::infinity();
+            }
+        }
+        return change;
+    }
+
+
+
+    void LinearSolverReuseAmg::updateMatrix(const int size, const int nonzeros,
+                                            const int* ia, const int* ja, const double* sa) const
+    {
+        const bool samePattern = int(ia_.size()) == size + 1
+            && int(ja_.size()) == nonzeros
+            && std::equal(ia_.begin(), ia_.end(), ia)
+            && std::equal(ja_.begin(), ja_.end(), ja);
+        if (!samePattern) {
+            ia_.assign(ia, ia + size + 1);
+            ja_.assign(ja, ja + nonzeros);
+            Matrix matrix(size, size, nonzeros, Matrix::row_wise);
+            int i = 0;
+            for (auto row = matrix.createbegin(); row != matrix.createend(); ++row, ++i) {
+                for (int k = ia[i]; k < ia[i + 1]; ++k) {
+                    row.insert(ja[k]);
+                }
+            }
+            matrix_ = matrix;
+        }
+
+        // the columns of a row of the CSR matrix need not be sorted and
+        // may appear more than once
+        matrix_ = 0.0;
+        for (int i = 0; i < size; ++i) {
+            auto& row = matrix_[i];
+            for (int k = ia[i]; k < ia[i + 1]; ++k) {
+                row[ja[k]] += sa[k];
+            }
+        }
+    }
+
+} // namespace Opm
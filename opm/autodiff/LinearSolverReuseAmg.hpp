@@ -0,0 +1,117 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef OPM_LINEARSOLVERREUSEAMG_HEADER_INCLUDED
+#define OPM_LINEARSOLVERREUSEAMG_HEADER_INCLUDED
+
+#include <opm/core/linalg/LinearSolverInterface.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+#include <opm/autodiff/CPRPreconditioner.hpp>
+
+#include <vector>
+
+namespace Opm
+{
+
+    /// A linear solver for the scalar pressure systems of the opm-core
+    /// pressure solvers, e.g. CompressibleTpfa, which keeps the matrix and
+    /// the AMG setup between the solves. The matrices of such a solver
+    /// have the same sparsity pattern in all nonlinear iterations and time
+    /// steps, only the coefficients change. The pattern is compared with
+    /// the stored one and the matrix is only rebuilt if it differs. The
+    /// AMG coarsening is kept for linsolver_reuse_setup solves, for which
+    /// only the Galerkin products are recomputed, see CPREllipticSetup. A
+    /// new coarsening is also computed when a diagonal entry of the matrix
+    /// changed by more than the relative linsolver_reuse_change since the
+    /// last one, e.g. for large mobility changes of a pressure system. A
+    /// solve which does not converge with a reused setup is repeated with
+    /// a new one. With linsolver_warm_start the given solution is the
+    /// initial guess, otherwise zero.
+    ///
+    /// Parameters: linsolver_residual_tolerance, linsolver_max_iterations,
+    /// linsolver_verbosity, linsolver_reuse_setup, linsolver_reuse_change,
+    /// linsolver_warm_start and the cpr_amg_* and cpr_relax parameters of
+    /// the AMG.
+    class LinearSolverReuseAmg : public LinearSolverInterface
+    {
+    public:
+        explicit LinearSolverReuseAmg(const ParameterGroup& param);
+
+        using LinearSolverInterface::solve;
+
+        /// Solve a linear system, with a matrix given in compressed sparse
+        /// row format.
+        /// \param[in] size        # of rows in matrix
+        /// \param[in] nonzeros    # of nonzeros elements in matrix
+        /// \param[in] ia          array of length (size + 1) containing start and end indices for each row
+        /// \param[in] ja          array of length nonzeros containing column numbers for the nonzero elements
+        /// \param[in] sa          array of length nonzeros containing the values of the nonzero elements
+        /// \param[in] rhs         array of length size containing the right hand side
+        /// \param[inout] solution array of length size to which the solution will be written, may also be used
+        ///                        as initial guess by iterative solvers.
+        virtual LinearSolverReport solve(const int size,
+                                         const int nonzeros,
+                                         const int* ia,
+                                         const int* ja,
+                                         const double* sa,
+                                         const double* rhs,
+                                         double* solution) const;
+
+        /// Set tolerance for the residual
+        /// \param[in] tol         tolerance value
+        virtual void setTolerance(const double tol);
+
+        /// Get tolerance for the residual
+        virtual double getTolerance() const;
+
+        /// The number of iterations of the last solve.
+        virtual int iterations() const { return iterations_; }
+
+    private:
+        typedef Dune::BCRSMatrix< Dune::FieldMatrix< double, 1, 1 > > Matrix;
+        typedef Dune::BlockVector< Dune::FieldVector< double, 1 > > Vector;
+
+        // Copy the values of the CSR matrix, rebuild the matrix if its
+        // pattern differs from the stored one.
+        void updateMatrix(const int size, const int nonzeros,
+                          const int* ia, const int* ja, const double* sa) const;
+
+        // The largest relative change of a diagonal entry since the last
+        // AMG coarsening, infinite if there was none.
+        double diagonalChange() const;
+
+        double tolerance_;
+        int maxIterations_;
+        int verbosity_;
+        CPRParameter amgParam_;
+        double reuseChange_;
+        bool warmStart_;
+
+        mutable std::vector<int> ia_;
+        mutable std::vector<int> ja_;
+        mutable Matrix matrix_;
+        mutable CPREllipticSetup< Matrix, Vector > setup_;
+        mutable std::vector<double> setupDiagonal_;
+        mutable int iterations_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_LINEARSOLVERREUSEAMG_HEADER_INCLUDED
@@ -0,0 +1,369 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_LINEARSYSTEMDUMP_HEADER_INCLUDED
+#define OPM_LINEARSYSTEMDUMP_HEADER_INCLUDED
+
+#include <opm/autodiff/PerforationBlocks.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    /// A linear system of the fully implicit black-oil models as it is
+    /// handed to the linear solver: the reservoir Jacobian A, the residual b
+    /// and the well equations, which enter the operator as A - B^T inv(D) C.
+    ///
+    /// It is written by BlackoilModelEbos when the dump_linear_system
+    /// parameter asks for it and read by the replay_linear_solver program.
+    /// The binary file holds, in native byte order,
+    ///
+    ///     "OPMLSD01", version, block size, Newton iteration, linear solve
+    ///     A:    rows, columns, nonzeros, row offsets, column indices, blocks
+    ///     b:    size, blocks
+    ///     B, C: wells, perforations, well offsets, perforation cells, blocks
+    ///     invD: as A
+    ///     the explicit well flags, one byte per well
+    ///
+    /// where the counts and indices are 32 bit integers, except for the 64
+    /// bit row offsets, and the blocks are doubles in row-major order.
+    template <class MatrixBlock, class VectorBlock>
+    struct LinearSystemDump
+    {
+        typedef Dune::BCRSMatrix<MatrixBlock> Matrix;
+        typedef Dune::BlockVector<VectorBlock> Vector;
+        typedef PerforationBlocks<MatrixBlock> PerfBlocks;
+
+        Matrix A;
+        Vector b;
+        PerfBlocks B;
+        PerfBlocks C;
+        Matrix invD;
+        /// The wells whose Schur complement is already contained in A.
+        std::vector<bool> explicitWell;
+        int newtonIteration = 0;
+        int linearSolve = 0;
+
+        /// Ax -= B^T inv(D) C x for the implicit wells, as done by
+        /// StandardWellsDense::apply.
+        void applyWells(const Vector& x, Vector& Ax) const
+        {
+            const int nw = invD.N();
+            if (nw == 0) {
+                return;
+            }
+            Vector Cx(nw);
+            Vector invDCx(nw);
+            C.mv(x, Cx);
+            invD.mv(Cx, invDCx);
+            for (int w = 0; w < nw; ++w) {
+                if (explicitWell[w]) {
+                    invDCx[w] = 0.0;
+                }
+            }
+            B.mmtv(invDCx, Ax);
+        }
+    };
+
+
+    namespace LinearSystemDumpDetail
+    {
+        const char magic[] = "OPMLSD01";
+        const std::int32_t version = 1;
+
+        template <class T>
+        void write(std::ostream& os, const T& value)
+        {
+            os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <class T>
+        void writeArray(std::ostream& os, const std::vector<T>& values)
+        {
+            os.write(reinterpret_cast<const char*>(values.data()), values.size()*sizeof(T));
+        }
+
+        template <class T>
+        T read(std::istream& is)
+        {
+            T value;
+            is.read(reinterpret_cast<char*>(&value), sizeof(T));
+            return value;
+        }
+
+        template <class T>
+        void readArray(std::istream& is, std::vector<T>& values, const std::size_t size)
+        {
+            values.resize(size);
+            is.read(reinterpret_cast<char*>(values.data()), size*sizeof(T));
+        }
+
+        template <class Block>
+        void writeBlock(std::ostream& os, const Block& block)
+        {
+            for (int r = 0; r < Block::rows; ++r) {
+                for (int c = 0; c < Block::cols; ++c) {
+                    write<double>(os, block[r][c]);
+                }
+            }
+        }
+
+        template <class Block>
+        void readBlock(std::istream& is, Block& block)
+        {
+            for (int r = 0; r < Block::rows; ++r) {
+                for (int c = 0; c < Block::cols; ++c) {
+                    block[r][c] = read<double>(is);
+                }
+            }
+        }
+
+        template <class Matrix>
+        void writeMatrix(std::ostream& os, const Matrix& A)
+        {
+            write<std::int32_t>(os, A.N());
+            write<std::int32_t>(os, A.M());
+            write<std::int32_t>(os, A.nonzeroes());
+            std::vector<std::int64_t> rowStart(1, 0);
+            std::vector<std::int32_t> cols;
+            cols.reserve(A.nonzeroes());
+            for (auto row = A.begin(); row != A.end(); ++row) {
+                for (auto col = row->begin(); col != row->end(); ++col) {
+                    cols.push_back(col.index());
+                }
+                rowStart.push_back(cols.size());
+            }
+            writeArray(os, rowStart);
+            writeArray(os, cols);
+            for (auto row = A.begin(); row != A.end(); ++row) {
+                for (auto col = row->begin(); col != row->end(); ++col) {
+                    writeBlock(os, *col);
+                }
+            }
+        }
+
+        template <class Matrix>
+        void readMatrix(std::istream& is, Matrix& A)
+        {
+            const int n = read<std::int32_t>(is);
+            const int m = read<std::int32_t>(is);
+            const int nnz = read<std::int32_t>(is);
+            std::vector<std::int64_t> rowStart;
+            std::vector<std::int32_t> cols;
+            readArray(is, rowStart, n + 1);
+            readArray(is, cols, nnz);
+            if (!is) {
+                OPM_THROW(std::runtime_error, "Truncated matrix in linear system dump");
+            }
+
+            Matrix result(n, m, nnz, Matrix::row_wise);
+            for (auto row = result.createbegin(); row != result.createend(); ++row) {
+                for (auto k = rowStart[row.index()]; k < rowStart[row.index() + 1]; ++k) {
+                    row.insert(cols[k]);
+                }
+            }
+            for (auto row = result.begin(); row != result.end(); ++row) {
+                for (auto col = row->begin(); col != row->end(); ++col) {
+                    readBlock(is, *col);
+                }
+            }
+            A = result;
+        }
+
+        template <class Vector>
+        void writeVector(std::ostream& os, const Vector& v)
+        {
+            write<std::int32_t>(os, v.size());
+            for (const auto& block : v) {
+                for (int i = 0; i < Vector::block_type::dimension; ++i) {
+                    write<double>(os, block[i]);
+                }
+            }
+        }
+
+        template <class Vector>
+        void readVector(std::istream& is, Vector& v)
+        {
+            v.resize(read<std::int32_t>(is));
+            for (auto& block : v) {
+                for (int i = 0; i < Vector::block_type::dimension; ++i) {
+                    block[i] = read<double>(is);
+                }
+            }
+        }
+
+        template <class Block>
+        void writePerforationBlocks(std::ostream& os, const PerforationBlocks<Block>& blocks)
+        {
+            const int nw = blocks.numWells();
+            const int nperf = blocks.numPerforations();
+            write<std::int32_t>(os, nw);
+            write<std::int32_t>(os, nperf);
+            for (int w = 0; w <= nw; ++w) {
+                write<std::int32_t>(os, w < nw ? blocks.wellBegin(w) : nperf);
+            }
+            for (int perf = 0; perf < nperf; ++perf) {
+                write<std::int32_t>(os, blocks.cell(perf));
+            }
+            for (int perf = 0; perf < nperf; ++perf) {
+                writeBlock(os, blocks[perf]);
+            }
+        }
+
+        template <class Block>
+        void readPerforationBlocks(std::istream& is, PerforationBlocks<Block>& blocks)
+        {
+            const int nw = read<std::int32_t>(is);
+            const int nperf = read<std::int32_t>(is);
+            std::vector<std::int32_t> wellStart;
+            std::vector<std::int32_t> cells;
+            readArray(is, wellStart, nw + 1);
+            readArray(is, cells, nperf);
+            if (!is) {
+                OPM_THROW(std::runtime_error, "Truncated well matrix in linear system dump");
+            }
+            const std::vector<int> start(wellStart.begin(), wellStart.end());
+            const std::vector<int> perfCells(cells.begin(), cells.end());
+            blocks.init(nw, start.data(), perfCells.data());
+            for (int perf = 0; perf < nperf; ++perf) {
+                readBlock(is, blocks[perf]);
+            }
+        }
+
+        /// Read the header and return the block size.
+        inline int readHeader(std::istream& is, const std::string& filename)
+        {
+            char buffer[sizeof(magic) - 1];
+            is.read(buffer, sizeof(buffer));
+            if (!is || std::memcmp(buffer, magic, sizeof(buffer)) != 0) {
+                OPM_THROW(std::runtime_error, filename << " is not a linear system dump");
+            }
+            const int fileVersion = read<std::int32_t>(is);
+            if (fileVersion != version) {
+                OPM_THROW(std::runtime_error, "Linear system dump " << filename << " has version "
+                          << fileVersion << ", expected " << version);
+            }
+            return read<std::int32_t>(is);
+        }
+    } // namespace LinearSystemDumpDetail
+
+
+    /// Write a linear system, see LinearSystemDump for the format.
+    /// \param[in] filename         name of the file to write
+    /// \param[in] A                the reservoir Jacobian
+    /// \param[in] b                the residual
+    /// \param[in] B                the transposed blocks of the well matrix B
+    /// \param[in] C                the blocks of the well matrix C
+    /// \param[in] invD             the inverse of the well matrix D
+    /// \param[in] explicitWell     the wells whose Schur complement is in A
+    /// \param[in] newtonIteration  the Newton iteration of the system
+    /// \param[in] linearSolve      the number of the linear solve of the run
+    template <class Matrix, class Vector, class Block>
+    void writeLinearSystem(const std::string& filename,
+                           const Matrix& A, const Vector& b,
+                           const PerforationBlocks<Block>& B,
+                           const PerforationBlocks<Block>& C,
+                           const Matrix& invD,
+                           const std::vector<bool>& explicitWell,
+                           const int newtonIteration,
+                           const int linearSolve)
+    {
+        using namespace LinearSystemDumpDetail;
+        static_assert(Block::rows == Block::cols, "The blocks of the linear system must be square");
+
+        std::ofstream os(filename.c_str(), std::ios::binary);
+        if (!os) {
+            OPM_THROW(std::runtime_error, "Could not open linear system dump " << filename);
+        }
+        os.write(magic, sizeof(magic) - 1);
+        write<std::int32_t>(os, version);
+        write<std::int32_t>(os, Block::rows);
+        write<std::int32_t>(os, newtonIteration);
+        write<std::int32_t>(os, linearSolve);
+        writeMatrix(os, A);
+        writeVector(os, b);
+        writePerforationBlocks(os, B);
+        writePerforationBlocks(os, C);
+        writeMatrix(os, invD);
+        for (std::size_t w = 0; w < invD.N(); ++w) {
+            write<std::uint8_t>(os, w < explicitWell.size() && explicitWell[w]);
+        }
+        if (!os) {
+            OPM_THROW(std::runtime_error, "Could not write linear system dump " << filename);
+        }
+    }
+
+
+    /// The block size of the linear system of a dump.
+    inline int readLinearSystemBlockSize(const std::string& filename)
+    {
+        std::ifstream is(filename.c_str(), std::ios::binary);
+        if (!is) {
+            OPM_THROW(std::runtime_error, "Could not open linear system dump " << filename);
+        }
+        return LinearSystemDumpDetail::readHeader(is, filename);
+    }
+
+
+    /// Read a linear system written by writeLinearSystem. The block size of
+    /// the dump must be the one of the matrix blocks.
+    template <class MatrixBlock, class VectorBlock>
+    void readLinearSystem(const std::string& filename,
+                          LinearSystemDump<MatrixBlock, VectorBlock>& system)
+    {
+        using namespace LinearSystemDumpDetail;
+
+        std::ifstream is(filename.c_str(), std::ios::binary);
+        if (!is) {
+            OPM_THROW(std::runtime_error, "Could not open linear system dump " << filename);
+        }
+        const int blockSize = readHeader(is, filename);
+        if (blockSize != MatrixBlock::rows) {
+            OPM_THROW(std::runtime_error, "Linear system dump " << filename << " has block size "
+                      << blockSize << ", expected " << MatrixBlock::rows);
+        }
+        system.newtonIteration = read<std::int32_t>(is);
+        system.linearSolve = read<std::int32_t>(is);
+        readMatrix(is, system.A);
+        readVector(is, system.b);
+        readPerforationBlocks(is, system.B);
+        readPerforationBlocks(is, system.C);
+        readMatrix(is, system.invD);
+        system.explicitWell.resize(system.invD.N());
+        for (std::size_t w = 0; w < system.explicitWell.size(); ++w) {
+            system.explicitWell[w] = read<std::uint8_t>(is) != 0;
+        }
+        if (!is) {
+            OPM_THROW(std::runtime_error, "Truncated linear system dump " << filename);
+        }
+    }
+
+} // namespace Opm
+
+#endif // OPM_LINEARSYSTEMDUMP_HEADER_INCLUDED
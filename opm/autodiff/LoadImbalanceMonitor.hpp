@@ -0,0 +1,121 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_LOADIMBALANCEMONITOR_HEADER_INCLUDED
+#define OPM_LOADIMBALANCEMONITOR_HEADER_INCLUDED
+
+#include <opm/autodiff/SumAndMaxReduction.hpp>
+
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
+#include <vector>
+
+namespace Opm
+{
+
+    /// Measures the imbalance of the work of the processes per report step,
+    /// as the maximum over the mean of the time each process spent on its
+    /// own cells, i.e. without the time waiting for the others.
+    ///
+    /// The partition of the grid cannot change within a run, since the
+    /// simulator objects are built on the distributed grid. When the
+    /// imbalance exceeds the threshold the run may instead be stopped at
+    /// the report step, to be restarted with a partition weighted by the
+    /// wells of the restart step.
+    class LoadImbalanceMonitor
+    {
+    public:
+        /// Threshold of the imbalance, 0 disables the monitor, and whether
+        /// to stop the run when it is exceeded.
+        LoadImbalanceMonitor(const double threshold, const bool stop)
+            : threshold_(threshold)
+            , stop_(stop)
+            , imbalance_(1.0)
+#if HAVE_MPI
+            , comm_(MPI_COMM_SELF)
+#endif
+        {
+        }
+
+#if HAVE_MPI
+        /// The processes whose work is compared.
+        void setCommunicator(MPI_Comm comm)
+        {
+            comm_ = comm;
+        }
+#endif
+
+        bool active() const
+        {
+            return threshold_ > 0.0;
+        }
+
+        /// Record the time this process spent on the last report step and
+        /// return the imbalance over all processes. Collective call.
+        double update(const double localTime)
+        {
+            imbalance_ = 1.0;
+#if HAVE_MPI
+            int size = 1;
+            MPI_Comm_size(comm_, &size);
+            if (size > 1) {
+                std::vector<double> sums(1, localTime);
+                std::vector<double> maxima(1, localTime);
+                sumAndMaxAllReduce(comm_, sums, maxima);
+                const double mean = sums[0] / size;
+                if (mean > 0.0) {
+                    imbalance_ = maxima[0] / mean;
+                }
+            }
+#endif
+            return imbalance_;
+        }
+
+        /// The imbalance of the last report step.
+        double imbalance() const
+        {
+            return imbalance_;
+        }
+
+        /// True if the imbalance of the last report step exceeds the threshold.
+        bool exceeded() const
+        {
+            return active() && imbalance_ > threshold_;
+        }
+
+        /// True if the run should be stopped for a new partition.
+        bool stopRequested() const
+        {
+            return stop_ && exceeded();
+        }
+
+    private:
+        double threshold_;
+        bool stop_;
+        double imbalance_;
+#if HAVE_MPI
+        MPI_Comm comm_;
+#endif
+    };
+
+} // namespace Opm
+
+#endif // OPM_LOADIMBALANCEMONITOR_HEADER_INCLUDED
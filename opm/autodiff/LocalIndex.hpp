@@ -0,0 +1,53 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_LOCALINDEX_HEADER_INCLUDED
+#define OPM_LOCALINDEX_HEADER_INCLUDED
+
+#include <opm/common/ErrorMacros.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+namespace Opm
+{
+
+    /// The index type of the sparse structures of one process: the rows,
+    /// columns and nonzero offsets of its matrices and preconditioners and
+    /// the cells of its connectivity. Those always fit in 32 bits, only the
+    /// global ids of a parallel run, e.g. the global index of the parallel
+    /// index sets, need wider types. Half the width of std::size_t halves
+    /// the index traffic of the sparse kernels.
+    typedef std::uint32_t LocalIndex;
+
+    /// Throw if count entries of a process cannot be indexed by LocalIndex,
+    /// whose largest value is kept as the unset marker.
+    inline void checkLocalIndexRange(const std::size_t count, const char* what)
+    {
+        if (count >= std::size_t(std::numeric_limits<LocalIndex>::max())) {
+            OPM_THROW(std::runtime_error, "The " << count << " " << what
+                      << " of this process exceed the range of the 32-bit local indices.");
+        }
+    }
+
+} // namespace Opm
+
+#endif // OPM_LOCALINDEX_HEADER_INCLUDED
@@ -0,0 +1,198 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+#include <opm/autodiff/MatlabStepWriter.hpp>
+#include <opm/simulators/ensureDirectoryExists.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+namespace Opm
+{
+
+    namespace
+    {
+        // The NumPy type string of the values in the native byte order.
+        std::string dtype(const bool singlePrecision)
+        {
+            const std::uint16_t one = 1;
+            const bool littleEndian = *reinterpret_cast<const unsigned char*>(&one) == 1;
+            return std::string(littleEndian ? "<" : ">") + (singlePrecision ? "f4" : "f8");
+        }
+
+        // The header of a NumPy file, padded such that the data is aligned
+        // to 64 bytes.
+        std::string npyHeader(const std::string& type, const std::size_t rows, const int columns)
+        {
+            std::ostringstream dict;
+            dict << "{'descr': '" << type << "', 'fortran_order': False, 'shape': (" << rows;
+            if (columns > 1) {
+                dict << ", " << columns << "), }";
+            }
+            else {
+                dict << ",), }";
+            }
+            std::string header = dict.str();
+            // magic (6), version (2) and length (2) precede the dictionary,
+            // which ends with a newline
+            const std::size_t unpadded = 10 + header.size() + 1;
+            header.append((64 - unpadded % 64) % 64, ' ');
+            header.push_back('\n');
+
+            std::string result("\x93NUMPY\x01\x00", 8);
+            const std::size_t length = header.size();
+            result.push_back(char(length & 0xff));
+            result.push_back(char((length >> 8) & 0xff));
+            return result + header;
+        }
+    } // anonymous namespace
+
+
+    MatlabStepWriter::MatlabStepWriter(const std::string& outputDir,
+                                       const int step,
+                                       const Encoding encoding,
+                                       const bool singlePrecision)
+        : outputDir_(outputDir)
+        , step_(step)
+        , encoding_(encoding)
+        , singlePrecision_(singlePrecision)
+        , rawOffset_(0)
+    {
+    }
+
+
+    MatlabStepWriter::Encoding MatlabStepWriter::encoding(const std::string& name)
+    {
+        if (name == "text") {
+            return Text;
+        }
+        else if (name == "npy") {
+            return Npy;
+        }
+        else if (name == "raw") {
+            return Raw;
+        }
+        OPM_THROW(std::runtime_error, "Unknown Matlab output format " << name << ", use text, npy or raw");
+    }
+
+
+    void MatlabStepWriter::write(const std::string& name, const std::vector<double>& values, const int columns)
+    {
+        const std::size_t rows = columns > 0 ? values.size() / columns : values.size();
+        if (encoding_ == Text) {
+            const std::string filename = fieldFile(name, "txt");
+            std::ofstream file(filename.c_str());
+            if (!file) {
+                OPM_THROW(std::runtime_error, "Failed to open " << filename);
+            }
+            file.precision(15);
+            std::copy(values.begin(), values.end(), std::ostream_iterator<double>(file, "\n"));
+            return;
+        }
+
+        Entry entry;
+        entry.name = name;
+        entry.rows = rows;
+        entry.columns = columns;
+        if (encoding_ == Npy) {
+            const std::string filename = fieldFile(name, "npy");
+            std::ofstream file(filename.c_str(), std::ios::binary);
+            if (!file) {
+                OPM_THROW(std::runtime_error, "Failed to open " << filename);
+            }
+            const std::string header = npyHeader(dtype(singlePrecision_), rows, columns);
+            file.write(header.data(), header.size());
+            writeValues(file, values);
+            if (!file) {
+                OPM_THROW(std::runtime_error, "Failed to write " << filename);
+            }
+            entry.file = name + "/" + filename.substr(filename.find_last_of('/') + 1);
+            entry.offset = header.size();
+        }
+        else {
+            // appended to the file of the step, which is created by the
+            // first field
+            const std::string filename = fieldFile("raw", "bin");
+            std::ofstream file(filename.c_str(), rawOffset_ == 0 ? std::ios::binary | std::ios::trunc
+                                                                 : std::ios::binary | std::ios::app);
+            if (!file) {
+                OPM_THROW(std::runtime_error, "Failed to open " << filename);
+            }
+            writeValues(file, values);
+            if (!file) {
+                OPM_THROW(std::runtime_error, "Failed to write " << filename);
+            }
+            entry.file = "raw/" + filename.substr(filename.find_last_of('/') + 1);
+            entry.offset = rawOffset_;
+            rawOffset_ += values.size() * (singlePrecision_ ? sizeof(float) : sizeof(double));
+        }
+        index_.push_back(entry);
+    }
+
+
+    void MatlabStepWriter::finish()
+    {
+        if (encoding_ == Text) {
+            return;
+        }
+        const std::string filename = fieldFile("index", "txt");
+        std::ofstream file(filename.c_str());
+        if (!file) {
+            OPM_THROW(std::runtime_error, "Failed to open " << filename);
+        }
+        const std::string type = dtype(singlePrecision_);
+        file << "# name file dtype rows columns offset\n";
+        for (const auto& entry : index_) {
+            file << entry.name << ' ' << entry.file << ' ' << type << ' '
+                 << entry.rows << ' ' << entry.columns << ' ' << entry.offset << '\n';
+        }
+        index_.clear();
+    }
+
+
+    std::string MatlabStepWriter::fieldFile(const std::string& name, const char* extension) const
+    {
+        std::ostringstream filename;
+        filename << outputDir_ << "/" << name;
+        ensureDirectoryExists(filename.str());
+        filename << "/" << std::setw(3) << std::setfill('0') << step_ << "." << extension;
+        return filename.str();
+    }
+
+
+    void MatlabStepWriter::writeValues(std::ostream& os, const std::vector<double>& values) const
+    {
+        if (singlePrecision_) {
+            const std::vector<float> converted(values.begin(), values.end());
+            os.write(reinterpret_cast<const char*>(converted.data()), converted.size() * sizeof(float));
+        }
+        else {
+            os.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+        }
+    }
+
+} // namespace Opm
@@ -0,0 +1,99 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef OPM_MATLABSTEPWRITER_HEADER_INCLUDED
+#define OPM_MATLABSTEPWRITER_HEADER_INCLUDED
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Writes the fields of one time step of the Matlab output.
+    ///
+    /// The fields are written as
+    ///
+    ///  - Text: <dir>/<field>/<step>.txt with one value per line, the
+    ///    format read by the Matlab scripts,
+    ///  - Npy:  <dir>/<field>/<step>.npy in the NumPy format, version 1.0,
+    ///          with one row per cell or well,
+    ///  - Raw:  all fields of the step one after the other in
+    ///          <dir>/raw/<step>.bin,
+    ///
+    /// where <step> has three digits. The binary formats are written with
+    /// one bulk write per field in the native byte order, optionally
+    /// converted to single precision. For them finish() writes the index
+    /// of the step, <dir>/index/<step>.txt, with one line per field:
+    ///
+    ///   name file dtype rows columns offset
+    ///
+    /// where dtype is the NumPy type string, e.g. <f8, and offset is the
+    /// position of the values in bytes in the file.
+    class MatlabStepWriter
+    {
+    public:
+        enum Encoding { Text = 0, Npy, Raw };
+
+        /// \param[in] outputDir        output directory
+        /// \param[in] step             number of the time step
+        /// \param[in] encoding         format of the files
+        /// \param[in] singlePrecision  convert the binary formats to float32
+        MatlabStepWriter(const std::string& outputDir,
+                         const int step,
+                         const Encoding encoding = Text,
+                         const bool singlePrecision = false);
+
+        /// The encoding of a format name, text, npy or raw. Throws
+        /// std::runtime_error for other names.
+        static Encoding encoding(const std::string& name);
+
+        /// Write a field with the given number of values per row.
+        void write(const std::string& name, const std::vector<double>& values, const int columns = 1);
+
+        /// Write the index of the step, nothing for the text format.
+        void finish();
+
+    private:
+        struct Entry
+        {
+            std::string name;
+            std::string file;
+            std::size_t rows;
+            int columns;
+            std::size_t offset;
+        };
+
+        std::string fieldFile(const std::string& name, const char* extension) const;
+        void writeValues(std::ostream& os, const std::vector<double>& values) const;
+
+        std::string outputDir_;
+        int step_;
+        Encoding encoding_;
+        bool singlePrecision_;
+        std::size_t rawOffset_;
+        std::vector<Entry> index_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_MATLABSTEPWRITER_HEADER_INCLUDED
@@ -0,0 +1,298 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_MATRIXORDERING_HEADER_INCLUDED
+#define OPM_MATRIXORDERING_HEADER_INCLUDED
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Compute a reverse Cuthill-McKee ordering of the rows of a
+    /// structurally symmetric sparse matrix. Each connected component is
+    /// traversed breadth first from an unvisited row of smallest degree,
+    /// visiting the neighbours of a row in order of increasing degree.
+    /// \param[in]  A     a Dune::BCRSMatrix or a matrix with the same row
+    ///                   and column iterator interface.
+    /// \param[out] perm  perm[i] is the row of A that becomes row i of the
+    ///                   reordered matrix.
+    template <class M, class IndexVector>
+    void reverseCuthillMcKee(const M& A, IndexVector& perm)
+    {
+        typedef typename IndexVector::value_type Index;
+        const std::size_t n = A.N();
+
+        std::vector<std::size_t> degree(n);
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            degree[row.index()] = row->size();
+        }
+        const auto byDegree = [&degree](const Index a, const Index b) { return degree[a] < degree[b]; };
+
+        std::vector<Index> starts(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            starts[i] = i;
+        }
+        std::stable_sort(starts.begin(), starts.end(), byDegree);
+
+        std::vector<bool> visited(n, false);
+        std::vector<Index> neighbours;
+        perm.clear();
+        perm.reserve(n);
+        for (const Index start : starts) {
+            if (visited[start]) {
+                continue;
+            }
+            visited[start] = true;
+            std::size_t head = perm.size();
+            perm.push_back(start);
+            while (head < perm.size()) {
+                const Index row = perm[head++];
+                neighbours.clear();
+                const auto& cols = A[row];
+                for (auto col = cols.begin(); col != cols.end(); ++col) {
+                    if (!visited[col.index()]) {
+                        visited[col.index()] = true;
+                        neighbours.push_back(col.index());
+                    }
+                }
+                std::stable_sort(neighbours.begin(), neighbours.end(), byDegree);
+                perm.insert(perm.end(), neighbours.begin(), neighbours.end());
+            }
+        }
+        std::reverse(perm.begin(), perm.end());
+    }
+
+
+
+    /// Compute a multi-color ordering of the rows of a structurally
+    /// symmetric sparse matrix. The rows are colored greedily in their
+    /// order, each with the smallest color not used by a coupled row, and
+    /// sorted by color, keeping their order within a color. Rows of the
+    /// same color are not coupled, so the triangular solves and the ILU0
+    /// decomposition of the reordered matrix have at most one dependency
+    /// level per color.
+    /// \param[in]  A     a Dune::BCRSMatrix or a matrix with the same row
+    ///                   and column iterator interface.
+    /// \param[out] perm  perm[i] is the row of A that becomes row i of the
+    ///                   reordered matrix.
+    /// \return the number of colors.
+    template <class M, class IndexVector>
+    std::size_t multiColorOrdering(const M& A, IndexVector& perm)
+    {
+        const std::size_t n = A.N();
+        const std::size_t none = n;
+        std::vector<std::size_t> color(n, none);
+        // usedBy[c] == row if color c is taken by a neighbour of row
+        std::vector<std::size_t> usedBy;
+        std::size_t numColors = 0;
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            const auto& cols = *row;
+            for (auto col = cols.begin(); col != cols.end(); ++col) {
+                const std::size_t c = color[col.index()];
+                if (c != none) {
+                    usedBy[c] = row.index();
+                }
+            }
+            std::size_t c = 0;
+            while (c < numColors && usedBy[c] == row.index()) {
+                ++c;
+            }
+            if (c == numColors) {
+                usedBy.push_back(none);
+                ++numColors;
+            }
+            color[row.index()] = c;
+        }
+
+        // bucket sort the rows by color
+        std::vector<std::size_t> start(numColors + 1, 0);
+        for (std::size_t i = 0; i < n; ++i) {
+            ++start[color[i] + 1];
+        }
+        for (std::size_t c = 0; c < numColors; ++c) {
+            start[c + 1] += start[c];
+        }
+        perm.resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            perm[start[color[i]]++] = i;
+        }
+        return numColors;
+    }
+
+
+
+    /// Compute a distance-2 coloring of the columns of a sparsity pattern,
+    /// i.e. no row has nonzeros in two columns of the same color. The
+    /// columns of a color can be perturbed together when a Jacobian is
+    /// approximated by finite differences (Curtis, Powell and Reid), as
+    /// each row of the difference depends on one perturbed column only.
+    /// The columns are colored greedily in their order, each with the
+    /// smallest color not used by a column sharing a row with it.
+    /// \param[in]  rows     rows[i] are the columns of the nonzeros of row i.
+    /// \param[in]  numCols  the number of columns.
+    /// \param[out] color    color[j] is the color of column j.
+    /// \return the number of colors.
+    template <class Pattern, class IndexVector>
+    std::size_t distanceTwoColoring(const Pattern& rows, const std::size_t numCols, IndexVector& color)
+    {
+        const std::size_t n = rows.size();
+
+        // the rows of each column
+        std::vector<std::size_t> colStart(numCols + 1, 0);
+        for (std::size_t i = 0; i < n; ++i) {
+            for (const auto j : rows[i]) {
+                assert(std::size_t(j) < numCols);
+                ++colStart[j + 1];
+            }
+        }
+        for (std::size_t j = 0; j < numCols; ++j) {
+            colStart[j + 1] += colStart[j];
+        }
+        std::vector<std::size_t> colRows(colStart[numCols]);
+        std::vector<std::size_t> pos(colStart.begin(), colStart.end() - 1);
+        for (std::size_t i = 0; i < n; ++i) {
+            for (const auto j : rows[i]) {
+                colRows[pos[j]++] = i;
+            }
+        }
+
+        const std::size_t none = numCols;
+        std::vector<std::size_t> colColor(numCols, none);
+        // usedBy[c] == col if color c is taken by a column sharing a row with col
+        std::vector<std::size_t> usedBy;
+        std::size_t numColors = 0;
+        for (std::size_t j = 0; j < numCols; ++j) {
+            for (std::size_t k = colStart[j]; k < colStart[j + 1]; ++k) {
+                for (const auto other : rows[colRows[k]]) {
+                    const std::size_t c = colColor[other];
+                    if (c != none) {
+                        usedBy[c] = j;
+                    }
+                }
+            }
+            std::size_t c = 0;
+            while (c < numColors && usedBy[c] == j) {
+                ++c;
+            }
+            if (c == numColors) {
+                usedBy.push_back(none);
+                ++numColors;
+            }
+            colColor[j] = c;
+        }
+
+        color.assign(colColor.begin(), colColor.end());
+        return numColors;
+    }
+
+
+
+    /// The inverse of a permutation, inverse[perm[i]] == i.
+    template <class IndexVector>
+    void invertPermutation(const IndexVector& perm, IndexVector& inverse)
+    {
+        inverse.resize(perm.size());
+        for (std::size_t i = 0; i < perm.size(); ++i) {
+            inverse[perm[i]] = i;
+        }
+    }
+
+
+
+    /// The bandwidth of A, i.e. the largest distance |i - j| of a nonzero
+    /// A[i][j] from the diagonal.
+    template <class M>
+    std::size_t matrixBandwidth(const M& A)
+    {
+        std::size_t bandwidth = 0;
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            const std::size_t i = row.index();
+            for (auto col = row->begin(); col != row->end(); ++col) {
+                const std::size_t j = col.index();
+                bandwidth = std::max(bandwidth, i > j ? i - j : j - i);
+            }
+        }
+        return bandwidth;
+    }
+
+
+
+    /// The bandwidth A would have after renumbering its rows and columns
+    /// by perm, as computed by reverseCuthillMcKee.
+    template <class M, class IndexVector>
+    std::size_t matrixBandwidth(const M& A, const IndexVector& perm)
+    {
+        IndexVector inverse;
+        invertPermutation(perm, inverse);
+        std::size_t bandwidth = 0;
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            const std::size_t i = inverse[row.index()];
+            for (auto col = row->begin(); col != row->end(); ++col) {
+                const std::size_t j = inverse[col.index()];
+                bandwidth = std::max(bandwidth, i > j ? i - j : j - i);
+            }
+        }
+        return bandwidth;
+    }
+
+
+
+    /// Copy the values of A into the matrix B previously created by
+    /// permuteMatrix for a matrix with the sparsity pattern of A.
+    template <class M, class IndexVector>
+    void permuteMatrixValues(const M& A, const IndexVector& perm, const IndexVector& inverse, M& B)
+    {
+        const int n = B.N();
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; ++i) {
+            auto& row = B[i];
+            const auto& cols = A[perm[i]];
+            for (auto col = cols.begin(); col != cols.end(); ++col) {
+                row[inverse[col.index()]] = *col;
+            }
+        }
+    }
+
+
+
+    /// Create the symmetrically permuted matrix B = P A P^T, where row i
+    /// of B is row perm[i] of A and inverse is the inverse of perm.
+    /// B must be a default constructed Dune::BCRSMatrix.
+    template <class M, class IndexVector>
+    void permuteMatrix(const M& A, const IndexVector& perm, const IndexVector& inverse, M& B)
+    {
+        assert(perm.size() == A.N() && inverse.size() == A.N());
+        B.setBuildMode(M::row_wise);
+        B.setSize(A.N(), A.M(), A.nonzeroes());
+        for (auto row = B.createbegin(); row != B.createend(); ++row) {
+            const auto& cols = A[perm[row.index()]];
+            for (auto col = cols.begin(); col != cols.end(); ++col) {
+                row.insert(inverse[col.index()]);
+            }
+        }
+        permuteMatrixValues(A, perm, inverse, B);
+    }
+
+} // namespace Opm
+
+#endif // OPM_MATRIXORDERING_HEADER_INCLUDED
@@ -0,0 +1,159 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+#include <opm/autodiff/MemoryTracker.hpp>
+#include <opm/autodiff/PerformanceSummary.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+namespace Opm
+{
+
+    bool MemoryTracker::enabled_ = false;
+    std::array<bool, MemoryTracker::NumPhases> MemoryTracker::sampled_ = {};
+
+    namespace
+    {
+        const char* phaseNames[ MemoryTracker::NumPhases ] = {
+            "deck and grid",
+            "equilibration",
+            "geology",
+            "first linearization",
+            "first linear solve",
+            "first output",
+            "simulation"
+        };
+
+        std::array<double, MemoryTracker::NumPhases * MemoryTracker::NumValues> values;
+        std::ofstream file;
+
+        void writeSample(const int phase)
+        {
+            file << std::left << std::setw(22) << phaseNames[phase] << std::right << std::fixed << std::setprecision(0)
+                 << " rss " << std::setw(12) << values[phase * MemoryTracker::NumValues + MemoryTracker::Resident] << " kB"
+                 << " hwm " << std::setw(12) << values[phase * MemoryTracker::NumValues + MemoryTracker::HighWaterMark] << " kB"
+                 << std::endl;
+        }
+    } // anonymous namespace
+
+
+    void MemoryTracker::enable(const bool on)
+    {
+        enabled_ = on;
+    }
+
+
+    void MemoryTracker::open(const std::string& filename)
+    {
+        file.open(filename.c_str());
+        if (!file) {
+            OPM_THROW(std::runtime_error, "Could not open memory tracking file " << filename);
+        }
+        for (int phase = 0; phase < NumPhases; ++phase) {
+            if (sampled_[phase]) {
+                writeSample(phase);
+            }
+        }
+    }
+
+
+    void MemoryTracker::take(const Phase phase)
+    {
+        sampled_[phase] = true;
+        values[phase * NumValues + Resident] = residentSetSize();
+        values[phase * NumValues + HighWaterMark] = PerformanceSummary::peakResidentSetSize();
+        if (file.is_open()) {
+            // flushed, the file must be complete when the process is killed
+            writeSample(phase);
+        }
+    }
+
+
+    std::vector<double> MemoryTracker::samples()
+    {
+        return std::vector<double>(values.begin(), values.end());
+    }
+
+
+    const char* MemoryTracker::name(const Phase phase)
+    {
+        return phaseNames[phase];
+    }
+
+
+    double MemoryTracker::residentSetSize()
+    {
+        // the second value of statm is the resident set size in pages
+        std::ifstream statm("/proc/self/statm");
+        long size = 0;
+        long resident = 0;
+        if (!(statm >> size >> resident)) {
+            return 0.0;
+        }
+        return resident * (sysconf(_SC_PAGESIZE) / 1024.0);
+    }
+
+
+    std::string MemoryTracker::format(const std::vector<double>& samples, const int numProcesses)
+    {
+        const int stride = NumPhases * NumValues;
+        std::ostringstream os;
+        os << "Memory use of the phases in MB over " << numProcesses << " processes:\n";
+        os << std::left << std::setw(22) << "phase" << std::right
+           << std::setw(10) << "min rss" << std::setw(10) << "mean rss" << std::setw(10) << "max rss"
+           << std::setw(10) << "min hwm" << std::setw(10) << "mean hwm" << std::setw(10) << "max hwm"
+           << std::setw(8) << "rank" << "\n";
+        for (int phase = 0; phase < NumPhases; ++phase) {
+            os << std::left << std::setw(22) << phaseNames[phase] << std::right
+               << std::fixed << std::setprecision(1);
+            int worst = 0;
+            for (int value = 0; value < NumValues; ++value) {
+                double min = 0.0;
+                double sum = 0.0;
+                double max = 0.0;
+                for (int rank = 0; rank < numProcesses; ++rank) {
+                    const double v = samples[rank * stride + phase * NumValues + value] / 1024.0;
+                    min = rank == 0 ? v : std::min(min, v);
+                    sum += v;
+                    if (rank == 0 || v > max) {
+                        max = v;
+                        if (value == HighWaterMark) {
+                            worst = rank;
+                        }
+                    }
+                }
+                os << std::setw(10) << min
+                   << std::setw(10) << (numProcesses > 0 ? sum / numProcesses : 0.0)
+                   << std::setw(10) << max;
+            }
+            os << std::setw(8) << worst << "\n";
+        }
+        return os.str();
+    }
+
+} // namespace Opm
@@ -0,0 +1,118 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef OPM_MEMORYTRACKER_HEADER_INCLUDED
+#define OPM_MEMORYTRACKER_HEADER_INCLUDED
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    /// The resident set size and its high-water mark of this process at
+    /// the end of the phases of a run, to find the phase in which a run
+    /// runs out of memory.
+    ///
+    /// Each phase is sampled the first time it ends. The samples are
+    /// appended to a file of the process as they are taken, and the file
+    /// is flushed, such that it shows the last completed phase of a
+    /// process that was killed. At the end of the run the samples of all
+    /// processes are gathered and reported with the process of the
+    /// largest high-water mark of each phase.
+    class MemoryTracker
+    {
+    public:
+        /// The phases that are sampled, in the order of a run.
+        enum Phase {
+            DeckAndGrid = 0,
+            Equilibration,
+            Geology,
+            FirstLinearization,
+            FirstLinearSolve,
+            FirstOutput,
+            Simulation,
+            NumPhases
+        };
+
+        /// The values of a sample in kB.
+        enum Value {
+            Resident = 0,
+            HighWaterMark,
+            NumValues
+        };
+
+        /// Start or stop sampling.
+        static void enable(const bool on);
+
+        /// Whether the phases are sampled.
+        static bool enabled() { return enabled_; }
+
+        /// Append the samples to the file, including those taken so far.
+        static void open(const std::string& filename);
+
+        /// Sample the end of a phase, unless it was sampled before.
+        static void sample(const Phase phase)
+        {
+            if (enabled_ && !sampled_[phase]) {
+                take(phase);
+            }
+        }
+
+        /// The samples of this process, NumValues per phase, zero for the
+        /// phases that were not sampled.
+        static std::vector<double> samples();
+
+        /// The name of a phase.
+        static const char* name(const Phase phase);
+
+        /// The current resident set size of this process in kB, zero where
+        /// it is not available.
+        static double residentSetSize();
+
+        /// Gather the samples of all processes on the root process and
+        /// return the report there, collective over the processes of comm.
+        template <class Communication>
+        static std::string report(const Communication& comm, const int root = 0)
+        {
+            std::vector<double> local = samples();
+            std::vector<double> all(local.size() * comm.size(), 0.0);
+            comm.gather(local.data(), all.data(), local.size(), root);
+            return comm.rank() == root ? format(all, comm.size()) : std::string();
+        }
+
+        /// The table of the minimum, mean and maximum of the samples of
+        /// each phase over the processes, with the process of the maximum.
+        /// \param[in] samples       the samples of the processes one after
+        ///                          the other, as given by samples()
+        /// \param[in] numProcesses  the number of processes
+        static std::string format(const std::vector<double>& samples, const int numProcesses);
+
+    private:
+        static void take(const Phase phase);
+
+        static bool enabled_;
+        static std::array<bool, NumPhases> sampled_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_MEMORYTRACKER_HEADER_INCLUDED
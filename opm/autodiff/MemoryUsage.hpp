@@ -0,0 +1,70 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_MEMORYUSAGE_HEADER_INCLUDED
+#define OPM_MEMORYUSAGE_HEADER_INCLUDED
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+
+#include <cstddef>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    /// The number of bytes held by the elements of a vector, including
+    /// the reserved capacity.
+    template <class T, class Alloc>
+    std::size_t memoryUsage(const std::vector<T, Alloc>& v)
+    {
+        return v.capacity()*sizeof(T);
+    }
+
+    /// The number of bytes held by the blocks of a block vector.
+    template <class B, class Alloc>
+    std::size_t memoryUsage(const Dune::BlockVector<B, Alloc>& v)
+    {
+        return v.capacity()*sizeof(B);
+    }
+
+    /// The number of bytes held by a BCRS matrix: the blocks and column
+    /// indices of the non-zeroes and the row descriptors.
+    template <class B, class Alloc>
+    std::size_t memoryUsage(const Dune::BCRSMatrix<B, Alloc>& A)
+    {
+        typedef Dune::BCRSMatrix<B, Alloc> Matrix;
+        return A.nonzeroes()*(sizeof(B) + sizeof(typename Matrix::size_type))
+            + A.N()*sizeof(typename Matrix::row_type);
+    }
+
+    /// Format a number of bytes in MB for log messages.
+    inline std::string formatMemoryUsage(const double bytes)
+    {
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(1) << bytes/(1024.0*1024.0) << " MB";
+        return os.str();
+    }
+
+} // namespace Opm
+
+#endif // OPM_MEMORYUSAGE_HEADER_INCLUDED
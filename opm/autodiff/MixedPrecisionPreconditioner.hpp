@@ -0,0 +1,174 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef OPM_MIXEDPRECISIONPRECONDITIONER_HEADER_INCLUDED
+#define OPM_MIXEDPRECISIONPRECONDITIONER_HEADER_INCLUDED
+
+#include <opm/autodiff/MemoryUsage.hpp>
+
+#include <dune/common/unused.hh>
+#include <dune/istl/preconditioner.hh>
+
+#include <memory>
+#include <utility>
+
+namespace Opm
+{
+    namespace detail
+    {
+        //! \brief Copy the values of A into B which has the same pattern.
+        //! The rows are copied in a statically scheduled threaded loop.
+        template <class MatrixIn, class MatrixOut>
+        void copyValuesConvertingPrecision(const MatrixIn& A, MatrixOut& B)
+        {
+            const int numRows = A.N();
+#pragma omp parallel for schedule(static)
+            for( int rowIdx = 0; rowIdx < numRows; ++rowIdx )
+            {
+                const auto& row = A[ rowIdx ];
+                auto& rowB = B[ rowIdx ];
+                auto colB = rowB.begin();
+                const auto endj = row.end();
+                for( auto col = row.begin(); col != endj; ++col, ++colB )
+                {
+                    for( int i = 0; i < MatrixIn::block_type::rows; ++i )
+                    {
+                        for( int j = 0; j < MatrixIn::block_type::cols; ++j )
+                        {
+                            (*colB)[ i ][ j ] = (*col)[ i ][ j ];
+                        }
+                    }
+                }
+            }
+        }
+
+        //! \brief Copy the pattern and the values of A into B, converting the
+        //! field type of the blocks (e.g. from double to float).
+        template <class MatrixIn, class MatrixOut>
+        void copyMatrixConvertingPrecision(const MatrixIn& A, MatrixOut& B)
+        {
+            B.setSize( A.N(), A.M(), A.nonzeroes() );
+            B.setBuildMode( MatrixOut::row_wise );
+            for( auto row = B.createbegin(); row != B.createend(); ++row )
+            {
+                const auto& rowA = A[ row.index() ];
+                const auto endj = rowA.end();
+                for( auto col = rowA.begin(); col != endj; ++col )
+                {
+                    row.insert( col.index() );
+                }
+            }
+
+            copyValuesConvertingPrecision( A, B );
+        }
+
+        //! \brief Copy x into y converting the field type.
+        template <class VectorIn, class VectorOut>
+        void copyVectorConvertingPrecision(const VectorIn& x, VectorOut& y)
+        {
+            const int size = x.size();
+#pragma omp parallel for schedule(static)
+            for( int i = 0; i < size; ++i )
+            {
+                for( int k = 0; k < VectorIn::block_type::dimension; ++k )
+                {
+                    y[ i ][ k ] = x[ i ][ k ];
+                }
+            }
+        }
+    } // end namespace detail
+
+    /// \brief A preconditioner that stores and applies a preconditioner in a
+    ///        lower precision than the one used by the Krylov solver.
+    ///
+    /// Preconditioner application is limited by memory bandwidth, so storing
+    /// its data in single precision almost halves the cost of an apply. The
+    /// defect is converted to the low precision, the wrapped preconditioner is
+    /// applied and the correction is converted back.
+    /// \tparam Domain The type of the (high precision) domain vector.
+    /// \tparam Range  The type of the (high precision) range vector.
+    /// \tparam LowPrecisionPreconditioner The wrapped preconditioner.
+    template <class Domain, class Range, class LowPrecisionPreconditioner>
+    class MixedPrecisionPreconditioner
+        : public Dune::Preconditioner<Domain,Range>
+    {
+    public:
+        //! \brief The domain type of the preconditioner.
+        typedef Domain domain_type;
+        //! \brief The range type of the preconditioner.
+        typedef Range range_type;
+        //! \brief The field type of the preconditioner.
+        typedef typename Domain::field_type field_type;
+
+        typedef typename LowPrecisionPreconditioner::domain_type LowPrecisionDomain;
+        typedef typename LowPrecisionPreconditioner::range_type  LowPrecisionRange;
+
+        // define the category
+        enum {
+            //! \brief The category the preconditioner is part of.
+            category = LowPrecisionPreconditioner::category
+        };
+
+        /// \brief Constructor.
+        /// \param precond The low precision preconditioner to wrap.
+        /// \param size    The number of blocks of the vectors.
+        MixedPrecisionPreconditioner( std::unique_ptr< LowPrecisionPreconditioner >&& precond,
+                                      const std::size_t size )
+            : precond_( std::move( precond ) ),
+              v_( size ),
+              d_( size )
+        {
+        }
+
+        virtual void pre (Domain& x, Range& b)
+        {
+            DUNE_UNUSED_PARAMETER(x);
+            DUNE_UNUSED_PARAMETER(b);
+        }
+
+        virtual void apply (Domain& v, const Range& d)
+        {
+            detail::copyVectorConvertingPrecision( d, d_ );
+            v_ = 0.0;
+            precond_->apply( v_, d_ );
+            detail::copyVectorConvertingPrecision( v_, v );
+        }
+
+        virtual void post (Domain& x)
+        {
+            DUNE_UNUSED_PARAMETER(x);
+        }
+
+        /// \brief Access to the wrapped low precision preconditioner.
+        LowPrecisionPreconditioner& lowPrecisionPreconditioner() { return *precond_; }
+
+        /// \brief The number of bytes held by the wrapped preconditioner and
+        ///        the low precision work vectors.
+        std::size_t memoryUsage() const
+        {
+            return precond_->memoryUsage() + Opm::memoryUsage( v_ ) + Opm::memoryUsage( d_ );
+        }
+
+    protected:
+        std::unique_ptr< LowPrecisionPreconditioner > precond_;
+        LowPrecisionDomain v_;
+        LowPrecisionRange  d_;
+    };
+
+} // end namespace Opm
+#endif
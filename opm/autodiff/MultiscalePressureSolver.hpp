@@ -0,0 +1,443 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_MULTISCALEPRESSURESOLVER_HEADER_INCLUDED
+#define OPM_MULTISCALEPRESSURESOLVER_HEADER_INCLUDED
+
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <Eigen/Eigen>
+#include <Eigen/Sparse>
+#include <Eigen/SparseLU>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Multiscale restriction-smoothed basis (MsRSB) solver for a scalar
+    /// pressure system, to be used as an approximate solver, e.g. in the
+    /// first stage of a CPR preconditioner.
+    ///
+    /// The rows of the matrix are aggregated into connected coarse blocks.
+    /// Each coarse block has a basis function, supported on the block and
+    /// a few layers of rows around it, that starts as the indicator of the block and
+    /// is smoothed by damped Jacobi iterations restricted to the support,
+    /// keeping the basis functions a partition of unity. A solve is the
+    /// coarse correction P (R A P)^{-1} R r, with the finite-volume
+    /// restriction R summing over the coarse blocks, followed by Jacobi
+    /// smoothing steps.
+    ///
+    /// The basis functions can be kept for new values of the matrix: update()
+    /// smooths only those whose support saw a relative change of a diagonal
+    /// entry, i.e. of the total mobility, above a tolerance since their last
+    /// smoothing, and recomputes the coarse system.
+    class MultiscalePressureSolver
+    {
+    public:
+        typedef Eigen::SparseMatrix<double, Eigen::RowMajor> Matrix;
+        typedef Eigen::VectorXd Vector;
+
+        /// \param[in] blockSize        the number of rows of a coarse block
+        /// \param[in] iterations       maximum number of smoothing iterations
+        ///                             of the basis functions
+        /// \param[in] tolerance        the basis functions are converged when
+        ///                             the largest update is below this value
+        /// \param[in] updateTolerance  relative change of the diagonal that
+        ///                             triggers smoothing a basis function again
+        /// \param[in] smoothingSteps   Jacobi steps after the coarse correction
+        MultiscalePressureSolver(const int blockSize, const int iterations, const double tolerance,
+                                 const double updateTolerance, const int smoothingSteps)
+            : blockSize_(std::max(blockSize, 1)),
+              iterations_(iterations),
+              tolerance_(tolerance),
+              updateTolerance_(updateTolerance),
+              smoothingSteps_(smoothingSteps),
+              smoothedBases_(0)
+        {
+        }
+
+        /// Partition the rows of A and compute all basis functions.
+        void setup(const Matrix& A)
+        {
+            partition(A);
+            createSupports(A);
+            std::vector<int> active(bases_.size());
+            for (int j = 0; j < static_cast<int>(bases_.size()); ++j) {
+                active[j] = j;
+            }
+            smoothBases(A, active);
+            createCoarseSystem(A);
+        }
+
+        /// Keep the basis functions for the new values of A, which must have
+        /// the rows of the matrix of setup(), and smooth those whose support
+        /// changed by more than the update tolerance. Falls back to setup()
+        /// if the number of rows changed.
+        void update(const Matrix& A)
+        {
+            if (A.rows() != static_cast<int>(coarse_.size())) {
+                setup(A);
+                return;
+            }
+            std::vector<int> active;
+            for (int j = 0; j < static_cast<int>(bases_.size()); ++j) {
+                const Basis& basis = bases_[j];
+                for (std::size_t a = 0; a < basis.cells.size(); ++a) {
+                    const double previous = basis.diagonal[a];
+                    const double change = std::abs(A.coeff(basis.cells[a], basis.cells[a]) - previous);
+                    if (!(change <= updateTolerance_ * std::abs(previous))) {
+                        active.push_back(j);
+                        break;
+                    }
+                }
+            }
+            smoothBases(A, active);
+            createCoarseSystem(A);
+        }
+
+        /// x = P (R A P)^{-1} R r, followed by the Jacobi smoothing steps.
+        void apply(const Vector& r, Vector& x) const
+        {
+            const Vector rc = R_ * r;
+            const Vector xc = coarseSolver_.solve(rc);
+            x = P_ * xc;
+            for (int step = 0; step < smoothingSteps_; ++step) {
+                x += omega() * invDiagonal_.cwiseProduct(r - A_ * x);
+            }
+        }
+
+        /// The number of rows of the matrix of the last setup.
+        int numRows() const { return coarse_.size(); }
+
+        /// The number of coarse blocks.
+        int numBlocks() const { return bases_.size(); }
+
+        /// The coarse block of each row.
+        const std::vector<int>& coarsePartition() const { return coarse_; }
+
+        /// The prolongation P, whose column j is the basis function of block j.
+        const Matrix& prolongation() const { return P_; }
+
+        /// The number of basis functions smoothed by the last setup or update.
+        int smoothedBases() const { return smoothedBases_; }
+
+    private:
+        struct Basis
+        {
+            // the rows of the support, in increasing order
+            std::vector<int> cells;
+            std::vector<double> values;
+            // whether a row of the support is connected to a row outside
+            std::vector<char> boundary;
+            // the diagonal of the matrix at the last smoothing
+            std::vector<double> diagonal;
+        };
+
+        static double omega() { return 2.0 / 3.0; }
+
+        /// Aggregate the rows into connected blocks of blockSize rows grown
+        /// breadth first, and merge blocks of less than a quarter of that
+        /// into a neighbouring block.
+        void partition(const Matrix& A)
+        {
+            const int n = A.rows();
+            coarse_.assign(n, -1);
+            std::vector<std::vector<int>> blocks;
+            std::vector<int> queue;
+            for (int seed = 0; seed < n; ++seed) {
+                if (coarse_[seed] >= 0) {
+                    continue;
+                }
+                const int block = blocks.size();
+                queue.assign(1, seed);
+                coarse_[seed] = block;
+                for (std::size_t head = 0; head < queue.size() && static_cast<int>(queue.size()) < blockSize_; ++head) {
+                    for (Matrix::InnerIterator it(A, queue[head]); it; ++it) {
+                        const int k = it.col();
+                        if (coarse_[k] < 0 && static_cast<int>(queue.size()) < blockSize_) {
+                            coarse_[k] = block;
+                            queue.push_back(k);
+                        }
+                    }
+                }
+                blocks.push_back(queue);
+            }
+
+            // merge the small blocks, the remainders of the aggregation
+            std::vector<int> renumber(blocks.size(), -1);
+            for (std::size_t b = 0; b < blocks.size(); ++b) {
+                if (4 * static_cast<int>(blocks[b].size()) >= blockSize_ || blocks.size() == 1) {
+                    continue;
+                }
+                int target = -1;
+                for (std::size_t c = 0; c < blocks[b].size() && target < 0; ++c) {
+                    for (Matrix::InnerIterator it(A, blocks[b][c]); it; ++it) {
+                        if (coarse_[it.col()] != static_cast<int>(b)) {
+                            target = coarse_[it.col()];
+                            break;
+                        }
+                    }
+                }
+                if (target >= 0) {
+                    for (const int cell : blocks[b]) {
+                        coarse_[cell] = target;
+                    }
+                    blocks[target].insert(blocks[target].end(), blocks[b].begin(), blocks[b].end());
+                    blocks[b].clear();
+                }
+            }
+            int numBlocks = 0;
+            for (std::size_t b = 0; b < blocks.size(); ++b) {
+                if (!blocks[b].empty()) {
+                    renumber[b] = numBlocks++;
+                }
+            }
+            for (int i = 0; i < n; ++i) {
+                coarse_[i] = renumber[coarse_[i]];
+            }
+        }
+
+        /// The support of a basis function is its block extended by overlap
+        /// layers of neighbouring rows, half the depth of the block, and the
+        /// initial basis function the indicator of the block.
+        void createSupports(const Matrix& A)
+        {
+            const int n = A.rows();
+            int numBlocks = 0;
+            for (const int block : coarse_) {
+                numBlocks = std::max(numBlocks, block + 1);
+            }
+            std::vector<std::vector<int>> blockCells(numBlocks);
+            for (int i = 0; i < n; ++i) {
+                blockCells[coarse_[i]].push_back(i);
+            }
+
+            bases_.assign(numBlocks, Basis());
+            std::vector<int> layer(n, -1);
+            for (int j = 0; j < numBlocks; ++j) {
+                // the breadth first depth of the block from its first row
+                std::vector<int>& cells = bases_[j].cells;
+                cells.assign(1, blockCells[j].front());
+                layer[cells.front()] = 0;
+                int depth = 0;
+                for (std::size_t head = 0; head < cells.size(); ++head) {
+                    for (Matrix::InnerIterator it(A, cells[head]); it; ++it) {
+                        if (coarse_[it.col()] == j && layer[it.col()] < 0) {
+                            layer[it.col()] = layer[cells[head]] + 1;
+                            depth = std::max(depth, layer[it.col()]);
+                            cells.push_back(it.col());
+                        }
+                    }
+                }
+                for (const int cell : cells) {
+                    layer[cell] = 0;
+                }
+
+                // extend the block by the overlap layers
+                const int overlap = std::max(1, depth / 2);
+                for (std::size_t head = 0; head < cells.size(); ++head) {
+                    if (layer[cells[head]] >= overlap) {
+                        continue;
+                    }
+                    for (Matrix::InnerIterator it(A, cells[head]); it; ++it) {
+                        if (layer[it.col()] < 0) {
+                            layer[it.col()] = layer[cells[head]] + 1;
+                            cells.push_back(it.col());
+                        }
+                    }
+                }
+                for (const int cell : cells) {
+                    layer[cell] = -1;
+                }
+
+                Basis& basis = bases_[j];
+                std::sort(basis.cells.begin(), basis.cells.end());
+                basis.values.resize(basis.cells.size());
+                for (std::size_t a = 0; a < basis.cells.size(); ++a) {
+                    basis.values[a] = coarse_[basis.cells[a]] == j ? 1.0 : 0.0;
+                }
+                basis.diagonal.assign(basis.cells.size(), 0.0);
+                basis.boundary.assign(basis.cells.size(), 0);
+                for (std::size_t a = 0; a < basis.cells.size(); ++a) {
+                    for (Matrix::InnerIterator it(A, basis.cells[a]); it; ++it) {
+                        if (!std::binary_search(basis.cells.begin(), basis.cells.end(), static_cast<int>(it.col()))) {
+                            basis.boundary[a] = 1;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        /// The value of a basis function in a row, zero outside the support.
+        static double value(const Basis& basis, const int row)
+        {
+            const auto it = std::lower_bound(basis.cells.begin(), basis.cells.end(), row);
+            if (it == basis.cells.end() || *it != row) {
+                return 0.0;
+            }
+            return basis.values[it - basis.cells.begin()];
+        }
+
+        /// Damped Jacobi iterations on the given basis functions, restricted to
+        /// their supports, each followed by a normalization of the basis
+        /// functions to a partition of unity.
+        void smoothBases(const Matrix& A, std::vector<int> active)
+        {
+            smoothedBases_ = active.size();
+            for (const int j : active) {
+                Basis& basis = bases_[j];
+                for (std::size_t a = 0; a < basis.cells.size(); ++a) {
+                    basis.diagonal[a] = A.coeff(basis.cells[a], basis.cells[a]);
+                }
+            }
+
+            for (int iteration = 0; iteration < iterations_ && !active.empty(); ++iteration) {
+                const int numActive = active.size();
+                std::vector<char> converged(numActive, 0);
+                std::exception_ptr error;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+                for (int b = 0; b < numActive; ++b) {
+                    try {
+                        Basis& basis = bases_[active[b]];
+                        const std::size_t size = basis.cells.size();
+                        std::vector<double> increment(size);
+                        double largest = 0.0;
+                        for (std::size_t a = 0; a < size; ++a) {
+                            // the basis function vanishes beyond the support
+                            if (basis.boundary[a]) {
+                                increment[a] = 0.0;
+                                continue;
+                            }
+                            double product = 0.0;
+                            for (Matrix::InnerIterator it(A, basis.cells[a]); it; ++it) {
+                                product += it.value() * value(basis, it.col());
+                            }
+                            increment[a] = -omega() * product / basis.diagonal[a];
+                            largest = std::max(largest, std::abs(increment[a]));
+                        }
+                        for (std::size_t a = 0; a < size; ++a) {
+                            basis.values[a] += increment[a];
+                        }
+                        converged[b] = largest < tolerance_;
+                    }
+                    catch (...) {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
+                }
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                normalize(A.rows());
+
+                std::vector<int> remaining;
+                for (int b = 0; b < numActive; ++b) {
+                    if (!converged[b]) {
+                        remaining.push_back(active[b]);
+                    }
+                }
+                active.swap(remaining);
+            }
+        }
+
+        /// Scale the basis functions such that they sum to one in each row.
+        void normalize(const int n)
+        {
+            std::vector<double> sum(n, 0.0);
+            for (const Basis& basis : bases_) {
+                for (std::size_t a = 0; a < basis.cells.size(); ++a) {
+                    sum[basis.cells[a]] += basis.values[a];
+                }
+            }
+            for (Basis& basis : bases_) {
+                for (std::size_t a = 0; a < basis.cells.size(); ++a) {
+                    if (sum[basis.cells[a]] > 0.0) {
+                        basis.values[a] /= sum[basis.cells[a]];
+                    }
+                }
+            }
+        }
+
+        /// Assemble the prolongation, the restriction and the coarse matrix
+        /// R A P and factorize it.
+        void createCoarseSystem(const Matrix& A)
+        {
+            typedef Eigen::Triplet<double> Triplet;
+            const int n = A.rows();
+            const int numBlocks = bases_.size();
+            std::vector<Triplet> entries;
+            for (int j = 0; j < numBlocks; ++j) {
+                const Basis& basis = bases_[j];
+                for (std::size_t a = 0; a < basis.cells.size(); ++a) {
+                    if (basis.values[a] != 0.0) {
+                        entries.push_back(Triplet(basis.cells[a], j, basis.values[a]));
+                    }
+                }
+            }
+            P_.resize(n, numBlocks);
+            P_.setFromTriplets(entries.begin(), entries.end());
+
+            entries.clear();
+            for (int i = 0; i < n; ++i) {
+                entries.push_back(Triplet(coarse_[i], i, 1.0));
+            }
+            R_.resize(numBlocks, n);
+            R_.setFromTriplets(entries.begin(), entries.end());
+
+            A_ = A;
+            invDiagonal_ = A_.diagonal().cwiseInverse();
+            const Eigen::SparseMatrix<double> coarse = R_ * (A_ * P_);
+            coarseSolver_.compute(coarse);
+            if (coarseSolver_.info() != Eigen::Success) {
+                OPM_THROW(NumericalProblem, "The coarse system of the multiscale pressure solver is singular");
+            }
+        }
+
+        int blockSize_;
+        int iterations_;
+        double tolerance_;
+        double updateTolerance_;
+        int smoothingSteps_;
+        int smoothedBases_;
+
+        std::vector<int> coarse_;
+        std::vector<Basis> bases_;
+
+        Matrix A_;
+        Vector invDiagonal_;
+        Matrix P_;
+        Matrix R_;
+        Eigen::SparseLU<Eigen::SparseMatrix<double>> coarseSolver_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_MULTISCALEPRESSURESOLVER_HEADER_INCLUDED
@@ -60,6 +60,7 @@ namespace Opm {
         }
         assert(well_perf_start == total_nperf);
         assert(int(well_cells.size()) == total_nperf);
+        well_cells_plan = GatherPlan(well_cells);
 
         // Create all the operator matrices,
         // using the setFromTriplets() method.
@@ -318,6 +319,35 @@ namespace Opm {
 
 
 
+    bool
+    MultisegmentWells::
+    solveSegmentSystem(const Eigen::SparseMatrix<double>& jacobian,
+                       const Vector& residual,
+                       Vector& dx) const
+    {
+        // the outlets in the numbering of all segments
+        std::vector<int> outlet;
+        outlet.reserve(nseg_total_);
+        for (const auto& well : msWells()) {
+            const int offset = outlet.size();
+            for (const int out : well->outletSegment()) {
+                outlet.push_back(out < 0 ? -1 : offset + out);
+            }
+        }
+        assert(int(outlet.size()) == nseg_total_);
+
+        SegmentTreeJacobian tree(outlet, num_phases_ + 1);
+        if (!tree.assemble(jacobian) || !tree.factorize()) {
+            return false;
+        }
+        dx = tree.solve(residual.matrix()).array();
+        return true;
+    }
+
+
+
+
+
     void
     MultisegmentWells::
     computeSegmentPressuresDelta(const double grav)
@@ -43,6 +43,7 @@
 #include <opm/autodiff/VFPProperties.hpp>
 
 #include <opm/autodiff/WellMultiSegment.hpp>
+#include <opm/autodiff/SegmentTreeJacobian.hpp>
 #include <opm/autodiff/WellDensitySegmented.hpp>
 #include <opm/simulators/WellSwitchingLogger.hpp>
 
@@ -72,6 +73,7 @@ namespace Opm {
                 Eigen::SparseMatrix<double> topseg2w;         // top segment -> well
                 AutoDiffMatrix eliminate_topseg;              // change the top segment related to be zero
                 std::vector<int> well_cells;                  // the set of perforated cells
+                GatherPlan well_cells_plan;                   // gathers the perforated cells
                 Vector conn_trans_factors;                         // connection transmissibility factors
                 bool has_multisegment_wells;                  // flag indicating whether there is any muli-segment well
             };
@@ -225,6 +227,16 @@ namespace Opm {
             variableWellStateInitials(const WellState& xw,
                                       std::vector<Vector>& vars0) const;
 
+            /// Solve the linear system of the segment equations with the
+            /// Jacobian jacobian with respect to the segment variables, by
+            /// block elimination along the segment trees of the wells.
+            /// Returns false, and leaves dx unchanged, if the Jacobian
+            /// couples segments of different branches or is singular.
+            bool
+            solveSegmentSystem(const Eigen::SparseMatrix<double>& jacobian,
+                               const Vector& residual,
+                               Vector& dx) const;
+
             template <class SolutionState, class WellState>
             void computeWellConnectionPressures(const SolutionState& state,
                                                 const WellState& xw,
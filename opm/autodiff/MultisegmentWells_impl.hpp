@@ -64,12 +64,11 @@ namespace Opm
             b_perfcells.clear();
             return;
         } else {
-            const std::vector<int>& well_cells = wellOps().well_cells;
             mob_perfcells.resize(num_phases_, ADB::null());
             b_perfcells.resize(num_phases_, ADB::null());
             for (int phase = 0; phase < num_phases_; ++phase) {
-                mob_perfcells[phase] = subset(rq[phase].mob, well_cells);
-                b_perfcells[phase] = subset(rq[phase].b, well_cells);
+                mob_perfcells[phase] = subset(rq[phase].mob, wellOps().well_cells_plan);
+                b_perfcells[phase] = subset(rq[phase].b, wellOps().well_cells_plan);
             }
         }
     }
@@ -174,13 +173,12 @@ namespace Opm
 
         {
             const Vector& Tw = wellOps().conn_trans_factors;
-            const std::vector<int>& well_cells = wellOps().well_cells;
 
             // determining in-flow (towards well-bore) or out-flow (towards reservoir)
             // for mutli-segmented wells and non-segmented wells, the calculation of the drawdown are different.
-            const ADB& p_perfcells = subset(state.pressure, well_cells);
-            const ADB& rs_perfcells = subset(state.rs, well_cells);
-            const ADB& rv_perfcells = subset(state.rv, well_cells);
+            const ADB& p_perfcells = subset(state.pressure, wellOps().well_cells_plan);
+            const ADB& rs_perfcells = subset(state.rs, wellOps().well_cells_plan);
+            const ADB& rv_perfcells = subset(state.rv, wellOps().well_cells_plan);
 
             const ADB& seg_pressures = state.segp;
 
@@ -988,7 +986,7 @@ namespace Opm
         assert(start_segment == xw.numSegments());
 
         // Use cell values for the temperature as the wells don't knows its temperature yet.
-        const ADB perf_temp = subset(state.temperature, well_cells);
+        const ADB perf_temp = subset(state.temperature, wellOps().well_cells_plan);
 
         // Compute b, rsmax, rvmax values for perforations.
         // Evaluate the properties using average well block pressures
@@ -1007,16 +1005,16 @@ namespace Opm
             b.col(pu.phase_pos[BlackoilPhases::Aqua]) = bw;
         }
         assert((*active_)[Oil]);
-        const Vector perf_so =  subset(state.saturation[pu.phase_pos[Oil]].value(), well_cells);
+        const Vector perf_so =  subset(state.saturation[pu.phase_pos[Oil]].value(), wellOps().well_cells_plan);
         if (pu.phase_used[BlackoilPhases::Liquid]) {
-            const ADB perf_rs = subset(state.rs, well_cells);
+            const ADB perf_rs = subset(state.rs, wellOps().well_cells_plan);
             const Vector bo = fluid_->bOil(avg_press_ad, perf_temp, perf_rs, perf_cond, well_cells).value();
             b.col(pu.phase_pos[BlackoilPhases::Liquid]) = bo;
             const Vector rssat = fluid_->rsSat(ADB::constant(avg_press), ADB::constant(perf_so), well_cells).value();
             rsmax_perf.assign(rssat.data(), rssat.data() + nperf_total);
         }
         if (pu.phase_used[BlackoilPhases::Vapour]) {
-            const ADB perf_rv = subset(state.rv, well_cells);
+            const ADB perf_rv = subset(state.rv, wellOps().well_cells_plan);
             const Vector bg = fluid_->bGas(avg_press_ad, perf_temp, perf_rv, perf_cond, well_cells).value();
             b.col(pu.phase_pos[BlackoilPhases::Vapour]) = bg;
             const Vector rvsat = fluid_->rvSat(ADB::constant(avg_press), ADB::constant(perf_so), well_cells).value();
@@ -1065,7 +1063,7 @@ namespace Opm
         std::vector<Vector> perf_kr;
         for(size_t i = 0; i < temp_size; ++i) {
             // const ADB kr_phase_adb = subset(kr_adb[i], well_cells);
-            const Vector kr_phase = (subset(kr_adb[i], well_cells)).value();
+            const Vector kr_phase = (subset(kr_adb[i], wellOps().well_cells_plan)).value();
             perf_kr.push_back(kr_phase);
         }
 
@@ -1090,7 +1088,7 @@ namespace Opm
         for (int phaseIdx = 0; phaseIdx < fluid_->numPhases(); ++phaseIdx) {
             // const int canonicalPhaseIdx = canph_[phaseIdx];
             // const ADB fluid_density = fluidDensity(canonicalPhaseIdx, rq_[phaseIdx].b, state.rs, state.rv);
-            const Vector rho_perf = subset(fluid_density[phaseIdx], well_cells).value();
+            const Vector rho_perf = subset(fluid_density[phaseIdx], wellOps().well_cells_plan).value();
             // TODO: phaseIdx or canonicalPhaseIdx ?
             rho_avg_perf += rho_perf * perf_kr[phaseIdx];
         }
@@ -56,6 +56,7 @@ namespace Opm
     NewtonIterationBlackoilCPR::NewtonIterationBlackoilCPR(const ParameterGroup& param,
                                                            const boost::any& parallelInformation_arg)
       : cpr_param_( param ),
+        ellipticSetup_(),
         iterations_( 0 ),
         parallelInformation_(parallelInformation_arg),
         newton_use_gmres_( param.getDefault("newton_use_gmres", false ) ),
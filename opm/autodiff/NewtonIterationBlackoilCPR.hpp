@@ -49,6 +49,7 @@ namespace Opm
         typedef Dune::FieldMatrix<double, 1, 1> MatrixBlockType;
         typedef Dune::BCRSMatrix <MatrixBlockType>        Mat;
         typedef Dune::BlockVector<VectorBlockType>        Vector;
+        typedef CPREllipticSetup<Mat,Vector>              EllipticSetup;
 
     public:
 
@@ -61,6 +62,8 @@ namespace Opm
         ///                        cpr_ilu_n        (default 0) use ILU(n) for preconditioning of the linear system
         ///                        cpr_use_amg      (default false) if true, use AMG preconditioner for elliptic part
         ///                        cpr_use_bicgstab (default true)  if true, use BiCGStab (else use CG) for elliptic part
+        ///                        cpr_reuse_setup  (default 0) number of linear solves an AMG setup of the elliptic
+        ///                                         part is reused for (sequential runs only)
         /// \param[in] parallelInformation In the case of a parallel run
         ///                               with dune-istl the information about the parallelization.
         NewtonIterationBlackoilCPR(const ParameterGroup& param,
@@ -98,8 +101,10 @@ namespace Opm
             // typedef Dune::SeqILU0<Mat,Vector,Vector> Preconditioner;
            typedef Opm::CPRPreconditioner<Mat,Vector,Vector,P> Preconditioner;
             parallelInformation_arg.copyOwnerToAll(istlb, istlb);
-            Preconditioner precond(cpr_param_, opA.getmat(), istlAe, parallelInformation_arg,
-                                   parallelInformationAe);
+            std::unique_ptr<Preconditioner>
+                precondPtr(createPreconditioner(opA.getmat(), istlAe, parallelInformation_arg,
+                                                parallelInformationAe));
+            Preconditioner& precond = *precondPtr;
 
             // TODO: Revise when linear solvers interface opm-core is done
             // Construct linear solver.
@@ -118,7 +123,41 @@ namespace Opm
             }
         }
 
+        /// \brief create the CPR preconditioner for a parallel run.
+        template<class P>
+        CPRPreconditioner<Mat,Vector,Vector,P>*
+        createPreconditioner(const Mat& A, const Mat& Ae,
+                             const P& parallelInformation_arg,
+                             const P& parallelInformationAe) const
+        {
+            return new CPRPreconditioner<Mat,Vector,Vector,P>(cpr_param_, A, Ae, parallelInformation_arg,
+                                                              parallelInformationAe);
+        }
+
+        /// \brief create the CPR preconditioner for a sequential run.
+        ///
+        /// If requested the AMG setup of the elliptic part is kept and
+        /// reused for several linear solves.
+        CPRPreconditioner<Mat,Vector,Vector>*
+        createPreconditioner(const Mat& A, const Mat& Ae,
+                             const Dune::Amg::SequentialInformation& parallelInformation_arg,
+                             const Dune::Amg::SequentialInformation& parallelInformationAe) const
+        {
+            if ( cpr_param_.cpr_use_amg_ && cpr_param_.cpr_reuse_setup_ > 0 ) {
+                if ( ! ellipticSetup_ ) {
+                    ellipticSetup_.reset(new EllipticSetup());
+                }
+                ellipticSetup_->update(Ae, cpr_param_);
+                return new CPRPreconditioner<Mat,Vector,Vector>(cpr_param_, A, Ae,
+                                                                ellipticSetup_->op(), ellipticSetup_->amg(),
+                                                                parallelInformation_arg, parallelInformationAe);
+            }
+            return new CPRPreconditioner<Mat,Vector,Vector>(cpr_param_, A, Ae, parallelInformation_arg,
+                                                            parallelInformationAe);
+        }
+
         CPRParameter cpr_param_;
+        mutable std::unique_ptr<EllipticSetup> ellipticSetup_;
 
         mutable int iterations_;
         boost::any parallelInformation_;
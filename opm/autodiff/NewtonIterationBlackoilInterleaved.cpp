@@ -48,6 +48,9 @@
 #endif
 #include <opm/common/utility/platform_dependent/reenable_warnings.h>
 
+#include <algorithm>
+#include <vector>
+
 namespace Opm
 {
 
@@ -108,62 +111,27 @@ namespace Opm
         const boost::any& parallelInformation() const { return istlSolver_.parallelInformation(); }
 
     public:
-        void formInterleavedSystem(const std::vector<LinearisedBlackoilResidual::ADB>& eqs,
-                                   Mat& istlA) const
+        /// Fill the interleaved system matrix from the jacobians of eqs.
+        /// The block pattern and the position of every jacobian entry in
+        /// it are kept, and only rebuilt if the pattern of one of the
+        /// jacobians changes, e.g. when wells are opened or shut.
+        Mat& formInterleavedSystem(const std::vector<LinearisedBlackoilResidual::ADB>& eqs) const
         {
             assert( np == int(eqs.size()) );
-            // Find sparsity structure as union of basic block sparsity structures,
-            // corresponding to the jacobians with respect to pressure.
-            // Use our custom PointOneOp to get to the union structure.
-            // As default we only iterate over the pressure derivatives.
-            Eigen::SparseMatrix<double, Eigen::ColMajor> col_major = eqs[0].derivative()[0].getSparse();
-            detail::PointOneOp<double> point_one;
-            for (int phase = 1; phase < np; ++phase) {
-                const AutoDiffMatrix::SparseRep& mat = eqs[phase].derivative()[0].getSparse();
-                col_major = col_major.binaryExpr(mat, point_one);
-            }
-            // For some cases (for instance involving Solvent flow) the reasoning for only adding
-            // the pressure derivatives fails. As getting the sparsity pattern is non-trivial, in terms
-            // of work, the full sparsity pattern is only added when required.
-            if (parameters_.require_full_sparsity_pattern_) {
-                for (int p1 = 0; p1 < np; ++p1) {
-                    for (int p2 = 1; p2 < np; ++p2) { // pressure is already added
-                        const AutoDiffMatrix::SparseRep& mat = eqs[p1].derivative()[p2].getSparse();
-                        col_major = col_major.binaryExpr(mat, point_one);
-                    }
-                }
-            }
-
-            // Automatically convert the column major structure to a row-major structure
-            Eigen::SparseMatrix<double, Eigen::RowMajor> row_major = col_major;
-
-            const int size = row_major.rows();
-            assert(size == row_major.cols());
-
-            {
-                // Create ISTL matrix with interleaved rows and columns (block structured).
-                istlA.setSize(row_major.rows(), row_major.cols(), row_major.nonZeros());
-                istlA.setBuildMode(Mat::row_wise);
-                const int* ia = row_major.outerIndexPtr();
-                const int* ja = row_major.innerIndexPtr();
-                const typename Mat::CreateIterator endrow = istlA.createend();
-                for (typename Mat::CreateIterator row = istlA.createbegin(); row != endrow; ++row) {
-                    const int ri = row.index();
-                    for (int i = ia[ri]; i < ia[ri + 1]; ++i) {
-                        row.insert(ja[i]);
-                    }
+            std::vector<const AutoDiffMatrix::SparseRep*> jacs(np*np);
+            for (int p1 = 0; p1 < np; ++p1) {
+                for (int p2 = 0; p2 < np; ++p2) {
+                    jacs[p1*np + p2] = &eqs[p1].derivative()[p2].getSparse();
                 }
             }
 
-            /*
-            // not neeeded since MatrixBlock initially zeros all elements during construction
-            // Set all blocks to zero.
-            for (auto row = istlA.begin(), rowend = istlA.end(); row != rowend; ++row ) {
-                for (auto col = row->begin(), colend = row->end(); col != colend; ++col ) {
-                    *col = 0.0;
+            if (!samePattern(jacs)) {
+                // Try the structure of the pressure derivatives first, as
+                // the full structure is expensive to get.
+                if (!formPattern(jacs, parameters_.require_full_sparsity_pattern_)) {
+                    formPattern(jacs, true);
                 }
             }
-            */
 
             /**
              * Go through all jacobians, and insert in correct spot
@@ -173,25 +141,30 @@ namespace Opm
              * from all "input matrices" (derivatives).
              *
              * A faster alternative is to instead run through each "input matrix" and
-             * insert its elements in the correct spot in the output matrix.
-             *
+             * insert its elements in the correct spot in the output matrix. Every
+             * entry of a jacobian goes to a different block, so the entries can be
+             * inserted in parallel.
              */
-            for (int p1 = 0; p1 < np; ++p1) {
-                for (int p2 = 0; p2 < np; ++p2) {
-                    // Note that that since these are CSC and not CSR matrices,
-                    // ja contains row numbers instead of column numbers.
-                    const AutoDiffMatrix::SparseRep& s = eqs[p1].derivative()[p2].getSparse();
-                    const int* ia = s.outerIndexPtr();
-                    const int* ja = s.innerIndexPtr();
-                    const double* sa = s.valuePtr();
-                    for (int col = 0; col < size; ++col) {
-                        for (int elem_ix = ia[col]; elem_ix < ia[col + 1]; ++elem_ix) {
-                            const int row = ja[elem_ix];
-                            istlA[row][col][p1][p2] = sa[elem_ix];
+            const int numBlocks = blocks_.size();
+#pragma omp parallel
+            {
+#pragma omp for
+                for (int i = 0; i < numBlocks; ++i) {
+                    *blocks_[i] = 0.0;
+                }
+                for (int p1 = 0; p1 < np; ++p1) {
+                    for (int p2 = 0; p2 < np; ++p2) {
+                        const double* sa = jacs[p1*np + p2]->valuePtr();
+                        const std::vector<int>& target = jacTargets_[p1*np + p2];
+                        const int nnz = target.size();
+#pragma omp for
+                        for (int elem_ix = 0; elem_ix < nnz; ++elem_ix) {
+                            (*blocks_[target[elem_ix]])[p1][p2] = sa[elem_ix];
                         }
                     }
                 }
             }
+            return istlA_;
         }
 
 
@@ -254,8 +227,7 @@ namespace Opm
             assert(pos == size_b);
 
             // Create ISTL matrix with interleaved rows and columns (block structured).
-            Mat istlA;
-            formInterleavedSystem(eqs, istlA);
+            Mat& istlA = formInterleavedSystem(eqs);
 
             // Solve reduced system.
             SolutionVector dx(SolutionVector::Zero(b.size()));
@@ -293,8 +265,123 @@ namespace Opm
         }
 
     protected:
+        // true if the jacobians have the patterns of the last system
+        bool samePattern(const std::vector<const AutoDiffMatrix::SparseRep*>& jacs) const
+        {
+            if (jacPatterns_.size() != jacs.size()) {
+                return false;
+            }
+            for (std::size_t j = 0; j < jacs.size(); ++j) {
+                const AutoDiffMatrix::SparseRep& s = *jacs[j];
+                const std::vector<int>& pattern = jacPatterns_[j];
+                const int cols = s.cols();
+                const int nnz = s.nonZeros();
+                if (!s.isCompressed() || int(pattern.size()) != cols + 1 + nnz
+                    || !std::equal(s.outerIndexPtr(), s.outerIndexPtr() + cols + 1, pattern.begin())
+                    || !std::equal(s.innerIndexPtr(), s.innerIndexPtr() + nnz, pattern.begin() + cols + 1)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Create the block pattern of the system and the position of every
+        // jacobian entry in it. Returns false if the pattern is built from
+        // the pressure derivatives only and misses an entry of another jacobian.
+        bool formPattern(const std::vector<const AutoDiffMatrix::SparseRep*>& jacs,
+                         const bool fullPattern) const
+        {
+            // Find sparsity structure as union of basic block sparsity structures,
+            // corresponding to the jacobians with respect to pressure.
+            // Use our custom PointOneOp to get to the union structure.
+            // As default we only iterate over the pressure derivatives.
+            Eigen::SparseMatrix<double, Eigen::ColMajor> col_major = *jacs[0];
+            detail::PointOneOp<double> point_one;
+            for (int phase = 1; phase < np; ++phase) {
+                col_major = col_major.binaryExpr(*jacs[phase*np], point_one);
+            }
+            // For some cases (for instance involving Solvent flow) the reasoning for only adding
+            // the pressure derivatives fails. As getting the sparsity pattern is non-trivial, in terms
+            // of work, the full sparsity pattern is only added when required.
+            if (fullPattern) {
+                for (int p1 = 0; p1 < np; ++p1) {
+                    for (int p2 = 1; p2 < np; ++p2) { // pressure is already added
+                        col_major = col_major.binaryExpr(*jacs[p1*np + p2], point_one);
+                    }
+                }
+            }
+
+            // Automatically convert the column major structure to a row-major structure
+            Eigen::SparseMatrix<double, Eigen::RowMajor> row_major = col_major;
+
+            const int size = row_major.rows();
+            assert(size == row_major.cols());
+            const int* ia = row_major.outerIndexPtr();
+            const int* ja = row_major.innerIndexPtr();
+
+            // Position of every jacobian entry in the row major pattern.
+            std::vector<std::vector<int> > targets(jacs.size());
+            for (std::size_t j = 0; j < jacs.size(); ++j) {
+                // Note that that since these are CSC and not CSR matrices,
+                // inner contains row numbers instead of column numbers.
+                const AutoDiffMatrix::SparseRep& s = *jacs[j];
+                const int* outer = s.outerIndexPtr();
+                const int* inner = s.innerIndexPtr();
+                targets[j].resize(s.nonZeros());
+                for (int col = 0; col < size; ++col) {
+                    for (int elem_ix = outer[col]; elem_ix < outer[col + 1]; ++elem_ix) {
+                        const int row = inner[elem_ix];
+                        const int* pos = std::lower_bound(ja + ia[row], ja + ia[row + 1], col);
+                        if (pos == ja + ia[row + 1] || *pos != col) {
+                            assert(!fullPattern);
+                            return false;
+                        }
+                        targets[j][elem_ix] = pos - ja;
+                    }
+                }
+            }
+
+            // Create ISTL matrix with interleaved rows and columns (block structured).
+            istlA_ = Mat();
+            istlA_.setSize(row_major.rows(), row_major.cols(), row_major.nonZeros());
+            istlA_.setBuildMode(Mat::row_wise);
+            const typename Mat::CreateIterator endrow = istlA_.createend();
+            for (typename Mat::CreateIterator row = istlA_.createbegin(); row != endrow; ++row) {
+                const int ri = row.index();
+                for (int i = ia[ri]; i < ia[ri + 1]; ++i) {
+                    row.insert(ja[i]);
+                }
+            }
+
+            blocks_.clear();
+            blocks_.reserve(row_major.nonZeros());
+            for (auto row = istlA_.begin(), rowend = istlA_.end(); row != rowend; ++row) {
+                for (auto col = row->begin(), colend = row->end(); col != colend; ++col) {
+                    blocks_.push_back(&*col);
+                }
+            }
+
+            jacTargets_ = std::move(targets);
+            jacPatterns_.resize(jacs.size());
+            for (std::size_t j = 0; j < jacs.size(); ++j) {
+                const AutoDiffMatrix::SparseRep& s = *jacs[j];
+                std::vector<int>& pattern = jacPatterns_[j];
+                pattern.assign(s.outerIndexPtr(), s.outerIndexPtr() + s.cols() + 1);
+                pattern.insert(pattern.end(), s.innerIndexPtr(), s.innerIndexPtr() + s.nonZeros());
+            }
+            return true;
+        }
+
         ISTLSolverType istlSolver_;
         NewtonIterationBlackoilInterleavedParameters parameters_;
+
+        // system matrix of the last solve and its blocks in row major order
+        mutable Mat istlA_;
+        mutable std::vector<MatrixBlockType*> blocks_;
+        // outer and inner indices of the jacobians of the last system
+        mutable std::vector<std::vector<int> > jacPatterns_;
+        // block of every jacobian entry in blocks_
+        mutable std::vector<std::vector<int> > jacTargets_;
     }; // end NewtonIterationBlackoilInterleavedImpl
 
 
@@ -27,9 +27,14 @@
 
 #include <opm/autodiff/NewtonIterationBlackoilInterface.hpp>
 #include <opm/core/utility/parameters/ParameterGroup.hpp>
+#include <opm/common/ErrorMacros.hpp>
 
 #include <array>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace Opm
 {
@@ -38,14 +43,42 @@ namespace Opm
     {
         double linear_solver_reduction_;
         double ilu_relaxation_;
+        double ilu_drop_tolerance_;
+        double amg_alpha_;
+        double amg_smoother_relaxation_;
         int    linear_solver_maxiter_;
         int    linear_solver_restart_;
+        int    linear_solver_recycle_;
         int    linear_solver_verbosity_;
         int    ilu_fillin_level_;
+        int    amg_max_level_;
+        int    amg_coarsen_target_;
+        int    amg_aggregation_dim_;
+        int    amg_pre_smooth_steps_;
+        int    amg_post_smooth_steps_;
+        int    amg_smoother_iterations_;
+        int    subdomain_solver_reuse_;
+        int    linear_solver_fallback_ilu_level_;
+        int    linear_solver_fallback_lu_size_;
         bool   newton_use_gmres_;
+        bool   linear_solver_batched_gmres_;
         bool   require_full_sparsity_pattern_;
         bool   ignoreConvergenceFailure_;
         bool   linear_solver_use_amg_;
+        bool   ilu_level_scheduling_;
+        bool   ilu_reuse_structure_;
+        bool   ilu_single_precision_;
+        bool   ilu_compact_;
+        bool   ilu_reorder_;
+        bool   ilu_coloring_;
+        bool   subdomain_solver_keep_symbolic_;
+        bool   use_cpr_;
+        bool   amg_coarse_accumulate_;
+        bool   amg_report_;
+        std::string amg_smoother_;
+        std::string amg_cycle_;
+        std::string subdomain_solver_;
+        std::vector<std::string> linear_solver_fallback_;
 
         NewtonIterationBlackoilInterleavedParameters() { reset(); }
         // read values from parameter class
@@ -59,12 +92,66 @@ namespace Opm
             linear_solver_reduction_ = param.getDefault("linear_solver_reduction", linear_solver_reduction_ );
             linear_solver_maxiter_   = param.getDefault("linear_solver_maxiter", linear_solver_maxiter_);
             linear_solver_restart_   = param.getDefault("linear_solver_restart", linear_solver_restart_);
+            linear_solver_recycle_   = param.getDefault("linear_solver_recycle", linear_solver_recycle_);
+            linear_solver_batched_gmres_ = param.getDefault("linear_solver_batched_gmres", linear_solver_batched_gmres_);
             linear_solver_verbosity_ = param.getDefault("linear_solver_verbosity", linear_solver_verbosity_);
             require_full_sparsity_pattern_ = param.getDefault("require_full_sparsity_pattern", require_full_sparsity_pattern_);
             ignoreConvergenceFailure_ = param.getDefault("linear_solver_ignoreconvergencefailure", ignoreConvergenceFailure_);
             linear_solver_use_amg_    = param.getDefault("linear_solver_use_amg", linear_solver_use_amg_ );
             ilu_relaxation_           = param.getDefault("ilu_relaxation", ilu_relaxation_ );
             ilu_fillin_level_         = param.getDefault("ilu_fillin_level",  ilu_fillin_level_ );
+            ilu_drop_tolerance_       = param.getDefault("ilu_drop_tolerance", ilu_drop_tolerance_ );
+            ilu_level_scheduling_     = param.getDefault("ilu_level_scheduling", ilu_level_scheduling_ );
+            ilu_reuse_structure_      = param.getDefault("ilu_reuse_structure", ilu_reuse_structure_ );
+            ilu_single_precision_     = param.getDefault("ilu_single_precision", ilu_single_precision_ );
+            ilu_compact_              = param.getDefault("ilu_compact", ilu_compact_ );
+            ilu_reorder_              = param.getDefault("ilu_reorder", ilu_reorder_ );
+            ilu_coloring_             = param.getDefault("ilu_coloring", ilu_coloring_ );
+            use_cpr_                  = param.getDefault("use_cpr", use_cpr_ );
+            amg_max_level_            = param.getDefault("amg_max_level", amg_max_level_ );
+            amg_coarsen_target_       = param.getDefault("amg_coarsen_target", amg_coarsen_target_ );
+            amg_aggregation_dim_      = param.getDefault("amg_aggregation_dim", amg_aggregation_dim_ );
+            amg_alpha_                = param.getDefault("amg_alpha", amg_alpha_ );
+            amg_pre_smooth_steps_     = param.getDefault("amg_pre_smooth_steps", amg_pre_smooth_steps_ );
+            amg_post_smooth_steps_    = param.getDefault("amg_post_smooth_steps", amg_post_smooth_steps_ );
+            amg_smoother_             = param.getDefault("amg_smoother", amg_smoother_ );
+            amg_smoother_iterations_  = param.getDefault("amg_smoother_iterations", amg_smoother_iterations_ );
+            amg_smoother_relaxation_  = param.getDefault("amg_smoother_relaxation", amg_smoother_relaxation_ );
+            amg_cycle_                = param.getDefault("amg_cycle", amg_cycle_ );
+            amg_coarse_accumulate_    = param.getDefault("amg_coarse_accumulate", amg_coarse_accumulate_ );
+            amg_report_               = param.getDefault("amg_report", amg_report_ );
+            subdomain_solver_         = param.getDefault("subdomain_solver", subdomain_solver_ );
+            subdomain_solver_reuse_   = param.getDefault("subdomain_solver_reuse", subdomain_solver_reuse_ );
+            subdomain_solver_keep_symbolic_ = param.getDefault("subdomain_solver_keep_symbolic", subdomain_solver_keep_symbolic_ );
+            linear_solver_fallback_ilu_level_ = param.getDefault("linear_solver_fallback_ilu_level", linear_solver_fallback_ilu_level_ );
+            linear_solver_fallback_lu_size_ = param.getDefault("linear_solver_fallback_lu_size", linear_solver_fallback_lu_size_ );
+            {
+                std::istringstream stages(param.getDefault("linear_solver_fallback", std::string("")));
+                std::string stage;
+                while( std::getline(stages, stage, ',') ) {
+                    if( stage.empty() ) {
+                        continue;
+                    }
+                    if( stage != "cpr" && stage != "iluk" && stage != "lu" ) {
+                        OPM_THROW(std::runtime_error, "Unknown linear_solver_fallback stage " << stage
+                                  << ", use a comma separated list of cpr, iluk and lu");
+                    }
+                    linear_solver_fallback_.push_back(stage);
+                }
+            }
+
+            if( amg_smoother_ != "ilu0" && amg_smoother_ != "jacobi" && amg_smoother_ != "gs" &&
+                amg_smoother_ != "sgs" && amg_smoother_ != "chebyshev" ) {
+                OPM_THROW(std::runtime_error, "Unknown amg_smoother " << amg_smoother_
+                          << ", use one of ilu0, jacobi, gs, sgs and chebyshev");
+            }
+            if( amg_cycle_ != "v" && amg_cycle_ != "w" ) {
+                OPM_THROW(std::runtime_error, "Unknown amg_cycle " << amg_cycle_ << ", use v or w");
+            }
+            if( subdomain_solver_ != "ilu" && subdomain_solver_ != "iluk" && subdomain_solver_ != "lu" ) {
+                OPM_THROW(std::runtime_error, "Unknown subdomain_solver " << subdomain_solver_
+                          << ", use one of ilu, iluk and lu");
+            }
         }
 
         // set default values
@@ -74,12 +161,54 @@ namespace Opm
             linear_solver_reduction_ = 1e-2;
             linear_solver_maxiter_   = 150;
             linear_solver_restart_   = 40;
+            linear_solver_recycle_   = 0;
+            linear_solver_batched_gmres_ = false;
             linear_solver_verbosity_ = 0;
             require_full_sparsity_pattern_ = false;
             ignoreConvergenceFailure_ = false;
             linear_solver_use_amg_    = false;
             ilu_fillin_level_         = 0;
+            // ILUT(ilu_fillin_level, ilu_drop_tolerance) if positive, else ILU(ilu_fillin_level)
+            ilu_drop_tolerance_       = 0.0;
             ilu_relaxation_           = 0.9;
+            ilu_level_scheduling_     = false;
+            ilu_reuse_structure_      = false;
+            ilu_single_precision_     = false;
+            ilu_compact_              = false;
+            ilu_reorder_              = false;
+            // multi-color ILU0, with ilu_level_scheduling one parallel sweep per color
+            ilu_coloring_             = false;
+            use_cpr_                  = false;
+            // aggregation and smoothing of the AMG used if linear_solver_use_amg is true
+            amg_max_level_            = 15;
+            amg_coarsen_target_       = 1200;
+            amg_aggregation_dim_      = 2;
+            amg_alpha_                = 1.0/3.0;
+            amg_pre_smooth_steps_     = 1;
+            amg_post_smooth_steps_    = 1;
+            amg_smoother_             = "ilu0";
+            amg_smoother_iterations_  = 1;
+            amg_smoother_relaxation_  = 1.0;
+            amg_cycle_                = "v";
+            amg_coarse_accumulate_    = false;
+            amg_report_               = false;
+            // ilu:  the ILU of the ilu_* parameters, ILU0 on the subdomains in parallel
+            // iluk: ILU(ilu_fillin_level) on the subdomains, also in parallel
+            // lu:   direct solves on the subdomains with UMFPack or SuperLU
+            // the iluk and lu factorizations are kept for subdomain_solver_reuse further solves
+            subdomain_solver_         = "ilu";
+            subdomain_solver_reuse_   = 0;
+            // a new lu factorization keeps the ordering and symbolic analysis
+            // of the previous one if the sparsity pattern is the same (UMFPack)
+            subdomain_solver_keep_symbolic_ = false;
+            // the solvers tried in turn on the same system if a solve fails:
+            // cpr:  the CPR preconditioner
+            // iluk: ILU(linear_solver_fallback_ilu_level) on the subdomains
+            // lu:   direct subdomain solves, skipped if a process has more than
+            //       linear_solver_fallback_lu_size rows
+            linear_solver_fallback_.clear();
+            linear_solver_fallback_ilu_level_ = 2;
+            linear_solver_fallback_lu_size_ = 100000;
         }
     };
 
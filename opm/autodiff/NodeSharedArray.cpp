@@ -0,0 +1,125 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#include <opm/autodiff/NodeSharedArray.hpp>
+
+#include <vector>
+
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
+#if HAVE_MPI && MPI_VERSION >= 3
+#define OPM_NODESHAREDARRAY_USE_MPI 1
+#endif
+
+namespace Opm
+{
+
+    struct NodeSharedArray::Storage
+    {
+        std::vector<double> local;
+#if OPM_NODESHAREDARRAY_USE_MPI
+        MPI_Comm nodeComm = MPI_COMM_NULL;
+        MPI_Win window = MPI_WIN_NULL;
+#endif
+
+        ~Storage()
+        {
+#if OPM_NODESHAREDARRAY_USE_MPI
+            int finalized = 0;
+            MPI_Finalized(&finalized);
+            if (window != MPI_WIN_NULL && !finalized) {
+                MPI_Win_free(&window);
+                MPI_Comm_free(&nodeComm);
+            }
+#endif
+        }
+    };
+
+
+
+    NodeSharedArray::NodeSharedArray()
+        : storage_(),
+          data_(nullptr),
+          size_(0)
+    {
+    }
+
+
+
+    NodeSharedArray::NodeSharedArray(const std::size_t size, const Fill& fill, const bool shareOnNode)
+        : storage_(std::make_shared<Storage>()),
+          data_(nullptr),
+          size_(size)
+    {
+#if OPM_NODESHAREDARRAY_USE_MPI
+        int initialized = 0;
+        MPI_Initialized(&initialized);
+        int numProcs = 1;
+        if (initialized) {
+            MPI_Comm_size(MPI_COMM_WORLD, &numProcs);
+        }
+        if (shareOnNode && numProcs > 1 && size > 0) {
+            Storage& storage = *storage_;
+            MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &storage.nodeComm);
+            int nodeRank = 0;
+            MPI_Comm_rank(storage.nodeComm, &nodeRank);
+
+            // only the first process of the node allocates memory, the
+            // others attach to its segment
+            const MPI_Aint bytes = (nodeRank == 0) ? static_cast<MPI_Aint>(size*sizeof(double)) : 0;
+            double* base = nullptr;
+            MPI_Win_allocate_shared(bytes, sizeof(double), MPI_INFO_NULL, storage.nodeComm,
+                                    &base, &storage.window);
+            MPI_Aint segmentSize = 0;
+            int dispUnit = 0;
+            MPI_Win_shared_query(storage.window, 0, &segmentSize, &dispUnit, &base);
+
+            MPI_Win_fence(0, storage.window);
+            if (nodeRank == 0) {
+                fill(base);
+            }
+            MPI_Win_fence(0, storage.window);
+
+            data_ = base;
+            return;
+        }
+#else
+        static_cast<void>(shareOnNode);
+#endif
+        storage_->local.resize(size);
+        fill(storage_->local.data());
+        data_ = storage_->local.data();
+    }
+
+
+
+    bool NodeSharedArray::shared() const
+    {
+#if OPM_NODESHAREDARRAY_USE_MPI
+        return storage_ && storage_->window != MPI_WIN_NULL;
+#else
+        return false;
+#endif
+    }
+
+} // namespace Opm
@@ -0,0 +1,71 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_NODESHAREDARRAY_HEADER_INCLUDED
+#define OPM_NODESHAREDARRAY_HEADER_INCLUDED
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace Opm
+{
+
+    /// A read-only array of doubles which can be stored once per compute
+    /// node instead of once per process.
+    ///
+    /// When sharing is requested and MPI (version 3 or later) is running
+    /// with more than one process, the array is allocated in an MPI shared
+    /// memory window of the processes on the same node. It is filled by the
+    /// first process of the node only and read by all of them. Otherwise
+    /// every process holds its own copy. Copies of a NodeSharedArray refer
+    /// to the same storage.
+    ///
+    /// With sharing, construction and destruction are collective: all
+    /// processes must create and release their arrays in the same order.
+    class NodeSharedArray
+    {
+    public:
+        typedef std::function<void(double*)> Fill;
+
+        /// An empty array.
+        NodeSharedArray();
+
+        /// Allocate an array of the given size and let fill() write its
+        /// values.
+        NodeSharedArray(const std::size_t size, const Fill& fill, const bool shareOnNode);
+
+        const double* data() const { return data_; }
+
+        std::size_t size() const { return size_; }
+
+        /// Whether the array lives in memory shared with other processes.
+        bool shared() const;
+
+    private:
+        struct Storage;
+
+        std::shared_ptr<Storage> storage_;
+        const double* data_;
+        std::size_t size_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_NODESHAREDARRAY_HEADER_INCLUDED
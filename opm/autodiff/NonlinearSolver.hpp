@@ -49,6 +49,13 @@ namespace Opm {
             double         relax_rel_tol_;
             int            max_iter_; // max nonlinear iterations
             int            min_iter_; // min nonlinear iterations
+            bool           divergence_check_; // abort diverging time steps early
+            double         divergence_growth_; // growth of the residual over its minimum considered divergence
+            int            divergence_linear_failures_; // number of consecutive linear solver failures considered divergence
+            bool           linear_forcing_; // set the linear solver reduction of each iteration by forcingTerm()
+            double         forcing_gamma_; // scaling of the forcing term
+            double         forcing_alpha_; // exponent of the residual ratio of the forcing term
+            double         forcing_max_; // largest forcing term
 
             explicit SolverParameters( const ParameterGroup& param );
             SolverParameters();
@@ -159,6 +166,30 @@ namespace Opm {
         void detectOscillations(const std::vector<std::vector<double>>& residual_history,
                                 const int it, bool& oscillate, bool& stagnate) const;
 
+        /// Detect a time step that will not converge: the residual grew in
+        /// each of the last two iterations to more than divergenceGrowth()
+        /// times its smallest value, it is not finite, or the linear solver
+        /// failed in the last divergenceLinearFailures() iterations.
+        bool detectDivergence(const std::vector<std::vector<double>>& residual_history,
+                              const int it, const int linear_failures) const;
+
+        /// The inexact Newton forcing term of iteration it, i.e. the relative
+        /// reduction of the linear residual that is sufficient in this
+        /// iteration, by choice 2 of Eisenstat and Walker:
+        ///
+        ///     eta_it = gamma (|F_it| / |F_it-1|)^alpha,
+        ///
+        /// where |F| is the largest residual norm of an iteration. It is not
+        /// smaller than gamma eta_it-1^alpha if that exceeds 0.1, so that it
+        /// does not drop by orders of magnitude in one iteration, and not
+        /// larger than forcingMax(), which is also the term of the first
+        /// iteration.
+        /// \param[in] residual_history  the residual norms of the iterations
+        /// \param[in] it                the current iteration
+        /// \param[in] previous          the forcing term of the previous iteration
+        double forcingTerm(const std::vector<std::vector<double>>& residual_history,
+                           const int it, const double previous) const;
+
         /// Apply a stabilization to dx, depending on dxOld and relaxation parameters.
         /// Implemention for Dune block vectors.
         template <class BVector>
@@ -182,6 +213,21 @@ namespace Opm {
         /// The minimum number of nonlinear iterations allowed.
         int minIter() const              { return param_.min_iter_; }
 
+        /// Whether diverging time steps are aborted early.
+        bool divergenceCheck() const     { return param_.divergence_check_; }
+
+        /// The growth of the residual over its minimum that is considered divergence.
+        double divergenceGrowth() const  { return param_.divergence_growth_; }
+
+        /// The number of consecutive linear solver failures that is considered divergence.
+        int divergenceLinearFailures() const { return param_.divergence_linear_failures_; }
+
+        /// Whether the linear solver reduction is set by forcingTerm().
+        bool linearForcing() const       { return param_.linear_forcing_; }
+
+        /// The largest inexact Newton forcing term.
+        double forcingMax() const        { return param_.forcing_max_; }
+
         /// Set parameters to override those given at construction time.
         void setParameters(const SolverParameters& param) { param_ = param; }
 
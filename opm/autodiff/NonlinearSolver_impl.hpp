@@ -27,6 +27,9 @@
 #include <opm/common/Exceptions.hpp>
 #include <opm/common/ErrorMacros.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 namespace Opm
 {
     template <class PhysicalModel>
@@ -138,7 +141,6 @@ namespace Opm
          ReservoirState& reservoir_state,
          WellState& well_state)
     {
-        ReservoirState init_reservoir_state = reservoir_state;
         SimulatorReport iterReport;
         SimulatorReport report;
         failureReport_ = SimulatorReport();
@@ -159,7 +161,7 @@ namespace Opm
                 // Do the nonlinear step. If we are in a converged state, the
                 // model will usually do an early return without an expensive
                 // solve, unless the minIter() count has not been reached yet.
-                iterReport = model_->nonlinearIteration(iteration, timer, *this, reservoir_state, well_state, init_reservoir_state);
+                iterReport = model_->nonlinearIteration(iteration, timer, *this, reservoir_state, well_state, initial_reservoir_state);
 
                 report += iterReport;
                 report.converged = iterReport.converged;
@@ -203,6 +205,13 @@ namespace Opm
         relax_rel_tol_   = 0.2;
         max_iter_        = 10;
         min_iter_        = 1;
+        divergence_check_ = false;
+        divergence_growth_ = 10.0;
+        divergence_linear_failures_ = 2;
+        linear_forcing_ = false;
+        forcing_gamma_ = 0.9;
+        forcing_alpha_ = 2.0;
+        forcing_max_ = 0.1;
     }
 
     template <class PhysicalModel>
@@ -224,6 +233,13 @@ namespace Opm
         relax_max_   = param.getDefault("relax_max", relax_max_);
         max_iter_    = param.getDefault("max_iter", max_iter_);
         min_iter_    = param.getDefault("min_iter", min_iter_);
+        divergence_check_ = param.getDefault("divergence_check", divergence_check_);
+        divergence_growth_ = param.getDefault("divergence_growth", divergence_growth_);
+        divergence_linear_failures_ = param.getDefault("divergence_linear_failures", divergence_linear_failures_);
+        linear_forcing_ = param.getDefault("linear_forcing", linear_forcing_);
+        forcing_gamma_ = param.getDefault("forcing_gamma", forcing_gamma_);
+        forcing_alpha_ = param.getDefault("forcing_alpha", forcing_alpha_);
+        forcing_max_ = param.getDefault("forcing_max", forcing_max_);
 
         std::string relaxation_type = param.getDefault("relax_type", std::string("dampen"));
         if (relaxation_type == "dampen") {
@@ -272,6 +288,70 @@ namespace Opm
     }
 
 
+    template <class PhysicalModel>
+    bool
+    NonlinearSolver<PhysicalModel>::detectDivergence(const std::vector<std::vector<double>>& residual_history,
+                                                     const int it,
+                                                     const int linear_failures) const
+    {
+        // The residual norms are reduced over all processes, so that all
+        // of them take the same decision.
+        if ( !divergenceCheck() ) {
+            return false;
+        }
+
+        if ( linear_failures >= divergenceLinearFailures() ) {
+            return true;
+        }
+
+        // the largest residual of the phases in every iteration
+        std::vector<double> norms;
+        norms.reserve(it + 1);
+        for (int i = 0; i <= it; ++i) {
+            const std::vector<double>& F = residual_history[i];
+            norms.push_back(F.empty() ? 0.0 : *std::max_element(F.begin(), F.end()));
+        }
+
+        if ( !std::isfinite(norms[it]) ) {
+            return true;
+        }
+        if ( it < 2 ) {
+            return false;
+        }
+
+        const double smallest = *std::min_element(norms.begin(), norms.end());
+        return norms[it] > norms[it - 1] && norms[it - 1] > norms[it - 2]
+            && norms[it] > divergenceGrowth() * smallest;
+    }
+
+
+    template <class PhysicalModel>
+    double
+    NonlinearSolver<PhysicalModel>::forcingTerm(const std::vector<std::vector<double>>& residual_history,
+                                                const int it,
+                                                const double previous) const
+    {
+        if ( it < 1 ) {
+            return forcingMax();
+        }
+
+        const std::vector<double>& F0 = residual_history[it];
+        const std::vector<double>& F1 = residual_history[it - 1];
+        const double norm = F0.empty() ? 0.0 : *std::max_element(F0.begin(), F0.end());
+        const double previousNorm = F1.empty() ? 0.0 : *std::max_element(F1.begin(), F1.end());
+        if ( !(previousNorm > 0.0) || !std::isfinite(norm) ) {
+            return forcingMax();
+        }
+
+        double eta = param_.forcing_gamma_ * std::pow(norm / previousNorm, param_.forcing_alpha_);
+        const double safeguard = param_.forcing_gamma_ * std::pow(previous, param_.forcing_alpha_);
+        if ( safeguard > 0.1 ) {
+            eta = std::max(eta, safeguard);
+        }
+        return std::min(eta, forcingMax());
+    }
+
+
     template <class PhysicalModel>
     template <class BVector>
     void
@@ -0,0 +1,115 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+#include <opm/autodiff/OutputPrecision.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <boost/algorithm/string.hpp>
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace Opm
+{
+
+    OutputPrecision::OutputPrecision()
+    {
+    }
+
+
+    OutputPrecision::OutputPrecision(const std::string& specification)
+    {
+        std::vector<std::string> entries;
+        boost::split(entries, specification, boost::is_any_of(","));
+        for (auto entry : entries) {
+            boost::trim(entry);
+            if (entry.empty()) {
+                continue;
+            }
+            const std::string::size_type equal = entry.find('=');
+            if (equal == std::string::npos || equal == 0 || equal + 1 == entry.size()) {
+                OPM_THROW(std::runtime_error, "Invalid output precision '" << entry << "', expected name=precision");
+            }
+            const std::string name = boost::trim_copy(entry.substr(0, equal));
+            const std::string value = boost::trim_copy(entry.substr(equal + 1));
+            Field field;
+            if (value == "double") {
+                field.type = Double;
+            }
+            else if (value == "float") {
+                field.type = Float;
+            }
+            else {
+                std::size_t end = 0;
+                try {
+                    field.tolerance = std::stod(value, &end);
+                }
+                catch (const std::exception&) {
+                    end = 0;
+                }
+                if (end != value.size() || !(field.tolerance > 0.0)) {
+                    OPM_THROW(std::runtime_error, "Invalid output precision '" << value << "' of " << name
+                              << ", use double, float or a positive tolerance");
+                }
+                field.type = Quantized;
+            }
+            if (name == "*") {
+                default_ = field;
+            }
+            else {
+                fields_[name] = field;
+            }
+        }
+    }
+
+
+    const OutputPrecision::Field& OutputPrecision::field(const std::string& name) const
+    {
+        auto it = fields_.find(name);
+        if (it == fields_.end()) {
+            const std::string::size_type slash = name.find_last_of('/');
+            if (slash != std::string::npos) {
+                it = fields_.find(name.substr(slash + 1));
+            }
+        }
+        return it != fields_.end() ? it->second : default_;
+    }
+
+
+    bool OutputPrecision::quantize(const std::vector<double>& values, const double tolerance,
+                                   std::vector<int>& quantized)
+    {
+        const double scale = 1.0 / step(tolerance);
+        const double limit = std::numeric_limits<int>::max();
+        quantized.resize(values.size());
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            const double q = std::round(values[i] * scale);
+            // also false for NaN
+            if (!(std::abs(q) < limit)) {
+                return false;
+            }
+            quantized[i] = int(q);
+        }
+        return true;
+    }
+
+} // namespace Opm
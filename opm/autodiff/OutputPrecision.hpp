@@ -0,0 +1,87 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef OPM_OUTPUTPRECISION_HEADER_INCLUDED
+#define OPM_OUTPUTPRECISION_HEADER_INCLUDED
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    /// The precision of the output fields, given by a specification of
+    /// comma separated entries name=precision, where precision is
+    ///
+    ///  - double:    the values as they are,
+    ///  - float:     the values converted to single precision,
+    ///  - a number:  the values quantized to integers with the number as
+    ///               the largest absolute error, i.e. with a step of twice
+    ///               the number, e.g. SWAT=1e-4.
+    ///
+    /// A name is matched against the full name of a field, e.g. cells/SWAT,
+    /// and then against its last component, SWAT. The name * gives the
+    /// precision of the fields not named otherwise, double by default.
+    /// Quantized integers compress much better than floating point values,
+    /// which is meant for saturations and ratios, whose range is known.
+    class OutputPrecision
+    {
+    public:
+        enum Type { Double = 0, Float, Quantized };
+
+        /// The precision of a field.
+        struct Field
+        {
+            Type type = Double;
+            double tolerance = 0.0;
+        };
+
+        /// All fields in double precision.
+        OutputPrecision();
+
+        /// Parse a specification, throws std::runtime_error if it is
+        /// malformed.
+        explicit OutputPrecision(const std::string& specification);
+
+        /// The precision of the field name.
+        const Field& field(const std::string& name) const;
+
+        /// The step of the quantization with the largest absolute error
+        /// tolerance.
+        static double step(const double tolerance)
+        {
+            return 2.0 * tolerance;
+        }
+
+        /// Quantize values to round(value / step(tolerance)). Returns false
+        /// if a value is not finite or its quantized value does not fit an
+        /// int.
+        static bool quantize(const std::vector<double>& values, const double tolerance,
+                             std::vector<int>& quantized);
+
+    private:
+        std::map<std::string, Field> fields_;
+        Field default_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_OUTPUTPRECISION_HEADER_INCLUDED
@@ -0,0 +1,196 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <opm/autodiff/OutputShard.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace Opm
+{
+
+    namespace
+    {
+        const char magic[8] = { 'O', 'P', 'M', 'S', 'H', 'A', 'R', 'D' };
+        const std::uint64_t version = 1;
+
+        void writeWord(std::ofstream& file, const std::uint64_t value)
+        {
+            file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        std::uint64_t readWord(std::ifstream& file)
+        {
+            std::uint64_t value = 0;
+            file.read(reinterpret_cast<char*>(&value), sizeof(value));
+            return value;
+        }
+    } // anonymous namespace
+
+
+    std::string OutputShard::filename(const std::string& outputDir, const std::string& baseName,
+                                      const int rank, const int reportStep)
+    {
+        std::ostringstream name;
+        name << outputDir << "/" << baseName << ".SHARD"
+             << std::setw(4) << std::setfill('0') << reportStep << "."
+             << std::setw(5) << std::setfill('0') << rank;
+        return name.str();
+    }
+
+
+    void OutputShard::write(const std::string& filename, const OutputShard& shard)
+    {
+        std::ofstream file(filename.c_str(), std::ios::binary);
+        if (!file) {
+            OPM_THROW(std::runtime_error, "Could not open output shard " << filename);
+        }
+
+        file.write(magic, sizeof(magic));
+        writeWord(file, version);
+        writeWord(file, shard.reportStep);
+        file.write(reinterpret_cast<const char*>(&shard.time), sizeof(shard.time));
+        writeWord(file, shard.globalCell.size());
+        file.write(reinterpret_cast<const char*>(shard.globalCell.data()),
+                   shard.globalCell.size() * sizeof(int));
+
+        writeWord(file, shard.fields.size());
+        for (const auto& field : shard.fields) {
+            const std::string& name = field.first;
+            writeWord(file, name.size());
+            writeWord(file, field.second.size());
+            file.write(name.data(), name.size());
+            file.write(reinterpret_cast<const char*>(field.second.data()),
+                       field.second.size() * sizeof(double));
+        }
+
+        if (!file) {
+            OPM_THROW(std::runtime_error, "Could not write output shard " << filename);
+        }
+    }
+
+
+    OutputShard OutputShard::read(const std::string& filename)
+    {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        char fileMagic[sizeof(magic)];
+        if (!file.read(fileMagic, sizeof(fileMagic)) ||
+            std::memcmp(fileMagic, magic, sizeof(magic)) != 0 ||
+            readWord(file) != version) {
+            OPM_THROW(std::runtime_error, "Could not read output shard " << filename);
+        }
+
+        OutputShard shard;
+        shard.reportStep = readWord(file);
+        file.read(reinterpret_cast<char*>(&shard.time), sizeof(shard.time));
+        shard.globalCell.resize(readWord(file));
+        file.read(reinterpret_cast<char*>(shard.globalCell.data()),
+                  shard.globalCell.size() * sizeof(int));
+
+        const std::uint64_t numFields = readWord(file);
+        for (std::uint64_t f = 0; f < numFields && file; ++f) {
+            std::string name(readWord(file), ' ');
+            std::vector<double> values(readWord(file));
+            file.read(&name[0], name.size());
+            file.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(double));
+            shard.fields[name] = std::move(values);
+        }
+
+        if (!file) {
+            OPM_THROW(std::runtime_error, "Output shard " << filename << " is truncated");
+        }
+        return shard;
+    }
+
+
+    OutputShard::Fields OutputShard::merge(const std::vector<OutputShard>& shards,
+                                           const std::vector<int>& globalCell)
+    {
+        Fields fields;
+        if (shards.empty()) {
+            return fields;
+        }
+
+        std::unordered_map<int, int> position;
+        position.reserve(globalCell.size());
+        for (std::size_t i = 0; i < globalCell.size(); ++i) {
+            position[globalCell[i]] = i;
+        }
+
+        // the strides of the fields, from the first shard with cells
+        std::map<std::string, std::size_t> strides;
+        for (const auto& shard : shards) {
+            if (!shard.globalCell.empty()) {
+                for (const auto& field : shard.fields) {
+                    strides[field.first] = field.second.size() / shard.globalCell.size();
+                }
+                break;
+            }
+        }
+        for (const auto& stride : strides) {
+            fields[stride.first].assign(globalCell.size() * stride.second, 0.0);
+        }
+
+        std::vector<char> covered(globalCell.size(), false);
+        for (const auto& shard : shards) {
+            const std::size_t numCells = shard.globalCell.size();
+            if (shard.fields.size() != fields.size() && numCells > 0) {
+                OPM_THROW(std::runtime_error, "Output shards of step " << shard.reportStep
+                          << " do not have the same fields");
+            }
+            for (std::size_t cell = 0; cell < numCells; ++cell) {
+                const auto pos = position.find(shard.globalCell[cell]);
+                if (pos == position.end() || covered[pos->second]) {
+                    OPM_THROW(std::runtime_error, "Output shards of step " << shard.reportStep
+                              << " do not match the grid at cell " << shard.globalCell[cell]);
+                }
+                covered[pos->second] = true;
+            }
+            for (const auto& field : shard.fields) {
+                const auto stride = strides.find(field.first);
+                if (stride == strides.end() || field.second.size() != numCells * stride->second) {
+                    OPM_THROW(std::runtime_error, "Output shards of step " << shard.reportStep
+                              << " do not match for field " << field.first);
+                }
+                std::vector<double>& values = fields[field.first];
+                const std::size_t s = stride->second;
+                for (std::size_t cell = 0; cell < numCells; ++cell) {
+                    const std::size_t global = position[shard.globalCell[cell]];
+                    for (std::size_t c = 0; c < s; ++c) {
+                        values[global * s + c] = field.second[cell * s + c];
+                    }
+                }
+            }
+        }
+
+        for (std::size_t i = 0; i < covered.size(); ++i) {
+            if (!covered[i]) {
+                OPM_THROW(std::runtime_error, "Output shards do not cover cell " << globalCell[i]);
+            }
+        }
+        return fields;
+    }
+
+} // namespace Opm
@@ -0,0 +1,74 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_OUTPUTSHARD_HEADER_INCLUDED
+#define OPM_OUTPUTSHARD_HEADER_INCLUDED
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    /// The cell data of one report step owned by one process of a
+    /// parallel run.
+    ///
+    /// With distributed output every process writes the cells it owns to
+    /// its own shard file, such that no process holds the arrays of the
+    /// global grid. The shards of a step are merged into the global
+    /// arrays afterwards by merge(). The data is stored in the native
+    /// byte order.
+    struct OutputShard
+    {
+        typedef std::map<std::string, std::vector<double> > Fields;
+
+        int reportStep = 0;
+        double time = 0.0;
+
+        /// Global (cartesian) index of each cell of the shard.
+        std::vector<int> globalCell;
+
+        /// The fields by name, with the components of a cell stored
+        /// contiguously, i.e. the values of cell i of a field with stride
+        /// components are entries [i*stride, (i+1)*stride).
+        Fields fields;
+
+        /// Name of the shard file of a process and report step.
+        static std::string filename(const std::string& outputDir, const std::string& baseName,
+                                    const int rank, const int reportStep);
+
+        /// Write a shard, throws std::runtime_error on failure.
+        static void write(const std::string& filename, const OutputShard& shard);
+
+        /// Read a shard, throws std::runtime_error if the file cannot be
+        /// read or is not a shard.
+        static OutputShard read(const std::string& filename);
+
+        /// Assemble the fields of the shards of a step in the order of the
+        /// cells of the global grid, given by their global (cartesian)
+        /// index. Throws std::runtime_error if the shards do not cover
+        /// the grid or their fields do not match.
+        static Fields merge(const std::vector<OutputShard>& shards,
+                            const std::vector<int>& globalCell);
+    };
+
+} // namespace Opm
+
+#endif // OPM_OUTPUTSHARD_HEADER_INCLUDED
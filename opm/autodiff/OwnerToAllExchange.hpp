@@ -0,0 +1,187 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_OWNERTOALLEXCHANGE_HEADER_INCLUDED
+#define OPM_OWNERTOALLEXCHANGE_HEADER_INCLUDED
+
+#if HAVE_MPI
+#include <mpi.h>
+#include <dune/common/enumset.hh>
+#include <dune/common/parallel/interface.hh>
+#include <dune/istl/owneroverlapcopy.hh>
+#endif
+
+#include <opm/autodiff/LocalIndex.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Split-phase version of copyOwnerToAll of a parallel information
+    /// object: begin() starts the exchange of the values of the owned rows,
+    /// end() waits for it and overwrites the rows received from the other
+    /// processes. In between, the rows for which received() is false may
+    /// be used and the vector may be modified.
+    ///
+    /// This generic version does the whole exchange in end(), every row is
+    /// considered received.
+    template <class ParallelInfo>
+    class OwnerToAllExchange
+    {
+    public:
+        explicit OwnerToAllExchange(const ParallelInfo& info)
+            : info_(info)
+        {
+        }
+
+        template <class Vector>
+        void begin(const Vector&)
+        {
+        }
+
+        template <class Vector>
+        void end(Vector& v)
+        {
+            info_.copyOwnerToAll(v, v);
+        }
+
+        bool received(const std::size_t) const
+        {
+            return true;
+        }
+
+    private:
+        const ParallelInfo& info_;
+    };
+
+
+
+#if HAVE_MPI
+    /// Non-blocking exchange of the rows owned by this process with the
+    /// processes which hold copies of them.
+    template <class GlobalIdType, class LocalIdType>
+    class OwnerToAllExchange< Dune::OwnerOverlapCopyCommunication<GlobalIdType, LocalIdType> >
+    {
+        typedef Dune::OwnerOverlapCopyCommunication<GlobalIdType, LocalIdType> ParallelInfo;
+        typedef Dune::OwnerOverlapCopyAttributeSet::AttributeSet AttributeSet;
+        typedef Dune::EnumItem<AttributeSet, Dune::OwnerOverlapCopyAttributeSet::owner> OwnerSet;
+        typedef Dune::AllSet<AttributeSet> AllSet;
+
+        struct Neighbour
+        {
+            int rank;
+            std::vector<LocalIndex> sendRows;
+            std::vector<LocalIndex> receiveRows;
+            std::vector<double> sendBuffer;
+            std::vector<double> receiveBuffer;
+        };
+
+    public:
+        explicit OwnerToAllExchange(const ParallelInfo& info)
+            : comm_(info.communicator())
+        {
+            // the same interface as the one of copyOwnerToAll
+            Dune::Interface interface(comm_);
+            interface.build(info.remoteIndices(), OwnerSet(), AllSet());
+            for (const auto& entry : interface.interfaces()) {
+                Neighbour neighbour;
+                neighbour.rank = entry.first;
+                const auto& send = entry.second.first;
+                for (std::size_t i = 0; i < send.size(); ++i) {
+                    neighbour.sendRows.push_back(send[i]);
+                }
+                const auto& receive = entry.second.second;
+                for (std::size_t i = 0; i < receive.size(); ++i) {
+                    const std::size_t row = receive[i];
+                    neighbour.receiveRows.push_back(row);
+                    if (row >= received_.size()) {
+                        received_.resize(row + 1, false);
+                    }
+                    received_[row] = true;
+                }
+                neighbours_.push_back(neighbour);
+            }
+            requests_.reserve(2 * neighbours_.size());
+        }
+
+        template <class Vector>
+        void begin(const Vector& v)
+        {
+            const int blockSize = Vector::block_type::dimension;
+            requests_.clear();
+            for (Neighbour& neighbour : neighbours_) {
+                neighbour.receiveBuffer.resize(neighbour.receiveRows.size() * blockSize);
+                if (!neighbour.receiveBuffer.empty()) {
+                    requests_.push_back(MPI_Request());
+                    MPI_Irecv(neighbour.receiveBuffer.data(), neighbour.receiveBuffer.size(), MPI_DOUBLE,
+                              neighbour.rank, messageTag, comm_, &requests_.back());
+                }
+            }
+            for (Neighbour& neighbour : neighbours_) {
+                neighbour.sendBuffer.resize(neighbour.sendRows.size() * blockSize);
+                std::size_t pos = 0;
+                for (const LocalIndex row : neighbour.sendRows) {
+                    for (int k = 0; k < blockSize; ++k, ++pos) {
+                        neighbour.sendBuffer[pos] = v[row][k];
+                    }
+                }
+                if (!neighbour.sendBuffer.empty()) {
+                    requests_.push_back(MPI_Request());
+                    MPI_Isend(neighbour.sendBuffer.data(), neighbour.sendBuffer.size(), MPI_DOUBLE,
+                              neighbour.rank, messageTag, comm_, &requests_.back());
+                }
+            }
+        }
+
+        template <class Vector>
+        void end(Vector& v)
+        {
+            const int blockSize = Vector::block_type::dimension;
+            MPI_Waitall(requests_.size(), requests_.data(), MPI_STATUSES_IGNORE);
+            for (const Neighbour& neighbour : neighbours_) {
+                std::size_t pos = 0;
+                for (const LocalIndex row : neighbour.receiveRows) {
+                    for (int k = 0; k < blockSize; ++k, ++pos) {
+                        v[row][k] = neighbour.receiveBuffer[pos];
+                    }
+                }
+            }
+        }
+
+        /// True if row is overwritten by end().
+        bool received(const std::size_t row) const
+        {
+            return row < received_.size() && received_[row];
+        }
+
+    private:
+        static const int messageTag = 4711;
+
+        MPI_Comm comm_;
+        std::vector<Neighbour> neighbours_;
+        std::vector<bool> received_;
+        std::vector<MPI_Request> requests_;
+    };
+#endif
+
+} // namespace Opm
+
+#endif // OPM_OWNERTOALLEXCHANGE_HEADER_INCLUDED
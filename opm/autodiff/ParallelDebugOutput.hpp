@@ -19,7 +19,10 @@
 #ifndef OPM_PARALLELDEBUGOUTPUT_HEADER_INCLUDED
 #define OPM_PARALLELDEBUGOUTPUT_HEADER_INCLUDED
 
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <opm/common/data/SimulationDataContainer.hpp>
 
@@ -66,6 +69,13 @@ namespace Opm
         virtual bool isParallel() const = 0;
         virtual int numCells() const = 0 ;
         virtual const int* globalCell() const = 0;
+
+        //! \brief the rank of this process
+        virtual int rank() const = 0;
+        //! \brief the local index of the cells owned by this process
+        virtual const std::vector<int>& ownedCells() const = 0;
+        //! \brief the global (cartesian) index of the cells owned by this process
+        virtual const std::vector<int>& ownedGlobalCell() const = 0;
     };
 
     template <class GridImpl>
@@ -78,12 +88,26 @@ namespace Opm
         const WellStateFullyImplicitBlackoil* wellState_;
         const data::Solution*                 globalCellData_;
 
+        std::vector<int>                      ownedCells_;
+        std::vector<int>                      ownedGlobalCell_;
+
     public:
         ParallelDebugOutput ( const GridImpl& grid,
                               const EclipseState& /* eclipseState */,
                               const int,
                               const Opm::PhaseUsage& )
-            : grid_( grid ) {}
+            : grid_( grid )
+        {
+            const int nc = Opm::AutoDiffGrid::numCells(grid_);
+            const int* gc = Opm::AutoDiffGrid::globalCell(grid_);
+            ownedCells_.resize( nc );
+            ownedGlobalCell_.resize( nc );
+            for( int cell = 0; cell < nc; ++cell )
+            {
+                ownedCells_[ cell ] = cell;
+                ownedGlobalCell_[ cell ] = gc ? gc[ cell ] : cell;
+            }
+        }
 
         // gather solution to rank 0 for EclipseWriter
         virtual bool collectToIORank( const SimulationDataContainer& localReservoirState,
@@ -107,6 +131,9 @@ namespace Opm
         virtual bool isParallel () const { return false; }
         virtual int numCells() const { return Opm::AutoDiffGrid::numCells(grid_); }
         virtual const int* globalCell() const { return Opm::AutoDiffGrid::globalCell(grid_); }
+        virtual int rank() const { return 0; }
+        virtual const std::vector<int>& ownedCells() const { return ownedCells_; }
+        virtual const std::vector<int>& ownedGlobalCell() const { return ownedGlobalCell_; }
     };
 
 #if HAVE_OPM_GRID
@@ -239,6 +266,204 @@ namespace Opm
             }
         };
 
+#if HAVE_MPI
+        // Gather of the cell data of all processes to the I/O rank with
+        // persistent requests. The partition does not change during a run
+        // and the fields only rarely, so the positions of the cells of
+        // every process in the global state are computed once, and the
+        // buffers and requests are set up once per set of fields and are
+        // started again at every output step.
+        class CellDataGather
+        {
+        public:
+            // name and number of values per cell of the gathered fields
+            typedef std::vector< std::pair< std::string, std::size_t > > Layout;
+
+            // collective, computes the positions of the cells of all processes
+            CellDataGather( MPI_Comm comm,
+                            const int rootRank,
+                            const IndexMapType& localIndexMap,
+                            const IndexMapType& ownedGlobalCell,
+                            const IndexMapType& globalIndex )
+              : comm_( comm ),
+                rootRank_( rootRank ),
+                localIndexMap_( localIndexMap )
+            {
+                MPI_Comm_rank( comm_, &rank_ );
+                int size = 0;
+                MPI_Comm_size( comm_, &size );
+
+                int numOwned = localIndexMap_.size();
+                std::vector< int > counts( rank_ == rootRank_ ? size : 0 );
+                MPI_Gather( &numOwned, 1, MPI_INT, counts.data(), 1, MPI_INT, rootRank_, comm_ );
+
+                std::vector< int > displs( counts.size() + 1, 0 );
+                for( std::size_t r = 0; r < counts.size(); ++r ) {
+                    displs[ r + 1 ] = displs[ r ] + counts[ r ];
+                }
+                std::vector< int > ids( displs.back() );
+                MPI_Gatherv( const_cast< int* >( ownedGlobalCell.data() ), numOwned, MPI_INT,
+                             ids.data(), counts.data(), displs.data(), MPI_INT, rootRank_, comm_ );
+
+                if( rank_ == rootRank_ )
+                {
+                    std::unordered_map< int, int > globalPosition;
+                    globalPosition.reserve( globalIndex.size() );
+                    for( std::size_t index = 0; index < globalIndex.size(); ++index ) {
+                        globalPosition[ globalIndex[ index ] ] = index;
+                    }
+                    positions_.resize( size );
+                    for( int r = 0; r < size; ++r )
+                    {
+                        positions_[ r ].resize( counts[ r ] );
+                        for( int i = 0; i < counts[ r ]; ++i )
+                        {
+                            const auto pos = globalPosition.find( ids[ displs[ r ] + i ] );
+                            assert( pos != globalPosition.end() );
+                            positions_[ r ][ i ] = pos->second;
+                        }
+                    }
+                }
+            }
+
+            ~CellDataGather()
+            {
+                freeRequests();
+            }
+
+            // collective, gathers the fields of localCellData into the
+            // fields of globalCellData on the I/O rank, which need to
+            // be registered with the size of the global state
+            void gather( const data::Solution& localCellData,
+                         const std::size_t numLocalCells,
+                         data::Solution& globalCellData )
+            {
+                Layout layout;
+                for( const auto& pair : localCellData ) {
+                    layout.emplace_back( pair.first, numLocalCells > 0 ? pair.second.data.size() / numLocalCells : 0 );
+                }
+                // all processes have to agree on a new setup
+                int changed = ( layout != layout_ || requests_.empty() );
+                MPI_Allreduce( MPI_IN_PLACE, &changed, 1, MPI_INT, MPI_MAX, comm_ );
+                if( changed ) {
+                    setup( layout );
+                }
+
+                if( rank_ == rootRank_ )
+                {
+                    MPI_Startall( requests_.size(), requests_.data() );
+                    // the own cells are copied while the messages arrive
+                    pack( localCellData, ownBuffer_ );
+                    unpack( ownBuffer_, positions_[ rank_ ], globalCellData );
+                    MPI_Waitall( requests_.size(), requests_.data(), MPI_STATUSES_IGNORE );
+                    for( std::size_t r = 0; r < positions_.size(); ++r ) {
+                        if( int(r) != rank_ ) {
+                            unpack( buffers_[ r ], positions_[ r ], globalCellData );
+                        }
+                    }
+                }
+                else
+                {
+                    pack( localCellData, ownBuffer_ );
+                    MPI_Startall( requests_.size(), requests_.data() );
+                    MPI_Waitall( requests_.size(), requests_.data(), MPI_STATUSES_IGNORE );
+                }
+            }
+
+        protected:
+            enum { cellDataTag = 3141 };
+
+            void setup( const Layout& layout )
+            {
+                freeRequests();
+                layout_ = layout;
+                std::size_t valuesPerCell = 0;
+                for( const auto& field : layout_ ) {
+                    valuesPerCell += field.second;
+                }
+
+                ownBuffer_.resize( localIndexMap_.size() * valuesPerCell );
+                if( rank_ == rootRank_ )
+                {
+                    buffers_.resize( positions_.size() );
+                    for( std::size_t r = 0; r < positions_.size(); ++r )
+                    {
+                        if( int(r) == rank_ ) {
+                            continue;
+                        }
+                        buffers_[ r ].resize( positions_[ r ].size() * valuesPerCell );
+                        requests_.emplace_back();
+                        MPI_Recv_init( buffers_[ r ].data(), buffers_[ r ].size(), MPI_DOUBLE,
+                                       r, cellDataTag, comm_, &requests_.back() );
+                    }
+                }
+                else
+                {
+                    requests_.emplace_back();
+                    MPI_Send_init( ownBuffer_.data(), ownBuffer_.size(), MPI_DOUBLE,
+                                   rootRank_, cellDataTag, comm_, &requests_.back() );
+                }
+            }
+
+            void freeRequests()
+            {
+                int finalized = 0;
+                MPI_Finalized( &finalized );
+                if( ! finalized ) {
+                    for( auto& request : requests_ ) {
+                        MPI_Request_free( &request );
+                    }
+                }
+                requests_.clear();
+            }
+
+            // the values of the owned cells, field by field in the order of the layout
+            void pack( const data::Solution& localCellData, std::vector< double >& buffer ) const
+            {
+                std::size_t k = 0;
+                for( const auto& field : layout_ )
+                {
+                    const auto& data = localCellData.at( field.first ).data;
+                    const std::size_t stride = field.second;
+                    for( const int cell : localIndexMap_ ) {
+                        for( std::size_t c = 0; c < stride; ++c ) {
+                            buffer[ k++ ] = data[ cell * stride + c ];
+                        }
+                    }
+                }
+                assert( k == buffer.size() );
+            }
+
+            void unpack( const std::vector< double >& buffer, const IndexMapType& positions,
+                         data::Solution& globalCellData ) const
+            {
+                std::size_t k = 0;
+                for( const auto& field : layout_ )
+                {
+                    auto& data = globalCellData.data( field.first );
+                    const std::size_t stride = field.second;
+                    for( const int pos : positions ) {
+                        for( std::size_t c = 0; c < stride; ++c ) {
+                            data[ pos * stride + c ] = buffer[ k++ ];
+                        }
+                    }
+                }
+                assert( k == buffer.size() );
+            }
+
+            MPI_Comm comm_;
+            const int rootRank_;
+            int rank_;
+            const IndexMapType& localIndexMap_;
+            // the positions of the cells of every process in the global state
+            IndexMapStorageType positions_;
+            Layout layout_;
+            std::vector< double > ownBuffer_;
+            std::vector< std::vector< double > > buffers_;
+            std::vector< MPI_Request > requests_;
+        };
+#endif // HAVE_MPI
+
         enum { ioRank = 0 };
 
         /// \brief Constructor
@@ -254,6 +479,7 @@ namespace Opm
               eclipseState_( eclipseState ),
               globalCellData_(new data::Solution),
               isIORank_(true),
+              rank_(0),
               phaseUsage_(phaseUsage)
 
         {
@@ -266,7 +492,8 @@ namespace Opm
                 std::set< int > send, recv;
                 distributed_grid.switchToDistributedView();
                 toIORankComm_ = distributed_grid.comm();
-                isIORank_ = (distributed_grid.comm().rank() == ioRank);
+                rank_ = distributed_grid.comm().rank();
+                isIORank_ = (rank_ == ioRank);
 
                 // the I/O rank receives from all other ranks
                 if( isIORank() )
@@ -322,6 +549,13 @@ namespace Opm
                     }
                 }
 
+                ownedGlobalCell_.clear();
+                ownedGlobalCell_.reserve( localIndexMap_.size() );
+                for( const int cell : localIndexMap_ )
+                {
+                    ownedGlobalCell_.push_back( distributed_grid.globalCell()[ cell ] );
+                }
+
                 // insert send and recv linkage to communicator
                 toIORankComm_.insertRequest( send, recv );
 
@@ -335,11 +569,22 @@ namespace Opm
                 // distribute global id's to io rank for later association of dof's
                 DistributeIndexMapping distIndexMapping( globalIndex_, distributed_grid.globalCell(), localIndexMap_, indexMaps_ );
                 toIORankComm_.exchange( distIndexMapping );
+
+#if HAVE_MPI
+                cellDataGather_.reset( new CellDataGather( distributed_grid.comm(), ioRank, localIndexMap_,
+                                                           ownedGlobalCell_, globalIndex_ ) );
+#endif
             }
             else // serial run
             {
                 // copy global cartesian index
                 globalIndex_ = distributed_grid.globalCell();
+                localIndexMap_.resize( globalIndex_.size() );
+                for( std::size_t cell = 0; cell < globalIndex_.size(); ++cell )
+                {
+                    localIndexMap_[ cell ] = cell;
+                }
+                ownedGlobalCell_ = globalIndex_;
             }
         }
 
@@ -353,6 +598,8 @@ namespace Opm
             WellStateFullyImplicitBlackoil& globalWellState_;
             const IndexMapType& localIndexMap_;
             const IndexMapStorageType& indexMaps_;
+            // false if the cell data is gathered separately
+            const bool withCellData_;
 
         public:
             PackUnPackSimulationDataContainer( const SimulationDataContainer& localState,
@@ -363,7 +610,8 @@ namespace Opm
                                                WellStateFullyImplicitBlackoil& globalWellState,
                                                const IndexMapType& localIndexMap,
                                                const IndexMapStorageType& indexMaps,
-                                               const bool isIORank )
+                                               const bool isIORank,
+                                               const bool withCellData = true )
             : localState_( localState ),
               globalState_( globalState ),
               localCellData_( localCellData ),
@@ -371,7 +619,8 @@ namespace Opm
               localWellState_( localWellState ),
               globalWellState_( globalWellState ),
               localIndexMap_( localIndexMap ),
-              indexMaps_( indexMaps )
+              indexMaps_( indexMaps ),
+              withCellData_( withCellData )
             {
                 if( isIORank )
                 {
@@ -412,6 +661,9 @@ namespace Opm
 
                 // write all cell data registered in local state
                 for (const auto& pair : localCellData_) {
+                    if( ! withCellData_ ) {
+                        break;
+                    }
                     const auto& data = pair.second.data;
                     const size_t stride = data.size()/localState_.numCells();
 
@@ -432,6 +684,9 @@ namespace Opm
                 // we loop over the data of the local state as
                 // its order governs the order the data got received.
                 for (auto& pair : localCellData_) {
+                    if( ! withCellData_ ) {
+                        break;
+                    }
                     const std::string& key = pair.first;
 
                     auto& data = globalCellData_.data(key);
@@ -649,14 +904,25 @@ namespace Opm
                 globalCellData_->clear();
             }
 
+#if HAVE_MPI
+            // the cell data is gathered with the persistent requests
+            const bool withCellData = ! cellDataGather_;
+#else
+            const bool withCellData = true;
+#endif
             PackUnPackSimulationDataContainer packUnpack( localReservoirState, *globalReservoirState_,
                                                           localCellData, *globalCellData_,
                                                           localWellState, globalWellState_,
                                                           localIndexMap_, indexMaps_,
-                                                          isIORank() );
+                                                          isIORank(), withCellData );
 
             //toIORankComm_.exchangeCached( packUnpack );
             toIORankComm_.exchange( packUnpack );
+#if HAVE_MPI
+            if( cellDataGather_ ) {
+                cellDataGather_->gather( localCellData, localReservoirState.numCells(), *globalCellData_ );
+            }
+#endif
 #ifndef NDEBUG
             // make sure every process is on the same page
             toIORankComm_.barrier();
@@ -696,19 +962,29 @@ namespace Opm
             return globalIndex_.data();
         }
 
+        int rank() const { return rank_; }
+        const std::vector<int>& ownedCells() const { return localIndexMap_; }
+        const std::vector<int>& ownedGlobalCell() const { return ownedGlobalCell_; }
+
     protected:
         std::unique_ptr< Dune::CpGrid >           grid_;
         const EclipseState&                       eclipseState_;
         P2PCommunicatorType                       toIORankComm_;
         IndexMapType                              globalIndex_;
         IndexMapType                              localIndexMap_;
+        // global cartesian index of the cells of localIndexMap_
+        IndexMapType                              ownedGlobalCell_;
         IndexMapStorageType                       indexMaps_;
+#if HAVE_MPI
+        std::unique_ptr<CellDataGather>           cellDataGather_;
+#endif
         std::unique_ptr<SimulationDataContainer>  globalReservoirState_;
         std::unique_ptr<data::Solution>           globalCellData_;
         // this needs to be revised
         WellStateFullyImplicitBlackoil            globalWellState_;
         // true if we are on I/O rank
         bool                                      isIORank_;
+        int                                       rank_;
         // Phase usage needed to convert solution to simulation data container
         Opm::PhaseUsage phaseUsage_;
     };
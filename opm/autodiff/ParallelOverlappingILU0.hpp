@@ -21,11 +21,27 @@
 #define OPM_PARALLELOVERLAPPINGILU0_HEADER_INCLUDED
 
 #include <opm/common/Exceptions.hpp>
+#include <opm/autodiff/BlockKernels.hpp>
+#include <opm/autodiff/OwnerToAllExchange.hpp>
+#include <opm/autodiff/MemoryUsage.hpp>
+#include <opm/autodiff/FirstTouchAllocator.hpp>
+#include <opm/autodiff/LocalIndex.hpp>
+#include <opm/autodiff/MatrixOrdering.hpp>
+#include <opm/autodiff/HardwareCounters.hpp>
 
 #include <dune/istl/preconditioner.hh>
 #include <dune/istl/paamg/smoother.hh>
 #include <dune/istl/paamg/pinfo.hh>
 
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace Opm
 {
 
@@ -142,6 +158,377 @@ namespace Opm
           upper.rows_[ row+1 ] = colcount;
         }
       }
+
+      //! \brief Overwrite the values of CRS structures previously created
+      //! by convertToCRS for a matrix with the same sparsity pattern.
+      //! In contrast to convertToCRS no memory is allocated.
+      template<class M, class CRS, class InvVector>
+      void refillCRSValues(const M& A, CRS& lower, CRS& upper, InvVector& inv )
+      {
+        typedef typename M :: size_type size_type;
+
+        assert( lower.rows() == A.N() );
+        assert( upper.rows() == A.N() );
+
+        const auto endi = A.end();
+        size_type colcount = 0;
+        for (auto i=A.begin(); i!=endi; ++i)
+        {
+          const size_type iIndex = i.index();
+          for (auto j=(*i).begin(); j.index() < iIndex; ++j )
+          {
+            lower.values_[ colcount++ ] = (*j);
+          }
+        }
+
+        const auto rendi = A.beforeBegin();
+        size_type row = 0;
+        colcount = 0;
+        for (auto i=A.beforeEnd(); i!=rendi; --i, ++ row )
+        {
+          const size_type iIndex = i.index();
+          for (auto j=(*i).beforeEnd(); j.index()>=iIndex; --j )
+          {
+            if( j.index() == iIndex )
+            {
+              inv[ row ] = (*j);
+              break;
+            }
+            upper.values_[ colcount++ ] = (*j);
+          }
+        }
+      }
+
+      //! \brief Compute a dependency level ordering of the rows of A.
+      //!
+      //! Row i of the lower (upper) triangular part depends on all rows j < i
+      //! (j > i) with A[i][j] != 0. Rows within the same level are independent
+      //! of each other and can be processed concurrently. The rows are stored
+      //! in the index space of the CRS structures created by convertToCRS, i.e.
+      //! the row index for the lower part and the reversed row index for the
+      //! upper part.
+      //! \param A          The matrix whose sparsity pattern is used.
+      //! \param upper      Whether to compute the levels of the upper part.
+      //! \param levelStart Offsets of the levels into levelRows (size #levels+1).
+      //! \param levelRows  The rows sorted by level.
+      template<class M, class IndexVector>
+      void computeLevelSets(const M& A, const bool upper,
+                            IndexVector& levelStart, IndexVector& levelRows)
+      {
+        typedef typename M :: size_type size_type;
+
+        const size_type n = A.N();
+        std::vector< size_type > level( n, 0 );
+        size_type numLevels = 0;
+
+        if( ! upper )
+        {
+          for (auto i=A.begin(); i!=A.end(); ++i)
+          {
+            const size_type iIndex = i.index();
+            size_type lev = 0;
+            for (auto j=(*i).begin(); j.index() < iIndex; ++j )
+            {
+              lev = std::max( lev, level[ j.index() ] + 1 );
+            }
+            level[ iIndex ] = lev;
+            numLevels = std::max( numLevels, lev + 1 );
+          }
+        }
+        else
+        {
+          const auto rendi = A.beforeBegin();
+          for (auto i=A.beforeEnd(); i!=rendi; --i)
+          {
+            const size_type iIndex = i.index();
+            size_type lev = 0;
+            for (auto j=(*i).beforeEnd(); j.index() > iIndex; --j )
+            {
+              lev = std::max( lev, level[ j.index() ] + 1 );
+            }
+            level[ iIndex ] = lev;
+            numLevels = std::max( numLevels, lev + 1 );
+          }
+        }
+
+        // bucket sort the rows by level, keeping the order within a level
+        levelStart.assign( numLevels + 1, 0 );
+        for( size_type i=0; i<n; ++i )
+        {
+          ++levelStart[ level[ i ] + 1 ];
+        }
+        for( size_type lev=0; lev<numLevels; ++lev )
+        {
+          levelStart[ lev+1 ] += levelStart[ lev ];
+        }
+
+        levelRows.resize( n );
+        IndexVector fill( levelStart.begin(), levelStart.end() - 1 );
+        for( size_type crsRow=0; crsRow<n; ++crsRow )
+        {
+          const size_type row = upper ? n - 1 - crsRow : crsRow;
+          levelRows[ fill[ level[ row ] ]++ ] = crsRow;
+        }
+      }
+
+      //! \brief Compute the ILU0 decomposition of A using a level schedule.
+      //!
+      //! Same algorithm as Dune::bilu0_decomposition, but the rows within each
+      //! dependency level are factorized concurrently. A is overwritten by its
+      //! decomposition.
+      //! \param A          The matrix to decompose.
+      //! \param levelStart Level offsets as computed by computeLevelSets.
+      //! \param levelRows  Rows sorted by level as computed by computeLevelSets.
+      template<class M, class IndexVector>
+      void bilu0DecompositionLevelScheduled(M& A, const IndexVector& levelStart,
+                                            const IndexVector& levelRows)
+      {
+        typedef typename M :: size_type     size_type;
+        typedef typename M :: block_type    block_type;
+        typedef typename M :: ColIterator   coliterator;
+
+        const size_type numLevels = levelStart.size() - 1;
+        bool success = true;
+        std::string message;
+
+        for( size_type lev=0; lev<numLevels; ++lev )
+        {
+          const int begin = levelStart[ lev ];
+          const int end   = levelStart[ lev+1 ];
+#pragma omp parallel for schedule(static)
+          for( int k=begin; k<end; ++k )
+          {
+            const size_type iIndex = levelRows[ k ];
+            auto& row = A[ iIndex ];
+            const coliterator endij = row.end();
+            coliterator ij = row.begin();
+
+            try
+            {
+              for (; ij.index() < iIndex; ++ij )
+              {
+                // row ij.index() belongs to a previous level and is final
+                auto& rowJ = A[ ij.index() ];
+                const coliterator jj = rowJ.find( ij.index() );
+                (*ij).rightmultiply( *jj );
+
+                const coliterator endjk = rowJ.end();
+                coliterator jk = jj; ++jk;
+                coliterator ik = ij; ++ik;
+                while( ik != endij && jk != endjk )
+                {
+                  if( ik.index() == jk.index() )
+                  {
+                    block_type B( *jk );
+                    B.leftmultiply( *ij );
+                    *ik -= B;
+                    ++ik; ++jk;
+                  }
+                  else if( ik.index() < jk.index() )
+                  {
+                    ++ik;
+                  }
+                  else
+                  {
+                    ++jk;
+                  }
+                }
+              }
+
+              if( ij == endij || ij.index() != iIndex )
+              {
+                DUNE_THROW(Dune::ISTLError, "diagonal entry missing in row " << iIndex);
+              }
+
+              (*ij).invert();
+            }
+            catch( const Dune::Exception& e )
+            {
+#pragma omp critical (bilu0DecompositionLevelScheduled)
+              {
+                success = false;
+                message = e.what();
+              }
+            }
+          }
+
+          if( ! success )
+          {
+            DUNE_THROW(Dune::MatrixBlockError, "ILU failed: " << message);
+          }
+        }
+      }
+
+      //! \brief Keep the at most maxSize columns of cols whose entries in
+      //! work have the largest norms, and those only if their norm is at
+      //! least tolerance. The kept columns are sorted.
+      template<class IndexVector, class BlockVector>
+      void keepLargestEntries(IndexVector& cols, const BlockVector& work,
+                              const double tolerance, const std::size_t maxSize)
+      {
+        typedef typename IndexVector :: value_type size_type;
+        const auto norm = [ &work ]( const size_type c ) { return work[ c ].frobenius_norm(); };
+        cols.erase( std::remove_if( cols.begin(), cols.end(),
+                                    [ &norm, tolerance ]( const size_type c ) { return norm( c ) < tolerance; } ),
+                    cols.end() );
+        if( cols.size() > maxSize )
+        {
+          std::nth_element( cols.begin(), cols.begin() + maxSize, cols.end(),
+                            [ &norm ]( const size_type a, const size_type b ) { return norm( a ) > norm( b ); } );
+          cols.resize( maxSize );
+        }
+        std::sort( cols.begin(), cols.end() );
+      }
+
+      //! \brief Compute the threshold ILU decomposition ILUT(fillIn, dropTolerance)
+      //! of A into ILU, which has the format of the ILU0 decomposition: the
+      //! multipliers of L below the diagonal, the inverted pivots on it and
+      //! U above it.
+      //!
+      //! The rows are eliminated in IKJ order. Entries whose norm is less than
+      //! dropTolerance times the mean norm of the entries of the row of A are
+      //! dropped. Of the remaining entries of the L and of the U part of a row
+      //! at most the number of entries of the part in A plus fillIn entries
+      //! with the largest norms are kept, so the pattern is found during the
+      //! factorization as for ILU-n.
+      //! \param A             The matrix to decompose.
+      //! \param fillIn        The additional entries allowed per row of L and U.
+      //! \param dropTolerance The relative drop tolerance.
+      //! \param ILU           A default constructed matrix receiving the decomposition.
+      template<class M>
+      void bilutDecomposition(const M& A, const int fillIn, const double dropTolerance, M& ILU)
+      {
+        typedef typename M :: size_type     size_type;
+        typedef typename M :: block_type    block_type;
+        typedef std::pair< size_type, block_type > Entry;
+
+        const size_type n = A.N();
+        std::vector< std::vector< Entry > > rows( n );
+        // position of the pivot in each row of the decomposition
+        std::vector< size_type > diagonal( n );
+
+        // dense work row, the columns set in it and the columns of the row
+        // still to be eliminated in increasing order
+        std::vector< block_type > work( A.M() );
+        std::vector< bool > used( A.M(), false );
+        std::vector< size_type > touched;
+        std::vector< size_type > lowerCols;
+        std::vector< size_type > upperCols;
+        std::priority_queue< size_type, std::vector< size_type >, std::greater< size_type > > pending;
+
+        for (auto i=A.begin(); i!=A.end(); ++i)
+        {
+          const size_type iIndex = i.index();
+          double rowNorm = 0.0;
+          std::size_t lowerSize = 0;
+          std::size_t upperSize = 0;
+          for (auto j=(*i).begin(); j!=(*i).end(); ++j)
+          {
+            const size_type jIndex = j.index();
+            work[ jIndex ] = *j;
+            used[ jIndex ] = true;
+            touched.push_back( jIndex );
+            rowNorm += j->frobenius_norm();
+            if( jIndex < iIndex ) {
+              pending.push( jIndex );
+              ++lowerSize;
+            }
+            else if( jIndex > iIndex ) {
+              upperCols.push_back( jIndex );
+              ++upperSize;
+            }
+          }
+          if( ! used[ iIndex ] )
+          {
+            DUNE_THROW(Dune::MatrixBlockError, "ILUT failed: diagonal entry missing in row " << iIndex);
+          }
+          const double tolerance = dropTolerance * rowNorm / (*i).size();
+
+          while( ! pending.empty() )
+          {
+            const size_type k = pending.top();
+            pending.pop();
+            block_type& multiplier = work[ k ];
+            multiplier.rightmultiply( rows[ k ][ diagonal[ k ] ].second );
+            if( multiplier.frobenius_norm() < tolerance ) {
+              // row k does not contribute, later rows only fill columns > k
+              continue;
+            }
+            lowerCols.push_back( k );
+
+            const auto& rowK = rows[ k ];
+            for( size_type p = diagonal[ k ] + 1; p < rowK.size(); ++p )
+            {
+              const size_type jIndex = rowK[ p ].first;
+              if( ! used[ jIndex ] )
+              {
+                work[ jIndex ] = 0.0;
+                used[ jIndex ] = true;
+                touched.push_back( jIndex );
+                if( jIndex < iIndex ) {
+                  pending.push( jIndex );
+                }
+                else if( jIndex > iIndex ) {
+                  upperCols.push_back( jIndex );
+                }
+              }
+              block_type B( rowK[ p ].second );
+              B.leftmultiply( multiplier );
+              work[ jIndex ] -= B;
+            }
+          }
+
+          keepLargestEntries( lowerCols, work, tolerance, lowerSize + fillIn );
+          keepLargestEntries( upperCols, work, tolerance, upperSize + fillIn );
+
+          auto& row = rows[ iIndex ];
+          row.reserve( lowerCols.size() + 1 + upperCols.size() );
+          for( const size_type c : lowerCols ) {
+            row.emplace_back( c, work[ c ] );
+          }
+          diagonal[ iIndex ] = row.size();
+          row.emplace_back( iIndex, work[ iIndex ] );
+          try
+          {
+            row.back().second.invert();
+          }
+          catch( const Dune::FMatrixError& e )
+          {
+            DUNE_THROW(Dune::MatrixBlockError, "ILUT failed to invert the pivot of row " << iIndex << ": " << e.what());
+          }
+          for( const size_type c : upperCols ) {
+            row.emplace_back( c, work[ c ] );
+          }
+
+          for( const size_type c : touched ) {
+            used[ c ] = false;
+          }
+          touched.clear();
+          lowerCols.clear();
+          upperCols.clear();
+        }
+
+        size_type nonZeros = 0;
+        for( const auto& row : rows ) {
+          nonZeros += row.size();
+        }
+        ILU.setBuildMode( M::row_wise );
+        ILU.setSize( n, A.M(), nonZeros );
+        for (auto row=ILU.createbegin(); row!=ILU.createend(); ++row)
+        {
+          for( const Entry& entry : rows[ row.index() ] ) {
+            row.insert( entry.first );
+          }
+        }
+        for( size_type i=0; i<n; ++i )
+        {
+          auto col = ILU[ i ].begin();
+          for( const Entry& entry : rows[ i ] ) {
+            *col = entry.second;
+            ++col;
+          }
+        }
+      }
     } // end namespace detail
 
 /// \brief A two-step version of an overlapping Schwarz preconditioner using one step ILU0 as
@@ -188,7 +575,7 @@ protected:
 
       size_type nonZeros() const
       {
-        assert( rows_[ rows() ] != size_type(-1) );
+        assert( rows_[ rows() ] != LocalIndex(-1) );
         return rows_[ rows() ];
       }
 
@@ -197,7 +584,7 @@ protected:
           if( nRows_ != nRows )
           {
             nRows_ = nRows ;
-            rows_.resize( nRows_+1, size_type(-1) );
+            rows_.resize( nRows_+1, LocalIndex(-1) );
           }
       }
 
@@ -215,12 +602,13 @@ protected:
       void push_back( const block_type& value, const size_type index )
       {
           values_.push_back( value );
-          cols_.push_back( index );
+          cols_.push_back( static_cast< LocalIndex >( index ) );
       }
 
-      std::vector< size_type  > rows_;
-      std::vector< block_type > values_;
-      std::vector< size_type  > cols_;
+      // the pages are distributed over the NUMA nodes of the threads
+      std::vector< LocalIndex, FirstTouchAllocator< LocalIndex > > rows_;
+      std::vector< block_type, FirstTouchAllocator< block_type > > values_;
+      std::vector< LocalIndex, FirstTouchAllocator< LocalIndex > > cols_;
       size_type nRows_;
     };
 
@@ -236,17 +624,44 @@ public:
 
       Constructor gets all parameters to operate the prec.
       \param A The matrix to operate on.
-      \param n ILU fill in level (for testing). This does not work in parallel.
+      \param n ILU fill in level, or the additional entries per row of L and U
+             of the ILUT if dropTolerance is positive.
       \param w The relaxation factor.
+      \param levelScheduling Whether to factorize and apply the rows of each
+             dependency level concurrently (requires OpenMP).
+      \param compact Whether to apply the decomposition directly from the
+             factorized matrix instead of from a CRS copy of its triangular
+             parts, which halves the memory of the preconditioner.
+      \param reorder Whether to decompose the matrix in reverse Cuthill-McKee
+             order, which keeps the rows coupled in the triangular solves
+             close in memory.
+      \param dropTolerance If positive, compute the threshold ILU
+             ILUT(n, dropTolerance) instead of ILU-n, see
+             detail::bilutDecomposition.
+      \param coloring Whether to decompose the matrix in multi-color order
+             instead, see multiColorOrdering. With level scheduling the
+             rows of each color are then processed concurrently, which
+             gives a few wide levels instead of many narrow ones at the cost
+             of a weaker ILU0.
     */
     template<class BlockType, class Alloc>
     ParallelOverlappingILU0 (const Dune::BCRSMatrix<BlockType,Alloc>& A,
-                             const int n, const field_type w )
+                             const int n, const field_type w,
+                             const bool levelScheduling = false,
+                             const bool compact = false,
+                             const bool reorder = false,
+                             const double dropTolerance = 0.0,
+                             const bool coloring = false )
         : lower_(),
           upper_(),
           inv_(),
           comm_(nullptr), w_(w),
-          relaxation_( std::abs( w - 1.0 ) > 1e-15 )
+          relaxation_( std::abs( w - 1.0 ) > 1e-15 ),
+          levelScheduling_( levelScheduling ),
+          compact_( compact ),
+          reorder_( reorder ),
+          coloring_( coloring ),
+          dropTolerance_( dropTolerance )
     {
         // BlockMatrix is a Subclass of FieldMatrix that just adds
         // methods. Therefore this cast should be safe.
@@ -272,19 +687,39 @@ public:
       \param A      The matrix to operate on.
       \param comm   communication object, e.g. Dune::OwnerOverlapCopyCommunication
       \param w      The relaxation factor.
+      \param levelScheduling Whether to factorize and apply the rows of each
+             dependency level concurrently (requires OpenMP).
+      \param compact Whether to apply the decomposition directly from the
+             factorized matrix, see above.
+      \param n ILU fill in level or ILUT fill, see above.
+      \param dropTolerance The drop tolerance of the ILUT, see above.
+
+      The rows are not reordered in parallel runs, the exchange with the
+      other processes refers to the numbering of A. The fill-in is computed
+      from the local matrix including the overlap, the triangular solves
+      exchange the rows as for ILU0.
     */
     template<class BlockType, class Alloc>
     ParallelOverlappingILU0 (const Dune::BCRSMatrix<BlockType,Alloc>& A,
-                             const ParallelInfo& comm, const field_type w)
+                             const ParallelInfo& comm, const field_type w,
+                             const bool levelScheduling = false,
+                             const bool compact = false,
+                             const int n = 0,
+                             const double dropTolerance = 0.0 )
         : lower_(),
           upper_(),
           inv_(),
           comm_(&comm), w_(w),
-          relaxation_( std::abs( w - 1.0 ) > 1e-15 )
+          relaxation_( std::abs( w - 1.0 ) > 1e-15 ),
+          levelScheduling_( levelScheduling ),
+          compact_( compact ),
+          reorder_( false ),
+          coloring_( false ),
+          dropTolerance_( dropTolerance )
     {
         // BlockMatrix is a Subclass of FieldMatrix that just adds
         // methods. Therefore this cast should be safe.
-        init( reinterpret_cast<const Matrix&>(A), 0 );
+        init( reinterpret_cast<const Matrix&>(A), n );
     }
 
     /*!
@@ -305,58 +740,251 @@ public:
     */
     virtual void apply (Domain& v, const Range& d)
     {
+        HardwareCounters::Scope counters(HardwareCounters::Preconditioner);
         Range& md = const_cast<Range&>(d);
-        copyOwnerToAll( md );
 
-        // iterator types
-        typedef typename Range ::block_type  dblock;
-        typedef typename Domain::block_type  vblock;
-
-        const size_type iEnd = lower_.rows();
-        const size_type lastRow = iEnd - 1;
-        if( iEnd != upper_.rows() )
+        if( ! compact_ && lower_.rows() != upper_.rows() )
         {
             std::abort();
            // OPM_THROW(std::logic_error,"ILU: lower and upper rows must be the same");
         }
 
-        // lower triangular solve
-        for( size_type i=0; i<iEnd; ++ i )
+        if( ! perm_.empty() )
         {
-          dblock rhs( d[ i ] );
-          const size_type rowI     = lower_.rows_[ i ];
-          const size_type rowINext = lower_.rows_[ i+1 ];
-
-          for( size_type col = rowI; col < rowINext; ++ col )
-          {
-            lower_.values_[ col ].mmv( v[ lower_.cols_[ col ] ], rhs );
-          }
+            // solve in the numbering of the decomposition, there is no
+            // exchange since reordering is only done in sequential runs
+            const size_type n = rows();
+            for( size_type i=0; i<n; ++i ) {
+                reorderedD_[ i ] = d[ perm_[ i ] ];
+            }
+            lowerSolve( reorderedV_, reorderedD_, false );
+            upperSolve( reorderedV_, false );
+            for( size_type i=0; i<n; ++i ) {
+                v[ perm_[ i ] ] = reorderedV_[ i ];
+            }
 
-          v[ i ] = rhs;  // Lii = I
+            if( relaxation_ ) {
+                v *= w_;
+            }
+            return;
         }
 
+        // the rows which do not depend on rows of other processes are
+        // solved while these are exchanged
+        beginExchange( md );
+        lowerSolve( v, d, false );
+        endExchange( md );
+        lowerSolve( v, d, true );
+
+        beginExchange( v );
+        upperSolve( v, false );
+        endExchange( v );
+        upperSolve( v, true );
+
         copyOwnerToAll( v );
 
-        for( size_type i=0; i<iEnd; ++ i )
+        if( relaxation_ ) {
+            v *= w_;
+        }
+    }
+
+    /*!
+      \brief Update the preconditioner for a new matrix.
+
+      If the sparsity pattern of A is the one of the current decomposition,
+      the CRS index arrays and level sets are kept and only the numerical
+      values are recomputed. Otherwise the preconditioner is set up from
+      scratch.
+
+      \param A      The matrix to operate on.
+      \param comm   communication object; pass nullptr to keep the current one.
+    */
+    template<class BlockType, class Alloc>
+    void update (const Dune::BCRSMatrix<BlockType,Alloc>& A,
+                 const ParallelInfo* comm = nullptr )
+    {
+        if( comm ) {
+            comm_ = comm;
+        }
+
+        const Matrix& mat = reinterpret_cast<const Matrix&>(A);
+        // ILU-n and ILUT determine their pattern during the factorization
+        if( iluIteration_ == 0 && dropTolerance_ <= 0.0 && hasPatternOf( mat ) ) {
+            refactorize( mat );
+            if( comm ) {
+                setupExchange();
+            }
+        }
+        else {
+            init( mat, iluIteration_ );
+        }
+    }
+
+    //! \brief Whether the stored decomposition has the sparsity pattern of A.
+    //! Only the sizes are compared, since the Jacobian pattern of a given grid
+    //! does not change between Newton iterations.
+    bool hasPatternOf( const Matrix& A ) const
+    {
+        return ILU_ && ILU_->N() == A.N() && ILU_->M() == A.M()
+            && ILU_->nonzeroes() == A.nonzeroes();
+    }
+
+    //! \brief The number of bytes held by the decomposition, the CRS copy
+    //! of its triangular parts and the index arrays of the triangular solves.
+    std::size_t memoryUsage() const
+    {
+        std::size_t bytes = ILU_ ? Opm::memoryUsage( *ILU_ ) : 0;
+        bytes += Opm::memoryUsage( lower_.rows_ ) + Opm::memoryUsage( lower_.values_ ) + Opm::memoryUsage( lower_.cols_ );
+        bytes += Opm::memoryUsage( upper_.rows_ ) + Opm::memoryUsage( upper_.values_ ) + Opm::memoryUsage( upper_.cols_ );
+        bytes += Opm::memoryUsage( inv_ );
+        bytes += Opm::memoryUsage( lowerLevelStart_ ) + Opm::memoryUsage( lowerLevelRows_ );
+        bytes += Opm::memoryUsage( upperLevelStart_ ) + Opm::memoryUsage( upperLevelRows_ );
+        bytes += Opm::memoryUsage( lowerLevelExchangeStart_ ) + Opm::memoryUsage( upperLevelExchangeStart_ );
+        bytes += ( lowerAfterExchange_.capacity() + upperAfterExchange_.capacity() ) / 8;
+        bytes += Opm::memoryUsage( perm_ ) + Opm::memoryUsage( invPerm_ );
+        bytes += Opm::memoryUsage( reorderedV_ ) + Opm::memoryUsage( reorderedD_ );
+        return bytes;
+    }
+
+    //! \brief The number of rows of the decomposition.
+    size_type rows() const
+    {
+        return ILU_ ? ILU_->N() : 0;
+    }
+
+    //! \brief Forward substitution for row i of L (Lii = I)
+    void lowerSolveRow( const size_type i, Domain& v, const Range& d ) const
+    {
+        typename Range::block_type rhs( d[ i ] );
+        if( compact_ )
         {
-            vblock& vBlock = v[ lastRow - i ];
-            vblock rhs ( vBlock );
-            const size_type rowI     = upper_.rows_[ i ];
-            const size_type rowINext = upper_.rows_[ i+1 ];
+            const auto& row = (*ILU_)[ i ];
+            for( auto j = row.begin(); j.index() < i; ++j )
+            {
+                BlockKernels::mmv( *j, v[ j.index() ], rhs );
+            }
+            v[ i ] = rhs;
+            return;
+        }
+
+        const size_type rowI     = lower_.rows_[ i ];
+        const size_type rowINext = lower_.rows_[ i+1 ];
+
+        for( size_type col = rowI; col < rowINext; ++ col )
+        {
+            BlockKernels::mmv( lower_.values_[ col ], v[ lower_.cols_[ col ] ], rhs );
+        }
 
-            for( size_type col = rowI; col < rowINext; ++ col )
+        v[ i ] = rhs;
+    }
+
+    //! \brief Backward substitution for row i of the (reversed) U
+    void upperSolveRow( const size_type i, const size_type lastRow, Domain& v ) const
+    {
+        typename Domain::block_type& vBlock = v[ lastRow - i ];
+        typename Domain::block_type rhs ( vBlock );
+        if( compact_ )
+        {
+            // the factorized diagonal block holds the inverse of the pivot
+            const auto& row = (*ILU_)[ lastRow - i ];
+            const auto diag = row.find( lastRow - i );
+            assert( diag != row.end() );
+            const auto endj = row.end();
+            auto j = diag;
+            for( ++j; j != endj; ++j )
             {
-                upper_.values_[ col ].mmv( v[ upper_.cols_[ col ] ], rhs );
+                BlockKernels::mmv( *j, v[ j.index() ], rhs );
             }
+            BlockKernels::mv( *diag, rhs, vBlock );
+            return;
+        }
+
+        const size_type rowI     = upper_.rows_[ i ];
+        const size_type rowINext = upper_.rows_[ i+1 ];
 
-            // apply inverse and store result
-            inv_[ i ].mv( rhs, vBlock);
+        for( size_type col = rowI; col < rowINext; ++ col )
+        {
+            BlockKernels::mmv( upper_.values_[ col ], v[ upper_.cols_[ col ] ], rhs );
         }
 
-        copyOwnerToAll( v );
+        // apply inverse and store result
+        BlockKernels::mv( inv_[ i ], rhs, vBlock );
+    }
 
-        if( relaxation_ ) {
-            v *= w_;
+    //! \brief Forward substitution of the rows which do (afterExchange) or
+    //! do not depend on the rows received from other processes.
+    void lowerSolve( Domain& v, const Range& d, const bool afterExchange ) const
+    {
+        if( levelScheduling_ )
+        {
+            const size_type numLevels = lowerLevelStart_.size() - 1;
+            for( size_type level=0; level<numLevels; ++level )
+            {
+                const int begin = afterExchange ? lowerLevelExchangeStart_[ level ] : lowerLevelStart_[ level ];
+                const int end   = afterExchange ? lowerLevelStart_[ level+1 ] : lowerLevelExchangeStart_[ level ];
+#pragma omp parallel for schedule(static)
+                for( int k=begin; k<end; ++k )
+                {
+                    lowerSolveRow( lowerLevelRows_[ k ], v, d );
+                }
+            }
+        }
+        else
+        {
+            const size_type iEnd = rows();
+            for( size_type i=0; i<iEnd; ++ i )
+            {
+                if( lowerAfterExchange_[ i ] == afterExchange ) {
+                    lowerSolveRow( i, v, d );
+                }
+            }
+        }
+    }
+
+    //! \brief Backward substitution of the rows which do (afterExchange) or
+    //! do not depend on the rows received from other processes.
+    void upperSolve( Domain& v, const bool afterExchange ) const
+    {
+        const size_type iEnd = rows();
+        const size_type lastRow = iEnd - 1;
+        if( levelScheduling_ )
+        {
+            const size_type numLevels = upperLevelStart_.size() - 1;
+            for( size_type level=0; level<numLevels; ++level )
+            {
+                const int begin = afterExchange ? upperLevelExchangeStart_[ level ] : upperLevelStart_[ level ];
+                const int end   = afterExchange ? upperLevelStart_[ level+1 ] : upperLevelExchangeStart_[ level ];
+#pragma omp parallel for schedule(static)
+                for( int k=begin; k<end; ++k )
+                {
+                    upperSolveRow( upperLevelRows_[ k ], lastRow, v );
+                }
+            }
+        }
+        else
+        {
+            for( size_type i=0; i<iEnd; ++ i )
+            {
+                if( upperAfterExchange_[ i ] == afterExchange ) {
+                    upperSolveRow( i, lastRow, v );
+                }
+            }
+        }
+    }
+
+    template <class V>
+    void beginExchange( const V& v ) const
+    {
+        if( exchange_ ) {
+            exchange_->begin( v );
+        }
+    }
+
+    template <class V>
+    void endExchange( V& v ) const
+    {
+        if( exchange_ ) {
+            exchange_->end( v );
         }
     }
 
@@ -381,23 +1009,58 @@ public:
 protected:
     void init( const Matrix& A, const int iluIteration )
     {
+        iluIteration_ = iluIteration;
+
         int ilu_setup_successful = 1;
         std::string message;
         const int rank = ( comm_ ) ? comm_->communicator().rank() : 0;
+        checkLocalIndexRange( A.nonzeroes(), "nonzero blocks of the matrix" );
 
-        std::unique_ptr< Matrix > ILU;
+        // decompose the matrix in multi-color or reverse Cuthill-McKee order
+        std::unique_ptr< Matrix > reordered;
+        if( ( coloring_ || reorder_ ) && ! comm_ )
+        {
+            if( coloring_ ) {
+                multiColorOrdering( A, perm_ );
+            }
+            else {
+                reverseCuthillMcKee( A, perm_ );
+            }
+            invertPermutation( perm_, invPerm_ );
+            reordered.reset( new Matrix() );
+            permuteMatrix( A, perm_, invPerm_, *reordered );
+            reorderedV_.resize( A.N() );
+            reorderedD_.resize( A.N() );
+        }
+        else
+        {
+            perm_.clear();
+            invPerm_.clear();
+        }
+        const Matrix& mat = reordered ? *reordered : A;
 
         try
         {
-            if( iluIteration == 0 ) {
+            if( dropTolerance_ > 0.0 ) {
+                // create ILUT decomposition
+                ILU_.reset( new Matrix() );
+                detail::bilutDecomposition( mat, iluIteration, dropTolerance_, *ILU_ );
+            }
+            else if( iluIteration == 0 && levelScheduling_ ) {
+                // create ILU-0 decomposition, processing independent rows concurrently
+                ILU_.reset( new Matrix( mat ) );
+                detail::computeLevelSets( *ILU_, false, lowerLevelStart_, lowerLevelRows_ );
+                detail::bilu0DecompositionLevelScheduled( *ILU_, lowerLevelStart_, lowerLevelRows_ );
+            }
+            else if( iluIteration == 0 ) {
                 // create ILU-0 decomposition
-                ILU.reset( new Matrix( A ) );
-                bilu0_decomposition( *ILU );
+                ILU_.reset( new Matrix( mat ) );
+                bilu0_decomposition( *ILU_ );
             }
             else {
                 // create ILU-n decomposition
-                ILU.reset( new Matrix( A.N(), A.M(), Matrix::row_wise) );
-                bilu_decomposition( A, iluIteration, *ILU );
+                ILU_.reset( new Matrix( mat.N(), mat.M(), Matrix::row_wise) );
+                bilu_decomposition( mat, iluIteration, *ILU_ );
             }
         }
         catch ( Dune::MatrixBlockError error )
@@ -409,27 +1072,204 @@ protected:
             ilu_setup_successful = 0;
         }
 
+        // Check whether there was a problem on some process
+        checkSetup( ilu_setup_successful );
+
+        // store ILU in simple CRS format, unless it is applied directly
+        if( ! compact_ ) {
+            detail::convertToCRS( *ILU_, lower_, upper_, inv_ );
+        }
+
+        if( levelScheduling_ )
+        {
+            // the pattern of ILU-n and ILUT contains fill-in, so the levels for
+            // the triangular solves have to be computed from the decomposition
+            if( iluIteration != 0 || dropTolerance_ > 0.0 ) {
+                detail::computeLevelSets( *ILU_, false, lowerLevelStart_, lowerLevelRows_ );
+            }
+            detail::computeLevelSets( *ILU_, true, upperLevelStart_, upperLevelRows_ );
+        }
+
+        setupExchange();
+    }
+
+    //! \brief Set up the exchange with the other processes and find the rows
+    //! of the triangular solves which depend on received rows, directly or
+    //! through the rows they are coupled to.
+    void setupExchange()
+    {
+        const size_type iEnd = rows();
+        const size_type lastRow = iEnd - 1;
+        exchange_.reset( comm_ ? new OwnerToAllExchange< ParallelInfo >( *comm_ ) : nullptr );
+
+        lowerAfterExchange_.assign( iEnd, false );
+        upperAfterExchange_.assign( iEnd, false );
+        if( exchange_ )
+        {
+            // the columns of the lower and upper parts are the same in the
+            // factorized matrix and in its CRS copy
+            for( size_type i=0; i<iEnd; ++i )
+            {
+                bool after = exchange_->received( i );
+                const auto& row = (*ILU_)[ i ];
+                for( auto j = row.begin(); !after && j.index() < i; ++j )
+                {
+                    after = lowerAfterExchange_[ j.index() ];
+                }
+                lowerAfterExchange_[ i ] = after;
+            }
+            // the upper rows are stored in reversed order
+            for( size_type i=0; i<iEnd; ++i )
+            {
+                bool after = exchange_->received( lastRow - i );
+                const auto& row = (*ILU_)[ lastRow - i ];
+                const auto endj = row.end();
+                for( auto j = row.find( lastRow - i ); !after && j != endj; ++j )
+                {
+                    if( j.index() > lastRow - i ) {
+                        after = upperAfterExchange_[ lastRow - j.index() ];
+                    }
+                }
+                upperAfterExchange_[ i ] = after;
+            }
+        }
+
+        if( levelScheduling_ )
+        {
+            partitionLevels( lowerLevelStart_, lowerAfterExchange_, lowerLevelRows_, lowerLevelExchangeStart_ );
+            partitionLevels( upperLevelStart_, upperAfterExchange_, upperLevelRows_, upperLevelExchangeStart_ );
+        }
+    }
+
+    //! \brief Move the rows of each level which depend on the exchange to
+    //! the end of the level. The rows of a level are independent, so their
+    //! order does not matter.
+    static void partitionLevels( const std::vector< LocalIndex >& levelStart,
+                                 const std::vector< bool >& afterExchange,
+                                 std::vector< LocalIndex >& levelRows,
+                                 std::vector< LocalIndex >& levelExchangeStart )
+    {
+        const size_type numLevels = levelStart.size() - 1;
+        levelExchangeStart.resize( numLevels );
+        for( size_type level=0; level<numLevels; ++level )
+        {
+            const auto begin = levelRows.begin() + levelStart[ level ];
+            const auto end   = levelRows.begin() + levelStart[ level+1 ];
+            const auto split = std::stable_partition( begin, end,
+                [ &afterExchange ]( const LocalIndex row ) { return !afterExchange[ row ]; } );
+            levelExchangeStart[ level ] = split - levelRows.begin();
+        }
+    }
+
+    //! \brief Refactorize A reusing the pattern of the stored ILU0 decomposition.
+    void refactorize( const Matrix& A )
+    {
+        int ilu_setup_successful = 1;
+        const int rank = ( comm_ ) ? comm_->communicator().rank() : 0;
+
+        // copy the values of A into the stored matrix without reallocation
+        if( ! perm_.empty() )
+        {
+            permuteMatrixValues( A, perm_, invPerm_, *ILU_ );
+        }
+        else
+        {
+            auto iluRow = ILU_->begin();
+            const auto endi = A.end();
+            for( auto row = A.begin(); row != endi; ++row, ++iluRow )
+            {
+                auto iluCol = iluRow->begin();
+                const auto endj = row->end();
+                for( auto col = row->begin(); col != endj; ++col, ++iluCol )
+                {
+                    *iluCol = *col;
+                }
+            }
+        }
+
+        try
+        {
+            if( levelScheduling_ ) {
+                detail::bilu0DecompositionLevelScheduled( *ILU_, lowerLevelStart_, lowerLevelRows_ );
+            }
+            else {
+                bilu0_decomposition( *ILU_ );
+            }
+        }
+        catch ( Dune::MatrixBlockError error )
+        {
+            std::cerr<<"Exception occured on process " << rank << " during " <<
+                "update of ILU0 preconditioner with message: " <<
+                error.what()<<std::endl;
+            ilu_setup_successful = 0;
+        }
+
+        checkSetup( ilu_setup_successful );
+
+        // the CRS index arrays are still valid, only refill the values
+        if( ! compact_ ) {
+            detail::refillCRSValues( *ILU_, lower_, upper_, inv_ );
+        }
+    }
+
+    void checkSetup( const int ilu_setup_successful ) const
+    {
         // Check whether there was a problem on some process
         if ( comm_ && comm_->communicator().min(ilu_setup_successful) == 0 )
         {
             throw Dune::MatrixBlockError();
         }
-
-        // store ILU in simple CRS format
-        detail::convertToCRS( *ILU, lower_, upper_, inv_ );
     }
 
 protected:
+    //! \brief The ILU decomposition of the matrix, kept to allow cheap updates.
+    std::unique_ptr< Matrix > ILU_;
+    //! \brief The fill-in level of the decomposition.
+    int iluIteration_;
     //! \brief The ILU0 decomposition of the matrix.
     CRS lower_;
     CRS upper_;
-    std::vector< block_type > inv_;
+    std::vector< block_type, FirstTouchAllocator< block_type > > inv_;
 
     const ParallelInfo* comm_;
     //! \brief The relaxation factor to use.
     const field_type w_;
     const bool relaxation_;
 
+    //! \brief Whether rows of the same dependency level are processed concurrently.
+    const bool levelScheduling_;
+    //! \brief Whether the triangular solves read the factorized matrix ILU_
+    //! instead of the CRS copies lower_, upper_ and inv_, which are then empty.
+    const bool compact_;
+    //! \brief Whether the rows are decomposed in reverse Cuthill-McKee order.
+    const bool reorder_;
+    //! \brief Whether the rows are decomposed in multi-color order.
+    const bool coloring_;
+    //! \brief The drop tolerance of the ILUT, ILU-n is used if it is not positive.
+    const double dropTolerance_;
+    //! \brief Row i of the decomposition is row perm_[ i ] of the matrix,
+    //! empty if the rows are not reordered.
+    std::vector< LocalIndex > perm_;
+    std::vector< LocalIndex > invPerm_;
+    //! \brief The vectors of apply in the numbering of the decomposition.
+    Domain reorderedV_;
+    Range reorderedD_;
+    //! \brief Level offsets and rows sorted by level for the lower and upper solves.
+    std::vector< LocalIndex > lowerLevelStart_;
+    std::vector< LocalIndex > lowerLevelRows_;
+    std::vector< LocalIndex > upperLevelStart_;
+    std::vector< LocalIndex > upperLevelRows_;
+
+    //! \brief Split-phase exchange of the owned rows with the other processes.
+    std::unique_ptr< OwnerToAllExchange< ParallelInfo > > exchange_;
+    //! \brief Whether a row of the lower and upper solve has to wait for
+    //! the exchange, in the storage order of the CRS matrices.
+    std::vector< bool > lowerAfterExchange_;
+    std::vector< bool > upperAfterExchange_;
+    //! \brief Offsets of the rows waiting for the exchange within the levels.
+    std::vector< LocalIndex > lowerLevelExchangeStart_;
+    std::vector< LocalIndex > upperLevelExchangeStart_;
+
 };
 
 } // end namespace Opm
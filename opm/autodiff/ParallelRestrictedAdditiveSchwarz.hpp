@@ -173,7 +173,14 @@ public:
     */
     virtual void apply (Domain& v, const Range& d)
     {
-        apply<true>(v, d);
+        // hack us a mutable d to prevent copying.
+        Range& md = const_cast<Range&>(d);
+        communication_.copyOwnerToAll(md,md);
+        // plain apply, the sequential preconditioner need not be a smoother
+        preconditioner_.apply(v,d);
+        communication_.copyOwnerToAll(v,v);
+        // Make sure that d is the same as at the beginning of apply.
+        communication_.project(md);
     }
 
     template<bool forward>
@@ -0,0 +1,166 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_PARAREALPROPAGATORS_HEADER_INCLUDED
+#define OPM_PARAREALPROPAGATORS_HEADER_INCLUDED
+
+#include <opm/core/props/BlackoilPhases.hpp>
+#include <opm/core/simulator/SimulatorReport.hpp>
+#include <opm/core/utility/initHydroCarbonState.hpp>
+#include <opm/simulators/timestepping/SimulatorTimer.hpp>
+#include <opm/parser/eclipse/EclipseState/Schedule/TimeMap.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Opm
+{
+
+    /// The coarse and fine propagators of a PararealIteration over the time
+    /// slabs of a schedule, both of them simulators of the blackoil model
+    /// which run the report steps of a slab from a given state.
+    ///
+    /// The correction of the iteration acts on the primary fields of the
+    /// reservoir state, after which the saturations are cut to [0, 1] and
+    /// the hydrocarbon state is recomputed from them.
+    template <class Simulator>
+    class PararealPropagators
+    {
+    public:
+        typedef typename Simulator::ReservoirState ReservoirState;
+
+        /// \param[in] coarse      the simulator of the coarse propagator
+        /// \param[in] fine        the simulator of the fine propagator
+        /// \param[in] timeMap     the report steps of the schedule
+        /// \param[in] boundaries  the first report step of each slab, followed by the end
+        /// \param[in] phaseUsage  the active phases
+        /// \param[in] hasDisgas   whether the oil has dissolved gas
+        /// \param[in] hasVapoil   whether the gas has vaporized oil
+        PararealPropagators(Simulator& coarse,
+                            Simulator& fine,
+                            const TimeMap& timeMap,
+                            const std::vector<int>& boundaries,
+                            const PhaseUsage& phaseUsage,
+                            const bool hasDisgas,
+                            const bool hasVapoil)
+            : coarse_(coarse)
+            , fine_(fine)
+            , timeMap_(timeMap)
+            , boundaries_(boundaries)
+            , phaseUsage_(phaseUsage)
+            , hasDisgas_(hasDisgas)
+            , hasVapoil_(hasVapoil)
+        {
+        }
+
+        void coarse(const int slab, ReservoirState& state)
+        {
+            coarseReport_ += propagate(coarse_, slab, state);
+        }
+
+        void fine(const int slab, ReservoirState& state)
+        {
+            fineReport_ += propagate(fine_, slab, state);
+        }
+
+        void correct(ReservoirState& coarseNew, const ReservoirState& fineOld, const ReservoirState& coarseOld) const
+        {
+            add(coarseNew.pressure(), fineOld.pressure(), coarseOld.pressure());
+            add(coarseNew.saturation(), fineOld.saturation(), coarseOld.saturation());
+            add(coarseNew.gasoilratio(), fineOld.gasoilratio(), coarseOld.gasoilratio());
+            add(coarseNew.rv(), fineOld.rv(), coarseOld.rv());
+
+            const int numCells = coarseNew.numCells();
+            const int np = phaseUsage_.num_phases;
+            auto& saturation = coarseNew.saturation();
+            for (int cell = 0; cell < numCells; ++cell) {
+                double sum = 0.0;
+                for (int phase = 0; phase < np; ++phase) {
+                    double& s = saturation[cell*np + phase];
+                    s = std::max(s, 0.0);
+                    sum += s;
+                }
+                if (sum > 0.0) {
+                    for (int phase = 0; phase < np; ++phase) {
+                        saturation[cell*np + phase] /= sum;
+                    }
+                }
+                coarseNew.gasoilratio()[cell] = std::max(coarseNew.gasoilratio()[cell], 0.0);
+                coarseNew.rv()[cell] = std::max(coarseNew.rv()[cell], 0.0);
+            }
+            initHydroCarbonState(coarseNew, phaseUsage_, numCells, hasDisgas_, hasVapoil_);
+        }
+
+        /// The largest change of the saturations and of the pressures
+        /// relative to the largest pressure, over all processes.
+        double difference(const ReservoirState& a, const ReservoirState& b) const
+        {
+            double pressureScale = 0.0;
+            double pressureChange = 0.0;
+            for (std::size_t i = 0; i < a.pressure().size(); ++i) {
+                pressureScale = std::max(pressureScale, std::abs(b.pressure()[i]));
+                pressureChange = std::max(pressureChange, std::abs(a.pressure()[i] - b.pressure()[i]));
+            }
+            double saturationChange = 0.0;
+            for (std::size_t i = 0; i < a.saturation().size(); ++i) {
+                saturationChange = std::max(saturationChange, std::abs(a.saturation()[i] - b.saturation()[i]));
+            }
+            const auto& comm = fine_.grid().comm();
+            pressureScale = comm.max(pressureScale);
+            pressureChange = comm.max(pressureChange);
+            saturationChange = comm.max(saturationChange);
+            return std::max(pressureScale > 0.0 ? pressureChange / pressureScale : 0.0, saturationChange);
+        }
+
+        /// The accumulated report of the coarse solves.
+        const SimulatorReport& coarseReport() const { return coarseReport_; }
+
+        /// The accumulated report of the fine solves.
+        const SimulatorReport& fineReport() const { return fineReport_; }
+
+    private:
+        SimulatorReport propagate(Simulator& simulator, const int slab, ReservoirState& state) const
+        {
+            SimulatorTimer timer;
+            timer.init(timeMap_, boundaries_[slab]);
+            return simulator.runSlab(timer, state, boundaries_[slab + 1]);
+        }
+
+        static void add(std::vector<double>& x, const std::vector<double>& plus, const std::vector<double>& minus)
+        {
+            for (std::size_t i = 0; i < x.size(); ++i) {
+                x[i] += plus[i] - minus[i];
+            }
+        }
+
+        Simulator& coarse_;
+        Simulator& fine_;
+        const TimeMap& timeMap_;
+        std::vector<int> boundaries_;
+        PhaseUsage phaseUsage_;
+        bool hasDisgas_;
+        bool hasVapoil_;
+        SimulatorReport coarseReport_;
+        SimulatorReport fineReport_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_PARAREALPROPAGATORS_HEADER_INCLUDED
@@ -0,0 +1,204 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_PARTITIONWEIGHTS_HEADER_INCLUDED
+#define OPM_PARTITIONWEIGHTS_HEADER_INCLUDED
+
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/core/utility/parameters/ParameterGroup.hpp>
+#include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
+#include <opm/parser/eclipse/EclipseState/InitConfig/InitConfig.hpp>
+#include <opm/parser/eclipse/EclipseState/Schedule/Schedule.hpp>
+#include <opm/parser/eclipse/EclipseState/Schedule/Well.hpp>
+#include <opm/autodiff/GridHelpers.hpp>
+
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Parameters of the weights of the cells and connections of the grid
+    /// used when it is partitioned among the processes, and of the overlap
+    /// of the partitions.
+    struct PartitionWeightParameters
+    {
+        /// Weight the connections of the grid by the cost of their cells,
+        /// otherwise only by their transmissibilities.
+        bool use_weights_;
+        /// Cost of an open completion relative to an ordinary cell.
+        double completion_weight_;
+        /// Additional cost of a completion of a multi-segment well.
+        double multisegment_weight_;
+        /// File with the cost of every active cell in a previous run, one
+        /// value per cell in the order of the global grid. Empty for none.
+        std::string cost_file_;
+        /// Number of layers of overlap cells around the interior cells of a
+        /// process. The cells of the first layer hold the couplings of the
+        /// interior cells to the other processes and cannot be left out,
+        /// further layers make the parallel ILU more like an overlapping
+        /// Schwarz method at the cost of assembly and communication.
+        int overlap_layers_;
+
+        PartitionWeightParameters()
+            : use_weights_(false)
+            , completion_weight_(4.0)
+            , multisegment_weight_(4.0)
+            , overlap_layers_(1)
+        {
+        }
+
+        explicit PartitionWeightParameters(const ParameterGroup& param)
+            : PartitionWeightParameters()
+        {
+            use_weights_ = param.getDefault("partition_weights", use_weights_);
+            completion_weight_ = param.getDefault("partition_completion_weight", completion_weight_);
+            multisegment_weight_ = param.getDefault("partition_multisegment_weight", multisegment_weight_);
+            cost_file_ = param.getDefault("partition_cost_file", cost_file_);
+            overlap_layers_ = param.getDefault("overlap_layers", overlap_layers_);
+            if (overlap_layers_ < 1) {
+                OPM_THROW(std::invalid_argument, "overlap_layers is " << overlap_layers_
+                          << ", at least one layer of overlap is needed for the"
+                          " couplings between the processes");
+            }
+        }
+    };
+
+
+
+    /// Read the cost of numCells cells of a previous run, whitespace
+    /// separated. Throws std::runtime_error if the file cannot be read or
+    /// does not hold numCells values.
+    inline std::vector<double> readPartitionCost(const std::string& filename, const int numCells)
+    {
+        std::ifstream file(filename.c_str());
+        if (!file) {
+            OPM_THROW(std::runtime_error, "Cannot read the partition cost file " << filename);
+        }
+        std::vector<double> cost;
+        cost.reserve(numCells);
+        double value;
+        while (file >> value) {
+            cost.push_back(value);
+        }
+        if (!file.eof() || static_cast<int>(cost.size()) != numCells) {
+            OPM_THROW(std::runtime_error, "The partition cost file " << filename << " holds "
+                      << cost.size() << " values for " << numCells << " cells");
+        }
+        return cost;
+    }
+
+
+
+    /// The estimated cost of the cells of the global grid, relative to an
+    /// ordinary cell. Cells with open completions of the wells at the first
+    /// simulated report step, i.e. the restart step of a restarted run, are
+    /// more expensive, more so for multi-segment wells, and the cost of a
+    /// previous run is added relative to its mean.
+    template <class Grid>
+    std::vector<double> partitionCellWeights(const Grid& grid,
+                                             const EclipseState& eclipseState,
+                                             const PartitionWeightParameters& param)
+    {
+        const int numCells = UgGridHelpers::numCells(grid);
+        std::vector<double> weights(numCells, 1.0);
+
+        const int* globalCell = UgGridHelpers::globalCell(grid);
+        const int* cartDims = UgGridHelpers::cartDims(grid);
+        std::unordered_map<int, int> cartesianToCompressed;
+        for (int cell = 0; cell < numCells; ++cell) {
+            cartesianToCompressed[globalCell ? globalCell[cell] : cell] = cell;
+        }
+
+        const std::size_t timeStep = eclipseState.getInitConfig().getRestartStep();
+        for (const auto* well : eclipseState.getSchedule().getWells(timeStep)) {
+            if (well->getStatus(timeStep) == WellCommon::SHUT) {
+                continue;
+            }
+            const double weight = param.completion_weight_
+                + (well->isMultiSegment(timeStep) ? param.multisegment_weight_ : 0.0);
+            const auto& completionSet = well->getCompletions(timeStep);
+            for (std::size_t c = 0; c < completionSet.size(); ++c) {
+                const auto& completion = completionSet.get(c);
+                if (completion.getState() != WellCompletion::OPEN) {
+                    continue;
+                }
+                const int cartesianIdx = completion.getI()
+                    + cartDims[0]*(completion.getJ() + cartDims[1]*completion.getK());
+                const auto cell = cartesianToCompressed.find(cartesianIdx);
+                if (cell != cartesianToCompressed.end()) {
+                    weights[cell->second] += weight;
+                }
+            }
+        }
+
+        if (!param.cost_file_.empty()) {
+            const std::vector<double> cost = readPartitionCost(param.cost_file_, numCells);
+            double meanCost = 0.0;
+            for (const double value : cost) {
+                meanCost += value;
+            }
+            meanCost /= numCells;
+            if (meanCost > 0.0) {
+                for (int cell = 0; cell < numCells; ++cell) {
+                    weights[cell] += cost[cell] / meanCost;
+                }
+            }
+        }
+
+        return weights;
+    }
+
+
+
+    /// The weights of the faces of the grid for the graph partitioner: the
+    /// magnitudes of the numFaces transmissibilities, scaled by the mean
+    /// weight of the two cells of a face.
+    ///
+    /// The partitioner of CpGrid balances the number of cells and takes
+    /// no cell weights, so the cost of the cells enters through the faces:
+    /// stronger connections keep expensive cells, e.g. around a well, on
+    /// one process and away from the process boundaries, where the cells
+    /// of the overlap are assembled on both processes.
+    template <class FaceCells>
+    std::vector<double> partitionEdgeWeights(const FaceCells& faceCells,
+                                             const int numFaces,
+                                             const double* transmissibility,
+                                             const std::vector<double>& cellWeights)
+    {
+        std::vector<double> weights(numFaces);
+        for (int face = 0; face < numFaces; ++face) {
+            const int c1 = faceCells(face, 0);
+            const int c2 = faceCells(face, 1);
+            double scale = 1.0;
+            if (c1 >= 0 && c2 >= 0) {
+                scale = 0.5 * (cellWeights[c1] + cellWeights[c2]);
+            }
+            weights[face] = std::abs(transmissibility[face]) * scale;
+        }
+        return weights;
+    }
+
+} // namespace Opm
+
+#endif // OPM_PARTITIONWEIGHTS_HEADER_INCLUDED
@@ -0,0 +1,212 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_PERFORATIONBLOCKS_HEADER_INCLUDED
+#define OPM_PERFORATIONBLOCKS_HEADER_INCLUDED
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace Opm
+{
+
+    /// The coupling blocks between wells and their perforated cells, such as
+    /// the B and C matrices of the well equations, stored as one block per
+    /// perforation in the order of the perforations.
+    ///
+    /// The perforations of well w are [wellBegin(w), wellEnd(w)). Unlike a
+    /// wells x cells BCRS matrix the structure is set up by copying the
+    /// perforation offsets and cells, and the products are plain loops over
+    /// the perforations. If a well perforates a cell more than once, the
+    /// blocks of these perforations act as their sum.
+    template <class Block>
+    class PerforationBlocks
+    {
+    public:
+        typedef Block block_type;
+        typedef typename Block::field_type field_type;
+
+        PerforationBlocks()
+            : wellStart_(1, 0)
+        {
+        }
+
+        /// Set up the structure from the perforation offsets of the wells,
+        /// of size nw + 1, and the cells of all perforations.
+        void init(const int nw, const int* wellStart, const int* cells)
+        {
+            wellStart_.assign(wellStart, wellStart + nw + 1);
+            const int nperf = wellStart_.back();
+            cells_.assign(cells, cells + nperf);
+            blocks_.clear();
+            blocks_.resize(nperf);
+            *this = 0.0;
+        }
+
+        /// Set all blocks to a value.
+        PerforationBlocks& operator=(const field_type value)
+        {
+            for (auto& block : blocks_) {
+                block = value;
+            }
+            return *this;
+        }
+
+        int numWells() const { return wellStart_.size() - 1; }
+        int numPerforations() const { return cells_.size(); }
+
+        int wellBegin(const int w) const { return wellStart_[w]; }
+        int wellEnd(const int w) const { return wellStart_[w+1]; }
+
+        /// The cell of a perforation.
+        int cell(const int perf) const { return cells_[perf]; }
+
+        /// The block of a perforation.
+        Block& operator[](const int perf) { return blocks_[perf]; }
+        const Block& operator[](const int perf) const { return blocks_[perf]; }
+
+        /// y_w = sum of the blocks of well w times x of their cells, for all wells.
+        template <class X, class Y>
+        void mv(const X& x, Y& y) const
+        {
+            y = 0.0;
+            umv(x, y);
+        }
+
+        /// y_w += sum of the blocks of well w times x of their cells.
+        template <class X, class Y>
+        void umv(const X& x, Y& y) const
+        {
+            assert(static_cast<int>(y.size()) == numWells());
+            const int nw = numWells();
+            for (int w = 0; w < nw; ++w) {
+                for (int perf = wellStart_[w]; perf < wellStart_[w+1]; ++perf) {
+                    blocks_[perf].umv(x[cells_[perf]], y[w]);
+                }
+            }
+        }
+
+        /// y_w -= sum of the blocks of well w times x of their cells.
+        template <class X, class Y>
+        void mmv(const X& x, Y& y) const
+        {
+            assert(static_cast<int>(y.size()) == numWells());
+            const int nw = numWells();
+            for (int w = 0; w < nw; ++w) {
+                for (int perf = wellStart_[w]; perf < wellStart_[w+1]; ++perf) {
+                    blocks_[perf].mmv(x[cells_[perf]], y[w]);
+                }
+            }
+        }
+
+        /// x_c -= the transposed blocks of the perforations in cell c times
+        /// y of their wells, i.e. the transposed product of mmv.
+        template <class Y, class X>
+        void mmtv(const Y& y, X& x) const
+        {
+            assert(static_cast<int>(y.size()) == numWells());
+            const int nw = numWells();
+            for (int w = 0; w < nw; ++w) {
+                for (int perf = wellStart_[w]; perf < wellStart_[w+1]; ++perf) {
+                    blocks_[perf].mmtv(y[w], x[cells_[perf]]);
+                }
+            }
+        }
+
+        /// Copy the blocks to a wells x cells BCRS matrix, e.g. for inspection.
+        template <class Matrix>
+        void copyTo(const int numCells, Matrix& matrix) const
+        {
+            const int nw = numWells();
+            Matrix result(nw, numCells, numPerforations(), Matrix::row_wise);
+            for (auto row = result.createbegin(), end = result.createend(); row != end; ++row) {
+                for (int perf = wellStart_[row.index()]; perf < wellStart_[row.index()+1]; ++perf) {
+                    row.insert(cells_[perf]);
+                }
+            }
+            result = 0.0;
+            for (int w = 0; w < nw; ++w) {
+                for (int perf = wellStart_[w]; perf < wellStart_[w+1]; ++perf) {
+                    result[w][cells_[perf]] += blocks_[perf];
+                }
+            }
+            matrix = result;
+        }
+
+        /// The number of bytes held by the blocks and the perforation structure.
+        std::size_t memoryUsage() const
+        {
+            return (wellStart_.capacity() + cells_.capacity())*sizeof(int)
+                + blocks_.capacity()*sizeof(Block);
+        }
+
+    private:
+        std::vector<int> wellStart_;
+        std::vector<int> cells_;
+        std::vector<Block> blocks_;
+    };
+
+    namespace detail
+    {
+        /// \brief Check whether the matrix has an entry for every pair of
+        ///        cells perforated by well w.
+        template <class Block, class Matrix>
+        bool hasWellCouplings(const PerforationBlocks<Block>& blocks, const int w, const Matrix& A)
+        {
+            for (int i = blocks.wellBegin(w); i < blocks.wellEnd(w); ++i) {
+                for (int j = blocks.wellBegin(w); j < blocks.wellEnd(w); ++j) {
+                    if (!A.exists(blocks.cell(i), blocks.cell(j))) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /// \brief Subtract the Schur complement B^T inv(D) C of well w from
+        ///        the matrix, which must have all couplings of the well.
+        ///
+        /// The blocks of B are stored transposed, as applied by
+        /// PerforationBlocks::mmtv, and all blocks are square.
+        template <class Block, class Matrix>
+        void subtractWellSchurComplement(const PerforationBlocks<Block>& B, const Block& invD,
+                                         const PerforationBlocks<Block>& C, const int w, Matrix& A)
+        {
+            static const int n = Block::rows;
+            for (int j = C.wellBegin(w); j < C.wellEnd(w); ++j) {
+                Block invDC(invD);
+                invDC.rightmultiply(C[j]);
+                for (int i = B.wellBegin(w); i < B.wellEnd(w); ++i) {
+                    auto& block = A[B.cell(i)][C.cell(j)];
+                    for (int r = 0; r < n; ++r) {
+                        for (int c = 0; c < n; ++c) {
+                            for (int k = 0; k < n; ++k) {
+                                block[r][c] -= B[i][k][r] * invDC[k][c];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    } // namespace detail
+
+} // namespace Opm
+
+#endif // OPM_PERFORATIONBLOCKS_HEADER_INCLUDED
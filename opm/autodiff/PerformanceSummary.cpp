@@ -0,0 +1,126 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#include <opm/autodiff/PerformanceSummary.hpp>
+#include <opm/core/simulator/SimulatorReport.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace Opm
+{
+
+    namespace
+    {
+        const int formatVersion = 1;
+
+        const char* phaseNames[ PerformanceSummary::NumPhases ] = {
+            "setup",
+            "simulation"
+        };
+
+        double wallTime()
+        {
+            const auto now = std::chrono::steady_clock::now().time_since_epoch();
+            return std::chrono::duration<double>(now).count();
+        }
+    } // anonymous namespace
+
+
+    PerformanceSummary::PerformanceSummary()
+        : start_(wallTime())
+    {
+        time_.fill(0.0);
+        peakRss_.fill(0.0);
+    }
+
+
+    void PerformanceSummary::endPhase(const Phase phase)
+    {
+        const double now = wallTime();
+        time_[phase] += now - start_;
+        peakRss_[phase] = peakResidentSetSize();
+        start_ = now;
+    }
+
+
+    void PerformanceSummary::write(const std::string& filename,
+                                   const std::string& simulator,
+                                   const std::string& caseName,
+                                   const int numProcesses,
+                                   const int numCells,
+                                   const SimulatorReport& success,
+                                   const SimulatorReport& failure) const
+    {
+        std::ofstream file(filename.c_str());
+        if (!file) {
+            OPM_THROW(std::runtime_error, "Could not open performance summary file " << filename);
+        }
+        file << std::setprecision(10);
+        file << "{\n"
+             << "  \"format_version\": " << formatVersion << ",\n"
+             << "  \"simulator\": \"" << simulator << "\",\n"
+             << "  \"case\": \"" << caseName << "\",\n"
+             << "  \"processes\": " << numProcesses << ",\n"
+             << "  \"cells\": " << numCells << ",\n"
+             << "  \"converged\": " << (success.converged ? "true" : "false") << ",\n";
+        for (int phase = 0; phase < NumPhases; ++phase) {
+            file << "  \"" << phaseNames[phase] << "_wall_time\": " << time_[phase] << ",\n"
+                 << "  \"" << phaseNames[phase] << "_peak_rss_kb\": " << peakRss_[phase] << ",\n";
+        }
+        file << "  \"total_time\": " << success.total_time << ",\n"
+             << "  \"solver_time\": " << success.solver_time << ",\n"
+             << "  \"assemble_time\": " << success.assemble_time << ",\n"
+             << "  \"linear_solve_time\": " << success.linear_solve_time << ",\n"
+             << "  \"update_time\": " << success.update_time << ",\n"
+             << "  \"output_write_time\": " << success.output_write_time << ",\n"
+             << "  \"newton_iterations\": " << success.total_newton_iterations << ",\n"
+             << "  \"linear_iterations\": " << success.total_linear_iterations << ",\n"
+             << "  \"linearizations\": " << success.total_linearizations << ",\n"
+             << "  \"well_iterations\": " << success.total_well_iterations << ",\n"
+             << "  \"failed_time\": " << failure.total_time << ",\n"
+             << "  \"failed_newton_iterations\": " << failure.total_newton_iterations << ",\n"
+             << "  \"failed_linear_iterations\": " << failure.total_linear_iterations << "\n"
+             << "}\n";
+    }
+
+
+    double PerformanceSummary::peakResidentSetSize()
+    {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0.0;
+        }
+#ifdef __APPLE__
+        // bytes on macOS
+        return usage.ru_maxrss / 1024.0;
+#else
+        // kilobytes on Linux
+        return usage.ru_maxrss;
+#endif
+    }
+
+} // namespace Opm
@@ -0,0 +1,95 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_PERFORMANCESUMMARY_HEADER_INCLUDED
+#define OPM_PERFORMANCESUMMARY_HEADER_INCLUDED
+
+#include <array>
+#include <string>
+
+namespace Opm
+{
+
+    struct SimulatorReport;
+
+    /// Records the wall time and the peak resident set size of the phases
+    /// of a simulation run and writes them, together with the totals of the
+    /// SimulatorReport of the run, to a JSON file.
+    ///
+    /// The file holds a single object with one key per line in a fixed
+    /// order, so that it may be compared with a baseline by line based
+    /// tools, see tests/run-performanceTest.sh. The format_version key is
+    /// increased whenever keys are renamed or removed.
+    class PerformanceSummary
+    {
+    public:
+        /// The phases of a run that are recorded.
+        enum Phase {
+            Setup = 0,
+            Simulation,
+            NumPhases
+        };
+
+        /// Start the first phase.
+        PerformanceSummary();
+
+        /// End a phase and start the next one. The peak resident set size
+        /// is the high-water mark of the process at the end of the phase.
+        void endPhase(const Phase phase);
+
+        /// Take the maximum of the times and memory use over all processes
+        /// of the collective communication comm.
+        template <class Communication>
+        void reduce(const Communication& comm)
+        {
+            for (int phase = 0; phase < NumPhases; ++phase) {
+                time_[phase] = comm.max(time_[phase]);
+                peakRss_[phase] = comm.max(peakRss_[phase]);
+            }
+        }
+
+        /// Write the summary.
+        /// \param[in] filename      name of the file to write
+        /// \param[in] simulator     name of the simulator
+        /// \param[in] caseName      name of the case
+        /// \param[in] numProcesses  number of processes of the run
+        /// \param[in] numCells      global number of active cells
+        /// \param[in] success       report of the converged time steps
+        /// \param[in] failure       report of the failed time steps
+        void write(const std::string& filename,
+                   const std::string& simulator,
+                   const std::string& caseName,
+                   const int numProcesses,
+                   const int numCells,
+                   const SimulatorReport& success,
+                   const SimulatorReport& failure) const;
+
+        /// The peak resident set size of this process in kB so far, zero
+        /// where it is not available.
+        static double peakResidentSetSize();
+
+    private:
+        double start_;
+        std::array<double, NumPhases> time_;
+        std::array<double, NumPhases> peakRss_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_PERFORMANCESUMMARY_HEADER_INCLUDED
@@ -0,0 +1,154 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <opm/autodiff/PerformanceTrace.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <chrono>
+#include <iomanip>
+#include <stdexcept>
+
+namespace Opm
+{
+
+    namespace
+    {
+        const char* phaseNames[ PerformanceTrace::NumPhases ] = {
+            "assembly",
+            "well_assembly",
+            "convert_results",
+            "preconditioner_setup",
+            "linear_solve",
+            "update_state"
+        };
+
+        std::string rankFilename(const std::string& filename, const int rank, const int size)
+        {
+            if (size <= 1) {
+                return filename;
+            }
+            const std::string::size_type dot = filename.find_last_of('.');
+            const std::string::size_type slash = filename.find_last_of('/');
+            const std::string suffix = "." + std::to_string(rank);
+            if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+                return filename + suffix;
+            }
+            return filename.substr(0, dot) + suffix + filename.substr(dot);
+        }
+
+        bool hasJsonExtension(const std::string& filename)
+        {
+            const std::string ext(".json");
+            return filename.size() >= ext.size()
+                && filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+        }
+    } // anonymous namespace
+
+
+    PerformanceTrace::PerformanceTrace(const std::string& filename, const int rank, const int size)
+        : filename_(rankFilename(filename, rank, size))
+        , file_(filename_.c_str())
+        , json_(hasJsonExtension(filename_))
+        , rank_(rank)
+        , active_(false)
+        , reportStep_(0)
+        , timeStep_(0)
+        , iteration_(0)
+        , timestamp_(0.0)
+        , linearIterations_(0)
+    {
+        if (!file_) {
+            OPM_THROW(std::runtime_error, "Could not open performance trace file " << filename_);
+        }
+        // enough digits for the microseconds of the timestamp
+        file_ << std::setprecision(16);
+        times_.fill(0.0);
+        writeHeader();
+    }
+
+
+    void PerformanceTrace::beginIteration(const int reportStep, const int timeStep, const int iteration)
+    {
+        active_ = true;
+        reportStep_ = reportStep;
+        timeStep_ = timeStep;
+        iteration_ = iteration;
+        linearIterations_ = 0;
+        times_.fill(0.0);
+
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+        timestamp_ = std::chrono::duration<double>(now).count();
+    }
+
+
+    void PerformanceTrace::record(const Phase phase, const double seconds)
+    {
+        times_[phase] += seconds;
+    }
+
+
+    void PerformanceTrace::setLinearIterations(const int iterations)
+    {
+        linearIterations_ = iterations;
+    }
+
+
+    void PerformanceTrace::endIteration()
+    {
+        if (!active_) {
+            return;
+        }
+        active_ = false;
+
+        if (json_) {
+            file_ << "{\"rank\": " << rank_
+                  << ", \"report_step\": " << reportStep_
+                  << ", \"time_step\": " << timeStep_
+                  << ", \"iteration\": " << iteration_
+                  << ", \"timestamp\": " << timestamp_;
+            for (int phase = 0; phase < NumPhases; ++phase) {
+                file_ << ", \"" << phaseNames[phase] << "\": " << times_[phase];
+            }
+            file_ << ", \"linear_iterations\": " << linearIterations_ << "}\n";
+        }
+        else {
+            file_ << rank_ << ',' << reportStep_ << ',' << timeStep_ << ',' << iteration_ << ','
+                  << timestamp_;
+            for (int phase = 0; phase < NumPhases; ++phase) {
+                file_ << ',' << times_[phase];
+            }
+            file_ << ',' << linearIterations_ << '\n';
+        }
+        file_.flush();
+    }
+
+
+    void PerformanceTrace::writeHeader()
+    {
+        if (json_) {
+            return;
+        }
+        file_ << "rank,report_step,time_step,iteration,timestamp";
+        for (int phase = 0; phase < NumPhases; ++phase) {
+            file_ << ',' << phaseNames[phase];
+        }
+        file_ << ",linear_iterations\n";
+    }
+
+} // namespace Opm
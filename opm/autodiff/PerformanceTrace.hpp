@@ -0,0 +1,91 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_PERFORMANCETRACE_HEADER_INCLUDED
+#define OPM_PERFORMANCETRACE_HEADER_INCLUDED
+
+#include <array>
+#include <fstream>
+#include <string>
+
+namespace Opm
+{
+
+    /// Records the time spent in the phases of every Newton iteration and
+    /// writes one record per iteration to a file, either as CSV or, if the
+    /// file name ends in ".json", as JSON lines (one object per line).
+    ///
+    /// In parallel runs every rank writes its own file, the rank is
+    /// inserted before the extension of the file name.
+    class PerformanceTrace
+    {
+    public:
+        /// The phases of a Newton iteration that are timed.
+        enum Phase {
+            Assembly = 0,
+            WellAssembly,
+            ConvertResults,
+            PreconditionerSetup,
+            LinearSolve,
+            UpdateState,
+            NumPhases
+        };
+
+        /// Open the trace file.
+        /// \param[in] filename   name of the trace file
+        /// \param[in] rank       rank of this process
+        /// \param[in] size       number of processes
+        PerformanceTrace(const std::string& filename, const int rank, const int size);
+
+        /// Start the record of a Newton iteration.
+        void beginIteration(const int reportStep, const int timeStep, const int iteration);
+
+        /// Add the time in seconds spent in a phase of the current iteration.
+        void record(const Phase phase, const double seconds);
+
+        /// Set the number of linear iterations of the current iteration.
+        void setLinearIterations(const int iterations);
+
+        /// Write the record of the current iteration.
+        void endIteration();
+
+        /// The name of the file written by this process.
+        const std::string& filename() const { return filename_; }
+
+    private:
+        void writeHeader();
+
+        std::string filename_;
+        std::ofstream file_;
+        bool json_;
+        int rank_;
+
+        // the current record
+        bool active_;
+        int reportStep_;
+        int timeStep_;
+        int iteration_;
+        double timestamp_;
+        int linearIterations_;
+        std::array<double, NumPhases> times_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_PERFORMANCETRACE_HEADER_INCLUDED
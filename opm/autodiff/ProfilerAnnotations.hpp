@@ -0,0 +1,121 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef OPM_PROFILERANNOTATIONS_HEADER_INCLUDED
+#define OPM_PROFILERANNOTATIONS_HEADER_INCLUDED
+
+/// OPM_PROFILE_REGION(name) marks the rest of the enclosing scope as a
+/// named range for an external profiler, where name is a string literal.
+/// The profiler is chosen when configuring with PROFILER_ANNOTATIONS:
+///
+///  - ITT:    tasks of the domain opm-simulators for Intel VTune,
+///  - NVTX:   ranges of the NVIDIA Tools Extension for Nsight Systems,
+///  - SCOREP: user regions of Score-P, when compiled with the scorep
+///            compiler wrapper and its --user option.
+///
+/// Without any of them the macro expands to nothing.
+
+#if HAVE_ITT
+
+#include <ittnotify.h>
+
+namespace Opm
+{
+namespace detail
+{
+    class IttRegion
+    {
+    public:
+        explicit IttRegion(__itt_string_handle* name)
+        {
+            __itt_task_begin(domain(), __itt_null, __itt_null, name);
+        }
+
+        ~IttRegion()
+        {
+            __itt_task_end(domain());
+        }
+
+        IttRegion(const IttRegion&) = delete;
+        IttRegion& operator=(const IttRegion&) = delete;
+
+        static __itt_domain* domain()
+        {
+            static __itt_domain* const d = __itt_domain_create("opm-simulators");
+            return d;
+        }
+    };
+} // namespace detail
+} // namespace Opm
+
+#define OPM_PROFILE_REGION(name)                                                       \
+    static __itt_string_handle* const OPM_PROFILE_NAME_(opmProfileHandle, __LINE__) =  \
+        __itt_string_handle_create(name);                                              \
+    ::Opm::detail::IttRegion OPM_PROFILE_NAME_(opmProfileRegion, __LINE__)             \
+        (OPM_PROFILE_NAME_(opmProfileHandle, __LINE__))
+
+#elif HAVE_NVTX
+
+#include <nvToolsExt.h>
+
+namespace Opm
+{
+namespace detail
+{
+    class NvtxRegion
+    {
+    public:
+        explicit NvtxRegion(const char* name)
+        {
+            nvtxRangePushA(name);
+        }
+
+        ~NvtxRegion()
+        {
+            nvtxRangePop();
+        }
+
+        NvtxRegion(const NvtxRegion&) = delete;
+        NvtxRegion& operator=(const NvtxRegion&) = delete;
+    };
+} // namespace detail
+} // namespace Opm
+
+#define OPM_PROFILE_REGION(name) \
+    ::Opm::detail::NvtxRegion OPM_PROFILE_NAME_(opmProfileRegion, __LINE__)(name)
+
+#elif defined(SCOREP_USER_ENABLE)
+
+#include <scorep/SCOREP_User.h>
+
+#define OPM_PROFILE_REGION(name) \
+    SCOREP_USER_REGION(name, SCOREP_USER_REGION_TYPE_COMMON)
+
+#else
+
+#define OPM_PROFILE_REGION(name)
+
+#endif
+
+// a unique name of a local variable per line
+#define OPM_PROFILE_NAME_(prefix, line) OPM_PROFILE_NAME_IMPL_(prefix, line)
+#define OPM_PROFILE_NAME_IMPL_(prefix, line) prefix ## line
+
+#endif // OPM_PROFILERANNOTATIONS_HEADER_INCLUDED
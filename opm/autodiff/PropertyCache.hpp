@@ -0,0 +1,123 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_PROPERTYCACHE_HEADER_INCLUDED
+#define OPM_PROPERTYCACHE_HEADER_INCLUDED
+
+#include <opm/autodiff/AutoDiffBlock.hpp>
+
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+namespace Opm
+{
+
+    /// The results of the last evaluation of a property function, such as
+    /// the relative permeabilities of the saturations, kept for reuse.
+    ///
+    /// The results are valid for one version of the state, which the owner
+    /// changes whenever anything but the arguments that the function
+    /// depends on may have changed, e.g. the phase condition. They are
+    /// returned for arguments of the same values and block pattern. For
+    /// arguments without derivatives, the results are also returned
+    /// without their derivatives.
+    class PropertyCache
+    {
+    public:
+        typedef AutoDiffBlock<double> ADB;
+
+        PropertyCache()
+            : version_(0)
+            , valid_(false)
+        {
+        }
+
+        /// Copy the results stored for the arguments in the given version
+        /// to results, and return true if there are any.
+        bool find(const unsigned long version,
+                  std::initializer_list<const ADB*> args,
+                  std::vector<ADB>& results) const
+        {
+            if (!valid_ || version != version_ || args.size() != args_.size()) {
+                return false;
+            }
+            bool constant = true;
+            bool samePattern = true;
+            std::size_t i = 0;
+            for (const ADB* arg : args) {
+                const ADB::V& value = arg->value();
+                if (value.size() != args_[i].size() || !(value == args_[i]).all()) {
+                    return false;
+                }
+                constant = constant && arg->numBlocks() == 0;
+                samePattern = samePattern && arg->blockPattern() == patterns_[i];
+                ++i;
+            }
+            if (samePattern) {
+                results = results_;
+            } else if (constant) {
+                results.clear();
+                results.reserve(results_.size());
+                for (const ADB& result : results_) {
+                    results.push_back(ADB::constant(result.value()));
+                }
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        /// Store the results of the arguments in the given version,
+        /// replacing any results stored before.
+        void store(const unsigned long version,
+                   std::initializer_list<const ADB*> args,
+                   const std::vector<ADB>& results)
+        {
+            version_ = version;
+            args_.clear();
+            patterns_.clear();
+            for (const ADB* arg : args) {
+                args_.push_back(arg->value());
+                patterns_.push_back(arg->blockPattern());
+            }
+            results_ = results;
+            valid_ = true;
+        }
+
+        /// Release the stored results.
+        void clear()
+        {
+            valid_ = false;
+            args_.clear();
+            patterns_.clear();
+            results_.clear();
+        }
+
+    private:
+        unsigned long version_;
+        bool valid_;
+        std::vector<ADB::V> args_;
+        std::vector<std::vector<int> > patterns_;
+        std::vector<ADB> results_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_PROPERTYCACHE_HEADER_INCLUDED
@@ -0,0 +1,114 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <opm/autodiff/RankLoadReport.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+namespace Opm
+{
+
+    namespace
+    {
+        const char* quantityNames[ RankLoadReport::NumQuantities ] = {
+            "assembly [s]",
+            "well assembly [s]",
+            "linear solve [s]",
+            "output [s]",
+            "owned cells",
+            "perforations"
+        };
+    } // anonymous namespace
+
+
+    double RankLoadReport::imbalance(const Quantity quantity) const
+    {
+        double sum = 0.0;
+        double max = 0.0;
+        for (int rank = 0; rank < numProcesses_; ++rank) {
+            sum += value(quantity, rank);
+            max = std::max(max, value(quantity, rank));
+        }
+        if (sum <= 0.0) {
+            return 1.0;
+        }
+        return max / (sum / numProcesses_);
+    }
+
+
+    std::vector<int> RankLoadReport::worstRanks(const Quantity quantity, const int n) const
+    {
+        std::vector<int> ranks(numProcesses_);
+        std::iota(ranks.begin(), ranks.end(), 0);
+        const int count = std::min(n, numProcesses_);
+        // the lower rank first among equal values
+        std::partial_sort(ranks.begin(), ranks.begin() + count, ranks.end(),
+                          [this, quantity](const int a, const int b) {
+                              return value(quantity, a) > value(quantity, b)
+                                  || (value(quantity, a) == value(quantity, b) && a < b);
+                          });
+        ranks.resize(count);
+        return ranks;
+    }
+
+
+    std::string RankLoadReport::format(const int numWorst) const
+    {
+        std::ostringstream os;
+        os << "Load balance over " << numProcesses_ << " processes:\n";
+        os << std::left << std::setw(20) << "" << std::right
+           << std::setw(12) << "min"
+           << std::setw(12) << "mean"
+           << std::setw(12) << "max"
+           << std::setw(10) << "max/mean"
+           << "  worst ranks\n";
+        os << std::fixed;
+        for (int q = 0; q < NumQuantities; ++q) {
+            const Quantity quantity = static_cast<Quantity>(q);
+            double min = numProcesses_ > 0 ? value(quantity, 0) : 0.0;
+            double max = min;
+            double sum = 0.0;
+            for (int rank = 0; rank < numProcesses_; ++rank) {
+                min = std::min(min, value(quantity, rank));
+                max = std::max(max, value(quantity, rank));
+                sum += value(quantity, rank);
+            }
+            const double mean = numProcesses_ > 0 ? sum / numProcesses_ : 0.0;
+            // the counts without decimals
+            const int precision = quantity >= OwnedCells ? 0 : 2;
+            os << std::left << std::setw(20) << quantityNames[q] << std::right
+               << std::setprecision(precision)
+               << std::setw(12) << min
+               << std::setw(12) << mean
+               << std::setw(12) << max
+               << std::setprecision(2)
+               << std::setw(10) << imbalance(quantity) << " ";
+            for (const int rank : worstRanks(quantity, numWorst)) {
+                os << " " << rank;
+            }
+            os << "\n";
+        }
+        return os.str();
+    }
+
+} // namespace Opm
@@ -0,0 +1,102 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef OPM_RANKLOADREPORT_HEADER_INCLUDED
+#define OPM_RANKLOADREPORT_HEADER_INCLUDED
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    /// The work of every process of a parallel run: the times of its
+    /// phases and the number of its cells and perforations, gathered on
+    /// one process at the end of the run. The imbalance of a quantity is
+    /// its maximum over its mean, the worst ranks are those with the
+    /// largest values.
+    class RankLoadReport
+    {
+    public:
+        /// The quantities of a process.
+        enum Quantity {
+            Assembly = 0,
+            WellAssembly,
+            LinearSolve,
+            Output,
+            OwnedCells,
+            Perforations,
+            NumQuantities
+        };
+
+        RankLoadReport()
+            : numProcesses_(0)
+        {
+            local_.fill(0.0);
+        }
+
+        /// Set a quantity of this process.
+        void set(const Quantity quantity, const double value)
+        {
+            local_[quantity] = value;
+        }
+
+        /// Gather the quantities of all processes on the root process,
+        /// collective over the processes of comm.
+        template <class Communication>
+        void gather(const Communication& comm, const int root = 0)
+        {
+            numProcesses_ = comm.size();
+            values_.assign(NumQuantities * numProcesses_, 0.0);
+            comm.gather(local_.data(), values_.data(), NumQuantities, root);
+        }
+
+        /// The number of processes, zero before gather().
+        int numProcesses() const
+        {
+            return numProcesses_;
+        }
+
+        /// A quantity of a process, only on the root process.
+        double value(const Quantity quantity, const int rank) const
+        {
+            return values_[rank * NumQuantities + quantity];
+        }
+
+        /// The maximum over the mean of a quantity, 1 if the mean is zero.
+        double imbalance(const Quantity quantity) const;
+
+        /// The n ranks with the largest values of a quantity, largest first.
+        std::vector<int> worstRanks(const Quantity quantity, const int n) const;
+
+        /// The table of the minimum, mean, maximum and imbalance of each
+        /// quantity with its worst ranks, only on the root process.
+        std::string format(const int numWorst = 3) const;
+
+    private:
+        std::array<double, NumQuantities> local_;
+        int numProcesses_;
+        std::vector<double> values_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_RANKLOADREPORT_HEADER_INCLUDED
@@ -22,6 +22,7 @@
 #define OPM_RATECONVERTER_HPP_HEADER_INCLUDED
 
 #include <opm/autodiff/BlackoilPropsAdFromDeck.hpp>
+#include <opm/autodiff/CellDataView.hpp>
 
 #include <opm/core/props/BlackoilPhases.hpp>
 #include <opm/core/simulator/BlackoilState.hpp>
@@ -397,6 +398,10 @@ namespace Opm {
             /**
              * Constructor.
              *
+             * \param[in] cellPvtRegionIdx PVT region of each cell, not
+             * copied and must outlive the converter.  All cells are in
+             * region zero if null.
+             *
              * \param[in] region Forward region mapping.  Often
              * corresponds to the "FIPNUM" mapping of an ECLIPSE input
              * deck.
@@ -405,14 +410,31 @@ namespace Opm {
                                       const int* cellPvtRegionIdx,
                                       const int numCells,
                                       const Region&   region)
+                : SurfaceToReservoirVoidage(phaseUsage,
+                                            cellPvtRegionIdx
+                                            ? CellDataView<int>(cellPvtRegionIdx, numCells)
+                                            : CellDataView<int>(numCells, [](int) { return 0; }),
+                                            region)
+            {
+            }
+
+            /**
+             * Constructor.
+             *
+             * \param[in] cellPvtRegionIdx View of the PVT region of
+             * each cell, e.g. computed from the simulator's problem
+             * on access.  Its data must outlive the converter.
+             *
+             * \param[in] region Forward region mapping.
+             */
+            SurfaceToReservoirVoidage(const PhaseUsage& phaseUsage,
+                                      CellDataView<int> cellPvtRegionIdx,
+                                      const Region&   region)
                 : phaseUsage_(phaseUsage)
+                , cellPvtIdx_(std::move(cellPvtRegionIdx))
                 , rmap_ (region)
                 , attr_ (rmap_, Attributes(phaseUsage_.num_phases))
             {
-                cellPvtIdx_.resize(numCells, 0);
-                if (cellPvtRegionIdx) {
-                    std::copy_n(cellPvtRegionIdx, numCells, cellPvtIdx_.begin());
-                }
             }
 
             /**
@@ -449,6 +471,7 @@ namespace Opm {
                     calcAverages<false>(state, info, dummyOwnership);
                 }   
                 calcRmax();
+                calcInverseFVF();
             }
             /**
              * Region identifier.
@@ -502,9 +525,7 @@ namespace Opm {
                 if (Details::PhaseUsed::water(pu)) {
                     // q[w]_r = q[w]_s / bw
 
-                    const double bw = FluidSystem::waterPvt().inverseFormationVolumeFactor(pvtRegionIdx, T, p);
-
-                    coeff[iw] = 1.0 / bw;
+                    coeff[iw] = 1.0 / ra.bw;
                 }
 
                 const Miscibility& m = calcMiscibility(in, r);
@@ -516,7 +537,9 @@ namespace Opm {
                     // q[o]_r = 1/(bo * (1 - rs*rv)) * (q[o]_s - rv*q[g]_s)
 
                     const double Rs = m.rs;
-                    const double bo = FluidSystem::oilPvt().inverseFormationVolumeFactor(pvtRegionIdx, T, p, Rs);
+                    const double bo = (Rs == 0.0) ? ra.bo0
+                        : (Rs == ra.Rmax[io]) ? ra.boSat
+                        : FluidSystem::oilPvt().inverseFormationVolumeFactor(pvtRegionIdx, T, p, Rs);
                     const double den = bo * detR;
 
                     coeff[io] += 1.0 / den;
@@ -530,7 +553,9 @@ namespace Opm {
                     // q[g]_r = 1/(bg * (1 - rs*rv)) * (q[g]_s - rs*q[o]_s)
 
                     const double Rv = m.rv;
-                    const double bg  = FluidSystem::gasPvt().inverseFormationVolumeFactor(pvtRegionIdx, T, p, Rv);
+                    const double bg  = (Rv == 0.0) ? ra.bg0
+                        : (Rv == ra.Rmax[ig]) ? ra.bgSat
+                        : FluidSystem::gasPvt().inverseFormationVolumeFactor(pvtRegionIdx, T, p, Rv);
                     const double den = bg * detR;
 
                     coeff[ig] += 1.0 / den;
@@ -546,7 +571,7 @@ namespace Opm {
              * Fluid property object.
              */
             const PhaseUsage phaseUsage_;
-            std::vector<int> cellPvtIdx_;
+            CellDataView<int> cellPvtIdx_;
 
             /**
              * "Fluid-in-place" region mapping (forward and reverse).
@@ -561,11 +586,30 @@ namespace Opm {
                     : pressure   (0.0)
                     , temperature(0.0)
                     , Rmax(np, 0.0)
+                    , bw   (1.0)
+                    , bo0  (1.0)
+                    , boSat(1.0)
+                    , bg0  (1.0)
+                    , bgSat(1.0)
                 {}
 
                 double         pressure;
                 double         temperature;
                 std::vector<double> Rmax;
+
+                /**
+                 * Inverse formation volume factors at the average
+                 * conditions of the region, for fluids without dissolved
+                 * gas or vaporized oil (bo0, bg0) and for saturated fluids
+                 * (boSat, bgSat). Together these cover water wells,
+                 * injectors and producers with free gas without any PVT
+                 * evaluation in calcCoeff().
+                 */
+                double         bw;
+                double         bo0;
+                double         boSat;
+                double         bg0;
+                double         bgSat;
             };
 
             Details::RegionAttributes<RegionId, Attributes> attr_;
@@ -633,36 +677,45 @@ namespace Opm {
                 const auto& press = state.pressure();
                 const auto& temp  = state.temperature();
 
-                for (const auto& reg : rmap_.activeRegions()) {
-                    auto& ra = attr_.attributes(reg);
-                    auto& p  = ra.pressure;
-                    auto& T  = ra.temperature;
-
-                    std::size_t n = 0;
-                    p = T = 0.0;
-                    for (const auto& cell : rmap_.cells(reg)) {
+                // sums of pressure, temperature and number of cells of
+                // all regions, reduced over the processes in one call
+                const auto& regions = rmap_.activeRegions();
+                const int nreg = regions.size();
+                std::vector<double> sums(3 * nreg, 0.0);
+
+                for (int r = 0; r < nreg; ++r) {
+                    const auto cells = rmap_.cells(regions[r]);
+                    const int ncells = cells.size();
+                    double p = 0.0;
+                    double T = 0.0;
+                    double n = 0.0;
+#pragma omp parallel for schedule(static) reduction(+:p,T,n)
+                    for (int c = 0; c < ncells; ++c) {
                         auto increment = Details::
                             AverageIncrementCalculator<is_parallel>()(press, temp,
                                                                       ownerShip,
-                                                                      cell);
+                                                                      cells.begin()[c]);
                         p += std::get<0>(increment);
                         T += std::get<1>(increment);
                         n += std::get<2>(increment);
                     }
-                    std::size_t global_n = n;
-                    double global_p = p;
-                    double global_T = T;
+                    sums[3*r + 0] = p;
+                    sums[3*r + 1] = T;
+                    sums[3*r + 2] = n;
+                }
 #if HAVE_MPI
-                    if ( is_parallel )
-                    {
-                        const auto& real_info = boost::any_cast<const ParallelISTLInformation&>(info);
-                        global_n = real_info.communicator().sum(n);
-                        global_p = real_info.communicator().sum(p);
-                        global_T = real_info.communicator().sum(T);
-                    }
+                if ( is_parallel && nreg > 0 )
+                {
+                    const auto& real_info = boost::any_cast<const ParallelISTLInformation&>(info);
+                    real_info.communicator().sum(sums.data(), sums.size());
+                }
+#else
+                static_cast<void>(info);
 #endif
-                    p = global_p / global_n;
-                    T = global_T / global_n;
+                for (int r = 0; r < nreg; ++r) {
+                    auto& ra = attr_.attributes(regions[r]);
+                    ra.pressure    = sums[3*r + 0] / sums[3*r + 2];
+                    ra.temperature = sums[3*r + 1] / sums[3*r + 2];
                 }
             }
             /**
@@ -703,6 +756,49 @@ namespace Opm {
                 }
             }
 
+            /**
+             * Compute the rate independent inverse formation volume
+             * factors of all regions at average hydrocarbon pressure.
+             *
+             * Uses the maximum ratios computed by calcRmax() and must
+             * therefore be called *after* that method.
+             */
+            void
+            calcInverseFVF()
+            {
+                const PhaseUsage& pu = phaseUsage_;
+                const int io = Details::PhasePos::oil(pu);
+                const int ig = Details::PhasePos::gas(pu);
+                const bool miscible = Details::PhaseUsed::oil(pu) && Details::PhaseUsed::gas(pu);
+
+                for (const auto& reg : rmap_.activeRegions()) {
+                    auto& ra = attr_.attributes(reg);
+
+                    const double T = ra.temperature;
+                    const double p = ra.pressure;
+                    const int cellIdx = attr_.cell(reg);
+                    const int pvtRegionIdx = cellPvtIdx_[cellIdx];
+
+                    if (Details::PhaseUsed::water(pu)) {
+                        ra.bw = FluidSystem::waterPvt().inverseFormationVolumeFactor(pvtRegionIdx, T, p);
+                    }
+
+                    if (Details::PhaseUsed::oil(pu)) {
+                        ra.bo0 = FluidSystem::oilPvt().inverseFormationVolumeFactor(pvtRegionIdx, T, p, 0.0);
+                        ra.boSat = miscible
+                            ? FluidSystem::oilPvt().inverseFormationVolumeFactor(pvtRegionIdx, T, p, ra.Rmax[io])
+                            : ra.bo0;
+                    }
+
+                    if (Details::PhaseUsed::gas(pu)) {
+                        ra.bg0 = FluidSystem::gasPvt().inverseFormationVolumeFactor(pvtRegionIdx, T, p, 0.0);
+                        ra.bgSat = miscible
+                            ? FluidSystem::gasPvt().inverseFormationVolumeFactor(pvtRegionIdx, T, p, ra.Rmax[ig])
+                            : ra.bg0;
+                    }
+                }
+            }
+
             /**
              * Compute fluid conditions in particular region for a
              * given set of component rates at surface conditions.
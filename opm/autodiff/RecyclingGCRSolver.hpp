@@ -0,0 +1,300 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef OPM_RECYCLINGGCRSOLVER_HEADER_INCLUDED
+#define OPM_RECYCLINGGCRSOLVER_HEADER_INCLUDED
+
+#include <dune/common/timer.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/scalarproducts.hh>
+#include <dune/istl/solver.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace Opm
+{
+
+    /*!
+      \brief Restarted flexible GCR solver that recycles search directions
+             between solves.
+
+      Consecutive Newton iterations and time steps solve systems whose
+      matrices change slowly, so the slow modes found in one solve are
+      useful in the next. The solver keeps directions approximating the
+      slowest modes of a solve in a space owned by the caller. A new solve
+      starts by minimizing the residual over this space and keeps later
+      search directions orthogonal to it (GCRO), which removes these modes
+      from the Krylov iterations.
+
+      As in GCRO-DR the recycled space is spanned by the harmonic Ritz
+      vectors of the smallest harmonic Ritz values of the last search space.
+      Each recycled direction costs one operator application per solve. The
+      directions are applied with the preconditioner of the solve they
+      came from, which GCR allows since it is flexible. The solver stores
+      two vectors per search direction, i.e. for restart m and k recycled
+      directions 2 (m + k) vectors.
+
+      \tparam X The vector type of the domain and range.
+    */
+    template <class X>
+    class RecyclingGCRSolver : public Dune::InverseOperator<X,X>
+    {
+    public:
+        typedef X domain_type;
+        typedef X range_type;
+        typedef typename X::field_type field_type;
+        typedef std::vector<X> RecycledSpace;
+
+        /*! \brief Constructor.
+
+          \param op        The operator of the system.
+          \param sp        The scalar product, parallel runs need a consistent one.
+          \param prec      The preconditioner.
+          \param reduction The relative reduction of the defect to reach.
+          \param restart   The number of new search directions before a restart.
+          \param maxit     The maximum number of iterations.
+          \param verbose   Print the result of the solve if positive.
+          \param recycled  The recycled directions, updated by every solve.
+          \param numRecycled The number of directions to keep for the next solve.
+        */
+        RecyclingGCRSolver(Dune::LinearOperator<X,X>& op,
+                           Dune::ScalarProduct<X>& sp,
+                           Dune::Preconditioner<X,X>& prec,
+                           const double reduction,
+                           const int restart,
+                           const int maxit,
+                           const int verbose,
+                           RecycledSpace& recycled,
+                           const int numRecycled)
+            : op_(op),
+              sp_(sp),
+              prec_(prec),
+              reduction_(reduction),
+              restart_(std::max(restart, 1)),
+              maxit_(maxit),
+              verbose_(verbose),
+              recycled_(recycled),
+              numRecycled_(numRecycled)
+        {
+        }
+
+        virtual void apply(X& x, X& b, Dune::InverseOperatorResult& res)
+        {
+            apply(x, b, reduction_, res);
+        }
+
+        /*!
+          \brief Solve A x = b starting from x, b is overwritten with the defect.
+        */
+        virtual void apply(X& x, X& b, double reduction, Dune::InverseOperatorResult& res)
+        {
+            Dune::Timer watch;
+            res.clear();
+
+            // b is the defect from now on
+            op_.applyscaleadd(-1.0, x, b);
+            const double def0 = sp_.norm(b);
+            double def = def0;
+
+            std::vector<X> z;
+            std::vector<X> q;
+
+            // minimize the defect over the recycled directions, which
+            // stay in the search space until the end of the solve
+            X zero(x.size());
+            zero = 0.0;
+            for (const X& u : recycled_) {
+                if (u.size() != x.size()) {
+                    continue;
+                }
+                z.push_back(u);
+                q.push_back(zero);
+                op_.apply(z.back(), q.back());
+                if (!addDirection(x, b, z, q)) {
+                    z.pop_back();
+                    q.pop_back();
+                }
+            }
+            const int numKept = z.size();
+            if (numKept > 0) {
+                def = sp_.norm(b);
+            }
+
+            prec_.pre(x, b);
+            int it = 0;
+            while (it < maxit_ && def > reduction * def0 && def > 0.0) {
+                // restart: keep the recycled directions only
+                if (static_cast<int>(z.size()) - numKept >= restart_) {
+                    z.resize(numKept);
+                    q.resize(numKept);
+                }
+
+                z.push_back(zero);
+                q.push_back(zero);
+                prec_.apply(z.back(), b);
+                op_.apply(z.back(), q.back());
+                ++it;
+                if (!addDirection(x, b, z, q)) {
+                    // the preconditioned defect is in the span of the directions
+                    z.pop_back();
+                    q.pop_back();
+                    break;
+                }
+                def = sp_.norm(b);
+            }
+            prec_.post(x);
+
+            keepDirections(z, q);
+
+            res.iterations = it;
+            res.reduction = def0 > 0.0 ? def / def0 : 0.0;
+            res.converged = def <= reduction * def0;
+            res.conv_rate = it > 0 ? std::pow(res.reduction, 1.0 / it) : 0.0;
+            res.elapsed = watch.elapsed();
+
+            if (verbose_ > 0) {
+                std::cout << "=== RecyclingGCRSolver: " << numKept << " recycled directions, "
+                          << it << " iterations, reduction " << res.reduction
+                          << ", time " << res.elapsed << std::endl;
+            }
+        }
+
+    private:
+        // Orthonormalize the last q against the others, with the same
+        // operations on z such that q = A z, and update x and the defect.
+        bool addDirection(X& x, X& b, std::vector<X>& z, std::vector<X>& q) const
+        {
+            X& zn = z.back();
+            X& qn = q.back();
+            const int n = q.size() - 1;
+            for (int j = 0; j < n; ++j) {
+                const field_type beta = sp_.dot(q[j], qn);
+                qn.axpy(-beta, q[j]);
+                zn.axpy(-beta, z[j]);
+            }
+            const double norm = sp_.norm(qn);
+            if (!(norm > 0.0)) {
+                return false;
+            }
+            qn *= 1.0 / norm;
+            zn *= 1.0 / norm;
+
+            const field_type alpha = sp_.dot(qn, b);
+            x.axpy(alpha, zn);
+            b.axpy(-alpha, qn);
+            return true;
+        }
+
+        // Store the approximate invariant subspace of the smallest harmonic
+        // Ritz values of the search space in the recycled space. With
+        // Q = A Z orthonormal, the harmonic Ritz vectors Z y solve
+        // (Q^T Z) y = 1/theta y, the wanted subspace is the dominant one of
+        // G = Q^T Z, which is found by subspace iteration on the small matrix.
+        void keepDirections(const std::vector<X>& z, const std::vector<X>& q)
+        {
+            const int m = z.size();
+            const int k = std::min(m, numRecycled_);
+            RecycledSpace recycled;
+            if (k <= 0) {
+                recycled_ = std::move(recycled);
+                return;
+            }
+
+            std::vector<double> G(m*m);
+            for (int i = 0; i < m; ++i) {
+                for (int j = 0; j < m; ++j) {
+                    G[i*m + j] = sp_.dot(q[i], z[j]);
+                }
+            }
+
+            // start with the latest directions, which are closest to the slow modes
+            std::vector<double> W(m*k, 0.0);
+            for (int j = 0; j < k; ++j) {
+                W[(m - 1 - j)*k + j] = 1.0;
+            }
+            std::vector<double> GW(m*k);
+            for (int sweep = 0; sweep < subspaceIterations; ++sweep) {
+                for (int i = 0; i < m; ++i) {
+                    for (int j = 0; j < k; ++j) {
+                        double value = 0.0;
+                        for (int l = 0; l < m; ++l) {
+                            value += G[i*m + l] * W[l*k + j];
+                        }
+                        GW[i*k + j] = value;
+                    }
+                }
+                W.swap(GW);
+                orthonormalizeColumns(W, m, k);
+            }
+
+            recycled.reserve(k);
+            for (int j = 0; j < k; ++j) {
+                recycled.push_back(z[0]);
+                recycled.back() = 0.0;
+                for (int l = 0; l < m; ++l) {
+                    recycled.back().axpy(W[l*k + j], z[l]);
+                }
+            }
+            recycled_ = std::move(recycled);
+        }
+
+        // Modified Gram-Schmidt on the columns of the m x k matrix W.
+        static void orthonormalizeColumns(std::vector<double>& W, const int m, const int k)
+        {
+            for (int j = 0; j < k; ++j) {
+                for (int i = 0; i < j; ++i) {
+                    double dot = 0.0;
+                    for (int l = 0; l < m; ++l) {
+                        dot += W[l*k + i] * W[l*k + j];
+                    }
+                    for (int l = 0; l < m; ++l) {
+                        W[l*k + j] -= dot * W[l*k + i];
+                    }
+                }
+                double norm = 0.0;
+                for (int l = 0; l < m; ++l) {
+                    norm += W[l*k + j] * W[l*k + j];
+                }
+                norm = std::sqrt(norm);
+                for (int l = 0; l < m; ++l) {
+                    W[l*k + j] = norm > 0.0 ? W[l*k + j] / norm : 0.0;
+                }
+            }
+        }
+
+        static const int subspaceIterations = 30;
+
+        Dune::LinearOperator<X,X>& op_;
+        Dune::ScalarProduct<X>& sp_;
+        Dune::Preconditioner<X,X>& prec_;
+        double reduction_;
+        int restart_;
+        int maxit_;
+        int verbose_;
+        RecycledSpace& recycled_;
+        int numRecycled_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_RECYCLINGGCRSOLVER_HEADER_INCLUDED
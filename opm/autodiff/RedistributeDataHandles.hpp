@@ -22,7 +22,10 @@
 #ifndef OPM_REDISTRIBUTEDATAHANDLES_HEADER
 #define OPM_REDISTRIBUTEDATAHANDLES_HEADER
 
+#include <algorithm>
+#include <unordered_map>
 #include <unordered_set>
+#include <sstream>
 #include <string>
 #include <type_traits>
 #include <iterator>
@@ -32,6 +35,8 @@
 #include <opm/autodiff/BlackoilPropsAdFromDeck.hpp>
 #include <opm/autodiff/ExtractParallelGridInformationToISTL.hpp>
 #include <opm/autodiff/createGlobalCellArray.hpp>
+#include <opm/autodiff/PartitionWeights.hpp>
+#include <opm/common/OpmLog/OpmLog.hpp>
 
 #include<boost/any.hpp>
 
@@ -49,7 +54,8 @@ distributeGridAndData( Grid& ,
                        std::shared_ptr<BlackoilPropsAdFromDeck::MaterialLawManager>&,
                        std::vector<double>&,
                        boost::any& ,
-                       const bool )
+                       const bool ,
+                       const PartitionWeightParameters& = PartitionWeightParameters() )
 {
     return std::unordered_set<std::string>();
 }
@@ -119,169 +125,59 @@ private:
 
 
 #if HAVE_OPM_GRID && HAVE_MPI
-/// \brief a data handle to distribute the threshold pressures
-class ThresholdPressureDataHandle
+/// \brief A data handle distributing the cell and face data of the
+/// BlackoilState, the pore volumes and transmissibilities of the
+/// DerivedGeology and the threshold pressures in a single round of
+/// communication. The optional fields that are not sent keep the values
+/// the receiving containers were created with.
+class BlackoilDistributionDataHandle
 {
 public:
-    /// \brief type of the data we send
-    typedef double DataType;
-    /// \brief Constructor
-    /// \param sendGrid    The grid that the data is attached to when sending.
-    /// \param recvGrid    The grid that the data is attached to when receiving.
-    /// \param sendPressures The container where we will retrieve the values to be sent.
-    /// \param numFaces Number of faces of the distributed grid.
-    ThresholdPressureDataHandle(const Dune::CpGrid& sendGrid,
-                                const Dune::CpGrid& recvGrid,
-                                const std::vector<double>& sendPressures,
-                                std::vector<double>& recvPressures)
-        : sendGrid_(sendGrid), recvGrid_(recvGrid), sendPressures_(sendPressures),
-          recvPressures_(recvPressures)
-    {}
-
-    bool fixedsize(int /*dim*/, int /*codim*/)
-    {
-        return false;
-    }
-    template<class T>
-    std::size_t size(const T& e)
-    {
-        if ( T::codimension == 0)
-        {
-            return sendGrid_.numCellFaces(e.index());
-        }
-        else
-        {
-            OPM_THROW(std::logic_error, "Data handle can only be used for elements");
-        }
-    }
-    template<class B, class T>
-    void gather(B& buffer, const T& e)
-    {
-        assert( T::codimension == 0);
-        for ( int i=0; i< sendGrid_.numCellFaces(e.index()); ++i )
-        {
-            buffer.write(sendPressures_[sendGrid_.cellFace(e.index(), i)]);
-        }
-    }
-    template<class B, class T>
-    void scatter(B& buffer, const T& e, std::size_t /* size */)
-    {
-        assert( T::codimension == 0);
-        for ( int i=0; i< recvGrid_.numCellFaces(e.index()); ++i )
-        {
-            double val;
-            buffer.read(val);
-            recvPressures_[recvGrid_.cellFace(e.index(), i)]=val;
-        }
-    }
-    bool contains(int dim, int codim)
-    {
-        return dim==3 && codim==0;
-    }
-
-private:
-    /// \brief The grid that the data we send is associated with.
-    const Dune::CpGrid& sendGrid_;
-    /// \brief The grid that the data we receive is associated with.
-    const Dune::CpGrid& recvGrid_;
-    /// \brief The data to send.
-    const std::vector<double>& sendPressures_;
-    /// \brief The data to receive.
-    std::vector<double>& recvPressures_;
-};
-
-/// \brief a data handle to distribute Derived Geology
-class GeologyDataHandle
-{
-public:
-    /// \brief type of the data we send
-    typedef double DataType;
-    /// \brief Constructor
-    /// \param sendGrid    The grid that the data is attached to when sending.
-    /// \param recvGrid    The grid that the data is attached to when receiving.
-    /// \param sendGeology The state where we will retieve the values to be sent.
-    /// \param recvGeology The state where we will store the received values.
-    GeologyDataHandle(const Dune::CpGrid& sendGrid,
-                      const Dune::CpGrid& recvGrid,
-                      const DerivedGeology& sendGeology,
-                      DerivedGeology& recvGeology)
-        : sendGrid_(sendGrid), recvGrid_(recvGrid), sendGeology_(sendGeology),
-          recvGeology_(recvGeology)
-    {}
-
-    bool fixedsize(int /*dim*/, int /*codim*/)
-    {
-        return false;
-    }
-    template<class T>
-    std::size_t size(const T& e)
-    {
-        if ( T::codimension == 0)
-        {
-            return 1 + sendGrid_.numCellFaces(e.index());
-        }
-        else
-        {
-            OPM_THROW(std::logic_error, "Data handle can only be used for elements");
-        }
-    }
-    template<class B, class T>
-    void gather(B& buffer, const T& e)
-    {
-        assert( T::codimension == 0);
-        buffer.write(sendGeology_.poreVolume()[e.index()]);
-        for ( int i=0; i< sendGrid_.numCellFaces(e.index()); ++i )
-        {
-            buffer.write(sendGeology_.transmissibility()[sendGrid_.cellFace(e.index(), i)]);
-        }
-    }
-    template<class B, class T>
-    void scatter(B& buffer, const T& e, std::size_t /* size */)
-    {
-        assert( T::codimension == 0);
-        double val;
-        buffer.read(val);
-        recvGeology_.poreVolume()[e.index()]=val;
-        for ( int i=0; i< recvGrid_.numCellFaces(e.index()); ++i )
-        {
-            buffer.read(val);
-            recvGeology_.transmissibility()[recvGrid_.cellFace(e.index(), i)]=val;
-        }
-    }
-    bool contains(int dim, int codim)
+    /// \brief The optional fields to send.
+    struct Fields
     {
-        return dim==3 && codim==0;
-    }
-private:
-    /// \brief The grid that the data we send is associated with.
-    const Dune::CpGrid& sendGrid_;
-    /// \brief The grid that the data we receive is associated with.
-    const Dune::CpGrid& recvGrid_;
-    /// \brief The data to send.
-    const DerivedGeology& sendGeology_;
-    /// \brief The data to receive.
-    DerivedGeology& recvGeology_;
-};
+        /// \brief The dissolved gas-oil ratio.
+        bool gasOilRatio = true;
+        /// \brief The vaporized oil-gas ratio.
+        bool rv = true;
+        /// \brief The face pressures and fluxes.
+        bool faceData = true;
+        /// \brief The threshold pressures of the faces.
+        bool thresholdPressures = false;
+    };
 
-/// \brief a data handle to distribute the BlackoilState
-class BlackoilStateDataHandle
-{
-public:
     /// \brief The data that we send.
     typedef double DataType;
     /// \brief Constructor.
-    /// \param sendGrid   The grid that the data is attached to when sending.
-    /// \param recvGrid   The grid that the data is attached to when receiving.
-    /// \param sendState  The state where we will retieve the values to be sent.
-    /// \param recvState The state where we will store the received values.
-    BlackoilStateDataHandle(const Dune::CpGrid& sendGrid,
-                            const Dune::CpGrid& recvGrid,
-                            const BlackoilState& sendState,
-                            BlackoilState& recvState)
-        : sendGrid_(sendGrid), recvGrid_(recvGrid), sendState_(sendState), recvState_(recvState)
+    /// \param sendGrid      The grid that the data is attached to when sending.
+    /// \param recvGrid      The grid that the data is attached to when receiving.
+    /// \param sendState     The state where we will retrieve the values to be sent.
+    /// \param recvState     The state where we will store the received values.
+    /// \param sendGeology   The geology where we will retrieve the values to be sent.
+    /// \param recvGeology   The geology where we will store the received values.
+    /// \param sendPressures The threshold pressures of the faces of sendGrid.
+    /// \param recvPressures The threshold pressures of the faces of recvGrid.
+    /// \param fields        The optional fields to send.
+    BlackoilDistributionDataHandle(const Dune::CpGrid& sendGrid,
+                                   const Dune::CpGrid& recvGrid,
+                                   const BlackoilState& sendState,
+                                   BlackoilState& recvState,
+                                   const DerivedGeology& sendGeology,
+                                   DerivedGeology& recvGeology,
+                                   const std::vector<double>& sendPressures,
+                                   std::vector<double>& recvPressures,
+                                   const Fields& fields)
+        : sendGrid_(sendGrid), recvGrid_(recvGrid), sendState_(sendState), recvState_(recvState),
+          sendGeology_(sendGeology), recvGeology_(recvGeology),
+          sendPressures_(sendPressures), recvPressures_(recvPressures), fields_(fields),
+          numPhases_(sendState.numPhases()),
+          // surface volumes, saturations, pressure, temperature, hydrocarbon state, pore volume
+          cellSize_(2 * numPhases_ + 4 + fields.gasOilRatio + fields.rv),
+          // transmissibility
+          faceSize_(1 + 2 * fields.faceData + fields.thresholdPressures)
     {
         // construction does not resize surfacevol and hydroCarbonState. Do it manually.
-        recvState.surfacevol().resize(recvGrid.numCells()*sendState.numPhases(),
+        recvState.surfacevol().resize(recvGrid.numCells()*numPhases_,
                                       std::numeric_limits<double>::max());
         recvState.hydroCarbonState().resize(recvGrid.numCells());
     }
@@ -296,7 +192,7 @@ public:
     {
         if ( T::codimension == 0)
         {
-            return 2 * sendState_.numPhases() + 5 + 2*sendGrid_.numCellFaces(e.index());
+            return cellSize_ + faceSize_ * sendGrid_.numCellFaces(e.index());
         }
         else
         {
@@ -308,86 +204,101 @@ public:
     void gather(B& buffer, const T& e)
     {
         assert( T::codimension == 0);
+        const int cell = e.index();
 
-        for ( size_t i=0; i<sendState_.numPhases(); ++i )
+        for ( std::size_t i=0; i<numPhases_; ++i )
         {
-            buffer.write(sendState_.surfacevol()[e.index()*sendState_.numPhases()+i]);
+            buffer.write(sendState_.surfacevol()[cell*numPhases_+i]);
+            buffer.write(sendState_.saturation()[cell*numPhases_+i]);
         }
-        buffer.write(sendState_.gasoilratio()[e.index()]);
-        buffer.write(sendState_.rv()[e.index()]);
-        buffer.write(sendState_.pressure()[e.index()]);
-        buffer.write(sendState_.temperature()[e.index()]);
-	//We can only send one type with this buffer. Ergo we convert the enum to a double.
-	double hydroCarbonState_ = sendState_.hydroCarbonState()[e.index()];
-	buffer.write(hydroCarbonState_);
-
-        for ( size_t i=0; i<sendState_.numPhases(); ++i )
-        {
-            buffer.write(sendState_.saturation()[e.index()*sendState_.numPhases()+i]);
+        if ( fields_.gasOilRatio ) {
+            buffer.write(sendState_.gasoilratio()[cell]);
         }
-        for ( int i=0; i<sendGrid_.numCellFaces(e.index()); ++i )
-        {
-            buffer.write(sendState_.facepressure()[sendGrid_.cellFace(e.index(), i)]);
+        if ( fields_.rv ) {
+            buffer.write(sendState_.rv()[cell]);
         }
-        for ( int i=0; i<sendGrid_.numCellFaces(e.index()); ++i )
+        buffer.write(sendState_.pressure()[cell]);
+        buffer.write(sendState_.temperature()[cell]);
+        //We can only send one type with this buffer. Ergo we convert the enum to a double.
+        const double hydroCarbonState = sendState_.hydroCarbonState()[cell];
+        buffer.write(hydroCarbonState);
+        buffer.write(sendGeology_.poreVolume()[cell]);
+
+        for ( int i=0; i<sendGrid_.numCellFaces(cell); ++i )
         {
-            buffer.write(sendState_.faceflux()[sendGrid_.cellFace(e.index(), i)]);
+            const int face = sendGrid_.cellFace(cell, i);
+            buffer.write(sendGeology_.transmissibility()[face]);
+            if ( fields_.faceData ) {
+                buffer.write(sendState_.facepressure()[face]);
+                buffer.write(sendState_.faceflux()[face]);
+            }
+            if ( fields_.thresholdPressures ) {
+                buffer.write(sendPressures_[face]);
+            }
         }
     }
+
     template<class B, class T>
     void scatter(B& buffer, const T& e, std::size_t size_arg)
     {
         assert( T::codimension == 0);
-        assert( size_arg == 2 * recvState_.numPhases() + 5 +2*recvGrid_.numCellFaces(e.index()));
+        const int cell = e.index();
+        assert( size_arg == cellSize_ + faceSize_ * recvGrid_.numCellFaces(cell));
         static_cast<void>(size_arg);
 
-        double val;
-        for ( size_t i=0; i<recvState_.numPhases(); ++i )
+        for ( std::size_t i=0; i<numPhases_; ++i )
         {
-            buffer.read(val);
-            recvState_.surfacevol()[e.index()*sendState_.numPhases()+i]=val;
+            buffer.read(recvState_.surfacevol()[cell*numPhases_+i]);
+            buffer.read(recvState_.saturation()[cell*numPhases_+i]);
         }
-        buffer.read(val);
-        recvState_.gasoilratio()[e.index()]=val;
-        buffer.read(val);
-        recvState_.rv()[e.index()]=val;
-        buffer.read(val);
-        recvState_.pressure()[e.index()]=val;
-        buffer.read(val);
-        recvState_.temperature()[e.index()]=val;
-	//We can only send one type with this buffer. Ergo we convert the enum to a double.
-	buffer.read(val);
-	recvState_.hydroCarbonState()[e.index()]=static_cast<HydroCarbonState>(val);
-
-        for ( size_t i=0; i<recvState_.numPhases(); ++i )
-        {
-            buffer.read(val);
-            recvState_.saturation()[e.index()*sendState_.numPhases()+i]=val;
+        if ( fields_.gasOilRatio ) {
+            buffer.read(recvState_.gasoilratio()[cell]);
         }
-        for ( int i=0; i<recvGrid_.numCellFaces(e.index()); ++i )
-        {
-            buffer.read(val);
-            recvState_.facepressure()[recvGrid_.cellFace(e.index(), i)]=val;
+        if ( fields_.rv ) {
+            buffer.read(recvState_.rv()[cell]);
         }
-        for ( int i=0; i<recvGrid_.numCellFaces(e.index()); ++i )
+        buffer.read(recvState_.pressure()[cell]);
+        buffer.read(recvState_.temperature()[cell]);
+        double hydroCarbonState;
+        buffer.read(hydroCarbonState);
+        recvState_.hydroCarbonState()[cell] = static_cast<HydroCarbonState>(hydroCarbonState);
+        buffer.read(recvGeology_.poreVolume()[cell]);
+
+        for ( int i=0; i<recvGrid_.numCellFaces(cell); ++i )
         {
-            buffer.read(val);
-            recvState_.faceflux()[recvGrid_.cellFace(e.index(), i)]=val;
+            const int face = recvGrid_.cellFace(cell, i);
+            buffer.read(recvGeology_.transmissibility()[face]);
+            if ( fields_.faceData ) {
+                buffer.read(recvState_.facepressure()[face]);
+                buffer.read(recvState_.faceflux()[face]);
+            }
+            if ( fields_.thresholdPressures ) {
+                buffer.read(recvPressures_[face]);
+            }
         }
     }
+
     bool contains(int dim, int codim)
     {
         return dim==3 && codim==0;
     }
+
 private:
     /// \brief The grid that the data is attached to when sending
     const Dune::CpGrid& sendGrid_;
     /// \brief The grid that the data is attached to when receiving
     const Dune::CpGrid& recvGrid_;
-    /// \brief The state where we will retieve the values to be sent.
     const BlackoilState& sendState_;
-    // \brief The state where we will store the received values.
     BlackoilState& recvState_;
+    const DerivedGeology& sendGeology_;
+    DerivedGeology& recvGeology_;
+    const std::vector<double>& sendPressures_;
+    std::vector<double>& recvPressures_;
+    Fields fields_;
+    std::size_t numPhases_;
+    /// \brief The number of values of a cell and of each of its faces.
+    std::size_t cellSize_;
+    std::size_t faceSize_;
 };
 
 /// \brief A DUNE data handle for sending the blackoil properties
@@ -495,16 +406,58 @@ distributeGridAndData( Dune::CpGrid& grid,
                        std::shared_ptr<BlackoilPropsAdFromDeck::MaterialLawManager>& material_law_manager,
                        std::vector<double>& threshold_pressures,
                        boost::any& parallelInformation,
-                       const bool useLocalPerm)
+                       const bool useLocalPerm,
+                       const PartitionWeightParameters& weightParam = PartitionWeightParameters())
 {
     Dune::CpGrid global_grid ( grid );
     global_grid.switchToGlobalView();
 
+    // the estimated cost of the cells, also used to report the imbalance
+    const std::vector<double> cellWeights = partitionCellWeights(global_grid, eclipseState, weightParam);
+    std::vector<double> edgeWeights;
+    const double* partitionWeights = geology.transmissibility().data();
+    if (weightParam.use_weights_) {
+        edgeWeights = partitionEdgeWeights(UgGridHelpers::faceCells(global_grid),
+                                           UgGridHelpers::numFaces(global_grid),
+                                           geology.transmissibility().data(),
+                                           cellWeights);
+        partitionWeights = edgeWeights.data();
+    }
+
     // distribute the grid and switch to the distributed view
     using std::get;
-    auto my_defunct_wells = get<1>(grid.loadBalance(&eclipseState,
-                                            geology.transmissibility().data()));
+    auto my_defunct_wells = get<1>(grid.loadBalance(&eclipseState, partitionWeights,
+                                                    weightParam.overlap_layers_));
     grid.switchToDistributedView();
+
+    {
+        // the estimated cost of the interior cells of this process
+        std::unordered_map<int, double> cartesianWeights;
+        for (int cell = 0; cell < global_grid.numCells(); ++cell) {
+            cartesianWeights[global_grid.globalCell()[cell]] = cellWeights[cell];
+        }
+        const auto& gridView = grid.leafGridView();
+        double localWeight = 0.0;
+        int numInterior = 0;
+        const auto& elemEndIt = gridView.template end<0, Dune::Interior_Partition>();
+        for (auto elemIt = gridView.template begin<0, Dune::Interior_Partition>(); elemIt != elemEndIt; ++elemIt) {
+            localWeight += cartesianWeights[grid.globalCell()[gridView.indexSet().index(*elemIt)]];
+            ++numInterior;
+        }
+        const double maxWeight = grid.comm().max(localWeight);
+        const double meanWeight = grid.comm().sum(localWeight) / grid.comm().size();
+        // the overlap cells are assembled and communicated in addition
+        const int numCells = gridView.size(0);
+        const double overlapFraction = grid.comm().max(numCells > 0 ? double(numCells - numInterior) / numCells : 0.0);
+        if (grid.comm().rank() == 0 && meanWeight > 0.0) {
+            std::ostringstream msg;
+            msg << "Estimated load imbalance of the partition (max/mean cell cost): "
+                << maxWeight / meanWeight << "\n"
+                << "Largest share of overlap cells of a process with "
+                << weightParam.overlap_layers_ << " overlap layers: " << overlapFraction;
+            OpmLog::info(msg.str());
+        }
+    }
     std::vector<int> compressedToCartesianIdx;
     Opm::createGlobalCellArray(grid, compressedToCartesianIdx);
     typedef BlackoilPropsAdFromDeck::MaterialLawManager MaterialLawManager;
@@ -528,23 +481,16 @@ distributeGridAndData( Dune::CpGrid& grid,
                                               distributed_material_law_manager,
                                               grid.numCells());
     BlackoilState distributed_state(grid.numCells(), grid.numFaces(), state.numPhases());
-    BlackoilStateDataHandle state_handle(global_grid, grid,
-                                         state, distributed_state);
     BlackoilPropsDataHandle props_handle(properties,
                                          distributed_props);
-    grid.scatterData(state_handle);
     grid.scatterData(props_handle);
     // Create a distributed Geology. Some values will be updated using communication
     // below
     DerivedGeology distributed_geology(grid,
                                        distributed_props, eclipseState,
                                        useLocalPerm, geology.gravity());
-    GeologyDataHandle geo_handle(global_grid, grid,
-                                 geology, distributed_geology);
-    grid.scatterData(geo_handle);
 
     std::vector<double> distributed_pressures;
-
     if( !threshold_pressures.empty() ) // Might be empty if not specified
     {
         if( threshold_pressures.size() !=
@@ -555,12 +501,28 @@ distributeGridAndData( Dune::CpGrid& grid,
                       threshold_pressures.size()<<" threshold pressure values");
         }
         distributed_pressures.resize(UgGridHelpers::numFaces(grid));
-        ThresholdPressureDataHandle press_handle(global_grid, grid,
-                                                 threshold_pressures,
-                                                 distributed_pressures);
-        grid.scatterData(press_handle);
     }
 
+    // the state, the geology and the threshold pressures in one round, without
+    // the fields that are zero everywhere, e.g. the face fluxes of an initial
+    // state or the gas-oil ratio of a model without dissolved gas
+    const auto anyNonZero = [&grid](const std::vector<double>& values) {
+        const bool nonZero = std::any_of(values.begin(), values.end(),
+                                         [](const double v) { return v != 0.0; });
+        return grid.comm().max(int(nonZero)) > 0;
+    };
+    BlackoilDistributionDataHandle::Fields fields;
+    fields.gasOilRatio = anyNonZero(state.gasoilratio());
+    fields.rv = anyNonZero(state.rv());
+    fields.faceData = anyNonZero(state.facepressure()) || anyNonZero(state.faceflux());
+    fields.thresholdPressures = !threshold_pressures.empty();
+    BlackoilDistributionDataHandle handle(global_grid, grid,
+                                          state, distributed_state,
+                                          geology, distributed_geology,
+                                          threshold_pressures, distributed_pressures,
+                                          fields);
+    grid.scatterData(handle);
+
     // copy states
     properties           = distributed_props;
     geology              = distributed_geology;
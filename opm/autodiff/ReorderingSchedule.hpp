@@ -0,0 +1,228 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_REORDERINGSCHEDULE_HEADER_INCLUDED
+#define OPM_REORDERINGSCHEDULE_HEADER_INCLUDED
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Order of the cells of a reordering solver and a schedule solving
+    /// independent parts of the ordering in parallel.
+    ///
+    /// The cells are grouped into the strongly connected components of
+    /// the graph of upstream dependencies, which are ordered such that
+    /// every component comes after the components upstream of it, as by
+    /// compute_sequence(). The components are further grouped into
+    /// levels, such that a component is in a later level than the
+    /// components upstream of it, and no two components of a level
+    /// contain neighbouring cells. Solving the levels one after the other
+    /// is thereby a valid ordering, and the components of a level can be
+    /// solved in parallel with the same result as solving them in turn.
+    /// The graph is given by the neighbours of each cell, so any grid and
+    /// non-neighbouring connections are supported.
+    class ReorderingSchedule
+    {
+    public:
+        /// Compute the ordering and the levels.
+        /// \param[in] neighbourStart  start of the neighbours of each cell in
+        ///                            neighbours, with one entry per cell plus one.
+        /// \param[in] neighbours      the neighbouring cells of all cells.
+        /// \param[in] upstream        for each entry in neighbours true if the
+        ///                            neighbour is upstream of the cell.
+        void compute(const std::vector<int>& neighbourStart,
+                     const std::vector<int>& neighbours,
+                     const std::vector<char>& upstream)
+        {
+            assert(!neighbourStart.empty());
+            assert(neighbours.size() == upstream.size());
+            computeComponents(neighbourStart, neighbours, upstream);
+            computeLevels(neighbourStart, neighbours, upstream);
+        }
+
+        /// The cells in the order of their components.
+        const std::vector<int>& sequence() const { return sequence_; }
+
+        /// Start of each component in sequence(), with one entry per
+        /// component plus one, as by compute_sequence().
+        const std::vector<int>& components() const { return components_; }
+
+        int numComponents() const { return components_.size() - 1; }
+
+        int numLevels() const { return levelStart_.size() - 1; }
+
+        /// Start of each level in levelComponents(), with one entry per
+        /// level plus one.
+        const std::vector<int>& levelStart() const { return levelStart_; }
+
+        /// The components grouped by level, in order within each level.
+        const std::vector<int>& levelComponents() const { return levelComponents_; }
+
+    private:
+        // Tarjan's algorithm with an explicit stack, following the upstream
+        // edges. A component is completed after all components upstream of
+        // it, which gives the wanted order.
+        void computeComponents(const std::vector<int>& neighbourStart,
+                               const std::vector<int>& neighbours,
+                               const std::vector<char>& upstream)
+        {
+            const int numCells = neighbourStart.size() - 1;
+            sequence_.clear();
+            sequence_.reserve(numCells);
+            components_.assign(1, 0);
+
+            std::vector<int> index(numCells, -1);
+            std::vector<int> lowlink(numCells, 0);
+            std::vector<char> onStack(numCells, false);
+            std::vector<int> stack;
+            // (cell, next neighbour entry) of the cells being visited
+            std::vector<std::pair<int, int> > visit;
+            int counter = 0;
+
+            for (int root = 0; root < numCells; ++root) {
+                if (index[root] >= 0) {
+                    continue;
+                }
+                visit.emplace_back(root, neighbourStart[root]);
+                index[root] = lowlink[root] = counter++;
+                stack.push_back(root);
+                onStack[root] = true;
+
+                while (!visit.empty()) {
+                    const int cell = visit.back().first;
+                    int& pos = visit.back().second;
+                    bool descended = false;
+                    for (; pos < neighbourStart[cell + 1]; ++pos) {
+                        if (!upstream[pos]) {
+                            continue;
+                        }
+                        const int other = neighbours[pos];
+                        if (index[other] < 0) {
+                            ++pos;
+                            index[other] = lowlink[other] = counter++;
+                            stack.push_back(other);
+                            onStack[other] = true;
+                            visit.emplace_back(other, neighbourStart[other]);
+                            descended = true;
+                            break;
+                        }
+                        if (onStack[other]) {
+                            lowlink[cell] = std::min(lowlink[cell], index[other]);
+                        }
+                    }
+                    if (descended) {
+                        continue;
+                    }
+
+                    if (lowlink[cell] == index[cell]) {
+                        int member;
+                        do {
+                            member = stack.back();
+                            stack.pop_back();
+                            onStack[member] = false;
+                            sequence_.push_back(member);
+                        } while (member != cell);
+                        components_.push_back(sequence_.size());
+                    }
+                    visit.pop_back();
+                    if (!visit.empty()) {
+                        const int parent = visit.back().first;
+                        lowlink[parent] = std::min(lowlink[parent], lowlink[cell]);
+                    }
+                }
+            }
+            assert(int(sequence_.size()) == numCells);
+        }
+
+        // Greedy assignment of the components in order to the first level
+        // after their upstream components not taken by a neighbour.
+        void computeLevels(const std::vector<int>& neighbourStart,
+                           const std::vector<int>& neighbours,
+                           const std::vector<char>& upstream)
+        {
+            const int numCells = neighbourStart.size() - 1;
+            const int numComp = numComponents();
+            std::vector<int> component(numCells);
+            for (int comp = 0; comp < numComp; ++comp) {
+                for (int i = components_[comp]; i < components_[comp + 1]; ++i) {
+                    component[sequence_[i]] = comp;
+                }
+            }
+
+            std::vector<int> level(numComp, 0);
+            std::vector<int> taken;
+            int numLevels = 0;
+            for (int comp = 0; comp < numComp; ++comp) {
+                int minLevel = 0;
+                taken.clear();
+                for (int i = components_[comp]; i < components_[comp + 1]; ++i) {
+                    const int cell = sequence_[i];
+                    for (int pos = neighbourStart[cell]; pos < neighbourStart[cell + 1]; ++pos) {
+                        const int other = component[neighbours[pos]];
+                        if (other < comp) {
+                            taken.push_back(level[other]);
+                            if (upstream[pos]) {
+                                minLevel = std::max(minLevel, level[other] + 1);
+                            }
+                        }
+                        assert(!upstream[pos] || other <= comp);
+                    }
+                }
+                std::sort(taken.begin(), taken.end());
+                int l = minLevel;
+                for (const int t : taken) {
+                    if (t == l) {
+                        ++l;
+                    } else if (t > l) {
+                        break;
+                    }
+                }
+                level[comp] = l;
+                numLevels = std::max(numLevels, l + 1);
+            }
+
+            // group the components by level, keeping their order
+            levelStart_.assign(numLevels + 1, 0);
+            for (int comp = 0; comp < numComp; ++comp) {
+                ++levelStart_[level[comp] + 1];
+            }
+            for (int l = 0; l < numLevels; ++l) {
+                levelStart_[l + 1] += levelStart_[l];
+            }
+            levelComponents_.resize(numComp);
+            std::vector<int> next(levelStart_.begin(), levelStart_.end() - 1);
+            for (int comp = 0; comp < numComp; ++comp) {
+                levelComponents_[next[level[comp]]++] = comp;
+            }
+        }
+
+        std::vector<int> sequence_;
+        std::vector<int> components_;
+        std::vector<int> levelStart_;
+        std::vector<int> levelComponents_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_REORDERINGSCHEDULE_HEADER_INCLUDED
@@ -0,0 +1,226 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_SEGMENTTREEJACOBIAN_HEADER_INCLUDED
+#define OPM_SEGMENTTREEJACOBIAN_HEADER_INCLUDED
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <vector>
+
+namespace Opm
+{
+
+    /// The Jacobian of the equations of the segments of multi-segment wells
+    /// with respect to the segment variables, stored as dense blocks per
+    /// segment and factorized along the segment tree of every well.
+    ///
+    /// The rows and columns are ordered as the segment equations and
+    /// variables of MultisegmentWells: variable k of segment s, i.e. the
+    /// rate of phase k or the pressure for k equal to the number of phases,
+    /// is found at k * numSegments + s.
+    ///
+    /// A segment may be coupled with itself and with the segments on its
+    /// path to the top segment of its well, e.g. its outlet and, through
+    /// the mixture of the injecting perforations, the top segment. Block
+    /// elimination from the deepest segments upwards then creates no
+    /// entries outside these paths, and every segment is eliminated with
+    /// the inverse of its own small diagonal block.
+    class SegmentTreeJacobian
+    {
+    public:
+        typedef Eigen::MatrixXd Block;
+
+        /// outlet[s] is the outlet segment of segment s, or -1 for the top
+        /// segment of a well. blockSize is the number of variables per segment.
+        SegmentTreeJacobian(const std::vector<int>& outlet, const int blockSize)
+            : outlet_(outlet)
+            , blockSize_(blockSize)
+            , depth_(outlet.size(), -1)
+            , diag_(outlet.size(), Block::Zero(blockSize, blockSize))
+            , diagInv_(outlet.size())
+            , up_(outlet.size())
+            , down_(outlet.size())
+        {
+            const int nseg = outlet_.size();
+            for (int seg = 0; seg < nseg; ++seg) {
+                depth_[seg] = depth(seg);
+                order_.push_back(seg);
+            }
+            // the deepest segments first, every segment before its outlet
+            std::stable_sort(order_.begin(), order_.end(),
+                             [this](const int a, const int b) { return depth_[a] > depth_[b]; });
+        }
+
+        int numSegments() const
+        {
+            return outlet_.size();
+        }
+
+        /// Copy the entries of jacobian into the blocks. Returns false if it
+        /// couples segments which are not on one path to a top segment.
+        bool assemble(const Eigen::SparseMatrix<double>& jacobian)
+        {
+            const int nseg = numSegments();
+            assert(jacobian.rows() == nseg * blockSize_ && jacobian.cols() == nseg * blockSize_);
+            for (int col = 0; col < jacobian.outerSize(); ++col) {
+                const int colSeg = col % nseg;
+                const int colVar = col / nseg;
+                for (Eigen::SparseMatrix<double>::InnerIterator it(jacobian, col); it; ++it) {
+                    const int rowSeg = it.row() % nseg;
+                    const int rowVar = it.row() / nseg;
+                    Block* block = find(rowSeg, colSeg);
+                    if (!block) {
+                        return false;
+                    }
+                    (*block)(rowVar, colVar) += it.value();
+                }
+            }
+            return true;
+        }
+
+        /// Eliminate the segments from the deepest upwards. Returns false
+        /// if a diagonal block is singular.
+        bool factorize()
+        {
+            for (const int seg : order_) {
+                const Eigen::FullPivLU<Block> lu(diag_[seg]);
+                if (!lu.isInvertible()) {
+                    return false;
+                }
+                diagInv_[seg] = lu.inverse();
+
+                // J(a, b) -= J(a, seg) inv(J(seg, seg)) J(seg, b) for the
+                // ancestors a and b of seg
+                for (const auto& lower : down_[seg]) {
+                    const Block multiplier = lower.second * diagInv_[seg];
+                    for (const auto& upper : up_[seg]) {
+                        Block* block = find(lower.first, upper.first);
+                        assert(block);
+                        block->noalias() -= multiplier * upper.second;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /// Solve the factorized system for the right hand side rhs.
+        Eigen::VectorXd solve(const Eigen::VectorXd& rhs) const
+        {
+            const int nseg = numSegments();
+            std::vector<Eigen::VectorXd> y(nseg, Eigen::VectorXd(blockSize_));
+            for (int seg = 0; seg < nseg; ++seg) {
+                for (int k = 0; k < blockSize_; ++k) {
+                    y[seg][k] = rhs[k * nseg + seg];
+                }
+            }
+
+            for (const int seg : order_) {
+                const Eigen::VectorXd z = diagInv_[seg] * y[seg];
+                for (const auto& lower : down_[seg]) {
+                    y[lower.first].noalias() -= lower.second * z;
+                }
+            }
+
+            std::vector<Eigen::VectorXd> x(nseg);
+            for (auto seg = order_.rbegin(); seg != order_.rend(); ++seg) {
+                Eigen::VectorXd r = y[*seg];
+                for (const auto& upper : up_[*seg]) {
+                    r.noalias() -= upper.second * x[upper.first];
+                }
+                x[*seg] = diagInv_[*seg] * r;
+            }
+
+            Eigen::VectorXd result(nseg * blockSize_);
+            for (int seg = 0; seg < nseg; ++seg) {
+                for (int k = 0; k < blockSize_; ++k) {
+                    result[k * nseg + seg] = x[seg][k];
+                }
+            }
+            return result;
+        }
+
+    private:
+        int depth(int seg) const
+        {
+            int d = 0;
+            while (outlet_[seg] >= 0) {
+                seg = outlet_[seg];
+                ++d;
+            }
+            return d;
+        }
+
+        // true if ancestor is on the path from seg to its top segment
+        bool isAncestor(const int ancestor, int seg) const
+        {
+            while (depth_[seg] > depth_[ancestor]) {
+                seg = outlet_[seg];
+            }
+            return seg == ancestor;
+        }
+
+        // the block of row segment r and column segment c, created if
+        // needed, or null if the two segments are not on one path
+        Block* find(const int r, const int c)
+        {
+            std::map<int, Block>* blocks = nullptr;
+            int key = -1;
+            if (r == c) {
+                return &diag_[r];
+            }
+            else if (depth_[r] > depth_[c] && isAncestor(c, r)) {
+                blocks = &up_[r];
+                key = c;
+            }
+            else if (depth_[c] > depth_[r] && isAncestor(r, c)) {
+                blocks = &down_[c];
+                key = r;
+            }
+            else {
+                return nullptr;
+            }
+            auto block = blocks->find(key);
+            if (block == blocks->end()) {
+                block = blocks->insert(std::make_pair(key, Block::Zero(blockSize_, blockSize_))).first;
+            }
+            return &block->second;
+        }
+
+        std::vector<int> outlet_;
+        int blockSize_;
+        std::vector<int> depth_;
+        std::vector<int> order_;
+        std::vector<Block> diag_;
+        std::vector<Block> diagInv_;
+        // up_[s][a] is the block of row s and column a, for an ancestor a of s
+        std::vector< std::map<int, Block> > up_;
+        // down_[s][a] is the block of row a and column s, for an ancestor a of s
+        std::vector< std::map<int, Block> > down_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_SEGMENTTREEJACOBIAN_HEADER_INCLUDED
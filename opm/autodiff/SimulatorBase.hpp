@@ -33,6 +33,7 @@
 #include <opm/autodiff/BlackoilPropsAdFromDeck.hpp>
 #include <opm/autodiff/WellStateFullyImplicitBlackoil.hpp>
 #include <opm/autodiff/RateConverter.hpp>
+#include <opm/autodiff/LoadImbalanceMonitor.hpp>
 
 #include <opm/core/grid.h>
 #include <opm/core/wells.h>
@@ -223,6 +224,8 @@ namespace Opm
         // (e.g. in a parallel run when they are handeled by
         // a different process)
         std::unordered_set<std::string> defunct_well_names_;
+        // Imbalance of the work of the processes per report step
+        LoadImbalanceMonitor imbalance_monitor_;
     };
 
 } // namespace Opm
@@ -63,7 +63,9 @@ namespace Opm
           rateConverter_(props_.phaseUsage(), props.cellPvtRegionIndex(), AutoDiffGrid::numCells(grid_), std::vector<int>(AutoDiffGrid::numCells(grid_), 0)),
           threshold_pressures_by_face_(threshold_pressures_by_face),
           is_parallel_run_( false ),
-          defunct_well_names_(defunct_well_names)
+          defunct_well_names_(defunct_well_names),
+          imbalance_monitor_(param.getDefault("rebalance_threshold", 0.0),
+                             param.getDefault("rebalance_stop", false))
     {
         // Misc init.
         const int num_cells = AutoDiffGrid::numCells(grid);
@@ -79,6 +81,7 @@ namespace Opm
             // Only rank 0 does print to std::cout
             terminal_output_ = terminal_output_ && ( info.communicator().rank() == 0 );
             is_parallel_run_ = ( info.communicator().size() > 1 );
+            imbalance_monitor_.setCommunicator(info.communicator());
         }
 #endif
     }
@@ -210,6 +213,7 @@ namespace Opm
 
             // Run a multiple steps of the solver depending on the time step control.
             solver_timer.start();
+            const double work_before_step = report.assemble_time + report.update_time;
 
             const WellModel well_model(wells, &(wells_manager.wellCollection()));
 
@@ -286,6 +290,19 @@ namespace Opm
             // update timing.
             report.solver_time += solver_timer.secsSinceStart();
 
+            // compare the time the processes spent on their own cells, the
+            // linear solves are excluded since they synchronize the processes
+            if (imbalance_monitor_.active()) {
+                const double imbalance =
+                    imbalance_monitor_.update(report.assemble_time + report.update_time - work_before_step);
+                if (terminal_output_ && imbalance_monitor_.exceeded()) {
+                    std::ostringstream msg;
+                    msg << "Load imbalance of the processes in report step " << timer.currentStepNum()
+                        << ": " << imbalance << " (max/mean).";
+                    OpmLog::warning("Load imbalance", msg.str());
+                }
+            }
+
             // Compute current FIP.
             std::vector<std::vector<double> > COIP;
             COIP = solver->computeFluidInPlace(state, fipnum);
@@ -330,6 +347,19 @@ namespace Opm
 
             asImpl().updateListEconLimited(solver, eclipse_state_->getSchedule(), timer.currentStepNum(), wells,
                                            well_state, dynamic_list_econ_limited);
+
+            // the partition is fixed for the run, stop to let it be
+            // restarted from this report step with a new partition
+            if (imbalance_monitor_.stopRequested() && !timer.done()) {
+                if (terminal_output_) {
+                    std::ostringstream msg;
+                    msg << "Stopping at report step " << timer.currentStepNum()
+                        << " to repartition the grid, restart from this step"
+                        << " with partition_weights=true.";
+                    OpmLog::warning("Load imbalance", msg.str());
+                }
+                break;
+            }
         }
 
         // Stop timer and create timing report
@@ -26,11 +26,16 @@
 #include <opm/autodiff/NonlinearSolver.hpp>
 #include <opm/autodiff/BlackoilModelEbos.hpp>
 #include <opm/autodiff/BlackoilModelParameters.hpp>
+#include <opm/autodiff/CellDataView.hpp>
 #include <opm/autodiff/WellStateFullyImplicitBlackoilDense.hpp>
 #include <opm/autodiff/StandardWellsDense.hpp>
 #include <opm/autodiff/RateConverter.hpp>
 #include <opm/autodiff/SimFIBODetails.hpp>
 #include <opm/autodiff/moduleVersion.hpp>
+#include <opm/autodiff/PerformanceTrace.hpp>
+#include <opm/autodiff/RankLoadReport.hpp>
+#include <opm/autodiff/MemoryTracker.hpp>
+#include <opm/simulators/MetricsExporter.hpp>
 #include <opm/simulators/timestepping/AdaptiveTimeStepping.hpp>
 #include <opm/core/utility/initHydroCarbonState.hpp>
 #include <opm/core/utility/StopWatch.hpp>
@@ -40,6 +45,8 @@
 
 #include <dune/common/unused.hh>
 
+#include <exception>
+
 namespace Opm {
 
 
@@ -65,6 +72,7 @@ public:
     typedef BlackoilModelParameters ModelParameters;
     typedef NonlinearSolver<Model> Solver;
     typedef StandardWellsDense<TypeTag> WellModel;
+    typedef typename Model::Adjoint Adjoint;
 
 
     /// Initialise from parameters and objects to observe.
@@ -79,6 +87,13 @@ public:
     ///     nl_pressure_maxiter (10)       max nonlinear iterations in pressure
     ///     nl_maxiter (30)                max nonlinear iterations in transport
     ///     nl_tolerance (1e-9)            transport solver absolute residual tolerance
+    ///     performance_trace_file ("")    if set, write the timings of every Newton
+    ///                                    iteration to this file (CSV, or JSON lines
+    ///                                    if it ends in .json)
+    ///     adjoint_gradient_file ("")     if set, write the gradients of the well rate
+    ///                                    mismatch of the WCONHIST producers with respect
+    ///                                    to the pore volume and connection transmissibility
+    ///                                    multipliers to this file (serial runs only)
     ///     num_transport_substeps (1)     number of transport steps per pressure step
     ///     use_segregation_split (false)  solve for gravity segregation (if false,
     ///                                    segregation is ignored).
@@ -111,12 +126,49 @@ public:
           defunct_well_names_( defunct_well_names ),
           is_parallel_run_( false )
     {
-        extractLegacyCellPvtRegionIndex_();
+        createLegacyViews_();
         rateConverter_.reset(new RateConverterType(phaseUsage_,
-                                                   legacyCellPvtRegionIdx_.data(),
-                                                   AutoDiffGrid::numCells(grid()),
+                                                   legacyCellPvtRegionIdx_,
                                                    std::vector<int>(AutoDiffGrid::numCells(grid()), 0)));
 
+        const std::string traceFile = param.getDefault("performance_trace_file", std::string(""));
+        if ( ! traceFile.empty() ) {
+            const auto& comm = ebosSimulator_.gridView().comm();
+            performanceTrace_.reset(new PerformanceTrace(traceFile, comm.rank(), comm.size()));
+        }
+
+        // live progress of the run for the job scheduler, published by the
+        // first process only
+        const std::string metricsFile = param.getDefault("metrics_file", std::string(""));
+        const std::string metricsAddress = param.getDefault("metrics_udp_address", std::string(""));
+        if ( (! metricsFile.empty() || ! metricsAddress.empty())
+             && ebosSimulator_.gridView().comm().rank() == 0 ) {
+            metricsExporter_.reset(new MetricsExporter(metricsFile, metricsAddress,
+                                                       eclState().getIOConfig().getBaseName()));
+        }
+
+        // the linearizations of all time steps are kept in memory for the
+        // backward run of the adjoint gradients
+        adjointFile_ = param.getDefault("adjoint_gradient_file", std::string(""));
+        if ( ! adjointFile_.empty() ) {
+            if (ebosSimulator_.gridView().comm().size() > 1
+                || model_param_.well_schur_max_perforations_ > 0
+                || model_param_.aim_cfl_limit_ > 0.0) {
+                OPM_THROW(std::runtime_error, "The adjoint gradients need a serial run without explicit wells "
+                          "(well_schur_max_perforations=0) and without the adaptive implicit Jacobian.");
+            }
+            adjoint_.reset(new Adjoint(param.getDefault("adjoint_linear_reduction", 1e-8),
+                                       param.getDefault("adjoint_linear_max_iterations", 1000),
+                                       param.getDefault("adjoint_min_rate", 1e-5)));
+        }
+
+        // gather the well control switches of all processes at the end of
+        // each report step instead of after every update of the controls
+        if ( param.getDefault("defer_well_switch_log", false) ) {
+            switchingLogger_.reset(new wellhelpers::WellSwitchingLogger(
+                Dune::MPIHelper::getCollectiveCommunication(), /*deferred=*/true));
+        }
+
 #if HAVE_MPI
         if ( solver_.parallelInformation().type() == typeid(ParallelISTLInformation) )
         {
@@ -143,8 +195,6 @@ public:
         ExtraData extra;
 
         failureReport_ = SimulatorReport();
-        extractLegacyPoreVolume_();
-        extractLegacyDepth_();
 
         if (output_writer_.isRestart()) {
             // This is a restart, populate WellState and ReservoirState state objects from restart file
@@ -185,6 +235,7 @@ public:
                     adaptiveTimeStepping->setSuggestedNextStep(extra.suggested_step);
                 }
             }
+            adaptiveTimeStepping->setMetricsExporter(metricsExporter_.get());
         }
 
         std::string restorefilename = param_.getDefault("restorefile", std::string("") );
@@ -204,6 +255,10 @@ public:
         SimulatorReport report;
         SimulatorReport stepReport;
 
+        // the wells are kept between report steps which do not change them
+        std::unique_ptr<WellsManager> wells_manager;
+        const bool reuse_wells = param_.getDefault("reuse_wells", true);
+
         std::vector<int> fipnum_global = eclState().get3DProperties().getIntGridProperty("FIPNUM").getData();
         //Get compressed cell fipnum.
         std::vector<int> fipnum(Opm::UgGridHelpers::numCells(grid()));
@@ -217,6 +272,10 @@ public:
         std::vector<std::vector<double>> originalFluidInPlace;
         std::vector<double> originalFluidInPlaceTotals;
 
+        // the work of this process for the load balance report
+        double wellAssemblyTime = 0.0;
+        int numPerforations = 0;
+
         // Main simulation loop.
         while (!timer.done()) {
             // Report timestep.
@@ -228,24 +287,28 @@ public:
                 OpmLog::note(ss.str());
             }
 
-            // Create wells and well state.
-            WellsManager wells_manager(eclState(),
-                                       timer.currentStepNum(),
-                                       Opm::UgGridHelpers::numCells(grid()),
-                                       Opm::UgGridHelpers::globalCell(grid()),
-                                       Opm::UgGridHelpers::cartDims(grid()),
-                                       Opm::UgGridHelpers::dimensions(grid()),
-                                       Opm::UgGridHelpers::cell2Faces(grid()),
-                                       Opm::UgGridHelpers::beginFaceCentroids(grid()),
-                                       dynamic_list_econ_limited,
-                                       is_parallel_run_,
-                                       defunct_well_names_ );
-            const Wells* wells = wells_manager.c_wells();
+            // Create wells, unless those of the previous report step are
+            // still valid, and the well state.
+            if (!wells_manager || !reuse_wells
+                || wellsChanged(*wells_manager, timer.currentStepNum(), dynamic_list_econ_limited)) {
+                wells_manager.reset(new WellsManager(eclState(),
+                                                     timer.currentStepNum(),
+                                                     Opm::UgGridHelpers::numCells(grid()),
+                                                     Opm::UgGridHelpers::globalCell(grid()),
+                                                     Opm::UgGridHelpers::cartDims(grid()),
+                                                     Opm::UgGridHelpers::dimensions(grid()),
+                                                     Opm::UgGridHelpers::cell2Faces(grid()),
+                                                     Opm::UgGridHelpers::beginFaceCentroids(grid()),
+                                                     dynamic_list_econ_limited,
+                                                     is_parallel_run_,
+                                                     defunct_well_names_ ));
+            }
+            const Wells* wells = wells_manager->c_wells();
             WellState well_state;
             well_state.init(wells, state, prev_well_state, phaseUsage_);
 
             // give the polymer and surfactant simulators the chance to do their stuff
-            handleAdditionalWellInflow(timer, wells_manager, well_state, wells);
+            handleAdditionalWellInflow(timer, *wells_manager, well_state, wells);
 
             // Compute reservoir volumes for RESV controls.
             computeRESV(timer.currentStepNum(), wells, state, well_state);
@@ -254,7 +317,8 @@ public:
             solver_timer.start();
 
             const auto& wells_ecl = eclState().getSchedule().getWells(timer.currentStepNum());
-            WellModel well_model(wells, &(wells_manager.wellCollection()), wells_ecl, model_param_, terminal_output_,
+            warnAboutMultiSegmentWells(wells_ecl, timer.currentStepNum());
+            WellModel well_model(wells, &(wells_manager->wellCollection()), wells_ecl, model_param_, terminal_output_,
                                  timer.currentStepNum());
 
             auto solver = createSolver(well_model);
@@ -329,6 +393,13 @@ public:
                 stepReport = solver->step(timer, state, well_state);
                 report += stepReport;
                 failureReport_ += solver->failureReport();
+                if ( metricsExporter_ ) {
+                    metricsExporter_->recordStep(timer.simulationTimeElapsed() + timer.currentStepLength(),
+                                                 timer.totalTime(), timer.currentStepLength(),
+                                                 timer.reportStepNum(), stepReport.converged,
+                                                 stepReport.total_newton_iterations,
+                                                 stepReport.total_linear_iterations);
+                }
 
                 if( terminal_output_ )
                 {
@@ -346,6 +417,8 @@ public:
             }
 
             solver->model().endReportStep();
+            wellAssemblyTime += solver->model().wellAssemblyTime();
+            numPerforations = wells ? wells->well_connpos[wells->number_of_wells] : 0;
 
             // take time that was used to solve system for this reportStep
             solver_timer.stop();
@@ -361,6 +434,10 @@ public:
             // Increment timer, remember well state.
             ++timer;
 
+            if ( switchingLogger_ ) {
+                switchingLogger_->flush();
+            }
+
             // Compute current fluid in place.
             currentFluidInPlace = solver->computeFluidInPlace(fipnum);
             currentFluidInPlaceTotals = FIPTotals(currentFluidInPlace, state);
@@ -391,13 +468,24 @@ public:
             const double nextstep = adaptiveTimeStepping ? adaptiveTimeStepping->suggestedNextStep() : -1.0;
             output_writer_.writeTimeStep( timer, state, well_state, solver->model(), false, nextstep, report);
             report.output_write_time += perfTimer.stop();
-
-            prev_well_state = well_state;
+            MemoryTracker::sample(MemoryTracker::FirstOutput);
 
             updateListEconLimited(solver, eclState().getSchedule(), timer.currentStepNum(), wells,
                                   well_state, dynamic_list_econ_limited);
+
+            // the well state of this step is not used any more
+            prev_well_state.swap(well_state);
         }
 
+        // the output of the last report step in the snapshot output mode
+        output_writer_.finishSnapshot();
+
+        if (adjoint_) {
+            writeAdjointGradients();
+        }
+
+        writeLoadReport(report, wellAssemblyTime, numPerforations);
+
         // Stop timer and create timing report
         total_timer.stop();
         report.total_time = total_timer.secsSinceStart();
@@ -405,6 +493,143 @@ public:
         return report;
     }
 
+    /// Benchmark the linearize-solve-update cycle.
+    /// Runs a fixed number of Newton iterations of the current report step,
+    /// each of them starting from the same (frozen) state, so that the
+    /// timings of different builds and solver settings can be compared.
+    /// \param[in]     timer          the timer of the report step to use
+    /// \param[in]     state          the state to start every iteration from
+    /// \param[in]     numIterations  number of Newton iterations to run
+    /// \return                       report with the accumulated timings
+    SimulatorReport benchmark(const SimulatorTimer& timer,
+                              const ReservoirState& state,
+                              const int numIterations)
+    {
+        DynamicListEconLimited dynamic_list_econ_limited;
+        WellsManager wells_manager(eclState(),
+                                   timer.currentStepNum(),
+                                   Opm::UgGridHelpers::numCells(grid()),
+                                   Opm::UgGridHelpers::globalCell(grid()),
+                                   Opm::UgGridHelpers::cartDims(grid()),
+                                   Opm::UgGridHelpers::dimensions(grid()),
+                                   Opm::UgGridHelpers::cell2Faces(grid()),
+                                   Opm::UgGridHelpers::beginFaceCentroids(grid()),
+                                   dynamic_list_econ_limited,
+                                   is_parallel_run_,
+                                   defunct_well_names_ );
+        const Wells* wells = wells_manager.c_wells();
+        WellState prev_well_state;
+        WellState frozen_well_state;
+        frozen_well_state.init(wells, state, prev_well_state, phaseUsage_);
+        computeRESV(timer.currentStepNum(), wells, state, frozen_well_state);
+
+        const auto& wells_ecl = eclState().getSchedule().getWells(timer.currentStepNum());
+        WellModel well_model(wells, &(wells_manager.wellCollection()), wells_ecl, model_param_, terminal_output_,
+                             timer.currentStepNum());
+
+        auto solver = createSolver(well_model);
+        solver->model().beginReportStep();
+        solver->model().prepareStep(timer, state, frozen_well_state);
+
+        Opm::time::StopWatch total_timer;
+        total_timer.start();
+        SimulatorReport report;
+        for (int iteration = 0; iteration < numIterations; ++iteration) {
+            ReservoirState iteration_state( state );
+            ReservoirState initial_state( state );
+            WellState iteration_well_state( frozen_well_state );
+
+            // reset ebos to the frozen state, the previous update changed it
+            solver->model().convertInput(/*iterationIdx=*/0, state, ebosSimulator_ );
+            ebosSimulator_.model().invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+
+            // iteration index 0 never counts as converged, so every
+            // iteration does a full linearize, solve and update
+            report += solver->model().nonlinearIteration(/*iteration=*/0, timer, *solver,
+                                                         iteration_state, iteration_well_state,
+                                                         initial_state);
+        }
+        total_timer.stop();
+        report.total_time = total_timer.secsSinceStart();
+
+        solver->model().endReportStep();
+        return report;
+    }
+
+    /// Run the report steps of a time slab from a given state, without
+    /// any output, as the propagators of a parallel-in-time iteration.
+    /// The wells start from their controls and the hysteresis of ebos
+    /// is the one of the previously simulated slab.
+    /// \param[in,out] timer    the timer at the first report step of the slab
+    /// \param[in,out] state    the state at the start of the slab, the state
+    ///                         at its end on return
+    /// \param[in]     endStep  the first report step after the slab
+    /// \return                 simulation report, with timing data
+    SimulatorReport runSlab(SimulatorTimer& timer,
+                            ReservoirState& state,
+                            const int endStep)
+    {
+        const auto& schedule = eclState().getSchedule();
+        const auto& events = schedule.getEvents();
+        std::unique_ptr< AdaptiveTimeStepping > adaptiveTimeStepping;
+        if( param_.getDefault("timestep.adaptive", true ) ) {
+            adaptiveTimeStepping.reset( new AdaptiveTimeStepping( param_, /*terminal_output=*/false ) );
+        }
+
+        DynamicListEconLimited dynamic_list_econ_limited;
+        WellState prev_well_state;
+        SimulatorReport report;
+        bool slabStart = true;
+        while (!timer.done() && timer.currentStepNum() < endStep) {
+            WellsManager wells_manager(eclState(),
+                                       timer.currentStepNum(),
+                                       Opm::UgGridHelpers::numCells(grid()),
+                                       Opm::UgGridHelpers::globalCell(grid()),
+                                       Opm::UgGridHelpers::cartDims(grid()),
+                                       Opm::UgGridHelpers::dimensions(grid()),
+                                       Opm::UgGridHelpers::cell2Faces(grid()),
+                                       Opm::UgGridHelpers::beginFaceCentroids(grid()),
+                                       dynamic_list_econ_limited,
+                                       is_parallel_run_,
+                                       defunct_well_names_ );
+            const Wells* wells = wells_manager.c_wells();
+            WellState well_state;
+            well_state.init(wells, state, prev_well_state, phaseUsage_);
+            computeRESV(timer.currentStepNum(), wells, state, well_state);
+
+            const auto& wells_ecl = schedule.getWells(timer.currentStepNum());
+            WellModel well_model(wells, &(wells_manager.wellCollection()), wells_ecl, model_param_,
+                                 /*terminal_output=*/false, timer.currentStepNum());
+            auto solver = createSolver(well_model);
+
+            // ebos holds the solution of whatever was simulated last
+            if (slabStart) {
+                solver->model().convertInput(/*iterationIdx=*/0, state, ebosSimulator_ );
+                ebosSimulator_.model().invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+                slabStart = false;
+            }
+
+            solver->model().beginReportStep();
+            if( adaptiveTimeStepping ) {
+                const bool event = events.hasEvent(ScheduleEvents::NEW_WELL, timer.currentStepNum()) ||
+                        events.hasEvent(ScheduleEvents::PRODUCTION_UPDATE, timer.currentStepNum()) ||
+                        events.hasEvent(ScheduleEvents::INJECTION_UPDATE, timer.currentStepNum()) ||
+                        events.hasEvent(ScheduleEvents::WELL_STATUS_CHANGE, timer.currentStepNum());
+                report += adaptiveTimeStepping->step( timer, *solver, state, well_state, event );
+            }
+            else {
+                report += solver->step(timer, state, well_state);
+            }
+            solver->model().endReportStep();
+
+            ++timer;
+            updateListEconLimited(solver, schedule, timer.currentStepNum(), wells,
+                                  well_state, dynamic_list_econ_limited);
+            prev_well_state.swap(well_state);
+        }
+        return report;
+    }
+
     /** \brief Returns the simulator report for the failed substeps of the simulation.
      */
     const SimulatorReport& failureReport() const { return failureReport_; };
@@ -420,6 +645,75 @@ protected:
     {
     }
 
+    /// Log the times of the phases of the run and the numbers of owned cells
+    /// and perforations of every process of a parallel run, with their
+    /// imbalance and the worst ranks. The times include the failed steps.
+    void writeLoadReport(const SimulatorReport& report, const double wellAssemblyTime,
+                         const int numPerforations) const
+    {
+        const auto& gridView = ebosSimulator_.gridView();
+        if (gridView.comm().size() < 2) {
+            return;
+        }
+        int ownedCells = 0;
+        auto elemIt = gridView.template begin</*codim=*/0, Dune::Interior_Partition>();
+        const auto& elemEndIt = gridView.template end</*codim=*/0, Dune::Interior_Partition>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            ++ownedCells;
+        }
+
+        RankLoadReport load;
+        load.set(RankLoadReport::Assembly, report.assemble_time + failureReport_.assemble_time);
+        load.set(RankLoadReport::WellAssembly, wellAssemblyTime);
+        load.set(RankLoadReport::LinearSolve, report.linear_solve_time + failureReport_.linear_solve_time);
+        load.set(RankLoadReport::Output, report.output_write_time);
+        load.set(RankLoadReport::OwnedCells, ownedCells);
+        load.set(RankLoadReport::Perforations, numPerforations);
+        load.gather(gridView.comm());
+        if (terminal_output_) {
+            OpmLog::info(load.format());
+        }
+    }
+
+    /// Solve the adjoint equations of the recorded time steps and write the
+    /// objective and its gradients to the adjoint gradient file, a line
+    /// "PORV <global cell> <gradient>" per cell and "WI <well> <global cell>
+    /// <gradient>" per well connection.
+    void writeAdjointGradients()
+    {
+        Opm::time::StopWatch adjoint_timer;
+        adjoint_timer.start();
+        std::vector<double> poreVolume;
+        std::vector<double> connection;
+        adjoint_->computeGradients(poreVolume, connection);
+        adjoint_timer.stop();
+
+        const int* globalCell = Opm::UgGridHelpers::globalCell(grid());
+        auto global = [globalCell](const int cell) { return globalCell ? globalCell[cell] : cell; };
+        std::ofstream os(adjointFile_.c_str());
+        if (!os) {
+            OPM_THROW(std::runtime_error, "Cannot open the adjoint gradient file " << adjointFile_);
+        }
+        os.precision(16);
+        os << "OBJECTIVE " << adjoint_->objective() << "\n";
+        for (std::size_t cell = 0; cell < poreVolume.size(); ++cell) {
+            os << "PORV " << global(cell) << " " << poreVolume[cell] << "\n";
+        }
+        const auto& connections = adjoint_->connections();
+        for (std::size_t i = 0; i < connections.size(); ++i) {
+            os << "WI " << connections[i].first << " " << global(connections[i].second)
+               << " " << connection[i] << "\n";
+        }
+
+        if (terminal_output_) {
+            std::ostringstream ss;
+            ss << "Adjoint gradients of " << adjoint_->numSteps() << " time steps, "
+               << adjoint_->memoryUsage() / (1024 * 1024) << " MB, computed in "
+               << adjoint_timer.secsSinceStart() << " seconds and written to " << adjointFile_;
+            OpmLog::info(ss.str());
+        }
+    }
+
     std::unique_ptr<Solver> createSolver(WellModel& well_model)
     {
         const auto& gridView = ebosSimulator_.gridView();
@@ -442,15 +736,66 @@ protected:
                         rateConverter_.get(),
                         globalNumCells,
                         grid());
+        well_model.setSwitchingLogger(switchingLogger_.get());
+        if (!cartesianToCompressed_) {
+            cartesianToCompressed_.reset(new CartesianToCompressed(Opm::UgGridHelpers::globalCell(grid()),
+                                                                   Opm::UgGridHelpers::numCells(grid()),
+                                                                   Opm::UgGridHelpers::cartDims(grid())));
+        }
+        well_model.setCartesianToCompressed(cartesianToCompressed_.get());
         auto model = std::unique_ptr<Model>(new Model(ebosSimulator_,
                                                       model_param_,
                                                       well_model,
                                                       solver_,
                                                       terminal_output_));
+        model->setPerformanceTrace(performanceTrace_.get());
+        model->setAdjointSensitivities(adjoint_.get());
 
         return std::unique_ptr<Solver>(new Solver(solver_param_, std::move(model)));
     }
 
+    /// Whether the wells of the previous report step have to be created
+    /// again for the report step. They are kept if the schedule has no well
+    /// or group event at the step, no group controls are active, which
+    /// change the well targets, no well injects under history matching
+    /// control, whose limit computeRESV() adds to the controls, and no well
+    /// is closed, stopped or has closed completions due to its economic
+    /// limits.
+    bool wellsChanged(const WellsManager& wells_manager,
+                      const std::size_t step,
+                      const DynamicListEconLimited& list_econ_limited) const
+    {
+        const auto& schedule = eclState().getSchedule();
+        const auto& events = schedule.getEvents();
+        bool changed = events.hasEvent(ScheduleEvents::NEW_WELL, step) ||
+            events.hasEvent(ScheduleEvents::WELL_WELSPECS_UPDATE, step) ||
+            events.hasEvent(ScheduleEvents::WELL_STATUS_CHANGE, step) ||
+            events.hasEvent(ScheduleEvents::COMPLETION_CHANGE, step) ||
+            events.hasEvent(ScheduleEvents::PRODUCTION_UPDATE, step) ||
+            events.hasEvent(ScheduleEvents::INJECTION_UPDATE, step) ||
+            events.hasEvent(ScheduleEvents::NEW_GROUP, step) ||
+            events.hasEvent(ScheduleEvents::GROUP_CHANGE, step) ||
+            wells_manager.wellCollection().groupControlActive();
+
+        for (const auto* well : schedule.getWells(step)) {
+            if (changed) {
+                break;
+            }
+            changed = well->isInjector(step) && !well->getInjectionProperties(step).predictionMode;
+        }
+
+        const Wells* wells = wells_manager.c_wells();
+        for (int w = 0; !changed && wells && w < wells->number_of_wells; ++w) {
+            const std::string name(wells->name[w]);
+            changed = list_econ_limited.wellShutEconLimited(name) ||
+                list_econ_limited.wellStoppedEconLimited(name) ||
+                list_econ_limited.anyConnectionClosedForWell(name);
+        }
+
+        // the economic limits are checked for the wells of each process
+        return ebosSimulator_.gridView().comm().max(static_cast<int>(changed)) != 0;
+    }
+
     void computeRESV(const std::size_t step,
                      const Wells* wells,
                      const BlackoilState& x,
@@ -629,6 +974,22 @@ protected:
                                                           well_state, list_econ_limited);
     }
 
+    // The dense well model has no segments, the completions of all
+    // segments of a multi-segment well belong to one standard well. Report
+    // every such well once.
+    void warnAboutMultiSegmentWells(const std::vector<const Well*>& wells_ecl,
+                                    const std::size_t step)
+    {
+        for (const auto* well : wells_ecl) {
+            if (well->isMultiSegment(step)
+                && multisegment_well_names_.insert(well->name()).second
+                && terminal_output_) {
+                OpmLog::warning("Well " + well->name() + " is a multi-segment well, it is simulated as a"
+                                " standard well without segments. Use flow_multisegment for the segment model.");
+            }
+        }
+    }
+
     void FIPUnitConvert(const UnitSystem& units,
                         std::vector<std::vector<double>>& fip)
     {
@@ -780,78 +1141,67 @@ protected:
     const EclipseState& eclState() const
     { return ebosSimulator_.gridManager().eclState(); }
 
-    void extractLegacyCellPvtRegionIndex_()
-    {
-        const auto& grid = ebosSimulator_.gridManager().grid();
-        const auto& eclProblem = ebosSimulator_.problem();
-        const unsigned numCells = grid.size(/*codim=*/0);
-
-        legacyCellPvtRegionIdx_.resize(numCells);
-        for (unsigned cellIdx = 0; cellIdx < numCells; ++cellIdx) {
-            legacyCellPvtRegionIdx_[cellIdx] =
-                eclProblem.pvtRegionIndex(cellIdx);
-        }
-    }
-
+    // Pass the maximum oil saturations and the hysteresis parameters of a
+    // restart to ebos. The cells are independent, each thread sets a
+    // contiguous range of them.
     void initHysteresisParams(ReservoirState& state) {
         const int num_cells = Opm::UgGridHelpers::numCells(grid());
 
         typedef std::vector<double> VectorType;
 
         const VectorType& somax = state.getCellData( "SOMAX" );
-
+        auto matLawManager = ebosSimulator_.problem().materialLawManager();
+        const bool hysteresis = matLawManager->enableHysteresis();
+        const VectorType* pcSwMdc_ow = hysteresis ? &state.getCellData( "PCSWMDC_OW" ) : nullptr;
+        const VectorType* krnSwMdc_ow = hysteresis ? &state.getCellData( "KRNSWMDC_OW" ) : nullptr;
+        const VectorType* pcSwMdc_go = hysteresis ? &state.getCellData( "PCSWMDC_GO" ) : nullptr;
+        const VectorType* krnSwMdc_go = hysteresis ? &state.getCellData( "KRNSWMDC_GO" ) : nullptr;
+
+        std::exception_ptr error;
+#pragma omp parallel for schedule(static)
         for (int cellIdx = 0; cellIdx < num_cells; ++cellIdx) {
-            ebosSimulator_.model().setMaxOilSaturation(somax[cellIdx], cellIdx);
-        }
-
-        if (ebosSimulator_.problem().materialLawManager()->enableHysteresis()) {
-            auto matLawManager = ebosSimulator_.problem().materialLawManager();
-
-            VectorType& pcSwMdc_ow = state.getCellData( "PCSWMDC_OW" );
-            VectorType& krnSwMdc_ow = state.getCellData( "KRNSWMDC_OW" );
-
-            VectorType& pcSwMdc_go = state.getCellData( "PCSWMDC_GO" );
-            VectorType& krnSwMdc_go = state.getCellData( "KRNSWMDC_GO" );
-
-            for (int cellIdx = 0; cellIdx < num_cells; ++cellIdx) {
-                matLawManager->setOilWaterHysteresisParams(
-                        pcSwMdc_ow[cellIdx],
-                        krnSwMdc_ow[cellIdx],
-                        cellIdx);
-                matLawManager->setGasOilHysteresisParams(
-                        pcSwMdc_go[cellIdx],
-                        krnSwMdc_go[cellIdx],
-                        cellIdx);
+            try {
+                ebosSimulator_.model().setMaxOilSaturation(somax[cellIdx], cellIdx);
+                if (hysteresis) {
+                    matLawManager->setOilWaterHysteresisParams(
+                            (*pcSwMdc_ow)[cellIdx],
+                            (*krnSwMdc_ow)[cellIdx],
+                            cellIdx);
+                    matLawManager->setGasOilHysteresisParams(
+                            (*pcSwMdc_go)[cellIdx],
+                            (*krnSwMdc_go)[cellIdx],
+                            cellIdx);
+                }
+            }
+            catch (...) {
+#pragma omp critical
+                error = std::current_exception();
             }
         }
-    }
-
-    void extractLegacyPoreVolume_()
-    {
-        const auto& grid = ebosSimulator_.gridManager().grid();
-        const unsigned numCells = grid.size(/*codim=*/0);
-        const auto& ebosProblem = ebosSimulator_.problem();
-        const auto& ebosModel = ebosSimulator_.model();
-
-        legacyPoreVolume_.resize(numCells);
-        for (unsigned cellIdx = 0; cellIdx < numCells; ++cellIdx) {
-            // todo (?): respect rock compressibility
-            legacyPoreVolume_[cellIdx] =
-                ebosModel.dofTotalVolume(cellIdx)
-                *ebosProblem.porosity(cellIdx);
+        if (error) {
+            std::rethrow_exception(error);
         }
     }
 
-    void extractLegacyDepth_()
+    // The cell data of the legacy interfaces, computed from the ebos
+    // simulator when accessed instead of copied into arrays of the
+    // size of the grid.
+    void createLegacyViews_()
     {
-        const auto& grid = ebosSimulator_.gridManager().grid();
-        const unsigned numCells = grid.size(/*codim=*/0);
-
-        legacyDepth_.resize(numCells);
-        for (unsigned cellIdx = 0; cellIdx < numCells; ++cellIdx) {
-            legacyDepth_[cellIdx] =
-                grid.cellCenterDepth(cellIdx);
-        }
+        const Simulator* simulator = &ebosSimulator_;
+        const int numCells = simulator->gridManager().grid().size(/*codim=*/0);
+
+        legacyCellPvtRegionIdx_ = CellDataView<int>(numCells, [simulator](int cellIdx) {
+                return int(simulator->problem().pvtRegionIndex(cellIdx));
+            });
+        // todo (?): respect rock compressibility
+        legacyPoreVolume_ = CellDataView<double>(numCells, [simulator](int cellIdx) {
+                return simulator->model().dofTotalVolume(cellIdx)
+                    * simulator->problem().porosity(cellIdx);
+            });
+        legacyDepth_ = CellDataView<double>(numCells, [simulator](int cellIdx) {
+                return simulator->gridManager().grid().cellCenterDepth(cellIdx);
+            });
     }
 
 
@@ -861,9 +1211,9 @@ protected:
     // Data.
     Simulator& ebosSimulator_;
 
-    std::vector<int> legacyCellPvtRegionIdx_;
-    std::vector<double> legacyPoreVolume_;
-    std::vector<double> legacyDepth_;
+    CellDataView<int> legacyCellPvtRegionIdx_;
+    CellDataView<double> legacyPoreVolume_;
+    CellDataView<double> legacyDepth_;
     typedef RateConverter::SurfaceToReservoirVoidage<FluidSystem, std::vector<int> > RateConverterType;
     typedef typename Solver::SolverParameters SolverParameters;
 
@@ -891,6 +1241,25 @@ protected:
     // Whether this a parallel simulation or not
     bool is_parallel_run_;
 
+    // The multi-segment wells which have been reported as standard wells
+    std::unordered_set<std::string> multisegment_well_names_;
+
+    // Optional trace of the Newton iteration timings
+    std::unique_ptr<PerformanceTrace> performanceTrace_;
+
+    // Optional live metrics of the time steps
+    std::unique_ptr<MetricsExporter> metricsExporter_;
+
+    // Optional adjoint gradients and the file they are written to
+    std::unique_ptr<Adjoint> adjoint_;
+    std::string adjointFile_;
+
+    // Optional logger buffering the well control switches between report steps
+    std::unique_ptr<wellhelpers::WellSwitchingLogger> switchingLogger_;
+
+    // The compressed cell of each Cartesian cell of the grid, for the wells
+    std::unique_ptr<CartesianToCompressed> cartesianToCompressed_;
+
 };
 
 } // namespace Opm
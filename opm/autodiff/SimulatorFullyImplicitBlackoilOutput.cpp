@@ -35,7 +35,10 @@
 
 #include <opm/autodiff/GridHelpers.hpp>
 #include <opm/autodiff/BackupRestore.hpp>
+#include <opm/autodiff/OutputShard.hpp>
 
+#include <cassert>
+#include <memory>
 #include <sstream>
 #include <iomanip>
 #include <fstream>
@@ -61,14 +64,15 @@ namespace Opm
     void outputStateVtk(const UnstructuredGrid& grid,
                         const SimulationDataContainer& state,
                         const int step,
-                        const std::string& output_dir)
+                        const std::string& output_dir,
+                        const VtkEncoding encoding)
     {
         // Write data in VTK format.
         std::ostringstream vtkfilename;
         vtkfilename << output_dir << "/vtk_files";
         ensureDirectoryExists(vtkfilename.str());
         vtkfilename << "/output-" << std::setw(3) << std::setfill('0') << step << ".vtu";
-        std::ofstream vtkfile(vtkfilename.str().c_str());
+        std::ofstream vtkfile(vtkfilename.str().c_str(), std::ios::binary);
         if (!vtkfile) {
             OPM_THROW(std::runtime_error, "Failed to open " << vtkfilename.str());
         }
@@ -85,31 +89,25 @@ namespace Opm
                                   AutoDiffGrid::dimensions(grid),
                                   state.faceflux(), cell_velocity);
         dm["velocity"] = &cell_velocity;
-        Opm::writeVtkData(grid, dm, vtkfile);
+        Opm::writeVtuData(grid, dm, encoding, vtkfile);
     }
 
     void outputWellStateMatlab(const Opm::WellState& well_state,
                                const int step,
                                const std::string& output_dir)
     {
-        Opm::DataMap dm;
-        dm["bhp"] = &well_state.bhp();
-        dm["wellrates"] = &well_state.wellRates();
-
-        // Write data (not grid) in Matlab format
-        for (Opm::DataMap::const_iterator it = dm.begin(); it != dm.end(); ++it) {
-            std::ostringstream fname;
-            fname << output_dir << "/" << it->first;
-            ensureDirectoryExists(fname.str());
-            fname << "/" << std::setw(3) << std::setfill('0') << step << ".txt";
-            std::ofstream file(fname.str().c_str());
-            if (!file) {
-                OPM_THROW(std::runtime_error,"Failed to open " << fname.str());
-            }
-            file.precision(15);
-            const std::vector<double>& d = *(it->second);
-            std::copy(d.begin(), d.end(), std::ostream_iterator<double>(file, "\n"));
-        }
+        MatlabStepWriter writer(output_dir, step);
+        outputWellStateMatlab(well_state, writer);
+    }
+
+    void outputWellStateMatlab(const Opm::WellState& well_state,
+                               MatlabStepWriter& writer)
+    {
+        // Write data in Matlab format, one row per well
+        const std::size_t numWells = well_state.bhp().size();
+        writer.write("bhp", well_state.bhp());
+        writer.write("wellrates", well_state.wellRates(),
+                     numWells > 0 ? well_state.wellRates().size() / numWells : 1);
     }
 
 #if 0
@@ -142,7 +140,8 @@ namespace Opm
     void outputStateVtk(const Dune::CpGrid& grid,
                         const Opm::SimulationDataContainer& state,
                         const int step,
-                        const std::string& output_dir)
+                        const std::string& output_dir,
+                        const VtkEncoding encoding)
     {
         // Write data in VTK format.
         std::ostringstream vtkfilename;
@@ -169,7 +168,12 @@ namespace Opm
                                   AutoDiffGrid::dimensions(grid),
                                   state.faceflux(), cell_velocity);
         writer.addCellData(cell_velocity, "velocity", Dune::CpGrid::dimension);
-        writer.pwrite(vtkfilename.str(), vtkpath.str(), std::string("."), Dune::VTK::ascii);
+        // every process writes its own piece, the pvtu file is written by
+        // rank 0. The Dune writer does not compress, zlib is written as
+        // uncompressed appended data.
+        const Dune::VTK::OutputType outputType =
+            encoding == VtkEncoding::Ascii ? Dune::VTK::ascii : Dune::VTK::appendedraw;
+        writer.pwrite(vtkfilename.str(), vtkpath.str(), std::string("."), outputType);
     }
 #endif
 
@@ -178,9 +182,9 @@ namespace Opm
 
     namespace detail {
 
-        struct WriterCall : public ThreadHandle :: ObjectInterface
+        // copy of the data of one output step, shared by the writers
+        struct WriterData
         {
-            BlackoilOutputWriter& writer_;
             std::unique_ptr< SimulatorTimerInterface > timer_;
             const SimulationDataContainer state_;
             const WellStateFullyImplicitBlackoil wellState_;
@@ -189,16 +193,14 @@ namespace Opm
             std::map<std::string, std::vector<double>> extraRestartData_;
             const bool substep_;
 
-            explicit WriterCall( BlackoilOutputWriter& writer,
-                                 const SimulatorTimerInterface& timer,
-                                 const SimulationDataContainer& state,
-                                 const WellStateFullyImplicitBlackoil& wellState,
-                                 const data::Solution& simProps,
-                                 const std::map<std::string, double>& miscSummaryData,
-                                 const std::map<std::string, std::vector<double>>& extraRestartData,
-                                 bool substep )
-                : writer_( writer ),
-                  timer_( timer.clone() ),
+            WriterData( const SimulatorTimerInterface& timer,
+                        const SimulationDataContainer& state,
+                        const WellStateFullyImplicitBlackoil& wellState,
+                        const data::Solution& simProps,
+                        const std::map<std::string, double>& miscSummaryData,
+                        const std::map<std::string, std::vector<double>>& extraRestartData,
+                        bool substep )
+                : timer_( timer.clone() ),
                   state_( state ),
                   wellState_( wellState ),
                   simProps_( simProps ),
@@ -207,14 +209,219 @@ namespace Opm
                   substep_( substep )
             {
             }
+        };
+
+        struct WriterCall : public ThreadHandle :: ObjectInterface
+        {
+            BlackoilOutputWriter& writer_;
+            const BlackoilOutputWriter::OutputChannel channel_;
+            std::shared_ptr< const WriterData > data_;
+
+            WriterCall( BlackoilOutputWriter& writer,
+                        const BlackoilOutputWriter::OutputChannel channel,
+                        const std::shared_ptr< const WriterData >& data )
+                : writer_( writer ),
+                  channel_( channel ),
+                  data_( data )
+            {
+            }
 
             // callback to writer's serial writeTimeStep method
             void run ()
             {
                 // write data
-                writer_.writeTimeStepSerial( *timer_, state_, wellState_, simProps_, miscSummaryData_, extraRestartData_, substep_ );
+                writer_.writeTimeStepSerial( channel_, *data_->timer_, data_->state_, data_->wellState_,
+                                             data_->simProps_, data_->miscSummaryData_,
+                                             data_->extraRestartData_, data_->substep_ );
+            }
+        };
+
+        // the checkpoint of a report step, written in full or as a delta
+        // to the keyframe if one is given
+        struct CheckpointData
+        {
+            std::string filename;
+            int reportStep;
+            std::shared_ptr< const CheckpointFile::Chunks > chunks;
+            std::shared_ptr< const CheckpointFile::Chunks > keyframe;
+            int keyframeStep;
+            double tolerance;
+            CheckpointFile::Compression compression;
+
+            void write() const
+            {
+                if( keyframe ) {
+                    CheckpointFile::write( filename, reportStep,
+                                           CheckpointFile::delta( *keyframe, *chunks, keyframeStep, tolerance ),
+                                           compression );
+                }
+                else {
+                    CheckpointFile::write( filename, reportStep, *chunks, compression );
+                }
+            }
+        };
+
+        struct CheckpointCall : public ThreadHandle :: ObjectInterface
+        {
+            const CheckpointData data_;
+
+            explicit CheckpointCall( const CheckpointData& data )
+                : data_( data )
+            {
+            }
+
+            // compare, compress and write the copy of the state
+            void run ()
+            {
+                data_.write();
+            }
+        };
+
+        // copy of the data of one step in the snapshot output mode, its
+        // cell data is computed by the snapshot thread
+        struct OutputSnapshot
+        {
+            std::unique_ptr< SimulatorTimerInterface > timer_;
+            const SimulationDataContainer state_;
+            const WellStateFullyImplicitBlackoil wellState_;
+            SimulationDataContainer simulatorData_;
+            FIPData fipData_;
+            data::Solution cellData_;
+            const std::map<std::string, double> miscSummaryData_;
+            const std::map<std::string, std::vector<double>> extraRestartData_;
+            const bool substep_;
+
+            OutputSnapshot( const SimulatorTimerInterface& timer,
+                            const SimulationDataContainer& state,
+                            const WellStateFullyImplicitBlackoil& wellState,
+                            SimulationDataContainer&& simulatorData,
+                            FIPData&& fipData,
+                            const std::map<std::string, double>& miscSummaryData,
+                            const std::map<std::string, std::vector<double>>& extraRestartData,
+                            bool substep )
+                : timer_( timer.clone() ),
+                  state_( state ),
+                  wellState_( wellState ),
+                  simulatorData_( std::move( simulatorData ) ),
+                  fipData_( std::move( fipData ) ),
+                  cellData_(),
+                  miscSummaryData_( miscSummaryData ),
+                  extraRestartData_( extraRestartData ),
+                  substep_( substep )
+            {
             }
         };
+
+        SummaryPlan::SummaryPlan(const SummaryConfig& summaryConfig)
+            : wip( hasFRBKeyword( summaryConfig, "WIP" ) ),
+              oipl( hasFRBKeyword( summaryConfig, "OIPL" ) ),
+              oipg( hasFRBKeyword( summaryConfig, "OIPG" ) ),
+              oip( hasFRBKeyword( summaryConfig, "OIP" ) ),
+              gipg( hasFRBKeyword( summaryConfig, "GIPG" ) ),
+              gipl( hasFRBKeyword( summaryConfig, "GIPL" ) ),
+              gip( hasFRBKeyword( summaryConfig, "GIP" ) ),
+              rpv( hasFRBKeyword( summaryConfig, "RPV" ) ),
+              prh( summaryConfig.hasKeyword( "FPRH" ) || summaryConfig.hasKeyword( "RPRH" ) )
+        {
+        }
+
+        struct SnapshotCall : public ThreadHandle :: ObjectInterface
+        {
+            std::shared_ptr< OutputSnapshot > snapshot_;
+            const Opm::PhaseUsage phaseUsage_;
+            const EclipseState& eclipseState_;
+            const SummaryPlan summaryPlan_;
+            const bool restartDoubleSi_;
+
+            SnapshotCall( const std::shared_ptr< OutputSnapshot >& snapshot,
+                          const Opm::PhaseUsage& phaseUsage,
+                          const EclipseState& eclipseState,
+                          const SummaryPlan& summaryPlan,
+                          const bool restartDoubleSi )
+                : snapshot_( snapshot ),
+                  phaseUsage_( phaseUsage ),
+                  eclipseState_( eclipseState ),
+                  summaryPlan_( summaryPlan ),
+                  restartDoubleSi_( restartDoubleSi )
+            {
+            }
+
+            // the derived fields of writeTimeStep from the copy of the
+            // model's fields, the warnings of unhandled restart keywords are
+            // not logged from this thread
+            void run ()
+            {
+                OutputSnapshot& snapshot = *snapshot_;
+                const RestartConfig& restartConfig = eclipseState_.getRestartConfig();
+                getCellData( snapshot.cellData_, std::move( snapshot.simulatorData_ ), snapshot.state_,
+                             phaseUsage_, snapshot, restartConfig, snapshot.timer_->reportStepNum(),
+                             restartDoubleSi_, false );
+                if( summaryPlan_.needsFIP() ) {
+                    getFIPSummaryData( snapshot.cellData_, phaseUsage_, std::move( snapshot.fipData_ ), summaryPlan_ );
+                }
+            }
+        };
+    }
+
+
+
+
+    void
+    BlackoilOutputWriter::
+    takeSnapshot(const SimulatorTimerInterface& timer,
+                 const SimulationDataContainer& localState,
+                 const WellStateFullyImplicitBlackoil& localWellState,
+                 SimulationDataContainer&& simulatorData,
+                 FIPData&& fipData,
+                 const std::map<std::string, double>& miscSummaryData,
+                 const std::map<std::string, std::vector<double>>& extraRestartData,
+                 bool substep)
+    {
+        TimerTree::Region region("snapshot");
+        assert( ! pendingSnapshot_ );
+        pendingSnapshot_.reset( new detail::OutputSnapshot( timer, localState, localWellState,
+                                                            std::move( simulatorData ), std::move( fipData ),
+                                                            miscSummaryData, extraRestartData, substep ) );
+        snapshotOutput_->dispatch( detail::SnapshotCall( pendingSnapshot_, phaseUsage_, eclipseState_, summaryPlan_, restart_double_si_ ) );
+    }
+
+
+
+
+    void
+    BlackoilOutputWriter::
+    finishSnapshot()
+    {
+        if( ! pendingSnapshot_ ) {
+            return;
+        }
+        std::shared_ptr< detail::OutputSnapshot > snapshot;
+        snapshot.swap( pendingSnapshot_ );
+
+        // the cell data of the snapshot, all processes fail together
+        int err = 0;
+        std::string emsg;
+        {
+            TimerTree::Region region("wait for snapshot");
+            try {
+                snapshotOutput_->wait();
+            } catch (const std::exception& msg) {
+                err = 1;
+                emsg = msg.what();
+            }
+        }
+#if HAVE_MPI
+        MPI_Allreduce(MPI_IN_PLACE, &err, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+        if (err) {
+            throw std::runtime_error(emsg.empty() ? std::string("Snapshot output failed on another process.") : emsg);
+        }
+
+        TimerTree::Region region("output");
+        OPM_PROFILE_REGION("output");
+        writeTimeStepWithCellProperties( *snapshot->timer_, snapshot->state_, snapshot->cellData_,
+                                         snapshot->wellState_, snapshot->miscSummaryData_,
+                                         snapshot->extraRestartData_, snapshot->substep_ );
     }
 
 
@@ -230,6 +437,10 @@ namespace Opm
                   const std::map<std::string, std::vector<double>>& extraRestartData,
                   bool substep)
     {
+        TimerTree::Region region("output");
+        OPM_PROFILE_REGION("output");
+        // the output of the previous step in the snapshot output mode
+        finishSnapshot();
         data::Solution localCellData{};
         if( output_ )
         {
@@ -254,11 +465,45 @@ namespace Opm
                   const std::map<std::string, std::vector<double>>& extraRestartData,
                   bool substep)
     {
+        TimerTree::Region region("write time step");
         // VTK output (is parallel if grid is parallel)
         if( vtkWriter_ ) {
             vtkWriter_->writeTimeStep( timer, localState, localWellState, false );
         }
 
+        // HDF5 output of the cells owned by every process, collective
+        if( hdf5Writer_ ) {
+            hdf5Writer_->writeTimeStep( timer, localState, localWellState, localCellData, substep );
+        }
+
+        // checkpoint of the local state, written by every process
+        if( ! checkpointBase_.empty() ) {
+            writeCheckpoint( timer, localState, localWellState );
+        }
+
+        // distributed output of the report steps, no data leaves the process
+        if( distributedOutput_ )
+        {
+            int err = 0;
+            std::string emsg;
+            if( ! substep )
+            {
+                try {
+                    writeOutputShard( timer, localState, localCellData );
+                } catch (std::runtime_error& msg) {
+                    err = 1;
+                    emsg = msg.what();
+                }
+            }
+#if HAVE_MPI
+            MPI_Allreduce(MPI_IN_PLACE, &err, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+            if (err) {
+                throw std::runtime_error(emsg.empty() ? std::string("I/O process encountered problems.") : emsg);
+            }
+            return;
+        }
+
         bool isIORank = output_ ;
         if( parallelOutput_ && parallelOutput_->isParallel() )
         {
@@ -286,8 +531,12 @@ namespace Opm
         if( isIORank )
         {
             if( asyncOutput_ ) {
-                // dispatch the write call to the extra thread
-                asyncOutput_->dispatch( detail::WriterCall( *this, timer, state, wellState, cellData, miscSummaryData, extraRestartData, substep ) );
+                // dispatch the write calls to the output threads, one channel per writer
+                std::shared_ptr< const detail::WriterData >
+                    data( new detail::WriterData( timer, state, wellState, cellData, miscSummaryData, extraRestartData, substep ) );
+                for( int channel = 0; channel < NumOutputChannels; ++channel ) {
+                    asyncOutput_->dispatch( detail::WriterCall( *this, OutputChannel(channel), data ), channel );
+                }
             }
             else {
                 // just write the data to disk
@@ -316,6 +565,184 @@ namespace Opm
 
 
 
+    void
+    BlackoilOutputWriter::
+    writeOutputShard(const SimulatorTimerInterface& timer,
+                     const SimulationDataContainer& localState,
+                     const data::Solution& localCellData)
+    {
+        const std::vector<int>& cells = parallelOutput_->ownedCells();
+        const std::size_t numCells = cells.size();
+
+        OutputShard shard;
+        shard.reportStep = timer.reportStepNum();
+        shard.time = timer.simulationTimeElapsed();
+        shard.globalCell = parallelOutput_->ownedGlobalCell();
+        for (const auto& pair : localCellData) {
+            const auto& data = pair.second.data;
+            const std::size_t stride = data.size() / localState.numCells();
+            std::vector<double>& values = shard.fields[ pair.first ];
+            values.resize( numCells * stride );
+            for( std::size_t i = 0; i < numCells; ++i )
+            {
+                for( std::size_t c = 0; c < stride; ++c )
+                {
+                    values[ i * stride + c ] = data[ cells[ i ] * stride + c ];
+                }
+            }
+        }
+
+        const std::string filename = OutputShard::filename( outputDir_, eclipseState_.getIOConfig().getBaseName(),
+                                                            parallelOutput_->rank(), shard.reportStep );
+        OutputShard::write( filename, shard );
+    }
+
+
+
+    void
+    BlackoilHdf5Writer::
+    writeTimeStep(const SimulatorTimerInterface& timer,
+                  const SimulationDataContainer& state,
+                  const WellStateFullyImplicitBlackoil& wellState,
+                  const data::Solution& cellData,
+                  bool substep)
+    {
+        if( substep ) {
+            return;
+        }
+        TimerTree::Region region("HDF5 output");
+        const std::vector<int>& cells = parallelOutput_.ownedCells();
+        const std::size_t numCells = cells.size();
+        const std::size_t numLocalCells = state.numCells();
+
+        // the entries of the owned cells of an array with the components
+        // of a cell stored contiguously
+        auto owned = [ & ]( const std::vector<double>& data, const std::size_t stride ) {
+            std::vector<double> values( numCells * stride );
+            for( std::size_t i = 0; i < numCells; ++i ) {
+                for( std::size_t c = 0; c < stride; ++c ) {
+                    values[ i * stride + c ] = data[ cells[ i ] * stride + c ];
+                }
+            }
+            return values;
+        };
+
+        file_.beginStep( timer.reportStepNum(), timer.simulationTimeElapsed() );
+        file_.write( "global_cell", parallelOutput_.ownedGlobalCell() );
+        for( const auto& pair : state.cellData() ) {
+            const std::size_t stride = numLocalCells > 0 ? pair.second.size() / numLocalCells : 1;
+            file_.write( "state/" + pair.first, owned( pair.second, stride ), stride );
+        }
+        for( const auto& pair : cellData ) {
+            const auto& data = pair.second.data;
+            const std::size_t stride = numLocalCells > 0 ? data.size() / numLocalCells : 1;
+            file_.write( "cells/" + pair.first, owned( data, stride ), stride );
+        }
+
+        // the wells in the order of their names, processes without wells
+        // take the number of phases from the others
+        const int nw = wellState.numWells();
+        const int np = std::max( nw > 0 ? int( wellState.wellRates().size() ) / nw : 1, 1 );
+        std::vector<std::string> names, perfWells;
+        std::vector<double> bhp, thp, temperature, rates, perfPressure, perfRates;
+        for( const auto& well : wellState.wellMap() ) {
+            const int w = well.second[ 0 ];
+            names.push_back( well.first );
+            bhp.push_back( wellState.bhp()[ w ] );
+            thp.push_back( wellState.thp()[ w ] );
+            temperature.push_back( wellState.temperature()[ w ] );
+            for( int p = 0; p < np; ++p ) {
+                rates.push_back( wellState.wellRates()[ w * np + p ] );
+            }
+            const int firstPerf = well.second[ 1 ];
+            for( int perf = firstPerf; perf < firstPerf + well.second[ 2 ]; ++perf ) {
+                perfWells.push_back( well.first );
+                perfPressure.push_back( wellState.perfPress()[ perf ] );
+                for( int p = 0; p < np; ++p ) {
+                    perfRates.push_back( wellState.perfPhaseRates()[ perf * np + p ] );
+                }
+            }
+        }
+        file_.write( "wells/name", names );
+        file_.write( "wells/bhp", bhp );
+        file_.write( "wells/thp", thp );
+        file_.write( "wells/temperature", temperature );
+        file_.write( "wells/rates", rates, np );
+        file_.write( "perforations/well", perfWells );
+        file_.write( "perforations/pressure", perfPressure );
+        file_.write( "perforations/rates", perfRates, np );
+        file_.endStep();
+    }
+
+
+
+    void
+    BlackoilOutputWriter::
+    writeCheckpoint(const SimulatorTimerInterface& timer,
+                    const SimulationDataContainer& localState,
+                    const WellStateFullyImplicitBlackoil& localWellState)
+    {
+        const int reportStep      = timer.reportStepNum();
+        const int currentTimeStep = timer.currentStepNum();
+        // the report steps, as for the backup file
+        if( ! ( reportStep == currentTimeStep || currentTimeStep == 0 || timer.done() )
+            || lastCheckpointReportStep_ == reportStep )
+        {
+            return;
+        }
+        lastCheckpointReportStep_ = reportStep;
+
+        // the arrays are copied, the state changes while the copy is written
+        std::shared_ptr< CheckpointFile::Chunks > chunks( new CheckpointFile::Chunks );
+        addToCheckpoint( *chunks, localState );
+        addToCheckpoint( *chunks, localWellState );
+
+        const int rank = parallelOutput_ ? parallelOutput_->rank() : 0;
+        detail::CheckpointData data;
+        data.filename = CheckpointFile::filename( checkpointBase_, rank, reportStep );
+        data.reportStep = reportStep;
+        data.chunks = chunks;
+        data.tolerance = checkpointDeltaTolerance_;
+        data.compression = checkpointCompression_;
+
+        // every keyframe interval a full checkpoint, deltas to it between,
+        // the keyframe is kept in memory for the comparison
+        if( checkpointKeyframe_ && ++checkpointsSinceKeyframe_ < checkpointKeyframeInterval_ ) {
+            data.keyframe = checkpointKeyframe_;
+            data.keyframeStep = checkpointKeyframeStep_;
+        }
+        else {
+            data.keyframeStep = reportStep;
+            checkpointsSinceKeyframe_ = 0;
+            if( checkpointKeyframeInterval_ > 1 ) {
+                checkpointKeyframe_ = chunks;
+                checkpointKeyframeStep_ = reportStep;
+            }
+        }
+
+        if( asyncOutput_ && asyncOutput_->numThreads() > 0 ) {
+            asyncOutput_->dispatch( detail::CheckpointCall( data ), BackupOutput );
+            return;
+        }
+
+        int err = 0;
+        std::string emsg;
+        try {
+            data.write();
+        } catch (std::runtime_error& msg) {
+            err = 1;
+            emsg = msg.what();
+        }
+#if HAVE_MPI
+        MPI_Allreduce(MPI_IN_PLACE, &err, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+        if (err) {
+            throw std::runtime_error(emsg.empty() ? std::string("I/O process encountered problems.") : emsg);
+        }
+    }
+
+
+
     void
     BlackoilOutputWriter::
     writeTimeStepSerial(const SimulatorTimerInterface& timer,
@@ -325,14 +752,31 @@ namespace Opm
                         const std::map<std::string, double>& miscSummaryData,
                         const std::map<std::string, std::vector<double>>& extraRestartData,
                         bool substep)
+    {
+        for( int channel = 0; channel < NumOutputChannels; ++channel ) {
+            writeTimeStepSerial( OutputChannel(channel), timer, state, wellState, simProps,
+                                 miscSummaryData, extraRestartData, substep );
+        }
+    }
+
+    void
+    BlackoilOutputWriter::
+    writeTimeStepSerial(const OutputChannel channel,
+                        const SimulatorTimerInterface& timer,
+                        const SimulationDataContainer& state,
+                        const WellStateFullyImplicitBlackoil& wellState,
+                        const data::Solution& simProps,
+                        const std::map<std::string, double>& miscSummaryData,
+                        const std::map<std::string, std::vector<double>>& extraRestartData,
+                        bool substep)
     {
         // Matlab output
-        if( matlabWriter_ ) {
+        if( channel == MatlabOutput && matlabWriter_ ) {
             matlabWriter_->writeTimeStep( timer, state, wellState, substep );
         }
 
         // ECL output
-        if ( eclIO_ )
+        if ( channel == EclipseOutput && eclIO_ )
         {
             const auto& initConfig = eclipseState_.getInitConfig();
             if (initConfig.restartRequested() && ((initConfig.getRestartStep()) == (timer.currentStepNum()))) {
@@ -351,7 +795,7 @@ namespace Opm
         }
 
         // write backup file
-        if( backupfile_.is_open() )
+        if( channel == BackupOutput && backupfile_.is_open() )
         {
             int reportStep      = timer.reportStepNum();
             int currentTimeStep = timer.currentStepNum();
@@ -388,6 +832,11 @@ namespace Opm
             const std::string& filename,
             const int desiredResportStep )
     {
+        if( ! checkpointBase_.empty() ) {
+            restoreCheckpoint( timer, state, wellState, filename, desiredResportStep );
+            return;
+        }
+
         std::ifstream restorefile( filename.c_str() );
         if( restorefile )
         {
@@ -453,6 +902,83 @@ namespace Opm
     }
 
 
+    void
+    BlackoilOutputWriter::
+    restoreCheckpoint(SimulatorTimerInterface& timer,
+                      BlackoilState& state,
+                      WellStateFullyImplicitBlackoil& wellState,
+                      const std::string& baseName,
+                      const int desiredReportStep )
+    {
+        const int rank = parallelOutput_ ? parallelOutput_->rank() : 0;
+        // true if the checkpoint of the step exists on all processes
+        auto exists = [ &baseName, rank ] ( const int reportStep ) {
+            int found = std::ifstream( CheckpointFile::filename( baseName, rank, reportStep ).c_str() ) ? 1 : 0;
+#if HAVE_MPI
+            MPI_Allreduce(MPI_IN_PLACE, &found, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+#endif
+            return found == 1;
+        };
+
+        int reportStep = timer.reportStepNum();
+        if( ! exists( reportStep ) )
+        {
+            std::cerr << "Warning: Couldn't open restore checkpoint '"
+                      << CheckpointFile::filename( baseName, rank, reportStep ) << "'" << std::endl;
+            return;
+        }
+
+        std::cout << "============================================================================"<<std::endl;
+        std::cout << "Restoring from ";
+        if( desiredReportStep < 0 ) {
+            std::cout << "last";
+        }
+        else {
+            std::cout << desiredReportStep;
+        }
+        std::cout << " report step! checkpoints = " << baseName << std::endl << std::endl;
+
+        const int readReportStep = (desiredReportStep < 0) ?
+            std::numeric_limits<int>::max() : desiredReportStep;
+
+        while( reportStep <= readReportStep && ! timer.done() )
+        {
+            {
+                // the chunks are mapped, only copied into the state
+                const std::string name = CheckpointFile::filename( baseName, rank, reportStep );
+                std::unique_ptr< CheckpointFile > keyframe;
+                std::unique_ptr< CheckpointFile > checkpoint( new CheckpointFile( name ) );
+                if( checkpoint->isDelta() ) {
+                    keyframe.reset( new CheckpointFile( CheckpointFile::filename( baseName, rank, checkpoint->keyframeStep() ) ) );
+                    checkpoint.reset( new CheckpointFile( name, *keyframe ) );
+                }
+                restoreFromCheckpoint( *checkpoint, state );
+                restoreFromCheckpoint( *checkpoint, wellState );
+            }
+
+            // the checkpoint of the restored step exists already
+            lastCheckpointReportStep_ = reportStep;
+            writeTimeStepWithoutCellProperties( timer, state, wellState, {}, {});
+
+            // some output
+            std::cout << "Restored step " << timer.reportStepNum() << " at day "
+                      <<  unit::convert::to(timer.simulationTimeElapsed(),unit::day) << std::endl;
+
+            if( readReportStep == reportStep || ! exists( reportStep + 1 ) ) {
+                break;
+            }
+
+            // next step
+            ++reportStep;
+            timer.advance();
+
+            if( timer.reportStepNum() != reportStep ) {
+                break;
+            }
+        }
+    }
+
+
     bool BlackoilOutputWriter::isRestart() const {
         const auto& initconfig = eclipseState_.getInitConfig();
         return initconfig.restartRequested();
@@ -41,12 +41,20 @@
 
 #include <opm/autodiff/WellStateFullyImplicitBlackoil.hpp>
 #include <opm/autodiff/ThreadHandle.hpp>
+#include <opm/autodiff/CheckpointFile.hpp>
+#include <opm/autodiff/Hdf5Output.hpp>
+#include <opm/autodiff/MatlabStepWriter.hpp>
+#include <opm/autodiff/TimerTree.hpp>
+#include <opm/autodiff/ProfilerAnnotations.hpp>
 #include <opm/autodiff/AutoDiffBlock.hpp>
+#include <opm/autodiff/BlackoilModelEnums.hpp>
 
 #include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
 #include <opm/parser/eclipse/EclipseState/InitConfig/InitConfig.hpp>
 #include <opm/simulators/ensureDirectoryExists.hpp>
+#include <opm/simulators/vtk/writeVtkData.hpp>
 
+#include <algorithm>
 #include <string>
 #include <sstream>
 #include <iomanip>
@@ -68,23 +76,27 @@ namespace Opm
     void outputStateVtk(const UnstructuredGrid& grid,
                         const Opm::SimulationDataContainer& state,
                         const int step,
-                        const std::string& output_dir);
+                        const std::string& output_dir,
+                        const VtkEncoding encoding = VtkEncoding::Ascii);
 
     void outputWellStateMatlab(const Opm::WellState& well_state,
                                const int step,
                                const std::string& output_dir);
+
+    void outputWellStateMatlab(const Opm::WellState& well_state,
+                               MatlabStepWriter& writer);
 #ifdef HAVE_OPM_GRID
     void outputStateVtk(const Dune::CpGrid& grid,
                         const Opm::SimulationDataContainer& state,
                         const int step,
-                        const std::string& output_dir);
+                        const std::string& output_dir,
+                        const VtkEncoding encoding = VtkEncoding::Ascii);
 #endif
 
     template<class Grid>
     void outputStateMatlab(const Grid& grid,
                            const Opm::SimulationDataContainer& state,
-                           const int step,
-                           const std::string& output_dir)
+                           MatlabStepWriter& writer)
     {
         Opm::DataMap dm;
         dm["saturation"] = &state.saturation();
@@ -120,22 +132,24 @@ namespace Opm
                                   state.faceflux(), cell_velocity);
         dm["velocity"] = &cell_velocity;
 
-        // Write data (not grid) in Matlab format
+        // Write data (not grid) in Matlab format, one row per cell
+        const std::size_t numCells = AutoDiffGrid::numCells(grid);
         for (Opm::DataMap::const_iterator it = dm.begin(); it != dm.end(); ++it) {
-            std::ostringstream fname;
-            fname << output_dir << "/" << it->first;
-            ensureDirectoryExists(fname.str());
-            fname << "/" << std::setw(3) << std::setfill('0') << step << ".txt";
-            std::ofstream file(fname.str().c_str());
-            if (!file) {
-                OPM_THROW(std::runtime_error, "Failed to open " << fname.str());
-            }
-            file.precision(15);
             const std::vector<double>& d = *(it->second);
-            std::copy(d.begin(), d.end(), std::ostream_iterator<double>(file, "\n"));
+            writer.write(it->first, d, numCells > 0 ? d.size() / numCells : 1);
         }
     }
 
+    template<class Grid>
+    void outputStateMatlab(const Grid& grid,
+                           const Opm::SimulationDataContainer& state,
+                           const int step,
+                           const std::string& output_dir)
+    {
+        MatlabStepWriter writer(output_dir, step);
+        outputStateMatlab(grid, state, writer);
+    }
+
     class BlackoilSubWriter {
         public:
             BlackoilSubWriter( const std::string& outputDir )
@@ -154,9 +168,11 @@ namespace Opm
     class BlackoilVTKWriter : public BlackoilSubWriter {
         public:
             BlackoilVTKWriter( const Grid& grid,
-                               const std::string& outputDir )
+                               const std::string& outputDir,
+                               const VtkEncoding encoding = VtkEncoding::Ascii )
                 : BlackoilSubWriter( outputDir )
                 , grid_( grid )
+                , encoding_( encoding )
         {}
 
             void writeTimeStep(const SimulatorTimerInterface& timer,
@@ -164,11 +180,12 @@ namespace Opm
                     const WellStateFullyImplicitBlackoil&,
                     bool /*substep*/ = false) override
             {
-                outputStateVtk(grid_, state, timer.currentStepNum(), outputDir_);
+                outputStateVtk(grid_, state, timer.currentStepNum(), outputDir_, encoding_);
             }
 
         protected:
             const Grid& grid_;
+            const VtkEncoding encoding_;
     };
 
     template< typename Grid >
@@ -176,9 +193,13 @@ namespace Opm
     {
         public:
             BlackoilMatlabWriter( const Grid& grid,
-                             const std::string& outputDir )
+                             const std::string& outputDir,
+                             const MatlabStepWriter::Encoding encoding = MatlabStepWriter::Text,
+                             const bool singlePrecision = false )
                 : BlackoilSubWriter( outputDir )
                 , grid_( grid )
+                , encoding_( encoding )
+                , singlePrecision_( singlePrecision )
         {}
 
         void writeTimeStep(const SimulatorTimerInterface& timer,
@@ -186,15 +207,89 @@ namespace Opm
                            const WellStateFullyImplicitBlackoil& wellState,
                            bool /*substep*/ = false) override
         {
-            outputStateMatlab(grid_, reservoirState, timer.currentStepNum(), outputDir_);
-            outputWellStateMatlab(wellState, timer.currentStepNum(), outputDir_);
+            MatlabStepWriter writer(outputDir_, timer.currentStepNum(), encoding_, singlePrecision_);
+            outputStateMatlab(grid_, reservoirState, writer);
+            outputWellStateMatlab(wellState, writer);
+            writer.finish();
         }
 
         protected:
             const Grid& grid_;
+            const MatlabStepWriter::Encoding encoding_;
+            const bool singlePrecision_;
+    };
+
+
+    /// Writes the cells owned by this process and its wells to an HDF5
+    /// file shared by all processes, written by all of them together, see
+    /// Hdf5Output. Only report steps are written.
+    class BlackoilHdf5Writer : public BlackoilSubWriter
+    {
+        public:
+            BlackoilHdf5Writer( const std::string& outputDir,
+                                const std::string& baseName,
+                                const ParallelDebugOutputInterface& parallelOutput,
+                                const int compression,
+                                const OutputPrecision& precision = OutputPrecision() )
+                : BlackoilSubWriter( outputDir )
+                , parallelOutput_( parallelOutput )
+                , file_( outputDir + "/" + baseName + ".h5", compression, precision )
+        {}
+
+        void writeTimeStep(const SimulatorTimerInterface& timer,
+                           const SimulationDataContainer& state,
+                           const WellStateFullyImplicitBlackoil& wellState,
+                           bool substep = false) override
+        {
+            writeTimeStep(timer, state, wellState, data::Solution(), substep);
+        }
+
+        /// Write the arrays of the state to the group state, the cell data,
+        /// e.g. that requested by RPTRST, to the group cells and the wells
+        /// of the process to the groups wells and perforations. A well with
+        /// perforations on several processes is written by each of them.
+        void writeTimeStep(const SimulatorTimerInterface& timer,
+                           const SimulationDataContainer& state,
+                           const WellStateFullyImplicitBlackoil& wellState,
+                           const data::Solution& cellData,
+                           bool substep);
+
+        protected:
+            const ParallelDebugOutputInterface& parallelOutput_;
+            Hdf5Output file_;
     };
 
 
+    namespace detail {
+        struct OutputSnapshot;
+
+        /**
+         * The fluid in place fields of the summary, resolved once from the
+         * summary config instead of looking up its keywords at every step.
+         */
+        struct SummaryPlan
+        {
+            explicit SummaryPlan(const SummaryConfig& summaryConfig);
+
+            /// Whether any field needs the fluid in place of the model.
+            bool needsFIP() const
+            {
+                return wip || oipl || oipg || oip || gipg || gipl || gip || rpv || prh;
+            }
+
+            bool wip;
+            bool oipl;
+            bool oipg;
+            bool oip;
+            bool gipg;
+            bool gipl;
+            bool gip;
+            bool rpv;
+            bool prh;
+        };
+    }
+
+
     /// Extra data to read/write for OPM restarting
     struct ExtraData
     {
@@ -274,6 +369,34 @@ namespace Opm
                                  const std::map<std::string, std::vector<double>>& extraRestartData,
                                  bool substep);
 
+        /*!
+         * \brief The writers of writeTimeStepSerial. With asynchronous output
+         *        every writer is dispatched to its own channel of the output
+         *        threads, i.e. the writers run in parallel while the steps of
+         *        one writer are written in order.
+         */
+        enum OutputChannel { MatlabOutput = 0, EclipseOutput, BackupOutput, NumOutputChannels };
+
+        /*!
+         * \brief Write the part of writeTimeStepSerial belonging to one writer.
+         */
+        void writeTimeStepSerial(const OutputChannel channel,
+                                 const SimulatorTimerInterface& timer,
+                                 const SimulationDataContainer& reservoirState,
+                                 const Opm::WellStateFullyImplicitBlackoil& wellState,
+                                 const data::Solution& simProps,
+                                 const std::map<std::string, double>& miscSummaryData,
+                                 const std::map<std::string, std::vector<double>>& extraRestartData,
+                                 bool substep);
+
+        /*!
+         * \brief Complete the output of the step whose snapshot was taken by
+         *        writeTimeStep in the snapshot output mode, collective. Called
+         *        by writeTimeStep before the next step, and must be called by
+         *        the simulator after the last one.
+         */
+        void finishSnapshot();
+
         /** \brief return output directory */
         const std::string& outputDirectory() const { return outputDir_; }
 
@@ -305,23 +428,114 @@ namespace Opm
         bool requireFIPNUM() const;
 
     protected:
+        /*!
+         * \brief Take the snapshot of a step in the snapshot output mode for
+         *        a model which returns its derived fields in a copy, the cell
+         *        data is computed in the background. Returns false if the
+         *        mode is not enabled.
+         */
+        template<class Model>
+        bool snapshotTimeStep(const SimulatorTimerInterface& timer,
+                              const SimulationDataContainer& localState,
+                              const WellStateFullyImplicitBlackoil& localWellState,
+                              const Model& physicalModel,
+                              SimulationDataContainer&& simulatorData,
+                              const std::map<std::string, double>& miscSummaryData,
+                              const std::map<std::string, std::vector<double>>& extraRestartData,
+                              bool substep);
+
+        /*!
+         * \brief The derived fields of the other models reference the arrays
+         *        of the model, they are always written synchronously.
+         */
+        template<class Model, class SimulatorData>
+        bool snapshotTimeStep(const SimulatorTimerInterface& /* timer */,
+                              const SimulationDataContainer& /* localState */,
+                              const WellStateFullyImplicitBlackoil& /* localWellState */,
+                              const Model& /* physicalModel */,
+                              const SimulatorData& /* simulatorData */,
+                              const std::map<std::string, double>& /* miscSummaryData */,
+                              const std::map<std::string, std::vector<double>>& /* extraRestartData */,
+                              bool /* substep */)
+        {
+            return false;
+        }
+
+        /*!
+         * \brief Copy the data of a step and dispatch the computation of its
+         *        cell data to the snapshot thread.
+         */
+        void takeSnapshot(const SimulatorTimerInterface& timer,
+                          const SimulationDataContainer& localState,
+                          const WellStateFullyImplicitBlackoil& localWellState,
+                          SimulationDataContainer&& simulatorData,
+                          FIPData&& fipData,
+                          const std::map<std::string, double>& miscSummaryData,
+                          const std::map<std::string, std::vector<double>>& extraRestartData,
+                          bool substep);
+
+        /*!
+         * \brief Write the cells owned by this process to its output shard
+         *        of the report step, used by distributed output.
+         */
+        void writeOutputShard(const SimulatorTimerInterface& timer,
+                              const SimulationDataContainer& localState,
+                              const data::Solution& localCellData);
+
+        /*!
+         * \brief Write the local state of this process to its checkpoint
+         *        file of the report step, used by the chunked backup format.
+         */
+        void writeCheckpoint(const SimulatorTimerInterface& timer,
+                             const SimulationDataContainer& localState,
+                             const WellStateFullyImplicitBlackoil& localWellState);
+
+        /*!
+         * \brief Restore from the checkpoint files of this process.
+         */
+        void restoreCheckpoint(SimulatorTimerInterface& timer,
+                               BlackoilState& state,
+                               WellStateFullyImplicitBlackoil& wellState,
+                               const std::string& baseName,
+                               const int desiredReportStep);
+
         const bool output_;
         std::unique_ptr< ParallelDebugOutputInterface > parallelOutput_;
 
         // Parameters for output.
         const std::string outputDir_;
         const bool restart_double_si_;
+        // every process writes its own cells instead of gathering to the I/O rank
+        const bool distributedOutput_;
 
         int lastBackupReportStep_;
 
         std::ofstream backupfile_;
+        // base name of the per-process checkpoint files, empty unless the
+        // chunked backup format is used
+        std::string checkpointBase_;
+        CheckpointFile::Compression checkpointCompression_;
+        int lastCheckpointReportStep_;
+        // incremental checkpoints: a full keyframe every interval report
+        // steps, and deltas of the blocks changed beyond the tolerance
+        int checkpointKeyframeInterval_;
+        double checkpointDeltaTolerance_;
+        std::shared_ptr< const CheckpointFile::Chunks > checkpointKeyframe_;
+        int checkpointKeyframeStep_;
+        int checkpointsSinceKeyframe_;
         Opm::PhaseUsage phaseUsage_;
         std::unique_ptr< BlackoilSubWriter > vtkWriter_;
         std::unique_ptr< BlackoilSubWriter > matlabWriter_;
+        std::unique_ptr< BlackoilHdf5Writer > hdf5Writer_;
         std::unique_ptr< EclipseIO > eclIO_;
         const EclipseState& eclipseState_;
+        const detail::SummaryPlan summaryPlan_;
 
         std::unique_ptr< ThreadHandle > asyncOutput_;
+        // snapshot output: the thread computing the cell data of the step
+        // whose output is completed before the next one
+        std::unique_ptr< ThreadHandle > snapshotOutput_;
+        std::shared_ptr< detail::OutputSnapshot > pendingSnapshot_;
     };
 
 
@@ -347,18 +561,57 @@ namespace Opm
         parallelOutput_( output_ ? new ParallelDebugOutput< Grid >( grid, eclipseState, phaseUsage.num_phases, phaseUsage ) : 0 ),
         outputDir_( eclipseState.getIOConfig().getOutputDir() ),
         restart_double_si_( output_ ? param.getDefault("restart_double_si", false) : false ),
+        distributedOutput_( output_ ? param.getDefault("distributed_output", false) : false ),
         lastBackupReportStep_( -1 ),
+        checkpointCompression_( CheckpointFile::NoCompression ),
+        lastCheckpointReportStep_( -1 ),
+        checkpointKeyframeInterval_( 1 ),
+        checkpointDeltaTolerance_( 0.0 ),
+        checkpointKeyframeStep_( -1 ),
+        checkpointsSinceKeyframe_( 0 ),
         phaseUsage_( phaseUsage ),
         eclipseState_(eclipseState),
-        asyncOutput_()
+        summaryPlan_(eclipseState.getSummaryConfig()),
+        asyncOutput_(),
+        snapshotOutput_(),
+        pendingSnapshot_()
     {
         // For output.
         if ( output_ )
         {
             if ( param.getDefault("output_vtk",false) )
             {
+                // ascii, binary (appended raw data) or zlib (compressed appended data)
+                const std::string format = param.getDefault("output_vtk_format", std::string("ascii") );
+                VtkEncoding encoding = VtkEncoding::Ascii;
+                if( format == "binary" ) {
+                    encoding = VtkEncoding::Binary;
+                }
+                else if( format == "zlib" ) {
+                    encoding = VtkEncoding::BinaryZlib;
+                }
+                else if( format != "ascii" ) {
+                    OPM_THROW(std::runtime_error,"Unknown output_vtk_format " << format << ", use ascii, binary or zlib");
+                }
+                if( ! vtkEncodingAvailable( encoding ) ) {
+                    OPM_THROW(std::runtime_error,"output_vtk_format " << format << " is not available in this build");
+                }
                 vtkWriter_
-                    .reset(new BlackoilVTKWriter< Grid >( grid, outputDir_ ));
+                    .reset(new BlackoilVTKWriter< Grid >( grid, outputDir_, encoding ));
+            }
+
+            // every process writes its own cells to the shared file
+            if ( param.getDefault("output_hdf5", false) )
+            {
+                if( ! Hdf5Output::available() ) {
+                    OPM_THROW(std::runtime_error,"output_hdf5 is not available in this build");
+                }
+                ensureDirectoryExists(outputDir_);
+                hdf5Writer_
+                    .reset(new BlackoilHdf5Writer( outputDir_, eclipseState.getIOConfig().getBaseName(),
+                                                   *parallelOutput_,
+                                                   param.getDefault("output_hdf5_compression", int(1) ),
+                                                   OutputPrecision( param.getDefault("output_hdf5_precision", std::string("") ) ) ));
             }
 
             auto output_matlab = param.getDefault("output_matlab", false );
@@ -369,12 +622,54 @@ namespace Opm
                                      "Velocity output for matlab is broken in parallel.");
             }
 
+            if ( distributedOutput_ )
+            {
+                // every process writes its shard files
+                ensureDirectoryExists(outputDir_);
+                if ( parallelOutput_->isIORank() )
+                {
+                    Opm::OpmLog::warning("Parallel Output Config",
+                                         "Distributed output writes the cells of every process to its own shard file, "
+                                         "no ECLIPSE restart and summary files are written for the time steps.");
+                }
+            }
+
+            // the chunked backup format writes one checkpoint file per
+            // process and report step, instead of the backup file of the
+            // global state written by the I/O rank
+            const std::string backupfilename = param.getDefault("backupfile", std::string("") );
+            const std::string backupFormat = param.getDefault("backup_format", std::string("stream") );
+            if( ! backupfilename.empty() && backupFormat == "chunked" )
+            {
+                checkpointBase_ = backupfilename;
+                const std::string compression = param.getDefault("backup_compression", std::string("none") );
+                if( compression == "zlib" ) {
+                    checkpointCompression_ = CheckpointFile::ZlibCompression;
+                }
+                else if( compression != "none" ) {
+                    OPM_THROW(std::runtime_error,"Unknown backup_compression " << compression << ", use none or zlib");
+                }
+                if( ! CheckpointFile::compressionAvailable( checkpointCompression_ ) ) {
+                    OPM_THROW(std::runtime_error,"backup_compression " << compression << " is not available in this build");
+                }
+                // 1 writes every checkpoint in full
+                checkpointKeyframeInterval_ = std::max( param.getDefault("backup_keyframe_interval", int(1) ), 1 );
+                checkpointDeltaTolerance_ = param.getDefault("backup_delta_tolerance", double(0.0) );
+            }
+            else if( backupFormat != "stream" && backupFormat != "chunked" )
+            {
+                OPM_THROW(std::runtime_error,"Unknown backup_format " << backupFormat << ", use stream or chunked");
+            }
+
             if( parallelOutput_->isIORank() ) {
 
                 if ( output_matlab )
                 {
+                    // text, or the binary npy and raw formats with an index per step
+                    const auto encoding = MatlabStepWriter::encoding( param.getDefault("output_matlab_format", std::string("text") ) );
                     matlabWriter_
-                        .reset(new BlackoilMatlabWriter< Grid >( grid, outputDir_ ));
+                        .reset(new BlackoilMatlabWriter< Grid >( grid, outputDir_, encoding,
+                                                                 param.getDefault("output_matlab_float32", false) ));
                 }
 
                 eclIO_ = std::move(eclIO);
@@ -382,8 +677,7 @@ namespace Opm
                 // Ensure that output dir exists
                 ensureDirectoryExists(outputDir_);
 
-                std::string backupfilename = param.getDefault("backupfile", std::string("") );
-                if( ! backupfilename.empty() )
+                if( ! backupfilename.empty() && checkpointBase_.empty() )
                 {
                     backupfile_.open( backupfilename.c_str() );
                 }
@@ -398,11 +692,31 @@ namespace Opm
 #endif
             if( param.getDefault("async_output", asyncOutputDefault ) )
             {
+                // checkpoints are written by every process
                 const bool isIORank = parallelOutput_ ? parallelOutput_->isIORank() : true;
+                const bool createThreads = isIORank || ! checkpointBase_.empty();
+                // number of threads writing in parallel, at most one per writer
+                const int numThreads = std::min( param.getDefault("async_output_threads", int(NumOutputChannels) ),
+                                                 int(NumOutputChannels) );
+                // number of writes waiting for the threads before a time step
+                // waits, every waiting write holds a copy of the state
+                const int maxQueueSize = param.getDefault("async_output_queue_size", 2 * int(NumOutputChannels) );
 #if HAVE_PTHREAD
-                asyncOutput_.reset( new ThreadHandle( isIORank ) );
+                asyncOutput_.reset( new ThreadHandle( createThreads, numThreads, std::max( maxQueueSize, 1 ) ) );
 #else
                 OPM_THROW(std::runtime_error,"Pthreads were not found, cannot enable async_output");
+#endif
+            }
+
+            // snapshot output: writeTimeStep only copies the state and the
+            // fields of the model, the cell data is computed by a thread of
+            // every process while the next step is simulated
+            if( param.getDefault("output_snapshot", false ) )
+            {
+#if HAVE_PTHREAD
+                snapshotOutput_.reset( new ThreadHandle( true, 1, 1 ) );
+#else
+                OPM_THROW(std::runtime_error,"Pthreads were not found, cannot enable output_snapshot");
 #endif
             }
         }
@@ -419,17 +733,28 @@ namespace Opm
                          ExtraData& extra )
     {
         std::map<std::string, RestartKey> solution_keys {{"PRESSURE" , RestartKey(UnitSystem::measure::pressure)},
-                                                         {"SWAT" , RestartKey(UnitSystem::measure::identity)},
-                                                         {"SGAS" , RestartKey(UnitSystem::measure::identity)},
                                                          {"TEMP" , RestartKey(UnitSystem::measure::temperature)},
-                                                         {"RS" , RestartKey(UnitSystem::measure::gas_oil_ratio)},
-                                                         {"RV" , RestartKey(UnitSystem::measure::oil_gas_ratio)},
                                                          {"SOMAX", {UnitSystem::measure::identity, false}},
                                                          {"PCSWM_OW", {UnitSystem::measure::identity, false}},
                                                          {"KRNSW_OW", {UnitSystem::measure::identity, false}},
                                                          {"PCSWM_GO", {UnitSystem::measure::identity, false}},
                                                          {"KRNSW_GO", {UnitSystem::measure::identity, false}}};
 
+        // only the saturations of the active phases and the dissolution
+        // ratios of the state are read and converted
+        if (phaseUsage.phase_used[BlackoilPhases::Aqua]) {
+            solution_keys.emplace("SWAT", RestartKey(UnitSystem::measure::identity));
+        }
+        if (phaseUsage.phase_used[BlackoilPhases::Vapour]) {
+            solution_keys.emplace("SGAS", RestartKey(UnitSystem::measure::identity));
+        }
+        if (simulatorstate.hasCellData("GASOILRATIO")) {
+            solution_keys.emplace("RS", RestartKey(UnitSystem::measure::gas_oil_ratio));
+        }
+        if (simulatorstate.hasCellData("RV")) {
+            solution_keys.emplace("RV", RestartKey(UnitSystem::measure::oil_gas_ratio));
+        }
+
         std::map<std::string, bool> extra_keys {
             {"OPMEXTRA" , false}
         };
@@ -463,7 +788,8 @@ namespace Opm
         wellstate.resize(wells, simulatorstate, phaseUsage ); //Resize for restart step
         auto restart_values = eclIO_->loadRestart(solution_keys, extra_keys);
 
-        solutionToSim( restart_values.solution, restart_values.extra, phaseUsage, simulatorstate );
+        // the restart solution is not used afterwards, its fields are moved
+        solutionToSim( std::move(restart_values.solution), restart_values.extra, phaseUsage, simulatorstate );
         wellsToState( restart_values.wells, phaseUsage, wellstate );
 
         const auto opmextra_iter = restart_values.extra.find("OPMEXTRA");
@@ -484,112 +810,114 @@ namespace Opm
     namespace detail {
 
 
-        template <class V>
-        void addToSimData( SimulationDataContainer& simData,
-                           const std::string& name,
-                           const V& vec )
-        {
-            if (vec.size() == 0) {
-                return;
-            }
-
-            typedef std::vector< double > OutputVectorType;
-
-            // get data map
-            auto& dataMap = simData.cellData();
-
-            // insert name,vector into data map
-            dataMap.insert( std::make_pair( name, OutputVectorType( vec.data(), vec.data() + vec.size() ) ) );
-        }
-
-        template <class Scalar>
-        void addToSimData( SimulationDataContainer& simData,
-                           const std::string& name,
-                           const AutoDiffBlock<Scalar>& adb )
+        // Lazy access to the derived fields of the SimulatorData of a model
+        // with the interface of a SimulationDataContainer. The fields are
+        // only referenced, a field is converted to an output vector when
+        // getRestartData() actually writes it at a report step. Cell data
+        // of the reservoir state takes precedence over the model's.
+        class SimulatorDataFields
         {
-            // forward value of ADB to output
-            addToSimData( simData, name, adb.value() );
-        }
-
-
-        // this method basically converts all Eigen vectors to std::vectors
-        // stored in a SimulationDataContainer
-        template <class SimulatorData>
-        SimulationDataContainer
-        convertToSimulationDataContainer( const SimulatorData& sd,
-                                          const SimulationDataContainer& localState,
-                                          const Opm::PhaseUsage& phaseUsage )
-        {
-            // copy local state and then add missing data
-            SimulationDataContainer simData( localState );
+        public:
+            template <class SimulatorData>
+            SimulatorDataFields( const SimulatorData& sd,
+                                 const SimulationDataContainer& localState,
+                                 const Opm::PhaseUsage& phaseUsage )
+                : localState_( localState )
+            {
+                //Get shorthands for water, oil, gas
+                const int aqua_active   = phaseUsage.phase_used[Opm::PhaseUsage::Aqua];
+                const int liquid_active = phaseUsage.phase_used[Opm::PhaseUsage::Liquid];
+                const int vapour_active = phaseUsage.phase_used[Opm::PhaseUsage::Vapour];
+
+                const int aqua_idx   = phaseUsage.phase_pos[Opm::PhaseUsage::Aqua];
+                const int liquid_idx = phaseUsage.phase_pos[Opm::PhaseUsage::Liquid];
+                const int vapour_idx = phaseUsage.phase_pos[Opm::PhaseUsage::Vapour];
+
+                // WATER
+                if( aqua_active ) {
+                    add( "1OVERBW",  sd.rq[aqua_idx].b   );
+                    add( "WAT_DEN",  sd.rq[aqua_idx].rho );
+                    add( "WAT_VISC", sd.rq[aqua_idx].mu  );
+                    add( "WATKR",    sd.rq[aqua_idx].kr  );
+                }
 
-            //Get shorthands for water, oil, gas
-            const int aqua_active   = phaseUsage.phase_used[Opm::PhaseUsage::Aqua];
-            const int liquid_active = phaseUsage.phase_used[Opm::PhaseUsage::Liquid];
-            const int vapour_active = phaseUsage.phase_used[Opm::PhaseUsage::Vapour];
+                // OIL
+                if( liquid_active ) {
+                    add( "1OVERBO",  sd.rq[liquid_idx].b   );
+                    add( "OIL_DEN",  sd.rq[liquid_idx].rho );
+                    add( "OIL_VISC", sd.rq[liquid_idx].mu  );
+                    add( "OILKR",    sd.rq[liquid_idx].kr  );
+                }
 
-            const int aqua_idx   = phaseUsage.phase_pos[Opm::PhaseUsage::Aqua];
-            const int liquid_idx = phaseUsage.phase_pos[Opm::PhaseUsage::Liquid];
-            const int vapour_idx = phaseUsage.phase_pos[Opm::PhaseUsage::Vapour];
+                // GAS
+                if( vapour_active ) {
+                    add( "1OVERBG",  sd.rq[vapour_idx].b   );
+                    add( "GAS_DEN",  sd.rq[vapour_idx].rho );
+                    add( "GAS_VISC", sd.rq[vapour_idx].mu  );
+                    add( "GASKR",    sd.rq[vapour_idx].kr  );
+                }
 
-            // WATER
-            if( aqua_active ) {
-                addToSimData( simData, "1OVERBW",  sd.rq[aqua_idx].b   );
-                addToSimData( simData, "WAT_DEN",  sd.rq[aqua_idx].rho );
-                addToSimData( simData, "WAT_VISC", sd.rq[aqua_idx].mu  );
-                addToSimData( simData, "WATKR",    sd.rq[aqua_idx].kr  );
+                // RS and RV
+                add( "RSSAT", sd.rsSat );
+                add( "RVSAT", sd.rvSat );
+
+                add( "SOMAX", sd.soMax );
+                add( "PBUB", sd.Pb );
+                add( "PDEW", sd.Pd );
+                add( "PCSWMDC_OW", sd.pcswmdc_ow );
+                add( "KRNSWMDC_OW", sd.krnswdc_ow );
+                add( "PCSWMDC_GO", sd.pcswmdc_go );
+                add( "KRNSWMDC_GO", sd.krnswdc_go );
             }
 
-            // OIL
-            if( liquid_active ) {
-                addToSimData( simData, "1OVERBO",  sd.rq[liquid_idx].b   );
-                addToSimData( simData, "OIL_DEN",  sd.rq[liquid_idx].rho );
-                addToSimData( simData, "OIL_VISC", sd.rq[liquid_idx].mu  );
-                addToSimData( simData, "OILKR",    sd.rq[liquid_idx].kr  );
+            bool hasCellData( const std::string& name ) const
+            {
+                return localState_.hasCellData( name ) || fields_.count( name ) > 0;
             }
 
-            // GAS
-            if( vapour_active ) {
-                addToSimData( simData, "1OVERBG",  sd.rq[vapour_idx].b   );
-                addToSimData( simData, "GAS_DEN",  sd.rq[vapour_idx].rho );
-                addToSimData( simData, "GAS_VISC", sd.rq[vapour_idx].mu  );
-                addToSimData( simData, "GASKR",    sd.rq[vapour_idx].kr  );
+            std::vector< double > getCellData( const std::string& name ) const
+            {
+                if( localState_.hasCellData( name ) ) {
+                    return localState_.getCellData( name );
+                }
+                auto field = fields_.find( name );
+                if( field == fields_.end() ) {
+                    OPM_THROW(std::logic_error, "No output field " << name);
+                }
+                return std::vector< double >( field->second.first, field->second.first + field->second.second );
             }
 
-            // RS and RV
-            addToSimData( simData, "RSSAT", sd.rsSat );
-            addToSimData( simData, "RVSAT", sd.rvSat );
-
-            addToSimData( simData, "SOMAX", sd.soMax );
-            addToSimData( simData, "PBUB", sd.Pb );
-            addToSimData( simData, "PDEW", sd.Pd );
-            addToSimData( simData, "PCSWMDC_OW", sd.pcswmdc_ow );
-            addToSimData( simData, "KRNSWMDC_OW", sd.krnswdc_ow );
-            addToSimData( simData, "PCSWMDC_GO", sd.pcswmdc_go );
-            addToSimData( simData, "KRNSWMDC_GO", sd.krnswdc_go );
+        private:
+            template <class V>
+            void add( const std::string& name, const V& vec )
+            {
+                if (vec.size() == 0) {
+                    return;
+                }
+                fields_.insert( std::make_pair( name, std::make_pair( vec.data(), std::size_t( vec.size() ) ) ) );
+            }
 
-            return simData;
-        }
+            template <class Scalar>
+            void add( const std::string& name, const AutoDiffBlock<Scalar>& adb )
+            {
+                // forward value of ADB to output
+                add( name, adb.value() );
+            }
 
-        // in case the data is already in a SimulationDataContainer no
-        // conversion is needed
-        inline
-        SimulationDataContainer&&
-        convertToSimulationDataContainer( SimulationDataContainer&& sd,
-                                          const SimulationDataContainer& ,
-                                          const Opm::PhaseUsage& )
-        {
-            return std::move( sd );
-        }
+            const SimulationDataContainer& localState_;
+            std::map< std::string, std::pair< const double*, std::size_t > > fields_;
+        };
 
         /**
-         * Returns the data requested in the restartConfig
+         * Returns the data requested in the restartConfig.
+         * The fields are taken from sd, a SimulationDataContainer or
+         * the SimulatorDataFields of a model, only if they are written.
          * NOTE: Since this function steals data from the SimulationDataContainer (std::move),
          * the variable sd becomes "invalid" after calling this function.
          */
-        template<class Model>
+        template<class Model, class Fields>
         void getRestartData(data::Solution& output,
-                            SimulationDataContainer&& sd,
+                            Fields&& sd,
                             const Opm::PhaseUsage& /* phaseUsage */,
                             const Model& /* physicalModel */,
                             const RestartConfig& restartConfig,
@@ -707,7 +1035,7 @@ namespace Opm
              * Relative permeabilities for water, oil, gas
              */
             if (aqua_active && rstKeywords["KRW"] > 0) {
-                auto& krWater = sd.getCellData("WATKR");
+                auto&& krWater = sd.getCellData("WATKR");
                 if (krWater.size() > 0) {
                     rstKeywords["KRW"] = 0;
                     output.insert("WATKR", // WAT_KR ???
@@ -724,7 +1052,7 @@ namespace Opm
                 }
             }
             if (liquid_active && rstKeywords["KRO"] > 0) {
-                auto& krOil = sd.getCellData("OILKR");
+                auto&& krOil = sd.getCellData("OILKR");
                 if (krOil.size() > 0) {
                     rstKeywords["KRO"] = 0;
                     output.insert("OILKR",
@@ -741,7 +1069,7 @@ namespace Opm
                 }
             }
             if (vapour_active && rstKeywords["KRG"] > 0) {
-                auto& krGas = sd.getCellData("GASKR");
+                auto&& krGas = sd.getCellData("GASKR");
                 if (krGas.size() > 0) {
                     rstKeywords["KRG"] = 0;
                     output.insert("GASKR",
@@ -853,6 +1181,50 @@ namespace Opm
 
 
 
+        /**
+         * The solution and the requested restart fields of a model whose
+         * derived fields are held in a SimulatorData struct. They are
+         * written straight from the model's arrays.
+         */
+        template<class Model, class SimulatorData>
+        void getCellData(data::Solution& output,
+                         const SimulatorData& sd,
+                         const SimulationDataContainer& localState,
+                         const Opm::PhaseUsage& phaseUsage,
+                         const Model& physicalModel,
+                         const RestartConfig& restartConfig,
+                         const int reportStepNum,
+                         const bool restart_double_si,
+                         const bool log)
+        {
+            output = simToSolution( localState, restart_double_si, phaseUsage ); // Get "normal" data (SWAT, PRESSURE, ...);
+            getRestartData( output, SimulatorDataFields( sd, localState, phaseUsage ), phaseUsage,
+                            physicalModel, restartConfig, reportStepNum, log );
+        }
+
+        /**
+         * The solution and the requested restart fields of a model which
+         * returns all its fields in a SimulationDataContainer.
+         */
+        template<class Model>
+        void getCellData(data::Solution& output,
+                         SimulationDataContainer&& sd,
+                         const SimulationDataContainer& /* localState */,
+                         const Opm::PhaseUsage& phaseUsage,
+                         const Model& physicalModel,
+                         const RestartConfig& restartConfig,
+                         const int reportStepNum,
+                         const bool restart_double_si,
+                         const bool log)
+        {
+            output = simToSolution( sd, restart_double_si, phaseUsage ); // Get "normal" data (SWAT, PRESSURE, ...);
+            getRestartData( output, std::move( sd ), phaseUsage,
+                            physicalModel, restartConfig, reportStepNum, log );
+            // sd will be invalid after getRestartData has been called
+        }
+
+
+
         /**
          * Checks if the summaryConfig has a keyword with the standardized field, region, or block prefixes.
          */
@@ -867,19 +1239,17 @@ namespace Opm
 
 
         /**
-         * Returns the data as asked for in the summaryConfig
+         * Returns the data of the fluid in place fd as asked for in the
+         * summary plan. The vectors of fd are moved to the output.
          */
-        template<class Model>
-        void getSummaryData(data::Solution& output,
-                            const Opm::PhaseUsage& phaseUsage,
-                            const Model& physicalModel,
-                            const SummaryConfig& summaryConfig) {
+        template<class FIPDataType>
+        void getFIPSummaryData(data::Solution& output,
+                               const Opm::PhaseUsage& phaseUsage,
+                               FIPDataType fd,
+                               const SummaryPlan& plan) {
 
-            typedef typename Model::FIPDataType FIPDataType;
             typedef typename FIPDataType::VectorType VectorType;
 
-            FIPDataType fd = physicalModel.getFIPData();
-
             //Get shorthands for water, oil, gas
             const int aqua_active = phaseUsage.phase_used[Opm::PhaseUsage::Aqua];
             const int liquid_active = phaseUsage.phase_used[Opm::PhaseUsage::Liquid];
@@ -889,7 +1259,7 @@ namespace Opm
              * Now process all of the summary config files
              */
             // Water in place
-            if (aqua_active && hasFRBKeyword(summaryConfig, "WIP")) {
+            if (aqua_active && plan.wip) {
                 output.insert("WIP",
                               Opm::UnitSystem::measure::volume,
                               std::move( fd.fip[ FIPDataType::FIP_AQUA ] ),
@@ -910,21 +1280,21 @@ namespace Opm
                 }
 
                 //Oil in place (liquid phase only)
-                if (hasFRBKeyword(summaryConfig, "OIPL")) {
+                if (plan.oipl) {
                     output.insert("OIPL",
                                   Opm::UnitSystem::measure::volume,
                                   std::move( oipl ),
                                   data::TargetType::SUMMARY );
                 }
                 //Oil in place (gas phase only)
-                if (hasFRBKeyword(summaryConfig, "OIPG")) {
+                if (plan.oipg) {
                     output.insert("OIPG",
                                   Opm::UnitSystem::measure::volume,
                                   std::move( oipg ),
                                   data::TargetType::SUMMARY );
                 }
                 // Oil in place (in liquid and gas phases)
-                if (hasFRBKeyword(summaryConfig, "OIP")) {
+                if (plan.oip) {
                     output.insert("OIP",
                                   Opm::UnitSystem::measure::volume,
                                   std::move( oip ),
@@ -946,7 +1316,7 @@ namespace Opm
                 }
 
                 // Gas in place (gas phase only)
-                if (hasFRBKeyword(summaryConfig, "GIPG")) {
+                if (plan.gipg) {
                     output.insert("GIPG",
                                   Opm::UnitSystem::measure::volume,
                                   std::move( gipg ),
@@ -954,14 +1324,14 @@ namespace Opm
                 }
 
                 // Gas in place (liquid phase only)
-                if (hasFRBKeyword(summaryConfig, "GIPL")) {
+                if (plan.gipl) {
                     output.insert("GIPL",
                                   Opm::UnitSystem::measure::volume,
                                   std::move( gipl ),
                                   data::TargetType::SUMMARY );
                 }
                 // Gas in place (in both liquid and gas phases)
-                if (hasFRBKeyword(summaryConfig, "GIP")) {
+                if (plan.gip) {
                     output.insert("GIP",
                                   Opm::UnitSystem::measure::volume,
                                   std::move( gip ),
@@ -969,14 +1339,14 @@ namespace Opm
                 }
             }
             // Cell pore volume in reservoir conditions
-            if (hasFRBKeyword(summaryConfig, "RPV")) {
+            if (plan.rpv) {
                 output.insert("RPV",
                               Opm::UnitSystem::measure::volume,
                               std::move( fd.fip[FIPDataType::FIP_PV]),
                               data::TargetType::SUMMARY );
             }
             // Pressure averaged value (hydrocarbon pore volume weighted)
-            if (summaryConfig.hasKeyword("FPRH") || summaryConfig.hasKeyword("RPRH")) {
+            if (plan.prh) {
                 output.insert("PRH",
                               Opm::UnitSystem::measure::pressure,
                               std::move(fd.fip[FIPDataType::FIP_WEIGHTED_PRESSURE]),
@@ -984,6 +1354,21 @@ namespace Opm
             }
         }
 
+
+        /**
+         * Returns the data as asked for in the summary plan
+         */
+        template<class Model>
+        void getSummaryData(data::Solution& output,
+                            const Opm::PhaseUsage& phaseUsage,
+                            const Model& physicalModel,
+                            const SummaryPlan& plan) {
+            // the fluid in place is only copied from the model if a
+            // summary vector needs it
+            if (plan.needsFIP()) {
+                getFIPSummaryData(output, phaseUsage, physicalModel.getFIPData(), plan);
+            }
+        }
     }
 
 
@@ -1000,33 +1385,20 @@ namespace Opm
                   const double nextstep,
                   const SimulatorReport& simulatorReport)
     {
+        TimerTree::Region region("output");
+        OPM_PROFILE_REGION("output");
         data::Solution localCellData{};
         const RestartConfig& restartConfig = eclipseState_.getRestartConfig();
-        const SummaryConfig& summaryConfig = eclipseState_.getSummaryConfig();
         const int reportStepNum = timer.reportStepNum();
         bool logMessages = output_ && parallelOutput_->isIORank();
         std::map<std::string, std::vector<double>> extraRestartData;
         std::map<std::string, double> miscSummaryData;
 
+        // the output of the previous step in the snapshot output mode
+        finishSnapshot();
+
         if( output_ )
         {
-            {
-                // get all data that need to be included in output from the model
-                // for flow_legacy and polymer this is a struct holding the data
-                // while for flow_ebos a SimulationDataContainer is returned
-                // this is addressed in the above specialized methods
-                SimulationDataContainer sd =
-                    detail::convertToSimulationDataContainer( physicalModel.getSimulatorData(localState), localState, phaseUsage_ );
-
-                localCellData = simToSolution( sd, restart_double_si_, phaseUsage_); // Get "normal" data (SWAT, PRESSURE, ...);
-
-                detail::getRestartData( localCellData, std::move(sd), phaseUsage_, physicalModel,
-                                        restartConfig, reportStepNum, logMessages );
-                // sd will be invalid after getRestartData has been called
-            }
-            detail::getSummaryData( localCellData, phaseUsage_, physicalModel, summaryConfig );
-            assert(!localCellData.empty());
-
             // Add suggested next timestep to extra data.
             extraRestartData["OPMEXTRA"] = std::vector<double>(1, nextstep);
 
@@ -1035,9 +1407,55 @@ namespace Opm
             if (totalSolverTime != 0.0) {
                 miscSummaryData["TCPU"] = totalSolverTime;
             }
+
+            TimerTree::Region cellDataRegion("cell data");
+            // get all data that need to be included in output from the model
+            // for flow_legacy and polymer this is a struct holding the data
+            // while for flow_ebos a SimulationDataContainer is returned
+            // this is addressed in the above specialized methods
+            auto&& simulatorData = physicalModel.getSimulatorData(localState);
+            if( snapshotTimeStep( timer, localState, localWellState, physicalModel,
+                                  std::forward<decltype(simulatorData)>( simulatorData ),
+                                  miscSummaryData, extraRestartData, substep ) ) {
+                return;
+            }
+            detail::getCellData( localCellData, std::forward<decltype(simulatorData)>( simulatorData ), localState,
+                                 phaseUsage_, physicalModel, restartConfig, reportStepNum,
+                                 restart_double_si_, logMessages );
+            detail::getSummaryData( localCellData, phaseUsage_, physicalModel, summaryPlan_ );
+            assert(!localCellData.empty());
         }
 
         writeTimeStepWithCellProperties(timer, localState, localCellData, localWellState, miscSummaryData, extraRestartData, substep);
     }
+
+
+
+
+    template<class Model>
+    inline bool
+    BlackoilOutputWriter::
+    snapshotTimeStep(const SimulatorTimerInterface& timer,
+                     const SimulationDataContainer& localState,
+                     const WellStateFullyImplicitBlackoil& localWellState,
+                     const Model& physicalModel,
+                     SimulationDataContainer&& simulatorData,
+                     const std::map<std::string, double>& miscSummaryData,
+                     const std::map<std::string, std::vector<double>>& extraRestartData,
+                     bool substep)
+    {
+        if( ! snapshotOutput_ ) {
+            return false;
+        }
+        // the fluid in place is only copied from the model if a summary
+        // vector needs it
+        FIPData fipData;
+        if( summaryPlan_.needsFIP() ) {
+            fipData = physicalModel.getFIPData();
+        }
+        takeSnapshot( timer, localState, localWellState, std::move( simulatorData ), std::move( fipData ),
+                      miscSummaryData, extraRestartData, substep );
+        return true;
+    }
 }
 #endif
@@ -55,6 +55,7 @@ namespace Opm {
                 Eigen::SparseMatrix<double> w2p;              // well -> perf (scatter)
                 Eigen::SparseMatrix<double> p2w;              // perf -> well (gather)
                 std::vector<int> well_cells;                  // the set of perforated cells
+                GatherPlan well_cells_plan;                   // gathers the perforated cells
             };
 
             // ---------      Types      ---------
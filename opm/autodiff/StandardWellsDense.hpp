@@ -29,8 +29,14 @@
 #include <opm/common/utility/platform_dependent/disable_warnings.h>
 #include <opm/common/utility/platform_dependent/reenable_warnings.h>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <exception>
+#include <memory>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include <opm/parser/eclipse/EclipseState/Schedule/Schedule.hpp>
 
@@ -38,10 +44,17 @@
 #include <opm/core/wells/DynamicListEconLimited.hpp>
 #include <opm/core/wells/WellCollection.hpp>
 #include <opm/core/simulator/SimulatorReport.hpp>
+#include <opm/autodiff/CartesianToCompressed.hpp>
+#include <opm/autodiff/CellDataView.hpp>
+#include <opm/autodiff/DebugLog.hpp>
+#include <opm/autodiff/DistributedWells.hpp>
 #include <opm/autodiff/VFPProperties.hpp>
 #include <opm/autodiff/VFPInjProperties.hpp>
 #include <opm/autodiff/VFPProdProperties.hpp>
 #include <opm/autodiff/WellHelpers.hpp>
+#include <opm/autodiff/WellChangeTracker.hpp>
+#include <opm/autodiff/PerforationBlocks.hpp>
+#include <opm/autodiff/MemoryUsage.hpp>
 #include <opm/autodiff/BlackoilModelEnums.hpp>
 #include <opm/autodiff/WellDensitySegmented.hpp>
 #include <opm/autodiff/BlackoilPropsAdFromDeck.hpp>
@@ -49,6 +62,7 @@
 #include <opm/autodiff/BlackoilModelParameters.hpp>
 #include <opm/autodiff/WellStateFullyImplicitBlackoilDense.hpp>
 #include <opm/autodiff/RateConverter.hpp>
+#include <opm/autodiff/TimerTree.hpp>
 #include<dune/common/fmatrix.hh>
 #include<dune/istl/bcrsmatrix.hh>
 #include<dune/istl/matrixmatrix.hh>
@@ -98,9 +112,13 @@ enum WellVariablePositions {
             typedef Dune::FieldVector<Scalar, numEq    > VectorBlockType;
             typedef Dune::FieldMatrix<Scalar, numEq, numEq > MatrixBlockType;
             typedef Dune::BCRSMatrix <MatrixBlockType> Mat;
+            typedef PerforationBlocks <MatrixBlockType> PerfBlocks;
             typedef Dune::BlockVector<VectorBlockType> BVector;
 
             typedef DenseAd::Evaluation<Scalar, /*size=*/numEq + numWellEq> EvalWell;
+            // a value per component, of which there are at most numEq, kept on
+            // the stack such that the well assembly does not allocate
+            typedef std::array<EvalWell, numEq> EvalWellComponents;
             typedef DenseAd::Evaluation<Scalar, /*size=*/numEq> Eval;
             typedef Ewoms::BlackOilPolymerModule<TypeTag> PolymerModule;
 
@@ -120,12 +138,29 @@ enum WellVariablePositions {
                       const std::vector<bool>& active_arg,
                       const VFPProperties*  vfp_properties_arg,
                       const double gravity_arg,
-                      const std::vector<double>& depth_arg,
-                      const std::vector<double>& pv_arg,
+                      const CellDataView<double>& depth_arg,
+                      const CellDataView<double>& pv_arg,
                       const RateConverterType* rate_converter,
                       long int global_nc,
                       const Grid& grid);
 
+            /// Log the control switches through a deferred logger, which
+            /// sends them to the root process only when it is flushed,
+            /// instead of gathering them in every updateWellControls().
+            /// Pass nullptr to gather them immediately.
+            void setSwitchingLogger(wellhelpers::WellSwitchingLogger* logger)
+            {
+                switching_logger_ = logger;
+            }
+
+            /// The Cartesian to compressed cell lookup of the grid, kept by
+            /// the caller for the whole run. Pass nullptr to create one
+            /// when needed.
+            void setCartesianToCompressed(const CartesianToCompressed* cartesian_to_compressed)
+            {
+                cartesian_to_compressed_ = cartesian_to_compressed;
+            }
+
 
             /// The number of components in the model.
             int numComponents() const
@@ -154,17 +189,89 @@ enum WellVariablePositions {
                                      const double dt,
                                      WellState& well_state);
 
+            /// Assemble the well equations like assemble(), but without their
+            /// contributions to the reservoir equations, which are added by
+            /// addReservoirContributions() once ebos has linearized them. Only
+            /// the intensive quantities of the perforated cells are read.
+            SimulatorReport assembleWells(Simulator& ebosSimulator,
+                                          const int iterationIdx,
+                                          const double dt,
+                                          WellState& well_state);
+
+            /// Subtract the perforation contributions of the last assembly of
+            /// the wells from the linearized reservoir equations of ebos.
+            void addReservoirContributions(Simulator& ebosSimulator,
+                                           bool residual_only = false);
+
+            /// Whether assembleWells() may run concurrently with the
+            /// linearization of the reservoir, i.e. no perforation uses its own
+            /// saturation table and no well is distributed. Wells must be active.
+            bool independentOfReservoirAssembly(const Simulator& ebosSimulator) const;
+
+            /// The perforated cells, each listed once.
+            const std::vector<int>& perforatedCells() const { return perforatedCells_; }
+
+            /// Subtract the perforation contributions of the last assembly of
+            /// the wells from the residual and the diagonal Jacobian block of
+            /// a cell, nothing if the cell is not perforated.
+            void subtractPerforationContributions(const int cell_idx,
+                                                  VectorBlockType& residual,
+                                                  MatrixBlockType& jacobian) const
+            {
+                const int i = perforatedCellIndex_.empty() ? -1 : perforatedCellIndex_[cell_idx];
+                if (i < 0) {
+                    return;
+                }
+                for (int j = perforatedCellPerfStart_[i]; j < perforatedCellPerfStart_[i+1]; ++j) {
+                    const int perf = perforatedCellPerfs_[j];
+                    residual -= perfResidual_[perf];
+                    jacobian -= perfJacobian_[perf];
+                }
+            }
+
+            /// Assemble the residuals of the well equations with the current
+            /// controls and subtract the well contributions from the reservoir
+            /// residual, without the Jacobians, e.g. for finite differences.
+            void assembleResidual(Simulator& ebosSimulator,
+                                  const double dt,
+                                  WellState& well_state);
+
             void assembleWellEq(Simulator& ebosSimulator,
                                 const double dt,
                                 WellState& well_state,
-                                bool only_wells);
+                                bool only_wells,
+                                bool residual_only = false,
+                                bool add_to_reservoir = true);
+
+            // assemble the equations of a single well, and store its contributions
+            // to the reservoir equations in perfResidual_ and perfJacobian_
+            void assembleSingleWellEq(const Simulator& ebosSimulator,
+                                      const int w,
+                                      const double dt,
+                                      WellState& well_state,
+                                      bool only_wells,
+                                      bool residual_only = false);
+
+            // the wells to reassemble in a full assembly, i.e. all wells except
+            // the converged ones whose control, primary variables and perforated
+            // cells changed less than well_skip_converged_tolerance_
+            std::vector<bool> wellsToAssemble(const Simulator& ebosSimulator);
+
+            // flag the assembled wells whose residual is below tolerance_wells_
+            void updateWellConverged(Simulator& ebosSimulator,
+                                     const std::vector<bool>& assembled);
+
+            // subtract the Schur complement of the wells with at most
+            // well_schur_max_perforations_ perforations from the reservoir
+            // matrix, these wells are then skipped when applying the wells
+            void addExplicitWellContributions(Simulator& ebosSimulator);
 
             void
             getMobility(const Simulator& ebosSimulator,
                         const int w,
                         const int perf,
                         const int cell_idx,
-                        std::vector<EvalWell>& mob) const;
+                        EvalWellComponents& mob) const;
 
             bool allow_cross_flow(const int w, const Simulator& ebosSimulator) const;
 
@@ -178,6 +285,25 @@ enum WellVariablePositions {
             // subtract B*inv(D)*C * x from A*x
             void apply(const BVector& x, BVector& Ax) const;
 
+            // as apply(x, Ax), with the wells and the perforated cells
+            // distributed among the threads
+            void applyWellPartitioned(const BVector& x, BVector& Ax) const;
+
+            // as apply(x, Ax), in a single threaded pass over the wells
+            // without the Cx_ and invDrw_ temporaries
+            void applyFused(const BVector& x, BVector& Ax) const;
+
+            // as apply(x, Ax), with C*x of the distributed wells summed over
+            // the processes, collective over the processes
+            void applyDistributed(const BVector& x, BVector& Ax) const;
+
+            // sum the well residuals and the diagonal of D of the distributed
+            // wells over the processes, before D is inverted
+            void sumDistributedWellEquations();
+
+            // find the wells with perforations on several processes
+            void initDistributedWells(const Grid& grid);
+
             // apply well model with scaling of alpha
             void applyScaleAdd(const Scalar alpha, const BVector& x, BVector& Ax) const;
 
@@ -191,7 +317,7 @@ enum WellVariablePositions {
             int flowPhaseToEbosPhaseIdx( const int phaseIdx ) const;
 
             std::vector<double>
-            extractPerfData(const std::vector<double>& in) const;
+            extractPerfData(const CellDataView<double>& in) const;
 
             int numPhases() const;
 
@@ -211,6 +337,13 @@ enum WellVariablePositions {
             /// return true if wells are available on this process
             bool localWellsActive() const;
 
+            /// return true if wells have perforations on several processes,
+            /// apply() and recoverVariable() are then collective
+            bool distributedWellsActive() const
+            {
+                return distributed_wells_.active();
+            }
+
             int numWellVars() const;
 
             /// Density of each well perforation
@@ -223,28 +356,71 @@ enum WellVariablePositions {
 
             void setWellVariables(const WellState& xw);
 
+            void setSingleWellVariables(const int w, const WellState& xw);
+
             void print(const EvalWell& in) const;
 
             void printWellState(std::ostream & s, const WellState & wellState) const;
 
             void computeAccumWells();
 
-            void computeWellFlux(const int& w, const double& Tw, const IntensiveQuantities& intQuants, const std::vector<EvalWell>& mob_perfcells_dense,
-                                 const EvalWell& bhp, const double& cdp, const bool& allow_cf, std::vector<EvalWell>& cq_s)  const;
+            void computeWellFlux(const int& w, const double& Tw, const IntensiveQuantities& intQuants, const EvalWellComponents& mob_perfcells_dense,
+                                 const EvalWell& bhp, const double& cdp, const bool& allow_cf, EvalWellComponents& cq_s)  const;
 
             SimulatorReport solveWellEq(Simulator& ebosSimulator,
                                         const double dt,
                                         WellState& well_state);
 
+            /// Solve the well equations of each well on its own with fixed
+            /// controls, threaded over the wells, until the controls settle.
+            SimulatorReport solveWellEqLocally(Simulator& ebosSimulator,
+                                               const double dt,
+                                               WellState& well_state);
+
             void printIf(const int c, const double x, const double y, const double eps, const std::string type) const;
 
             std::vector<double> residual() const;
             BVector residualWE() const;
 
+            /// The contributions of the perforations to the residuals of their
+            /// cells, in the ebos component order, which are subtracted.
+            const std::vector<VectorBlockType>& perforationResiduals() const { return perfResidual_; }
+
+            /// The mismatch of the surface rates of the producers under history
+            /// control (WCONHIST) with their observed rates, the sum over the
+            /// wells and phases of ((q - q_obs) / max(|q_obs|, min_rate))^2,
+            /// and its gradient with respect to the well variables.
+            double historyRateMismatch(const double min_rate, BVector& gradient) const;
+
+            /// The number of bytes held by the well matrices, the well residual
+            /// and the work vectors of the linear operator.
+            std::size_t memoryUsage() const
+            {
+                return duneB_.memoryUsage() + duneC_.memoryUsage()
+                    + Opm::memoryUsage(invDuneD_) + Opm::memoryUsage(duneD_)
+                    + Opm::memoryUsage(resWell_) + Opm::memoryUsage(perfJacobian_)
+                    + Opm::memoryUsage(perfResidual_) + Opm::memoryUsage(Cx_)
+                    + Opm::memoryUsage(invDrw_) + Opm::memoryUsage(scaleAddRes_)
+                    + Opm::memoryUsage(exportB_) + Opm::memoryUsage(exportC_);
+            }
+
+            /// The well matrices of the linear operator A - B^T inv(D) C,
+            /// e.g. for writing the linear system to a file.
+            const PerfBlocks& matrixB() const { return duneB_; }
+            const PerfBlocks& matrixC() const { return duneC_; }
+            const Mat& invMatrixD() const { return invDuneD_; }
+
+            /// The wells whose Schur complement is in the reservoir matrix.
+            const std::vector<bool>& explicitWells() const { return explicitWell_; }
+
 
             bool getWellConvergence(Simulator& ebosSimulator,
                                     const int iteration) const;
 
+            /// The formation volume factors of the components averaged over
+            /// the global grid, used to scale the well residuals.
+            std::vector<double> averageFormationVolumeFactors(Simulator& ebosSimulator) const;
+
             void computeWellConnectionPressures(const Simulator& ebosSimulator,
                                                 const WellState& xw);
 
@@ -253,11 +429,19 @@ enum WellVariablePositions {
                                                              std::vector<double>& b_perf,
                                                              std::vector<double>& rsmax_perf,
                                                              std::vector<double>& rvmax_perf,
-                                                             std::vector<double>& surf_dens_perf) const;
+                                                             std::vector<double>& surf_dens_perf,
+                                                             const std::vector<bool>* update_well = nullptr) const;
 
             void updateWellState(const BVector& dwells,
                                  WellState& well_state) const;
 
+            void updateSingleWellState(const int w,
+                                       const VectorBlockType& dwell,
+                                       WellState& well_state) const;
+
+            /// Update the THP of the wells with a THP constraint from their BHP.
+            void updateWellThp(WellState& well_state) const;
+
 
 
             void updateWellControls(WellState& xw) const;
@@ -274,7 +458,6 @@ enum WellVariablePositions {
                                                         const std::vector<double>& rsmax_perf,
                                                         const std::vector<double>& rvmax_perf,
                                                         const std::vector<double>& surf_dens_perf,
-                                                        const std::vector<double>& depth_perf,
                                                         const double grav);
 
 
@@ -291,6 +474,13 @@ enum WellVariablePositions {
 
             WellCollection* wellCollection() const;
 
+            /// Whether the well rates meet the group targets. The result of
+            /// the last evaluation is reused as long as the rates and the
+            /// group targets did not change, which saves the walk over the
+            /// group tree when the same rates are checked again, e.g. by the
+            /// well solve and the convergence check of the reservoir model.
+            bool groupTargetConverged(const std::vector<double>& well_rates) const;
+
             const std::vector<double>&
             wellPerfEfficiencyFactors() const;
 
@@ -302,14 +492,11 @@ enum WellVariablePositions {
 
             void applyVREPGroupControl(WellState& well_state) const;
 
+            // B and C as wells x cells matrices, copied on each call
             const Mat& B() const;
 
-            Mat& B();
-
             const Mat& C() const;
 
-            Mat& C();
-
             const Mat& D() const;
 
             Mat& D();
@@ -331,15 +518,27 @@ enum WellVariablePositions {
 
             ModelParameters param_;
             bool terminal_output_;
-            bool has_solvent_;
-            bool has_polymer_;
+            // known at compile time, see BlackoilModelEbos
+            static const bool has_solvent_ = GET_PROP_VALUE(TypeTag, EnableSolvent);
+            static const bool has_polymer_ = GET_PROP_VALUE(TypeTag, EnablePolymer);
             int current_timeIdx_;
 
             PhaseUsage phase_usage_;
             std::vector<bool>  active_;
             const VFPProperties* vfp_properties_;
+            // the table intervals of the last thp evaluation of the producers
+            mutable detail::VFPBrackets vfp_thp_brackets_;
             double gravity_;
             const RateConverterType* rate_converter_;
+            wellhelpers::WellSwitchingLogger* switching_logger_ = nullptr;
+
+            // the Cartesian to compressed cell lookup of the grid, not owned
+            const CartesianToCompressed* cartesian_to_compressed_ = nullptr;
+
+            // the wells with perforations on several processes and the grid
+            // whose communication sums their equations
+            DistributedWells distributed_wells_;
+            const Grid* grid_ = nullptr;
 
             // The efficiency factor for each connection. It is specified based on wells and groups,
             // We calculate the factor for each connection for the computation of contributions to the mass balance equations.
@@ -348,11 +547,38 @@ enum WellVariablePositions {
             // the depth of the all the cell centers
             // for standard Wells, it the same with the perforation depth
             std::vector<double> cell_depths_;
-            std::vector<double> pv_;
+            // the depth difference of each perforation to the one above it,
+            // or to the reference depth for the top perforation of each well
+            std::vector<double> perf_depth_diffs_;
+            int number_of_cells_ = 0;
 
             std::vector<double> well_perforation_densities_;
             std::vector<double> well_perforation_pressure_diffs_;
 
+            // the perforation properties of the last computation of the connection
+            // pressures, which are kept for the wells that have not changed
+            std::vector<double> b_perf_;
+            std::vector<double> rsmax_perf_;
+            std::vector<double> rvmax_perf_;
+            std::vector<double> surf_dens_perf_;
+            WellChangeTracker connection_pressure_tracker_;
+
+            // the well potentials of the last computation
+            mutable std::vector<double> well_potentials_;
+            mutable WellChangeTracker well_potential_tracker_;
+
+            // the wells converged in their last full assembly and the values
+            // they were assembled with, the equations of the converged wells
+            // that have not changed are kept in the next full assembly
+            std::vector<bool> well_converged_;
+            WellChangeTracker assembly_tracker_;
+
+            // the well rates of the last evaluation of the group targets and
+            // its result, invalid after the group targets may have changed
+            mutable std::vector<double> group_target_rates_;
+            mutable bool group_target_converged_ = false;
+            mutable bool group_target_valid_ = false;
+
             std::vector<double> wpolymer_;
             std::vector<double> wsolvent_;
 
@@ -363,8 +589,9 @@ enum WellVariablePositions {
             std::vector<EvalWell> wellVariables_;
             std::vector<double> F0_;
 
-            Mat duneB_;
-            Mat duneC_;
+            // the blocks of B^T and C, one per perforation
+            PerfBlocks duneB_;
+            PerfBlocks duneC_;
             Mat invDuneD_;
             Mat duneD_;
 
@@ -372,9 +599,29 @@ enum WellVariablePositions {
 
             long int global_nc_;
 
+            // the wells whose Schur complement is in the reservoir matrix
+            std::vector<bool> explicitWell_;
+            int numExplicitWells_;
+
+            // the well of each perforation
+            std::vector<int> perfWell_;
+            // perforated cells, offsets into perforatedCellPerfs_ and the
+            // perforations of each perforated cell, in the order of perforatedCells_
+            std::vector<int> perforatedCells_;
+            std::vector<int> perforatedCellPerfStart_;
+            std::vector<int> perforatedCellPerfs_;
+            // the index of each cell in perforatedCells_, -1 if not perforated
+            std::vector<int> perforatedCellIndex_;
+
+            // the contributions of each perforation to the reservoir equations
+            std::vector<VectorBlockType> perfResidual_;
+            std::vector<MatrixBlockType> perfJacobian_;
+
             mutable BVector Cx_;
             mutable BVector invDrw_;
             mutable BVector scaleAddRes_;
+            mutable Mat exportB_;
+            mutable Mat exportC_;
 
             double dbhpMaxRel() const {return param_.dbhp_max_rel_; }
             double dWellFractionMax() const {return param_.dwell_fraction_max_; }
@@ -447,8 +694,6 @@ enum WellVariablePositions {
 
             double wpolymer(const int well_index) const;
 
-            void setupCompressedToCartesian(const int* global_cell, int number_of_cells, std::map<int,int>& cartesian_to_compressed ) const;
-
             void computeRepRadiusPerfLength(const Grid& grid);
 
 
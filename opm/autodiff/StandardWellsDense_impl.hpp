@@ -17,21 +17,18 @@ namespace Opm {
        , well_collection_(well_collection)
        , param_(param)
        , terminal_output_(terminal_output)
-       , has_solvent_(GET_PROP_VALUE(TypeTag, EnableSolvent))
-       , has_polymer_(GET_PROP_VALUE(TypeTag, EnablePolymer))
        , current_timeIdx_(current_timeIdx)
        , well_perforation_efficiency_factors_((wells_!=nullptr ? wells_->well_connpos[wells_->number_of_wells] : 0), 1.0)
        , well_perforation_densities_( wells_ ? wells_arg->well_connpos[wells_arg->number_of_wells] : 0)
        , well_perforation_pressure_diffs_( wells_ ? wells_arg->well_connpos[wells_arg->number_of_wells] : 0)
        , wellVariables_( wells_ ? (wells_arg->number_of_wells * numWellEq) : 0)
        , F0_(wells_ ? (wells_arg->number_of_wells * numWellEq) : 0 )
+       , numExplicitWells_(0)
     {
         if( wells_ )
         {
             invDuneD_.setBuildMode( Mat::row_wise );
             duneD_.setBuildMode( Mat::row_wise );
-            duneC_.setBuildMode( Mat::row_wise );
-            duneB_.setBuildMode( Mat::row_wise );
          }
     }
 
@@ -46,8 +43,8 @@ namespace Opm {
          const std::vector<bool>& active_arg,
          const VFPProperties*  vfp_properties_arg,
          const double gravity_arg,
-         const std::vector<double>& depth_arg,
-         const std::vector<double>& pv_arg,
+         const CellDataView<double>& depth_arg,
+         const CellDataView<double>& pv_arg,
          const RateConverterType* rate_converter,
          long int global_nc,
          const Grid& grid)
@@ -55,6 +52,10 @@ namespace Opm {
         // has to be set always for the convergence check!
         global_nc_   = global_nc;
 
+        // collective, also on the processes without wells
+        initDistributedWells(grid);
+
+        perforatedCellIndex_.clear();
         if ( ! localWellsActive() ) {
             return;
         }
@@ -64,11 +65,18 @@ namespace Opm {
         vfp_properties_ = vfp_properties_arg;
         gravity_ = gravity_arg;
         cell_depths_ = extractPerfData(depth_arg);
-        pv_ = pv_arg;
+        perf_depth_diffs_ = WellDensitySegmented::computePerforationDepthDifferences(wells(), cell_depths_);
+        number_of_cells_ = pv_arg.size();
         rate_converter_ = rate_converter;
 
         calculateEfficiencyFactors();
 
+        // the wells may have changed, recompute everything in the next update
+        connection_pressure_tracker_ = WellChangeTracker(param_.well_update_tolerance_, param_.well_full_update_interval_);
+        well_potential_tracker_ = WellChangeTracker(param_.well_update_tolerance_, param_.well_full_update_interval_);
+        assembly_tracker_ = WellChangeTracker(param_.well_skip_converged_tolerance_, param_.well_full_update_interval_);
+        well_converged_.clear();
+
         // setup sparsity pattern for the matrices
         //[A B^T    [x    =  [ res
         // C D] x_well]      res_well]
@@ -92,12 +100,6 @@ namespace Opm {
         // set duneD
         duneD_.setSize( nw, nw, nw );
 
-        // set duneC
-        duneC_.setSize( nw, nc, nperf );
-
-        // set duneB
-        duneB_.setSize( nw, nc, nperf );
-
         for (auto row=invDuneD_.createbegin(), end = invDuneD_.createend(); row!=end; ++row) {
             // Add nonzeros for diagonal
             row.insert(row.index());
@@ -108,26 +110,57 @@ namespace Opm {
             row.insert(row.index());
         }
 
-        for (auto row = duneC_.createbegin(), end = duneC_.createend(); row!=end; ++row) {
-            // Add nonzeros for diagonal
-            for (int perf = wells().well_connpos[row.index()] ; perf < wells().well_connpos[row.index()+1]; ++perf) {
-                const int cell_idx = wells().well_cells[perf];
-                row.insert(cell_idx);
+        // B^T and C only need the perforations of the wells
+        duneC_.init( nw, wells().well_connpos, wells().well_cells );
+        duneB_.init( nw, wells().well_connpos, wells().well_cells );
+
+        // index of B^T: the perforated cells and their perforations, such
+        // that B^T can be applied concurrently for all cells
+        {
+            perfWell_.resize( nperf );
+            for (int w = 0; w < nw; ++w) {
+                for (int perf = wells().well_connpos[w]; perf < wells().well_connpos[w+1]; ++perf) {
+                    perfWell_[perf] = w;
+                }
             }
-        }
 
-        // make the B^T matrix
-        for (auto row = duneB_.createbegin(), end = duneB_.createend(); row!=end; ++row) {
-            for (int perf = wells().well_connpos[row.index()] ; perf < wells().well_connpos[row.index()+1]; ++perf) {
-                const int cell_idx = wells().well_cells[perf];
-                row.insert(cell_idx);
+            // the perforations of each perforated cell, in increasing order
+            std::vector< std::pair<int, int> > cellPerfs;
+            cellPerfs.reserve( nperf );
+            for (int perf = 0; perf < nperf; ++perf) {
+                cellPerfs.emplace_back( wells().well_cells[perf], perf );
+            }
+            std::sort( cellPerfs.begin(), cellPerfs.end() );
+
+            perforatedCells_.clear();
+            perforatedCellPerfStart_.clear();
+            perforatedCellPerfs_.clear();
+            perforatedCellPerfs_.reserve( nperf );
+            for (std::size_t i = 0; i < cellPerfs.size(); ++i) {
+                if (i == 0 || cellPerfs[i-1].first != cellPerfs[i].first) {
+                    perforatedCells_.push_back( cellPerfs[i].first );
+                    perforatedCellPerfStart_.push_back( perforatedCellPerfs_.size() );
+                }
+                perforatedCellPerfs_.push_back( cellPerfs[i].second );
+            }
+            perforatedCellPerfStart_.push_back( perforatedCellPerfs_.size() );
+
+            perforatedCellIndex_.assign( nc, -1 );
+            for (std::size_t i = 0; i < perforatedCells_.size(); ++i) {
+                perforatedCellIndex_[ perforatedCells_[i] ] = i;
             }
         }
 
+        perfResidual_.resize( nperf );
+        perfJacobian_.resize( nperf );
+
+        explicitWell_.assign( nw, false );
+        numExplicitWells_ = 0;
+
         resWell_.resize( nw );
 
         // resize temporary class variables
-        Cx_.resize( duneC_.N() );
+        Cx_.resize( nw );
         invDrw_.resize( invDuneD_.N() );
 
         if (has_polymer_)
@@ -149,6 +182,25 @@ namespace Opm {
              const double dt,
              WellState& well_state)
     {
+        SimulatorReport report = assembleWells(ebosSimulator, iterationIdx, dt, well_state);
+        if (wellsActive()) {
+            addReservoirContributions(ebosSimulator);
+        }
+        return report;
+    }
+
+
+
+
+
+    template<typename TypeTag>
+    SimulatorReport
+    StandardWellsDense<TypeTag>::
+    assembleWells(Simulator& ebosSimulator,
+                  const int iterationIdx,
+                  const double dt,
+                  WellState& well_state)
+    {
 
         if (iterationIdx == 0) {
             prepareTimeStep(ebosSimulator, well_state);
@@ -159,20 +211,30 @@ namespace Opm {
             return report;
         }
 
-        updateWellControls(well_state);
+        {
+            TimerTree::Region region("well controls");
+            updateWellControls(well_state);
+        }
         // Set the primary variables for the wells
         setWellVariables(well_state);
 
         if (iterationIdx == 0) {
+            TimerTree::Region region("connection pressures");
             computeWellConnectionPressures(ebosSimulator, well_state);
             computeAccumWells();
+            // the time step and the connection pressures changed
+            assembly_tracker_.reset();
         }
 
         if (param_.solve_welleq_initially_ && iterationIdx == 0) {
             // solve the well equations as a pre-processing step
+            TimerTree::Region region("initial well solve");
             report = solveWellEq(ebosSimulator, dt, well_state);
         }
-        assembleWellEq(ebosSimulator, dt, well_state, false);
+        {
+            TimerTree::Region region("well equations");
+            assembleWellEq(ebosSimulator, dt, well_state, false, false, false);
+        }
 
         report.converged = true;
         return report;
@@ -182,59 +244,375 @@ namespace Opm {
 
 
 
+    template<typename TypeTag>
+    void
+    StandardWellsDense<TypeTag>::
+    assembleResidual(Simulator& ebosSimulator,
+                     const double dt,
+                     WellState& well_state)
+    {
+        if ( ! wellsActive() ) {
+            return;
+        }
+
+        setWellVariables(well_state);
+        assembleWellEq(ebosSimulator, dt, well_state, false, true);
+    }
+
+
+
+
+
     template<typename TypeTag>
     void
     StandardWellsDense<TypeTag>::
     assembleWellEq(Simulator& ebosSimulator,
                    const double dt,
                    WellState& well_state,
-                   bool only_wells)
+                   bool only_wells,
+                   bool residual_only,
+                   bool add_to_reservoir)
     {
         const int nw = wells().number_of_wells;
-        const int numComp = numComponents();
-        const int np = numPhases();
 
-        // clear all entries
-        duneB_ = 0.0;
-        duneC_ = 0.0;
-        invDuneD_ = 0.0;
-        resWell_ = 0.0;
+        // A full assembly keeps the equations and reservoir contributions of
+        // the converged wells that have not changed since their last assembly.
+        // The group controls and the distributed wells couple the wells.
+        const bool skipConverged = !only_wells && !residual_only
+            && param_.well_skip_converged_tolerance_ > 0.0
+            && !wellCollection()->groupControlActive()
+            && !distributed_wells_.active();
+        std::vector<bool> assemble(nw, true);
+        if (skipConverged) {
+            assemble = wellsToAssemble(ebosSimulator);
+        }
+        else if (!residual_only) {
+            // the kept equations are overwritten
+            assembly_tracker_.reset();
+        }
 
+        // clear the entries of the wells to assemble, the matrices are kept
+        // for the residual only
+        for (int w = 0; w < nw; ++w) {
+            if (!assemble[w]) {
+                continue;
+            }
+            resWell_[w] = 0.0;
+            if (!residual_only) {
+                invDuneD_[w][w] = 0.0;
+                for (int perf = duneB_.wellBegin(w); perf < duneB_.wellEnd(w); ++perf) {
+                    duneB_[perf] = 0.0;
+                    duneC_[perf] = 0.0;
+                }
+            }
+        }
+
+        // The wells are independent apart from their contributions to the
+        // perforated cells, which are stored per perforation and added to the
+        // reservoir equations afterwards. A perforation with its own saturation
+        // table temporarily changes the material law parameters of its cell,
+        // such wells are assembled serially.
+        std::vector<int> threadedWells;
+        std::vector<int> serialWells;
+        if (param_.parallel_well_assembly_) {
+            const auto& materialLawManager = ebosSimulator.problem().materialLawManager();
+            for (int w = 0; w < nw; ++w) {
+                if (!assemble[w]) {
+                    continue;
+                }
+                bool ownSatnum = false;
+                for (int perf = wells().well_connpos[w] ; perf < wells().well_connpos[w+1]; ++perf) {
+                    const int cell_idx = wells().well_cells[perf];
+                    ownSatnum = ownSatnum || (wells().sat_table_id[perf] - 1 != materialLawManager->satnumRegionIdx(cell_idx));
+                }
+                (ownSatnum ? serialWells : threadedWells).push_back(w);
+            }
+        } else {
+            for (int w = 0; w < nw; ++w) {
+                if (assemble[w]) {
+                    serialWells.push_back(w);
+                }
+            }
+        }
+
+        // exceptions must not leave the parallel region, the first one is rethrown
+        std::exception_ptr exception;
+        const int numThreadedWells = threadedWells.size();
+#pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < numThreadedWells; ++i) {
+            try {
+                assembleSingleWellEq(ebosSimulator, threadedWells[i], dt, well_state, only_wells, residual_only);
+            }
+            catch (...) {
+#pragma omp critical
+                if (!exception) {
+                    exception = std::current_exception();
+                }
+            }
+        }
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+
+        for (const int w : serialWells) {
+            assembleSingleWellEq(ebosSimulator, w, dt, well_state, only_wells, residual_only);
+        }
+
+        if (distributed_wells_.active()) {
+            if (residual_only) {
+                distributed_wells_.sumBlocks(resWell_, numEq, grid_->comm());
+            }
+            else {
+                sumDistributedWellEquations();
+            }
+        }
+
+        if (!residual_only) {
+            // D is block diagonal, copy the well equations, i.e. without the
+            // polymer equation, and invert the blocks of the assembled wells
+            for (int w = 0; w < nw; ++w) {
+                if (!assemble[w]) {
+                    continue;
+                }
+                for (int i = 0; i < numWellEq; ++i) {
+                    for (int j = 0; j < numWellEq; ++j) {
+                        duneD_[w][w][i][j] = invDuneD_[w][w][i][j];
+                    }
+                }
+                invDuneD_[w][w].invert();
+            }
+        }
+
+        if (skipConverged) {
+            updateWellConverged(ebosSimulator, assemble);
+        }
+
+        if (!only_wells && add_to_reservoir) {
+            addReservoirContributions(ebosSimulator, residual_only);
+        }
+    }
+
+
+
+
+
+    template<typename TypeTag>
+    void
+    StandardWellsDense<TypeTag>::
+    addReservoirContributions(Simulator& ebosSimulator,
+                              bool residual_only)
+    {
+        // subtract the perforation contributions in the order of the
+        // perforations, i.e. independent of the number of threads
         auto& ebosJac = ebosSimulator.model().linearizer().matrix();
         auto& ebosResid = ebosSimulator.model().linearizer().residual();
+        const int numPerforatedCells = perforatedCells_.size();
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < numPerforatedCells; ++i) {
+            const int cell_idx = perforatedCells_[i];
+            auto& jacobian = ebosJac[cell_idx][cell_idx];
+            for (int j = perforatedCellPerfStart_[i]; j < perforatedCellPerfStart_[i+1]; ++j) {
+                const int perf = perforatedCellPerfs_[j];
+                ebosResid[cell_idx] -= perfResidual_[perf];
+                if (!residual_only) {
+                    jacobian -= perfJacobian_[perf];
+                }
+            }
+        }
 
-        const double volume = 0.002831684659200; // 0.1 cu ft;
+        if (!residual_only) {
+            addExplicitWellContributions(ebosSimulator);
+        }
+    }
+
+
+
+
+
+    template<typename TypeTag>
+    std::vector<bool>
+    StandardWellsDense<TypeTag>::
+    wellsToAssemble(const Simulator& ebosSimulator)
+    {
+        // the values the equations of a well depend on within a time step
+        const int nw = wells().number_of_wells;
+        const int numComp = numComponents();
+        const auto& solution = ebosSimulator.model().solution(/*timeIdx=*/0);
+        std::vector<double> values;
+        std::vector<int> offsets(1, 0);
         for (int w = 0; w < nw; ++w) {
-            bool allow_cf = allow_cross_flow(w, ebosSimulator);
-            const EvalWell& bhp = getBhp(w);
-            for (int perf = wells().well_connpos[w] ; perf < wells().well_connpos[w+1]; ++perf) {
+            values.push_back(well_controls_get_current(wells().ctrls[w]));
+            for (int eqIdx = 0; eqIdx < numComp; ++eqIdx) {
+                values.push_back(wellVariables_[nw*eqIdx + w].value());
+            }
+            for (int perf = wells().well_connpos[w]; perf < wells().well_connpos[w+1]; ++perf) {
+                const auto& cellPv = solution[wells().well_cells[perf]];
+                values.push_back(static_cast<double>(cellPv.primaryVarsMeaning()));
+                for (int pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                    values.push_back(cellPv[pvIdx]);
+                }
+            }
+            offsets.push_back(values.size());
+        }
+        const std::vector<bool>& changed = assembly_tracker_.update(values, offsets);
 
-                const int cell_idx = wells().well_cells[perf];
-                const auto& intQuants = *(ebosSimulator.model().cachedIntensiveQuantities(cell_idx, /*timeIdx=*/0));
-                std::vector<EvalWell> cq_s(numComp,0.0);
-                std::vector<EvalWell> mob(numComp, 0.0);
-                getMobility(ebosSimulator, w, perf, cell_idx, mob);
-                computeWellFlux(w, wells().WI[perf], intQuants, mob, bhp, wellPerforationPressureDiffs()[perf], allow_cf, cq_s);
+        std::vector<bool> assemble(nw, true);
+        if (static_cast<int>(well_converged_.size()) == nw) {
+            for (int w = 0; w < nw; ++w) {
+                assemble[w] = changed[w] || !well_converged_[w];
+            }
+        }
+        return assemble;
+    }
 
-                for (int componentIdx = 0; componentIdx < numComp; ++componentIdx) {
 
-                    // the cq_s entering mass balance equations need to consider the efficiency factors.
-                    const EvalWell cq_s_effective = cq_s[componentIdx] * well_perforation_efficiency_factors_[perf];
 
-                    if (!only_wells) {
-                        // subtract sum of component fluxes in the reservoir equation.
-                        // need to consider the efficiency factor
-                        ebosResid[cell_idx][flowPhaseToEbosCompIdx(componentIdx)] -= cq_s_effective.value();
-                    }
 
-                    // subtract sum of phase fluxes in the well equations.
-                    resWell_[w][componentIdx] -= cq_s[componentIdx].value();
 
-                    // assemble the jacobians
+    template<typename TypeTag>
+    void
+    StandardWellsDense<TypeTag>::
+    updateWellConverged(Simulator& ebosSimulator,
+                        const std::vector<bool>& assembled)
+    {
+        const int nw = wells().number_of_wells;
+        const int numComp = numComponents();
+        const double tol_wells = param_.tolerance_wells_;
+        const std::vector<double> B_avg = averageFormationVolumeFactors(ebosSimulator);
+
+        well_converged_.resize(nw, false);
+        for (int w = 0; w < nw; ++w) {
+            if (!assembled[w]) {
+                continue;
+            }
+            bool converged = true;
+            for (int compIdx = 0; compIdx < numComp; ++compIdx) {
+                converged = converged && B_avg[compIdx] * std::abs(resWell_[w][compIdx]) < tol_wells;
+            }
+            well_converged_[w] = converged;
+        }
+    }
+
+
+
+
+
+    template<typename TypeTag>
+    bool
+    StandardWellsDense<TypeTag>::
+    independentOfReservoirAssembly(const Simulator& ebosSimulator) const
+    {
+        // the perforations with their own saturation table temporarily
+        // change the material law parameters of their cells, and the
+        // distributed wells communicate during their assembly
+        if (distributed_wells_.active()) {
+            return false;
+        }
+        const auto& materialLawManager = ebosSimulator.problem().materialLawManager();
+        const int nperf = wells().well_connpos[wells().number_of_wells];
+        for (int perf = 0; perf < nperf; ++perf) {
+            const int cell_idx = wells().well_cells[perf];
+            if (wells().sat_table_id[perf] - 1 != materialLawManager->satnumRegionIdx(cell_idx)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+    template<typename TypeTag>
+    void
+    StandardWellsDense<TypeTag>::
+    addExplicitWellContributions(Simulator& ebosSimulator)
+    {
+        const int nw = wells().number_of_wells;
+        explicitWell_.assign( nw, false );
+        numExplicitWells_ = 0;
+
+        const int maxPerforations = param_.well_schur_max_perforations_;
+        if (maxPerforations <= 0) {
+            return;
+        }
+
+        // only wells whose couplings are all in the pattern of the reservoir
+        // matrix, e.g. single perforations and perforations of neighbouring cells
+        auto& ebosJac = ebosSimulator.model().linearizer().matrix();
+        for (int w = 0; w < nw; ++w) {
+            const int numPerforations = duneB_.wellEnd( w ) - duneB_.wellBegin( w );
+            if (numPerforations > maxPerforations || distributed_wells_.isDistributed( w )
+                || !detail::hasWellCouplings( duneB_, w, ebosJac )) {
+                continue;
+            }
+            detail::subtractWellSchurComplement( duneB_, invDuneD_[ w ][ w ], duneC_, w, ebosJac );
+            explicitWell_[ w ] = true;
+            ++numExplicitWells_;
+        }
+    }
+
+
+    template<typename TypeTag>
+    void
+    StandardWellsDense<TypeTag>::
+    assembleSingleWellEq(const Simulator& ebosSimulator,
+                         const int w,
+                         const double dt,
+                         WellState& well_state,
+                         bool only_wells,
+                         bool residual_only)
+    {
+        const int nw = wells().number_of_wells;
+        const int numComp = numComponents();
+        const int np = numPhases();
+
+        const double volume = 0.002831684659200; // 0.1 cu ft;
+        bool allow_cf = allow_cross_flow(w, ebosSimulator);
+        const EvalWell& bhp = getBhp(w);
+
+        // the worst-offending connection of a water cut limit is tracked
+        // with the perforation rates, see checkMaxWaterCutLimit()
+        const bool track_water_cut = active_[Oil] && active_[Water];
+        int worst_water_cut_connection = -1;
+        double worst_water_cut = 0.;
+
+        for (int perf = wells().well_connpos[w] ; perf < wells().well_connpos[w+1]; ++perf) {
+
+            const int cell_idx = wells().well_cells[perf];
+            const auto& intQuants = *(ebosSimulator.model().cachedIntensiveQuantities(cell_idx, /*timeIdx=*/0));
+
+            // the contributions to the reservoir equations of the perforated cell,
+            // which are subtracted after all wells have been assembled
+            VectorBlockType& perfResidual = perfResidual_[perf];
+            MatrixBlockType& perfJacobian = perfJacobian_[perf];
+            perfResidual = 0.0;
+            perfJacobian = 0.0;
+
+            EvalWellComponents cq_s;
+            cq_s.fill(0.0);
+            EvalWellComponents mob;
+            mob.fill(0.0);
+            getMobility(ebosSimulator, w, perf, cell_idx, mob);
+            computeWellFlux(w, wells().WI[perf], intQuants, mob, bhp, wellPerforationPressureDiffs()[perf], allow_cf, cq_s);
+
+            for (int componentIdx = 0; componentIdx < numComp; ++componentIdx) {
+
+                // the cq_s entering mass balance equations need to consider the efficiency factors.
+                const EvalWell cq_s_effective = cq_s[componentIdx] * well_perforation_efficiency_factors_[perf];
+
+                if (!only_wells) {
+                    // subtract sum of component fluxes in the reservoir equation.
+                    // need to consider the efficiency factor
+                    perfResidual[flowPhaseToEbosCompIdx(componentIdx)] += cq_s_effective.value();
+                }
+
+                // subtract sum of phase fluxes in the well equations.
+                resWell_[w][componentIdx] -= cq_s[componentIdx].value();
+
+                // assemble the jacobians
+                if (!residual_only) {
                     for (int pvIdx = 0; pvIdx < numWellEq; ++pvIdx) {
                         if (!only_wells) {
                             // also need to consider the efficiency factor when manipulating the jacobians.
-                            duneB_[w][cell_idx][pvIdx][flowPhaseToEbosCompIdx(componentIdx)] -= cq_s_effective.derivative(pvIdx+numEq); // intput in transformed matrix
+                            duneB_[perf][pvIdx][flowPhaseToEbosCompIdx(componentIdx)] -= cq_s_effective.derivative(pvIdx+numEq); // intput in transformed matrix
                         }
                         invDuneD_[w][w][componentIdx][pvIdx] -= cq_s[componentIdx].derivative(pvIdx+numEq);
                     }
@@ -242,94 +620,178 @@ namespace Opm {
                     for (int pvIdx = 0; pvIdx < numEq; ++pvIdx) {
                         if (!only_wells) {
                             // also need to consider the efficiency factor when manipulating the jacobians.
-                            ebosJac[cell_idx][cell_idx][flowPhaseToEbosCompIdx(componentIdx)][flowToEbosPvIdx(pvIdx)] -= cq_s_effective.derivative(pvIdx);
-                            duneC_[w][cell_idx][componentIdx][flowToEbosPvIdx(pvIdx)] -= cq_s_effective.derivative(pvIdx);
+                            perfJacobian[flowPhaseToEbosCompIdx(componentIdx)][flowToEbosPvIdx(pvIdx)] += cq_s_effective.derivative(pvIdx);
+                            duneC_[perf][componentIdx][flowToEbosPvIdx(pvIdx)] -= cq_s_effective.derivative(pvIdx);
                         }
                     }
 
-                    // add trivial equation for 2p cases (Only support water + oil)
-                    if (numComp < numEq ) {
+                    // add trivial equation for 2p cases (Only support water + oil),
+                    // once for the distributed wells as their equations are summed
+                    if (numComp < numEq && distributed_wells_.isOwner(w)) {
                         assert(!active_[ Gas ]);
                         invDuneD_[w][w][Gas][Gas] = 1.0;
                     }
+                }
 
-                    // Store the perforation phase flux for later usage.
-                    if (has_solvent_ && componentIdx == solventSaturationIdx) {// if (flowPhaseToEbosCompIdx(componentIdx) == Solvent)
-                        well_state.perfRateSolvent()[perf] = cq_s[componentIdx].value();
-                    } else {
-                        well_state.perfPhaseRates()[perf*np + componentIdx] = cq_s[componentIdx].value();
-                    }
+                // Store the perforation phase flux for later usage.
+                if (has_solvent_ && componentIdx == solventSaturationIdx) {// if (flowPhaseToEbosCompIdx(componentIdx) == Solvent)
+                    well_state.perfRateSolvent()[perf] = cq_s[componentIdx].value();
+                } else {
+                    well_state.perfPhaseRates()[perf*np + componentIdx] = cq_s[componentIdx].value();
                 }
+            }
 
-                if (has_polymer_) {
-                    EvalWell cq_s_poly = cq_s[Water];
-                    if (wells().type[w] == INJECTOR) {
-                        cq_s_poly *= wpolymer(w);
-                    } else {
-                        cq_s_poly *= extendEval(intQuants.polymerConcentration() * intQuants.polymerViscosityCorrection());
-                    }
-                    if (!only_wells) {
+            if (has_polymer_) {
+                EvalWell cq_s_poly = cq_s[Water];
+                if (wells().type[w] == INJECTOR) {
+                    cq_s_poly *= wpolymer(w);
+                } else {
+                    cq_s_poly *= extendEval(intQuants.polymerConcentration() * intQuants.polymerViscosityCorrection());
+                }
+                if (!only_wells) {
+                    if (!residual_only) {
                         for (int pvIdx = 0; pvIdx < numEq; ++pvIdx) {
-                            ebosJac[cell_idx][cell_idx][contiPolymerEqIdx][flowToEbosPvIdx(pvIdx)] -= cq_s_poly.derivative(pvIdx);
+                            perfJacobian[contiPolymerEqIdx][flowToEbosPvIdx(pvIdx)] += cq_s_poly.derivative(pvIdx);
                         }
-                        ebosResid[cell_idx][contiPolymerEqIdx] -= cq_s_poly.value();
                     }
+                    perfResidual[contiPolymerEqIdx] += cq_s_poly.value();
                 }
+            }
 
-                // Store the perforation pressure for later usage.
-                well_state.perfPress()[perf] = well_state.bhp()[w] + wellPerforationPressureDiffs()[perf];
+            if (track_water_cut) {
+                const double oil_perf_rate = cq_s[phase_usage_.phase_pos[ Oil ]].value();
+                const double water_perf_rate = cq_s[phase_usage_.phase_pos[ Water ]].value();
+                const double liquid_perf_rate = oil_perf_rate + water_perf_rate;
+                const double water_cut_perf = (std::abs(liquid_perf_rate) != 0.) ? water_perf_rate / liquid_perf_rate : 0.;
+                if (water_cut_perf > worst_water_cut) {
+                    worst_water_cut_connection = perf - wells().well_connpos[w];
+                    worst_water_cut = water_cut_perf;
+                }
             }
 
-            // add vol * dF/dt + Q to the well equations;
-            for (int componentIdx = 0; componentIdx < numComp; ++componentIdx) {
-                EvalWell resWell_loc = (wellSurfaceVolumeFraction(w, componentIdx) - F0_[w + nw*componentIdx]) * volume / dt;
-                resWell_loc += getQs(w, componentIdx);
+            // Store the perforation pressure for later usage.
+            well_state.perfPress()[perf] = well_state.bhp()[w] + wellPerforationPressureDiffs()[perf];
+        }
+
+        if (track_water_cut) {
+            well_state.worstWaterCutConnection()[w] = worst_water_cut_connection;
+            well_state.worstWaterCut()[w] = worst_water_cut;
+        }
+
+        // the terms without perforations are added by a single process
+        // of a distributed well
+        if (!distributed_wells_.isOwner(w)) {
+            return;
+        }
+
+        // add vol * dF/dt + Q to the well equations;
+        for (int componentIdx = 0; componentIdx < numComp; ++componentIdx) {
+            EvalWell resWell_loc = (wellSurfaceVolumeFraction(w, componentIdx) - F0_[w + nw*componentIdx]) * volume / dt;
+            resWell_loc += getQs(w, componentIdx);
+            if (!residual_only) {
                 for (int pvIdx = 0; pvIdx < numWellEq; ++pvIdx) {
                     invDuneD_[w][w][componentIdx][pvIdx] += resWell_loc.derivative(pvIdx+numEq);
                 }
-                resWell_[w][componentIdx] += resWell_loc.value();
             }
+            resWell_[w][componentIdx] += resWell_loc.value();
+        }
 
-            // add trivial equation for polymer
-            if (has_polymer_) {
-                invDuneD_[w][w][contiPolymerEqIdx][polymerConcentrationIdx] = 1.0; //
-            }
+        // add trivial equation for polymer
+        if (has_polymer_ && !residual_only) {
+            invDuneD_[w][w][contiPolymerEqIdx][polymerConcentrationIdx] = 1.0; //
         }
+    }
+
 
 
-        //const auto& invDune = invD();
-        //duneD = invDune;
 
 
-        for(std::size_t row_block=0; row_block < duneD_.N(); ++row_block ){
-            for(std::size_t col_block=0; col_block < duneD_.M(); ++col_block ){
-                if (invDuneD_.exists(row_block, col_block)){
-                    duneD_[row_block][col_block][0][0] = invDuneD_[row_block][col_block][0][0];
-                    duneD_[row_block][col_block][0][1] = invDuneD_[row_block][col_block][0][1];
-                    duneD_[row_block][col_block][0][2] = invDuneD_[row_block][col_block][0][2];
-                    duneD_[row_block][col_block][1][0] = invDuneD_[row_block][col_block][1][0];
-                    duneD_[row_block][col_block][1][1] = invDuneD_[row_block][col_block][1][1];
-                    duneD_[row_block][col_block][1][2] = invDuneD_[row_block][col_block][1][2];
-                    duneD_[row_block][col_block][2][0] = invDuneD_[row_block][col_block][2][0];
-                    duneD_[row_block][col_block][2][1] = invDuneD_[row_block][col_block][2][1];
-                    duneD_[row_block][col_block][2][2] = invDuneD_[row_block][col_block][2][2];
+    template<typename TypeTag>
+    void
+    StandardWellsDense<TypeTag>::
+    sumDistributedWellEquations()
+    {
+        // the well residual followed by the diagonal block of D, all wells in
+        // a single reduction
+        const int blockSize = numEq + numEq * numEq;
+        std::vector<double> values(distributed_wells_.size() * blockSize, 0.0);
+        for (int i = 0; i < distributed_wells_.size(); ++i) {
+            const int w = distributed_wells_.localWell(i);
+            if (w < 0) {
+                continue;
+            }
+            double* value = &values[i * blockSize];
+            for (int row = 0; row < numEq; ++row) {
+                *value++ = resWell_[w][row];
+            }
+            for (int row = 0; row < numEq; ++row) {
+                for (int col = 0; col < numEq; ++col) {
+                    *value++ = invDuneD_[w][w][row][col];
                 }
             }
         }
 
-        // do the local inversion of D.
-        localInvert( invDuneD_ );
+        grid_->comm().sum(values.data(), values.size());
+
+        for (int i = 0; i < distributed_wells_.size(); ++i) {
+            const int w = distributed_wells_.localWell(i);
+            if (w < 0) {
+                continue;
+            }
+            const double* value = &values[i * blockSize];
+            for (int row = 0; row < numEq; ++row) {
+                resWell_[w][row] = *value++;
+            }
+            for (int row = 0; row < numEq; ++row) {
+                for (int col = 0; col < numEq; ++col) {
+                    invDuneD_[w][w][row][col] = *value++;
+                }
+            }
+        }
     }
 
 
+
+
+
+    template<typename TypeTag>
+    void
+    StandardWellsDense<TypeTag>::
+    initDistributedWells(const Grid& grid)
+    {
+        grid_ = &grid;
+        distributed_wells_ = DistributedWells();
+        if (!param_.distributed_wells_ || grid.comm().size() < 2) {
+            return;
+        }
+
+        // the local index of each well of the schedule, which lists the
+        // wells in the same order on all processes
+        const int nw = wells_ ? wells_->number_of_wells : 0;
+        std::vector<int> localIndex(wells_ecl_.size(), -1);
+        for (std::size_t i = 0; i < wells_ecl_.size(); ++i) {
+            for (int w = 0; w < nw; ++w) {
+                if (wells_ecl_[i]->name() == wells_->name[w]) {
+                    localIndex[i] = w;
+                    break;
+                }
+            }
+        }
+        distributed_wells_.init(localIndex, nw, grid.comm());
+    }
+
+
+
+
+
     template<typename TypeTag>
     void
     StandardWellsDense<TypeTag >::
-    getMobility(const Simulator& ebosSimulator, const int w, const int perf, const int cell_idx, std::vector<EvalWell>& mob) const
+    getMobility(const Simulator& ebosSimulator, const int w, const int perf, const int cell_idx, EvalWellComponents& mob) const
     {
 
         const int np = wells().number_of_phases;
-        assert (int(mob.size()) == numComponents());
+        assert (numComponents() <= int(mob.size()));
         const auto& intQuants = *(ebosSimulator.model().cachedIntensiveQuantities(cell_idx, /*timeIdx=*/0));
         const auto& materialLawManager = ebosSimulator.problem().materialLawManager();
 
@@ -382,7 +844,8 @@ namespace Opm {
                 const int numComp = numComponents();
                 bool allow_cf = allow_cross_flow(w, ebosSimulator);
                 const EvalWell& bhp = getBhp(w);
-                std::vector<EvalWell> cq_s(numComp,0.0);
+                EvalWellComponents cq_s;
+                cq_s.fill(0.0);
                 computeWellFlux(w, wells().WI[perf], intQuants, mob, bhp, wellPerforationPressureDiffs()[perf], allow_cf, cq_s);
                 double area = 2 * M_PI * wells_rep_radius_[perf] * wells_perf_length_[perf];
                 const auto& materialLawManager = ebosSimulator.problem().materialLawManager();
@@ -477,7 +940,7 @@ namespace Opm {
     {
         for (auto row = istlA.begin(), rowend = istlA.end(); row != rowend; ++row ) {
             for (auto col = row->begin(), colend = row->end(); col != colend; ++col ) {
-                std::cout << row.index() << " " << col.index() << "/n \n"<<(*col) << std::endl;
+                OPM_DEBUG_LOG(Wells, row.index() << " " << col.index() << "\n" << (*col));
             }
         }
     }
@@ -510,17 +973,41 @@ namespace Opm {
     StandardWellsDense<TypeTag>::
     apply(const BVector& x, BVector& Ax) const
     {
+        if ( distributed_wells_.active() ) {
+            applyDistributed( x, Ax );
+            return;
+        }
+
         if ( ! localWellsActive() ) {
             return;
         }
 
-        assert( Cx_.size() == duneC_.N() );
+        switch ( param_.well_apply_strategy_ ) {
+        case 1:
+            applyWellPartitioned( x, Ax );
+            return;
+        case 2:
+            applyFused( x, Ax );
+            return;
+        default:
+            break;
+        }
+
+        assert( Cx_.size() == invDuneD_.N() );
 
         BVector& invDCx = invDrw_;
         assert( invDCx.size() == invDuneD_.N());
 
         duneC_.mv(x, Cx_);
         invDuneD_.mv(Cx_, invDCx);
+        if (numExplicitWells_ > 0) {
+            // already in the reservoir matrix
+            for (std::size_t w = 0; w < invDCx.size(); ++w) {
+                if (explicitWell_[ w ]) {
+                    invDCx[ w ] = 0.0;
+                }
+            }
+        }
         duneB_.mmtv(invDCx,Ax);
     }
 
@@ -531,12 +1018,121 @@ namespace Opm {
     template<typename TypeTag>
     void
     StandardWellsDense<TypeTag>::
-    applyScaleAdd(const Scalar alpha, const BVector& x, BVector& Ax) const
+    applyWellPartitioned(const BVector& x, BVector& Ax) const
+    {
+        BVector& invDCx = invDrw_;
+        assert( invDCx.size() == invDuneD_.N());
+
+        // invDCx = inv(D) * C * x, each well is independent
+        const int nw = invDuneD_.N();
+#pragma omp parallel for schedule(dynamic)
+        for (int w = 0; w < nw; ++w) {
+            invDCx[ w ] = 0.0;
+            if (explicitWell_[ w ]) {
+                continue;
+            }
+            VectorBlockType cx( 0.0 );
+            for (int perf = duneC_.wellBegin( w ); perf < duneC_.wellEnd( w ); ++perf) {
+                duneC_[ perf ].umv( x[ duneC_.cell( perf ) ], cx );
+            }
+            invDuneD_[ w ][ w ].umv( cx, invDCx[ w ] );
+        }
+
+        // Ax -= B^T * invDCx, gathered per perforated cell
+        const int ncells = perforatedCells_.size();
+#pragma omp parallel for schedule(static)
+        for (int k = 0; k < ncells; ++k) {
+            const int cell = perforatedCells_[ k ];
+            for (int j = perforatedCellPerfStart_[ k ]; j < perforatedCellPerfStart_[ k + 1 ]; ++j) {
+                const int perf = perforatedCellPerfs_[ j ];
+                duneB_[ perf ].mmtv( invDCx[ perfWell_[ perf ] ], Ax[ cell ] );
+            }
+        }
+    }
+
+
+
+
+
+    template<typename TypeTag>
+    void
+    StandardWellsDense<TypeTag>::
+    applyFused(const BVector& x, BVector& Ax) const
+    {
+        // a single pass over the wells computing B^T * inv(D) * C * x
+        // for each well with local temporaries only
+        const int nw = invDuneD_.N();
+#pragma omp parallel for schedule(dynamic)
+        for (int w = 0; w < nw; ++w) {
+            if (explicitWell_[ w ]) {
+                continue;
+            }
+            VectorBlockType cx( 0.0 );
+            for (int perf = duneC_.wellBegin( w ); perf < duneC_.wellEnd( w ); ++perf) {
+                duneC_[ perf ].umv( x[ duneC_.cell( perf ) ], cx );
+            }
+
+            VectorBlockType invDCx( 0.0 );
+            invDuneD_[ w ][ w ].umv( cx, invDCx );
+
+            for (int perf = duneB_.wellBegin( w ); perf < duneB_.wellEnd( w ); ++perf) {
+                VectorBlockType bx( 0.0 );
+                duneB_[ perf ].umtv( invDCx, bx );
+
+                // several wells may perforate the same cell
+                VectorBlockType& y = Ax[ duneB_.cell( perf ) ];
+                for (int i = 0; i < numEq; ++i) {
+#pragma omp atomic
+                    y[ i ] -= bx[ i ];
+                }
+            }
+        }
+    }
+
+
+
+
+
+    template<typename TypeTag>
+    void
+    StandardWellsDense<TypeTag>::
+    applyDistributed(const BVector& x, BVector& Ax) const
     {
+        // all processes take part in the sum of C*x of the distributed wells
+        if ( localWellsActive() ) {
+            duneC_.mv(x, Cx_);
+        }
+        distributed_wells_.sumBlocks(Cx_, numEq, grid_->comm());
+
         if ( ! localWellsActive() ) {
             return;
         }
 
+        BVector& invDCx = invDrw_;
+        invDuneD_.mv(Cx_, invDCx);
+        if (numExplicitWells_ > 0) {
+            for (std::size_t w = 0; w < invDCx.size(); ++w) {
+                if (explicitWell_[ w ]) {
+                    invDCx[ w ] = 0.0;
+                }
+            }
+        }
+        duneB_.mmtv(invDCx, Ax);
+    }
+
+
+
+
+
+    template<typename TypeTag>
+    void
+    StandardWellsDense<TypeTag>::
+    applyScaleAdd(const Scalar alpha, const BVector& x, BVector& Ax) const
+    {
+        if ( ! localWellsActive() && ! distributed_wells_.active() ) {
+            return;
+        }
+
         if( scaleAddRes_.size() != Ax.size() ) {
             scaleAddRes_.resize( Ax.size() );
         }
@@ -555,11 +1151,22 @@ namespace Opm {
     StandardWellsDense<TypeTag>::
     recoverVariable(const BVector& x, BVector& xw) const
     {
+        if ( distributed_wells_.active() ) {
+            // all processes take part in the sum of C*x of the distributed wells
+            if ( localWellsActive() ) {
+                duneC_.mv(x, Cx_);
+            }
+            distributed_wells_.sumBlocks(Cx_, numEq, grid_->comm());
+        }
         if ( ! localWellsActive() ) {
              return;
         }
         BVector resWell = resWell_;
-        duneC_.mmv(x, resWell);
+        if ( distributed_wells_.active() ) {
+            resWell -= Cx_;
+        } else {
+            duneC_.mmv(x, resWell);
+        }
         invDuneD_.mv(resWell, xw);
     }
 
@@ -611,7 +1218,7 @@ namespace Opm {
     template<typename TypeTag>
     std::vector<double>
     StandardWellsDense<TypeTag>::
-    extractPerfData(const std::vector<double>& in) const
+    extractPerfData(const CellDataView<double>& in) const
     {
         const int nw   = wells().number_of_wells;
         const int nperf = wells().well_connpos[nw];
@@ -646,7 +1253,7 @@ namespace Opm {
     StandardWellsDense<TypeTag>::
     numCells() const
     {
-        return pv_.size();
+        return number_of_cells_;
     }
 
 
@@ -798,21 +1405,34 @@ namespace Opm {
     void
     StandardWellsDense<TypeTag>::
     setWellVariables(const WellState& xw)
+    {
+        const int nw = wells().number_of_wells;
+        for (int w = 0; w < nw; ++w) {
+            setSingleWellVariables(w, xw);
+        }
+    }
+
+
+
+
+
+    template<typename TypeTag>
+    void
+    StandardWellsDense<TypeTag>::
+    setSingleWellVariables(const int w, const WellState& xw)
     {
         const int nw = wells().number_of_wells;
         // for two-phase numComp < numWellEq
         const int numComp = numComponents();
         for (int eqIdx = 0; eqIdx < numComp;  ++eqIdx) {
-            for (int w = 0; w < nw; ++w) {
-                const unsigned int idx = nw * eqIdx + w;
-                assert( idx < wellVariables_.size() );
-                assert( idx < xw.wellSolutions().size() );
-                EvalWell& eval = wellVariables_[ idx ];
-
-                eval = 0.0;
-                eval.setValue( xw.wellSolutions()[ idx ] );
-                eval.setDerivative(numEq + eqIdx, 1.0);
-            }
+            const unsigned int idx = nw * eqIdx + w;
+            assert( idx < wellVariables_.size() );
+            assert( idx < xw.wellSolutions().size() );
+            EvalWell& eval = wellVariables_[ idx ];
+
+            eval = 0.0;
+            eval.setValue( xw.wellSolutions()[ idx ] );
+            eval.setDerivative(numEq + eqIdx, 1.0);
         }
     }
 
@@ -825,9 +1445,9 @@ namespace Opm {
     StandardWellsDense<TypeTag>::
     print(const EvalWell& in) const
     {
-        std::cout << in.value() << std::endl;
+        OPM_DEBUG_LOG(Wells, in.value());
         for (int i = 0; i < in.size; ++i) {
-            std::cout << in.derivative(i) << std::endl;
+            OPM_DEBUG_LOG(Wells, in.derivative(i));
         }
     }
 
@@ -857,14 +1477,15 @@ namespace Opm {
     StandardWellsDense<TypeTag>::
     computeWellFlux(const int& w, const double& Tw,
                     const IntensiveQuantities& intQuants,
-                    const std::vector<EvalWell>& mob_perfcells_dense,
+                    const EvalWellComponents& mob_perfcells_dense,
                     const EvalWell& bhp, const double& cdp,
-                    const bool& allow_cf, std::vector<EvalWell>& cq_s)  const
+                    const bool& allow_cf, EvalWellComponents& cq_s)  const
     {
         const Opm::PhaseUsage& pu = phase_usage_;
         const int np = wells().number_of_phases;
         const int numComp = numComponents();
-        std::vector<EvalWell> cmix_s(numComp,0.0);
+        EvalWellComponents cmix_s;
+        cmix_s.fill(0.0);
         for (int componentIdx = 0; componentIdx < numComp; ++componentIdx) {
             cmix_s[componentIdx] = wellSurfaceVolumeFraction(w, componentIdx);
         }
@@ -873,7 +1494,8 @@ namespace Opm {
         EvalWell pressure = extendEval(fs.pressure(FluidSystem::oilPhaseIdx));
         EvalWell rs = extendEval(fs.Rs());
         EvalWell rv = extendEval(fs.Rv());
-        std::vector<EvalWell> b_perfcells_dense(numComp, 0.0);
+        EvalWellComponents b_perfcells_dense;
+        b_perfcells_dense.fill(0.0);
         for (int phase = 0; phase < np; ++phase) {
             int ebosPhaseIdx = flowPhaseToEbosPhaseIdx(phase);
             b_perfcells_dense[phase] = extendEval(fs.invB(ebosPhaseIdx));
@@ -985,6 +1607,13 @@ namespace Opm {
                 const double dt,
                 WellState& well_state)
     {
+        // the wells are only coupled through the group controls and through
+        // the processes of a distributed well
+        if (param_.local_well_solve_ && !wellCollection()->groupControlActive()
+            && !distributed_wells_.active()) {
+            return solveWellEqLocally(ebosSimulator, dt, well_state);
+        }
+
         const int nw = wells().number_of_wells;
         WellState well_state0 = well_state;
 
@@ -996,8 +1625,9 @@ namespace Opm {
 
             // checking whether the group targets are converged
             if (wellCollection()->groupControlActive()) {
-                converged = converged && wellCollection()->groupTargetConverged(well_state.wellRates());
+                converged = converged && groupTargetConverged(well_state.wellRates());
             }
+            OPM_DEBUG_LOG(Wells, "Well solve iteration " << it << (converged ? ": converged" : ""));
 
             if (converged) {
                 break;
@@ -1022,6 +1652,7 @@ namespace Opm {
         } while (it < 15);
 
         if (!converged) {
+            OPM_DEBUG_LOG(Wells, "Well solve did not converge in " << it << " iterations, the well state is reset");
             well_state = well_state0;
             // also recover the old well controls
             for (int w = 0; w < nw; ++w) {
@@ -1040,13 +1671,159 @@ namespace Opm {
 
 
 
+    template<typename TypeTag>
+    SimulatorReport
+    StandardWellsDense<TypeTag>::
+    solveWellEqLocally(Simulator& ebosSimulator,
+                       const double dt,
+                       WellState& well_state)
+    {
+        const int nw = wellsActive() ? wells().number_of_wells : 0;
+        const int numComp = numComponents();
+        const int maxIter = 15;
+        const double tol_wells = param_.tolerance_wells_;
+        const double maxResidualAllowed = param_.max_residual_allowed_;
+        WellState well_state0 = well_state;
+
+        // the well equations are assembled in place of the inverted ones
+        assembly_tracker_.reset();
+
+        const std::vector<double> B_avg = averageFormationVolumeFactors(ebosSimulator);
+
+        // as in the assembly, wells with perforations using their own saturation
+        // table change the material law parameters of the cells and are solved serially
+        std::vector<int> threadedWells;
+        std::vector<int> serialWells;
+        const auto& materialLawManager = ebosSimulator.problem().materialLawManager();
+        for (int w = 0; w < nw; ++w) {
+            bool ownSatnum = false;
+            for (int perf = wells().well_connpos[w] ; perf < wells().well_connpos[w+1]; ++perf) {
+                const int cell_idx = wells().well_cells[perf];
+                ownSatnum = ownSatnum || (wells().sat_table_id[perf] - 1 != materialLawManager->satnumRegionIdx(cell_idx));
+            }
+            (ownSatnum ? serialWells : threadedWells).push_back(w);
+        }
+
+        std::vector<int> iterations(nw, 0);
+        std::vector<char> wellConverged(nw, 0);
+        // the reservoir is fixed, a converged well whose control did not
+        // change stays converged and is not solved again
+        std::vector<char> solveWell(nw, 1);
+
+        // Newton iterations of the single well w with its current control
+        auto solveSingleWell = [&](const int w) {
+            int it = 0;
+            bool converged = false;
+            while (true) {
+                resWell_[w] = 0.0;
+                invDuneD_[w][w] = 0.0;
+                assembleSingleWellEq(ebosSimulator, w, dt, well_state, true);
+
+                converged = true;
+                for (int compIdx = 0; compIdx < numComp; ++compIdx) {
+                    const double res = B_avg[compIdx] * std::abs(resWell_[w][compIdx]);
+                    if (std::isnan(res)) {
+                        OPM_THROW(Opm::NumericalProblem, "NaN residual for well " << wells().name[w]);
+                    }
+                    if (res > maxResidualAllowed) {
+                        OPM_THROW(Opm::NumericalProblem, "Too large residual for well " << wells().name[w]);
+                    }
+                    converged = converged && res < tol_wells;
+                }
+                if (converged || it >= maxIter) {
+                    break;
+                }
+
+                ++it;
+                MatrixBlockType invD = invDuneD_[w][w];
+                invD.invert();
+                VectorBlockType dx_well(0.0);
+                invD.mv(resWell_[w], dx_well);
+                updateSingleWellState(w, dx_well, well_state);
+                setSingleWellVariables(w, well_state);
+            }
+            iterations[w] = std::max(iterations[w], it);
+            wellConverged[w] = converged;
+        };
+
+        bool converged = false;
+        int controlIt = 0;
+        do {
+            // exceptions must not leave the parallel region, the first one is rethrown
+            std::exception_ptr exception;
+            const int numThreadedWells = threadedWells.size();
+#pragma omp parallel for schedule(dynamic)
+            for (int i = 0; i < numThreadedWells; ++i) {
+                try {
+                    if (solveWell[threadedWells[i]]) {
+                        solveSingleWell(threadedWells[i]);
+                    }
+                }
+                catch (...) {
+#pragma omp critical
+                    if (!exception) {
+                        exception = std::current_exception();
+                    }
+                }
+            }
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+
+            for (const int w : serialWells) {
+                if (solveWell[w]) {
+                    solveSingleWell(w);
+                }
+            }
+
+            int allConverged = std::all_of(wellConverged.begin(), wellConverged.end(),
+                                           [](const char c) { return c != 0; });
+            int controlsChanged = 0;
+            if( wellsActive() )
+            {
+                // updateWellControls uses communication
+                updateWellThp(well_state);
+                const std::vector<int> oldControls = well_state.currentControls();
+                updateWellControls(well_state);
+                setWellVariables(well_state);
+                controlsChanged = oldControls != well_state.currentControls();
+                for (int w = 0; w < nw; ++w) {
+                    solveWell[w] = !wellConverged[w] || oldControls[w] != well_state.currentControls()[w];
+                }
+                const auto& comm = ebosSimulator.gridManager().grid().comm();
+                allConverged = comm.min(allConverged);
+                controlsChanged = comm.max(controlsChanged);
+            }
+            converged = allConverged && !controlsChanged;
+            ++controlIt;
+        } while (!converged && controlIt < maxIter);
+
+        if (!converged) {
+            well_state = well_state0;
+            // also recover the old well controls
+            for (int w = 0; w < nw; ++w) {
+                WellControls* wc = wells().ctrls[w];
+                well_controls_set_current(wc, well_state.currentControls()[w]);
+            }
+        }
+
+        SimulatorReport report;
+        report.converged = converged;
+        report.total_well_iterations = iterations.empty() ? 0 : *std::max_element(iterations.begin(), iterations.end());
+        return report;
+    }
+
+
+
+
+
     template<typename TypeTag>
     void
     StandardWellsDense<TypeTag>::
     printIf(const int c, const double x, const double y, const double eps, const std::string type) const
     {
         if (std::abs(x-y) > eps) {
-            std::cout << type << " " << c << ": "<<x << " " << y << std::endl;
+            OPM_DEBUG_LOG(Wells, type << " " << c << ": " << x << " " << y);
         }
     }
 
@@ -1100,22 +1877,14 @@ namespace Opm {
 
 
     template<typename TypeTag>
-    bool
+    std::vector<double>
     StandardWellsDense<TypeTag>::
-    getWellConvergence(Simulator& ebosSimulator,
-                       const int iteration) const
+    averageFormationVolumeFactors(Simulator& ebosSimulator) const
     {
-        typedef double Scalar;
-        typedef std::vector< Scalar > Vector;
-
         const int np = numPhases();
         const int numComp = numComponents();
 
-        const double tol_wells = param_.tolerance_wells_;
-        const double maxResidualAllowed = param_.max_residual_allowed_;
-
-        std::vector< Scalar > B_avg( numComp, Scalar() );
-        std::vector< Scalar > maxNormWell(numComp, Scalar() );
+        std::vector< double > B_avg( numComp, 0.0 );
 
         auto& grid = ebosSimulator.gridManager().grid();
         const auto& gridView = grid.leafGridView();
@@ -1150,6 +1919,32 @@ namespace Opm {
         {
             bval/=global_nc_;
         }
+        return B_avg;
+    }
+
+
+
+
+
+    template<typename TypeTag>
+    bool
+    StandardWellsDense<TypeTag>::
+    getWellConvergence(Simulator& ebosSimulator,
+                       const int iteration) const
+    {
+        typedef double Scalar;
+        typedef std::vector< Scalar > Vector;
+
+        const int np = numPhases();
+        const int numComp = numComponents();
+
+        const double tol_wells = param_.tolerance_wells_;
+        const double maxResidualAllowed = param_.max_residual_allowed_;
+
+        const std::vector< Scalar > B_avg = averageFormationVolumeFactors(ebosSimulator);
+        std::vector< Scalar > maxNormWell(numComp, Scalar() );
+
+        auto& grid = ebosSimulator.gridManager().grid();
 
         auto res = residual();
         const int nw = res.size() / numComp;
@@ -1225,15 +2020,30 @@ namespace Opm {
     {
          if( ! localWellsActive() ) return ;
 
+         // The properties of a well are only recomputed if its pressures or
+         // rates have changed beyond the tolerance since it was last computed.
+         const int nw = wells().number_of_wells;
+         const int np = wells().number_of_phases;
+         std::vector<double> values;
+         std::vector<int> offsets(1, 0);
+         for (int w = 0; w < nw; ++w) {
+             values.push_back(xw.bhp()[w]);
+             for (int perf = wells().well_connpos[w]; perf < wells().well_connpos[w+1]; ++perf) {
+                 values.push_back(xw.perfPress()[perf]);
+             }
+             for (int p = 0; p < np; ++p) {
+                 values.push_back(xw.wellRates()[w*np + p]);
+             }
+             values.push_back(xw.solventWellRate(w));
+             offsets.push_back(values.size());
+         }
+         const std::vector<bool>& changed = connection_pressure_tracker_.update(values, offsets);
+
          // 1. Compute properties required by computeConnectionPressureDelta().
          //    Note that some of the complexity of this part is due to the function
          //    taking std::vector<double> arguments, and not Eigen objects.
-         std::vector<double> b_perf;
-         std::vector<double> rsmax_perf;
-         std::vector<double> rvmax_perf;
-         std::vector<double> surf_dens_perf;
-         computePropertiesForWellConnectionPressures(ebosSimulator, xw, b_perf, rsmax_perf, rvmax_perf, surf_dens_perf);
-         computeWellConnectionDensitesPressures(xw, b_perf, rsmax_perf, rvmax_perf, surf_dens_perf, cell_depths_, gravity_);
+         computePropertiesForWellConnectionPressures(ebosSimulator, xw, b_perf_, rsmax_perf_, rvmax_perf_, surf_dens_perf_, &changed);
+         computeWellConnectionDensitesPressures(xw, b_perf_, rsmax_perf_, rvmax_perf_, surf_dens_perf_, gravity_);
     }
 
 
@@ -1248,7 +2058,8 @@ namespace Opm {
                                                 std::vector<double>& b_perf,
                                                 std::vector<double>& rsmax_perf,
                                                 std::vector<double>& rvmax_perf,
-                                                std::vector<double>& surf_dens_perf) const
+                                                std::vector<double>& surf_dens_perf,
+                                                const std::vector<bool>* update_well) const
     {
         const int nperf = wells().well_connpos[wells().number_of_wells];
         const int nw = wells().number_of_wells;
@@ -1265,6 +2076,11 @@ namespace Opm {
 
         // Compute the average pressure in each well block
         for (int w = 0; w < nw; ++w) {
+            // keep the values of the wells not to update
+            if (update_well && !(*update_well)[w]) {
+                continue;
+            }
+
             for (int perf = wells().well_connpos[w]; perf < wells().well_connpos[w+1]; ++perf) {
 
                 const int cell_idx = wells().well_cells[perf];
@@ -1354,242 +2170,279 @@ namespace Opm {
     updateWellState(const BVector& dwells,
                     WellState& well_state) const
     {
-        if( !localWellsActive() ) return;
-
+        if( !localWellsActive() ) return;
+
+        const int nw = wells().number_of_wells;
+        for (int w = 0; w < nw; ++w) {
+            updateSingleWellState(w, dwells[w], well_state);
+        }
+
+        updateWellThp(well_state);
+    }
+
+
+
+
+
+    template<typename TypeTag>
+    void
+    StandardWellsDense<TypeTag>::
+    updateSingleWellState(const int w,
+                          const VectorBlockType& dwell,
+                          WellState& well_state) const
+    {
         const int np = wells().number_of_phases;
         const int nw = wells().number_of_wells;
 
         double dFLimit = dWellFractionMax();
         double dBHPLimit = dbhpMaxRel();
-        std::vector<double> xvar_well_old = well_state.wellSolutions();
-
-        for (int w = 0; w < nw; ++w) {
+        // the well variables of this well before the update
+        std::array<double, numWellEq> xvar_well_old;
+        xvar_well_old.fill(0.0);
+        for (int eqIdx = 0; eqIdx < numComponents(); ++eqIdx) {
+            xvar_well_old[eqIdx] = well_state.wellSolutions()[eqIdx*nw + w];
+        }
 
-            // update the second and third well variable (The flux fractions)
-            std::vector<double> F(np,0.0);
-            if (active_[ Water ]) {
-                const int sign2 = dwells[w][WFrac] > 0 ? 1: -1;
-                const double dx2_limited = sign2 * std::min(std::abs(dwells[w][WFrac]),dFLimit);
-                well_state.wellSolutions()[WFrac*nw + w] = xvar_well_old[WFrac*nw + w] - dx2_limited;
-            }
+        // update the second and third well variable (The flux fractions)
+        std::vector<double> F(np,0.0);
+        if (active_[ Water ]) {
+            const int sign2 = dwell[WFrac] > 0 ? 1: -1;
+            const double dx2_limited = sign2 * std::min(std::abs(dwell[WFrac]),dFLimit);
+            well_state.wellSolutions()[WFrac*nw + w] = xvar_well_old[WFrac] - dx2_limited;
+        }
 
-            if (active_[ Gas ]) {
-                const int sign3 = dwells[w][GFrac] > 0 ? 1: -1;
-                const double dx3_limited = sign3 * std::min(std::abs(dwells[w][GFrac]),dFLimit);
-                well_state.wellSolutions()[GFrac*nw + w] = xvar_well_old[GFrac*nw + w] - dx3_limited;
-            }
+        if (active_[ Gas ]) {
+            const int sign3 = dwell[GFrac] > 0 ? 1: -1;
+            const double dx3_limited = sign3 * std::min(std::abs(dwell[GFrac]),dFLimit);
+            well_state.wellSolutions()[GFrac*nw + w] = xvar_well_old[GFrac] - dx3_limited;
+        }
 
-            if (has_solvent_) {
-                const int sign4 = dwells[w][SFrac] > 0 ? 1: -1;
-                const double dx4_limited = sign4 * std::min(std::abs(dwells[w][SFrac]),dFLimit);
-                well_state.wellSolutions()[SFrac*nw + w] = xvar_well_old[SFrac*nw + w] - dx4_limited;
-            }
+        if (has_solvent_) {
+            const int sign4 = dwell[SFrac] > 0 ? 1: -1;
+            const double dx4_limited = sign4 * std::min(std::abs(dwell[SFrac]),dFLimit);
+            well_state.wellSolutions()[SFrac*nw + w] = xvar_well_old[SFrac] - dx4_limited;
+        }
 
-            assert(active_[ Oil ]);
-            F[Oil] = 1.0;
-            if (active_[ Water ]) {
-                F[Water] = well_state.wellSolutions()[WFrac*nw + w];
-                F[Oil] -= F[Water];
-            }
+        assert(active_[ Oil ]);
+        F[Oil] = 1.0;
+        if (active_[ Water ]) {
+            F[Water] = well_state.wellSolutions()[WFrac*nw + w];
+            F[Oil] -= F[Water];
+        }
 
-            if (active_[ Gas ]) {
-                F[Gas] = well_state.wellSolutions()[GFrac*nw + w];
-                F[Oil] -= F[Gas];
-            }
+        if (active_[ Gas ]) {
+            F[Gas] = well_state.wellSolutions()[GFrac*nw + w];
+            F[Oil] -= F[Gas];
+        }
 
-            double F_solvent = 0.0;
-            if (has_solvent_) {
-                F_solvent = well_state.wellSolutions()[SFrac*nw + w];
-                F[Oil] -= F_solvent;
-            }
+        double F_solvent = 0.0;
+        if (has_solvent_) {
+            F_solvent = well_state.wellSolutions()[SFrac*nw + w];
+            F[Oil] -= F_solvent;
+        }
 
-            if (active_[ Water ]) {
-                if (F[Water] < 0.0) {
-                    if (active_[ Gas ]) {
-                        F[Gas] /= (1.0 - F[Water]);
-                    }
-                    if (has_solvent_) {
-                        F_solvent /= (1.0 - F[Water]);
-                    }
-                    F[Oil] /= (1.0 - F[Water]);
-                    F[Water] = 0.0;
+        if (active_[ Water ]) {
+            if (F[Water] < 0.0) {
+                if (active_[ Gas ]) {
+                    F[Gas] /= (1.0 - F[Water]);
                 }
-            }
-            if (active_[ Gas ]) {
-                if (F[Gas] < 0.0) {
-                    if (active_[ Water ]) {
-                        F[Water] /= (1.0 - F[Gas]);
-                    }
-                    if (has_solvent_) {
-                        F_solvent /= (1.0 - F[Gas]);
-                    }
-                    F[Oil] /= (1.0 - F[Gas]);
-                    F[Gas] = 0.0;
+                if (has_solvent_) {
+                    F_solvent /= (1.0 - F[Water]);
                 }
+                F[Oil] /= (1.0 - F[Water]);
+                F[Water] = 0.0;
             }
-            if (F[Oil] < 0.0) {
+        }
+        if (active_[ Gas ]) {
+            if (F[Gas] < 0.0) {
                 if (active_[ Water ]) {
-                     F[Water] /= (1.0 - F[Oil]);
-                }
-                if (active_[ Gas ]) {
-                    F[Gas] /= (1.0 - F[Oil]);
+                    F[Water] /= (1.0 - F[Gas]);
                 }
                 if (has_solvent_) {
-                    F_solvent /= (1.0 - F[Oil]);
+                    F_solvent /= (1.0 - F[Gas]);
                 }
-                F[Oil] = 0.0;
+                F[Oil] /= (1.0 - F[Gas]);
+                F[Gas] = 0.0;
             }
-
+        }
+        if (F[Oil] < 0.0) {
             if (active_[ Water ]) {
-                well_state.wellSolutions()[WFrac*nw + w] = F[Water];
+                 F[Water] /= (1.0 - F[Oil]);
             }
             if (active_[ Gas ]) {
-                well_state.wellSolutions()[GFrac*nw + w] = F[Gas];
+                F[Gas] /= (1.0 - F[Oil]);
             }
-            if(has_solvent_) {
-                well_state.wellSolutions()[SFrac*nw + w] = F_solvent;
+            if (has_solvent_) {
+                F_solvent /= (1.0 - F[Oil]);
             }
+            F[Oil] = 0.0;
+        }
 
-            // F_solvent is added to F_gas. This means that well_rate[Gas] also contains solvent.
-            // More testing is needed to make sure this is correct for well groups and THP.
-            if (has_solvent_){
-                F[Gas] += F_solvent;
-            }
+        if (active_[ Water ]) {
+            well_state.wellSolutions()[WFrac*nw + w] = F[Water];
+        }
+        if (active_[ Gas ]) {
+            well_state.wellSolutions()[GFrac*nw + w] = F[Gas];
+        }
+        if(has_solvent_) {
+            well_state.wellSolutions()[SFrac*nw + w] = F_solvent;
+        }
 
-            // The interpretation of the first well variable depends on the well control
-            const WellControls* wc = wells().ctrls[w];
+        // F_solvent is added to F_gas. This means that well_rate[Gas] also contains solvent.
+        // More testing is needed to make sure this is correct for well groups and THP.
+        if (has_solvent_){
+            F[Gas] += F_solvent;
+        }
 
-            // The current control in the well state overrides
-            // the current control set in the Wells struct, which
-            // is instead treated as a default.
-            const int current = well_state.currentControls()[w];
-            const double target_rate = well_controls_iget_target(wc, current);
+        // The interpretation of the first well variable depends on the well control
+        const WellControls* wc = wells().ctrls[w];
 
-            std::vector<double> g = {1,1,0.01};
-            if (well_controls_iget_type(wc, current) == RESERVOIR_RATE) {
-                const double* distr = well_controls_iget_distr(wc, current);
-                for (int p = 0; p < np; ++p) {
-                    if (distr[p] > 0.) { // For injection wells, there only one non-zero distr value
-                        F[p] /= distr[p];
-                    } else {
-                        F[p] = 0.;
-                    }
-                }
-            } else {
-                for (int p = 0; p < np; ++p) {
-                    F[p] /= g[p];
+        // The current control in the well state overrides
+        // the current control set in the Wells struct, which
+        // is instead treated as a default.
+        const int current = well_state.currentControls()[w];
+        const double target_rate = well_controls_iget_target(wc, current);
+
+        std::vector<double> g = {1,1,0.01};
+        if (well_controls_iget_type(wc, current) == RESERVOIR_RATE) {
+            const double* distr = well_controls_iget_distr(wc, current);
+            for (int p = 0; p < np; ++p) {
+                if (distr[p] > 0.) { // For injection wells, there only one non-zero distr value
+                    F[p] /= distr[p];
+                } else {
+                    F[p] = 0.;
                 }
             }
+        } else {
+            for (int p = 0; p < np; ++p) {
+                F[p] /= g[p];
+            }
+        }
 
-            switch (well_controls_iget_type(wc, current)) {
-                case THP: // The BHP and THP both uses the total rate as first well variable.
-                case BHP:
-                {
-                    well_state.wellSolutions()[nw*XvarWell + w] = xvar_well_old[nw*XvarWell + w] - dwells[w][XvarWell];
+        switch (well_controls_iget_type(wc, current)) {
+            case THP: // The BHP and THP both uses the total rate as first well variable.
+            case BHP:
+            {
+                well_state.wellSolutions()[nw*XvarWell + w] = xvar_well_old[XvarWell] - dwell[XvarWell];
 
-                    switch (wells().type[w]) {
-                    case INJECTOR:
-                        for (int p = 0; p < np; ++p) {
-                            const double comp_frac = wells().comp_frac[np*w + p];
-                            well_state.wellRates()[w*np + p] = comp_frac * well_state.wellSolutions()[nw*XvarWell + w];
-                        }
-                        break;
-                    case PRODUCER:
-                        for (int p = 0; p < np; ++p) {
-                            well_state.wellRates()[w*np + p] = well_state.wellSolutions()[nw*XvarWell + w] * F[p];
-                        }
-                        break;
+                switch (wells().type[w]) {
+                case INJECTOR:
+                    for (int p = 0; p < np; ++p) {
+                        const double comp_frac = wells().comp_frac[np*w + p];
+                        well_state.wellRates()[w*np + p] = comp_frac * well_state.wellSolutions()[nw*XvarWell + w];
+                    }
+                    break;
+                case PRODUCER:
+                    for (int p = 0; p < np; ++p) {
+                        well_state.wellRates()[w*np + p] = well_state.wellSolutions()[nw*XvarWell + w] * F[p];
                     }
+                    break;
+                }
 
-                    if (well_controls_iget_type(wc, current) == THP) {
+                if (well_controls_iget_type(wc, current) == THP) {
 
-                        // Calculate bhp from thp control and well rates
-                        double aqua = 0.0;
-                        double liquid = 0.0;
-                        double vapour = 0.0;
+                    // Calculate bhp from thp control and well rates
+                    double aqua = 0.0;
+                    double liquid = 0.0;
+                    double vapour = 0.0;
 
-                        const Opm::PhaseUsage& pu = phase_usage_;
+                    const Opm::PhaseUsage& pu = phase_usage_;
 
-                        if (active_[ Water ]) {
-                            aqua = well_state.wellRates()[w*np + pu.phase_pos[ Water ] ];
-                        }
-                        if (active_[ Oil ]) {
-                            liquid = well_state.wellRates()[w*np + pu.phase_pos[ Oil ] ];
-                        }
-                        if (active_[ Gas ]) {
-                            vapour = well_state.wellRates()[w*np + pu.phase_pos[ Gas ] ];
-                        }
+                    if (active_[ Water ]) {
+                        aqua = well_state.wellRates()[w*np + pu.phase_pos[ Water ] ];
+                    }
+                    if (active_[ Oil ]) {
+                        liquid = well_state.wellRates()[w*np + pu.phase_pos[ Oil ] ];
+                    }
+                    if (active_[ Gas ]) {
+                        vapour = well_state.wellRates()[w*np + pu.phase_pos[ Gas ] ];
+                    }
 
-                        const int vfp        = well_controls_iget_vfp(wc, current);
-                        const double& thp    = well_controls_iget_target(wc, current);
-                        const double& alq    = well_controls_iget_alq(wc, current);
+                    const int vfp        = well_controls_iget_vfp(wc, current);
+                    const double& thp    = well_controls_iget_target(wc, current);
+                    const double& alq    = well_controls_iget_alq(wc, current);
 
-                        //Set *BHP* target by calculating bhp from THP
-                        const WellType& well_type = wells().type[w];
-                        // pick the density in the top layer
-                        const int perf = wells().well_connpos[w];
-                        const double rho = well_perforation_densities_[perf];
+                    //Set *BHP* target by calculating bhp from THP
+                    const WellType& well_type = wells().type[w];
+                    // pick the density in the top layer
+                    const int perf = wells().well_connpos[w];
+                    const double rho = well_perforation_densities_[perf];
 
-                        if (well_type == INJECTOR) {
-                             const double dp = wellhelpers::computeHydrostaticCorrection(
-                                               wells(), w, vfp_properties_->getInj()->getTable(vfp)->getDatumDepth(),
-                                               rho, gravity_);
+                    if (well_type == INJECTOR) {
+                         const double dp = wellhelpers::computeHydrostaticCorrection(
+                                           wells(), w, vfp_properties_->getInj()->getTable(vfp)->getDatumDepth(),
+                                           rho, gravity_);
 
-                             well_state.bhp()[w] = vfp_properties_->getInj()->bhp(vfp, aqua, liquid, vapour, thp) - dp;
-                        }
-                        else if (well_type == PRODUCER) {
-                            const double dp = wellhelpers::computeHydrostaticCorrection(
-                                              wells(), w, vfp_properties_->getProd()->getTable(vfp)->getDatumDepth(),
-                                              rho, gravity_);
+                         well_state.bhp()[w] = vfp_properties_->getInj()->bhp(vfp, aqua, liquid, vapour, thp) - dp;
+                    }
+                    else if (well_type == PRODUCER) {
+                        const double dp = wellhelpers::computeHydrostaticCorrection(
+                                          wells(), w, vfp_properties_->getProd()->getTable(vfp)->getDatumDepth(),
+                                          rho, gravity_);
 
-                            well_state.bhp()[w] = vfp_properties_->getProd()->bhp(vfp, aqua, liquid, vapour, thp, alq) - dp;
-                        }
-                        else {
-                            OPM_THROW(std::logic_error, "Expected INJECTOR or PRODUCER well");
-                        }
+                        well_state.bhp()[w] = vfp_properties_->getProd()->bhp(vfp, aqua, liquid, vapour, thp, alq) - dp;
+                    }
+                    else {
+                        OPM_THROW(std::logic_error, "Expected INJECTOR or PRODUCER well");
                     }
                 }
-                    break;
-                case SURFACE_RATE: // Both rate controls use bhp as first well variable
-                case RESERVOIR_RATE:
-                {
-                    const int sign1 = dwells[w][XvarWell] > 0 ? 1: -1;
-                    const double dx1_limited = sign1 * std::min(std::abs(dwells[w][XvarWell]),std::abs(xvar_well_old[nw*XvarWell + w])*dBHPLimit);
-                    well_state.wellSolutions()[nw*XvarWell + w] = std::max(xvar_well_old[nw*XvarWell + w] - dx1_limited,1e5);
-                    well_state.bhp()[w] = well_state.wellSolutions()[nw*XvarWell + w];
-
-                    if (well_controls_iget_type(wc, current) == SURFACE_RATE) {
-                        if (wells().type[w]==PRODUCER) {
-
-                            const double* distr = well_controls_iget_distr(wc, current);
-
-                            double F_target = 0.0;
-                            for (int p = 0; p < np; ++p) {
-                                F_target += distr[p] * F[p];
-                            }
-                            for (int p = 0; p < np; ++p) {
-                                well_state.wellRates()[np*w + p] = F[p] * target_rate / F_target;
-                            }
-                        } else {
+            }
+                break;
+            case SURFACE_RATE: // Both rate controls use bhp as first well variable
+            case RESERVOIR_RATE:
+            {
+                const int sign1 = dwell[XvarWell] > 0 ? 1: -1;
+                const double dx1_limited = sign1 * std::min(std::abs(dwell[XvarWell]),std::abs(xvar_well_old[XvarWell])*dBHPLimit);
+                well_state.wellSolutions()[nw*XvarWell + w] = std::max(xvar_well_old[XvarWell] - dx1_limited,1e5);
+                well_state.bhp()[w] = well_state.wellSolutions()[nw*XvarWell + w];
 
-                            for (int p = 0; p < np; ++p) {
-                                well_state.wellRates()[w*np + p] = wells().comp_frac[np*w + p] * target_rate;
-                            }
+                if (well_controls_iget_type(wc, current) == SURFACE_RATE) {
+                    if (wells().type[w]==PRODUCER) {
+
+                        const double* distr = well_controls_iget_distr(wc, current);
+
+                        double F_target = 0.0;
+                        for (int p = 0; p < np; ++p) {
+                            F_target += distr[p] * F[p];
+                        }
+                        for (int p = 0; p < np; ++p) {
+                            well_state.wellRates()[np*w + p] = F[p] * target_rate / F_target;
                         }
-                    } else { // RESERVOIR_RATE
+                    } else {
+
                         for (int p = 0; p < np; ++p) {
-                            well_state.wellRates()[np*w + p] = F[p] * target_rate;
+                            well_state.wellRates()[w*np + p] = wells().comp_frac[np*w + p] * target_rate;
                         }
                     }
+                } else { // RESERVOIR_RATE
+                    for (int p = 0; p < np; ++p) {
+                        well_state.wellRates()[np*w + p] = F[p] * target_rate;
+                    }
                 }
-                    break;
-            } // end of switch (well_controls_iget_type(wc, current))
-        } // end of for (int w = 0; w < nw; ++w)
+            }
+                break;
+        } // end of switch (well_controls_iget_type(wc, current))
+    }
+
+
+
+
 
+    template<typename TypeTag>
+    void
+    StandardWellsDense<TypeTag>::
+    updateWellThp(WellState& well_state) const
+    {
+        TimerTree::Region region("VFP");
+        const int np = wells().number_of_phases;
+        const int nw = wells().number_of_wells;
 
         // for the wells having a THP constaint, we should update their thp value
         // If it is under THP control, it will be set to be the target value. Otherwise,
         // the thp value will be calculated based on the bhp value, assuming the bhp value is correctly calculated.
+        // The thp of the producers is evaluated for all of them at once after the loop.
+        std::vector<int> prod_wells, prod_table_id;
+        std::vector<double> prod_aqua, prod_liquid, prod_vapour, prod_bhp, prod_alq;
         for (int w = 0; w < nw; ++w) {
             const WellControls* wc = wells().ctrls[w];
             const int nwc = well_controls_get_num(wc);
@@ -1637,8 +2490,13 @@ namespace Opm {
                                               wells(), w, vfp_properties_->getProd()->getTable(table_id)->getDatumDepth(),
                                               wellPerforationDensities()[perf], gravity_);
 
-                            const double bhp = well_state.bhp()[w];
-                            well_state.thp()[w] = vfp_properties_->getProd()->thp(table_id, aqua, liquid, vapour, bhp + dp, alq);
+                            prod_wells.push_back(w);
+                            prod_table_id.push_back(table_id);
+                            prod_aqua.push_back(aqua);
+                            prod_liquid.push_back(liquid);
+                            prod_vapour.push_back(vapour);
+                            prod_bhp.push_back(well_state.bhp()[w] + dp);
+                            prod_alq.push_back(alq);
                         } else {
                             OPM_THROW(std::logic_error, "Expected INJECTOR or PRODUCER well");
                         }
@@ -1654,6 +2512,15 @@ namespace Opm {
                 well_state.thp()[w] = 0.0;
             }
         } // end of for (int w = 0; w < nw; ++w)
+
+        if ( !prod_wells.empty() ) {
+            std::vector<double> prod_thp;
+            vfp_properties_->getProd()->thp(prod_table_id, prod_aqua, prod_liquid, prod_vapour,
+                                            prod_bhp, prod_alq, prod_thp, vfp_thp_brackets_);
+            for (std::size_t i = 0; i < prod_wells.size(); ++i) {
+                well_state.thp()[prod_wells[i]] = prod_thp[i];
+            }
+        }
     }
 
 
@@ -1667,8 +2534,8 @@ namespace Opm {
     {
         // Even if there no wells active locally, we cannot
         // return as the Destructor of the WellSwitchingLogger
-        // uses global communication. For no well active globally
-        // we simply return.
+        // uses global communication, unless a deferred logger is
+        // used. For no well active globally we simply return.
         if( !wellsActive() ) return ;
 
         const int np = wells().number_of_phases;
@@ -1731,6 +2598,9 @@ namespace Opm {
             }
         }
 
+        // the group targets may change below
+        group_target_valid_ = false;
+
         // the new well control indices after all the related updates,
         std::vector<int> updated_control_index(nw, 0);
         for (int w = 0; w < nw; ++w) {
@@ -1738,7 +2608,11 @@ namespace Opm {
         }
 
         // checking whether control changed
-        wellhelpers::WellSwitchingLogger logger;
+        std::unique_ptr<wellhelpers::WellSwitchingLogger> local_logger;
+        if ( !switching_logger_ ) {
+            local_logger.reset(new wellhelpers::WellSwitchingLogger());
+        }
+        wellhelpers::WellSwitchingLogger& logger = switching_logger_ ? *switching_logger_ : *local_logger;
         for (int w = 0; w < nw; ++w) {
             const WellControls* wc = wells().ctrls[w];
             if (updated_control_index[w] != old_control_index[w]) {
@@ -1884,11 +2758,10 @@ namespace Opm {
                                            const std::vector<double>& rsmax_perf,
                                            const std::vector<double>& rvmax_perf,
                                            const std::vector<double>& surf_dens_perf,
-                                           const std::vector<double>& depth_perf,
                                            const double grav)
     {
         // Compute densities
-        const int nperf = depth_perf.size();
+        const int nperf = wells().well_connpos[wells().number_of_wells];
         const int numComponent = b_perf.size() / nperf;
         const int np = wells().number_of_phases;
         std::vector<double> perfRates(b_perf.size(),0.0);
@@ -1907,8 +2780,8 @@ namespace Opm {
 
         // Compute pressure deltas
         well_perforation_pressure_diffs_ =
-                  WellDensitySegmented::computeConnectionPressureDelta(
-                          wells(), depth_perf, well_perforation_densities_, grav);
+                  WellDensitySegmented::computeConnectionPressureDeltaFromDepthDifferences(
+                          wells(), perf_depth_diffs_, well_perforation_densities_, grav);
     }
 
 
@@ -1927,51 +2800,112 @@ namespace Opm {
         const int nw = wells().number_of_wells;
         const int np = wells().number_of_phases;
 
-        well_potentials.resize(nw * np, 0.0);
-
+        // The potentials of a well are only recomputed if the pressures of its
+        // perforated cells, its connection pressures or its rates have changed
+        // beyond the tolerance since they were last computed.
+        std::vector<double> values;
+        std::vector<int> offsets(1, 0);
+        for (int w = 0; w < nw; ++w) {
+            values.push_back(mostStrictBhpFromBhpLimits(w));
+            values.push_back(well_state.isNewWell(w) ? 1.0 : 0.0);
+            for (int perf = wells().well_connpos[w]; perf < wells().well_connpos[w+1]; ++perf) {
+                const int cell_idx = wells().well_cells[perf];
+                const auto& intQuants = *(ebosSimulator.model().cachedIntensiveQuantities(cell_idx, /*timeIdx=*/0));
+                values.push_back(intQuants.fluidState().pressure(FluidSystem::oilPhaseIdx).value());
+                values.push_back(well_perforation_pressure_diffs_[perf]);
+            }
+            for (int p = 0; p < np; ++p) {
+                values.push_back(well_state.wellRates()[w*np + p]);
+            }
+            offsets.push_back(values.size());
+        }
+        const std::vector<bool>& changed = well_potential_tracker_.update(values, offsets);
+        well_potentials_.resize(nw * np, 0.0);
+
+        // The potential of each well is an independent well solve that only
+        // reads the converged reservoir state, so the wells are distributed over
+        // the threads. Perforations with their own saturation table switch the
+        // material law parameters of their cell in place, which two wells
+        // perforating the same cell must not do concurrently; the wells are then
+        // computed serially.
+        std::vector<int> changed_wells;
+        bool own_saturation_tables = false;
+        const auto& materialLawManager = ebosSimulator.problem().materialLawManager();
         for (int w = 0; w < nw; ++w) {
+            if (!changed[w]) {
+                continue;
+            }
+            changed_wells.push_back(w);
+            for (int perf = wells().well_connpos[w]; perf < wells().well_connpos[w+1]; ++perf) {
+                const int cell_idx = wells().well_cells[perf];
+                if (wells().sat_table_id[perf] - 1 != int(materialLawManager->satnumRegionIdx(cell_idx))) {
+                    own_saturation_tables = true;
+                }
+            }
+        }
+        const int num_changed = changed_wells.size();
 
-            // get the bhp value based on the bhp constraints
-            const double bhp = mostStrictBhpFromBhpLimits(w);
+        std::exception_ptr error;
+#pragma omp parallel for schedule(dynamic) if (!own_saturation_tables)
+        for (int i = 0; i < num_changed; ++i) {
+            try {
+                const int w = changed_wells[i];
 
-            // does the well have a THP related constraint?
-            const bool has_thp_control = wellHasTHPConstraints(w);
+                // get the bhp value based on the bhp constraints
+                const double bhp = mostStrictBhpFromBhpLimits(w);
 
-            std::vector<double> potentials(np);
+                // does the well have a THP related constraint?
+                const bool has_thp_control = wellHasTHPConstraints(w);
 
-            if ( !has_thp_control ) {
+                std::vector<double> potentials(np);
 
-                assert(std::abs(bhp) != std::numeric_limits<double>::max());
+                if ( !has_thp_control ) {
 
-                computeWellRatesWithBhp(ebosSimulator, bhp, w, potentials);
+                    assert(std::abs(bhp) != std::numeric_limits<double>::max());
 
-            } else { // the well has a THP related constraint
-                // checking whether a well is newly added, it only happens at the beginning of the report step
-                if ( !well_state.isNewWell(w) ) {
-                    for (int p = 0; p < np; ++p) {
-                        // This is dangerous for new added well
-                        // since we are not handling the initialization correctly for now
-                        potentials[p] = well_state.wellRates()[w * np + p];
-                    }
-                } else {
-                    // We need to generate a reasonable rates to start the iteration process
                     computeWellRatesWithBhp(ebosSimulator, bhp, w, potentials);
-                    for (double& value : potentials) {
-                        // make the value a little safer in case the BHP limits are default ones
-                        // TODO: a better way should be a better rescaling based on the investigation of the VFP table.
-                        const double rate_safety_scaling_factor = 0.00001;
-                        value *= rate_safety_scaling_factor;
+
+                } else { // the well has a THP related constraint
+                    // checking whether a well is newly added, it only happens at the beginning of the report step
+                    if ( !well_state.isNewWell(w) ) {
+                        for (int p = 0; p < np; ++p) {
+                            // This is dangerous for new added well
+                            // since we are not handling the initialization correctly for now
+                            potentials[p] = well_state.wellRates()[w * np + p];
+                        }
+                    } else {
+                        // We need to generate a reasonable rates to start the iteration process
+                        computeWellRatesWithBhp(ebosSimulator, bhp, w, potentials);
+                        for (double& value : potentials) {
+                            // make the value a little safer in case the BHP limits are default ones
+                            // TODO: a better way should be a better rescaling based on the investigation of the VFP table.
+                            const double rate_safety_scaling_factor = 0.00001;
+                            value *= rate_safety_scaling_factor;
+                        }
                     }
+
+                    potentials = computeWellPotentialWithTHP(ebosSimulator, w, bhp, potentials);
                 }
 
-                potentials = computeWellPotentialWithTHP(ebosSimulator, w, bhp, potentials);
+                // putting the sucessfully calculated potentials to the well_potentials
+                for (int p = 0; p < np; ++p) {
+                    well_potentials_[w * np + p] = std::abs(potentials[p]);
+                }
             }
-
-            // putting the sucessfully calculated potentials to the well_potentials
-            for (int p = 0; p < np; ++p) {
-                well_potentials[w * np + p] = std::abs(potentials[p]);
+            catch (...) {
+#pragma omp critical
+                if (!error) {
+                    error = std::current_exception();
+                }
             }
-        } // end of for (int w = 0; w < nw; ++w)
+        } // end of for (int i = 0; i < num_changed; ++i)
+        if (error) {
+            // the wells whose potentials were not computed are redone next time
+            well_potential_tracker_.reset();
+            std::rethrow_exception(error);
+        }
+
+        well_potentials = well_potentials_;
     }
 
 
@@ -1984,6 +2918,8 @@ namespace Opm {
     prepareTimeStep(const Simulator& ebos_simulator,
                     WellState& well_state)
     {
+        group_target_valid_ = false;
+
         const int nw = wells().number_of_wells;
         for (int w = 0; w < nw; ++w) {
             // after restarting, the well_controls can be modified while
@@ -2074,6 +3010,23 @@ namespace Opm {
 
 
 
+
+    template<typename TypeTag>
+    bool
+    StandardWellsDense<TypeTag>::
+    groupTargetConverged(const std::vector<double>& well_rates) const
+    {
+        if ( !group_target_valid_ || well_rates != group_target_rates_ ) {
+            group_target_converged_ = well_collection_->groupTargetConverged(well_rates);
+            group_target_rates_ = well_rates;
+            group_target_valid_ = true;
+        }
+        return group_target_converged_;
+    }
+
+
+
+
     template<typename TypeTag>
     const std::vector<double>&
     StandardWellsDense<TypeTag>::
@@ -2219,6 +3172,7 @@ namespace Opm {
             bhp.setValue(target_rate);
             return bhp;
         } else if (well_controls_get_current_type(wc) == THP) {
+            TimerTree::Region region("VFP");
             const int control = well_controls_get_current(wc);
             const double thp = well_controls_get_current_target(wc);
             const double alq = well_controls_iget_alq(wc, control);
@@ -2291,6 +3245,55 @@ namespace Opm {
         return getQs(wellIdx, compIdx);
     }
 
+    template<typename TypeTag>
+    double
+    StandardWellsDense<TypeTag>::
+    historyRateMismatch(const double min_rate, BVector& gradient) const
+    {
+        const int nw = wellsActive() ? wells().number_of_wells : 0;
+        gradient.resize(nw);
+        gradient = 0.0;
+        double mismatch = 0.0;
+        const PhaseUsage& pu = phase_usage_;
+        for (const auto& well : wells_ecl_) {
+            if (well->getStatus(current_timeIdx_) == WellCommon::SHUT
+                || !well->isProducer(current_timeIdx_)) {
+                continue;
+            }
+            const WellProductionProperties& production = well->getProductionProperties(current_timeIdx_);
+            if (production.predictionMode) {
+                continue;
+            }
+            int w = 0;
+            while (w < nw && well->name() != wells().name[w]) {
+                ++w;
+            }
+            if (w == nw || !distributed_wells_.isOwner(w)) {
+                continue;
+            }
+
+            // the observed rates are positive, those of the producers negative
+            const std::pair<BlackoilPhases::PhaseIndex, double> observed[] = {
+                { BlackoilPhases::Aqua, production.WaterRate },
+                { BlackoilPhases::Liquid, production.OilRate },
+                { BlackoilPhases::Vapour, production.GasRate }
+            };
+            for (const auto& phase : observed) {
+                if (!pu.phase_used[phase.first]) {
+                    continue;
+                }
+                const double scale = std::max(std::abs(phase.second), min_rate);
+                const EvalWell misfit = (getQs(w, pu.phase_pos[phase.first]) + phase.second) / scale;
+                mismatch += misfit.value() * misfit.value();
+                for (int pvIdx = 0; pvIdx < numWellEq; ++pvIdx) {
+                    gradient[w][pvIdx] += 2.0 * misfit.value() * misfit.derivative(pvIdx + numEq);
+                }
+            }
+        }
+        return mismatch;
+    }
+
+
     template<typename TypeTag>
     typename StandardWellsDense<TypeTag>::EvalWell
     StandardWellsDense<TypeTag>::
@@ -2657,38 +3660,37 @@ namespace Opm {
         }
 
         if (water_cut_limit_violated) {
-            // need to handle the worst_offending_connection
+            // the worst-offending connection is kept up to date by the
+            // assembly of the well, the perforations are only searched if
+            // the perforation rates have not been assembled, e.g. at restart
             const int perf_start = map_entry[1];
             const int perf_number = map_entry[2];
 
-            std::vector<double> water_cut_perf(perf_number);
-            for (int perf = 0; perf < perf_number; ++perf) {
-                const int i_perf = perf_start + perf;
-                const double oil_perf_rate = well_state.perfPhaseRates()[i_perf * np + pu.phase_pos[ Oil ] ];
-                const double water_perf_rate = well_state.perfPhaseRates()[i_perf * np + pu.phase_pos[ Water ] ];
-                const double liquid_perf_rate = oil_perf_rate + water_perf_rate;
-                if (std::abs(liquid_perf_rate) != 0.) {
-                    water_cut_perf[perf] = water_perf_rate / liquid_perf_rate;
-                } else {
-                    water_cut_perf[perf] = 0.;
+            worst_offending_connection = well_state.worstWaterCutConnection()[well_number];
+            double max_water_cut_perf = well_state.worstWaterCut()[well_number];
+            if (worst_offending_connection < 0) {
+                worst_offending_connection = INVALIDCONNECTION;
+                max_water_cut_perf = 0.;
+                for (int perf = 0; perf < perf_number; ++perf) {
+                    const int i_perf = perf_start + perf;
+                    const double oil_perf_rate = well_state.perfPhaseRates()[i_perf * np + pu.phase_pos[ Oil ] ];
+                    const double water_perf_rate = well_state.perfPhaseRates()[i_perf * np + pu.phase_pos[ Water ] ];
+                    const double liquid_perf_rate = oil_perf_rate + water_perf_rate;
+                    const double water_cut_perf = (std::abs(liquid_perf_rate) != 0.) ? water_perf_rate / liquid_perf_rate : 0.;
+                    if (water_cut_perf > max_water_cut_perf) {
+                        worst_offending_connection = perf;
+                        max_water_cut_perf = water_cut_perf;
+                    }
                 }
             }
 
             last_connection = (perf_number == 1);
             if (last_connection) {
                 worst_offending_connection = 0;
-                violation_extent = water_cut_perf[0] / max_water_cut_limit;
+                violation_extent = max_water_cut_perf / max_water_cut_limit;
                 return std::make_tuple(water_cut_limit_violated, last_connection, worst_offending_connection, violation_extent);
             }
 
-            double max_water_cut_perf = 0.;
-            for (int perf = 0; perf < perf_number; ++perf) {
-                if (water_cut_perf[perf] > max_water_cut_perf) {
-                    worst_offending_connection = perf;
-                    max_water_cut_perf = water_cut_perf[perf];
-                }
-            }
-
             assert(max_water_cut_perf != 0.);
             assert((worst_offending_connection >= 0) && (worst_offending_connection < perf_number));
 
@@ -2961,8 +3963,10 @@ namespace Opm {
             const int cell_index = wells().well_cells[perf];
             const auto& intQuants = *(ebosSimulator.model().cachedIntensiveQuantities(cell_index, /*timeIdx=*/ 0));
             // flux for each perforation
-            std::vector<EvalWell> cq_s(numComp, 0.0);
-            std::vector<EvalWell> mob(numComp, 0.0);
+            EvalWellComponents cq_s;
+            cq_s.fill(0.0);
+            EvalWellComponents mob;
+            mob.fill(0.0);
             getMobility(ebosSimulator, well_index, perf, cell_index, mob);
             computeWellFlux(well_index, wells().WI[perf], intQuants, mob, bhp,
                             wellPerforationPressureDiffs()[perf], allow_cf, cq_s);
@@ -3226,24 +4230,6 @@ namespace Opm {
     }
 
 
-    template<typename TypeTag>
-    void
-    StandardWellsDense<TypeTag>::
-    setupCompressedToCartesian(const int* global_cell, int number_of_cells, std::map<int,int>& cartesian_to_compressed ) const
-    {
-        if (global_cell) {
-            for (int i = 0; i < number_of_cells; ++i) {
-                cartesian_to_compressed.insert(std::make_pair(global_cell[i], i));
-            }
-        }
-        else {
-            for (int i = 0; i < number_of_cells; ++i) {
-                cartesian_to_compressed.insert(std::make_pair(i, i));
-            }
-        }
-
-    }
-
     template<typename TypeTag>
     void
     StandardWellsDense<TypeTag>::
@@ -3277,10 +4263,12 @@ namespace Opm {
         wells_perf_length_.reserve(nperf);
         wells_bore_diameter_.reserve(nperf);
 
-        std::map<int,int> cartesian_to_compressed;
-
-        setupCompressedToCartesian(global_cell, number_of_cells,
-                                    cartesian_to_compressed);
+        std::unique_ptr<CartesianToCompressed> local_cartesian_to_compressed;
+        if (!cartesian_to_compressed_) {
+            local_cartesian_to_compressed.reset(new CartesianToCompressed(global_cell, number_of_cells, cart_dims));
+        }
+        const CartesianToCompressed& cartesian_to_compressed =
+            cartesian_to_compressed_ ? *cartesian_to_compressed_ : *local_cartesian_to_compressed;
 
         int well_index = 0;
 
@@ -3299,14 +4287,11 @@ namespace Opm {
                          int j = completion.getJ();
                          int k = completion.getK();
 
-                         const int* cpgdim = cart_dims;
-                         int cart_grid_indx = i + cpgdim[0]*(j + cpgdim[1]*k);
-                         std::map<int, int>::const_iterator cgit = cartesian_to_compressed.find(cart_grid_indx);
-                         if (cgit == cartesian_to_compressed.end()) {
+                         const int cell = cartesian_to_compressed.compressedIndex(i, j, k);
+                         if (cell < 0) {
                              OPM_THROW(std::runtime_error, "Cell with i,j,k indices " << i << ' ' << j << ' '
                                        << k << " not found in grid (well = " << well->name() << ')');
                          }
-                         int cell = cgit->second;
 
                          {
                              double radius = 0.5*completion.getDiameter();
@@ -3362,15 +4347,8 @@ namespace Opm {
     StandardWellsDense<TypeTag>::
     B() const
     {
-        return duneB_;
-    }
-
-    template<typename TypeTag>
-    typename StandardWellsDense<TypeTag>::Mat &
-    StandardWellsDense<TypeTag>::
-    B()
-    {
-        return duneB_;
+        duneB_.copyTo( numCells(), exportB_ );
+        return exportB_;
     }
 
     template<typename TypeTag>
@@ -3378,15 +4356,8 @@ namespace Opm {
     StandardWellsDense<TypeTag>::
     C() const
     {
-        return duneC_;
-    }
-
-    template<typename TypeTag>
-    typename StandardWellsDense<TypeTag>::Mat &
-    StandardWellsDense<TypeTag>::
-    C()
-    {
-        return duneC_;
+        duneC_.copyTo( numCells(), exportC_ );
+        return exportC_;
     }
 
     template<typename TypeTag>
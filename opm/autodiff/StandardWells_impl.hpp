@@ -37,7 +37,8 @@ namespace Opm
     WellOps::WellOps(const Wells* wells)
       : w2p(),
         p2w(),
-        well_cells()
+        well_cells(),
+        well_cells_plan()
     {
         if( wells )
         {
@@ -64,6 +65,7 @@ namespace Opm
             p2w.setFromTriplets(gather .begin(), gather .end());
 
             well_cells.assign(wells->well_cells, wells->well_cells + wells->well_connpos[wells->number_of_wells]);
+            well_cells_plan = GatherPlan(well_cells);
         }
     }
 
@@ -246,7 +248,7 @@ namespace Opm
         const std::vector<int>& well_cells = wellOps().well_cells;
 
         // Use cell values for the temperature as the wells don't knows its temperature yet.
-        const ADB perf_temp = subset(state.temperature, well_cells);
+        const ADB perf_temp = subset(state.temperature, wellOps().well_cells_plan);
 
         // Compute b, rsmax, rvmax values for perforations.
         // Evaluate the properties using average well block pressures
@@ -264,14 +266,14 @@ namespace Opm
             b.col(pu.phase_pos[BlackoilPhases::Aqua]) = bw;
         }
         assert((*active_)[Oil]);
-        const Vector perf_so =  subset(state.saturation[pu.phase_pos[Oil]].value(), well_cells);
+        const Vector perf_so =  subset(state.saturation[pu.phase_pos[Oil]].value(), wellOps().well_cells_plan);
         if (pu.phase_used[BlackoilPhases::Liquid]) {
-            const ADB perf_rs = (state.rs.size() > 0) ? subset(state.rs, well_cells) : ADB::null();
+            const ADB perf_rs = (state.rs.size() > 0) ? subset(state.rs, wellOps().well_cells_plan) : ADB::null();
             const Vector bo = fluid_->bOil(avg_press_ad, perf_temp, perf_rs, perf_cond, well_cells).value();
             b.col(pu.phase_pos[BlackoilPhases::Liquid]) = bo;
         }
         if (pu.phase_used[BlackoilPhases::Vapour]) {
-            const ADB perf_rv = (state.rv.size() > 0) ? subset(state.rv, well_cells) : ADB::null();
+            const ADB perf_rv = (state.rv.size() > 0) ? subset(state.rv, wellOps().well_cells_plan) : ADB::null();
             const Vector bg = fluid_->bGas(avg_press_ad, perf_temp, perf_rv, perf_cond, well_cells).value();
             b.col(pu.phase_pos[BlackoilPhases::Vapour]) = bg;
         }
@@ -377,13 +379,12 @@ namespace Opm
             b_perfcells.clear();
             return;
         } else {
-            const std::vector<int>& well_cells = wellOps().well_cells;
             const int num_phases = wells().number_of_phases;
             mob_perfcells.resize(num_phases, ADB::null());
             b_perfcells.resize(num_phases, ADB::null());
             for (int phase = 0; phase < num_phases; ++phase) {
-                mob_perfcells[phase] = subset(rq[phase].mob, well_cells);
-                b_perfcells[phase] = subset(rq[phase].b, well_cells);
+                mob_perfcells[phase] = subset(rq[phase].mob, wellOps().well_cells_plan);
+                b_perfcells[phase] = subset(rq[phase].b, wellOps().well_cells_plan);
             }
         }
     }
@@ -408,12 +409,11 @@ namespace Opm
         const int nw = wells().number_of_wells;
         const int nperf = wells().well_connpos[nw];
         Vector Tw = Eigen::Map<const Vector>(wells().WI, nperf);
-        const std::vector<int>& well_cells = wellOps().well_cells;
 
         // pressure diffs computed already (once per step, not changing per iteration)
         const Vector& cdp = wellPerforationPressureDiffs();
         // Extract needed quantities for the perforation cells
-        const ADB& p_perfcells = subset(state.pressure, well_cells);
+        const ADB& p_perfcells = subset(state.pressure, wellOps().well_cells_plan);
 
         // Perforation pressure
         const ADB perfpressure = (wellOps().w2p * state.bhp) + cdp;
@@ -468,8 +468,8 @@ namespace Opm
             const int gaspos = pu.phase_pos[Gas];
             const ADB cq_psOil = cq_ps[oilpos];
             const ADB cq_psGas = cq_ps[gaspos];
-            const ADB& rv_perfcells = subset(state.rv, well_cells);
-            const ADB& rs_perfcells = subset(state.rs, well_cells);
+            const ADB& rv_perfcells = subset(state.rv, wellOps().well_cells_plan);
+            const ADB& rs_perfcells = subset(state.rs, wellOps().well_cells_plan);
             cq_ps[gaspos] += rs_perfcells * cq_psOil;
             cq_ps[oilpos] += rv_perfcells * cq_psGas;
         }
@@ -527,8 +527,8 @@ namespace Opm
 
         if ((*active_)[Oil] && (*active_)[Gas]) {
             // Incorporate RS/RV factors if both oil and gas active
-            const ADB& rv_perfcells = subset(state.rv, well_cells);
-            const ADB& rs_perfcells = subset(state.rs, well_cells);
+            const ADB& rv_perfcells = subset(state.rv, wellOps().well_cells_plan);
+            const ADB& rs_perfcells = subset(state.rs, wellOps().well_cells_plan);
             const ADB d = Vector::Constant(nperf,1.0) - rv_perfcells * rs_perfcells;
 
             const int oilpos = pu.phase_pos[Oil];
@@ -0,0 +1,212 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <opm/autodiff/StartupCache.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Opm
+{
+
+    namespace
+    {
+        const char magic[8] = { 'O', 'P', 'M', 'C', 'A', 'C', 'H', 'E' };
+        const std::uint64_t version = 1;
+
+        const std::uint64_t fnvOffset = 14695981039346656037ULL;
+        const std::uint64_t fnvPrime = 1099511628211ULL;
+
+        // names are padded to keep the arrays aligned
+        std::size_t paddedLength(const std::size_t length)
+        {
+            return (length + 7) / 8 * 8;
+        }
+
+        void writeWord(std::ofstream& file, const std::uint64_t value)
+        {
+            file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+    } // anonymous namespace
+
+
+    StartupCache::StartupCache(const std::string& filename, const std::uint64_t key)
+        : data_(nullptr)
+        , size_(0)
+        , key_(key)
+        , valid_(false)
+    {
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat status;
+        if (::fstat(fd, &status) == 0 && status.st_size > 0) {
+            void* mapped = ::mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data_ = static_cast<const char*>(mapped);
+                size_ = status.st_size;
+            }
+        }
+        ::close(fd);
+
+        valid_ = data_ && parse();
+        if (!valid_) {
+            arrays_.clear();
+        }
+    }
+
+
+    StartupCache::~StartupCache()
+    {
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+
+    bool StartupCache::has(const std::string& name) const
+    {
+        return arrays_.find(name) != arrays_.end();
+    }
+
+
+    StartupCache::ArrayView StartupCache::array(const std::string& name) const
+    {
+        const auto it = arrays_.find(name);
+        if (it == arrays_.end()) {
+            return ArrayView{ nullptr, 0 };
+        }
+        return it->second;
+    }
+
+
+    bool StartupCache::parse()
+    {
+        std::size_t pos = 0;
+        auto readWord = [this, &pos](std::uint64_t& value) {
+            if (size_ - pos < sizeof(value)) {
+                return false;
+            }
+            std::memcpy(&value, data_ + pos, sizeof(value));
+            pos += sizeof(value);
+            return true;
+        };
+
+        if (size_ < sizeof(magic) || std::memcmp(data_, magic, sizeof(magic)) != 0) {
+            return false;
+        }
+        pos = sizeof(magic);
+
+        std::uint64_t fileVersion, fileKey, count;
+        if (!readWord(fileVersion) || fileVersion != version ||
+            !readWord(fileKey) || fileKey != key_ ||
+            !readWord(count)) {
+            return false;
+        }
+
+        for (std::uint64_t a = 0; a < count; ++a) {
+            std::uint64_t nameLength, arraySize;
+            if (!readWord(nameLength) || !readWord(arraySize)) {
+                return false;
+            }
+            const std::size_t padded = paddedLength(nameLength);
+            if (size_ - pos < padded) {
+                return false;
+            }
+            const std::string name(data_ + pos, nameLength);
+            pos += padded;
+
+            if ((size_ - pos) / sizeof(double) < arraySize) {
+                return false;
+            }
+            arrays_[name] = ArrayView{ reinterpret_cast<const double*>(data_ + pos), arraySize };
+            pos += arraySize * sizeof(double);
+        }
+        return true;
+    }
+
+
+    void StartupCache::write(const std::string& filename, const std::uint64_t key, const Arrays& arrays)
+    {
+        std::ofstream file(filename.c_str(), std::ios::binary);
+        if (!file) {
+            OPM_THROW(std::runtime_error, "Could not open startup cache file " << filename);
+        }
+
+        file.write(magic, sizeof(magic));
+        writeWord(file, version);
+        writeWord(file, key);
+        writeWord(file, arrays.size());
+
+        const char padding[8] = { 0 };
+        for (const auto& array : arrays) {
+            const std::string& name = array.first;
+            writeWord(file, name.size());
+            writeWord(file, array.second.size());
+            file.write(name.data(), name.size());
+            file.write(padding, paddedLength(name.size()) - name.size());
+            file.write(reinterpret_cast<const char*>(array.second.data()),
+                       array.second.size() * sizeof(double));
+        }
+
+        if (!file) {
+            OPM_THROW(std::runtime_error, "Could not write startup cache file " << filename);
+        }
+    }
+
+
+    std::uint64_t StartupCache::hashFile(const std::string& filename, const std::uint64_t seed)
+    {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        if (!file) {
+            return seed;
+        }
+
+        std::uint64_t hash = fnvOffset ^ seed;
+        char buffer[ 1 << 16 ];
+        while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+            const std::streamsize count = file.gcount();
+            for (std::streamsize i = 0; i < count; ++i) {
+                hash ^= static_cast<unsigned char>(buffer[i]);
+                hash *= fnvPrime;
+            }
+        }
+        return hash;
+    }
+
+
+    std::uint64_t StartupCache::hashCombine(const std::uint64_t hash, const std::uint64_t value)
+    {
+        std::uint64_t result = hash;
+        for (int byte = 0; byte < 8; ++byte) {
+            result ^= (value >> (8*byte)) & 0xff;
+            result *= fnvPrime;
+        }
+        return result;
+    }
+
+} // namespace Opm
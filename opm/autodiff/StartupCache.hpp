@@ -0,0 +1,98 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_STARTUPCACHE_HEADER_INCLUDED
+#define OPM_STARTUPCACHE_HEADER_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    /// A binary file holding named arrays derived from a deck, such as
+    /// the transmissibilities and non-neighbouring connections written to
+    /// the INIT file, which lets later runs of the same deck skip their
+    /// computation.
+    ///
+    /// The cache is tagged with a key, typically the hash of the deck
+    /// (see hashFile()), and is ignored if the key does not match. The
+    /// file is memory mapped when read, the arrays are not copied until
+    /// they are used. The data is stored in the native byte order, a
+    /// cache is not meant to be moved between machines.
+    class StartupCache
+    {
+    public:
+        typedef std::map<std::string, std::vector<double> > Arrays;
+
+        /// A read-only view of an array in the cache.
+        struct ArrayView
+        {
+            const double* data;
+            std::size_t size;
+
+            const double* begin() const { return data; }
+            const double* end() const { return data + size; }
+        };
+
+        /// Open and map a cache file. If the file does not exist, is
+        /// corrupt or has been written with another key the cache is not
+        /// valid.
+        StartupCache(const std::string& filename, const std::uint64_t key);
+
+        ~StartupCache();
+
+        StartupCache(const StartupCache&) = delete;
+        StartupCache& operator=(const StartupCache&) = delete;
+
+        /// True if the file could be read and matches the key.
+        bool valid() const { return valid_; }
+
+        /// True if the cache holds an array of the given name.
+        bool has(const std::string& name) const;
+
+        /// The array of the given name, empty if it is not in the cache.
+        ArrayView array(const std::string& name) const;
+
+        /// Write all arrays to a cache file, tagged with the key.
+        static void write(const std::string& filename, const std::uint64_t key, const Arrays& arrays);
+
+        /// 64 bit FNV-1a hash of the contents of a file, combined with
+        /// the given seed. Returns the seed if the file cannot be read.
+        static std::uint64_t hashFile(const std::string& filename, const std::uint64_t seed = 0);
+
+        /// Combine a hash with an integer value.
+        static std::uint64_t hashCombine(const std::uint64_t hash, const std::uint64_t value);
+
+    private:
+        bool parse();
+
+        const char* data_;
+        std::size_t size_;
+        std::uint64_t key_;
+        bool valid_;
+        std::map<std::string, ArrayView> arrays_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_STARTUPCACHE_HEADER_INCLUDED
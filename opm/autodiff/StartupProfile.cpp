@@ -0,0 +1,80 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include <opm/autodiff/StartupProfile.hpp>
+#include <opm/autodiff/MemoryTracker.hpp>
+#include <opm/autodiff/PerformanceSummary.hpp>
+
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+namespace Opm
+{
+
+    namespace
+    {
+        double wallTime()
+        {
+            const auto now = std::chrono::steady_clock::now().time_since_epoch();
+            return std::chrono::duration<double>(now).count();
+        }
+    } // anonymous namespace
+
+
+    StartupProfile::StartupProfile()
+        : start_(wallTime())
+    {
+    }
+
+
+    void StartupProfile::endStep(const std::string& name)
+    {
+        const double now = wallTime();
+        names_.push_back(name);
+        values_.push_back(now - start_);
+        values_.push_back(MemoryTracker::residentSetSize());
+        values_.push_back(PerformanceSummary::peakResidentSetSize());
+        start_ = now;
+    }
+
+
+    std::string StartupProfile::format(const std::vector<double>& values, const int numProcesses) const
+    {
+        std::ostringstream os;
+        os << "Startup steps, maxima over " << numProcesses << " processes:\n";
+        os << std::left << std::setw(36) << "step" << std::right
+           << std::setw(12) << "time (s)" << std::setw(12) << "rss (MB)" << std::setw(12) << "hwm (MB)" << "\n";
+        os << std::fixed;
+        double total = 0.0;
+        for (int i = 0; i < numSteps(); ++i) {
+            const double* v = values.data() + i * NumValues;
+            total += v[Time];
+            os << std::left << std::setw(36) << names_[i] << std::right
+               << std::setprecision(3) << std::setw(12) << v[Time]
+               << std::setprecision(1) << std::setw(12) << v[Resident] / 1024.0
+               << std::setw(12) << v[HighWaterMark] / 1024.0 << "\n";
+        }
+        os << std::left << std::setw(36) << "total" << std::right
+           << std::setprecision(3) << std::setw(12) << total << "\n";
+        return os.str();
+    }
+
+} // namespace Opm
@@ -0,0 +1,86 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_STARTUPPROFILE_HEADER_INCLUDED
+#define OPM_STARTUPPROFILE_HEADER_INCLUDED
+
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Records the wall time, the resident set size and its high-water mark
+    /// at the end of each step of the startup of a simulator, for the dry
+    /// run of flow_ebos that stops before the first time step.
+    ///
+    /// The steps are recorded in the same order on all processes, the
+    /// report holds the maxima over the processes.
+    class StartupProfile
+    {
+    public:
+        /// The values of a step.
+        enum Value {
+            Time = 0,
+            Resident,
+            HighWaterMark,
+            NumValues
+        };
+
+        /// Start the first step.
+        StartupProfile();
+
+        /// End a step and start the next one.
+        void endStep(const std::string& name);
+
+        /// The number of steps ended so far.
+        int numSteps() const { return names_.size(); }
+
+        /// The name of step i.
+        const std::string& name(const int i) const { return names_[i]; }
+
+        /// The value of step i, the time in seconds and the memory in kB.
+        double value(const int i, const Value v) const { return values_[i * NumValues + v]; }
+
+        /// Take the maximum of the values over the processes of comm and
+        /// return the report, collective over the processes.
+        template <class Communication>
+        std::string report(const Communication& comm) const
+        {
+            std::vector<double> values = values_;
+            if (!values.empty()) {
+                comm.max(values.data(), values.size());
+            }
+            return format(values, comm.size());
+        }
+
+        /// The table of the steps and the total time.
+        /// \param[in] values        NumValues per step, as given by value()
+        /// \param[in] numProcesses  the number of processes of the values
+        std::string format(const std::vector<double>& values, const int numProcesses) const;
+
+    private:
+        double start_;
+        std::vector<std::string> names_;
+        std::vector<double> values_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_STARTUPPROFILE_HEADER_INCLUDED
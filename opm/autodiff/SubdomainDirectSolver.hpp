@@ -0,0 +1,238 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_SUBDOMAINDIRECTSOLVER_HEADER_INCLUDED
+#define OPM_SUBDOMAINDIRECTSOLVER_HEADER_INCLUDED
+
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <dune/common/unused.hh>
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/solvercategory.hh>
+#if HAVE_UMFPACK
+#include <dune/istl/umfpack.hh>
+#elif HAVE_SUPERLU
+#include <dune/istl/superlu.hh>
+#endif
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace Opm
+{
+
+    /// \brief A preconditioner solving with a sparse LU factorization of its
+    ///        matrix, computed by UMFPack or SuperLU.
+    ///
+    /// Wrapped in ParallelRestrictedOverlappingSchwarz this gives a restricted
+    /// additive Schwarz method with exact solves on the overlapping subdomain
+    /// of each process. The factorization may be kept while the matrix
+    /// changes, the solves are then approximate.
+    ///
+    /// With UMFPack the symbolic analysis (ordering and elimination tree) is
+    /// kept by update() for a matrix with the same sparsity pattern, only the
+    /// numeric factorization is redone. With SuperLU update() factorizes from
+    /// scratch.
+    /// \tparam M The matrix type.
+    /// \tparam X The domain type.
+    /// \tparam Y The range type.
+    template <class M, class X, class Y>
+    class SubdomainDirectSolver
+        : public Dune::Preconditioner<X,Y>
+    {
+#if HAVE_SUPERLU && ! HAVE_UMFPACK
+        typedef Dune::SuperLU<M> DirectSolver;
+#endif
+        typedef typename M::block_type Block;
+        enum { rowsPerBlock = Block::rows, colsPerBlock = Block::cols };
+
+    public:
+        //! \brief The matrix type the preconditioner is for.
+        typedef M matrix_type;
+        //! \brief The domain type of the preconditioner.
+        typedef X domain_type;
+        //! \brief The range type of the preconditioner.
+        typedef Y range_type;
+        //! \brief The field type of the preconditioner.
+        typedef typename X::field_type field_type;
+
+        // define the category
+        enum {
+            //! \brief The category the preconditioner is part of.
+            category = Dune::SolverCategory::sequential
+        };
+
+        /// \brief Constructor, factorizes A.
+        explicit SubdomainDirectSolver( const M& A )
+            : size_( A.N() ),
+              rhs_( A.N() )
+        {
+#if HAVE_UMFPACK
+            umfpack_di_defaults( control_ );
+            factorize( A, false );
+#elif HAVE_SUPERLU
+            solver_.reset( new DirectSolver( A, 0, false ) );
+#else
+            OPM_THROW(std::runtime_error, "The direct subdomain solver needs UMFPack or SuperLU");
+#endif
+        }
+
+        // the factorization is owned by the preconditioner
+        SubdomainDirectSolver( const SubdomainDirectSolver& ) = delete;
+        SubdomainDirectSolver& operator= ( const SubdomainDirectSolver& ) = delete;
+
+        virtual ~SubdomainDirectSolver()
+        {
+#if HAVE_UMFPACK
+            umfpack_di_free_numeric( &numeric_ );
+            umfpack_di_free_symbolic( &symbolic_ );
+#endif
+        }
+
+        /// \brief Factorize A, keeping the symbolic analysis of the previous
+        ///        matrix if A has the same sparsity pattern.
+        void update( const M& A )
+        {
+            size_ = A.N();
+            rhs_.resize( A.N() );
+#if HAVE_UMFPACK
+            factorize( A, true );
+#elif HAVE_SUPERLU
+            solver_.reset( new DirectSolver( A, 0, false ) );
+#endif
+        }
+
+        virtual void pre (X& x, Y& b)
+        {
+            DUNE_UNUSED_PARAMETER(x);
+            DUNE_UNUSED_PARAMETER(b);
+        }
+
+        virtual void apply (X& v, const Y& d)
+        {
+#if HAVE_UMFPACK
+            if( size_ == 0 ) {
+                return;
+            }
+            // the transpose of the stored matrix was factorized
+            const int status = umfpack_di_solve( UMFPACK_At, rowStart_.data(), columns_.data(), values_.data(),
+                                                 &v[0][0], &d[0][0], numeric_, control_, info_ );
+            if( status != UMFPACK_OK ) {
+                OPM_THROW(LinearSolverProblem, "UMFPack solve failed with status " << status);
+            }
+#elif HAVE_SUPERLU
+            // the direct solvers may overwrite the right hand side
+            rhs_ = d;
+            Dune::InverseOperatorResult result;
+            solver_->apply( v, rhs_, result );
+#else
+            DUNE_UNUSED_PARAMETER(v);
+            DUNE_UNUSED_PARAMETER(d);
+#endif
+        }
+
+        /// \brief The solve is exact, the direction is irrelevant.
+        template <bool forward>
+        void apply (X& v, const Y& d)
+        {
+            apply( v, d );
+        }
+
+        virtual void post (X& x)
+        {
+            DUNE_UNUSED_PARAMETER(x);
+        }
+
+        /// \brief The number of rows of the factorized matrix.
+        std::size_t size() const { return size_; }
+
+    protected:
+#if HAVE_UMFPACK
+        /// \brief Store A as scalar compressed rows, i.e. its transpose in the
+        ///        compressed columns of UMFPack, and factorize it. The symbolic
+        ///        analysis is kept if keepSymbolic is set and the pattern is
+        ///        that of the previous matrix.
+        void factorize( const M& A, const bool keepSymbolic )
+        {
+            const int n = A.N() * rowsPerBlock;
+            if( n == 0 ) {
+                return;
+            }
+            std::vector<int> rowStart;
+            std::vector<int> columns;
+            rowStart.reserve( n + 1 );
+            columns.reserve( A.nonzeroes() * rowsPerBlock * colsPerBlock );
+            values_.clear();
+            values_.reserve( A.nonzeroes() * rowsPerBlock * colsPerBlock );
+            rowStart.push_back( 0 );
+            const auto endi = A.end();
+            for( auto row = A.begin(); row != endi; ++row ) {
+                for( int r = 0; r < rowsPerBlock; ++r ) {
+                    const auto endj = row->end();
+                    for( auto col = row->begin(); col != endj; ++col ) {
+                        for( int c = 0; c < colsPerBlock; ++c ) {
+                            columns.push_back( col.index() * colsPerBlock + c );
+                            values_.push_back( (*col)[r][c] );
+                        }
+                    }
+                    rowStart.push_back( columns.size() );
+                }
+            }
+
+            umfpack_di_free_numeric( &numeric_ );
+            const bool samePattern = keepSymbolic && symbolic_ && rowStart == rowStart_ && columns == columns_;
+            if( ! samePattern ) {
+                umfpack_di_free_symbolic( &symbolic_ );
+                rowStart_.swap( rowStart );
+                columns_.swap( columns );
+                const int status = umfpack_di_symbolic( n, n, rowStart_.data(), columns_.data(), values_.data(),
+                                                        &symbolic_, control_, info_ );
+                if( status != UMFPACK_OK ) {
+                    OPM_THROW(LinearSolverProblem, "UMFPack symbolic analysis failed with status " << status);
+                }
+            }
+            const int status = umfpack_di_numeric( rowStart_.data(), columns_.data(), values_.data(),
+                                                   symbolic_, &numeric_, control_, info_ );
+            if( status != UMFPACK_OK ) {
+                OPM_THROW(LinearSolverProblem, "UMFPack factorization failed with status " << status);
+            }
+        }
+
+        std::vector<int> rowStart_;
+        std::vector<int> columns_;
+        std::vector<double> values_;
+        void* symbolic_ = nullptr;
+        void* numeric_ = nullptr;
+        double control_[UMFPACK_CONTROL];
+        double info_[UMFPACK_INFO];
+#elif HAVE_SUPERLU
+        std::unique_ptr< DirectSolver > solver_;
+#endif
+        std::size_t size_;
+        Y rhs_;
+    };
+
+} // end namespace Opm
+
+#endif // OPM_SUBDOMAINDIRECTSOLVER_HEADER_INCLUDED
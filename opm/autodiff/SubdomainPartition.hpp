@@ -0,0 +1,159 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_SUBDOMAINPARTITION_HEADER_INCLUDED
+#define OPM_SUBDOMAINPARTITION_HEADER_INCLUDED
+
+#include <opm/autodiff/MatrixOrdering.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace Opm
+{
+
+    /// A partition of the rows of a structurally symmetric sparse matrix
+    /// into disjoint subdomains of about equal size. The subdomains are
+    /// consecutive pieces of the reverse Cuthill-McKee ordering, i.e. bands
+    /// of breadth first level sets, which keeps them compact on the grids
+    /// of reservoir models.
+    ///
+    /// The matrices of the subdomains couple the rows of a subdomain only,
+    /// the couplings to the other subdomains are dropped, i.e. the other
+    /// rows are kept fixed in a solve with them.
+    class SubdomainPartition
+    {
+    public:
+        /// Partition the rows of A into numDomains subdomains, at most one
+        /// per row.
+        template <class M>
+        SubdomainPartition(const M& A, const int numDomains)
+            : domain_(A.N()),
+              localIndex_(A.N())
+        {
+            std::vector<std::size_t> perm;
+            reverseCuthillMcKee(A, perm);
+            const std::size_t n = perm.size();
+            const std::size_t domains = std::max<std::size_t>(1, std::min<std::size_t>(numDomains, n));
+            rows_.resize(n > 0 ? domains : 0);
+            for (std::size_t i = 0; i < n; ++i) {
+                const int d = i * domains / n;
+                domain_[perm[i]] = d;
+            }
+            // the rows of a subdomain in increasing order
+            for (std::size_t row = 0; row < n; ++row) {
+                std::vector<int>& rows = rows_[domain_[row]];
+                localIndex_[row] = rows.size();
+                rows.push_back(row);
+            }
+        }
+
+        /// The number of subdomains.
+        int numDomains() const { return rows_.size(); }
+
+        /// The number of rows of the partitioned matrix.
+        std::size_t numRows() const { return domain_.size(); }
+
+        /// The subdomain of a row.
+        int domain(const int row) const { return domain_[row]; }
+
+        /// The rows of a subdomain, in increasing order.
+        const std::vector<int>& rows(const int d) const { return rows_[d]; }
+
+        /// Create the matrix of the subdomain d from A, which has the
+        /// sparsity pattern of the partitioned matrix. local must be a
+        /// default constructed Dune::BCRSMatrix.
+        template <class M>
+        void createMatrix(const M& A, const int d, M& local) const
+        {
+            const std::vector<int>& rows = rows_[d];
+            std::size_t nonzeroes = 0;
+            for (const int row : rows) {
+                const auto& cols = A[row];
+                for (auto col = cols.begin(); col != cols.end(); ++col) {
+                    nonzeroes += domain_[col.index()] == d;
+                }
+            }
+            local.setBuildMode(M::row_wise);
+            local.setSize(rows.size(), rows.size(), nonzeroes);
+            for (auto row = local.createbegin(); row != local.createend(); ++row) {
+                const auto& cols = A[rows[row.index()]];
+                for (auto col = cols.begin(); col != cols.end(); ++col) {
+                    if (domain_[col.index()] == d) {
+                        row.insert(localIndex_[col.index()]);
+                    }
+                }
+            }
+            copyMatrixValues(A, d, local);
+        }
+
+        /// Copy the values of A into the matrix of subdomain d previously
+        /// created by createMatrix.
+        template <class M>
+        void copyMatrixValues(const M& A, const int d, M& local) const
+        {
+            const std::vector<int>& rows = rows_[d];
+            assert(local.N() == rows.size());
+            for (std::size_t i = 0; i < rows.size(); ++i) {
+                auto& localRow = local[i];
+                const auto& cols = A[rows[i]];
+                for (auto col = cols.begin(); col != cols.end(); ++col) {
+                    if (domain_[col.index()] == d) {
+                        localRow[localIndex_[col.index()]] = *col;
+                    }
+                }
+            }
+        }
+
+        /// Copy the entries of the rows of subdomain d of the global vector
+        /// into the local vector.
+        template <class V>
+        void restrictVector(const V& global, const int d, V& local) const
+        {
+            const std::vector<int>& rows = rows_[d];
+            local.resize(rows.size());
+            for (std::size_t i = 0; i < rows.size(); ++i) {
+                local[i] = global[rows[i]];
+            }
+        }
+
+        /// Copy the local vector of subdomain d into its rows of the global
+        /// vector, the other rows are left unchanged.
+        template <class V>
+        void prolongateVector(const V& local, const int d, V& global) const
+        {
+            const std::vector<int>& rows = rows_[d];
+            assert(local.size() == rows.size());
+            for (std::size_t i = 0; i < rows.size(); ++i) {
+                global[rows[i]] = local[i];
+            }
+        }
+
+    private:
+        std::vector<int> domain_;
+        // the index of a row within its subdomain
+        std::vector<int> localIndex_;
+        std::vector<std::vector<int>> rows_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_SUBDOMAINPARTITION_HEADER_INCLUDED
@@ -0,0 +1,87 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_SUMANDMAXREDUCTION_HEADER_INCLUDED
+#define OPM_SUMANDMAXREDUCTION_HEADER_INCLUDED
+
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+namespace Opm
+{
+
+#if HAVE_MPI
+    namespace detail
+    {
+        /// MPI operation on buffers of doubles, where the first entry holds
+        /// the number n of summed entries, identical on all processes. The
+        /// next n entries are summed, the maximum of the remaining ones is
+        /// taken. The whole buffer is a single element of the datatype, so
+        /// that MPI never splits it.
+        inline void sumAndMaxOperation(void* invec, void* inoutvec, int* len, MPI_Datatype* datatype)
+        {
+            int bytes = 0;
+            MPI_Type_size(*datatype, &bytes);
+            const int size = bytes / sizeof(double);
+            const double* in = static_cast<const double*>(invec);
+            double* inout = static_cast<double*>(inoutvec);
+            for (int element = 0; element < *len; ++element, in += size, inout += size) {
+                const int numSums = static_cast<int>(in[0]);
+                for (int i = 1; i <= numSums; ++i) {
+                    inout[i] += in[i];
+                }
+                for (int i = numSums + 1; i < size; ++i) {
+                    inout[i] = std::max(inout[i], in[i]);
+                }
+            }
+        }
+    } // namespace detail
+
+    /// Replace the values of sums by their sums and the values of maxima by
+    /// their maxima over all processes of comm, with a single collective
+    /// call instead of one for the sums and one for the maxima.
+    inline void sumAndMaxAllReduce(MPI_Comm comm, std::vector<double>& sums, std::vector<double>& maxima)
+    {
+        std::vector<double> buffer;
+        buffer.reserve(1 + sums.size() + maxima.size());
+        buffer.push_back(sums.size());
+        buffer.insert(buffer.end(), sums.begin(), sums.end());
+        buffer.insert(buffer.end(), maxima.begin(), maxima.end());
+
+        MPI_Datatype type;
+        MPI_Type_contiguous(buffer.size(), MPI_DOUBLE, &type);
+        MPI_Type_commit(&type);
+        MPI_Op op;
+        MPI_Op_create(&detail::sumAndMaxOperation, /*commute=*/1, &op);
+        MPI_Allreduce(MPI_IN_PLACE, buffer.data(), 1, type, op, comm);
+        MPI_Op_free(&op);
+        MPI_Type_free(&type);
+
+        std::copy(buffer.begin() + 1, buffer.begin() + 1 + sums.size(), sums.begin());
+        std::copy(buffer.begin() + 1 + sums.size(), buffer.end(), maxima.begin());
+    }
+#endif
+
+} // namespace Opm
+
+#endif // OPM_SUMANDMAXREDUCTION_HEADER_INCLUDED
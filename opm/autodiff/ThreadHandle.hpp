@@ -2,15 +2,28 @@
 #define OPM_THREADHANDLE_HPP
 
 #include <cassert>
-#include <dune/common/exceptions.hh>
+#include <opm/common/ErrorMacros.hpp>
 
-#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 namespace Opm
 {
 
+  //! A small pool of threads executing dispatched objects in the background.
+  //!
+  //! Every object is dispatched to a channel. Objects of the same channel
+  //! are executed one after the other in the order of dispatch, objects of
+  //! different channels may be executed in parallel. The queue of waiting
+  //! objects can be bounded, dispatch then blocks until an object has been
+  //! taken from the queue. Exceptions thrown by an object are rethrown by
+  //! the next call to dispatch or wait.
   class ThreadHandle
   {
   public:
@@ -34,92 +47,155 @@ namespace Opm
     };
 
   protected:
-    class EndObject : public ObjectInterface
-    {
-    public:
-      void run () { }
-      bool isEndMarker () const { return true; }
-    };
-
     ////////////////////////////////////////////
     // class ThreadHandleQueue
     ////////////////////////////////////////////
     class ThreadHandleQueue
     {
     protected:
-      std::queue< std::unique_ptr< ObjectInterface > > objQueue_;
-      std::mutex  mutex_;
+      struct Task
+      {
+        std::unique_ptr< ObjectInterface > obj;
+        int channel;
+      };
+
+      std::deque< Task > objQueue_;
+      std::vector< int > busyChannels_;
+      std::mutex mutex_;
+      std::condition_variable taskAvailable_;
+      std::condition_variable taskDone_;
+      const std::size_t maxQueueSize_;
+      int running_;
+      bool stop_;
+      std::exception_ptr error_;
 
       // no copying
       ThreadHandleQueue( const ThreadHandleQueue& ) = delete;
 
-      // wait duration of 10 milli seconds
-      void wait() const
+      bool isBusy( const int channel ) const
       {
-          std::this_thread::sleep_for( std::chrono::milliseconds(10) );
+        for( const int busy : busyChannels_ ) {
+          if( busy == channel ) {
+            return true;
+          }
+        }
+        return false;
       }
 
-    public:
-      //! constructor creating object that is executed by thread
-      ThreadHandleQueue()
-        : objQueue_(), mutex_()
+      // first queued object whose channel is not being executed, objects
+      // of one channel are thereby taken in the order of dispatch
+      std::deque< Task >::iterator nextTask()
       {
+        auto task = objQueue_.begin();
+        while( task != objQueue_.end() && isBusy( task->channel ) ) {
+          ++task;
+        }
+        return task;
       }
 
-      ~ThreadHandleQueue()
+      void rethrowError( std::unique_lock< std::mutex >& lock )
       {
-        // wait until all objects have been written.
-        while( ! objQueue_.empty() )
-        {
-            wait();
+        if( error_ ) {
+          std::exception_ptr error = error_;
+          error_ = nullptr;
+          lock.unlock();
+          std::rethrow_exception( error );
         }
       }
 
-      //! insert object into threads queue
-      void push_back( std::unique_ptr< ObjectInterface >&& obj )
+    public:
+      //! constructor creating queue with at most maxQueueSize waiting objects (0 means unbounded)
+      explicit ThreadHandleQueue( const std::size_t maxQueueSize )
+        : objQueue_(), busyChannels_(), mutex_(),
+          maxQueueSize_( maxQueueSize ),
+          running_( 0 ),
+          stop_( false ),
+          error_()
+      {
+      }
+
+      //! insert object into the queue, waits while the queue is full
+      void push_back( std::unique_ptr< ObjectInterface >&& obj, const int channel )
       {
-        // lock mutex to make sure objPtr is not used
-        mutex_.lock();
-        objQueue_.emplace( std::move(obj) );
-        mutex_.unlock();
+        std::unique_lock< std::mutex > lock( mutex_ );
+        rethrowError( lock );
+        taskDone_.wait( lock, [this] {
+            return maxQueueSize_ == 0 || objQueue_.size() < maxQueueSize_;
+          } );
+        objQueue_.push_back( Task{ std::move( obj ), channel } );
+        lock.unlock();
+        taskAvailable_.notify_one();
       }
 
-      //! do the work until the queue received an end object
-      void run()
+      //! wait until all objects in the queue have been executed
+      void wait()
+      {
+        std::unique_lock< std::mutex > lock( mutex_ );
+        taskDone_.wait( lock, [this] { return objQueue_.empty() && running_ == 0; } );
+        rethrowError( lock );
+      }
+
+      //! let the threads terminate once the queue is empty
+      void stop()
       {
-        // wait until objects have been pushed to the queue
-        while( objQueue_.empty() )
         {
-          // sleep one second
-          wait();
+          std::lock_guard< std::mutex > lock( mutex_ );
+          stop_ = true;
         }
+        taskAvailable_.notify_all();
+      }
 
+      //! do the work until the queue is stopped and empty
+      void run()
+      {
+        std::unique_lock< std::mutex > lock( mutex_ );
+        while( true )
         {
-            // lock mutex for access to objQueue_
-            mutex_.lock();
-
-            // get next object from queue
-            std::unique_ptr< ObjectInterface > obj( objQueue_.front().release() );
-            // remove object from queue
-            objQueue_.pop();
-
-            // unlock mutex for access to objQueue_
-            mutex_.unlock();
-
-            // if object is end marker terminate thread
-            if( obj->isEndMarker() ){
-                if( ! objQueue_.empty() ) {
-                    OPM_THROW(std::logic_error,"ThreadHandleQueue: not all queued objects were executed");
-                }
-                return;
+          auto task = nextTask();
+          if( task == objQueue_.end() )
+          {
+            if( stop_ && objQueue_.empty() ) {
+              return;
             }
+            taskAvailable_.wait( lock );
+            continue;
+          }
 
-            // execute object action
+          // take the object from the queue and mark its channel busy
+          std::unique_ptr< ObjectInterface > obj( std::move( task->obj ) );
+          const int channel = task->channel;
+          objQueue_.erase( task );
+          busyChannels_.push_back( channel );
+          ++running_;
+          lock.unlock();
+          // a slot in the queue has been freed
+          taskDone_.notify_all();
+
+          // execute object action
+          std::exception_ptr error;
+          try {
             obj->run();
-        }
+          }
+          catch( ... ) {
+            error = std::current_exception();
+          }
+          obj.reset();
 
-        // keep thread running
-        run();
+          lock.lock();
+          --running_;
+          for( auto busy = busyChannels_.begin(); busy != busyChannels_.end(); ++busy ) {
+            if( *busy == channel ) {
+              busyChannels_.erase( busy );
+              break;
+            }
+          }
+          if( error && ! error_ ) {
+            error_ = error;
+          }
+          // objects of this channel may be executed now
+          taskAvailable_.notify_all();
+          taskDone_.notify_all();
+        }
       }
     }; // end ThreadHandleQueue
 
@@ -134,7 +210,7 @@ namespace Opm
     }
 
     ThreadHandleQueue threadObjectQueue_;
-    std::unique_ptr< std::thread > thread_;
+    std::vector< std::thread > threads_;
 
   private:
     // prohibit copying
@@ -142,30 +218,37 @@ namespace Opm
 
   public:
     //! constructor creating ThreadHandle
-    //! \param isIORank  if true thread is created
-    ThreadHandle( const bool createThread )
-      : threadObjectQueue_(),
-        thread_()
+    //! \param createThread  if true the threads are created (i.e. on the I/O rank)
+    //! \param numThreads    number of threads executing the objects
+    //! \param maxQueueSize  maximal number of waiting objects, 0 means unbounded
+    explicit ThreadHandle( const bool createThread,
+                           const int numThreads = 1,
+                           const std::size_t maxQueueSize = 0 )
+      : threadObjectQueue_( maxQueueSize ),
+        threads_()
     {
         if( createThread )
         {
-           thread_.reset( new std::thread( startThread, &threadObjectQueue_ ) );
-           // detach thread into nirvana
-           thread_->detach();
+           const int n = numThreads > 0 ? numThreads : 1;
+           threads_.reserve( n );
+           for( int i = 0; i < n; ++i ) {
+               threads_.emplace_back( startThread, &threadObjectQueue_ );
+           }
         }
     } // end constructor
 
-    //! dispatch object to queue of separate thread
+    //! dispatch object to the queue of the threads, objects of one channel
+    //! are executed in the order of dispatch
     template <class Object>
-    void dispatch( Object&& obj )
+    void dispatch( Object&& obj, const int channel = 0 )
     {
-        if( thread_ )
+        if( ! threads_.empty() )
         {
             typedef ObjectWrapper< Object >  ObjectPointer;
             ObjectInterface* objPtr = new ObjectPointer( std::move(obj) );
 
             // add object to queue of objects
-            threadObjectQueue_.push_back( std::unique_ptr< ObjectInterface > (objPtr) );
+            threadObjectQueue_.push_back( std::unique_ptr< ObjectInterface > (objPtr), channel );
         }
         else
         {
@@ -173,13 +256,23 @@ namespace Opm
         }
     }
 
-    //! destructor terminating the thread
+    //! wait until all dispatched objects have been executed
+    void wait()
+    {
+        if( ! threads_.empty() ) {
+            threadObjectQueue_.wait();
+        }
+    }
+
+    //! number of threads executing the objects
+    int numThreads() const { return threads_.size(); }
+
+    //! destructor executing the remaining objects and terminating the threads
     ~ThreadHandle()
     {
-        if( thread_ )
-        {
-            // dispatch end object which will terminate the thread
-            threadObjectQueue_.push_back( std::unique_ptr< ObjectInterface > (new EndObject()) ) ;
+        threadObjectQueue_.stop();
+        for( auto& thread : threads_ ) {
+            thread.join();
         }
     }
   };
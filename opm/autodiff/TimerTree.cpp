@@ -0,0 +1,207 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <opm/autodiff/TimerTree.hpp>
+
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace Opm
+{
+
+    struct TimerTree::Node
+    {
+        Node(const char* nodeName, Node* parentNode)
+            : name(nodeName)
+            , parent(parentNode)
+            , seconds(0.0)
+            , calls(0)
+        {
+        }
+
+        std::string name;
+        Node* parent;
+        double seconds;
+        long calls;
+        std::vector< std::unique_ptr<Node> > children;
+    };
+
+    bool TimerTree::enabled_ = false;
+
+    namespace
+    {
+        // The regions of one thread and the innermost open one.
+        struct ThreadTree
+        {
+            ThreadTree()
+                : root("", nullptr)
+                , current(&root)
+            {
+            }
+
+            TimerTree::Node root;
+            TimerTree::Node* current;
+        };
+
+        // the trees of all threads that opened a region, kept until the end
+        // of the run
+        std::mutex treesMutex;
+        std::vector< std::unique_ptr<ThreadTree> > trees;
+        thread_local ThreadTree* threadTree = nullptr;
+
+        ThreadTree& localTree()
+        {
+            if (!threadTree) {
+                std::lock_guard<std::mutex> lock(treesMutex);
+                trees.emplace_back(new ThreadTree);
+                threadTree = trees.back().get();
+            }
+            return *threadTree;
+        }
+
+        void collect(const TimerTree::Node& node, const std::string& path,
+                     std::vector<std::string>& paths,
+                     std::vector<double>& seconds,
+                     std::vector<double>& calls)
+        {
+            for (const auto& child : node.children) {
+                const std::string childPath = path.empty() ? child->name : path + '\t' + child->name;
+                const int n = paths.size();
+                const int k = TimerTree::insertRegion(paths, childPath);
+                if (int(paths.size()) > n) {
+                    seconds.insert(seconds.begin() + k, 0.0);
+                    calls.insert(calls.begin() + k, 0.0);
+                }
+                seconds[k] += child->seconds;
+                calls[k] += child->calls;
+                collect(*child, childPath, paths, seconds, calls);
+            }
+        }
+    } // anonymous namespace
+
+
+    TimerTree::Node* TimerTree::enter(const char* name)
+    {
+        ThreadTree& tree = localTree();
+        Node* parent = tree.current;
+        for (const auto& child : parent->children) {
+            if (child->name == name) {
+                tree.current = child.get();
+                return tree.current;
+            }
+        }
+        parent->children.emplace_back(new Node(name, parent));
+        tree.current = parent->children.back().get();
+        return tree.current;
+    }
+
+
+    void TimerTree::leave(Node* node, const double seconds)
+    {
+        node->seconds += seconds;
+        ++node->calls;
+        localTree().current = node->parent;
+    }
+
+
+    void TimerTree::reset()
+    {
+        std::lock_guard<std::mutex> lock(treesMutex);
+        for (const auto& tree : trees) {
+            tree->root.children.clear();
+            tree->current = &tree->root;
+        }
+    }
+
+
+    void TimerTree::localRegions(std::vector<std::string>& paths,
+                                 std::vector<double>& seconds,
+                                 std::vector<double>& calls)
+    {
+        paths.clear();
+        seconds.clear();
+        calls.clear();
+        std::lock_guard<std::mutex> lock(treesMutex);
+        for (const auto& tree : trees) {
+            collect(tree->root, "", paths, seconds, calls);
+        }
+    }
+
+
+    int TimerTree::insertRegion(std::vector<std::string>& paths, const std::string& path)
+    {
+        const int n = paths.size();
+        for (int i = 0; i < n; ++i) {
+            if (paths[i] == path) {
+                return i;
+            }
+        }
+        // after the parent and all regions below it, at the end for a top
+        // level region
+        const std::string::size_type sep = path.find_last_of('\t');
+        int position = n;
+        if (sep != std::string::npos) {
+            const std::string prefix = path.substr(0, sep + 1);
+            const std::string parent = path.substr(0, sep);
+            for (int i = 0; i < n; ++i) {
+                if (paths[i] == parent || paths[i].compare(0, prefix.size(), prefix) == 0) {
+                    position = i + 1;
+                }
+            }
+        }
+        paths.insert(paths.begin() + position, path);
+        return position;
+    }
+
+
+    std::string TimerTree::format(const std::vector<std::string>& paths,
+                                  const std::vector<double>& calls,
+                                  const std::vector<double>& minSeconds,
+                                  const std::vector<double>& avgSeconds,
+                                  const std::vector<double>& maxSeconds,
+                                  const int numProcesses)
+    {
+        std::ostringstream os;
+        os << "Timed regions, seconds over " << numProcesses
+           << (numProcesses == 1 ? " process" : " processes") << ":\n";
+        os << std::left << std::setw(44) << "region" << std::right
+           << std::setw(12) << "calls"
+           << std::setw(12) << "min"
+           << std::setw(12) << "avg"
+           << std::setw(12) << "max" << "\n";
+        os << std::fixed;
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            const std::string::size_type sep = paths[i].find_last_of('\t');
+            const int depth = std::count(paths[i].begin(), paths[i].end(), '\t');
+            const std::string name = std::string(2*depth, ' ')
+                + (sep == std::string::npos ? paths[i] : paths[i].substr(sep + 1));
+            os << std::left << std::setw(44) << name << std::right
+               << std::setw(12) << std::setprecision(0) << calls[i]
+               << std::setprecision(3)
+               << std::setw(12) << minSeconds[i]
+               << std::setw(12) << avgSeconds[i]
+               << std::setw(12) << maxSeconds[i] << "\n";
+        }
+        return os.str();
+    }
+
+} // namespace Opm
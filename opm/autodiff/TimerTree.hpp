@@ -0,0 +1,181 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef OPM_TIMERTREE_HEADER_INCLUDED
+#define OPM_TIMERTREE_HEADER_INCLUDED
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Hierarchical profiler of named regions of the code.
+    ///
+    /// A region is timed by a TimerTree::Region object in its scope, regions
+    /// opened within the scope of another one are its children. Every thread
+    /// accumulates the time and the number of calls of its regions in its
+    /// own tree, the trees of the threads are merged by the names of the
+    /// regions from the root when the report is made. Regions opened by the
+    /// threads of a parallel loop are therefore top level regions unless
+    /// they are nested within that loop.
+    ///
+    /// The profiler is disabled by default, a disabled region only tests
+    /// a flag. Enable it before any region is opened.
+    class TimerTree
+    {
+    public:
+        struct Node;
+
+        /// Time a region until the end of the scope.
+        class Region
+        {
+        public:
+            /// \param[in] name  name of the region, without tabs and newlines
+            explicit Region(const char* name)
+                : node_(nullptr)
+            {
+                if (TimerTree::enabled()) {
+                    node_ = TimerTree::enter(name);
+                    start_ = std::chrono::steady_clock::now();
+                }
+            }
+
+            ~Region()
+            {
+                if (node_) {
+                    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+                    TimerTree::leave(node_, elapsed.count());
+                }
+            }
+
+            Region(const Region&) = delete;
+            Region& operator=(const Region&) = delete;
+
+        private:
+            Node* node_;
+            std::chrono::steady_clock::time_point start_;
+        };
+
+        /// Enable or disable the timing of the regions.
+        static void enable(const bool on = true) { enabled_ = on; }
+
+        /// Whether the regions are timed.
+        static bool enabled() { return enabled_; }
+
+        /// Remove the regions of all threads. No region may be open.
+        static void reset();
+
+        /// The regions of all threads of this process in depth first order,
+        /// each given by the names from the root separated by tabs, with
+        /// the total time in seconds and the number of calls.
+        static void localRegions(std::vector<std::string>& paths,
+                                 std::vector<double>& seconds,
+                                 std::vector<double>& calls);
+
+        /// Insert a region into paths in depth first order, after the last
+        /// descendant of its parent, unless it is there already. Returns the
+        /// index of the region.
+        static int insertRegion(std::vector<std::string>& paths, const std::string& path);
+
+        /// The report of the regions as a tree, with the minimum, average and
+        /// maximum time over the processes and the average number of calls.
+        static std::string format(const std::vector<std::string>& paths,
+                                  const std::vector<double>& calls,
+                                  const std::vector<double>& minSeconds,
+                                  const std::vector<double>& avgSeconds,
+                                  const std::vector<double>& maxSeconds,
+                                  const int numProcesses);
+
+        /// The report of the regions of all processes of the collective
+        /// communication comm, collective over the processes. The regions
+        /// are the union of those of the processes, a process without a
+        /// region has spent no time in it.
+        template <class Communication>
+        static std::string report(const Communication& comm)
+        {
+            std::vector<std::string> localPaths;
+            std::vector<double> localSeconds;
+            std::vector<double> localCalls;
+            localRegions(localPaths, localSeconds, localCalls);
+
+            // the union of the regions, every process in turn broadcasts
+            // those that are not known yet, usually none after the first
+            std::vector<std::string> paths;
+            for (int root = 0; root < comm.size(); ++root) {
+                std::string added;
+                if (comm.rank() == root) {
+                    for (const auto& path : localPaths) {
+                        if (std::find(paths.begin(), paths.end(), path) == paths.end()) {
+                            added += path;
+                            added += '\n';
+                        }
+                    }
+                }
+                int length = added.size();
+                comm.broadcast(&length, 1, root);
+                if (length == 0) {
+                    continue;
+                }
+                added.resize(length);
+                comm.broadcast(&added[0], length, root);
+                std::string::size_type begin = 0;
+                while (begin < added.size()) {
+                    const std::string::size_type end = added.find('\n', begin);
+                    insertRegion(paths, added.substr(begin, end - begin));
+                    begin = end + 1;
+                }
+            }
+
+            const int n = paths.size();
+            std::vector<double> calls(n, 0.0);
+            std::vector<double> minSeconds(n, 0.0);
+            for (int i = 0; i < int(localPaths.size()); ++i) {
+                const int k = insertRegion(paths, localPaths[i]);
+                calls[k] = localCalls[i];
+                minSeconds[k] = localSeconds[i];
+            }
+            std::vector<double> avgSeconds(minSeconds);
+            std::vector<double> maxSeconds(minSeconds);
+            if (n > 0) {
+                comm.sum(calls.data(), n);
+                comm.min(minSeconds.data(), n);
+                comm.sum(avgSeconds.data(), n);
+                comm.max(maxSeconds.data(), n);
+            }
+            for (int i = 0; i < n; ++i) {
+                calls[i] /= comm.size();
+                avgSeconds[i] /= comm.size();
+            }
+            return format(paths, calls, minSeconds, avgSeconds, maxSeconds, comm.size());
+        }
+
+    private:
+        static Node* enter(const char* name);
+        static void leave(Node* node, const double seconds);
+
+        static bool enabled_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_TIMERTREE_HEADER_INCLUDED
@@ -27,6 +27,8 @@
 #include <opm/core/utility/parameters/ParameterGroup.hpp>
 #include <opm/common/ErrorMacros.hpp>
 #include <opm/common/Exceptions.hpp>
+#include <algorithm>
+#include <cassert>
 #include <iostream>
 
 
@@ -72,6 +74,66 @@ namespace Opm
             tpfa_trans_compute(const_cast<UnstructuredGrid*>(&grid), htrans.data(), trans.data());
             transi_ = subset(trans, ops_.internal_faces);
         }
+        setupSparsityPattern();
+    }
+
+
+
+
+    void TransportSolverTwophaseAd::setupSparsityPattern()
+    {
+        using namespace Opm::AutoDiffGrid;
+        const int nc = numCells(grid_);
+        const int ni = ops_.internal_faces.size();
+
+        const auto& face_cells = ops_.topology->internal_face_cells;
+        std::vector<std::vector<int>> columns(nc);
+        for (int c = 0; c < nc; ++c) {
+            columns[c].push_back(c);
+        }
+        for (int i = 0; i < ni; ++i) {
+            const int c1 = face_cells(i, 0);
+            const int c2 = face_cells(i, 1);
+            columns[c1].push_back(c2);
+            columns[c2].push_back(c1);
+        }
+
+        jac_rows_.assign(1, 0);
+        jac_cols_.clear();
+        for (auto& cols : columns) {
+            std::sort(cols.begin(), cols.end());
+            cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+            jac_cols_.insert(jac_cols_.end(), cols.begin(), cols.end());
+            jac_rows_.push_back(jac_cols_.size());
+        }
+        jac_values_.assign(jac_cols_.size(), 0.0);
+
+        const auto position = [this](const int row, const int col) {
+            const auto begin = jac_cols_.begin() + jac_rows_[row];
+            const auto end   = jac_cols_.begin() + jac_rows_[row + 1];
+            const auto it = std::lower_bound(begin, end, col);
+            assert(it != end && *it == col);
+            return int(it - jac_cols_.begin());
+        };
+
+        diag_pos_.resize(nc);
+        for (int c = 0; c < nc; ++c) {
+            diag_pos_[c] = position(c, c);
+        }
+
+        face_pos_.resize(2 * ni);
+        for (int i = 0; i < ni; ++i) {
+            const int c1 = face_cells(i, 0);
+            const int c2 = face_cells(i, 1);
+            face_pos_[2*i]     = position(c1, c2);
+            face_pos_[2*i + 1] = position(c2, c1);
+        }
+
+        upwind_w_.resize(ni);
+        upwind_o_.resize(ni);
+        flux_.resize(ni);
+        dflux_w_.resize(ni);
+        dflux_o_.resize(ni);
     }
 
 
@@ -89,26 +151,25 @@ namespace Opm
     namespace
     {
 
-        template <class ADB>
-        std::vector<ADB>
+        typedef Eigen::Array<double, Eigen::Dynamic, 2, Eigen::RowMajor> TwoCol;
+
+        /// Computes the water and oil mobilities (columns 0 and 1 of mob)
+        /// and their derivatives with respect to sw.
+        void
         phaseMobility(const Opm::IncompPropertiesInterface& props,
                       const std::vector<int>& cells,
-                      const typename ADB::V& sw)
+                      const AutoDiffBlock<double>::V& sw,
+                      TwoCol& mob,
+                      TwoCol& dmob)
         {
-            typedef Eigen::Array<double, Eigen::Dynamic, 2, Eigen::RowMajor> TwoCol;
             typedef Eigen::Array<double, Eigen::Dynamic, 4, Eigen::RowMajor> FourCol;
-            typedef Eigen::SparseMatrix<double> S;
-            typedef typename ADB::V V;
-            typedef typename ADB::M M;
             const int nc = props.numCells();
             TwoCol s(nc, 2);
             s.leftCols<1>() = sw;
             s.rightCols<1>() = 1.0 - s.leftCols<1>();
-            TwoCol kr(nc, 2);
+            mob.resize(nc, 2);
             FourCol dkr(nc, 4);
-            props.relperm(nc, s.data(), cells.data(), kr.data(), dkr.data());
-            V krw = kr.leftCols<1>();
-            V kro = kr.rightCols<1>();
+            props.relperm(nc, s.data(), cells.data(), mob.data(), dkr.data());
             // In dkr, columns col(0..3) are:
             //    dkrw/dsw  dkro/dsw  dkrw/dso  dkrw/dso  <-- partial derivatives, really.
             // If we want the derivatives with respect to some variable x,
@@ -117,36 +178,14 @@ namespace Opm
             // If x is sw as in our case we are left with.
             //    dkrw/dsw = col(0) - col(2)
             //    dkro/dsw = col(1) - col(3)
-            V dkrw = dkr.leftCols<1>() - dkr.rightCols<2>().leftCols<1>();
-            V dkro = dkr.leftCols<2>().rightCols<1>() - dkr.rightCols<1>();
-            S krwjac(nc,nc);
-            S krojac(nc,nc);
-            auto sizes = Eigen::ArrayXi::Ones(nc);
-            krwjac.reserve(sizes);
-            krojac.reserve(sizes);
-            for (int c = 0; c < nc; ++c) {
-                krwjac.insert(c,c) = dkrw(c);
-                krojac.insert(c,c) = dkro(c);
-            }
+            dmob.resize(nc, 2);
+            dmob.leftCols<1>()  = dkr.leftCols<1>() - dkr.rightCols<2>().leftCols<1>();
+            dmob.rightCols<1>() = dkr.leftCols<2>().rightCols<1>() - dkr.rightCols<1>();
             const double* mu = props.viscosity();
-            std::vector<M> dmw = { M(krwjac)/mu[0] };
-            std::vector<M> dmo = { M(krojac)/mu[1] };
-
-            std::vector<ADB> pmobc = { ADB::function(krw / mu[0], std::move(dmw)) ,
-                                       ADB::function(kro / mu[1], std::move(dmo)) };
-            return pmobc;
-        }
-
-        /// Returns fw(sw).
-        template <class ADB>
-        ADB
-        fluxFunc(const std::vector<ADB>& m)
-        {
-            assert (m.size() == 2);
-
-            ADB f = m[0] / (m[0] + m[1]);
-
-            return f;
+            for (int phase = 0; phase < 2; ++phase) {
+                mob.col(phase)  /= mu[phase];
+                dmob.col(phase) /= mu[phase];
+            }
         }
 
     } // anonymous namespace
@@ -166,7 +205,6 @@ namespace Opm
                                           TwophaseState& state)
     {
         using namespace Opm::AutoDiffGrid;
-        typedef Eigen::Array<double, Eigen::Dynamic, 2, Eigen::RowMajor> TwoCol;
         typedef Eigen::Map<const V> Vec;
         const int nc = numCells(grid_);
         const TwoCol s0 = Eigen::Map<const TwoCol>(state.saturation().data(), nc, 2);
@@ -194,8 +232,13 @@ namespace Opm
         const double* density = props_.density();
         const V dhw = ndp - ndz*(gravity_*density[0]);
         const V dho = ndp - ndz*(gravity_*density[1]);
-        const UpwindSelector<double> upwind_w(grid_, ops_, dhw);
-        const UpwindSelector<double> upwind_o(grid_, ops_, dho);
+        // The upwind cells only depend on the pressure, they are kept for
+        // the whole Newton loop.
+        const GridTopology& topology = *ops_.topology;
+        for (int i = 0; i < num_internal; ++i) {
+            upwind_w_[i] = topology.internal_face_cells(i, dhw[i] >= 0.0 ? 0 : 1);
+            upwind_o_[i] = topology.internal_face_cells(i, dho[i] >= 0.0 ? 0 : 1);
+        }
 
         // Compute more explicit and constant terms used in the equations.
         const V pv = Vec(porevolume, nc, 1);
@@ -207,44 +250,73 @@ namespace Opm
         const V gravflux = (gravity_ == 0.0) ? V(V::Zero(num_internal, 1))
             : ndz*transi_*gfactor;
 
-        // Block pattern for variables.
-        // Primary variables:
-        //    sw : one per cell
-        std::vector<int> bpat = { nc };
-
-        // Newton-Raphson loop.
+        // Newton-Raphson loop. The residual of cell c is
+        //    sw - sw0 + dt/pv*(div(fw_face*(dflux - mob_o_face*gravflux)) - qpos - fw_cell*qneg),
+        // its Jacobian is assembled into the fixed sparsity pattern.
+        TwoCol mob, dmob;
+        V residual(nc);
         int it = 0;
         do {
-            // Assemble linear system.
-            const ADB sw = ADB::variable(0, sw1, bpat);
-            const std::vector<ADB> pmobc = phaseMobility<ADB>(props_, allcells_, sw.value());
-            const ADB fw_cell = fluxFunc(pmobc);
-            const std::vector<ADB> pmobf = { upwind_w.select(pmobc[0]),
-                                             upwind_o.select(pmobc[1])  };
-            const ADB fw_face = fluxFunc(pmobf);
-            const ADB flux = fw_face * (dflux - pmobf[1]*gravflux);
-            // const ADB fw_face = upwind_w.select(fw_cell);
-            // const ADB flux = fw_face * dflux;
-            const ADB qtr_ad = qpos + fw_cell*qneg;
-            const ADB transport_residual = sw - sw0 + dtpv*(ops_.div*flux - qtr_ad);
-            res_norm = transport_residual.value().matrix().norm();
+            phaseMobility(props_, allcells_, sw1, mob, dmob);
+
+            // Face fluxes and their derivatives w.r.t. the upwind saturations.
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+            for (int i = 0; i < num_internal; ++i) {
+                const int uw = upwind_w_[i];
+                const int uo = upwind_o_[i];
+                const double mw = mob(uw, 0);
+                const double mo = mob(uo, 1);
+                const double mt = mw + mo;
+                const double fw = mw / mt;
+                const double drive = dflux[i] - mo*gravflux[i];
+                flux_[i]    = fw * drive;
+                dflux_w_[i] = mo / (mt*mt) * drive * dmob(uw, 0);
+                dflux_o_[i] = (-mw / (mt*mt) * drive - fw*gravflux[i]) * dmob(uo, 1);
+            }
+
+            // Cell rows.
+            std::fill(jac_values_.begin(), jac_values_.end(), 0.0);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+            for (int c = 0; c < nc; ++c) {
+                const double mw = mob(c, 0);
+                const double mo = mob(c, 1);
+                const double mt = mw + mo;
+                const double fw_cell = mw / mt;
+                const double dfw_cell = (mo*dmob(c, 0) - mw*dmob(c, 1)) / (mt*mt);
+                double div = 0.0;
+                jac_values_[diag_pos_[c]] = 1.0 - dtpv[c]*dfw_cell*qneg[c];
+                for (int k = topology.cell_internal_face_start[c]; k < topology.cell_internal_face_start[c + 1]; ++k) {
+                    const int i = topology.cell_internal_faces[k];
+                    const bool first = topology.internal_face_cells(i, 0) == c;
+                    const double sign = first ? 1.0 : -1.0;
+                    const int neighbour_pos = face_pos_[2*i + (first ? 0 : 1)];
+                    div += sign*flux_[i];
+                    const int uw = upwind_w_[i];
+                    const int uo = upwind_o_[i];
+                    jac_values_[uw == c ? diag_pos_[c] : neighbour_pos] += dtpv[c]*sign*dflux_w_[i];
+                    jac_values_[uo == c ? diag_pos_[c] : neighbour_pos] += dtpv[c]*sign*dflux_o_[i];
+                }
+                residual[c] = sw1[c] - sw0[c] + dtpv[c]*(div - qpos[c] - fw_cell*qneg[c]);
+            }
+            res_norm = residual.matrix().norm();
             std::cout << "Residual l2-norm = " << res_norm << std::endl;
 
             // Solve linear system.
-            Eigen::SparseMatrix<double, Eigen::RowMajor> smatr;
-            transport_residual.derivative()[0].toSparse(smatr);
-            assert(smatr.isCompressed());
             V ds(nc);
             LinearSolverInterface::LinearSolverReport rep
-                = linsolver_.solve(nc, smatr.nonZeros(),
-                                   smatr.outerIndexPtr(), smatr.innerIndexPtr(), smatr.valuePtr(),
-                                   transport_residual.value().data(), ds.data());
+                = linsolver_.solve(nc, jac_values_.size(),
+                                   jac_rows_.data(), jac_cols_.data(), jac_values_.data(),
+                                   residual.data(), ds.data());
             if (!rep.converged) {
                 OPM_THROW(LinearSolverProblem, "Linear solver convergence error in TransportSolverTwophaseAd::solve()");
             }
 
             // Update (possible clamp) sw1.
-            sw1 = sw.value() - ds;
+            sw1 = sw1 - ds;
             sw1 = sw1.min(V::Ones(nc,1)).max(V::Zero(nc,1));
             it += 1;
         } while (res_norm > tol_ && it < maxit_);
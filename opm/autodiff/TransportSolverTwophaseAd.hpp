@@ -34,8 +34,10 @@ namespace Opm
     class LinearSolverInterface;
     class ParameterGroup;
 
-    /// Implements an implicit transport solver for incompressible two-phase flow,
-    /// using automatic differentiation.
+    /// Implements an implicit transport solver for incompressible two-phase flow.
+    /// The Jacobian is assembled directly into compressed row storage whose
+    /// sparsity pattern, like the face connectivity, is set up once in the
+    /// constructor and refilled in every Newton iteration.
     class TransportSolverTwophaseAd : public TransportSolverTwophaseInterface
     {
     public:
@@ -82,6 +84,24 @@ namespace Opm
         int maxit_;
         std::vector<int> allcells_;
         V transi_;
+
+        // Jacobian in compressed row storage, with the positions of the
+        // diagonal of each row and of the entries (c1,c2) and (c2,c1) of
+        // internal face i at 2i and 2i+1.
+        std::vector<int> jac_rows_;
+        std::vector<int> jac_cols_;
+        std::vector<double> jac_values_;
+        std::vector<int> diag_pos_;
+        std::vector<int> face_pos_;
+        // Upwind cells of the phases for each internal face, kept between solves.
+        std::vector<int> upwind_w_;
+        std::vector<int> upwind_o_;
+        // Face fluxes and their derivatives w.r.t. the upwind saturations.
+        std::vector<double> flux_;
+        std::vector<double> dflux_w_;
+        std::vector<double> dflux_o_;
+
+        void setupSparsityPattern();
     };
 
 } // namespace Opm
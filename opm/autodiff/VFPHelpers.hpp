@@ -25,9 +25,14 @@
 #include <opm/parser/eclipse/EclipseState/Tables/VFPProdTable.hpp>
 #include <opm/parser/eclipse/EclipseState/Tables/VFPInjTable.hpp>
 #include <opm/autodiff/AutoDiffHelpers.hpp>
+#include <opm/autodiff/NodeSharedArray.hpp>
 #include <opm/material/densead/Math.hpp>
 #include <opm/material/densead/Evaluation.hpp>
 
+#include <algorithm>
+#include <array>
+#include <vector>
+
 /**
  * This file contains a set of helper functions used by VFPProd / VFPInj.
  */
@@ -201,6 +206,34 @@ struct InterpData {
 
 
 
+/**
+ * Helper function to compute the interpolation data for the interval
+ * [values[ind], values[ind+1]].
+ */
+inline InterpData makeInterpData(const double& value, const std::vector<double>& values, const int ind) {
+    InterpData retval;
+    retval.ind_[0] = ind;
+    retval.ind_[1] = ind+1;
+
+    const double start = values[retval.ind_[0]];
+    const double end   = values[retval.ind_[1]];
+
+    //Find interpolation ratio
+    if (end > start) {
+        //FIXME: Possible source for floating point error here if value and floor are large,
+        //but very close to each other
+        retval.inv_dist_ = 1.0 / (end-start);
+        retval.factor_ = (value-start) * retval.inv_dist_;
+    }
+    else {
+        retval.inv_dist_ = 0.0;
+        retval.factor_ = 0.0;
+    }
+
+    return retval;
+}
+
+
 /**
  * Helper function to find indices etc. for linear interpolation and extrapolation
  *  @param value Value to find in values
@@ -208,60 +241,62 @@ struct InterpData {
  *  @return Data required to find the interpolated value
  */
 inline InterpData findInterpData(const double& value, const std::vector<double>& values) {
-    InterpData retval;
-
     const int nvalues = values.size();
 
     //If we only have one value in our vector, return that
-    if (values.size() == 1) {
-        retval.ind_[0] = 0;
-        retval.ind_[1] = 0;
-        retval.inv_dist_ = 0.0;
-        retval.factor_ = 0.0;
+    if (nvalues == 1) {
+        return InterpData();
     }
-    // Else search in the vector
-    else {
-        //If value is less than all values, use first interval
-        if (value < values.front()) {
-            retval.ind_[0] = 0;
-            retval.ind_[1] = 1;
-        }
-        //If value is greater than all values, use last interval
-        else if (value >= values.back()) {
-            retval.ind_[0] = nvalues-2;
-            retval.ind_[1] = nvalues-1;
-        }
-        else {
-            //Search internal intervals
-            for (int i=1; i<nvalues; ++i) {
-                if (values[i] >= value) {
-                    retval.ind_[0] = i-1;
-                    retval.ind_[1] = i;
-                    break;
-                }
-            }
-        }
 
-        const double start = values[retval.ind_[0]];
-        const double end   = values[retval.ind_[1]];
+    //If value is less than all values, use first interval
+    if (value < values.front()) {
+        return makeInterpData(value, values, 0);
+    }
+    //If value is greater than all values, use last interval
+    if (value >= values.back()) {
+        return makeInterpData(value, values, nvalues-2);
+    }
 
-        //Find interpolation ratio
-        if (end > start) {
-            //FIXME: Possible source for floating point error here if value and floor are large,
-            //but very close to each other
-            retval.inv_dist_ = 1.0 / (end-start);
-            retval.factor_ = (value-start) * retval.inv_dist_;
-        }
-        else {
-            retval.inv_dist_ = 0.0;
-            retval.factor_ = 0.0;
+    //Search internal intervals for the first element greater than or equal to value
+    const auto upper = std::lower_bound(values.begin()+1, values.end(), value);
+    return makeInterpData(value, values, static_cast<int>(upper - values.begin()) - 1);
+}
+
+
+/**
+ * Helper function to find indices etc. for linear interpolation and extrapolation,
+ * which first tries the interval found by a previous search. Gives the same result
+ * as findInterpData(value, values).
+ *  @param value Value to find in values
+ *  @param values Sorted list of values to search for value in.
+ *  @param bracket First index of the interval of the previous search, or a negative
+ *                 number if there is none. Updated on return.
+ *  @return Data required to find the interpolated value
+ */
+inline InterpData findInterpData(const double& value, const std::vector<double>& values, int& bracket) {
+    const int nvalues = values.size();
+    if (nvalues > 1 && bracket >= 0 && bracket < nvalues-1) {
+        const bool above_lower = (bracket == 0) || (values[bracket] < value);
+        const bool below_upper = (bracket == nvalues-2) || (value <= values[bracket+1] && value < values.back());
+        if (above_lower && below_upper) {
+            return makeInterpData(value, values, bracket);
         }
     }
 
+    const InterpData retval = findInterpData(value, values);
+    bracket = retval.ind_[0];
     return retval;
 }
 
 
+/**
+ * The interpolation intervals on the axes of a production table (FLO, THP, WFR, GFR
+ * and ALQ) of a number of evaluations, used as the starting point of the search in
+ * the next evaluation.
+ */
+typedef std::vector< std::array<int, 5> > VFPBrackets;
+
+
 
 
 
@@ -330,37 +365,57 @@ inline VFPEvaluation operator*(
 #endif
 
 
-inline VFPEvaluation interpolate(
+/**
+ * Helper function which copies the 32 corners of the hypercube given by the
+ * interpolation data from the table to a flat array, with the flo index running
+ * fastest (and the thp index slowest).
+ */
+inline void gatherCorners(
         const VFPProdTable::array_type& array,
         const InterpData& flo_i,
         const InterpData& thp_i,
         const InterpData& wfr_i,
         const InterpData& gfr_i,
+        const InterpData& alq_i,
+        double* corners) {
+    int corner = 0;
+    for (int t=0; t<=1; ++t) {
+        for (int w=0; w<=1; ++w) {
+            for (int g=0; g<=1; ++g) {
+                for (int a=0; a<=1; ++a) {
+                    for (int f=0; f<=1; ++f) {
+                        corners[corner++] = array[thp_i.ind_[t]][wfr_i.ind_[w]][gfr_i.ind_[g]][alq_i.ind_[a]][flo_i.ind_[f]];
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * Helper function which interpolates the corners of a hypercube given in the
+ * order of gatherCorners(), using the factors of the interpolation data.
+ */
+inline VFPEvaluation interpolate(
+        const double* corners,
+        const InterpData& flo_i,
+        const InterpData& thp_i,
+        const InterpData& wfr_i,
+        const InterpData& gfr_i,
         const InterpData& alq_i) {
 
     //Values and derivatives in a 5D hypercube
     VFPEvaluation nn[2][2][2][2][2];
 
-
-    //Pick out nearest neighbors (nn) to our evaluation point
-    //This is not really required, but performance-wise it may pay off, since the 32-elements
-    //we copy to (nn) will fit better in cache than the full original table for the
-    //interpolation below.
     //The following ladder of for loops will presumably be unrolled by a reasonable compiler.
+    int corner = 0;
     for (int t=0; t<=1; ++t) {
         for (int w=0; w<=1; ++w) {
             for (int g=0; g<=1; ++g) {
                 for (int a=0; a<=1; ++a) {
                     for (int f=0; f<=1; ++f) {
-                        //Shorthands for indexing
-                        const int ti = thp_i.ind_[t];
-                        const int wi = wfr_i.ind_[w];
-                        const int gi = gfr_i.ind_[g];
-                        const int ai = alq_i.ind_[a];
-                        const int fi = flo_i.ind_[f];
-
-                        //Copy element
-                        nn[t][w][g][a][f].value = array[ti][wi][gi][ai][fi];
+                        nn[t][w][g][a][f].value = corners[corner++];
                     }
                 }
             }
@@ -441,6 +496,24 @@ inline VFPEvaluation interpolate(
 
 
 
+inline VFPEvaluation interpolate(
+        const VFPProdTable::array_type& array,
+        const InterpData& flo_i,
+        const InterpData& thp_i,
+        const InterpData& wfr_i,
+        const InterpData& gfr_i,
+        const InterpData& alq_i) {
+    //Pick out nearest neighbors to our evaluation point
+    //This is not really required, but performance-wise it may pay off, since the 32-elements
+    //we copy will fit better in cache than the full original table for the
+    //interpolation below.
+    double corners[32];
+    gatherCorners(array, flo_i, thp_i, wfr_i, gfr_i, alq_i, corners);
+    return interpolate(corners, flo_i, thp_i, wfr_i, gfr_i, alq_i);
+}
+
+
+
 
 
 /**
@@ -505,6 +578,52 @@ inline VFPEvaluation interpolate(
 
 
 
+/**
+ * Helper function which interpolates the value of a production table only. This is
+ * the interpolation of interpolate() without the derivatives, working on the 32
+ * corners of the hypercube in the order of gatherCorners().
+ */
+inline double interpolateValue(
+        const double* corners,
+        const InterpData& flo_i,
+        const InterpData& thp_i,
+        const InterpData& wfr_i,
+        const InterpData& gfr_i,
+        const InterpData& alq_i) {
+    double nn[32];
+    std::copy(corners, corners + 32, nn);
+
+    // Remove dimensions one by one, in the same order as interpolate(),
+    // the pairs of corners along the fastest index are combined first.
+    const double factors[5] = { flo_i.factor_, alq_i.factor_, gfr_i.factor_, wfr_i.factor_, thp_i.factor_ };
+    int n = 16;
+    for (int d=0; d<5; ++d, n/=2) {
+        const double t2 = factors[d];
+        const double t1 = (1.0-t2);
+        for (int i=0; i<n; ++i) {
+            nn[i] = t1*nn[2*i] + t2*nn[2*i+1];
+        }
+    }
+
+    return nn[0];
+}
+
+
+inline double interpolateValue(
+        const VFPProdTable::array_type& array,
+        const InterpData& flo_i,
+        const InterpData& thp_i,
+        const InterpData& wfr_i,
+        const InterpData& gfr_i,
+        const InterpData& alq_i) {
+    double corners[32];
+    gatherCorners(array, flo_i, thp_i, wfr_i, gfr_i, alq_i, corners);
+    return interpolateValue(corners, flo_i, thp_i, wfr_i, gfr_i, alq_i);
+}
+
+
+
+
 #ifdef __GNUC__
 #pragma GCC pop_options //unroll loops
 #endif
@@ -513,6 +632,173 @@ inline VFPEvaluation interpolate(
 
 
 
+/**
+ * A production table repacked so that the 32 corners of each hypercell are
+ * stored contiguously, in the order of gatherCorners(). An interpolation then
+ * reads 256 consecutive bytes instead of 32 values scattered across the table,
+ * at the cost of storing every value of the table up to 32 times. To limit
+ * the memory use the repacked table may be stored once per compute node, see
+ * NodeSharedArray.
+ */
+class VFPHypercellTable {
+public:
+    VFPHypercellTable() {
+        cells_.fill(0);
+    }
+
+    VFPHypercellTable(const VFPProdTable::array_type& array, const bool shareOnNode) {
+        //Axes in the order of the table: thp, wfr, gfr, alq, flo
+        //An axis with a single value has one cell with equal end points
+        std::array<int, 5> offset;
+        for (int d=0; d<5; ++d) {
+            const int n = array.shape()[d];
+            cells_[d] = std::max(n-1, 1);
+            offset[d] = (n > 1) ? 1 : 0;
+        }
+
+        const std::size_t size = std::size_t(cells_[0])*cells_[1]*cells_[2]*cells_[3]*cells_[4]*32;
+        const std::array<int, 5>& cells = cells_;
+        corners_ = NodeSharedArray(size, [&array, &cells, &offset](double* corners) {
+            for (int ti=0; ti<cells[0]; ++ti) {
+                for (int wi=0; wi<cells[1]; ++wi) {
+                    for (int gi=0; gi<cells[2]; ++gi) {
+                        for (int ai=0; ai<cells[3]; ++ai) {
+                            for (int fi=0; fi<cells[4]; ++fi) {
+                                for (int t=0; t<=1; ++t) {
+                                    for (int w=0; w<=1; ++w) {
+                                        for (int g=0; g<=1; ++g) {
+                                            for (int a=0; a<=1; ++a) {
+                                                for (int f=0; f<=1; ++f) {
+                                                    *corners++ = array[ti + t*offset[0]][wi + w*offset[1]][gi + g*offset[2]]
+                                                                      [ai + a*offset[3]][fi + f*offset[4]];
+                                                }
+                                            }
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }, shareOnNode);
+    }
+
+    /**
+     * The 32 corners of the hypercell given by the interpolation data.
+     */
+    const double* corners(
+            const InterpData& flo_i,
+            const InterpData& thp_i,
+            const InterpData& wfr_i,
+            const InterpData& gfr_i,
+            const InterpData& alq_i) const {
+        const int cell = (((thp_i.ind_[0]*cells_[1] + wfr_i.ind_[0])*cells_[2]
+                           + gfr_i.ind_[0])*cells_[3] + alq_i.ind_[0])*cells_[4] + flo_i.ind_[0];
+        return corners_.data() + 32*cell;
+    }
+
+private:
+    std::array<int, 5> cells_;
+    NodeSharedArray corners_;
+};
+
+
+
+
+
+/**
+ * The inverse of a production table with respect to the THP: for each cell
+ * of the flo, wfr, gfr and alq axes the bhp values of its 16 corners at all
+ * nodes of the THP axis, stored contiguously. The bhp as a function of the
+ * THP for given flo, wfr, gfr and alq values then needs one 4D interpolation
+ * per THP node from one block of the table, instead of a lookup and a 5D
+ * interpolation of a hypercell each. The result is the same as interpolating
+ * the hypercells at the THP nodes. Built on the first THP computation with
+ * the table, see VFPProdProperties.
+ */
+class VFPInverseTHPTable {
+public:
+    VFPInverseTHPTable() : nthp_(0) {
+        cells_.fill(0);
+    }
+
+    explicit VFPInverseTHPTable(const VFPProdTable::array_type& array) {
+        //Axes in the order of the table: thp, wfr, gfr, alq, flo
+        nthp_ = array.shape()[0];
+        std::array<int, 4> offset;
+        for (int d=0; d<4; ++d) {
+            const int n = array.shape()[d+1];
+            cells_[d] = std::max(n-1, 1);
+            offset[d] = (n > 1) ? 1 : 0;
+        }
+
+        values_.resize(std::size_t(cells_[0])*cells_[1]*cells_[2]*cells_[3]*nthp_*16);
+        double* values = values_.data();
+        for (int wi=0; wi<cells_[0]; ++wi) {
+            for (int gi=0; gi<cells_[1]; ++gi) {
+                for (int ai=0; ai<cells_[2]; ++ai) {
+                    for (int fi=0; fi<cells_[3]; ++fi) {
+                        for (int t=0; t<nthp_; ++t) {
+                            for (int w=0; w<=1; ++w) {
+                                for (int g=0; g<=1; ++g) {
+                                    for (int a=0; a<=1; ++a) {
+                                        for (int f=0; f<=1; ++f) {
+                                            *values++ = array[t][wi + w*offset[0]][gi + g*offset[1]]
+                                                              [ai + a*offset[2]][fi + f*offset[3]];
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * The bhp values at the nodes of the THP axis for the interpolation data
+     * of the other axes.
+     */
+    void bhpValues(
+            const InterpData& flo_i,
+            const InterpData& wfr_i,
+            const InterpData& gfr_i,
+            const InterpData& alq_i,
+            std::vector<double>& bhp_array) const {
+        const int cell = ((wfr_i.ind_[0]*cells_[1] + gfr_i.ind_[0])*cells_[2]
+                          + alq_i.ind_[0])*cells_[3] + flo_i.ind_[0];
+        const double* values = values_.data() + std::size_t(16)*nthp_*cell;
+
+        // The same order of the dimensions as interpolateValue().
+        const double factors[4] = { flo_i.factor_, alq_i.factor_, gfr_i.factor_, wfr_i.factor_ };
+        bhp_array.resize(nthp_);
+        for (int t=0; t<nthp_; ++t, values += 16) {
+            double nn[16];
+            std::copy(values, values + 16, nn);
+            int n = 8;
+            for (int d=0; d<4; ++d, n/=2) {
+                const double t2 = factors[d];
+                const double t1 = (1.0-t2);
+                for (int i=0; i<n; ++i) {
+                    nn[i] = t1*nn[2*i] + t2*nn[2*i+1];
+                }
+            }
+            bhp_array[t] = nn[0];
+        }
+    }
+
+private:
+    int nthp_;
+    std::array<int, 4> cells_;
+    std::vector<double> values_;
+};
+
+
+
+
+
 inline VFPEvaluation bhp(const VFPProdTable* table,
         const double& aqua,
         const double& liquid,
@@ -570,7 +856,7 @@ inline VFPEvaluation bhp(const VFPInjTable* table,
  * Returns the table from the map if found, or throws an exception
  */
 template <typename T>
-const T* getTable(const std::map<int, T*> tables, int table_id) {
+const T* getTable(const std::map<int, T*>& tables, int table_id) {
     auto entry = tables.find(table_id);
     if (entry == tables.end()) {
         OPM_THROW(std::invalid_argument, "Nonexistent table " << table_id << " referenced.");
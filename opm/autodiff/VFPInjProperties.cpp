@@ -191,7 +191,7 @@ double VFPInjProperties::thp(int table_id,
     //Find interpolation variables
     double flo = detail::getFlo(aqua, liquid, vapour, table->getFloType());
 
-    const std::vector<double> thp_array = table->getTHPAxis();
+    const std::vector<double>& thp_array = table->getTHPAxis();
     int nthp = thp_array.size();
 
     /**
@@ -34,6 +34,58 @@
 namespace Opm {
 
 
+namespace {
+
+/**
+ * Finds the interpolation data of the flo, wfr, gfr and alq axes, starting
+ * from the intervals in bracket.
+ */
+void findProdInterpData(const VFPProdTable* table,
+                        const double& aqua,
+                        const double& liquid,
+                        const double& vapour,
+                        const double& alq,
+                        std::array<int, 5>& bracket,
+                        detail::InterpData& flo_i,
+                        detail::InterpData& wfr_i,
+                        detail::InterpData& gfr_i,
+                        detail::InterpData& alq_i) {
+    const double flo = detail::getFlo(aqua, liquid, vapour, table->getFloType());
+    const double wfr = detail::getWFR(aqua, liquid, vapour, table->getWFRType());
+    const double gfr = detail::getGFR(aqua, liquid, vapour, table->getGFRType());
+
+    //Recall that flo is negative in Opm, so switch sign.
+    flo_i = detail::findInterpData(-flo, table->getFloAxis(), bracket[0]);
+    wfr_i = detail::findInterpData( wfr, table->getWFRAxis(), bracket[2]);
+    gfr_i = detail::findInterpData( gfr, table->getGFRAxis(), bracket[3]);
+    alq_i = detail::findInterpData( alq, table->getALQAxis(), bracket[4]);
+}
+
+
+double prodTHP(const VFPProdTable* table,
+               const detail::VFPInverseTHPTable& inverse,
+               const double& aqua,
+               const double& liquid,
+               const double& vapour,
+               const double& bhp_arg,
+               const double& alq,
+               std::array<int, 5>& bracket) {
+    detail::InterpData flo_i, wfr_i, gfr_i, alq_i;
+    findProdInterpData(table, aqua, liquid, vapour, alq, bracket, flo_i, wfr_i, gfr_i, alq_i);
+
+    /**
+     * Find the function bhp_array(thp) from the bhp values of the table
+     * at the THP nodes of the cell of the other axes.
+     */
+    std::vector<double> bhp_array;
+    inverse.bhpValues(flo_i, wfr_i, gfr_i, alq_i, bhp_array);
+
+    return detail::findTHP(bhp_array, table->getTHPAxis(), bhp_arg);
+}
+
+} // anonymous namespace
+
+
 
 
 VFPProdProperties::VFPProdProperties() {
@@ -44,14 +96,17 @@ VFPProdProperties::VFPProdProperties() {
 
 VFPProdProperties::VFPProdProperties(const VFPProdTable* table){
     m_tables[table->getTableNum()] = table;
+    m_hypercells[table->getTableNum()] = detail::VFPHypercellTable(table->getTable(), false);
 }
 
 
 
 
-VFPProdProperties::VFPProdProperties(const std::map<int, VFPProdTable>& tables) {
+VFPProdProperties::VFPProdProperties(const std::map<int, VFPProdTable>& tables,
+                                     const bool share_on_node) {
     for (const auto& table : tables) {
         m_tables[table.first] = &table.second;
+        m_hypercells[table.first] = detail::VFPHypercellTable(table.second.getTable(), share_on_node);
     }
 }
 
@@ -123,7 +178,8 @@ VFPProdProperties::ADB VFPProdProperties::bhp(const std::vector<int>& table_id,
             auto gfr_i = detail::findInterpData( gfr.value()[i], table->getGFRAxis());
             auto alq_i = detail::findInterpData( alq.value()[i], table->getALQAxis());
 
-            detail::VFPEvaluation bhp_val = detail::interpolate(table->getTable(), flo_i, thp_i, wfr_i, gfr_i, alq_i);
+            const double* corners = getHypercells(table_id[i]).corners(flo_i, thp_i, wfr_i, gfr_i, alq_i);
+            detail::VFPEvaluation bhp_val = detail::interpolate(corners, flo_i, thp_i, wfr_i, gfr_i, alq_i);
 
             value[i] = bhp_val.value;
             dthp[i] = bhp_val.dthp;
@@ -183,8 +239,14 @@ double VFPProdProperties::bhp(int table_id,
         const double& alq) const {
     const VFPProdTable* table = detail::getTable(m_tables, table_id);
 
-    detail::VFPEvaluation retval = detail::bhp(table, aqua, liquid, vapour, thp_arg, alq);
-    return retval.value;
+    std::array<int, 5> bracket;
+    bracket.fill(-1);
+    detail::InterpData flo_i, wfr_i, gfr_i, alq_i;
+    findProdInterpData(table, aqua, liquid, vapour, alq, bracket, flo_i, wfr_i, gfr_i, alq_i);
+    auto thp_i = detail::findInterpData(thp_arg, table->getTHPAxis());
+
+    const double* corners = getHypercells(table_id).corners(flo_i, thp_i, wfr_i, gfr_i, alq_i);
+    return detail::interpolateValue(corners, flo_i, thp_i, wfr_i, gfr_i, alq_i);
 }
 
 
@@ -196,34 +258,76 @@ double VFPProdProperties::thp(int table_id,
         const double& bhp_arg,
         const double& alq) const {
     const VFPProdTable* table = detail::getTable(m_tables, table_id);
-    const VFPProdTable::array_type& data = table->getTable();
 
-    //Find interpolation variables
-    double flo = detail::getFlo(aqua, liquid, vapour, table->getFloType());
-    double wfr = detail::getWFR(aqua, liquid, vapour, table->getWFRType());
-    double gfr = detail::getGFR(aqua, liquid, vapour, table->getGFRType());
+    std::array<int, 5> bracket;
+    bracket.fill(-1);
+    return prodTHP(table, getInverseTHP(table_id), aqua, liquid, vapour, bhp_arg, alq, bracket);
+}
 
-    const std::vector<double> thp_array = table->getTHPAxis();
-    int nthp = thp_array.size();
 
-    /**
-     * Find the function bhp_array(thp) by creating a 1D view of the data
-     * by interpolating for every value of thp. This might be somewhat
-     * expensive, but let us assome that nthp is small
-     * Recall that flo is negative in Opm, so switch the sign
-     */
-    auto flo_i = detail::findInterpData(-flo, table->getFloAxis());
-    auto wfr_i = detail::findInterpData( wfr, table->getWFRAxis());
-    auto gfr_i = detail::findInterpData( gfr, table->getGFRAxis());
-    auto alq_i = detail::findInterpData( alq, table->getALQAxis());
-    std::vector<double> bhp_array(nthp);
-    for (int i=0; i<nthp; ++i) {
-        auto thp_i = detail::findInterpData(thp_array[i], thp_array);
-        bhp_array[i] = detail::interpolate(data, flo_i, thp_i, wfr_i, gfr_i, alq_i).value;
+
+void VFPProdProperties::bhp(const std::vector<int>& table_id,
+        const std::vector<double>& aqua,
+        const std::vector<double>& liquid,
+        const std::vector<double>& vapour,
+        const std::vector<double>& thp_arg,
+        const std::vector<double>& alq,
+        std::vector<double>& bhp_arg,
+        detail::VFPBrackets& brackets) const {
+    const int nw = table_id.size();
+    assert(static_cast<int>(aqua.size())    == nw);
+    assert(static_cast<int>(liquid.size())  == nw);
+    assert(static_cast<int>(vapour.size())  == nw);
+    assert(static_cast<int>(thp_arg.size()) == nw);
+    assert(static_cast<int>(alq.size())     == nw);
+
+    std::array<int, 5> none;
+    none.fill(-1);
+    brackets.resize(nw, none);
+    bhp_arg.resize(nw);
+
+    for (int i=0; i<nw; ++i) {
+        if (table_id[i] < 0) {
+            bhp_arg[i] = -1e100; //Signal that this value has not been calculated properly, due to "missing" table
+            continue;
+        }
+        const VFPProdTable* table = detail::getTable(m_tables, table_id[i]);
+
+        detail::InterpData flo_i, wfr_i, gfr_i, alq_i;
+        findProdInterpData(table, aqua[i], liquid[i], vapour[i], alq[i], brackets[i], flo_i, wfr_i, gfr_i, alq_i);
+        auto thp_i = detail::findInterpData(thp_arg[i], table->getTHPAxis(), brackets[i][1]);
+
+        const double* corners = getHypercells(table_id[i]).corners(flo_i, thp_i, wfr_i, gfr_i, alq_i);
+        bhp_arg[i] = detail::interpolateValue(corners, flo_i, thp_i, wfr_i, gfr_i, alq_i);
     }
+}
 
-    double retval = detail::findTHP(bhp_array, thp_array, bhp_arg);
-    return retval;
+
+
+void VFPProdProperties::thp(const std::vector<int>& table_id,
+        const std::vector<double>& aqua,
+        const std::vector<double>& liquid,
+        const std::vector<double>& vapour,
+        const std::vector<double>& bhp_arg,
+        const std::vector<double>& alq,
+        std::vector<double>& thp_arg,
+        detail::VFPBrackets& brackets) const {
+    const int nw = table_id.size();
+    assert(static_cast<int>(aqua.size())    == nw);
+    assert(static_cast<int>(liquid.size())  == nw);
+    assert(static_cast<int>(vapour.size())  == nw);
+    assert(static_cast<int>(bhp_arg.size()) == nw);
+    assert(static_cast<int>(alq.size())     == nw);
+
+    std::array<int, 5> none;
+    none.fill(-1);
+    brackets.resize(nw, none);
+    thp_arg.resize(nw);
+
+    for (int i=0; i<nw; ++i) {
+        const VFPProdTable* table = detail::getTable(m_tables, table_id[i]);
+        thp_arg[i] = prodTHP(table, getInverseTHP(table_id[i]), aqua[i], liquid[i], vapour[i], bhp_arg[i], alq[i], brackets[i]);
+    }
 }
 
 
@@ -237,6 +341,33 @@ const VFPProdTable* VFPProdProperties::getTable(const int table_id) const {
 
 
 
+const detail::VFPHypercellTable& VFPProdProperties::getHypercells(const int table_id) const {
+    auto entry = m_hypercells.find(table_id);
+    if (entry == m_hypercells.end()) {
+        OPM_THROW(std::invalid_argument, "Nonexistent table " << table_id << " referenced.");
+    }
+    return entry->second;
+}
+
+
+
+const detail::VFPInverseTHPTable& VFPProdProperties::getInverseTHP(const int table_id) const {
+    const VFPProdTable* table = detail::getTable(m_tables, table_id);
+    const detail::VFPInverseTHPTable* inverse = nullptr;
+    // the entries are not moved by the insertion of others
+#pragma omp critical(VFPProdProperties_getInverseTHP)
+    {
+        auto entry = m_inverse_thp.find(table_id);
+        if (entry == m_inverse_thp.end()) {
+            entry = m_inverse_thp.emplace(table_id, detail::VFPInverseTHPTable(table->getTable())).first;
+        }
+        inverse = &entry->second;
+    }
+    return *inverse;
+}
+
+
+
 
 
 
@@ -60,8 +60,12 @@ public:
      * Constructor
      * Takes *no* ownership of data.
      * @param prod_tables A map of different VFPPROD tables.
+     * @param share_on_node Store the repacked tables once per compute node,
+     *                      see NodeSharedArray. Construction is then
+     *                      collective over all processes.
      */
-    explicit VFPProdProperties(const std::map<int, VFPProdTable>& prod_tables);
+    explicit VFPProdProperties(const std::map<int, VFPProdTable>& prod_tables,
+                               const bool share_on_node = false);
 
     /**
      * Linear interpolation of bhp as function of the input parameters.
@@ -148,7 +152,8 @@ public:
             auto gfr_i = detail::findInterpData( gfr.value(), table->getGFRAxis());
             auto alq_i = detail::findInterpData( alq, table->getALQAxis()); //assume constant
 
-            detail::VFPEvaluation bhp_val = detail::interpolate(table->getTable(), flo_i, thp_i, wfr_i, gfr_i, alq_i);
+            const double* corners = getHypercells(table_id).corners(flo_i, thp_i, wfr_i, gfr_i, alq_i);
+            detail::VFPEvaluation bhp_val = detail::interpolate(corners, flo_i, thp_i, wfr_i, gfr_i, alq_i);
 
             bhp = (bhp_val.dwfr * wfr) + (bhp_val.dgfr * gfr) - (bhp_val.dflo * flo);
             bhp.setValue(bhp_val.value);
@@ -197,6 +202,50 @@ public:
             const double& bhp,
             const double& alq) const;
 
+    /**
+     * Linear interpolation of bhp for a number of wells at once, with one
+     * vector per input parameter. A negative table number gives a bhp of -1e100.
+     * @param table_id Table number to use for each well
+     * @param aqua Water phase
+     * @param liquid Oil phase
+     * @param vapour Gas phase
+     * @param thp Tubing head pressure
+     * @param alq Artificial lift or other parameter
+     * @param bhp The bottom hole pressures on return.
+     * @param brackets The interpolation intervals of the previous call, which are
+     * the starting point of the table search, updated on return. The intervals
+     * are only a hint, the result does not depend on them.
+     */
+    void bhp(const std::vector<int>& table_id,
+             const std::vector<double>& aqua,
+             const std::vector<double>& liquid,
+             const std::vector<double>& vapour,
+             const std::vector<double>& thp,
+             const std::vector<double>& alq,
+             std::vector<double>& bhp,
+             detail::VFPBrackets& brackets) const;
+
+    /**
+     * Linear interpolation of thp for a number of wells at once, with one
+     * vector per input parameter.
+     * @param table_id Table number to use for each well
+     * @param aqua Water phase
+     * @param liquid Oil phase
+     * @param vapour Gas phase
+     * @param bhp Bottom hole pressure
+     * @param alq Artificial lift or other parameter
+     * @param thp The tubing head pressures on return.
+     * @param brackets The interpolation intervals of the previous call, see bhp().
+     */
+    void thp(const std::vector<int>& table_id,
+             const std::vector<double>& aqua,
+             const std::vector<double>& liquid,
+             const std::vector<double>& vapour,
+             const std::vector<double>& bhp,
+             const std::vector<double>& alq,
+             std::vector<double>& thp,
+             detail::VFPBrackets& brackets) const;
+
     /**
      * Returns the table associated with the ID, or throws an exception if
      * the table does not exist
@@ -211,8 +260,26 @@ public:
     }
 
 private:
+    /**
+     * Returns the repacked table associated with the ID.
+     */
+    const detail::VFPHypercellTable& getHypercells(const int table_id) const;
+
+    /**
+     * Returns the inverse of the table with respect to the THP, built on
+     * the first call for the table.
+     */
+    const detail::VFPInverseTHPTable& getInverseTHP(const int table_id) const;
+
     // Map which connects the table number with the table itself
     std::map<int, const VFPProdTable*> m_tables;
+
+    // The tables with the corners of each hypercell stored contiguously,
+    // which is the layout used for the interpolation.
+    std::map<int, detail::VFPHypercellTable> m_hypercells;
+
+    // The inverse tables of the THP computations, built lazily.
+    mutable std::map<int, detail::VFPInverseTHPTable> m_inverse_thp;
 };
 
 
@@ -39,9 +39,10 @@ VFPProperties::VFPProperties(const VFPInjTable* inj_table, const VFPProdTable* p
 }
 
 VFPProperties::VFPProperties(const std::map<int, VFPInjTable>& inj_tables,
-                             const std::map<int, VFPProdTable>& prod_tables) {
+                             const std::map<int, VFPProdTable>& prod_tables,
+                             const bool share_on_node) {
     m_inj.reset(new VFPInjProperties(inj_tables));
-    m_prod.reset(new VFPProdProperties(prod_tables));
+    m_prod.reset(new VFPProdProperties(prod_tables, share_on_node));
 }
 
 
@@ -51,9 +51,12 @@ public:
      * Takes *no* ownership of data.
      * @param inj_tables A map of different VFPINJ tables.
      * @param prod_tables A map of different VFPPROD tables.
+     * @param share_on_node Store the repacked VFPPROD tables once per
+     *                      compute node, see VFPProdProperties.
      */
     VFPProperties(const std::map<int, VFPInjTable>& inj_tables,
-                  const std::map<int, VFPProdTable>& prod_tables);
+                  const std::map<int, VFPProdTable>& prod_tables,
+                  const bool share_on_node = false);
 
     /**
      * Returns the VFP properties for injection wells
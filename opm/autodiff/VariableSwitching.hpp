@@ -0,0 +1,141 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_VARIABLESWITCHING_HEADER_INCLUDED
+#define OPM_VARIABLESWITCHING_HEADER_INCLUDED
+
+#include <opm/core/simulator/BlackoilState.hpp>
+
+#include <cmath>
+#include <limits>
+
+namespace Opm {
+namespace detail {
+
+    /// The tolerance of the saturation checks of the variable switching.
+    inline double switchingEpsilon()
+    {
+        return std::sqrt(std::numeric_limits<double>::epsilon());
+    }
+
+    template <bool water, bool gas>
+    inline void chopSaturationsImpl(const int nc, double* sw, double* so, double* sg)
+    {
+        for (int c = 0; c < nc; ++c) {
+            double w = water ? sw[c] : 0.0;
+            double o = so[c];
+            double g = gas ? sg[c] : 0.0;
+            // a negative saturation is set to zero and the others are
+            // scaled, dividing by one leaves a saturation unchanged
+            if (gas) {
+                const double scale = g < 0.0 ? 1.0 - g : 1.0;
+                w /= scale;
+                o /= scale;
+                g = g < 0.0 ? 0.0 : g;
+            }
+            {
+                const double scale = o < 0.0 ? 1.0 - o : 1.0;
+                w /= scale;
+                g /= scale;
+                o = o < 0.0 ? 0.0 : o;
+            }
+            if (water) {
+                const double scale = w < 0.0 ? 1.0 - w : 1.0;
+                o /= scale;
+                g /= scale;
+                w = w < 0.0 ? 0.0 : w;
+            }
+            if (water) {
+                sw[c] = w;
+            }
+            so[c] = o;
+            if (gas) {
+                sg[c] = g;
+            }
+        }
+    }
+
+    /// Chop the negative gas, oil and water saturations of the Newton
+    /// update of the legacy models, in this order and in one pass over the
+    /// cells. The saturations of an inactive phase are nullptr, the oil
+    /// phase must be active.
+    inline void chopSaturations(const int nc, double* sw, double* so, double* sg)
+    {
+        if (sw && sg) {
+            chopSaturationsImpl<true, true>(nc, sw, so, sg);
+        }
+        else if (sw) {
+            chopSaturationsImpl<true, false>(nc, sw, so, sg);
+        }
+        else if (sg) {
+            chopSaturationsImpl<false, true>(nc, sw, so, sg);
+        }
+        else {
+            chopSaturationsImpl<false, false>(nc, sw, so, sg);
+        }
+    }
+
+    /// Switch the cells between Sg and Rs as the primary variable: gas
+    /// appears if Sg is positive or Rs exceeds its saturated value, the
+    /// latter only if the previous Rs was saturated already. Saturated
+    /// cells get the saturated Rs, water only cells no oil and gas, and
+    /// undersaturated ones the state OilOnly. sw is nullptr without water.
+    inline void switchDissolvedGas(const int nc, const double* sw, const double* isRs,
+                                   const double* rsSat, const double* rsSat0, const double* rsOld,
+                                   double* so, double* sg, double* rs, HydroCarbonState* state)
+    {
+        const double epsilon = switchingEpsilon();
+        for (int c = 0; c < nc; ++c) {
+            const bool watOnly = sw != nullptr && sw[c] > 1.0 - epsilon;
+            const bool hasGas = sg[c] > 0.0 && isRs[c] == 0.0;
+            const bool gasVaporized = rs[c] > rsSat[c] * (1.0 + epsilon) && isRs[c] == 1.0
+                && rsOld[c] > rsSat0[c] * (1.0 - epsilon);
+            const bool useSg = watOnly || hasGas || gasVaporized;
+            rs[c] = watOnly ? 0.0 : (useSg ? rsSat[c] : rs[c]);
+            so[c] = watOnly ? 0.0 : so[c];
+            sg[c] = watOnly ? 0.0 : sg[c];
+            state[c] = useSg ? state[c] : HydroCarbonState::OilOnly;
+        }
+    }
+
+    /// Switch the cells between Sg and Rv as the primary variable, the
+    /// counterpart of switchDissolvedGas for the oil vaporized in the gas.
+    /// Undersaturated cells get the state GasOnly.
+    inline void switchVaporizedOil(const int nc, const double* sw, const double* isRv,
+                                   const double* rvSat, const double* rvSat0, const double* rvOld,
+                                   double* so, double* sg, double* rv, HydroCarbonState* state)
+    {
+        const double epsilon = switchingEpsilon();
+        for (int c = 0; c < nc; ++c) {
+            const bool watOnly = sw != nullptr && sw[c] > 1.0 - epsilon;
+            const bool hasOil = so[c] > 0.0 && isRv[c] == 0.0;
+            const bool oilCondensed = rv[c] > rvSat[c] * (1.0 + epsilon) && isRv[c] == 1.0
+                && rvOld[c] > rvSat0[c] * (1.0 - epsilon);
+            const bool useSg = watOnly || hasOil || oilCondensed;
+            rv[c] = watOnly ? 0.0 : (useSg ? rvSat[c] : rv[c]);
+            so[c] = watOnly ? 0.0 : so[c];
+            sg[c] = watOnly ? 0.0 : sg[c];
+            state[c] = useSg ? state[c] : HydroCarbonState::GasOnly;
+        }
+    }
+
+} // namespace detail
+} // namespace Opm
+
+#endif // OPM_VARIABLESWITCHING_HEADER_INCLUDED
@@ -0,0 +1,114 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_WELLCHANGETRACKER_HEADER_INCLUDED
+#define OPM_WELLCHANGETRACKER_HEADER_INCLUDED
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Decides which wells need a quantity recomputed, by comparing the
+    /// values the quantity depends on with their values at the last
+    /// recomputation of each well.
+    ///
+    /// A well is flagged if any of its values changed by more than the
+    /// relative tolerance, if the number of its values changed, or if it has
+    /// not been recomputed before. All wells are flagged every
+    /// fullUpdateInterval calls, and always if the tolerance is not positive.
+    class WellChangeTracker
+    {
+    public:
+        WellChangeTracker()
+            : tolerance_(0.0)
+            , fullUpdateInterval_(1)
+            , callsSinceFullUpdate_(0)
+        {
+        }
+
+        WellChangeTracker(const double tolerance, const int fullUpdateInterval)
+            : tolerance_(tolerance)
+            , fullUpdateInterval_(std::max(fullUpdateInterval, 1))
+            , callsSinceFullUpdate_(0)
+        {
+        }
+
+        /// Flag the wells to recompute, and store their values as the
+        /// reference of the next call.
+        /// \param[in] values    the values of all wells, well w owns the values
+        ///                      [offsets[w], offsets[w+1])
+        /// \param[in] offsets   the offsets of the wells, of size nw + 1
+        /// \return              for each well if it needs to be recomputed
+        const std::vector<bool>& update(const std::vector<double>& values,
+                                        const std::vector<int>& offsets)
+        {
+            assert(!offsets.empty());
+            assert(offsets.back() == static_cast<int>(values.size()));
+            const int nw = offsets.size() - 1;
+
+            const bool fullUpdate = tolerance_ <= 0.0
+                || callsSinceFullUpdate_ % fullUpdateInterval_ == 0
+                || static_cast<int>(reference_.size()) != nw;
+            ++callsSinceFullUpdate_;
+            if (fullUpdate) {
+                callsSinceFullUpdate_ = 1;
+                reference_.assign(nw, std::vector<double>());
+            }
+
+            changed_.assign(nw, fullUpdate);
+            for (int w = 0; w < nw; ++w) {
+                std::vector<double>& reference = reference_[w];
+                const int size = offsets[w+1] - offsets[w];
+                const double* value = values.data() + offsets[w];
+
+                bool changed = fullUpdate || static_cast<int>(reference.size()) != size;
+                for (int i = 0; i < size && !changed; ++i) {
+                    const double scale = std::max(std::abs(value[i]), std::abs(reference[i]));
+                    changed = std::abs(value[i] - reference[i]) > tolerance_ * scale;
+                }
+
+                if (changed) {
+                    changed_[w] = true;
+                    reference.assign(value, value + size);
+                }
+            }
+            return changed_;
+        }
+
+        /// Force all wells to be recomputed in the next call.
+        void reset()
+        {
+            reference_.clear();
+        }
+
+    private:
+        double tolerance_;
+        int fullUpdateInterval_;
+        int callsSinceFullUpdate_;
+        std::vector< std::vector<double> > reference_;
+        std::vector<bool> changed_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_WELLCHANGETRACKER_HEADER_INCLUDED
@@ -23,6 +23,7 @@
 #include <opm/autodiff/WellStateFullyImplicitBlackoilSolvent.hpp>
 #include <opm/common/ErrorMacros.hpp>
 #include <opm/core/props/BlackoilPhases.hpp>
+#include <algorithm>
 #include <numeric>
 #include <cmath>
 
@@ -64,82 +65,94 @@ Opm::WellDensitySegmented::computeConnectionDensities(const Wells& wells,
         }
     }
 
-    // 1. Compute the flow (in surface volume units for each
+    // The wells are independent, so they are processed in parallel. For
+    // each well we
+    // 1. compute the flow (in surface volume units for each
     //    component) exiting up the wellbore from each perforation,
     //    taking into account flow from lower in the well, and
-    //    in/out-flow at each perforation.
+    //    in/out-flow at each perforation,
+    // 2. compute the component mix at each perforation as the
+    //    absolute values of the surface rates divided by their sum,
+    //    then the volume ratios (formation factors) and finally the
+    //    densities for the segments associated with each perforation.
+    const int gaspos = phase_usage.phase_pos[BlackoilPhases::Vapour];
+    const int oilpos = phase_usage.phase_pos[BlackoilPhases::Liquid];
     std::vector<double> q_out_perf(nperf*numComponents);
-    for (int w = 0; w < nw; ++w) {
-        // Iterate over well perforations from bottom to top.
-        for (int perf = wells.well_connpos[w+1] - 1; perf >= wells.well_connpos[w]; --perf) {
-            for (int component = 0; component < numComponents; ++component) {
-                if (perf == wells.well_connpos[w+1] - 1) {
+    std::vector<double> dens(nperf);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        std::vector<double> mix(numComponents);
+        std::vector<double> x(numComponents);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for (int w = 0; w < nw; ++w) {
+            const int wbeg = wells.well_connpos[w];
+            const int wend = wells.well_connpos[w+1];
+
+            // Iterate over well perforations from bottom to top.
+            for (int perf = wend - 1; perf >= wbeg; --perf) {
+                double* q_out = q_out_perf.data() + perf*numComponents;
+                const double* rate = perfComponentRates.data() + perf*numComponents;
+                if (perf == wend - 1) {
                     // This is the bottom perforation. No flow from below.
-                    q_out_perf[perf*numComponents + component] = 0.0;
+                    for (int component = 0; component < numComponents; ++component) {
+                        q_out[component] = -rate[component];
+                    }
                 } else {
-                    // Set equal to flow from below.
-                    q_out_perf[perf*numComponents + component] = q_out_perf[(perf+1)*numComponents + component];
+                    // Flow from below minus outflow through perforation.
+                    const double* q_below = q_out + numComponents;
+                    for (int component = 0; component < numComponents; ++component) {
+                        q_out[component] = q_below[component] - rate[component];
+                    }
                 }
-                // Subtract outflow through perforation.
-                q_out_perf[perf*numComponents + component] -= perfComponentRates[perf*numComponents + component];
             }
-        }
-    }
 
-    // 2. Compute the component mix at each perforation as the
-    //    absolute values of the surface rates divided by their sum.
-    //    Then compute volume ratios (formation factors) for each perforation.
-    //    Finally compute densities for the segments associated with each perforation.
-    const int gaspos = phase_usage.phase_pos[BlackoilPhases::Vapour];
-    const int oilpos = phase_usage.phase_pos[BlackoilPhases::Liquid];
-    std::vector<double> mix(numComponents,0.0);
-    std::vector<double> x(numComponents);
-    std::vector<double> surf_dens(numComponents);
-    std::vector<double> dens(nperf);
-    for (int w = 0; w < nw; ++w) {
-        for (int perf = wells.well_connpos[w]; perf < wells.well_connpos[w+1]; ++perf) {
-            // Find component mix.
-            const double tot_surf_rate = std::accumulate(q_out_perf.begin() + numComponents*perf,
-                                                         q_out_perf.begin() + numComponents*(perf+1), 0.0);
-            if (tot_surf_rate != 0.0) {
-                for (int component = 0; component < numComponents; ++component) {
-                    mix[component] = std::fabs(q_out_perf[perf*numComponents + component]/tot_surf_rate);
+            for (int perf = wbeg; perf < wend; ++perf) {
+                // Find component mix.
+                const double* q_out = q_out_perf.data() + perf*numComponents;
+                const double tot_surf_rate = std::accumulate(q_out, q_out + numComponents, 0.0);
+                if (tot_surf_rate != 0.0) {
+                    for (int component = 0; component < numComponents; ++component) {
+                        mix[component] = std::fabs(q_out[component]/tot_surf_rate);
+                    }
+                } else {
+                    // No flow => use well specified fractions for mix.
+                    std::copy(wells.comp_frac + w*np, wells.comp_frac + (w+1)*np, mix.begin());
+                    std::fill(mix.begin() + np, mix.end(), 0.0);
                 }
-            } else {
-                // No flow => use well specified fractions for mix.
-                for (int phase = 0; phase < np; ++phase) {
-                    mix[phase] = wells.comp_frac[w*np + phase];
+                // Compute volume ratio.
+                x = mix;
+                double rs = 0.0;
+                double rv = 0.0;
+                if (!rsmax_perf.empty() && mix[oilpos] > 0.0) {
+                    rs = std::min(mix[gaspos]/mix[oilpos], rsmax_perf[perf]);
+                }
+                if (!rvmax_perf.empty() && mix[gaspos] > 0.0) {
+                    rv = std::min(mix[oilpos]/mix[gaspos], rvmax_perf[perf]);
+                }
+                if (rs != 0.0) {
+                    // Subtract gas in oil from gas mixture
+                    x[gaspos] = (mix[gaspos] - mix[oilpos]*rs)/(1.0 - rs*rv);
+                }
+                if (rv != 0.0) {
+                    // Subtract oil in gas from oil mixture
+                    x[oilpos] = (mix[oilpos] - mix[gaspos]*rv)/(1.0 - rs*rv);
+                }
+                const double* b = b_perf.data() + perf*numComponents;
+                const double* surf_dens = surf_dens_perf.data() + perf*numComponents;
+                double volrat = 0.0;
+                double mass = 0.0;
+                for (int component = 0; component < numComponents; ++component) {
+                    volrat += x[component] / b[component];
+                    mass += surf_dens[component] * mix[component];
                 }
-                // intialize 0.0 for comIdx >= np;
-            }
-            // Compute volume ratio.
-            x = mix;
-            double rs = 0.0;
-            double rv = 0.0;
-            if (!rsmax_perf.empty() && mix[oilpos] > 0.0) {
-                rs = std::min(mix[gaspos]/mix[oilpos], rsmax_perf[perf]);
-            }
-            if (!rvmax_perf.empty() && mix[gaspos] > 0.0) {
-                rv = std::min(mix[oilpos]/mix[gaspos], rvmax_perf[perf]);
-            }
-            if (rs != 0.0) {
-                // Subtract gas in oil from gas mixture
-                x[gaspos] = (mix[gaspos] - mix[oilpos]*rs)/(1.0 - rs*rv);
-            }
-            if (rv != 0.0) {
-                // Subtract oil in gas from oil mixture
-                x[oilpos] = (mix[oilpos] - mix[gaspos]*rv)/(1.0 - rs*rv);;
-            }
-            double volrat = 0.0;
-            for (int component = 0; component < numComponents; ++component) {
-                volrat += x[component] / b_perf[perf*numComponents + component];
-            }
-            for (int component = 0; component < numComponents; ++component) {
-                surf_dens[component] = surf_dens_perf[perf*numComponents + component];
-            }
 
-            // Compute segment density.
-            dens[perf] = std::inner_product(surf_dens.begin(), surf_dens.end(), mix.begin(), 0.0) / volrat;
+                // Compute segment density.
+                dens[perf] = mass / volrat;
+            }
         }
     }
 
@@ -282,36 +295,76 @@ Opm::WellDensitySegmented::computeConnectionPressureDelta(const Wells& wells,
         OPM_THROW(std::logic_error, "Inconsistent input: wells vs. dens_perf.");
     }
 
-    // Algorithm:
+    return computeConnectionPressureDeltaFromDepthDifferences(wells,
+                                                              computePerforationDepthDifferences(wells, z_perf),
+                                                              dens_perf, gravity);
+}
+
+
+
+
+std::vector<double>
+Opm::WellDensitySegmented::computePerforationDepthDifferences(const Wells& wells,
+                                                              const std::vector<double>& z_perf)
+{
+    const int nw = wells.number_of_wells;
+    const int nperf = wells.well_connpos[nw];
+
+    if (nperf != int(z_perf.size())) {
+        OPM_THROW(std::logic_error, "Inconsistent input: wells vs. z_perf.");
+    }
 
     // We'll assume the perforations are given in order from top to
     // bottom for each well.  By top and bottom we do not necessarily
     // mean in a geometric sense (depth), but in a topological sense:
     // the 'top' perforation is nearest to the surface topologically.
-    // Our goal is to compute a pressure delta for each perforation.
-
-    // 1. Compute pressure differences between perforations.
-    //    dp_perf will contain the pressure difference between a
-    //    perforation and the one above it, except for the first
-    //    perforation for each well, for which it will be the
-    //    difference to the reference (bhp) depth.
-    std::vector<double> dp_perf(nperf);
+    // dz_perf will contain the depth difference between a perforation
+    // and the one above it, except for the first perforation for each
+    // well, for which it will be the difference to the reference (bhp)
+    // depth.
+    std::vector<double> dz_perf(nperf);
     for (int w = 0; w < nw; ++w) {
         for (int perf = wells.well_connpos[w]; perf < wells.well_connpos[w+1]; ++perf) {
             const double z_above = perf == wells.well_connpos[w] ? wells.depth_ref[w] : z_perf[perf - 1];
-            const double dz = z_perf[perf] - z_above;
-            dp_perf[perf] = dz * dens_perf[perf] * gravity;
+            dz_perf[perf] = z_perf[perf] - z_above;
         }
     }
+    return dz_perf;
+}
+
+
+
+
+std::vector<double>
+Opm::WellDensitySegmented::computeConnectionPressureDeltaFromDepthDifferences(const Wells& wells,
+                                                                              const std::vector<double>& dz_perf,
+                                                                              const std::vector<double>& dens_perf,
+                                                                              const double gravity)
+{
+    const int nw = wells.number_of_wells;
+    const int nperf = wells.well_connpos[nw];
+
+    if (nperf != int(dz_perf.size())) {
+        OPM_THROW(std::logic_error, "Inconsistent input: wells vs. dz_perf.");
+    }
+    if (nperf != int(dens_perf.size())) {
+        OPM_THROW(std::logic_error, "Inconsistent input: wells vs. dens_perf.");
+    }
 
-    // 2. Compute pressure differences to the reference point (bhp) by
-    //    accumulating the already computed adjacent pressure
-    //    differences, storing the result in dp_perf.
-    //    This accumulation must be done per well.
+    // The pressure difference between a perforation and the one above
+    // it is dz * dens * gravity. The pressure differences to the
+    // reference point (bhp) are the running sums of those along each
+    // well, the wells are accumulated in parallel.
+    std::vector<double> dp_perf(nperf);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
     for (int w = 0; w < nw; ++w) {
-        const auto beg = dp_perf.begin() + wells.well_connpos[w];
-        const auto end = dp_perf.begin() + wells.well_connpos[w + 1];
-        std::partial_sum(beg, end, beg);
+        double dp = 0.0;
+        for (int perf = wells.well_connpos[w]; perf < wells.well_connpos[w+1]; ++perf) {
+            dp += dz_perf[perf] * dens_perf[perf] * gravity;
+            dp_perf[perf] = dp;
+        }
     }
 
     return dp_perf;
@@ -89,6 +89,31 @@ namespace Opm
                                                                   const std::vector<double>& z_perf,
                                                                   const std::vector<double>& dens_perf,
                                                                   const double gravity);
+
+
+
+        /// Compute the depth difference of each perforation to the one
+        /// above it, or to the reference depth for the top perforation of
+        /// each well. The result only depends on the well geometry and may
+        /// be computed once and reused for computeConnectionPressureDeltaFromDepthDifferences().
+        /// Notation: N = number of perforations
+        /// \param[in] wells        struct with static well info
+        /// \param[in] z_perf       depth values for each perforation, size N
+        static std::vector<double> computePerforationDepthDifferences(const Wells& wells,
+                                                                      const std::vector<double>& z_perf);
+
+
+
+        /// Compute pressure deltas from precomputed perforation depth differences.
+        /// Notation: N = number of perforations
+        /// \param[in] wells        struct with static well info
+        /// \param[in] dz_perf      depth differences for each perforation, size N (typically computed using computePerforationDepthDifferences)
+        /// \param[in] dens_perf    densities for each perforation, size N (typically computed using computeConnectionDensities)
+        /// \param[in] gravity      gravity acceleration constant
+        static std::vector<double> computeConnectionPressureDeltaFromDepthDifferences(const Wells& wells,
+                                                                                      const std::vector<double>& dz_perf,
+                                                                                      const std::vector<double>& dens_perf,
+                                                                                      const double gravity);
     };
 
 } // namespace Opm
@@ -265,6 +265,25 @@ namespace Opm
             is_new_well_[w] = is_new_well;
         }
 
+    protected:
+        /// Exchange the state of this class and of WellState with another
+        /// well state without copying. Derived classes with members of
+        /// their own call this from a swap() that exchanges those.
+        void swapBase(WellStateFullyImplicitBlackoil& other)
+        {
+            bhp().swap(other.bhp());
+            thp().swap(other.thp());
+            temperature().swap(other.temperature());
+            wellRates().swap(other.wellRates());
+            perfRates().swap(other.perfRates());
+            perfPress().swap(other.perfPress());
+            wellMap().swap(other.wellMap());
+            wells_.swap(other.wells_);
+            perfphaserates_.swap(other.perfphaserates_);
+            current_controls_.swap(other.current_controls_);
+            is_new_well_.swap(other.is_new_well_);
+        }
+
     private:
         std::vector<double> perfphaserates_;
         std::vector<int> current_controls_;
@@ -69,6 +69,8 @@ namespace Opm
 
 
             const int nw = wells->number_of_wells;
+            worst_water_cut_connection_.assign(nw, -1);
+            worst_water_cut_.assign(nw, 0.0);
             if (nw == 0) {
                 return;
             }
@@ -220,6 +222,15 @@ namespace Opm
         std::vector<double>& perfRateSolvent() { return perfRateSolvent_; }
         const std::vector<double>& perfRateSolvent() const { return perfRateSolvent_; }
 
+        /// The connection of each well with the largest water cut of the
+        /// perforation rates, counted from the first perforation of the well,
+        /// and its water cut. The connection is -1 if no connection produces
+        /// water or the perforation rates have not been assembled yet.
+        std::vector<int>& worstWaterCutConnection() { return worst_water_cut_connection_; }
+        const std::vector<int>& worstWaterCutConnection() const { return worst_water_cut_connection_; }
+        std::vector<double>& worstWaterCut() { return worst_water_cut_; }
+        const std::vector<double>& worstWaterCut() const { return worst_water_cut_; }
+
         /// One rate pr well
         double solventWellRate(const int w) const {
             double solvent_well_rate = 0.0;
@@ -230,6 +241,18 @@ namespace Opm
         }
 
 
+        /// Exchange the contents with another well state without
+        /// copying, e.g. to keep the state of the last report step.
+        void swap(WellStateFullyImplicitBlackoilDense& other)
+        {
+            BaseType::swapBase(other);
+            well_solutions_.swap(other.well_solutions_);
+            perfRateSolvent_.swap(other.perfRateSolvent_);
+            worst_water_cut_connection_.swap(other.worst_water_cut_connection_);
+            worst_water_cut_.swap(other.worst_water_cut_);
+        }
+
+
         data::Wells report(const PhaseUsage& pu) const override {
             data::Wells res = BaseType::report(pu);
             const int nw = WellState::numWells();
@@ -253,6 +276,8 @@ namespace Opm
     private:
         std::vector<double> well_solutions_;
         std::vector<double> perfRateSolvent_;
+        std::vector<int> worst_water_cut_connection_;
+        std::vector<double> worst_water_cut_;
 
     };
 
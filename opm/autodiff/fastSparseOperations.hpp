@@ -14,10 +14,13 @@
 
 #include <Eigen/Sparse>
 
+#include <opm/autodiff/AutoDiffStencil.hpp>
+
 #include <algorithm>
 #include <iterator>
 #include <functional>
 #include <limits>
+#include <list>
 #include <vector>
 
 #include <Eigen/Core>
@@ -142,7 +145,116 @@ void fastSparseProduct(const Lhs& lhs, const Rhs& rhs, ResultType& res)
 
 
 
-inline void fastDiagSparseProduct(const std::vector<double>& lhs,
+// true if the compressed column major matrix s has the given pattern
+inline bool
+hasStencilPattern(const Eigen::SparseMatrix<double>& s, const StencilPattern& pattern)
+{
+    if( s.rows() != pattern.rows() || s.cols() != pattern.cols() || s.nonZeros() != pattern.nonZeros() ) {
+        return false;
+    }
+    return std::equal(pattern.outer().begin(), pattern.outer().end(), s.outerIndexPtr())
+        && std::equal(pattern.inner().begin(), pattern.inner().end(), s.innerIndexPtr());
+}
+
+// the pattern of the compressed column major matrix s
+inline StencilPattern::Pointer
+stencilPatternOf(const Eigen::SparseMatrix<double>& s)
+{
+    std::vector<int> outer(s.outerIndexPtr(), s.outerIndexPtr() + s.outerSize() + 1);
+    std::vector<int> inner(s.innerIndexPtr(), s.innerIndexPtr() + s.nonZeros());
+    return StencilPattern::create(s.rows(), s.cols(), std::move(outer), std::move(inner));
+}
+
+/// Symbolic products of sparse matrices recently multiplied by the
+/// calling thread, keyed by the patterns of the operands.
+///
+/// The operands of many products, e.g. the divergence of the fluxes,
+/// have the same patterns in every Newton iteration. For these only the
+/// numeric part of the product is computed. Unlike fastSparseProduct
+/// the result keeps entries that happen to be zero, such that its
+/// pattern only depends on the patterns of the operands.
+class SparseProductCache
+{
+public:
+    /// Compute res = lhs * rhs, reusing the symbolic product if the
+    /// patterns of lhs and rhs have been multiplied before.
+    static void multiply(const Eigen::SparseMatrix<double>& lhs,
+                         const Eigen::SparseMatrix<double>& rhs,
+                         Eigen::SparseMatrix<double>& res)
+    {
+        if( lhs.nonZeros() == 0 || rhs.nonZeros() == 0 || !lhs.isCompressed() || !rhs.isCompressed() ) {
+            fastSparseProduct(lhs, rhs, res);
+            return;
+        }
+
+        const Entry& entry = instance().lookup(lhs, rhs);
+        const StencilPattern::Product& plan = *entry.product;
+        const StencilPattern& pattern = *plan.pattern;
+
+        res.resize(lhs.rows(), rhs.cols());
+        res.resizeNonZeros(pattern.nonZeros());
+        std::copy(pattern.outer().begin(), pattern.outer().end(), res.outerIndexPtr());
+        std::copy(pattern.inner().begin(), pattern.inner().end(), res.innerIndexPtr());
+
+        const double* lhsV = lhs.valuePtr();
+        const double* rhsV = rhs.valuePtr();
+        double* resV = res.valuePtr();
+        const int nnz = pattern.nonZeros();
+        for (int k = 0; k < nnz; ++k) {
+            double value = 0.0;
+            for (int t = plan.start[k]; t < plan.start[k + 1]; ++t) {
+                value += lhsV[plan.lhs[t]] * rhsV[plan.rhs[t]];
+            }
+            resV[k] = value;
+        }
+    }
+
+    /// Number of symbolic products kept per thread.
+    static const std::size_t maxEntries = 16;
+
+private:
+    struct Entry
+    {
+        StencilPattern::Pointer lhs;
+        StencilPattern::Pointer rhs;
+        std::shared_ptr<const StencilPattern::Product> product;
+    };
+
+    static SparseProductCache& instance()
+    {
+        static thread_local SparseProductCache cache;
+        return cache;
+    }
+
+    // the entry of the patterns of lhs and rhs, most recently used first
+    const Entry& lookup(const Eigen::SparseMatrix<double>& lhs,
+                        const Eigen::SparseMatrix<double>& rhs)
+    {
+        for (auto entry = entries_.begin(); entry != entries_.end(); ++entry) {
+            if( hasStencilPattern(lhs, *entry->lhs) && hasStencilPattern(rhs, *entry->rhs) ) {
+                entries_.splice(entries_.begin(), entries_, entry);
+                return entries_.front();
+            }
+        }
+
+        Entry entry;
+        entry.lhs = stencilPatternOf(lhs);
+        entry.rhs = stencilPatternOf(rhs);
+        entry.product = entry.lhs->product(entry.rhs);
+        entries_.push_front(std::move(entry));
+        if( entries_.size() > maxEntries ) {
+            entries_.pop_back();
+        }
+        return entries_.front();
+    }
+
+    std::list<Entry> entries_;
+};
+
+
+
+template<typename Diag>
+inline void fastDiagSparseProduct(const Diag& lhs,
                                   const Eigen::SparseMatrix<double>& rhs,
                                   Eigen::SparseMatrix<double>& res)
 {
@@ -161,8 +273,9 @@ inline void fastDiagSparseProduct(const std::vector<double>& lhs,
 
 
 
+template<typename Diag>
 inline void fastSparseDiagProduct(const Eigen::SparseMatrix<double>& lhs,
-                                  const std::vector<double>& rhs,
+                                  const Diag& rhs,
                                   Eigen::SparseMatrix<double>& res)
 {
     res = lhs;
@@ -177,6 +290,21 @@ inline void fastSparseDiagProduct(const Eigen::SparseMatrix<double>& lhs,
     }
 }
 
+// this function multiplies the rows of a sparse matrix by the
+// elements of d in place, i.e. computes diag(d) * mat
+template<typename Diag>
+inline void fastDiagSparseScale(const Diag& d,
+                                Eigen::SparseMatrix<double>& mat)
+{
+    int n = mat.cols();
+    for (int col = 0; col < n; ++col) {
+        typedef Eigen::SparseMatrix<double>::InnerIterator It;
+        for (It it(mat, col); it; ++it) {
+            it.valueRef() *= d[it.row()];
+        }
+    }
+}
+
 template<typename Lhs, typename Rhs>
 inline bool
 equalSparsityPattern(const Lhs& lhs, const Rhs& rhs)
@@ -279,6 +407,39 @@ fastSparseSubstract(Lhs& lhs, const Rhs& rhs)
     }
 }
 
+// this function adds diag(d) * rhs to lhs
+// if the sparsity pattern is the same no temporary is created
+template<typename Diag>
+inline void
+fastSparseAddDiagProduct(Eigen::SparseMatrix<double>& lhs,
+                         const Diag& d,
+                         const Eigen::SparseMatrix<double>& rhs)
+{
+    if( equalSparsityPattern( lhs, rhs ) )
+    {
+        typedef Eigen::SparseMatrix<double>::Index Index;
+        const Index outerSize = rhs.outerSize();
+
+        // the inner index of the column major storage is the row
+        const auto outer = rhs.outerIndexPtr();
+        const auto inner = rhs.innerIndexPtr();
+        const double* rhsV = rhs.valuePtr();
+        double* lhsV = lhs.valuePtr();
+
+        for (Index col = 0; col < outerSize; ++col) {
+            for (Index i = outer[ col ]; i < outer[ col + 1 ]; ++i) {
+                lhsV[ i ] += d[ inner[ i ] ] * rhsV[ i ];
+            }
+        }
+    }
+    else
+    {
+        Eigen::SparseMatrix<double> scaled = rhs;
+        fastDiagSparseScale( d, scaled );
+        lhs += scaled;
+    }
+}
+
 } // end namespace Opm
 
 #endif // OPM_FASTSPARSEPRODUCT_HEADER_INCLUDED
@@ -84,5 +84,35 @@ namespace Opm
     }
 
 
+
+    void multiPhaseUpwind(const int num_connections,
+                          const int* connection_cells,
+                          const std::array<const double*, 3>& head_diff,
+                          const std::array<const double*, 3>& mob,
+                          const double* transmissibility,
+                          const double* flux,
+                          const std::array<double*, 3>& upwind)
+    {
+        enum { NumPhases = 3 };
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (int conn = 0; conn < num_connections; ++conn) {
+            const int a = connection_cells[2*conn];     // first cell of connection
+            const int b = connection_cells[2*conn + 1]; // second cell of connection
+            std::array<double, NumPhases> dh, mob1, mob2;
+            for (int phase = 0; phase < NumPhases; ++phase) {
+                dh[phase] = head_diff[phase][conn];
+                mob1[phase] = mob[phase][a];
+                mob2[phase] = mob[phase][b];
+            }
+            const auto up = connectionMultiPhaseUpwind(dh, mob1, mob2, transmissibility[conn], flux[conn]);
+            for (int phase = 0; phase < NumPhases; ++phase) {
+                upwind[phase][conn] = up[phase];
+            }
+        }
+    }
+
+
 } // namespace Opm
 
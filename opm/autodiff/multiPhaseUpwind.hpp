@@ -40,6 +40,27 @@ namespace Opm
                                                      const std::array<double, 3>& mob2,
                                                      const double transmissibility,
                                                      const double flux);
+
+    /// Compute upwind directions for three-phase flow across all connections,
+    /// as connectionMultiPhaseUpwind() does for each of them.
+    ///
+    /// @param[in]  num_connections     number of connections
+    /// @param[in]  connection_cells    first and second cell of each connection,
+    ///                                 2*num_connections entries
+    /// @param[in]  head_diff           head differences, one array over the connections per phase
+    /// @param[in]  mob                 mobilities, one array over the cells per phase
+    /// @param[in]  transmissibility    tranmissibilities of the connections
+    /// @param[in]  flux                total volume fluxes across the connections
+    /// @param[out] upwind              one array over the connections per phase, 1.0 if flow
+    ///                                 in the direction of the connection, -1.0 if flow in
+    ///                                 the opposite direction.
+    void multiPhaseUpwind(const int num_connections,
+                          const int* connection_cells,
+                          const std::array<const double*, 3>& head_diff,
+                          const std::array<const double*, 3>& mob,
+                          const double* transmissibility,
+                          const double* flux,
+                          const std::array<double*, 3>& upwind);
 } // namespace Opm
 
 #endif // OPM_MULTIPHASEUPWIND_HEADER_INCLUDED
@@ -141,8 +141,9 @@ namespace Opm
         cell_phasemob_.resize(nc*np);
         for (int cell = 0; cell < nc; ++cell) {
             poly_props_.effectiveVisc((*c_)[cell], cell_viscosity_[np*cell + 0], cell_eff_viscosity_[np*cell + 0]);
-            poly_props_.effectiveMobilities((*c_)[cell], (*cmax_)[cell], &cell_viscosity_[np*cell + 0], &cell_relperm_[np*cell + 0], &cell_phasemob_[np*cell + 0]);
         }
+        poly_props_.effectiveMobilities(nc, c_->data(), cmax_->data(), cell_viscosity_.data(), np,
+                                        cell_relperm_.data(), cell_phasemob_.data());
 
         // Volume discrepancy: we have that
         //     z = Au, voldiscr = sum(u) - 1,
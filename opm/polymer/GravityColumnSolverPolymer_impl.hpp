@@ -43,6 +43,7 @@
 #include <iostream>
 #include <cmath>
 #include <algorithm>
+#include <exception>
 
 namespace Opm
 {
@@ -141,10 +142,25 @@ namespace Opm
         const double tol_c_cell = 1e-2*cmax_cell; 
 	while (iter < maxit_) {
 	    fmodel_.initIteration(state, grid_, sys);
+            // The columns have no cells in common and only write the
+            // increments of their own cells, so they are solved in parallel.
             int size = columns.size();
+            std::exception_ptr error;
+#pragma omp parallel for schedule(dynamic)
             for(int i = 0; i < size; ++i) {
-		solveSingleColumn(columns[i], dt, s, c, cmax, increment);
+                try {
+                    solveSingleColumn(columns[i], dt, s, c, cmax, increment);
+                }
+                catch (...) {
+#pragma omp critical
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
 	    }
+            if (error) {
+                std::rethrow_exception(error);
+            }
 	    for (int cell = 0; cell < grid_.number_of_cells; ++cell) {
                 double& s_cell = sys.vector().writableSolution()[2*cell + 0];
                 double& c_cell = sys.vector().writableSolution()[2*cell + 1];
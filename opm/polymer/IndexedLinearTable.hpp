@@ -0,0 +1,127 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_INDEXEDLINEARTABLE_HEADER_INCLUDED
+#define OPM_INDEXEDLINEARTABLE_HEADER_INCLUDED
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace Opm {
+
+    namespace detail {
+
+        /// Piecewise linear function of a table with a uniform grid index.
+        ///
+        /// The table is evaluated as by Opm::linearInterpolation(), i.e. x
+        /// is located in the last interval whose start is not above x and
+        /// the function is extrapolated linearly outside the table. The
+        /// interval of x is found from a uniform grid over the table,
+        /// which stores for every grid cell the interval containing its
+        /// start, and a few steps from there. The lookup is thereby O(1)
+        /// for tables that are not extremely non-uniform, while the table
+        /// points are kept exactly instead of resampling the table.
+        class IndexedLinearTable
+        {
+        public:
+            IndexedLinearTable()
+                : x0_(0.0), inv_h_(0.0)
+            {
+            }
+
+            /// Construct from at least two strictly increasing x values
+            /// and their function values.
+            IndexedLinearTable(const std::vector<double>& x, const std::vector<double>& y)
+                : x_(x), y_(y), x0_(0.0), inv_h_(0.0)
+            {
+                assert(x_.size() == y_.size());
+                assert(x_.size() >= 2);
+                const int n = x_.size();
+                slope_.resize(n - 1);
+                for (int i = 0; i < n - 1; ++i) {
+                    slope_[i] = (y_[i + 1] - y_[i]) / (x_[i + 1] - x_[i]);
+                }
+
+                const int num_cells = gridCellsPerInterval * (n - 1);
+                x0_ = x_[0];
+                inv_h_ = num_cells / (x_.back() - x_[0]);
+                start_.resize(num_cells);
+                int i = 0;
+                for (int cell = 0; cell < num_cells; ++cell) {
+                    const double start = x0_ + cell / inv_h_;
+                    while (i < n - 2 && x_[i + 1] <= start) {
+                        ++i;
+                    }
+                    start_[cell] = i;
+                }
+            }
+
+            bool empty() const { return x_.empty(); }
+
+            /// Index of the interval used for x.
+            int interval(const double x) const
+            {
+                assert(!empty());
+                const double t = (x - x0_) * inv_h_;
+                const int last_cell = start_.size() - 1;
+                // the comparisons also map NaN to the first cell
+                const int cell = t > 0.0 ? (t < last_cell ? int(t) : last_cell) : 0;
+                int i = start_[cell];
+                // correct for rounding in the cell of x
+                while (i > 0 && x < x_[i]) {
+                    --i;
+                }
+                const int last = x_.size() - 2;
+                while (i < last && x >= x_[i + 1]) {
+                    ++i;
+                }
+                return i;
+            }
+
+            double operator()(const double x) const
+            {
+                const int i = interval(x);
+                return slope_[i] * (x - x_[i]) + y_[i];
+            }
+
+            /// Function value and derivative at x.
+            double evaluate(const double x, double& derivative) const
+            {
+                const int i = interval(x);
+                derivative = slope_[i];
+                return slope_[i] * (x - x_[i]) + y_[i];
+            }
+
+        private:
+            static const int gridCellsPerInterval = 4;
+
+            std::vector<double> x_;
+            std::vector<double> y_;
+            std::vector<double> slope_;
+            std::vector<int> start_;
+            double x0_;
+            double inv_h_;
+        };
+
+    } // namespace detail
+
+} // namespace Opm
+
+#endif // OPM_INDEXEDLINEARTABLE_HEADER_INCLUDED
@@ -21,6 +21,7 @@
 
 #include <opm/polymer/PolymerProperties.hpp>
 #include <opm/polymer/Point2D.hpp>
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <vector>
@@ -134,13 +135,40 @@ namespace Opm
 
     double PolymerProperties::viscMult(double c) const
     {
-        return Opm::linearInterpolation(c_vals_visc_, visc_mult_vals_, c);
+        if (visc_table_.empty()) {
+            return Opm::linearInterpolation(c_vals_visc_, visc_mult_vals_, c);
+        }
+        return visc_table_(c);
     }
 
     double PolymerProperties::viscMultWithDer(double c, double* der) const
     {
-        *der = Opm::linearInterpolationDerivative(c_vals_visc_, visc_mult_vals_, c);
-        return Opm::linearInterpolation(c_vals_visc_, visc_mult_vals_, c);
+        if (visc_table_.empty()) {
+            *der = Opm::linearInterpolationDerivative(c_vals_visc_, visc_mult_vals_, c);
+            return Opm::linearInterpolation(c_vals_visc_, visc_mult_vals_, c);
+        }
+        return visc_table_.evaluate(c, *der);
+    }
+
+    void PolymerProperties::viscMult(const int n, const double* c,
+                                     double* visc_mult, double* dvisc_mult_dc) const
+    {
+        if (visc_table_.empty()) {
+            for (int i = 0; i < n; ++i) {
+                visc_mult[i] = Opm::linearInterpolation(c_vals_visc_, visc_mult_vals_, c[i]);
+                if (dvisc_mult_dc) {
+                    dvisc_mult_dc[i] = Opm::linearInterpolationDerivative(c_vals_visc_, visc_mult_vals_, c[i]);
+                }
+            }
+        } else if (dvisc_mult_dc) {
+            for (int i = 0; i < n; ++i) {
+                visc_mult[i] = visc_table_.evaluate(c[i], dvisc_mult_dc[i]);
+            }
+        } else {
+            for (int i = 0; i < n; ++i) {
+                visc_mult[i] = visc_table_(c[i]);
+            }
+        }
     }
 
     void PolymerProperties::simpleAdsorption(double c, double& c_ads) const
@@ -158,11 +186,14 @@ namespace Opm
     void PolymerProperties::simpleAdsorptionBoth(double c, double& c_ads,
                                                  double& dc_ads_dc, bool if_with_der) const
     {
-        c_ads = Opm::linearInterpolation(c_vals_ads_, ads_vals_, c);;
-        if (if_with_der) {
-            dc_ads_dc = Opm::linearInterpolationDerivative(c_vals_ads_, ads_vals_, c);
+        if (ads_table_.empty()) {
+            c_ads = Opm::linearInterpolation(c_vals_ads_, ads_vals_, c);
+            dc_ads_dc = if_with_der ? Opm::linearInterpolationDerivative(c_vals_ads_, ads_vals_, c) : 0.;
         } else {
-            dc_ads_dc = 0.;
+            c_ads = ads_table_.evaluate(c, dc_ads_dc);
+            if (!if_with_der) {
+                dc_ads_dc = 0.;
+            }
         }
     }
 
@@ -191,6 +222,20 @@ namespace Opm
         }
     }
 
+    void PolymerProperties::adsorption(const int n, const double* c, const double* cmax,
+                                       double* c_ads, double* dc_ads_dc) const
+    {
+        if (ads_index_ != Desorption && ads_index_ != NoDesorption) {
+            OPM_THROW(std::runtime_error, "Invalid Adsoption index");
+        }
+        const bool desorption = ads_index_ == Desorption;
+        double dummy;
+        for (int i = 0; i < n; ++i) {
+            const double ci = desorption ? c[i] : std::max(c[i], cmax[i]);
+            simpleAdsorptionBoth(ci, c_ads[i], dc_ads_dc ? dc_ads_dc[i] : dummy, dc_ads_dc != nullptr);
+        }
+    }
+
 
     void PolymerProperties::effectiveVisc(const double c, const double mu_w, double& mu_w_eff) const {
         effectiveInvVisc(c, mu_w, mu_w_eff);
@@ -399,6 +444,35 @@ namespace Opm
         }
     }
 
+    void PolymerProperties::effectiveMobilities(const int n, const double* c, const double* cmax,
+                                                const double* visc, const int visc_stride,
+                                                const double* relperm, double* mob) const
+    {
+        // the table lookups of all cells first, then the arithmetic of
+        // effectiveMobilitiesBoth() in a loop without calls
+        std::vector<double> visc_mult(n);
+        std::vector<double> c_ads(n);
+        viscMult(n, c, visc_mult.data(), nullptr);
+        adsorption(n, c, cmax, c_ads.data(), nullptr);
+        const double omega = mix_param_;
+        const double visc_mult_max = viscMult(c_max_);
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; ++i) {
+            const double* visc_cell = visc + i*visc_stride;
+            const double mu_w = visc_cell[0];
+            const double cbar = c[i]/c_max_;
+            const double mu_m = visc_mult[i]*mu_w;
+            const double mu_p = visc_mult_max*mu_w;
+            const double inv_mu_m_omega = std::pow(mu_m, -omega);
+            const double inv_mu_w_e   = inv_mu_m_omega*std::pow(mu_w, omega - 1.);
+            const double inv_mu_p_eff = inv_mu_m_omega*std::pow(mu_p, omega - 1.);
+            const double inv_mu_w_eff = (1.0 - cbar)*inv_mu_w_e + cbar*inv_mu_p_eff;
+            const double rk = 1 + (res_factor_ - 1)*c_ads[i]/c_max_ads_;
+            mob[2*i]     = relperm[2*i]/rk*inv_mu_w_eff;
+            mob[2*i + 1] = relperm[2*i + 1]/visc_cell[1];
+        }
+    }
+
     void PolymerProperties::effectiveTotalMobility(const double c,
                                                    const double cmax,
                                                    const double* visc,
@@ -460,24 +534,55 @@ namespace Opm
     void PolymerProperties::computeMcBoth(const double& c, double& mc,
                                           double& dmc_dc, bool if_with_der) const
     {
-        double cbar = c/c_max_;
-        double omega = mix_param_;
-        double r = std::pow(viscMult(c_max_), 1 - omega); // viscMult(c_max_)=mu_p/mu_w
-        mc = c/(cbar + (1 - cbar)*r);
+        const double cbar = c/c_max_;
+        const double r = mc_ratio_;
+        const double denom = cbar + (1 - cbar)*r;
+        mc = c/denom;
         if (if_with_der) {
-            dmc_dc = r/std::pow(cbar + (1 - cbar)*r, 2);
+            dmc_dc = r/(denom*denom);
         } else {
             dmc_dc = 0.;
         }
     }
 
+    void PolymerProperties::computeMc(const int n, const double* c,
+                                      double* mc, double* dmc_dc) const
+    {
+        const double r = mc_ratio_;
+        if (dmc_dc) {
+            for (int i = 0; i < n; ++i) {
+                const double cbar = c[i]/c_max_;
+                const double denom = cbar + (1 - cbar)*r;
+                mc[i] = c[i]/denom;
+                dmc_dc[i] = r/(denom*denom);
+            }
+        } else {
+            for (int i = 0; i < n; ++i) {
+                const double cbar = c[i]/c_max_;
+                mc[i] = c[i]/(cbar + (1 - cbar)*r);
+            }
+        }
+    }
+
+    void PolymerProperties::updateTables()
+    {
+        visc_table_ = c_vals_visc_.size() >= 2
+            ? detail::IndexedLinearTable(c_vals_visc_, visc_mult_vals_)
+            : detail::IndexedLinearTable();
+        ads_table_ = c_vals_ads_.size() >= 2
+            ? detail::IndexedLinearTable(c_vals_ads_, ads_vals_)
+            : detail::IndexedLinearTable();
+        // viscMult(c_max_)=mu_p/mu_w
+        mc_ratio_ = c_vals_visc_.empty() ? 1.0 : std::pow(viscMult(c_max_), 1 - mix_param_);
+    }
+
     bool PolymerProperties::computeShearMultLog(std::vector<double>& water_vel, std::vector<double>& visc_mult, std::vector<double>& shear_mult) const
     {
 
         double refConcentration = plyshlogRefConc();
         double refViscMult = viscMult(refConcentration);
 
-        std::vector<double> shear_water_vel = shearWaterVelocity();
+        const std::vector<double>& shear_water_vel = shearWaterVelocity();
         std::vector<double> shear_vrf = shearViscosityReductionFactor();
 
         std::vector<double> logShearWaterVel;
@@ -506,10 +611,12 @@ namespace Opm
                  continue;
             }
 
-            for (size_t j = 0; j < shear_vrf.size(); ++j) {
-                logShearVRF[j] = (1 + (visc_mult[i] - 1.0) * shear_vrf[j]) / visc_mult[i];
-                logShearVRF[j] = std::log(logShearVRF[j]);
-            }
+            // the logarithms of the converted table are only evaluated as
+            // far as the search for the intersection gets
+            const double viscMultCell = visc_mult[i];
+            auto logVRF = [&](const size_t j) {
+                return std::log((1 + (viscMultCell - 1.0) * shear_vrf[j]) / viscMultCell);
+            };
 
             // const double logWaterVelO = std::log(water_vel[i]);
             const double logWaterVelO = std::log(std::abs(water_vel[i]));
@@ -517,8 +624,10 @@ namespace Opm
             size_t iIntersection; // finding the intersection on the iIntersectionth table segment
             bool foundSegment = false;
 
+            logShearVRF[0] = logVRF(0);
             for (iIntersection = 0; iIntersection < shear_vrf.size() - 1; ++iIntersection) {
 
+                logShearVRF[iIntersection + 1] = logVRF(iIntersection + 1);
                 double temp1 = logShearVRF[iIntersection] + logShearWaterVel[iIntersection] - logWaterVelO;
                 double temp2 = logShearVRF[iIntersection + 1] + logShearWaterVel[iIntersection + 1] - logWaterVelO;
 
@@ -550,6 +659,7 @@ namespace Opm
                     return false; // failed in finding the solution.
                 }
             } else {
+                // all of the table has been evaluated by the search
                 // check if the failure in finding the shear multiplier is due to too big water velocity.
                 if ((logWaterVelO - logShearVRF.back()) < logShearWaterVel.back()) {
                     std::cout << " the veclocity is " << water_vel[i] << std::endl;
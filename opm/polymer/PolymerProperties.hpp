@@ -32,6 +32,8 @@
 #include <opm/parser/eclipse/Units/UnitSystem.hpp>
 
 
+#include <opm/polymer/IndexedLinearTable.hpp>
+
 #include <cmath>
 #include <vector>
 #include <opm/common/ErrorMacros.hpp>
@@ -90,6 +92,7 @@ namespace Opm
               water_vel_vals_(water_vel_vals),
               shear_vrf_vals_(shear_vrf_vals)
         {
+            updateTables();
         }
 
         PolymerProperties(const Opm::Deck& deck, const Opm::EclipseState& eclipseState)
@@ -125,6 +128,7 @@ namespace Opm
             ads_index_ = ads_index;
             water_vel_vals_ = water_vel_vals;
             shear_vrf_vals_ = shear_vrf_vals;
+            updateTables();
         }
 
         void readFromDeck(const Opm::Deck& deck, const Opm::EclipseState& eclipseState)
@@ -214,6 +218,8 @@ namespace Opm
                     has_plyshlog_ref_temp_ = false;
                 }
             }
+
+            updateTables();
         }
 
         double cMax() const;
@@ -371,6 +377,25 @@ namespace Opm
         void computeMcBoth(const double& c, double& mc,
                            double& dmc_dc, bool if_with_der) const;
 
+        /// Batch versions over n cells. The derivatives are only computed
+        /// if their pointer is not null.
+        void viscMult(const int n, const double* c,
+                      double* visc_mult, double* dvisc_mult_dc) const;
+
+        void computeMc(const int n, const double* c,
+                       double* mc, double* dmc_dc) const;
+
+        void adsorption(const int n, const double* c, const double* cmax,
+                        double* c_ads, double* dc_ads_dc) const;
+
+        /// The mobilities of effectiveMobilities() of n cells, relperm and
+        /// mob have the two phases of a cell next to each other. The
+        /// viscosities of cell i start at visc + i*visc_stride, i.e. a
+        /// stride of 0 uses the same viscosities for all cells.
+        void effectiveMobilities(const int n, const double* c, const double* cmax,
+                                 const double* visc, const int visc_stride,
+                                 const double* relperm, double* mob) const;
+
         /// Computing the shear multiplier based on the water velocity/shear rate with PLYSHLOG keyword
         bool computeShearMultLog(std::vector<double>& water_vel, std::vector<double>& visc_mult, std::vector<double>& shear_mult) const;
 
@@ -402,6 +427,13 @@ namespace Opm
         bool has_plyshlog_ref_salinity_;
         bool has_plyshlog_ref_temp_;
 
+        // tables of viscMult() and the adsorption with a uniform index,
+        // and pow(viscMult(c_max_), 1 - mix_param_) used by computeMc()
+        detail::IndexedLinearTable visc_table_;
+        detail::IndexedLinearTable ads_table_;
+        double mc_ratio_;
+
+        void updateTables();
 
         void simpleAdsorptionBoth(double c, double& c_ads,
                                   double& dc_ads_dc, bool if_with_der) const;
@@ -395,6 +395,19 @@ namespace Opm
                            &transport_src[0], &polymer_inflow_c[0], stepsize,
                            state.saturation(), state.surfacevol(),
                            state.getCellData( state.CONCENTRATION ), state.getCellData( state.CMAX ));
+            const TransportSolverTwophaseCompressiblePolymer::SolverStatistics& tstats = tsolver_.statistics();
+            std::cout << "Transport single-cell solves: " << tstats.cells
+                      << " in " << tstats.levels << " levels, "
+                      << tstats.converged_cells << " initially converged, max "
+                      << tstats.max_cell_iterations << " iterations\n"
+                      << "    Newton steps: " << tstats.newton_iterations
+                      << " (" << tstats.failed_line_searches << " failed line searches)"
+                      << ", gradient steps: " << tstats.gradient_iterations
+                      << ", regula falsi iterations: " << tstats.falsi_iterations
+                      << ", bracketing fallbacks: " << tstats.bracketing_fallbacks << "\n"
+                      << "    multi-cell components: " << tstats.multicell_components
+                      << " (" << tstats.multicell_iterations << " sweeps)"
+                      << ", residual evaluations: " << tstats.residual_evaluations << std::endl;
             double substep_injected[2] = { 0.0 };
             double substep_produced[2] = { 0.0 };
             double substep_polyinj = 0.0;
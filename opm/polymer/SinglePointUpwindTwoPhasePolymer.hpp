@@ -47,12 +47,12 @@ namespace Opm {
     namespace polymer_reorder {
         class ModelParameterStorage {
         public:
-            ModelParameterStorage(int nc, int totconn)
-                : drho_(0.0), rockdensity_(0.0), mob_(0), 
+            ModelParameterStorage(int nc, int totconn, int nf)
+                : nc_(nc), nf_(nf), drho_(0.0), rockdensity_(0.0), mob_(0), 
                   dmobds_(0), dmobwatdc_(0), mc_(0),
                   dmcdc_(0), porevol_(0), porosity_(0), dg_(0), sw_(0), c_(0), cmax_(0),
                   ds_(0), dsc_(0), dcads_(0), dcadsdc_(0), pc_(0), dpc_(0), 
-                  trans_(0), data_()
+                  trans_(0), fluxres_(0), fluxjac_(0), data_()
             {
                 size_t alloc_sz;
 
@@ -74,6 +74,8 @@ namespace Opm {
                 alloc_sz += 1 * nc;        // pc_
                 alloc_sz += 1 * nc;        // dpc_
                 alloc_sz += 1 * totconn;   // trans_
+                alloc_sz += 2 * nf;        // fluxres_
+                alloc_sz += 8 * nf;        // fluxjac_
                 data_.resize(alloc_sz);
 
                 mob_           = &data_[0];
@@ -94,6 +96,8 @@ namespace Opm {
                 pc_            = dcadsdc_        + (1 * nc     );
                 dpc_           = pc_             + (1 * nc     );
                 trans_         = dpc_            + (1 * nc     );
+                fluxres_       = trans_          + (1 * totconn);
+                fluxjac_       = fluxres_        + (2 * nf     );
             }
 
             double&       drho   ()            { return drho_            ; }
@@ -102,11 +106,12 @@ namespace Opm {
             double&       rockdensity()            { return rockdensity_      ; }
             double        rockdensity()    const { return rockdensity_  ; }
 
-            double*       mob    (int cell)       { return mob_  + (2*cell + 0); }
-            const double* mob    (int cell) const { return mob_  + (2*cell + 0); }
+            // Phase values are stored one phase after the other.
+            double&       mob    (int cell, int p)       { return mob_[p*nc_ + cell]; }
+            double        mob    (int cell, int p) const { return mob_[p*nc_ + cell]; }
 
-            double*       dmobds    (int cell)       { return dmobds_  + (2*cell + 0); }
-            const double* dmobds    (int cell) const { return dmobds_  + (2*cell + 0); }
+            double&       dmobds    (int cell, int p)       { return dmobds_[p*nc_ + cell]; }
+            double        dmobds    (int cell, int p) const { return dmobds_[p*nc_ + cell]; }
 
             double&       dmobwatdc    (int cell)       { return dmobwatdc_[cell]; }
             double        dmobwatdc    (int cell) const { return dmobwatdc_[cell]; }
@@ -157,7 +162,19 @@ namespace Opm {
             double&       trans(int f)         { return trans_[f]     ; }
             double        trans(int f)   const { return trans_[f]     ; }
 
+            // Residual F[k] of face f seen from its first cell, without
+            // the time step.
+            double&       fluxres(int f, int k)       { return fluxres_[k*nf_ + f]; }
+            double        fluxres(int f, int k) const { return fluxres_[k*nf_ + f]; }
+
+            // Jacobian of fluxres() with respect to the variables of the
+            // cell on side s of face f, same layout as in fluxConnection().
+            double&       fluxjac(int f, int s, int k)       { return fluxjac_[(4*s + k)*nf_ + f]; }
+            double        fluxjac(int f, int s, int k) const { return fluxjac_[(4*s + k)*nf_ + f]; }
+
         private:
+            int     nc_          ;
+            int     nf_          ;
             double  drho_        ;
             double  rockdensity_  ;
             double *mob_         ;
@@ -178,6 +195,8 @@ namespace Opm {
             double *pc_          ;
             double *dpc_         ;
             double *trans_       ;
+            double *fluxres_     ;
+            double *fluxjac_     ;
 
             std::vector<double> data_;
         };
@@ -197,7 +216,8 @@ namespace Opm {
               gravity_ (grav)                               ,
               f2hf_    (2 * g.number_of_faces, -1)          ,
               store_   (g.number_of_cells,
-			g.cell_facepos[ g.number_of_cells ]),
+			g.cell_facepos[ g.number_of_cells ],
+                        g.number_of_faces),
 	      init_step_use_previous_sol_(guess_previous)   ,
 	      sat_tol_  (1e-5)
         {
@@ -287,84 +307,19 @@ namespace Opm {
                                                       //dFd2[0]= d(F[0])/d(s2), dFd2[1]= d(F[0])/d(c2), dFd2[2]= d(F[1])/d(s2), dFd2[3]= d(F[1])/d(c2).
 
 		       ) const {
-
-            const int *n = g.face_cells + (2 * f);
-            double dflux = state.faceflux()[f];
-            double gflux = gravityFlux(f);
-            double pcflux, dpcflux[2];
-            capFlux(f, n, pcflux, dpcflux);
-            gflux += pcflux;
-
-            int    pix[2];
-            double m[2], dmds[2], dmobwatdc;
-            double mc, dmcdc;
-            upwindMobility(dflux, gflux, n, pix, m, dmds, dmobwatdc, mc, dmcdc);
-
-            assert ((m[0] >= 0.0) && (m[1] >= 0.0));
-
-            double mt = m[0] + m[1];
-            assert (mt >= 0.0);
-
-            double sgn  = 2.0*(n[0] == cell) - 1.0;
-            dflux      *= sgn;
-            gflux      *= sgn;
-
-
-            double       f1 = m[0] / mt;
-            const double v1 = dflux + m[1]*gflux;
-
-            // Assemble residual contributions
-            F[0] += dt * f1 * v1;
-            F[1] += dt * mc * f1 * v1;
-
-            // Assemble Jacobian (J1 <-> cell, J2 <-> other)
-            double *dFsds[2];
-            double *dFsdc[2];
-            double *dFcds[2];
-            double *dFcdc[2];
-            if (n[0] == cell) {
-                dFsds[0] = &dFd1[0]; dFsds[1] = &dFd2[0];
-                dFsdc[0] = &dFd1[1]; dFsdc[1] = &dFd2[1];
-                dFcds[0] = &dFd1[2]; dFcds[1] = &dFd2[2];
-                dFcdc[0] = &dFd1[3]; dFcdc[1] = &dFd2[3];
-                // sign is positive
-                dFd1[0] += sgn*dt * f1            * dpcflux[0] * m[1];
-                dFd2[0] += sgn*dt * f1            * dpcflux[1] * m[1];
-                dFd1[2] += sgn*dt * f1 * mc       * dpcflux[0] * m[1];
-                dFd2[2] += sgn*dt * f1 * mc       * dpcflux[1] * m[1];
-		// We assume that the capillary pressure is independent of the polymer concentration.
-                // Hence, no more contributions.
-            } else {
-                dFsds[0] = &dFd2[0]; dFsds[1] = &dFd1[0];
-                dFsdc[0] = &dFd2[1]; dFsdc[1] = &dFd1[1];
-                dFcds[0] = &dFd2[2]; dFcds[1] = &dFd1[2];
-                dFcdc[0] = &dFd2[3]; dFcdc[1] = &dFd1[3];
-                // sign is negative
-                dFd1[0] += sgn*dt * f1            * dpcflux[1] * m[1];
-                dFd2[0] += sgn*dt * f1            * dpcflux[0] * m[1];
-                dFd1[2] += sgn*dt * f1 * mc       * dpcflux[1] * m[1];
-                dFd2[2] += sgn*dt * f1 * mc       * dpcflux[0] * m[1];
-		// We assume that the capillary pressure is independent of the polymer concentration.
-                // Hence, no more contributions.
+            (void) state;   // The face terms are computed in initIteration().
+
+            // The other cell sees the same flux in the opposite direction.
+            const int    *n    = g.face_cells + (2 * f);
+            const int     self = (n[0] == cell) ? 0 : 1;
+            const double  sdt  = (2.0*(n[0] == cell) - 1.0) * dt;
+
+            F[0] += sdt * store_.fluxres(f, 0);
+            F[1] += sdt * store_.fluxres(f, 1);
+            for (int k = 0; k < 4; ++k) {
+                dFd1[k] += sdt * store_.fluxjac(f,     self, k);
+                dFd2[k] += sdt * store_.fluxjac(f, 1 - self, k);
             }
-
-            // dFs/dm_1 \cdot dm_1/ds
-            *dFsds[ pix[0] ] += dt * (1 - f1) / mt * v1      * dmds[0];
-            // dFc/dm_1 \cdot dm_1/ds
-            *dFcds[ pix[0] ] += dt * (1 - f1) / mt * v1 * mc * dmds[0];
-
-            // dFs/dm_2 \cdot dm_2/ds
-            *dFsds[ pix[1] ] -= dt * f1       / mt * v1    *      dmds[1];
-            *dFsds[ pix[1] ] += dt * f1            * gflux *      dmds[1];
-            // dFc/dm_2 \cdot dm_2/ds
-            *dFcds[ pix[1] ] -= dt * f1       / mt * v1    * mc * dmds[1];
-            *dFcds[ pix[1] ] += dt * f1            * gflux * mc * dmds[1];
-
-            // dFs/dm_1 \cdot dm_1/dc
-            *dFsdc[ pix[0] ] += dt * (1 - f1) / mt * v1      * dmobwatdc;
-            // dFc/dm_1 \cdot dm_1/dc
-            *dFcdc[ pix[0] ] += dt * (1 - f1) / mt * v1 * mc * dmobwatdc;
-            *dFcdc[ pix[0] ] += dt * f1 * v1 * dmcdc;                 // Polymer is only carried by water.
         }
 
         template <class Grid>
@@ -409,8 +364,8 @@ namespace Opm {
             } else {
                 // cell -> src
                 const int     cell  = src->cell[i];
-                const double* m  = store_.mob (cell);
-                const double* dm = store_.dmobds(cell);
+                const double  m[2]  = { store_.mob   (cell, 0), store_.mob   (cell, 1) };
+                const double  dm[2] = { store_.dmobds(cell, 0), store_.dmobds(cell, 1) };
 
                 const double  mt = m[0] + m[1];
 
@@ -496,22 +451,24 @@ namespace Opm {
                       const Grid&           g    ,
                       JacobianSystem&       sys) {
 
-            double s[2];
-            double mob[2];
-            double dmobds[4];
-            double dmobwatdc;
-            double c, cmax;
-            double mc, dmcdc;
-            double pc, dpc;
-
             const typename JacobianSystem::vector_type& x =
                 sys.vector().solution();
             const ::std::vector<double>& sat = state.saturation();
             const ::std::vector<double>& cpoly = state.concentration();
             const ::std::vector<double>& cmaxpoly = state.maxconcentration();
 
+            // Every cell only writes its own entries of the storage.
             bool in_range = true;
+#pragma omp parallel for schedule(static) reduction(&&:in_range)
             for (int cell = 0; cell < g.number_of_cells; ++cell) {
+                double s[2];
+                double mob[2];
+                double dmobds[4];
+                double dmobwatdc;
+                double c, cmax;
+                double mc, dmcdc;
+                double pc, dpc;
+
                 // Store wat-sat, sat-change, cpoly, (sat * cpoly)-change for accumulation().
                 store_.ds(cell) = x[2*cell + 0];
                 s[0] = sat[cell*2 + 0] + x[2*cell + 0];
@@ -548,16 +505,29 @@ namespace Opm {
                 fluid_.computeMc(c, mc, dmcdc);
                 fluid_.pc(cell, s, pc, dpc);
 
-                store_.mob (cell)[0]   =  mob [0];
-                store_.mob (cell)[1]   =  mob [1];
-                store_.dmobds(cell)[0] =  dmobds[0*2 + 0];
-                store_.dmobds(cell)[1] = -dmobds[1*2 + 1];
+                store_.mob (cell, 0)   =  mob [0];
+                store_.mob (cell, 1)   =  mob [1];
+                store_.dmobds(cell, 0) =  dmobds[0*2 + 0];
+                store_.dmobds(cell, 1) = -dmobds[1*2 + 1];
                 store_.dmobwatdc(cell) =  dmobwatdc;
                 store_.mc(cell)        = mc;
                 store_.dmcdc(cell)     = dmcdc;
                 store_.pc(cell)        = pc;
                 store_.dpc(cell)       = dpc;
             }
+
+            // The face terms need the mobilities of both cells, hence the
+            // second loop.  Each face is computed once for both of its
+            // cells by fluxConnection().
+            const double* faceflux = &state.faceflux()[0];
+#pragma omp parallel for schedule(static)
+            for (int f = 0; f < g.number_of_faces; ++f) {
+                const int *n = g.face_cells + (2 * f);
+                if ((n[0] >= 0) && (n[1] >= 0)) {
+                    faceFlux(f, n, faceflux[f]);
+                }
+            }
+
 	    if (!in_range) {
 		std::cout << "Warning: initIteration() - s was clamped in some cells.\n";
 	    }
@@ -603,6 +573,75 @@ namespace Opm {
         }
 
     private:
+        // Residual and Jacobian of the flux across face f seen from its
+        // first cell n[0], per unit time.  Only the entries of face f in
+        // the storage are written, such that faces may be computed
+        // concurrently.
+        void
+        faceFlux(const int    f    ,
+                 const int*   n    ,
+                 double       dflux) {
+
+            double gflux = gravityFlux(f);
+            double pcflux, dpcflux[2];
+            capFlux(f, n, pcflux, dpcflux);
+            gflux += pcflux;
+
+            int    pix[2];
+            double m[2], dmds[2], dmobwatdc;
+            double mc, dmcdc;
+            upwindMobility(dflux, gflux, n, pix, m, dmds, dmobwatdc, mc, dmcdc);
+
+            assert ((m[0] >= 0.0) && (m[1] >= 0.0));
+
+            double mt = m[0] + m[1];
+            assert (mt >= 0.0);
+
+            double       f1 = m[0] / mt;
+            const double v1 = dflux + m[1]*gflux;
+
+            // Residual contributions
+            store_.fluxres(f, 0) = f1 * v1;
+            store_.fluxres(f, 1) = mc * f1 * v1;
+
+            // Jacobian (J[0] <-> n[0], J[1] <-> n[1])
+            double J[2][4];
+            J[0][0] = f1      * dpcflux[0] * m[1];
+            J[1][0] = f1      * dpcflux[1] * m[1];
+            J[0][1] = 0.0;
+            J[1][1] = 0.0;
+            J[0][2] = f1 * mc * dpcflux[0] * m[1];
+            J[1][2] = f1 * mc * dpcflux[1] * m[1];
+            J[0][3] = 0.0;
+            J[1][3] = 0.0;
+            // We assume that the capillary pressure is independent of the polymer concentration.
+            // Hence, no more contributions.
+
+            // dFs/dm_1 \cdot dm_1/ds
+            J[ pix[0] ][0] += (1 - f1) / mt * v1      * dmds[0];
+            // dFc/dm_1 \cdot dm_1/ds
+            J[ pix[0] ][2] += (1 - f1) / mt * v1 * mc * dmds[0];
+
+            // dFs/dm_2 \cdot dm_2/ds
+            J[ pix[1] ][0] -= f1       / mt * v1    *      dmds[1];
+            J[ pix[1] ][0] += f1            * gflux *      dmds[1];
+            // dFc/dm_2 \cdot dm_2/ds
+            J[ pix[1] ][2] -= f1       / mt * v1    * mc * dmds[1];
+            J[ pix[1] ][2] += f1            * gflux * mc * dmds[1];
+
+            // dFs/dm_1 \cdot dm_1/dc
+            J[ pix[0] ][1] += (1 - f1) / mt * v1      * dmobwatdc;
+            // dFc/dm_1 \cdot dm_1/dc
+            J[ pix[0] ][3] += (1 - f1) / mt * v1 * mc * dmobwatdc;
+            J[ pix[0] ][3] += f1 * v1 * dmcdc;                 // Polymer is only carried by water.
+
+            for (int s = 0; s < 2; ++s) {
+                for (int k = 0; k < 4; ++k) {
+                    store_.fluxjac(f, s, k) = J[s][k];
+                }
+            }
+        }
+
         void
         upwindMobility(const double dflux,
                        const double gflux,
@@ -621,30 +660,30 @@ namespace Opm {
                 if (! (dflux < 0) && ! (gflux < 0)) { pix[0] = 0; }
                 else                                { pix[0] = 1; }
 
-                m[0] = store_.mob(n[ pix[0] ]) [ 0 ];
+                m[0] = store_.mob(n[ pix[0] ], 0);
                 mc = store_.mc(n[ pix[0] ]);
 
                 if (! (dflux - m[0]*gflux < 0))     { pix[1] = 0; }
                 else                                { pix[1] = 1; }
 
-                m[1] = store_.mob(n[ pix[1] ]) [ 1 ];
+                m[1] = store_.mob(n[ pix[1] ], 1);
 
             } else {
 
                 if (! (dflux < 0) && ! (gflux > 0)) { pix[1] = 0; }
                 else                                { pix[1] = 1; }
 
-                m[1] = store_.mob(n[ pix[1] ]) [ 1 ];
+                m[1] = store_.mob(n[ pix[1] ], 1);
 
                 if (dflux + m[1]*gflux > 0)         { pix[0] = 0; }
                 else                                { pix[0] = 1; }
 
-                m[0] = store_.mob(n[ pix[0] ]) [ 0 ];
+                m[0] = store_.mob(n[ pix[0] ], 0);
                 mc = store_.mc(n[ pix[0] ]);
             }
 
-            dmds[0]   = store_.dmobds(n[ pix[0] ]) [ 0 ];
-            dmds[1]   = store_.dmobds(n[ pix[1] ]) [ 1 ];
+            dmds[0]   = store_.dmobds(n[ pix[0] ], 0);
+            dmds[1]   = store_.dmobds(n[ pix[1] ], 1);
             dmobwatdc = store_.dmobwatdc(n[ pix[0] ]);
             dmcdc     = store_.dmcdc(n[ pix[0] ]);
         }
@@ -28,9 +28,17 @@
 #include <opm/core/utility/miscUtilitiesBlackoil.hpp>
 #include <opm/core/pressure/tpfa/trans_tpfa.h>
 #include <opm/common/ErrorMacros.hpp>
+#include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <exception>
 #include <list>
 #include <iostream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 // Choose error policy for scalar solves here.
 typedef Opm::RegulaFalsi<Opm::WarnAndContinueOnError> RootFinder;
 
@@ -58,6 +66,7 @@ public:
     double ads0;
 
     TransportSolverTwophaseCompressiblePolymer& tm;
+    SolverStatistics& stats;
 
     ResidualEquation(TransportSolverTwophaseCompressiblePolymer& tmodel, int cell_index);
     void computeResidual(const double* x, double* res) const;
@@ -212,6 +221,66 @@ namespace Opm
 
 
 
+    TransportSolverTwophaseCompressiblePolymer::SolverStatistics::SolverStatistics()
+        : levels(0),
+          cells(0),
+          converged_cells(0),
+          max_cell_iterations(0),
+          newton_iterations(0),
+          failed_line_searches(0),
+          gradient_iterations(0),
+          falsi_iterations(0),
+          bracketing_fallbacks(0),
+          multicell_components(0),
+          multicell_iterations(0),
+          residual_evaluations(0)
+    {
+    }
+
+
+
+
+    void TransportSolverTwophaseCompressiblePolymer::SolverStatistics::add(const SolverStatistics& other)
+    {
+        levels = std::max(levels, other.levels);
+        cells += other.cells;
+        converged_cells += other.converged_cells;
+        max_cell_iterations = std::max(max_cell_iterations, other.max_cell_iterations);
+        newton_iterations += other.newton_iterations;
+        failed_line_searches += other.failed_line_searches;
+        gradient_iterations += other.gradient_iterations;
+        falsi_iterations += other.falsi_iterations;
+        bracketing_fallbacks += other.bracketing_fallbacks;
+        multicell_components += other.multicell_components;
+        multicell_iterations += other.multicell_iterations;
+        residual_evaluations += other.residual_evaluations;
+    }
+
+
+
+
+    const TransportSolverTwophaseCompressiblePolymer::SolverStatistics&
+    TransportSolverTwophaseCompressiblePolymer::statistics() const
+    {
+        return statistics_;
+    }
+
+
+
+
+    TransportSolverTwophaseCompressiblePolymer::SolverStatistics&
+    TransportSolverTwophaseCompressiblePolymer::threadStatistics()
+    {
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        return thread_statistics_[thread];
+    }
+
+
+
+
     void TransportSolverTwophaseCompressiblePolymer::solve(const double* darcyflux,
                                                   const std::vector<double>& initial_pressure,
                                                   const std::vector<double>& pressure,
@@ -251,16 +320,28 @@ namespace Opm
         std::vector<int> seq(grid_.number_of_cells);
         std::vector<int> comp(grid_.number_of_cells + 1);
         int ncomp;
-        compute_sequence_graph(&grid_, darcyflux_,
-                               &seq[0], &comp[0], &ncomp,
-                               &ia_upw_[0], &ja_upw_[0]);
         const int nf = grid_.number_of_faces;
         std::vector<double> neg_darcyflux(nf);
         std::transform(darcyflux, darcyflux + nf, neg_darcyflux.begin(), std::negate<double>());
         compute_sequence_graph(&grid_, &neg_darcyflux[0],
                                &seq[0], &comp[0], &ncomp,
                                &ia_downw_[0], &ja_downw_[0]);
-        reorderAndTransport(grid_, darcyflux);
+        // The upwind sequence is computed last, it is the one solved.
+        compute_sequence_graph(&grid_, darcyflux_,
+                               &seq[0], &comp[0], &ncomp,
+                               &ia_upw_[0], &ja_upw_[0]);
+
+        int num_threads = 1;
+#ifdef _OPENMP
+        num_threads = omp_get_max_threads();
+#endif
+        thread_statistics_.assign(num_threads, SolverStatistics());
+        solveLevels(&seq[0], &comp[0], ncomp);
+        statistics_ = SolverStatistics();
+        for (const auto& stats : thread_statistics_) {
+            statistics_.add(stats);
+        }
+        statistics_.levels = level_start_.size() - 1;
         toBothSat(saturation_, saturation);
 
         // Compute surface volume as a postprocessing step from saturation and A_
@@ -350,7 +431,8 @@ namespace Opm
     // value and the values of its derivatives.
 
     TransportSolverTwophaseCompressiblePolymer::ResidualEquation::ResidualEquation(TransportSolverTwophaseCompressiblePolymer& tmodel, int cell_index)
-        : tm(tmodel)
+        : tm(tmodel),
+          stats(tmodel.threadStatistics())
     {
         gradient_method = Analytic;
         cell    = cell_index;
@@ -475,6 +557,9 @@ namespace Opm
                                                                                   double* res, double* dres_s_dsdc,
                                                                                   double* dres_c_dsdc, double& mc, double& ff) const
     {
+        if (if_res_s || if_res_c) {
+            ++stats.residual_evaluations;
+        }
         if ((if_dres_s_dsdc || if_dres_c_dsdc) && gradient_method == Analytic) {
             double s = x[0];
             double c = x[1];
@@ -493,6 +578,7 @@ namespace Opm
             if (if_res_s) {
                 res[0] = s - B_cell/B_cell0*porosity0/porosity*s0 + dtpv*(outflux*ff + influx);
 #if PROFILING
+#pragma omp critical
                 tm.res_counts.push_back(Newton_Iter(true, cell, x[0], x[1]));
 #endif
             }
@@ -503,6 +589,7 @@ namespace Opm
                     + rhor*B_cell/porosity*((1.0 - porosity)*ads - (1.0 - porosity0)*ads0)
                     + dtpv*(outflux*ff*mc + influx_polymer);
 #if PROFILING
+#pragma omp critical
                 tm.res_counts.push_back(Newton_Iter(false, cell, x[0], x[1]));
 #endif
             }
@@ -523,6 +610,7 @@ namespace Opm
             if (if_res_s) {
                 res[0] = s - B_cell/B_cell0*porosity0/porosity*s0 + dtpv*(outflux*ff + influx);
 #if PROFILING
+#pragma omp critical
                 tm.res_counts.push_back(Newton_Iter(true, cell, x[0], x[1]));
 #endif
             }
@@ -534,6 +622,7 @@ namespace Opm
                     + rhor*B_cell/porosity*((1.0 - porosity)*ads - (1.0 - porosity0)*ads0)
                     + dtpv*(outflux*ff*mc + influx_polymer);
 #if PROFILING
+#pragma omp critical
                 tm.res_counts.push_back(Newton_Iter(false, cell, x[0], x[1]));
 #endif
             }
@@ -622,28 +711,127 @@ namespace Opm
 
 
 
+    // Solve the components of the reorder sequence level by level. A
+    // component only depends on the components holding the upwind
+    // neighbours of its cells, through their fractional flows and mc
+    // values, and each component only writes the state of its own cells.
+    // The components of a level are therefore solved concurrently.
+    void TransportSolverTwophaseCompressiblePolymer::solveLevels(const int* sequence,
+                                                                 const int* components,
+                                                                 const int num_components)
+    {
+        const int nc = grid_.number_of_cells;
+        std::vector<int> cell_comp(nc);
+        for (int k = 0; k < num_components; ++k) {
+            for (int i = components[k]; i < components[k + 1]; ++i) {
+                cell_comp[sequence[i]] = k;
+            }
+        }
+
+        // The components are in upwind order, so the levels of the upwind
+        // components are known when a component is reached.
+        comp_level_.assign(num_components, 0);
+        int num_levels = 0;
+        for (int k = 0; k < num_components; ++k) {
+            int level = 0;
+            for (int i = components[k]; i < components[k + 1]; ++i) {
+                const int cell = sequence[i];
+                for (int hf = grid_.cell_facepos[cell]; hf < grid_.cell_facepos[cell + 1]; ++hf) {
+                    const int f = grid_.cell_faces[hf];
+                    double flux;
+                    int other;
+                    if (cell == grid_.face_cells[2*f]) {
+                        flux  = darcyflux_[f];
+                        other = grid_.face_cells[2*f+1];
+                    } else {
+                        flux  =-darcyflux_[f];
+                        other = grid_.face_cells[2*f];
+                    }
+                    if (other != -1 && flux < 0.0 && cell_comp[other] != k) {
+                        assert(cell_comp[other] < k);
+                        level = std::max(level, comp_level_[cell_comp[other]] + 1);
+                    }
+                }
+            }
+            comp_level_[k] = level;
+            num_levels = std::max(num_levels, level + 1);
+        }
+
+        // Group the components by level, keeping the sequence order.
+        level_start_.assign(num_levels + 1, 0);
+        for (int k = 0; k < num_components; ++k) {
+            ++level_start_[comp_level_[k] + 1];
+        }
+        for (int level = 0; level < num_levels; ++level) {
+            level_start_[level + 1] += level_start_[level];
+        }
+        level_comps_.resize(num_components);
+        std::vector<int> pos(level_start_.begin(), level_start_.end() - 1);
+        for (int k = 0; k < num_components; ++k) {
+            level_comps_[pos[comp_level_[k]]++] = k;
+        }
+
+        for (int level = 0; level < num_levels; ++level) {
+            const int begin = level_start_[level];
+            const int end = level_start_[level + 1];
+            std::exception_ptr error;
+#pragma omp parallel for schedule(dynamic) if (end - begin > 1)
+            for (int i = begin; i < end; ++i) {
+                const int k = level_comps_[i];
+                const int num_cells = components[k + 1] - components[k];
+                try {
+                    if (num_cells == 1) {
+                        solveSingleCell(sequence[components[k]]);
+                    } else {
+                        solveMultiCell(num_cells, sequence + components[k]);
+                    }
+                }
+                catch (...) {
+#pragma omp critical
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+
+
     void TransportSolverTwophaseCompressiblePolymer::solveSingleCell(const int cell)
     {
+        int iterations = 0;
         switch (method_) {
         case Bracketing:
-            solveSingleCellBracketing(cell);
+            iterations = solveSingleCellBracketing(cell);
             break;
         case Newton:
-            solveSingleCellNewton(cell, true);
+            iterations = solveSingleCellNewton(cell, true);
             break;
         case NewtonC:
-            solveSingleCellNewton(cell, false);
+            iterations = solveSingleCellNewton(cell, false);
             break;
         case Gradient:
-            solveSingleCellGradient(cell);
+            iterations = solveSingleCellGradient(cell);
             break;
         default:
             OPM_THROW(std::runtime_error, "Unknown method " << method_);
         }
+        SolverStatistics& stats = threadStatistics();
+        ++stats.cells;
+        if (iterations == 0) {
+            ++stats.converged_cells;
+        }
+        stats.max_cell_iterations = std::max(stats.max_cell_iterations, iterations);
     }
 
 
-    void TransportSolverTwophaseCompressiblePolymer::solveSingleCellBracketing(int cell)
+    // Returns the number of regula falsi iterations, 0 if the current
+    // state is already a solution.
+    int TransportSolverTwophaseCompressiblePolymer::solveSingleCellBracketing(int cell)
     {
 
         ResidualEquation res_eq(*this, cell);
@@ -659,7 +847,7 @@ namespace Opm
         if (norm(res_sc) < tol_) {
             fractionalflow_[cell] = ff;
             mc_[cell] = mc;
-            return;
+            return 0;
         }
 
         concentration_[cell] = RootFinder::solve(res, a, b, maxit_, tol_, iters_used);
@@ -668,6 +856,8 @@ namespace Opm
         fracFlow(saturation_[cell], concentration_[cell], cmax_[cell], cell,
                  fractionalflow_[cell]);
         computeMc(concentration_[cell], mc_[cell]);
+        res_eq.stats.falsi_iterations += iters_used;
+        return iters_used;
     }
 
 
@@ -675,7 +865,9 @@ namespace Opm
     // Newton method, where we first try a Newton step. Then, if it does not work well, we look for
     // the zero of either the residual in s or the residual in c along a specified piecewise linear
     // curve. In these cases, we can use a robust 1d solver.
-    void TransportSolverTwophaseCompressiblePolymer::solveSingleCellGradient(int cell)
+    // Returns the number of root solves along curves, including the
+    // iterations of the bracketing fallback.
+    int TransportSolverTwophaseCompressiblePolymer::solveSingleCellGradient(int cell)
     {
         int iters_used_falsi = 0;
         const int max_iters_split = maxit_;
@@ -694,7 +886,7 @@ namespace Opm
             cmax_[cell] = std::max(cmax_[cell], concentration_[cell]);
             fractionalflow_[cell] = ff;
             mc_[cell] = mc;
-            return;
+            return 0;
         }
 
         double x_min[2] = { 0.0, 0.0 };
@@ -791,6 +983,7 @@ namespace Opm
                 }
                 // Note: In some experiments modifiedRegularFalsi does not yield a result under the given tolerance.
                 t = RootFinder::solve(res_s_on_curve, 0., t_max, maxit_, tol_, iters_used_falsi);
+                res_eq.stats.falsi_iterations += iters_used_falsi;
                 res_s_on_curve.curve.computeXOfT(x, t);
             } else {
                 if (res[1] < 0) {
@@ -809,6 +1002,7 @@ namespace Opm
                     }
                 }
                 t = RootFinder::solve(res_c_on_curve, 0., t_max, maxit_, tol_, iters_used_falsi);
+                res_eq.stats.falsi_iterations += iters_used_falsi;
                 res_c_on_curve.curve.computeXOfT(x, t);
 
             }
@@ -816,12 +1010,14 @@ namespace Opm
             res_eq.computeResidual(x_c, res, mc, ff);
             iters_used_split += 1;
         }
+        res_eq.stats.gradient_iterations += iters_used_split;
 
 
 
         if ((iters_used_split >=  max_iters_split) && (norm(res) > tol_)) {
             OPM_MESSAGE("Newton for single cell did not work in cell number " << cell);
-            solveSingleCellBracketing(cell);
+            ++res_eq.stats.bracketing_fallbacks;
+            return iters_used_split + solveSingleCellBracketing(cell);
         } else {
             scToc(x, x_c);
             concentration_[cell] = x_c[1];
@@ -830,9 +1026,12 @@ namespace Opm
             fractionalflow_[cell] = ff;
             mc_[cell] = mc;
         }
+        return iters_used_split;
     }
 
-    void TransportSolverTwophaseCompressiblePolymer::solveSingleCellNewton(int cell, bool use_sc,
+    // Returns the number of Newton steps, including the iterations of the
+    // bracketing fallback.
+    int TransportSolverTwophaseCompressiblePolymer::solveSingleCellNewton(int cell, bool use_sc,
                                                                   bool use_explicit_step)
     {
         const int max_iters_split = maxit_;
@@ -849,7 +1048,7 @@ namespace Opm
             cmax_[cell] = std::max(cmax_[cell], concentration_[cell]);
             fractionalflow_[cell] = ff;
             mc_[cell] = mc;
-            return;
+            return 0;
         }
 
         if (use_explicit_step) {
@@ -951,6 +1150,7 @@ namespace Opm
             }
             if (lin_it>=max_lin_it) {
                 successfull_newton_step = false;
+                ++res_eq.stats.failed_line_searches;
             } else  {
                 if (use_sc) {
                     scToc(x_new, x);
@@ -964,10 +1164,12 @@ namespace Opm
                 successfull_newton_step = true;;
             }
         }
+        res_eq.stats.newton_iterations += iters_used_split;
 
         if ((iters_used_split >=  max_iters_split) && (norm(res) > tol_)) {
             OPM_MESSAGE("Newton for single cell did not work in cell number " << cell);
-            solveSingleCellBracketing(cell);
+            ++res_eq.stats.bracketing_fallbacks;
+            return iters_used_split + solveSingleCellBracketing(cell);
         } else {
             concentration_[cell] = x[1];
             cmax_[cell] = std::max(cmax_[cell], concentration_[cell]);
@@ -975,6 +1177,7 @@ namespace Opm
             fractionalflow_[cell] = ff;
             mc_[cell] = mc;
         }
+        return iters_used_split;
     }
 
 
@@ -995,7 +1198,7 @@ namespace Opm
             computeMc(concentration_[cell], mc_[cell]);
             s0[i] = saturation_[cell];
             c0[i] = concentration_[cell];
-            cmax0[i] = cmax_[i];
+            cmax0[i] = cmax_[cell];
         }
         do {
             // int max_s_change_cell = -1;
@@ -1023,6 +1226,9 @@ namespace Opm
             // std::cout << "Iter = " << num_iters << "    max_s_change = " << max_s_change
             //        << "    in cell " << max_change_cell << std::endl;
         } while (((max_s_change > tol_) || (max_c_change > tol_)) && ++num_iters < maxit_);
+        SolverStatistics& stats = threadStatistics();
+        ++stats.multicell_components;
+        stats.multicell_iterations += num_iters + 1;
         if (max_s_change > tol_) {
             OPM_THROW(std::runtime_error, "In solveMultiCell(), we did not converge after "
                   << num_iters << " iterations. Delta s = " << max_s_change);
@@ -48,6 +48,27 @@ namespace Opm
 	enum SingleCellMethod { Bracketing, Newton, NewtonC, Gradient};
         enum GradientMethod { Analytic, FinDif }; // Analytic is chosen (hard-coded)
 
+        /// Counts of the nonlinear work of a call to solve().
+        struct SolverStatistics
+        {
+            SolverStatistics();
+            /// Add the counts of other, taking the larger maximum.
+            void add(const SolverStatistics& other);
+
+            int levels;                 // levels of independent components of the reorder sequence
+            int cells;                  // single-cell solves
+            int converged_cells;        // single-cell solves that were converged initially
+            int max_cell_iterations;    // most iterations of a single-cell solve
+            int newton_iterations;      // Newton steps
+            int failed_line_searches;   // Newton steps without residual reduction
+            int gradient_iterations;    // root solves along curves of the gradient method
+            int falsi_iterations;       // regula falsi iterations, bracketing and gradient method
+            int bracketing_fallbacks;   // Newton or gradient solves that fell back to bracketing
+            int multicell_components;   // components with more than one cell
+            int multicell_iterations;   // Gauss-Seidel sweeps over those components
+            long residual_evaluations;  // evaluations of the single-cell residual
+        };
+
 	/// Construct solver.
 	/// \param[in] grid       A 2d or 3d grid.
 	/// \param[in] props      Rock and fluid properties.
@@ -69,8 +90,14 @@ namespace Opm
 	/// Set the preferred method, Bracketing or Newton.
         void setPreferredMethod(SingleCellMethod method);
 
+        /// Statistics of the last call to solve().
+        const SolverStatistics& statistics() const;
+
 	/// Solve for saturation, concentration and cmax at next timestep.
 	/// Using implicit Euler scheme, reordered.
+        /// The components of the reorder sequence are grouped in levels
+        /// whose components only depend on those of earlier levels, and
+        /// the components of a level are solved in parallel.
 	/// \param[in] darcyflux           Array of signed face fluxes.
 	/// \param[in] initial_pressure    Array with pressure at start of timestep.
 	/// \param[in] pressure            Array with pressure.
@@ -174,7 +201,16 @@ namespace Opm
         std::vector<int> ja_upw_;
         std::vector<int> ia_downw_;
         std::vector<int> ja_downw_;
-        
+
+        // Schedule of the components of the reorder sequence.
+        std::vector<int> comp_level_;
+        std::vector<int> level_start_;
+        std::vector<int> level_comps_;
+
+        // Statistics, one entry per thread during solve().
+        std::vector<SolverStatistics> thread_statistics_;
+        SolverStatistics statistics_;
+
 	struct ResidualC;
 	struct ResidualS;
 
@@ -192,9 +228,11 @@ namespace Opm
 
 	virtual void solveSingleCell(const int cell);
 	virtual void solveMultiCell(const int num_cells, const int* cells);
-	void solveSingleCellBracketing(int cell);
-	void solveSingleCellNewton(int cell, bool use_sc, bool use_explicit_step = false);
-	void solveSingleCellGradient(int cell);
+        void solveLevels(const int* sequence, const int* components, const int num_components);
+        SolverStatistics& threadStatistics();
+	int solveSingleCellBracketing(int cell);
+	int solveSingleCellNewton(int cell, bool use_sc, bool use_explicit_step = false);
+	int solveSingleCellGradient(int cell);
         void solveSingleCellGravity(const std::vector<int>& cells,
                                     const int pos,
                                     const double* gravflux);
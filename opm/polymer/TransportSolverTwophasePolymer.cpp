@@ -27,9 +27,12 @@
 #include <opm/core/utility/miscUtilities.hpp>
 #include <opm/core/pressure/tpfa/trans_tpfa.h>
 #include <opm/common/ErrorMacros.hpp>
+#include <algorithm>
 #include <cmath>
+#include <exception>
 #include <list>
 #include <iostream>
+#include <numeric>
 // Choose error policy for scalar solves here.
 typedef Opm::RegulaFalsi<Opm::WarnAndContinueOnError> RootFinder;
 
@@ -1309,6 +1312,13 @@ namespace Opm
     }
 
     int TransportSolverTwophasePolymer::solveGravityColumn(const std::vector<int>& cells)
+    {
+        return solveGravityColumn(cells, s0_, c0_);
+    }
+
+    int TransportSolverTwophasePolymer::solveGravityColumn(const std::vector<int>& cells,
+                                                           std::vector<double>& s0,
+                                                           std::vector<double>& c0)
     {
         // Set up column gravflux.
         const int nc = cells.size();
@@ -1328,11 +1338,11 @@ namespace Opm
         }
 
         // Store initial saturation s0
-        s0_.resize(nc);
-        c0_.resize(nc);
+        s0.resize(nc);
+        c0.resize(nc);
         for (int ci = 0; ci < nc; ++ci) {
-            s0_[ci] = saturation_[cells[ci]];
-            c0_[ci] = concentration_[cells[ci]];
+            s0[ci] = saturation_[cells[ci]];
+            c0[ci] = concentration_[cells[ci]];
         }
 
         // Solve single cell problems, repeating if necessary.
@@ -1346,11 +1356,11 @@ namespace Opm
                                     saturation_[cells[ci2]] };
                 double old_c[2] = { concentration_[cells[ci]],
                                     concentration_[cells[ci2]] };
-                saturation_[cells[ci]] = s0_[ci];
-                concentration_[cells[ci]] = c0_[ci];
+                saturation_[cells[ci]] = s0[ci];
+                concentration_[cells[ci]] = c0[ci];
                 solveSingleCellGravity(cells, ci, &col_gravflux[0]);
-                saturation_[cells[ci2]] = s0_[ci2];
-                concentration_[cells[ci2]] = c0_[ci2];
+                saturation_[cells[ci2]] = s0[ci2];
+                concentration_[cells[ci2]] = c0[ci2];
                 solveSingleCellGravity(cells, ci2, &col_gravflux[0]);
                 max_sc_change = std::max(max_sc_change, 0.25*(std::fabs(saturation_[cells[ci]] - old_s[0]) + 
                                                               std::fabs(concentration_[cells[ci]] - old_c[0]) +
@@ -1393,19 +1403,50 @@ namespace Opm
         }
 
 
-        // Solve on all columns.
-        int num_iters = 0;
+        // Solve on all columns. The columns have no cells in common and
+        // are solved in parallel, with column variables per thread.
+        const int num_columns = columns.size();
+        column_iterations_.assign(num_columns, 0);
+        std::exception_ptr error;
         // std::cout << "Gauss-Seidel column solver # columns: " << columns.size() << std::endl;
-        for (std::vector<std::vector<int> >::size_type i = 0; i < columns.size(); i++) {
-            // std::cout << "==== new column" << std::endl;
-            num_iters += solveGravityColumn(columns[i]);
+#pragma omp parallel
+        {
+            std::vector<double> s0;
+            std::vector<double> c0;
+#pragma omp for schedule(dynamic)
+            for (int i = 0; i < num_columns; ++i) {
+                // std::cout << "==== new column" << std::endl;
+                try {
+                    column_iterations_[i] = solveGravityColumn(columns[i], s0, c0);
+                }
+                catch (...) {
+#pragma omp critical
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        if (num_columns > 0) {
+            const int num_iters = std::accumulate(column_iterations_.begin(), column_iterations_.end(), 0);
+            const auto max_iters = std::max_element(column_iterations_.begin(), column_iterations_.end());
+            std::cout << "Gauss-Seidel column solver average iterations: "
+                      << double(num_iters)/double(num_columns)
+                      << ", max " << *max_iters << " in column " << (max_iters - column_iterations_.begin())
+                      << std::endl;
         }
-        std::cout << "Gauss-Seidel column solver average iterations: "
-                  << double(num_iters)/double(columns.size()) << std::endl;
 
         toBothSat(saturation_, saturation);
     }
 
+    const std::vector<int>& TransportSolverTwophasePolymer::columnIterations() const
+    {
+        return column_iterations_;
+    }
+
     void TransportSolverTwophasePolymer::scToc(const double* x, double* x_c) const {
         x_c[0] = x[0];
         if (x[0] < 1e-2*tol_) {
@@ -104,6 +104,10 @@ namespace Opm
                           std::vector<double>& concentration,
                           std::vector<double>& cmax);
 
+        /// Number of Gauss-Seidel iterations used for each column by the
+        /// last call to solveGravity().
+        const std::vector<int>& columnIterations() const;
+
     public: // But should be made private...
 	virtual void solveSingleCell(const int cell);
 	virtual void solveMultiCell(const int num_cells, const int* cells);
@@ -118,6 +122,9 @@ namespace Opm
                                     const int pos,
                                     const double* gravflux);
         int solveGravityColumn(const std::vector<int>& cells);
+        int solveGravityColumn(const std::vector<int>& cells,
+                               std::vector<double>& s0,
+                               std::vector<double>& c0);
         void scToc(const double* x, double* x_c) const;
 
         #ifdef PROFILING
@@ -171,6 +178,7 @@ namespace Opm
         // For gravity segregation, column variables
         std::vector<double> s0_;
         std::vector<double> c0_;
+        std::vector<int> column_iterations_;
 
 	struct ResidualC;
 	struct ResidualS;
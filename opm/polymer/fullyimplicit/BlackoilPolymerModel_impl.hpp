@@ -245,8 +245,12 @@ namespace Opm {
             const V phi = Eigen::Map<const V>(&fluid_.porosity()[0], AutoDiffGrid::numCells(grid_));
             const double dead_pore_vol = polymer_props_ad_.deadPoreVol();
             // Compute polymer accumulation term.
-            sd_.rq[poly_pos_].accum[aix] = pv_mult * sd_.rq[pu.phase_pos[Water]].b * sat[pu.phase_pos[Water]] * c * (1. - dead_pore_vol)
-                                        + pv_mult * rho_rock * (1. - phi) / phi * ads;
+            ADB& accum = sd_.rq[poly_pos_].accum[aix];
+            accum = pv_mult * sd_.rq[pu.phase_pos[Water]].b;
+            accum *= sat[pu.phase_pos[Water]];
+            accum *= c;
+            accum *= (1. - dead_pore_vol);
+            accum.fma(pv_mult, rho_rock * (1. - phi) / phi * ads);
         }
 
     }
@@ -317,7 +321,7 @@ namespace Opm {
 
             residual_.material_balance_eq[ phaseIdx ] =
                 pvdt_ * (sd_.rq[phaseIdx].accum[1] - sd_.rq[phaseIdx].accum[0])
-                + ops_.div*sd_.rq[phaseIdx].mflux;
+                + ops_.stencil.div*sd_.rq[phaseIdx].mflux;
         }
 
         // -------- Extra (optional) rs and rv contributions to the mass balance equations --------
@@ -337,8 +341,8 @@ namespace Opm {
                                                 sd_.rq[pg].dh.value());
             const ADB rv_face = upwindGas.select(state.rv);
 
-            residual_.material_balance_eq[ pg ] += ops_.div * (rs_face * sd_.rq[po].mflux);
-            residual_.material_balance_eq[ po ] += ops_.div * (rv_face * sd_.rq[pg].mflux);
+            residual_.material_balance_eq[ pg ] += ops_.stencil.div * (rs_face * sd_.rq[po].mflux);
+            residual_.material_balance_eq[ po ] += ops_.stencil.div * (rv_face * sd_.rq[pg].mflux);
 
             // OPM_AD_DUMP(residual_.material_balance_eq[ Gas ]);
 
@@ -347,7 +351,7 @@ namespace Opm {
         // Add polymer equation.
         if (has_polymer_) {
             residual_.material_balance_eq[poly_pos_] = pvdt_ * (sd_.rq[poly_pos_].accum[1] - sd_.rq[poly_pos_].accum[0])
-                                               + ops_.div*sd_.rq[poly_pos_].mflux;
+                                               + ops_.stencil.div*sd_.rq[poly_pos_].mflux;
         }
 
 
@@ -613,8 +617,8 @@ namespace Opm {
 
         // compute gravity potensial using the face average as in eclipse and MRST
         const ADB rho   = fluidDensity(canonicalPhaseIdx, sd_.rq[phase].b, state.rs, state.rv);
-        const ADB rhoavg = ops_.caver * rho;
-        sd_.rq[ phase ].dh = ops_.ngrad * phasePressure[ canonicalPhaseIdx ] - geo_.gravity()[2] * (rhoavg * (ops_.ngrad * geo_.z().matrix()));
+        const ADB rhoavg = ops_.stencil.caver * rho;
+        sd_.rq[ phase ].dh = ops_.stencil.ngrad * phasePressure[ canonicalPhaseIdx ] - geo_.gravity()[2] * (rhoavg * (ops_.ngrad * geo_.z().matrix()));
         if (use_threshold_pressure_) {
             applyThresholdPressures(sd_.rq[ phase ].dh);
         }
@@ -123,9 +123,7 @@ namespace Opm {
     {
         int nc = c.size();
         V visc_mult(nc);
-        for (int i = 0; i < nc; ++i) {
-            visc_mult[i] = polymer_props_.viscMult(c[i]);
-        }
+        polymer_props_.viscMult(nc, c.data(), visc_mult.data(), nullptr);
         return visc_mult;
     }
 
@@ -136,13 +134,7 @@ namespace Opm {
         const int nc = c.size();
         V visc_mult(nc);
         V dvisc_mult(nc);
-
-        for (int i = 0; i < nc; ++i) {
-            double im = 0, dim = 0;
-            im = polymer_props_.viscMultWithDer(c.value()(i), &dim);
-            visc_mult(i) = im;
-            dvisc_mult(i) = dim;
-        }
+        polymer_props_.viscMult(nc, c.value().data(), visc_mult.data(), dvisc_mult.data());
 
         ADB::M dim_diag(dvisc_mult.matrix().asDiagonal());
         const int num_blocks = c.numBlocks();
@@ -249,12 +241,7 @@ namespace Opm {
     {
         const int nc = c.size();
         V mc(nc);
-
-        for (int i = 0; i < nc; ++i) {
-            double m = 0;
-            polymer_props_.computeMc(c(i), m);
-            mc(i) = m;
-        }
+        polymer_props_.computeMc(nc, c.data(), mc.data(), nullptr);
 
        return mc;
     }
@@ -269,15 +256,7 @@ namespace Opm {
         const int nc = c.size();
         V mc(nc);
         V dmc(nc);
-
-        for (int i = 0; i < nc; ++i) {
-            double m = 0;
-            double dm = 0;
-            polymer_props_.computeMcWithDer(c.value()(i), m, dm);
-
-            mc(i) = m;
-            dmc(i) = dm;
-        }
+        polymer_props_.computeMc(nc, c.value().data(), mc.data(), dmc.data());
 
         ADB::M dmc_diag(dmc.matrix().asDiagonal());
         const int num_blocks = c.numBlocks();
@@ -297,13 +276,7 @@ namespace Opm {
     {
         const int nc = c.size();
         V ads(nc);
-
-        for (int i = 0; i < nc; ++i) {
-            double c_ads = 0;
-            polymer_props_.adsorption(c(i), cmax_cells(i), c_ads);
-
-            ads(i) = c_ads;
-        }
+        polymer_props_.adsorption(nc, c.data(), cmax_cells.data(), ads.data(), nullptr);
 
         return ads;
     }
@@ -318,14 +291,8 @@ namespace Opm {
 
         V ads(nc);
         V dads(nc);
-
-        for (int i = 0; i < nc; ++i) {
-            double c_ads = 0;
-            double dc_ads = 0;
-            polymer_props_.adsorptionWithDer(c.value()(i), cmax_cells.value()(i), c_ads, dc_ads);
-            ads(i) = c_ads;
-            dads(i) = dc_ads;
-        }
+        polymer_props_.adsorption(nc, c.value().data(), cmax_cells.value().data(),
+                                  ads.data(), dads.data());
 
         ADB::M dads_diag(dads.matrix().asDiagonal());
         int num_blocks = c.numBlocks();
@@ -34,6 +34,7 @@
 #include <opm/autodiff/GeoProps.hpp>
 #include <opm/autodiff/BlackoilPropsAdFromDeck.hpp>
 #include <opm/autodiff/RateConverter.hpp>
+#include <opm/autodiff/CartesianToCompressed.hpp>
 #include <opm/autodiff/NonlinearSolver.hpp>
 
 #include <opm/core/grid.h>
@@ -148,10 +149,9 @@ namespace Opm
         std::vector<double> wells_perf_length_;
         std::vector<double> wells_bore_diameter_;
 
-        // generate the mapping from Cartesian grid cells to global compressed cells,
-        // copied from opm-core, to be used in function computeRepRadiusPerfLength()
-        static void
-        setupCompressedToCartesian(const int* global_cell, int number_of_cells, std::map<int,int>& cartesian_to_compressed);
+        // the mapping from Cartesian grid cells to compressed cells used in
+        // computeRepRadiusPerfLength(), created once for the grid
+        std::unique_ptr<CartesianToCompressed> cartesian_to_compressed_;
 
         //  calculate the representative radius and length for for well peforations
         //  and store the wellbore diameters
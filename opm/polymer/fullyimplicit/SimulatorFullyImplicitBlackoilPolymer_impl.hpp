@@ -131,25 +131,6 @@ namespace Opm
     }
 
 
-    template <class GridT>
-    void SimulatorFullyImplicitBlackoilPolymer<GridT>::
-    setupCompressedToCartesian(const int* global_cell, int number_of_cells,
-                               std::map<int,int>& cartesian_to_compressed )
-    {
-        if (global_cell) {
-            for (int i = 0; i < number_of_cells; ++i) {
-                cartesian_to_compressed.insert(std::make_pair(global_cell[i], i));
-            }
-        }
-        else {
-            for (int i = 0; i < number_of_cells; ++i) {
-                cartesian_to_compressed.insert(std::make_pair(i, i));
-            }
-        }
-
-    }
-
-
     template <class GridT>
     void SimulatorFullyImplicitBlackoilPolymer<GridT>::
     computeRepRadiusPerfLength(const Opm::EclipseState&        eclipseState,
@@ -184,10 +165,10 @@ namespace Opm
         wells_perf_length.reserve(n_perf);
         wells_bore_diameter.reserve(n_perf);
 
-        std::map<int,int> cartesian_to_compressed;
-
-        setupCompressedToCartesian(global_cell, number_of_cells,
-                                   cartesian_to_compressed);
+        if (!cartesian_to_compressed_) {
+            cartesian_to_compressed_.reset(new CartesianToCompressed(global_cell, number_of_cells, cart_dims));
+        }
+        const CartesianToCompressed& cartesian_to_compressed = *cartesian_to_compressed_;
 
         const auto& schedule = eclipseState.getSchedule();
         auto wells           = schedule.getWells(timeStep);
@@ -209,14 +190,11 @@ namespace Opm
                          int j = completion.getJ();
                          int k = completion.getK();
 
-                         const int* cpgdim = cart_dims;
-                         int cart_grid_indx = i + cpgdim[0]*(j + cpgdim[1]*k);
-                         std::map<int, int>::const_iterator cgit = cartesian_to_compressed.find(cart_grid_indx);
-                         if (cgit == cartesian_to_compressed.end()) {
+                         const int cell = cartesian_to_compressed.compressedIndex(i, j, k);
+                         if (cell < 0) {
                              OPM_THROW(std::runtime_error, "Cell with i,j,k indices " << i << ' ' << j << ' '
                                        << k << " not found in grid (well = " << well->name() << ')');
                          }
-                         int cell = cgit->second;
 
                          {
                              double radius = 0.5*completion.getDiameter();
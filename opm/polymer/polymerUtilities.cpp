@@ -22,6 +22,40 @@
 #include <opm/polymer/polymerUtilities.hpp>
 #include <opm/core/utility/miscUtilities.hpp>
 
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+    // The cells with a negative transport source, i.e. outflow.
+    std::vector<int> outflowCells(const std::vector<double>& transport_src)
+    {
+        std::vector<int> cells;
+        const int num_cells = transport_src.size();
+        for (int cell = 0; cell < num_cells; ++cell) {
+            if (transport_src[cell] < 0.0) {
+                cells.push_back(cell);
+            }
+        }
+        return cells;
+    }
+
+    // The n values of each of the given cells.
+    std::vector<double> cellValues(const std::vector<double>& values,
+                                   const std::vector<int>& cells,
+                                   const int n)
+    {
+        std::vector<double> cell_values(n*cells.size());
+        for (std::size_t i = 0; i < cells.size(); ++i) {
+            std::copy(values.begin() + n*cells[i], values.begin() + n*(cells[i] + 1),
+                      cell_values.begin() + n*i);
+        }
+        return cell_values;
+    }
+
+} // anonymous namespace
+
 namespace Opm
 {
 
@@ -44,11 +78,11 @@ namespace Opm
 	totmob.resize(num_cells);
 	std::vector<double> kr(2*num_cells);
 	props.relperm(num_cells, &s[0], &cells[0], &kr[0], 0);
-        const double* visc = props.viscosity();
+        std::vector<double> mob(2*num_cells);
+        polyprops.effectiveMobilities(num_cells, c.data(), cmax.data(), props.viscosity(), 0,
+                                      kr.data(), mob.data());
 	for (int cell = 0; cell < num_cells; ++cell) {
-            double*  kr_cell = &kr[2*cell];
-            polyprops.effectiveTotalMobility(c[cell], cmax[cell], visc, kr_cell,
-                                             totmob[cell]);
+            totmob[cell] = mob[2*cell] + mob[2*cell + 1];
 	}
     }
 
@@ -80,15 +114,15 @@ namespace Opm
 	assert(int(s.size()) == num_cells*num_phases);
 	std::vector<double> kr(num_cells*num_phases);
 	props.relperm(num_cells, &s[0], &cells[0], &kr[0], 0);
-	const double* visc = props.viscosity();
 	const double* rho = props.density();
-        double mob[2]; // here we assume num_phases=2
+        // here we assume num_phases=2
+        std::vector<double> mob(num_cells*num_phases);
+        polyprops.effectiveMobilities(num_cells, c.data(), cmax.data(), props.viscosity(), 0,
+                                      kr.data(), mob.data());
 	for (int cell = 0; cell < num_cells; ++cell) {
-            double*  kr_cell = &kr[2*cell];
-            polyprops.effectiveMobilities(c[cell], cmax[cell], visc, kr_cell,
-                                          mob);
-            totmob[cell] = mob[0] + mob[1];
-            omega[cell] = rho[0]*mob[0]/totmob[cell] + rho[1]*mob[1]/totmob[cell];
+            const double* mob_cell = &mob[2*cell];
+            totmob[cell] = mob_cell[0] + mob_cell[1];
+            omega[cell] = rho[0]*mob_cell[0]/totmob[cell] + rho[1]*mob_cell[1]/totmob[cell];
         }
     }
 
@@ -118,13 +152,13 @@ namespace Opm
 	assert(int(s.size()) == num_cells*num_phases);
 	std::vector<double> kr(num_cells*num_phases);
 	props.relperm(num_cells, &s[0], &cells[0], &kr[0], 0);
-	const double* visc = props.viscosity();
-        double mob[2]; // here we assume num_phases=2
+        std::vector<double> mob(num_cells*num_phases);
+        polyprops.effectiveMobilities(num_cells, c.data(), cmax.data(), props.viscosity(), 0,
+                                      kr.data(), mob.data());
 	for (int cell = 0; cell < num_cells; ++cell) {
-            double* kr_cell = &kr[2*cell];
-            polyprops.effectiveMobilities(c[cell], cmax[cell], visc, kr_cell, mob);
-            fractional_flows[2*cell]     = mob[0] / (mob[0] + mob[1]);
-            fractional_flows[2*cell + 1] = mob[1] / (mob[0] + mob[1]);
+            const double* mob_cell = &mob[2*cell];
+            fractional_flows[2*cell]     = mob_cell[0] / (mob_cell[0] + mob_cell[1]);
+            fractional_flows[2*cell + 1] = mob_cell[1] / (mob_cell[0] + mob_cell[1]);
         }
     }
 
@@ -161,13 +195,13 @@ namespace Opm
 	props.relperm(num_cells, &s[0], &cells[0], &kr[0], 0);
 	std::vector<double> mu(num_cells*num_phases);
 	props.viscosity(num_cells, &p[0], &T[0], &z[0], &cells[0], &mu[0], 0);
-        double mob[2]; // here we assume num_phases=2
+        std::vector<double> mob(num_cells*num_phases);
+        polyprops.effectiveMobilities(num_cells, c.data(), cmax.data(), mu.data(), num_phases,
+                                      kr.data(), mob.data());
 	for (int cell = 0; cell < num_cells; ++cell) {
-            double* kr_cell = &kr[2*cell];
-            double* mu_cell = &mu[2*cell];
-            polyprops.effectiveMobilities(c[cell], cmax[cell], mu_cell, kr_cell, mob);
-            fractional_flows[2*cell]     = mob[0] / (mob[0] + mob[1]);
-            fractional_flows[2*cell + 1] = mob[1] / (mob[0] + mob[1]);
+            const double* mob_cell = &mob[2*cell];
+            fractional_flows[2*cell]     = mob_cell[0] / (mob_cell[0] + mob_cell[1]);
+            fractional_flows[2*cell + 1] = mob_cell[1] / (mob_cell[0] + mob_cell[1]);
         }
     }
 
@@ -210,35 +244,45 @@ namespace Opm
         if (int(state.saturation().size()) != num_cells*np) {
             OPM_THROW(std::runtime_error, "Sizes of state vectors do not match number of cells.");
         }
-        const std::vector<double>& s = state.saturation();
-        const std::vector<double>& c = state.getCellData( state.CONCENTRATION );
-        const std::vector<double>& cmax = state.getCellData( state.CMAX );
+        if (np != 2) {
+            OPM_THROW(std::runtime_error, "computeInjectedProduced() assumes 2 phases.");
+        }
         std::fill(injected, injected + np, 0.0);
         std::fill(produced, produced + np, 0.0);
         polyinj = 0.0;
         polyprod = 0.0;
-        const double* visc = props.viscosity();
-        std::vector<double> kr_cell(np);
-        double mob[2];
-        double mc;
         for (int cell = 0; cell < num_cells; ++cell) {
             if (transport_src[cell] > 0.0) {
                 injected[0] += transport_src[cell]*dt;
                 polyinj += transport_src[cell]*dt*inj_c[cell];
-            } else if (transport_src[cell] < 0.0) {
-                const double flux = -transport_src[cell]*dt;
-                const double* sat = &s[np*cell];
-                props.relperm(1, sat, &cell, &kr_cell[0], 0);
-                polyprops.effectiveMobilities(c[cell], cmax[cell], visc,
-                                              &kr_cell[0], mob);
-                double totmob = mob[0] + mob[1];
-                for (int p = 0; p < np; ++p) {
-                    produced[p] += (mob[p]/totmob)*flux;
-                }
-                polyprops.computeMc(c[cell], mc);
-                polyprod += (mob[0]/totmob)*flux*mc;
             }
         }
+
+        // the mobilities of all cells with outflow in one call
+        const std::vector<int> cells = outflowCells(transport_src);
+        const int num_prod = cells.size();
+        if (num_prod == 0) {
+            return;
+        }
+        const std::vector<double> s = cellValues(state.saturation(), cells, np);
+        const std::vector<double> c = cellValues(state.getCellData( state.CONCENTRATION ), cells, 1);
+        const std::vector<double> cmax = cellValues(state.getCellData( state.CMAX ), cells, 1);
+        std::vector<double> kr(np*num_prod);
+        props.relperm(num_prod, s.data(), cells.data(), kr.data(), 0);
+        std::vector<double> mob(np*num_prod);
+        polyprops.effectiveMobilities(num_prod, c.data(), cmax.data(), props.viscosity(), 0,
+                                      kr.data(), mob.data());
+        std::vector<double> mc(num_prod);
+        polyprops.computeMc(num_prod, c.data(), mc.data(), nullptr);
+        for (int i = 0; i < num_prod; ++i) {
+            const double flux = -transport_src[cells[i]]*dt;
+            const double* mob_cell = &mob[np*i];
+            double totmob = mob_cell[0] + mob_cell[1];
+            for (int p = 0; p < np; ++p) {
+                produced[p] += (mob_cell[p]/totmob)*flux;
+            }
+            polyprod += (mob_cell[0]/totmob)*flux*mc[i];
+        }
     }
 
     /// @brief Computes injected and produced volumes of all phases,
@@ -278,56 +322,67 @@ namespace Opm
         if (int(state.saturation().size()) != num_cells*np) {
             OPM_THROW(std::runtime_error, "Sizes of state vectors do not match number of cells.");
         }
-        const std::vector<double>& press = state.pressure();
-        const std::vector<double>& temp = state.temperature();
-        const std::vector<double>& s = state.saturation();
-        const std::vector<double>& z = state.surfacevol();
-        const std::vector<double>& c = state.getCellData( state.CONCENTRATION );
-        const std::vector<double>& cmax = state.getCellData( state.CMAX );
+        if (np != 2) {
+            OPM_THROW(std::runtime_error, "computeInjectedProduced() assumes 2 phases.");
+        }
         std::fill(injected, injected + np, 0.0);
         std::fill(produced, produced + np, 0.0);
         polyinj = 0.0;
         polyprod = 0.0;
-        std::vector<double> visc(np);
-        std::vector<double> kr_cell(np);
-        std::vector<double> mob(np);
-        std::vector<double> A(np*np);
-        std::vector<double> prod_resv_phase(np);
-        std::vector<double> prod_surfvol(np);
-        double mc;
         for (int cell = 0; cell < num_cells; ++cell) {
             if (transport_src[cell] > 0.0) {
                 // Inflowing transport source is a surface volume flux
                 // for the first phase.
                 injected[0] += transport_src[cell]*dt;
                 polyinj += transport_src[cell]*dt*inj_c[cell];
-            } else if (transport_src[cell] < 0.0) {
-                // Outflowing transport source is a total reservoir
-                // volume flux.
-                const double flux = -transport_src[cell]*dt;
-                const double* sat = &s[np*cell];
-                props.relperm(1, sat, &cell, &kr_cell[0], 0);
-                props.viscosity(1, &press[cell], &temp[cell], &z[np*cell], &cell, &visc[0], 0);
-                props.matrix(1, &press[cell], &temp[cell], &z[np*cell], &cell, &A[0], 0);
-                polyprops.effectiveMobilities(c[cell], cmax[cell], &visc[0],
-                                              &kr_cell[0], &mob[0]);
-                double totmob = 0.0;
-                for (int p = 0; p < np; ++p) {
-                    totmob += mob[p];
-                }
-                std::fill(prod_surfvol.begin(), prod_surfvol.end(), 0.0);
-                for (int p = 0; p < np; ++p) {
-                    prod_resv_phase[p] = (mob[p]/totmob)*flux;
-                    for (int q = 0; q < np; ++q) {
-                        prod_surfvol[q] += prod_resv_phase[p]*A[q + np*p];
-                    }
-                }
-                for (int p = 0; p < np; ++p) {
-                    produced[p] += prod_surfvol[p];
+            }
+        }
+
+        // Outflowing transport source is a total reservoir volume flux,
+        // the properties of all cells with outflow are computed in one call.
+        const std::vector<int> cells = outflowCells(transport_src);
+        const int num_prod = cells.size();
+        if (num_prod == 0) {
+            return;
+        }
+        const std::vector<double> press = cellValues(state.pressure(), cells, 1);
+        const std::vector<double> temp = cellValues(state.temperature(), cells, 1);
+        const std::vector<double> s = cellValues(state.saturation(), cells, np);
+        const std::vector<double> z = cellValues(state.surfacevol(), cells, np);
+        const std::vector<double> c = cellValues(state.getCellData( state.CONCENTRATION ), cells, 1);
+        const std::vector<double> cmax = cellValues(state.getCellData( state.CMAX ), cells, 1);
+        std::vector<double> kr(np*num_prod);
+        std::vector<double> visc(np*num_prod);
+        std::vector<double> A(np*np*num_prod);
+        props.relperm(num_prod, s.data(), cells.data(), kr.data(), 0);
+        props.viscosity(num_prod, press.data(), temp.data(), z.data(), cells.data(), visc.data(), 0);
+        props.matrix(num_prod, press.data(), temp.data(), z.data(), cells.data(), A.data(), 0);
+        std::vector<double> mob(np*num_prod);
+        polyprops.effectiveMobilities(num_prod, c.data(), cmax.data(), visc.data(), np,
+                                      kr.data(), mob.data());
+        std::vector<double> mc(num_prod);
+        polyprops.computeMc(num_prod, c.data(), mc.data(), nullptr);
+        std::vector<double> prod_resv_phase(np);
+        std::vector<double> prod_surfvol(np);
+        for (int i = 0; i < num_prod; ++i) {
+            const double flux = -transport_src[cells[i]]*dt;
+            const double* mob_cell = &mob[np*i];
+            const double* A_cell = &A[np*np*i];
+            double totmob = 0.0;
+            for (int p = 0; p < np; ++p) {
+                totmob += mob_cell[p];
+            }
+            std::fill(prod_surfvol.begin(), prod_surfvol.end(), 0.0);
+            for (int p = 0; p < np; ++p) {
+                prod_resv_phase[p] = (mob_cell[p]/totmob)*flux;
+                for (int q = 0; q < np; ++q) {
+                    prod_surfvol[q] += prod_resv_phase[p]*A_cell[q + np*p];
                 }
-                polyprops.computeMc(c[cell], mc);
-                polyprod += produced[0]*mc;
             }
+            for (int p = 0; p < np; ++p) {
+                produced[p] += prod_surfvol[p];
+            }
+            polyprod += produced[0]*mc[i];
         }
     }
 
@@ -0,0 +1,211 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+#include <opm/simulators/MetricsExporter.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace Opm
+{
+
+    namespace
+    {
+        const double secondsPerDay = 86400.0;
+
+        // A UDP socket connected to host:port.
+        int connectUdp(const std::string& address)
+        {
+            const std::string::size_type colon = address.find_last_of(':');
+            if (colon == std::string::npos || colon == 0 || colon + 1 == address.size()) {
+                OPM_THROW(std::runtime_error, "Invalid metrics address '" << address << "', expected host:port");
+            }
+            const std::string host = address.substr(0, colon);
+            const std::string port = address.substr(colon + 1);
+
+            addrinfo hints = addrinfo();
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_DGRAM;
+            addrinfo* result = nullptr;
+            if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0) {
+                OPM_THROW(std::runtime_error, "Could not resolve the metrics address '" << address << "'");
+            }
+            int fd = -1;
+            for (addrinfo* info = result; info != nullptr && fd < 0; info = info->ai_next) {
+                fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+                if (fd >= 0 && connect(fd, info->ai_addr, info->ai_addrlen) != 0) {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+            freeaddrinfo(result);
+            if (fd < 0) {
+                OPM_THROW(std::runtime_error, "Could not open a socket to the metrics address '" << address << "'");
+            }
+            return fd;
+        }
+    } // anonymous namespace
+
+
+    MetricsExporter::MetricsExporter(const std::string& filename,
+                                     const std::string& udpAddress,
+                                     const std::string& caseName)
+        : filename_(filename)
+        , caseName_(caseName)
+        , socket_(udpAddress.empty() ? -1 : connectUdp(udpAddress))
+        , start_(std::chrono::steady_clock::now())
+        , started_(false)
+        , startTime_(0.0)
+        , simulatedTime_(0.0)
+        , totalTime_(0.0)
+        , stepLength_(0.0)
+        , reportStep_(0)
+        , steps_(0)
+        , failures_(0)
+        , newtonIterations_(0)
+        , linearIterations_(0)
+        , lastNewtonIterations_(0)
+        , lastLinearIterations_(0)
+        , wallSeconds_(0.0)
+    {
+    }
+
+
+    MetricsExporter::~MetricsExporter()
+    {
+        if (socket_ >= 0) {
+            close(socket_);
+        }
+    }
+
+
+    void MetricsExporter::recordStep(const double simulatedTime,
+                                     const double totalTime,
+                                     const double stepLength,
+                                     const int reportStep,
+                                     const bool converged,
+                                     const int newtonIterations,
+                                     const int linearIterations)
+    {
+        if (!started_) {
+            // the throughput of a restarted run counts from its first step
+            startTime_ = converged ? simulatedTime - stepLength : simulatedTime;
+            started_ = true;
+        }
+        simulatedTime_ = simulatedTime;
+        totalTime_ = totalTime;
+        stepLength_ = stepLength;
+        reportStep_ = reportStep;
+        if (converged) {
+            ++steps_;
+        } else {
+            ++failures_;
+        }
+        newtonIterations_ += newtonIterations;
+        linearIterations_ += linearIterations;
+        lastNewtonIterations_ = newtonIterations;
+        lastLinearIterations_ = linearIterations;
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+        wallSeconds_ = elapsed.count();
+        publish();
+    }
+
+
+    std::string MetricsExporter::prometheusText() const
+    {
+        const double throughput = wallSeconds_ > 0.0
+            ? (simulatedTime_ - startTime_) / secondsPerDay / (wallSeconds_ / 3600.0) : 0.0;
+        const std::string label = "{case=\"" + caseName_ + "\"}";
+        std::ostringstream os;
+        os << std::setprecision(10);
+        auto metric = [&os, &label](const char* name, const char* type, const char* help, const double value) {
+            os << "# HELP " << name << " " << help << "\n"
+               << "# TYPE " << name << " " << type << "\n"
+               << name << label << " " << value << "\n";
+        };
+        metric("flow_simulated_days", "gauge", "Simulated time.", simulatedTime_ / secondsPerDay);
+        metric("flow_total_days", "gauge", "Simulated time at the end of the run.", totalTime_ / secondsPerDay);
+        metric("flow_timestep_days", "gauge", "Length of the last attempted time step.", stepLength_ / secondsPerDay);
+        metric("flow_report_step", "gauge", "Index of the current report step.", reportStep_);
+        metric("flow_timesteps_total", "counter", "Converged time steps.", steps_);
+        metric("flow_timestep_failures_total", "counter", "Failed time steps that were chopped.", failures_);
+        metric("flow_newton_iterations_total", "counter", "Newton iterations of all time steps.", newtonIterations_);
+        metric("flow_linear_iterations_total", "counter", "Linear iterations of all time steps.", linearIterations_);
+        metric("flow_newton_iterations_last_step", "gauge", "Newton iterations of the last time step.", lastNewtonIterations_);
+        metric("flow_linear_iterations_last_step", "gauge", "Linear iterations of the last time step.", lastLinearIterations_);
+        metric("flow_wall_seconds", "gauge", "Wall time since the start of the simulation.", wallSeconds_);
+        metric("flow_throughput_days_per_hour", "gauge", "Simulated days per wall hour.", throughput);
+        return os.str();
+    }
+
+
+    std::string MetricsExporter::statsdText() const
+    {
+        const double throughput = wallSeconds_ > 0.0
+            ? (simulatedTime_ - startTime_) / secondsPerDay / (wallSeconds_ / 3600.0) : 0.0;
+        const std::string prefix = "flow." + caseName_ + ".";
+        std::ostringstream os;
+        os << std::setprecision(10)
+           << prefix << "simulated_days:" << simulatedTime_ / secondsPerDay << "|g\n"
+           << prefix << "total_days:" << totalTime_ / secondsPerDay << "|g\n"
+           << prefix << "timestep_days:" << stepLength_ / secondsPerDay << "|g\n"
+           << prefix << "report_step:" << reportStep_ << "|g\n"
+           << prefix << "timesteps:" << steps_ << "|g\n"
+           << prefix << "timestep_failures:" << failures_ << "|g\n"
+           << prefix << "newton_iterations:" << newtonIterations_ << "|g\n"
+           << prefix << "linear_iterations:" << linearIterations_ << "|g\n"
+           << prefix << "newton_iterations_last_step:" << lastNewtonIterations_ << "|g\n"
+           << prefix << "linear_iterations_last_step:" << lastLinearIterations_ << "|g\n"
+           << prefix << "throughput_days_per_hour:" << throughput << "|g\n";
+        return os.str();
+    }
+
+
+    void MetricsExporter::publish() const
+    {
+        if (!filename_.empty()) {
+            // written to a temporary file and renamed, readers never see a
+            // partial file
+            const std::string tmp = filename_ + ".tmp";
+            {
+                std::ofstream os(tmp.c_str());
+                os << prometheusText();
+            }
+            std::rename(tmp.c_str(), filename_.c_str());
+        }
+        if (socket_ >= 0) {
+            // a lost datagram is replaced by the next one
+            const std::string text = statsdText();
+            const ssize_t sent = send(socket_, text.data(), text.size(), 0);
+            static_cast<void>(sent);
+        }
+    }
+
+} // namespace Opm
@@ -0,0 +1,102 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef OPM_METRICSEXPORTER_HEADER_INCLUDED
+#define OPM_METRICSEXPORTER_HEADER_INCLUDED
+
+#include <chrono>
+#include <string>
+
+namespace Opm
+{
+
+    /// Publishes the progress of a running simulation after every time
+    /// step, for schedulers to detect stalled or thrashing jobs:
+    ///
+    ///  - to a file in the Prometheus text exposition format, replaced
+    ///    atomically such that it can be read at any time, e.g. by the
+    ///    textfile collector of the node exporter, and/or
+    ///  - as statsd gauges and counters in one UDP datagram to host:port.
+    ///
+    /// Only one process of a parallel run should publish.
+    class MetricsExporter
+    {
+    public:
+        /// \param[in] filename    Prometheus text file, empty for none
+        /// \param[in] udpAddress  statsd address host:port, empty for none
+        /// \param[in] caseName    value of the case label of the metrics
+        MetricsExporter(const std::string& filename,
+                        const std::string& udpAddress,
+                        const std::string& caseName);
+
+        ~MetricsExporter();
+
+        MetricsExporter(const MetricsExporter&) = delete;
+        MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+        /// Record an attempted time step and publish the metrics.
+        /// \param[in] simulatedTime     simulated time in seconds after the step,
+        ///                              before it if the step failed
+        /// \param[in] totalTime         simulated time of the run in seconds
+        /// \param[in] stepLength        length of the attempted step in seconds
+        /// \param[in] reportStep        index of the report step
+        /// \param[in] converged         whether the step converged
+        /// \param[in] newtonIterations  Newton iterations of the step
+        /// \param[in] linearIterations  linear iterations of the step
+        void recordStep(const double simulatedTime,
+                        const double totalTime,
+                        const double stepLength,
+                        const int reportStep,
+                        const bool converged,
+                        const int newtonIterations,
+                        const int linearIterations);
+
+        /// The metrics in the Prometheus text exposition format.
+        std::string prometheusText() const;
+
+        /// The metrics as statsd lines.
+        std::string statsdText() const;
+
+    private:
+        void publish() const;
+
+        std::string filename_;
+        std::string caseName_;
+        int socket_;
+        std::chrono::steady_clock::time_point start_;
+
+        bool started_;
+        double startTime_;
+        double simulatedTime_;
+        double totalTime_;
+        double stepLength_;
+        int reportStep_;
+        long steps_;
+        long failures_;
+        long newtonIterations_;
+        long linearIterations_;
+        int lastNewtonIterations_;
+        int lastLinearIterations_;
+        double wallSeconds_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_METRICSEXPORTER_HEADER_INCLUDED
@@ -21,13 +21,24 @@
 #ifndef OPM_PARALLELFILEMERGER_HEADER_INCLUDED
 #define OPM_PARALLELFILEMERGER_HEADER_INCLUDED
 
+#include <array>
 #include <memory>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/regex.hpp>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif
+
 namespace Opm
 {
 namespace detail
@@ -35,30 +46,140 @@ namespace detail
 
 namespace fs = boost::filesystem;
 
+/// \brief Append the contents of a file to another file.
+///
+/// The data is copied in the kernel with sendfile on Linux and in blocks
+/// of 1 MiB otherwise. Streams writing to the target must be flushed
+/// before.
+/// \param from The file to append.
+/// \param to The file appended to, it is created if it does not exist.
+inline void appendFileContents(const fs::path& from, const fs::path& to)
+{
+    const std::size_t blockSize = 1 << 20;
+#ifdef __linux__
+    const int in = ::open(from.c_str(), O_RDONLY);
+    const int out = ::open(to.c_str(), O_WRONLY | O_CREAT, 0666);
+    if ( in < 0 || out < 0 || ::lseek(out, 0, SEEK_END) < 0 )
+    {
+        std::cerr << "WARNING: Could not append file " << from.string()
+                  << " to " << to.string() << std::endl;
+    }
+    else
+    {
+        // sendfile advances the offset of in, so a fallback continues
+        // where it stopped
+        bool useSendfile = true;
+        std::vector<char> buffer;
+        while ( true )
+        {
+            ssize_t copied = -1;
+            if ( useSendfile )
+            {
+                copied = ::sendfile(out, in, nullptr, blockSize);
+                if ( copied < 0 )
+                {
+                    useSendfile = false;
+                    continue;
+                }
+            }
+            else
+            {
+                buffer.resize(blockSize);
+                copied = ::read(in, buffer.data(), buffer.size());
+                for ( ssize_t written = 0; copied > 0 && written < copied; )
+                {
+                    const ssize_t n = ::write(out, buffer.data() + written, copied - written);
+                    if ( n < 0 )
+                    {
+                        copied = -1;
+                        break;
+                    }
+                    written += n;
+                }
+            }
+            if ( copied <= 0 )
+            {
+                if ( copied < 0 )
+                {
+                    std::cerr << "WARNING: Error while appending file " << from.string()
+                              << " to " << to.string() << std::endl;
+                }
+                break;
+            }
+        }
+    }
+    if ( in >= 0 )
+    {
+        ::close(in);
+    }
+    if ( out >= 0 )
+    {
+        ::close(out);
+    }
+#else
+    fs::ifstream in(from, std::ios::binary);
+    fs::ofstream out(to, std::ios::binary | std::ios::app);
+    std::vector<char> buffer(blockSize);
+    while ( in.read(buffer.data(), buffer.size()) || in.gcount() > 0 )
+    {
+        out.write(buffer.data(), in.gcount());
+    }
+#endif
+}
+
+/// \brief Write the line that precedes the output of a rank in a merged file.
+inline void writeSectionHeader(std::ostream& of, const fs::path& file, const std::string& rank)
+{
+    of<<std::endl<< std::endl;
+    of<<"=======================================================";
+    of<<std::endl<<std::endl;
+    of << " Output written by rank " << rank << " to file " << file.string();
+    of << ":" << std::endl << std::endl;
+}
+
+/// \brief Write the line that follows the output of a rank in a merged file.
+inline void writeSectionFooter(std::ostream& of)
+{
+    of << std::endl << std::endl;
+    of << "======================== end output =====================";
+    of << std::endl;
+}
+
 /// \brief A functor that merges multiple files of a parallel run to one file.
 ///
 /// Without care multiple processes might log messages in a parallel run.
 /// Non-root processes will do that to seperate files
 /// <basename>.<rank>.<extension. This functor will append those file
 /// to usual ones and delete the other files.
+///
+/// Alternatively it only writes an index of the non-empty files with their
+/// sizes to <basename>.PRT.index and .<basename>.DEBUG.index and keeps them.
 class ParallelFileMerger
 {
 public:
     /// \brief Constructor
     /// \param output_dir The output directory to use for reading/Writing.
     /// \param deckanme The name of the deck.
+    /// \param writeIndex Whether to write an index instead of merging.
     ParallelFileMerger(const fs::path& output_dir,
-                       const std::string& deckname)
+                       const std::string& deckname,
+                       const bool writeIndex = false)
         : debugFileRegex_("\\."+deckname+"\\.\\d+\\.DEBUG"),
-          logFileRegex_(deckname+"\\.\\d+\\.PRT")
+          logFileRegex_(deckname+"\\.\\d+\\.PRT"),
+          writeIndex_(writeIndex)
     {
-        auto debugPath = output_dir;
-        debugPath /= (std::string(".") + deckname + ".DEBUG");
-        debugStream_.reset(new fs::ofstream(debugPath,
+        debugPath_ = output_dir;
+        debugPath_ /= (std::string(".") + deckname + ".DEBUG");
+        logPath_ = output_dir;
+        logPath_ /= ( deckname + ".PRT");
+        if ( writeIndex_ )
+        {
+            debugPath_ += ".index";
+            logPath_ += ".index";
+        }
+        debugStream_.reset(new fs::ofstream(debugPath_,
                                             std::ofstream::app));
-        auto logPath = output_dir;
-        logPath /= ( deckname + ".PRT");
-        logStream_.reset(new fs::ofstream(logPath,
+        logStream_.reset(new fs::ofstream(logPath_,
                                           std::ofstream::app));
     }
 
@@ -74,13 +195,13 @@ public:
 
             if( boost::regex_match(filename, logFileRegex_) )
             {
-                appendFile(*logStream_, file, rank);
+                appendFile(*logStream_, logPath_, file, rank);
             }
             else
             {
                 if (boost::regex_match(filename, debugFileRegex_)  )
                 {
-                    appendFile(*debugStream_, file, rank);
+                    appendFile(*debugStream_, debugPath_, file, rank);
                 }
                 else
                 {
@@ -95,26 +216,29 @@ public:
 private:
     /// \brief Append contents of a file to a stream
     /// \brief of The output stream to use.
+    /// \brief target The file the stream writes to.
     /// \brief file The file whose content to append.
     /// \brief rank The rank that wrote the file.
-    void appendFile(fs::ofstream& of, const fs::path& file, const std::string& rank)
+    void appendFile(fs::ofstream& of, const fs::path& target,
+                    const fs::path& file, const std::string& rank)
     {
-        if( fs::file_size(file) )
+        const auto size = fs::file_size(file);
+        if( size )
         {
             std::cerr << "WARNING: There has been logging to file "
                       << file.string() <<" by process "
                       << rank << std::endl;
 
-            fs::ifstream in(file);
-            of<<std::endl<< std::endl;
-            of<<"=======================================================";
-            of<<std::endl<<std::endl;
-            of << " Output written by rank " << rank << " to file " << file.string();
-            of << ":" << std::endl << std::endl;
-            of << in.rdbuf() << std::endl << std::endl;
-            of << "======================== end output =====================";
-            of << std::endl;
-            in.close();
+            if ( writeIndex_ )
+            {
+                of << rank << " " << size << " " << file.string() << std::endl;
+                return;
+            }
+
+            writeSectionHeader(of, file, rank);
+            of.flush();
+            appendFileContents(file, target);
+            writeSectionFooter(of);
         }
         fs::remove(file);
     }
@@ -127,7 +251,102 @@ private:
     std::unique_ptr<fs::ofstream> debugStream_;
     /// \brief Stream to *.PRT file
     std::unique_ptr<fs::ofstream> logStream_;
+    /// \brief The files written by debugStream_ and logStream_.
+    fs::path debugPath_;
+    fs::path logPath_;
+    /// \brief Whether the files are only listed in an index.
+    bool writeIndex_;
 };
+
+/// \brief Merge the log files of all processes of a parallel run along a
+/// binary tree.
+///
+/// Every process first wraps its own files <basename>.<rank>.PRT and
+/// .<basename>.<rank>.DEBUG in the section markers of ParallelFileMerger.
+/// Then, in round k, each process whose rank is a multiple of 2^(k+1)
+/// appends the sections collected by rank + 2^k to its own. Thus the
+/// copying is spread over the processes and rank 0 appends only
+/// log2(#processes) files. The sections end up in the order of the ranks.
+/// Collective.
+/// \param output_dir The output directory to use for reading/Writing.
+/// \param deckname The name of the deck.
+/// \param comm The collective communication of all processes.
+template <class Communication>
+void mergeParallelFilesTree(const fs::path& output_dir,
+                            const std::string& deckname,
+                            const Communication& comm)
+{
+    const int rank = comm.rank();
+    const int size = comm.size();
+
+    // the prefix and suffix of the log and debug files
+    const std::array<std::pair<std::string, std::string>, 2> kinds =
+        {{ { "", ".PRT" }, { ".", ".DEBUG" } }};
+    const auto path = [&](const std::size_t kind, const int r, const bool sections)
+    {
+        std::ostringstream name;
+        name << kinds[kind].first << deckname;
+        if ( r > 0 )
+        {
+            name << "." << r;
+        }
+        name << kinds[kind].second;
+        // rank 0 collects the sections in the merged file itself
+        if ( r > 0 && sections )
+        {
+            name << ".sections";
+        }
+        return output_dir / name.str();
+    };
+
+    if ( rank > 0 )
+    {
+        for ( std::size_t kind = 0; kind < kinds.size(); ++kind )
+        {
+            const fs::path file = path(kind, rank, false);
+            if ( ! fs::exists(file) )
+            {
+                continue;
+            }
+            if ( fs::file_size(file) )
+            {
+                std::cerr << "WARNING: There has been logging to file "
+                          << file.string() <<" by process "
+                          << rank << std::endl;
+
+                const fs::path sections = path(kind, rank, true);
+                {
+                    fs::ofstream of(sections, std::ofstream::trunc);
+                    writeSectionHeader(of, file, std::to_string(rank));
+                }
+                appendFileContents(file, sections);
+                {
+                    fs::ofstream of(sections, std::ofstream::app);
+                    writeSectionFooter(of);
+                }
+            }
+            fs::remove(file);
+        }
+    }
+
+    for ( int stride = 1; stride < size; stride *= 2 )
+    {
+        // the sections of the children are complete
+        comm.barrier();
+        if ( rank % (2 * stride) == 0 && rank + stride < size )
+        {
+            for ( std::size_t kind = 0; kind < kinds.size(); ++kind )
+            {
+                const fs::path child = path(kind, rank + stride, true);
+                if ( fs::exists(child) )
+                {
+                    appendFileContents(child, path(kind, rank, true));
+                    fs::remove(child);
+                }
+            }
+        }
+    }
+}
 } // end namespace detail
 } // end namespace OPM
 #endif // end header guard
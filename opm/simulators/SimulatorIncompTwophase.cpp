@@ -55,6 +55,8 @@
 
 
 #include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cmath>
 #include <memory>
 
 #include <iostream>
@@ -91,6 +93,9 @@ namespace Opm
         // Parameters for well control
         bool check_well_controls_;
         int max_well_control_iterations_;
+        // Parameters for the pressure-transport iteration
+        int nl_pressure_transport_maxiter_;
+        double nl_pressure_change_tolerance_;
         // Parameters for transport solver.
         int num_transport_substeps_;
         bool use_reorder_;
@@ -376,6 +381,10 @@ namespace Opm
         check_well_controls_ = param.getDefault("check_well_controls", false);
         max_well_control_iterations_ = param.getDefault("max_well_control_iterations", 10);
 
+        // Pressure-transport iteration init.
+        nl_pressure_transport_maxiter_ = param.getDefault("nl_pressure_transport_maxiter", 1);
+        nl_pressure_change_tolerance_ = param.getDefault("nl_pressure_change_tolerance", 1.0);
+
         // Transport related init.
         num_transport_substeps_ = param.getDefault("num_transport_substeps", 1);
 
@@ -456,74 +465,114 @@ namespace Opm
 
             SimulatorReport sreport;
 
-            // Solve pressure equation.
-            if (check_well_controls_) {
-                computeFractionalFlow(props_, allcells_, state.saturation(), fractional_flows);
-                wells_manager_.applyExplicitReinjectionControls(well_resflows_phase, well_resflows_phase);
-            }
-            bool well_control_passed = !check_well_controls_;
-            int well_control_iteration = 0;
-            do {
-                // Run solver.
-                pressure_timer.start();
-                std::vector<double> initial_pressure = state.pressure();
-                psolver_.solve(timer.currentStepLength(), state, well_state);
-
-                // Renormalize pressure if rock is incompressible, and
-                // there are no pressure conditions (bcs or wells).
-                // It is deemed sufficient for now to renormalize
-                // using geometric volume instead of pore volume.
-                if ((rock_comp_props_ == NULL || !rock_comp_props_->isActive())
-                    && allNeumannBCs(bcs_) && allRateWells(wells_)) {
-                    // Compute average pressures of previous and last
-                    // step, and total volume.
-                    double av_prev_press = 0.0;
-                    double av_press = 0.0;
-                    double tot_vol = 0.0;
-                    const int num_cells = grid_.number_of_cells;
-                    for (int cell = 0; cell < num_cells; ++cell) {
-                        av_prev_press += initial_pressure[cell]*grid_.cell_volumes[cell];
-                        av_press      += state.pressure()[cell]*grid_.cell_volumes[cell];
-                        tot_vol       += grid_.cell_volumes[cell];
-                    }
-                    // Renormalization constant
-                    const double ren_const = (av_prev_press - av_press)/tot_vol;
-                    for (int cell = 0; cell < num_cells; ++cell) {
-                        state.pressure()[cell] += ren_const;
-                    }
-                    const int num_wells = (wells_ == NULL) ? 0 : wells_->number_of_wells;
-                    for (int well = 0; well < num_wells; ++well) {
-                        well_state.bhp()[well] += ren_const;
-                    }
+            // Solve pressure equation. With more than one pressure-transport
+            // iteration, a trial transport step gives the saturations, and
+            // thus the mobilities, of the next pressure solve, which starts
+            // from the last pressure. The step itself is transported from
+            // the initial saturations with the fluxes of the last pressure.
+            const std::vector<double> step_saturation = state.saturation();
+            std::vector<double> last_pressure;
+            for (int pt_iteration = 0; ; ++pt_iteration) {
+                if (check_well_controls_) {
+                    computeFractionalFlow(props_, allcells_, state.saturation(), fractional_flows);
+                    wells_manager_.applyExplicitReinjectionControls(well_resflows_phase, well_resflows_phase);
                 }
+                bool well_control_passed = !check_well_controls_;
+                int well_control_iteration = 0;
+                do {
+                    // Run solver.
+                    pressure_timer.start();
+                    std::vector<double> initial_pressure = state.pressure();
+                    psolver_.solve(timer.currentStepLength(), state, well_state);
+
+                    // Renormalize pressure if rock is incompressible, and
+                    // there are no pressure conditions (bcs or wells).
+                    // It is deemed sufficient for now to renormalize
+                    // using geometric volume instead of pore volume.
+                    if ((rock_comp_props_ == NULL || !rock_comp_props_->isActive())
+                        && allNeumannBCs(bcs_) && allRateWells(wells_)) {
+                        // Compute average pressures of previous and last
+                        // step, and total volume.
+                        double av_prev_press = 0.0;
+                        double av_press = 0.0;
+                        double tot_vol = 0.0;
+                        const int num_cells = grid_.number_of_cells;
+                        for (int cell = 0; cell < num_cells; ++cell) {
+                            av_prev_press += initial_pressure[cell]*grid_.cell_volumes[cell];
+                            av_press      += state.pressure()[cell]*grid_.cell_volumes[cell];
+                            tot_vol       += grid_.cell_volumes[cell];
+                        }
+                        // Renormalization constant
+                        const double ren_const = (av_prev_press - av_press)/tot_vol;
+                        for (int cell = 0; cell < num_cells; ++cell) {
+                            state.pressure()[cell] += ren_const;
+                        }
+                        const int num_wells = (wells_ == NULL) ? 0 : wells_->number_of_wells;
+                        for (int well = 0; well < num_wells; ++well) {
+                            well_state.bhp()[well] += ren_const;
+                        }
+                    }
 
-                // Stop timer and report.
-                pressure_timer.stop();
-                double pt = pressure_timer.secsSinceStart();
-                *log_ << "Pressure solver took:  " << pt << " seconds." << std::endl;
-                ptime += pt;
-                sreport.pressure_time = pt;
+                    // Stop timer and report.
+                    pressure_timer.stop();
+                    double pt = pressure_timer.secsSinceStart();
+                    *log_ << "Pressure solver took:  " << pt << " seconds." << std::endl;
+                    ptime += pt;
+                    sreport.pressure_time += pt;
+
+                    // Optionally, check if well controls are satisfied.
+                    if (check_well_controls_) {
+                        Opm::computePhaseFlowRatesPerWell(*wells_,
+                                                          well_state.perfRates(),
+                                                          fractional_flows,
+                                                          well_resflows_phase);
+                        *log_ << "Checking well conditions." << std::endl;
+                        // For testing we set surface := reservoir
+                        well_control_passed = wells_manager_.conditionsMet(well_state.bhp(), well_resflows_phase, well_resflows_phase);
+                        ++well_control_iteration;
+                        if (!well_control_passed && well_control_iteration > max_well_control_iterations_) {
+                            OPM_THROW(std::runtime_error, "Could not satisfy well conditions in " << max_well_control_iterations_ << " tries.");
+                        }
+                        if (!well_control_passed) {
+                            *log_ << "Well controls not passed, solving again." << std::endl;
+                        } else {
+                            *log_ << "Well conditions met." << std::endl;
+                        }
+                    }
+                } while (!well_control_passed);
 
-                // Optionally, check if well controls are satisfied.
-                if (check_well_controls_) {
-                    Opm::computePhaseFlowRatesPerWell(*wells_,
-                                                      well_state.perfRates(),
-                                                      fractional_flows,
-                                                      well_resflows_phase);
-                    *log_ << "Checking well conditions." << std::endl;
-                    // For testing we set surface := reservoir
-                    well_control_passed = wells_manager_.conditionsMet(well_state.bhp(), well_resflows_phase, well_resflows_phase);
-                    ++well_control_iteration;
-                    if (!well_control_passed && well_control_iteration > max_well_control_iterations_) {
-                        OPM_THROW(std::runtime_error, "Could not satisfy well conditions in " << max_well_control_iterations_ << " tries.");
+                if (pt_iteration > 0) {
+                    double max_change = 0.0;
+                    for (std::size_t cell = 0; cell < last_pressure.size(); ++cell) {
+                        max_change = std::max(max_change, std::fabs(state.pressure()[cell] - last_pressure[cell]));
                     }
-                    if (!well_control_passed) {
-                        *log_ << "Well controls not passed, solving again." << std::endl;
-                    } else {
-                        *log_ << "Well conditions met." << std::endl;
+                    *log_ << "Pressure-transport iteration " << pt_iteration
+                          << ": max pressure change " << max_change << std::endl;
+                    if (max_change < nl_pressure_change_tolerance_) {
+                        break;
                     }
                 }
-            } while (!well_control_passed);
+                if (pt_iteration + 1 >= nl_pressure_transport_maxiter_) {
+                    break;
+                }
+
+                // Trial transport step, without segregation.
+                last_pressure = state.pressure();
+                Opm::computeTransportSource(grid_, src_, state.faceflux(), 1.0,
+                                            wells_, well_state.perfRates(), transport_src);
+                transport_timer.start();
+                TwophaseState trial_state(state);
+                trial_state.saturation() = step_saturation;
+                const double trial_stepsize = timer.currentStepLength() / double(num_transport_substeps_);
+                for (int tr_substep = 0; tr_substep < num_transport_substeps_; ++tr_substep) {
+                    tsolver_->solve(&porevol[0], &transport_src[0], trial_stepsize, trial_state);
+                }
+                transport_timer.stop();
+                ttime += transport_timer.secsSinceStart();
+                sreport.transport_time += transport_timer.secsSinceStart();
+                state.saturation() = trial_state.saturation();
+            }
+            state.saturation() = step_saturation;
 
             // Update pore volumes if rock is compressible.
             if (rock_comp_props_ && rock_comp_props_->isActive()) {
@@ -572,7 +621,7 @@ namespace Opm
             }
             transport_timer.stop();
             double tt = transport_timer.secsSinceStart();
-            sreport.transport_time = tt;
+            sreport.transport_time += tt;
             *log_ << "Transport solver took: " << tt << " seconds." << std::endl;
             ttime += tt;
             // Report volume balances.
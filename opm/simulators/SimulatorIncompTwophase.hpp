@@ -55,6 +55,9 @@ namespace Opm
         ///     nl_pressure_residual_tolerance (0.0) pressure solver residual tolerance (in Pascal)
         ///     nl_pressure_change_tolerance (1.0)   pressure solver change tolerance (in Pascal)
         ///     nl_pressure_maxiter (10)       max nonlinear iterations in pressure
+        ///     nl_pressure_transport_maxiter (1)  max pressure solves per step, iterating
+        ///                                    pressure and transport until the pressure
+        ///                                    changes less than nl_pressure_change_tolerance
         ///     nl_maxiter (30)                max nonlinear iterations in transport
         ///     nl_tolerance (1e-9)            transport solver absolute residual tolerance
         ///     num_transport_substeps (1)     number of transport steps per pressure step
@@ -100,6 +100,12 @@ void WellSwitchingLogger::unpackDataAndLog(std::vector<char>& recv_buffer,
 {
     for(int p=1; p < cc_.size(); ++p)
     {
+        // processes without switches may not have sent anything
+        if ( displ[p] == displ[p+1] )
+        {
+            continue;
+        }
+
         int offset = displ[p];
         int no_switches = 0;
         MPI_Unpack(recv_buffer.data(), recv_buffer.size(), &offset,
@@ -143,7 +149,89 @@ void WellSwitchingLogger::logSwitch(const char* name, std::array<char,2> fromto,
                << " on rank " << rank;
             OpmLog::info(ss.str());
 }
+
+void WellSwitchingLogger::completeFlush()
+{
+    if ( pendingRequest_ == MPI_REQUEST_NULL )
+    {
+        return;
+    }
+
+    MPI_Wait(&pendingRequest_, MPI_STATUS_IGNORE);
+    if ( cc_.rank() == 0 )
+    {
+        unpackDataAndLog(pendingRecvBuffer_, pendingDispl_);
+    }
+}
+#endif
+
+void WellSwitchingLogger::flush()
+{
+#if HAVE_MPI
+    if( cc_.size() == 1 || ! deferred_ )
+    {
+        return;
+    }
+
+    completeFlush();
+
+    // the root process logs its own switches directly
+    std::vector<int> well_name_lengths;
+    int message_size = 0;
+    if ( cc_.rank() == 0 )
+    {
+        for(const auto& entry : switchMap_)
+        {
+            logSwitch(entry.first.c_str(), entry.second,0);
+        }
+    }
+    else if ( ! switchMap_.empty() )
+    {
+        message_size = calculateMessageSize(well_name_lengths);
+    }
+
+    // all processes learn the message sizes, nothing is gathered if
+    // no well switched
+    pendingCounts_.resize(cc_.size());
+    MPI_Allgather(&message_size, 1, MPI_INT, pendingCounts_.data(),
+                  1, MPI_INT, MPI_COMM_WORLD);
+
+    pendingSendBuffer_.resize(message_size);
+    if ( message_size > 0 )
+    {
+        packData(well_name_lengths, pendingSendBuffer_);
+    }
+    switchMap_.clear();
+
+    if ( std::accumulate(pendingCounts_.begin(), pendingCounts_.end(), 0) == 0 )
+    {
+        return;
+    }
+
+    if ( cc_.rank() == 0 )
+    {
+        pendingDispl_.assign(cc_.size() + 1, 0);
+        std::partial_sum(pendingCounts_.begin(), pendingCounts_.end(),
+                         pendingDispl_.begin()+1);
+        pendingRecvBuffer_.resize(pendingDispl_[cc_.size()]);
+    }
+
+#if MPI_VERSION >= 3
+    MPI_Igatherv(pendingSendBuffer_.data(), message_size, MPI_PACKED,
+                 pendingRecvBuffer_.data(), pendingCounts_.data(),
+                 pendingDispl_.data(), MPI_PACKED, 0, MPI_COMM_WORLD,
+                 &pendingRequest_);
+#else
+    MPI_Gatherv(pendingSendBuffer_.data(), message_size, MPI_PACKED,
+                pendingRecvBuffer_.data(), pendingCounts_.data(),
+                pendingDispl_.data(), MPI_PACKED, 0, MPI_COMM_WORLD);
+    if ( cc_.rank() == 0 )
+    {
+        unpackDataAndLog(pendingRecvBuffer_, pendingDispl_);
+    }
+#endif
 #endif
+}
 
 void WellSwitchingLogger::gatherDataAndLog()
 {
@@ -199,7 +287,17 @@ void WellSwitchingLogger::gatherDataAndLog()
 
 WellSwitchingLogger::~WellSwitchingLogger()
 {
-    gatherDataAndLog();
+    if ( deferred_ )
+    {
+        flush();
+#if HAVE_MPI
+        completeFlush();
+#endif
+    }
+    else
+    {
+        gatherDataAndLog();
+    }
 }
 } // end namespace wellhelpers
 } // end namespace Opm
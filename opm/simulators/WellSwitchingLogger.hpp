@@ -40,10 +40,13 @@ namespace wellhelpers
 /// \brief Utility class to handle the log messages about well switching.
 ///
 /// In parallel all the messages will be send to a root processor
-/// and logged there.
+/// and logged there. By default this happens in the destructor, which
+/// is collective. A deferred logger instead buffers the switches until
+/// flush() is called, e.g. at the end of a report step, and gathers them
+/// without blocking while the simulation continues.
 class WellSwitchingLogger
 {
-    typedef std::map<std::string, std::array<char,2> > SwitchMap;
+    typedef std::multimap<std::string, std::array<char,2> > SwitchMap;
 
 public:
     /// \brief The type of the collective communication used.
@@ -53,11 +56,17 @@ public:
     /// \brief Constructor.
     ///
     /// \param cc The collective communication to use.
+    /// \param deferred Whether the switches are only sent to the root
+    ///                 process by flush() and the destructor.
     explicit WellSwitchingLogger(const Communication& cc =
-                                 Dune::MPIHelper::getCollectiveCommunication())
-        : cc_(cc)
+                                 Dune::MPIHelper::getCollectiveCommunication(),
+                                 const bool deferred = false)
+        : cc_(cc), deferred_(deferred)
     {}
 
+    WellSwitchingLogger(const WellSwitchingLogger&) = delete;
+    WellSwitchingLogger& operator=(const WellSwitchingLogger&) = delete;
+
     /// \brief Log that a well switched.
     /// \param name The name of the well.
     /// \param from The control of the well before the switch.
@@ -81,6 +90,12 @@ public:
         }
     }
 
+    /// \brief Send the switches buffered by a deferred logger to the root
+    /// process. Collective, but the gather is only started here and logged
+    /// by the next flush() or the destructor. If no process buffered a
+    /// switch nothing is gathered.
+    void flush();
+
     /// \brief Destructor send does the actual logging.
     ~WellSwitchingLogger();
 
@@ -98,6 +113,15 @@ private:
     void logSwitch(const char* name, std::array<char,2> fromto,
                    int rank);
 
+    /// \brief Wait for the gather started by the last flush() and log it.
+    void completeFlush();
+
+    /// \brief The gather started by the last flush().
+    MPI_Request pendingRequest_ = MPI_REQUEST_NULL;
+    std::vector<char> pendingSendBuffer_;
+    std::vector<char> pendingRecvBuffer_;
+    std::vector<int> pendingCounts_;
+    std::vector<int> pendingDispl_;
 #endif // HAVE_MPI
 
     void gatherDataAndLog();
@@ -106,6 +130,8 @@ private:
     SwitchMap switchMap_;
     /// \brief Collective communication object.
     Communication cc_;
+    /// \brief Whether the switches are only sent by flush().
+    bool deferred_;
     /// \brief The strings for printing.
     const std::string modestring[4] = { "BHP", "THP", "RESERVOIR_RATE", "SURFACE_RATE" };
 };
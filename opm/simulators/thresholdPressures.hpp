@@ -23,6 +23,12 @@
 #include <opm/core/props/BlackoilPropertiesFromDeck.hpp>
 #include <opm/core/props/BlackoilPhases.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <opm/parser/eclipse/EclipseState/SimulationConfig/SimulationConfig.hpp>
 #include <opm/parser/eclipse/EclipseState/SimulationConfig/ThresholdPressure.hpp>
@@ -30,6 +36,10 @@
 #include <opm/parser/eclipse/Deck/Deck.hpp>
 #include <opm/parser/eclipse/EclipseState/Grid/NNC.hpp>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 
 namespace Opm
 {
@@ -248,51 +258,85 @@ void computeMaxDp(std::map<std::pair<int, int>, double>& maxDp,
     }
 
     // Calculate the maximum pressure potential difference between all PVT region
-    // transitions of the initial solution.
+    // transitions of the initial solution. The faces are split among the
+    // threads, each of which collects the maxima of the region pairs it sees
+    // in its own table. The tables are merged in the order of the threads.
     const int num_faces = UgGridHelpers::numFaces(grid);
     const auto& fc = UgGridHelpers::faceCells(grid);
-    for (int face = 0; face < num_faces; ++face) {
-        const int c1 = fc(face, 0);
-        const int c2 = fc(face, 1);
-        if (c1 < 0 || c2 < 0) {
-            // Boundary face, skip this.
-            continue;
-        }
-        const int gc1 = (gc == 0) ? c1 : gc[c1];
-        const int gc2 = (gc == 0) ? c2 : gc[c2];
-        const int eq1 = eqlnumData[gc1];
-        const int eq2 = eqlnumData[gc2];
-
-        if (eq1 == eq2) {
-            // not an equilibration region boundary. skip this.
-            continue;
-        }
+    const auto& saturation = initialState.saturation();
 
-        // update the maximum pressure potential difference between the two
-        // regions
-        const auto barrierId = std::make_pair(std::min(eq1, eq2), std::max(eq1, eq2));
-        if (maxDp.count(barrierId) == 0) {
-            maxDp[barrierId] = 0.0;
-        }
+    int numThreads = 1;
+#ifdef _OPENMP
+    numThreads = omp_get_max_threads();
+#endif
+    std::vector<std::unordered_map<std::uint64_t, double> > threadMaxDp(numThreads);
+
+#pragma omp parallel
+    {
+        int thread = 0;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+#endif
+        auto& localMaxDp = threadMaxDp[thread];
+#pragma omp for schedule(static)
+        for (int face = 0; face < num_faces; ++face) {
+            const int c1 = fc(face, 0);
+            const int c2 = fc(face, 1);
+            if (c1 < 0 || c2 < 0) {
+                // Boundary face, skip this.
+                continue;
+            }
+            const int gc1 = (gc == 0) ? c1 : gc[c1];
+            const int gc2 = (gc == 0) ? c2 : gc[c2];
+            const int eq1 = eqlnumData[gc1];
+            const int eq2 = eqlnumData[gc2];
+
+            if (eq1 == eq2) {
+                // not an equilibration region boundary. skip this.
+                continue;
+            }
+
+            // update the maximum pressure potential difference between the two
+            // regions. the region pair is packed into a single key, smallest
+            // region number first.
+            const std::uint64_t barrierKey =
+                (static_cast<std::uint64_t>(static_cast<std::uint32_t>(std::min(eq1, eq2))) << 32)
+                | static_cast<std::uint32_t>(std::max(eq1, eq2));
+            double& dp = localMaxDp[barrierKey];
 
-        for (int phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
             const double z1 = UgGridHelpers::cellCenterDepth(grid, c1);
             const double z2 = UgGridHelpers::cellCenterDepth(grid, c2);
 
-            const double rhoAvg = (rho[phaseIdx][c1] + rho[phaseIdx][c2])/2;
+            for (int phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+                const double rhoAvg = (rho[phaseIdx][c1] + rho[phaseIdx][c2])/2;
+
+                const double s1 = saturation[numPhases*c1 + phaseIdx];
+                const double s2 = saturation[numPhases*c2 + phaseIdx];
 
-            const double s1 = initialState.saturation()[numPhases*c1 + phaseIdx];
-            const double s2 = initialState.saturation()[numPhases*c2 + phaseIdx];
+                const double sResid1 = minSat[numPhases*c1 + phaseIdx];
+                const double sResid2 = minSat[numPhases*c2 + phaseIdx];
 
-            const double sResid1 = minSat[numPhases*c1 + phaseIdx];
-            const double sResid2 = minSat[numPhases*c2 + phaseIdx];
+                // compute gravity corrected pressure potentials at the average depth
+                const double p1 = phasePressure[phaseIdx][c1];
+                const double p2 = phasePressure[phaseIdx][c2] + rhoAvg*gravity*(z1 - z2);
 
-            // compute gravity corrected pressure potentials at the average depth
-            const double p1 = phasePressure[phaseIdx][c1];
-            const double p2 = phasePressure[phaseIdx][c2] + rhoAvg*gravity*(z1 - z2);
+                if ((p1 > p2 && s1 > sResid1) || (p2 > p1 && s2 > sResid2))
+                    dp = std::max(dp, std::abs(p1 - p2));
+            }
+        }
+    }
 
-            if ((p1 > p2 && s1 > sResid1) || (p2 > p1 && s2 > sResid2))
-                maxDp[barrierId] = std::max(maxDp[barrierId], std::abs(p1 - p2));
+    for (const auto& localMaxDp : threadMaxDp) {
+        for (const auto& entry : localMaxDp) {
+            const auto barrierId = std::make_pair(static_cast<int>(entry.first >> 32),
+                                                  static_cast<int>(entry.first & 0xffffffffu));
+            auto it = maxDp.find(barrierId);
+            if (it == maxDp.end()) {
+                maxDp.insert(std::make_pair(barrierId, entry.second));
+            }
+            else {
+                it->second = std::max(it->second, entry.second);
+            }
         }
     }
 }
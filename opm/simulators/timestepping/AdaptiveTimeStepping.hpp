@@ -28,6 +28,7 @@
 #include <opm/common/ErrorMacros.hpp>
 #include <opm/simulators/timestepping/SimulatorTimer.hpp>
 #include <opm/simulators/timestepping/TimeStepControlInterface.hpp>
+#include <opm/simulators/MetricsExporter.hpp>
 
 namespace Opm {
 
@@ -97,6 +98,10 @@ namespace Opm {
 
         void setSuggestedNextStep(const double x) { suggested_next_timestep_ = x; }
 
+        /// Publish the metrics of every substep attempt with exporter, which
+        /// must outlive this object, nullptr for none.
+        void setMetricsExporter(MetricsExporter* exporter) { metricsExporter_ = exporter; }
+
     protected:
         template <class Solver, class State, class WellState, class Output>
         SimulatorReport stepImpl( const SimulatorTimer& timer,
@@ -122,6 +127,7 @@ namespace Opm {
         bool full_timestep_initially_;        //!< beginning with the size of the time step from data file
         const double timestep_after_event_;   //!< suggested size of timestep after an event
         bool use_newton_iteration_;           //!< use newton iteration count for adaptive time step control
+        MetricsExporter* metricsExporter_;    //!< live metrics of the substeps, may be nullptr
     };
 }
 
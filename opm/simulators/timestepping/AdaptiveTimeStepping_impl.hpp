@@ -92,6 +92,7 @@ namespace Opm {
         , full_timestep_initially_( param.getDefault("full_timestep_initially", bool(false) ) )
         , timestep_after_event_( tuning.getTMAXWC(time_step))
         , use_newton_iteration_(false)
+        , metricsExporter_(nullptr)
     {
         init(param);
 
@@ -112,6 +113,7 @@ namespace Opm {
         , full_timestep_initially_( param.getDefault("full_timestep_initially", bool(false) ) )
         , timestep_after_event_( unit::convert::from(param.getDefault("timestep.timestep_in_days_after_event", -1.0 ), unit::day))
         , use_newton_iteration_(false)
+        , metricsExporter_(nullptr)
     {
         init(param);
     }
@@ -119,7 +121,7 @@ namespace Opm {
     void AdaptiveTimeStepping::
     init(const ParameterGroup& param)
     {
-        // valid are "pid" and "pid+iteration"
+        // valid are "pid", "pid+iteration", "pid+newtoniteration", "iterationcount", "cost" and "hardcoded"
         std::string control = param.getDefault("timestep.control", std::string("pid") );
         // iterations is the accumulation of all linear iterations over all newton steops per time step
         const int defaultTargetIterations = 30;
@@ -146,6 +148,10 @@ namespace Opm {
             const double decayrate  = param.getDefault("timestep.control.decayrate",  double(0.75) );
             const double growthrate = param.getDefault("timestep.control.growthrate", double(1.25) );
             timeStepControl_ = TimeStepControlType( new SimpleIterationCountTimeStepControl( iterations, decayrate, growthrate ) );
+        }
+        else if ( control == "cost" )
+        {
+            timeStepControl_ = TimeStepControlType( new CostModelTimeStepControl( restart_factor_, max_growth_ ) );
         } else if ( control == "hardcoded") {
             const std::string filename    = param.getDefault("timestep.control.filename", std::string("timesteps"));
             timeStepControl_ = TimeStepControlType( new HardcodedTimeStepControl( filename ) );
@@ -208,7 +214,7 @@ namespace Opm {
         // create adaptive step timer with previously used sub step size
         AdaptiveSimulatorTimer substepTimer( simulatorTimer, suggested_next_timestep_, max_time_step_ );
 
-        // copy states in case solver has to be restarted (to be revised)
+        // copy states in case solver has to be restarted
         State  last_state( state );
         WState last_well_state( well_state );
 
@@ -233,117 +239,16 @@ namespace Opm {
 
             SimulatorReport substepReport;
             std::string cause_of_failure = "";
+            Opm::time::StopWatch attemptTimer;
+            attemptTimer.start();
             try {
-                State initial_reservoir_state = state;
-
                 substepReport = solver.step( substepTimer, state, well_state);
                 report += substepReport;
 
-                // Store the final states.
-                State final_reservoir_state = state;
-                WState final_well_state = well_state;
-
-                // -----------------------------------------------------------------------------------------------
-                // -----------------------------------------------------------------------------------------------
-                // --------------------------- Numerical jacobian w.r.t. the initial state -----------------------
-                // ---------------------------------------- DOES NOT WORK ----------------------------------------
-                // -----------------------------------------------------------------------------------------------
-
-                // We only need to create the 'A' matrix.
-                //  1. Perturb the initial solution by dx/2.
-                //  2. Run one linearization.
-                //  3. Store residuals.
-/*
-
-
-                // Initialization of all the matrices.
-                typedef double Scalar;
-                typedef Dune::FieldVector<Scalar, 3>            VectorBlockType;
-                typedef Dune::BlockVector<VectorBlockType>      BVector;
-
-                typedef Dune::FieldMatrix<Scalar,2,2> dimBlockA0;
-                Dune::BCRSMatrix<dimBlockA0> A0(9,9, Dune::BCRSMatrix<dimBlockA0>::random);
-                Dune::BCRSMatrix<dimBlockA0> numA0(9,9, Dune::BCRSMatrix<dimBlockA0>::random);
-                Dune::BCRSMatrix<dimBlockA0> diffA0(9,9, Dune::BCRSMatrix<dimBlockA0>::random);
-                solver.model().denseInitializationOfBCRSMatrix(A0);
-                solver.model().denseInitializationOfBCRSMatrix(numA0);
-                solver.model().denseInitializationOfBCRSMatrix(diffA0);
-
-
-                // Get a reference to the ebos simulator for convenience. The '2' is just because I made a public wrapper function.
-                auto& ebosSimulator = solver.model().ebosSimulator2();
-
-
-                std::vector<std::vector<Dune::FieldVector<Scalar, 3>>> residualsMB;
-                // Initialization of residualsMB:
-                for (std::size_t i=0; i < 2; ++i){
-                    std::vector<Dune::FieldVector<Scalar, 3>> tmp1;
-                    for (std::size_t j=0; j < 9; ++j){
-                        Dune::FieldVector<Scalar, 3> tmp2;
-                        tmp1.push_back(tmp2);
-                    }
-                    residualsMB.push_back(tmp1);
-                }
-
-
-                BVector dx0(9);
-                dx0 = 0;
-                std::vector<Scalar> pert_sizes0 = {-0.000001, -10}; // Using a negative value is the same as applying a positive perturbation.
-
-                for(std::size_t cell_block=0; cell_block<9; ++cell_block){      // For each grid/cell block.
-                    for(int state_type = 1; state_type<2; ++state_type){           // For each phase/state_variable in that grid block
-
-                        // Resetting the residual container.
-                        for (std::size_t i=0; i < residualsMB.size(); ++i){
-                            for (std::size_t j=0; j < residualsMB[i].size(); ++j){
-                                for (std::size_t k=0; k < residualsMB[i][j].size(); ++k){
-                                    residualsMB[i][j][k] = 0;
-                                }
-                            }
-                        }
-
-                        for (int i = 0; i < 2; ++i){                        // We are doing central difference
-                            State tmp_initial_reservoir_state = initial_reservoir_state;    // Copy
-                            State tmp_final_reservoir_state = final_reservoir_state;
-                            WState tmp_final_well_state = final_well_state;       // Copy
-
-                            dx0 = 0; // Reset the perturbation vector
-                            dx0[cell_block][stateType] = (i==0) ? -pert_sizes0[stateType]/2 : pert_sizes0[stateType]/2; // The first iteration calculates the f(x - dx/2)
-
-                            // Apply the perturbation to the initial reservoir state
-                            solver.model().updateState(dx0,tmp_initial_reservoir_state);
-
-                            // Perform one linearization (Does not perform an update). DOES NOT WORK.
-                            solver.runOneLinearization( substepTimer, tmp_initial_reservoir_state, tmp_final_reservoir_state, tmp_final_well_state);
-
-                            // Get a deep copy of the residuals
-                            const auto resMB_perturbed = ebosSimulator.model().linearizer().residual();
-
-                            for (int grid_block = 0; grid_block < 9; ++grid_block){
-                                for(int res_nr = 0; res_nr < 3; ++res_nr){
-                                    residualsMB[i][grid_block][res_nr] = resMB_perturbed[grid_block][res_nr];
-                                }
-                            }
-                        }
-
-                        // Calculate the numerical difference
-                        for (std::size_t cell_block_res=0; cell_block_res < 9; ++cell_block_res){
-                            for (std::size_t res_nr=0; res_nr < 2; ++res_nr){
-                                // (f(x+dx/2) - f(x-dx/2)) / (dx)
-                                numA0[cell_block_res][cell_block][res_nr][state_type] = (residualsMB[1][cell_block_res][res_nr] - residualsMB[0][cell_block_res][res_nr])/((-pert_sizes0[state_type]));
-                            }
-                        }
-                    }
-                }
+                // The Jacobian is compared with finite differences by the
+                // model after the Newton iterations, see verify_jacobian.
 
 
-                //Dune::printmatrix(std::cout, A0, "AD A0", "row");
-                Dune::printmatrix(std::cout, numA0, "numerical A0", "row");
-                //solver.model().calculateDifference(A0, numA0, &diffA0);
-                //Dune::printmatrix(std::cout, diffA0, "A0  difference", "row");
-
-*/
-
 
                 if( solver_verbose_ ) {
                     // report number of linear iterations
@@ -390,6 +295,22 @@ namespace Opm {
                 // this can be thrown by ISTL's ILU0 in block mode, yet is not an ISTLError
             }
 
+            // let the time step control learn the cost of converged and failed attempts
+            timeStepControl_->recordStep( dt, substepReport.converged,
+                                          substepReport.total_newton_iterations,
+                                          substepReport.total_linear_iterations,
+                                          attemptTimer.secsSinceStart() );
+
+            if( metricsExporter_ ) {
+                const double elapsed = substepTimer.simulationTimeElapsed()
+                    + (substepReport.converged ? dt : 0.0);
+                metricsExporter_->recordStep( elapsed, simulatorTimer.totalTime(), dt,
+                                              simulatorTimer.reportStepNum(),
+                                              substepReport.converged,
+                                              substepReport.total_newton_iterations,
+                                              substepReport.total_linear_iterations );
+            }
+
             if( substepReport.converged )
             {
                 // advance by current dt
@@ -449,9 +370,12 @@ namespace Opm {
                 // set new time step length
                 substepTimer.provideTimeStepEstimate( dtEstimate );
 
-                // update states
-                last_state      = state ;
-                last_well_state = well_state;
+                // update states, the states after the last substep are
+                // never restored
+                if( ! substepTimer.done() ) {
+                    last_state      = state ;
+                    last_well_state = well_state;
+                }
 
                 report.converged = substepTimer.done();
                 substepTimer.setLastStepFailed(false);
@@ -0,0 +1,195 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_PARAREALITERATION_HEADER_INCLUDED
+#define OPM_PARAREALITERATION_HEADER_INCLUDED
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace Opm
+{
+
+    /// The parallel-in-time iteration of Parareal over the time slabs of a
+    /// schedule.
+    ///
+    /// A cheap coarse propagator G gives the initial states of all slabs,
+    /// then each iteration k advances the states U_n of the slabs with the
+    /// accurate fine propagator F and corrects them sequentially with
+    ///
+    ///     U_{n+1} = G(U_n new) + F(U_n old) - G(U_n old).
+    ///
+    /// The fine solves of one iteration are independent of each other, which
+    /// is where the parallelism in time comes from: with one group of
+    /// processes per slab their wall time is that of the slowest slab. After
+    /// iteration k the first k+1 slabs equal the sequential fine solution,
+    /// such that their fine solves are skipped from then on.
+    ///
+    /// The propagators are given by an object with the members
+    ///
+    ///     void coarse(int slab, State& state);   // advance state over the slab with G
+    ///     void fine(int slab, State& state);     // advance state over the slab with F
+    ///     void correct(State& coarseNew, const State& fineOld, const State& coarseOld);
+    ///                                            // coarseNew += fineOld - coarseOld
+    ///     double difference(const State& a, const State& b);
+    ///                                            // the change between two iterates
+    class PararealIteration
+    {
+    public:
+        /// \param[in] numSlabs       the number of time slabs
+        /// \param[in] tolerance      the largest difference between the end
+        ///                           states of two iterations for convergence
+        /// \param[in] maxIterations  the maximal number of iterations, at most
+        ///                           numSlabs of them are ever needed
+        PararealIteration(const int numSlabs, const double tolerance, const int maxIterations)
+            : numSlabs_(numSlabs)
+            , tolerance_(tolerance)
+            , maxIterations_(std::min(maxIterations, numSlabs))
+            , iterations_(0)
+            , converged_(false)
+            , coarseTime_(0.0)
+            , fineTime_(0.0)
+            , fineCriticalPath_(0.0)
+        {
+        }
+
+        /// Split the report steps [first, lengths.size()) into numSlabs
+        /// slabs of about the same length in time.
+        /// \return the first report step of each slab, followed by the end
+        static std::vector<int> slabBoundaries(const std::vector<double>& lengths,
+                                               const int first, const int numSlabs)
+        {
+            const int end = lengths.size();
+            double total = 0.0;
+            for (int step = first; step < end; ++step) {
+                total += lengths[step];
+            }
+            std::vector<int> boundaries(1, first);
+            double elapsed = 0.0;
+            int step = first;
+            for (int slab = 1; slab < numSlabs && step < end; ++slab) {
+                const double target = total * slab / numSlabs;
+                // at least one report step per slab while there are any left
+                do {
+                    elapsed += lengths[step];
+                    ++step;
+                } while (step < end && elapsed + 0.5 * lengths[step] < target);
+                if (step < end) {
+                    boundaries.push_back(step);
+                }
+            }
+            if (boundaries.back() < end) {
+                boundaries.push_back(end);
+            }
+            return boundaries;
+        }
+
+        /// Run the iteration from the initial state.
+        /// \return the state at the end of each slab
+        template <class State, class Propagators>
+        std::vector<State> run(const State& initial, Propagators& propagators)
+        {
+            iterations_ = 0;
+            converged_ = false;
+            coarseTime_ = 0.0;
+            fineTime_ = 0.0;
+            fineCriticalPath_ = 0.0;
+
+            // the start states of the slabs and the coarse end states from them
+            std::vector<State> start(numSlabs_ + 1, initial);
+            std::vector<State> coarseEnd(numSlabs_, initial);
+            for (int n = 0; n < numSlabs_; ++n) {
+                coarseEnd[n] = start[n];
+                coarseTime_ += timed([&]() { propagators.coarse(n, coarseEnd[n]); });
+                start[n + 1] = coarseEnd[n];
+            }
+
+            std::vector<State> fineEnd(numSlabs_, initial);
+            for (int k = 0; k < maxIterations_ && !converged_; ++k) {
+                // independent of each other, one group of processes each
+                double slowest = 0.0;
+                for (int n = k; n < numSlabs_; ++n) {
+                    fineEnd[n] = start[n];
+                    const double time = timed([&]() { propagators.fine(n, fineEnd[n]); });
+                    fineTime_ += time;
+                    slowest = std::max(slowest, time);
+                }
+                fineCriticalPath_ += slowest;
+
+                // the start of slab k is exact, so is its fine end state
+                double change = propagators.difference(fineEnd[k], start[k + 1]);
+                start[k + 1] = fineEnd[k];
+                for (int n = k + 1; n < numSlabs_; ++n) {
+                    State coarseNew = start[n];
+                    coarseTime_ += timed([&]() { propagators.coarse(n, coarseNew); });
+                    State corrected = coarseNew;
+                    propagators.correct(corrected, fineEnd[n], coarseEnd[n]);
+                    change = std::max(change, propagators.difference(corrected, start[n + 1]));
+                    coarseEnd[n] = std::move(coarseNew);
+                    start[n + 1] = std::move(corrected);
+                }
+
+                ++iterations_;
+                converged_ = change <= tolerance_ || k + 1 == numSlabs_;
+            }
+
+            start.erase(start.begin());
+            return start;
+        }
+
+        /// The number of iterations of the last run.
+        int iterations() const { return iterations_; }
+
+        /// Whether the last run converged.
+        bool converged() const { return converged_; }
+
+        /// The time of all coarse solves in seconds, which are sequential.
+        double coarseTime() const { return coarseTime_; }
+
+        /// The time of all fine solves in seconds.
+        double fineTime() const { return fineTime_; }
+
+        /// The time of the fine solves in seconds if the slabs of each
+        /// iteration were solved concurrently.
+        double fineCriticalPath() const { return fineCriticalPath_; }
+
+    private:
+        template <class Function>
+        static double timed(Function function)
+        {
+            const auto begin = std::chrono::steady_clock::now();
+            function();
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        }
+
+        int numSlabs_;
+        double tolerance_;
+        int maxIterations_;
+        int iterations_;
+        bool converged_;
+        double coarseTime_;
+        double fineTime_;
+        double fineCriticalPath_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_PARAREALITERATION_HEADER_INCLUDED
@@ -19,6 +19,7 @@
   along with OPM.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <config.h>
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <iostream>
@@ -193,4 +194,167 @@ namespace Opm
         return std::min(dtEstimatePID, dtEstimateIter);
     }
 
+
+
+
+    ////////////////////////////////////////////////////////////
+    //
+    //  CostModelTimeStepControl  Implementation
+    //
+    ////////////////////////////////////////////////////////////
+
+    namespace
+    {
+        // weight of the history in the exponentially weighted estimates
+        const double costModelDecay = 0.7;
+        // width of the logistic failure probability in log(dt)
+        const double failureWidth = 0.5;
+        // number of candidate step sizes between the restart factor and the maximum growth
+        const int numCandidates = 32;
+    }
+
+    CostModelTimeStepControl::
+    CostModelTimeStepControl( const double restart_factor,
+                              const double max_growth,
+                              const bool verbose )
+        : restart_factor_( restart_factor )
+        , max_growth_( max_growth )
+        , verbose_( verbose )
+        , sumNN_( 0.0 ), sumNL_( 0.0 ), sumLL_( 0.0 ), sumNT_( 0.0 ), sumLT_( 0.0 )
+        , timePerNewton_( 0.0 )
+        , timePerLinear_( 0.0 )
+        , lastDt_( 0.0 )
+        , lastNewton_( 0.0 )
+        , lastLinear_( 0.0 )
+        , newtonExponent_( 0.5 )
+        , linearExponent_( 0.75 )
+        , logFailureDt_( 0.0 )
+        , hasFailed_( false )
+        , failedCost_( 0.0 )
+    {
+        if( restart_factor_ <= 0.0 || restart_factor_ >= 1.0 ) {
+            OPM_THROW(std::runtime_error,"CostModelTimeStepControl: restart factor should be in (0,1) " << restart_factor_ );
+        }
+        if( max_growth_ < 1.0 ) {
+            OPM_THROW(std::runtime_error,"CostModelTimeStepControl: growth should be >= 1 " << max_growth_ );
+        }
+    }
+
+    void CostModelTimeStepControl::
+    recordStep( const double dt, const bool converged,
+                const int newtonIterations, const int linearIterations,
+                const double wallTime )
+    {
+        const double lambda = costModelDecay;
+        const double n = std::max( newtonIterations, 1 );
+        const double l = std::max( linearIterations, 0 );
+
+        // least squares fit of the cost, failed attempts included
+        sumNN_ = lambda * sumNN_ + n * n;
+        sumNL_ = lambda * sumNL_ + n * l;
+        sumLL_ = lambda * sumLL_ + l * l;
+        sumNT_ = lambda * sumNT_ + n * wallTime;
+        sumLT_ = lambda * sumLT_ + l * wallTime;
+        const double det = sumNN_ * sumLL_ - sumNL_ * sumNL_;
+        timePerNewton_ = -1.0;
+        if( det > 1e-8 * sumNN_ * sumLL_ ) {
+            timePerNewton_ = ( sumLL_ * sumNT_ - sumNL_ * sumLT_ ) / det;
+            timePerLinear_ = ( sumNN_ * sumLT_ - sumNL_ * sumNT_ ) / det;
+        }
+        if( timePerNewton_ < 0.0 || timePerLinear_ < 0.0 ) {
+            // no reliable split, charge everything to the Newton iterations
+            timePerNewton_ = sumNT_ / sumNN_;
+            timePerLinear_ = 0.0;
+        }
+
+        const double logDt = std::log( dt );
+        if( converged ) {
+            if( lastDt_ > 0.0 ) {
+                const double logRatio = logDt - std::log( lastDt_ );
+                if( std::abs( logRatio ) > 0.05 ) {
+                    const double newtonExponent = std::log( n / lastNewton_ ) / logRatio;
+                    newtonExponent_ = lambda * newtonExponent_
+                        + ( 1.0 - lambda ) * std::min( std::max( newtonExponent, 0.0 ), 1.0 );
+                    if( l > 0.0 && lastLinear_ > 0.0 ) {
+                        const double linearExponent = std::log( l / lastLinear_ ) / logRatio;
+                        linearExponent_ = lambda * linearExponent_
+                            + ( 1.0 - lambda ) * std::min( std::max( linearExponent, 0.0 ), 1.5 );
+                    }
+                }
+            }
+            lastDt_ = dt;
+            lastNewton_ = n;
+            lastLinear_ = std::max( l, 1.0 );
+
+            // accepted steps close to the failure centre move it upwards
+            if( hasFailed_ && logDt + failureWidth > logFailureDt_ ) {
+                logFailureDt_ += ( 1.0 - lambda ) * ( logDt + failureWidth - logFailureDt_ );
+            }
+        }
+        else {
+            // a failure at dt puts the centre at dt or below
+            logFailureDt_ = hasFailed_ ? std::min( lambda * logFailureDt_ + ( 1.0 - lambda ) * logDt, logDt )
+                                       : logDt;
+            failedCost_ = hasFailed_ ? lambda * failedCost_ + ( 1.0 - lambda ) * wallTime
+                                     : wallTime;
+            hasFailed_ = true;
+        }
+    }
+
+    double CostModelTimeStepControl::
+    predictedCost( const double dt ) const
+    {
+        const double ratio = dt / lastDt_;
+        const double newton = std::max( lastNewton_ * std::pow( ratio, newtonExponent_ ), 1.0 );
+        const double linear = lastLinear_ * std::pow( ratio, linearExponent_ );
+        return std::max( timePerNewton_ * newton + timePerLinear_ * linear, 1e-12 );
+    }
+
+    double CostModelTimeStepControl::
+    failureProbability( const double dt ) const
+    {
+        if( !hasFailed_ ) {
+            return 0.0;
+        }
+        return 1.0 / ( 1.0 + std::exp( -( std::log( dt ) - logFailureDt_ ) / failureWidth ) );
+    }
+
+    double CostModelTimeStepControl::
+    expectedRate( const double dt ) const
+    {
+        const double p = failureProbability( dt );
+        const double retry = restart_factor_ * dt;
+        const double simulated = ( 1.0 - p ) * dt + p * retry;
+        const double cost = ( 1.0 - p ) * predictedCost( dt ) + p * ( failedCost_ + predictedCost( retry ) );
+        return simulated / cost;
+    }
+
+    double CostModelTimeStepControl::
+    computeTimeStepSize( const double dt, const int /* iterations */, const RelativeChangeInterface& /* relativeChange */, const double /*simulationTimeElapsed */) const
+    {
+        if( lastDt_ <= 0.0 || sumNN_ <= 0.0 ) {
+            return dt;
+        }
+
+        // the candidate with the largest expected rate, on a geometric grid
+        double bestDt = dt;
+        double bestRate = expectedRate( dt );
+        const double logMin = std::log( restart_factor_ );
+        const double logMax = std::log( max_growth_ );
+        for( int i = 0; i < numCandidates; ++i ) {
+            const double candidate = dt * std::exp( logMin + ( logMax - logMin ) * i / ( numCandidates - 1 ) );
+            const double rate = expectedRate( candidate );
+            if( rate > bestRate ) {
+                bestRate = rate;
+                bestDt = candidate;
+            }
+        }
+
+        if( verbose_ ) {
+            std::cout << "Computed step size (cost): " << unit::convert::to( bestDt, unit::day )
+                      << " (days), failure probability " << failureProbability( bestDt ) << std::endl;
+        }
+        return bestDt;
+    }
+
 } // end namespace Opm
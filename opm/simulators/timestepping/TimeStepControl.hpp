@@ -117,6 +117,73 @@ namespace Opm
         const int     target_iterations_;
     };
 
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ///
+    ///  Time step control that predicts the wall clock cost of a time step
+    ///  and chooses the step size with the most simulated time per second.
+    ///
+    ///  The wall time of an attempt is fitted as a linear function of its
+    ///  Newton and linear iterations. The iterations of a step of size dt are
+    ///  extrapolated from the last accepted step by power laws in dt whose
+    ///  exponents are fitted to consecutive steps. The probability that a
+    ///  step fails is a logistic function of log(dt) centred at the sizes of
+    ///  the failed steps, which accepted steps move upwards again. A failure
+    ///  costs the failed attempt plus a step chopped by the restart factor.
+    //
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    class CostModelTimeStepControl : public TimeStepControlInterface
+    {
+    public:
+        /// \brief constructor
+        /// \param restart_factor  factor by which the step size of a failed attempt is chopped
+        /// \param max_growth      largest factor by which the step size may grow
+        /// \param verbose         if true get some output (default = false)
+        CostModelTimeStepControl( const double restart_factor,
+                                  const double max_growth,
+                                  const bool verbose = false );
+
+        /// \brief \copydoc TimeStepControlInterface::computeTimeStepSize
+        double computeTimeStepSize( const double dt, const int /* iterations */, const RelativeChangeInterface& /* relativeChange */, const double /*simulationTimeElapsed */ ) const;
+
+        /// \brief \copydoc TimeStepControlInterface::recordStep
+        void recordStep( const double dt, const bool converged,
+                         const int newtonIterations, const int linearIterations,
+                         const double wallTime );
+
+        /// predicted wall time of a converging step of size dt
+        double predictedCost( const double dt ) const;
+
+        /// predicted probability that a step of size dt fails
+        double failureProbability( const double dt ) const;
+
+        /// expected simulated time per second of wall clock time for steps of size dt
+        double expectedRate( const double dt ) const;
+
+    protected:
+        const double restart_factor_;
+        const double max_growth_;
+        const bool   verbose_;
+
+        // exponentially weighted sums of the fit wallTime = a * newton + b * linear
+        double sumNN_, sumNL_, sumLL_, sumNT_, sumLT_;
+        double timePerNewton_;
+        double timePerLinear_;
+
+        // the last accepted step
+        double lastDt_;
+        double lastNewton_;
+        double lastLinear_;
+        // exponents of the iterations as power laws of dt
+        double newtonExponent_;
+        double linearExponent_;
+
+        // centre of the failure probability in log(dt)
+        double logFailureDt_;
+        bool   hasFailed_;
+        // mean wall time of a failed attempt
+        double failedCost_;
+    };
+
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
     ///
     ///  HardcodedTimeStepControl
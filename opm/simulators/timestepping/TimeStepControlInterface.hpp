@@ -58,6 +58,17 @@ namespace Opm
         /// \return suggested time step size for the next step
         virtual double computeTimeStepSize( const double dt, const int iterations, const RelativeChangeInterface& relativeChange , const double simulationTimeElapsed) const = 0;
 
+        /// record the outcome of an attempted time step, called before
+        /// computeTimeStepSize for converged steps (default: ignored)
+        /// \param dt                time step size of the attempt
+        /// \param converged         whether the attempt converged
+        /// \param newtonIterations  number of Newton iterations used
+        /// \param linearIterations  number of linear iterations used
+        /// \param wallTime          wall clock time of the attempt in seconds
+        virtual void recordStep( const double /* dt */, const bool /* converged */,
+                                 const int /* newtonIterations */, const int /* linearIterations */,
+                                 const double /* wallTime */ ) {}
+
         /// virtual destructor (empty)
         virtual ~TimeStepControlInterface () {}
     };
@@ -24,11 +24,17 @@
 #include <opm/core/grid.h>
 #include <set>
 #include <cmath>
+#include <cstdint>
 #include <algorithm>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <vector>
 
+#if HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 
 
 namespace Opm
@@ -314,5 +320,232 @@ namespace Opm
        }
     }
 
-} // namespace Opm
 
+
+
+    namespace
+    {
+        // The appended arrays are split into blocks of this size when
+        // compressed, as vtkZLibDataCompressor does.
+        const std::size_t zlibBlockSize = 1 << 15;
+
+        // A data array of a vtu file, encoded for the appended section.
+        struct AppendedArray
+        {
+            PMap attributes;
+            std::vector<char> encoded;
+        };
+
+        void appendWord(std::vector<char>& out, const std::uint64_t value)
+        {
+            const char* bytes = reinterpret_cast<const char*>(&value);
+            out.insert(out.end(), bytes, bytes + sizeof(value));
+        }
+
+        // Encode raw bytes for the appended section: the number of bytes
+        // followed by the bytes, or the header of the compressed blocks
+        // followed by the blocks.
+        std::vector<char> encodeAppended(const char* data, const std::size_t size,
+                                         const VtkEncoding encoding)
+        {
+            std::vector<char> out;
+            if (encoding != VtkEncoding::BinaryZlib) {
+                out.reserve(sizeof(std::uint64_t) + size);
+                appendWord(out, size);
+                out.insert(out.end(), data, data + size);
+                return out;
+            }
+#if HAVE_ZLIB
+            const std::size_t numBlocks = (size + zlibBlockSize - 1) / zlibBlockSize;
+            std::vector<std::vector<char> > blocks(numBlocks);
+            for (std::size_t b = 0; b < numBlocks; ++b) {
+                const std::size_t raw = std::min(zlibBlockSize, size - b*zlibBlockSize);
+                uLongf length = compressBound(raw);
+                blocks[b].resize(length);
+                const int status = compress2(reinterpret_cast<Bytef*>(blocks[b].data()), &length,
+                                             reinterpret_cast<const Bytef*>(data + b*zlibBlockSize),
+                                             raw, Z_BEST_SPEED);
+                if (status != Z_OK) {
+                    OPM_THROW(std::runtime_error, "zlib compression of vtu data failed");
+                }
+                blocks[b].resize(length);
+            }
+            appendWord(out, numBlocks);
+            appendWord(out, zlibBlockSize);
+            appendWord(out, size % zlibBlockSize);
+            for (const auto& block : blocks) {
+                appendWord(out, block.size());
+            }
+            for (const auto& block : blocks) {
+                out.insert(out.end(), block.begin(), block.end());
+            }
+#endif
+            return out;
+        }
+
+        template <class T>
+        AppendedArray appendedArray(const std::string& name, const std::string& type,
+                                    const int numComponents, const std::vector<T>& values,
+                                    const VtkEncoding encoding)
+        {
+            AppendedArray array;
+            array.attributes["Name"] = name;
+            array.attributes["type"] = type;
+            array.attributes["NumberOfComponents"] = std::to_string(numComponents);
+            array.attributes["format"] = "appended";
+            array.encoded = encodeAppended(reinterpret_cast<const char*>(values.data()),
+                                           values.size()*sizeof(T), encoding);
+            return array;
+        }
+
+        void writeDataArrays(std::vector<AppendedArray>& arrays, std::uint64_t& offset,
+                             std::ostream& os)
+        {
+            for (auto& array : arrays) {
+                array.attributes["offset"] = std::to_string(offset);
+                offset += array.encoded.size();
+                Tag t("DataArray", array.attributes, os);
+            }
+        }
+
+        bool littleEndian()
+        {
+            const std::uint16_t one = 1;
+            return *reinterpret_cast<const char*>(&one) == 1;
+        }
+    } // anonymous namespace
+
+
+    bool vtkEncodingAvailable(const VtkEncoding encoding)
+    {
+#if HAVE_ZLIB
+        return true;
+#else
+        return encoding != VtkEncoding::BinaryZlib;
+#endif
+    }
+
+
+    void writeVtuData(const UnstructuredGrid& grid,
+                      const std::map< std::string, const std::vector< double >* >& data,
+                      const VtkEncoding encoding,
+                      std::ostream& os)
+    {
+        if (grid.dimensions != 3) {
+            OPM_THROW(std::runtime_error, "Vtk output for 3d grids only");
+        }
+        if (!vtkEncodingAvailable(encoding)) {
+            OPM_THROW(std::runtime_error, "zlib compressed vtu output is not available in this build");
+        }
+        if (encoding == VtkEncoding::Ascii) {
+            writeVtkData(grid, data, os);
+            return;
+        }
+
+        const int num_pts = grid.number_of_nodes;
+        const int num_cells = grid.number_of_cells;
+
+        // The cells are written as polyhedra, see writeVtkData() for the
+        // layout of the arrays.
+        std::vector<int> connectivity;
+        std::vector<int> offsets;
+        std::vector<int> faces;
+        std::vector<int> faceoffsets;
+        offsets.reserve(num_cells);
+        faceoffsets.reserve(num_cells);
+        for (int c = 0; c < num_cells; ++c) {
+            std::set<int> cell_pts;
+            faces.push_back(grid.cell_facepos[c+1] - grid.cell_facepos[c]);
+            for (int hf = grid.cell_facepos[c]; hf < grid.cell_facepos[c+1]; ++hf) {
+                const int f = grid.cell_faces[hf];
+                const int* fnbeg = grid.face_nodes + grid.face_nodepos[f];
+                const int* fnend = grid.face_nodes + grid.face_nodepos[f+1];
+                cell_pts.insert(fnbeg, fnend);
+                faces.push_back(fnend - fnbeg);
+                faces.insert(faces.end(), fnbeg, fnend);
+            }
+            connectivity.insert(connectivity.end(), cell_pts.begin(), cell_pts.end());
+            offsets.push_back(connectivity.size());
+            faceoffsets.push_back(faces.size());
+        }
+        const std::vector<unsigned char> types(num_cells, 42);
+        const std::vector<double> coordinates(grid.node_coordinates,
+                                              grid.node_coordinates + 3*num_pts);
+
+        std::vector<AppendedArray> points;
+        points.push_back(appendedArray("Coordinates", "Float64", 3, coordinates, encoding));
+
+        std::vector<AppendedArray> cells;
+        cells.push_back(appendedArray("connectivity", "Int32", 1, connectivity, encoding));
+        cells.push_back(appendedArray("offsets", "Int32", 1, offsets, encoding));
+        cells.push_back(appendedArray("faces", "Int32", 1, faces, encoding));
+        cells.push_back(appendedArray("faceoffsets", "Int32", 1, faceoffsets, encoding));
+        cells.push_back(appendedArray("types", "UInt8", 1, types, encoding));
+
+        std::vector<AppendedArray> cellData;
+        for (auto dit = data.begin(); dit != data.end(); ++dit) {
+            std::vector<double> field = *(dit->second);
+            for (double& value : field) {
+                if (std::fabs(value) < std::numeric_limits<double>::min()) {
+                    // Avoiding denormal numbers to work around
+                    // bug in Paraview.
+                    value = 0.0;
+                }
+            }
+            const int num_comps = num_cells > 0 ? field.size()/num_cells : 1;
+            cellData.push_back(appendedArray(dit->first, "Float64", num_comps, field, encoding));
+        }
+
+        os << "<?xml version=\"1.0\"?>\n";
+        PMap pm;
+        pm["type"] = "UnstructuredGrid";
+        pm["version"] = "1.0";
+        pm["byte_order"] = littleEndian() ? "LittleEndian" : "BigEndian";
+        pm["header_type"] = "UInt64";
+        if (encoding == VtkEncoding::BinaryZlib) {
+            pm["compressor"] = "vtkZLibDataCompressor";
+        }
+        std::uint64_t offset = 0;
+        {
+            Tag vtkfiletag("VTKFile", pm, os);
+            {
+                Tag ugtag("UnstructuredGrid", os);
+                pm.clear();
+                pm["NumberOfPoints"] = std::to_string(num_pts);
+                pm["NumberOfCells"] = std::to_string(num_cells);
+                Tag piecetag("Piece", pm, os);
+                {
+                    Tag pointstag("Points", os);
+                    writeDataArrays(points, offset, os);
+                }
+                {
+                    Tag cellstag("Cells", os);
+                    writeDataArrays(cells, offset, os);
+                }
+                {
+                    pm.clear();
+                    if (data.find("saturation") != data.end()) {
+                        pm["Scalars"] = "saturation";
+                    } else if (data.find("pressure") != data.end()) {
+                        pm["Scalars"] = "pressure";
+                    }
+                    Tag celldatatag("CellData", pm, os);
+                    writeDataArrays(cellData, offset, os);
+                }
+            }
+            Tag::indent(os);
+            os << "<AppendedData encoding=\"raw\">\n";
+            Tag::indent(os);
+            os << "_";
+            for (const auto* arrays : { &points, &cells, &cellData }) {
+                for (const auto& array : *arrays) {
+                    os.write(array.encoded.data(), array.encoded.size());
+                }
+            }
+            os << "\n";
+            Tag::indent(os);
+            os << "</AppendedData>\n";
+        }
+    }
+
+} // namespace Opm
@@ -42,6 +42,30 @@ namespace Opm
     void writeVtkData(const UnstructuredGrid& ,
                       const std::map< std::string, const std::vector< double >* >& data,
                       std::ostream& os);
+
+    /// Encoding of the data arrays of vtu files.
+    enum class VtkEncoding {
+        //! \brief Inline ASCII, as written by writeVtkData().
+        Ascii,
+        //! \brief Raw binary data appended to the end of the file.
+        Binary,
+        //! \brief Appended binary data, compressed with zlib.
+        BinaryZlib
+    };
+
+    /// True if vtu files can be written with the given encoding, zlib
+    /// compression needs a build with zlib.
+    bool vtkEncodingAvailable(const VtkEncoding encoding);
+
+    /// Vtu output for general grids, with the data arrays appended in
+    /// binary to the end of the file and optionally zlib compressed.
+    /// The stream must be opened in binary mode. Throws
+    /// std::runtime_error if the encoding is not available.
+    void writeVtuData(const UnstructuredGrid& grid,
+                      const std::map< std::string, const std::vector< double >* >& data,
+                      const VtkEncoding encoding,
+                      std::ostream& os);
+
 } // namespace Opm
 
 #endif // OPM_WRITEVTKDATA_HEADER_INCLUDED
@@ -0,0 +1,74 @@
+#!/bin/bash
+
+# This runs a simulator with a performance summary, then compares the
+# summary against a baseline recorded earlier on the same machine.
+# The test fails if a time, an iteration count or the peak memory use
+# grows by more than the given relative threshold. If there is no
+# baseline the summary of this run is stored as the baseline, remove
+# it to record a new one.
+
+INPUT_DATA_PATH="$1"
+RESULT_PATH="$2"
+BINPATH="$3"
+FILENAME="$4"
+THRESHOLD="$5"
+BASELINE_PATH="$6"
+EXE_NAME="${7}"
+shift 7
+TEST_ARGS="$@"
+
+SUMMARY=${RESULT_PATH}/${FILENAME}.perf.json
+BASELINE=${BASELINE_PATH}/${EXE_NAME}+${FILENAME}.perf.json
+
+rm -Rf  ${RESULT_PATH}
+mkdir -p ${RESULT_PATH}
+cd ${RESULT_PATH}
+${BINPATH}/${EXE_NAME} ${TEST_ARGS} output_dir=${RESULT_PATH} performance_summary_file=${SUMMARY}
+if [ $? -ne 0 ]
+then
+  echo "${EXE_NAME} failed"
+  exit 1
+fi
+cd ..
+
+cat ${SUMMARY}
+
+if [ ! -f ${BASELINE} ]
+then
+  mkdir -p ${BASELINE_PATH}
+  cp ${SUMMARY} ${BASELINE}
+  echo "=== No baseline, stored ${BASELINE} ==="
+  exit 0
+fi
+
+# The value of a key of a summary, the files have one key per line.
+value() {
+  grep "\"$1\":" $2 | sed -e 's/.*: *//' -e 's/,$//'
+}
+
+if [ "$(value format_version ${SUMMARY})" != "$(value format_version ${BASELINE})" ]
+then
+  echo "=== Baseline ${BASELINE} has a different format, remove it to record a new one ==="
+  exit 1
+fi
+
+ecode=0
+echo "=== Comparing with baseline ${BASELINE}, threshold ${THRESHOLD} ==="
+for key in total_time assemble_time linear_solve_time update_time setup_wall_time \
+           newton_iterations linear_iterations setup_peak_rss_kb simulation_peak_rss_kb
+do
+  current=$(value ${key} ${SUMMARY})
+  baseline=$(value ${key} ${BASELINE})
+  awk -v key=${key} -v cur=${current} -v base=${baseline} -v tol=${THRESHOLD} 'BEGIN {
+    ratio = base > 0 ? cur / base : 1.0;
+    status = ratio > 1.0 + tol ? "REGRESSION" : "ok";
+    printf "%-24s %14g %14g %8.3f %s\n", key, base, cur, ratio, status;
+    exit (status == "ok" ? 0 : 1);
+  }'
+  if [ $? -ne 0 ]
+  then
+    ecode=1
+  fi
+done
+
+exit $ecode
@@ -0,0 +1,95 @@
+#!/bin/bash
+
+# This runs a simulator on a synthetic deck of generate_scaling_deck on
+# 1, 2, 4, ... up to the given number of processes and tabulates the
+# simulation wall time, speedup and parallel efficiency of the runs.
+#
+# strong: the same deck on all process counts, the efficiency is
+#         T(1) / (p T(p)).
+# weak:   the deck grows with the number of processes, by multiplying ny
+#         with it, the efficiency is T(1) / T(p).
+#
+# The times are the simulation_wall_time of the performance summaries of
+# the runs, see PerformanceSummary.hpp.
+#
+# Usage: run-scalingStudy.sh <bin dir> <result dir> <strong|weak> <max processes>
+#                            <nx> <ny> <nz> [generator parameters] [-- simulator parameters]
+
+BINPATH="$1"
+RESULT_PATH="$2"
+MODE="$3"
+MAX_PROCS="$4"
+NX="$5"
+NY="$6"
+NZ="$7"
+shift 7
+
+GENERATOR_ARGS=()
+while [ $# -gt 0 ] && [ "$1" != "--" ]
+do
+  GENERATOR_ARGS+=("$1")
+  shift
+done
+[ "$1" == "--" ] && shift
+SIMULATOR_ARGS="$@"
+EXE_NAME=${EXE_NAME:-flow_ebos}
+MPIRUN=${MPIRUN:-mpirun}
+
+if [ "${MODE}" != "strong" ] && [ "${MODE}" != "weak" ]
+then
+  echo "The mode must be strong or weak, not ${MODE}"
+  exit 1
+fi
+
+mkdir -p ${RESULT_PATH}
+
+# The value of a key of a summary, the files have one key per line.
+value() {
+  grep "\"$1\":" $2 | sed -e 's/.*: *//' -e 's/,$//'
+}
+
+TABLE=${RESULT_PATH}/scaling-${MODE}.txt
+printf "%6s %12s %12s %10s %10s %8s %8s\n" procs cells "time [s]" speedup efficiency newton linear > ${TABLE}
+
+procs=1
+time1=""
+while [ ${procs} -le ${MAX_PROCS} ]
+do
+  ny=${NY}
+  if [ "${MODE}" == "weak" ]
+  then
+    ny=$((NY * procs))
+  fi
+  RUN_PATH=${RESULT_PATH}/${MODE}-np${procs}
+  rm -Rf ${RUN_PATH}
+  mkdir -p ${RUN_PATH}
+  DECK=${RUN_PATH}/SCALING.DATA
+  ${BINPATH}/generate_scaling_deck output=${DECK} nx=${NX} ny=${ny} nz=${NZ} "${GENERATOR_ARGS[@]}" || exit 1
+
+  SUMMARY=${RUN_PATH}/SCALING.perf.json
+  if [ ${procs} -eq 1 ]
+  then
+    LAUNCHER=""
+  else
+    LAUNCHER="${MPIRUN} -np ${procs}"
+  fi
+  ${LAUNCHER} ${BINPATH}/${EXE_NAME} ${DECK} output_dir=${RUN_PATH} \
+      performance_summary_file=${SUMMARY} ${SIMULATOR_ARGS} > ${RUN_PATH}/run.log 2>&1
+  if [ $? -ne 0 ]
+  then
+    echo "${EXE_NAME} failed on ${procs} processes, see ${RUN_PATH}/run.log"
+    exit 1
+  fi
+
+  time=$(value simulation_wall_time ${SUMMARY})
+  [ -z "${time1}" ] && time1=${time}
+  awk -v mode=${MODE} -v p=${procs} -v cells=$(value cells ${SUMMARY}) -v t=${time} -v t1=${time1} \
+      -v newton=$(value newton_iterations ${SUMMARY}) -v linear=$(value linear_iterations ${SUMMARY}) 'BEGIN {
+    speedup = mode == "strong" ? t1 / t : p * t1 / t;
+    printf "%6d %12d %12.3f %10.3f %10.3f %8d %8d\n", p, cells, t, speedup, speedup / p, newton, linear;
+  }' >> ${TABLE}
+
+  procs=$((procs * 2))
+done
+
+cat ${TABLE}
@@ -0,0 +1,106 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE AdaptiveImplicitJacobianTest
+
+#include <opm/autodiff/AdaptiveImplicitJacobian.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/istl/bcrsmatrix.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    typedef Dune::FieldMatrix<double, 2, 2> Block;
+    typedef Dune::BCRSMatrix<Block> Matrix;
+
+    const double accumulation = 10.0;
+    const double transmissibility = 2.0;
+
+    // Upwind transport from left to right through n cells with the primary
+    // variables pressure and saturation: the flux out of cell i is
+    // transmissibility * s_i, the accumulation is accumulation * s_i.
+    Matrix transport(const int n)
+    {
+        Matrix A(n, n, 3*n, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            if (row.index() > 0)                    row.insert(row.index() - 1);
+            row.insert(row.index());
+            if (row.index() < std::size_t(n - 1))   row.insert(row.index() + 1);
+        }
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = row->begin(); col != row->end(); ++col) {
+                Block& block = *col;
+                block = 0.0;
+                if (col.index() == row.index()) {
+                    block[0][0] = 1.0;
+                    block[1][1] = accumulation + (row.index() < std::size_t(n - 1) ? transmissibility : 0.0);
+                }
+                else {
+                    block[0][0] = -0.5;
+                    if (col.index() < row.index()) {
+                        block[1][1] = -transmissibility;
+                    }
+                }
+            }
+        }
+        return A;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(ThroughputRatios)
+{
+    const Matrix A = transport(3);
+    std::vector<double> ratios;
+    Opm::throughputRatios(A, /*pressureIdx=*/0, ratios);
+    BOOST_REQUIRE_EQUAL(ratios.size(), 3u);
+    BOOST_CHECK_CLOSE(ratios[0], transmissibility / accumulation, 1e-12);
+    BOOST_CHECK_CLOSE(ratios[1], transmissibility / accumulation, 1e-12);
+    // no flow out of the last cell
+    BOOST_CHECK_EQUAL(ratios[2], 0.0);
+}
+
+
+BOOST_AUTO_TEST_CASE(RemoveExplicitFluxDerivatives)
+{
+    Matrix A = transport(3);
+    const std::vector<char> isExplicit = { 1, 0, 0 };
+    Opm::removeExplicitFluxDerivatives(A, isExplicit, /*pressureIdx=*/0);
+
+    // the explicit cell keeps its accumulation derivative only
+    BOOST_CHECK_CLOSE(A[0][0][1][1], accumulation, 1e-12);
+    BOOST_CHECK_EQUAL(A[1][0][1][1], 0.0);
+    // the pressure derivatives are kept
+    BOOST_CHECK_EQUAL(A[1][0][0][0], -0.5);
+    BOOST_CHECK_EQUAL(A[0][0][0][0], 1.0);
+    // the implicit cells are unchanged
+    BOOST_CHECK_CLOSE(A[1][1][1][1], accumulation + transmissibility, 1e-12);
+    BOOST_CHECK_EQUAL(A[2][1][1][1], -transmissibility);
+}
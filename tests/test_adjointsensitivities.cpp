@@ -0,0 +1,178 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE AdjointSensitivitiesTest
+
+#include <opm/autodiff/AdjointSensitivities.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <array>
+#include <vector>
+
+namespace
+{
+    typedef Dune::FieldMatrix<double, 1, 1> Block;
+    typedef Dune::FieldVector<double, 1> VectorBlock;
+    typedef Opm::AdjointSensitivities<Block, VectorBlock> Adjoint;
+    typedef Adjoint::Matrix Matrix;
+
+    // Two cells and a well with the residuals
+    //
+    //     R_c = m (x_n - x_{n-1}) / dt + K x_n + b w_n - f - p s = 0
+    //     R_w = c^T x_n + d w_n - p g = 0
+    //
+    // for the pore volume multipliers m, a connection parameter p and the
+    // objective sum_n dt (w_n - target)^2.
+    const double K[2][2] = { { 3.0, -1.0 }, { -1.0, 2.0 } };
+    const double b[2] = { 0.5, 0.25 };
+    const double f[2] = { 1.0, 0.0 };
+    const double s[2] = { 0.2, 0.0 };
+    const double c[2] = { 0.3, -0.6 };
+    const double d = 2.0;
+    const double g = 0.4;
+    const double target = 0.1;
+    const double dt[3] = { 0.5, 1.0, 2.0 };
+
+    Matrix matrix(const double values[2][2])
+    {
+        Matrix A(2, 2, 4, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            row.insert(0);
+            row.insert(1);
+        }
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 2; ++j) {
+                A[i][j] = values[i][j];
+            }
+        }
+        return A;
+    }
+
+    Matrix coupling(const double values[2])
+    {
+        Matrix A(1, 2, 2, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            row.insert(0);
+            row.insert(1);
+        }
+        A[0][0] = values[0];
+        A[0][1] = values[1];
+        return A;
+    }
+
+    // The objective of the forward run, the steps are recorded if adjoint
+    // is given.
+    double forward(const std::array<double, 2>& m, const double p, Adjoint* adjoint)
+    {
+        std::array<double, 2> x = { { 1.0, 2.0 } };
+        double objective = 0.0;
+        for (const double h : dt) {
+            Dune::FieldMatrix<double, 3, 3> J(0.0);
+            Dune::FieldVector<double, 3> rhs(0.0);
+            for (int i = 0; i < 2; ++i) {
+                for (int j = 0; j < 2; ++j) {
+                    J[i][j] = K[i][j] + (i == j ? m[i] / h : 0.0);
+                }
+                J[i][2] = b[i];
+                J[2][i] = c[i];
+                rhs[i] = f[i] + p * s[i] + m[i] * x[i] / h;
+            }
+            J[2][2] = d;
+            rhs[2] = p * g;
+            Dune::FieldVector<double, 3> y;
+            J.solve(y, rhs);
+            objective += h * (y[2] - target) * (y[2] - target);
+
+            if (adjoint) {
+                Adjoint::Step step;
+                step.dt = h;
+                step.objective = h * (y[2] - target) * (y[2] - target);
+                double a[2][2];
+                for (int i = 0; i < 2; ++i) {
+                    for (int j = 0; j < 2; ++j) {
+                        a[i][j] = J[i][j];
+                    }
+                }
+                adjoint->storeMatrix(matrix(a), step);
+                step.b = coupling(b);
+                step.c = coupling(c);
+                step.d.assign(1, Block(d));
+                step.cellStorage = { Block(m[0]), Block(m[1]) };
+                step.wellStorage.assign(1, Block(0.0));
+                step.wellNames.assign(1, "W");
+                step.wellObjective.resize(1);
+                step.wellObjective[0] = 2.0 * h * (y[2] - target);
+                step.accumulation.resize(2);
+                Adjoint::Connection conn;
+                conn.parameter = adjoint->connectionParameter("W", 0);
+                conn.cell = 0;
+                conn.well = 0;
+                conn.cellDerivative = -s[0];
+                conn.wellDerivative = -g;
+                step.connections.push_back(conn);
+                for (int i = 0; i < 2; ++i) {
+                    step.accumulation[i] = (y[i] - x[i]) / h;
+                }
+                adjoint->addStep(std::move(step));
+            }
+            x = { { y[0], y[1] } };
+        }
+        return objective;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(GradientsAgreeWithFiniteDifferences)
+{
+    const std::array<double, 2> m = { { 1.0, 1.0 } };
+    const double p = 1.0;
+    Adjoint adjoint(1e-14, 100, 1e-5);
+    const double objective = forward(m, p, &adjoint);
+    BOOST_CHECK_EQUAL(adjoint.numSteps(), 3);
+    BOOST_CHECK_CLOSE(adjoint.objective(), objective, 1e-10);
+    BOOST_REQUIRE_EQUAL(adjoint.connections().size(), 1);
+
+    std::vector<double> poreVolume;
+    std::vector<double> connection;
+    adjoint.computeGradients(poreVolume, connection);
+    BOOST_REQUIRE_EQUAL(poreVolume.size(), 2);
+    BOOST_REQUIRE_EQUAL(connection.size(), 1);
+
+    const double eps = 1e-6;
+    for (int i = 0; i < 2; ++i) {
+        std::array<double, 2> plus = m;
+        std::array<double, 2> minus = m;
+        plus[i] += eps;
+        minus[i] -= eps;
+        const double numerical = (forward(plus, p, nullptr) - forward(minus, p, nullptr)) / (2 * eps);
+        BOOST_CHECK_CLOSE(poreVolume[i], numerical, 1e-4);
+    }
+    const double numerical = (forward(m, p + eps, nullptr) - forward(m, p - eps, nullptr)) / (2 * eps);
+    BOOST_CHECK_CLOSE(connection[0], numerical, 1e-4);
+}
@@ -0,0 +1,120 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE AndersonAccelerationTest
+
+#include <opm/autodiff/AndersonAcceleration.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    typedef Opm::AndersonAcceleration::Vector Vector;
+
+    // the contraction G(x) = A x + b with a slowly converging fixed-point iteration
+    struct LinearMap
+    {
+        Eigen::MatrixXd A;
+        Vector b;
+        Vector solution;
+
+        explicit LinearMap(const int n)
+            : A(Eigen::MatrixXd::Zero(n, n)), b(Vector::Ones(n))
+        {
+            for (int i = 0; i < n; ++i) {
+                A(i, i) = 0.9 - 0.5 * i / n;
+                if (i > 0) {
+                    A(i, i - 1) = 0.05;
+                }
+                if (i < n - 1) {
+                    A(i, i + 1) = 0.04;
+                }
+            }
+            solution = (Eigen::MatrixXd::Identity(n, n) - A).lu().solve(b);
+        }
+
+        Vector operator()(const Vector& x) const { return A * x + b; }
+    };
+
+    int iterationsToConverge(const LinearMap& G, Opm::AndersonAcceleration& acceleration)
+    {
+        Vector x = Vector::Zero(G.b.size());
+        int it = 0;
+        while ((x - G.solution).norm() > 1e-8 * G.solution.norm() && it < 1000) {
+            x = acceleration.update(x, G(x));
+            ++it;
+        }
+        return it;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(DepthZeroIsRelaxedFixedPoint)
+{
+    Opm::AndersonAcceleration acceleration(0, 0.5);
+    const Vector x = Vector::Constant(3, 2.0);
+    const Vector g = Vector::Constant(3, 4.0);
+    const Vector next = acceleration.update(x, g);
+    BOOST_CHECK_SMALL((next - Vector::Constant(3, 3.0)).norm(), 1e-14);
+    BOOST_CHECK_EQUAL(acceleration.historySize(), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(FasterThanFixedPoint)
+{
+    const LinearMap G(50);
+    Opm::AndersonAcceleration plain(0);
+    Opm::AndersonAcceleration accelerated(5);
+    const int plainIterations = iterationsToConverge(G, plain);
+    const int acceleratedIterations = iterationsToConverge(G, accelerated);
+    BOOST_CHECK_LT(acceleratedIterations, plainIterations / 4);
+    BOOST_CHECK_EQUAL(accelerated.historySize(), 5);
+}
+
+
+BOOST_AUTO_TEST_CASE(ExactForSmallLinearMaps)
+{
+    // with a history of the dimension of the map the iteration is a Krylov
+    // method that terminates after dimension + 1 updates
+    const LinearMap G(4);
+    Opm::AndersonAcceleration acceleration(4);
+    BOOST_CHECK_LE(iterationsToConverge(G, acceleration), 6);
+}
+
+
+BOOST_AUTO_TEST_CASE(Reset)
+{
+    const LinearMap G(10);
+    Opm::AndersonAcceleration acceleration(3);
+    Vector x = Vector::Zero(10);
+    for (int i = 0; i < 3; ++i) {
+        x = acceleration.update(x, G(x));
+    }
+    BOOST_CHECK_EQUAL(acceleration.historySize(), 2);
+    acceleration.reset();
+    const Vector next = acceleration.update(x, G(x));
+    BOOST_CHECK_EQUAL(acceleration.historySize(), 0);
+    BOOST_CHECK_SMALL((next - G(x)).norm(), 1e-14);
+}
@@ -0,0 +1,107 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE AutoDiffArenaTest
+
+#include <opm/autodiff/AutoDiffArena.hpp>
+#include <opm/autodiff/AutoDiffBlock.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using namespace Opm;
+
+BOOST_AUTO_TEST_CASE(SizeClasses)
+{
+    BOOST_CHECK_EQUAL(AutoDiffArena::sizeClass(1), 64u);
+    BOOST_CHECK_EQUAL(AutoDiffArena::sizeClass(64), 64u);
+    BOOST_CHECK_EQUAL(AutoDiffArena::sizeClass(65), 80u);
+    BOOST_CHECK_EQUAL(AutoDiffArena::sizeClass(1000), 1024u);
+    BOOST_CHECK_EQUAL(AutoDiffArena::sizeClass(1025), 1280u);
+    for (std::size_t bytes = 1; bytes < 100000; bytes += 37) {
+        const std::size_t size = AutoDiffArena::sizeClass(bytes);
+        BOOST_CHECK(size >= bytes);
+        BOOST_CHECK(bytes <= 64 || 4 * (size - bytes) < 3 * bytes);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ReuseInsideScope)
+{
+    typedef std::vector<double, AutoDiffArenaAllocator<double> > Vector;
+    AutoDiffArena& arena = AutoDiffArena::instance();
+    const std::size_t reused = arena.reusedBuffers();
+
+    // outside a scope nothing is cached
+    {
+        Vector v(1000, 1.0);
+    }
+    BOOST_CHECK_EQUAL(arena.cachedBytes(), 0u);
+
+    {
+        AutoDiffArena::Scope scope;
+        const double* first = nullptr;
+        {
+            Vector v(1000, 1.0);
+            first = v.data();
+        }
+        BOOST_CHECK_EQUAL(arena.cachedBytes(), AutoDiffArena::sizeClass(1000 * sizeof(double)));
+        {
+            // same size class, served from the cache
+            Vector w(990, 2.0);
+            BOOST_CHECK_EQUAL(w.data(), first);
+            BOOST_CHECK_EQUAL(arena.reusedBuffers(), reused + 1);
+        }
+        {
+            AutoDiffArena::Scope nested;
+        }
+        // the nested scope does not release the cache
+        BOOST_CHECK(arena.cachedBytes() > 0u);
+    }
+    BOOST_CHECK_EQUAL(arena.cachedBytes(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(DiagonalTemporaries)
+{
+    typedef AutoDiffBlock<double> ADB;
+    ADB::V vx(3);
+    vx << 0.2, 1.2, 13.4;
+    std::vector<ADB::V> vals{ vx };
+
+    // results created inside the scope stay valid after it
+    ADB z = ADB::null();
+    {
+        AutoDiffArena::Scope scope;
+        const ADB x = ADB::variables(vals)[0];
+        for (int i = 0; i < 10; ++i) {
+            z = x * vx * x;
+        }
+    }
+    BOOST_CHECK_EQUAL(AutoDiffArena::instance().cachedBytes(), 0u);
+    for (int i = 0; i < 3; ++i) {
+        BOOST_CHECK_CLOSE(z.value()[i], vx[i] * vx[i] * vx[i], 1e-12);
+        BOOST_CHECK_CLOSE(z.derivative()[0].coeff(i, i), 2.0 * vx[i] * vx[i], 1e-12);
+    }
+}
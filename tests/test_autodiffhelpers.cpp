@@ -26,6 +26,7 @@
 #define BOOST_TEST_MODULE AutoDiffHelpersTest
 
 #include <opm/autodiff/AutoDiffHelpers.hpp>
+#include <opm/core/grid/GridManager.hpp>
 
 #include <boost/test/unit_test.hpp>
 
@@ -228,3 +229,42 @@ BOOST_AUTO_TEST_CASE(subsetEmptyTest)
     }
 }
 
+
+
+BOOST_AUTO_TEST_CASE(gridTopologyTest)
+{
+    // 3x2 Cartesian grid: 2*2 internal faces in x and 3 in y.
+    Opm::GridManager gm(3, 2);
+    const UnstructuredGrid& grid = *gm.c_grid();
+    const HelperOps ops(grid);
+    BOOST_REQUIRE(ops.topology);
+    const GridTopology& topology = *ops.topology;
+
+    BOOST_CHECK_EQUAL(topology.num_cells, 6);
+    BOOST_CHECK_EQUAL(topology.face_cells.rows(), grid.number_of_faces);
+    BOOST_REQUIRE_EQUAL(topology.internal_faces.size(), 7);
+    BOOST_CHECK((ops.internal_faces == topology.internal_faces).all());
+    BOOST_CHECK((ops.connection_cells == topology.internal_face_cells).all());
+
+    for (int i = 0; i < topology.internal_faces.size(); ++i) {
+        const int f = topology.internal_faces[i];
+        BOOST_CHECK_EQUAL(topology.internal_face_cells(i, 0), grid.face_cells[2*f]);
+        BOOST_CHECK_EQUAL(topology.internal_face_cells(i, 1), grid.face_cells[2*f + 1]);
+    }
+
+    // Every internal face is listed once for each of its cells.
+    BOOST_REQUIRE_EQUAL(topology.cell_internal_face_start.size(), 7);
+    BOOST_CHECK_EQUAL(topology.cell_internal_face_start.back(), 14);
+    for (int c = 0; c < topology.num_cells; ++c) {
+        for (int k = topology.cell_internal_face_start[c]; k < topology.cell_internal_face_start[c + 1]; ++k) {
+            const int i = topology.cell_internal_faces[k];
+            BOOST_CHECK(topology.internal_face_cells(i, 0) == c || topology.internal_face_cells(i, 1) == c);
+        }
+    }
+
+    // Operators built from the same topology share it.
+    const HelperOps ops2(grid, ops.topology);
+    BOOST_CHECK(ops2.topology == ops.topology);
+    BOOST_CHECK(ops2.ngrad.isApprox(ops.ngrad));
+    BOOST_CHECK(ops2.fulldiv.isApprox(ops.fulldiv));
+}
@@ -421,3 +421,199 @@ BOOST_AUTO_TEST_CASE(nonZeros)
     BOOST_CHECK_EQUAL(s.nonZeros(), 4);
 }
 
+
+namespace {
+    Eigen::MatrixXd dense(const Mat& m)
+    {
+        Sp s;
+        m.toSparse(s);
+        return Eigen::MatrixXd(s);
+    }
+
+    bool close(const Mat& m, const Eigen::MatrixXd& reference)
+    {
+        const Eigen::MatrixXd md = dense(m);
+        return md.rows() == reference.rows() && md.cols() == reference.cols()
+            && (md - reference).norm() <= 1e-12 * (1.0 + reference.norm());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(StencilOps)
+{
+    // gradient of a chain of 4 cells with 3 faces
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> g1(3,4);
+    g1 <<
+        1.0, -1.0, 0.0, 0.0,
+        0.0, 1.0, -1.0, 0.0,
+        0.0, 0.0, 1.0, -1.0;
+    const Sp gs(g1.sparseView());
+    const Sp divs(gs.transpose());
+    const Mat grad = Mat::createStencil(gs);
+    const Mat div = Mat::createStencil(divs);
+
+    // square stencils with and without full diagonal
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> t1(4,4), t2(4,4);
+    t1 <<
+        2.0, -1.0, 0.0, 0.0,
+        -1.0, 2.0, -1.0, 0.0,
+        0.0, -1.0, 2.0, -1.0,
+        0.0, 0.0, -1.0, 2.0;
+    t2 <<
+        0.0, 3.0, 0.0, 0.0,
+        0.0, 1.0, 0.0, 0.5,
+        4.0, 0.0, 0.0, 0.0,
+        0.0, 0.0, 1.5, 0.0;
+    const Mat tf = Mat::createStencil(Sp(t1.sparseView()));
+    const Mat tp = Mat::createStencil(Sp(t2.sparseView()));
+
+    Eigen::Array<double, Eigen::Dynamic, 1> d1(4);
+    d1 << 0.2, 1.2, 13.4, -2.0;
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> s1(4,4);
+    s1 <<
+        1.0, 0.0, 2.0, 0.0,
+        0.0, 1.0, 0.0, 0.0,
+        0.0, 0.0, 2.0, 0.0,
+        0.5, 0.0, 0.0, 1.0;
+
+    const std::vector<Mat> mats = {
+        Mat(4, 4), Mat::createIdentity(4), Mat(d1.matrix().asDiagonal()),
+        Mat(Sp(s1.sparseView())), tf, tp
+    };
+
+    // sums and products with all other types
+    for (const Mat& a : mats) {
+        for (const Mat& b : mats) {
+            BOOST_CHECK(close(a + b, dense(a) + dense(b)));
+            BOOST_CHECK(close(a * b, dense(a) * dense(b)));
+            Mat c = a;
+            c += b;
+            BOOST_CHECK(close(c, dense(a) + dense(b)));
+            c -= b;
+            BOOST_CHECK(close(c, dense(a)));
+            c = a;
+            c.addScaledRows(d1, b);
+            BOOST_CHECK(close(c, dense(a) + d1.matrix().asDiagonal() * dense(b)));
+        }
+    }
+
+    // the divergence of the gradient, twice to use the cached product
+    const Eigen::MatrixXd lap = divs * gs;
+    for (int i = 0; i < 2; ++i) {
+        const Mat dg = div * (grad * 2.0);
+        BOOST_CHECK(close(dg, 2.0 * lap));
+        BOOST_CHECK_EQUAL(dg.nonZeros(), 10);
+        BOOST_CHECK_EQUAL(dg.coeff(1, 1), 4.0);
+        BOOST_CHECK_EQUAL(dg.coeff(0, 3), 0.0);
+    }
+
+    // upwind selection has a sub-pattern of the gradient
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> u1(3,4);
+    u1 <<
+        1.0, 0.0, 0.0, 0.0,
+        0.0, 0.0, 1.0, 0.0,
+        0.0, 0.0, 1.0, 0.0;
+    const Mat up = Mat::createStencil(Sp(u1.sparseView()));
+    const Mat flux = up * 3.0 + grad;
+    BOOST_CHECK(close(flux, 3.0 * u1 + g1));
+    BOOST_CHECK_EQUAL(flux.nonZeros(), grad.nonZeros());
+    BOOST_CHECK(close(div * flux, divs * (3.0 * u1 + g1)));
+
+    // scaling and vector products
+    Mat scaled = grad;
+    scaled.scaleRows(Eigen::Array<double, Eigen::Dynamic, 1>::Constant(3, 2.0));
+    scaled *= 0.25;
+    BOOST_CHECK(close(scaled, 0.5 * g1));
+    BOOST_CHECK(close(grad / 4.0, 0.25 * g1));
+    const Eigen::VectorXd v = d1.matrix();
+    BOOST_CHECK_SMALL((grad * v - g1 * v).norm(), 1e-12);
+    BOOST_CHECK(close(Mat(grad.getSparse()), g1));
+}
+
+
+BOOST_AUTO_TEST_CASE(GatherScatterRows)
+{
+    Eigen::Array<double, Eigen::Dynamic, 1> d1(4);
+    d1 << 0.2, 1.2, 13.4, -2.0;
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> s1(4,4);
+    s1 <<
+        1.0, 0.0, 2.0, 0.0,
+        0.0, 1.0, 0.0, 0.0,
+        0.0, 0.0, 2.0, 3.0,
+        0.5, 0.0, 0.0, 1.0;
+    const std::vector<Mat> mats = {
+        Mat(4, 4), Mat::createIdentity(4), Mat(d1.matrix().asDiagonal()),
+        Mat(Sp(s1.sparseView())), Mat::createStencil(Sp(s1.sparseView()))
+    };
+
+    // sorted, unsorted with a repeated index, and empty index sets
+    const std::vector< std::vector<int> > index_sets = { { 0, 2, 3 }, { 3, 1, 3, 0 }, { } };
+    for (const std::vector<int>& indices : index_sets) {
+        const GatherPlan plan(indices);
+        const int m = indices.size();
+        Eigen::MatrixXd select = Eigen::MatrixXd::Zero(m, 4);
+        for (int i = 0; i < m; ++i) {
+            select(i, indices[i]) = 1.0;
+        }
+        for (const Mat& a : mats) {
+            // twice to use the cached stencil patterns
+            for (int repeat = 0; repeat < 2; ++repeat) {
+                const Mat g = a.gatherRows(plan);
+                BOOST_CHECK(close(g, select * dense(a)));
+                BOOST_CHECK(close(g.scatterRows(plan, 4), select.transpose() * select * dense(a)));
+            }
+        }
+    }
+
+    // scattering to more rows than indexed
+    const GatherPlan plan(std::vector<int>{ 1, 0 });
+    Eigen::MatrixXd scatter = Eigen::MatrixXd::Zero(3, 2);
+    scatter(1, 0) = 1.0;
+    scatter(0, 1) = 1.0;
+    const Mat small = Mat::createStencil(Sp(s1.topLeftCorner(2, 2).sparseView()));
+    BOOST_CHECK(close(small.scatterRows(plan, 3), scatter * s1.topLeftCorner(2, 2)));
+    BOOST_CHECK(close(Mat::createIdentity(2).scatterRows(plan, 3), scatter));
+}
+
+
+BOOST_AUTO_TEST_CASE(CachedSparseProduct)
+{
+    Eigen::MatrixXd a1(3, 4);
+    a1 <<
+        1.0, 0.0, 2.0, 0.0,
+        0.0, 3.0, 0.0, 1.0,
+        4.0, 0.0, 0.0, 5.0;
+    Eigen::MatrixXd b1(4, 3);
+    b1 <<
+        1.0, 2.0, 0.0,
+        0.0, 0.0, 1.0,
+        3.0, 0.0, 0.0,
+        0.0, 1.0, 2.0;
+    const Sp a(a1.sparseView());
+    const Sp b(b1.sparseView());
+
+    // the second product only performs the numeric part
+    for (int repeat = 0; repeat < 2; ++repeat) {
+        const double scale = 1.0 + repeat;
+        Sp bs = b * scale;
+        Sp res;
+        Opm::SparseProductCache::multiply(a, bs, res);
+        const Eigen::MatrixXd reference = a1 * b1 * scale;
+        BOOST_CHECK((Eigen::MatrixXd(res) - reference).norm() < 1e-12);
+        BOOST_CHECK(close(Mat(a) * Mat(bs), reference));
+    }
+
+    // products which cancel keep their entries
+    Sp c = b;
+    c.coeffRef(0, 0) = 0.0;
+    c.coeffRef(2, 0) = 0.0;
+    Sp res;
+    Opm::SparseProductCache::multiply(a, c, res);
+    BOOST_CHECK_EQUAL(res.nonZeros(), Sp(a * b).nonZeros());
+    BOOST_CHECK(close(Mat(res), a1 * Eigen::MatrixXd(c)));
+
+    // a different pattern is not confused with the cached one
+    const Sp t(b1.transpose().sparseView());
+    const Sp tt = a * t.transpose();
+    Opm::SparseProductCache::multiply(a, Sp(t.transpose()), res);
+    BOOST_CHECK((Eigen::MatrixXd(res) - Eigen::MatrixXd(tt)).norm() < 1e-12);
+}
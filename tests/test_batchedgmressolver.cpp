@@ -0,0 +1,132 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE BatchedGMResSolverTest
+
+#include <opm/autodiff/BatchedGMResSolver.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioners.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    typedef Dune::BCRSMatrix<Dune::FieldMatrix<double, 2, 2> > Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double, 2> > Vector;
+
+    // a nonsymmetric block tridiagonal matrix
+    Matrix convectionDiffusion(const int n)
+    {
+        Matrix A(n, n, 3*n, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            if (row.index() > 0) row.insert(row.index() - 1);
+            row.insert(row.index());
+            if (static_cast<int>(row.index()) < n - 1) row.insert(row.index() + 1);
+        }
+        for (int i = 0; i < n; ++i) {
+            A[i][i] = 0.0;
+            A[i][i][0][0] = 2.2 + 0.01 * i;
+            A[i][i][1][1] = 2.5;
+            A[i][i][0][1] = 0.3;
+            if (i > 0) {
+                A[i][i-1] = 0.0;
+                A[i][i-1][0][0] = -1.1;
+                A[i][i-1][1][1] = -1.2;
+            }
+            if (i < n - 1) {
+                A[i][i+1] = 0.0;
+                A[i][i+1][0][0] = -1.0;
+                A[i][i+1][1][1] = -0.9;
+            }
+        }
+        return A;
+    }
+
+    Dune::InverseOperatorResult solve(const Matrix& A, const Vector& rhs, const int restart, Vector& x)
+    {
+        Dune::MatrixAdapter<Matrix, Vector, Vector> op(A);
+        Opm::SequentialBatchedScalarProduct<Vector> sp;
+        Dune::SeqJac<Matrix, Vector, Vector> jacobi(A, 1, 1.0);
+        Opm::BatchedGMResSolver<Vector> solver(op, sp, jacobi, 1e-8, restart, 2000, 0);
+
+        Vector b(rhs);
+        x.resize(rhs.size());
+        x = 0.0;
+        Dune::InverseOperatorResult result;
+        solver.apply(x, b, result);
+        return result;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BatchedScalarProducts)
+{
+    std::vector<Vector> basis(2, Vector(3));
+    Vector w(3);
+    for (int i = 0; i < 3; ++i) {
+        basis[0][i] = 1.0;
+        basis[1][i][0] = i;
+        basis[1][i][1] = -i;
+        w[i][0] = 2.0;
+        w[i][1] = i;
+    }
+
+    std::vector<double> results;
+    Opm::SequentialBatchedScalarProduct<Vector> sp;
+    sp.dots(basis, 2, w, results);
+    BOOST_REQUIRE_EQUAL(results.size(), 3u);
+    BOOST_CHECK_CLOSE(results[0], basis[0] * w, 1e-12);
+    BOOST_CHECK_CLOSE(results[1], basis[1] * w, 1e-12);
+    BOOST_CHECK_CLOSE(results[2], w * w, 1e-12);
+}
+
+BOOST_AUTO_TEST_CASE(SolvesWithAndWithoutRestarts)
+{
+    const int n = 200;
+    const Matrix A = convectionDiffusion(n);
+    Vector b(n);
+    for (int i = 0; i < n; ++i) {
+        b[i][0] = std::sin(double(i));
+        b[i][1] = std::cos(double(i));
+    }
+
+    for (const int restart : { 5, 20, 400 }) {
+        Vector x;
+        const Dune::InverseOperatorResult result = solve(A, b, restart, x);
+        BOOST_CHECK(result.converged);
+
+        // the true residual, not only the estimate of the iteration
+        Vector residual(b);
+        A.mmv(x, residual);
+        BOOST_CHECK_SMALL(residual.two_norm() / b.two_norm(), 1e-7);
+    }
+}
@@ -285,6 +285,82 @@ BOOST_AUTO_TEST_CASE(AssignAddSubtractOperators)
     checkClose(z, yconst, tolerance);
 }
 
+BOOST_AUTO_TEST_CASE(InPlaceMultiplyAndFma)
+{
+    typedef AutoDiffBlock<double> ADB;
+
+    ADB::V vx(3);
+    vx << 0.2, 1.2, 13.4;
+
+    ADB::V vy(3);
+    vy << 1.0, 2.2, 3.4;
+
+    std::vector<ADB::V> vals{ vx, vy };
+    std::vector<ADB> vars = ADB::variables(vals);
+
+    const ADB x = vars[0];
+    const ADB y = vars[1];
+
+    // a sparse coupling of the cells
+    Eigen::SparseMatrix<double> S(3, 3);
+    S.insert(0, 0) = 2.0;
+    S.insert(1, 0) = -1.0;
+    S.insert(1, 2) = 0.5;
+    S.insert(2, 1) = 3.0;
+    S.makeCompressed();
+    const ADB sx = S * x;
+    const ADB sxy = S * x + S * y;
+
+    const double tolerance = 1e-14;
+
+    // identity and sparse Jacobians
+    ADB z = x;
+    z *= y;
+    checkClose(z, x * y, tolerance);
+
+    z = sx;
+    z *= sxy;
+    checkClose(z, sx * sxy, tolerance);
+
+    z *= 2.5;
+    checkClose(z, sx * sxy * 2.5, tolerance);
+
+    z = sxy;
+    z *= vy;
+    checkClose(z, sxy * vy, tolerance);
+
+    // left hand side with empty jacobian
+    z = ADB::constant(vy);
+    z *= sxy;
+    checkClose(z, vy * sxy, tolerance);
+
+    // fused multiply-add with equal and different sparsity patterns
+    z = sxy;
+    z.fma(sx, sxy);
+    checkClose(z, sxy + sx * sxy, tolerance);
+
+    z = x;
+    z.fma(sx, y);
+    checkClose(z, x + sx * y, tolerance);
+
+    z = ADB::constant(vx);
+    z.fma(x, y);
+    checkClose(z, vx + x * y, tolerance);
+
+    z = sx;
+    z.fma(vy, sxy);
+    checkClose(z, sx + vy * sxy, tolerance);
+
+    // aliased arguments
+    z = sx;
+    z.fma(z, y);
+    checkClose(z, sx + sx * y, tolerance);
+
+    z = sx;
+    z *= z;
+    checkClose(z, sx * sx, tolerance);
+}
+
 BOOST_AUTO_TEST_CASE(Pow)
 {
     typedef AutoDiffBlock<double> ADB;
@@ -369,3 +445,39 @@ BOOST_AUTO_TEST_CASE(Pow)
 }
 
 
+
+
+BOOST_AUTO_TEST_CASE(ThreadedElementwise)
+{
+    typedef AutoDiffBlock<double> ADB;
+
+    const int n = 1000;
+    const ADB::V vx = ADB::V::LinSpaced(n, 0.5, 2.0);
+    const ADB::V vy = ADB::V::LinSpaced(n, 3.0, 1.0);
+    std::vector<ADB> vars = ADB::variables(std::vector<ADB::V>{ vx, vy });
+    const ADB& x = vars[0];
+    const ADB& y = vars[1];
+
+    // the same results with the arrays split among the threads
+    const int minimum_size = AutoDiffThreading::minimumSize();
+    std::vector<ADB> results[2];
+    for (int threaded = 0; threaded < 2; ++threaded) {
+        AutoDiffThreading::setMinimumSize(threaded ? 1 : n + 1);
+        ADB z = x;
+        z *= y;
+        z.fma(x, y);
+        z -= y;
+        results[threaded] = { x + y, x - y, x * y, x / y, Opm::pow(x, 1.5), Opm::pow(x, y), z };
+    }
+    AutoDiffThreading::setMinimumSize(minimum_size);
+    for (std::size_t i = 0; i < results[0].size(); ++i) {
+        checkClose(results[0][i], results[1][i], 1e-14);
+    }
+
+    // d(x / y) = dx / y - x dy / y^2
+    const ADB q = results[1][3];
+    for (int i = 0; i < n; i += 99) {
+        BOOST_CHECK_CLOSE(q.derivative()[0].coeff(i, i), 1.0 / vy[i], 1e-12);
+        BOOST_CHECK_CLOSE(q.derivative()[1].coeff(i, i), -vx[i] / (vy[i] * vy[i]), 1e-12);
+    }
+}
@@ -0,0 +1,145 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE BlockCPRPreconditionerTest
+
+#include <opm/autodiff/BlockCPRPreconditioner.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/solvers.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    typedef Dune::FieldMatrix<double, 2, 2> Block;
+    typedef Dune::BCRSMatrix<Block> Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double, 2> > Vector;
+
+    // Block 5-point stencil on a nx by ny grid, where the first
+    // variable (the "pressure") is elliptic and couples to the second.
+    Matrix pressureSystem(const int nx, const int ny)
+    {
+        const int n = nx * ny;
+        Matrix A(n, n, 5*n, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            const int i = row.index() % nx;
+            const int j = row.index() / nx;
+            if (j > 0)      row.insert(row.index() - nx);
+            if (i > 0)      row.insert(row.index() - 1);
+            row.insert(row.index());
+            if (i < nx - 1) row.insert(row.index() + 1);
+            if (j < ny - 1) row.insert(row.index() + nx);
+        }
+
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = row->begin(); col != row->end(); ++col) {
+                *col = 0.0;
+                if (col.index() == row.index()) {
+                    (*col)[0][0] = 4.0; (*col)[1][0] = 2.0;
+                    (*col)[0][1] = 0.5; (*col)[1][1] = 1.0 + 0.1 * row.index();
+                } else {
+                    (*col)[0][0] = -1.0; (*col)[1][0] = -0.5;
+                }
+            }
+        }
+        return A;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(QuasiImpesWeights)
+{
+    const Matrix A = pressureSystem(4, 3);
+
+    std::vector<Dune::FieldVector<double, 2> > weights;
+    Opm::detail::computeQuasiImpesWeights<0>(A, weights);
+    BOOST_REQUIRE_EQUAL(weights.size(), A.N());
+
+    // D_ii^T w_i = e_p
+    for (std::size_t i = 0; i < A.N(); ++i) {
+        const Block& diag = A[i][i];
+        for (int j = 0; j < 2; ++j) {
+            double value = 0.0;
+            for (int k = 0; k < 2; ++k) {
+                value += diag[k][j] * weights[i][k];
+            }
+            BOOST_CHECK_SMALL(value - (j == 0 ? 1.0 : 0.0), 1e-10);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(PressureMatrixDecouplesDiagonal)
+{
+    const Matrix A = pressureSystem(4, 3);
+
+    typedef Opm::BlockCPRPreconditioner<Matrix, Vector, Vector> CPR;
+    Dune::Amg::SequentialInformation info;
+    CPR cpr(A, 1.0, info);
+
+    const CPR::PressureMatrix& Ap = cpr.pressureMatrix();
+    BOOST_CHECK_EQUAL(Ap.N(), A.N());
+    BOOST_CHECK_EQUAL(Ap.nonzeroes(), A.nonzeroes());
+
+    // the weighted diagonal is the unit pressure coefficient
+    for (std::size_t i = 0; i < Ap.N(); ++i) {
+        BOOST_CHECK_CLOSE(Ap[i][i][0][0], 1.0, 1e-10);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CPRPreconditionedSolve)
+{
+    const Matrix A = pressureSystem(10, 10);
+
+    typedef Opm::BlockCPRPreconditioner<Matrix, Vector, Vector> CPR;
+    Dune::Amg::SequentialInformation info;
+    CPR cpr(A, 1.0, info);
+
+    Dune::MatrixAdapter<Matrix, Vector, Vector> opA(A);
+    Dune::SeqScalarProduct<Vector> sp;
+    Dune::BiCGSTABSolver<Vector> solver(opA, sp, cpr, 1e-8, 100, 0);
+
+    Vector x(A.N()), b(A.N());
+    for (std::size_t i = 0; i < b.size(); ++i) {
+        b[i][0] = std::sin(double(i));
+        b[i][1] = std::cos(double(i));
+    }
+    const Vector rhs(b);
+    x = 0.0;
+
+    Dune::InverseOperatorResult result;
+    solver.apply(x, b, result);
+    BOOST_CHECK(result.converged);
+
+    Vector residual(rhs);
+    A.mmv(x, residual);
+    BOOST_CHECK_SMALL(residual.two_norm() / rhs.two_norm(), 1e-6);
+}
@@ -0,0 +1,176 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE BlockKernelsTest
+
+#include <opm/autodiff/BlockKernels.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    template <int n>
+    void fillBlock(Dune::FieldMatrix<double,n,n>& A, Dune::FieldVector<double,n>& x, const int seed)
+    {
+        for (int i = 0; i < n; ++i) {
+            x[i] = 0.5 * (i + seed) - 1.0;
+            for (int j = 0; j < n; ++j) {
+                A[i][j] = 1.0 / (1 + i + 2*j + seed);
+            }
+        }
+    }
+
+    template <int n>
+    void checkBlockKernels()
+    {
+        Dune::FieldMatrix<double,n,n> A;
+        Dune::FieldVector<double,n> x;
+        fillBlock(A, x, 3);
+
+        Dune::FieldVector<double,n> expected, y;
+        A.mv(x, expected);
+        Opm::BlockKernels::mv(A, x, y);
+        for (int i = 0; i < n; ++i) {
+            BOOST_CHECK_CLOSE(y[i], expected[i], 1e-12);
+        }
+
+        expected = 1.0;
+        y = 1.0;
+        A.umv(x, expected);
+        Opm::BlockKernels::umv(A, x, y);
+        for (int i = 0; i < n; ++i) {
+            BOOST_CHECK_CLOSE(y[i], expected[i], 1e-12);
+        }
+
+        expected = 1.0;
+        y = 1.0;
+        A.mmv(x, expected);
+        Opm::BlockKernels::mmv(A, x, y);
+        for (int i = 0; i < n; ++i) {
+            BOOST_CHECK_CLOSE(y[i], expected[i], 1e-12);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(BlockOperations)
+{
+    checkBlockKernels<1>();
+    checkBlockKernels<2>();
+    checkBlockKernels<3>();
+    checkBlockKernels<4>();
+}
+
+BOOST_AUTO_TEST_CASE(MatrixVectorProduct)
+{
+    typedef Dune::FieldMatrix<double,3,3> Block;
+    typedef Dune::BCRSMatrix<Block> Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double,3> > Vector;
+
+    // a block tridiagonal matrix
+    const int n = 10;
+    Matrix A(n, n, 3*n - 2, Matrix::row_wise);
+    for (auto row = A.createbegin(); row != A.createend(); ++row) {
+        const int i = row.index();
+        for (int j = std::max(i - 1, 0); j <= std::min(i + 1, n - 1); ++j) {
+            row.insert(j);
+        }
+    }
+    Vector x(n);
+    for (auto row = A.begin(); row != A.end(); ++row) {
+        for (auto col = row->begin(); col != row->end(); ++col) {
+            fillBlock(*col, x[col.index()], row.index() + 2*col.index());
+        }
+    }
+
+    Vector expected(n), y(n);
+    A.mv(x, expected);
+    y = 42.0;
+    Opm::BlockKernels::matrixMv(A, x, y);
+    for (int i = 0; i < n; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            BOOST_CHECK_CLOSE(y[i][k], expected[i][k], 1e-12);
+        }
+    }
+
+    // several vectors at once, the second one scaled
+    std::vector<Vector> xs(2, x);
+    xs[1] *= -2.0;
+    std::vector<Vector> ys(2, Vector(n));
+    ys[0] = 42.0;
+    Opm::BlockKernels::matrixMultiMv(A, xs, ys);
+    for (int i = 0; i < n; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            BOOST_CHECK_CLOSE(ys[0][i][k], expected[i][k], 1e-12);
+            BOOST_CHECK_CLOSE(ys[1][i][k], -2.0 * expected[i][k], 1e-12);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SinglePrecisionMatrixVectorProduct)
+{
+    typedef Dune::FieldMatrix<double,3,3> Block;
+    typedef Dune::FieldMatrix<float,3,3> FloatBlock;
+    typedef Dune::BCRSMatrix<Block> Matrix;
+    typedef Dune::BCRSMatrix<FloatBlock> FloatMatrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double,3> > Vector;
+
+    // a block diagonal matrix and its single precision copy
+    const int n = 5;
+    Matrix A(n, n, n, Matrix::row_wise);
+    FloatMatrix floatA(n, n, n, FloatMatrix::row_wise);
+    for (auto row = A.createbegin(); row != A.createend(); ++row) {
+        row.insert(row.index());
+    }
+    for (auto row = floatA.createbegin(); row != floatA.createend(); ++row) {
+        row.insert(row.index());
+    }
+    Vector x(n);
+    for (int i = 0; i < n; ++i) {
+        fillBlock(A[i][i], x[i], i);
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                floatA[i][i][r][c] = A[i][i][r][c];
+            }
+        }
+    }
+
+    Vector expected(n), y(n);
+    A.mv(x, expected);
+    Opm::BlockKernels::matrixMv(floatA, x, y);
+    for (int i = 0; i < n; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            // only the rounding of the matrix entries to single precision
+            BOOST_CHECK_CLOSE(y[i][k], expected[i][k], 1e-4);
+        }
+    }
+}
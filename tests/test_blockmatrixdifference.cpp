@@ -0,0 +1,118 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE BlockMatrixDifferenceTest
+
+#include <opm/autodiff/BlockMatrixDifference.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/istl/bcrsmatrix.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+namespace
+{
+    typedef Dune::FieldMatrix<double, 3, 3> Block;
+    typedef Dune::BCRSMatrix<Block> Matrix;
+
+    // A matrix with the given columns in each row and the blocks filled
+    // with 1 + i + j.
+    Matrix matrix(const std::vector< std::vector<int> >& columns, const int numCols)
+    {
+        Matrix A(columns.size(), numCols, Matrix::random);
+        for (std::size_t row = 0; row < columns.size(); ++row) {
+            A.setrowsize(row, columns[row].size());
+        }
+        A.endrowsizes();
+        for (std::size_t row = 0; row < columns.size(); ++row) {
+            for (const int col : columns[row]) {
+                A.addindex(row, col);
+            }
+        }
+        A.endindices();
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = row->begin(); col != row->end(); ++col) {
+                for (int i = 0; i < 3; ++i) {
+                    for (int j = 0; j < 3; ++j) {
+                        (*col)[i][j] = 1.0 + i + j;
+                    }
+                }
+            }
+        }
+        return A;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(EqualMatrices)
+{
+    const Matrix A = matrix({ { 0, 1 }, { 0, 1, 2 }, { 1, 2 } }, 3);
+    Opm::BlockMatrixDifference diff;
+    Opm::addBlockMatrixDifference(A, A, 3, 3, diff);
+    BOOST_CHECK_EQUAL(diff.numEntries(), 7 * 9);
+    BOOST_CHECK_EQUAL(diff.numAboveTolerance(), 0);
+    BOOST_CHECK_EQUAL(diff.maxRelative(), 0.0);
+    BOOST_CHECK_EQUAL(diff.row(), -1);
+}
+
+
+BOOST_AUTO_TEST_CASE(LeadingEntriesOfTheBlocks)
+{
+    const Matrix A = matrix({ { 0, 1 }, { 0, 1 } }, 2);
+    Matrix B = A;
+    // outside of the compared 2x2 part and a small difference inside
+    B[1][0][2][2] = 100.0;
+    B[0][1][0][1] = 2.001;
+    Opm::BlockMatrixDifference diff(1e-2);
+    Opm::addBlockMatrixDifference(A, B, 2, 2, diff);
+    BOOST_CHECK_EQUAL(diff.numEntries(), 4 * 4);
+    BOOST_CHECK_EQUAL(diff.numAboveTolerance(), 0);
+    BOOST_CHECK_CLOSE(diff.maxAbsolute(), 0.001, 1e-6);
+    BOOST_CHECK_EQUAL(diff.row(), 0);
+    BOOST_CHECK_EQUAL(diff.col(), 1);
+    BOOST_CHECK_EQUAL(diff.blockRow(), 0);
+    BOOST_CHECK_EQUAL(diff.blockCol(), 1);
+}
+
+
+BOOST_AUTO_TEST_CASE(DifferentSparsityPatterns)
+{
+    // the block (0, 2) is only in A and the block (1, 0) only in B, both
+    // are compared with zero
+    const Matrix A = matrix({ { 0, 2 }, { 1 } }, 3);
+    const Matrix B = matrix({ { 0 }, { 0, 1 } }, 3);
+    Opm::BlockMatrixDifference diff;
+    Opm::addBlockMatrixDifference(A, B, 1, 1, diff);
+    BOOST_CHECK_EQUAL(diff.numEntries(), 4);
+    BOOST_CHECK_EQUAL(diff.numAboveTolerance(), 2);
+    BOOST_CHECK_EQUAL(diff.maxRelative(), 1.0);
+    BOOST_CHECK_EQUAL(diff.maxAbsolute(), 1.0);
+    BOOST_CHECK_EQUAL(diff.row(), 0);
+    BOOST_CHECK_EQUAL(diff.col(), 2);
+    BOOST_CHECK_EQUAL(diff.expected(), 1.0);
+    BOOST_CHECK_EQUAL(diff.actual(), 0.0);
+}
@@ -0,0 +1,109 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE ChebyshevSmootherTest
+
+#include <opm/autodiff/ChebyshevSmoother.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+namespace
+{
+    typedef Dune::FieldMatrix<double,1,1> Block;
+    typedef Dune::BCRSMatrix<Block> Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double,1> > Vector;
+
+    // The 1D Laplacian, the eigenvalues of D^{-1}A are 1 - cos(k pi / (n+1)).
+    void createLaplacian(Matrix& A, const int n)
+    {
+        A.setSize(n, n, 3*n - 2);
+        A.setBuildMode(Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            const int i = row.index();
+            if (i > 0) {
+                row.insert(i - 1);
+            }
+            row.insert(i);
+            if (i < n - 1) {
+                row.insert(i + 1);
+            }
+        }
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = row->begin(); col != row->end(); ++col) {
+                *col = (col.index() == row.index()) ? 2.0 : -1.0;
+            }
+        }
+    }
+
+    // The relative error left of the k-th eigenmode after one apply.
+    double reductionOfMode(const Matrix& A, Opm::ChebyshevSmoother<Matrix,Vector,Vector>& smoother, const int k)
+    {
+        const int n = A.N();
+        Vector e(n);
+        for (int i = 0; i < n; ++i) {
+            e[i] = std::sin(k * M_PI * (i + 1) / (n + 1));
+        }
+        Vector d(n);
+        A.mv(e, d);
+        Vector v(n);
+        v = 0.0;
+        smoother.apply(v, d);
+        v -= e;
+        return v.two_norm() / e.two_norm();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(LargestEigenvalue)
+{
+    const int n = 100;
+    Matrix A;
+    createLaplacian(A, n);
+    Opm::ChebyshevSmoother<Matrix,Vector,Vector> smoother(A, 4);
+
+    const double lambdaMax = 1.0 - std::cos(n * M_PI / (n + 1));
+    BOOST_CHECK(smoother.largestEigenvalue() > 0.9 * lambdaMax);
+    BOOST_CHECK(smoother.largestEigenvalue() < 1.1 * lambdaMax);
+}
+
+BOOST_AUTO_TEST_CASE(DampsOscillatoryModes)
+{
+    const int n = 100;
+    Matrix A;
+    createLaplacian(A, n);
+    Opm::ChebyshevSmoother<Matrix,Vector,Vector> smoother(A, 4);
+
+    // the upper half of the spectrum is damped, the smoothest mode is kept
+    for (int k = n/2; k <= n; k += 5) {
+        BOOST_CHECK(reductionOfMode(A, smoother, k) < 0.45);
+    }
+    BOOST_CHECK(reductionOfMode(A, smoother, 1) > 0.99);
+}
@@ -0,0 +1,222 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE CheckpointFileTest
+
+#include <opm/autodiff/CheckpointFile.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    Opm::CheckpointFile::Chunks makeChunks(std::vector<double>& pressure, std::vector<int>& controls)
+    {
+        pressure.resize(10000);
+        for (std::size_t i = 0; i < pressure.size(); ++i) {
+            pressure[i] = 1.0e7 + (i % 100);
+        }
+        controls = { 2, -1, 0 };
+
+        Opm::CheckpointFile::Chunks chunks;
+        Opm::CheckpointFile::add(chunks, "cell.PRESSURE", pressure);
+        Opm::CheckpointFile::add(chunks, "well.currentControls", controls);
+        Opm::CheckpointFile::add(chunks, "well.names", std::string("PROD") + '\0');
+        Opm::CheckpointFile::add(chunks, "face.FACEFLUX", std::vector<double>());
+        return chunks;
+    }
+
+    void checkRoundTrip(const Opm::CheckpointFile::Compression compression, const std::size_t blockSize)
+    {
+        std::vector<double> pressure;
+        std::vector<int> controls;
+        const Opm::CheckpointFile::Chunks chunks = makeChunks(pressure, controls);
+
+        const std::string filename = Opm::CheckpointFile::filename("CASE", 1, 7);
+        Opm::CheckpointFile::write(filename, 7, chunks, compression, blockSize);
+
+        Opm::CheckpointFile checkpoint(filename);
+        BOOST_CHECK_EQUAL(checkpoint.reportStep(), 7);
+        BOOST_CHECK(checkpoint.has("cell.PRESSURE"));
+        BOOST_CHECK(!checkpoint.has("cell.SATURATION"));
+
+        std::vector<double> p(pressure.size());
+        checkpoint.read("cell.PRESSURE", p);
+        BOOST_CHECK(p == pressure);
+
+        std::vector<int> c;
+        checkpoint.read("well.currentControls", c, true);
+        BOOST_CHECK(c == controls);
+
+        std::string names;
+        checkpoint.read("well.names", names, true);
+        BOOST_CHECK(names == std::string("PROD") + '\0');
+
+        std::vector<double> flux;
+        checkpoint.read("face.FACEFLUX", flux);
+        BOOST_CHECK(flux.empty());
+
+        // the size of the simulation data has to match
+        std::vector<double> wrong(pressure.size() - 1);
+        BOOST_CHECK_THROW(checkpoint.read("cell.PRESSURE", wrong), std::logic_error);
+        BOOST_CHECK_THROW(checkpoint.chunk("cell.SATURATION"), std::runtime_error);
+
+        std::remove(filename.c_str());
+    }
+} // anonymous namespace
+
+
+BOOST_AUTO_TEST_CASE(UncompressedChunksAreMapped)
+{
+    checkRoundTrip(Opm::CheckpointFile::NoCompression, Opm::CheckpointFile::defaultBlockSize);
+    checkRoundTrip(Opm::CheckpointFile::NoCompression, 1000);
+
+    std::vector<double> pressure;
+    std::vector<int> controls;
+    const std::string filename = Opm::CheckpointFile::filename("CASE", 0, 2);
+    Opm::CheckpointFile::write(filename, 2, makeChunks(pressure, controls),
+                               Opm::CheckpointFile::NoCompression, 1000);
+
+    // the view is aligned for the values of the chunk
+    Opm::CheckpointFile checkpoint(filename);
+    const Opm::CheckpointFile::ChunkView view = checkpoint.chunk("cell.PRESSURE");
+    BOOST_CHECK_EQUAL(view.size, pressure.size() * sizeof(double));
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(view.data) % sizeof(double), 0u);
+    std::remove(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE(CompressedChunks)
+{
+    if (!Opm::CheckpointFile::compressionAvailable(Opm::CheckpointFile::ZlibCompression)) {
+        BOOST_CHECK_THROW(Opm::CheckpointFile::write("CASE.CHKP", 0, Opm::CheckpointFile::Chunks(),
+                                                     Opm::CheckpointFile::ZlibCompression),
+                          std::runtime_error);
+        return;
+    }
+    checkRoundTrip(Opm::CheckpointFile::ZlibCompression, Opm::CheckpointFile::defaultBlockSize);
+    // blocks of a size that does not divide the chunks
+    checkRoundTrip(Opm::CheckpointFile::ZlibCompression, 1000);
+    checkRoundTrip(Opm::CheckpointFile::ZlibCompression, 4);
+}
+
+
+BOOST_AUTO_TEST_CASE(DeltaCheckpoints)
+{
+    std::vector<double> pressure;
+    std::vector<int> controls;
+    const Opm::CheckpointFile::Chunks keyframeChunks = makeChunks(pressure, controls);
+
+    // a large change in the last block, and one within the tolerance
+    std::vector<double> newPressure = pressure;
+    newPressure.back() += 1.0e5;
+    newPressure[10] *= 1.0 + 1.0e-9;
+    std::vector<int> newControls = { 1, -1, 0 };
+    std::vector<double> rates = { 1.0, 2.0 };
+    Opm::CheckpointFile::Chunks chunks = keyframeChunks;
+    Opm::CheckpointFile::add(chunks, "cell.PRESSURE", newPressure);
+    Opm::CheckpointFile::add(chunks, "well.currentControls", newControls);
+    Opm::CheckpointFile::add(chunks, "well.wellRates", rates);
+
+    const Opm::CheckpointFile::Chunks delta = Opm::CheckpointFile::delta(keyframeChunks, chunks, 3, 1.0e-6);
+    BOOST_CHECK(delta.find("face.FACEFLUX") == delta.end());
+    BOOST_CHECK(delta.find("well.names") == delta.end());
+    BOOST_CHECK_EQUAL(delta.at("cell.PRESSURE").bytes.size(),
+                      pressure.size() * sizeof(double) % Opm::CheckpointFile::defaultDeltaBlockSize);
+
+    const std::string keyframeName = Opm::CheckpointFile::filename("CASE", 0, 3);
+    const std::string deltaName = Opm::CheckpointFile::filename("CASE", 0, 5);
+    Opm::CheckpointFile::write(keyframeName, 3, keyframeChunks, Opm::CheckpointFile::NoCompression);
+    Opm::CheckpointFile::write(deltaName, 5, delta, Opm::CheckpointFile::NoCompression);
+
+    Opm::CheckpointFile keyframe(keyframeName);
+    BOOST_CHECK(!keyframe.isDelta());
+    {
+        // a delta is only read with its keyframe
+        Opm::CheckpointFile checkpoint(deltaName);
+        BOOST_CHECK(checkpoint.isDelta());
+        BOOST_CHECK_EQUAL(checkpoint.keyframeStep(), 3);
+        BOOST_CHECK_THROW(checkpoint.chunk("cell.PRESSURE"), std::runtime_error);
+        BOOST_CHECK_THROW(Opm::CheckpointFile(deltaName, checkpoint), std::runtime_error);
+    }
+
+    Opm::CheckpointFile checkpoint(deltaName, keyframe);
+    BOOST_CHECK_EQUAL(checkpoint.reportStep(), 5);
+    std::vector<double> p(pressure.size());
+    checkpoint.read("cell.PRESSURE", p);
+    BOOST_CHECK_EQUAL(p.back(), newPressure.back());
+    BOOST_CHECK_EQUAL(p[10], pressure[10]);
+    for (std::size_t i = 0; i < p.size(); ++i) {
+        BOOST_CHECK_CLOSE(p[i], newPressure[i], 1.0e-4);
+    }
+
+    std::vector<int> c;
+    checkpoint.read("well.currentControls", c, true);
+    BOOST_CHECK(c == newControls);
+    std::vector<double> r;
+    checkpoint.read("well.wellRates", r, true);
+    BOOST_CHECK(r == rates);
+    std::string names;
+    checkpoint.read("well.names", names, true);
+    BOOST_CHECK(names == std::string("PROD") + '\0');
+    BOOST_CHECK(checkpoint.has("face.FACEFLUX"));
+
+    std::remove(keyframeName.c_str());
+    std::remove(deltaName.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE(InvalidFiles)
+{
+    BOOST_CHECK_THROW(Opm::CheckpointFile("no-such-checkpoint"), std::runtime_error);
+
+    const std::string filename = "invalid.CHKP";
+    {
+        std::ofstream file(filename.c_str());
+        file << "not a checkpoint";
+    }
+    BOOST_CHECK_THROW(Opm::CheckpointFile checkpoint(filename), std::runtime_error);
+
+    // a truncated checkpoint
+    std::vector<double> pressure;
+    std::vector<int> controls;
+    Opm::CheckpointFile::write(filename, 1, makeChunks(pressure, controls), Opm::CheckpointFile::NoCompression);
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    const std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    {
+        std::ofstream file(filename.c_str(), std::ios::binary);
+        file.write(contents.data(), contents.size() / 2);
+    }
+    BOOST_CHECK_THROW(Opm::CheckpointFile checkpoint(filename), std::runtime_error);
+    std::remove(filename.c_str());
+}
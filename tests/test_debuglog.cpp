@@ -0,0 +1,72 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE DebugLogTest
+
+#include <opm/autodiff/DebugLog.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+
+namespace
+{
+    int evaluations = 0;
+
+    int evaluate()
+    {
+        return ++evaluations;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(EnableTopics)
+{
+    Opm::DebugLog::enable("wells,linearsolver");
+    BOOST_CHECK(Opm::DebugLog::enabled(Opm::DebugLog::Wells));
+    BOOST_CHECK(!Opm::DebugLog::enabled(Opm::DebugLog::Newton));
+    BOOST_CHECK(Opm::DebugLog::enabled(Opm::DebugLog::LinearSolver));
+
+    Opm::DebugLog::enable("all");
+    BOOST_CHECK(Opm::DebugLog::enabled(Opm::DebugLog::Newton));
+
+    Opm::DebugLog::enable("");
+    BOOST_CHECK(!Opm::DebugLog::enabled(Opm::DebugLog::Wells));
+
+    BOOST_CHECK_THROW(Opm::DebugLog::enable("wells,solver"), std::invalid_argument);
+}
+
+
+BOOST_AUTO_TEST_CASE(DisabledMessagesAreNotEvaluated)
+{
+    evaluations = 0;
+    Opm::DebugLog::enable("newton");
+    OPM_DEBUG_LOG(Wells, "value " << evaluate());
+    BOOST_CHECK_EQUAL(evaluations, 0);
+
+    OPM_DEBUG_LOG(Newton, "value " << evaluate());
+    BOOST_CHECK_EQUAL(evaluations, 1);
+    Opm::DebugLog::enable("");
+}
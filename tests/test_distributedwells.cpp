@@ -0,0 +1,152 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE DistributedWellsTest
+
+#include <opm/autodiff/DistributedWells.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+namespace
+{
+    // The collective communication of one of several processes, the
+    // combined values of the other processes are given in the order of the
+    // reductions.
+    class Processes
+    {
+    public:
+        Processes(const int rank, const int size)
+            : rank_(rank)
+            , size_(size)
+        {
+        }
+
+        int rank() const { return rank_; }
+        int size() const { return size_; }
+
+        void expect(const std::vector<double>& remote)
+        {
+            remote_.push_back(remote);
+        }
+
+        template <class T>
+        int sum(T* values, const int n) const
+        {
+            const std::vector<double> remote = next(n);
+            for (int i = 0; i < n; ++i) {
+                values[i] += T(remote[i]);
+            }
+            return 0;
+        }
+
+        template <class T>
+        int min(T* values, const int n) const
+        {
+            const std::vector<double> remote = next(n);
+            for (int i = 0; i < n; ++i) {
+                values[i] = std::min(values[i], T(remote[i]));
+            }
+            return 0;
+        }
+
+    private:
+        std::vector<double> next(const int n) const
+        {
+            BOOST_REQUIRE(!remote_.empty());
+            const std::vector<double> remote = remote_.front();
+            remote_.pop_front();
+            BOOST_REQUIRE_EQUAL(remote.size(), std::size_t(n));
+            return remote;
+        }
+
+        int rank_;
+        int size_;
+        mutable std::deque< std::vector<double> > remote_;
+    };
+}
+
+
+BOOST_AUTO_TEST_CASE(FindDistributedWells)
+{
+    // three wells in the schedule: the first only on the other process,
+    // the second on both, the third only on this one
+    Processes comm(1, 2);
+    comm.expect({ 1.0, 1.0, 0.0 });   // the number of processes of each well
+    comm.expect({ 0.0, 0.0, 2.0 });   // the lowest rank of each well
+    Opm::DistributedWells wells;
+    wells.init({ -1, 1, 0 }, 2, comm);
+
+    BOOST_CHECK(wells.active());
+    BOOST_REQUIRE_EQUAL(wells.size(), 1);
+    BOOST_CHECK_EQUAL(wells.localWell(0), 1);
+    BOOST_CHECK(wells.isDistributed(1));
+    BOOST_CHECK(!wells.isDistributed(0));
+    // the other process has the lower rank
+    BOOST_CHECK(!wells.isOwner(1));
+    BOOST_CHECK(wells.isOwner(0));
+}
+
+
+BOOST_AUTO_TEST_CASE(SumBlocks)
+{
+    // two distributed wells among three processes, the second without
+    // perforations on this process
+    Processes comm(0, 3);
+    comm.expect({ 1.0, 2.0 });
+    comm.expect({ 1.0, 1.0 });
+    Opm::DistributedWells wells;
+    wells.init({ 0, -1 }, 1, comm);
+    BOOST_REQUIRE_EQUAL(wells.size(), 2);
+    BOOST_CHECK(wells.isOwner(0));
+    BOOST_CHECK_EQUAL(wells.localWell(1), -1);
+
+    std::vector< std::vector<double> > blocks(1, std::vector<double>{ 1.0, 2.0 });
+    comm.expect({ 10.0, 20.0, 30.0, 40.0 });
+    wells.sumBlocks(blocks, 2, comm);
+    BOOST_CHECK_EQUAL(blocks[0][0], 11.0);
+    BOOST_CHECK_EQUAL(blocks[0][1], 22.0);
+}
+
+
+BOOST_AUTO_TEST_CASE(NoDistributedWells)
+{
+    Processes comm(0, 2);
+    comm.expect({ 0.0, 1.0 });
+    comm.expect({ 2.0, 1.0 });
+    Opm::DistributedWells wells;
+    wells.init({ 0, -1 }, 1, comm);
+    BOOST_CHECK(!wells.active());
+    BOOST_CHECK(!wells.isDistributed(0));
+    BOOST_CHECK(wells.isOwner(0));
+
+    // no reduction at all
+    std::vector< std::vector<double> > blocks(1, std::vector<double>{ 1.0 });
+    wells.sumBlocks(blocks, 1, comm);
+    BOOST_CHECK_EQUAL(blocks[0][0], 1.0);
+}
@@ -0,0 +1,108 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE ElementColoringTest
+
+#include <opm/autodiff/ElementColoring.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/istl/bcrsmatrix.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <vector>
+
+namespace
+{
+    typedef Dune::FieldMatrix<double, 1, 1> Block;
+    typedef Dune::BCRSMatrix<Block> Matrix;
+
+    // the pattern of a five point stencil on an nx by ny grid
+    Matrix fivePoint(const int nx, const int ny)
+    {
+        const int n = nx * ny;
+        Matrix A(n, n, 5*n, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            const int i = row.index() % nx;
+            const int j = row.index() / nx;
+            if (j > 0)        row.insert(row.index() - nx);
+            if (i > 0)        row.insert(row.index() - 1);
+            row.insert(row.index());
+            if (i < nx - 1)   row.insert(row.index() + 1);
+            if (j < ny - 1)   row.insert(row.index() + nx);
+        }
+        A = 1.0;
+        return A;
+    }
+
+    std::vector<int> allRows(const int n)
+    {
+        std::vector<int> rows(n);
+        for (int i = 0; i < n; ++i) {
+            rows[i] = i;
+        }
+        return rows;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(NoCommonNeighbours)
+{
+    const Matrix A = fivePoint(7, 5);
+    const auto colors = Opm::distanceTwoColoring(A, allRows(A.N()));
+
+    std::vector<int> count(A.N(), 0);
+    for (const auto& rows : colors) {
+        BOOST_CHECK(!rows.empty());
+        // the stencils of the rows of one color are disjoint
+        std::set<int> written;
+        for (const int row : rows) {
+            ++count[row];
+            for (auto col = A[row].begin(); col != A[row].end(); ++col) {
+                BOOST_CHECK(written.insert(col.index()).second);
+            }
+        }
+    }
+    for (const int c : count) {
+        BOOST_CHECK_EQUAL(c, 1);
+    }
+    // a greedy coloring of the five point stencil needs few colors
+    BOOST_CHECK_LE(colors.size(), 13u);
+}
+
+
+BOOST_AUTO_TEST_CASE(SubsetOfRows)
+{
+    // a chain of six cells of which only the interior ones are colored
+    const Matrix A = fivePoint(6, 1);
+    const auto colors = Opm::distanceTwoColoring(A, { 1, 2, 3, 4 });
+
+    // cells at a distance of three share a color
+    BOOST_REQUIRE_EQUAL(colors.size(), 3u);
+    BOOST_CHECK((colors[0] == std::vector<int>{ 1, 4 }));
+    BOOST_CHECK((colors[1] == std::vector<int>{ 2 }));
+    BOOST_CHECK((colors[2] == std::vector<int>{ 3 }));
+}
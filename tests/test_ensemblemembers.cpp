@@ -0,0 +1,70 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE EnsembleMembersTest
+
+#include <opm/autodiff/EnsembleMembers.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+BOOST_AUTO_TEST_CASE(ReadMembers)
+{
+    std::istringstream input("# name overrides\n"
+                             "real-001  tolerance_cnv=0.02 solver_approach=interleaved\n"
+                             "\n"
+                             "   real-002   # no overrides\n"
+                             "real-003 output_dir=\n");
+    const Opm::EnsembleMembers members(input, "test");
+
+    BOOST_REQUIRE_EQUAL(members.size(), 3u);
+    BOOST_CHECK_EQUAL(members[0].name, "real-001");
+    BOOST_CHECK_EQUAL(members[0].overrides.size(), 2u);
+    BOOST_CHECK_EQUAL(members[0].overrides.at("tolerance_cnv"), "0.02");
+    BOOST_CHECK_EQUAL(members[0].overrides.at("solver_approach"), "interleaved");
+    BOOST_CHECK_EQUAL(members[1].name, "real-002");
+    BOOST_CHECK(members[1].overrides.empty());
+    BOOST_CHECK_EQUAL(members[2].overrides.at("output_dir"), "");
+}
+
+BOOST_AUTO_TEST_CASE(MalformedLines)
+{
+    std::istringstream duplicate("a\nb\na\n");
+    BOOST_CHECK_THROW(Opm::EnsembleMembers(duplicate, "test"), std::runtime_error);
+
+    std::istringstream noName("tolerance_cnv=0.02\n");
+    BOOST_CHECK_THROW(Opm::EnsembleMembers(noName, "test"), std::runtime_error);
+
+    std::istringstream noValue("a tolerance_cnv\n");
+    BOOST_CHECK_THROW(Opm::EnsembleMembers(noValue, "test"), std::runtime_error);
+
+    std::istringstream noKey("a =1\n");
+    BOOST_CHECK_THROW(Opm::EnsembleMembers(noKey, "test"), std::runtime_error);
+
+    BOOST_CHECK_THROW(Opm::EnsembleMembers("no_such_ensemble_file.txt"), std::runtime_error);
+}
@@ -0,0 +1,98 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE ForcingTermTest
+
+#include <opm/autodiff/NonlinearSolver.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    // the forcing term does not refer to the model
+    struct DummyModel
+    {
+        typedef int ReservoirState;
+        typedef int WellState;
+    };
+
+    typedef Opm::NonlinearSolver<DummyModel> Solver;
+
+    Solver solver(const Solver::SolverParameters& param = Solver::SolverParameters())
+    {
+        return Solver(param, std::unique_ptr<DummyModel>(new DummyModel));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(FirstIterationUsesMaximum)
+{
+    const Solver s = solver();
+    const std::vector<std::vector<double>> history = { { 1.0, 2.0 } };
+    BOOST_CHECK_EQUAL(s.forcingTerm(history, 0, 0.5), s.forcingMax());
+}
+
+
+BOOST_AUTO_TEST_CASE(FollowsResidualReduction)
+{
+    const Solver s = solver();
+    // the largest norm drops from 2 to 0.2
+    const std::vector<std::vector<double>> history = { { 1.0, 2.0 }, { 0.2, 0.1 } };
+    BOOST_CHECK_CLOSE(s.forcingTerm(history, 1, 0.1), 0.9 * 0.01, 1e-12);
+
+    // slow reduction is capped by the maximum
+    const std::vector<std::vector<double>> slow = { { 1.0 }, { 0.9 } };
+    BOOST_CHECK_EQUAL(s.forcingTerm(slow, 1, 0.1), 0.1);
+}
+
+
+BOOST_AUTO_TEST_CASE(Safeguard)
+{
+    Solver::SolverParameters param;
+    param.forcing_max_ = 0.9;
+    const Solver s = solver(param);
+
+    // a large previous term limits the decrease to gamma previous^alpha
+    const std::vector<std::vector<double>> history = { { 1.0 }, { 0.01 } };
+    BOOST_CHECK_CLOSE(s.forcingTerm(history, 1, 0.9), 0.9 * 0.81, 1e-12);
+
+    // but not once that is below 0.1
+    BOOST_CHECK_CLOSE(s.forcingTerm(history, 1, 0.3), 0.9 * 1e-4, 1e-12);
+}
+
+
+BOOST_AUTO_TEST_CASE(InvalidNormsUseMaximum)
+{
+    const Solver s = solver();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const std::vector<std::vector<double>> zero = { { 0.0 }, { 0.0 } };
+    BOOST_CHECK_EQUAL(s.forcingTerm(zero, 1, 0.01), s.forcingMax());
+    const std::vector<std::vector<double>> notFinite = { { 1.0 }, { nan } };
+    BOOST_CHECK_EQUAL(s.forcingTerm(notFinite, 1, 0.01), s.forcingMax());
+}
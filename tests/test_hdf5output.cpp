@@ -0,0 +1,202 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE Hdf5OutputTest
+
+#include <opm/autodiff/Hdf5Output.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#if HAVE_HDF5
+#include <hdf5.h>
+
+namespace
+{
+    // The dimensions and values of a dataset of doubles.
+    std::vector<double> readDataset(const std::string& filename, const std::string& name,
+                                    std::vector<hsize_t>& dims)
+    {
+        const hid_t file = H5Fopen(filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+        BOOST_REQUIRE(file >= 0);
+        const hid_t dataset = H5Dopen2(file, name.c_str(), H5P_DEFAULT);
+        BOOST_REQUIRE(dataset >= 0);
+        const hid_t space = H5Dget_space(dataset);
+        dims.resize(H5Sget_simple_extent_ndims(space));
+        H5Sget_simple_extent_dims(space, dims.data(), nullptr);
+        std::vector<double> values(H5Sget_simple_extent_npoints(space));
+        if (!values.empty()) {
+            H5Dread(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data());
+        }
+        H5Sclose(space);
+        H5Dclose(dataset);
+        H5Fclose(file);
+        return values;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(WriteAndRead)
+{
+    const std::string filename = "test_hdf5output.h5";
+    {
+        Opm::Hdf5Output output(filename, 1);
+        output.beginStep(3, 86400.0);
+        output.write("state/PRESSURE", std::vector<double>{ 1.0, 2.0, 3.0 });
+        output.write("state/SATURATION", std::vector<double>{ 0.2, 0.8, 0.3, 0.7, 0.4, 0.6 }, 2);
+        output.write("wells/bhp", std::vector<double>());
+        output.write("wells/name", std::vector<std::string>{ "PROD", "INJ" });
+        output.endStep();
+    }
+
+    std::vector<hsize_t> dims;
+    const std::vector<double> pressure = readDataset(filename, "report_step_0003/state/PRESSURE", dims);
+    BOOST_REQUIRE_EQUAL(dims.size(), 1);
+    BOOST_CHECK_EQUAL(dims[0], 3);
+    BOOST_CHECK_EQUAL(pressure[2], 3.0);
+
+    const std::vector<double> saturation = readDataset(filename, "report_step_0003/state/SATURATION", dims);
+    BOOST_REQUIRE_EQUAL(dims.size(), 2);
+    BOOST_CHECK_EQUAL(dims[0], 3);
+    BOOST_CHECK_EQUAL(dims[1], 2);
+    BOOST_CHECK_EQUAL(saturation[3], 0.7);
+
+    // no wells on any process
+    const std::vector<double> bhp = readDataset(filename, "report_step_0003/wells/bhp", dims);
+    BOOST_CHECK(bhp.empty());
+
+    std::remove(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE(ReducedPrecision)
+{
+    const std::string filename = "test_hdf5output_precision.h5";
+    {
+        Opm::Hdf5Output output(filename, 1, Opm::OutputPrecision("SWAT=0.0005, PRESSURE=float"));
+        output.beginStep(1, 0.0);
+        output.write("cells/SWAT", std::vector<double>{ 0.2, 0.30012, 1.0 });
+        output.write("cells/PRESSURE", std::vector<double>{ 2.0e7, 2.5e7, 3.0e7 });
+        // does not fit the quantization, written as doubles
+        output.write("cells/SWAT_BIG", std::vector<double>{ 1.0e10 });
+        output.endStep();
+    }
+
+    const hid_t file = H5Fopen(filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    BOOST_REQUIRE(file >= 0);
+    const hid_t swat = H5Dopen2(file, "report_step_0001/cells/SWAT", H5P_DEFAULT);
+    const hid_t swatType = H5Dget_type(swat);
+    BOOST_CHECK(H5Tget_class(swatType) == H5T_INTEGER);
+    H5Tclose(swatType);
+    double scale = 0.0;
+    const hid_t attribute = H5Aopen(swat, "scale_factor", H5P_DEFAULT);
+    H5Aread(attribute, H5T_NATIVE_DOUBLE, &scale);
+    H5Aclose(attribute);
+    BOOST_CHECK_CLOSE(scale, 0.001, 1e-10);
+    H5Dclose(swat);
+
+    const hid_t pressure = H5Dopen2(file, "report_step_0001/cells/PRESSURE", H5P_DEFAULT);
+    const hid_t pressureType = H5Dget_type(pressure);
+    BOOST_CHECK_EQUAL(H5Tget_size(pressureType), sizeof(float));
+    H5Tclose(pressureType);
+    H5Dclose(pressure);
+    H5Fclose(file);
+
+    std::vector<hsize_t> dims;
+    // converted by the library when read as doubles
+    const std::vector<double> quantized = readDataset(filename, "report_step_0001/cells/SWAT", dims);
+    BOOST_CHECK_EQUAL(quantized[1], 300.0);
+    const std::vector<double> big = readDataset(filename, "report_step_0001/cells/SWAT_BIG", dims);
+    BOOST_CHECK_EQUAL(big[0], 1.0e10);
+
+    std::remove(filename.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE(ReplaceStep)
+{
+    const std::string filename = "test_hdf5output_replace.h5";
+    {
+        Opm::Hdf5Output output(filename, 0);
+        output.beginStep(0, 0.0);
+        output.write("state/PRESSURE", std::vector<double>{ 1.0 });
+        output.endStep();
+        output.beginStep(0, 0.0);
+        output.write("state/PRESSURE", std::vector<double>{ 5.0 });
+        output.endStep();
+    }
+
+    std::vector<hsize_t> dims;
+    const std::vector<double> pressure = readDataset(filename, "report_step_0000/state/PRESSURE", dims);
+    BOOST_REQUIRE_EQUAL(pressure.size(), 1);
+    BOOST_CHECK_EQUAL(pressure[0], 5.0);
+
+    std::remove(filename.c_str());
+}
+
+#else
+
+BOOST_AUTO_TEST_CASE(NotAvailable)
+{
+    BOOST_CHECK(!Opm::Hdf5Output::available());
+    BOOST_CHECK_THROW(Opm::Hdf5Output("test_hdf5output.h5", 1), std::runtime_error);
+}
+
+#endif
+
+BOOST_AUTO_TEST_CASE(ParsePrecision)
+{
+    const Opm::OutputPrecision precision("SWAT=1e-4, cells/RS=float,*=float, state/PRESSURE=double");
+    BOOST_CHECK(precision.field("cells/SWAT").type == Opm::OutputPrecision::Quantized);
+    BOOST_CHECK_EQUAL(precision.field("SWAT").tolerance, 1e-4);
+    BOOST_CHECK(precision.field("cells/RS").type == Opm::OutputPrecision::Float);
+    BOOST_CHECK(precision.field("state/PRESSURE").type == Opm::OutputPrecision::Double);
+    BOOST_CHECK(precision.field("cells/PRESSURE").type == Opm::OutputPrecision::Float);
+    BOOST_CHECK(Opm::OutputPrecision().field("SWAT").type == Opm::OutputPrecision::Double);
+
+    BOOST_CHECK_THROW(Opm::OutputPrecision("SWAT"), std::runtime_error);
+    BOOST_CHECK_THROW(Opm::OutputPrecision("SWAT=half"), std::runtime_error);
+    BOOST_CHECK_THROW(Opm::OutputPrecision("SWAT=-1"), std::runtime_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(Quantize)
+{
+    std::vector<int> quantized;
+    BOOST_CHECK(Opm::OutputPrecision::quantize({ 0.0, 0.1234, -0.5 }, 0.005, quantized));
+    BOOST_CHECK_EQUAL(quantized[1], 12);
+    BOOST_CHECK_EQUAL(quantized[2], -50);
+    BOOST_CHECK(!Opm::OutputPrecision::quantize({ 1.0e20 }, 0.005, quantized));
+}
+
+
+BOOST_AUTO_TEST_CASE(GroupName)
+{
+    BOOST_CHECK_EQUAL(Opm::Hdf5Output::groupName(12), "report_step_0012");
+}
@@ -0,0 +1,82 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE IndexedLinearTableTest
+
+#include <opm/polymer/IndexedLinearTable.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+namespace {
+    // Last interval whose start is not above x, by a linear search.
+    int referenceInterval(const std::vector<double>& x, const double value)
+    {
+        int i = 0;
+        while (i < int(x.size()) - 2 && x[i + 1] <= value) {
+            ++i;
+        }
+        return i;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MatchesTableInterpolation)
+{
+    // strongly non-uniform spacing, as in PLYVISC tables
+    const std::vector<double> x = { 0.0, 0.01, 0.02, 0.5, 0.51, 3.0 };
+    const std::vector<double> y = { 1.0, 2.0, 2.5, 10.0, 10.2, 40.0 };
+    const Opm::detail::IndexedLinearTable table(x, y);
+
+    std::vector<double> points = x;
+    for (double value = -1.0; value < 4.0; value += 0.0037) {
+        points.push_back(value);
+    }
+
+    for (const double value : points) {
+        const int i = referenceInterval(x, value);
+        BOOST_CHECK_EQUAL(table.interval(value), i);
+
+        const double slope = (y[i + 1] - y[i]) / (x[i + 1] - x[i]);
+        double derivative = 0.0;
+        const double f = table.evaluate(value, derivative);
+        BOOST_CHECK_EQUAL(derivative, slope);
+        BOOST_CHECK_EQUAL(f, slope * (value - x[i]) + y[i]);
+        BOOST_CHECK_EQUAL(table(value), f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TablePointsAreExact)
+{
+    const std::vector<double> x = { 1.0, 2.0, 7.0, 7.5 };
+    const std::vector<double> y = { 0.0, 0.3, 0.35, 0.36 };
+    const Opm::detail::IndexedLinearTable table(x, y);
+
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        BOOST_CHECK_EQUAL(table(x[i]), y[i]);
+    }
+    BOOST_CHECK(Opm::detail::IndexedLinearTable().empty());
+    BOOST_CHECK(!table.empty());
+}
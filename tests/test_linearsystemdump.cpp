@@ -0,0 +1,206 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE LinearSystemDumpTest
+
+#include <opm/autodiff/LinearSystemDump.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    typedef Dune::FieldMatrix<double, 3, 3> Block;
+    typedef Dune::FieldVector<double, 3> VectorBlock;
+    typedef Opm::LinearSystemDump<Block, VectorBlock> System;
+    typedef System::Matrix Matrix;
+    typedef System::Vector Vector;
+
+    const int numCells = 5;
+
+    // a tridiagonal matrix of the cells
+    Matrix cellMatrix()
+    {
+        Matrix A(numCells, numCells, 3*numCells - 2, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            const int c = row.index();
+            for (int j = std::max(c - 1, 0); j <= std::min(c + 1, numCells - 1); ++j) {
+                row.insert(j);
+            }
+        }
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = row->begin(); col != row->end(); ++col) {
+                for (int i = 0; i < 3; ++i) {
+                    for (int j = 0; j < 3; ++j) {
+                        (*col)[i][j] = std::sin(1.0 + row.index() + 2*col.index() + 3*i + j);
+                    }
+                }
+            }
+        }
+        return A;
+    }
+
+    // two wells, the first perforating cells 0 and 3, the second cell 4
+    System system()
+    {
+        System s;
+        s.A = cellMatrix();
+        s.b.resize(numCells);
+        for (int c = 0; c < numCells; ++c) {
+            for (int i = 0; i < 3; ++i) {
+                s.b[c][i] = std::cos(0.5 * c + i);
+            }
+        }
+
+        const int wellStart[] = { 0, 2, 3 };
+        const int cells[] = { 0, 3, 4 };
+        s.B.init(2, wellStart, cells);
+        s.C.init(2, wellStart, cells);
+        for (int perf = 0; perf < 3; ++perf) {
+            for (int i = 0; i < 3; ++i) {
+                for (int j = 0; j < 3; ++j) {
+                    s.B[perf][i][j] = std::sin(2.0 + perf + 3*i + j);
+                    s.C[perf][i][j] = std::cos(3.0 + perf + 3*i + j);
+                }
+            }
+        }
+
+        s.invD.setBuildMode(Matrix::row_wise);
+        s.invD.setSize(2, 2, 2);
+        for (auto row = s.invD.createbegin(); row != s.invD.createend(); ++row) {
+            row.insert(row.index());
+        }
+        s.invD[0][0] = 0.0;
+        s.invD[1][1] = 0.0;
+        for (int i = 0; i < 3; ++i) {
+            s.invD[0][0][i][i] = 2.0;
+            s.invD[1][1][i][i] = 0.5;
+        }
+        s.explicitWell = { false, true };
+        s.newtonIteration = 3;
+        s.linearSolve = 17;
+        return s;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(RoundTrip)
+{
+    const System original = system();
+    const std::string filename = "test_linearsystemdump.bin";
+    Opm::writeLinearSystem(filename, original.A, original.b, original.B, original.C,
+                           original.invD, original.explicitWell,
+                           original.newtonIteration, original.linearSolve);
+
+    BOOST_CHECK_EQUAL(Opm::readLinearSystemBlockSize(filename), 3);
+
+    System read;
+    Opm::readLinearSystem(filename, read);
+    std::remove(filename.c_str());
+
+    BOOST_CHECK_EQUAL(read.newtonIteration, 3);
+    BOOST_CHECK_EQUAL(read.linearSolve, 17);
+    BOOST_REQUIRE_EQUAL(read.A.N(), original.A.N());
+    BOOST_REQUIRE_EQUAL(read.A.nonzeroes(), original.A.nonzeroes());
+    for (auto row = original.A.begin(); row != original.A.end(); ++row) {
+        for (auto col = row->begin(); col != row->end(); ++col) {
+            BOOST_REQUIRE(read.A.exists(row.index(), col.index()));
+            Block diff = read.A[row.index()][col.index()];
+            diff -= *col;
+            BOOST_CHECK_EQUAL(diff.frobenius_norm(), 0.0);
+        }
+    }
+    BOOST_REQUIRE_EQUAL(read.b.size(), original.b.size());
+    BOOST_CHECK_EQUAL((Vector(read.b) -= original.b).two_norm(), 0.0);
+    BOOST_REQUIRE_EQUAL(read.B.numPerforations(), 3);
+    BOOST_REQUIRE_EQUAL(read.C.numWells(), 2);
+    BOOST_CHECK_EQUAL(read.C.wellEnd(0), 2);
+    BOOST_CHECK_EQUAL(read.C.cell(2), 4);
+    BOOST_CHECK(read.explicitWell == original.explicitWell);
+
+    // the read system is the same operator
+    Vector x(numCells);
+    for (int c = 0; c < numCells; ++c) {
+        for (int i = 0; i < 3; ++i) {
+            x[c][i] = 1.0 + c - i;
+        }
+    }
+    Vector y1(numCells), y2(numCells);
+    original.A.mv(x, y1);
+    original.applyWells(x, y1);
+    read.A.mv(x, y2);
+    read.applyWells(x, y2);
+    BOOST_CHECK_EQUAL((y1 -= y2).two_norm(), 0.0);
+}
+
+
+BOOST_AUTO_TEST_CASE(ApplyWellsSkipsExplicitWells)
+{
+    System s = system();
+    Vector x(numCells);
+    x = 1.0;
+
+    // y = -B^T inv(D) C x of the first well only
+    Vector y(numCells);
+    y = 0.0;
+    s.applyWells(x, y);
+
+    VectorBlock cx(0.0);
+    for (int perf = 0; perf < 2; ++perf) {
+        s.C[perf].umv(x[s.C.cell(perf)], cx);
+    }
+    VectorBlock invDCx(0.0);
+    s.invD[0][0].umv(cx, invDCx);
+    Vector expected(numCells);
+    expected = 0.0;
+    for (int perf = 0; perf < 2; ++perf) {
+        s.B[perf].mmtv(invDCx, expected[s.B.cell(perf)]);
+    }
+    BOOST_CHECK_SMALL((y -= expected).two_norm(), 1e-14);
+}
+
+
+BOOST_AUTO_TEST_CASE(RejectsOtherFiles)
+{
+    const std::string filename = "test_linearsystemdump_invalid.bin";
+    {
+        std::ofstream os(filename.c_str());
+        os << "not a linear system";
+    }
+    BOOST_CHECK_THROW(Opm::readLinearSystemBlockSize(filename), std::runtime_error);
+
+    System s;
+    BOOST_CHECK_THROW(Opm::readLinearSystem(filename, s), std::runtime_error);
+    std::remove(filename.c_str());
+}
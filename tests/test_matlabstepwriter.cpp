@@ -0,0 +1,129 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE MatlabStepWriterTest
+
+#include <opm/autodiff/MatlabStepWriter.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::string readFile(const std::string& filename)
+    {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        BOOST_REQUIRE(file);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    struct OutputDir
+    {
+        OutputDir()
+            : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+        {
+        }
+
+        ~OutputDir()
+        {
+            boost::filesystem::remove_all(path);
+        }
+
+        boost::filesystem::path path;
+    };
+}
+
+
+BOOST_AUTO_TEST_CASE(Text)
+{
+    OutputDir dir;
+    Opm::MatlabStepWriter writer(dir.path.string(), 7);
+    writer.write("pressure", { 1.5, 2.5 });
+    writer.finish();
+
+    BOOST_CHECK_EQUAL(readFile((dir.path / "pressure" / "007.txt").string()), "1.5\n2.5\n");
+    BOOST_CHECK(!boost::filesystem::exists(dir.path / "index"));
+}
+
+
+BOOST_AUTO_TEST_CASE(Npy)
+{
+    OutputDir dir;
+    Opm::MatlabStepWriter writer(dir.path.string(), 3, Opm::MatlabStepWriter::Npy);
+    const std::vector<double> saturation = { 0.2, 0.8, 0.3, 0.7, 0.4, 0.6 };
+    writer.write("saturation", saturation, 2);
+    writer.finish();
+
+    const std::string npy = readFile((dir.path / "saturation" / "003.npy").string());
+    BOOST_REQUIRE(npy.size() > 10);
+    BOOST_CHECK_EQUAL(npy.substr(0, 6), "\x93NUMPY");
+    // the header length of version 1.0, little endian, the data is aligned
+    // to 64 bytes
+    const std::size_t headerSize = 10 + int((unsigned char)(npy[8])) + 256 * int((unsigned char)(npy[9]));
+    BOOST_CHECK_EQUAL(headerSize % 64, 0);
+    BOOST_REQUIRE_EQUAL(npy.size(), headerSize + saturation.size() * sizeof(double));
+    BOOST_CHECK(npy.find("'shape': (3, 2), }") != std::string::npos);
+    BOOST_CHECK_EQUAL(npy[headerSize - 1], '\n');
+    double last = 0.0;
+    std::copy(npy.end() - sizeof(double), npy.end(), reinterpret_cast<char*>(&last));
+    BOOST_CHECK_EQUAL(last, 0.6);
+
+    const std::string index = readFile((dir.path / "index" / "003.txt").string());
+    BOOST_CHECK(index.find("saturation saturation/003.npy") != std::string::npos);
+    BOOST_CHECK(index.find("f8 3 2 " + std::to_string(headerSize) + "\n") != std::string::npos);
+}
+
+
+BOOST_AUTO_TEST_CASE(RawSinglePrecision)
+{
+    OutputDir dir;
+    Opm::MatlabStepWriter writer(dir.path.string(), 12, Opm::MatlabStepWriter::Raw, true);
+    writer.write("pressure", { 1.0, 2.0, 3.0 });
+    writer.write("bhp", { 4.0 });
+    writer.finish();
+
+    const std::string raw = readFile((dir.path / "raw" / "012.bin").string());
+    BOOST_REQUIRE_EQUAL(raw.size(), 4 * sizeof(float));
+    float bhp = 0.0;
+    std::copy(raw.begin() + 3 * sizeof(float), raw.end(), reinterpret_cast<char*>(&bhp));
+    BOOST_CHECK_EQUAL(bhp, 4.0f);
+
+    const std::string index = readFile((dir.path / "index" / "012.txt").string());
+    BOOST_CHECK(index.find("bhp raw/012.bin") != std::string::npos);
+    BOOST_CHECK(index.find("f4 1 1 12\n") != std::string::npos);
+}
+
+
+BOOST_AUTO_TEST_CASE(UnknownFormat)
+{
+    BOOST_CHECK_EQUAL(Opm::MatlabStepWriter::encoding("npy"), Opm::MatlabStepWriter::Npy);
+    BOOST_CHECK_THROW(Opm::MatlabStepWriter::encoding("csv"), std::runtime_error);
+}
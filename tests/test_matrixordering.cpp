@@ -0,0 +1,119 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE MatrixOrderingTest
+
+#include <opm/autodiff/MatrixOrdering.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+namespace
+{
+    typedef std::vector< std::vector<int> > Pattern;
+
+    // the 5-point stencil of an nx by ny grid
+    Pattern fivePointStencil(const int nx, const int ny)
+    {
+        Pattern rows(nx * ny);
+        for (int j = 0; j < ny; ++j) {
+            for (int i = 0; i < nx; ++i) {
+                auto& row = rows[j*nx + i];
+                if (j > 0)      row.push_back((j-1)*nx + i);
+                if (i > 0)      row.push_back(j*nx + i - 1);
+                row.push_back(j*nx + i);
+                if (i < nx - 1) row.push_back(j*nx + i + 1);
+                if (j < ny - 1) row.push_back((j+1)*nx + i);
+            }
+        }
+        return rows;
+    }
+
+    // no row has two columns of the same color
+    void checkColoring(const Pattern& rows, const std::vector<int>& color, const std::size_t numColors)
+    {
+        for (const auto& row : rows) {
+            std::vector<bool> used(numColors, false);
+            for (const int j : row) {
+                BOOST_REQUIRE(std::size_t(color[j]) < numColors);
+                BOOST_CHECK(!used[color[j]]);
+                used[color[j]] = true;
+            }
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(DistanceTwoColoringOfChain)
+{
+    // the 3-point stencil needs three colors, repeated along the chain
+    Pattern rows(7);
+    for (int i = 0; i < 7; ++i) {
+        for (int j = std::max(i - 1, 0); j <= std::min(i + 1, 6); ++j) {
+            rows[i].push_back(j);
+        }
+    }
+    std::vector<int> color;
+    const std::size_t numColors = Opm::distanceTwoColoring(rows, 7, color);
+    BOOST_CHECK_EQUAL(numColors, 3);
+    BOOST_REQUIRE_EQUAL(color.size(), 7);
+    for (int i = 0; i < 7; ++i) {
+        BOOST_CHECK_EQUAL(color[i], i % 3);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(DistanceTwoColoringOfGrid)
+{
+    const Pattern rows = fivePointStencil(6, 5);
+    std::vector<int> color;
+    const std::size_t numColors = Opm::distanceTwoColoring(rows, 30, color);
+    checkColoring(rows, color, numColors);
+    // at least the 5 columns of an interior row, far fewer than the columns
+    BOOST_CHECK(numColors >= 5);
+    BOOST_CHECK(numColors <= 9);
+}
+
+
+BOOST_AUTO_TEST_CASE(DistanceTwoColoringOfWellRow)
+{
+    // a chain of four cells and a well perforating the first and the last
+    // cell, the well is the column 4 and the row 4
+    Pattern rows(5);
+    for (int i = 0; i < 4; ++i) {
+        for (int j = std::max(i - 1, 0); j <= std::min(i + 1, 3); ++j) {
+            rows[i].push_back(j);
+        }
+    }
+    rows[0].push_back(4);
+    rows[3].push_back(4);
+    rows[4] = { 0, 3, 4 };
+
+    std::vector<int> color;
+    const std::size_t numColors = Opm::distanceTwoColoring(rows, 5, color);
+    checkColoring(rows, color, numColors);
+    BOOST_CHECK(color[0] != color[3]);
+}
@@ -0,0 +1,81 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE MetricsExporterTest
+
+#include <opm/simulators/MetricsExporter.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+namespace
+{
+    const double day = 86400.0;
+
+    bool contains(const std::string& text, const std::string& line)
+    {
+        return text.find(line + "\n") != std::string::npos;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(PrometheusText)
+{
+    Opm::MetricsExporter exporter("", "", "NORNE");
+    exporter.recordStep(2.0 * day, 10.0 * day, 1.0 * day, 3, true, 4, 40);
+    exporter.recordStep(2.0 * day, 10.0 * day, 0.5 * day, 3, false, 8, 100);
+
+    const std::string text = exporter.prometheusText();
+    BOOST_CHECK(contains(text, "# TYPE flow_timestep_failures_total counter"));
+    BOOST_CHECK(contains(text, "flow_simulated_days{case=\"NORNE\"} 2"));
+    BOOST_CHECK(contains(text, "flow_total_days{case=\"NORNE\"} 10"));
+    BOOST_CHECK(contains(text, "flow_timestep_days{case=\"NORNE\"} 0.5"));
+    BOOST_CHECK(contains(text, "flow_report_step{case=\"NORNE\"} 3"));
+    BOOST_CHECK(contains(text, "flow_timesteps_total{case=\"NORNE\"} 1"));
+    BOOST_CHECK(contains(text, "flow_timestep_failures_total{case=\"NORNE\"} 1"));
+    BOOST_CHECK(contains(text, "flow_newton_iterations_total{case=\"NORNE\"} 12"));
+    BOOST_CHECK(contains(text, "flow_linear_iterations_total{case=\"NORNE\"} 140"));
+    BOOST_CHECK(contains(text, "flow_newton_iterations_last_step{case=\"NORNE\"} 8"));
+}
+
+
+BOOST_AUTO_TEST_CASE(StatsdText)
+{
+    Opm::MetricsExporter exporter("", "", "SPE1");
+    exporter.recordStep(1.0 * day, 10.0 * day, 1.0 * day, 0, true, 3, 20);
+
+    const std::string text = exporter.statsdText();
+    BOOST_CHECK(contains(text, "flow.SPE1.simulated_days:1|g"));
+    BOOST_CHECK(contains(text, "flow.SPE1.timestep_failures:0|g"));
+    BOOST_CHECK(contains(text, "flow.SPE1.linear_iterations_last_step:20|g"));
+}
+
+
+BOOST_AUTO_TEST_CASE(InvalidAddress)
+{
+    BOOST_CHECK_THROW(Opm::MetricsExporter("", "localhost", "SPE1"), std::runtime_error);
+}
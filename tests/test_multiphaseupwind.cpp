@@ -106,3 +106,29 @@ BOOST_AUTO_TEST_CASE(GravityColumnHighFlux)
     BOOST_CHECK_EQUAL(upw[1], expected_upw[1]);
     BOOST_CHECK_EQUAL(upw[2], expected_upw[2]);
 }
+
+
+BOOST_AUTO_TEST_CASE(AllConnections)
+{
+    // Cases 1-3 as three connections of a column of four cells,
+    // the second connection pointing upwards.
+
+    const int num_connections = 3;
+    const int connection_cells[] = { 0, 1,  2, 1,  2, 3 };
+    const double gd[3][3] = {{ 4.0, -4.0, 4.0 }, { -1.0, 1.0, -1.0 }, { -2.0, 2.0, -2.0 }};
+    const double mob[4] = { 1.0, 1.0, 1.0, 1.0 };
+    const double transmissibility[] = { 1.0, 1.0, 1.0 };
+    const double flux[] = { 1.0, -5.0, 10.0 };
+
+    double upw[3][3];
+    Opm::multiPhaseUpwind(num_connections, connection_cells,
+                          {{ gd[0], gd[1], gd[2] }}, {{ mob, mob, mob }},
+                          transmissibility, flux, {{ upw[0], upw[1], upw[2] }});
+
+    const double expected_upw[3][3] = {{ 1.0, -1.0, 1.0 }, { -1.0, -1.0, 1.0 }, { -1.0, 1.0, 1.0 }};
+    for (int phase = 0; phase < 3; ++phase) {
+        for (int conn = 0; conn < num_connections; ++conn) {
+            BOOST_CHECK_EQUAL(upw[phase][conn], expected_upw[phase][conn]);
+        }
+    }
+}
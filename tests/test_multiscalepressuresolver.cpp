@@ -0,0 +1,135 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE MultiscalePressureSolverTest
+
+#include <opm/autodiff/MultiscalePressureSolver.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    typedef Opm::MultiscalePressureSolver::Matrix Matrix;
+    typedef Opm::MultiscalePressureSolver::Vector Vector;
+
+    // Two-point pressure matrix on a nx by ny grid with a log-normal like
+    // permeability variation, the mobility multiplies the transmissibilities
+    // and a small accumulation term keeps it nonsingular.
+    Matrix pressureMatrix(const int nx, const int ny, const double mobility = 1.0)
+    {
+        const int n = nx * ny;
+        std::vector<double> perm(n);
+        for (int c = 0; c < n; ++c) {
+            perm[c] = std::exp(std::sin(0.7 * (c % nx)) + std::cos(1.3 * (c / nx)));
+        }
+        std::vector<Eigen::Triplet<double>> entries;
+        for (int c = 0; c < n; ++c) {
+            const int i = c % nx;
+            const int j = c / nx;
+            double diagonal = 1e-3;
+            const int neighbours[4] = { i > 0 ? c - 1 : -1, i < nx - 1 ? c + 1 : -1,
+                                        j > 0 ? c - nx : -1, j < ny - 1 ? c + nx : -1 };
+            for (const int k : neighbours) {
+                if (k >= 0) {
+                    const double t = mobility * 2.0 * perm[c] * perm[k] / (perm[c] + perm[k]);
+                    entries.push_back(Eigen::Triplet<double>(c, k, -t));
+                    diagonal += t;
+                }
+            }
+            entries.push_back(Eigen::Triplet<double>(c, c, diagonal));
+        }
+        Matrix A(n, n);
+        A.setFromTriplets(entries.begin(), entries.end());
+        return A;
+    }
+
+    // The number of iterations of the preconditioned Richardson iteration
+    // x += M^{-1} (b - A x) to reduce the residual by 1e-6.
+    int richardsonIterations(const Matrix& A, const Opm::MultiscalePressureSolver& solver)
+    {
+        // a source and a sink in the corners
+        Vector b = Vector::Zero(A.rows());
+        b[0] = 1.0;
+        b[A.rows() - 1] = -1.0;
+        Vector x = Vector::Zero(A.rows());
+        Vector dx;
+        int it = 0;
+        while ((b - A * x).norm() > 1e-6 * b.norm() && it < 500) {
+            solver.apply(b - A * x, dx);
+            x += dx;
+            ++it;
+        }
+        return it;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(PartitionOfUnity)
+{
+    const Matrix A = pressureMatrix(20, 20);
+    Opm::MultiscalePressureSolver solver(16, 100, 1e-3, 0.2, 1);
+    solver.setup(A);
+    BOOST_CHECK_GT(solver.numBlocks(), 10);
+    BOOST_CHECK_LT(solver.numBlocks(), 40);
+    BOOST_CHECK_EQUAL(solver.smoothedBases(), solver.numBlocks());
+
+    const Vector rowSums = solver.prolongation() * Vector::Ones(solver.numBlocks());
+    for (int i = 0; i < rowSums.size(); ++i) {
+        BOOST_CHECK_CLOSE(rowSums[i], 1.0, 1e-10);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(ConvergesAsPreconditioner)
+{
+    const Matrix A = pressureMatrix(20, 20);
+    Opm::MultiscalePressureSolver solver(16, 100, 1e-3, 0.2, 2);
+    solver.setup(A);
+    BOOST_CHECK_LT(richardsonIterations(A, solver), 150);
+}
+
+
+BOOST_AUTO_TEST_CASE(LazyUpdate)
+{
+    Opm::MultiscalePressureSolver solver(16, 100, 1e-3, 0.2, 2);
+    solver.setup(pressureMatrix(20, 20));
+
+    // a small change of the mobility keeps all basis functions
+    solver.update(pressureMatrix(20, 20, 1.1));
+    BOOST_CHECK_EQUAL(solver.smoothedBases(), 0);
+
+    // a large one smooths all of them again
+    const Matrix A = pressureMatrix(20, 20, 3.0);
+    solver.update(A);
+    BOOST_CHECK_EQUAL(solver.smoothedBases(), solver.numBlocks());
+    BOOST_CHECK_LT(richardsonIterations(A, solver), 150);
+
+    // a new grid is set up from scratch
+    solver.update(pressureMatrix(10, 10));
+    BOOST_CHECK_EQUAL(solver.numRows(), 100);
+}
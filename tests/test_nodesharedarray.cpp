@@ -0,0 +1,61 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE NodeSharedArrayTest
+
+#include <opm/autodiff/NodeSharedArray.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(Empty)
+{
+    const Opm::NodeSharedArray array;
+    BOOST_CHECK_EQUAL(array.size(), 0u);
+    BOOST_CHECK(array.data() == nullptr);
+    BOOST_CHECK(!array.shared());
+}
+
+BOOST_AUTO_TEST_CASE(FillAndCopy)
+{
+    // without a running MPI every process keeps its own copy, also when
+    // sharing is requested
+    for (const bool shareOnNode : { false, true }) {
+        const Opm::NodeSharedArray array(100, [](double* values) {
+                for (int i = 0; i < 100; ++i) {
+                    values[i] = 0.5*i;
+                }
+            }, shareOnNode);
+        BOOST_REQUIRE_EQUAL(array.size(), 100u);
+        BOOST_CHECK(!array.shared());
+        for (int i = 0; i < 100; ++i) {
+            BOOST_CHECK_EQUAL(array.data()[i], 0.5*i);
+        }
+
+        // copies refer to the same values
+        const Opm::NodeSharedArray copy = array;
+        BOOST_CHECK(copy.data() == array.data());
+        BOOST_CHECK_EQUAL(copy.size(), array.size());
+    }
+}
@@ -0,0 +1,94 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE OutputShardTest
+
+#include <opm/autodiff/OutputShard.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(WriteReadAndMerge)
+{
+    // a grid of four active cells with cartesian indices 1, 3, 4, 7
+    const std::vector<int> globalCell = { 1, 3, 4, 7 };
+
+    Opm::OutputShard first;
+    first.reportStep = 3;
+    first.time = 86400.0;
+    first.globalCell = { 4, 1 };
+    first.fields["PRESSURE"] = { 40.0, 10.0 };
+    first.fields["SAT"] = { 0.4, 0.6, 0.1, 0.9 };
+
+    Opm::OutputShard second;
+    second.reportStep = 3;
+    second.time = 86400.0;
+    second.globalCell = { 7, 3 };
+    second.fields["PRESSURE"] = { 70.0, 30.0 };
+    second.fields["SAT"] = { 0.7, 0.3, 0.2, 0.8 };
+
+    const std::string file0 = Opm::OutputShard::filename(".", "CASE", 0, 3);
+    const std::string file1 = Opm::OutputShard::filename(".", "CASE", 1, 3);
+    BOOST_CHECK(file0 != file1);
+    Opm::OutputShard::write(file0, first);
+    Opm::OutputShard::write(file1, second);
+
+    std::vector<Opm::OutputShard> shards;
+    shards.push_back(Opm::OutputShard::read(file0));
+    shards.push_back(Opm::OutputShard::read(file1));
+    BOOST_CHECK_EQUAL(shards[0].reportStep, 3);
+    BOOST_CHECK_EQUAL(shards[0].time, 86400.0);
+    BOOST_CHECK_EQUAL_COLLECTIONS(shards[1].globalCell.begin(), shards[1].globalCell.end(),
+                                  second.globalCell.begin(), second.globalCell.end());
+
+    const Opm::OutputShard::Fields fields = Opm::OutputShard::merge(shards, globalCell);
+    BOOST_REQUIRE_EQUAL(fields.size(), 2u);
+    const std::vector<double> pressure = { 10.0, 30.0, 40.0, 70.0 };
+    const std::vector<double> sat = { 0.1, 0.9, 0.2, 0.8, 0.4, 0.6, 0.7, 0.3 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(fields.at("PRESSURE").begin(), fields.at("PRESSURE").end(),
+                                  pressure.begin(), pressure.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(fields.at("SAT").begin(), fields.at("SAT").end(),
+                                  sat.begin(), sat.end());
+}
+
+BOOST_AUTO_TEST_CASE(MergeChecksCoverage)
+{
+    Opm::OutputShard shard;
+    shard.globalCell = { 0, 2 };
+    shard.fields["PRESSURE"] = { 1.0, 2.0 };
+    const std::vector<Opm::OutputShard> shards(1, shard);
+
+    // cell 1 is missing
+    BOOST_CHECK_THROW(Opm::OutputShard::merge(shards, { 0, 1, 2 }), std::runtime_error);
+    // cell 2 is not in the grid
+    BOOST_CHECK_THROW(Opm::OutputShard::merge(shards, { 0 }), std::runtime_error);
+    // the cells appear twice
+    BOOST_CHECK_THROW(Opm::OutputShard::merge({ shard, shard }, { 0, 2 }), std::runtime_error);
+
+    BOOST_CHECK_THROW(Opm::OutputShard::read("output_shard_missing.bin"), std::runtime_error);
+}
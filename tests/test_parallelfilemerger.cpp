@@ -0,0 +1,216 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE ParallelFileMergerTest
+
+#include <opm/simulators/ParallelFileMerger.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    namespace fs = boost::filesystem;
+
+    // A fresh directory that is removed at the end of the test.
+    struct TemporaryDirectory
+    {
+        TemporaryDirectory()
+            : path(fs::temp_directory_path() / fs::unique_path("parallelfilemerger-%%%%-%%%%"))
+        {
+            fs::create_directories(path);
+        }
+
+        ~TemporaryDirectory()
+        {
+            fs::remove_all(path);
+        }
+
+        fs::path path;
+    };
+
+    void writeFile(const fs::path& file, const std::string& content)
+    {
+        fs::ofstream of(file, std::ios::binary);
+        of << content;
+    }
+
+    std::string readFile(const fs::path& file)
+    {
+        fs::ifstream in(file, std::ios::binary);
+        std::ostringstream content;
+        content << in.rdbuf();
+        return content.str();
+    }
+
+    // The processes of a parallel run simulated by threads.
+    class ThreadCommunication
+    {
+    public:
+        struct Shared
+        {
+            explicit Shared(const int numThreads)
+                : size(numThreads), waiting(0), generation(0)
+            {}
+
+            const int size;
+            int waiting;
+            int generation;
+            std::mutex mutex;
+            std::condition_variable condition;
+        };
+
+        ThreadCommunication(const int rank, Shared& shared)
+            : rank_(rank), shared_(shared)
+        {}
+
+        int rank() const { return rank_; }
+
+        int size() const { return shared_.size; }
+
+        void barrier() const
+        {
+            std::unique_lock<std::mutex> lock(shared_.mutex);
+            const int generation = shared_.generation;
+            if ( ++shared_.waiting == shared_.size )
+            {
+                shared_.waiting = 0;
+                ++shared_.generation;
+                shared_.condition.notify_all();
+            }
+            else
+            {
+                shared_.condition.wait(lock, [&]() { return shared_.generation != generation; });
+            }
+        }
+
+    private:
+        const int rank_;
+        Shared& shared_;
+    };
+}
+
+BOOST_AUTO_TEST_CASE(AppendLargeFile)
+{
+    TemporaryDirectory dir;
+    std::string content(3 * (1 << 20) + 17, 'x');
+    for ( std::size_t i = 0; i < content.size(); i += 4099 )
+    {
+        content[i] = char('a' + i % 26);
+    }
+    writeFile(dir.path / "from", content);
+    writeFile(dir.path / "to", "head");
+
+    Opm::detail::appendFileContents(dir.path / "from", dir.path / "to");
+    BOOST_CHECK(readFile(dir.path / "to") == "head" + content);
+
+    Opm::detail::appendFileContents(dir.path / "from", dir.path / "new");
+    BOOST_CHECK(readFile(dir.path / "new") == content);
+}
+
+BOOST_AUTO_TEST_CASE(SerialMergeAndIndex)
+{
+    TemporaryDirectory dir;
+    writeFile(dir.path / "CASE.PRT", "root\n");
+    writeFile(dir.path / "CASE.1.PRT", "rank one\n");
+    writeFile(dir.path / "CASE.2.PRT", "");
+    writeFile(dir.path / ".CASE.3.DEBUG", "debug three\n");
+
+    std::for_each(fs::directory_iterator(dir.path), fs::directory_iterator(),
+                  Opm::detail::ParallelFileMerger(dir.path, "CASE", true));
+    // the index keeps the non-empty files
+    BOOST_CHECK(readFile(dir.path / "CASE.PRT.index").find("1 9 ") == 0);
+    BOOST_CHECK(readFile(dir.path / ".CASE.DEBUG.index").find("3 12 ") == 0);
+    BOOST_CHECK(fs::exists(dir.path / "CASE.1.PRT"));
+    BOOST_CHECK(!fs::exists(dir.path / "CASE.2.PRT"));
+
+    std::for_each(fs::directory_iterator(dir.path), fs::directory_iterator(),
+                  Opm::detail::ParallelFileMerger(dir.path, "CASE"));
+    const std::string log = readFile(dir.path / "CASE.PRT");
+    BOOST_CHECK(log.find("root\n") == 0);
+    BOOST_CHECK(log.find("Output written by rank 1") != std::string::npos);
+    BOOST_CHECK(log.find("rank one\n") != std::string::npos);
+    BOOST_CHECK(readFile(dir.path / ".CASE.DEBUG").find("debug three\n") != std::string::npos);
+    BOOST_CHECK(!fs::exists(dir.path / "CASE.1.PRT"));
+    BOOST_CHECK(!fs::exists(dir.path / ".CASE.3.DEBUG"));
+}
+
+BOOST_AUTO_TEST_CASE(TreeMergeKeepsRankOrder)
+{
+    TemporaryDirectory dir;
+    const int size = 7;
+    writeFile(dir.path / "CASE.PRT", "root\n");
+    for ( int rank = 1; rank < size; ++rank )
+    {
+        std::ostringstream name;
+        name << "CASE." << rank << ".PRT";
+        std::ostringstream content;
+        if ( rank != 4 )
+        {
+            content << "output of rank " << rank << "\n";
+        }
+        writeFile(dir.path / name.str(), content.str());
+    }
+
+    ThreadCommunication::Shared shared(size);
+    std::vector<std::thread> threads;
+    for ( int rank = 0; rank < size; ++rank )
+    {
+        threads.emplace_back([&dir, &shared, rank]() {
+            Opm::detail::mergeParallelFilesTree(dir.path, "CASE", ThreadCommunication(rank, shared));
+        });
+    }
+    for ( auto& thread : threads )
+    {
+        thread.join();
+    }
+
+    const std::string log = readFile(dir.path / "CASE.PRT");
+    BOOST_CHECK(log.find("root\n") == 0);
+    std::size_t pos = 0;
+    for ( int rank = 1; rank < size; ++rank )
+    {
+        std::ostringstream content;
+        content << "output of rank " << rank << "\n";
+        const std::size_t found = log.find(content.str());
+        if ( rank == 4 )
+        {
+            BOOST_CHECK(found == std::string::npos);
+            continue;
+        }
+        BOOST_REQUIRE(found != std::string::npos);
+        BOOST_CHECK(found > pos);
+        pos = found;
+    }
+    // only the merged file is left
+    BOOST_CHECK_EQUAL(std::distance(fs::directory_iterator(dir.path), fs::directory_iterator()), 1);
+}
@@ -0,0 +1,504 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE ParallelOverlappingILU0Test
+
+#include <opm/autodiff/ParallelOverlappingILU0.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    typedef Dune::FieldMatrix<double, 2, 2> Block;
+    typedef Dune::BCRSMatrix<Block> Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double, 2> > Vector;
+
+    // Block 5-point Laplacian on a nx by ny grid.
+    Matrix laplacian(const int nx, const int ny)
+    {
+        const int n = nx * ny;
+        Matrix A(n, n, 5*n, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            const int i = row.index() % nx;
+            const int j = row.index() / nx;
+            if (j > 0)      row.insert(row.index() - nx);
+            if (i > 0)      row.insert(row.index() - 1);
+            row.insert(row.index());
+            if (i < nx - 1) row.insert(row.index() + 1);
+            if (j < ny - 1) row.insert(row.index() + nx);
+        }
+
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = row->begin(); col != row->end(); ++col) {
+                *col = 0.0;
+                if (col.index() == row.index()) {
+                    (*col)[0][0] = 4.0; (*col)[1][1] = 4.5; (*col)[0][1] = 0.5;
+                } else {
+                    (*col)[0][0] = -1.0; (*col)[1][1] = -1.0; (*col)[1][0] = 0.1;
+                }
+            }
+        }
+        return A;
+    }
+
+    // A parallel information whose rows divisible by three are received
+    // from other processes, which send their current values back.
+    struct HaloInfo
+    {
+        struct Communicator
+        {
+            int rank() const { return 0; }
+            int min(const int value) const { return value; }
+        };
+
+        const Communicator& communicator() const { return comm_; }
+
+        template <class V>
+        void copyOwnerToAll(const V&, V&) const
+        {
+        }
+
+        Communicator comm_;
+    };
+}
+
+namespace Opm
+{
+    // tracks that no received row is used before the end of the exchange
+    template <>
+    class OwnerToAllExchange<HaloInfo>
+    {
+    public:
+        explicit OwnerToAllExchange(const HaloInfo&)
+        {
+        }
+
+        template <class V>
+        void begin(const V& v)
+        {
+            values_.resize(v.size());
+            for (std::size_t row = 0; row < v.size(); ++row) {
+                values_[row] = v[row][0];
+            }
+        }
+
+        template <class V>
+        void end(V& v)
+        {
+            for (std::size_t row = 0; row < v.size(); ++row) {
+                if (received(row)) {
+                    v[row][0] = values_[row];
+                }
+            }
+        }
+
+        bool received(const std::size_t row) const
+        {
+            return row % 3 == 0;
+        }
+
+    private:
+        std::vector<double> values_;
+    };
+}
+
+BOOST_AUTO_TEST_CASE(LevelSetsOfLaplacian)
+{
+    const int nx = 4, ny = 3;
+    const Matrix A = laplacian(nx, ny);
+
+    std::vector<Matrix::size_type> levelStart, levelRows;
+    Opm::detail::computeLevelSets(A, false, levelStart, levelRows);
+
+    // the levels of a 5-point stencil are the anti-diagonals of the grid
+    BOOST_CHECK_EQUAL(levelStart.size(), std::size_t(nx + ny));
+    BOOST_CHECK_EQUAL(levelRows.size(), std::size_t(nx * ny));
+    for (std::size_t level = 0; level + 1 < levelStart.size(); ++level) {
+        for (auto k = levelStart[level]; k < levelStart[level + 1]; ++k) {
+            const int row = levelRows[k];
+            BOOST_CHECK_EQUAL(std::size_t(row % nx + row / nx), level);
+        }
+    }
+
+    Opm::detail::computeLevelSets(A, true, levelStart, levelRows);
+    BOOST_CHECK_EQUAL(levelStart.size(), std::size_t(nx + ny));
+    BOOST_CHECK_EQUAL(levelRows.front(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(LevelScheduledApplyMatchesSequential)
+{
+    const Matrix A = laplacian(7, 5);
+
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector> ILU;
+    ILU sequential(A, 0, 1.0, false);
+    ILU levelScheduled(A, 0, 1.0, true);
+
+    Vector d(A.N());
+    for (std::size_t i = 0; i < d.size(); ++i) {
+        d[i][0] = std::sin(double(i));
+        d[i][1] = std::cos(double(i));
+    }
+
+    Vector v1(A.N()), v2(A.N());
+    v1 = 0.0;
+    v2 = 0.0;
+    sequential.apply(v1, d);
+    levelScheduled.apply(v2, d);
+
+    for (std::size_t i = 0; i < v1.size(); ++i) {
+        BOOST_CHECK_CLOSE(v1[i][0], v2[i][0], 1e-10);
+        BOOST_CHECK_CLOSE(v1[i][1], v2[i][1], 1e-10);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(UpdateReusesStructure)
+{
+    Matrix A = laplacian(6, 4);
+
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector> ILU;
+    ILU reused(A, 0, 1.0, true);
+
+    // change the values, but not the pattern
+    for (auto row = A.begin(); row != A.end(); ++row) {
+        (*row)[row.index()][0][0] += 0.5 * row.index();
+    }
+    reused.update(A);
+    ILU fresh(A, 0, 1.0, false);
+
+    Vector d(A.N());
+    d = 1.0;
+    Vector v1(A.N()), v2(A.N());
+    v1 = 0.0;
+    v2 = 0.0;
+    reused.apply(v1, d);
+    fresh.apply(v2, d);
+
+    for (std::size_t i = 0; i < v1.size(); ++i) {
+        BOOST_CHECK_CLOSE(v1[i][0], v2[i][0], 1e-10);
+        BOOST_CHECK_CLOSE(v1[i][1], v2[i][1], 1e-10);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SplitPhaseApplyMatchesSequential)
+{
+    const Matrix A = laplacian(7, 5);
+    const HaloInfo info;
+
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector> ILU;
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector, HaloInfo> SplitILU;
+    ILU sequential(A, 0, 1.0, false);
+    SplitILU split(A, info, 1.0, false);
+    SplitILU splitLevelScheduled(A, info, 1.0, true);
+
+    Vector d(A.N());
+    for (std::size_t i = 0; i < d.size(); ++i) {
+        d[i][0] = std::sin(double(i));
+        d[i][1] = std::cos(double(i));
+    }
+
+    // the exchange sends back the values at its begin, so the result only
+    // matches if the received rows are solved after its end
+    Vector v1(A.N()), v2(A.N()), v3(A.N());
+    v1 = 0.0;
+    v2 = 0.0;
+    v3 = 0.0;
+    sequential.apply(v1, d);
+    split.apply(v2, d);
+    splitLevelScheduled.apply(v3, d);
+
+    for (std::size_t i = 0; i < v1.size(); ++i) {
+        BOOST_CHECK_CLOSE(v1[i][0], v2[i][0], 1e-10);
+        BOOST_CHECK_CLOSE(v1[i][1], v2[i][1], 1e-10);
+        BOOST_CHECK_CLOSE(v1[i][0], v3[i][0], 1e-10);
+        BOOST_CHECK_CLOSE(v1[i][1], v3[i][1], 1e-10);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CompactApplyMatchesCRS)
+{
+    Matrix A = laplacian(7, 5);
+    const HaloInfo info;
+
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector> ILU;
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector, HaloInfo> SplitILU;
+    ILU crs(A, 0, 1.0, false, false);
+    ILU compact(A, 0, 1.0, false, true);
+    ILU compactLevelScheduled(A, 0, 1.0, true, true);
+    SplitILU compactSplit(A, info, 1.0, false, true);
+
+    // the compact decomposition does not keep the CRS copy
+    BOOST_CHECK(compact.memoryUsage() < crs.memoryUsage());
+    BOOST_CHECK(compact.memoryUsage() >= Opm::memoryUsage(A));
+
+    Vector d(A.N());
+    for (std::size_t i = 0; i < d.size(); ++i) {
+        d[i][0] = std::sin(double(i));
+        d[i][1] = std::cos(double(i));
+    }
+
+    const auto checkApply = [&]() {
+        std::vector<Vector> v(4, Vector(A.N()));
+        for (auto& vi : v) {
+            vi = 0.0;
+        }
+        crs.apply(v[0], d);
+        compact.apply(v[1], d);
+        compactLevelScheduled.apply(v[2], d);
+        compactSplit.apply(v[3], d);
+        for (int k = 1; k < 4; ++k) {
+            for (std::size_t i = 0; i < A.N(); ++i) {
+                BOOST_CHECK_CLOSE(v[0][i][0], v[k][i][0], 1e-10);
+                BOOST_CHECK_CLOSE(v[0][i][1], v[k][i][1], 1e-10);
+            }
+        }
+    };
+    checkApply();
+
+    // refactorization keeps the compact storage
+    for (auto row = A.begin(); row != A.end(); ++row) {
+        (*row)[row.index()][0][0] += 0.5 * row.index();
+    }
+    crs.update(A);
+    compact.update(A);
+    compactLevelScheduled.update(A);
+    compactSplit.update(A);
+    checkApply();
+}
+
+BOOST_AUTO_TEST_CASE(ReorderedDecompositionOfScrambledChain)
+{
+    // a chain of cells numbered out of order, whose ILU0 decomposition is
+    // exact in reverse Cuthill-McKee order
+    const int n = 20;
+    const auto cell = [n](const int k) { return (7 * k) % n; };
+    std::vector<std::vector<int> > neighbours(n);
+    for (int k = 0; k < n; ++k) {
+        if (k > 0)     neighbours[cell(k)].push_back(cell(k - 1));
+        if (k < n - 1) neighbours[cell(k)].push_back(cell(k + 1));
+    }
+
+    Matrix A(n, n, 3*n, Matrix::row_wise);
+    for (auto row = A.createbegin(); row != A.createend(); ++row) {
+        row.insert(row.index());
+        for (const int nb : neighbours[row.index()]) {
+            row.insert(nb);
+        }
+    }
+    for (auto row = A.begin(); row != A.end(); ++row) {
+        for (auto col = row->begin(); col != row->end(); ++col) {
+            *col = 0.0;
+            if (col.index() == row.index()) {
+                (*col)[0][0] = 4.0; (*col)[1][1] = 4.5; (*col)[0][1] = 0.5;
+            } else {
+                (*col)[0][0] = -1.0; (*col)[1][1] = -1.0; (*col)[1][0] = 0.1;
+            }
+        }
+    }
+
+    std::vector<std::size_t> perm;
+    Opm::reverseCuthillMcKee(A, perm);
+    BOOST_REQUIRE_EQUAL(perm.size(), std::size_t(n));
+    BOOST_CHECK(Opm::matrixBandwidth(A) > 1);
+    BOOST_CHECK_EQUAL(Opm::matrixBandwidth(A, perm), 1u);
+
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector> ILU;
+    ILU reordered(A, 0, 1.0, false, false, true);
+    ILU reorderedCompact(A, 0, 1.0, true, true, true);
+
+    Vector d(A.N());
+    for (std::size_t i = 0; i < d.size(); ++i) {
+        d[i][0] = std::sin(double(i));
+        d[i][1] = std::cos(double(i));
+    }
+
+    const auto checkExact = [&](ILU& ilu) {
+        Vector v(A.N());
+        v = 0.0;
+        ilu.apply(v, d);
+        Vector r(d);
+        A.mmv(v, r);
+        BOOST_CHECK_SMALL(r.two_norm(), 1e-12);
+    };
+    checkExact(reordered);
+    checkExact(reorderedCompact);
+
+    // refactorization copies the values in the reordered numbering
+    for (auto row = A.begin(); row != A.end(); ++row) {
+        (*row)[row.index()][0][0] += 0.5 * row.index();
+    }
+    reordered.update(A);
+    reorderedCompact.update(A);
+    checkExact(reordered);
+    checkExact(reorderedCompact);
+}
+
+BOOST_AUTO_TEST_CASE(MultiColorDecompositionOfLaplacian)
+{
+    const Matrix A = laplacian(7, 5);
+
+    // the 5-point stencil is red-black colored
+    std::vector<std::size_t> perm, inverse;
+    BOOST_CHECK_EQUAL(Opm::multiColorOrdering(A, perm), 2u);
+    BOOST_REQUIRE_EQUAL(perm.size(), A.N());
+    Opm::invertPermutation(perm, inverse);
+    Matrix reordered;
+    Opm::permuteMatrix(A, perm, inverse, reordered);
+
+    // one dependency level per color
+    std::vector<Matrix::size_type> levelStart, levelRows;
+    Opm::detail::computeLevelSets(reordered, false, levelStart, levelRows);
+    BOOST_CHECK_EQUAL(levelStart.size(), 3u);
+    const std::size_t numRed = levelStart[1];
+    Opm::detail::computeLevelSets(reordered, true, levelStart, levelRows);
+    BOOST_CHECK_EQUAL(levelStart.size(), 3u);
+
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector> ILU;
+    ILU colored(A, 0, 1.0, false, false, false, 0.0, true);
+    ILU coloredLevelScheduled(A, 0, 1.0, true, false, false, 0.0, true);
+
+    Vector d(A.N());
+    for (std::size_t i = 0; i < d.size(); ++i) {
+        d[i][0] = std::sin(double(i));
+        d[i][1] = std::cos(double(i));
+    }
+
+    const auto checkApply = [&]() {
+        Vector v1(A.N()), v2(A.N());
+        v1 = 0.0;
+        v2 = 0.0;
+        colored.apply(v1, d);
+        coloredLevelScheduled.apply(v2, d);
+        for (std::size_t i = 0; i < v1.size(); ++i) {
+            BOOST_CHECK_CLOSE(v1[i][0], v2[i][0], 1e-10);
+            BOOST_CHECK_CLOSE(v1[i][1], v2[i][1], 1e-10);
+        }
+        // the red rows are solved exactly
+        Vector r(d);
+        A.mmv(v1, r);
+        for (std::size_t k = 0; k < numRed; ++k) {
+            const std::size_t row = perm[k];
+            BOOST_CHECK_SMALL(r[row].two_norm(), 1e-12);
+        }
+    };
+    checkApply();
+
+    // refactorization keeps the colored pattern
+    Matrix B(A);
+    for (auto row = B.begin(); row != B.end(); ++row) {
+        (*row)[row.index()][0][0] += 0.5 * row.index();
+    }
+    colored.update(B);
+    coloredLevelScheduled.update(B);
+    Vector v1(A.N()), v2(A.N());
+    v1 = 0.0;
+    v2 = 0.0;
+    colored.apply(v1, d);
+    coloredLevelScheduled.apply(v2, d);
+    for (std::size_t i = 0; i < v1.size(); ++i) {
+        BOOST_CHECK_CLOSE(v1[i][0], v2[i][0], 1e-10);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ThresholdDecompositionOfLaplacian)
+{
+    const Matrix A = laplacian(6, 5);
+    const int n = A.N();
+
+    Vector x(n), d(n);
+    for (int i = 0; i < n; ++i) {
+        x[i][0] = std::sin(double(i));
+        x[i][1] = std::cos(double(i));
+    }
+    A.mv(x, d);
+
+    const auto error = [&](Opm::ParallelOverlappingILU0<Matrix, Vector, Vector>& ilu) {
+        Vector v(n);
+        v = 0.0;
+        ilu.apply(v, d);
+        v -= x;
+        return v.infinity_norm();
+    };
+
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector> ILU;
+    // without dropping and with unlimited fill-in ILUT is the exact LU
+    ILU exact(A, n, 1.0, false, false, false, 1e-300);
+    BOOST_CHECK_SMALL(error(exact), 1e-10);
+
+    // limited fill-in lies between ILU0 and the exact decomposition
+    ILU ilu0(A, 0, 1.0);
+    ILU ilut(A, 2, 1.0, false, false, false, 1e-4);
+    ILU ilutCompact(A, 2, 1.0, true, true, false, 1e-4);
+    BOOST_CHECK(ilut.memoryUsage() > ilu0.memoryUsage());
+    BOOST_CHECK(error(ilut) < error(ilu0));
+    BOOST_CHECK_CLOSE(error(ilut), error(ilutCompact), 1e-8);
+
+    // the ILUT is recomputed on update
+    ILU updated(A, 2, 1.0, false, false, false, 1e-4);
+    updated.update(A);
+    BOOST_CHECK_CLOSE(error(ilut), error(updated), 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(SplitPhaseApplyWithFillIn)
+{
+    const Matrix A = laplacian(7, 5);
+    const HaloInfo info;
+
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector> ILU;
+    typedef Opm::ParallelOverlappingILU0<Matrix, Vector, Vector, HaloInfo> SplitILU;
+    ILU iluk(A, 2, 1.0);
+    SplitILU splitIluk(A, info, 1.0, false, false, 2);
+    ILU ilut(A, 3, 1.0, false, false, false, 1e-3);
+    SplitILU splitIlut(A, info, 1.0, true, false, 3, 1e-3);
+
+    Vector d(A.N());
+    for (std::size_t i = 0; i < d.size(); ++i) {
+        d[i][0] = std::sin(double(i));
+        d[i][1] = std::cos(double(i));
+    }
+
+    // the received rows are solved after the exchange also with fill-in
+    std::vector<Vector> v(4, Vector(A.N()));
+    for (auto& vi : v) {
+        vi = 0.0;
+    }
+    iluk.apply(v[0], d);
+    splitIluk.apply(v[1], d);
+    ilut.apply(v[2], d);
+    splitIlut.apply(v[3], d);
+    for (std::size_t i = 0; i < A.N(); ++i) {
+        BOOST_CHECK_CLOSE(v[0][i][0], v[1][i][0], 1e-10);
+        BOOST_CHECK_CLOSE(v[0][i][1], v[1][i][1], 1e-10);
+        BOOST_CHECK_CLOSE(v[2][i][0], v[3][i][0], 1e-10);
+        BOOST_CHECK_CLOSE(v[2][i][1], v[3][i][1], 1e-10);
+    }
+}
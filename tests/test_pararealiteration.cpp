@@ -0,0 +1,128 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE PararealIterationTest
+
+#include <opm/simulators/timestepping/PararealIteration.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    // y' = -y with one implicit Euler step per slab of unit length for the
+    // coarse propagator and many of them for the fine one
+    struct Decay
+    {
+        explicit Decay(const int fineSteps)
+            : fineSteps_(fineSteps)
+            , fineSolves(0)
+        {
+        }
+
+        void coarse(const int /* slab */, double& y)
+        {
+            y /= 2.0;
+        }
+
+        void fine(const int /* slab */, double& y)
+        {
+            for (int i = 0; i < fineSteps_; ++i) {
+                y /= 1.0 + 1.0 / fineSteps_;
+            }
+            ++fineSolves;
+        }
+
+        void correct(double& coarseNew, const double& fineOld, const double& coarseOld)
+        {
+            coarseNew += fineOld - coarseOld;
+        }
+
+        double difference(const double& a, const double& b)
+        {
+            return std::abs(a - b);
+        }
+
+        int fineSteps_;
+        int fineSolves;
+    };
+}
+
+
+BOOST_AUTO_TEST_CASE(ExactAfterOneIterationPerSlab)
+{
+    Decay decay(100);
+    Opm::PararealIteration parareal(6, 0.0, 100);
+    const std::vector<double> end = parareal.run(1.0, decay);
+
+    BOOST_CHECK_EQUAL(parareal.iterations(), 6);
+    BOOST_CHECK(parareal.converged());
+    // the first slab is solved in every iteration, the last one only in the first
+    BOOST_CHECK_EQUAL(decay.fineSolves, 6 + 5 + 4 + 3 + 2 + 1);
+    BOOST_REQUIRE_EQUAL(end.size(), 6);
+    double y = 1.0;
+    for (int n = 0; n < 6; ++n) {
+        decay.fine(n, y);
+        BOOST_CHECK_CLOSE(end[n], y, 1e-10);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(ConvergesBeforeTheLastSlab)
+{
+    Decay decay(100);
+    Opm::PararealIteration parareal(10, 1e-3, 100);
+    const std::vector<double> end = parareal.run(1.0, decay);
+
+    BOOST_CHECK(parareal.converged());
+    BOOST_CHECK_LT(parareal.iterations(), 10);
+    BOOST_CHECK_LE(parareal.fineCriticalPath(), parareal.fineTime());
+    double y = 1.0;
+    for (int n = 0; n < 10; ++n) {
+        decay.fine(n, y);
+    }
+    BOOST_CHECK_SMALL(end.back() - y, 1e-3);
+}
+
+
+BOOST_AUTO_TEST_CASE(SlabBoundaries)
+{
+    // equal report steps after the restart step 2
+    const std::vector<int> equal = Opm::PararealIteration::slabBoundaries(std::vector<double>(10, 1.0), 2, 3);
+    const std::vector<int> expectedEqual = { 2, 5, 7, 10 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(equal.begin(), equal.end(), expectedEqual.begin(), expectedEqual.end());
+
+    // a long report step gets a slab of its own
+    const std::vector<int> uneven = Opm::PararealIteration::slabBoundaries({ 1.0, 1.0, 10.0, 1.0 }, 0, 3);
+    const std::vector<int> expectedUneven = { 0, 2, 3, 4 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(uneven.begin(), uneven.end(), expectedUneven.begin(), expectedUneven.end());
+
+    // never more slabs than report steps
+    const std::vector<int> few = Opm::PararealIteration::slabBoundaries({ 1.0, 1.0 }, 0, 5);
+    const std::vector<int> expectedFew = { 0, 1, 2 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(few.begin(), few.end(), expectedFew.begin(), expectedFew.end());
+}
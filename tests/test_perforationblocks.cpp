@@ -0,0 +1,312 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE PerforationBlocksTest
+
+#include <opm/autodiff/PerforationBlocks.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/solvers.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    typedef Dune::FieldMatrix<double, 3, 3> Block;
+    typedef Dune::BCRSMatrix<Block> Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double, 3> > Vector;
+
+    // three wells in six cells, the second well perforates cell 4 twice
+    // and shares cell 1 with the first well
+    const int numCells = 6;
+    const int wellStart[] = { 0, 2, 5, 6 };
+    const int cells[] = { 1, 0, 4, 1, 4, 5 };
+
+    Opm::PerforationBlocks<Block> perforationBlocks()
+    {
+        Opm::PerforationBlocks<Block> blocks;
+        blocks.init(3, wellStart, cells);
+        for (int perf = 0; perf < blocks.numPerforations(); ++perf) {
+            for (int i = 0; i < 3; ++i) {
+                for (int j = 0; j < 3; ++j) {
+                    blocks[perf][i][j] = std::sin(1.0 + perf + 3*i + j);
+                }
+            }
+        }
+        return blocks;
+    }
+
+    Vector cellVector()
+    {
+        Vector x(numCells);
+        for (int c = 0; c < numCells; ++c) {
+            for (int i = 0; i < 3; ++i) {
+                x[c][i] = std::cos(0.5 * c + i);
+            }
+        }
+        return x;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Structure)
+{
+    const auto blocks = perforationBlocks();
+    BOOST_CHECK_EQUAL(blocks.numWells(), 3);
+    BOOST_CHECK_EQUAL(blocks.numPerforations(), 6);
+    BOOST_CHECK_EQUAL(blocks.wellBegin(1), 2);
+    BOOST_CHECK_EQUAL(blocks.wellEnd(1), 5);
+    BOOST_CHECK_EQUAL(blocks.cell(4), 4);
+
+    Opm::PerforationBlocks<Block> empty;
+    BOOST_CHECK_EQUAL(empty.numWells(), 0);
+    BOOST_CHECK_EQUAL(empty.numPerforations(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(ProductsMatchMatrix)
+{
+    const auto blocks = perforationBlocks();
+    Matrix matrix;
+    blocks.copyTo(numCells, matrix);
+    BOOST_CHECK_EQUAL(matrix.N(), 3u);
+    BOOST_CHECK_EQUAL(matrix.M(), 6u);
+    BOOST_CHECK_EQUAL(matrix.nonzeroes(), 5u);
+
+    const Vector x = cellVector();
+    Vector y(3), yMatrix(3);
+    blocks.mv(x, y);
+    matrix.mv(x, yMatrix);
+    for (int w = 0; w < 3; ++w) {
+        for (int i = 0; i < 3; ++i) {
+            BOOST_CHECK_CLOSE(y[w][i], yMatrix[w][i], 1e-12);
+        }
+    }
+
+    Vector r(x), rMatrix(x);
+    blocks.mmv(x, y);
+    for (int w = 0; w < 3; ++w) {
+        BOOST_CHECK_SMALL(y[w].two_norm(), 1e-12);
+    }
+
+    blocks.mmtv(yMatrix, r);
+    matrix.mmtv(yMatrix, rMatrix);
+    for (int c = 0; c < numCells; ++c) {
+        for (int i = 0; i < 3; ++i) {
+            BOOST_CHECK_CLOSE(r[c][i], rMatrix[c][i], 1e-12);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Reinit)
+{
+    auto blocks = perforationBlocks();
+    blocks = 0.0;
+    for (int perf = 0; perf < blocks.numPerforations(); ++perf) {
+        BOOST_CHECK_EQUAL(blocks[perf].frobenius_norm(), 0.0);
+    }
+
+    const int start[] = { 0, 1 };
+    const int cell[] = { 3 };
+    blocks.init(1, start, cell);
+    BOOST_CHECK_EQUAL(blocks.numWells(), 1);
+    BOOST_CHECK_EQUAL(blocks.numPerforations(), 1);
+    BOOST_CHECK_EQUAL(blocks.cell(0), 3);
+    BOOST_CHECK_EQUAL(blocks[0].frobenius_norm(), 0.0);
+}
+
+namespace
+{
+    // Applies A - B^T inv(D) C without assembling it, as the well model does.
+    class ImplicitWellOperator : public Dune::LinearOperator<Vector, Vector>
+    {
+    public:
+        enum { category = Dune::SolverCategory::sequential };
+
+        ImplicitWellOperator(const Matrix& A, const Opm::PerforationBlocks<Block>& B,
+                             const std::vector<Block>& invD, const Opm::PerforationBlocks<Block>& C)
+            : A_(A), B_(B), invD_(invD), C_(C)
+        {
+        }
+
+        virtual void apply(const Vector& x, Vector& y) const
+        {
+            A_.mv(x, y);
+            Vector cx(invD_.size()), invDCx(invD_.size());
+            C_.mv(x, cx);
+            for (std::size_t w = 0; w < invD_.size(); ++w) {
+                invD_[w].mv(cx[w], invDCx[w]);
+            }
+            B_.mmtv(invDCx, y);
+        }
+
+        virtual void applyscaleadd(double alpha, const Vector& x, Vector& y) const
+        {
+            Vector ax(y.size());
+            apply(x, ax);
+            y.axpy(alpha, ax);
+        }
+
+    private:
+        const Matrix& A_;
+        const Opm::PerforationBlocks<Block>& B_;
+        const std::vector<Block>& invD_;
+        const Opm::PerforationBlocks<Block>& C_;
+    };
+
+    // A 1D reservoir of n cells with a strongly coupled well perforating
+    // the cells [first, first + numPerf).
+    void wellSystem(const int n, const int first, const int numPerf, Matrix& A,
+                    Opm::PerforationBlocks<Block>& B, std::vector<Block>& invD,
+                    Opm::PerforationBlocks<Block>& C)
+    {
+        A = Matrix(n, n, 3*n, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            if (row.index() > 0)     row.insert(row.index() - 1);
+            row.insert(row.index());
+            if (static_cast<int>(row.index()) < n - 1) row.insert(row.index() + 1);
+        }
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = row->begin(); col != row->end(); ++col) {
+                *col = 0.0;
+                for (int i = 0; i < 3; ++i) {
+                    (*col)[i][i] = (col.index() == row.index()) ? 2.0 + 0.1 * i : -1.0;
+                }
+                (*col)[1][0] = (col.index() == row.index()) ? 0.3 : -0.1;
+            }
+        }
+
+        const int start[] = { 0, numPerf };
+        std::vector<int> cells(numPerf);
+        for (int perf = 0; perf < numPerf; ++perf) {
+            cells[perf] = first + perf;
+        }
+        B.init(1, start, cells.data());
+        C.init(1, start, cells.data());
+        const double wellIndex = 1.0e3;
+        Block D;
+        D = 0.0;
+        for (int perf = 0; perf < numPerf; ++perf) {
+            for (int i = 0; i < 3; ++i) {
+                A[cells[perf]][cells[perf]][i][i] += wellIndex;
+                B[perf][i][i] = -wellIndex;
+                C[perf][i][i] = -wellIndex;
+                D[i][i] += wellIndex;
+            }
+        }
+        D[0][0] += 1.0;
+        invD.assign(1, D);
+        invD[0].invert();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SchurComplementMatchesImplicitWells)
+{
+    Matrix A;
+    Opm::PerforationBlocks<Block> B, C;
+    std::vector<Block> invD;
+    wellSystem(10, 4, 2, A, B, invD, C);
+    BOOST_REQUIRE(Opm::detail::hasWellCouplings(B, 0, A));
+
+    // cells 3 and 5 are not neighbours
+    Matrix A3;
+    Opm::PerforationBlocks<Block> B3, C3;
+    wellSystem(10, 3, 3, A3, B3, invD, C3);
+    BOOST_CHECK(!Opm::detail::hasWellCouplings(B3, 0, A3));
+
+    wellSystem(10, 4, 2, A, B, invD, C);
+    const ImplicitWellOperator implicitOp(A, B, invD, C);
+    Matrix S(A);
+    Opm::detail::subtractWellSchurComplement(B, invD[0], C, 0, S);
+
+    const Vector x = [] {
+        Vector v(10);
+        for (int c = 0; c < 10; ++c) {
+            for (int i = 0; i < 3; ++i) {
+                v[c][i] = std::cos(0.5 * c + i);
+            }
+        }
+        return v;
+    }();
+    Vector y(10), yExplicit(10);
+    implicitOp.apply(x, y);
+    S.mv(x, yExplicit);
+    for (int c = 0; c < 10; ++c) {
+        for (int i = 0; i < 3; ++i) {
+            BOOST_CHECK_SMALL(y[c][i] - yExplicit[c][i], 1e-9);
+        }
+    }
+}
+
+// Solves the same system with the wells applied implicitly and with their
+// Schur complement in the matrix, where the ILU0 preconditioner sees them.
+BOOST_AUTO_TEST_CASE(ImplicitAndExplicitWellSolve)
+{
+    const int n = 200;
+    Matrix A;
+    Opm::PerforationBlocks<Block> B, C;
+    std::vector<Block> invD;
+    wellSystem(n, 100, 2, A, B, invD, C);
+
+    Vector rhs(n);
+    for (int c = 0; c < n; ++c) {
+        for (int i = 0; i < 3; ++i) {
+            rhs[c][i] = std::sin(double(c + i));
+        }
+    }
+
+    ImplicitWellOperator implicitOp(A, B, invD, C);
+    Dune::SeqILU0<Matrix, Vector, Vector> implicitPrec(A, 1.0);
+    Dune::BiCGSTABSolver<Vector> implicitSolver(implicitOp, implicitPrec, 1e-10, 1000, 0);
+    Vector x(n), b(rhs);
+    x = 0.0;
+    Dune::InverseOperatorResult implicitResult;
+    implicitSolver.apply(x, b, implicitResult);
+    BOOST_CHECK(implicitResult.converged);
+
+    Matrix S(A);
+    Opm::detail::subtractWellSchurComplement(B, invD[0], C, 0, S);
+    Dune::MatrixAdapter<Matrix, Vector, Vector> explicitOp(S);
+    Dune::SeqILU0<Matrix, Vector, Vector> explicitPrec(S, 1.0);
+    Dune::BiCGSTABSolver<Vector> explicitSolver(explicitOp, explicitPrec, 1e-10, 1000, 0);
+    Vector xExplicit(n);
+    b = rhs;
+    xExplicit = 0.0;
+    Dune::InverseOperatorResult explicitResult;
+    explicitSolver.apply(xExplicit, b, explicitResult);
+    BOOST_CHECK(explicitResult.converged);
+
+    BOOST_TEST_MESSAGE("BiCGSTAB iterations with implicit wells: " << implicitResult.iterations
+                       << ", with the Schur complement in the matrix: " << explicitResult.iterations);
+
+    xExplicit -= x;
+    BOOST_CHECK_SMALL(xExplicit.two_norm() / x.two_norm(), 1e-6);
+}
@@ -0,0 +1,82 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE PerformanceTraceTest
+
+#include <opm/autodiff/PerformanceTrace.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <string>
+
+BOOST_AUTO_TEST_CASE(CsvRecords)
+{
+    std::string filename;
+    {
+        Opm::PerformanceTrace trace("performance_trace_test.csv", 0, 1);
+        filename = trace.filename();
+        trace.beginIteration(2, 5, 1);
+        trace.record(Opm::PerformanceTrace::Assembly, 0.5);
+        trace.record(Opm::PerformanceTrace::Assembly, 0.25);
+        trace.record(Opm::PerformanceTrace::LinearSolve, 2.0);
+        trace.setLinearIterations(17);
+        trace.endIteration();
+        // not started, nothing is written
+        trace.endIteration();
+    }
+    BOOST_CHECK_EQUAL(filename, "performance_trace_test.csv");
+
+    std::ifstream file(filename.c_str());
+    std::string header, record, extra;
+    std::getline(file, header);
+    std::getline(file, record);
+    BOOST_CHECK(!std::getline(file, extra));
+
+    BOOST_CHECK_EQUAL(header, "rank,report_step,time_step,iteration,timestamp,assembly,well_assembly,"
+                      "convert_results,preconditioner_setup,linear_solve,update_state,linear_iterations");
+    BOOST_CHECK_EQUAL(record.substr(0, 8), "0,2,5,1,");
+    const std::string::size_type times = record.find(',', 8);
+    BOOST_CHECK_EQUAL(record.substr(times), ",0.75,0,0,0,2,0,17");
+}
+
+BOOST_AUTO_TEST_CASE(JsonRecordsPerRank)
+{
+    std::string filename;
+    {
+        Opm::PerformanceTrace trace("performance_trace_test.json", 3, 4);
+        filename = trace.filename();
+        trace.beginIteration(0, 0, 0);
+        trace.record(Opm::PerformanceTrace::UpdateState, 1.5);
+        trace.endIteration();
+    }
+    BOOST_CHECK_EQUAL(filename, "performance_trace_test.3.json");
+
+    std::ifstream file(filename.c_str());
+    std::string record;
+    std::getline(file, record);
+    BOOST_CHECK_EQUAL(record.substr(0, 62), "{\"rank\": 3, \"report_step\": 0, \"time_step\": 0, \"iteration\": 0, ");
+    BOOST_CHECK(record.find("\"update_state\": 1.5, \"linear_iterations\": 0}") != std::string::npos);
+}
@@ -0,0 +1,89 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE PolymerMobilitiesTest
+
+#include <opm/polymer/PolymerProperties.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+namespace {
+    Opm::PolymerProperties polymer(const Opm::PolymerProperties::AdsorptionBehaviour ads_index)
+    {
+        const std::vector<double> c_vals_visc = { 0.0, 0.5, 3.0 };
+        const std::vector<double> visc_mult_vals = { 1.0, 4.0, 20.0 };
+        const std::vector<double> c_vals_ads = { 0.0, 2.0, 8.0 };
+        const std::vector<double> ads_vals = { 0.0, 0.0015, 0.0025 };
+        const std::vector<double> water_vel_vals = { 0.0, 10.0 };
+        const std::vector<double> shear_vrf_vals = { 1.0, 1.0 };
+        return Opm::PolymerProperties(3.0, 0.7, 1000.0, 0.0, 1.5, 0.0025, ads_index,
+                                      c_vals_visc, visc_mult_vals, c_vals_ads, ads_vals,
+                                      water_vel_vals, shear_vrf_vals);
+    }
+
+    // The batch mobilities of the cells against those of one cell at a time.
+    void checkMobilities(const Opm::PolymerProperties& props,
+                         const std::vector<double>& visc, const int visc_stride)
+    {
+        const std::vector<double> c = { 0.0, 0.1, 0.5, 1.2, 2.9, 3.0 };
+        const std::vector<double> cmax = { 0.0, 2.0, 0.4, 1.2, 3.0, 3.0 };
+        const int n = c.size();
+        std::vector<double> relperm(2*n);
+        for (int i = 0; i < n; ++i) {
+            relperm[2*i] = 0.1*i;
+            relperm[2*i + 1] = 1.0 - 0.15*i;
+        }
+
+        std::vector<double> mob(2*n);
+        props.effectiveMobilities(n, c.data(), cmax.data(), visc.data(), visc_stride,
+                                  relperm.data(), mob.data());
+        for (int i = 0; i < n; ++i) {
+            double expected[2];
+            props.effectiveMobilities(c[i], cmax[i], &visc[i*visc_stride], &relperm[2*i], expected);
+            BOOST_CHECK_CLOSE(mob[2*i], expected[0], 1e-12);
+            BOOST_CHECK_CLOSE(mob[2*i + 1], expected[1], 1e-12);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SameViscositiesForAllCells)
+{
+    const std::vector<double> visc = { 5e-4, 2e-3 };
+    checkMobilities(polymer(Opm::PolymerProperties::NoDesorption), visc, 0);
+    checkMobilities(polymer(Opm::PolymerProperties::Desorption), visc, 0);
+}
+
+BOOST_AUTO_TEST_CASE(ViscositiesPerCell)
+{
+    std::vector<double> visc;
+    for (int i = 0; i < 6; ++i) {
+        visc.push_back(5e-4 + 1e-5*i);
+        visc.push_back(2e-3 - 1e-5*i);
+    }
+    checkMobilities(polymer(Opm::PolymerProperties::NoDesorption), visc, 2);
+}
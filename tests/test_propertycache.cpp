@@ -0,0 +1,105 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE PropertyCacheTest
+
+#include <opm/autodiff/PropertyCache.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using namespace Opm;
+
+typedef PropertyCache::ADB ADB;
+
+namespace
+{
+    std::vector<ADB> square(const ADB& x)
+    {
+        return std::vector<ADB>(1, x * x);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ResultsOfSameVersionAndArguments)
+{
+    std::vector<int> blocks = { 3, 2 };
+    ADB::V v(3);
+    v << 1.0, 2.0, 3.0;
+    const ADB x = ADB::variable(0, v, blocks);
+    const ADB c = ADB::constant(v);
+
+    PropertyCache cache;
+    std::vector<ADB> results;
+    BOOST_CHECK(!cache.find(1, { &x, &c }, results));
+
+    cache.store(1, { &x, &c }, square(x));
+    BOOST_CHECK(cache.find(1, { &x, &c }, results));
+    BOOST_REQUIRE_EQUAL(results.size(), 1u);
+    BOOST_CHECK((results[0].value() == v * v).all());
+    BOOST_CHECK_EQUAL(results[0].numBlocks(), 2);
+
+    // a new version of the state
+    BOOST_CHECK(!cache.find(2, { &x, &c }, results));
+
+    // other values
+    ADB::V w = v;
+    w[2] = 4.0;
+    const ADB y = ADB::variable(0, w, blocks);
+    BOOST_CHECK(!cache.find(1, { &y, &c }, results));
+    BOOST_CHECK(!cache.find(1, { &x }, results));
+
+    cache.clear();
+    BOOST_CHECK(!cache.find(1, { &x, &c }, results));
+}
+
+BOOST_AUTO_TEST_CASE(DerivativesOfTheArguments)
+{
+    std::vector<int> blocks = { 3, 2 };
+    ADB::V v(3);
+    v << 1.0, 2.0, 3.0;
+    const ADB x = ADB::variable(0, v, blocks);
+    const ADB c = ADB::constant(v);
+
+    PropertyCache cache;
+    std::vector<ADB> results;
+
+    // the results are returned without derivatives for constant arguments
+    cache.store(1, { &x }, square(x));
+    BOOST_CHECK(cache.find(1, { &c }, results));
+    BOOST_REQUIRE_EQUAL(results.size(), 1u);
+    BOOST_CHECK((results[0].value() == v * v).all());
+    BOOST_CHECK_EQUAL(results[0].numBlocks(), 0);
+
+    // but not with derivatives of another pattern
+    std::vector<int> otherBlocks = { 3, 4 };
+    const ADB z = ADB::variable(0, v, otherBlocks);
+    BOOST_CHECK(!cache.find(1, { &z }, results));
+
+    // and results without derivatives are not returned for variables
+    cache.store(1, { &c }, square(c));
+    BOOST_CHECK(cache.find(1, { &c }, results));
+    BOOST_CHECK(!cache.find(1, { &x }, results));
+}
@@ -0,0 +1,100 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE RankLoadReportTest
+
+#include <opm/autodiff/RankLoadReport.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+namespace
+{
+    // The root process of three, the quantities of the other two are given.
+    class Processes
+    {
+    public:
+        explicit Processes(const std::vector<double>& remote)
+            : remote_(remote)
+        {
+        }
+
+        int rank() const { return 0; }
+        int size() const { return 3; }
+
+        int gather(const double* in, double* out, const int len, const int root) const
+        {
+            BOOST_CHECK_EQUAL(root, 0);
+            BOOST_REQUIRE_EQUAL(remote_.size(), std::size_t(2 * len));
+            for (int i = 0; i < len; ++i) {
+                out[i] = in[i];
+            }
+            for (int i = 0; i < 2 * len; ++i) {
+                out[len + i] = remote_[i];
+            }
+            return 0;
+        }
+
+    private:
+        std::vector<double> remote_;
+    };
+}
+
+
+BOOST_AUTO_TEST_CASE(ImbalanceAndWorstRanks)
+{
+    Opm::RankLoadReport report;
+    report.set(Opm::RankLoadReport::Assembly, 10.0);
+    report.set(Opm::RankLoadReport::LinearSolve, 4.0);
+    report.set(Opm::RankLoadReport::OwnedCells, 1000.0);
+    report.set(Opm::RankLoadReport::Perforations, 12.0);
+
+    //                assembly  wells  solve  output  cells  perforations
+    Processes comm({  20.0,     1.0,   4.0,   0.0,    1000.0, 0.0,
+                      30.0,     2.0,   4.0,   0.0,    1000.0, 0.0 });
+    report.gather(comm);
+
+    BOOST_CHECK_EQUAL(report.numProcesses(), 3);
+    BOOST_CHECK_EQUAL(report.value(Opm::RankLoadReport::Assembly, 2), 30.0);
+    BOOST_CHECK_CLOSE(report.imbalance(Opm::RankLoadReport::Assembly), 1.5, 1e-12);
+    BOOST_CHECK_CLOSE(report.imbalance(Opm::RankLoadReport::LinearSolve), 1.0, 1e-12);
+    BOOST_CHECK_CLOSE(report.imbalance(Opm::RankLoadReport::Perforations), 3.0, 1e-12);
+    // nothing written at all
+    BOOST_CHECK_EQUAL(report.imbalance(Opm::RankLoadReport::Output), 1.0);
+
+    const std::vector<int> worst = report.worstRanks(Opm::RankLoadReport::Assembly, 2);
+    BOOST_REQUIRE_EQUAL(worst.size(), 2u);
+    BOOST_CHECK_EQUAL(worst[0], 2);
+    BOOST_CHECK_EQUAL(worst[1], 1);
+    // the lower rank first among equal values
+    BOOST_CHECK_EQUAL(report.worstRanks(Opm::RankLoadReport::OwnedCells, 1)[0], 0);
+    BOOST_CHECK_EQUAL(report.worstRanks(Opm::RankLoadReport::Output, 5).size(), 3u);
+
+    const std::string table = report.format();
+    BOOST_CHECK(table.find("over 3 processes") != std::string::npos);
+    BOOST_CHECK(table.find("perforations") != std::string::npos);
+}
@@ -0,0 +1,134 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE RecyclingGCRSolverTest
+
+#include <opm/autodiff/RecyclingGCRSolver.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/scalarproducts.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    typedef Dune::BCRSMatrix<Dune::FieldMatrix<double, 1, 1> > Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double, 1> > Vector;
+    typedef Opm::RecyclingGCRSolver<Vector> Solver;
+
+    // a nonsymmetric tridiagonal matrix
+    Matrix convectionDiffusion(const int n)
+    {
+        Matrix A(n, n, 3*n, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            if (row.index() > 0) row.insert(row.index() - 1);
+            row.insert(row.index());
+            if (static_cast<int>(row.index()) < n - 1) row.insert(row.index() + 1);
+        }
+        for (int i = 0; i < n; ++i) {
+            A[i][i] = 2.2 + 0.01 * i;
+            if (i > 0)     A[i][i-1] = -1.1;
+            if (i < n - 1) A[i][i+1] = -1.0;
+        }
+        return A;
+    }
+
+    Vector rhs(const int n, const int shift)
+    {
+        Vector b(n);
+        for (int i = 0; i < n; ++i) {
+            b[i] = std::sin(double(i + shift));
+        }
+        return b;
+    }
+
+    Dune::InverseOperatorResult solve(const Matrix& A, const Vector& rhs, Solver::RecycledSpace& recycled,
+                                      const int numRecycled, Vector& x)
+    {
+        Dune::MatrixAdapter<Matrix, Vector, Vector> op(A);
+        Dune::SeqScalarProduct<Vector> sp;
+        Dune::SeqJac<Matrix, Vector, Vector> jacobi(A, 1, 1.0);
+        Solver solver(op, sp, jacobi, 1e-8, 20, 1000, 0, recycled, numRecycled);
+
+        Vector b(rhs);
+        x.resize(rhs.size());
+        x = 0.0;
+        Dune::InverseOperatorResult result;
+        solver.apply(x, b, result);
+        return result;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SolvesWithoutRecycling)
+{
+    const int n = 200;
+    const Matrix A = convectionDiffusion(n);
+    const Vector b = rhs(n, 0);
+
+    Solver::RecycledSpace recycled;
+    Vector x;
+    const Dune::InverseOperatorResult result = solve(A, b, recycled, 0, x);
+    BOOST_CHECK(result.converged);
+    BOOST_CHECK(recycled.empty());
+
+    Vector residual(b);
+    A.mmv(x, residual);
+    BOOST_CHECK_SMALL(residual.two_norm() / b.two_norm(), 1e-7);
+}
+
+BOOST_AUTO_TEST_CASE(RecyclingReducesIterations)
+{
+    const int n = 200;
+    const Matrix A = convectionDiffusion(n);
+
+    Solver::RecycledSpace recycled;
+    Vector x;
+    BOOST_CHECK(solve(A, rhs(n, 0), recycled, 8, x).converged);
+    BOOST_CHECK_EQUAL(recycled.size(), 8u);
+
+    for (int shift = 1; shift < 4; ++shift) {
+        const Vector b = rhs(n, shift);
+
+        Solver::RecycledSpace none;
+        Vector xPlain;
+        const Dune::InverseOperatorResult plain = solve(A, b, none, 0, xPlain);
+
+        const Dune::InverseOperatorResult recycling = solve(A, b, recycled, 8, x);
+        BOOST_CHECK(recycling.converged);
+        BOOST_CHECK_LT(recycling.iterations, plain.iterations);
+
+        Vector residual(b);
+        A.mmv(x, residual);
+        BOOST_CHECK_SMALL(residual.two_norm() / b.two_norm(), 1e-7);
+    }
+}
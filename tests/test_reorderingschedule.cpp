@@ -0,0 +1,140 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE ReorderingScheduleTest
+
+#include <opm/autodiff/ReorderingSchedule.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace {
+    // Neighbours of the cells connected by the given (from, to) flow
+    // edges, with zero flux edges given with a negative from.
+    struct Graph
+    {
+        std::vector<int> start;
+        std::vector<int> neighbours;
+        std::vector<char> upstream;
+    };
+
+    Graph createGraph(const int numCells,
+                      const std::vector<std::pair<int, int> >& flow,
+                      const std::vector<std::pair<int, int> >& noflow)
+    {
+        std::vector<std::vector<std::pair<int, char> > > adj(numCells);
+        for (const auto& e : flow) {
+            adj[e.first].emplace_back(e.second, false);
+            adj[e.second].emplace_back(e.first, true);
+        }
+        for (const auto& e : noflow) {
+            adj[e.first].emplace_back(e.second, false);
+            adj[e.second].emplace_back(e.first, false);
+        }
+        Graph g;
+        g.start.push_back(0);
+        for (const auto& a : adj) {
+            for (const auto& n : a) {
+                g.neighbours.push_back(n.first);
+                g.upstream.push_back(n.second);
+            }
+            g.start.push_back(g.neighbours.size());
+        }
+        return g;
+    }
+
+    std::vector<int> positions(const Opm::ReorderingSchedule& schedule)
+    {
+        const std::vector<int>& seq = schedule.sequence();
+        std::vector<int> pos(seq.size());
+        for (std::size_t i = 0; i < seq.size(); ++i) {
+            pos[seq[i]] = i;
+        }
+        return pos;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(UpstreamCellsComeFirst)
+{
+    // 0 -> 1 -> 2 -> 3 -> 1 is a cycle of 1, 2, 3, and 4 -> 2, 5 has no flow.
+    const Graph g = createGraph(6, { {0, 1}, {1, 2}, {2, 3}, {3, 1}, {4, 2} }, { {5, 0} });
+    Opm::ReorderingSchedule schedule;
+    schedule.compute(g.start, g.neighbours, g.upstream);
+
+    BOOST_CHECK_EQUAL(schedule.numComponents(), 4);
+    const std::vector<int>& comps = schedule.components();
+    const std::vector<int> pos = positions(schedule);
+    int bigComp = -1;
+    for (int c = 0; c < schedule.numComponents(); ++c) {
+        if (comps[c + 1] - comps[c] == 3) {
+            bigComp = c;
+        }
+    }
+    BOOST_REQUIRE(bigComp >= 0);
+    for (int cell : { 1, 2, 3 }) {
+        BOOST_CHECK(pos[cell] >= comps[bigComp] && pos[cell] < comps[bigComp + 1]);
+        BOOST_CHECK(pos[0] < pos[cell]);
+        BOOST_CHECK(pos[4] < pos[cell]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(LevelsSeparateNeighbours)
+{
+    // Two chains 0 -> 1 -> 2 and 3 -> 4 -> 5, with 2 and 3 neighbours without flow.
+    const Graph g = createGraph(6, { {0, 1}, {1, 2}, {3, 4}, {4, 5} }, { {2, 3} });
+    Opm::ReorderingSchedule schedule;
+    schedule.compute(g.start, g.neighbours, g.upstream);
+
+    BOOST_CHECK_EQUAL(schedule.numComponents(), 6);
+    const std::vector<int>& levelStart = schedule.levelStart();
+    const std::vector<int>& levelComps = schedule.levelComponents();
+    BOOST_CHECK_EQUAL(levelStart.back(), 6);
+
+    // level of every cell
+    std::vector<int> level(6, -1);
+    for (int l = 0; l < schedule.numLevels(); ++l) {
+        for (int i = levelStart[l]; i < levelStart[l + 1]; ++i) {
+            const int comp = levelComps[i];
+            level[schedule.sequence()[schedule.components()[comp]]] = l;
+        }
+    }
+    const std::vector<int> pos = positions(schedule);
+    for (int cell = 0; cell < 6; ++cell) {
+        BOOST_CHECK(level[cell] >= 0);
+        for (int i = g.start[cell]; i < g.start[cell + 1]; ++i) {
+            const int other = g.neighbours[i];
+            // neighbours are in different levels, upstream cells in earlier ones
+            BOOST_CHECK(level[other] != level[cell]);
+            if (g.upstream[i]) {
+                BOOST_CHECK(level[other] < level[cell]);
+                BOOST_CHECK(pos[other] < pos[cell]);
+            }
+        }
+    }
+    // the chains are solved side by side
+    BOOST_CHECK_EQUAL(schedule.numLevels(), 3);
+}
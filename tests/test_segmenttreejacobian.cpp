@@ -0,0 +1,136 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE SegmentTreeJacobianTest
+
+#include <opm/autodiff/SegmentTreeJacobian.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    typedef Eigen::SparseMatrix<double> Sp;
+
+    // Two wells: segments 0 to 4, where segments 2 and 4 both have the
+    // outlet 1, and the unbranched segments 5 to 7.
+    std::vector<int> outlets()
+    {
+        return { -1, 0, 1, 2, 1, -1, 5, 6 };
+    }
+
+    int topSegment(const std::vector<int>& outlet, int seg)
+    {
+        while (outlet[seg] >= 0) {
+            seg = outlet[seg];
+        }
+        return seg;
+    }
+
+    void addBlock(std::vector< Eigen::Triplet<double> >& entries, const int nseg, const int bs,
+                  const int rowSeg, const int colSeg, const double scale)
+    {
+        for (int i = 0; i < bs; ++i) {
+            for (int j = 0; j < bs; ++j) {
+                const double value = rowSeg == colSeg && i == j
+                    ? 10.0 + i
+                    : scale * std::sin(1.0 + rowSeg + 3.0*colSeg + 5.0*i + 7.0*j);
+                entries.emplace_back(i * nseg + rowSeg, j * nseg + colSeg, value);
+            }
+        }
+    }
+
+    // coupling of every segment with its outlet and its top segment
+    Sp segmentJacobian(const std::vector<int>& outlet, const int bs)
+    {
+        const int nseg = outlet.size();
+        std::vector< Eigen::Triplet<double> > entries;
+        for (int seg = 0; seg < nseg; ++seg) {
+            addBlock(entries, nseg, bs, seg, seg, 1.0);
+            if (outlet[seg] >= 0) {
+                addBlock(entries, nseg, bs, seg, outlet[seg], 1.0);
+                addBlock(entries, nseg, bs, outlet[seg], seg, 0.5);
+                const int top = topSegment(outlet, seg);
+                if (top != outlet[seg]) {
+                    addBlock(entries, nseg, bs, seg, top, 0.25);
+                }
+            }
+        }
+        Sp jacobian(nseg * bs, nseg * bs);
+        jacobian.setFromTriplets(entries.begin(), entries.end());
+        return jacobian;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SolveMatchesSparseLU)
+{
+    const std::vector<int> outlet = outlets();
+    const int bs = 3;
+    const int n = outlet.size() * bs;
+    const Sp jacobian = segmentJacobian(outlet, bs);
+
+    Eigen::VectorXd rhs(n);
+    for (int i = 0; i < n; ++i) {
+        rhs[i] = std::cos(double(i));
+    }
+
+    Opm::SegmentTreeJacobian tree(outlet, bs);
+    BOOST_REQUIRE(tree.assemble(jacobian));
+    BOOST_REQUIRE(tree.factorize());
+    const Eigen::VectorXd x = tree.solve(rhs);
+
+    Sp compressed = jacobian;
+    compressed.makeCompressed();
+    const Eigen::SparseLU<Sp> lu(compressed);
+    const Eigen::VectorXd reference = lu.solve(rhs);
+
+    BOOST_REQUIRE_EQUAL(x.size(), n);
+    for (int i = 0; i < n; ++i) {
+        BOOST_CHECK_CLOSE(x[i], reference[i], 1e-9);
+    }
+    BOOST_CHECK_SMALL((jacobian * x - rhs).norm(), 1e-12);
+}
+
+BOOST_AUTO_TEST_CASE(RejectsCouplingOfBranches)
+{
+    const std::vector<int> outlet = outlets();
+    const int bs = 2;
+    const int nseg = outlet.size();
+    Sp jacobian = segmentJacobian(outlet, bs);
+
+    // segments 3 and 4 are on different branches of the first well
+    Opm::SegmentTreeJacobian tree(outlet, bs);
+    Sp coupled = jacobian;
+    coupled.coeffRef(3, nseg + 4) = 1.0;
+    BOOST_CHECK(!tree.assemble(coupled));
+
+    // as are segments of different wells
+    Opm::SegmentTreeJacobian other(outlet, bs);
+    coupled = jacobian;
+    coupled.coeffRef(6, 2) = 1.0;
+    BOOST_CHECK(!other.assemble(coupled));
+}
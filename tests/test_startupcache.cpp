@@ -0,0 +1,88 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE StartupCacheTest
+
+#include <opm/autodiff/StartupCache.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(WriteAndMap)
+{
+    Opm::StartupCache::Arrays arrays;
+    arrays["TRANX"] = { 1.0, 2.5, -3.0 };
+    arrays["NNC_TRANS"] = { 0.125 };
+    arrays["EMPTY"] = {};
+    Opm::StartupCache::write("startup_cache_test.bin", 42, arrays);
+
+    Opm::StartupCache cache("startup_cache_test.bin", 42);
+    BOOST_REQUIRE(cache.valid());
+    BOOST_CHECK(cache.has("EMPTY"));
+    BOOST_CHECK(!cache.has("TRANY"));
+    BOOST_CHECK_EQUAL(cache.array("TRANY").size, 0u);
+
+    for (const auto& array : arrays) {
+        const Opm::StartupCache::ArrayView view = cache.array(array.first);
+        const std::vector<double> values(view.begin(), view.end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(),
+                                      array.second.begin(), array.second.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(KeyMismatch)
+{
+    Opm::StartupCache::Arrays arrays;
+    arrays["TRANX"] = { 1.0 };
+    Opm::StartupCache::write("startup_cache_key.bin", 1, arrays);
+
+    Opm::StartupCache cache("startup_cache_key.bin", 2);
+    BOOST_CHECK(!cache.valid());
+    BOOST_CHECK(!cache.has("TRANX"));
+
+    Opm::StartupCache missing("startup_cache_missing.bin", 1);
+    BOOST_CHECK(!missing.valid());
+}
+
+BOOST_AUTO_TEST_CASE(HashFile)
+{
+    {
+        std::ofstream file("startup_cache_deck.data");
+        file << "RUNSPEC\nDIMENS\n 10 10 3 /\n";
+    }
+    const std::uint64_t hash = Opm::StartupCache::hashFile("startup_cache_deck.data");
+    BOOST_CHECK_EQUAL(hash, Opm::StartupCache::hashFile("startup_cache_deck.data"));
+    BOOST_CHECK(hash != Opm::StartupCache::hashFile("startup_cache_deck.data", 1));
+    BOOST_CHECK(Opm::StartupCache::hashCombine(hash, 300) != Opm::StartupCache::hashCombine(hash, 301));
+
+    {
+        std::ofstream file("startup_cache_deck.data");
+        file << "RUNSPEC\nDIMENS\n 10 10 4 /\n";
+    }
+    BOOST_CHECK(hash != Opm::StartupCache::hashFile("startup_cache_deck.data"));
+}
@@ -0,0 +1,89 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE StartupProfileTest
+
+#include <opm/autodiff/StartupProfile.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Two processes, the other one took twice as long and used twice the
+    // memory.
+    struct TwoProcesses
+    {
+        int rank() const { return 0; }
+        int size() const { return 2; }
+        template <class T>
+        int max(T* values, const int n) const
+        {
+            for (int i = 0; i < n; ++i) {
+                values[i] *= 2;
+            }
+            return 0;
+        }
+    };
+}
+
+
+BOOST_AUTO_TEST_CASE(RecordSteps)
+{
+    Opm::StartupProfile profile;
+    BOOST_CHECK_EQUAL(profile.numSteps(), 0);
+    profile.endStep("deck and grid");
+    profile.endStep("state");
+    BOOST_REQUIRE_EQUAL(profile.numSteps(), 2);
+    BOOST_CHECK_EQUAL(profile.name(0), "deck and grid");
+    BOOST_CHECK_EQUAL(profile.name(1), "state");
+    for (int i = 0; i < profile.numSteps(); ++i) {
+        BOOST_CHECK(profile.value(i, Opm::StartupProfile::Time) >= 0.0);
+        BOOST_CHECK(profile.value(i, Opm::StartupProfile::HighWaterMark) >= 0.0);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(Report)
+{
+    Opm::StartupProfile profile;
+    profile.endStep("deck and grid");
+    profile.endStep("linear solver");
+
+    const std::vector<double> values = { 1.5, 2048.0, 4096.0,
+                                         0.25, 3072.0, 4096.0 };
+    const std::string table = profile.format(values, 4);
+    BOOST_CHECK(table.find("over 4 processes") != std::string::npos);
+    BOOST_CHECK(table.find("deck and grid") != std::string::npos);
+    BOOST_CHECK(table.find("1.500") != std::string::npos);
+    BOOST_CHECK(table.find("3.0") != std::string::npos);
+    BOOST_CHECK(table.find("1.750") != std::string::npos);
+
+    const std::string reduced = profile.report(TwoProcesses());
+    BOOST_CHECK(reduced.find("over 2 processes") != std::string::npos);
+    BOOST_CHECK(reduced.find("linear solver") != std::string::npos);
+}
@@ -0,0 +1,149 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE SubdomainPartitionTest
+
+#include <opm/autodiff/SubdomainPartition.hpp>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+namespace
+{
+    typedef Dune::FieldMatrix<double, 1, 1> Block;
+    typedef Dune::BCRSMatrix<Block> Matrix;
+    typedef Dune::BlockVector<Dune::FieldVector<double, 1> > Vector;
+
+    // 5-point Laplacian on a nx by ny grid, the off-diagonal entries
+    // encode their row and column.
+    Matrix laplacian(const int nx, const int ny)
+    {
+        const int n = nx * ny;
+        Matrix A(n, n, 5*n, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            const int i = row.index() % nx;
+            const int j = row.index() / nx;
+            if (j > 0)      row.insert(row.index() - nx);
+            if (i > 0)      row.insert(row.index() - 1);
+            row.insert(row.index());
+            if (i < nx - 1) row.insert(row.index() + 1);
+            if (j < ny - 1) row.insert(row.index() + nx);
+        }
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            for (auto col = row->begin(); col != row->end(); ++col) {
+                *col = col.index() == row.index() ? 4.0 : -(1.0 + row.index() + 0.001 * col.index());
+            }
+        }
+        return A;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(BalancedDisjointSubdomains)
+{
+    const Matrix A = laplacian(12, 10);
+    const Opm::SubdomainPartition partition(A, 4);
+    BOOST_CHECK_EQUAL(partition.numDomains(), 4);
+
+    std::vector<int> seen(A.N(), 0);
+    for (int d = 0; d < partition.numDomains(); ++d) {
+        BOOST_CHECK_EQUAL(partition.rows(d).size(), 30u);
+        for (const int row : partition.rows(d)) {
+            BOOST_CHECK_EQUAL(partition.domain(row), d);
+            ++seen[row];
+        }
+    }
+    for (const int count : seen) {
+        BOOST_CHECK_EQUAL(count, 1);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(MoreSubdomainsThanRows)
+{
+    const Matrix A = laplacian(2, 2);
+    const Opm::SubdomainPartition partition(A, 10);
+    BOOST_CHECK_EQUAL(partition.numDomains(), 4);
+}
+
+
+BOOST_AUTO_TEST_CASE(SubdomainMatrixDropsCouplings)
+{
+    Matrix A = laplacian(6, 5);
+    const Opm::SubdomainPartition partition(A, 3);
+    for (int d = 0; d < partition.numDomains(); ++d) {
+        const std::vector<int>& rows = partition.rows(d);
+        Matrix local;
+        partition.createMatrix(A, d, local);
+        BOOST_REQUIRE_EQUAL(local.N(), rows.size());
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            for (std::size_t j = 0; j < rows.size(); ++j) {
+                const bool coupled = A.exists(rows[i], rows[j]);
+                BOOST_CHECK_EQUAL(local.exists(i, j), coupled);
+                if (coupled) {
+                    BOOST_CHECK_EQUAL(local[i][j][0][0], A[rows[i]][rows[j]][0][0]);
+                }
+            }
+        }
+
+        // new values of A are copied into the existing pattern
+        A *= 2.0;
+        partition.copyMatrixValues(A, d, local);
+        BOOST_CHECK_EQUAL(local[0][0][0][0], A[rows[0]][rows[0]][0][0]);
+        A *= 0.5;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(RestrictAndProlongate)
+{
+    const Matrix A = laplacian(4, 4);
+    const Opm::SubdomainPartition partition(A, 2);
+    Vector global(A.N());
+    for (std::size_t i = 0; i < global.size(); ++i) {
+        global[i] = i;
+    }
+
+    Vector local;
+    partition.restrictVector(global, 1, local);
+    const std::vector<int>& rows = partition.rows(1);
+    BOOST_REQUIRE_EQUAL(local.size(), rows.size());
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        BOOST_CHECK_EQUAL(local[i][0], rows[i]);
+    }
+
+    local *= -1.0;
+    partition.prolongateVector(local, 1, global);
+    for (std::size_t i = 0; i < global.size(); ++i) {
+        const double expected = partition.domain(i) == 1 ? -double(i) : double(i);
+        BOOST_CHECK_EQUAL(global[i][0], expected);
+    }
+}
@@ -0,0 +1,106 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE SumAndMaxReductionTest
+#define BOOST_TEST_NO_MAIN
+
+#include <opm/autodiff/SumAndMaxReduction.hpp>
+#include <opm/autodiff/LoadImbalanceMonitor.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#if HAVE_MPI
+BOOST_AUTO_TEST_CASE(SumsAndMaxima)
+{
+    int rank = 0;
+    int size = 1;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    std::vector<double> sums = { 1.0, double(rank), -0.5 };
+    std::vector<double> maxima = { double(rank), -double(rank), 2.0, double(size - rank) };
+    Opm::sumAndMaxAllReduce(MPI_COMM_WORLD, sums, maxima);
+
+    BOOST_CHECK_EQUAL(sums[0], double(size));
+    BOOST_CHECK_EQUAL(sums[1], double(size * (size - 1) / 2));
+    BOOST_CHECK_EQUAL(sums[2], -0.5 * size);
+    BOOST_CHECK_EQUAL(maxima[0], double(size - 1));
+    BOOST_CHECK_EQUAL(maxima[1], 0.0);
+    BOOST_CHECK_EQUAL(maxima[2], 2.0);
+    BOOST_CHECK_EQUAL(maxima[3], double(size));
+
+    // without any sums
+    std::vector<double> noSums;
+    std::vector<double> onlyMaxima = { double(rank) };
+    Opm::sumAndMaxAllReduce(MPI_COMM_WORLD, noSums, onlyMaxima);
+    BOOST_CHECK_EQUAL(onlyMaxima[0], double(size - 1));
+}
+
+BOOST_AUTO_TEST_CASE(LoadImbalance)
+{
+    int rank = 0;
+    int size = 1;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    Opm::LoadImbalanceMonitor monitor(1.2, true);
+    monitor.setCommunicator(MPI_COMM_WORLD);
+    BOOST_CHECK_EQUAL(monitor.update(2.0), 1.0);
+    BOOST_CHECK(!monitor.stopRequested());
+
+    // the last process takes twice as long as the others
+    const double imbalance = monitor.update(rank == size - 1 ? 2.0 : 1.0);
+    BOOST_CHECK_CLOSE(imbalance, 2.0 * size / (size + 1), 1.0e-12);
+    BOOST_CHECK_EQUAL(monitor.stopRequested(), size > 1);
+
+    Opm::LoadImbalanceMonitor disabled(0.0, true);
+    BOOST_CHECK(!disabled.active());
+    BOOST_CHECK(!disabled.stopRequested());
+}
+#else
+BOOST_AUTO_TEST_CASE(NoMPI)
+{
+}
+#endif
+
+bool
+init_unit_test_func()
+{
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+#if HAVE_MPI
+    MPI_Init(&argc, &argv);
+#endif
+    const int result = boost::unit_test::unit_test_main(&init_unit_test_func, argc, argv);
+#if HAVE_MPI
+    MPI_Finalize();
+#endif
+    return result;
+}
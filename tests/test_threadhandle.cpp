@@ -0,0 +1,135 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE ThreadHandleTest
+
+#include <opm/autodiff/ThreadHandle.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // appends its value to a log shared by all tasks
+    struct AppendTask
+    {
+        std::vector<int>* log;
+        std::mutex* mutex;
+        int value;
+
+        void run()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            std::lock_guard<std::mutex> lock(*mutex);
+            log->push_back(value);
+        }
+    };
+
+    // waits until another task has set the flag, gives up after a second
+    struct WaitTask
+    {
+        std::atomic<bool>* flag;
+        std::atomic<bool>* seen;
+
+        void run()
+        {
+            for (int i = 0; i < 1000 && !*flag; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            *seen = flag->load();
+        }
+    };
+
+    struct SetTask
+    {
+        std::atomic<bool>* flag;
+
+        void run() { *flag = true; }
+    };
+
+    struct ThrowTask
+    {
+        void run() { throw std::runtime_error("write failed"); }
+    };
+}
+
+BOOST_AUTO_TEST_CASE(ChannelsKeepOrder)
+{
+    std::vector<int> log;
+    std::mutex mutex;
+    {
+        Opm::ThreadHandle pool(true, 3, 2);
+        BOOST_CHECK_EQUAL(pool.numThreads(), 3);
+        for (int i = 0; i < 20; ++i) {
+            pool.dispatch(AppendTask{&log, &mutex, i}, i % 2);
+        }
+        pool.wait();
+        BOOST_CHECK_EQUAL(log.size(), 20u);
+        // destruction executes the remaining objects
+        for (int i = 20; i < 30; ++i) {
+            pool.dispatch(AppendTask{&log, &mutex, i}, i % 2);
+        }
+    }
+    BOOST_REQUIRE_EQUAL(log.size(), 30u);
+
+    // the values of one channel appear in the order of dispatch
+    int last[2] = { -1, -1 };
+    for (const int value : log) {
+        BOOST_CHECK(value > last[value % 2]);
+        last[value % 2] = value;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ChannelsRunInParallel)
+{
+    std::atomic<bool> flag(false);
+    std::atomic<bool> seen(false);
+    {
+        Opm::ThreadHandle pool(true, 2, 1);
+        pool.dispatch(WaitTask{&flag, &seen}, 0);
+        pool.dispatch(SetTask{&flag}, 1);
+        pool.wait();
+    }
+    BOOST_CHECK(seen);
+}
+
+BOOST_AUTO_TEST_CASE(ErrorsAreRethrown)
+{
+    Opm::ThreadHandle pool(true, 1, 1);
+    pool.dispatch(ThrowTask());
+    BOOST_CHECK_THROW(pool.wait(), std::runtime_error);
+    // the error is reported once
+    pool.wait();
+
+    Opm::ThreadHandle noThreads(false);
+    BOOST_CHECK_EQUAL(noThreads.numThreads(), 0);
+    BOOST_CHECK_THROW(noThreads.dispatch(ThrowTask()), std::logic_error);
+}
@@ -0,0 +1,106 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE TimerTreeTest
+
+#include <opm/autodiff/TimerTree.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    // A single process.
+    struct SerialComm
+    {
+        int rank() const { return 0; }
+        int size() const { return 1; }
+        template <class T>
+        int broadcast(T*, int, int) const { return 0; }
+        template <class T>
+        int sum(T*, int) const { return 0; }
+        template <class T>
+        int min(T*, int) const { return 0; }
+        template <class T>
+        int max(T*, int) const { return 0; }
+    };
+}
+
+
+BOOST_AUTO_TEST_CASE(NestedRegions)
+{
+    Opm::TimerTree::reset();
+    Opm::TimerTree::enable();
+    for (int i = 0; i < 3; ++i) {
+        Opm::TimerTree::Region assembly("assembly");
+        {
+            Opm::TimerTree::Region wells("well assembly");
+            Opm::TimerTree::Region vfp("VFP");
+        }
+    }
+    {
+        Opm::TimerTree::Region solve("linear solve");
+    }
+    Opm::TimerTree::enable(false);
+    {
+        Opm::TimerTree::Region ignored("output");
+    }
+
+    std::vector<std::string> paths;
+    std::vector<double> seconds;
+    std::vector<double> calls;
+    Opm::TimerTree::localRegions(paths, seconds, calls);
+    const std::vector<std::string> expected = {
+        "assembly", "assembly\twell assembly", "assembly\twell assembly\tVFP", "linear solve"
+    };
+    BOOST_CHECK_EQUAL_COLLECTIONS(paths.begin(), paths.end(), expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(calls[0], 3.0);
+    BOOST_CHECK_EQUAL(calls[2], 3.0);
+    BOOST_CHECK_EQUAL(calls[3], 1.0);
+    // a region takes at least the time of its children
+    BOOST_CHECK(seconds[0] >= seconds[1]);
+    BOOST_CHECK(seconds[1] >= seconds[2]);
+
+    const std::string report = Opm::TimerTree::report(SerialComm());
+    BOOST_CHECK(report.find("\n    VFP") != std::string::npos);
+    BOOST_CHECK(report.find("output") == std::string::npos);
+    Opm::TimerTree::reset();
+}
+
+
+BOOST_AUTO_TEST_CASE(InsertAfterDescendants)
+{
+    // the regions of another process are inserted below their parents
+    std::vector<std::string> paths = { "a", "a\tb", "a\tb\tc", "d" };
+    BOOST_CHECK_EQUAL(Opm::TimerTree::insertRegion(paths, "a\tb\tc"), 2);
+    BOOST_CHECK_EQUAL(Opm::TimerTree::insertRegion(paths, "a\te"), 3);
+    BOOST_CHECK_EQUAL(Opm::TimerTree::insertRegion(paths, "d\tf"), 5);
+    BOOST_CHECK_EQUAL(Opm::TimerTree::insertRegion(paths, "g"), 6);
+    const std::vector<std::string> expected = { "a", "a\tb", "a\tb\tc", "a\te", "d", "d\tf", "g" };
+    BOOST_CHECK_EQUAL_COLLECTIONS(paths.begin(), paths.end(), expected.begin(), expected.end());
+}
@@ -0,0 +1,91 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE TimeStepControlTest
+
+#include <opm/simulators/timestepping/TimeStepControl.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+namespace
+{
+    struct NoChange : public Opm::RelativeChangeInterface
+    {
+        double relativeChange() const { return 0.0; }
+    };
+
+    const double day = 86400.0;
+
+    // wall time of 2 s per Newton and 0.1 s per linear iteration
+    double wallTime(const int newton, const int linear)
+    {
+        return 2.0 * newton + 0.1 * linear;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CostModelFitsIterations)
+{
+    Opm::CostModelTimeStepControl control(0.33, 3.0);
+    control.recordStep(1.0 * day, true, 4, 40, wallTime(4, 40));
+    control.recordStep(2.0 * day, true, 5, 60, wallTime(5, 60));
+    control.recordStep(4.0 * day, true, 6, 90, wallTime(6, 90));
+
+    BOOST_CHECK_CLOSE(control.predictedCost(4.0 * day), wallTime(6, 90), 1e-6);
+    // more iterations for longer steps
+    BOOST_CHECK_GT(control.predictedCost(8.0 * day), control.predictedCost(4.0 * day));
+    BOOST_CHECK_EQUAL(control.failureProbability(100.0 * day), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(GrowsWithoutFailures)
+{
+    Opm::CostModelTimeStepControl control(0.33, 3.0);
+    control.recordStep(1.0 * day, true, 4, 40, wallTime(4, 40));
+    control.recordStep(2.0 * day, true, 5, 50, wallTime(5, 50));
+
+    const NoChange noChange;
+    const double dt = control.computeTimeStepSize(2.0 * day, 50, noChange, 3.0 * day);
+    BOOST_CHECK_CLOSE(dt, 6.0 * day, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(AvoidsFailingStepSizes)
+{
+    Opm::CostModelTimeStepControl control(0.33, 3.0);
+    control.recordStep(1.0 * day, true, 4, 40, wallTime(4, 40));
+    control.recordStep(3.0 * day, true, 5, 50, wallTime(5, 50));
+    // a step of 9 days fails after many iterations and is chopped
+    control.recordStep(9.0 * day, false, 15, 300, wallTime(15, 300));
+    control.recordStep(3.0 * day, true, 5, 50, wallTime(5, 50));
+
+    BOOST_CHECK_GT(control.failureProbability(9.0 * day), 0.4);
+    BOOST_CHECK_LT(control.failureProbability(3.0 * day), 0.2);
+    BOOST_CHECK_GT(control.expectedRate(4.0 * day), control.expectedRate(9.0 * day));
+
+    const NoChange noChange;
+    const double dt = control.computeTimeStepSize(3.0 * day, 50, noChange, 7.0 * day);
+    BOOST_CHECK_GT(dt, 3.0 * day);
+    BOOST_CHECK_LT(dt, 9.0 * day);
+}
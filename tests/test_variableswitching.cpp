@@ -0,0 +1,123 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE VariableSwitchingTest
+
+#include <opm/autodiff/VariableSwitching.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(ChopSaturations)
+{
+    // negative gas, negative oil, negative water and none of them
+    std::vector<double> sw = {  0.2,  0.5, -0.1, 0.3 };
+    std::vector<double> so = {  0.9, -0.2,  0.6, 0.3 };
+    std::vector<double> sg = { -0.1,  0.7,  0.5, 0.4 };
+    Opm::detail::chopSaturations(4, sw.data(), so.data(), sg.data());
+
+    BOOST_CHECK_EQUAL(sg[0], 0.0);
+    BOOST_CHECK_CLOSE(sw[0], 0.2 / 1.1, 1e-12);
+    BOOST_CHECK_CLOSE(so[0], 0.9 / 1.1, 1e-12);
+
+    BOOST_CHECK_EQUAL(so[1], 0.0);
+    BOOST_CHECK_CLOSE(sw[1], 0.5 / 1.2, 1e-12);
+    BOOST_CHECK_CLOSE(sg[1], 0.7 / 1.2, 1e-12);
+
+    BOOST_CHECK_EQUAL(sw[2], 0.0);
+    BOOST_CHECK_CLOSE(so[2], 0.6 / 1.1, 1e-12);
+    BOOST_CHECK_CLOSE(sg[2], 0.5 / 1.1, 1e-12);
+
+    BOOST_CHECK_EQUAL(sw[3], 0.3);
+    BOOST_CHECK_EQUAL(so[3], 0.3);
+    BOOST_CHECK_EQUAL(sg[3], 0.4);
+}
+
+
+BOOST_AUTO_TEST_CASE(ChopSaturationsWithoutWater)
+{
+    std::vector<double> so = { -0.25, 1.0 };
+    std::vector<double> sg = {  1.0,  0.0 };
+    Opm::detail::chopSaturations(2, nullptr, so.data(), sg.data());
+    BOOST_CHECK_EQUAL(so[0], 0.0);
+    BOOST_CHECK_CLOSE(sg[0], 1.0 / 1.25, 1e-12);
+    BOOST_CHECK_EQUAL(so[1], 1.0);
+    BOOST_CHECK_EQUAL(sg[1], 0.0);
+}
+
+
+BOOST_AUTO_TEST_CASE(SwitchDissolvedGas)
+{
+    using Opm::HydroCarbonState;
+    // cells: free gas with Sg primary, undersaturated with Rs primary,
+    // Rs primary exceeding the saturated value, water only
+    const std::vector<double> sw     = { 0.2, 0.2, 0.2, 1.0 };
+    const std::vector<double> isRs   = { 0.0, 1.0, 1.0, 0.0 };
+    const std::vector<double> rsSat  = { 100.0, 100.0, 100.0, 100.0 };
+    const std::vector<double> rsSat0 = { 100.0, 100.0, 100.0, 100.0 };
+    const std::vector<double> rsOld  = { 100.0, 50.0, 100.0, 100.0 };
+    std::vector<double> so = { 0.5, 0.8, 0.8, 0.1 };
+    std::vector<double> sg = { 0.3, 0.0, 0.0, 0.1 };
+    std::vector<double> rs = { 90.0, 60.0, 120.0, 90.0 };
+    std::vector<HydroCarbonState> state(4, HydroCarbonState::GasAndOil);
+    Opm::detail::switchDissolvedGas(4, sw.data(), isRs.data(), rsSat.data(), rsSat0.data(), rsOld.data(),
+                                    so.data(), sg.data(), rs.data(), state.data());
+
+    BOOST_CHECK(state[0] == HydroCarbonState::GasAndOil);
+    BOOST_CHECK_EQUAL(rs[0], 100.0);
+    BOOST_CHECK(state[1] == HydroCarbonState::OilOnly);
+    BOOST_CHECK_EQUAL(rs[1], 60.0);
+    BOOST_CHECK(state[2] == HydroCarbonState::GasAndOil);
+    BOOST_CHECK_EQUAL(rs[2], 100.0);
+    BOOST_CHECK(state[3] == HydroCarbonState::GasAndOil);
+    BOOST_CHECK_EQUAL(rs[3], 0.0);
+    BOOST_CHECK_EQUAL(so[3], 0.0);
+    BOOST_CHECK_EQUAL(sg[3], 0.0);
+    BOOST_CHECK_EQUAL(so[0], 0.5);
+    BOOST_CHECK_EQUAL(sg[0], 0.3);
+}
+
+
+BOOST_AUTO_TEST_CASE(SwitchVaporizedOil)
+{
+    using Opm::HydroCarbonState;
+    // cells: oil present with Sg primary, undersaturated gas with Rv primary
+    const std::vector<double> isRv   = { 0.0, 1.0 };
+    const std::vector<double> rvSat  = { 1e-4, 1e-4 };
+    const std::vector<double> rvSat0 = { 1e-4, 1e-4 };
+    const std::vector<double> rvOld  = { 1e-4, 5e-5 };
+    std::vector<double> so = { 0.4, 0.0 };
+    std::vector<double> sg = { 0.6, 1.0 };
+    std::vector<double> rv = { 5e-5, 6e-5 };
+    std::vector<HydroCarbonState> state(2, HydroCarbonState::GasAndOil);
+    Opm::detail::switchVaporizedOil(2, nullptr, isRv.data(), rvSat.data(), rvSat0.data(), rvOld.data(),
+                                    so.data(), sg.data(), rv.data(), state.data());
+
+    BOOST_CHECK(state[0] == HydroCarbonState::GasAndOil);
+    BOOST_CHECK_EQUAL(rv[0], 1e-4);
+    BOOST_CHECK(state[1] == HydroCarbonState::GasOnly);
+    BOOST_CHECK_EQUAL(rv[1], 6e-5);
+}
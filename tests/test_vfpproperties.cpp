@@ -27,6 +27,7 @@
 #define BOOST_TEST_MODULE AutoDiffBlockTest
 
 #include <algorithm>
+#include <cmath>
 #include <memory>
 #include <map>
 #include <sstream>
@@ -108,6 +109,69 @@ BOOST_AUTO_TEST_CASE(findInterpData)
     BOOST_CHECK_EQUAL(eval5.factor_, 1.0);
 }
 
+BOOST_AUTO_TEST_CASE(findInterpDataBracket)
+{
+    std::vector<double> values = {1, 5, 7, 9, 11, 15};
+    std::vector<double> points = {9.0, 6.0, -1.0, 19.0, 1.0, 15.0, 11.0, 5.0, 14.0};
+
+    //Any starting bracket must give the result of the plain search
+    for (int start = -1; start < 6; ++start) {
+        int bracket = start;
+        for (double point : points) {
+            Opm::detail::InterpData expected = Opm::detail::findInterpData(point, values);
+            Opm::detail::InterpData eval = Opm::detail::findInterpData(point, values, bracket);
+            BOOST_CHECK_EQUAL(eval.ind_[0], expected.ind_[0]);
+            BOOST_CHECK_EQUAL(eval.ind_[1], expected.ind_[1]);
+            BOOST_CHECK_EQUAL(eval.factor_, expected.factor_);
+            BOOST_CHECK_EQUAL(bracket, expected.ind_[0]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hypercellTable)
+{
+    //A table with a single value on the alq axis
+    const std::vector<double> thp_axis = {0.0, 1.0, 3.0};
+    const std::vector<double> wfr_axis = {0.0, 0.5};
+    const std::vector<double> gfr_axis = {0.0, 0.25, 1.0};
+    const std::vector<double> alq_axis = {0.0};
+    const std::vector<double> flo_axis = {0.0, 1.0, 2.0, 4.0};
+    Opm::VFPProdTable::extents size = {{3, 2, 3, 1, 4}};
+    Opm::VFPProdTable::array_type data(size);
+    int n = 0;
+    for (int i=0; i<3; ++i) {
+        for (int j=0; j<2; ++j) {
+            for (int k=0; k<3; ++k) {
+                for (int m=0; m<4; ++m) {
+                    data[i][j][k][0][m] = std::sin(++n);
+                }
+            }
+        }
+    }
+
+    const Opm::detail::VFPHypercellTable hypercells(data);
+    const std::vector<double> points = {-0.5, 0.3, 0.9, 1.7, 3.5};
+    for (double t : points) {
+        for (double g : points) {
+            for (double f : points) {
+                auto flo_i = Opm::detail::findInterpData(f, flo_axis);
+                auto thp_i = Opm::detail::findInterpData(t, thp_axis);
+                auto wfr_i = Opm::detail::findInterpData(0.5*g, wfr_axis);
+                auto gfr_i = Opm::detail::findInterpData(g, gfr_axis);
+                auto alq_i = Opm::detail::findInterpData(0.7, alq_axis);
+
+                double expected[32];
+                Opm::detail::gatherCorners(data, flo_i, thp_i, wfr_i, gfr_i, alq_i, expected);
+                const double* corners = hypercells.corners(flo_i, thp_i, wfr_i, gfr_i, alq_i);
+                BOOST_CHECK_EQUAL_COLLECTIONS(corners, corners + 32, expected, expected + 32);
+
+                const Opm::detail::VFPEvaluation eval = Opm::detail::interpolate(data, flo_i, thp_i, wfr_i, gfr_i, alq_i);
+                BOOST_CHECK_CLOSE(Opm::detail::interpolateValue(corners, flo_i, thp_i, wfr_i, gfr_i, alq_i), eval.value, max_d_tol);
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END() // HelperTests
 
 
@@ -982,6 +1046,52 @@ BOOST_AUTO_TEST_CASE(THPToBHPAndBackNonTrivial)
 
 
 
+BOOST_AUTO_TEST_CASE(BatchedBHPAndTHP)
+{
+    fillDataRandom();
+    initProperties();
+
+    const std::vector<int> table_id = {1, 1, 1, -1};
+    const std::vector<double> aqua = {-0.5, -0.15, -1.5, -0.5};
+    const std::vector<double> liquid = {-0.9, -0.25, -0.3, -0.9};
+    const std::vector<double> vapour = {-0.1, -0.35, -0.2, -0.1};
+    const std::vector<double> thp = {50.0, 0.45, 12.0, 50.0};
+    const std::vector<double> alq = {32.9, 0.55, 0.9, 32.9};
+
+    Opm::detail::VFPBrackets brackets;
+    std::vector<double> bhp;
+    //The second evaluation starts from the intervals of the first
+    for (int repeat = 0; repeat < 2; ++repeat) {
+        properties->bhp(table_id, aqua, liquid, vapour, thp, alq, bhp, brackets);
+        BOOST_REQUIRE_EQUAL(bhp.size(), table_id.size());
+        BOOST_REQUIRE_EQUAL(brackets.size(), table_id.size());
+        for (int i = 0; i < 3; ++i) {
+            const double reference = properties->bhp(table_id[i], aqua[i], liquid[i], vapour[i], thp[i], alq[i]);
+            BOOST_CHECK_CLOSE(bhp[i], reference, max_d_tol);
+        }
+        BOOST_CHECK_EQUAL(bhp[3], -1e100);
+    }
+
+    const std::vector<int> prod_table_id(table_id.begin(), table_id.begin() + 3);
+    const std::vector<double> prod_bhp(bhp.begin(), bhp.begin() + 3);
+    std::vector<double> thp_val;
+    Opm::detail::VFPBrackets thp_brackets;
+    properties->thp(prod_table_id,
+                    std::vector<double>(aqua.begin(), aqua.begin() + 3),
+                    std::vector<double>(liquid.begin(), liquid.begin() + 3),
+                    std::vector<double>(vapour.begin(), vapour.begin() + 3),
+                    prod_bhp,
+                    std::vector<double>(alq.begin(), alq.begin() + 3),
+                    thp_val, thp_brackets);
+    for (int i = 0; i < 3; ++i) {
+        const double reference = properties->thp(table_id[i], aqua[i], liquid[i], vapour[i], prod_bhp[i], alq[i]);
+        BOOST_CHECK_CLOSE(thp_val[i], reference, max_d_tol);
+    }
+}
+
+
+
+
 BOOST_AUTO_TEST_SUITE_END() // Trivial tests
 
 
@@ -0,0 +1,80 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE WellChangeTrackerTest
+
+#include <opm/autodiff/WellChangeTracker.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+namespace
+{
+    std::vector<bool> flags(std::initializer_list<bool> values)
+    {
+        return std::vector<bool>(values);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ZeroToleranceUpdatesAll)
+{
+    Opm::WellChangeTracker tracker;
+    const std::vector<double> values = { 1.0, 2.0, 3.0 };
+    const std::vector<int> offsets = { 0, 2, 3 };
+    BOOST_CHECK(tracker.update(values, offsets) == flags({ true, true }));
+    BOOST_CHECK(tracker.update(values, offsets) == flags({ true, true }));
+}
+
+BOOST_AUTO_TEST_CASE(OnlyChangedWells)
+{
+    Opm::WellChangeTracker tracker(1e-3, 4);
+    const std::vector<int> offsets = { 0, 2, 3, 3 };
+    std::vector<double> values = { 100.0, 0.0, 50.0 };
+
+    // first call and wells without values
+    BOOST_CHECK(tracker.update(values, offsets) == flags({ true, true, true }));
+
+    // small changes accumulate relative to the last recomputation
+    values[0] = 100.05;
+    BOOST_CHECK(tracker.update(values, offsets) == flags({ false, false, false }));
+    values[0] = 100.2;
+    values[2] = 50.0;
+    BOOST_CHECK(tracker.update(values, offsets) == flags({ true, false, false }));
+
+    BOOST_CHECK(tracker.update(values, offsets) == flags({ false, false, false }));
+
+    // every fourth call updates all wells
+    BOOST_CHECK(tracker.update(values, offsets) == flags({ true, true, true }));
+    values[2] = 50.1;
+    BOOST_CHECK(tracker.update(values, offsets) == flags({ false, true, false }));
+
+    // a different number of wells forces a full update
+    const std::vector<double> fewer = { 100.2, 1e-10 };
+    BOOST_CHECK(tracker.update(fewer, { 0, 2 }) == flags({ true }));
+
+    tracker.reset();
+    BOOST_CHECK(tracker.update(fewer, { 0, 2 }) == flags({ true }));
+}
@@ -117,3 +117,46 @@ BOOST_AUTO_TEST_CASE(TestPressureDeltas)
         BOOST_CHECK_CLOSE(dp[i], answer[i], 1e-8);
     }
 }
+
+BOOST_AUTO_TEST_CASE(TestDepthDifferences)
+{
+    // Two wells with different reference depths.
+    const int np = 3;
+    const int nperf = 5;
+    const double comp_frac[np] = { 1.0, 0.0, 0.0 };
+    const int cells[nperf] = { 0, 1, 2, 3, 4 };
+    const double WI[nperf] = { 1.0, 1.0, 1.0, 1.0, 1.0 };
+    const bool allow_crossflow = true;
+    std::shared_ptr<Wells> wells(create_wells(np, 2, nperf), destroy_wells);
+    BOOST_REQUIRE(wells);
+    int ok = add_well(INJECTOR, 5.0, 3, comp_frac, cells, WI, 0, "INJ", allow_crossflow, wells.get());
+    BOOST_REQUIRE(ok);
+    ok = add_well(PRODUCER, 20.0, 2, comp_frac, cells + 3, WI, 0, "PROD", allow_crossflow, wells.get());
+    BOOST_REQUIRE(ok);
+
+    const std::vector<double> z_perf = { 10, 30, 25, 40, 70 };
+    const std::vector<double> dens_perf = { 1000.0, 900.0, 800.0, 700.0, 600.0 };
+    const double gravity = Opm::unit::gravity;
+
+    const std::vector<double> dz =
+            WellDensitySegmented::computePerforationDepthDifferences(*wells, z_perf);
+    const std::vector<double> dz_answer = { 5.0, 20.0, -5.0, 20.0, 30.0 };
+    BOOST_REQUIRE_EQUAL(dz.size(), dz_answer.size());
+    for (size_t i = 0; i < dz.size(); ++i) {
+        BOOST_CHECK_CLOSE(dz[i], dz_answer[i], 1e-8);
+    }
+
+    const std::vector<double> dp =
+            WellDensitySegmented::computeConnectionPressureDelta(
+                    *wells, z_perf, dens_perf, gravity);
+    const std::vector<double> dp_dz =
+            WellDensitySegmented::computeConnectionPressureDeltaFromDepthDifferences(
+                    *wells, dz, dens_perf, gravity);
+    const std::vector<double> answer = { 5e3*gravity, 23e3*gravity, 19e3*gravity, 14e3*gravity, 32e3*gravity };
+    BOOST_REQUIRE_EQUAL(dp.size(), answer.size());
+    BOOST_REQUIRE_EQUAL(dp_dz.size(), answer.size());
+    for (size_t i = 0; i < dp.size(); ++i) {
+        BOOST_CHECK_CLOSE(dp[i], answer[i], 1e-8);
+        BOOST_CHECK_CLOSE(dp_dz[i], answer[i], 1e-8);
+    }
+}
@@ -50,6 +50,27 @@ BOOST_AUTO_TEST_CASE(wellswitchlog)
 
 }
 
+BOOST_AUTO_TEST_CASE(wellswitchlogdeferred)
+{
+    auto cc = Dune::MPIHelper::getCollectiveCommunication();
+
+    Opm::wellhelpers::WellSwitchingLogger logger(cc, true);
+    // nothing to gather
+    logger.flush();
+
+    std::ostringstream name;
+    name <<"Well on rank "<<cc.rank()<<std::flush;
+    if ( cc.rank() % 2 == 1 )
+    {
+        logger.wellSwitched(name.str(), BHP, THP);
+        logger.wellSwitched(name.str(), THP, BHP);
+    }
+    logger.flush();
+
+    // logged by the destructor
+    logger.wellSwitched(name.str(), BHP, SURFACE_RATE);
+}
+
 int main(int argc, char** argv)
 {
     Dune::MPIHelper::instance(argc, argv);
@@ -0,0 +1,156 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE WriteVtkDataTest
+
+#include <opm/simulators/vtk/writeVtkData.hpp>
+#include <opm/core/grid.h>
+#include <opm/core/grid/cart_grid.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace
+{
+    struct GridDeleter
+    {
+        void operator()(UnstructuredGrid* grid) const { destroy_grid(grid); }
+    };
+
+    std::uint64_t readWord(const std::string& bytes, const std::size_t pos)
+    {
+        std::uint64_t value;
+        std::memcpy(&value, bytes.data() + pos, sizeof(value));
+        return value;
+    }
+
+    // The offset of the named data array in the appended section.
+    std::size_t arrayOffset(const std::string& vtu, const std::string& name)
+    {
+        const std::size_t tag = vtu.find("Name=\"" + name + "\"");
+        BOOST_REQUIRE(tag != std::string::npos);
+        const std::size_t offset = vtu.find("offset=\"", tag) + 8;
+        return std::stoul(vtu.substr(offset, vtu.find('"', offset) - offset));
+    }
+
+    std::size_t appendedBegin(const std::string& vtu)
+    {
+        const std::size_t appended = vtu.find("<AppendedData");
+        BOOST_REQUIRE(appended != std::string::npos);
+        return vtu.find('_', appended) + 1;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(AppendedRaw)
+{
+    std::unique_ptr<UnstructuredGrid, GridDeleter> grid(create_grid_cart3d(2, 2, 1));
+    const int numCells = grid->number_of_cells;
+    std::vector<double> pressure(numCells);
+    std::vector<double> saturation(2*numCells);
+    for (int c = 0; c < numCells; ++c) {
+        pressure[c] = 1.0e5 + c;
+        saturation[2*c] = 0.1*c;
+        saturation[2*c + 1] = 1.0 - 0.1*c;
+    }
+    std::map<std::string, const std::vector<double>*> data;
+    data["pressure"] = &pressure;
+    data["saturation"] = &saturation;
+
+    std::ostringstream os;
+    Opm::writeVtuData(*grid, data, Opm::VtkEncoding::Binary, os);
+    const std::string vtu = os.str();
+
+    BOOST_CHECK(vtu.find("header_type=\"UInt64\"") != std::string::npos);
+    BOOST_CHECK(vtu.find("compressor") == std::string::npos);
+    BOOST_CHECK(vtu.find("Name=\"saturation\" NumberOfComponents=\"2\"") != std::string::npos);
+
+    const std::size_t begin = appendedBegin(vtu);
+    const std::size_t coordinates = begin + arrayOffset(vtu, "Coordinates");
+    BOOST_CHECK_EQUAL(readWord(vtu, coordinates), 3*sizeof(double)*grid->number_of_nodes);
+    BOOST_CHECK(std::memcmp(vtu.data() + coordinates + 8, grid->node_coordinates,
+                            3*sizeof(double)*grid->number_of_nodes) == 0);
+
+    const std::size_t sat = begin + arrayOffset(vtu, "saturation");
+    BOOST_CHECK_EQUAL(readWord(vtu, sat), saturation.size()*sizeof(double));
+    BOOST_CHECK(std::memcmp(vtu.data() + sat + 8, saturation.data(),
+                            saturation.size()*sizeof(double)) == 0);
+}
+
+#if HAVE_ZLIB
+BOOST_AUTO_TEST_CASE(AppendedZlib)
+{
+    std::unique_ptr<UnstructuredGrid, GridDeleter> grid(create_grid_cart3d(20, 20, 20));
+    const int numCells = grid->number_of_cells;
+    std::vector<double> pressure(numCells);
+    for (int c = 0; c < numCells; ++c) {
+        pressure[c] = 1.0e5 + c;
+    }
+    std::map<std::string, const std::vector<double>*> data;
+    data["pressure"] = &pressure;
+
+    BOOST_REQUIRE(Opm::vtkEncodingAvailable(Opm::VtkEncoding::BinaryZlib));
+    std::ostringstream os;
+    Opm::writeVtuData(*grid, data, Opm::VtkEncoding::BinaryZlib, os);
+    const std::string vtu = os.str();
+    BOOST_CHECK(vtu.find("compressor=\"vtkZLibDataCompressor\"") != std::string::npos);
+
+    // block header: number of blocks, block size, size of the last
+    // partial block and the compressed size of each block
+    std::size_t pos = appendedBegin(vtu) + arrayOffset(vtu, "pressure");
+    const std::size_t numBlocks = readWord(vtu, pos);
+    const std::size_t blockSize = readWord(vtu, pos + 8);
+    const std::size_t lastSize = readWord(vtu, pos + 16);
+    const std::size_t rawSize = pressure.size()*sizeof(double);
+    BOOST_REQUIRE_EQUAL(numBlocks, (rawSize + blockSize - 1)/blockSize);
+    BOOST_CHECK(numBlocks > 1);
+    BOOST_CHECK_EQUAL(lastSize, rawSize % blockSize);
+
+    std::vector<char> raw;
+    std::size_t block = pos + 24 + 8*numBlocks;
+    for (std::size_t b = 0; b < numBlocks; ++b) {
+        const std::size_t compressed = readWord(vtu, pos + 24 + 8*b);
+        std::vector<char> out(blockSize);
+        uLongf length = blockSize;
+        BOOST_REQUIRE_EQUAL(uncompress(reinterpret_cast<Bytef*>(out.data()), &length,
+                                       reinterpret_cast<const Bytef*>(vtu.data() + block),
+                                       compressed), Z_OK);
+        raw.insert(raw.end(), out.begin(), out.begin() + length);
+        block += compressed;
+    }
+    BOOST_REQUIRE_EQUAL(raw.size(), rawSize);
+    BOOST_CHECK(std::memcmp(raw.data(), pressure.data(), rawSize) == 0);
+}
+#endif